@@ -0,0 +1,209 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <benchmark/benchmark.h>
+
+#include <stdarg.h>
+
+#include "memory.h"
+#include "fiber.h"
+#include "say.h"
+#include "cbus.h"
+
+/*
+ * Benchmarks are run in a fiber of the main cord while its
+ * event loop delivers replies from a worker cord.
+ */
+
+enum {
+	/** Stack size of the fiber running the benchmarks. */
+	BENCH_STACK_SIZE = 8 * 1024 * 1024,
+};
+
+/** Worker cord, replies to all messages. */
+static struct cord worker;
+/** Pipe from the main cord to the worker. */
+static struct cpipe pipe_to_worker;
+/** Pipe from the worker to the main cord, owned by the worker. */
+static struct cpipe pipe_to_main;
+/** Fiber delivering messages to the main cord. */
+static struct fiber *endpoint_fiber;
+
+static int
+worker_f(va_list ap)
+{
+	(void)ap;
+	cpipe_create(&pipe_to_main, "main");
+	struct cbus_endpoint endpoint;
+	cbus_endpoint_create(&endpoint, "worker", fiber_schedule_cb, fiber());
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	cpipe_destroy(&pipe_to_main);
+	return 0;
+}
+
+static int
+endpoint_f(va_list ap)
+{
+	(void)ap;
+	struct cbus_endpoint endpoint;
+	cbus_endpoint_create(&endpoint, "main", fiber_schedule_cb, fiber());
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	return 0;
+}
+
+static int
+call_f(struct cbus_call_msg *msg)
+{
+	(void)msg;
+	return 0;
+}
+
+/** Synchronous cbus_call() round trip. */
+static void
+bench_cbus_call(benchmark::State &state)
+{
+	for (auto _ : state) {
+		struct cbus_call_msg msg;
+		if (cbus_call(&pipe_to_worker, &pipe_to_main, &msg,
+			      call_f, NULL, TIMEOUT_INFINITY) != 0)
+			panic("cbus_call failed");
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bench_cbus_call);
+
+/** State of a batch of messages sent in a pipeline. */
+struct batch {
+	/** Number of messages which haven't returned yet. */
+	int pending;
+	/** Fiber waiting for the batch. */
+	struct fiber *fiber;
+};
+
+struct batch_msg {
+	struct cmsg base;
+	struct batch *batch;
+};
+
+static void
+batch_msg_worker(struct cmsg *m)
+{
+	(void)m;
+}
+
+static void
+batch_msg_done(struct cmsg *m)
+{
+	struct batch *batch = ((struct batch_msg *)m)->batch;
+	if (--batch->pending == 0)
+		fiber_wakeup(batch->fiber);
+}
+
+/** Round trip of a batch of messages sent without waiting. */
+static void
+bench_cbus_pipeline(benchmark::State &state)
+{
+	static const struct cmsg_hop route[] = {
+		{ batch_msg_worker, &pipe_to_main },
+		{ batch_msg_done, NULL },
+	};
+	int count = state.range(0);
+	struct batch_msg *msgs = new struct batch_msg[count];
+	struct batch batch;
+	batch.fiber = fiber();
+	for (auto _ : state) {
+		batch.pending = count;
+		for (int i = 0; i < count; i++) {
+			cmsg_init(&msgs[i].base, route);
+			msgs[i].batch = &batch;
+			cpipe_push(&pipe_to_worker, &msgs[i].base);
+		}
+		while (batch.pending > 0)
+			fiber_yield();
+	}
+	delete[] msgs;
+	state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(bench_cbus_pipeline)->RangeMultiplier(8)->Range(1, 4096);
+
+static int
+bench_f(va_list ap)
+{
+	(void)ap;
+	endpoint_fiber = fiber_new("endpoint", endpoint_f);
+	if (endpoint_fiber == NULL)
+		panic("failed to create the endpoint fiber");
+	fiber_set_joinable(endpoint_fiber, true);
+	fiber_start(endpoint_fiber);
+	if (cord_costart(&worker, "worker", worker_f, NULL) != 0)
+		panic("failed to start the worker");
+	cpipe_create(&pipe_to_worker, "worker");
+
+	::benchmark::RunSpecifiedBenchmarks();
+
+	cbus_stop_loop(&pipe_to_worker);
+	cpipe_destroy(&pipe_to_worker);
+	if (cord_join(&worker) != 0)
+		panic("failed to join the worker");
+	fiber_cancel(endpoint_fiber);
+	fiber_join(endpoint_fiber);
+	ev_break(loop(), EVBREAK_ALL);
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	::benchmark::Initialize(&argc, argv);
+	if (::benchmark::ReportUnrecognizedArguments(argc, argv))
+		return 1;
+
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	cbus_init();
+
+	struct fiber_attr *attr = fiber_attr_new();
+	if (attr == NULL ||
+	    fiber_attr_setstacksize(attr, BENCH_STACK_SIZE) != 0)
+		panic("failed to set up fiber attributes");
+	struct fiber *bench = fiber_new_ex("bench", attr, bench_f);
+	if (bench == NULL)
+		panic("failed to create the benchmark fiber");
+	fiber_attr_delete(attr);
+	fiber_wakeup(bench);
+	ev_run(loop(), 0);
+
+	cbus_free();
+	fiber_free();
+	memory_free();
+	return 0;
+}
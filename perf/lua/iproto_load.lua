@@ -0,0 +1,146 @@
+#!/usr/bin/env tarantool
+
+--
+-- IPROTO load generator.
+--
+-- Runs a number of fibers issuing requests over net.box and
+-- prints one JSON object per request type with throughput and
+-- latency percentiles, so the output can be tracked between
+-- releases. Without --uri a local instance listening on a
+-- unix socket is started and benchmarked.
+--
+--   tarantool iproto_load.lua [--uri <uri>] [--fibers <n>]
+--       [--duration <seconds>] [--ops ping,get,select,replace,call]
+--       [--tuples <n>]
+--
+-- Besides the default request types, --ops accepts call_select,
+-- which calls a function returning 1000 tuples, and call_rows,
+-- which returns them as 1000 Lua tables, to measure encoding of
+-- large CALL results.
+--
+
+local fiber = require('fiber')
+local clock = require('clock')
+local fio = require('fio')
+local json = require('json')
+local net_box = require('net.box')
+local argparse = require('internal.argparse').parse
+
+local params = argparse(arg, {
+    {'uri', 'string'},
+    {'fibers', 'number'},
+    {'duration', 'number'},
+    {'ops', 'string'},
+    {'tuples', 'number'},
+})
+local fiber_count = params.fibers or 50
+local duration = params.duration or 10
+local tuple_count = params.tuples or 10000
+local op_names = params.ops or 'ping,get,select,replace,call'
+
+local uri = params.uri
+if uri == nil then
+    local sock = fio.pathjoin(fio.tempdir(), 'iproto_load.sock')
+    box.cfg{listen = sock, log_level = 2, wal_mode = 'none'}
+    box.schema.user.grant('guest', 'read,write,execute', 'universe', nil,
+                          {if_not_exists = true})
+    local s = box.schema.space.create('iproto_load', {if_not_exists = true})
+    s:create_index('pk', {if_not_exists = true})
+    for i = 1, tuple_count do
+        s:replace{i, string.rep('x', 32)}
+    end
+    rawset(_G, 'iproto_load_call', function(x) return x end)
+    rawset(_G, 'iproto_load_select', function()
+        return s:select({}, {limit = 1000})
+    end)
+    rawset(_G, 'iproto_load_rows', function()
+        local rows = {}
+        for _, t in ipairs(s:select({}, {limit = 1000})) do
+            table.insert(rows, {t[1], t[2]})
+        end
+        return rows
+    end)
+    uri = 'unix/:' .. sock
+end
+
+local ops = {
+    ping = function(c) c:ping() end,
+    get = function(c)
+        c.space.iproto_load:get(math.random(tuple_count))
+    end,
+    select = function(c)
+        c.space.iproto_load:select(math.random(tuple_count), {limit = 10})
+    end,
+    replace = function(c)
+        c.space.iproto_load:replace{math.random(tuple_count),
+                                    string.rep('y', 32)}
+    end,
+    call = function(c) c:call('iproto_load_call', {1}) end,
+    call_select = function(c) c:call('iproto_load_select') end,
+    call_rows = function(c) c:call('iproto_load_rows') end,
+}
+
+local function percentile(sorted, p)
+    if #sorted == 0 then
+        return 0
+    end
+    return sorted[math.max(1, math.ceil(#sorted * p))]
+end
+
+local function run(name, op)
+    local conn = net_box.connect(uri)
+    if not conn:is_connected() then
+        error(string.format('failed to connect to %s: %s', uri, conn.error))
+    end
+    local latencies = {}
+    local errors = 0
+    local deadline = clock.monotonic() + duration
+    local workers = {}
+    for i = 1, fiber_count do
+        local f = fiber.new(function()
+            while clock.monotonic() < deadline do
+                local start = clock.monotonic()
+                if pcall(op, conn) then
+                    table.insert(latencies, clock.monotonic() - start)
+                else
+                    errors = errors + 1
+                end
+            end
+        end)
+        f:set_joinable(true)
+        workers[i] = f
+    end
+    local start = clock.monotonic()
+    for _, f in ipairs(workers) do
+        f:join()
+    end
+    local elapsed = clock.monotonic() - start
+    conn:close()
+    table.sort(latencies)
+    local sum = 0
+    for _, v in ipairs(latencies) do
+        sum = sum + v
+    end
+    return {
+        bench = 'iproto_' .. name,
+        fibers = fiber_count,
+        duration = elapsed,
+        requests = #latencies,
+        errors = errors,
+        rps = #latencies / elapsed,
+        latency_avg = #latencies > 0 and sum / #latencies or 0,
+        latency_p50 = percentile(latencies, 0.5),
+        latency_p99 = percentile(latencies, 0.99),
+        latency_p999 = percentile(latencies, 0.999),
+        latency_max = latencies[#latencies] or 0,
+    }
+end
+
+for name in op_names:gmatch('[^,]+') do
+    local op = ops[name]
+    if op == nil then
+        error('unknown request type: ' .. name)
+    end
+    print(json.encode(run(name, op)))
+end
+os.exit(0)
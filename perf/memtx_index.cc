@@ -0,0 +1,265 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <benchmark/benchmark.h>
+
+#include <stdlib.h>
+#include <vector>
+
+#include "memory.h"
+#include "fiber.h"
+#include "say.h"
+#include "msgpuck.h"
+#include "key_def.h"
+#include "tuple.h"
+#include "tuple_format.h"
+#include "tuple_hash.h"
+#include "memtx_tree.h"
+#include "memtx_hash.h"
+
+/*
+ * Benchmarks of the containers behind memtx TREE and HASH
+ * indexes. They use the same tree and hash table definitions
+ * and comparators as memtx, but bypass the engine and the
+ * space, so only the index data structure is measured.
+ */
+
+static void *
+extent_alloc(void *ctx)
+{
+	(void)ctx;
+	return malloc(MEMTX_EXTENT_SIZE);
+}
+
+static void
+extent_free(void *ctx, void *extent)
+{
+	(void)ctx;
+	free(extent);
+}
+
+/** Tuples {unsigned, string} with unique random primary keys. */
+struct tuple_set {
+	struct key_def *key_def;
+	struct tuple_format *format;
+	std::vector<struct tuple *> tuples;
+	/** MsgPack-encoded primary keys, without array header. */
+	std::vector<char> keys;
+	/** Offsets of the keys in @keys. */
+	std::vector<size_t> key_offsets;
+
+	explicit tuple_set(size_t count);
+	~tuple_set();
+
+	const char *
+	key(size_t i) const { return keys.data() + key_offsets[i]; }
+};
+
+tuple_set::tuple_set(size_t count)
+{
+	uint32_t fieldno = 0;
+	uint32_t type = FIELD_TYPE_UNSIGNED;
+	key_def = box_key_def_new(&fieldno, &type, 1);
+	if (key_def == NULL)
+		panic("failed to create a key definition");
+	format = box_tuple_format_new(&key_def, 1);
+	if (format == NULL)
+		panic("failed to create a tuple format");
+	tuple_format_ref(format);
+
+	/* Shuffle keys so that inserts go in random order. */
+	std::vector<uint64_t> ids(count);
+	for (size_t i = 0; i < count; i++)
+		ids[i] = i * 2;
+	for (size_t i = count; i > 1; i--)
+		std::swap(ids[i - 1], ids[rand() % i]);
+
+	char buf[64];
+	for (size_t i = 0; i < count; i++) {
+		char *end = mp_encode_array(buf, 2);
+		end = mp_encode_uint(end, ids[i]);
+		end = mp_encode_str(end, "payload", 7);
+		struct tuple *tuple = tuple_new(format, buf, end);
+		if (tuple == NULL)
+			panic("failed to create a tuple");
+		tuple_ref(tuple);
+		tuples.push_back(tuple);
+
+		key_offsets.push_back(keys.size());
+		char *key_end = mp_encode_uint(buf, ids[i]);
+		keys.insert(keys.end(), buf, key_end);
+	}
+}
+
+tuple_set::~tuple_set()
+{
+	for (auto tuple : tuples)
+		tuple_unref(tuple);
+	tuple_format_unref(format);
+	key_def_delete(key_def);
+}
+
+static void
+tree_fill(struct memtx_tree *tree, const struct tuple_set &set)
+{
+	for (auto tuple : set.tuples) {
+		struct memtx_tree_data data;
+		data.tuple = tuple;
+		data.hint = tuple_hint(tuple, set.key_def);
+		if (memtx_tree_insert(tree, data, NULL) != 0)
+			panic("failed to insert into a tree");
+	}
+}
+
+static void
+hash_fill(struct light_index_core *hash, const struct tuple_set &set)
+{
+	for (auto tuple : set.tuples) {
+		uint32_t h = tuple_hash(tuple, set.key_def);
+		if (light_index_insert(hash, h, tuple) == light_index_end)
+			panic("failed to insert into a hash");
+	}
+}
+
+static void
+bench_tree_insert(benchmark::State &state)
+{
+	struct tuple_set set(state.range(0));
+	for (auto _ : state) {
+		struct memtx_tree tree;
+		memtx_tree_create(&tree, set.key_def, extent_alloc,
+				  extent_free, NULL);
+		tree_fill(&tree, set);
+		state.PauseTiming();
+		memtx_tree_destroy(&tree);
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bench_tree_insert)->RangeMultiplier(16)->Range(1 << 10, 1 << 18)
+	->Unit(benchmark::kMillisecond);
+
+static void
+bench_tree_find(benchmark::State &state)
+{
+	struct tuple_set set(state.range(0));
+	struct memtx_tree tree;
+	memtx_tree_create(&tree, set.key_def, extent_alloc, extent_free, NULL);
+	tree_fill(&tree, set);
+	size_t i = 0;
+	for (auto _ : state) {
+		struct memtx_tree_key_data key_data;
+		key_data.key = set.key(i++ % set.tuples.size());
+		key_data.part_count = 1;
+		key_data.hint = key_hint(key_data.key, 1, set.key_def);
+		benchmark::DoNotOptimize(memtx_tree_find(&tree, &key_data));
+	}
+	memtx_tree_destroy(&tree);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bench_tree_find)->RangeMultiplier(16)->Range(1 << 10, 1 << 20);
+
+static void
+bench_tree_iterate(benchmark::State &state)
+{
+	struct tuple_set set(state.range(0));
+	struct memtx_tree tree;
+	memtx_tree_create(&tree, set.key_def, extent_alloc, extent_free, NULL);
+	tree_fill(&tree, set);
+	for (auto _ : state) {
+		struct memtx_tree_iterator it =
+			memtx_tree_iterator_first(&tree);
+		struct memtx_tree_data *data;
+		while ((data = memtx_tree_iterator_get_elem(&tree,
+							    &it)) != NULL) {
+			benchmark::DoNotOptimize(data->tuple);
+			memtx_tree_iterator_next(&tree, &it);
+		}
+	}
+	memtx_tree_destroy(&tree);
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bench_tree_iterate)->RangeMultiplier(16)->Range(1 << 10, 1 << 18)
+	->Unit(benchmark::kMicrosecond);
+
+static void
+bench_hash_insert(benchmark::State &state)
+{
+	struct tuple_set set(state.range(0));
+	for (auto _ : state) {
+		struct light_index_core hash;
+		light_index_create(&hash, MEMTX_EXTENT_SIZE, extent_alloc,
+				   extent_free, NULL, set.key_def);
+		hash_fill(&hash, set);
+		state.PauseTiming();
+		light_index_destroy(&hash);
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bench_hash_insert)->RangeMultiplier(16)->Range(1 << 10, 1 << 18)
+	->Unit(benchmark::kMillisecond);
+
+static void
+bench_hash_find(benchmark::State &state)
+{
+	struct tuple_set set(state.range(0));
+	struct light_index_core hash;
+	light_index_create(&hash, MEMTX_EXTENT_SIZE, extent_alloc,
+			   extent_free, NULL, set.key_def);
+	hash_fill(&hash, set);
+	size_t i = 0;
+	for (auto _ : state) {
+		const char *key = set.key(i++ % set.tuples.size());
+		uint32_t h = key_hash(key, set.key_def);
+		benchmark::DoNotOptimize(light_index_find_key(&hash, h, key));
+	}
+	light_index_destroy(&hash);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bench_hash_find)->RangeMultiplier(16)->Range(1 << 10, 1 << 20);
+
+int
+main(int argc, char **argv)
+{
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	tuple_init(NULL);
+
+	::benchmark::Initialize(&argc, argv);
+	if (::benchmark::ReportUnrecognizedArguments(argc, argv))
+		return 1;
+	::benchmark::RunSpecifiedBenchmarks();
+
+	tuple_free();
+	fiber_free();
+	memory_free();
+	return 0;
+}
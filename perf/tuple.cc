@@ -0,0 +1,297 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <benchmark/benchmark.h>
+
+#include <stdlib.h>
+#include <vector>
+
+#include "memory.h"
+#include "fiber.h"
+#include "say.h"
+#include "msgpuck.h"
+#include "key_def.h"
+#include "tuple.h"
+#include "tuple_format.h"
+#include "tuple_hash.h"
+#include "tuple_update.h"
+
+enum {
+	/** Number of tuples each benchmark iterates over. */
+	TUPLE_COUNT = 1024,
+	/** Length of the string field. */
+	STR_LEN = 16,
+};
+
+/** Key definition shapes covered by comparator benchmarks. */
+enum key_shape {
+	/** Single unsigned part: {1, 'unsigned'}. */
+	SHAPE_UNSIGNED,
+	/** Single string part: {2, 'string'}. */
+	SHAPE_STRING,
+	/** Composite key: {1, 'unsigned', 2, 'string'}. */
+	SHAPE_UNSIGNED_STRING,
+	/** Nullable part: {3, 'unsigned', is_nullable = true}. */
+	SHAPE_NULLABLE,
+	key_shape_MAX,
+};
+
+static const char *key_shape_strs[] = {
+	"unsigned", "string", "unsigned+string", "nullable"
+};
+
+/**
+ * A set of random tuples {unsigned, string, unsigned or nil}
+ * and a key definition of the given shape over them.
+ */
+struct tuple_set {
+	struct key_def *key_def;
+	struct tuple_format *format;
+	std::vector<struct tuple *> tuples;
+	/** Keys extracted from the tuples, without array header. */
+	std::vector<std::vector<char> > keys;
+
+	explicit tuple_set(enum key_shape shape);
+	~tuple_set();
+};
+
+tuple_set::tuple_set(enum key_shape shape)
+{
+	struct key_part_def parts[2];
+	uint32_t part_count = 1;
+	parts[0] = parts[1] = key_part_def_default;
+	switch (shape) {
+	case SHAPE_UNSIGNED:
+		parts[0].fieldno = 0;
+		parts[0].type = FIELD_TYPE_UNSIGNED;
+		break;
+	case SHAPE_STRING:
+		parts[0].fieldno = 1;
+		parts[0].type = FIELD_TYPE_STRING;
+		break;
+	case SHAPE_UNSIGNED_STRING:
+		parts[0].fieldno = 0;
+		parts[0].type = FIELD_TYPE_UNSIGNED;
+		parts[1].fieldno = 1;
+		parts[1].type = FIELD_TYPE_STRING;
+		part_count = 2;
+		break;
+	default:
+		parts[0].fieldno = 2;
+		parts[0].type = FIELD_TYPE_UNSIGNED;
+		parts[0].is_nullable = true;
+		parts[0].nullable_action = ON_CONFLICT_ACTION_NONE;
+		break;
+	}
+	key_def = key_def_new(parts, part_count);
+	if (key_def == NULL)
+		panic("failed to create a key definition");
+	format = box_tuple_format_new(&key_def, 1);
+	if (format == NULL)
+		panic("failed to create a tuple format");
+	tuple_format_ref(format);
+
+	char buf[64];
+	for (int i = 0; i < TUPLE_COUNT; i++) {
+		char str[STR_LEN];
+		for (int j = 0; j < STR_LEN; j++)
+			str[j] = 'a' + rand() % 26;
+		char *end = mp_encode_array(buf, 3);
+		end = mp_encode_uint(end, rand());
+		end = mp_encode_str(end, str, STR_LEN);
+		end = i % 8 == 0 ? mp_encode_nil(end) :
+		      mp_encode_uint(end, rand() % 1000);
+		struct tuple *tuple = tuple_new(format, buf, end);
+		if (tuple == NULL)
+			panic("failed to create a tuple");
+		tuple_ref(tuple);
+		tuples.push_back(tuple);
+
+		std::vector<char> key;
+		for (uint32_t k = 0; k < part_count; k++) {
+			const char *part = tuple_field(tuple,
+						       parts[k].fieldno);
+			const char *part_end = part;
+			mp_next(&part_end);
+			key.insert(key.end(), part, part_end);
+		}
+		keys.push_back(key);
+	}
+}
+
+tuple_set::~tuple_set()
+{
+	for (auto tuple : tuples)
+		tuple_unref(tuple);
+	tuple_format_unref(format);
+	key_def_delete(key_def);
+}
+
+static void
+bench_tuple_compare(benchmark::State &state)
+{
+	enum key_shape shape = (enum key_shape)state.range(0);
+	struct tuple_set set(shape);
+	state.SetLabel(key_shape_strs[shape]);
+	size_t i = 0;
+	for (auto _ : state) {
+		struct tuple *a = set.tuples[i % TUPLE_COUNT];
+		struct tuple *b = set.tuples[(i + 1) % TUPLE_COUNT];
+		benchmark::DoNotOptimize(tuple_compare(a, b, set.key_def));
+		i++;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bench_tuple_compare)->DenseRange(0, key_shape_MAX - 1);
+
+static void
+bench_tuple_compare_hinted(benchmark::State &state)
+{
+	enum key_shape shape = (enum key_shape)state.range(0);
+	struct tuple_set set(shape);
+	state.SetLabel(key_shape_strs[shape]);
+	std::vector<hint_t> hints;
+	for (auto tuple : set.tuples)
+		hints.push_back(tuple_hint(tuple, set.key_def));
+	size_t i = 0;
+	for (auto _ : state) {
+		size_t a = i % TUPLE_COUNT, b = (i + 1) % TUPLE_COUNT;
+		benchmark::DoNotOptimize(tuple_compare_hinted(
+				set.tuples[a], hints[a],
+				set.tuples[b], hints[b], set.key_def));
+		i++;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bench_tuple_compare_hinted)->DenseRange(0, key_shape_MAX - 1);
+
+static void
+bench_tuple_compare_with_key(benchmark::State &state)
+{
+	enum key_shape shape = (enum key_shape)state.range(0);
+	struct tuple_set set(shape);
+	state.SetLabel(key_shape_strs[shape]);
+	uint32_t part_count = set.key_def->part_count;
+	size_t i = 0;
+	for (auto _ : state) {
+		struct tuple *tuple = set.tuples[i % TUPLE_COUNT];
+		const char *key = set.keys[(i + 1) % TUPLE_COUNT].data();
+		benchmark::DoNotOptimize(tuple_compare_with_key(
+				tuple, key, part_count, set.key_def));
+		i++;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bench_tuple_compare_with_key)->DenseRange(0, key_shape_MAX - 1);
+
+static void
+bench_tuple_hash(benchmark::State &state)
+{
+	enum key_shape shape = (enum key_shape)state.range(0);
+	struct tuple_set set(shape);
+	state.SetLabel(key_shape_strs[shape]);
+	size_t i = 0;
+	for (auto _ : state) {
+		struct tuple *tuple = set.tuples[i++ % TUPLE_COUNT];
+		benchmark::DoNotOptimize(tuple_hash(tuple, set.key_def));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bench_tuple_hash)->DenseRange(0, SHAPE_UNSIGNED_STRING);
+
+/** Set, arithmetic and insert update operations. */
+static void
+bench_tuple_update(benchmark::State &state)
+{
+	struct tuple_set set(SHAPE_UNSIGNED);
+	char ops[64];
+	char *ops_end = mp_encode_array(ops, 1);
+	switch (state.range(0)) {
+	case 0:
+		state.SetLabel("set");
+		ops_end = mp_encode_array(ops_end, 3);
+		ops_end = mp_encode_str(ops_end, "=", 1);
+		ops_end = mp_encode_uint(ops_end, 2);
+		ops_end = mp_encode_str(ops_end, "updated", 7);
+		break;
+	case 1:
+		state.SetLabel("arith");
+		/* Field 3 is nil in some tuples: use field 1. */
+		ops_end = mp_encode_array(ops_end, 3);
+		ops_end = mp_encode_str(ops_end, "+", 1);
+		ops_end = mp_encode_uint(ops_end, 1);
+		ops_end = mp_encode_uint(ops_end, 1);
+		break;
+	default:
+		state.SetLabel("insert");
+		ops_end = mp_encode_array(ops_end, 3);
+		ops_end = mp_encode_str(ops_end, "!", 1);
+		ops_end = mp_encode_uint(ops_end, 2);
+		ops_end = mp_encode_uint(ops_end, 42);
+		break;
+	}
+	struct region *region = &fiber()->gc;
+	size_t i = 0;
+	for (auto _ : state) {
+		struct tuple *tuple = set.tuples[i++ % TUPLE_COUNT];
+		uint32_t bsize;
+		const char *data = tuple_data_range(tuple, &bsize);
+		size_t used = region_used(region);
+		uint32_t new_size;
+		const char *new_data =
+			tuple_update_execute(region_aligned_alloc_cb, region,
+					     ops, ops_end, data, data + bsize,
+					     &new_size, 1, NULL);
+		if (new_data == NULL)
+			panic("tuple update failed");
+		benchmark::DoNotOptimize(new_data);
+		region_truncate(region, used);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bench_tuple_update)->DenseRange(0, 2);
+
+int
+main(int argc, char **argv)
+{
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	tuple_init(NULL);
+
+	::benchmark::Initialize(&argc, argv);
+	if (::benchmark::ReportUnrecognizedArguments(argc, argv))
+		return 1;
+	::benchmark::RunSpecifiedBenchmarks();
+
+	tuple_free();
+	fiber_free();
+	memory_free();
+	return 0;
+}
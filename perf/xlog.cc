@@ -0,0 +1,166 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <benchmark/benchmark.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <limits.h>
+#include <vector>
+
+#include "memory.h"
+#include "fiber.h"
+#include "say.h"
+#include "tt_uuid.h"
+#include "vclock.h"
+#include "xrow.h"
+#include "xlog.h"
+#include "iproto_constants.h"
+
+enum {
+	/** Number of rows in a file read by the read benchmark. */
+	READ_ROW_COUNT = 100000,
+};
+
+/** Directory for xlog files, removed on exit. */
+static char dirname[] = "/tmp/xlog.perftest.XXXXXX";
+
+/** Create an empty xlog file. */
+static void
+xlog_bench_create(struct xlog *xlog, char *filename)
+{
+	static int file_count;
+	snprintf(filename, PATH_MAX, "%s/%020d.xlog", dirname,
+		 file_count++);
+	struct tt_uuid uuid;
+	tt_uuid_create(&uuid);
+	struct vclock vclock;
+	vclock_create(&vclock);
+	struct xlog_meta meta;
+	xlog_meta_create(&meta, "XLOG", &uuid, &vclock, NULL);
+	if (xlog_create(xlog, filename, 0, &meta) != 0)
+		panic("failed to create %s", filename);
+}
+
+/** Finalize a file created with xlog_bench_create(). */
+static void
+xlog_bench_close(struct xlog *xlog)
+{
+	if (xlog_flush(xlog) < 0 || xlog_rename(xlog) != 0)
+		panic("failed to write %s", xlog->filename);
+	xlog_close(xlog, false);
+}
+
+static void
+xrow_bench_create(struct xrow_header *row, const std::vector<char> &body)
+{
+	memset(row, 0, sizeof(*row));
+	row->type = IPROTO_INSERT;
+	row->replica_id = 1;
+	row->bodycnt = 1;
+	row->body[0].iov_base = (void *)body.data();
+	row->body[0].iov_len = body.size();
+}
+
+static void
+bench_xlog_write(benchmark::State &state)
+{
+	std::vector<char> body(state.range(0), 'x');
+	struct xrow_header row;
+	xrow_bench_create(&row, body);
+	struct xlog xlog;
+	char filename[PATH_MAX];
+	xlog_bench_create(&xlog, filename);
+	for (auto _ : state) {
+		row.lsn++;
+		if (xlog_write_row(&xlog, &row) < 0)
+			panic("failed to write %s", filename);
+	}
+	xlog_bench_close(&xlog);
+	unlink(filename);
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bench_xlog_write)->RangeMultiplier(8)->Range(64, 4096);
+
+static void
+bench_xlog_read(benchmark::State &state)
+{
+	std::vector<char> body(state.range(0), 'x');
+	struct xrow_header row;
+	xrow_bench_create(&row, body);
+	struct xlog xlog;
+	char filename[PATH_MAX];
+	xlog_bench_create(&xlog, filename);
+	for (int i = 0; i < READ_ROW_COUNT; i++) {
+		row.lsn++;
+		if (xlog_write_row(&xlog, &row) < 0)
+			panic("failed to write %s", filename);
+	}
+	xlog_bench_close(&xlog);
+	for (auto _ : state) {
+		struct xlog_cursor cursor;
+		if (xlog_cursor_open(&cursor, filename) != 0)
+			panic("failed to open %s", filename);
+		int rc;
+		while ((rc = xlog_cursor_next(&cursor, &row, false)) == 0)
+			benchmark::DoNotOptimize(row.lsn);
+		if (rc < 0)
+			panic("failed to read %s", filename);
+		xlog_cursor_close(&cursor, false);
+	}
+	unlink(filename);
+	state.SetItemsProcessed(state.iterations() * READ_ROW_COUNT);
+	state.SetBytesProcessed(state.iterations() * READ_ROW_COUNT *
+				state.range(0));
+}
+BENCHMARK(bench_xlog_read)->RangeMultiplier(8)->Range(64, 4096)
+	->Unit(benchmark::kMillisecond);
+
+int
+main(int argc, char **argv)
+{
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	if (mkdtemp(dirname) == NULL)
+		panic_syserror("failed to create %s", dirname);
+
+	::benchmark::Initialize(&argc, argv);
+	if (::benchmark::ReportUnrecognizedArguments(argc, argv))
+		return 1;
+	::benchmark::RunSpecifiedBenchmarks();
+
+	rmdir(dirname);
+	fiber_free();
+	memory_free();
+	return 0;
+}
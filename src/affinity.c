@@ -0,0 +1,366 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "affinity.h"
+
+#include <fnmatch.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trivia/config.h"
+#include "trivia/util.h"
+#include "diag.h"
+#include "say.h"
+#include "tt_pthread.h"
+
+#if defined(TARGET_OS_LINUX)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+enum {
+	/** Max number of CPUs or NUMA nodes in a set. */
+	AFFINITY_SET_MAX = 1024,
+	/** Max number of cord affinity rules. */
+	CORD_AFFINITY_RULES_MAX = 32,
+	/** Max length of a cord name pattern. */
+	CORD_AFFINITY_PATTERN_MAX = 32,
+};
+
+/** A set of CPUs or NUMA nodes. */
+struct affinity_set {
+	unsigned long bits[AFFINITY_SET_MAX / (8 * sizeof(unsigned long))];
+};
+
+static inline void
+affinity_set_add(struct affinity_set *set, unsigned i)
+{
+	set->bits[i / (8 * sizeof(unsigned long))] |=
+		1UL << (i % (8 * sizeof(unsigned long)));
+}
+
+static inline bool
+affinity_set_has(const struct affinity_set *set, unsigned i)
+{
+	return (set->bits[i / (8 * sizeof(unsigned long))] &
+		(1UL << (i % (8 * sizeof(unsigned long))))) != 0;
+}
+
+/**
+ * Parse a list of numbers and ranges like "0-3,8,10-11" from
+ * [@a str, @a end) to @a set. @a what names the list items for
+ * error messages.
+ */
+static int
+affinity_set_parse(const char *str, const char *end, const char *what,
+		   struct affinity_set *set)
+{
+	memset(set, 0, sizeof(*set));
+	if (str == end)
+		goto error;
+	while (str < end) {
+		char *next;
+		unsigned long first = strtoul(str, &next, 10);
+		if (next == str)
+			goto error;
+		unsigned long last = first;
+		str = next;
+		if (str < end && *str == '-') {
+			str++;
+			last = strtoul(str, &next, 10);
+			if (next == str)
+				goto error;
+			str = next;
+		}
+		if (first > last || last >= AFFINITY_SET_MAX)
+			goto error;
+		for (unsigned long i = first; i <= last; i++)
+			affinity_set_add(set, i);
+		if (str < end && *str != ',')
+			goto error;
+		if (str < end)
+			str++;
+	}
+	return 0;
+error:
+	diag_set(IllegalParams, "invalid %s list", what);
+	return -1;
+}
+
+/** Cords whose name matches the pattern run on the CPUs. */
+struct cord_affinity_rule {
+	char pattern[CORD_AFFINITY_PATTERN_MAX];
+	struct affinity_set cpus;
+};
+
+static struct cord_affinity_rule cord_affinity_rules[CORD_AFFINITY_RULES_MAX];
+static int cord_affinity_rule_count;
+/**
+ * CPUs the process was allowed to run on before any rule was
+ * set. A thread matching no rule is moved back to them, since
+ * it inherits CPUs of the thread that started it.
+ */
+static struct affinity_set cord_affinity_default;
+static bool cord_affinity_has_default;
+static pthread_mutex_t cord_affinity_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int
+cord_affinity_parse(const char *rules, struct cord_affinity_rule *result,
+		    int *count)
+{
+	*count = 0;
+	if (rules == NULL)
+		return 0;
+	const char *str = rules;
+	while (*str != '\0') {
+		const char *end = strchr(str, ';');
+		if (end == NULL)
+			end = str + strlen(str);
+		const char *colon = memchr(str, ':', end - str);
+		if (colon == NULL || colon == str ||
+		    colon - str >= CORD_AFFINITY_PATTERN_MAX) {
+			diag_set(IllegalParams, "invalid thread affinity rule "
+				 "'%.*s'", (int)(end - str), str);
+			return -1;
+		}
+		if (*count >= CORD_AFFINITY_RULES_MAX) {
+			diag_set(IllegalParams, "too many thread affinity "
+				 "rules, max %d", CORD_AFFINITY_RULES_MAX);
+			return -1;
+		}
+		struct cord_affinity_rule *rule = &result[(*count)++];
+		memcpy(rule->pattern, str, colon - str);
+		rule->pattern[colon - str] = '\0';
+		if (affinity_set_parse(colon + 1, end, "CPU",
+				       &rule->cpus) != 0)
+			return -1;
+		str = *end == ';' ? end + 1 : end;
+	}
+	return 0;
+}
+
+int
+cord_affinity_check(const char *rules)
+{
+	struct cord_affinity_rule result[CORD_AFFINITY_RULES_MAX];
+	int count;
+	return cord_affinity_parse(rules, result, &count);
+}
+
+#if defined(TARGET_OS_LINUX)
+
+static void
+affinity_set_to_cpu_set(const struct affinity_set *set, cpu_set_t *cpus)
+{
+	CPU_ZERO(cpus);
+	for (unsigned i = 0; i < AFFINITY_SET_MAX && i < CPU_SETSIZE; i++) {
+		if (affinity_set_has(set, i))
+			CPU_SET(i, cpus);
+	}
+}
+
+static void
+affinity_set_from_cpu_set(struct affinity_set *set, const cpu_set_t *cpus)
+{
+	memset(set, 0, sizeof(*set));
+	for (unsigned i = 0; i < AFFINITY_SET_MAX && i < CPU_SETSIZE; i++) {
+		if (CPU_ISSET(i, cpus))
+			affinity_set_add(set, i);
+	}
+}
+
+#endif /* defined(TARGET_OS_LINUX) */
+
+int
+cord_affinity_set(const char *rules)
+{
+	struct cord_affinity_rule result[CORD_AFFINITY_RULES_MAX];
+	int count;
+	if (cord_affinity_parse(rules, result, &count) != 0)
+		return -1;
+	tt_pthread_mutex_lock(&cord_affinity_mutex);
+#if defined(TARGET_OS_LINUX)
+	if (!cord_affinity_has_default) {
+		cpu_set_t cpus;
+		if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0) {
+			affinity_set_from_cpu_set(&cord_affinity_default,
+						  &cpus);
+			cord_affinity_has_default = true;
+		}
+	}
+#endif
+	memcpy(cord_affinity_rules, result, count * sizeof(result[0]));
+	cord_affinity_rule_count = count;
+	tt_pthread_mutex_unlock(&cord_affinity_mutex);
+	return 0;
+}
+
+void
+cord_affinity_apply(const char *name)
+{
+	struct affinity_set cpus;
+	bool found = false;
+	tt_pthread_mutex_lock(&cord_affinity_mutex);
+	for (int i = 0; i < cord_affinity_rule_count; i++) {
+		if (fnmatch(cord_affinity_rules[i].pattern, name, 0) == 0) {
+			cpus = cord_affinity_rules[i].cpus;
+			found = true;
+			break;
+		}
+	}
+	if (!found && cord_affinity_rule_count > 0 &&
+	    cord_affinity_has_default) {
+		cpus = cord_affinity_default;
+		found = true;
+	}
+	tt_pthread_mutex_unlock(&cord_affinity_mutex);
+	if (!found)
+		return;
+#if defined(TARGET_OS_LINUX)
+	cpu_set_t cpu_set;
+	affinity_set_to_cpu_set(&cpus, &cpu_set);
+	int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set),
+					&cpu_set);
+	if (rc != 0)
+		say_error("failed to set CPU affinity of thread '%s': %s",
+			  name, strerror(rc));
+#else
+	say_warn("CPU affinity of thread '%s' is not supported on this "
+		 "platform", name);
+#endif
+}
+
+/** Memory policy modes, see set_mempolicy(2). */
+enum numa_policy_mode {
+	NUMA_POLICY_PREFERRED = 1,
+	NUMA_POLICY_BIND = 2,
+	NUMA_POLICY_INTERLEAVE = 3,
+};
+
+/** File listing the online NUMA nodes. */
+static const char *numa_online_path = "/sys/devices/system/node/online";
+
+/** Read the set of online NUMA nodes. */
+static int
+numa_online_nodes(struct affinity_set *nodes)
+{
+	char buf[256];
+	FILE *f = fopen(numa_online_path, "r");
+	if (f == NULL) {
+		diag_set(SystemError, "failed to open '%s'", numa_online_path);
+		return -1;
+	}
+	char *str = fgets(buf, sizeof(buf), f);
+	fclose(f);
+	if (str == NULL) {
+		diag_set(SystemError, "failed to read '%s'", numa_online_path);
+		return -1;
+	}
+	return affinity_set_parse(str, str + strcspn(str, "\n"),
+				  "NUMA node", nodes);
+}
+
+static int
+numa_parse_memory_policy(const char *policy, int *mode,
+			 struct affinity_set *nodes, bool *all_nodes)
+{
+	static const struct {
+		const char *name;
+		int mode;
+	} modes[] = {
+		{ "interleave", NUMA_POLICY_INTERLEAVE },
+		{ "bind", NUMA_POLICY_BIND },
+		{ "preferred", NUMA_POLICY_PREFERRED },
+	};
+	*all_nodes = false;
+	for (size_t i = 0; i < lengthof(modes); i++) {
+		size_t len = strlen(modes[i].name);
+		if (strncmp(policy, modes[i].name, len) != 0)
+			continue;
+		*mode = modes[i].mode;
+		if (policy[len] == '\0' && *mode == NUMA_POLICY_INTERLEAVE) {
+			*all_nodes = true;
+			return 0;
+		}
+		if (policy[len] != ':')
+			break;
+		const char *list = policy + len + 1;
+		if (affinity_set_parse(list, list + strlen(list),
+				       "NUMA node", nodes) != 0)
+			return -1;
+		return 0;
+	}
+	diag_set(IllegalParams, "invalid NUMA memory policy '%s'", policy);
+	return -1;
+}
+
+int
+numa_check_memory_policy(const char *policy)
+{
+	int mode;
+	struct affinity_set nodes;
+	bool all_nodes;
+	return numa_parse_memory_policy(policy, &mode, &nodes, &all_nodes);
+}
+
+int
+numa_set_memory_policy(void *addr, size_t size, const char *policy)
+{
+	int mode;
+	struct affinity_set nodes;
+	bool all_nodes;
+	if (numa_parse_memory_policy(policy, &mode, &nodes, &all_nodes) != 0)
+		return -1;
+#if defined(TARGET_OS_LINUX) && defined(SYS_mbind)
+	if (all_nodes && numa_online_nodes(&nodes) != 0)
+		return -1;
+	/* The kernel ignores the last bit of maxnode. */
+	if (syscall(SYS_mbind, addr, size, mode, nodes.bits,
+		    AFFINITY_SET_MAX + 1, 0) != 0) {
+		diag_set(SystemError, "failed to set NUMA memory policy "
+			 "'%s'", policy);
+		return -1;
+	}
+	return 0;
+#else
+	(void)addr;
+	(void)size;
+	(void)nodes;
+	(void)all_nodes;
+	(void)numa_online_nodes;
+	diag_set(IllegalParams, "NUMA memory policy is not supported "
+		 "on this platform");
+	return -1;
+#endif
+}
@@ -0,0 +1,99 @@
+#ifndef TARANTOOL_AFFINITY_H_INCLUDED
+#define TARANTOOL_AFFINITY_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Set the rules placing threads on CPUs. @a rules is a list of
+ * "<pattern>:<cpus>" entries separated by ';', where pattern is
+ * a fnmatch(3) pattern matched against the cord name and cpus
+ * is a list of CPU numbers and ranges, e.g.
+ * "tx:0;iproto*:1-2;wal:3;vinyl.*:4-7,12". The first matching
+ * entry applies. NULL or an empty string clears the rules.
+ *
+ * The rules apply to cords started after the call, see
+ * cord_affinity_apply().
+ *
+ * Return 0 on success, -1 and set diag on parse error.
+ */
+int
+cord_affinity_set(const char *rules);
+
+/**
+ * Check @a rules syntax, see cord_affinity_set().
+ * Return 0 if the rules are valid, -1 and set diag otherwise.
+ */
+int
+cord_affinity_check(const char *rules);
+
+/**
+ * Pin the calling thread to CPUs of the first rule matching
+ * @a name. Does nothing if no rule matches. A failure is only
+ * logged, since the thread works fine on any CPU.
+ */
+void
+cord_affinity_apply(const char *name);
+
+/**
+ * Set the NUMA memory policy of the memory range
+ * [@a addr, @a addr + @a size). @a policy is one of:
+ *
+ *  - "interleave" - interleave pages over all nodes;
+ *  - "interleave:<nodes>" - interleave over the given nodes;
+ *  - "bind:<nodes>" - allocate pages only on the given nodes;
+ *  - "preferred:<node>" - prefer the given node.
+ *
+ * Nodes are listed like CPUs in cord_affinity_set(). The policy
+ * applies to pages touched after the call by any thread, so it
+ * must be set before the memory is populated.
+ *
+ * Return 0 on success, -1 and set diag on error.
+ */
+int
+numa_set_memory_policy(void *addr, size_t size, const char *policy);
+
+/**
+ * Check @a policy syntax, see numa_set_memory_policy().
+ * Return 0 if the policy is valid, -1 and set diag otherwise.
+ */
+int
+numa_check_memory_policy(const char *policy);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_AFFINITY_H_INCLUDED */
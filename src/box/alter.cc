@@ -204,12 +204,51 @@ index_opts_decode(struct index_opts *opts, const char *map,
 			  BOX_INDEX_FIELD_OPTS,
 			  "run_size_ratio must be greater than 1");
 	}
+	if (opts->compaction_strategy == index_compaction_strategy_MAX) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+			  BOX_INDEX_FIELD_OPTS, "compaction_strategy must be "\
+			  "either 'leveled' or 'tiered'");
+	}
+	if (opts->hash_func == index_hash_func_MAX) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+			  BOX_INDEX_FIELD_OPTS, "hash_func must be "\
+			  "either 'murmur' or 'wyhash'");
+	}
 	if (opts->bloom_fpr <= 0 || opts->bloom_fpr > 1) {
 		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
 			  BOX_INDEX_FIELD_OPTS,
 			  "bloom_fpr must be greater than 0 and "
 			  "less than or equal to 1");
 	}
+	if (opts->blob_threshold < 0) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+			  BOX_INDEX_FIELD_OPTS,
+			  "blob_threshold must be greater than or equal to 0");
+	}
+	if (opts->page_restart_interval < 0 ||
+	    opts->page_restart_interval > UINT16_MAX) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+			  BOX_INDEX_FIELD_OPTS,
+			  "page_restart_interval must be in range [0, 65535]");
+	}
+	if (opts->columnar && opts->page_restart_interval > 0) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+			  BOX_INDEX_FIELD_OPTS,
+			  "columnar and page_restart_interval are "
+			  "mutually exclusive");
+	}
+	if (opts->compression_dict_size < 0 ||
+	    opts->compression_dict_size > 1024 * 1024) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+			  BOX_INDEX_FIELD_OPTS,
+			  "compression_dict_size must be in range "
+			  "[0, 1048576]");
+	}
+	if (opts->size_hint < 0 || opts->size_hint > UINT32_MAX) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+			  BOX_INDEX_FIELD_OPTS,
+			  "size_hint must be in range [0, 4294967295]");
+	}
 }
 
 /**
@@ -523,6 +562,14 @@ space_def_new_from_tuple(struct tuple *tuple, uint32_t errcode,
 	}
 	if (opts.is_view && opts.sql == NULL)
 		tnt_raise(ClientError, ER_VIEW_MISSING_SQL);
+	if (opts.memory_quota < 0) {
+		tnt_raise(ClientError, errcode, tt_cstr(name, name_len),
+			  "memory_quota must be >= 0");
+	}
+	if (opts.compression_threshold < 0) {
+		tnt_raise(ClientError, errcode, tt_cstr(name, name_len),
+			  "compression_threshold must be >= 0");
+	}
 	struct space_def *def =
 		space_def_new_xc(id, uid, exact_field_count, name, name_len,
 				 engine_name, engine_name_len, &opts, fields,
@@ -555,6 +602,7 @@ space_swap_triggers(struct space *new_space, struct space *old_space)
 {
 	rlist_swap(&new_space->before_replace, &old_space->before_replace);
 	rlist_swap(&new_space->on_replace, &old_space->on_replace);
+	rlist_swap(&new_space->on_commit_batch, &old_space->on_commit_batch);
 	rlist_swap(&new_space->on_stmt_begin, &old_space->on_stmt_begin);
 	/** Swap SQL Triggers pointer. */
 	struct sql_trigger *new_value = new_space->sql_triggers;
@@ -570,6 +618,15 @@ space_swap_fkeys(struct space *new_space, struct space *old_space)
 	rlist_swap(&new_space->parent_fkey, &old_space->parent_fkey);
 }
 
+/** Request statistics survive space alter as well. */
+static void
+space_swap_op_stat(struct space *new_space, struct space *old_space)
+{
+	struct space_op_stat tmp = new_space->op_stat;
+	new_space->op_stat = old_space->op_stat;
+	old_space->op_stat = tmp;
+}
+
 /**
  * True if the space has records identified by key 'uid'.
  * Uses 'iid' index.
@@ -784,6 +841,7 @@ alter_space_rollback(struct trigger *trigger, void * /* event */)
 	 */
 	space_swap_triggers(alter->new_space, alter->old_space);
 	space_swap_fkeys(alter->new_space, alter->old_space);
+	space_swap_op_stat(alter->new_space, alter->old_space);
 	space_cache_replace(alter->new_space, alter->old_space);
 	alter_space_delete(alter);
 }
@@ -876,11 +934,17 @@ alter_space_do(struct txn *txn, struct alter_space *alter)
 	/* Rebuild index maps once for all indexes. */
 	space_fill_index_map(alter->old_space);
 	space_fill_index_map(alter->new_space);
+	/*
+	 * Let the engine catch up with changes made to the old
+	 * space while new indexes were being built.
+	 */
+	space_finish_alter(alter->old_space, alter->new_space);
 	/*
 	 * Don't forget about space triggers and foreign keys.
 	 */
 	space_swap_triggers(alter->new_space, alter->old_space);
 	space_swap_fkeys(alter->new_space, alter->old_space);
+	space_swap_op_stat(alter->new_space, alter->old_space);
 	/*
 	 * The new space is ready. Time to update the space
 	 * cache with it.
@@ -2468,6 +2532,21 @@ func_cache_replace_func(struct trigger * /* trigger */, void *event)
 	def_guard.is_active = false;
 }
 
+/**
+ * space_foreach() callback stopping at a space having
+ * a functional index that uses the given function.
+ */
+static int
+space_has_func_index(struct space *space, void *arg)
+{
+	uint32_t fid = *(uint32_t *) arg;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		if (space->index[i]->def->opts.func_id == fid)
+			return 1;
+	}
+	return 0;
+}
+
 /**
  * A trigger invoked on replace in a space containing
  * functions on which there were defined any grants.
@@ -2509,6 +2588,12 @@ on_replace_dd_func(struct trigger * /* trigger */, void *event)
 				  (unsigned) old_func->def->uid,
 				  "function has grants");
 		}
+		/* Can only delete func if no index uses it. */
+		if (space_foreach(space_has_func_index, &fid) != 0) {
+			tnt_raise(ClientError, ER_DROP_FUNCTION,
+				  (unsigned) old_func->def->uid,
+				  "function is used by a functional index");
+		}
 		struct trigger *on_commit =
 			txn_alter_trigger_new(func_cache_remove_func, NULL);
 		txn_on_commit(txn, on_commit);
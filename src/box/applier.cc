@@ -48,6 +48,12 @@
 #include "error.h"
 #include "session.h"
 #include "cfg.h"
+#include "txn.h"
+#include "space.h"
+#include "schema.h"
+#include "index.h"
+#include "tuple_hash.h"
+#include "third_party/PMurHash.h"
 
 STRS(applier_state, applier_STATE);
 
@@ -81,6 +87,9 @@ applier_log_error(struct applier *applier, struct error *e)
 	case APPLIER_AUTH:
 		say_info("failed to authenticate");
 		break;
+	case APPLIER_REGISTER:
+		say_info("can't register");
+		break;
 	case APPLIER_SYNC:
 	case APPLIER_FOLLOW:
 	case APPLIER_INITIAL_JOIN:
@@ -268,6 +277,105 @@ done:
 	applier_set_state(applier, APPLIER_READY);
 }
 
+/**
+ * Decompress a batch of rows sent by the master in a zstd
+ * frame, see IPROTO_COMPRESSED_ROWS, to applier->zbuf.
+ */
+static void
+applier_decompress_rows(struct applier *applier,
+			const struct xrow_header *packet)
+{
+	const char *zdata = NULL;
+	uint32_t zsize = 0;
+	if (packet->bodycnt != 0) {
+		const char *d = (const char *)packet->body[0].iov_base;
+		const char *end = d + packet->body[0].iov_len;
+		const char *p = d;
+		if (mp_check(&p, end) != 0 || mp_typeof(*d) != MP_MAP)
+			goto error;
+		uint32_t map_size = mp_decode_map(&d);
+		for (uint32_t i = 0; i < map_size; i++) {
+			if (mp_typeof(*d) != MP_UINT) {
+				mp_next(&d); /* key */
+				mp_next(&d); /* value */
+				continue;
+			}
+			uint64_t key = mp_decode_uint(&d);
+			if (key != IPROTO_DATA || mp_typeof(*d) != MP_BIN) {
+				mp_next(&d); /* value */
+				continue;
+			}
+			zdata = mp_decode_bin(&d, &zsize);
+		}
+	}
+	if (zdata == NULL) {
+error:
+		tnt_raise(ClientError, ER_INVALID_MSGPACK, "compressed rows");
+	}
+	if (applier->zdctx == NULL) {
+		applier->zdctx = ZSTD_createDStream();
+		if (applier->zdctx == NULL) {
+			tnt_raise(ClientError, ER_DECOMPRESSION,
+				  "failed to create context");
+		}
+	}
+	ZSTD_initDStream(applier->zdctx);
+	struct ibuf *zbuf = &applier->zbuf;
+	ibuf_reset(zbuf);
+	ZSTD_inBuffer input = {zdata, zsize, 0};
+	size_t rc;
+	do {
+		size_t size = ZSTD_DStreamOutSize();
+		void *dst = ibuf_reserve(zbuf, size);
+		if (dst == NULL) {
+			tnt_raise(OutOfMemory, size, "ibuf_reserve",
+				  "decompression buffer");
+		}
+		ZSTD_outBuffer output = {dst, ibuf_unused(zbuf), 0};
+		rc = ZSTD_decompressStream(applier->zdctx, &output, &input);
+		if (ZSTD_isError(rc)) {
+			tnt_raise(ClientError, ER_DECOMPRESSION,
+				  ZSTD_getErrorName(rc));
+		}
+		zbuf->wpos += output.pos;
+		if (rc != 0 && input.pos == input.size &&
+		    output.pos < output.size) {
+			tnt_raise(ClientError, ER_DECOMPRESSION,
+				  "truncated frame");
+		}
+	} while (rc != 0);
+	if (ibuf_used(zbuf) > zsize)
+		applier->bytes_saved += ibuf_used(zbuf) - zsize;
+}
+
+/**
+ * Read the next row of the replication stream. Rows the
+ * master sends in compressed batches are returned one by one.
+ * The row body is valid until the next call.
+ */
+static void
+applier_read_row(struct applier *applier, struct xrow_header *row,
+		 double timeout)
+{
+	struct ibuf *zbuf = &applier->zbuf;
+	if (ibuf_used(zbuf) == 0) {
+		coio_read_xrow_timeout_xc(&applier->io, &applier->ibuf,
+					  row, timeout);
+		if (row->type != IPROTO_COMPRESSED_ROWS)
+			return;
+		applier_decompress_rows(applier, row);
+	}
+	const char *pos = zbuf->rpos;
+	const char *end = zbuf->wpos;
+	if (mp_typeof(*pos) != MP_UINT || mp_check_uint(pos, end) > 0)
+		tnt_raise(ClientError, ER_INVALID_MSGPACK, "packet length");
+	uint32_t len = mp_decode_uint(&pos);
+	if ((size_t)(end - pos) < len)
+		tnt_raise(ClientError, ER_INVALID_MSGPACK, "packet length");
+	xrow_header_decode_xc(row, &pos, pos + len);
+	zbuf->rpos = (char *)pos;
+}
+
 /**
  * Execute and process JOIN request (bootstrap the instance).
  */
@@ -278,7 +386,12 @@ applier_join(struct applier *applier)
 	struct ev_io *coio = &applier->io;
 	struct ibuf *ibuf = &applier->ibuf;
 	struct xrow_header row;
-	xrow_encode_join_xc(&row, &INSTANCE_UUID);
+	applier->compress = replication_compression;
+	const struct vclock *wait_vclock = NULL;
+	if (vclock_is_set(&applier->join_vclock))
+		wait_vclock = &applier->join_vclock;
+	xrow_encode_join_xc(&row, &INSTANCE_UUID, wait_vclock,
+			    applier->compress, replication_anon);
 	coio_write_xrow(coio, &row);
 
 	/**
@@ -311,7 +424,7 @@ applier_join(struct applier *applier)
 	assert(applier->join_stream != NULL);
 	uint64_t row_count = 0;
 	while (true) {
-		coio_read_xrow(coio, ibuf, &row);
+		applier_read_row(applier, &row, TIMEOUT_INFINITY);
 		applier->last_row_time = ev_monotonic_now(loop());
 		if (iproto_type_is_dml(row.type)) {
 			xstream_write_xc(applier->join_stream, &row);
@@ -352,7 +465,7 @@ applier_join(struct applier *applier)
 	 * Receive final data.
 	 */
 	while (true) {
-		coio_read_xrow(coio, ibuf, &row);
+		applier_read_row(applier, &row, TIMEOUT_INFINITY);
 		applier->last_row_time = ev_monotonic_now(loop());
 		if (iproto_type_is_dml(row.type)) {
 			vclock_follow_xrow(&replicaset.vclock, &row);
@@ -378,6 +491,645 @@ applier_join(struct applier *applier)
 	applier_set_state(applier, APPLIER_READY);
 }
 
+/**
+ * Register the instance in _cluster of the master without
+ * fetching any data, see IPROTO_REGISTER. The vclock of the
+ * master after registration is stored in applier->join_vclock.
+ */
+static void
+applier_register(struct applier *applier)
+{
+	struct ev_io *coio = &applier->io;
+	struct ibuf *ibuf = &applier->ibuf;
+	struct xrow_header row;
+	applier_set_state(applier, APPLIER_REGISTER);
+	xrow_encode_register_xc(&row, &INSTANCE_UUID);
+	coio_write_xrow(coio, &row);
+	coio_read_xrow(coio, ibuf, &row);
+	applier->last_row_time = ev_monotonic_now(loop());
+	if (iproto_type_is_error(row.type)) {
+		xrow_decode_error_xc(&row); /* re-throw error */
+	} else if (row.type != IPROTO_OK) {
+		tnt_raise(ClientError, ER_UNKNOWN_REQUEST_TYPE,
+			  (uint32_t) row.type);
+	}
+	vclock_create(&applier->join_vclock);
+	xrow_decode_vclock_xc(&row, &applier->join_vclock);
+	say_info("registered in the replica set");
+
+	applier_set_state(applier, APPLIER_REGISTERED);
+	applier_set_state(applier, APPLIER_READY);
+}
+
+/**
+ * Max number of rows the applier fiber may submit to parallel
+ * workers before it waits for some of them to be applied.
+ */
+enum { APPLIER_ROWS_IN_FLIGHT_MAX = 1024 };
+
+/** A fiber applying rows submitted by the applier fiber. */
+struct applier_worker {
+	/** The applier that owns this worker. */
+	struct applier *applier;
+	/** The worker fiber. */
+	struct fiber *fiber;
+	/** Rows to apply, linked by applier_row::in_queue. */
+	struct stailq queue;
+	/** Signaled when a row is added to the queue. */
+	struct fiber_cond cond;
+};
+
+/** A row submitted to a parallel applier worker. */
+struct applier_row {
+	/** Link in applier_worker::queue. */
+	struct stailq_entry in_queue;
+	/** The applier that submitted the row. */
+	struct applier *applier;
+	/** Order of the row in the applier stream. */
+	int64_t seq;
+	/** Set once the row has passed its turn to enter WAL. */
+	bool is_wal_turn_passed;
+	/** Trigger run by txn_commit() before writing to WAL. */
+	struct trigger on_wal_write;
+	/** The row itself. The body is stored after the struct. */
+	struct xrow_header row;
+};
+
+static struct applier_row *
+applier_row_new(struct xrow_header *row)
+{
+	size_t size = 0;
+	for (int i = 0; i < row->bodycnt; i++)
+		size += row->body[i].iov_len;
+	struct applier_row *r = (struct applier_row *)
+		malloc(sizeof(*r) + size);
+	if (r == NULL) {
+		diag_set(OutOfMemory, sizeof(*r) + size, "malloc",
+			 "struct applier_row");
+		return NULL;
+	}
+	/*
+	 * The row body points to the applier input buffer,
+	 * which is reused for the next rows, so copy it.
+	 */
+	r->row = *row;
+	char *data = (char *)(r + 1);
+	for (int i = 0; i < row->bodycnt; i++) {
+		memcpy(data, row->body[i].iov_base, row->body[i].iov_len);
+		data += row->body[i].iov_len;
+	}
+	r->row.bodycnt = size > 0 ? 1 : 0;
+	r->row.body[0].iov_base = (char *)(r + 1);
+	r->row.body[0].iov_len = size;
+	r->is_wal_turn_passed = false;
+	return r;
+}
+
+/**
+ * Return a field of a tuple in MsgPack or NULL if the tuple
+ * doesn't have it.
+ */
+static const char *
+applier_tuple_field(const char *tuple, uint32_t fieldno)
+{
+	if (mp_typeof(*tuple) != MP_ARRAY)
+		return NULL;
+	uint32_t field_count = mp_decode_array(&tuple);
+	if (fieldno >= field_count)
+		return NULL;
+	for (uint32_t i = 0; i < fieldno; i++)
+		mp_next(&tuple);
+	return tuple;
+}
+
+/**
+ * Check if rows of a space may be applied in parallel as long
+ * as they have different primary keys. It is true unless the
+ * space has a unique secondary index or anything else that
+ * makes a row depend on rows with other keys.
+ */
+static bool
+applier_space_is_parallel(struct space *space)
+{
+	if (space->def->id <= BOX_SYSTEM_ID_MAX ||
+	    space->index_count == 0 || space->sequence != NULL ||
+	    space->sql_triggers != NULL ||
+	    !rlist_empty(&space->before_replace) ||
+	    !rlist_empty(&space->on_replace) ||
+	    !rlist_empty(&space->parent_fkey) ||
+	    !rlist_empty(&space->child_fkey))
+		return false;
+	if (space->index[0]->def->key_def->has_json_paths)
+		return false;
+	for (uint32_t i = 1; i < space->index_count; i++) {
+		if (space->index[i]->def->opts.is_unique)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Pick a worker for a row by the space id and the primary key
+ * of the row. Return -1 if the row depends on rows with other
+ * keys and so has to be applied after all rows submitted
+ * before it.
+ */
+static int
+applier_row_worker(struct applier *applier, struct xrow_header *row)
+{
+	if (!iproto_type_is_dml(row->type) || row->type == IPROTO_NOP)
+		return -1;
+	struct request request;
+	if (xrow_decode_dml(row, &request,
+			    dml_request_key_map(row->type)) != 0) {
+		/* The error is raised when the row is applied. */
+		diag_clear(diag_get());
+		return -1;
+	}
+	struct space *space = space_by_id(request.space_id);
+	if (space == NULL || !applier_space_is_parallel(space))
+		return -1;
+	struct key_def *key_def = space->index[0]->def->key_def;
+
+	uint32_t h = request.space_id;
+	uint32_t carry = 0;
+	uint32_t total_size = 0;
+	switch (request.type) {
+	case IPROTO_INSERT:
+	case IPROTO_REPLACE:
+	case IPROTO_UPSERT:
+		for (uint32_t i = 0; i < key_def->part_count; i++) {
+			struct key_part *part = &key_def->parts[i];
+			const char *field = applier_tuple_field(request.tuple,
+								part->fieldno);
+			if (field == NULL)
+				return -1;
+			total_size += tuple_hash_field(&h, &carry, &field,
+						       part->coll);
+		}
+		break;
+	case IPROTO_UPDATE:
+	case IPROTO_DELETE: {
+		const char *key = request.key;
+		if (request.index_id != 0 || mp_typeof(*key) != MP_ARRAY ||
+		    mp_decode_array(&key) != key_def->part_count)
+			return -1;
+		for (uint32_t i = 0; i < key_def->part_count; i++) {
+			total_size += tuple_hash_field(&h, &carry, &key,
+						key_def->parts[i].coll);
+		}
+		break;
+	}
+	default:
+		return -1;
+	}
+	uint32_t hash = PMurHash32_Result(h, carry, total_size);
+	return hash % applier->worker_count;
+}
+
+/**
+ * Wait until all rows submitted to workers before the given one
+ * have entered WAL. Return false if the row must be dropped,
+ * because one of them has failed.
+ */
+static bool
+applier_wait_wal_turn(struct applier *applier, int64_t seq)
+{
+	while (true) {
+		if (applier->failed_seq < seq)
+			return false;
+		if (applier->wal_seq == seq)
+			return true;
+		fiber_cond_wait(&applier->apply_cond);
+	}
+}
+
+static void
+applier_pass_wal_turn(struct applier *applier, struct applier_row *row)
+{
+	assert(applier->wal_seq == row->seq);
+	applier->wal_seq++;
+	row->is_wal_turn_passed = true;
+	fiber_cond_broadcast(&applier->apply_cond);
+}
+
+/**
+ * Run by txn_commit() of a row applied by a worker when the
+ * row is about to be written to WAL. Rows of the same replica
+ * must enter WAL in the LSN order, so wait for the turn of the
+ * row here. Executing rows before this point may yield (vinyl
+ * reads from disk), that's where fibers run in parallel.
+ */
+static void
+applier_row_on_wal_write(struct trigger *trigger, void *event)
+{
+	(void) event;
+	struct applier_row *row = (struct applier_row *) trigger->data;
+	if (!applier_wait_wal_turn(row->applier, row->seq)) {
+		diag_set(FiberIsCancelled);
+		diag_raise();
+	}
+	/*
+	 * Nothing yields until the WAL request is queued, so
+	 * the next row can't overtake this one even though
+	 * it is woken up right now.
+	 */
+	applier_pass_wal_turn(row->applier, row);
+}
+
+static void
+applier_worker_apply(struct applier_worker *worker, struct applier_row *row)
+{
+	struct applier *applier = worker->applier;
+	if (applier->failed_seq < row->seq)
+		return;
+	int rc = -1;
+	/*
+	 * Begin an autocommit transaction beforehand, so that
+	 * apply_row() uses it and it can be ordered in WAL.
+	 */
+	struct txn *txn = txn_begin(true);
+	if (txn != NULL) {
+		trigger_create(&row->on_wal_write, applier_row_on_wal_write,
+			       row, NULL);
+		txn_on_wal_write(txn, &row->on_wal_write);
+		rc = xstream_write(applier->subscribe_stream, &row->row);
+		/* The row may fail before it starts a statement. */
+		if (in_txn() != NULL)
+			txn_rollback();
+	}
+	if (rc != 0) {
+		struct error *e = diag_last_error(diag_get());
+		if (!row->is_wal_turn_passed &&
+		    e->type == &type_ClientError &&
+		    box_error_code(e) == ER_TUPLE_FOUND &&
+		    replication_skip_conflict) {
+			diag_clear(diag_get());
+			rc = 0;
+		}
+	}
+	if (rc == 0) {
+		/* The row didn't need WAL, still pass the turn. */
+		if (!row->is_wal_turn_passed &&
+		    applier_wait_wal_turn(applier, row->seq))
+			applier_pass_wal_turn(applier, row);
+		return;
+	}
+	if (row->seq < applier->failed_seq) {
+		applier->failed_seq = row->seq;
+		diag_move(diag_get(), &applier->apply_diag);
+	}
+	diag_clear(diag_get());
+}
+
+static int
+applier_worker_f(va_list ap)
+{
+	struct applier_worker *worker = va_arg(ap, struct applier_worker *);
+	struct applier *applier = worker->applier;
+	struct session *session = session_create_on_demand();
+	if (session == NULL)
+		return -1;
+	session_set_type(session, SESSION_TYPE_APPLIER);
+
+	while (!fiber_is_cancelled()) {
+		if (stailq_empty(&worker->queue)) {
+			fiber_cond_wait(&worker->cond);
+			continue;
+		}
+		struct applier_row *row = stailq_shift_entry(&worker->queue,
+						struct applier_row, in_queue);
+		applier_worker_apply(worker, row);
+		free(row);
+		fiber_gc();
+		applier->rows_in_flight--;
+		fiber_cond_broadcast(&applier->apply_cond);
+		fiber_cond_broadcast(&replicaset.applier.apply_cond);
+	}
+	return 0;
+}
+
+/**
+ * Start fibers applying rows in parallel if it's configured.
+ */
+static void
+applier_start_workers(struct applier *applier)
+{
+	assert(applier->workers == NULL);
+	if (replication_apply_fibers <= 1)
+		return;
+	int count = replication_apply_fibers;
+	applier->workers = (struct applier_worker *)
+		calloc(count, sizeof(*applier->workers));
+	if (applier->workers == NULL) {
+		tnt_raise(OutOfMemory, count * sizeof(*applier->workers),
+			  "malloc", "struct applier_worker");
+	}
+	applier->rows_in_flight = 0;
+	applier->submit_seq = 0;
+	applier->wal_seq = 0;
+	applier->failed_seq = INT64_MAX;
+	for (int i = 0; i < count; i++) {
+		struct applier_worker *worker = &applier->workers[i];
+		worker->applier = applier;
+		stailq_create(&worker->queue);
+		fiber_cond_create(&worker->cond);
+
+		char name[FIBER_NAME_MAX];
+		int pos = snprintf(name, sizeof(name), "applierp/");
+		uri_format(name + pos, sizeof(name) - pos, &applier->uri,
+			   false);
+		worker->fiber = fiber_new_xc(name, applier_worker_f);
+		fiber_set_joinable(worker->fiber, true);
+		applier->worker_count++;
+		fiber_start(worker->fiber, worker);
+	}
+}
+
+/**
+ * Wait for the rows submitted to workers to be applied and
+ * stop the workers.
+ */
+static void
+applier_stop_workers(struct applier *applier)
+{
+	if (applier->workers == NULL)
+		return;
+	while (applier->rows_in_flight > 0)
+		fiber_cond_wait(&applier->apply_cond);
+	for (int i = 0; i < applier->worker_count; i++) {
+		struct applier_worker *worker = &applier->workers[i];
+		assert(stailq_empty(&worker->queue));
+		fiber_cancel(worker->fiber);
+		fiber_join(worker->fiber);
+		fiber_cond_destroy(&worker->cond);
+	}
+	free(applier->workers);
+	applier->workers = NULL;
+	applier->worker_count = 0;
+	diag_clear(&applier->apply_diag);
+	/*
+	 * Rows dropped after a failure are fetched again
+	 * on reconnect, don't let other appliers wait for them.
+	 */
+	struct replica *replica = replica_by_uuid(&applier->uuid);
+	if (replica != NULL)
+		replica->parallel_lsn = 0;
+	fiber_cond_broadcast(&replicaset.applier.apply_cond);
+}
+
+/**
+ * Wait until no more than the given number of rows submitted
+ * to workers is in flight. Fail if a worker failed to apply
+ * a row.
+ */
+static int
+applier_wait_rows_in_flight(struct applier *applier, int limit)
+{
+	while (applier->rows_in_flight > limit &&
+	       applier->failed_seq == INT64_MAX)
+		fiber_cond_wait(&applier->apply_cond);
+	if (applier->failed_seq != INT64_MAX) {
+		diag_move(&applier->apply_diag, diag_get());
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Wait until the rows of a replica submitted to parallel
+ * workers of its applier are applied, so that a row applied
+ * right away doesn't overtake them in WAL.
+ */
+static void
+applier_wait_parallel_rows(struct replica *replica)
+{
+	if (replica == NULL)
+		return;
+	while (replica->parallel_lsn >
+	       vclock_get(&replicaset.vclock, replica->id))
+		fiber_cond_wait(&replicaset.applier.apply_cond);
+}
+
+/**
+ * Apply a row in the applier fiber.
+ */
+static int
+applier_apply_row(struct applier *applier, struct xrow_header *row)
+{
+	if (xstream_write(applier->subscribe_stream, row) == 0)
+		return 0;
+	struct error *e = diag_last_error(diag_get());
+	/**
+	 * Silently skip ER_TUPLE_FOUND error if such
+	 * option is set in config.
+	 */
+	if (e->type == &type_ClientError &&
+	    box_error_code(e) == ER_TUPLE_FOUND &&
+	    replication_skip_conflict) {
+		diag_clear(diag_get());
+		return 0;
+	}
+	return -1;
+}
+
+/**
+ * Submit a row of the master to a parallel worker or apply it
+ * in the applier fiber after all rows submitted before it if
+ * it can't be applied in parallel.
+ */
+static int
+applier_submit_row(struct applier *applier, struct replica *replica,
+		   struct xrow_header *row)
+{
+	if (applier_wait_rows_in_flight(applier,
+					APPLIER_ROWS_IN_FLIGHT_MAX - 1) != 0)
+		return -1;
+	if (vclock_get(&replicaset.vclock, row->replica_id) >= row->lsn)
+		return 0;
+	int worker_id = applier_row_worker(applier, row);
+	if (worker_id < 0) {
+		if (applier_wait_rows_in_flight(applier, 0) != 0)
+			return -1;
+		return applier_apply_row(applier, row);
+	}
+	struct applier_row *r = applier_row_new(row);
+	if (r == NULL)
+		return -1;
+	r->applier = applier;
+	r->seq = applier->submit_seq++;
+	replica->parallel_lsn = row->lsn;
+	struct applier_worker *worker = &applier->workers[worker_id];
+	stailq_add_tail_entry(&worker->queue, r, in_queue);
+	applier->rows_in_flight++;
+	fiber_cond_signal(&worker->cond);
+	return 0;
+}
+
+/** A row of the master collected into a batch. */
+struct applier_batch_row {
+	/** Link in the batch. */
+	struct stailq_entry in_batch;
+	/** The row. The body is copied to the fiber region. */
+	struct xrow_header row;
+};
+
+/**
+ * Return the engine of the space a row modifies if the row may
+ * be applied in one transaction with other rows or NULL if it
+ * may not. Transactions can't do DDL, and spaces with triggers
+ * are skipped, because a trigger yielding in a multi-statement
+ * transaction aborts it in memtx.
+ */
+static struct engine *
+applier_batch_engine(struct xrow_header *row)
+{
+	if (!iproto_type_is_dml(row->type) || row->type == IPROTO_NOP)
+		return NULL;
+	struct request request;
+	if (xrow_decode_dml(row, &request,
+			    dml_request_key_map(row->type)) != 0) {
+		/* The error is raised when the row is applied. */
+		diag_clear(diag_get());
+		return NULL;
+	}
+	struct space *space = space_by_id(request.space_id);
+	if (space == NULL || space->def->id <= BOX_SYSTEM_ID_MAX ||
+	    space->sql_triggers != NULL ||
+	    !rlist_empty(&space->before_replace) ||
+	    !rlist_empty(&space->on_replace))
+		return NULL;
+	return space->engine;
+}
+
+/**
+ * Copy a row to the fiber region and append it to a batch.
+ * Input buffers of the applier are reused for the next rows,
+ * while a row must live until its transaction is committed.
+ */
+static void
+applier_batch_add(struct stailq *batch, struct xrow_header *row)
+{
+	struct region *region = &fiber()->gc;
+	struct applier_batch_row *r = (struct applier_batch_row *)
+		region_alloc_xc(region, sizeof(*r));
+	r->row = *row;
+	if (row->bodycnt > 0) {
+		assert(row->bodycnt == 1);
+		size_t size = row->body[0].iov_len;
+		void *data = region_alloc_xc(region, size);
+		memcpy(data, row->body[0].iov_base, size);
+		r->row.body[0].iov_base = data;
+	}
+	stailq_add_tail_entry(batch, r, in_batch);
+}
+
+/**
+ * Decode the next row received from the master without
+ * consuming it. Wait for the row to arrive until the deadline
+ * if it isn't buffered yet. Return false if there's no row.
+ *
+ * Unlike applier_read_row(), the function never stops in the
+ * middle of a row, so the row can be read later in any case.
+ */
+static bool
+applier_peek_row(struct applier *applier, struct xrow_header *row,
+		 double deadline)
+{
+	while (true) {
+		struct ibuf *buf = &applier->zbuf;
+		if (ibuf_used(buf) == 0)
+			buf = &applier->ibuf;
+		const char *pos = buf->rpos;
+		const char *end = buf->wpos;
+		/* A malformed packet is reported by the reader. */
+		if (pos != end && mp_typeof(*pos) != MP_UINT)
+			return false;
+		if (pos != end && mp_check_uint(pos, end) <= 0) {
+			uint32_t len = mp_decode_uint(&pos);
+			if ((size_t)(end - pos) >= len) {
+				if (xrow_header_decode(row, &pos,
+						       pos + len) != 0) {
+					diag_clear(diag_get());
+					return false;
+				}
+				if (row->type != IPROTO_COMPRESSED_ROWS ||
+				    buf == &applier->zbuf)
+					return true;
+				/*
+				 * Unpack the compressed rows to
+				 * look at the first of them.
+				 */
+				buf->rpos = (char *)pos;
+				applier_decompress_rows(applier, row);
+				continue;
+			}
+		}
+		double timeout = deadline - ev_monotonic_now(loop());
+		if (timeout <= 0)
+			return false;
+		if (coio_wait(applier->io.fd, COIO_READ, timeout) == 0)
+			return false;
+		/* EOF is reported by the reader. */
+		if (coio_bread(&applier->io, &applier->ibuf, 1) == 0)
+			return false;
+	}
+}
+
+/**
+ * Collect rows of the master that follow a row into a batch to
+ * be applied in one transaction, so that they are written to WAL
+ * at once. The batch is bounded by replication_apply_batch_rows
+ * and by replication_apply_batch_delay, which is how long to
+ * wait for the next row. Leave the batch empty if the row can't
+ * be applied in a batch.
+ */
+static void
+applier_collect_batch(struct applier *applier, struct xrow_header *row,
+		      struct stailq *batch)
+{
+	struct engine *engine = applier_batch_engine(row);
+	if (engine == NULL)
+		return;
+	applier_batch_add(batch, row);
+	double deadline = ev_monotonic_now(loop()) +
+			  replication_apply_batch_delay;
+	for (int count = 1; count < replication_apply_batch_rows; count++) {
+		struct xrow_header next;
+		if (!applier_peek_row(applier, &next, deadline) ||
+		    next.replica_id != row->replica_id ||
+		    applier_batch_engine(&next) != engine)
+			break;
+		applier_read_row(applier, &next, TIMEOUT_INFINITY);
+		applier->lag = ev_now(loop()) - next.tm;
+		applier->last_row_time = ev_monotonic_now(loop());
+		applier_batch_add(batch, &next);
+	}
+}
+
+/**
+ * Apply a batch of rows in one transaction. Rows that have
+ * already been applied via another applier are skipped.
+ */
+static int
+applier_apply_batch(struct applier *applier, struct stailq *batch)
+{
+	struct txn *txn = txn_begin(false);
+	if (txn == NULL)
+		return -1;
+	struct applier_batch_row *r;
+	stailq_foreach_entry(r, batch, in_batch) {
+		if (vclock_get(&replicaset.vclock,
+			       r->row.replica_id) >= r->row.lsn)
+			continue;
+		if (applier_apply_row(applier, &r->row) != 0) {
+			txn_rollback();
+			return -1;
+		}
+	}
+	return txn_commit(txn);
+}
+
 /**
  * Execute and process SUBSCRIBE request (follow updates from a master).
  */
@@ -393,8 +1145,10 @@ applier_subscribe(struct applier *applier)
 	struct vclock remote_vclock_at_subscribe;
 	struct tt_uuid cluster_id = uuid_nil;
 
+	applier->compress = replication_compression;
 	xrow_encode_subscribe_xc(&row, &REPLICASET_UUID, &INSTANCE_UUID,
-				 &replicaset.vclock);
+				 &replicaset.vclock, applier->compress,
+				 replication_anon);
 	coio_write_xrow(coio, &row);
 
 	/* Read SUBSCRIBE response */
@@ -474,6 +1228,8 @@ applier_subscribe(struct applier *applier)
 		fiber_start(applier->writer, applier);
 	}
 
+	applier_start_workers(applier);
+
 	applier->lag = TIMEOUT_INFINITY;
 
 	/*
@@ -508,10 +1264,10 @@ applier_subscribe(struct applier *applier)
 		 * broken - the master might just be idle.
 		 */
 		if (applier->version_id < version_id(1, 7, 7)) {
-			coio_read_xrow(coio, ibuf, &row);
+			applier_read_row(applier, &row, TIMEOUT_INFINITY);
 		} else {
 			double timeout = replication_disconnect_timeout();
-			coio_read_xrow_timeout_xc(coio, ibuf, &row, timeout);
+			applier_read_row(applier, &row, timeout);
 		}
 
 		if (iproto_type_is_error(row.type))
@@ -530,6 +1286,13 @@ applier_subscribe(struct applier *applier)
 
 		applier->lag = ev_now(loop()) - row.tm;
 		applier->last_row_time = ev_monotonic_now(loop());
+
+		struct stailq batch;
+		stailq_create(&batch);
+		if (applier->workers == NULL &&
+		    replication_apply_batch_rows > 1)
+			applier_collect_batch(applier, &row, &batch);
+
 		struct replica *replica = replica_by_id(row.replica_id);
 		struct latch *latch = (replica ? &replica->order_latch :
 				       &replicaset.applier.order_latch);
@@ -540,23 +1303,26 @@ applier_subscribe(struct applier *applier)
 		 * that belong to the same server id.
 		 */
 		latch_lock(latch);
-		if (vclock_get(&replicaset.vclock, row.replica_id) < row.lsn) {
-			int res = xstream_write(applier->subscribe_stream, &row);
-			if (res != 0) {
-				struct error *e = diag_last_error(diag_get());
-				/**
-				 * Silently skip ER_TUPLE_FOUND error if such
-				 * option is set in config.
-				 */
-				if (e->type == &type_ClientError &&
-				    box_error_code(e) == ER_TUPLE_FOUND &&
-				    replication_skip_conflict)
-					diag_clear(diag_get());
-				else {
-					latch_unlock(latch);
-					diag_raise();
-				}
-			}
+		int rc = 0;
+		if (!stailq_empty(&batch)) {
+			applier_wait_parallel_rows(replica);
+			rc = applier_apply_batch(applier, &batch);
+		} else if (applier->workers != NULL && replica != NULL &&
+		    replica->applier == applier) {
+			/*
+			 * Rows originating from the master itself
+			 * are applied in parallel.
+			 */
+			rc = applier_submit_row(applier, replica, &row);
+		} else {
+			applier_wait_parallel_rows(replica);
+			if (vclock_get(&replicaset.vclock,
+				       row.replica_id) < row.lsn)
+				rc = applier_apply_row(applier, &row);
+		}
+		if (rc != 0) {
+			latch_unlock(latch);
+			diag_raise();
 		}
 		latch_unlock(latch);
 
@@ -578,10 +1344,12 @@ applier_disconnect(struct applier *applier, enum applier_state state)
 		fiber_join(applier->writer);
 		applier->writer = NULL;
 	}
+	applier_stop_workers(applier);
 
 	coio_close(loop(), &applier->io);
 	/* Clear all unparsed input. */
 	ibuf_reinit(&applier->ibuf);
+	ibuf_reinit(&applier->zbuf);
 	fiber_gc();
 }
 
@@ -606,9 +1374,14 @@ applier_f(va_list ap)
 				/*
 				 * Execute JOIN if this is a bootstrap.
 				 * The join will pause the applier
-				 * until WAL is created.
+				 * until WAL is created. If the data
+				 * is joined from another replica,
+				 * only register on this master.
 				 */
-				applier_join(applier);
+				if (applier->register_only)
+					applier_register(applier);
+				else
+					applier_join(applier);
 			}
 			applier_subscribe(applier);
 			/*
@@ -724,6 +1497,7 @@ applier_new(const char *uri, struct xstream *join_stream,
 	}
 	coio_create(&applier->io, -1);
 	ibuf_create(&applier->ibuf, &cord()->slabc, 1024);
+	ibuf_create(&applier->zbuf, &cord()->slabc, 1024);
 
 	/* uri_parse() sets pointers to applier->source buffer */
 	snprintf(applier->source, sizeof(applier->source), "%s", uri);
@@ -734,10 +1508,13 @@ applier_new(const char *uri, struct xstream *join_stream,
 
 	applier->join_stream = join_stream;
 	applier->subscribe_stream = subscribe_stream;
+	vclock_clear(&applier->join_vclock);
 	applier->last_row_time = ev_monotonic_now(loop());
 	rlist_create(&applier->on_state);
 	fiber_cond_create(&applier->resume_cond);
 	fiber_cond_create(&applier->writer_cond);
+	fiber_cond_create(&applier->apply_cond);
+	diag_create(&applier->apply_diag);
 
 	return applier;
 }
@@ -747,10 +1524,15 @@ applier_delete(struct applier *applier)
 {
 	assert(applier->reader == NULL && applier->writer == NULL);
 	ibuf_destroy(&applier->ibuf);
+	ibuf_destroy(&applier->zbuf);
+	if (applier->zdctx != NULL)
+		ZSTD_freeDStream(applier->zdctx);
 	assert(applier->io.fd == -1);
 	trigger_destroy(&applier->on_state);
 	fiber_cond_destroy(&applier->resume_cond);
 	fiber_cond_destroy(&applier->writer_cond);
+	fiber_cond_destroy(&applier->apply_cond);
+	diag_destroy(&applier->apply_diag);
 	free(applier);
 }
 
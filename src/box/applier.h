@@ -36,6 +36,7 @@
 #include <tarantool_ev.h>
 
 #include <small/ibuf.h>
+#include <zstd.h>
 
 #include "fiber_cond.h"
 #include "trigger.h"
@@ -46,6 +47,7 @@
 #include "xrow.h"
 
 struct xstream;
+struct applier_worker;
 
 enum { APPLIER_SOURCE_MAXLEN = 1024 }; /* enough to fit URI with passwords */
 
@@ -63,6 +65,8 @@ enum { APPLIER_SOURCE_MAXLEN = 1024 }; /* enough to fit URI with passwords */
 	_(APPLIER_STOPPED, 10)                                       \
 	_(APPLIER_DISCONNECTED, 11)                                  \
 	_(APPLIER_LOADING, 12)                                       \
+	_(APPLIER_REGISTER, 13)                                      \
+	_(APPLIER_REGISTERED, 14)                                    \
 
 /** States for the applier */
 ENUM(applier_state, applier_STATE);
@@ -107,6 +111,17 @@ struct applier {
 	struct ev_io io;
 	/** Input buffer */
 	struct ibuf ibuf;
+	/**
+	 * Set if the master was asked to send rows in compressed
+	 * batches, see IPROTO_COMPRESSED_ROWS.
+	 */
+	bool compress;
+	/** Rows decompressed from the last batch. */
+	struct ibuf zbuf;
+	/** zstd decompression context, created on demand. */
+	ZSTD_DStream *zdctx;
+	/** Number of bytes saved by compression of received rows. */
+	uint64_t bytes_saved;
 	/** Triggers invoked on state change */
 	struct rlist on_state;
 	/**
@@ -116,10 +131,45 @@ struct applier {
 	bool is_paused;
 	/** Condition variable signaled to resume the applier. */
 	struct fiber_cond resume_cond;
+	/**
+	 * Set on bootstrap if the data is joined from another
+	 * replica: the applier only REGISTERs the instance on
+	 * this master instead of JOINing it.
+	 */
+	bool register_only;
+	/**
+	 * After REGISTER, the vclock of the master right after
+	 * registration. Before JOIN, the vclock the remote
+	 * instance must reach before it sends any data, so that
+	 * the registration is included. Cleared if unused.
+	 */
+	struct vclock join_vclock;
 	/** xstream to process rows during initial JOIN */
 	struct xstream *join_stream;
 	/** xstream to process rows during final JOIN and SUBSCRIBE */
 	struct xstream *subscribe_stream;
+	/**
+	 * Fibers applying rows of the master in parallel or NULL
+	 * if rows are applied by the applier fiber itself.
+	 */
+	struct applier_worker *workers;
+	/** Number of entries in the workers array. */
+	int worker_count;
+	/** Number of rows submitted to workers and not done yet. */
+	int rows_in_flight;
+	/** Sequence number of the next row submitted to workers. */
+	int64_t submit_seq;
+	/** Sequence number of the next row allowed to enter WAL. */
+	int64_t wal_seq;
+	/**
+	 * Sequence number of the first row a worker failed to
+	 * apply or INT64_MAX. Rows submitted after it are dropped.
+	 */
+	int64_t failed_seq;
+	/** The error the row at failed_seq failed with. */
+	struct diag apply_diag;
+	/** Signaled whenever a row submitted to workers moves on. */
+	struct fiber_cond apply_cond;
 };
 
 /**
@@ -0,0 +1,254 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "backup.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trivia/config.h"
+#include "trivia/util.h"
+#include "tarantool_ev.h"
+#include "coio_task.h"
+#include "diag.h"
+#include "error.h"
+#include "fio.h"
+#include "say.h"
+
+enum {
+	/** Size of a tar block, all entries are padded to it. */
+	TAR_BLOCK_SIZE = 512,
+	/** Size of chunks files are copied in. */
+	BACKUP_CHUNK_SIZE = 1024 * 1024,
+};
+
+/** POSIX ustar header of an archive entry. */
+struct tar_header {
+	char name[100];
+	char mode[8];
+	char uid[8];
+	char gid[8];
+	char size[12];
+	char mtime[12];
+	char chksum[8];
+	char typeflag;
+	char linkname[100];
+	char magic[6];
+	char version[2];
+	char uname[32];
+	char gname[32];
+	char devmajor[8];
+	char devminor[8];
+	char prefix[155];
+	char pad[12];
+};
+
+static_assert(sizeof(struct tar_header) == TAR_BLOCK_SIZE,
+	      "tar header must occupy exactly one block");
+
+void
+backup_stream_create(struct backup_stream *stream, int fd,
+		     double rate_limit)
+{
+	stream->fd = fd;
+	stream->rate_limit = rate_limit;
+	stream->size = 0;
+}
+
+static int
+backup_stream_write(struct backup_stream *stream, const void *buf,
+		    size_t size)
+{
+	if (fio_writen(stream->fd, buf, size) != 0) {
+		diag_set(SystemError, "failed to write backup stream");
+		return -1;
+	}
+	stream->size += size;
+	return 0;
+}
+
+/**
+ * Store a file size in a header field. Sizes that don't fit
+ * in 11 octal digits (8 GB) use the base-256 encoding
+ * understood by GNU and BSD tar.
+ */
+static void
+tar_header_set_size(struct tar_header *header, uint64_t size)
+{
+	if (size < (1ULL << 33)) {
+		snprintf(header->size, sizeof(header->size), "%011llo",
+			 (unsigned long long)size);
+		return;
+	}
+	memset(header->size, 0, sizeof(header->size));
+	for (int i = sizeof(header->size) - 1; i > 0; i--) {
+		header->size[i] = (char)(size & 0xff);
+		size >>= 8;
+	}
+	header->size[0] = (char)0x80;
+}
+
+/**
+ * Fill in the header of a regular file entry.
+ * Returns -1 if the path is too long for the ustar format.
+ */
+static int
+tar_header_create(struct tar_header *header, const char *path,
+		  const struct stat *st)
+{
+	memset(header, 0, sizeof(*header));
+	while (*path == '/')
+		path++;
+	size_t len = strlen(path);
+	if (len < sizeof(header->name)) {
+		memcpy(header->name, path, len);
+	} else {
+		/*
+		 * Split the path at a slash so that the
+		 * directory part goes to the prefix field.
+		 */
+		const char *sep = path + len - sizeof(header->name);
+		sep = strchr(sep, '/');
+		if (sep == NULL || sep - path >= (int)sizeof(header->prefix)) {
+			diag_set(ClientError, ER_UNSUPPORTED, "Backup stream",
+				 "file paths longer than 255 bytes");
+			return -1;
+		}
+		memcpy(header->prefix, path, sep - path);
+		memcpy(header->name, sep + 1, path + len - sep - 1);
+	}
+	snprintf(header->mode, sizeof(header->mode), "%07o",
+		 (unsigned)(st->st_mode & 0777));
+	snprintf(header->uid, sizeof(header->uid), "%07o", 0);
+	snprintf(header->gid, sizeof(header->gid), "%07o", 0);
+	tar_header_set_size(header, st->st_size);
+	snprintf(header->mtime, sizeof(header->mtime), "%011llo",
+		 (unsigned long long)st->st_mtime);
+	header->typeflag = '0';
+	memcpy(header->magic, "ustar", sizeof(header->magic));
+	memcpy(header->version, "00", sizeof(header->version));
+
+	memset(header->chksum, ' ', sizeof(header->chksum));
+	unsigned chksum = 0;
+	const unsigned char *p = (const unsigned char *)header;
+	for (size_t i = 0; i < sizeof(*header); i++)
+		chksum += p[i];
+	snprintf(header->chksum, sizeof(header->chksum), "%06o", chksum);
+	return 0;
+}
+
+static ssize_t
+backup_stream_add_file_f(va_list ap)
+{
+	struct backup_stream *stream = va_arg(ap, struct backup_stream *);
+	const char *path = va_arg(ap, const char *);
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		diag_set(SystemError, "failed to open file '%s'", path);
+		return -1;
+	}
+	char *buf = NULL;
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		diag_set(SystemError, "failed to stat file '%s'", path);
+		goto fail;
+	}
+	struct tar_header header;
+	if (tar_header_create(&header, path, &st) != 0 ||
+	    backup_stream_write(stream, &header, sizeof(header)) != 0)
+		goto fail;
+#ifdef HAVE_POSIX_FADVISE
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+	buf = malloc(BACKUP_CHUNK_SIZE);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, BACKUP_CHUNK_SIZE, "malloc", "buf");
+		goto fail;
+	}
+	double start = ev_monotonic_time();
+	off_t offset = 0;
+	while (offset < st.st_size) {
+		size_t len = MIN(st.st_size - offset, BACKUP_CHUNK_SIZE);
+		ssize_t n = fio_pread(fd, buf, len, offset);
+		if (n < 0) {
+			diag_set(SystemError, "failed to read file '%s'", path);
+			goto fail;
+		}
+		if ((size_t)n < len) {
+			/* The file was truncated: pad with zeros. */
+			memset(buf + n, 0, len - n);
+		}
+		if (backup_stream_write(stream, buf, len) != 0)
+			goto fail;
+#ifdef HAVE_POSIX_FADVISE
+		/* Don't let the backup evict the hot data. */
+		posix_fadvise(fd, offset, len, POSIX_FADV_DONTNEED);
+#endif
+		offset += len;
+		if (stream->rate_limit > 0) {
+			double throttle_time = offset / stream->rate_limit -
+					       (ev_monotonic_time() - start);
+			if (throttle_time > 0)
+				ev_sleep(throttle_time);
+		}
+	}
+	free(buf);
+	close(fd);
+	size_t padding = (TAR_BLOCK_SIZE - st.st_size % TAR_BLOCK_SIZE) %
+			 TAR_BLOCK_SIZE;
+	static const char zeros[TAR_BLOCK_SIZE];
+	return backup_stream_write(stream, zeros, padding);
+fail:
+	free(buf);
+	close(fd);
+	return -1;
+}
+
+int
+backup_stream_add_file(struct backup_stream *stream, const char *path)
+{
+	say_info("streaming backup file '%s'", path);
+	return coio_call(backup_stream_add_file_f, stream, path) < 0 ? -1 : 0;
+}
+
+int
+backup_stream_finish(struct backup_stream *stream)
+{
+	static const char zeros[2 * TAR_BLOCK_SIZE];
+	return backup_stream_write(stream, zeros, sizeof(zeros));
+}
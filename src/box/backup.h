@@ -0,0 +1,90 @@
+#ifndef TARANTOOL_BOX_BACKUP_H_INCLUDED
+#define TARANTOOL_BOX_BACKUP_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Server-side backup streaming.
+ *
+ * Files pinned by box_backup_start() are written one after
+ * another to a file descriptor (a regular file, a pipe or a
+ * socket) in the POSIX ustar format, so that the receiving side
+ * can unpack the backup with tar(1). Files are read in a coio
+ * thread, optionally at a limited rate, and the page cache is
+ * released after each chunk is read so that streaming a backup
+ * does not evict the hot data of the instance.
+ */
+struct backup_stream {
+	/** File descriptor the archive is written to. */
+	int fd;
+	/** Max read rate, in bytes per second, 0 if unlimited. */
+	double rate_limit;
+	/** Number of bytes written so far. */
+	uint64_t size;
+};
+
+/** Create a stream writing an archive to @fd. */
+void
+backup_stream_create(struct backup_stream *stream, int fd,
+		     double rate_limit);
+
+/**
+ * Append a file to the archive. Only the part of the file that
+ * exists at the time of the call is written, so a file that is
+ * being appended to (e.g. the current WAL) is copied up to its
+ * current size. The file is stored under its path with leading
+ * slashes stripped.
+ *
+ * Returns 0 on success, -1 on error (diag is set).
+ */
+int
+backup_stream_add_file(struct backup_stream *stream, const char *path);
+
+/**
+ * Write the end-of-archive marker. The file descriptor is
+ * not closed.
+ *
+ * Returns 0 on success, -1 on error (diag is set).
+ */
+int
+backup_stream_finish(struct backup_stream *stream);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_BACKUP_H_INCLUDED */
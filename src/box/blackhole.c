@@ -129,6 +129,8 @@ static const struct space_vtab blackhole_space_vtab = {
 	/* .build_index = */ generic_space_build_index,
 	/* .swap_index = */ generic_space_swap_index,
 	/* .prepare_alter = */ generic_space_prepare_alter,
+	/* .finish_alter = */ generic_space_finish_alter,
+	/* .bulk_load = */ generic_space_bulk_load,
 };
 
 static void
@@ -158,7 +160,7 @@ blackhole_engine_create_space(struct engine *engine, struct space_def *def,
 	format = tuple_format_new(&tuple_format_runtime->vtab, NULL, NULL, 0,
 				  def->fields, def->field_count,
 				  def->exact_field_count, def->dict, false,
-				  false);
+				  false, false, false);
 	if (format == NULL) {
 		free(space);
 		return NULL;
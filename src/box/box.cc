@@ -30,6 +30,8 @@
  */
 #include "box/box.h"
 
+#include <fcntl.h>
+
 #include "trivia/config.h"
 
 #include "lua/utils.h" /* lua_hash() */
@@ -61,6 +63,8 @@
 #include "user.h"
 #include "cfg.h"
 #include "coio.h"
+#include "io_ring.h"
+#include "affinity.h"
 #include "replication.h" /* replica */
 #include "title.h"
 #include "xrow.h"
@@ -69,11 +73,19 @@
 #include "authentication.h"
 #include "path_lock.h"
 #include "gc.h"
+#include "gc_remove.h"
+#include "expire.h"
 #include "sql.h"
+#include "sql_stmt_cache.h"
+#include "lua/call.h"
 #include "systemd.h"
 #include "call.h"
 #include "func.h"
 #include "sequence.h"
+#include "column_mask.h"
+#include "synchro.h"
+#include "backup.h"
+#include "salad/stailq.h"
 
 static char status[64] = "unknown";
 
@@ -105,6 +117,9 @@ static bool backup_is_in_progress;
  */
 static struct gc_checkpoint_ref backup_gc;
 
+/** Vclock of the checkpoint pinned by backup_gc. */
+static struct vclock backup_vclock;
+
 /**
  * The instance is in read-write mode: the local checkpoint
  * and all write ahead logs are processed. For a replica,
@@ -132,6 +147,11 @@ static struct xstream subscribe_stream;
  * threads.
  */
 static struct fiber_pool tx_fiber_pool;
+/**
+ * Fiber pool serving iproto requests with IPROTO_PRIORITY,
+ * so they don't queue behind bulk requests in tx_fiber_pool.
+ */
+static struct fiber_pool tx_high_fiber_pool;
 /**
  * A separate endpoint for WAL wakeup messages, to
  * ensure that WAL messages are delivered even
@@ -190,6 +210,13 @@ box_process_rw(struct request *request, struct space *space,
 	*result = tuple;
 	if (tuple == NULL)
 		return txn_commit_stmt(txn, request);
+	/* The engine may store the tuple compressed. */
+	tuple = tuple_unpack(tuple);
+	if (tuple == NULL) {
+		txn_rollback_stmt();
+		return -1;
+	}
+	*result = tuple;
 	/*
 	 * Pin the tuple locally before the commit,
 	 * otherwise it may go away during yield in
@@ -222,6 +249,10 @@ process_nop(struct request *request)
 void
 box_set_ro(bool ro)
 {
+	if (!ro && replication_anon) {
+		tnt_raise(ClientError, ER_CFG, "read_only",
+			  "an anonymous replica must be read-only");
+	}
 	is_ro = ro;
 	fiber_cond_broadcast(&ro_cond);
 }
@@ -402,6 +433,19 @@ box_check_say()
 		tnt_raise(ClientError, ER_CFG, "log_nonblock",
 			  "the option is incompatible with file/stderr logger");
 	}
+	const char *log_async = cfg_gets("log_async");
+	if (log_async != NULL) {
+		if (strcmp(log_async, "drop") != 0 &&
+		    strcmp(log_async, "block_errors") != 0) {
+			tnt_raise(ClientError, ER_CFG, "log_async",
+				  "expected 'drop' or 'block_errors'");
+		}
+		if (type == SAY_LOGGER_SYSLOG || type == SAY_LOGGER_STDERR) {
+			tnt_raise(ClientError, ER_CFG, "log_async",
+				  "the option is incompatible with "
+				  "syslog/stderr logger");
+		}
+	}
 }
 
 static void
@@ -523,6 +567,166 @@ box_check_readahead(int readahead)
 	}
 }
 
+static void
+box_check_iproto_threads(int iproto_threads)
+{
+	if (iproto_threads < 1 || iproto_threads > IPROTO_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "iproto_threads",
+			  tt_sprintf("must be in range [1, %d]",
+				     IPROTO_THREADS_MAX));
+	}
+}
+
+static int
+box_check_replication_apply_fibers(void)
+{
+	int count = cfg_geti("replication_apply_fibers");
+	if (count < 1 || count > REPLICATION_APPLY_FIBERS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "replication_apply_fibers",
+			  tt_sprintf("must be in range [1, %d]",
+				     REPLICATION_APPLY_FIBERS_MAX));
+	}
+	return count;
+}
+
+static int
+box_check_replication_apply_batch_rows(void)
+{
+	int rows = cfg_geti("replication_apply_batch_rows");
+	if (rows < 1 || rows > REPLICATION_APPLY_BATCH_ROWS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "replication_apply_batch_rows",
+			  tt_sprintf("must be in range [1, %d]",
+				     REPLICATION_APPLY_BATCH_ROWS_MAX));
+	}
+	return rows;
+}
+
+static double
+box_check_replication_apply_batch_delay(void)
+{
+	double delay = cfg_getd("replication_apply_batch_delay");
+	if (delay < 0) {
+		tnt_raise(ClientError, ER_CFG, "replication_apply_batch_delay",
+			  "must not be less than 0");
+	}
+	return delay;
+}
+
+static int
+box_check_replication_synchro_quorum(void)
+{
+	int quorum = cfg_geti("replication_synchro_quorum");
+	if (quorum < 1 || quorum > VCLOCK_MAX) {
+		tnt_raise(ClientError, ER_CFG, "replication_synchro_quorum",
+			  tt_sprintf("must be in range [1, %d]", VCLOCK_MAX));
+	}
+	return quorum;
+}
+
+static double
+box_check_replication_synchro_timeout(void)
+{
+	double timeout = cfg_getd("replication_synchro_timeout");
+	if (timeout <= 0) {
+		tnt_raise(ClientError, ER_CFG, "replication_synchro_timeout",
+			  "the value must be greater than 0");
+	}
+	return timeout;
+}
+
+static bool
+box_check_replication_anon(void)
+{
+	bool anon = cfg_geti("replication_anon") != 0;
+	if (anon && cfg_geti("read_only") == 0) {
+		tnt_raise(ClientError, ER_CFG, "replication_anon",
+			  "an anonymous replica must be read-only");
+	}
+	return anon;
+}
+
+static int64_t
+box_check_iproto_zero_copy_threshold(int64_t threshold)
+{
+	if (threshold < 0) {
+		tnt_raise(ClientError, ER_CFG, "iproto_zero_copy_threshold",
+			  "the value must be greater or equal to 0");
+	}
+	return threshold;
+}
+
+static int64_t
+box_check_eval_cache_size(int64_t size)
+{
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "eval_cache_size",
+			  "the value must be greater or equal to 0");
+	}
+	return size;
+}
+
+static int64_t
+box_check_sql_cache_size(int64_t size)
+{
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "sql_cache_size",
+			  "the value must be greater or equal to 0");
+	}
+	return size;
+}
+
+static double
+box_check_wal_batch_delay(double delay)
+{
+	if (delay < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_batch_delay",
+			  "the value must be greater or equal to 0");
+	}
+	return delay;
+}
+
+static int64_t
+box_check_wal_batch_max_size(int64_t size)
+{
+	if (size <= 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_batch_max_size",
+			  "the value must be greater than 0");
+	}
+	return size;
+}
+
+static int
+box_check_wal_compress_threads(int threads)
+{
+	if (threads < 1 || threads > WAL_COMPRESS_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "wal_compress_threads",
+			  tt_sprintf("must be in range [1, %d]",
+				     WAL_COMPRESS_THREADS_MAX));
+	}
+	return threads;
+}
+
+static int
+box_check_memtx_snap_threads(int threads)
+{
+	if (threads < 1 || threads > MEMTX_SNAP_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "memtx_snap_threads",
+			  tt_sprintf("must be in range [1, %d]",
+				     MEMTX_SNAP_THREADS_MAX));
+	}
+	return threads;
+}
+
+static int
+box_check_memtx_snap_delta_max(int delta_max)
+{
+	if (delta_max < 0) {
+		tnt_raise(ClientError, ER_CFG, "memtx_snap_delta_max",
+			  "the value must not be less than 0");
+	}
+	return delta_max;
+}
+
 static void
 box_check_checkpoint_count(int checkpoint_count)
 {
@@ -554,6 +758,26 @@ box_check_wal_max_size(int64_t wal_max_size)
 	return wal_max_size;
 }
 
+static int64_t
+box_check_wal_ring_size(int64_t wal_ring_size)
+{
+	if (wal_ring_size < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_ring_size",
+			  "must not be less than 0");
+	}
+	return wal_ring_size;
+}
+
+static int
+box_check_wal_spare_files(int wal_spare_files)
+{
+	if (wal_spare_files < 0 || wal_spare_files > 16) {
+		tnt_raise(ClientError, ER_CFG, "wal_spare_files",
+			  "must be between 0 and 16");
+	}
+	return wal_spare_files;
+}
+
 static int64_t
 box_check_memtx_memory(int64_t memory)
 {
@@ -564,6 +788,24 @@ box_check_memtx_memory(int64_t memory)
 	return memory;
 }
 
+static void
+box_check_thread_affinity(const char *rules)
+{
+	if (cord_affinity_check(rules) != 0) {
+		tnt_raise(ClientError, ER_CFG, "thread_affinity",
+			  diag_last_error(diag_get())->errmsg);
+	}
+}
+
+static void
+box_check_memtx_numa_policy(const char *policy)
+{
+	if (policy != NULL && numa_check_memory_policy(policy) != 0) {
+		tnt_raise(ClientError, ER_CFG, "memtx_numa_policy",
+			  diag_last_error(diag_get())->errmsg);
+	}
+}
+
 static int64_t
 box_check_vinyl_memory(int64_t memory)
 {
@@ -574,6 +816,16 @@ box_check_vinyl_memory(int64_t memory)
 	return memory;
 }
 
+static double
+box_check_vinyl_read_latency_budget(double budget)
+{
+	if (budget < 0) {
+		tnt_raise(ClientError, ER_CFG, "vinyl_read_latency_budget",
+			  "must not be less than 0");
+	}
+	return budget;
+}
+
 static void
 box_check_vinyl_options(void)
 {
@@ -586,6 +838,8 @@ box_check_vinyl_options(void)
 	double bloom_fpr = cfg_getd("vinyl_bloom_fpr");
 
 	box_check_vinyl_memory(cfg_geti64("vinyl_memory"));
+	box_check_vinyl_read_latency_budget(
+			cfg_getd("vinyl_read_latency_budget"));
 
 	if (read_threads < 1) {
 		tnt_raise(ClientError, ER_CFG, "vinyl_read_threads",
@@ -628,13 +882,33 @@ box_check_config()
 	box_check_replication_connect_quorum();
 	box_check_replication_sync_lag();
 	box_check_replication_sync_timeout();
+	box_check_replication_apply_fibers();
+	box_check_replication_apply_batch_rows();
+	box_check_replication_apply_batch_delay();
+	box_check_replication_synchro_quorum();
+	box_check_replication_synchro_timeout();
+	box_check_replication_anon();
 	box_check_readahead(cfg_geti("readahead"));
+	box_check_iproto_threads(cfg_geti("iproto_threads"));
+	box_check_iproto_zero_copy_threshold(
+		cfg_geti64("iproto_zero_copy_threshold"));
+	box_check_sql_cache_size(cfg_geti64("sql_cache_size"));
+	box_check_eval_cache_size(cfg_geti64("eval_cache_size"));
 	box_check_checkpoint_count(cfg_geti("checkpoint_count"));
 	box_check_wal_max_rows(cfg_geti64("rows_per_wal"));
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
+	box_check_wal_ring_size(cfg_geti64("wal_ring_size"));
+	box_check_wal_spare_files(cfg_geti("wal_spare_files"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
+	box_check_wal_batch_delay(cfg_getd("wal_batch_delay"));
+	box_check_wal_batch_max_size(cfg_geti64("wal_batch_max_size"));
+	box_check_wal_compress_threads(cfg_geti("wal_compress_threads"));
 	box_check_memtx_memory(cfg_geti64("memtx_memory"));
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
+	box_check_memtx_snap_threads(cfg_geti("memtx_snap_threads"));
+	box_check_memtx_snap_delta_max(cfg_geti("memtx_snap_delta_max"));
+	box_check_memtx_numa_policy(cfg_gets("memtx_numa_policy"));
+	box_check_thread_affinity(cfg_gets("thread_affinity"));
 	box_check_vinyl_options();
 }
 
@@ -759,6 +1033,48 @@ box_set_replication_skip_conflict(void)
 	replication_skip_conflict = cfg_geti("replication_skip_conflict");
 }
 
+void
+box_set_replication_apply_fibers(void)
+{
+	/* Takes effect when an applier subscribes next time. */
+	replication_apply_fibers = box_check_replication_apply_fibers();
+}
+
+void
+box_set_replication_compression(void)
+{
+	/* Takes effect when an applier reconnects. */
+	replication_compression = cfg_geti("replication_compression");
+}
+
+void
+box_set_replication_apply_batch_rows(void)
+{
+	replication_apply_batch_rows =
+		box_check_replication_apply_batch_rows();
+}
+
+void
+box_set_replication_apply_batch_delay(void)
+{
+	replication_apply_batch_delay =
+		box_check_replication_apply_batch_delay();
+}
+
+void
+box_set_replication_synchro_quorum(void)
+{
+	replication_synchro_quorum = box_check_replication_synchro_quorum();
+	/* Waiters may have got enough acks for the new quorum. */
+	synchro_update();
+}
+
+void
+box_set_replication_synchro_timeout(void)
+{
+	replication_synchro_timeout = box_check_replication_synchro_timeout();
+}
+
 void
 box_listen(void)
 {
@@ -802,6 +1118,37 @@ box_set_snap_io_rate_limit(void)
 			cfg_getd("snap_io_rate_limit"));
 }
 
+void
+box_set_gc_remove_rate_limit(void)
+{
+	double limit = cfg_getd("gc_remove_rate_limit");
+	if (limit < 0) {
+		tnt_raise(ClientError, ER_CFG, "gc_remove_rate_limit",
+			  "must not be less than 0");
+	}
+	gc_remove_set_rate(limit * 1024 * 1024);
+}
+
+void
+box_set_memtx_snap_threads(void)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_snap_threads(memtx,
+		box_check_memtx_snap_threads(cfg_geti("memtx_snap_threads")));
+}
+
+void
+box_set_memtx_snap_delta_max(void)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_snap_delta_max(memtx,
+		box_check_memtx_snap_delta_max(cfg_geti("memtx_snap_delta_max")));
+}
+
 void
 box_set_memtx_memory(void)
 {
@@ -856,6 +1203,17 @@ box_set_checkpoint_interval(void)
 	gc_set_checkpoint_interval(interval);
 }
 
+void
+box_set_checkpoint_load_window(void)
+{
+	double window = cfg_getd("checkpoint_load_window");
+	if (window < 0) {
+		tnt_raise(ClientError, ER_CFG, "checkpoint_load_window",
+			  "must not be less than 0");
+	}
+	gc_set_checkpoint_window(window);
+}
+
 void
 box_set_checkpoint_wal_threshold(void)
 {
@@ -863,6 +1221,29 @@ box_set_checkpoint_wal_threshold(void)
 	wal_set_checkpoint_threshold(threshold);
 }
 
+void
+box_set_wal_batch_delay(void)
+{
+	double delay = box_check_wal_batch_delay(cfg_getd("wal_batch_delay"));
+	wal_set_batch_delay(delay);
+}
+
+void
+box_set_wal_batch_max_size(void)
+{
+	int64_t size = box_check_wal_batch_max_size(
+			cfg_geti64("wal_batch_max_size"));
+	wal_set_batch_max_size(size);
+}
+
+void
+box_set_wal_compress_threads(void)
+{
+	int threads = box_check_wal_compress_threads(
+			cfg_geti("wal_compress_threads"));
+	wal_set_compress_threads(threads);
+}
+
 void
 box_set_vinyl_memory(void)
 {
@@ -892,6 +1273,33 @@ box_set_vinyl_cache(void)
 	vinyl_engine_set_cache(vinyl, cfg_geti64("vinyl_cache"));
 }
 
+void
+box_set_vinyl_page_cache(void)
+{
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_page_cache(vinyl, cfg_geti64("vinyl_page_cache"));
+}
+
+void
+box_set_vinyl_read_ahead(void)
+{
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_read_ahead(vinyl, cfg_geti64("vinyl_read_ahead"));
+}
+
+void
+box_set_vinyl_index_cache(void)
+{
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_index_cache(vinyl, cfg_geti64("vinyl_index_cache"));
+}
+
 void
 box_set_vinyl_timeout(void)
 {
@@ -901,14 +1309,50 @@ box_set_vinyl_timeout(void)
 	vinyl_engine_set_timeout(vinyl,	cfg_getd("vinyl_timeout"));
 }
 
+void
+box_set_vinyl_read_latency_budget(void)
+{
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_read_latency_budget(vinyl,
+		box_check_vinyl_read_latency_budget(
+			cfg_getd("vinyl_read_latency_budget")));
+}
+
 void
 box_set_net_msg_max(void)
 {
 	int new_iproto_msg_max = cfg_geti("net_msg_max");
 	iproto_set_msg_max(new_iproto_msg_max);
-	fiber_pool_set_max_size(&tx_fiber_pool,
-				new_iproto_msg_max *
-				IPROTO_FIBER_POOL_SIZE_FACTOR);
+	/* net_msg_max is a per thread limit. */
+	int pool_size = new_iproto_msg_max * cfg_geti("iproto_threads") *
+			IPROTO_FIBER_POOL_SIZE_FACTOR;
+	fiber_pool_set_max_size(&tx_fiber_pool, pool_size);
+	fiber_pool_set_max_size(&tx_high_fiber_pool, pool_size);
+}
+
+void
+box_set_iproto_zero_copy_threshold(void)
+{
+	int64_t threshold = box_check_iproto_zero_copy_threshold(
+			cfg_geti64("iproto_zero_copy_threshold"));
+	iproto_set_zero_copy_threshold(threshold);
+}
+
+void
+box_set_sql_cache_size(void)
+{
+	int64_t size = box_check_sql_cache_size(cfg_geti64("sql_cache_size"));
+	sql_stmt_cache_set_size(size);
+}
+
+void
+box_set_eval_cache_size(void)
+{
+	int64_t size = box_check_eval_cache_size(
+			cfg_geti64("eval_cache_size"));
+	box_lua_eval_cache_set_size(size);
 }
 
 /* }}} configuration bindings */
@@ -981,6 +1425,20 @@ box_return_tuple(box_function_ctx_t *ctx, box_tuple_t *tuple)
 	return port_tuple_add(ctx->port, tuple);
 }
 
+void
+box_return_error(box_function_ctx_t *ctx)
+{
+	struct error *e = diag_last_error(diag_get());
+	if (e == NULL) {
+		diag_set(ClientError, ER_PROC_C, "unknown error");
+		e = diag_last_error(diag_get());
+	}
+	error_ref(e);
+	if (ctx->error != NULL)
+		error_unref(ctx->error);
+	ctx->error = e;
+}
+
 /* schema_find_id()-like method using only public API */
 uint32_t
 box_space_id_by_name(const char *name, uint32_t len)
@@ -1049,11 +1507,61 @@ box_process1(struct request *request, box_tuple_t **result)
 	return box_process_rw(request, space, result);
 }
 
-int
-box_select(uint32_t space_id, uint32_t index_id,
-	   int iterator, uint32_t offset, uint32_t limit,
-	   const char *key, const char *key_end,
-	   struct port *port)
+/**
+ * Create a tuple consisting of the given fields of a tuple,
+ * in the given order. A missing field is set to nil.
+ */
+static struct tuple *
+box_tuple_project(struct tuple *tuple, const uint32_t *fields,
+		  uint32_t field_count)
+{
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	size_t size = mp_sizeof_array(field_count);
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = tuple_field(tuple, fields[i]);
+		if (field != NULL) {
+			const char *field_end = field;
+			mp_next(&field_end);
+			size += field_end - field;
+		} else {
+			size += mp_sizeof_nil();
+		}
+	}
+	char *data = (char *)region_alloc(region, size);
+	if (data == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "tuple");
+		return NULL;
+	}
+	char *pos = mp_encode_array(data, field_count);
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = tuple_field(tuple, fields[i]);
+		if (field != NULL) {
+			const char *field_end = field;
+			mp_next(&field_end);
+			memcpy(pos, field, field_end - field);
+			pos += field_end - field;
+		} else {
+			pos = mp_encode_nil(pos);
+		}
+	}
+	assert(pos == data + size);
+	struct tuple *result = tuple_new(tuple_format_runtime, data, pos);
+	region_truncate(region, used);
+	return result;
+}
+
+/**
+ * Implementation of box_select() and box_select_fields().
+ * If @fields is not NULL, only the given fields of each
+ * tuple are returned.
+ */
+static int
+box_select_impl(uint32_t space_id, uint32_t index_id,
+		int iterator, uint32_t offset, uint32_t limit,
+		const char *key, const char *key_end,
+		const uint32_t *fields, uint32_t field_count,
+		struct port *port)
 {
 	(void)key_end;
 
@@ -1089,24 +1597,38 @@ box_select(uint32_t space_id, uint32_t index_id,
 	if (txn_begin_ro_stmt(space, &txn) != 0)
 		return -1;
 
-	struct iterator *it = index_create_iterator(index, type,
-						    key, part_count);
+	uint64_t start = op_latency_start();
+	struct iterator *it;
+	if (fields != NULL) {
+		uint64_t field_mask = 0;
+		for (uint32_t i = 0; i < field_count; i++)
+			column_mask_set_fieldno(&field_mask, fields[i]);
+		it = index_create_covering_iterator(index, type, key,
+						    part_count, field_mask);
+	} else {
+		it = index_create_iterator(index, type, key, part_count);
+	}
 	if (it == NULL) {
 		txn_rollback_stmt();
 		return -1;
 	}
 
-	int rc = 0;
+	int rc = limit > 0 ? iterator_skip(it, offset) : 0;
 	uint32_t found = 0;
+	uint64_t bytes = 0;
 	struct tuple *tuple;
 	port_tuple_create(port);
-	while (found < limit) {
+	while (rc == 0 && found < limit) {
 		rc = iterator_next(it, &tuple);
 		if (rc != 0 || tuple == NULL)
 			break;
-		if (offset > 0) {
-			offset--;
-			continue;
+		bytes += tuple_bsize(tuple);
+		if (fields != NULL) {
+			tuple = box_tuple_project(tuple, fields, field_count);
+			if (tuple == NULL) {
+				rc = -1;
+				break;
+			}
 		}
 		rc = port_tuple_add(port, tuple);
 		if (rc != 0)
@@ -1121,9 +1643,37 @@ box_select(uint32_t space_id, uint32_t index_id,
 		return -1;
 	}
 	txn_commit_ro_stmt(txn);
+	space->op_stat.select++;
+	struct index_op_stat *stat = &index->op_stat;
+	stat->select++;
+	stat->steps += found + (limit > 0 ? offset : 0);
+	stat->rows += found;
+	stat->bytes += bytes;
+	op_latency_collect(&stat->latency, start);
 	return 0;
 }
 
+int
+box_select(uint32_t space_id, uint32_t index_id,
+	   int iterator, uint32_t offset, uint32_t limit,
+	   const char *key, const char *key_end,
+	   struct port *port)
+{
+	return box_select_impl(space_id, index_id, iterator, offset, limit,
+			       key, key_end, NULL, 0, port);
+}
+
+int
+box_select_fields(uint32_t space_id, uint32_t index_id,
+		  int iterator, uint32_t offset, uint32_t limit,
+		  const char *key, const char *key_end,
+		  const uint32_t *fields, uint32_t field_count,
+		  struct port *port)
+{
+	return box_select_impl(space_id, index_id, iterator, offset, limit,
+			       key, key_end, fields, field_count, port);
+}
+
 int
 box_insert(uint32_t space_id, const char *tuple, const char *tuple_end,
 	   box_tuple_t **result)
@@ -1152,6 +1702,154 @@ box_replace(uint32_t space_id, const char *tuple, const char *tuple_end,
 	return box_process1(&request, result);
 }
 
+/** A tuple of a batch and its primary key. */
+struct batch_tuple {
+	const char *data;
+	const char *data_end;
+	const char *key;
+	/** Position in the batch, makes sorting stable. */
+	uint32_t pos;
+};
+
+/**
+ * Primary key definition of the batch being sorted. Sorting
+ * doesn't yield, so one variable is enough for all fibers.
+ */
+static struct key_def *batch_sort_key_def;
+
+static int
+batch_tuple_cmp(const void *a, const void *b)
+{
+	const struct batch_tuple *ta = (const struct batch_tuple *) a;
+	const struct batch_tuple *tb = (const struct batch_tuple *) b;
+	int rc = key_compare(ta->key, tb->key, batch_sort_key_def);
+	if (rc != 0)
+		return rc;
+	return ta->pos < tb->pos ? -1 : 1;
+}
+
+/**
+ * Execute INSERT or REPLACE requests for an array of tuples.
+ * All tuples are validated first, then they are sorted by the
+ * primary key so that index insertions touch neighbouring
+ * pages, and executed in one transaction. Outside of an
+ * explicit transaction the batch is committed with a single
+ * WAL write. The batch is atomic: on error none of its tuples
+ * is applied.
+ */
+static int
+box_process_batch(uint32_t type, uint32_t space_id, const char *tuples,
+		  const char *tuples_end)
+{
+	mp_tuple_assert(tuples, tuples_end);
+	(void) tuples_end;
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return -1;
+	if (!space_is_temporary(space) &&
+	    space_group_id(space) != GROUP_LOCAL &&
+	    box_check_writable() != 0)
+		return -1;
+	struct index *pk = index_find(space, 0);
+	if (pk == NULL)
+		return -1;
+	struct key_def *key_def = pk->def->key_def;
+	struct region *region = &fiber()->gc;
+	uint32_t count = mp_decode_array(&tuples);
+	if (count == 0)
+		return 0;
+	struct batch_tuple *batch = (struct batch_tuple *)
+		region_alloc(region, count * sizeof(*batch));
+	if (batch == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*batch), "region",
+			 "batch");
+		return -1;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		struct batch_tuple *t = &batch[i];
+		t->data = tuples;
+		mp_next(&tuples);
+		t->data_end = tuples;
+		t->pos = i;
+		if (mp_typeof(*t->data) != MP_ARRAY) {
+			diag_set(ClientError, ER_TUPLE_NOT_ARRAY);
+			return -1;
+		}
+		if (tuple_validate_raw(space->format, t->data) != 0)
+			return -1;
+		uint32_t key_size;
+		t->key = tuple_extract_key_raw(t->data, t->data_end, key_def,
+					       &key_size);
+		if (t->key == NULL)
+			return -1;
+	}
+	batch_sort_key_def = key_def;
+	qsort(batch, count, sizeof(*batch), batch_tuple_cmp);
+	batch_sort_key_def = NULL;
+
+	bool is_autocommit = !box_txn();
+	box_txn_savepoint_t *svp = NULL;
+	if (is_autocommit) {
+		if (box_txn_begin() != 0)
+			return -1;
+	} else {
+		svp = box_txn_savepoint();
+		if (svp == NULL)
+			return -1;
+	}
+	struct request request;
+	for (uint32_t i = 0; i < count; i++) {
+		memset(&request, 0, sizeof(request));
+		request.type = type;
+		request.space_id = space_id;
+		request.tuple = batch[i].data;
+		request.tuple_end = batch[i].data_end;
+		if (box_process_rw(&request, space, NULL) != 0)
+			goto rollback;
+	}
+	if (is_autocommit)
+		return box_txn_commit();
+	return 0;
+rollback:
+	if (is_autocommit)
+		box_txn_rollback();
+	else
+		box_txn_rollback_to_savepoint(svp);
+	return -1;
+}
+
+int
+box_insert_batch(uint32_t space_id, const char *tuples,
+		 const char *tuples_end)
+{
+	return box_process_batch(IPROTO_INSERT, space_id, tuples, tuples_end);
+}
+
+int
+box_replace_batch(uint32_t space_id, const char *tuples,
+		  const char *tuples_end)
+{
+	return box_process_batch(IPROTO_REPLACE, space_id, tuples, tuples_end);
+}
+
+int
+box_space_bulk_load(uint32_t space_id, struct bulk_load_source *source)
+{
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return -1;
+	if (box_check_writable() != 0)
+		return -1;
+	if (access_check_space(space, PRIV_W) != 0)
+		return -1;
+	if (in_txn() != NULL) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Transaction",
+			 "bulk load");
+		return -1;
+	}
+	return space_bulk_load(space, source);
+}
+
 int
 box_delete(uint32_t space_id, uint32_t index_id, const char *key,
 	   const char *key_end, box_tuple_t **result)
@@ -1313,8 +2011,22 @@ box_sequence_next(uint32_t seq_id, int64_t *result)
 	int64_t value;
 	if (sequence_next(seq, &value) != 0)
 		return -1;
-	if (sequence_data_update(seq_id, value) != 0)
+	if (sequence_is_reserved(seq, value)) {
+		*result = value;
+		return 0;
+	}
+	int64_t last = sequence_reserve(seq, value);
+	if (sequence_data_update(seq_id, last) != 0)
 		return -1;
+	if (last != value) {
+		/*
+		 * The _sequence_data trigger has moved the sequence
+		 * to the end of the reserved block, move it back.
+		 */
+		if (sequence_set(seq, value) != 0)
+			return -1;
+		sequence_reserve(seq, value);
+	}
 	*result = value;
 	return 0;
 }
@@ -1400,6 +2112,12 @@ box_process_auth(struct auth_request *request, const char *salt)
 	authenticate(user, len, salt, request->scramble);
 }
 
+/**
+ * Number of JOIN and FETCH_SNAPSHOT requests being served,
+ * reported in the ballot.
+ */
+static uint32_t box_join_count;
+
 void
 box_process_join(struct ev_io *io, struct xrow_header *header)
 {
@@ -1442,13 +2160,28 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	 *  - Cluster UUID in _schema space
 	 *  - Registration of master in _cluster space
 	 *  - Registration of the new replica in _cluster space
+	 *
+	 * FETCH_SNAPSHOT of an anonymous replica is processed the
+	 * same way except that the replica isn't registered.
+	 *
+	 * A replica may REGISTER on the master and then JOIN
+	 * another replica to offload the master, passing it
+	 * VCLOCK: the vclock of the master after registration.
+	 * The replica waits until it has received the rows up to
+	 * this vclock, including the registration, and then
+	 * serves JOIN as usual. See bootstrap_from_replica().
 	 */
 
-	assert(header->type == IPROTO_JOIN);
+	assert(header->type == IPROTO_JOIN ||
+	       header->type == IPROTO_FETCH_SNAPSHOT);
+	bool is_anon = header->type == IPROTO_FETCH_SNAPSHOT;
 
 	/* Decode JOIN request */
 	struct tt_uuid instance_uuid = uuid_nil;
-	xrow_decode_join_xc(header, &instance_uuid);
+	struct vclock wait_vclock;
+	bool compress = false;
+	vclock_create(&wait_vclock);
+	xrow_decode_join_xc(header, &instance_uuid, &wait_vclock, &compress);
 
 	/* Check that bootstrap has been finished */
 	if (!is_box_configured)
@@ -1461,6 +2194,14 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	/* Check permissions */
 	access_check_universe_xc(PRIV_R);
 
+	/* Wait for the registration made on the master. */
+	if (replicaset_wait_vclock(&wait_vclock,
+				   replication_sync_timeout) != 0)
+		diag_raise();
+
+	box_join_count++;
+	auto join_guard = make_scoped_guard([&]{ box_join_count--; });
+
 	/*
 	 * Unless already registered, the new replica will be
 	 * added to _cluster space once the initial join stage
@@ -1468,7 +2209,12 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	 * appropriate access privileges.
 	 */
 	struct replica *replica = replica_by_uuid(&instance_uuid);
-	if (replica == NULL || replica->id == REPLICA_ID_NIL) {
+	if (!is_anon && (replica == NULL || replica->id == REPLICA_ID_NIL)) {
+		if (replication_anon) {
+			tnt_raise(ClientError, ER_UNSUPPORTED,
+				  "Anonymous replica",
+				  "registration of replicas");
+		}
 		box_check_writable_xc();
 		struct space *space = space_cache_find_xc(BOX_CLUSTER_ID);
 		access_check_space_xc(space, PRIV_W);
@@ -1512,7 +2258,7 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	/*
 	 * Initial stream: feed replica with dirty data from engines.
 	 */
-	relay_initial_join(io->fd, header->sync, &start_vclock);
+	relay_initial_join(io->fd, header->sync, &start_vclock, compress);
 	say_info("initial data sent.");
 
 	/**
@@ -1521,7 +2267,8 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	 * sending OK - if the hook fails, the error reaches the
 	 * client.
 	 */
-	box_on_join(&instance_uuid);
+	if (!is_anon)
+		box_on_join(&instance_uuid);
 
 	/* Remember master's vclock after the last request */
 	struct vclock stop_vclock;
@@ -1530,14 +2277,18 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	/*
 	 * Register the replica as a WAL consumer so that
 	 * it can resume SUBSCRIBE where FINAL JOIN ends.
+	 * An anonymous replica pins xlogs only while it is
+	 * subscribed, see relay_subscribe_anon().
 	 */
-	replica = replica_by_uuid(&instance_uuid);
-	if (replica->gc != NULL)
-		gc_consumer_unregister(replica->gc);
-	replica->gc = gc_consumer_register(&stop_vclock, "replica %s",
-					   tt_uuid_str(&instance_uuid));
-	if (replica->gc == NULL)
-		diag_raise();
+	if (!is_anon) {
+		replica = replica_by_uuid(&instance_uuid);
+		if (replica->gc != NULL)
+			gc_consumer_unregister(replica->gc);
+		replica->gc = gc_consumer_register(&stop_vclock, "replica %s",
+						   tt_uuid_str(&instance_uuid));
+		if (replica->gc == NULL)
+			diag_raise();
+	}
 
 	/* Send end of initial stage data marker */
 	xrow_encode_vclock_xc(&row, &stop_vclock);
@@ -1548,7 +2299,8 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	 * Final stage: feed replica with WALs in range
 	 * (start_vclock, stop_vclock).
 	 */
-	relay_final_join(io->fd, header->sync, &start_vclock, &stop_vclock);
+	relay_final_join(io->fd, header->sync, &start_vclock, &stop_vclock,
+			 compress);
 	say_info("final data sent.");
 
 	/* Send end of WAL stream marker */
@@ -1557,6 +2309,66 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	coio_write_xrow(io, &row);
 }
 
+void
+box_process_register(struct ev_io *io, struct xrow_header *header)
+{
+	assert(header->type == IPROTO_REGISTER);
+
+	struct tt_uuid instance_uuid = uuid_nil;
+	xrow_decode_register_xc(header, &instance_uuid);
+
+	/* Check that bootstrap has been finished */
+	if (!is_box_configured)
+		tnt_raise(ClientError, ER_LOADING);
+
+	/* Forbid connection to itself */
+	if (tt_uuid_is_equal(&instance_uuid, &INSTANCE_UUID))
+		tnt_raise(ClientError, ER_CONNECTION_TO_SELF);
+
+	/* Check permissions */
+	access_check_universe_xc(PRIV_R);
+	if (replication_anon) {
+		tnt_raise(ClientError, ER_UNSUPPORTED, "Anonymous replica",
+			  "registration of replicas");
+	}
+	struct replica *replica = replica_by_uuid(&instance_uuid);
+	if (replica == NULL || replica->id == REPLICA_ID_NIL) {
+		box_check_writable_xc();
+		struct space *space = space_cache_find_xc(BOX_CLUSTER_ID);
+		access_check_space_xc(space, PRIV_W);
+	}
+
+	/* Forbid replication with disabled WAL */
+	if (wal_mode() == WAL_NONE) {
+		tnt_raise(ClientError, ER_UNSUPPORTED, "Replication",
+			  "wal_mode = 'none'");
+	}
+
+	box_on_join(&instance_uuid);
+	say_info("registered replica %s", tt_uuid_str(&instance_uuid));
+
+	struct vclock vclock;
+	vclock_copy(&vclock, &replicaset.vclock);
+
+	/*
+	 * The replica fetches the data from another instance and
+	 * then subscribes here from a vclock not less than this
+	 * one. Keep the WALs it needs until then.
+	 */
+	replica = replica_by_uuid(&instance_uuid);
+	if (replica->gc == NULL) {
+		replica->gc = gc_consumer_register(&vclock, "replica %s",
+						   tt_uuid_str(&instance_uuid));
+		if (replica->gc == NULL)
+			diag_raise();
+	}
+
+	struct xrow_header row;
+	xrow_encode_vclock_xc(&row, &vclock);
+	row.sync = header->sync;
+	coio_write_xrow(io, &row);
+}
+
 void
 box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 {
@@ -1569,9 +2381,12 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	struct tt_uuid replicaset_uuid = uuid_nil, replica_uuid = uuid_nil;
 	struct vclock replica_clock;
 	uint32_t replica_version_id;
+	bool compress = false;
+	bool is_anon = false;
 	vclock_create(&replica_clock);
 	xrow_decode_subscribe_xc(header, &replicaset_uuid, &replica_uuid,
-				 &replica_clock, &replica_version_id);
+				 &replica_clock, &replica_version_id,
+				 &compress, &is_anon);
 
 	/* Forbid connection to itself */
 	if (tt_uuid_is_equal(&replica_uuid, &INSTANCE_UUID))
@@ -1582,14 +2397,19 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 
 	/* Check replica uuid */
 	struct replica *replica = replica_by_uuid(&replica_uuid);
-	if (replica == NULL || replica->id == REPLICA_ID_NIL) {
+	if (!is_anon && (replica == NULL || replica->id == REPLICA_ID_NIL)) {
 		tnt_raise(ClientError, ER_UNKNOWN_REPLICA,
 			  tt_uuid_str(&replica_uuid),
 			  tt_uuid_str(&REPLICASET_UUID));
 	}
+	if (!is_anon && replication_anon) {
+		/* We have no replica id to identify ourselves. */
+		tnt_raise(ClientError, ER_UNSUPPORTED, "Anonymous replica",
+			  "subscription of registered replicas");
+	}
 
 	/* Don't allow multiple relays for the same replica */
-	if (relay_get_state(replica->relay) == RELAY_FOLLOW) {
+	if (!is_anon && relay_get_state(replica->relay) == RELAY_FOLLOW) {
 		tnt_raise(ClientError, ER_CFG, "replication",
 			  "duplicate connection with the same replica UUID");
 	}
@@ -1620,9 +2440,7 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	 * instance, this is the only way for a replica to find
 	 * out the id of the instance it has connected to.
 	 */
-	struct replica *self = replica_by_uuid(&INSTANCE_UUID);
-	assert(self != NULL); /* the local registration is read-only */
-	row.replica_id = self->id;
+	row.replica_id = instance_id;
 	row.sync = header->sync;
 	coio_write_xrow(io, &row);
 
@@ -1638,8 +2456,52 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	 * a stall in updates (in this case replica may hang
 	 * indefinitely).
 	 */
-	relay_subscribe(replica, io->fd, header->sync, &replica_clock,
-			replica_version_id);
+	if (is_anon) {
+		relay_subscribe_anon(&replica_uuid, io->fd, header->sync,
+				     &replica_clock, replica_version_id,
+				     compress);
+	} else {
+		relay_subscribe(replica, io->fd, header->sync, &replica_clock,
+				replica_version_id, compress);
+	}
+}
+
+void
+box_process_cdc_subscribe(struct ev_io *io, struct xrow_header *header)
+{
+	assert(header->type == IPROTO_CDC_SUBSCRIBE);
+
+	if (!is_box_configured)
+		tnt_raise(ClientError, ER_LOADING);
+
+	/* A consumer reads all data, like a replica does. */
+	access_check_universe_xc(PRIV_R);
+
+	if (wal_mode() == WAL_NONE) {
+		tnt_raise(ClientError, ER_UNSUPPORTED, "Change data capture",
+			  "wal_mode = 'none'");
+	}
+
+	struct vclock start_vclock;
+	struct cdc_filter filter;
+	vclock_create(&start_vclock);
+	xrow_decode_cdc_subscribe_xc(header, &start_vclock, &filter);
+	auto filter_guard = make_scoped_guard([&] {
+		cdc_filter_destroy(&filter);
+	});
+
+	/*
+	 * Reply the same way as to SUBSCRIBE so that the
+	 * consumer learns the current vclock of the instance.
+	 */
+	struct xrow_header row;
+	xrow_encode_subscribe_response_xc(&row, &REPLICASET_UUID,
+					  &replicaset.vclock);
+	row.replica_id = instance_id;
+	row.sync = header->sync;
+	coio_write_xrow(io, &row);
+
+	relay_cdc_subscribe(io->fd, header->sync, &start_vclock, &filter);
 }
 
 void
@@ -1648,6 +2510,11 @@ box_process_vote(struct ballot *ballot)
 	ballot->is_ro = cfg_geti("read_only") != 0;
 	vclock_copy(&ballot->vclock, &replicaset.vclock);
 	vclock_copy(&ballot->gc_vclock, &gc.vclock);
+	ballot->relay_count = box_join_count;
+	replicaset_foreach(replica) {
+		if (relay_get_state(replica->relay) == RELAY_FOLLOW)
+			ballot->relay_count++;
+	}
 }
 
 /** Insert a new cluster into _schema */
@@ -1682,14 +2549,45 @@ box_free(void)
 		tuple_free();
 		port_free();
 #endif
+		synchro_free();
 		replication_free();
 		sequence_free();
 		gc_free();
+		expire_free();
+		sql_free();
 		engine_shutdown();
 		wal_free();
 	}
 }
 
+enum {
+	/**
+	 * Max number of I/O requests tx fibers may have in
+	 * flight. A fiber that would exceed it waits for a slot.
+	 */
+	BOX_IO_RING_ENTRIES = 256,
+};
+
+/**
+ * Set up an io_uring instance for tx if it is configured.
+ * Fall back on thread pools if io_uring is unavailable.
+ *
+ * @retval true if tx submits I/O through io_uring.
+ */
+static bool
+box_init_io_ring(void)
+{
+	if (!cfg_geti("io_uring"))
+		return false;
+	if (io_ring_create(BOX_IO_RING_ENTRIES) != 0) {
+		diag_log();
+		say_warn("failed to set up io_uring, "
+			 "using thread pools for I/O");
+		return false;
+	}
+	return true;
+}
+
 static void
 engine_init()
 {
@@ -1703,10 +2601,22 @@ engine_init()
 	memtx = memtx_engine_new_xc(cfg_gets("memtx_dir"),
 				    cfg_geti("force_recovery"),
 				    cfg_getd("memtx_memory"),
+				    cfg_geti("memtx_use_hugepages"),
 				    cfg_geti("memtx_min_tuple_size"),
 				    cfg_getd("slab_alloc_factor"));
 	engine_register((struct engine *)memtx);
+	/*
+	 * Set the memory policy before recovery populates the
+	 * arena, so that pages land on the configured nodes no
+	 * matter which thread touches them first.
+	 */
+	const char *numa_policy = cfg_gets("memtx_numa_policy");
+	if (numa_policy != NULL &&
+	    memtx_engine_set_numa_policy(memtx, numa_policy) != 0)
+		diag_raise();
 	box_set_memtx_max_tuple_size();
+	box_set_memtx_snap_threads();
+	box_set_memtx_snap_delta_max();
 
 	struct sysview_engine *sysview = sysview_engine_new_xc();
 	engine_register((struct engine *)sysview);
@@ -1716,6 +2626,7 @@ engine_init()
 
 	struct vinyl_engine *vinyl;
 	vinyl = vinyl_engine_new_xc(cfg_gets("vinyl_dir"),
+				    cfg_gets("vinyl_cold_dir"),
 				    cfg_geti64("vinyl_memory"),
 				    cfg_geti("vinyl_read_threads"),
 				    cfg_geti("vinyl_write_threads"),
@@ -1723,7 +2634,11 @@ engine_init()
 	engine_register((struct engine *)vinyl);
 	box_set_vinyl_max_tuple_size();
 	box_set_vinyl_cache();
+	box_set_vinyl_page_cache();
+	box_set_vinyl_read_ahead();
+	box_set_vinyl_index_cache();
 	box_set_vinyl_timeout();
+	box_set_vinyl_read_latency_budget();
 }
 
 /**
@@ -1834,6 +2749,40 @@ bootstrap_from_master(struct replica *master)
 		panic("failed to create a checkpoint");
 }
 
+/**
+ * Bootstrap from a replica of the remote master so as not to
+ * load the master with sending the data: register in _cluster
+ * of the master, then JOIN the donor, which waits until it has
+ * received the registration. After that, the instance
+ * subscribes to all its peers, the master included, as after
+ * a bootstrap from the master. An anonymous replica needs no
+ * registration and simply joins the donor.
+ *
+ * \pre  master->applier->state == APPLIER_READY
+ * \pre  donor->applier->state == APPLIER_READY
+ * \post both appliers are in APPLIER_READY
+ */
+static void
+bootstrap_from_replica(struct replica *master, struct replica *donor)
+{
+	struct applier *applier = master->applier;
+	assert(applier != NULL && donor->applier != NULL);
+	if (!replication_anon) {
+		say_info("registering replica at master %s at %s",
+			 tt_uuid_str(&master->uuid),
+			 sio_strfaddr(&applier->addr, applier->addr_len));
+		applier->register_only = true;
+		applier_resume_to_state(applier, APPLIER_REGISTERED,
+					TIMEOUT_INFINITY);
+		vclock_copy(&donor->applier->join_vclock,
+			    &applier->join_vclock);
+	}
+	bootstrap_from_master(donor);
+	if (!replication_anon)
+		applier_resume_to_state(applier, APPLIER_READY,
+					TIMEOUT_INFINITY);
+}
+
 /**
  * Bootstrap a new instance either as the first master in a
  * replica set or as a replica of an existing master.
@@ -1874,7 +2823,13 @@ bootstrap(const struct tt_uuid *instance_uuid,
 	assert(master == NULL || master->applier != NULL);
 
 	if (master != NULL && !tt_uuid_is_equal(&master->uuid, &INSTANCE_UUID)) {
-		bootstrap_from_master(master);
+		struct replica *donor = NULL;
+		if (replication_join_from_replica)
+			donor = replicaset_join_donor(master);
+		if (donor != NULL)
+			bootstrap_from_replica(master, donor);
+		else
+			bootstrap_from_master(master);
 		/* Check replica set UUID */
 		if (!tt_uuid_is_nil(replicaset_uuid) &&
 		    !tt_uuid_is_equal(replicaset_uuid, &REPLICASET_UUID)) {
@@ -1883,6 +2838,11 @@ bootstrap(const struct tt_uuid *instance_uuid,
 				  tt_uuid_str(&REPLICASET_UUID));
 		}
 	} else {
+		if (replication_anon) {
+			tnt_raise(ClientError, ER_CFG, "replication_anon",
+				  "an anonymous replica can't bootstrap "
+				  "a replica set, it needs a master");
+		}
 		bootstrap_master(replicaset_uuid);
 		*is_bootstrap_leader = true;
 	}
@@ -1983,6 +2943,12 @@ local_recovery(const struct tt_uuid *instance_uuid,
 	if (wal_dir_lock < 0) {
 		title("hot_standby");
 		say_info("Entering hot standby mode");
+		/*
+		 * Keep all indexes up to date while following
+		 * the master's WAL so that promotion does not
+		 * have to build secondary keys.
+		 */
+		memtx_engine_build_secondary_keys_xc(memtx);
 		recovery_follow_local(recovery, &wal_stream.base, "hot_standby",
 				      cfg_getd("wal_dir_rescan_delay"));
 		while (true) {
@@ -1990,7 +2956,7 @@ local_recovery(const struct tt_uuid *instance_uuid,
 				diag_raise();
 			if (wal_dir_lock >= 0)
 				break;
-			fiber_sleep(0.1);
+			fiber_sleep(0.01);
 		}
 		recovery_stop_local(recovery);
 		recover_remaining_wals(recovery, &wal_stream.base, NULL, true);
@@ -2074,9 +3040,20 @@ box_is_configured(void)
 static inline void
 box_cfg_xc(void)
 {
+	/*
+	 * Threads inherit CPUs of the thread starting them, so
+	 * the rules must be set before any thread is started.
+	 */
+	if (cord_affinity_set(cfg_gets("thread_affinity")) != 0)
+		diag_raise();
+	cord_affinity_apply("tx");
+
 	/* Join the cord interconnect as "tx" endpoint. */
-	fiber_pool_create(&tx_fiber_pool, "tx",
-			  IPROTO_MSG_MAX_MIN * IPROTO_FIBER_POOL_SIZE_FACTOR,
+	int pool_size = IPROTO_MSG_MAX_MIN * cfg_geti("iproto_threads") *
+			IPROTO_FIBER_POOL_SIZE_FACTOR;
+	fiber_pool_create(&tx_fiber_pool, "tx", pool_size,
+			  FIBER_POOL_IDLE_TIMEOUT);
+	fiber_pool_create(&tx_high_fiber_pool, "tx_high", pool_size,
 			  FIBER_POOL_IDLE_TIMEOUT);
 	/* Add an extra endpoint for WAL wake up/rollback messages. */
 	cbus_endpoint_create(&tx_prio_endpoint, "tx_prio", tx_prio_cb, &tx_prio_endpoint);
@@ -2085,21 +3062,29 @@ box_cfg_xc(void)
 	rmean_error = rmean_new(rmean_error_strings, RMEAN_ERROR_LAST);
 
 	gc_init();
+	bool use_io_ring = box_init_io_ring();
 	engine_init();
 	if (module_init() != 0)
 		diag_raise();
 	schema_init();
 	replication_init();
+	synchro_init();
 	port_init();
-	iproto_init();
+	iproto_init(cfg_geti("iproto_threads"));
 	sql_init();
 
 	int64_t wal_max_rows = box_check_wal_max_rows(cfg_geti64("rows_per_wal"));
 	int64_t wal_max_size = box_check_wal_max_size(cfg_geti64("wal_max_size"));
+	int64_t wal_ring_size = box_check_wal_ring_size(
+		cfg_geti64("wal_ring_size"));
+	int wal_spare_files = box_check_wal_spare_files(
+		cfg_geti("wal_spare_files"));
 	enum wal_mode wal_mode = box_check_wal_mode(cfg_gets("wal_mode"));
 	if (wal_init(wal_mode, cfg_gets("wal_dir"), wal_max_rows,
 		     wal_max_size, &INSTANCE_UUID, on_wal_garbage_collection,
-		     on_wal_checkpoint_threshold) != 0) {
+		     on_wal_checkpoint_threshold, use_io_ring,
+		     wal_ring_size, wal_spare_files,
+		     cfg_getb("wal_direct_io")) != 0) {
 		diag_raise();
 	}
 
@@ -2110,6 +3095,9 @@ box_cfg_xc(void)
 	box_check_replicaset_uuid(&replicaset_uuid);
 
 	box_set_net_msg_max();
+	box_set_iproto_zero_copy_threshold();
+	box_set_sql_cache_size();
+	box_set_eval_cache_size();
 	box_set_too_long_threshold();
 	box_set_replication_timeout();
 	box_set_replication_connect_timeout();
@@ -2117,6 +3105,15 @@ box_cfg_xc(void)
 	box_set_replication_sync_lag();
 	box_set_replication_sync_timeout();
 	box_set_replication_skip_conflict();
+	box_set_replication_apply_fibers();
+	box_set_replication_compression();
+	box_set_replication_apply_batch_rows();
+	box_set_replication_apply_batch_delay();
+	box_set_replication_synchro_quorum();
+	box_set_replication_synchro_timeout();
+	replication_anon = box_check_replication_anon();
+	replication_join_from_replica =
+		cfg_geti("replication_join_from_replica") != 0;
 	xstream_create(&join_stream, apply_initial_join_row);
 	xstream_create(&subscribe_stream, apply_row);
 
@@ -2150,7 +3147,7 @@ box_cfg_xc(void)
 	fiber_gc();
 
 	/* Check for correct registration of the instance in _cluster */
-	{
+	if (!replication_anon) {
 		struct replica *self = replica_by_uuid(&INSTANCE_UUID);
 		if (self == NULL || self->id == REPLICA_ID_NIL) {
 			tnt_raise(ClientError, ER_UNKNOWN_REPLICA,
@@ -2165,6 +3162,7 @@ box_cfg_xc(void)
 	replicaset_follow();
 
 	sql_load_schema();
+	expire_init();
 
 	fiber_gc();
 	is_box_configured = true;
@@ -2228,6 +3226,7 @@ box_backup_start(int checkpoint_idx, box_backup_cb cb, void *cb_arg)
 		return -1;
 	}
 	backup_is_in_progress = true;
+	vclock_copy(&backup_vclock, &checkpoint->vclock);
 	gc_ref_checkpoint(checkpoint, &backup_gc, "backup");
 	int rc = engine_backup(&checkpoint->vclock, cb, cb_arg);
 	if (rc != 0) {
@@ -2246,6 +3245,117 @@ box_backup_stop(void)
 	}
 }
 
+/** A file collected for streaming, see box_backup_stream(). */
+struct backup_file {
+	/** Link in the list of files to stream. */
+	struct stailq_entry in_list;
+	/** File path, zero terminated. */
+	char path[0];
+};
+
+static int
+backup_file_add(struct stailq *files, const char *path)
+{
+	size_t len = strlen(path);
+	size_t size = sizeof(struct backup_file) + len + 1;
+	struct backup_file *file =
+		(struct backup_file *)region_alloc(&fiber()->gc, size);
+	if (file == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "backup_file");
+		return -1;
+	}
+	memcpy(file->path, path, len + 1);
+	stailq_add_tail_entry(files, file, in_list);
+	return 0;
+}
+
+static int
+backup_file_add_cb(const char *path, void *arg)
+{
+	return backup_file_add((struct stailq *)arg, path);
+}
+
+/**
+ * Collect WAL files needed to roll forward from @vclock and
+ * pin them with a garbage collector consumer.
+ */
+static struct gc_consumer *
+backup_collect_wals(const struct vclock *vclock, struct stailq *files)
+{
+	struct gc_consumer *gc = NULL;
+	struct xdir dir;
+	xdir_create(&dir, cfg_gets("wal_dir"), XLOG, &INSTANCE_UUID);
+	if (xdir_scan(&dir) != 0)
+		goto out;
+	struct vclock *first, *wal;
+	first = vclockset_match(&dir.index, (struct vclock *)vclock);
+	if (first != NULL && vclock_compare(first, vclock) > 0) {
+		diag_set(XlogGapError, vclock, first);
+		goto out;
+	}
+	for (wal = first; wal != NULL; wal = vclockset_next(&dir.index, wal)) {
+		if (backup_file_add(files, xdir_format_filename(&dir,
+					vclock_sum(wal), NONE)) != 0)
+			goto out;
+	}
+	gc = gc_consumer_register(first != NULL ? first : vclock, "backup");
+out:
+	xdir_destroy(&dir);
+	return gc;
+}
+
+int
+box_backup_stream(int checkpoint_idx, const struct vclock *since,
+		  const char *path, double rate_limit,
+		  box_backup_cb cb, void *cb_arg)
+{
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	struct stailq files;
+	stailq_create(&files);
+	struct gc_consumer *gc = NULL;
+	int fd = -1;
+	int rc = -1;
+	bool backup_started = false;
+	if (since == NULL) {
+		if (box_backup_start(checkpoint_idx, backup_file_add_cb,
+				     &files) != 0)
+			goto out;
+		backup_started = true;
+		since = &backup_vclock;
+	}
+	gc = backup_collect_wals(since, &files);
+	if (gc == NULL)
+		goto out;
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		diag_set(SystemError, "failed to open '%s'", path);
+		goto out;
+	}
+	struct backup_stream stream;
+	backup_stream_create(&stream, fd, rate_limit);
+	struct backup_file *file;
+	stailq_foreach_entry(file, &files, in_list) {
+		if (backup_stream_add_file(&stream, file->path) != 0 ||
+		    cb(file->path, cb_arg) != 0)
+			goto out;
+	}
+	if (backup_stream_finish(&stream) != 0)
+		goto out;
+	say_info("backup streamed to '%s', %llu bytes", path,
+		 (unsigned long long)stream.size);
+	rc = 0;
+out:
+	if (fd >= 0)
+		close(fd);
+	if (gc != NULL)
+		gc_consumer_unregister(gc);
+	if (backup_started)
+		box_backup_stop();
+	region_truncate(region, region_svp);
+	return rc;
+}
+
 const char *
 box_status(void)
 {
@@ -2267,5 +3377,6 @@ box_reset_stat(void)
 	rmean_cleanup(rmean_box);
 	rmean_cleanup(rmean_error);
 	engine_reset_stat();
+	wal_reset_stat();
 	space_foreach(box_reset_space_stat, NULL);
 }
@@ -52,6 +52,7 @@ struct ev_io;
 struct auth_request;
 struct space;
 struct vclock;
+struct bulk_load_source;
 
 /**
  * Pointer to TX thread local vclock.
@@ -155,6 +156,26 @@ box_backup_start(int checkpoint_idx, box_backup_cb cb, void *cb_arg);
 void
 box_backup_stop(void);
 
+/**
+ * Stream a backup to @path, which may be a regular file or
+ * a named pipe, in the tar format, see backup.h. The backup
+ * contains the files of checkpoint @checkpoint_idx, as returned
+ * by box_backup_start(), and the WAL files written since the
+ * checkpoint. Files are pinned while they are being streamed.
+ *
+ * If @since is not NULL, an incremental backup is streamed
+ * instead: it contains only the WAL files needed to roll
+ * forward from @since, e.g. the instance vclock at the time
+ * of the previous backup.
+ *
+ * @rate_limit is the max read rate, in bytes per second,
+ * 0 means unlimited. @cb is called for each streamed file.
+ */
+int
+box_backup_stream(int checkpoint_idx, const struct vclock *since,
+		  const char *path, double rate_limit,
+		  box_backup_cb cb, void *cb_arg);
+
 /**
  * Spit out some basic module status (master/slave, etc.
  */
@@ -166,6 +187,22 @@ const char *box_status(void);
 void
 box_reset_stat(void);
 
+/**
+ * Load tuples sorted by the primary key into an empty space
+ * bypassing the transaction and the write ahead log, so the
+ * loaded data is not replicated and doesn't fire triggers.
+ * Only supported by vinyl, which writes the tuples straight
+ * to a disk run.
+ *
+ * \param space_id space identifier
+ * \param source source of tuples
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ * \sa \code box.space[space_id]:bulk_load(tuples) \endcode
+ */
+int
+box_space_bulk_load(uint32_t space_id, struct bulk_load_source *source);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 
@@ -175,9 +212,19 @@ box_process_auth(struct auth_request *request, const char *salt);
 void
 box_process_join(struct ev_io *io, struct xrow_header *header);
 
+void
+box_process_register(struct ev_io *io, struct xrow_header *header);
+
 void
 box_process_subscribe(struct ev_io *io, struct xrow_header *header);
 
+/**
+ * Stream changes of the requested spaces to a change data
+ * capture consumer, see IPROTO_CDC_SUBSCRIBE.
+ */
+void
+box_process_cdc_subscribe(struct ev_io *io, struct xrow_header *header);
+
 void
 box_process_vote(struct ballot *ballot);
 
@@ -194,24 +241,44 @@ void box_set_log_level(void);
 void box_set_log_format(void);
 void box_set_io_collect_interval(void);
 void box_set_snap_io_rate_limit(void);
+void box_set_gc_remove_rate_limit(void);
 void box_set_too_long_threshold(void);
 void box_set_readahead(void);
 void box_set_checkpoint_count(void);
 void box_set_checkpoint_interval(void);
+void box_set_checkpoint_load_window(void);
 void box_set_checkpoint_wal_threshold(void);
+void box_set_wal_batch_delay(void);
+void box_set_wal_batch_max_size(void);
+void box_set_wal_compress_threads(void);
 void box_set_memtx_memory(void);
 void box_set_memtx_max_tuple_size(void);
+void box_set_memtx_snap_threads(void);
+void box_set_memtx_snap_delta_max(void);
 void box_set_vinyl_memory(void);
 void box_set_vinyl_max_tuple_size(void);
 void box_set_vinyl_cache(void);
+void box_set_vinyl_page_cache(void);
+void box_set_vinyl_read_ahead(void);
+void box_set_vinyl_index_cache(void);
 void box_set_vinyl_timeout(void);
+void box_set_vinyl_read_latency_budget(void);
 void box_set_replication_timeout(void);
 void box_set_replication_connect_timeout(void);
 void box_set_replication_connect_quorum(void);
 void box_set_replication_sync_lag(void);
 void box_set_replication_sync_timeout(void);
 void box_set_replication_skip_conflict(void);
+void box_set_replication_apply_fibers(void);
+void box_set_replication_compression(void);
+void box_set_replication_apply_batch_rows(void);
+void box_set_replication_apply_batch_delay(void);
+void box_set_replication_synchro_quorum(void);
+void box_set_replication_synchro_timeout(void);
 void box_set_net_msg_max(void);
+void box_set_iproto_zero_copy_threshold(void);
+void box_set_sql_cache_size(void);
+void box_set_eval_cache_size(void);
 
 extern "C" {
 #endif /* defined(__cplusplus) */
@@ -225,6 +292,18 @@ box_select(uint32_t space_id, uint32_t index_id,
 	   const char *key, const char *key_end,
 	   struct port *port);
 
+/**
+ * Like box_select(), but return only the given zero-based
+ * fields of each tuple. An index that stores all of them may
+ * skip fetching full tuples, see index_opts::covered_fields.
+ */
+int
+box_select_fields(uint32_t space_id, uint32_t index_id,
+		  int iterator, uint32_t offset, uint32_t limit,
+		  const char *key, const char *key_end,
+		  const uint32_t *fields, uint32_t field_count,
+		  struct port *port);
+
 /** \cond public */
 
 /*
@@ -246,6 +325,40 @@ typedef struct box_function_ctx box_function_ctx_t;
 API_EXPORT int
 box_return_tuple(box_function_ctx_t *ctx, box_tuple_t *tuple);
 
+/**
+ * A single call passed to the batch entry point of a stored C
+ * procedure.
+ *
+ * A module may export `<name>_batch` next to `<name>`:
+ *
+ *     int <name>_batch(box_function_call_t *calls, uint32_t count);
+ *
+ * If it does, concurrent calls of the procedure made by the same
+ * user are grouped and handed to the batch entry point at once.
+ * Results of each call are returned to its own \a ctx with
+ * box_return_tuple(). A single call is failed with
+ * box_return_error(), while -1 returned from the batch entry
+ * point fails all calls of the batch.
+ */
+typedef struct box_function_call {
+	/** Context of the call. */
+	box_function_ctx_t *ctx;
+	/** MsgPack array of the call arguments. */
+	const char *args;
+	/** End of \a args. */
+	const char *args_end;
+} box_function_call_t;
+
+/**
+ * Fail a call of a batch with the last error set by
+ * box_error_set(), see box_function_call_t.
+ *
+ * \param ctx an opaque structure passed to the stored C procedure by
+ * Tarantool
+ */
+API_EXPORT void
+box_return_error(box_function_ctx_t *ctx);
+
 /**
  * Find space id by name.
  *
@@ -303,6 +416,40 @@ API_EXPORT int
 box_replace(uint32_t space_id, const char *tuple, const char *tuple_end,
 	    box_tuple_t **result);
 
+/**
+ * Execute INSERT requests for an array of tuples in one
+ * transaction. The tuples are validated and sorted by the
+ * primary key before insertion. Outside of a transaction
+ * the batch is written to WAL at once. On error none of the
+ * tuples is inserted.
+ *
+ * \param space_id space identifier
+ * \param tuples encoded array of tuples ([ tuple1, tuple2, ...])
+ * \param tuples_end end of @a tuples
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ * \sa \code box.space[space_id]:insert_many(tuples) \endcode
+ */
+API_EXPORT int
+box_insert_batch(uint32_t space_id, const char *tuples,
+		 const char *tuples_end);
+
+/**
+ * Execute REPLACE requests for an array of tuples in one
+ * transaction, see box_insert_batch(). Tuples with equal
+ * primary keys are replaced in the order of the array.
+ *
+ * \param space_id space identifier
+ * \param tuples encoded array of tuples ([ tuple1, tuple2, ...])
+ * \param tuples_end end of @a tuples
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ * \sa \code box.space[space_id]:replace_many(tuples) \endcode
+ */
+API_EXPORT int
+box_replace_batch(uint32_t space_id, const char *tuples,
+		  const char *tuples_end);
+
 /**
  * Execute an DELETE request.
  *
@@ -42,6 +42,50 @@
 #include "rmean.h"
 #include "small/obuf.h"
 
+enum {
+	/** Number of slots in the function access cache. */
+	FUNC_ACCESS_CACHE_SIZE = 256,
+	/** Longer function names are not cached. */
+	FUNC_ACCESS_CACHE_NAME_MAX = 56,
+};
+
+/**
+ * A successful result of access_check_func() for a function
+ * name and a user. Saves a lookup in the function cache and
+ * the privilege checks on repeated calls of the same function.
+ */
+struct func_access_cache_entry {
+	/** access_version the entry is valid for. */
+	uint32_t version;
+	/** Credentials the access was granted to. */
+	uint8_t auth_token;
+	user_access_t universal_access;
+	/** Found function, NULL if it isn't in _func. */
+	struct func *func;
+	uint32_t name_len;
+	char name[FUNC_ACCESS_CACHE_NAME_MAX];
+};
+
+/**
+ * Direct-mapped cache of granted function access. Any change
+ * of functions, users or privileges bumps access_version,
+ * which invalidates all entries.
+ */
+static struct func_access_cache_entry
+func_access_cache[FUNC_ACCESS_CACHE_SIZE];
+
+static inline struct func_access_cache_entry *
+func_access_cache_slot(const char *name, uint32_t name_len)
+{
+	assert(name_len > 0);
+	uint32_t h = name_len;
+	h = h * 31 + (unsigned char) name[0];
+	h = h * 31 + (unsigned char) name[name_len / 2];
+	h = h * 31 + (unsigned char) name[name_len - 1];
+	h *= 2654435761u;
+	return &func_access_cache[h % FUNC_ACCESS_CACHE_SIZE];
+}
+
 /**
  * Find a function by name and check "EXECUTE" permissions.
  *
@@ -57,8 +101,20 @@
 static inline int
 access_check_func(const char *name, uint32_t name_len, struct func **funcp)
 {
-	struct func *func = func_by_name(name, name_len);
 	struct credentials *credentials = effective_user();
+	struct func_access_cache_entry *entry = NULL;
+	if (name_len > 0 && name_len <= FUNC_ACCESS_CACHE_NAME_MAX) {
+		entry = func_access_cache_slot(name, name_len);
+		if (entry->version == access_version &&
+		    entry->auth_token == credentials->auth_token &&
+		    entry->universal_access == credentials->universal_access &&
+		    entry->name_len == name_len &&
+		    memcmp(entry->name, name, name_len) == 0) {
+			*funcp = entry->func;
+			return 0;
+		}
+	}
+	struct func *func = func_by_name(name, name_len);
 	/*
 	 * If the user has universal access, don't bother with checks.
 	 * No special check for ADMIN user is necessary
@@ -101,6 +157,14 @@ access_check_func(const char *name, uint32_t name_len, struct func **funcp)
 	}
 
 	*funcp = func;
+	if (entry != NULL) {
+		entry->version = access_version;
+		entry->auth_token = credentials->auth_token;
+		entry->universal_access = credentials->universal_access;
+		entry->func = func;
+		entry->name_len = name_len;
+		memcpy(entry->name, name, name_len);
+	}
 	return 0;
 }
 
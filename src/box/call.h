@@ -38,8 +38,12 @@ extern "C" {
 struct port;
 struct call_request;
 
+struct error;
+
 struct box_function_ctx {
 	struct port *port;
+	/** Error of a call of a batch, see box_return_error(). */
+	struct error *error;
 };
 
 /**
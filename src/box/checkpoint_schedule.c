@@ -74,3 +74,53 @@ checkpoint_schedule_timeout(struct checkpoint_schedule *sched, double now)
 	assert(timeout > 0);
 	return timeout;
 }
+
+void
+checkpoint_schedule_set_window(struct checkpoint_schedule *sched,
+			       double window)
+{
+	sched->window = window;
+}
+
+double
+checkpoint_schedule_adjust(struct checkpoint_schedule *sched, double now,
+			   enum checkpoint_load load, bool *is_due)
+{
+	assert(sched->interval > 0 && sched->window > 0);
+	const double period = CHECKPOINT_SCHEDULE_CHECK_PERIOD;
+	double window = fmin(sched->window, sched->interval / 2);
+	double timeout = checkpoint_schedule_timeout(sched, now);
+	/* Time elapsed since the last scheduled checkpoint. */
+	double elapsed = sched->interval - timeout;
+
+	if (now >= sched->start_time && elapsed < window) {
+		/*
+		 * The checkpoint is overdue: any checkpoint made
+		 * moves the schedule to the future. Defer it while
+		 * the disk is busy, but not past the window.
+		 */
+		if (load == CHECKPOINT_LOAD_BUSY && elapsed + period < window) {
+			*is_due = false;
+			return period;
+		}
+		*is_due = true;
+		return 0;
+	}
+	if (timeout > window) {
+		/* Wake up when the window opens. */
+		*is_due = false;
+		return timeout - window;
+	}
+	if (load == CHECKPOINT_LOAD_IDLE) {
+		/* The disk is idle, make the checkpoint early. */
+		*is_due = true;
+		return 0;
+	}
+	if (timeout > period) {
+		*is_due = false;
+		return period;
+	}
+	/* Defer the checkpoint if the disk is still busy by then. */
+	*is_due = load != CHECKPOINT_LOAD_BUSY;
+	return timeout;
+}
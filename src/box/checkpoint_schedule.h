@@ -31,10 +31,22 @@
  * SUCH DAMAGE.
  */
 
+#include <stdbool.h>
+
 #if defined(__cplusplus)
 extern "C" {
 #endif /* defined(__cplusplus) */
 
+/** Disk load as seen from the WAL write rate. */
+enum checkpoint_load {
+	/** WAL writes are well below the average rate. */
+	CHECKPOINT_LOAD_IDLE,
+	/** WAL writes are about the average rate. */
+	CHECKPOINT_LOAD_NORMAL,
+	/** WAL writes are well above the average rate. */
+	CHECKPOINT_LOAD_BUSY,
+};
+
 struct checkpoint_schedule {
 	/**
 	 * Configured interval between checkpoints, in seconds.
@@ -46,6 +58,13 @@ struct checkpoint_schedule {
 	 * for calculating times of all subsequent checkpoints.
 	 */
 	double start_time;
+	/**
+	 * A scheduled checkpoint may be made up to this many
+	 * seconds earlier if the disk is idle or deferred up to
+	 * this many seconds if it's busy, see
+	 * checkpoint_schedule_adjust(). 0 if disabled.
+	 */
+	double window;
 };
 
 /**
@@ -78,6 +97,36 @@ checkpoint_schedule_reset(struct checkpoint_schedule *sched, double now);
 double
 checkpoint_schedule_timeout(struct checkpoint_schedule *sched, double now);
 
+/**
+ * Set the window of adjusting the schedule to the disk load,
+ * see checkpoint_schedule::window. It's capped at a half of
+ * the interval between checkpoints.
+ */
+void
+checkpoint_schedule_set_window(struct checkpoint_schedule *sched,
+			       double window);
+
+/**
+ * Return the time to wait before checking the schedule again,
+ * in seconds, given the current disk @load. Set @is_due if
+ * a checkpoint must be made once the time passes. A zero time
+ * with @is_due set means the checkpoint must be made now.
+ *
+ * Within the window before a scheduled checkpoint, it's made
+ * as soon as the disk gets idle. Within the window after it,
+ * it's deferred while the disk is busy. The load is checked
+ * every CHECKPOINT_SCHEDULE_CHECK_PERIOD seconds then.
+ *
+ * Must only be called if periodic checkpointing is enabled
+ * and the window is set.
+ */
+double
+checkpoint_schedule_adjust(struct checkpoint_schedule *sched, double now,
+			   enum checkpoint_load load, bool *is_due);
+
+/** How often the load is checked within the window, in seconds. */
+#define CHECKPOINT_SCHEDULE_CHECK_PERIOD 1.0
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
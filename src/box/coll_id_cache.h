@@ -38,6 +38,13 @@ extern "C" {
 
 struct coll_id;
 
+/**
+ * Incremented whenever a collation is added to or removed from
+ * the cache. Objects keeping collation pointers without taking
+ * a reference use it to find out that they may be stale.
+ */
+extern uint32_t coll_id_cache_version;
+
 /**
  * Create global hash tables.
  * @return - 0 on success, -1 on memory error.
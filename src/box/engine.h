@@ -62,6 +62,11 @@ struct engine_memory_stat {
 	size_t cache;
 	/** Size of memory used by active transactions. */
 	size_t tx;
+	/**
+	 * Size of memory that has been freed, but is kept
+	 * for open read views, e.g. checkpoints.
+	 */
+	size_t delayed_free;
 };
 
 typedef int
@@ -227,6 +227,13 @@ struct errcode_record {
 	/*172 */_(ER_ROWID_OVERFLOW,            "Rowid is overflowed: too many entries in ephemeral space") \
 	/*173 */_(ER_DROP_COLLATION,		"Can't drop collation %s : %s") \
 	/*174 */_(ER_ILLEGAL_COLLATION_MIX,	"Illegal mix of collations") \
+	/*175 */_(ER_WRONG_QUERY_ID,		"Prepared statement with id %u does not exist") \
+	/*176 */_(ER_SQL_PREPARE,		"Failed to prepare SQL statement: %s") \
+	/*177 */_(ER_SPACE_QUOTA,		"Memory quota of space '%s' exceeded") \
+	/*178 */_(ER_MULTIKEY_INDEX_MISMATCH,	"Field %s is used as multikey in one index and as single key in another") \
+	/*179 */_(ER_FUNC_INDEX_FUNC,		"Failed to build a key for functional index '%s' of space '%s': %s") \
+	/*180 */_(ER_SYNC_QUORUM_TIMEOUT,	"Quorum collection for a synchronous transaction is timed out") \
+	/*181 */_(ER_TRANSACTION_IS_READ_ONLY,	"Can't modify data in a read-only transaction") \
 
 /*
  * !IMPORTANT! Please follow instructions at start of the file
@@ -41,8 +41,10 @@
 #include "xrow.h"
 #include "schema.h"
 #include "port.h"
+#include "session.h"
 #include "tuple.h"
 #include "sql/vdbe.h"
+#include "sql_stmt_cache.h"
 
 const char *sql_type_strs[] = {
 	NULL,
@@ -503,9 +505,24 @@ sql_get_description(struct sql_stmt *stmt, struct obuf *out,
 	return 0;
 }
 
+/**
+ * Push the rows collected in @a port to the client as an
+ * IPROTO_CHUNK message and start collecting anew.
+ */
+static int
+sql_port_push(struct port *port)
+{
+	struct session *session = current_session();
+	if (session_push(session, session_sync(session), port) != 0)
+		return -1;
+	port_destroy(port);
+	port_tuple_create(port);
+	return 0;
+}
+
 static inline int
 sql_execute(sql *db, struct sql_stmt *stmt, struct port *port,
-	    struct region *region)
+	    struct region *region, uint32_t chunk_size)
 {
 	int rc, column_count = sql_column_count(stmt);
 	if (column_count > 0) {
@@ -514,6 +531,10 @@ sql_execute(sql *db, struct sql_stmt *stmt, struct port *port,
 			if (sql_row_to_port(stmt, column_count, region,
 					    port) != 0)
 				return -1;
+			if (chunk_size != 0 &&
+			    ((struct port_tuple *) port)->size >=
+			    (int) chunk_size && sql_port_push(port) != 0)
+				return -1;
 		}
 		assert(rc == SQL_DONE || rc != SQL_OK);
 	} else {
@@ -528,30 +549,237 @@ sql_execute(sql *db, struct sql_stmt *stmt, struct port *port,
 	return 0;
 }
 
+/**
+ * Compile an SQL statement.
+ * @retval NULL Client or memory error.
+ */
+static struct sql_stmt *
+sql_compile(struct sql *db, const char *sql, int len)
+{
+	struct sql_stmt *stmt;
+	if (sql_prepare_v2(db, sql, len, &stmt, NULL) != SQL_OK) {
+		diag_set(ClientError, ER_SQL_EXECUTE, sql_errmsg(db));
+		return NULL;
+	}
+	assert(stmt != NULL);
+	return stmt;
+}
+
+/**
+ * Take the statement of a cache entry for execution. The
+ * statement is recompiled if the schema or index statistics
+ * have changed since it was prepared: the plan is chosen at
+ * compile time and is reused by all executions otherwise. If
+ * the statement is being executed by another request, a private
+ * copy is compiled instead.
+ */
+static int
+sql_stmt_cache_take(struct sql *db, struct stmt_cache_entry *entry,
+		    struct sql_response *response)
+{
+	struct sql_stmt *stmt;
+	response->stmt_id = entry->id;
+	if (entry->is_busy) {
+		stmt = sql_compile(db, entry->sql, entry->sql_len);
+		if (stmt == NULL)
+			return -1;
+		entry = NULL;
+	} else {
+		if (entry->schema_version != schema_version ||
+		    entry->stat_version != sql_stat_version) {
+			stmt = sql_compile(db, entry->sql, entry->sql_len);
+			if (stmt == NULL)
+				return -1;
+			sql_stmt_cache_update(entry, stmt, schema_version,
+					      sql_stat_version);
+		}
+		stmt = entry->stmt;
+		entry->is_busy = true;
+	}
+	response->prep_stmt = stmt;
+	response->cache_entry = entry;
+	return 0;
+}
+
+/**
+ * Find a statement in the cache or compile it and add to the
+ * cache.
+ */
+static int
+sql_stmt_get(struct sql *db, const char *sql, int len,
+	     struct sql_response *response)
+{
+	struct stmt_cache_entry *entry = sql_stmt_cache_find(sql, len);
+	if (entry != NULL)
+		return sql_stmt_cache_take(db, entry, response);
+	struct sql_stmt *stmt = sql_compile(db, sql, len);
+	if (stmt == NULL)
+		return -1;
+	if (sql_stmt_cache_insert(stmt, sql, len, schema_version,
+				  sql_stat_version, &entry) != 0) {
+		sql_finalize(stmt);
+		return -1;
+	}
+	response->stmt_id = 0;
+	if (entry != NULL) {
+		entry->is_busy = true;
+		response->stmt_id = entry->id;
+	}
+	response->prep_stmt = stmt;
+	response->cache_entry = entry;
+	return 0;
+}
+
+/**
+ * Return a statement taken by a request. A cached statement
+ * is reset to be reused by the next request, a private one is
+ * deleted.
+ */
+static void
+sql_stmt_put(struct sql_response *response)
+{
+	struct sql_stmt *stmt = (struct sql_stmt *) response->prep_stmt;
+	struct stmt_cache_entry *entry = response->cache_entry;
+	if (entry == NULL) {
+		sql_finalize(stmt);
+		return;
+	}
+	sql_reset(stmt);
+	sql_clear_bindings(stmt);
+	/* The list was allocated on the request region. */
+	stailq_create(vdbe_autoinc_id_list((struct Vdbe *) stmt));
+	sql_stmt_cache_release(entry);
+}
+
+void
+sql_response_destroy(struct sql_response *response)
+{
+	port_destroy(&response->port);
+	sql_stmt_put(response);
+}
+
+/** Bind parameters and run a statement taken by a request. */
+static int
+sql_stmt_run(struct sql *db, const struct sql_bind *bind, uint32_t bind_count,
+	     uint32_t chunk_size, struct sql_response *response,
+	     struct region *region)
+{
+	struct sql_stmt *stmt = (struct sql_stmt *) response->prep_stmt;
+	port_tuple_create(&response->port);
+	if (sql_bind(stmt, bind, bind_count) == 0 &&
+	    sql_execute(db, stmt, &response->port, region, chunk_size) == 0)
+		return 0;
+	sql_response_destroy(response);
+	return -1;
+}
+
 int
 sql_prepare_and_execute(const char *sql, int len, const struct sql_bind *bind,
-			uint32_t bind_count, struct sql_response *response,
-			struct region *region)
+			uint32_t bind_count, uint32_t chunk_size,
+			struct sql_response *response, struct region *region)
 {
-	struct sql_stmt *stmt;
 	struct sql *db = sql_get();
 	if (db == NULL) {
 		diag_set(ClientError, ER_LOADING);
 		return -1;
 	}
-	if (sql_prepare_v2(db, sql, len, &stmt, NULL) != SQL_OK) {
-		diag_set(ClientError, ER_SQL_EXECUTE, sql_errmsg(db));
+	if (sql_stmt_get(db, sql, len, response) != 0)
+		return -1;
+	return sql_stmt_run(db, bind, bind_count, chunk_size, response,
+			    region);
+}
+
+int
+sql_execute_prepared(uint32_t stmt_id, const struct sql_bind *bind,
+		     uint32_t bind_count, uint32_t chunk_size,
+		     struct sql_response *response, struct region *region)
+{
+	struct sql *db = sql_get();
+	if (db == NULL) {
+		diag_set(ClientError, ER_LOADING);
+		return -1;
+	}
+	struct stmt_cache_entry *entry = sql_stmt_cache_find_by_id(stmt_id);
+	if (entry == NULL) {
+		diag_set(ClientError, ER_WRONG_QUERY_ID, stmt_id);
+		return -1;
+	}
+	if (sql_stmt_cache_take(db, entry, response) != 0)
+		return -1;
+	return sql_stmt_run(db, bind, bind_count, chunk_size, response,
+			    region);
+}
+
+int
+sql_prepare(const char *sql, int len, struct sql_response *response)
+{
+	struct sql *db = sql_get();
+	if (db == NULL) {
+		diag_set(ClientError, ER_LOADING);
+		return -1;
+	}
+	if (sql_stmt_get(db, sql, len, response) != 0)
+		return -1;
+	if (response->stmt_id == 0) {
+		sql_finalize((struct sql_stmt *) response->prep_stmt);
+		diag_set(ClientError, ER_SQL_PREPARE,
+			 "statement doesn't fit in the statement cache");
 		return -1;
 	}
-	assert(stmt != NULL);
 	port_tuple_create(&response->port);
-	response->prep_stmt = stmt;
-	if (sql_bind(stmt, bind, bind_count) == 0 &&
-	    sql_execute(db, stmt, &response->port, region) == 0)
-		return 0;
-	port_destroy(&response->port);
-	sql_finalize(stmt);
-	return -1;
+	return 0;
+}
+
+int
+sql_prepare_response_dump(struct sql_response *response, struct obuf *out)
+{
+	struct sql_stmt *stmt = (struct sql_stmt *) response->prep_stmt;
+	int rc = -1;
+	int column_count = sql_column_count(stmt);
+	int bind_count = sql_bind_parameter_count(stmt);
+	int keys = column_count > 0 ? 4 : 3;
+	size_t size = mp_sizeof_map(keys) + mp_sizeof_uint(IPROTO_STMT_ID) +
+		      mp_sizeof_uint(response->stmt_id) +
+		      mp_sizeof_uint(IPROTO_BIND_COUNT) +
+		      mp_sizeof_uint(bind_count) +
+		      mp_sizeof_uint(IPROTO_BIND_METADATA) +
+		      mp_sizeof_array(bind_count);
+	char *pos = (char *) obuf_alloc(out, size);
+	if (pos == NULL) {
+		diag_set(OutOfMemory, size, "obuf_alloc", "pos");
+		goto finish;
+	}
+	pos = mp_encode_map(pos, keys);
+	pos = mp_encode_uint(pos, IPROTO_STMT_ID);
+	pos = mp_encode_uint(pos, response->stmt_id);
+	pos = mp_encode_uint(pos, IPROTO_BIND_COUNT);
+	pos = mp_encode_uint(pos, bind_count);
+	pos = mp_encode_uint(pos, IPROTO_BIND_METADATA);
+	pos = mp_encode_array(pos, bind_count);
+	for (int i = 0; i < bind_count; ++i) {
+		/* Parameters are numbered from 1. */
+		const char *name = sql_bind_parameter_name(stmt, i + 1);
+		if (name == NULL)
+			name = "?";
+		uint32_t len = strlen(name);
+		size = mp_sizeof_map(1) + mp_sizeof_uint(IPROTO_FIELD_NAME) +
+		       mp_sizeof_str(len);
+		pos = (char *) obuf_alloc(out, size);
+		if (pos == NULL) {
+			diag_set(OutOfMemory, size, "obuf_alloc", "pos");
+			goto finish;
+		}
+		pos = mp_encode_map(pos, 1);
+		pos = mp_encode_uint(pos, IPROTO_FIELD_NAME);
+		pos = mp_encode_str(pos, name, len);
+	}
+	if (column_count > 0 &&
+	    sql_get_description(stmt, out, column_count) != 0)
+		goto finish;
+	rc = 0;
+finish:
+	sql_response_destroy(response);
+	return rc;
 }
 
 int
@@ -643,7 +871,6 @@ err:
 		}
 	}
 finish:
-	port_destroy(&response->port);
-	sql_finalize(stmt);
+	sql_response_destroy(response);
 	return rc;
 }
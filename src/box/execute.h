@@ -51,13 +51,21 @@ extern const char *sql_info_key_strs[];
 struct obuf;
 struct region;
 struct sql_bind;
+struct stmt_cache_entry;
 
-/** Response on EXECUTE request. */
+/** Response on EXECUTE or PREPARE request. */
 struct sql_response {
 	/** Port with response data if any. */
 	struct port port;
 	/** Prepared SQL statement with metadata. */
 	void *prep_stmt;
+	/**
+	 * Statement cache entry @prep_stmt belongs to, NULL
+	 * if the statement is private to the request.
+	 */
+	struct stmt_cache_entry *cache_entry;
+	/** Id of the cached statement, 0 if it isn't cached. */
+	uint32_t stmt_id;
 };
 
 /**
@@ -119,6 +127,10 @@ sql_response_dump(struct sql_response *response, struct obuf *out);
  * @param len Length of @a sql.
  * @param bind Array of parameters.
  * @param bind_count Length of @a bind.
+ * @param chunk_size If not 0, rows are pushed to the client
+ *        session in chunks of this many rows as they are
+ *        produced, and only the rest of them is left in
+ *        @a response.
  * @param[out] response Response to store result.
  * @param region Runtime allocator for temporary objects
  *        (columns, tuples ...).
@@ -128,8 +140,65 @@ sql_response_dump(struct sql_response *response, struct obuf *out);
  */
 int
 sql_prepare_and_execute(const char *sql, int len, const struct sql_bind *bind,
-			uint32_t bind_count, struct sql_response *response,
-			struct region *region);
+			uint32_t bind_count, uint32_t chunk_size,
+			struct sql_response *response, struct region *region);
+
+/**
+ * Execute a statement prepared with PREPARE request.
+ * @param stmt_id Id of the statement.
+ * @param bind Array of parameters.
+ * @param bind_count Length of @a bind.
+ * @param chunk_size See sql_prepare_and_execute().
+ * @param[out] response Response to store result.
+ * @param region Runtime allocator for temporary objects.
+ *
+ * @retval  0 Success.
+ * @retval -1 Client or memory error.
+ */
+int
+sql_execute_prepared(uint32_t stmt_id, const struct sql_bind *bind,
+		     uint32_t bind_count, uint32_t chunk_size,
+		     struct sql_response *response, struct region *region);
+
+/**
+ * Compile an SQL statement and put it into the statement cache
+ * without executing it.
+ * @param sql SQL statement.
+ * @param len Length of @a sql.
+ * @param[out] response Response to store the statement.
+ *
+ * @retval  0 Success.
+ * @retval -1 Client or memory error.
+ */
+int
+sql_prepare(const char *sql, int len, struct sql_response *response);
+
+/**
+ * Dump a response on PREPARE request into @an out buffer. The
+ * response is destroyed.
+ * Response body:
+ * +----------------------------------------------+
+ * | IPROTO_BODY: {                               |
+ * |     IPROTO_STMT_ID: number,                  |
+ * |     IPROTO_BIND_COUNT: number,               |
+ * |     IPROTO_BIND_METADATA: [                  |
+ * |         {IPROTO_FIELD_NAME: parameter name}, |
+ * |         ...                                  |
+ * |     ],                                       |
+ * |     IPROTO_METADATA: [ ... ]                 |
+ * | }                                            |
+ * +----------------------------------------------+
+ * IPROTO_METADATA is present only if the statement returns rows.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+sql_prepare_response_dump(struct sql_response *response, struct obuf *out);
+
+/** Destroy a response without dumping it. */
+void
+sql_response_destroy(struct sql_response *response);
 
 #if defined(__cplusplus)
 } /* extern "C" { */
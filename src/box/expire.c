@@ -0,0 +1,246 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "expire.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <msgpuck/msgpuck.h>
+
+#include "trivia/util.h"
+#include "diag.h"
+#include "error.h"
+#include "fiber.h"
+#include "say.h"
+#include "box.h"
+#include "index.h"
+#include "schema.h"
+#include "space.h"
+#include "tuple.h"
+#include "txn.h"
+
+enum {
+	/** Max number of tuples deleted in one transaction. */
+	EXPIRE_BATCH_SIZE = 1000,
+};
+
+/** Timeout between expiration rounds, in seconds. */
+static const double EXPIRE_PERIOD = 1.0;
+
+/** An index with the expire option. */
+struct expire_index {
+	uint32_t space_id;
+	uint32_t index_id;
+};
+
+static struct {
+	/** Fiber deleting expired tuples. */
+	struct fiber *fiber;
+	/** Indexes to check in the current round. */
+	struct expire_index *indexes;
+	/** Number of entries in indexes. */
+	uint32_t index_count;
+	/** Capacity of indexes. */
+	uint32_t index_capacity;
+} expire;
+
+/** space_foreach() callback collecting indexes to check. */
+static int
+expire_collect_space(struct space *space, void *arg)
+{
+	(void)arg;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct index *index = space->index[i];
+		if (!index->def->opts.expire)
+			continue;
+		if (expire.index_count == expire.index_capacity) {
+			uint32_t capacity = MAX(expire.index_capacity * 2, 16);
+			struct expire_index *indexes = realloc(expire.indexes,
+					capacity * sizeof(*indexes));
+			if (indexes == NULL) {
+				diag_set(OutOfMemory,
+					 capacity * sizeof(*indexes),
+					 "realloc", "expire indexes");
+				return -1;
+			}
+			expire.indexes = indexes;
+			expire.index_capacity = capacity;
+		}
+		struct expire_index *entry;
+		entry = &expire.indexes[expire.index_count++];
+		entry->space_id = space_id(space);
+		entry->index_id = index->def->iid;
+	}
+	return 0;
+}
+
+/**
+ * Delete up to EXPIRE_BATCH_SIZE tuples which expired by @a now
+ * from a space in one transaction. The tuples are looked up
+ * within the transaction, so that a concurrent update of a
+ * tuple aborts it in engines which may yield on read.
+ *
+ * @param entry Index ordering the tuples by expiration time.
+ * @param now Current time.
+ * @param[out] count Number of deleted tuples.
+ *
+ * @retval  0 Success.
+ * @retval -1 Error.
+ */
+static int
+expire_batch(struct expire_index *entry, uint64_t now, uint32_t *count)
+{
+	*count = 0;
+	/* The schema may have changed while we were sleeping. */
+	struct space *space = space_by_id(entry->space_id);
+	if (space == NULL)
+		return 0;
+	struct index *index = space_index(space, entry->index_id);
+	struct index *pk = space_index(space, 0);
+	if (index == NULL || pk == NULL || !index->def->opts.expire)
+		return 0;
+
+	char key[16];
+	char *key_end = mp_encode_array(key, 1);
+	key_end = mp_encode_uint(key_end, now);
+
+	if (box_txn_begin() != 0)
+		return -1;
+	struct region *region = &fiber()->gc;
+	const char **keys = region_alloc(region, EXPIRE_BATCH_SIZE *
+					 sizeof(*keys));
+	if (keys == NULL) {
+		diag_set(OutOfMemory, EXPIRE_BATCH_SIZE * sizeof(*keys),
+			 "region", "expired keys");
+		goto fail;
+	}
+	struct iterator *it = index_create_iterator(index, ITER_LE, key, 1);
+	if (it == NULL)
+		goto fail;
+	uint32_t n = 0;
+	while (n < EXPIRE_BATCH_SIZE) {
+		struct tuple *tuple;
+		if (iterator_next(it, &tuple) != 0) {
+			iterator_delete(it);
+			goto fail;
+		}
+		if (tuple == NULL)
+			break;
+		uint32_t key_size;
+		keys[n] = tuple_extract_key(tuple, pk->def->key_def,
+					    &key_size);
+		if (keys[n] == NULL) {
+			iterator_delete(it);
+			goto fail;
+		}
+		n++;
+	}
+	iterator_delete(it);
+	for (uint32_t i = 0; i < n; i++) {
+		const char *end = keys[i];
+		mp_next(&end);
+		if (box_delete(entry->space_id, 0, keys[i], end, NULL) != 0)
+			goto fail;
+	}
+	if (box_txn_commit() != 0)
+		return -1;
+	*count = n;
+	return 0;
+fail:
+	box_txn_rollback();
+	return -1;
+}
+
+/** Delete expired tuples from all spaces. */
+static void
+expire_round(void)
+{
+	expire.index_count = 0;
+	if (space_foreach(expire_collect_space, NULL) != 0) {
+		diag_log();
+		return;
+	}
+	for (uint32_t i = 0; i < expire.index_count; i++) {
+		struct expire_index *entry = &expire.indexes[i];
+		uint32_t count;
+		do {
+			/* Expiration stops if the instance goes read-only. */
+			if (box_is_ro())
+				return;
+			uint64_t now = (uint64_t)fiber_time();
+			if (expire_batch(entry, now, &count) != 0) {
+				say_error("failed to expire tuples in space %u",
+					  (unsigned)entry->space_id);
+				diag_log();
+				break;
+			}
+			/* Let other fibers run between batches. */
+			fiber_sleep(0);
+		} while (count == EXPIRE_BATCH_SIZE &&
+			 !fiber_is_cancelled());
+	}
+}
+
+static int
+expire_fiber_f(va_list ap)
+{
+	(void)ap;
+	while (!fiber_is_cancelled()) {
+		expire_round();
+		fiber_gc();
+		fiber_sleep(EXPIRE_PERIOD);
+	}
+	return 0;
+}
+
+void
+expire_init(void)
+{
+	expire.indexes = NULL;
+	expire.index_count = 0;
+	expire.index_capacity = 0;
+	expire.fiber = fiber_new("expire", expire_fiber_f);
+	if (expire.fiber == NULL)
+		panic("failed to start expiration fiber");
+	fiber_start(expire.fiber);
+}
+
+void
+expire_free(void)
+{
+	/*
+	 * The fiber isn't stopped, as the event loop isn't
+	 * running when this function is called.
+	 */
+	free(expire.indexes);
+	expire.indexes = NULL;
+	expire.index_count = expire.index_capacity = 0;
+}
@@ -34,6 +34,11 @@
 #include "lua/utils.h"
 #include "error.h"
 #include "diag.h"
+#include "fiber.h"
+#include "txn.h"
+#include "session.h"
+#include "call.h"
+#include "box.h"
 #include <dlfcn.h>
 
 /**
@@ -298,6 +303,16 @@ module_sym(struct module *module, const char *name)
 	return f;
 }
 
+/*
+ * Import the optional batch entry point of a function.
+ */
+static box_function_batch_f
+module_sym_batch(struct module *module, const char *name)
+{
+	return (box_function_batch_f)dlsym(module->handle,
+					   tt_sprintf("%s_batch", name));
+}
+
 int
 module_reload(const char *package, const char *package_end, struct module **module)
 {
@@ -319,6 +334,7 @@ module_reload(const char *package, const char *package_end, struct module **modu
 		func->func = module_sym(new_module, name.sym);
 		if (func->func == NULL)
 			goto restore;
+		func->batch = module_sym_batch(new_module, name.sym);
 		func->module = new_module;
 		rlist_move(&new_module->funcs, &func->item);
 	}
@@ -346,6 +362,7 @@ restore:
 			panic("Can't restore module function, "
 			      "server state is inconsistent");
 		}
+		func->batch = module_sym_batch(old_module, name.sym);
 		func->module = old_module;
 		rlist_move(&old_module->funcs, &func->item);
 	} while (func != rlist_first_entry(&old_module->funcs,
@@ -379,6 +396,7 @@ func_new(struct func_def *def)
 	 */
 	func->owner_credentials.auth_token = BOX_USER_MAX; /* invalid value */
 	func->func = NULL;
+	func->batch = NULL;
 	func->module = NULL;
 	return func;
 }
@@ -397,6 +415,7 @@ func_unload(struct func *func)
 	}
 	func->module = NULL;
 	func->func = NULL;
+	func->batch = NULL;
 }
 
 /**
@@ -427,11 +446,151 @@ func_load(struct func *func)
 	func->func = module_sym(module, name.sym);
 	if (func->func == NULL)
 		return -1;
+	func->batch = module_sym_batch(module, name.sym);
 	func->module = module;
 	rlist_add(&module->funcs, &func->item);
 	return 0;
 }
 
+enum {
+	/** Max number of calls invoked in one batch. */
+	FUNC_BATCH_MAX = 64,
+};
+
+/** A call waiting for its batch to be invoked. */
+struct func_batch_call {
+	box_function_call_t call;
+	/** Fiber making the call. */
+	struct fiber *fiber;
+	/** Set when results of the call are ready. */
+	bool is_done;
+	int rc;
+};
+
+/**
+ * Calls of a function with a batch entry point, which are
+ * collected while the first call yields and then invoked
+ * together. Lives on the stack of the first call.
+ */
+struct func_batch {
+	/** Batch entry point of the function. */
+	box_function_batch_f batch;
+	/** Effective user of all calls of the batch. */
+	uint8_t auth_token;
+	struct func_batch_call *calls[FUNC_BATCH_MAX];
+	uint32_t count;
+	/** Link in func_open_batches. */
+	struct rlist in_open;
+};
+
+/** Batches new calls can join. */
+static RLIST_HEAD(func_open_batches);
+
+/**
+ * Pass results of a batch call to the fiber that made it.
+ * @a e is the error of the whole batch, if any.
+ */
+static void
+func_batch_call_complete(struct func_batch_call *c, struct error *e)
+{
+	box_function_ctx_t *ctx = c->call.ctx;
+	if (ctx->error != NULL)
+		e = ctx->error;
+	if (e != NULL)
+		diag_add_error(&c->fiber->diag, e);
+	c->rc = e != NULL ? -1 : 0;
+	if (ctx->error != NULL) {
+		error_unref(ctx->error);
+		ctx->error = NULL;
+	}
+	c->is_done = true;
+}
+
+/**
+ * Call a function via its batch entry point. The first call
+ * opens a batch and yields once, so that concurrent calls
+ * of the function queued in tx can join it, then invokes the
+ * batch entry point for all of them and distributes results.
+ */
+static int
+func_call_batch(struct func *func, box_function_ctx_t *ctx,
+		const char *args, const char *args_end)
+{
+	struct func_batch_call self;
+	self.call.ctx = ctx;
+	self.call.args = args;
+	self.call.args_end = args_end;
+	self.fiber = fiber();
+	self.is_done = false;
+	self.rc = 0;
+	ctx->error = NULL;
+
+	box_function_batch_f batch_f = func->batch;
+	uint8_t auth_token = effective_user()->auth_token;
+	struct func_batch *batch;
+	rlist_foreach_entry(batch, &func_open_batches, in_open) {
+		if (batch->batch != batch_f || batch->auth_token != auth_token)
+			continue;
+		batch->calls[batch->count++] = &self;
+		if (batch->count == FUNC_BATCH_MAX)
+			rlist_del_entry(batch, in_open);
+		/* Results are written to our stack, wait for them. */
+		while (!self.is_done)
+			fiber_yield();
+		return self.rc;
+	}
+
+	struct func_batch open;
+	open.batch = batch_f;
+	open.auth_token = auth_token;
+	open.calls[0] = &self;
+	open.count = 1;
+	rlist_add_tail_entry(&func_open_batches, &open, in_open);
+	/*
+	 * The function may be deleted by DDL while we yield, but
+	 * the module stays loaded as long as it has active calls.
+	 */
+	struct module *module = func->module;
+	func = NULL;
+	++module->calls;
+	fiber_reschedule();
+	if (open.count < FUNC_BATCH_MAX)
+		rlist_del_entry(&open, in_open);
+
+	box_function_call_t calls[FUNC_BATCH_MAX];
+	for (uint32_t i = 0; i < open.count; i++)
+		calls[i] = open.calls[i]->call;
+	int rc = batch_f(calls, open.count);
+	--module->calls;
+	module_gc(module);
+
+	struct error *e = NULL;
+	if (rc != 0) {
+		if (diag_is_empty(diag_get()))
+			diag_set(ClientError, ER_PROC_C, "unknown error");
+		e = diag_last_error(diag_get());
+	} else if (in_txn() != NULL) {
+		/*
+		 * The transaction is shared by all calls of the
+		 * batch, so neither of them may commit it.
+		 */
+		diag_set(ClientError, ER_FUNCTION_TX_ACTIVE);
+		txn_rollback();
+		e = diag_last_error(diag_get());
+	}
+	if (e != NULL)
+		error_ref(e);
+	for (uint32_t i = 0; i < open.count; i++) {
+		struct func_batch_call *c = open.calls[i];
+		func_batch_call_complete(c, e);
+		if (c != &self)
+			fiber_wakeup(c->fiber);
+	}
+	if (e != NULL)
+		error_unref(e);
+	return self.rc;
+}
+
 int
 func_call(struct func *func, box_function_ctx_t *ctx, const char *args,
 	  const char *args_end)
@@ -440,6 +599,8 @@ func_call(struct func *func, box_function_ctx_t *ctx, const char *args,
 		if (func_load(func) != 0)
 			return -1;
 	}
+	if (func->batch != NULL)
+		return func_call_batch(func, ctx, args, args_end);
 
 	/* Module can be changed after function reload. */
 	struct module *module = func->module;
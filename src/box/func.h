@@ -69,6 +69,11 @@ struct func {
 	 * For C functions, the body of the function.
 	 */
 	box_function_f func;
+	/**
+	 * For C functions, the optional batch entry point,
+	 * see box_function_call_t.
+	 */
+	box_function_batch_f batch;
 	/**
 	 * Each stored function keeps a handle to the
 	 * dynamic library for the C callback.
@@ -86,4 +86,13 @@ typedef struct box_function_ctx box_function_ctx_t;
 typedef int (*box_function_f)(box_function_ctx_t *ctx,
 	     const char *args, const char *args_end);
 
+/**
+ * Optional batch entry point of C stored function, exported
+ * by the module as <name>_batch. Invoked once for a group of
+ * concurrent calls of the function.
+ */
+typedef struct box_function_call box_function_call_t;
+typedef int (*box_function_batch_f)(box_function_call_t *calls,
+	     uint32_t count);
+
 #endif /* TARANTOOL_BOX_FUNC_DEF_H_INCLUDED */
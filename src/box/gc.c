@@ -58,6 +58,15 @@
 #include "engine.h"		/* engine_collect_garbage() */
 #include "wal.h"		/* wal_collect_garbage() */
 #include "checkpoint_schedule.h"
+#include "gc_remove.h"
+#include "xlog.h"		/* xlog_set_priority_rate() */
+
+/** How often the WAL write rate is sampled, in seconds. */
+static const double GC_WAL_RATE_SAMPLE_PERIOD = 1;
+/** Averaging period of the current WAL write rate, in seconds. */
+static const double GC_WAL_RATE_SHORT_PERIOD = 5;
+/** Averaging period of the average WAL write rate, in seconds. */
+static const double GC_WAL_RATE_LONG_PERIOD = 600;
 
 struct gc_state gc;
 
@@ -66,6 +75,9 @@ gc_cleanup_fiber_f(va_list);
 static int
 gc_checkpoint_fiber_f(va_list);
 
+static void
+gc_wal_rate_timer_cb(struct ev_loop *loop, struct ev_timer *timer, int events);
+
 /**
  * Comparator used for ordering gc_consumer objects by signature
  * in a binary tree.
@@ -114,6 +126,12 @@ gc_init(void)
 	gc_tree_new(&gc.consumers);
 	fiber_cond_create(&gc.cleanup_cond);
 	checkpoint_schedule_cfg(&gc.checkpoint_schedule, 0, 0);
+	gc_remove_init();
+
+	gc.wal_sample_time = ev_monotonic_now(loop());
+	ev_timer_init(&gc.wal_rate_timer, gc_wal_rate_timer_cb,
+		      GC_WAL_RATE_SAMPLE_PERIOD, GC_WAL_RATE_SAMPLE_PERIOD);
+	ev_timer_start(loop(), &gc.wal_rate_timer);
 
 	gc.cleanup_fiber = fiber_new("gc", gc_cleanup_fiber_f);
 	if (gc.cleanup_fiber == NULL)
@@ -136,6 +154,9 @@ gc_free(void)
 	 * running when this function is called.
 	 */
 
+	gc_remove_free();
+	ev_timer_stop(loop(), &gc.wal_rate_timer);
+
 	/* Free checkpoints. */
 	struct gc_checkpoint *checkpoint, *next_checkpoint;
 	rlist_foreach_entry_safe(checkpoint, &gc.checkpoints, in_checkpoints,
@@ -327,6 +348,53 @@ gc_set_checkpoint_interval(double interval)
 		fiber_wakeup(gc.checkpoint_fiber);
 }
 
+void
+gc_set_checkpoint_window(double window)
+{
+	checkpoint_schedule_set_window(&gc.checkpoint_schedule, window);
+	if (!gc.checkpoint_is_in_progress)
+		fiber_wakeup(gc.checkpoint_fiber);
+}
+
+/**
+ * Update the WAL write rates and let rate-limited writers
+ * yield the disk bandwidth used by WAL writes.
+ */
+static void
+gc_wal_rate_timer_cb(struct ev_loop *loop, struct ev_timer *timer, int events)
+{
+	(void)timer;
+	(void)events;
+	double now = ev_monotonic_now(loop);
+	double dt = now - gc.wal_sample_time;
+	if (dt <= 0)
+		return;
+	int64_t bytes = wal_bytes_written();
+	double rate = (bytes - gc.wal_bytes) / dt;
+	gc.wal_bytes = bytes;
+	gc.wal_sample_time = now;
+	/* Exponential moving averages. */
+	gc.wal_rate += (rate - gc.wal_rate) *
+		       MIN(dt / GC_WAL_RATE_SHORT_PERIOD, 1);
+	gc.wal_avg_rate += (rate - gc.wal_avg_rate) *
+			   MIN(dt / GC_WAL_RATE_LONG_PERIOD, 1);
+	xlog_set_priority_rate(gc.wal_rate);
+}
+
+/**
+ * Estimate the disk load by comparing the current WAL write
+ * rate with the average one.
+ */
+static enum checkpoint_load
+gc_checkpoint_load(void)
+{
+	if (gc.wal_rate <= gc.wal_avg_rate / 2)
+		return CHECKPOINT_LOAD_IDLE;
+	if (gc.wal_rate > gc.wal_avg_rate * 3 / 2)
+		return CHECKPOINT_LOAD_BUSY;
+	return CHECKPOINT_LOAD_NORMAL;
+}
+
 void
 gc_add_checkpoint(const struct vclock *vclock)
 {
@@ -461,20 +529,27 @@ gc_checkpoint_fiber_f(va_list ap)
 
 	struct checkpoint_schedule *sched = &gc.checkpoint_schedule;
 	while (!fiber_is_cancelled()) {
-		double timeout = checkpoint_schedule_timeout(sched,
-					ev_monotonic_now(loop()));
-		if (timeout > 0) {
+		double now = ev_monotonic_now(loop());
+		double timeout = checkpoint_schedule_timeout(sched, now);
+		bool is_adjusted = timeout > 0 && sched->window > 0;
+		bool is_due = true;
+		if (timeout > 0 && (!is_adjusted || timeout > sched->window)) {
 			char buf[128];
 			struct tm tm;
 			time_t time = (time_t)(ev_now(loop()) + timeout);
 			localtime_r(&time, &tm);
 			strftime(buf, sizeof(buf), "%c", &tm);
 			say_info("scheduled next checkpoint for %s", buf);
-		} else {
+		}
+		if (is_adjusted) {
+			/* Move the checkpoint to a period of low load. */
+			timeout = checkpoint_schedule_adjust(sched, now,
+					gc_checkpoint_load(), &is_due);
+		} else if (timeout == 0) {
 			/* Periodic checkpointing is disabled. */
 			timeout = TIMEOUT_INFINITY;
 		}
-		if (!fiber_yield_timeout(timeout) &&
+		if (timeout > 0 && !fiber_yield_timeout(timeout) &&
 		    !gc.checkpoint_is_pending) {
 			/*
 			 * The checkpoint schedule has changed.
@@ -482,6 +557,10 @@ gc_checkpoint_fiber_f(va_list ap)
 			 */
 			continue;
 		}
+		if (!is_due && !gc.checkpoint_is_pending) {
+			/* Check the load again. */
+			continue;
+		}
 		/* Time to make the next scheduled checkpoint. */
 		gc.checkpoint_is_pending = false;
 		if (gc.checkpoint_is_in_progress) {
@@ -493,6 +572,13 @@ gc_checkpoint_fiber_f(va_list ap)
 		}
 		if (gc_do_checkpoint() != 0)
 			diag_log();
+		/*
+		 * The checkpoint may have been moved, count the
+		 * next one from it.
+		 */
+		if (is_adjusted)
+			checkpoint_schedule_reset(sched,
+						  ev_monotonic_now(loop()));
 	}
 	return 0;
 }
@@ -34,6 +34,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <small/rlist.h>
+#include <tarantool_ev.h>
 
 #include "fiber_cond.h"
 #include "vclock.h"
@@ -156,6 +157,16 @@ struct gc_state {
 	 * a checkpoint as soon as possible despite the schedule.
 	 */
 	bool checkpoint_is_pending;
+	/** Timer sampling the WAL write rate. */
+	struct ev_timer wal_rate_timer;
+	/** Value of wal_bytes_written() at the last sample. */
+	int64_t wal_bytes;
+	/** Time of the last sample. */
+	double wal_sample_time;
+	/** WAL write rate over the last few seconds, bytes/s. */
+	double wal_rate;
+	/** WAL write rate over the last few minutes, bytes/s. */
+	double wal_avg_rate;
 };
 extern struct gc_state gc;
 
@@ -231,6 +242,14 @@ gc_set_min_checkpoint_count(int min_checkpoint_count);
 void
 gc_set_checkpoint_interval(double interval);
 
+/**
+ * Set the time window within which a scheduled checkpoint
+ * may be moved to a period of low WAL load, in seconds, see
+ * checkpoint_schedule_adjust(). 0 disables adjusting.
+ */
+void
+gc_set_checkpoint_window(double window);
+
 /**
  * Track an existing checkpoint in the garbage collector state.
  * Note, this function may trigger garbage collection to remove
@@ -0,0 +1,279 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "gc_remove.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <small/rlist.h>
+
+#include "trivia/util.h"
+#include "tt_pthread.h"
+#include "say.h"
+
+enum {
+	/** Min size of data freed at once. */
+	GC_REMOVE_STEP_MIN = 1024 * 1024,
+};
+
+/** Period of freeing data of a file, in seconds. */
+static const double GC_REMOVE_STEP_PERIOD = 0.1;
+
+/** A file being removed. */
+struct gc_remove_entry {
+	/** Link in gc_remove::pending or gc_remove::removing. */
+	struct rlist in_queue;
+	/** Descriptor of an unlinked file, -1 if not open yet. */
+	int fd;
+	/** Size of data left to free. */
+	off_t size;
+	/** Path to the file. */
+	char path[0];
+};
+
+static struct {
+	pthread_t thread;
+	/** Set if the background thread is running. */
+	bool is_started;
+	/** Set if the background thread is asked to stop. */
+	bool is_stopped;
+	/** Protects all members of this structure. */
+	pthread_mutex_t mutex;
+	/** Signaled on new files and on shutdown. */
+	pthread_cond_t cond;
+	/** Rate of freeing disk space, bytes per second. */
+	double rate;
+	/** Files queued for removal, not unlinked yet. */
+	struct rlist pending;
+	/** Unlinked files, freed in order. */
+	struct rlist removing;
+	/** Statistics, see gc_remove_stat(). */
+	struct gc_remove_stat stat;
+} gc_remove;
+
+static double
+gc_remove_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Unlink a file keeping it open, so that its space could be
+ * freed gradually, but its name could be reused at once.
+ */
+static void
+gc_remove_unlink(struct gc_remove_entry *entry)
+{
+	struct stat st;
+	entry->fd = open(entry->path, O_RDWR);
+	if (entry->fd >= 0 && fstat(entry->fd, &st) == 0) {
+		entry->size = st.st_size;
+	} else if (entry->fd >= 0) {
+		close(entry->fd);
+		entry->fd = -1;
+	}
+	if (unlink(entry->path) == 0) {
+		say_info("removed %s", entry->path);
+	} else if (errno != ENOENT) {
+		say_syserror("error while removing %s", entry->path);
+	}
+}
+
+/**
+ * Free a step of the first file in the queue. Returns
+ * the number of bytes freed. Must be called without the
+ * mutex held.
+ */
+static off_t
+gc_remove_step(struct gc_remove_entry *entry, double rate)
+{
+	off_t step = entry->size;
+	if (rate > 0)
+		step = MIN(step, MAX((off_t)(rate * GC_REMOVE_STEP_PERIOD),
+				     (off_t)GC_REMOVE_STEP_MIN));
+	if (ftruncate(entry->fd, entry->size - step) != 0) {
+		say_syserror("failed to truncate removed %s", entry->path);
+		/* Let the kernel free the rest on close. */
+		step = entry->size;
+	}
+	return step;
+}
+
+static void *
+gc_remove_f(void *arg)
+{
+	(void)arg;
+	double next_step_time = 0;
+	tt_pthread_mutex_lock(&gc_remove.mutex);
+	while (!gc_remove.is_stopped) {
+		/*
+		 * Unlink new files first so that they don't
+		 * show up in directory scans.
+		 */
+		while (!rlist_empty(&gc_remove.pending)) {
+			struct gc_remove_entry *entry = rlist_shift_entry(
+				&gc_remove.pending, struct gc_remove_entry,
+				in_queue);
+			tt_pthread_mutex_unlock(&gc_remove.mutex);
+			gc_remove_unlink(entry);
+			tt_pthread_mutex_lock(&gc_remove.mutex);
+			if (entry->fd < 0) {
+				gc_remove.stat.files--;
+				free(entry);
+				continue;
+			}
+			gc_remove.stat.size += entry->size;
+			rlist_add_tail_entry(&gc_remove.removing, entry,
+					     in_queue);
+		}
+		if (rlist_empty(&gc_remove.removing)) {
+			tt_pthread_cond_wait(&gc_remove.cond,
+					     &gc_remove.mutex);
+			continue;
+		}
+		double rate = gc_remove.rate;
+		double now = gc_remove_time();
+		if (rate > 0 && now < next_step_time) {
+			struct timespec ts;
+			ts.tv_sec = (time_t)next_step_time;
+			ts.tv_nsec = (next_step_time - ts.tv_sec) * 1e9;
+			tt_pthread_cond_timedwait(&gc_remove.cond,
+						  &gc_remove.mutex, &ts);
+			continue;
+		}
+		struct gc_remove_entry *entry = rlist_first_entry(
+			&gc_remove.removing, struct gc_remove_entry, in_queue);
+		tt_pthread_mutex_unlock(&gc_remove.mutex);
+		off_t step = gc_remove_step(entry, rate);
+		tt_pthread_mutex_lock(&gc_remove.mutex);
+		if (rate > 0)
+			next_step_time = now + step / rate;
+		entry->size -= step;
+		gc_remove.stat.size -= step;
+		gc_remove.stat.removed += step;
+		if (entry->size == 0) {
+			rlist_del_entry(entry, in_queue);
+			close(entry->fd);
+			gc_remove.stat.files--;
+			free(entry);
+		}
+	}
+	tt_pthread_mutex_unlock(&gc_remove.mutex);
+	return NULL;
+}
+
+void
+gc_remove_init(void)
+{
+	tt_pthread_mutex_init(&gc_remove.mutex, NULL);
+	tt_pthread_cond_init(&gc_remove.cond, NULL);
+	rlist_create(&gc_remove.pending);
+	rlist_create(&gc_remove.removing);
+}
+
+void
+gc_remove_free(void)
+{
+	tt_pthread_mutex_lock(&gc_remove.mutex);
+	bool is_started = gc_remove.is_started;
+	gc_remove.is_stopped = true;
+	tt_pthread_cond_signal(&gc_remove.cond);
+	tt_pthread_mutex_unlock(&gc_remove.mutex);
+	if (is_started)
+		tt_pthread_join(gc_remove.thread, NULL);
+	/*
+	 * Closing a file frees its space at once, which is fine
+	 * on shutdown. Pending files are left for the next run.
+	 */
+	struct gc_remove_entry *entry, *next;
+	rlist_foreach_entry_safe(entry, &gc_remove.removing, in_queue, next) {
+		close(entry->fd);
+		free(entry);
+	}
+	rlist_foreach_entry_safe(entry, &gc_remove.pending, in_queue, next)
+		free(entry);
+	rlist_create(&gc_remove.pending);
+	rlist_create(&gc_remove.removing);
+}
+
+void
+gc_remove_set_rate(double rate)
+{
+	tt_pthread_mutex_lock(&gc_remove.mutex);
+	gc_remove.rate = rate;
+	if (rate > 0 && !gc_remove.is_started && !gc_remove.is_stopped) {
+		if (tt_pthread_create(&gc_remove.thread, NULL,
+				      gc_remove_f, NULL) == 0)
+			gc_remove.is_started = true;
+		else
+			say_error("failed to start file removal thread");
+	}
+	tt_pthread_cond_signal(&gc_remove.cond);
+	tt_pthread_mutex_unlock(&gc_remove.mutex);
+}
+
+bool
+gc_remove_file(const char *path)
+{
+	size_t len = strlen(path) + 1;
+	tt_pthread_mutex_lock(&gc_remove.mutex);
+	bool is_throttled = gc_remove.rate > 0 && gc_remove.is_started &&
+			    !gc_remove.is_stopped;
+	struct gc_remove_entry *entry = NULL;
+	if (is_throttled)
+		entry = malloc(sizeof(*entry) + len);
+	if (entry != NULL) {
+		entry->fd = -1;
+		entry->size = 0;
+		memcpy(entry->path, path, len);
+		rlist_add_tail_entry(&gc_remove.pending, entry, in_queue);
+		gc_remove.stat.files++;
+		tt_pthread_cond_signal(&gc_remove.cond);
+	}
+	tt_pthread_mutex_unlock(&gc_remove.mutex);
+	return entry != NULL;
+}
+
+void
+gc_remove_stat(struct gc_remove_stat *stat)
+{
+	tt_pthread_mutex_lock(&gc_remove.mutex);
+	*stat = gc_remove.stat;
+	tt_pthread_mutex_unlock(&gc_remove.mutex);
+}
@@ -0,0 +1,92 @@
+#ifndef TARANTOOL_BOX_GC_REMOVE_H_INCLUDED
+#define TARANTOOL_BOX_GC_REMOVE_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Throttled removal of garbage files.
+ *
+ * Freeing extents of a big file on unlink may saturate the
+ * disk for a while, stalling WAL writes. With throttling
+ * enabled, a file is unlinked by a background thread, which
+ * keeps it open and truncates it step by step at the given
+ * rate, and only then closes it.
+ */
+
+/** Statistics of throttled file removal. */
+struct gc_remove_stat {
+	/** Number of files being removed. */
+	int64_t files;
+	/** Size of data left to free, in bytes. */
+	int64_t size;
+	/** Size of data freed so far, in bytes. */
+	int64_t removed;
+};
+
+/** Initialize the throttled file removal. */
+void
+gc_remove_init(void);
+
+/**
+ * Stop the background thread. Files that haven't been
+ * freed by then are closed as is.
+ */
+void
+gc_remove_free(void);
+
+/**
+ * Set the rate of freeing disk space, in bytes per second.
+ * Zero disables throttling.
+ */
+void
+gc_remove_set_rate(double rate);
+
+/**
+ * Queue a file for throttled removal. Returns false if
+ * throttling is disabled, in which case the caller is
+ * supposed to remove the file as usual. Thread-safe.
+ */
+bool
+gc_remove_file(const char *path);
+
+/** Get statistics of throttled file removal. */
+void
+gc_remove_stat(struct gc_remove_stat *stat);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_GC_REMOVE_H_INCLUDED */
@@ -36,11 +36,14 @@
 #include "space.h"
 #include "iproto_constants.h"
 #include "txn.h"
+#include "fiber.h"
 #include "rmean.h"
 #include "info.h"
 
 /* {{{ Utilities. **********************************************/
 
+uint32_t op_latency_sample_counter;
+
 UnsupportedIndexFeature::UnsupportedIndexFeature(const char *file,
 	unsigned line, struct index_def *index_def, const char *what)
 	: ClientError(file, line, ER_UNKNOWN)
@@ -200,6 +203,22 @@ box_index_bsize(uint32_t space_id, uint32_t index_id)
 	return index_bsize(index);
 }
 
+/**
+ * Prepare a tuple found in an index to be returned to
+ * the user: unpack it if necessary and bless.
+ */
+static inline int
+index_result_bless(struct tuple **result)
+{
+	if (*result == NULL)
+		return 0;
+	struct tuple *tuple = tuple_unpack(*result);
+	if (tuple == NULL)
+		return -1;
+	*result = tuple_bless(tuple);
+	return 0;
+}
+
 int
 box_index_random(uint32_t space_id, uint32_t index_id, uint32_t rnd,
 		box_tuple_t **result)
@@ -212,9 +231,7 @@ box_index_random(uint32_t space_id, uint32_t index_id, uint32_t rnd,
 	/* No tx management, random() is for approximation anyway. */
 	if (index_random(index, rnd, result) != 0)
 		return -1;
-	if (*result != NULL)
-		tuple_bless(*result);
-	return 0;
+	return index_result_bless(result);
 }
 
 int
@@ -238,6 +255,7 @@ box_index_get(uint32_t space_id, uint32_t index_id, const char *key,
 	struct txn *txn;
 	if (txn_begin_ro_stmt(space, &txn) != 0)
 		return -1;
+	uint64_t start = op_latency_start();
 	if (index_get(index, key, part_count, result) != 0) {
 		txn_rollback_stmt();
 		return -1;
@@ -245,8 +263,65 @@ box_index_get(uint32_t space_id, uint32_t index_id, const char *key,
 	txn_commit_ro_stmt(txn);
 	/* Count statistics. */
 	rmean_collect(rmean_box, IPROTO_SELECT, 1);
-	if (*result != NULL)
-		tuple_bless(*result);
+	space->op_stat.select++;
+	index->op_stat.get++;
+	if (*result != NULL) {
+		index->op_stat.rows++;
+		index->op_stat.bytes += tuple_bsize(*result);
+	}
+	op_latency_collect(&index->op_stat.latency, start);
+	return index_result_bless(result);
+}
+
+int
+box_index_get_batch(uint32_t space_id, uint32_t index_id, const char *keys,
+		    const char *keys_end, box_tuple_t **results)
+{
+	assert(keys != NULL && keys_end != NULL && results != NULL);
+	mp_tuple_assert(keys, keys_end);
+	struct space *space;
+	struct index *index;
+	if (check_index(space_id, index_id, &space, &index) != 0)
+		return -1;
+	if (!index->def->opts.is_unique) {
+		diag_set(ClientError, ER_MORE_THAN_ONE_TUPLE);
+		return -1;
+	}
+	uint32_t key_count = mp_decode_array(&keys);
+	const char *key = keys;
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (mp_typeof(*key) != MP_ARRAY) {
+			diag_set(ClientError, ER_ILLEGAL_PARAMS,
+				 "key must be an array");
+			return -1;
+		}
+		uint32_t part_count = mp_decode_array(&key);
+		if (exact_key_validate(index->def->key_def, key, part_count))
+			return -1;
+		for (uint32_t j = 0; j < part_count; j++)
+			mp_next(&key);
+	}
+	/* Start transaction in the engine. */
+	struct txn *txn;
+	if (txn_begin_ro_stmt(space, &txn) != 0)
+		return -1;
+	uint64_t start = op_latency_start();
+	if (index_get_batch(index, keys, key_count, results) != 0) {
+		txn_rollback_stmt();
+		return -1;
+	}
+	txn_commit_ro_stmt(txn);
+	/* Count statistics. */
+	rmean_collect(rmean_box, IPROTO_SELECT, key_count);
+	space->op_stat.select += key_count;
+	index->op_stat.get += key_count;
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (results[i] == NULL)
+			continue;
+		index->op_stat.rows++;
+		index->op_stat.bytes += tuple_bsize(results[i]);
+	}
+	op_latency_collect(&index->op_stat.latency, start);
 	return 0;
 }
 
@@ -277,9 +352,7 @@ box_index_min(uint32_t space_id, uint32_t index_id, const char *key,
 		return -1;
 	}
 	txn_commit_ro_stmt(txn);
-	if (*result != NULL)
-		tuple_bless(*result);
-	return 0;
+	return index_result_bless(result);
 }
 
 int
@@ -309,9 +382,7 @@ box_index_max(uint32_t space_id, uint32_t index_id, const char *key,
 		return -1;
 	}
 	txn_commit_ro_stmt(txn);
-	if (*result != NULL)
-		tuple_bless(*result);
-	return 0;
+	return index_result_bless(result);
 }
 
 ssize_t
@@ -346,6 +417,70 @@ box_index_count(uint32_t space_id, uint32_t index_id, int type,
 	return count;
 }
 
+ssize_t
+box_index_estimate_count(uint32_t space_id, uint32_t index_id, int type,
+			 const char *key, const char *key_end)
+{
+	assert(key != NULL && key_end != NULL);
+	mp_tuple_assert(key, key_end);
+	if (type < 0 || type >= iterator_type_MAX) {
+		diag_set(ClientError, ER_ILLEGAL_PARAMS,
+			 "Invalid iterator type");
+		return -1;
+	}
+	enum iterator_type itype = (enum iterator_type) type;
+	struct space *space;
+	struct index *index;
+	if (check_index(space_id, index_id, &space, &index) != 0)
+		return -1;
+	uint32_t part_count = mp_decode_array(&key);
+	if (key_validate(index->def, itype, key, part_count))
+		return -1;
+	/* Engines may fall back on counting, which needs a tx. */
+	struct txn *txn;
+	if (txn_begin_ro_stmt(space, &txn) != 0)
+		return -1;
+	ssize_t count = index_estimate_count(index, itype, key, part_count);
+	if (count < 0) {
+		txn_rollback_stmt();
+		return -1;
+	}
+	txn_commit_ro_stmt(txn);
+	return count;
+}
+
+int
+box_index_aggregate(uint32_t space_id, uint32_t index_id, int type,
+		    const char *key, const char *key_end, uint32_t fieldno,
+		    struct index_aggregate *result)
+{
+	assert(key != NULL && key_end != NULL);
+	mp_tuple_assert(key, key_end);
+	if (type < 0 || type >= iterator_type_MAX) {
+		diag_set(ClientError, ER_ILLEGAL_PARAMS,
+			 "Invalid iterator type");
+		return -1;
+	}
+	enum iterator_type itype = (enum iterator_type) type;
+	struct space *space;
+	struct index *index;
+	if (check_index(space_id, index_id, &space, &index) != 0)
+		return -1;
+	uint32_t part_count = mp_decode_array(&key);
+	if (key_validate(index->def, itype, key, part_count))
+		return -1;
+	struct txn *txn;
+	if (txn_begin_ro_stmt(space, &txn) != 0)
+		return -1;
+	if (index_aggregate(index, itype, key, part_count,
+			    fieldno, result) != 0) {
+		txn_rollback_stmt();
+		return -1;
+	}
+	txn_commit_ro_stmt(txn);
+	return 0;
+}
+
 /* }}} */
 
 /* {{{ Iterators ************************************************/
@@ -383,15 +518,52 @@ box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
 	return it;
 }
 
+/**
+ * Yield if the iterator has made enough steps or run for long
+ * enough since the last yield, see box_iterator_set_auto_yield().
+ */
+static void
+iterator_auto_yield(struct iterator *it)
+{
+	if (in_txn() != NULL)
+		return;
+	it->steps_since_yield++;
+	if ((it->yield_steps == 0 ||
+	     it->steps_since_yield < it->yield_steps) &&
+	    (it->yield_timeout == 0 ||
+	     ev_monotonic_time() - it->last_yield_time < it->yield_timeout))
+		return;
+	fiber_sleep(0);
+	it->steps_since_yield = 0;
+	it->last_yield_time = ev_monotonic_time();
+}
+
 int
 box_iterator_next(box_iterator_t *itr, box_tuple_t **result)
 {
 	assert(result != NULL);
+	if (unlikely(itr->yield_steps != 0 || itr->yield_timeout != 0))
+		iterator_auto_yield(itr);
 	if (iterator_next(itr, result) != 0)
 		return -1;
-	if (*result != NULL)
-		tuple_bless(*result);
-	return 0;
+	if (*result != NULL) {
+		/* The index is alive since the iterator is valid. */
+		struct index_op_stat *stat = &itr->index->op_stat;
+		stat->steps++;
+		stat->rows++;
+		stat->bytes += tuple_bsize(*result);
+	}
+	return index_result_bless(result);
+}
+
+void
+box_iterator_set_auto_yield(box_iterator_t *it, uint32_t steps,
+			    double timeout)
+{
+	it->yield_steps = steps;
+	it->yield_timeout = timeout;
+	it->steps_since_yield = 0;
+	it->last_yield_time = ev_monotonic_time();
 }
 
 void
@@ -416,6 +588,18 @@ box_index_stat(uint32_t space_id, uint32_t index_id,
 	return 0;
 }
 
+int
+box_index_reset_stat(uint32_t space_id, uint32_t index_id)
+{
+	struct space *space;
+	struct index *index;
+	if (check_index(space_id, index_id, &space, &index) != 0)
+		return -1;
+	memset(&index->op_stat, 0, sizeof(index->op_stat));
+	index_reset_stat(index);
+	return 0;
+}
+
 int
 box_index_compact(uint32_t space_id, uint32_t index_id)
 {
@@ -427,6 +611,40 @@ box_index_compact(uint32_t space_id, uint32_t index_id)
 	return 0;
 }
 
+int
+box_space_stat(uint32_t space_id, struct info_handler *info)
+{
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return -1;
+	const struct space_op_stat *stat = &space->op_stat;
+	info_begin(info);
+	info_append_int(info, "select", stat->select);
+	info_append_int(info, "insert", stat->insert);
+	info_append_int(info, "replace", stat->replace);
+	info_append_int(info, "update", stat->update);
+	info_append_int(info, "upsert", stat->upsert);
+	info_append_int(info, "delete", stat->del);
+	op_latency_info(&stat->latency, "latency", info);
+	info_end(info);
+	return 0;
+}
+
+int
+box_space_reset_stat(uint32_t space_id)
+{
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return -1;
+	memset(&space->op_stat, 0, sizeof(space->op_stat));
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct index *index = space->index[i];
+		memset(&index->op_stat, 0, sizeof(index->op_stat));
+		index_reset_stat(index);
+	}
+	return 0;
+}
+
 /* }}} */
 
 /* {{{ Internal API */
@@ -435,7 +653,13 @@ void
 iterator_create(struct iterator *it, struct index *index)
 {
 	it->next = NULL;
+	it->skip = NULL;
 	it->free = NULL;
+	it->no_cache_fill = false;
+	it->yield_steps = 0;
+	it->yield_timeout = 0;
+	it->steps_since_yield = 0;
+	it->last_yield_time = 0;
 	it->space_cache_version = space_cache_version;
 	it->space_id = index->def->space_id;
 	it->index_id = index->def->iid;
@@ -466,6 +690,24 @@ invalidate:
 	return 0;
 }
 
+int
+iterator_skip(struct iterator *it, uint32_t count)
+{
+	if (count == 0)
+		return 0;
+	if (it->skip != NULL && (it->space_id == 0 ||
+	    it->space_cache_version == space_cache_version))
+		return it->skip(it, count);
+	struct tuple *tuple;
+	for (uint32_t i = 0; i < count; i++) {
+		if (iterator_next(it, &tuple) != 0)
+			return -1;
+		if (tuple == NULL)
+			break;
+	}
+	return 0;
+}
+
 void
 iterator_delete(struct iterator *it)
 {
@@ -473,6 +715,40 @@ iterator_delete(struct iterator *it)
 	it->free(it);
 }
 
+bool
+iterator_filter_match(const struct iterator_filter *filter,
+		      uint32_t filter_count, struct tuple *tuple)
+{
+	for (uint32_t i = 0; i < filter_count; i++) {
+		int rc = tuple_compare_with_key(tuple, filter[i].value, 1,
+						filter[i].key_def);
+		bool match;
+		switch (filter[i].type) {
+		case ITER_EQ:
+			match = rc == 0;
+			break;
+		case ITER_LT:
+			match = rc < 0;
+			break;
+		case ITER_LE:
+			match = rc <= 0;
+			break;
+		case ITER_GE:
+			match = rc >= 0;
+			break;
+		case ITER_GT:
+			match = rc > 0;
+			break;
+		default:
+			unreachable();
+			match = true;
+		}
+		if (!match)
+			return false;
+	}
+	return true;
+}
+
 int
 index_create(struct index *index, struct engine *engine,
 	     const struct index_vtab *vtab, struct index_def *def)
@@ -485,6 +761,9 @@ index_create(struct index *index, struct engine *engine,
 	index->engine = engine;
 	index->def = def;
 	index->space_cache_version = space_cache_version;
+	index->sampled_tuple_log_est = NULL;
+	index->sampled_size = 0;
+	memset(&index->op_stat, 0, sizeof(index->op_stat));
 	return 0;
 }
 
@@ -497,6 +776,7 @@ index_delete(struct index *index)
 	 * the index is primary or secondary.
 	 */
 	struct index_def *def = index->def;
+	free(index->sampled_tuple_log_est);
 	index->vtab->destroy(index);
 	index_def_delete(def);
 }
@@ -543,6 +823,190 @@ index_build(struct index *index, struct index *pk)
 	return 0;
 }
 
+enum {
+	/** Number of tuples aggregated in one go. */
+	INDEX_AGGREGATE_CHUNK = 256,
+};
+
+/**
+ * Integers not greater than this by absolute value can be
+ * summed up in a chunk without an overflow.
+ */
+static const int64_t INDEX_AGGREGATE_SAFE_INT =
+	INT64_MAX / INDEX_AGGREGATE_CHUNK;
+
+/** Values of a field extracted from a chunk of tuples. */
+struct index_aggregate_chunk {
+	uint32_t int_count;
+	uint32_t double_count;
+	int64_t ints[INDEX_AGGREGATE_CHUNK];
+	double doubles[INDEX_AGGREGATE_CHUNK];
+};
+
+static void
+index_aggregate_add_double(struct index_aggregate *agg, double sum)
+{
+	if (agg->is_int_sum) {
+		agg->sum = agg->int_sum;
+		agg->is_int_sum = false;
+	}
+	agg->sum += sum;
+}
+
+static void
+index_aggregate_add_int(struct index_aggregate *agg, int64_t sum)
+{
+	if (agg->is_int_sum &&
+	    ((sum > 0 && agg->int_sum > INT64_MAX - sum) ||
+	     (sum < 0 && agg->int_sum < INT64_MIN - sum)))
+		index_aggregate_add_double(agg, 0);
+	if (agg->is_int_sum)
+		agg->int_sum += sum;
+	else
+		agg->sum += sum;
+}
+
+static void
+index_aggregate_ints(struct index_aggregate *agg,
+		     const int64_t *v, uint32_t n)
+{
+	if (n == 0)
+		return;
+	int64_t min = v[0], max = v[0];
+	for (uint32_t i = 1; i < n; i++) {
+		min = v[i] < min ? v[i] : min;
+		max = v[i] > max ? v[i] : max;
+	}
+	if (min >= -INDEX_AGGREGATE_SAFE_INT &&
+	    max <= INDEX_AGGREGATE_SAFE_INT) {
+		int64_t sum = 0;
+		for (uint32_t i = 0; i < n; i++)
+			sum += v[i];
+		index_aggregate_add_int(agg, sum);
+	} else {
+		for (uint32_t i = 0; i < n; i++)
+			index_aggregate_add_int(agg, v[i]);
+	}
+	if (agg->int_count == 0 || min < agg->int_min)
+		agg->int_min = min;
+	if (agg->int_count == 0 || max > agg->int_max)
+		agg->int_max = max;
+	agg->int_count += n;
+}
+
+static void
+index_aggregate_doubles(struct index_aggregate *agg,
+			const double *v, uint32_t n)
+{
+	if (n == 0)
+		return;
+	double sum = 0, min = v[0], max = v[0];
+	for (uint32_t i = 0; i < n; i++) {
+		sum += v[i];
+		min = v[i] < min ? v[i] : min;
+		max = v[i] > max ? v[i] : max;
+	}
+	index_aggregate_add_double(agg, sum);
+	if (agg->double_count == 0 || min < agg->double_min)
+		agg->double_min = min;
+	if (agg->double_count == 0 || max > agg->double_max)
+		agg->double_max = max;
+	agg->double_count += n;
+}
+
+/**
+ * Decode a field value into the array of integers or doubles
+ * of a chunk.
+ */
+static int
+index_aggregate_extract(struct index_aggregate_chunk *chunk,
+			const char *field, uint32_t fieldno)
+{
+	if (field == NULL)
+		return 0;
+	switch (mp_typeof(*field)) {
+	case MP_NIL:
+		return 0;
+	case MP_UINT: {
+		uint64_t val = mp_decode_uint(&field);
+		if (val > INT64_MAX)
+			chunk->doubles[chunk->double_count++] = val;
+		else
+			chunk->ints[chunk->int_count++] = val;
+		return 0;
+	}
+	case MP_INT:
+		chunk->ints[chunk->int_count++] = mp_decode_int(&field);
+		return 0;
+	case MP_FLOAT:
+		chunk->doubles[chunk->double_count++] =
+			mp_decode_float(&field);
+		return 0;
+	case MP_DOUBLE:
+		chunk->doubles[chunk->double_count++] =
+			mp_decode_double(&field);
+		return 0;
+	default:
+		diag_set(ClientError, ER_FIELD_TYPE,
+			 int2str(fieldno + TUPLE_INDEX_BASE),
+			 field_type_strs[FIELD_TYPE_NUMBER]);
+		return -1;
+	}
+}
+
+int
+index_aggregate(struct index *index, enum iterator_type type,
+		const char *key, uint32_t part_count, uint32_t fieldno,
+		struct index_aggregate *result)
+{
+	memset(result, 0, sizeof(*result));
+	result->is_int_sum = true;
+	struct iterator *it = index_create_iterator(index, type,
+						    key, part_count);
+	if (it == NULL)
+		return -1;
+	struct index_aggregate_chunk chunk_buf;
+	struct index_aggregate_chunk *chunk = &chunk_buf;
+	int rc = 0;
+	bool eof = false;
+	while (!eof) {
+		chunk->int_count = 0;
+		chunk->double_count = 0;
+		for (int i = 0; i < INDEX_AGGREGATE_CHUNK; i++) {
+			struct tuple *tuple;
+			rc = iterator_next(it, &tuple);
+			if (rc != 0 || tuple == NULL) {
+				eof = true;
+				break;
+			}
+			tuple = tuple_unpack(tuple);
+			if (tuple == NULL) {
+				rc = -1;
+				eof = true;
+				break;
+			}
+			/*
+			 * The tuple may be freed by the next call to
+			 * iterator_next() so extract the value now.
+			 */
+			rc = index_aggregate_extract(chunk,
+					tuple_field(tuple, fieldno), fieldno);
+			if (rc != 0) {
+				eof = true;
+				break;
+			}
+		}
+		if (rc != 0)
+			break;
+		index_aggregate_ints(result, chunk->ints, chunk->int_count);
+		index_aggregate_doubles(result, chunk->doubles,
+					chunk->double_count);
+	}
+	iterator_delete(it);
+	result->count = result->int_count + result->double_count;
+	return rc;
+}
+
 /* }}} */
 
 /* {{{ Virtual method stubs */
@@ -651,6 +1115,13 @@ generic_index_count(struct index *index, enum iterator_type type,
 	return count;
 }
 
+ssize_t
+generic_index_estimate_count(struct index *index, enum iterator_type type,
+			     const char *key, uint32_t part_count)
+{
+	return index_count(index, type, key, part_count);
+}
+
 int
 generic_index_get(struct index *index, const char *key,
 		  uint32_t part_count, struct tuple **result)
@@ -662,6 +1133,27 @@ generic_index_get(struct index *index, const char *key,
 	return -1;
 }
 
+int
+generic_index_get_batch(struct index *index, const char *keys,
+			uint32_t key_count, struct tuple **results)
+{
+	for (uint32_t i = 0; i < key_count; i++) {
+		uint32_t part_count = mp_decode_array(&keys);
+		if (index_get(index, keys, part_count, &results[i]) != 0) {
+			for (uint32_t j = 0; j < i; j++) {
+				if (results[j] != NULL)
+					tuple_unref(results[j]);
+			}
+			return -1;
+		}
+		if (results[i] != NULL)
+			tuple_ref(results[i]);
+		for (uint32_t j = 0; j < part_count; j++)
+			mp_next(&keys);
+	}
+	return 0;
+}
+
 int
 generic_index_replace(struct index *index, struct tuple *old_tuple,
 		      struct tuple *new_tuple, enum dup_replace_mode mode,
@@ -675,6 +1167,84 @@ generic_index_replace(struct index *index, struct tuple *old_tuple,
 	return -1;
 }
 
+int
+generic_index_replace_in_place(struct index *index, struct tuple *old_tuple,
+			       struct tuple *new_tuple)
+{
+	struct tuple *unused;
+	return index_replace(index, old_tuple, new_tuple, DUP_INSERT, &unused);
+}
+
+struct iterator *
+generic_index_create_covering_iterator(struct index *index,
+				       enum iterator_type type,
+				       const char *key, uint32_t part_count,
+				       uint64_t field_mask)
+{
+	(void)field_mask;
+	return index_create_iterator(index, type, key, part_count);
+}
+
+/** Iterator skipping tuples of another one that fail filters. */
+struct filtered_iterator {
+	struct iterator base;
+	/** Iterator tuples are read from. */
+	struct iterator *it;
+	const struct iterator_filter *filter;
+	uint32_t filter_count;
+};
+
+static int
+filtered_iterator_next(struct iterator *base, struct tuple **ret)
+{
+	struct filtered_iterator *it = (struct filtered_iterator *)base;
+	do {
+		if (it->it->next(it->it, ret) != 0)
+			return -1;
+		/* Filters may refer to fields that aren't indexed. */
+		if (*ret != NULL && (*ret = tuple_unpack(*ret)) == NULL)
+			return -1;
+	} while (*ret != NULL &&
+		 !iterator_filter_match(it->filter, it->filter_count, *ret));
+	return 0;
+}
+
+static void
+filtered_iterator_free(struct iterator *base)
+{
+	struct filtered_iterator *it = (struct filtered_iterator *)base;
+	iterator_delete(it->it);
+	free(it);
+}
+
+struct iterator *
+generic_index_create_filtered_iterator(struct index *index,
+				       enum iterator_type type,
+				       const char *key, uint32_t part_count,
+				       const struct iterator_filter *filter,
+				       uint32_t filter_count)
+{
+	struct iterator *base = index_create_iterator(index, type, key,
+						      part_count);
+	if (base == NULL || filter_count == 0)
+		return base;
+	struct filtered_iterator *it =
+		(struct filtered_iterator *) malloc(sizeof(*it));
+	if (it == NULL) {
+		iterator_delete(base);
+		diag_set(OutOfMemory, sizeof(*it), "malloc",
+			 "struct filtered_iterator");
+		return NULL;
+	}
+	iterator_create(&it->base, index);
+	it->base.next = filtered_iterator_next;
+	it->base.free = filtered_iterator_free;
+	it->it = base;
+	it->filter = filter;
+	it->filter_count = filter_count;
+	return &it->base;
+}
+
 struct snapshot_iterator *
 generic_index_create_snapshot_iterator(struct index *index)
 {
@@ -682,11 +1252,31 @@ generic_index_create_snapshot_iterator(struct index *index)
 	return NULL;
 }
 
+void
+op_latency_info(const struct op_latency *latency, const char *key,
+		struct info_handler *handler)
+{
+	info_table_begin(handler, key);
+	info_append_int(handler, "samples", latency->count);
+	info_append_double(handler, "avg", latency->count == 0 ? 0 :
+			   (double)latency->sum / latency->count / 1e9);
+	info_append_double(handler, "max", latency->max / 1e9);
+	info_table_end(handler);
+}
+
 void
 generic_index_stat(struct index *index, struct info_handler *handler)
 {
-	(void)index;
+	const struct index_op_stat *stat = &index->op_stat;
 	info_begin(handler);
+	info_append_int(handler, "select", stat->select);
+	info_append_int(handler, "get", stat->get);
+	info_append_int(handler, "replace", stat->replace);
+	info_append_int(handler, "delete", stat->del);
+	info_append_int(handler, "steps", stat->steps);
+	info_append_int(handler, "rows", stat->rows);
+	info_append_int(handler, "bytes", stat->bytes);
+	op_latency_info(&stat->latency, "latency", handler);
 	info_end(handler);
 }
 
@@ -699,6 +1289,7 @@ generic_index_compact(struct index *index)
 void
 generic_index_reset_stat(struct index *index)
 {
+	/* Request counters are reset by box_index_reset_stat(). */
 	(void)index;
 }
 
@@ -32,6 +32,7 @@
  */
 #include <stdbool.h>
 #include "trivia/util.h"
+#include "clock.h"
 #include "iterator_type.h"
 #include "index_def.h"
 
@@ -81,6 +82,26 @@ box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
 int
 box_iterator_next(box_iterator_t *iterator, box_tuple_t **result);
 
+/**
+ * Make the \a iterator yield before retrieving the next item
+ * once it has made \a steps steps or run for \a timeout seconds
+ * since the last yield, whichever comes first. Zero disables
+ * the corresponding condition. The iterator never yields
+ * within a transaction.
+ *
+ * A TREE index iterator restores its position by the last
+ * returned tuple after concurrent changes, so it neither skips
+ * nor repeats tuples. Other indexes give the same guarantees
+ * as with an explicit yield between steps.
+ *
+ * \param iterator an iterator returned by box_index_iterator().
+ * \param steps max number of steps between yields.
+ * \param timeout max time between yields, in seconds.
+ */
+void
+box_iterator_set_auto_yield(box_iterator_t *iterator, uint32_t steps,
+			    double timeout);
+
 /**
  * Destroy and deallocate iterator.
  *
@@ -146,6 +167,29 @@ int
 box_index_get(uint32_t space_id, uint32_t index_id, const char *key,
 	      const char *key_end, box_tuple_t **result);
 
+/**
+ * Get tuples from a unique index by an array of keys. Unlike
+ * calling box_index_get() for each key, lets the engine look
+ * the keys up concurrently, e.g. vinyl reads the pages needed
+ * by all keys from disk at once.
+ *
+ * \param space_id space identifier
+ * \param index_id index identifier
+ * \param keys encoded array of keys ([key1, key2, ...]), each
+ * key is a MsgPack Array ([part1, part2, ...])
+ * \param keys_end the end of encoded \a keys
+ * \param[out] results array with room for a tuple per key, set
+ * to the found tuples, NULL for keys that aren't found. The
+ * tuples are referenced and must be released with
+ * box_tuple_unref().
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ * \sa \code box.space[space_id].index[index_id]:get_many(keys) \endcode
+ */
+int
+box_index_get_batch(uint32_t space_id, uint32_t index_id, const char *keys,
+		    const char *keys_end, box_tuple_t **results);
+
 /**
  * Return a first (minimal) tuple matched the provided key.
  *
@@ -224,6 +268,17 @@ int
 box_index_stat(uint32_t space_id, uint32_t index_id,
 	       struct info_handler *info);
 
+/**
+ * Reset index statistics (index:stat_reset())
+ *
+ * \param space_id space identifier
+ * \param index_id index identifier
+ * \retval -1 on error (check box_error_last())
+ * \retval >=0 on success
+ */
+int
+box_index_reset_stat(uint32_t space_id, uint32_t index_id);
+
 /**
  * Trigger index compaction (index:compact())
  *
@@ -235,6 +290,84 @@ box_index_stat(uint32_t space_id, uint32_t index_id,
 int
 box_index_compact(uint32_t space_id, uint32_t index_id);
 
+/**
+ * Space request statistics (space:stat())
+ *
+ * \param space_id space identifier
+ * \param info info handler
+ * \retval -1 on error (check box_error_last())
+ * \retval >=0 on success
+ */
+int
+box_space_stat(uint32_t space_id, struct info_handler *info);
+
+/**
+ * Reset request statistics of a space and all its indexes
+ * (space:stat_reset())
+ *
+ * \param space_id space identifier
+ * \retval -1 on error (check box_error_last())
+ * \retval >=0 on success
+ */
+int
+box_space_reset_stat(uint32_t space_id);
+
+/**
+ * Result of a numeric aggregate over a tuple field,
+ * see index_aggregate().
+ */
+struct index_aggregate {
+	/** Number of tuples that have the field set. */
+	uint64_t count;
+	/**
+	 * Set if all values seen so far are integers and
+	 * their sum fits in int64_t. Then the sum is stored
+	 * in @int_sum, otherwise in @sum.
+	 */
+	bool is_int_sum;
+	int64_t int_sum;
+	double sum;
+	/** Min and max of the integer values, if any. */
+	uint64_t int_count;
+	int64_t int_min;
+	int64_t int_max;
+	/** Min and max of the floating point values, if any. */
+	uint64_t double_count;
+	double double_min;
+	double double_max;
+};
+
+/**
+ * Compute COUNT, SUM, MIN and MAX over a numeric tuple field
+ * of the tuples matched by the given key (index:aggregate()).
+ *
+ * \param space_id space identifier
+ * \param index_id index identifier
+ * \param type iterator type - enum \link iterator_type \endlink
+ * \param key encoded key in MsgPack Array format ([part1, part2, ...]).
+ * \param key_end the end of encoded \a key.
+ * \param fieldno zero-based number of the aggregated field
+ * \param[out] result aggregate
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ */
+int
+box_index_aggregate(uint32_t space_id, uint32_t index_id, int type,
+		    const char *key, const char *key_end, uint32_t fieldno,
+		    struct index_aggregate *result);
+
+/**
+ * Estimate the number of tuples matched by the given key
+ * without reading them (index:count(key, {approximate = true})).
+ * Arguments are the same as for box_index_count().
+ *
+ * \retval -1 on error (check box_error_last())
+ * \retval >=0 on success
+ */
+ssize_t
+box_index_estimate_count(uint32_t space_id, uint32_t index_id, int type,
+			 const char *key, const char *key_end);
+
 struct iterator {
 	/**
 	 * Iterate to the next tuple.
@@ -242,8 +375,34 @@ struct iterator {
 	 * Returns 0 on success, -1 on error.
 	 */
 	int (*next)(struct iterator *it, struct tuple **ret);
+	/**
+	 * Skip @count tuples without returning them. Optional,
+	 * set by indexes that can position the iterator faster
+	 * than by calling next() @count times. Called only
+	 * before the first call of next().
+	 * Returns 0 on success, -1 on error.
+	 */
+	int (*skip)(struct iterator *it, uint32_t count);
 	/** Destroy the iterator. */
 	void (*free)(struct iterator *);
+	/**
+	 * Set if tuples read by the iterator should not be added
+	 * to the engine cache, e.g. for a full scan that would
+	 * otherwise evict frequently read tuples. Engines that
+	 * have no cache ignore it.
+	 */
+	bool no_cache_fill;
+	/**
+	 * Max number of steps and max time, in seconds, between
+	 * automatic yields made by box_iterator_next(), 0 if off.
+	 * See box_iterator_set_auto_yield().
+	 */
+	uint32_t yield_steps;
+	double yield_timeout;
+	/** Number of steps made since the last automatic yield. */
+	uint32_t steps_since_yield;
+	/** Time of the last automatic yield. */
+	double last_yield_time;
 	/** Space cache version at the time of the last index lookup. */
 	uint32_t space_cache_version;
 	/** ID of the space the iterator is for. */
@@ -277,12 +436,42 @@ iterator_create(struct iterator *it, struct index *index);
 int
 iterator_next(struct iterator *it, struct tuple **ret);
 
+/**
+ * Skip @count tuples. Must be called before the first
+ * iterator_next(). Uses iterator->skip if the index sets
+ * it and falls back on calling iterator_next() otherwise.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+iterator_skip(struct iterator *it, uint32_t count);
+
 /**
  * Destroy an iterator instance and free associated memory.
  */
 void
 iterator_delete(struct iterator *it);
 
+/**
+ * A condition on a tuple field checked by a filtered iterator.
+ * A tuple passes the filter if its field compared with @value
+ * satisfies @type, as if @value were a key of @type iterator
+ * over a single part index defined by @key_def.
+ */
+struct iterator_filter {
+	/** Definition of the checked field. */
+	struct key_def *key_def;
+	/** MsgPack value the field is compared with. */
+	const char *value;
+	/** ITER_EQ, ITER_LT, ITER_LE, ITER_GE or ITER_GT. */
+	enum iterator_type type;
+};
+
+/** Check if a tuple passes all the given filters. */
+bool
+iterator_filter_match(const struct iterator_filter *filter,
+		      uint32_t filter_count, struct tuple *tuple);
+
 /**
  * Snapshot iterator.
  * \sa index::create_snapshot_iterator().
@@ -409,15 +598,62 @@ struct index_vtab {
 	int (*random)(struct index *index, uint32_t rnd, struct tuple **result);
 	ssize_t (*count)(struct index *index, enum iterator_type type,
 			 const char *key, uint32_t part_count);
+	/**
+	 * Estimate the number of tuples matching a key without
+	 * reading them. Engines that can count exactly at a low
+	 * cost use generic_index_estimate_count(), which returns
+	 * the exact count.
+	 */
+	ssize_t (*estimate_count)(struct index *index,
+				  enum iterator_type type,
+				  const char *key, uint32_t part_count);
 	int (*get)(struct index *index, const char *key,
 		   uint32_t part_count, struct tuple **result);
+	/**
+	 * Look up @a key_count full keys stored one after another
+	 * at @a keys. Lets an engine fetch the tuples concurrently.
+	 * The tuples are returned referenced in @a results, NULL
+	 * for keys that aren't found.
+	 */
+	int (*get_batch)(struct index *index, const char *keys,
+			 uint32_t key_count, struct tuple **results);
 	int (*replace)(struct index *index, struct tuple *old_tuple,
 		       struct tuple *new_tuple, enum dup_replace_mode mode,
 		       struct tuple **result);
+	/**
+	 * Replace @a old_tuple with @a new_tuple that has the
+	 * same key in this index, e.g. because an UPDATE didn't
+	 * touch any of the key fields. Lets an index swap the
+	 * tuple pointer instead of deleting the old tuple and
+	 * inserting the new one.
+	 */
+	int (*replace_in_place)(struct index *index, struct tuple *old_tuple,
+				struct tuple *new_tuple);
 	/** Create an index iterator. */
 	struct iterator *(*create_iterator)(struct index *index,
 			enum iterator_type type,
 			const char *key, uint32_t part_count);
+	/**
+	 * Create an index iterator that only has to return
+	 * the fields set in @field_mask: other fields of the
+	 * returned tuples may be missing or nil. Lets an index
+	 * that stores these fields skip fetching full tuples,
+	 * see index_opts::covered_fields.
+	 */
+	struct iterator *(*create_covering_iterator)(struct index *index,
+			enum iterator_type type, const char *key,
+			uint32_t part_count, uint64_t field_mask);
+	/**
+	 * Create an index iterator that skips tuples which
+	 * don't pass @filter. Lets an engine check filters
+	 * before a tuple is fully fetched. The filters must
+	 * stay valid until the iterator is deleted.
+	 */
+	struct iterator *(*create_filtered_iterator)(struct index *index,
+			enum iterator_type type, const char *key,
+			uint32_t part_count,
+			const struct iterator_filter *filter,
+			uint32_t filter_count);
 	/**
 	 * Create an ALL iterator with personal read view so further
 	 * index modifications will not affect the iteration results.
@@ -447,6 +683,79 @@ struct index_vtab {
 	void (*end_build)(struct index *index);
 };
 
+enum {
+	/**
+	 * Request latency is measured for one request out of
+	 * this many, to keep the clock off the hot path.
+	 */
+	OP_LATENCY_SAMPLE_RATE = 16,
+};
+
+/** Sampled request latency, in nanoseconds. */
+struct op_latency {
+	/** Sum of sampled latencies. */
+	uint64_t sum;
+	/** Number of samples. */
+	uint64_t count;
+	/** Max sampled latency. */
+	uint64_t max;
+};
+
+extern uint32_t op_latency_sample_counter;
+
+/** Append sampled latency as a table named @a key. */
+void
+op_latency_info(const struct op_latency *latency, const char *key,
+		struct info_handler *handler);
+
+/**
+ * Start measuring a request if it is sampled.
+ * Returns the start time or 0 if the request isn't sampled.
+ */
+static inline uint64_t
+op_latency_start(void)
+{
+	if ((++op_latency_sample_counter % OP_LATENCY_SAMPLE_RATE) != 0)
+		return 0;
+	return clock_monotonic64();
+}
+
+/** Account a request started with op_latency_start(). */
+static inline void
+op_latency_collect(struct op_latency *latency, uint64_t start)
+{
+	if (start == 0)
+		return;
+	uint64_t value = clock_monotonic64() - start;
+	latency->sum += value;
+	latency->count++;
+	if (value > latency->max)
+		latency->max = value;
+}
+
+/**
+ * Request counters of an index, maintained by the generic
+ * request dispatch in box regardless of the engine.
+ */
+struct index_op_stat {
+	/** Number of select requests. */
+	uint64_t select;
+	/** Number of keys looked up with get. */
+	uint64_t get;
+	/** Number of tuples inserted or replaced in the index. */
+	uint64_t replace;
+	/** Number of tuples deleted from the index. */
+	uint64_t del;
+	/** Number of tuples visited by iterators. */
+	uint64_t steps;
+	/** Number of tuples returned. */
+	uint64_t rows;
+	/** Total size of the tuples returned, in bytes. */
+	uint64_t bytes;
+	/** Sampled latency of select and get. */
+	struct op_latency latency;
+};
+
 struct index {
 	/** Virtual function table. */
 	const struct index_vtab *vtab;
@@ -456,6 +765,17 @@ struct index {
 	struct index_def *def;
 	/* Space cache version at the time of construction. */
 	uint32_t space_cache_version;
+	/**
+	 * Logarithms of the average number of tuples per key
+	 * prefix, sampled by the SQL planner for an index
+	 * without statistics collected by ANALYZE. NULL if not
+	 * sampled yet. See index_field_tuple_est().
+	 */
+	log_est_t *sampled_tuple_log_est;
+	/** Index size at the moment of sampling. */
+	ssize_t sampled_size;
+	/** Request counters, see index:stat(). */
+	struct index_op_stat op_stat;
 };
 
 /**
@@ -588,6 +908,13 @@ index_count(struct index *index, enum iterator_type type,
 	return index->vtab->count(index, type, key, part_count);
 }
 
+static inline ssize_t
+index_estimate_count(struct index *index, enum iterator_type type,
+		     const char *key, uint32_t part_count)
+{
+	return index->vtab->estimate_count(index, type, key, part_count);
+}
+
 static inline int
 index_get(struct index *index, const char *key,
 	   uint32_t part_count, struct tuple **result)
@@ -595,14 +922,32 @@ index_get(struct index *index, const char *key,
 	return index->vtab->get(index, key, part_count, result);
 }
 
+static inline int
+index_get_batch(struct index *index, const char *keys,
+		uint32_t key_count, struct tuple **results)
+{
+	return index->vtab->get_batch(index, keys, key_count, results);
+}
+
 static inline int
 index_replace(struct index *index, struct tuple *old_tuple,
 	      struct tuple *new_tuple, enum dup_replace_mode mode,
 	      struct tuple **result)
 {
+	if (new_tuple != NULL)
+		index->op_stat.replace++;
+	else if (old_tuple != NULL)
+		index->op_stat.del++;
 	return index->vtab->replace(index, old_tuple, new_tuple, mode, result);
 }
 
+static inline int
+index_replace_in_place(struct index *index, struct tuple *old_tuple,
+		       struct tuple *new_tuple)
+{
+	return index->vtab->replace_in_place(index, old_tuple, new_tuple);
+}
+
 static inline struct iterator *
 index_create_iterator(struct index *index, enum iterator_type type,
 		      const char *key, uint32_t part_count)
@@ -610,6 +955,26 @@ index_create_iterator(struct index *index, enum iterator_type type,
 	return index->vtab->create_iterator(index, type, key, part_count);
 }
 
+static inline struct iterator *
+index_create_covering_iterator(struct index *index, enum iterator_type type,
+			       const char *key, uint32_t part_count,
+			       uint64_t field_mask)
+{
+	return index->vtab->create_covering_iterator(index, type, key,
+						     part_count, field_mask);
+}
+
+static inline struct iterator *
+index_create_filtered_iterator(struct index *index, enum iterator_type type,
+			       const char *key, uint32_t part_count,
+			       const struct iterator_filter *filter,
+			       uint32_t filter_count)
+{
+	return index->vtab->create_filtered_iterator(index, type, key,
+						     part_count, filter,
+						     filter_count);
+}
+
 static inline struct snapshot_iterator *
 index_create_snapshot_iterator(struct index *index)
 {
@@ -658,6 +1023,19 @@ index_end_build(struct index *index)
 	index->vtab->end_build(index);
 }
 
+/**
+ * Aggregate a numeric field over the tuples returned by
+ * an iterator of the given type. Tuples are processed in
+ * chunks: field values of a chunk are first extracted into
+ * arrays, which are then folded by tight loops the compiler
+ * can vectorize. Tuples with the field missing or nil are
+ * skipped, a non-numeric value is an error.
+ */
+int
+index_aggregate(struct index *index, enum iterator_type type,
+		const char *key, uint32_t part_count, uint32_t fieldno,
+		struct index_aggregate *result);
+
 /*
  * Virtual method stubs.
  */
@@ -676,9 +1054,23 @@ int generic_index_max(struct index *, const char *, uint32_t, struct tuple **);
 int generic_index_random(struct index *, uint32_t, struct tuple **);
 ssize_t generic_index_count(struct index *, enum iterator_type,
 			    const char *, uint32_t);
+ssize_t generic_index_estimate_count(struct index *, enum iterator_type,
+				     const char *, uint32_t);
 int generic_index_get(struct index *, const char *, uint32_t, struct tuple **);
+int generic_index_get_batch(struct index *, const char *, uint32_t,
+			    struct tuple **);
 int generic_index_replace(struct index *, struct tuple *, struct tuple *,
 			  enum dup_replace_mode, struct tuple **);
+int generic_index_replace_in_place(struct index *, struct tuple *,
+				   struct tuple *);
+struct iterator *
+generic_index_create_covering_iterator(struct index *, enum iterator_type,
+				       const char *, uint32_t, uint64_t);
+struct iterator *
+generic_index_create_filtered_iterator(struct index *, enum iterator_type,
+				       const char *, uint32_t,
+				       const struct iterator_filter *,
+				       uint32_t);
 struct snapshot_iterator *generic_index_create_snapshot_iterator(struct index *);
 void generic_index_stat(struct index *, struct info_handler *);
 void generic_index_compact(struct index *);
@@ -33,11 +33,63 @@
 #include "identifier.h"
 #include "tuple_format.h"
 #include "json/json.h"
+#include "column_mask.h"
+#include "diag.h"
+#include "error.h"
+#include "msgpuck.h"
+#include "bit/bit.h"
 
 const char *index_type_strs[] = { "HASH", "TREE", "BITSET", "RTREE" };
 
 const char *rtree_index_distance_type_strs[] = { "EUCLID", "MANHATTAN" };
 
+const char *index_compaction_strategy_strs[] = { "leveled", "tiered" };
+const char *index_hash_func_strs[] = { "murmur", "wyhash" };
+
+/**
+ * Decode an array of zero-based field numbers into a column
+ * mask. @a name is the option name used in the error message.
+ */
+static int
+index_opts_field_mask_decode(const char **str, uint32_t len, char *opt,
+			     uint32_t errcode, uint32_t field_no,
+			     const char *name)
+{
+	uint64_t mask = 0;
+	for (uint32_t i = 0; i < len; i++) {
+		if (mp_typeof(**str) != MP_UINT)
+			goto error;
+		uint64_t fieldno = mp_decode_uint(str);
+		if (fieldno >= 63)
+			goto error;
+		column_mask_set_fieldno(&mask, fieldno);
+	}
+	store_u64(opt, mask);
+	return 0;
+error:
+	diag_set(ClientError, errcode, field_no, tt_sprintf("%s must be "
+		 "an array of field numbers less than 63", name));
+	return -1;
+}
+
+/** Decoder of index_opts::covered_fields. */
+static int
+index_opts_covered_fields_decode(const char **str, uint32_t len, char *opt,
+				 uint32_t errcode, uint32_t field_no)
+{
+	return index_opts_field_mask_decode(str, len, opt, errcode, field_no,
+					    "covered_fields");
+}
+
+/** Decoder of index_opts::zone_map_fields. */
+static int
+index_opts_zone_map_fields_decode(const char **str, uint32_t len, char *opt,
+				  uint32_t errcode, uint32_t field_no)
+{
+	return index_opts_field_mask_decode(str, len, opt, errcode, field_no,
+					    "zone_map_fields");
+}
+
 const struct index_opts index_opts_default = {
 	/* .unique              = */ true,
 	/* .dimension           = */ 2,
@@ -46,7 +98,20 @@ const struct index_opts index_opts_default = {
 	/* .page_size           = */ 8192,
 	/* .run_count_per_level = */ 2,
 	/* .run_size_ratio      = */ 3.5,
+	/* .compaction_strategy = */ INDEX_COMPACTION_STRATEGY_LEVELED,
 	/* .bloom_fpr           = */ 0.05,
+	/* .covered_fields      = */ 0,
+	/* .blob_threshold      = */ 0,
+	/* .page_restart_interval = */ 0,
+	/* .columnar            = */ false,
+	/* .zone_map_fields     = */ 0,
+	/* .compression_dict_size = */ 0,
+	/* .is_sparse           = */ false,
+	/* .size_hint           = */ 0,
+	/* .expire              = */ false,
+	/* .func_id             = */ 0,
+	/* .store_key           = */ false,
+	/* .hash_func           = */ INDEX_HASH_FUNC_MURMUR,
 	/* .lsn                 = */ 0,
 	/* .stat                = */ NULL,
 };
@@ -60,7 +125,26 @@ const struct opt_def index_opts_reg[] = {
 	OPT_DEF("page_size", OPT_INT64, struct index_opts, page_size),
 	OPT_DEF("run_count_per_level", OPT_INT64, struct index_opts, run_count_per_level),
 	OPT_DEF("run_size_ratio", OPT_FLOAT, struct index_opts, run_size_ratio),
+	OPT_DEF_ENUM("compaction_strategy", index_compaction_strategy,
+		     struct index_opts, compaction_strategy, NULL),
 	OPT_DEF("bloom_fpr", OPT_FLOAT, struct index_opts, bloom_fpr),
+	OPT_DEF_ARRAY("covered_fields", struct index_opts, covered_fields,
+		      index_opts_covered_fields_decode),
+	OPT_DEF("blob_threshold", OPT_INT64, struct index_opts, blob_threshold),
+	OPT_DEF("page_restart_interval", OPT_INT64, struct index_opts,
+		page_restart_interval),
+	OPT_DEF("columnar", OPT_BOOL, struct index_opts, columnar),
+	OPT_DEF_ARRAY("zone_map_fields", struct index_opts, zone_map_fields,
+		      index_opts_zone_map_fields_decode),
+	OPT_DEF("compression_dict_size", OPT_INT64, struct index_opts,
+		compression_dict_size),
+	OPT_DEF("sparse", OPT_BOOL, struct index_opts, is_sparse),
+	OPT_DEF("size_hint", OPT_INT64, struct index_opts, size_hint),
+	OPT_DEF("expire", OPT_BOOL, struct index_opts, expire),
+	OPT_DEF("func", OPT_UINT32, struct index_opts, func_id),
+	OPT_DEF("store_key", OPT_BOOL, struct index_opts, store_key),
+	OPT_DEF_ENUM("hash_func", index_hash_func, struct index_opts,
+		     hash_func, NULL),
 	OPT_DEF("lsn", OPT_INT64, struct index_opts, lsn),
 	OPT_END,
 };
@@ -89,8 +173,16 @@ index_def_new(uint32_t space_id, uint32_t iid, const char *name,
 		return NULL;
 	}
 	def->key_def = key_def_dup(key_def);
+	if (def->key_def == NULL) {
+		index_def_delete(def);
+		return NULL;
+	}
+	if (opts->func_id != 0)
+		key_def_set_func_index(def->key_def);
+	else if (opts->store_key)
+		key_def_set_stored_key(def->key_def);
 	if (iid != 0) {
-		def->cmp_def = key_def_merge(key_def, pk_def);
+		def->cmp_def = key_def_merge(def->key_def, pk_def);
 		if (! opts->is_unique) {
 			def->cmp_def->unique_part_count =
 				def->cmp_def->part_count;
@@ -99,12 +191,16 @@ index_def_new(uint32_t space_id, uint32_t iid, const char *name,
 				def->key_def->part_count;
 		}
 	} else {
-		def->cmp_def = key_def_dup(key_def);
+		def->cmp_def = key_def_dup(def->key_def);
 	}
-	if (def->key_def == NULL || def->cmp_def == NULL) {
+	if (def->cmp_def == NULL) {
 		index_def_delete(def);
 		return NULL;
 	}
+	if (opts->hash_func == INDEX_HASH_FUNC_WYHASH) {
+		key_def_set_wyhash(def->key_def);
+		key_def_set_wyhash(def->cmp_def);
+	}
 	def->type = type;
 	def->space_id = space_id;
 	def->iid = iid;
@@ -258,6 +354,36 @@ index_def_is_valid(struct index_def *index_def, const char *space_name)
 			 space_name, "primary key must be unique");
 		return false;
 	}
+	if (index_def->iid == 0 && index_def->key_def->is_multikey) {
+		diag_set(ClientError, ER_MODIFY_INDEX, index_def->name,
+			 space_name, "primary key cannot be multikey");
+		return false;
+	}
+	if (index_def->opts.func_id != 0) {
+		const char *err = NULL;
+		if (index_def->iid == 0)
+			err = "primary key cannot be functional";
+		else if (index_def->key_def->is_multikey)
+			err = "functional index cannot be multikey";
+		else if (index_def->opts.expire)
+			err = "functional index cannot expire tuples";
+		if (err != NULL) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name, err);
+			return false;
+		}
+	}
+	if (index_def->opts.hash_func != INDEX_HASH_FUNC_MURMUR &&
+	    index_def->type != HASH) {
+		diag_set(ClientError, ER_MODIFY_INDEX, index_def->name,
+			 space_name, "hash_func can only be set for HASH index");
+		return false;
+	}
+	if (index_def->opts.store_key && index_def->key_def->is_multikey) {
+		diag_set(ClientError, ER_MODIFY_INDEX, index_def->name,
+			 space_name, "multikey index cannot store keys");
+		return false;
+	}
 	if (index_def->key_def->part_count == 0) {
 		diag_set(ClientError, ER_MODIFY_INDEX, index_def->name,
 			 space_name, "part count must be positive");
@@ -293,5 +419,22 @@ index_def_is_valid(struct index_def *index_def, const char *space_name)
 			}
 		}
 	}
+	if (index_def->opts.expire) {
+		struct key_part *part = &index_def->key_def->parts[0];
+		if (index_def->type != TREE) {
+			diag_set(ClientError, ER_MODIFY_INDEX, index_def->name,
+				 space_name, "only TREE index can expire tuples");
+			return false;
+		}
+		if ((part->type != FIELD_TYPE_UNSIGNED &&
+		     part->type != FIELD_TYPE_INTEGER &&
+		     part->type != FIELD_TYPE_NUMBER) ||
+		    key_part_is_nullable(part)) {
+			diag_set(ClientError, ER_MODIFY_INDEX, index_def->name,
+				 space_name, "expiration time must be "
+				 "a non-nullable number");
+			return false;
+		}
+	}
 	return true;
 }
@@ -58,6 +58,33 @@ enum rtree_index_distance_type {
 };
 extern const char *rtree_index_distance_type_strs[];
 
+/** Vinyl compaction strategy, @sa vy_range.c. */
+enum index_compaction_strategy {
+	/**
+	 * Keep levels of the LSM tree run_size_ratio times
+	 * apart and store at most one run at the last level.
+	 * Favors low space and read amplification.
+	 */
+	INDEX_COMPACTION_STRATEGY_LEVELED,
+	/**
+	 * Merge runs of similar size together and leave the
+	 * biggest runs alone. Favors low write amplification.
+	 */
+	INDEX_COMPACTION_STRATEGY_TIERED,
+	index_compaction_strategy_MAX
+};
+extern const char *index_compaction_strategy_strs[];
+
+/** Hash function of a HASH index. */
+enum index_hash_func {
+	/** MurmurHash3, used by all other hashes as well. */
+	INDEX_HASH_FUNC_MURMUR,
+	/** wyhash, much faster on long strings. */
+	INDEX_HASH_FUNC_WYHASH,
+	index_hash_func_MAX
+};
+extern const char *index_hash_func_strs[];
+
 /** Simple alias to represent logarithm metrics. */
 typedef int16_t log_est_t;
 
@@ -151,8 +178,86 @@ struct index_opts {
 	 * previous one.
 	 */
 	double run_size_ratio;
+	/** How to pick runs for compaction. */
+	enum index_compaction_strategy compaction_strategy;
 	/* Bloom filter false positive rate. */
 	double bloom_fpr;
+	/**
+	 * Column mask of the fields a vinyl secondary index
+	 * stores in addition to its key parts. A select that
+	 * only needs these fields and the key parts is served
+	 * without looking up the full tuple in the primary index.
+	 * Only fields 0..62 can be covered.
+	 */
+	uint64_t covered_fields;
+	/**
+	 * Tuples whose msgpack is at least this many bytes long
+	 * are stored by a vinyl primary index in separate blob
+	 * files, while runs only keep the key and a reference to
+	 * the value. Zero disables the separation.
+	 */
+	int64_t blob_threshold;
+	/**
+	 * If not zero, a vinyl index writes run pages with keys
+	 * prefix-compressed against the previous statement. Every
+	 * page_restart_interval-th statement is stored in full so
+	 * that a lookup does not have to decode the whole page.
+	 */
+	int64_t page_restart_interval;
+	/**
+	 * Vinyl only. Store statements of run pages column by
+	 * column rather than row by row, which makes pages of
+	 * wide tuples compress better.
+	 */
+	bool columnar;
+	/**
+	 * Column mask of the fields a vinyl index keeps per-page
+	 * min/max values of, so that range scans with a predicate
+	 * on such a field can skip run pages. Only fields 0..62
+	 * can be used.
+	 */
+	uint64_t zone_map_fields;
+	/**
+	 * Vinyl only. If not zero, a zstd dictionary of up to
+	 * this many bytes is trained on the pages of every run
+	 * written for the index and used to compress pages of
+	 * the next runs.
+	 */
+	int64_t compression_dict_size;
+	/**
+	 * BITSET index only. Keep pages with few bits set as
+	 * sorted arrays of bit offsets rather than bitmaps,
+	 * which saves memory on sparse keys.
+	 */
+	bool is_sparse;
+	/**
+	 * HASH index only. Number of tuples to size the hash
+	 * table for when the index is created, so that filling
+	 * it doesn't grow the table. Zero means no hint.
+	 */
+	int64_t size_hint;
+	/**
+	 * TREE index only. The first key part holds the time,
+	 * in seconds since the epoch, when the tuple expires.
+	 * Expired tuples are deleted by a background fiber.
+	 */
+	bool expire;
+	/**
+	 * Id of the function of a functional index, 0 for other
+	 * indexes. Key parts of a functional index refer to the
+	 * fields of a tuple the function returns for the indexed
+	 * tuple rather than to the fields of the indexed tuple.
+	 */
+	uint32_t func_id;
+	/**
+	 * Store the key of each tuple along with the tuple in
+	 * the index, so that comparisons don't look into tuples.
+	 * Pays off for keys that are slow to extract, like deep
+	 * JSON paths or fields far from the tuple beginning.
+	 */
+	bool store_key;
+	/** Hash function of a HASH index. */
+	enum index_hash_func hash_func;
 	/**
 	 * LSN from the time of index creation.
 	 */
@@ -205,8 +310,37 @@ index_opts_cmp(const struct index_opts *o1, const struct index_opts *o2)
 		       -1 : 1;
 	if (o1->run_size_ratio != o2->run_size_ratio)
 		return o1->run_size_ratio < o2->run_size_ratio ? -1 : 1;
+	if (o1->compaction_strategy != o2->compaction_strategy)
+		return o1->compaction_strategy < o2->compaction_strategy ?
+		       -1 : 1;
 	if (o1->bloom_fpr != o2->bloom_fpr)
 		return o1->bloom_fpr < o2->bloom_fpr ? -1 : 1;
+	if (o1->blob_threshold != o2->blob_threshold)
+		return o1->blob_threshold < o2->blob_threshold ? -1 : 1;
+	if (o1->page_restart_interval != o2->page_restart_interval)
+		return o1->page_restart_interval <
+		       o2->page_restart_interval ? -1 : 1;
+	if (o1->columnar != o2->columnar)
+		return o1->columnar < o2->columnar ? -1 : 1;
+	if (o1->covered_fields != o2->covered_fields)
+		return o1->covered_fields < o2->covered_fields ? -1 : 1;
+	if (o1->zone_map_fields != o2->zone_map_fields)
+		return o1->zone_map_fields < o2->zone_map_fields ? -1 : 1;
+	if (o1->compression_dict_size != o2->compression_dict_size)
+		return o1->compression_dict_size <
+		       o2->compression_dict_size ? -1 : 1;
+	if (o1->is_sparse != o2->is_sparse)
+		return o1->is_sparse < o2->is_sparse ? -1 : 1;
+	if (o1->size_hint != o2->size_hint)
+		return o1->size_hint < o2->size_hint ? -1 : 1;
+	if (o1->expire != o2->expire)
+		return o1->expire < o2->expire ? -1 : 1;
+	if (o1->func_id != o2->func_id)
+		return o1->func_id < o2->func_id ? -1 : 1;
+	if (o1->store_key != o2->store_key)
+		return o1->store_key < o2->store_key ? -1 : 1;
+	if (o1->hash_func != o2->hash_func)
+		return o1->hash_func < o2->hash_func ? -1 : 1;
 	return 0;
 }
 
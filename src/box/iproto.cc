@@ -32,10 +32,12 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <limits.h>
 
 #include <msgpuck.h>
 #include <small/ibuf.h>
 #include <small/obuf.h>
+#include <zstd.h>
 #include "third_party/base64.h"
 
 #include "version.h"
@@ -50,6 +52,8 @@
 #include "random.h"
 
 #include "port.h"
+#include "probe.h"
+#include "tuple.h"
 #include "box.h"
 #include "call.h"
 #include "tuple_convert.h"
@@ -59,6 +63,9 @@
 #include "replication.h" /* instance_uuid */
 #include "iproto_constants.h"
 #include "rmean.h"
+#include "latency.h"
+#include "clock.h"
+#include "info.h"
 #include "execute.h"
 #include "errinj.h"
 
@@ -127,6 +134,14 @@ unsigned iproto_readahead = 16320;
 /* The maximal number of iproto messages in fly. */
 static int iproto_msg_max = IPROTO_MSG_MAX_MIN;
 
+/**
+ * Select responses of at least this many bytes are sent
+ * from tuple memory rather than copied to the output buffer,
+ * see iproto_zc_chunk. 0 disables zero-copy responses.
+ * Used by the tx thread only.
+ */
+static size_t iproto_zero_copy_threshold = 0;
+
 /**
  * How big is a buffer which needs to be shrunk before
  * it is put back into buffer cache.
@@ -178,6 +193,8 @@ struct iproto_msg
 		struct auth_request auth;
 		/* SQL request, if this is the EXECUTE request. */
 		struct sql_request sql;
+		/** Compression threshold, if this is COMPRESS. */
+		uint32_t compress_threshold;
 		/** In case of iproto parse error, saved diagnostics. */
 		struct diag diag;
 	};
@@ -202,6 +219,12 @@ struct iproto_msg
 	 * more output to flush.
 	 */
 	struct iproto_wpos wpos;
+	/**
+	 * Response that must be sent right after the output at
+	 * wpos, bypassing the output buffer, or NULL. Set by the
+	 * tx thread.
+	 */
+	struct iproto_zc_chunk *zc_chunk;
 	/**
 	 * Message sent by the tx thread to notify iproto that input has
 	 * been processed and can be discarded before request completion.
@@ -213,56 +236,24 @@ struct iproto_msg
 	 * and the connection must be closed.
 	 */
 	bool close_connection;
+	/** When the message was sent to tx, by clock_monotonic(). */
+	double enqueue_time;
+	/** When tx started processing the message. */
+	double start_time;
 };
 
-static struct mempool iproto_msg_pool;
-
-static struct iproto_msg *
-iproto_msg_new(struct iproto_connection *con);
-
 /**
  * Resume stopped connections, if any.
  */
 static void
-iproto_resume();
+iproto_resume(struct iproto_thread *iproto_thread);
 
 static void
 iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		  bool *stop_input);
 
 static inline void
-iproto_msg_delete(struct iproto_msg *msg)
-{
-	mempool_free(&iproto_msg_pool, msg);
-	iproto_resume();
-}
-
-/**
- * A single global queue for all requests in all connections. All
- * requests from all connections are processed concurrently.
- * Is also used as a queue for just established connections and to
- * execute disconnect triggers. A few notes about these triggers:
- * - they need to be run in a fiber
- * - unlike an ordinary request failure, on_connect trigger
- *   failure must lead to connection close.
- * - on_connect trigger must be processed before any other
- *   request on this connection.
- */
-static struct cpipe tx_pipe;
-static struct cpipe net_pipe;
-
-/**
- * Network thread.
- */
-static struct cord net_cord;
-
-/**
- * Slab cache used for allocating memory for output network buffers
- * in the tx thread.
- */
-static struct slab_cache net_slabc;
-
-struct rmean *rmean_net;
+iproto_msg_delete(struct iproto_msg *msg);
 
 enum rmean_net_name {
 	IPROTO_SENT,
@@ -272,17 +263,82 @@ enum rmean_net_name {
 
 const char *rmean_net_strings[IPROTO_LAST] = { "SENT", "RECEIVED" };
 
-static void
-tx_process_destroy(struct cmsg *m);
-
-static void
-net_finish_destroy(struct cmsg *m);
-
-static const struct cmsg_hop destroy_route[] = {
-	{ tx_process_destroy, &net_pipe },
-	{ net_finish_destroy, NULL },
+/**
+ * Context of a single network thread. Accepted connections are
+ * spread among all network threads, each of them reads, decodes
+ * and flushes only connections it owns and talks to tx over its
+ * own pair of pipes.
+ */
+struct iproto_thread {
+	/** Ordinal number of the thread, starting from 0. */
+	int id;
+	/** Network thread. */
+	struct cord net_cord;
+	/**
+	 * A single queue for all requests in all connections
+	 * owned by the thread. All requests from all connections
+	 * are processed concurrently. Is also used as a queue
+	 * for just established connections and to execute
+	 * disconnect triggers. A few notes about these triggers:
+	 * - they need to be run in a fiber
+	 * - unlike an ordinary request failure, on_connect trigger
+	 *   failure must lead to connection close.
+	 * - on_connect trigger must be processed before any other
+	 *   request on this connection.
+	 */
+	struct cpipe tx_pipe;
+	/**
+	 * A queue for requests with IPROTO_PRIORITY set. It is
+	 * served by a separate fiber pool in tx, so interactive
+	 * requests bypass a backlog of bulk requests in tx_pipe.
+	 * Requests in different queues are not ordered with
+	 * respect to each other.
+	 */
+	struct cpipe tx_high_pipe;
+	struct cpipe net_pipe;
+	/**
+	 * Slab cache used for allocating memory for output
+	 * network buffers in the tx thread.
+	 */
+	struct slab_cache net_slabc;
+	struct mempool iproto_msg_pool;
+	struct mempool iproto_connection_pool;
+	/** Connections with input stopped by net_msg_max. */
+	struct rlist stopped_connections;
+	/**
+	 * Number of connections with messages in flight, which
+	 * share net_msg_max, see iproto_connection_check_msg_max().
+	 */
+	int busy_connection_count;
+	/** Network statistics of the thread (iproto & cbus). */
+	struct rmean *rmean;
+	/**
+	 * Listener of the thread. Only the first thread binds
+	 * the socket, others are attached to its descriptor.
+	 */
+	struct evio_service binary;
+	/*
+	 * Message routes. Since a route refers to the pipe of
+	 * its next hop, every thread needs its own copy.
+	 */
+	struct cmsg_hop destroy_route[2];
+	struct cmsg_hop push_route[2];
+	struct cmsg_hop misc_route[2];
+	struct cmsg_hop call_route[2];
+	struct cmsg_hop select_route[2];
+	struct cmsg_hop process1_route[2];
+	struct cmsg_hop sql_route[2];
+	const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX];
+	struct cmsg_hop join_route[2];
+	struct cmsg_hop subscribe_route[2];
+	struct cmsg_hop error_route[2];
+	struct cmsg_hop connect_route[2];
 };
 
+/** Network threads, the number is set by box.cfg.iproto_threads. */
+static struct iproto_thread *iproto_threads;
+static int iproto_threads_count;
+
 /** Fire on_disconnect triggers in the tx thread. */
 static void
 tx_process_disconnect(struct cmsg *m);
@@ -291,29 +347,6 @@ static const struct cmsg_hop disconnect_route[] = {
 	{ tx_process_disconnect, NULL }
 };
 
-/**
- * Kharon is in the dead world (iproto). Schedule an event to
- * flush new obuf as reflected in the fresh wpos.
- * @param m Kharon.
- */
-static void
-iproto_process_push(struct cmsg *m);
-
-/**
- * Kharon returns to the living world (tx) back from the dead one
- * (iproto). Check if a new push is pending and make a new trip
- * to iproto if necessary.
- * @param m Kharon.
- */
-static void
-tx_end_push(struct cmsg *m);
-
-static const struct cmsg_hop push_route[] = {
-	{ iproto_process_push, &tx_pipe },
-	{ tx_end_push, NULL }
-};
-
-
 /* }}} */
 
 /* {{{ iproto_connection - declaration and definition */
@@ -402,6 +435,8 @@ struct iproto_connection
 	 * connections.
 	 */
 	int long_poll_count;
+	/** Number of messages of the connection in flight. */
+	int msg_count;
 	struct ev_io input;
 	struct ev_io output;
 	/** Logical session. */
@@ -455,6 +490,12 @@ struct iproto_connection
 	 *                          ...
 	 */
 	struct iproto_kharon kharon;
+	/**
+	 * Zero-copy responses received from tx, but not sent yet,
+	 * in the order of their positions in the output, linked by
+	 * iproto_zc_chunk::in_net.
+	 */
+	struct rlist zc_chunks;
 	/**
 	 * The following fields are used exclusively by the tx thread.
 	 * Align them to prevent false-sharing.
@@ -463,6 +504,17 @@ struct iproto_connection
 		alignas(CACHELINE_SIZE)
 		/** Pointer to the current output buffer. */
 		struct obuf *p_obuf;
+		/**
+		 * All zero-copy responses that haven't been
+		 * released yet, linked by iproto_zc_chunk::in_tx.
+		 */
+		struct rlist zc_chunks;
+		/**
+		 * Bodies of responses of at least this size are
+		 * compressed, see IPROTO_COMPRESS. 0 means the
+		 * client hasn't requested compression.
+		 */
+		uint32_t compress_threshold;
 		/** True if Kharon is in use/travelling. */
 		bool is_push_sent;
 		/**
@@ -473,29 +525,82 @@ struct iproto_connection
 	} tx;
 	/** Authentication salt. */
 	char salt[IPROTO_SALT_SIZE];
+	/** Network thread the connection belongs to. */
+	struct iproto_thread *iproto_thread;
 };
 
-static struct mempool iproto_connection_pool;
-static RLIST_HEAD(stopped_connections);
+/**
+ * A select response that references tuple data rather than
+ * stores a copy of it in the connection output buffer.
+ *
+ * The tx thread pins the tuples and hands the chunk over
+ * to the network thread along with the request message.
+ * The network thread writes the chunk to the socket when
+ * it reaches the chunk position in the output and sends it
+ * back to tx, which unpins the tuples and frees the chunk.
+ */
+struct iproto_zc_chunk {
+	/** Message used to return the chunk to tx. */
+	struct cmsg base;
+	/** Link in iproto_connection::tx.zc_chunks. */
+	struct rlist in_tx;
+	/** Link in iproto_connection::zc_chunks. */
+	struct rlist in_net;
+	/** Position in the output the chunk must be sent at. */
+	struct iproto_wpos wpos;
+	/** Response header. */
+	char header[IPROTO_SELECT_HEADER_LEN];
+	/** Tuples referenced by the chunk. */
+	struct tuple **tuples;
+	/** Number of tuples. */
+	int tuple_count;
+	/** The header and tuple data. */
+	struct iovec *iov;
+	/** Number of entries in @iov. */
+	int iovcnt;
+	/** Index of the first entry of @iov not fully sent yet. */
+	int iov_pos;
+};
+
+/** Unpin the tuples of a zero-copy response and free it. */
+static void
+iproto_zc_chunk_delete(struct iproto_zc_chunk *chunk)
+{
+	for (int i = 0; i < chunk->tuple_count; i++)
+		tuple_unref(chunk->tuples[i]);
+	rlist_del_entry(chunk, in_tx);
+	free(chunk);
+}
+
+/** Release a zero-copy response sent by the network thread. */
+static void
+tx_release_zc_chunk(struct cmsg *m)
+{
+	iproto_zc_chunk_delete((struct iproto_zc_chunk *) m);
+}
+
+static const struct cmsg_hop tx_release_zc_chunk_route[] = {
+	{ tx_release_zc_chunk, NULL },
+};
 
 /**
  * Return true if we have not enough spare messages
- * in the message pool.
+ * in the message pool. The limit is per network thread.
  */
 static inline bool
-iproto_check_msg_max()
+iproto_check_msg_max(struct iproto_thread *iproto_thread)
 {
-	size_t request_count = mempool_count(&iproto_msg_pool);
+	size_t request_count = mempool_count(&iproto_thread->iproto_msg_pool);
 	return request_count > (size_t) iproto_msg_max;
 }
 
 static struct iproto_msg *
 iproto_msg_new(struct iproto_connection *con)
 {
-	struct iproto_msg *msg =
-		(struct iproto_msg *) mempool_alloc(&iproto_msg_pool);
+	struct mempool *pool = &con->iproto_thread->iproto_msg_pool;
+	struct iproto_msg *msg = (struct iproto_msg *) mempool_alloc(pool);
 	ERROR_INJECT(ERRINJ_TESTING, {
-		mempool_free(&iproto_msg_pool, msg);
+		mempool_free(pool, msg);
 		msg = NULL;
 	});
 	if (msg == NULL) {
@@ -505,9 +610,44 @@ iproto_msg_new(struct iproto_connection *con)
 		return NULL;
 	}
 	msg->connection = con;
+	msg->zc_chunk = NULL;
+	if (con->msg_count++ == 0)
+		con->iproto_thread->busy_connection_count++;
 	return msg;
 }
 
+static inline void
+iproto_msg_delete(struct iproto_msg *msg)
+{
+	struct iproto_connection *con = msg->connection;
+	struct iproto_thread *iproto_thread = con->iproto_thread;
+	mempool_free(&iproto_thread->iproto_msg_pool, msg);
+	assert(con->msg_count > 0);
+	if (--con->msg_count == 0)
+		iproto_thread->busy_connection_count--;
+	iproto_resume(iproto_thread);
+}
+
+/**
+ * Return true if the connection must not enqueue more
+ * requests: either the thread is out of messages or the
+ * connection has used up its share of them. net_msg_max is
+ * split evenly between connections with requests in flight,
+ * so a client pipelining lots of requests can't take all
+ * messages and stall requests of other clients. A single
+ * busy connection still may use the whole limit.
+ */
+static inline bool
+iproto_connection_check_msg_max(struct iproto_connection *con)
+{
+	struct iproto_thread *iproto_thread = con->iproto_thread;
+	if (iproto_check_msg_max(iproto_thread))
+		return true;
+	int share = iproto_msg_max /
+		    MAX(iproto_thread->busy_connection_count, 1);
+	return con->msg_count > share;
+}
+
 /**
  * A connection is idle when the client is gone
  * and there are no outstanding msgs in the msg queue.
@@ -551,15 +691,19 @@ iproto_connection_stop_msg_max_limit(struct iproto_connection *con)
 {
 	assert(rlist_empty(&con->in_stop_list));
 
-	say_warn_ratelimited("stopping input on connection %s, "
-			     "net_msg_max limit is reached",
-			     sio_socketname(con->input.fd));
+	/* Waiting for the connection share is not worth a warning. */
+	if (iproto_check_msg_max(con->iproto_thread)) {
+		say_warn_ratelimited("stopping input on connection %s, "
+				     "net_msg_max limit is reached",
+				     sio_socketname(con->input.fd));
+	}
 	ev_io_stop(con->loop, &con->input);
 	/*
 	 * Important to add to tail and fetch from head to ensure
 	 * strict lifo order (fairness) for stopped connections.
 	 */
-	rlist_add_tail(&stopped_connections, &con->in_stop_list);
+	rlist_add_tail(&con->iproto_thread->stopped_connections,
+		       &con->in_stop_list);
 }
 
 /**
@@ -586,7 +730,7 @@ iproto_connection_close(struct iproto_connection *con)
 		 * is done only once.
 		 */
 		con->p_ibuf->wpos -= con->parse_size;
-		cpipe_push(&tx_pipe, &con->disconnect_msg);
+		cpipe_push(&con->iproto_thread->tx_pipe, &con->disconnect_msg);
 	}
 	/*
 	 * If the connection has no outstanding requests in the
@@ -603,7 +747,7 @@ iproto_connection_close(struct iproto_connection *con)
 	if (iproto_connection_is_idle(con)) {
 		assert(! con->is_destroy_sent);
 		con->is_destroy_sent = true;
-		cpipe_push(&tx_pipe, &con->destroy_msg);
+		cpipe_push(&con->iproto_thread->tx_pipe, &con->destroy_msg);
 	}
 	rlist_del(&con->in_stop_list);
 }
@@ -697,6 +841,35 @@ iproto_connection_input_buffer(struct iproto_connection *con)
 	return new_ibuf;
 }
 
+/**
+ * Return true if the request should be sent to tx by the high
+ * priority lane. Only data requests can be prioritized, the
+ * rest keep their order in the bulk lane.
+ */
+static inline bool
+iproto_msg_is_high_priority(struct iproto_msg *msg)
+{
+	if (msg->header.priority == 0)
+		return false;
+	switch (msg->header.type) {
+	case IPROTO_SELECT:
+	case IPROTO_INSERT:
+	case IPROTO_REPLACE:
+	case IPROTO_UPDATE:
+	case IPROTO_DELETE:
+	case IPROTO_UPSERT:
+	case IPROTO_CALL_16:
+	case IPROTO_CALL:
+	case IPROTO_EVAL:
+	case IPROTO_EXECUTE:
+	case IPROTO_PREPARE:
+	case IPROTO_PING:
+		return true;
+	default:
+		return false;
+	}
+}
+
 /**
  * Enqueue all requests which were read up. If a request limit is
  * reached - stop the connection input even if not the whole batch
@@ -712,13 +885,16 @@ static inline int
 iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 {
 	assert(rlist_empty(&con->in_stop_list));
+	struct cpipe *tx_pipe = &con->iproto_thread->tx_pipe;
+	struct cpipe *tx_high_pipe = &con->iproto_thread->tx_high_pipe;
 	int n_requests = 0;
 	bool stop_input = false;
 	const char *errmsg;
 	while (con->parse_size != 0 && !stop_input) {
-		if (iproto_check_msg_max()) {
+		if (iproto_connection_check_msg_max(con)) {
 			iproto_connection_stop_msg_max_limit(con);
-			cpipe_flush_input(&tx_pipe);
+			cpipe_flush_input(tx_pipe);
+			cpipe_flush_input(tx_high_pipe);
 			return 0;
 		}
 		const char *reqstart = in->wpos - con->parse_size;
@@ -727,7 +903,8 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		if (mp_typeof(*pos) != MP_UINT) {
 			errmsg = "packet length";
 err_msgpack:
-			cpipe_flush_input(&tx_pipe);
+			cpipe_flush_input(tx_pipe);
+			cpipe_flush_input(tx_high_pipe);
 			diag_set(ClientError, ER_INVALID_MSGPACK,
 				 errmsg);
 			return -1;
@@ -759,11 +936,15 @@ err_msgpack:
 		msg->len = reqend - reqstart; /* total request length */
 
 		iproto_msg_decode(msg, &pos, reqend, &stop_input);
+		msg->enqueue_time = clock_monotonic();
 		/*
 		 * This can't throw, but should not be
 		 * done in case of exception.
 		 */
-		cpipe_push_input(&tx_pipe, &msg->base);
+		if (iproto_msg_is_high_priority(msg))
+			cpipe_push_input(tx_high_pipe, &msg->base);
+		else
+			cpipe_push_input(tx_pipe, &msg->base);
 		n_requests++;
 		/* Request is parsed */
 		assert(reqend > reqstart);
@@ -801,7 +982,8 @@ err_msgpack:
 		 */
 		ev_feed_event(con->loop, &con->input, EV_READ);
 	}
-	cpipe_flush_input(&tx_pipe);
+	cpipe_flush_input(tx_pipe);
+	cpipe_flush_input(tx_high_pipe);
 	return 0;
 }
 
@@ -813,7 +995,7 @@ err_msgpack:
 static void
 iproto_connection_resume(struct iproto_connection *con)
 {
-	assert(! iproto_check_msg_max());
+	assert(! iproto_check_msg_max(con->iproto_thread));
 	rlist_del(&con->in_stop_list);
 	/*
 	 * Enqueue_batch() stops the connection again, if the
@@ -837,18 +1019,30 @@ iproto_connection_resume(struct iproto_connection *con)
  * necessary to use up the limit.
  */
 static void
-iproto_resume()
+iproto_resume(struct iproto_thread *iproto_thread)
 {
-	while (!iproto_check_msg_max() && !rlist_empty(&stopped_connections)) {
+	struct rlist *stopped = &iproto_thread->stopped_connections;
+	if (rlist_empty(stopped))
+		return;
+	/*
+	 * A connection over its share is stopped again and goes
+	 * to the list tail, so visit each connection once.
+	 */
+	struct iproto_connection *last =
+		rlist_last_entry(stopped, struct iproto_connection,
+				 in_stop_list);
+	while (!iproto_check_msg_max(iproto_thread) &&
+	       !rlist_empty(stopped)) {
 		/*
 		 * Shift from list head to ensure strict FIFO
 		 * (fairness) for resumed connections.
 		 */
 		struct iproto_connection *con =
-			rlist_first_entry(&stopped_connections,
-					  struct iproto_connection,
+			rlist_first_entry(stopped, struct iproto_connection,
 					  in_stop_list);
 		iproto_connection_resume(con);
+		if (con == last)
+			break;
 	}
 }
 
@@ -867,7 +1061,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	 * otherwise we might deplete the fiber pool in tx
 	 * thread and deadlock.
 	 */
-	if (iproto_check_msg_max()) {
+	if (iproto_connection_check_msg_max(con)) {
 		iproto_connection_stop_msg_max_limit(con);
 		return;
 	}
@@ -892,7 +1086,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			return;
 		}
 		/* Count statistics */
-		rmean_collect(rmean_net, IPROTO_RECEIVED, nrd);
+		rmean_collect(con->iproto_thread->rmean, IPROTO_RECEIVED, nrd);
 
 		/* Update the read position and connection state. */
 		in->wpos += nrd;
@@ -910,6 +1104,38 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 
 /** writev() to the socket and handle the result. */
 
+/**
+ * writev() a zero-copy response to the socket.
+ * Return values are the same as of iproto_flush().
+ */
+static int
+iproto_flush_zc_chunk(struct iproto_connection *con,
+		      struct iproto_zc_chunk *chunk)
+{
+	struct iovec *iov = chunk->iov + chunk->iov_pos;
+	int iovcnt = MIN(chunk->iovcnt - chunk->iov_pos, IOV_MAX);
+	ssize_t nwr = sio_writev(con->output.fd, iov, iovcnt);
+	if (nwr > 0) {
+		rmean_collect(con->iproto_thread->rmean, IPROTO_SENT, nwr);
+		size_t offset = 0;
+		int advance = sio_move_iov(iov, nwr, &offset);
+		chunk->iov_pos += advance;
+		if (chunk->iov_pos == chunk->iovcnt) {
+			/* Let tx release the tuples. */
+			rlist_del_entry(chunk, in_net);
+			cpipe_push(&con->iproto_thread->tx_pipe, &chunk->base);
+			return 0;
+		}
+		if (advance == iovcnt)
+			return 0; /* more than IOV_MAX entries */
+		iov[advance].iov_base = (char *)iov[advance].iov_base + offset;
+		iov[advance].iov_len -= offset;
+	} else if (nwr < 0 && ! sio_wouldblock(errno)) {
+		diag_raise();
+	}
+	return -1;
+}
+
 static int
 iproto_flush(struct iproto_connection *con)
 {
@@ -918,6 +1144,18 @@ iproto_flush(struct iproto_connection *con)
 	struct obuf_svp obuf_end = obuf_create_svp(obuf);
 	struct obuf_svp *begin = &con->wpos.svp;
 	struct obuf_svp *end = &con->wend.svp;
+	/*
+	 * A zero-copy response must be sent before the output
+	 * following its position, see iproto_zc_chunk.
+	 */
+	struct iproto_zc_chunk *chunk = NULL;
+	if (!rlist_empty(&con->zc_chunks)) {
+		chunk = rlist_first_entry(&con->zc_chunks,
+					  struct iproto_zc_chunk, in_net);
+		if (chunk->wpos.obuf == obuf &&
+		    chunk->wpos.svp.used == begin->used)
+			return iproto_flush_zc_chunk(con, chunk);
+	}
 	if (con->wend.obuf != obuf) {
 		/*
 		 * Flush the current buffer before
@@ -930,6 +1168,12 @@ iproto_flush(struct iproto_connection *con)
 			end = &obuf_end;
 		}
 	}
+	if (chunk != NULL && chunk->wpos.obuf == obuf) {
+		if (chunk->wpos.svp.used == begin->used)
+			return iproto_flush_zc_chunk(con, chunk);
+		if (chunk->wpos.svp.used < end->used)
+			end = &chunk->wpos.svp;
+	}
 	if (begin->used == end->used) {
 		/* Nothing to do. */
 		return 1;
@@ -951,7 +1195,7 @@ iproto_flush(struct iproto_connection *con)
 
 	if (nwr > 0) {
 		/* Count statistics */
-		rmean_collect(rmean_net, IPROTO_SENT, nwr);
+		rmean_collect(con->iproto_thread->rmean, IPROTO_SENT, nwr);
 		if (begin->used + nwr == end->used) {
 			*begin = *end;
 			return 0;
@@ -996,10 +1240,10 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 }
 
 static struct iproto_connection *
-iproto_connection_new(int fd)
+iproto_connection_new(struct iproto_thread *iproto_thread, int fd)
 {
 	struct iproto_connection *con = (struct iproto_connection *)
-		mempool_alloc(&iproto_connection_pool);
+		mempool_alloc(&iproto_thread->iproto_connection_pool);
 	if (con == NULL) {
 		diag_set(OutOfMemory, sizeof(*con), "mempool_alloc", "con");
 		return NULL;
@@ -1010,22 +1254,29 @@ iproto_connection_new(int fd)
 	ev_io_init(&con->output, iproto_connection_on_output, fd, EV_WRITE);
 	ibuf_create(&con->ibuf[0], cord_slab_cache(), iproto_readahead);
 	ibuf_create(&con->ibuf[1], cord_slab_cache(), iproto_readahead);
-	obuf_create(&con->obuf[0], &net_slabc, iproto_readahead);
-	obuf_create(&con->obuf[1], &net_slabc, iproto_readahead);
+	obuf_create(&con->obuf[0], &iproto_thread->net_slabc,
+		    iproto_readahead);
+	obuf_create(&con->obuf[1], &iproto_thread->net_slabc,
+		    iproto_readahead);
 	con->p_ibuf = &con->ibuf[0];
 	con->tx.p_obuf = &con->obuf[0];
 	iproto_wpos_create(&con->wpos, con->tx.p_obuf);
 	iproto_wpos_create(&con->wend, con->tx.p_obuf);
 	con->parse_size = 0;
 	con->long_poll_count = 0;
+	con->msg_count = 0;
 	con->session = NULL;
 	rlist_create(&con->in_stop_list);
+	rlist_create(&con->zc_chunks);
+	rlist_create(&con->tx.zc_chunks);
 	/* It may be very awkward to allocate at close. */
-	cmsg_init(&con->destroy_msg, destroy_route);
+	cmsg_init(&con->destroy_msg, iproto_thread->destroy_route);
 	cmsg_init(&con->disconnect_msg, disconnect_route);
 	con->is_destroy_sent = false;
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = false;
+	con->tx.compress_threshold = 0;
+	con->iproto_thread = iproto_thread;
 	return con;
 }
 
@@ -1047,7 +1298,7 @@ iproto_connection_delete(struct iproto_connection *con)
 	       con->obuf[0].iov[0].iov_base == NULL);
 	assert(con->obuf[1].pos == 0 &&
 	       con->obuf[1].iov[0].iov_base == NULL);
-	mempool_free(&iproto_connection_pool, con);
+	mempool_free(&con->iproto_thread->iproto_connection_pool, con);
 }
 
 /* }}} iproto_connection */
@@ -1090,73 +1341,19 @@ net_end_join(struct cmsg *msg);
 static void
 net_end_subscribe(struct cmsg *msg);
 
-static const struct cmsg_hop misc_route[] = {
-	{ tx_process_misc, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop call_route[] = {
-	{ tx_process_call, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop select_route[] = {
-	{ tx_process_select, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop process1_route[] = {
-	{ tx_process1, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop sql_route[] = {
-	{ tx_process_sql, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX] = {
-	NULL,                                   /* IPROTO_OK */
-	select_route,                           /* IPROTO_SELECT */
-	process1_route,                         /* IPROTO_INSERT */
-	process1_route,                         /* IPROTO_REPLACE */
-	process1_route,                         /* IPROTO_UPDATE */
-	process1_route,                         /* IPROTO_DELETE */
-	call_route,                             /* IPROTO_CALL_16 */
-	misc_route,                             /* IPROTO_AUTH */
-	call_route,                             /* IPROTO_EVAL */
-	process1_route,                         /* IPROTO_UPSERT */
-	call_route,                             /* IPROTO_CALL */
-	sql_route,                              /* IPROTO_EXECUTE */
-	NULL,                                   /* IPROTO_NOP */
-};
-
-static const struct cmsg_hop join_route[] = {
-	{ tx_process_join_subscribe, &net_pipe },
-	{ net_end_join, NULL },
-};
-
-static const struct cmsg_hop subscribe_route[] = {
-	{ tx_process_join_subscribe, &net_pipe },
-	{ net_end_subscribe, NULL },
-};
-
-static const struct cmsg_hop error_route[] = {
-	{ tx_reply_iproto_error, &net_pipe },
-	{ net_send_error, NULL },
-};
-
 static void
 iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		  bool *stop_input)
 {
 	uint8_t type;
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
 
 	if (xrow_header_decode(&msg->header, pos, reqend))
 		goto error;
 	assert(*pos == reqend);
 
 	type = msg->header.type;
+	PROBE2(iproto_msg_decode, type, msg->header.sync);
 
 	/*
 	 * Parse request before putting it into the queue
@@ -1173,40 +1370,51 @@ iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		if (xrow_decode_dml(&msg->header, &msg->dml,
 				    dml_request_key_map(type)))
 			goto error;
-		assert(type < sizeof(dml_route)/sizeof(*dml_route));
-		cmsg_init(&msg->base, dml_route[type]);
+		assert(type < sizeof(iproto_thread->dml_route) /
+			      sizeof(*iproto_thread->dml_route));
+		cmsg_init(&msg->base, iproto_thread->dml_route[type]);
 		break;
 	case IPROTO_CALL_16:
 	case IPROTO_CALL:
 	case IPROTO_EVAL:
 		if (xrow_decode_call(&msg->header, &msg->call))
 			goto error;
-		cmsg_init(&msg->base, call_route);
+		cmsg_init(&msg->base, iproto_thread->call_route);
 		break;
 	case IPROTO_EXECUTE:
+	case IPROTO_PREPARE:
 		if (xrow_decode_sql(&msg->header, &msg->sql) != 0)
 			goto error;
-		cmsg_init(&msg->base, sql_route);
+		cmsg_init(&msg->base, iproto_thread->sql_route);
 		break;
 	case IPROTO_PING:
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	case IPROTO_JOIN:
-		cmsg_init(&msg->base, join_route);
+	case IPROTO_FETCH_SNAPSHOT:
+	case IPROTO_REGISTER:
+		cmsg_init(&msg->base, iproto_thread->join_route);
 		*stop_input = true;
 		break;
 	case IPROTO_SUBSCRIBE:
-		cmsg_init(&msg->base, subscribe_route);
+	case IPROTO_CDC_SUBSCRIBE:
+		cmsg_init(&msg->base, iproto_thread->subscribe_route);
 		*stop_input = true;
 		break;
 	case IPROTO_VOTE_DEPRECATED:
 	case IPROTO_VOTE:
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	case IPROTO_AUTH:
 		if (xrow_decode_auth(&msg->header, &msg->auth))
 			goto error;
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
+		break;
+	case IPROTO_COMPRESS:
+		if (xrow_decode_compress(&msg->header,
+					 &msg->compress_threshold) != 0)
+			goto error;
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	default:
 		diag_set(ClientError, ER_UNKNOWN_REQUEST_TYPE,
@@ -1219,7 +1427,7 @@ error:
 	diag_log();
 	diag_create(&msg->diag);
 	diag_move(&fiber()->diag, &msg->diag);
-	cmsg_init(&msg->base, error_route);
+	cmsg_init(&msg->base, iproto_thread->error_route);
 }
 
 static void
@@ -1227,6 +1435,7 @@ tx_fiber_init(struct session *session, uint64_t sync)
 {
 	struct fiber *f = fiber();
 	f->storage.net.sync = sync;
+	f->storage.wal_wait = 0;
 	/*
 	 * We do not cleanup fiber keys at the end of each request.
 	 * This does not lead to privilege escalation as long as
@@ -1274,6 +1483,10 @@ tx_process_destroy(struct cmsg *m)
 	 */
 	obuf_destroy(&con->obuf[0]);
 	obuf_destroy(&con->obuf[1]);
+	/* Release responses that haven't been sent. */
+	struct iproto_zc_chunk *chunk, *tmp;
+	rlist_foreach_entry_safe(chunk, &con->tx.zc_chunks, in_tx, tmp)
+		iproto_zc_chunk_delete(chunk);
 }
 
 /**
@@ -1301,6 +1514,23 @@ tx_check_schema(uint32_t new_schema_version)
 	return 0;
 }
 
+/**
+ * Wait until the instance has applied all changes up to
+ * IPROTO_WAIT_VCLOCK of the request, if it is set, so that
+ * a client reading from a replica sees its own writes made
+ * on the master.
+ */
+static int
+tx_wait_vclock(struct iproto_msg *msg)
+{
+	if (msg->header.wait_vclock == NULL)
+		return 0;
+	struct vclock vclock;
+	if (xrow_decode_wait_vclock(&msg->header, &vclock) != 0)
+		return -1;
+	return replicaset_wait_vclock(&vclock, replication_sync_timeout);
+}
+
 static void
 net_discard_input(struct cmsg *m)
 {
@@ -1322,7 +1552,8 @@ tx_discard_input(struct iproto_msg *msg)
 		{ net_discard_input, NULL },
 	};
 	cmsg_init(&msg->discard_input, discard_input_route);
-	cpipe_push(&net_pipe, &msg->discard_input);
+	cpipe_push(&msg->connection->iproto_thread->net_pipe,
+		   &msg->discard_input);
 }
 
 /**
@@ -1364,15 +1595,55 @@ tx_accept_wpos(struct iproto_connection *con, const struct iproto_wpos *wpos)
 	}
 }
 
+/**
+ * Latency of requests of one type, updated by the tx thread
+ * only, in seconds.
+ */
+struct tx_latency {
+	/** Time between decoding a request and starting it in tx. */
+	struct latency queue;
+	/** Time of processing a request in tx, WAL wait included. */
+	struct latency exec;
+	/** Time waiting for WAL, collected if a request wrote it. */
+	struct latency wal;
+};
+
+static struct tx_latency tx_latency[IPROTO_TYPE_STAT_MAX];
+/** Time between accepting a connection and handshaking it in tx. */
+static struct latency tx_connect_latency;
+
+static const int tx_latency_permille[] = { 500, 990, 999 };
+static const char *tx_latency_permille_strs[] = { "p50", "p99", "p999" };
+
 static inline struct iproto_msg *
 tx_accept_msg(struct cmsg *m)
 {
 	struct iproto_msg *msg = (struct iproto_msg *) m;
+	PROBE2(tx_process_start, msg->header.type, msg->header.sync);
+	msg->start_time = clock_monotonic();
 	tx_accept_wpos(msg->connection, &msg->wpos);
 	tx_fiber_init(msg->connection->session, msg->header.sync);
 	return msg;
 }
 
+/** Account a request processed by tx in latency statistics. */
+static inline void
+tx_end_msg(struct iproto_msg *msg)
+{
+	uint32_t type = msg->header.type;
+	PROBE2(tx_process_done, type, msg->header.sync);
+	if (type == IPROTO_CALL_16)
+		type = IPROTO_CALL;
+	if (type >= IPROTO_TYPE_STAT_MAX || iproto_type_strs[type] == NULL)
+		return;
+	struct tx_latency *latency = &tx_latency[type];
+	latency_collect(&latency->queue, msg->start_time - msg->enqueue_time);
+	latency_collect(&latency->exec, clock_monotonic() - msg->start_time);
+	double wal_wait = fiber()->storage.wal_wait;
+	if (wal_wait > 0)
+		latency_collect(&latency->wal, wal_wait);
+}
+
 /**
  * Write error message to the output buffer and advance
  * write position. Doesn't throw.
@@ -1431,9 +1702,153 @@ tx_process1(struct cmsg *m)
 	iproto_reply_select(out, &svp, msg->header.sync, ::schema_version,
 			    tuple != 0);
 	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg);
 	return;
 error:
 	tx_reply_error(msg);
+	tx_end_msg(msg);
+}
+
+/**
+ * Reply to a select with a zero-copy response if it is large
+ * enough, see iproto_zc_chunk. The response is positioned
+ * at the end of the current output. Return true on success,
+ * false if the response is too small or there is no memory,
+ * in which case the caller should fall back on copying.
+ */
+static bool
+tx_reply_select_zero_copy(struct iproto_msg *msg, struct port *port)
+{
+	struct iproto_connection *con = msg->connection;
+	struct port_tuple *tuples = port_tuple(port);
+	struct port_tuple_entry *pe;
+	/* A compressed response is built in the output anyway. */
+	if (con->tx.compress_threshold > 0)
+		return false;
+	size_t data_size = 0;
+	for (pe = tuples->first; pe != NULL; pe = pe->next)
+		data_size += pe->tuple->bsize;
+	if (data_size < iproto_zero_copy_threshold ||
+	    data_size > UINT32_MAX - IPROTO_SELECT_HEADER_LEN)
+		return false;
+
+	int count = tuples->size;
+	size_t size = sizeof(struct iproto_zc_chunk) +
+		      count * sizeof(struct tuple *) +
+		      (count + 1) * sizeof(struct iovec);
+	struct iproto_zc_chunk *chunk =
+		(struct iproto_zc_chunk *) malloc(size);
+	if (chunk == NULL)
+		return false;
+	chunk->tuples = (struct tuple **) (chunk + 1);
+	chunk->iov = (struct iovec *) (chunk->tuples + count);
+	chunk->iovcnt = count + 1;
+	chunk->iov_pos = 0;
+	chunk->tuple_count = count;
+
+	iproto_encode_select_header(chunk->header, msg->header.sync,
+				    ::schema_version, count, data_size);
+	chunk->iov[0].iov_base = chunk->header;
+	chunk->iov[0].iov_len = IPROTO_SELECT_HEADER_LEN;
+	int i = 0;
+	for (pe = tuples->first; pe != NULL; pe = pe->next, i++) {
+		uint32_t bsize;
+		const char *data = tuple_data_range(pe->tuple, &bsize);
+		tuple_ref(pe->tuple);
+		chunk->tuples[i] = pe->tuple;
+		chunk->iov[i + 1].iov_base = (void *) data;
+		chunk->iov[i + 1].iov_len = bsize;
+	}
+	port_destroy(port);
+
+	cmsg_init(&chunk->base, tx_release_zc_chunk_route);
+	rlist_add_tail_entry(&con->tx.zc_chunks, chunk, in_tx);
+	iproto_wpos_create(&chunk->wpos, con->tx.p_obuf);
+	msg->wpos = chunk->wpos;
+	msg->zc_chunk = chunk;
+	return true;
+}
+
+/** Stream used by the tx thread to compress responses. */
+static ZSTD_CStream *tx_zstream;
+
+/**
+ * Replace the body of a response written to the output since
+ * @a svp with its zstd frame, see IPROTO_COMPRESSED_BODY. The
+ * response is left as is if the client hasn't requested
+ * compression, the body is too small or doesn't shrink.
+ * Return -1 if the response was discarded for lack of memory.
+ */
+static int
+tx_compress_reply(struct iproto_msg *msg, struct obuf *out,
+		  struct obuf_svp *svp)
+{
+	uint32_t threshold = msg->connection->tx.compress_threshold;
+	size_t size = obuf_size(out) - svp->used - IPROTO_HEADER_LEN;
+	if (threshold == 0 || size < threshold)
+		return 0;
+	if (tx_zstream == NULL) {
+		tx_zstream = ZSTD_createCStream();
+		if (tx_zstream == NULL)
+			return 0;
+	}
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t zmax_size = ZSTD_compressBound(size);
+	char *zdata = (char *) region_alloc(region, zmax_size);
+	if (zdata == NULL)
+		return 0;
+	/*
+	 * The fastest level: compression runs in the tx thread
+	 * and stalls all other requests.
+	 */
+	ZSTD_initCStream(tx_zstream, 1);
+	ZSTD_outBuffer output = {zdata, zmax_size, 0};
+	struct obuf_svp end = obuf_create_svp(out);
+	size_t skip = IPROTO_HEADER_LEN;
+	for (size_t i = svp->pos; i <= end.pos; i++) {
+		const char *data = (const char *) out->iov[i].iov_base;
+		size_t len = i == end.pos ? end.iov_len : out->iov[i].iov_len;
+		size_t offset = i == svp->pos ? svp->iov_len : 0;
+		size_t header = MIN(skip, len - offset);
+		offset += header;
+		skip -= header;
+		ZSTD_inBuffer input = {data + offset, len - offset, 0};
+		size_t rc = ZSTD_compressStream(tx_zstream, &output, &input);
+		if (ZSTD_isError(rc) || input.pos != input.size)
+			goto skip;
+	}
+	if (ZSTD_endStream(tx_zstream, &output) != 0)
+		goto skip;
+	size_t header_size;
+	header_size = IPROTO_HEADER_LEN + mp_sizeof_map(1) +
+		      mp_sizeof_uint(IPROTO_COMPRESSED_BODY) +
+		      mp_sizeof_binl(output.pos);
+	if (header_size - IPROTO_HEADER_LEN + output.pos >= size)
+		goto skip;
+
+	obuf_rollback_to_svp(out, svp);
+	char *buf;
+	buf = (char *) obuf_alloc(out, header_size);
+	if (buf == NULL ||
+	    obuf_dup(out, zdata, output.pos) != output.pos) {
+		obuf_rollback_to_svp(out, svp);
+		region_truncate(region, region_svp);
+		diag_set(OutOfMemory, header_size + output.pos,
+			 "obuf_alloc", "buf");
+		return -1;
+	}
+	iproto_header_encode(buf, IPROTO_OK, msg->header.sync,
+			     ::schema_version,
+			     header_size - IPROTO_HEADER_LEN + output.pos);
+	char *pos;
+	pos = mp_encode_map(buf + IPROTO_HEADER_LEN, 1);
+	pos = mp_encode_uint(pos, IPROTO_COMPRESSED_BODY);
+	pos = mp_encode_binl(pos, output.pos);
+	assert(pos == buf + header_size);
+skip:
+	region_truncate(region, region_svp);
+	return 0;
 }
 
 static void
@@ -1448,6 +1863,8 @@ tx_process_select(struct cmsg *m)
 	struct request *req = &msg->dml;
 	if (tx_check_schema(msg->header.schema_version))
 		goto error;
+	if (tx_wait_vclock(msg) != 0)
+		goto error;
 
 	tx_inject_delay();
 	rc = box_select(req->space_id, req->index_id,
@@ -1457,6 +1874,12 @@ tx_process_select(struct cmsg *m)
 		goto error;
 
 	out = msg->connection->tx.p_obuf;
+	if (iproto_zero_copy_threshold > 0 &&
+	    port_tuple(&port)->size > 0 &&
+	    tx_reply_select_zero_copy(msg, &port)) {
+		tx_end_msg(msg);
+		return;
+	}
 	if (iproto_prepare_select(out, &svp) != 0) {
 		port_destroy(&port);
 		goto error;
@@ -1473,10 +1896,14 @@ tx_process_select(struct cmsg *m)
 	}
 	iproto_reply_select(out, &svp, msg->header.sync,
 			    ::schema_version, count);
+	if (tx_compress_reply(msg, out, &svp) != 0)
+		goto error;
 	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg);
 	return;
 error:
 	tx_reply_error(msg);
+	tx_end_msg(msg);
 }
 
 static void
@@ -1495,6 +1922,8 @@ tx_process_call(struct cmsg *m)
 	struct iproto_msg *msg = tx_accept_msg(m);
 	if (tx_check_schema(msg->header.schema_version))
 		goto error;
+	if (tx_wait_vclock(msg) != 0)
+		goto error;
 
 	/*
 	 * CALL/EVAL should copy its arguments so we can discard
@@ -1545,6 +1974,12 @@ tx_process_call(struct cmsg *m)
 	struct obuf_svp svp;
 
 	out = msg->connection->tx.p_obuf;
+	if (iproto_zero_copy_threshold > 0 &&
+	    port_tuple(&port)->size > 0 &&
+	    tx_reply_select_zero_copy(msg, &port)) {
+		tx_end_msg(msg);
+		return;
+	}
 	if (iproto_prepare_select(out, &svp) != 0) {
 		port_destroy(&port);
 		goto error;
@@ -1562,10 +1997,14 @@ tx_process_call(struct cmsg *m)
 
 	iproto_reply_select(out, &svp, msg->header.sync,
 			    ::schema_version, count);
+	if (tx_compress_reply(msg, out, &svp) != 0)
+		goto error;
 	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg);
 	return;
 error:
 	tx_reply_error(msg);
+	tx_end_msg(msg);
 }
 
 static void
@@ -1589,6 +2028,11 @@ tx_process_misc(struct cmsg *m)
 			iproto_reply_ok_xc(out, msg->header.sync,
 					   ::schema_version);
 			break;
+		case IPROTO_COMPRESS:
+			con->tx.compress_threshold = msg->compress_threshold;
+			iproto_reply_ok_xc(out, msg->header.sync,
+					   ::schema_version);
+			break;
 		case IPROTO_VOTE_DEPRECATED:
 			iproto_reply_vclock_xc(out, &replicaset.vclock,
 					       msg->header.sync,
@@ -1606,9 +2050,11 @@ tx_process_misc(struct cmsg *m)
 	} catch (Exception *e) {
 		tx_reply_error(msg);
 	}
+	tx_end_msg(msg);
 	return;
 error:
 	tx_reply_error(msg);
+	tx_end_msg(msg);
 }
 
 static void
@@ -1621,21 +2067,45 @@ tx_process_sql(struct cmsg *m)
 	int bind_count;
 	const char *sql;
 	uint32_t len;
+	int rc;
 
 	tx_fiber_init(msg->connection->session, msg->header.sync);
 
 	if (tx_check_schema(msg->header.schema_version))
 		goto error;
-	assert(msg->header.type == IPROTO_EXECUTE);
+	assert(msg->header.type == IPROTO_EXECUTE ||
+	       msg->header.type == IPROTO_PREPARE);
 	tx_inject_delay();
-	bind_count = sql_bind_list_decode(msg->sql.bind, &bind);
-	if (bind_count < 0)
-		goto error;
-	sql = msg->sql.sql_text;
-	sql = mp_decode_str(&sql, &len);
-	if (sql_prepare_and_execute(sql, len, bind, bind_count, &response,
-				    &fiber()->gc) != 0)
-		goto error;
+	if (msg->header.type == IPROTO_PREPARE) {
+		if (msg->sql.sql_text == NULL) {
+			diag_set(ClientError, ER_MISSING_REQUEST_FIELD,
+				 iproto_key_name(IPROTO_SQL_TEXT));
+			goto error;
+		}
+		sql = msg->sql.sql_text;
+		sql = mp_decode_str(&sql, &len);
+		if (sql_prepare(sql, len, &response) != 0)
+			goto error;
+	} else {
+		bind_count = sql_bind_list_decode(msg->sql.bind, &bind);
+		if (bind_count < 0)
+			goto error;
+		if (msg->sql.sql_text != NULL) {
+			sql = msg->sql.sql_text;
+			sql = mp_decode_str(&sql, &len);
+			rc = sql_prepare_and_execute(sql, len, bind,
+						     bind_count,
+						     msg->sql.chunk_size,
+						     &response, &fiber()->gc);
+		} else {
+			rc = sql_execute_prepared(msg->sql.stmt_id, bind,
+						  bind_count,
+						  msg->sql.chunk_size,
+						  &response, &fiber()->gc);
+		}
+		if (rc != 0)
+			goto error;
+	}
 	/*
 	 * Take an obuf only after execute(). Else the buffer can
 	 * become out of date during yield.
@@ -1643,17 +2113,27 @@ tx_process_sql(struct cmsg *m)
 	out = msg->connection->tx.p_obuf;
 	struct obuf_svp header_svp;
 	/* Prepare memory for the iproto header. */
-	if (iproto_prepare_header(out, &header_svp, IPROTO_HEADER_LEN) != 0)
+	if (iproto_prepare_header(out, &header_svp, IPROTO_HEADER_LEN) != 0) {
+		sql_response_destroy(&response);
 		goto error;
-	if (sql_response_dump(&response, out) != 0) {
+	}
+	if (msg->header.type == IPROTO_PREPARE)
+		rc = sql_prepare_response_dump(&response, out);
+	else
+		rc = sql_response_dump(&response, out);
+	if (rc != 0) {
 		obuf_rollback_to_svp(out, &header_svp);
 		goto error;
 	}
 	iproto_reply_sql(out, &header_svp, msg->header.sync, schema_version);
+	if (tx_compress_reply(msg, out, &header_svp) != 0)
+		goto error;
 	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg);
 	return;
 error:
 	tx_reply_error(msg);
+	tx_end_msg(msg);
 }
 
 static void
@@ -1664,6 +2144,7 @@ tx_process_join_subscribe(struct cmsg *m)
 	try {
 		switch (msg->header.type) {
 		case IPROTO_JOIN:
+		case IPROTO_FETCH_SNAPSHOT:
 			/*
 			 * As soon as box_process_subscribe() returns
 			 * the lambda in the beginning of the block
@@ -1671,6 +2152,10 @@ tx_process_join_subscribe(struct cmsg *m)
 			 */
 			box_process_join(&con->input, &msg->header);
 			break;
+		case IPROTO_REGISTER:
+			/* Same as JOIN, but only one response. */
+			box_process_register(&con->input, &msg->header);
+			break;
 		case IPROTO_SUBSCRIBE:
 			/*
 			 * Subscribe never returns - unless there
@@ -1680,6 +2165,10 @@ tx_process_join_subscribe(struct cmsg *m)
 			 */
 			box_process_subscribe(&con->input, &msg->header);
 			break;
+		case IPROTO_CDC_SUBSCRIBE:
+			/* Never returns unless there is an error. */
+			box_process_cdc_subscribe(&con->input, &msg->header);
+			break;
 		default:
 			unreachable();
 		}
@@ -1696,6 +2185,7 @@ net_send_msg(struct cmsg *m)
 {
 	struct iproto_msg *msg = (struct iproto_msg *) m;
 	struct iproto_connection *con = msg->connection;
+	PROBE1(iproto_reply, msg->header.sync);
 
 	if (msg->len != 0) {
 		/* Discard request (see iproto_enqueue_batch()). */
@@ -1705,6 +2195,8 @@ net_send_msg(struct cmsg *m)
 		assert(con->long_poll_count > 0);
 		con->long_poll_count--;
 	}
+	if (msg->zc_chunk != NULL)
+		rlist_add_tail_entry(&con->zc_chunks, msg->zc_chunk, in_net);
 	con->wend = msg->wpos;
 
 	if (evio_has_fd(&con->output)) {
@@ -1790,6 +2282,8 @@ tx_process_connect(struct cmsg *m)
 				diag_raise();
 		}
 		iproto_wpos_create(&msg->wpos, out);
+		latency_collect(&tx_connect_latency,
+				clock_monotonic() - msg->enqueue_time);
 	} catch (Exception *e) {
 		tx_reply_error(msg);
 		msg->close_connection = true;
@@ -1812,7 +2306,8 @@ net_send_greeting(struct cmsg *m)
 
 		if (nwr > 0) {
 			/* Count statistics. */
-			rmean_collect(rmean_net, IPROTO_SENT, nwr);
+			rmean_collect(con->iproto_thread->rmean, IPROTO_SENT,
+				      nwr);
 		} else if (nwr < 0 && ! sio_wouldblock(errno)) {
 			diag_log();
 		}
@@ -1833,24 +2328,22 @@ net_send_greeting(struct cmsg *m)
 	iproto_msg_delete(msg);
 }
 
-static const struct cmsg_hop connect_route[] = {
-	{ tx_process_connect, &net_pipe },
-	{ net_send_greeting, NULL },
-};
-
 /** }}} */
 
 /**
  * Create a connection and start input.
  */
 static int
-iproto_on_accept(struct evio_service * /* service */, int fd,
+iproto_on_accept(struct evio_service *service, int fd,
 		 struct sockaddr *addr, socklen_t addrlen)
 {
 	(void) addr;
 	(void) addrlen;
+	struct iproto_thread *iproto_thread =
+		(struct iproto_thread *) service->on_accept_param;
 	struct iproto_msg *msg;
-	struct iproto_connection *con = iproto_connection_new(fd);
+	struct iproto_connection *con =
+		iproto_connection_new(iproto_thread, fd);
 	if (con == NULL)
 		return -1;
 	/*
@@ -1860,62 +2353,96 @@ iproto_on_accept(struct evio_service * /* service */, int fd,
 	 */
 	msg = iproto_msg_new(con);
 	if (msg == NULL) {
-		mempool_free(&iproto_connection_pool, con);
+		mempool_free(&iproto_thread->iproto_connection_pool, con);
 		return -1;
 	}
-	cmsg_init(&msg->base, connect_route);
+	cmsg_init(&msg->base, iproto_thread->connect_route);
 	msg->p_ibuf = con->p_ibuf;
 	msg->wpos = con->wpos;
 	msg->close_connection = false;
-	cpipe_push(&tx_pipe, &msg->base);
+	msg->enqueue_time = clock_monotonic();
+	cpipe_push(&iproto_thread->tx_pipe, &msg->base);
 	return 0;
 }
 
-static struct evio_service binary; /* iproto binary listener */
+/**
+ * Name of the cbus endpoint of a network thread. The first
+ * thread keeps the name it had when there was only one.
+ */
+static const char *
+iproto_thread_endpoint_name(struct iproto_thread *iproto_thread)
+{
+	if (iproto_thread->id == 0)
+		return "net";
+	return tt_sprintf("net%d", iproto_thread->id);
+}
+
+/**
+ * Stop accepting connections in a network thread: let go of
+ * the socket shared with the first thread or close the one
+ * the thread owns.
+ */
+static void
+iproto_thread_stop_listen(struct iproto_thread *iproto_thread)
+{
+	struct evio_service *binary = &iproto_thread->binary;
+	if (binary->is_attached)
+		evio_service_detach(binary);
+	else if (evio_service_is_active(binary))
+		evio_service_stop(binary);
+}
+
 
 /**
  * The network io thread main function:
  * begin serving the message bus.
  */
 static int
-net_cord_f(va_list /* ap */)
+net_cord_f(va_list ap)
 {
-	mempool_create(&iproto_msg_pool, &cord()->slabc,
+	struct iproto_thread *iproto_thread =
+		va_arg(ap, struct iproto_thread *);
+
+	mempool_create(&iproto_thread->iproto_msg_pool, &cord()->slabc,
 		       sizeof(struct iproto_msg));
-	mempool_create(&iproto_connection_pool, &cord()->slabc,
+	mempool_create(&iproto_thread->iproto_connection_pool, &cord()->slabc,
 		       sizeof(struct iproto_connection));
 
-	evio_service_init(loop(), &binary, "binary",
-			  iproto_on_accept, NULL);
+	evio_service_init(loop(), &iproto_thread->binary, "binary",
+			  iproto_on_accept, iproto_thread);
 
 
 	/* Init statistics counter */
-	rmean_net = rmean_new(rmean_net_strings, IPROTO_LAST);
+	iproto_thread->rmean = rmean_new(rmean_net_strings, IPROTO_LAST);
 
-	if (rmean_net == NULL) {
+	if (iproto_thread->rmean == NULL) {
 		tnt_raise(OutOfMemory, sizeof(struct rmean),
 			  "rmean", "struct rmean");
 	}
 
 	struct cbus_endpoint endpoint;
 	/* Create "net" endpoint. */
-	cbus_endpoint_create(&endpoint, "net", fiber_schedule_cb, fiber());
+	cbus_endpoint_create(&endpoint,
+			     iproto_thread_endpoint_name(iproto_thread),
+			     fiber_schedule_cb, fiber());
 	/* Create a pipe to "tx" thread. */
-	cpipe_create(&tx_pipe, "tx");
-	cpipe_set_max_input(&tx_pipe, iproto_msg_max / 2);
+	cpipe_create(&iproto_thread->tx_pipe, "tx");
+	cpipe_set_max_input(&iproto_thread->tx_pipe, iproto_msg_max / 2);
+	cpipe_create(&iproto_thread->tx_high_pipe, "tx_high");
+	cpipe_set_max_input(&iproto_thread->tx_high_pipe, iproto_msg_max / 2);
 	/* Process incomming messages. */
 	cbus_loop(&endpoint);
 
-	cpipe_destroy(&tx_pipe);
+	cpipe_destroy(&iproto_thread->tx_high_pipe);
+	cpipe_destroy(&iproto_thread->tx_pipe);
 	/*
 	 * Nothing to do in the fiber so far, the service
 	 * will take care of creating events for incoming
 	 * connections.
 	 */
-	if (evio_service_is_active(&binary))
-		evio_service_stop(&binary);
+	iproto_thread_stop_listen(iproto_thread);
 
-	rmean_delete(rmean_net);
+	rmean_delete(iproto_thread->rmean);
 	return 0;
 }
 
@@ -1957,11 +2484,12 @@ static void
 tx_begin_push(struct iproto_connection *con)
 {
 	assert(! con->tx.is_push_sent);
-	cmsg_init(&con->kharon.base, push_route);
+	cmsg_init(&con->kharon.base, con->iproto_thread->push_route);
 	iproto_wpos_create(&con->kharon.wpos, con->tx.p_obuf);
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = true;
-	cpipe_push(&net_pipe, (struct cmsg *) &con->kharon);
+	cpipe_push(&con->iproto_thread->net_pipe,
+		   (struct cmsg *) &con->kharon);
 }
 
 static void
@@ -2009,30 +2537,121 @@ iproto_session_push(struct session *session, uint64_t sync, struct port *port)
 
 /** }}} */
 
-/** Initialize the iproto subsystem and start network io thread */
-void
-iproto_init()
+static inline void
+iproto_route_create(struct cmsg_hop *route, cmsg_f first, struct cpipe *pipe,
+		    cmsg_f second)
 {
-	slab_cache_create(&net_slabc, &runtime);
+	route[0].f = first;
+	route[0].pipe = pipe;
+	route[1].f = second;
+	route[1].pipe = NULL;
+}
 
-	if (cord_costart(&net_cord, "iproto", net_cord_f, NULL))
-		panic("failed to initialize iproto thread");
+/** Fill routes of a network thread, see struct iproto_thread. */
+static void
+iproto_thread_init_routes(struct iproto_thread *iproto_thread)
+{
+	struct cpipe *net_pipe = &iproto_thread->net_pipe;
+	iproto_route_create(iproto_thread->destroy_route,
+			    tx_process_destroy, net_pipe, net_finish_destroy);
+	iproto_route_create(iproto_thread->push_route, iproto_process_push,
+			    &iproto_thread->tx_pipe, tx_end_push);
+	iproto_route_create(iproto_thread->misc_route,
+			    tx_process_misc, net_pipe, net_send_msg);
+	iproto_route_create(iproto_thread->call_route,
+			    tx_process_call, net_pipe, net_send_msg);
+	iproto_route_create(iproto_thread->select_route,
+			    tx_process_select, net_pipe, net_send_msg);
+	iproto_route_create(iproto_thread->process1_route,
+			    tx_process1, net_pipe, net_send_msg);
+	iproto_route_create(iproto_thread->sql_route,
+			    tx_process_sql, net_pipe, net_send_msg);
+	iproto_route_create(iproto_thread->join_route,
+			    tx_process_join_subscribe, net_pipe, net_end_join);
+	iproto_route_create(iproto_thread->subscribe_route,
+			    tx_process_join_subscribe, net_pipe,
+			    net_end_subscribe);
+	iproto_route_create(iproto_thread->error_route,
+			    tx_reply_iproto_error, net_pipe, net_send_error);
+	iproto_route_create(iproto_thread->connect_route,
+			    tx_process_connect, net_pipe, net_send_greeting);
+
+	const struct cmsg_hop **dml_route = iproto_thread->dml_route;
+	memset(dml_route, 0, sizeof(iproto_thread->dml_route));
+	dml_route[IPROTO_SELECT] = iproto_thread->select_route;
+	dml_route[IPROTO_INSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_REPLACE] = iproto_thread->process1_route;
+	dml_route[IPROTO_UPDATE] = iproto_thread->process1_route;
+	dml_route[IPROTO_DELETE] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL_16] = iproto_thread->call_route;
+	dml_route[IPROTO_AUTH] = iproto_thread->misc_route;
+	dml_route[IPROTO_EVAL] = iproto_thread->call_route;
+	dml_route[IPROTO_UPSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL] = iproto_thread->call_route;
+	dml_route[IPROTO_EXECUTE] = iproto_thread->sql_route;
+	dml_route[IPROTO_PREPARE] = iproto_thread->sql_route;
+}
 
-	/* Create a pipe to "net" thread. */
-	cpipe_create(&net_pipe, "net");
-	cpipe_set_max_input(&net_pipe, iproto_msg_max / 2);
+/** Initialize the iproto subsystem and start network io threads */
+void
+iproto_init(int threads_count)
+{
+	assert(threads_count >= 1 && threads_count <= IPROTO_THREADS_MAX);
+	iproto_threads = (struct iproto_thread *)
+		calloc(threads_count, sizeof(*iproto_threads));
+	if (iproto_threads == NULL)
+		panic("failed to allocate iproto threads");
+	iproto_threads_count = threads_count;
+
+	for (int i = 0; i < threads_count; i++) {
+		struct iproto_thread *iproto_thread = &iproto_threads[i];
+		iproto_thread->id = i;
+		rlist_create(&iproto_thread->stopped_connections);
+		iproto_thread_init_routes(iproto_thread);
+		slab_cache_create(&iproto_thread->net_slabc, &runtime);
+
+		const char *name = i == 0 ? "iproto" :
+				   tt_sprintf("iproto%d", i);
+		if (cord_costart(&iproto_thread->net_cord, name,
+				 net_cord_f, iproto_thread))
+			panic("failed to initialize iproto thread");
+
+		/* Create a pipe to "net" thread. */
+		cpipe_create(&iproto_thread->net_pipe,
+			     iproto_thread_endpoint_name(iproto_thread));
+		cpipe_set_max_input(&iproto_thread->net_pipe,
+				    iproto_msg_max / 2);
+	}
 	struct session_vtab iproto_session_vtab = {
 		/* .push = */ iproto_session_push,
 		/* .fd = */ iproto_session_fd,
 		/* .sync = */ iproto_session_sync,
 	};
 	session_vtab_registry[SESSION_TYPE_BINARY] = iproto_session_vtab;
+
+	for (int i = 0; i < IPROTO_TYPE_STAT_MAX; i++) {
+		struct tx_latency *latency = &tx_latency[i];
+		if (latency_create(&latency->queue) != 0 ||
+		    latency_create(&latency->exec) != 0 ||
+		    latency_create(&latency->wal) != 0)
+			panic("failed to allocate request latency histograms");
+	}
+	if (latency_create(&tx_connect_latency) != 0)
+		panic("failed to allocate request latency histograms");
 }
 
 /** Available iproto configuration changes. */
 enum iproto_cfg_op {
 	IPROTO_CFG_MSG_MAX,
-	IPROTO_CFG_LISTEN
+	IPROTO_CFG_LISTEN,
+	/**
+	 * Start accepting on the address the first thread is
+	 * bound to: with an own SO_REUSEPORT socket if possible,
+	 * otherwise on the socket of the first thread.
+	 */
+	IPROTO_CFG_ATTACH,
+	/** Stop accepting and close the socket if it is owned. */
+	IPROTO_CFG_DETACH,
 };
 
 /**
@@ -2045,12 +2664,17 @@ struct iproto_cfg_msg: public cbus_call_msg
 {
 	/** Operation to execute in iproto thread. */
 	enum iproto_cfg_op op;
+	/** Thread to execute the operation in. */
+	struct iproto_thread *iproto_thread;
 	union {
 		/** New URI to bind to. */
 		const char *uri;
 
 		/** New iproto max message count. */
 		int iproto_msg_max;
+
+		/** Listener to attach to. */
+		const struct evio_service *binary;
 	};
 };
 
@@ -2065,25 +2689,56 @@ static int
 iproto_do_cfg_f(struct cbus_call_msg *m)
 {
 	struct iproto_cfg_msg *cfg_msg = (struct iproto_cfg_msg *) m;
-	int old;
+	struct iproto_thread *iproto_thread = cfg_msg->iproto_thread;
+	struct evio_service *binary = &iproto_thread->binary;
 	try {
 		switch (cfg_msg->op) {
 		case IPROTO_CFG_MSG_MAX:
-			cpipe_set_max_input(&tx_pipe,
+			cpipe_set_max_input(&iproto_thread->tx_pipe,
+					    cfg_msg->iproto_msg_max / 2);
+			cpipe_set_max_input(&iproto_thread->tx_high_pipe,
 					    cfg_msg->iproto_msg_max / 2);
-			old = iproto_msg_max;
+			/*
+			 * The limit is shared by all threads, so
+			 * the first one to get here would hide an
+			 * increase from the rest. Resuming is a
+			 * no-op if the limit is still exhausted.
+			 */
 			iproto_msg_max = cfg_msg->iproto_msg_max;
-			if (old < iproto_msg_max)
-				iproto_resume();
+			iproto_resume(iproto_thread);
 			break;
 		case IPROTO_CFG_LISTEN:
-			if (evio_service_is_active(&binary))
-				evio_service_stop(&binary);
+			if (evio_service_is_active(binary))
+				evio_service_stop(binary);
+			/* Let the other threads bind the same port. */
+			binary->reuse_port = iproto_threads_count > 1;
 			if (cfg_msg->uri != NULL &&
-			    (evio_service_bind(&binary, cfg_msg->uri) != 0 ||
-			     evio_service_listen(&binary) != 0))
+			    (evio_service_bind(binary, cfg_msg->uri) != 0 ||
+			     evio_service_listen(binary) != 0))
 				diag_raise();
 			break;
+		case IPROTO_CFG_ATTACH:
+			if (cfg_msg->binary->reuse_port &&
+			    cfg_msg->binary->addr.sa_family != AF_UNIX) {
+				/*
+				 * The kernel balances connections
+				 * between SO_REUSEPORT sockets, so
+				 * threads don't wake up on the same
+				 * accept.
+				 */
+				if (evio_service_bind_reuseport(binary,
+						cfg_msg->binary) == 0 &&
+				    evio_service_listen(binary) == 0)
+					break;
+				diag_log();
+				if (evio_service_is_active(binary))
+					evio_service_stop(binary);
+			}
+			evio_service_attach(binary, cfg_msg->binary);
+			break;
+		case IPROTO_CFG_DETACH:
+			iproto_thread_stop_listen(iproto_thread);
+			break;
 		default:
 			unreachable();
 		}
@@ -2094,10 +2749,11 @@ iproto_do_cfg_f(struct cbus_call_msg *m)
 }
 
 static inline void
-iproto_do_cfg(struct iproto_cfg_msg *msg)
+iproto_do_cfg(struct iproto_thread *iproto_thread, struct iproto_cfg_msg *msg)
 {
-	if (cbus_call(&net_pipe, &tx_pipe, msg, iproto_do_cfg_f,
-		      NULL, TIMEOUT_INFINITY) != 0)
+	msg->iproto_thread = iproto_thread;
+	if (cbus_call(&iproto_thread->net_pipe, &iproto_thread->tx_pipe, msg,
+		      iproto_do_cfg_f, NULL, TIMEOUT_INFINITY) != 0)
 		diag_raise();
 }
 
@@ -2105,21 +2761,108 @@ void
 iproto_listen(const char *uri)
 {
 	struct iproto_cfg_msg cfg_msg;
+	/*
+	 * The first thread binds the URI. The others must let
+	 * go of their sockets before it is rebound and then
+	 * listen on the same address, see IPROTO_CFG_ATTACH.
+	 */
+	for (int i = 1; i < iproto_threads_count; i++) {
+		iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_DETACH);
+		iproto_do_cfg(&iproto_threads[i], &cfg_msg);
+	}
 	iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_LISTEN);
 	cfg_msg.uri = uri;
-	iproto_do_cfg(&cfg_msg);
+	iproto_do_cfg(&iproto_threads[0], &cfg_msg);
+	if (uri == NULL)
+		return;
+	for (int i = 1; i < iproto_threads_count; i++) {
+		iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_ATTACH);
+		cfg_msg.binary = &iproto_threads[0].binary;
+		iproto_do_cfg(&iproto_threads[i], &cfg_msg);
+	}
 }
 
 size_t
 iproto_mem_used(void)
 {
-	return slab_cache_used(&net_cord.slabc) + slab_cache_used(&net_slabc);
+	size_t mem = 0;
+	for (int i = 0; i < iproto_threads_count; i++) {
+		struct iproto_thread *iproto_thread = &iproto_threads[i];
+		mem += slab_cache_used(&iproto_thread->net_cord.slabc) +
+		       slab_cache_used(&iproto_thread->net_slabc);
+	}
+	return mem;
 }
 
 void
 iproto_reset_stat(void)
 {
-	rmean_cleanup(rmean_net);
+	for (int i = 0; i < iproto_threads_count; i++)
+		rmean_cleanup(iproto_threads[i].rmean);
+	for (int i = 0; i < IPROTO_TYPE_STAT_MAX; i++) {
+		struct tx_latency *latency = &tx_latency[i];
+		latency_reset(&latency->queue);
+		latency_reset(&latency->exec);
+		latency_reset(&latency->wal);
+	}
+	latency_reset(&tx_connect_latency);
+}
+
+static void
+iproto_latency_stat_one(struct info_handler *h, const char *name,
+			struct latency *latency)
+{
+	info_table_begin(h, name);
+	for (int i = 0; i < (int)lengthof(tx_latency_permille); i++) {
+		info_append_double(h, tx_latency_permille_strs[i],
+				   latency_get_permille(latency,
+							tx_latency_permille[i]));
+	}
+	info_table_end(h);
+}
+
+void
+iproto_latency_stat(struct info_handler *h)
+{
+	info_begin(h);
+	for (int type = 0; type < IPROTO_TYPE_STAT_MAX; type++) {
+		if (iproto_type_strs[type] == NULL)
+			continue;
+		struct tx_latency *latency = &tx_latency[type];
+		info_table_begin(h, iproto_type_strs[type]);
+		iproto_latency_stat_one(h, "queue", &latency->queue);
+		iproto_latency_stat_one(h, "exec", &latency->exec);
+		iproto_latency_stat_one(h, "wal", &latency->wal);
+		info_table_end(h);
+	}
+	info_table_begin(h, "CONNECT");
+	iproto_latency_stat_one(h, "queue", &tx_connect_latency);
+	info_table_end(h);
+	info_end(h);
+}
+
+int
+iproto_rmean_foreach(rmean_cb cb, void *cb_ctx)
+{
+	for (size_t name = 0; name < IPROTO_LAST; name++) {
+		int64_t rps = 0;
+		int64_t total = 0;
+		for (int i = 0; i < iproto_threads_count; i++) {
+			struct rmean *rmean = iproto_threads[i].rmean;
+			rps += rmean_mean(rmean, name);
+			total += rmean_total(rmean, name);
+		}
+		int rc = cb(rmean_net_strings[name], rps, total, cb_ctx);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
+void
+iproto_set_zero_copy_threshold(size_t threshold)
+{
+	iproto_zero_copy_threshold = threshold;
 }
 
 void
@@ -2131,8 +2874,12 @@ iproto_set_msg_max(int new_iproto_msg_max)
 				     IPROTO_MSG_MAX_MIN));
 	}
 	struct iproto_cfg_msg cfg_msg;
-	iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_MSG_MAX);
-	cfg_msg.iproto_msg_max = new_iproto_msg_max;
-	iproto_do_cfg(&cfg_msg);
-	cpipe_set_max_input(&net_pipe, new_iproto_msg_max / 2);
+	for (int i = 0; i < iproto_threads_count; i++) {
+		struct iproto_thread *iproto_thread = &iproto_threads[i];
+		iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_MSG_MAX);
+		cfg_msg.iproto_msg_max = new_iproto_msg_max;
+		iproto_do_cfg(iproto_thread, &cfg_msg);
+		cpipe_set_max_input(&iproto_thread->net_pipe,
+				    new_iproto_msg_max / 2);
+	}
 }
@@ -33,6 +33,10 @@
 
 #include <stddef.h>
 
+#include "rmean.h"
+
+struct info_handler;
+
 #if defined(__cplusplus)
 extern "C" {
 #endif /* defined(__cplusplus) */
@@ -50,8 +54,17 @@ enum {
 	 * short-living requests, all requests are handled by the
 	 * same pool. When the pool size is exhausted, message
 	 * processing stops until some new fibers are freed up.
+	 * Since net_msg_max limits messages of each network
+	 * thread, the pool size is multiplied by the number of
+	 * threads as well.
 	 */
 	IPROTO_FIBER_POOL_SIZE_FACTOR = 5,
+	/**
+	 * The maximal number of iproto threads. Each thread
+	 * gets its own net_msg_max share of the tx fiber pool,
+	 * so the limit keeps the pool size sane.
+	 */
+	IPROTO_THREADS_MAX = 64,
 };
 
 extern unsigned iproto_readahead;
@@ -68,11 +81,32 @@ iproto_mem_used(void);
 void
 iproto_reset_stat(void);
 
+/**
+ * Invoke @a cb for each network statistics counter, summed up
+ * over all network threads.
+ */
+int
+iproto_rmean_foreach(rmean_cb cb, void *cb_ctx);
+
+/**
+ * Dump percentiles of request latency by request type:
+ * time spent in the tx queue, processing time in tx and
+ * time spent waiting for WAL. CONNECT.queue is the time from
+ * accepting a connection to handshaking it in tx. Must be
+ * called from tx.
+ */
+void
+iproto_latency_stat(struct info_handler *h);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 
+/**
+ * Initialize the iproto subsystem and start @a threads_count
+ * network threads.
+ */
 void
-iproto_init();
+iproto_init(int threads_count);
 
 void
 iproto_listen(const char *uri);
@@ -80,6 +114,14 @@ iproto_listen(const char *uri);
 void
 iproto_set_msg_max(int iproto_msg_max);
 
+/**
+ * Send select responses of at least @a threshold bytes
+ * directly from tuple memory rather than copy them to
+ * the connection output buffer. 0 disables this.
+ */
+void
+iproto_set_zero_copy_threshold(size_t threshold);
+
 #endif /* defined(__cplusplus) */
 
 #endif
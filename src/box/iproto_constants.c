@@ -41,11 +41,11 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 		/* 0x05 */	MP_UINT,   /* IPROTO_SCHEMA_VERSION */
 		/* 0x06 */	MP_UINT,   /* IPROTO_SERVER_VERSION */
 		/* 0x07 */	MP_UINT,   /* IPROTO_GROUP_ID */
+		/* 0x08 */	MP_UINT,   /* IPROTO_PRIORITY */
+		/* 0x09 */	MP_MAP,    /* IPROTO_WAIT_VCLOCK */
 	/* }}} */
 
 	/* {{{ unused */
-		/* 0x08 */	MP_UINT,
-		/* 0x09 */	MP_UINT,
 		/* 0x0a */	MP_UINT,
 		/* 0x0b */	MP_UINT,
 		/* 0x0c */	MP_UINT,
@@ -89,6 +89,10 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 	/* 0x29 */	MP_MAP, /* IPROTO_BALLOT */
 	/* 0x2a */	MP_MAP, /* IPROTO_TUPLE_META */
 	/* 0x2b */	MP_MAP, /* IPROTO_OPTIONS */
+	/* 0x2c */	MP_BOOL, /* IPROTO_COMPRESSION */
+	/* 0x2d */	MP_ARRAY, /* IPROTO_SPACE_IDS */
+	/* 0x2e */	MP_ARRAY, /* IPROTO_FIELDS */
+	/* 0x2f */	MP_BOOL, /* IPROTO_REPLICA_ANON */
 	/* }}} */
 };
 
@@ -107,6 +111,7 @@ const char *iproto_type_strs[] =
 	"CALL",
 	"EXECUTE",
 	NULL, /* NOP */
+	"PREPARE",
 };
 
 #define bit(c) (1ULL<<IPROTO_##c)
@@ -124,6 +129,7 @@ const uint64_t iproto_body_key_map[IPROTO_TYPE_STAT_MAX] = {
 	0,                                                     /* CALL */
 	0,                                                     /* EXECUTE */
 	0,                                                     /* NOP */
+	0,                                                     /* PREPARE */
 };
 #undef bit
 
@@ -136,8 +142,8 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"schema version",   /* 0x05 */
 	"server version",   /* 0x06 */
 	"group id",         /* 0x07 */
-	NULL,               /* 0x08 */
-	NULL,               /* 0x09 */
+	"priority",         /* 0x08 */
+	"wait vclock",      /* 0x09 */
 	NULL,               /* 0x0a */
 	NULL,               /* 0x0b */
 	NULL,               /* 0x0c */
@@ -172,16 +178,16 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"ballot",           /* 0x29 */
 	"tuple meta",       /* 0x2a */
 	"options",          /* 0x2b */
-	NULL,               /* 0x2c */
-	NULL,               /* 0x2d */
-	NULL,               /* 0x2e */
-	NULL,               /* 0x2f */
+	"compression",      /* 0x2c */
+	"space ids",        /* 0x2d */
+	"fields",           /* 0x2e */
+	"replica anon",     /* 0x2f */
 	"data",             /* 0x30 */
 	"error",            /* 0x31 */
 	"metadata",         /* 0x32 */
-	NULL,               /* 0x33 */
-	NULL,               /* 0x34 */
-	NULL,               /* 0x35 */
+	"bind meta",        /* 0x33 */
+	"bind count",       /* 0x34 */
+	"compressed body",  /* 0x35 */
 	NULL,               /* 0x36 */
 	NULL,               /* 0x37 */
 	NULL,               /* 0x38 */
@@ -195,6 +201,7 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"SQL text",         /* 0x40 */
 	"SQL bind",         /* 0x41 */
 	"SQL info",         /* 0x42 */
+	"stmt id",          /* 0x43 */
 };
 
 const char *vy_page_info_key_strs[VY_PAGE_INFO_KEY_MAX] = {
@@ -204,7 +211,11 @@ const char *vy_page_info_key_strs[VY_PAGE_INFO_KEY_MAX] = {
 	"unpacked size",
 	"row count",
 	"min key",
-	"row index offset"
+	"row index offset",
+	"version",
+	"restart interval",
+	"rows size",
+	"zone map",
 };
 
 const char *vy_run_info_key_strs[VY_RUN_INFO_KEY_MAX] = {
@@ -217,9 +228,17 @@ const char *vy_run_info_key_strs[VY_RUN_INFO_KEY_MAX] = {
 	"bloom filter legacy",
 	"bloom filter",
 	"stmt stat",
+	"blobs",
+	"bloom filter split block",
+	"zstd dict",
 };
 
 const char *vy_row_index_key_strs[VY_ROW_INDEX_KEY_MAX] = {
 	NULL,
 	"row index",
 };
+
+const char *vy_columns_key_strs[VY_COLUMNS_KEY_MAX] = {
+	NULL,
+	"columns",
+};
@@ -60,6 +60,18 @@ enum iproto_key {
 	IPROTO_SCHEMA_VERSION = 0x05,
 	IPROTO_SERVER_VERSION = 0x06,
 	IPROTO_GROUP_ID = 0x07,
+	/**
+	 * Request priority lane, 0 is the default bulk lane.
+	 * A request with a non-zero value is queued to tx
+	 * separately, so it doesn't wait behind bulk requests.
+	 */
+	IPROTO_PRIORITY = 0x08,
+	/**
+	 * Vclock to wait for before executing a read request,
+	 * so that a client can read its own writes from a
+	 * replica.
+	 */
+	IPROTO_WAIT_VCLOCK = 0x09,
 	/* Leave a gap for other keys in the header. */
 	IPROTO_SPACE_ID = 0x10,
 	IPROTO_INDEX_ID = 0x11,
@@ -91,6 +103,20 @@ enum iproto_key {
 	IPROTO_BALLOT = 0x29,
 	IPROTO_TUPLE_META = 0x2a,
 	IPROTO_OPTIONS = 0x2b,
+	/**
+	 * Request to compress the replication stream, or the
+	 * compression threshold in IPROTO_COMPRESS.
+	 */
+	IPROTO_COMPRESSION = 0x2c,
+	/** Ids of spaces to send in CDC_SUBSCRIBE. */
+	IPROTO_SPACE_IDS = 0x2d,
+	/** Numbers of tuple fields to send in CDC_SUBSCRIBE. */
+	IPROTO_FIELDS = 0x2e,
+	/**
+	 * Set in SUBSCRIBE of an anonymous replica, which isn't
+	 * registered in _cluster.
+	 */
+	IPROTO_REPLICA_ANON = 0x2f,
 
 	/* Leave a gap between request keys and response keys */
 	IPROTO_DATA = 0x30,
@@ -103,6 +129,22 @@ enum iproto_key {
 	 * ]
 	 */
 	IPROTO_METADATA = 0x32,
+	/**
+	 * IPROTO_BIND_METADATA: [
+	 *      { IPROTO_FIELD_NAME: parameter name },
+	 *      { ... },
+	 *      ...
+	 * ]
+	 */
+	IPROTO_BIND_METADATA = 0x33,
+	IPROTO_BIND_COUNT = 0x34,
+	/**
+	 * A response body compressed with zstd, sent instead of
+	 * the original body to a client that requested
+	 * IPROTO_COMPRESS.
+	 * The body is { IPROTO_COMPRESSED_BODY: bin }.
+	 */
+	IPROTO_COMPRESSED_BODY = 0x35,
 
 	/* Leave a gap between response keys and SQL keys. */
 	IPROTO_SQL_TEXT = 0x40,
@@ -113,6 +155,8 @@ enum iproto_key {
 	 * }
 	 */
 	IPROTO_SQL_INFO = 0x42,
+	/** Id of a statement compiled with PREPARE. */
+	IPROTO_STMT_ID = 0x43,
 	IPROTO_KEY_MAX
 };
 
@@ -126,10 +170,20 @@ enum iproto_metadata_key {
 	IPROTO_FIELD_TYPE = 1,
 };
 
+/** Keys of IPROTO_OPTIONS map of an EXECUTE request. */
+enum iproto_sql_option_key {
+	/**
+	 * Send the rows of a result set in IPROTO_CHUNK pushes
+	 * of this many rows each, ahead of the final response.
+	 */
+	IPROTO_SQL_OPT_CHUNK_SIZE = 0,
+};
+
 enum iproto_ballot_key {
 	IPROTO_BALLOT_IS_RO = 0x01,
 	IPROTO_BALLOT_VCLOCK = 0x02,
 	IPROTO_BALLOT_GC_VCLOCK = 0x03,
+	IPROTO_BALLOT_RELAY_COUNT = 0x04,
 };
 
 #define bit(c) (1ULL<<IPROTO_##c)
@@ -195,6 +249,8 @@ enum iproto_type {
 	IPROTO_EXECUTE = 11,
 	/** No operation. Treated as DML, used to bump LSN. */
 	IPROTO_NOP = 12,
+	/** Compile an SQL statement and cache it. */
+	IPROTO_PREPARE = 13,
 	/** The maximum typecode used for box.stat() */
 	IPROTO_TYPE_STAT_MAX,
 
@@ -208,6 +264,49 @@ enum iproto_type {
 	IPROTO_VOTE_DEPRECATED = 67,
 	/** Vote request command for master election */
 	IPROTO_VOTE = 68,
+	/**
+	 * A batch of replication rows compressed with zstd,
+	 * sent instead of plain rows if the replica requested
+	 * IPROTO_COMPRESSION on JOIN or SUBSCRIBE. The body
+	 * is { IPROTO_DATA: bin }, the binary data decompresses
+	 * to a sequence of rows, each prefixed with its length
+	 * as in the iproto stream.
+	 */
+	IPROTO_COMPRESSED_ROWS = 69,
+	/**
+	 * Enable compression of response bodies on the
+	 * connection. The body is { IPROTO_COMPRESSION: size },
+	 * responses with bodies not less than the size are
+	 * compressed, 0 disables compression.
+	 */
+	IPROTO_COMPRESS = 70,
+	/**
+	 * Subscribe to changes of the given spaces without
+	 * joining the replica set. The body is
+	 * { IPROTO_VCLOCK: start vclock,
+	 *   IPROTO_SPACE_IDS: [space id, ...],
+	 *   IPROTO_FIELDS: [field no, ...] }, both lists are
+	 * optional. Rows of other spaces are sent as IPROTO_NOP,
+	 * tuples are cut to the given fields. The consumer acks
+	 * received rows with its vclock as a replica does.
+	 */
+	IPROTO_CDC_SUBSCRIBE = 71,
+	/**
+	 * Same as JOIN, but doesn't register the replica in
+	 * _cluster: the initial and final data are sent, and
+	 * the replica is expected to SUBSCRIBE with
+	 * IPROTO_REPLICA_ANON after that.
+	 */
+	IPROTO_FETCH_SNAPSHOT = 72,
+	/**
+	 * Register a new replica in _cluster without sending
+	 * it any data. The body is { IPROTO_INSTANCE_UUID: uuid },
+	 * the response is { IPROTO_VCLOCK: vclock } - the vclock
+	 * of the master after the registration. The replica then
+	 * JOINs another replica, passing it this vclock to wait
+	 * for, and SUBSCRIBEs to the master afterwards.
+	 */
+	IPROTO_REGISTER = 73,
 
 	/** Vinyl run info stored in .index file */
 	VY_INDEX_RUN_INFO = 100,
@@ -215,6 +314,14 @@ enum iproto_type {
 	VY_INDEX_PAGE_INFO = 101,
 	/** Vinyl row index stored in .run file */
 	VY_RUN_ROW_INDEX = 102,
+	/**
+	 * Memtx space not written to a delta .snap file, its
+	 * tuples are in the base snapshot. The body is
+	 * { IPROTO_SPACE_ID: uint }.
+	 */
+	MEMTX_SNAP_BASE_SPACE = 103,
+	/** Column chunks of a columnar vinyl run page. */
+	VY_RUN_COLUMNS = 104,
 
 	/** Non-final response type. */
 	IPROTO_CHUNK = 128,
@@ -252,6 +359,10 @@ iproto_type_name(uint32_t type)
 		return "PAGEINFO";
 	case VY_RUN_ROW_INDEX:
 		return "ROWINDEX";
+	case MEMTX_SNAP_BASE_SPACE:
+		return "BASESPACE";
+	case VY_RUN_COLUMNS:
+		return "COLUMNS";
 	default:
 		return NULL;
 	}
@@ -317,7 +428,9 @@ iproto_type_is_request(uint32_t type)
 static inline bool
 iproto_type_is_sync(uint32_t type)
 {
-	return type == IPROTO_JOIN || type == IPROTO_SUBSCRIBE;
+	return type == IPROTO_JOIN || type == IPROTO_SUBSCRIBE ||
+	       type == IPROTO_CDC_SUBSCRIBE ||
+	       type == IPROTO_FETCH_SNAPSHOT || type == IPROTO_REGISTER;
 }
 
 /** This is an error. */
@@ -353,10 +466,16 @@ enum vy_run_info_key {
 	VY_RUN_INFO_PAGE_COUNT = 5,
 	/** Legacy bloom filter implementation. */
 	VY_RUN_INFO_BLOOM_LEGACY = 6,
-	/** Bloom filter for keys. */
+	/** Bloom filter for keys, blocked layout. */
 	VY_RUN_INFO_BLOOM = 7,
 	/** Number of statements of each type (map). */
 	VY_RUN_INFO_STMT_STAT = 8,
+	/** Blob files referenced by the run (array). */
+	VY_RUN_INFO_BLOBS = 9,
+	/** Bloom filter for keys, split block layout. */
+	VY_RUN_INFO_BLOOM_SPLIT_BLOCK = 10,
+	/** Zstd dictionary the run pages are compressed with. */
+	VY_RUN_INFO_ZSTD_DICT = 11,
 	/** The last key in this enum + 1 */
 	VY_RUN_INFO_KEY_MAX
 };
@@ -391,6 +510,14 @@ enum vy_page_info_key {
 	VY_PAGE_INFO_MIN_KEY = 5,
 	/** Offset of the row index in the page. */
 	VY_PAGE_INFO_ROW_INDEX_OFFSET = 6,
+	/** Page format version, see enum vy_page_version. */
+	VY_PAGE_INFO_VERSION = 7,
+	/** Distance between full rows of a prefix-compressed page. */
+	VY_PAGE_INFO_RESTART_INTERVAL = 8,
+	/** Size of the rows restored from a columnar page. */
+	VY_PAGE_INFO_ROWS_SIZE = 9,
+	/** Min/max values of non-key fields stored in the page. */
+	VY_PAGE_INFO_ZONE_MAP = 10,
 	/** The last key in this enum + 1 */
 	VY_PAGE_INFO_KEY_MAX
 };
@@ -432,6 +559,30 @@ vy_row_index_key_name(enum vy_row_index_key key)
 	return vy_row_index_key_strs[key];
 }
 
+/**
+ * Xrow keys for column chunks of a Vinyl page.
+ * @sa VY_PAGE_VERSION_COLUMNAR.
+ */
+enum vy_columns_key {
+	/** Array of column chunks. */
+	VY_COLUMNS_DATA = 1,
+	/** The last key in this enum + 1 */
+	VY_COLUMNS_KEY_MAX
+};
+
+/**
+ * Return vy_columns key name by @a key code.
+ * @param key key
+ */
+static inline const char *
+vy_columns_key_name(enum vy_columns_key key)
+{
+	if (key <= 0 || key >= VY_COLUMNS_KEY_MAX)
+		return NULL;
+	extern const char *vy_columns_key_strs[];
+	return vy_columns_key_strs[key];
+}
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif
@@ -133,6 +133,8 @@ key_def_set_cmp(struct key_def *def)
 {
 	def->tuple_compare = tuple_compare_create(def);
 	def->tuple_compare_with_key = tuple_compare_with_key_create(def);
+	key_def_set_hint_func(def);
+	key_def_set_custom_compare_func(def);
 	tuple_hash_func_set(def);
 	tuple_extract_key_set(def);
 }
@@ -163,9 +165,14 @@ key_def_set_part(struct key_def *def, uint32_t part_no, uint32_t fieldno,
 		*path_pool += path_len;
 		memcpy(def->parts[part_no].path, path, path_len);
 		def->parts[part_no].path_len = path_len;
+		def->parts[part_no].multikey_path_len =
+			json_path_multikey_offset(path, path_len,
+						  TUPLE_INDEX_BASE);
+		def->is_multikey |= key_part_is_multikey(&def->parts[part_no]);
 	} else {
 		def->parts[part_no].path = NULL;
 		def->parts[part_no].path_len = 0;
+		def->parts[part_no].multikey_path_len = 0;
 	}
 	column_mask_set_fieldno(&def->column_mask, fieldno);
 }
@@ -321,7 +328,8 @@ void
 key_def_update_optionality(struct key_def *def, uint32_t min_field_count)
 {
 	def->has_optional_parts = false;
-	for (uint32_t i = 0; i < def->part_count; ++i) {
+	/* Fields of a functional key are never absent. */
+	for (uint32_t i = def->func_part_count; i < def->part_count; ++i) {
 		struct key_part *part = &def->parts[i];
 		def->has_optional_parts |=
 			(min_field_count < part->fieldno + 1 ||
@@ -336,6 +344,28 @@ key_def_update_optionality(struct key_def *def, uint32_t min_field_count)
 	key_def_set_cmp(def);
 }
 
+void
+key_def_set_func_index(struct key_def *def)
+{
+	def->func_part_count = def->part_count;
+	def->stored_part_count = def->part_count;
+	key_def_set_cmp(def);
+}
+
+void
+key_def_set_stored_key(struct key_def *def)
+{
+	def->stored_part_count = def->part_count;
+	key_def_set_cmp(def);
+}
+
+void
+key_def_set_wyhash(struct key_def *def)
+{
+	def->use_wyhash = true;
+	tuple_hash_func_set(def);
+}
+
 int
 key_def_snprint_parts(char *buf, int size, const struct key_part_def *parts,
 		      uint32_t part_count)
@@ -498,6 +528,52 @@ key_def_decode_parts_166(struct key_part_def *parts, uint32_t part_count,
 	return 0;
 }
 
+/**
+ * Check that the JSON path of a key part has no more than one
+ * [*] and, if it has one, the part indexes the same array as
+ * the preceding multikey parts.
+ */
+static int
+key_def_check_multikey_part(const struct key_part_def *parts,
+			    uint32_t part_no)
+{
+	const struct key_part_def *part = &parts[part_no];
+	int path_len = strlen(part->path);
+	int offset = json_path_multikey_offset(part->path, path_len,
+					       TUPLE_INDEX_BASE);
+	if (offset == path_len)
+		return 0;
+	const char *rest = part->path + offset + strlen("[*]");
+	int rest_len = path_len - offset - strlen("[*]");
+	if (json_path_multikey_offset(rest, rest_len,
+				      TUPLE_INDEX_BASE) != rest_len) {
+		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+			 part_no + TUPLE_INDEX_BASE,
+			 "no more than one array index placeholder [*] "
+			 "is allowed in JSON path");
+		return -1;
+	}
+	for (uint32_t i = 0; i < part_no; i++) {
+		const struct key_part_def *other = &parts[i];
+		if (other->path == NULL)
+			continue;
+		int other_len = strlen(other->path);
+		int other_offset = json_path_multikey_offset(other->path,
+						other_len, TUPLE_INDEX_BASE);
+		if (other_offset == other_len)
+			continue;
+		if (other->fieldno != part->fieldno ||
+		    json_path_cmp(part->path, offset, other->path,
+				  other_offset, TUPLE_INDEX_BASE) != 0) {
+			diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+				 part_no + TUPLE_INDEX_BASE,
+				 "incompatible multikey index path");
+			return -1;
+		}
+	}
+	return 0;
+}
+
 int
 key_def_decode_parts(struct key_part_def *parts, uint32_t part_count,
 		     const char **data, const struct field_def *fields,
@@ -583,6 +659,9 @@ key_def_decode_parts(struct key_part_def *parts, uint32_t part_count,
 				 i + TUPLE_INDEX_BASE, "invalid path");
 			return -1;
 		}
+		if (part->path != NULL &&
+		    key_def_check_multikey_part(parts, i) != 0)
+			return -1;
 	}
 	return 0;
 }
@@ -636,10 +715,15 @@ key_def_merge(const struct key_def *first, const struct key_def *second)
 	const struct key_part *end = part + first->part_count;
 	for (; part != end; part++)
 		sz += part->path_len;
+	/*
+	 * Parts of a functional key and parts of a tuple never
+	 * duplicate each other.
+	 */
+	bool is_for_func_index = first->func_part_count > 0;
 	part = second->parts;
 	end = part + second->part_count;
 	for (; part != end; part++) {
-		if (key_def_find(first, part) != NULL)
+		if (!is_for_func_index && key_def_find(first, part) != NULL)
 			--new_part_count;
 		else
 			sz += part->path_len;
@@ -657,6 +741,9 @@ key_def_merge(const struct key_def *first, const struct key_def *second)
 	new_def->is_nullable = first->is_nullable || second->is_nullable;
 	new_def->has_optional_parts = first->has_optional_parts ||
 				      second->has_optional_parts;
+	new_def->func_part_count = first->func_part_count;
+	new_def->stored_part_count = first->stored_part_count;
+	new_def->use_wyhash = first->use_wyhash;
 
 	/* JSON paths data in the new key_def. */
 	char *path_pool = (char *)new_def + key_def_sizeof(new_part_count, 0);
@@ -677,7 +764,7 @@ key_def_merge(const struct key_def *first, const struct key_def *second)
 	part = second->parts;
 	end = part + second->part_count;
 	for (; part != end; part++) {
-		if (key_def_find(first, part) != NULL)
+		if (!is_for_func_index && key_def_find(first, part) != NULL)
 			continue;
 		key_def_set_part(new_def, pos++, part->fieldno, part->type,
 				 part->nullable_action, part->coll,
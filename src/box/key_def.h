@@ -97,6 +97,12 @@ struct key_part {
 	char *path;
 	/** The length of JSON path. */
 	uint32_t path_len;
+	/**
+	 * The length of JSON path prefix pointing to the array
+	 * indexed by a multikey key part, i.e. the offset of [*]
+	 * in the path. Equals path_len if the part isn't multikey.
+	 */
+	uint32_t multikey_path_len;
 	/**
 	 * Epoch of the tuple format the offset slot cached in
 	 * this part is valid for, see tuple_format::epoch.
@@ -128,6 +134,29 @@ key_part_is_nullable(const struct key_part *part)
 	return part->nullable_action == ON_CONFLICT_ACTION_NONE;
 }
 
+/** Return true if a key part indexes elements of an array. */
+static inline bool
+key_part_is_multikey(const struct key_part *part)
+{
+	return part->multikey_path_len < part->path_len;
+}
+
+/**
+ * Tuple comparison hint. It is computed from the first key part
+ * of a tuple or a key in such a way that if hint(a) < hint(b)
+ * then a < b. If hints are equal, nothing can be said about the
+ * order of a and b and they must be compared in full. Hints are
+ * meant to be stored along with tuples in ordered indexes to
+ * avoid dereferencing tuple data on most comparisons.
+ */
+typedef uint64_t hint_t;
+
+/**
+ * Hint value that means there is no hint and full comparison
+ * must be performed.
+ */
+#define HINT_NONE ((hint_t)UINT64_MAX)
+
 /** @copydoc tuple_compare_with_key() */
 typedef int (*tuple_compare_with_key_t)(const struct tuple *tuple_a,
 					const char *key,
@@ -152,6 +181,25 @@ typedef uint32_t (*tuple_hash_t)(const struct tuple *tuple,
 /** @copydoc key_hash() */
 typedef uint32_t (*key_hash_t)(const char *key,
 				struct key_def *key_def);
+/** @copydoc tuple_hint() */
+typedef hint_t (*tuple_hint_t)(const struct tuple *tuple,
+			       struct key_def *key_def);
+/** @copydoc key_hint() */
+typedef hint_t (*key_hint_t)(const char *key, uint32_t part_count,
+			     struct key_def *key_def);
+/** @copydoc tuple_compare_hinted() */
+typedef int (*tuple_compare_hinted_t)(const struct tuple *tuple_a,
+				      hint_t tuple_a_hint,
+				      const struct tuple *tuple_b,
+				      hint_t tuple_b_hint,
+				      struct key_def *key_def);
+/** @copydoc tuple_compare_with_key_hinted() */
+typedef int (*tuple_compare_with_key_hinted_t)(const struct tuple *tuple,
+					       hint_t tuple_hint,
+					       const char *key,
+					       uint32_t part_count,
+					       hint_t key_hint,
+					       struct key_def *key_def);
 
 /* Definition of a multipart key. */
 struct key_def {
@@ -167,6 +215,21 @@ struct key_def {
 	tuple_hash_t tuple_hash;
 	/** @see key_hash() */
 	key_hash_t key_hash;
+	/** @see tuple_hint() */
+	tuple_hint_t tuple_hint;
+	/** @see key_hint() */
+	key_hint_t key_hint;
+	/**
+	 * Comparators used instead of hinted ones for multikey
+	 * key definitions and key definitions with stored keys,
+	 * NULL otherwise. A hint passed to them is not a comparison
+	 * hint, but the position of the indexed array element in
+	 * the tuple or the tuple storing the key respectively.
+	 * @see tuple_compare_hinted()
+	 */
+	tuple_compare_hinted_t tuple_compare_custom;
+	/** @see tuple_compare_with_key_hinted() */
+	tuple_compare_with_key_hinted_t tuple_compare_with_key_custom;
 	/**
 	 * Minimal part count which always is unique. For example,
 	 * if a secondary index is unique, then
@@ -179,6 +242,34 @@ struct key_def {
 	bool is_nullable;
 	/** True if some key part has JSON path. */
 	bool has_json_paths;
+	/**
+	 * True if some key part has [*] in its JSON path, so
+	 * that a tuple has a key per each element of an array.
+	 * All multikey parts must index the same array.
+	 */
+	bool is_multikey;
+	/**
+	 * Number of leading parts indexing a key computed by the
+	 * function of a functional index rather than the tuple,
+	 * 0 for other indexes. The rest of the parts, e.g. primary
+	 * key parts of a cmp_def, index the tuple itself.
+	 */
+	uint32_t func_part_count;
+	/**
+	 * Number of leading parts, values of which are stored
+	 * along with the tuple in an index entry, so that they
+	 * are compared without looking into the tuple, 0 if the
+	 * index doesn't store keys. All parts of a functional key
+	 * are stored.
+	 */
+	uint32_t stored_part_count;
+	/**
+	 * Hash keys with wyhash rather than MurmurHash where
+	 * possible, see tuple_hash_func_set(). Hashes computed
+	 * with wyhash must never be persisted, since they are
+	 * not guaranteed to be the same on all platforms.
+	 */
+	bool use_wyhash;
 	/**
 	 * True, if some key parts can be absent in a tuple. These
 	 * fields assumed to be MP_NIL.
@@ -304,6 +395,29 @@ key_def_dump_parts(const struct key_def *def, struct key_part_def *parts,
 void
 key_def_update_optionality(struct key_def *def, uint32_t min_field_count);
 
+/**
+ * Mark all parts of @a def as indexing a key computed by the
+ * function of a functional index, see key_def::func_part_count.
+ * @param def Key definition to update.
+ */
+void
+key_def_set_func_index(struct key_def *def);
+
+/**
+ * Mark all parts of @a def as stored in index entries, see
+ * key_def::stored_part_count.
+ * @param def Key definition to update.
+ */
+void
+key_def_set_stored_key(struct key_def *def);
+
+/**
+ * Make @a def hash keys with wyhash, see key_def::use_wyhash.
+ * @param def Key definition to update.
+ */
+void
+key_def_set_wyhash(struct key_def *def);
+
 /**
  * An snprint-style function to print a key definition.
  */
@@ -551,6 +665,78 @@ tuple_compare_with_key(const struct tuple *tuple, const char *key,
 	return key_def->tuple_compare_with_key(tuple, key, part_count, key_def);
 }
 
+/**
+ * Compute a comparison hint for a tuple.
+ * @param tuple tuple
+ * @param key_def key definition
+ * @return hint, HINT_NONE if the key definition doesn't
+ *         support hints.
+ */
+static inline hint_t
+tuple_hint(const struct tuple *tuple, struct key_def *key_def)
+{
+	return key_def->tuple_hint(tuple, key_def);
+}
+
+/**
+ * Compute a comparison hint for a key.
+ * @param key key parts without MessagePack array header
+ * @param part_count the number of parts in @a key
+ * @param key_def key definition
+ * @return hint, HINT_NONE if the key is empty or the key
+ *         definition doesn't support hints.
+ */
+static inline hint_t
+key_hint(const char *key, uint32_t part_count, struct key_def *key_def)
+{
+	return key_def->key_hint(key, part_count, key_def);
+}
+
+/**
+ * Compare tuples using the key definition and comparison hints.
+ * Tuple data is only accessed if the hints are not conclusive.
+ * For a multikey key definition the hints are the positions of
+ * the compared array elements in the tuples, for one with stored
+ * keys they are the tuples storing the keys.
+ * @sa tuple_compare()
+ */
+static inline int
+tuple_compare_hinted(const struct tuple *tuple_a, hint_t hint_a,
+		     const struct tuple *tuple_b, hint_t hint_b,
+		     struct key_def *key_def)
+{
+	if (key_def->tuple_compare_custom != NULL) {
+		return key_def->tuple_compare_custom(tuple_a, hint_a,
+						     tuple_b, hint_b,
+						     key_def);
+	}
+	if (hint_a != hint_b && hint_a != HINT_NONE && hint_b != HINT_NONE)
+		return hint_a < hint_b ? -1 : 1;
+	return tuple_compare(tuple_a, tuple_b, key_def);
+}
+
+/**
+ * Compare a tuple with a key using the key definition and
+ * comparison hints. For a multikey key definition @a tuple_h
+ * is the position of the compared array element in the tuple,
+ * for one with stored keys it is the tuple storing the key.
+ * @sa tuple_compare_with_key()
+ */
+static inline int
+tuple_compare_with_key_hinted(const struct tuple *tuple, hint_t tuple_h,
+			      const char *key, uint32_t part_count,
+			      hint_t key_h, struct key_def *key_def)
+{
+	if (key_def->tuple_compare_with_key_custom != NULL) {
+		return key_def->tuple_compare_with_key_custom(tuple, tuple_h,
+							      key, part_count,
+							      key_h, key_def);
+	}
+	if (tuple_h != key_h && tuple_h != HINT_NONE && key_h != HINT_NONE)
+		return tuple_h < key_h ? -1 : 1;
+	return tuple_compare_with_key(tuple, key, part_count, key_def);
+}
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
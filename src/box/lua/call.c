@@ -43,6 +43,7 @@
 #include "lua_sql.h"
 #include "trivia/util.h"
 #include "mpstream.h"
+#include "assoc.h"
 
 /**
  * A helper to find a Lua function by name and put it
@@ -305,6 +306,126 @@ execute_lua_call(lua_State *L)
 	return lua_gettop(L);
 }
 
+/* {{{ EVAL cache */
+
+/** A compiled EVAL expression. */
+struct eval_cache_entry {
+	/** Link in eval_cache.lru. */
+	struct rlist in_lru;
+	/** Reference to the compiled chunk in the Lua registry. */
+	int ref;
+	/** Memory accounted for the entry. */
+	size_t size;
+	uint32_t expr_len;
+	/** Source text of the expression. */
+	char expr[0];
+};
+
+/** Cache of compiled EVAL expressions, tx thread only. */
+static struct {
+	/** Expression text -> struct eval_cache_entry. */
+	struct mh_strnptr_t *by_text;
+	/** Entries, most recently used first. */
+	struct rlist lru;
+	/** Memory taken by cached expressions. */
+	size_t mem_used;
+	/** Memory limit, box.cfg.eval_cache_size. */
+	size_t mem_quota;
+} eval_cache;
+
+static void
+eval_cache_evict(struct eval_cache_entry *entry)
+{
+	struct mh_strnptr_t *h = eval_cache.by_text;
+	mh_int_t k = mh_strnptr_find_inp(h, entry->expr, entry->expr_len);
+	assert(k != mh_end(h));
+	mh_strnptr_del(h, k, NULL);
+	rlist_del_entry(entry, in_lru);
+	assert(eval_cache.mem_used >= entry->size);
+	eval_cache.mem_used -= entry->size;
+	luaL_unref(tarantool_L, LUA_REGISTRYINDEX, entry->ref);
+	free(entry);
+}
+
+/**
+ * Evict least recently used entries until the cache fits in
+ * its quota.
+ */
+static void
+eval_cache_shrink(void)
+{
+	while (eval_cache.mem_used > eval_cache.mem_quota) {
+		struct eval_cache_entry *victim =
+			rlist_last_entry(&eval_cache.lru,
+					 struct eval_cache_entry, in_lru);
+		eval_cache_evict(victim);
+	}
+}
+
+void
+box_lua_eval_cache_set_size(size_t size)
+{
+	eval_cache.mem_quota = size;
+	eval_cache_shrink();
+}
+
+/**
+ * Push the compiled chunk of an expression onto the stack.
+ * Return false if the expression isn't cached.
+ */
+static bool
+eval_cache_find(struct lua_State *L, const char *expr, uint32_t len)
+{
+	struct mh_strnptr_t *h = eval_cache.by_text;
+	mh_int_t k = mh_strnptr_find_inp(h, expr, len);
+	if (k == mh_end(h))
+		return false;
+	struct eval_cache_entry *entry =
+		(struct eval_cache_entry *) mh_strnptr_node(h, k)->val;
+	rlist_move_entry(&eval_cache.lru, entry, in_lru);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, entry->ref);
+	return true;
+}
+
+/**
+ * Remember the chunk on top of the stack compiled from the
+ * expression. A failure to cache is not an error, the chunk
+ * is simply compiled again next time.
+ */
+static void
+eval_cache_insert(struct lua_State *L, const char *expr, uint32_t len)
+{
+	/*
+	 * The bytecode size is not known, assume it is about
+	 * the size of the source.
+	 */
+	size_t size = sizeof(struct eval_cache_entry) + 2 * (size_t) len;
+	if (size > eval_cache.mem_quota)
+		return;
+	struct eval_cache_entry *entry =
+		(struct eval_cache_entry *) malloc(sizeof(*entry) + len);
+	if (entry == NULL)
+		return;
+	memcpy(entry->expr, expr, len);
+	entry->expr_len = len;
+	entry->size = size;
+	const struct mh_strnptr_node_t node = {
+		entry->expr, len, mh_strn_hash(entry->expr, len), entry
+	};
+	if (mh_strnptr_put(eval_cache.by_text, &node, NULL,
+			   NULL) == mh_end(eval_cache.by_text)) {
+		free(entry);
+		return;
+	}
+	lua_pushvalue(L, -1);
+	entry->ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	rlist_add_entry(&eval_cache.lru, entry, in_lru);
+	eval_cache.mem_used += size;
+	eval_cache_shrink();
+}
+
+/* }}} */
+
 static int
 execute_lua_eval(lua_State *L)
 {
@@ -312,12 +433,15 @@ execute_lua_eval(lua_State *L)
 		lua_topointer(L, 1);
 	lua_settop(L, 0); /* clear the stack to simplify the logic below */
 
-	/* Compile expression */
+	/* Compile expression or take it from the cache */
 	const char *expr = request->expr;
 	uint32_t expr_len = mp_decode_strl(&expr);
-	if (luaL_loadbuffer(L, expr, expr_len, "=eval")) {
-		diag_set(LuajitError, lua_tostring(L, -1));
-		luaT_error(L);
+	if (!eval_cache_find(L, expr, expr_len)) {
+		if (luaL_loadbuffer(L, expr, expr_len, "=eval")) {
+			diag_set(LuajitError, lua_tostring(L, -1));
+			luaT_error(L);
+		}
+		eval_cache_insert(L, expr, expr_len);
 	}
 
 	/* Unpack arguments */
@@ -332,6 +456,40 @@ execute_lua_eval(lua_State *L)
 	return lua_gettop(L);
 }
 
+/**
+ * Encode a value returned by a CALL. Procedures often return
+ * large arrays of tuples or of flat tables, so those are encoded
+ * without the generic serializer: tuples are copied as is and
+ * dense arrays are detected by luaL_densearrlen() rather than
+ * by luaL_tofield(). Anything else goes to luamp_encode_r().
+ * The value must be on the stack top.
+ */
+static void
+luamp_encode_call_result(struct lua_State *L, struct luaL_serializer *cfg,
+			 struct mpstream *stream, int level)
+{
+	int top = lua_gettop(L);
+	struct tuple *tuple = luaT_istuple(L, top);
+	if (tuple != NULL) {
+		tuple_to_mpstream(tuple, stream);
+		return;
+	}
+	int len;
+	if (level < cfg->encode_max_depth &&
+	    (len = luaL_densearrlen(L, top)) > 0) {
+		mpstream_encode_array(stream, len);
+		for (int i = 1; i <= len; i++) {
+			lua_rawgeti(L, top, i);
+			luamp_encode_call_result(L, cfg, stream, level + 1);
+			lua_pop(L, 1);
+		}
+		return;
+	}
+	struct luaL_field field;
+	luaL_tofield(L, cfg, top, &field);
+	luamp_encode_r(L, cfg, stream, &field, level);
+}
+
 static int
 encode_lua_call(lua_State *L)
 {
@@ -347,8 +505,11 @@ encode_lua_call(lua_State *L)
 
 	struct luaL_serializer *cfg = luaL_msgpack_default;
 	int size = lua_gettop(port->L);
-	for (int i = 1; i <= size; ++i)
-		luamp_encode(port->L, cfg, &stream, i);
+	for (int i = 1; i <= size; ++i) {
+		lua_pushvalue(port->L, i);
+		luamp_encode_call_result(port->L, cfg, &stream, 0);
+		lua_pop(port->L, 1);
+	}
 	port->size = size;
 	mpstream_flush(&stream);
 	return 0;
@@ -481,6 +642,13 @@ box_lua_call_init(struct lua_State *L)
 	luaL_register(L, "box.internal", boxlib_internal);
 	lua_pop(L, 1);
 
+	eval_cache.by_text = mh_strnptr_new();
+	if (eval_cache.by_text == NULL)
+		panic("failed to allocate EVAL cache");
+	rlist_create(&eval_cache.lru);
+	eval_cache.mem_used = 0;
+	eval_cache.mem_quota = 0;
+
 #if 0
 	/* Get CTypeID for `struct port *' */
 	int rc = luaL_cdef(L, "struct port;");
@@ -30,6 +30,7 @@
  * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  */
+#include <stddef.h>
 
 #if defined(__cplusplus)
 extern "C" {
@@ -53,6 +54,14 @@ box_lua_call(struct call_request *request, struct port *port);
 int
 box_lua_eval(struct call_request *request, struct port *port);
 
+/**
+ * Set the memory limit of the cache of compiled EVAL
+ * expressions, evicting least recently used ones if needed.
+ * 0 flushes and disables the cache.
+ */
+void
+box_lua_eval_cache_set_size(size_t size);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -38,6 +38,7 @@
 
 #include "box/box.h"
 #include "libeio/eio.h"
+#include "coio_task.h"
 
 extern "C" {
 	#include <lua.h>
@@ -153,6 +154,28 @@ lbox_cfg_set_snap_io_rate_limit(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_memtx_snap_threads(struct lua_State *L)
+{
+	try {
+		box_set_memtx_snap_threads();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_memtx_snap_delta_max(struct lua_State *L)
+{
+	try {
+		box_set_memtx_snap_delta_max();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_checkpoint_count(struct lua_State *L)
 {
@@ -175,6 +198,28 @@ lbox_cfg_set_checkpoint_interval(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_gc_remove_rate_limit(struct lua_State *L)
+{
+	try {
+		box_set_gc_remove_rate_limit();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_checkpoint_load_window(struct lua_State *L)
+{
+	try {
+		box_set_checkpoint_load_window();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_checkpoint_wal_threshold(struct lua_State *L)
 {
@@ -186,6 +231,39 @@ lbox_cfg_set_checkpoint_wal_threshold(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_wal_batch_delay(struct lua_State *L)
+{
+	try {
+		box_set_wal_batch_delay();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_batch_max_size(struct lua_State *L)
+{
+	try {
+		box_set_wal_batch_max_size();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_compress_threads(struct lua_State *L)
+{
+	try {
+		box_set_wal_compress_threads();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_read_only(struct lua_State *L)
 {
@@ -252,6 +330,39 @@ lbox_cfg_set_vinyl_cache(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_vinyl_page_cache(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_page_cache();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_vinyl_read_ahead(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_read_ahead();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_vinyl_index_cache(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_index_cache();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_vinyl_timeout(struct lua_State *L)
 {
@@ -263,6 +374,17 @@ lbox_cfg_set_vinyl_timeout(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_vinyl_read_latency_budget(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_read_latency_budget();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_net_msg_max(struct lua_State *L)
 {
@@ -274,6 +396,39 @@ lbox_cfg_set_net_msg_max(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_iproto_zero_copy_threshold(struct lua_State *L)
+{
+	try {
+		box_set_iproto_zero_copy_threshold();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_sql_cache_size(struct lua_State *L)
+{
+	try {
+		box_set_sql_cache_size();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_eval_cache_size(struct lua_State *L)
+{
+	try {
+		box_set_eval_cache_size();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_worker_pool_threads(struct lua_State *L)
 {
@@ -283,6 +438,30 @@ lbox_cfg_set_worker_pool_threads(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_worker_pool_dns_threads(struct lua_State *L)
+{
+	(void) L;
+	coio_pool_set_size(COIO_POOL_DNS, cfg_geti("worker_pool_dns_threads"));
+	return 0;
+}
+
+static int
+lbox_cfg_set_worker_pool_file_threads(struct lua_State *L)
+{
+	(void) L;
+	coio_pool_set_size(COIO_POOL_FILE, cfg_geti("worker_pool_file_threads"));
+	return 0;
+}
+
+static int
+lbox_cfg_set_worker_pool_user_threads(struct lua_State *L)
+{
+	(void) L;
+	coio_pool_set_size(COIO_POOL_USER, cfg_geti("worker_pool_user_threads"));
+	return 0;
+}
+
 static int
 lbox_cfg_set_replication_timeout(struct lua_State *L)
 {
@@ -346,6 +525,72 @@ lbox_cfg_set_replication_skip_conflict(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_replication_apply_fibers(struct lua_State *L)
+{
+	try {
+		box_set_replication_apply_fibers();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_replication_compression(struct lua_State *L)
+{
+	try {
+		box_set_replication_compression();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_replication_apply_batch_rows(struct lua_State *L)
+{
+	try {
+		box_set_replication_apply_batch_rows();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_replication_apply_batch_delay(struct lua_State *L)
+{
+	try {
+		box_set_replication_apply_batch_delay();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_replication_synchro_quorum(struct lua_State *L)
+{
+	try {
+		box_set_replication_synchro_quorum();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_replication_synchro_timeout(struct lua_State *L)
+{
+	try {
+		box_set_replication_synchro_timeout();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 void
 box_lua_cfg_init(struct lua_State *L)
 {
@@ -355,29 +600,52 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_listen", lbox_cfg_set_listen},
 		{"cfg_set_replication", lbox_cfg_set_replication},
 		{"cfg_set_worker_pool_threads", lbox_cfg_set_worker_pool_threads},
+		{"cfg_set_worker_pool_dns_threads", lbox_cfg_set_worker_pool_dns_threads},
+		{"cfg_set_worker_pool_file_threads", lbox_cfg_set_worker_pool_file_threads},
+		{"cfg_set_worker_pool_user_threads", lbox_cfg_set_worker_pool_user_threads},
 		{"cfg_set_log_level", lbox_cfg_set_log_level},
 		{"cfg_set_log_format", lbox_cfg_set_log_format},
 		{"cfg_set_readahead", lbox_cfg_set_readahead},
 		{"cfg_set_io_collect_interval", lbox_cfg_set_io_collect_interval},
 		{"cfg_set_too_long_threshold", lbox_cfg_set_too_long_threshold},
 		{"cfg_set_snap_io_rate_limit", lbox_cfg_set_snap_io_rate_limit},
+		{"cfg_set_gc_remove_rate_limit", lbox_cfg_set_gc_remove_rate_limit},
+		{"cfg_set_memtx_snap_threads", lbox_cfg_set_memtx_snap_threads},
+		{"cfg_set_memtx_snap_delta_max", lbox_cfg_set_memtx_snap_delta_max},
 		{"cfg_set_checkpoint_count", lbox_cfg_set_checkpoint_count},
 		{"cfg_set_checkpoint_interval", lbox_cfg_set_checkpoint_interval},
+		{"cfg_set_checkpoint_load_window", lbox_cfg_set_checkpoint_load_window},
 		{"cfg_set_checkpoint_wal_threshold", lbox_cfg_set_checkpoint_wal_threshold},
+		{"cfg_set_wal_batch_delay", lbox_cfg_set_wal_batch_delay},
+		{"cfg_set_wal_batch_max_size", lbox_cfg_set_wal_batch_max_size},
+		{"cfg_set_wal_compress_threads", lbox_cfg_set_wal_compress_threads},
 		{"cfg_set_read_only", lbox_cfg_set_read_only},
 		{"cfg_set_memtx_memory", lbox_cfg_set_memtx_memory},
 		{"cfg_set_memtx_max_tuple_size", lbox_cfg_set_memtx_max_tuple_size},
 		{"cfg_set_vinyl_memory", lbox_cfg_set_vinyl_memory},
 		{"cfg_set_vinyl_max_tuple_size", lbox_cfg_set_vinyl_max_tuple_size},
 		{"cfg_set_vinyl_cache", lbox_cfg_set_vinyl_cache},
+		{"cfg_set_vinyl_page_cache", lbox_cfg_set_vinyl_page_cache},
+		{"cfg_set_vinyl_read_ahead", lbox_cfg_set_vinyl_read_ahead},
+		{"cfg_set_vinyl_index_cache", lbox_cfg_set_vinyl_index_cache},
 		{"cfg_set_vinyl_timeout", lbox_cfg_set_vinyl_timeout},
+		{"cfg_set_vinyl_read_latency_budget", lbox_cfg_set_vinyl_read_latency_budget},
 		{"cfg_set_replication_timeout", lbox_cfg_set_replication_timeout},
 		{"cfg_set_replication_connect_quorum", lbox_cfg_set_replication_connect_quorum},
 		{"cfg_set_replication_connect_timeout", lbox_cfg_set_replication_connect_timeout},
 		{"cfg_set_replication_sync_lag", lbox_cfg_set_replication_sync_lag},
 		{"cfg_set_replication_sync_timeout", lbox_cfg_set_replication_sync_timeout},
 		{"cfg_set_replication_skip_conflict", lbox_cfg_set_replication_skip_conflict},
+		{"cfg_set_replication_apply_fibers", lbox_cfg_set_replication_apply_fibers},
+		{"cfg_set_replication_compression", lbox_cfg_set_replication_compression},
+		{"cfg_set_replication_apply_batch_rows", lbox_cfg_set_replication_apply_batch_rows},
+		{"cfg_set_replication_apply_batch_delay", lbox_cfg_set_replication_apply_batch_delay},
+		{"cfg_set_replication_synchro_quorum", lbox_cfg_set_replication_synchro_quorum},
+		{"cfg_set_replication_synchro_timeout", lbox_cfg_set_replication_synchro_timeout},
 		{"cfg_set_net_msg_max", lbox_cfg_set_net_msg_max},
+		{"cfg_set_iproto_zero_copy_threshold", lbox_cfg_set_iproto_zero_copy_threshold},
+		{"cfg_set_sql_cache_size", lbox_cfg_set_sql_cache_size},
+		{"cfg_set_eval_cache_size", lbox_cfg_set_eval_cache_size},
 		{NULL, NULL}
 	};
 
@@ -34,8 +34,11 @@
 #include <info.h>
 #include "box/box.h"
 #include "box/index.h"
+#include "box/space.h"
 #include "box/lua/tuple.h"
 #include "box/lua/misc.h" /* lbox_encode_tuple_on_gc() */
+#include "box/tuple.h"
+#include "fiber.h"
 
 /** {{{ box.index Lua library: access to spaces and indexes
  */
@@ -74,6 +77,100 @@ lbox_replace(lua_State *L)
 	return luaT_pushtupleornil(L, result);
 }
 
+static int
+lbox_insert_many(lua_State *L)
+{
+	if (lua_gettop(L) != 2 || !lua_isnumber(L, 1) ||
+	    lua_type(L, 2) != LUA_TTABLE)
+		return luaL_error(L, "Usage space:insert_many(tuples)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	size_t tuples_len;
+	const char *tuples = lbox_encode_tuple_on_gc(L, 2, &tuples_len);
+
+	if (box_insert_batch(space_id, tuples, tuples + tuples_len) != 0)
+		return luaT_error(L);
+	return 0;
+}
+
+static int
+lbox_replace_many(lua_State *L)
+{
+	if (lua_gettop(L) != 2 || !lua_isnumber(L, 1) ||
+	    lua_type(L, 2) != LUA_TTABLE)
+		return luaL_error(L, "Usage space:replace_many(tuples)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	size_t tuples_len;
+	const char *tuples = lbox_encode_tuple_on_gc(L, 2, &tuples_len);
+
+	if (box_replace_batch(space_id, tuples, tuples + tuples_len) != 0)
+		return luaT_error(L);
+	return 0;
+}
+
+/** Bulk load source calling a Lua function for each tuple. */
+struct lbox_bulk_load_source {
+	struct bulk_load_source base;
+	lua_State *L;
+	/** Index of the generator function on the Lua stack. */
+	int idx;
+	/** Last returned tuple, referenced. */
+	struct tuple *last;
+};
+
+static int
+lbox_bulk_load_source_next(struct bulk_load_source *base,
+			   struct tuple **ret)
+{
+	struct lbox_bulk_load_source *source =
+		(struct lbox_bulk_load_source *)base;
+	lua_State *L = source->L;
+	if (source->last != NULL) {
+		tuple_unref(source->last);
+		source->last = NULL;
+	}
+	*ret = NULL;
+	lua_pushvalue(L, source->idx);
+	if (luaT_call(L, 0, 1) != 0)
+		return -1;
+	if (lua_isnil(L, -1)) {
+		lua_pop(L, 1);
+		return 0;
+	}
+	struct tuple *tuple = luaT_istuple(L, -1);
+	lua_pop(L, 1);
+	if (tuple == NULL) {
+		diag_set(IllegalParams, "bulk load source must return tuples");
+		return -1;
+	}
+	tuple_ref(tuple);
+	source->last = tuple;
+	*ret = tuple;
+	return 0;
+}
+
+static int
+lbox_bulk_load(lua_State *L)
+{
+	if (lua_gettop(L) != 2 || !lua_isnumber(L, 1) ||
+	    lua_type(L, 2) != LUA_TFUNCTION)
+		return luaL_error(L, "Usage space:bulk_load(tuples)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	struct lbox_bulk_load_source source;
+	source.base.next = lbox_bulk_load_source_next;
+	source.L = L;
+	source.idx = 2;
+	source.last = NULL;
+	int rc = box_space_bulk_load(space_id, &source.base);
+	if (source.last != NULL)
+		tuple_unref(source.last);
+	if (rc != 0)
+		return luaT_error(L);
+	return 0;
+}
+
 static int
 lbox_index_update(lua_State *L)
 {
@@ -169,6 +266,48 @@ lbox_index_get(lua_State *L)
 	return luaT_pushtupleornil(L, tuple);
 }
 
+static int
+lbox_index_get_many(lua_State *L)
+{
+	if (lua_gettop(L) != 3 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
+	    lua_type(L, 3) != LUA_TTABLE)
+		return luaL_error(L, "Usage index.get_many(space_id, index_id, "
+				  "keys)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+	size_t keys_len;
+	const char *keys = lbox_encode_tuple_on_gc(L, 3, &keys_len);
+	const char *data = keys;
+	uint32_t key_count = mp_decode_array(&data);
+
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	size_t size = key_count * sizeof(struct tuple *);
+	struct tuple **results = region_alloc(region, size);
+	if (results == NULL) {
+		diag_set(OutOfMemory, size, "region", "results");
+		return luaT_error(L);
+	}
+	if (box_index_get_batch(space_id, index_id, keys, keys + keys_len,
+				results) != 0) {
+		region_truncate(region, used);
+		return luaT_error(L);
+	}
+	lua_createtable(L, key_count, 0);
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (results[i] != NULL) {
+			luaT_pushtuple(L, results[i]);
+			tuple_unref(results[i]);
+		} else {
+			luaL_pushnull(L);
+		}
+		lua_rawseti(L, -2, i + 1);
+	}
+	region_truncate(region, used);
+	return 1;
+}
+
 static int
 lbox_index_min(lua_State *L)
 {
@@ -226,6 +365,88 @@ lbox_index_count(lua_State *L)
 	return 1;
 }
 
+static int
+lbox_index_estimate_count(lua_State *L)
+{
+	if (lua_gettop(L) != 4 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
+	    !lua_isnumber(L, 3)) {
+		return luaL_error(L, "usage index.estimate_count(space_id, "
+		       "index_id, iterator, key)");
+	}
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+	uint32_t iterator = lua_tonumber(L, 3);
+	size_t key_len;
+	const char *key = lbox_encode_tuple_on_gc(L, 4, &key_len);
+
+	ssize_t count = box_index_estimate_count(space_id, index_id, iterator,
+						 key, key + key_len);
+	if (count == -1)
+		return luaT_error(L);
+	lua_pushinteger(L, count);
+	return 1;
+}
+
+/**
+ * Push the min or max of an aggregate, choosing between
+ * the integer and the floating point bound.
+ */
+static void
+lbox_push_aggregate_bound(struct lua_State *L,
+			  const struct index_aggregate *agg,
+			  int64_t int_val, double double_val, bool is_min)
+{
+	if (agg->double_count == 0) {
+		luaL_pushint64(L, int_val);
+	} else if (agg->int_count == 0) {
+		lua_pushnumber(L, double_val);
+	} else if (is_min ? int_val < double_val : int_val > double_val) {
+		luaL_pushint64(L, int_val);
+	} else {
+		lua_pushnumber(L, double_val);
+	}
+}
+
+static int
+lbox_index_aggregate(lua_State *L)
+{
+	if (lua_gettop(L) != 5 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
+	    !lua_isnumber(L, 3) || !lua_isnumber(L, 5)) {
+		return luaL_error(L, "usage index.aggregate(space_id, index_id, "
+		       "iterator, key, fieldno)");
+	}
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+	uint32_t iterator = lua_tonumber(L, 3);
+	size_t key_len;
+	const char *key = lbox_encode_tuple_on_gc(L, 4, &key_len);
+	uint32_t fieldno = lua_tonumber(L, 5);
+
+	struct index_aggregate agg;
+	if (box_index_aggregate(space_id, index_id, iterator, key,
+				key + key_len, fieldno, &agg) != 0)
+		return luaT_error(L);
+	lua_createtable(L, 0, 4);
+	luaL_pushuint64(L, agg.count);
+	lua_setfield(L, -2, "count");
+	if (agg.is_int_sum)
+		luaL_pushint64(L, agg.int_sum);
+	else
+		lua_pushnumber(L, agg.sum);
+	lua_setfield(L, -2, "sum");
+	if (agg.count > 0) {
+		lbox_push_aggregate_bound(L, &agg, agg.int_min,
+					  agg.double_min, true);
+		lua_setfield(L, -2, "min");
+		lbox_push_aggregate_bound(L, &agg, agg.int_max,
+					  agg.double_max, false);
+		lua_setfield(L, -2, "max");
+	}
+	return 1;
+}
+
 static void
 box_index_init_iterator_types(struct lua_State *L, int idx)
 {
@@ -242,9 +463,9 @@ box_index_init_iterator_types(struct lua_State *L, int idx)
 static int
 lbox_index_iterator(lua_State *L)
 {
-	if (lua_gettop(L) != 4 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
+	if (lua_gettop(L) < 4 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
 	    !lua_isnumber(L, 3))
-		return luaL_error(L, "usage index.iterator(space_id, index_id, type, key)");
+		return luaL_error(L, "usage index.iterator(space_id, index_id, type, key[, no_cache_fill[, yield_steps, yield_timeout]])");
 
 	uint32_t space_id = lua_tonumber(L, 1);
 	uint32_t index_id = lua_tonumber(L, 2);
@@ -256,6 +477,11 @@ lbox_index_iterator(lua_State *L)
 						 mpkey, mpkey + mpkey_len);
 	if (it == NULL)
 		return luaT_error(L);
+	it->no_cache_fill = lua_toboolean(L, 5);
+	uint32_t yield_steps = lua_tonumber(L, 6);
+	double yield_timeout = lua_tonumber(L, 7);
+	if (yield_steps != 0 || yield_timeout != 0)
+		box_iterator_set_auto_yield(it, yield_steps, yield_timeout);
 
 	assert(CTID_STRUCT_ITERATOR_REF != 0);
 	struct iterator **ptr = (struct iterator **) luaL_pushcdata(L,
@@ -314,6 +540,48 @@ lbox_index_stat(lua_State *L)
 	return 1;
 }
 
+static int
+lbox_index_reset_stat(lua_State *L)
+{
+	if (lua_gettop(L) != 2 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2))
+		return luaL_error(L, "usage index.stat_reset(space_id, index_id)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+
+	if (box_index_reset_stat(space_id, index_id) != 0)
+		return luaT_error(L);
+	return 0;
+}
+
+static int
+lbox_space_stat(lua_State *L)
+{
+	if (lua_gettop(L) != 1 || !lua_isnumber(L, 1))
+		return luaL_error(L, "usage space.stat(space_id)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+
+	struct info_handler info;
+	luaT_info_handler_create(&info, L);
+	if (box_space_stat(space_id, &info) != 0)
+		return luaT_error(L);
+	return 1;
+}
+
+static int
+lbox_space_reset_stat(lua_State *L)
+{
+	if (lua_gettop(L) != 1 || !lua_isnumber(L, 1))
+		return luaL_error(L, "usage space.stat_reset(space_id)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+
+	if (box_space_reset_stat(space_id) != 0)
+		return luaT_error(L);
+	return 0;
+}
+
 static int
 lbox_index_compact(lua_State *L)
 {
@@ -352,18 +620,27 @@ box_lua_index_init(struct lua_State *L)
 	static const struct luaL_Reg boxlib_internal[] = {
 		{"insert", lbox_insert},
 		{"replace",  lbox_replace},
+		{"insert_many", lbox_insert_many},
+		{"replace_many", lbox_replace_many},
+		{"bulk_load", lbox_bulk_load},
 		{"update", lbox_index_update},
 		{"upsert",  lbox_upsert},
 		{"delete",  lbox_index_delete},
 		{"random", lbox_index_random},
 		{"get",  lbox_index_get},
+		{"get_many", lbox_index_get_many},
 		{"min", lbox_index_min},
 		{"max", lbox_index_max},
 		{"count", lbox_index_count},
+		{"estimate_count", lbox_index_estimate_count},
+		{"aggregate", lbox_index_aggregate},
 		{"iterator", lbox_index_iterator},
 		{"iterator_next", lbox_iterator_next},
 		{"truncate", lbox_truncate},
 		{"stat", lbox_index_stat},
+		{"stat_reset", lbox_index_reset_stat},
+		{"space_stat", lbox_space_stat},
+		{"space_reset_stat", lbox_space_reset_stat},
 		{"compact", lbox_index_compact},
 		{NULL, NULL}
 	};
@@ -43,6 +43,7 @@
 #include "box/replication.h"
 #include <info.h>
 #include "box/gc.h"
+#include "box/gc_remove.h"
 #include "box/engine.h"
 #include "box/vinyl.h"
 #include "main.h"
@@ -102,6 +103,12 @@ lbox_pushapplier(lua_State *L, struct applier *applier)
 		lua_pushlstring(L, name, total);
 		lua_settable(L, -3);
 
+		if (applier->compress) {
+			lua_pushstring(L, "bytes_saved");
+			luaL_pushuint64(L, applier->bytes_saved);
+			lua_settable(L, -3);
+		}
+
 		struct error *e = diag_last_error(&applier->reader->diag);
 		if (e != NULL) {
 			lua_pushstring(L, "message");
@@ -124,6 +131,17 @@ lbox_pushrelay(lua_State *L, struct relay *relay)
 		lua_pushstring(L, "vclock");
 		lbox_pushvclock(L, relay_vclock(relay));
 		lua_settable(L, -3);
+		if (relay_is_compressed(relay)) {
+			lua_pushstring(L, "bytes_saved");
+			luaL_pushuint64(L, relay_bytes_saved(relay));
+			lua_settable(L, -3);
+		}
+		lua_pushstring(L, "rows_sent");
+		luaL_pushuint64(L, relay_rows_sent(relay));
+		lua_settable(L, -3);
+		lua_pushstring(L, "writes");
+		luaL_pushuint64(L, relay_write_count(relay));
+		lua_settable(L, -3);
 		break;
 	case RELAY_STOPPED:
 	{
@@ -334,6 +352,10 @@ lbox_info_memory_call(struct lua_State *L)
 	luaL_pushuint64(L, stat.tx);
 	lua_settable(L, -3);
 
+	lua_pushstring(L, "delayed_free");
+	luaL_pushuint64(L, stat.delayed_free);
+	lua_settable(L, -3);
+
 	lua_pushstring(L, "net");
 	luaL_pushuint64(L, iproto_mem_used());
 	lua_settable(L, -3);
@@ -436,6 +458,26 @@ lbox_info_gc_call(struct lua_State *L)
 	}
 	lua_settable(L, -3);
 
+	struct gc_remove_stat remove_stat;
+	gc_remove_stat(&remove_stat);
+
+	lua_pushstring(L, "removal");
+	lua_createtable(L, 0, 3);
+
+	lua_pushstring(L, "files");
+	luaL_pushint64(L, remove_stat.files);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "size");
+	luaL_pushint64(L, remove_stat.size);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "removed");
+	luaL_pushint64(L, remove_stat.removed);
+	lua_settable(L, -3);
+
+	lua_settable(L, -3);
+
 	return 1;
 }
 
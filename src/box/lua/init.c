@@ -56,6 +56,7 @@
 #include "box/lua/net_box.h"
 #include "box/lua/cfg.h"
 #include "box/lua/xlog.h"
+#include "box/lua/read_view.h"
 #include "box/lua/console.h"
 #include "box/lua/tuple.h"
 #include "box/lua/sql.h"
@@ -65,6 +66,7 @@ extern char session_lua[],
 	schema_lua[],
 	load_cfg_lua[],
 	xlog_lua[],
+	transfer_lua[],
 	feedback_daemon_lua[],
 	net_box_lua[],
 	upgrade_lua[],
@@ -80,6 +82,7 @@ static const char *lua_sources[] = {
 	"box/console", console_lua,
 	"box/load_cfg", load_cfg_lua,
 	"box/xlog", xlog_lua,
+	"box/transfer", transfer_lua,
 	NULL
 };
 
@@ -258,6 +261,67 @@ lbox_backup_start(struct lua_State *L)
 	return 1;
 }
 
+/**
+ * box.backup.stream(path, [opts]): stream a backup to a file or
+ * a named pipe in the tar format. Options:
+ * - checkpoint_idx: checkpoint to back up, see box.backup.start()
+ * - since: vclock to stream an incremental backup from
+ * - rate_limit: max read rate, in bytes per second
+ * Returns a table with the paths of streamed files.
+ */
+static int
+lbox_backup_stream(struct lua_State *L)
+{
+	const char *path = luaL_checkstring(L, 1);
+	int checkpoint_idx = 0;
+	double rate_limit = 0;
+	struct vclock since;
+	bool is_incremental = false;
+	if (lua_gettop(L) > 1 && !lua_isnil(L, 2)) {
+		luaL_checktype(L, 2, LUA_TTABLE);
+		lua_getfield(L, 2, "checkpoint_idx");
+		if (!lua_isnil(L, -1)) {
+			checkpoint_idx = luaL_checkint(L, -1);
+			if (checkpoint_idx < 0)
+				return luaL_error(L, "invalid checkpoint index");
+		}
+		lua_pop(L, 1);
+		lua_getfield(L, 2, "rate_limit");
+		if (!lua_isnil(L, -1)) {
+			rate_limit = luaL_checknumber(L, -1);
+			if (rate_limit < 0)
+				return luaL_error(L, "invalid rate limit");
+		}
+		lua_pop(L, 1);
+		lua_getfield(L, 2, "since");
+		if (!lua_isnil(L, -1)) {
+			luaL_checktype(L, -1, LUA_TTABLE);
+			vclock_create(&since);
+			lua_pushnil(L);
+			while (lua_next(L, -2) != 0) {
+				int id = lua_tointeger(L, -2);
+				int64_t lsn = lua_tointeger(L, -1);
+				if (id < 0 || id >= VCLOCK_MAX || lsn < 0)
+					return luaL_error(L, "invalid vclock");
+				if (lsn > 0)
+					vclock_follow(&since, id, lsn);
+				lua_pop(L, 1);
+			}
+			is_incremental = true;
+		}
+		lua_pop(L, 1);
+	}
+	lua_newtable(L);
+	struct lbox_backup_arg arg = {
+		.L = L,
+	};
+	if (box_backup_stream(checkpoint_idx,
+			      is_incremental ? &since : NULL, path,
+			      rate_limit, lbox_backup_cb, &arg) != 0)
+		return luaT_error(L);
+	return 1;
+}
+
 static int
 lbox_backup_stop(struct lua_State *L)
 {
@@ -278,6 +342,7 @@ static const struct luaL_Reg boxlib[] = {
 static const struct luaL_Reg boxlib_backup[] = {
 	{"start", lbox_backup_start},
 	{"stop", lbox_backup_stop},
+	{"stream", lbox_backup_stream},
 	{NULL, NULL}
 };
 
@@ -307,6 +372,7 @@ box_lua_init(struct lua_State *L)
 	box_lua_ctl_init(L);
 	box_lua_session_init(L);
 	box_lua_xlog_init(L);
+	box_lua_read_view_init(L);
 	box_lua_sql_init(L);
 	luaopen_net_box(L);
 	lua_pop(L, 1);
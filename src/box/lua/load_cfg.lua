@@ -27,18 +27,27 @@ local default_cfg = {
     memtx_memory        = 256 * 1024 *1024,
     memtx_min_tuple_size = 16,
     memtx_max_tuple_size = 1024 * 1024,
+    memtx_snap_threads  = 1,
+    memtx_snap_delta_max = 0,
+    memtx_use_hugepages = false,
+    memtx_numa_policy   = nil,
     slab_alloc_factor   = 1.05,
     work_dir            = nil,
     memtx_dir           = ".",
     wal_dir             = ".",
 
     vinyl_dir           = '.',
+    vinyl_cold_dir      = nil,
     vinyl_memory        = 128 * 1024 * 1024,
     vinyl_cache         = 128 * 1024 * 1024,
+    vinyl_page_cache    = 0,
+    vinyl_read_ahead    = 16 * 1024 * 1024,
+    vinyl_index_cache   = 0,
     vinyl_max_tuple_size = 1024 * 1024,
     vinyl_read_threads  = 1,
     vinyl_write_threads = 4,
     vinyl_timeout       = 60,
+    vinyl_read_latency_budget = 0,
     vinyl_run_count_per_level = 2,
     vinyl_run_size_ratio      = 3.5,
     vinyl_range_size          = nil, -- set automatically
@@ -46,16 +55,24 @@ local default_cfg = {
     vinyl_bloom_fpr           = 0.05,
     log                 = nil,
     log_nonblock        = nil,
+    log_async           = nil,
     log_level           = 5,
     log_format          = "plain",
     io_collect_interval = nil,
     readahead           = 16320,
     snap_io_rate_limit  = nil, -- no limit
+    gc_remove_rate_limit = nil, -- remove files at once
     too_long_threshold  = 0.5,
     wal_mode            = "write",
     rows_per_wal        = 500000,
     wal_max_size        = 256 * 1024 * 1024,
+    wal_ring_size       = 0,
+    wal_spare_files     = 0,
+    wal_batch_delay     = 0,
+    wal_batch_max_size  = 1024 * 1024,
+    wal_compress_threads = 1,
     wal_dir_rescan_delay= 2,
+    wal_direct_io       = false,
     force_recovery      = false,
     replication         = nil,
     instance_uuid       = nil,
@@ -68,19 +85,37 @@ local default_cfg = {
     read_only           = false,
     hot_standby         = false,
     checkpoint_interval = 3600,
+    checkpoint_load_window = 0,
     checkpoint_wal_threshold = 1e18,
     checkpoint_count    = 2,
     worker_pool_threads = 4,
+    worker_pool_dns_threads = 0,
+    worker_pool_file_threads = 0,
+    worker_pool_user_threads = 0,
     replication_timeout = 1,
     replication_sync_lag = 10,
     replication_sync_timeout = 300,
     replication_connect_timeout = 30,
     replication_connect_quorum = nil, -- connect all
     replication_skip_conflict = false,
+    replication_apply_fibers = 1,
+    replication_compression = false,
+    replication_apply_batch_rows = 1,
+    replication_apply_batch_delay = 0,
+    replication_synchro_quorum = 1,
+    replication_synchro_timeout = 5,
+    replication_anon = false,
+    replication_join_from_replica = false,
     feedback_enabled      = true,
     feedback_host         = "https://feedback.tarantool.io",
     feedback_interval     = 3600,
     net_msg_max           = 768,
+    iproto_threads        = 1,
+    thread_affinity       = nil,
+    io_uring              = false,
+    iproto_zero_copy_threshold = 0,
+    sql_cache_size        = 5 * 1024 * 1024,
+    eval_cache_size       = 1024 * 1024,
 }
 
 -- types of available options
@@ -90,17 +125,26 @@ local template_cfg = {
     memtx_memory        = 'number',
     memtx_min_tuple_size  = 'number',
     memtx_max_tuple_size  = 'number',
+    memtx_snap_threads    = 'number',
+    memtx_snap_delta_max  = 'number',
+    memtx_use_hugepages   = 'boolean',
+    memtx_numa_policy     = 'string',
     slab_alloc_factor   = 'number',
     work_dir            = 'string',
     memtx_dir            = 'string',
     wal_dir             = 'string',
     vinyl_dir           = 'string',
+    vinyl_cold_dir      = 'string',
     vinyl_memory        = 'number',
     vinyl_cache               = 'number',
+    vinyl_page_cache          = 'number',
+    vinyl_read_ahead          = 'number',
+    vinyl_index_cache         = 'number',
     vinyl_max_tuple_size      = 'number',
     vinyl_read_threads        = 'number',
     vinyl_write_threads       = 'number',
     vinyl_timeout             = 'number',
+    vinyl_read_latency_budget = 'number',
     vinyl_run_count_per_level = 'number',
     vinyl_run_size_ratio      = 'number',
     vinyl_range_size          = 'number',
@@ -109,16 +153,24 @@ local template_cfg = {
 
     log              = 'string',
     log_nonblock     = 'boolean',
+    log_async        = 'string',
     log_level           = 'number',
     log_format          = 'string',
     io_collect_interval = 'number',
     readahead           = 'number',
     snap_io_rate_limit  = 'number',
+    gc_remove_rate_limit = 'number',
     too_long_threshold  = 'number',
     wal_mode            = 'string',
     rows_per_wal        = 'number',
     wal_max_size        = 'number',
+    wal_ring_size       = 'number',
+    wal_spare_files     = 'number',
+    wal_batch_delay     = 'number',
+    wal_batch_max_size  = 'number',
+    wal_compress_threads = 'number',
     wal_dir_rescan_delay= 'number',
+    wal_direct_io       = 'boolean',
     force_recovery      = 'boolean',
     replication         = 'string, number, table',
     instance_uuid       = 'string',
@@ -129,21 +181,39 @@ local template_cfg = {
     username            = 'string',
     coredump            = 'boolean',
     checkpoint_interval = 'number',
+    checkpoint_load_window = 'number',
     checkpoint_wal_threshold = 'number',
     checkpoint_count    = 'number',
     read_only           = 'boolean',
     hot_standby         = 'boolean',
     worker_pool_threads = 'number',
+    worker_pool_dns_threads = 'number',
+    worker_pool_file_threads = 'number',
+    worker_pool_user_threads = 'number',
     replication_timeout = 'number',
     replication_sync_lag = 'number',
     replication_sync_timeout = 'number',
     replication_connect_timeout = 'number',
     replication_connect_quorum = 'number',
     replication_skip_conflict = 'boolean',
+    replication_apply_fibers = 'number',
+    replication_compression = 'boolean',
+    replication_apply_batch_rows = 'number',
+    replication_apply_batch_delay = 'number',
+    replication_synchro_quorum = 'number',
+    replication_synchro_timeout = 'number',
+    replication_anon = 'boolean',
+    replication_join_from_replica = 'boolean',
     feedback_enabled      = 'boolean',
     feedback_host         = 'string',
     feedback_interval     = 'number',
     net_msg_max           = 'number',
+    iproto_threads        = 'number',
+    thread_affinity       = 'string',
+    io_uring              = 'boolean',
+    iproto_zero_copy_threshold = 'number',
+    sql_cache_size        = 'number',
+    eval_cache_size       = 'number',
 }
 
 local function normalize_uri(port)
@@ -221,17 +291,31 @@ local dynamic_cfg = {
     readahead               = private.cfg_set_readahead,
     too_long_threshold      = private.cfg_set_too_long_threshold,
     snap_io_rate_limit      = private.cfg_set_snap_io_rate_limit,
+    gc_remove_rate_limit    = private.cfg_set_gc_remove_rate_limit,
     read_only               = private.cfg_set_read_only,
     memtx_memory            = private.cfg_set_memtx_memory,
     memtx_max_tuple_size    = private.cfg_set_memtx_max_tuple_size,
+    memtx_snap_threads      = private.cfg_set_memtx_snap_threads,
+    memtx_snap_delta_max    = private.cfg_set_memtx_snap_delta_max,
     vinyl_memory            = private.cfg_set_vinyl_memory,
     vinyl_max_tuple_size    = private.cfg_set_vinyl_max_tuple_size,
     vinyl_cache             = private.cfg_set_vinyl_cache,
+    vinyl_page_cache        = private.cfg_set_vinyl_page_cache,
+    vinyl_read_ahead        = private.cfg_set_vinyl_read_ahead,
+    vinyl_index_cache       = private.cfg_set_vinyl_index_cache,
     vinyl_timeout           = private.cfg_set_vinyl_timeout,
+    vinyl_read_latency_budget = private.cfg_set_vinyl_read_latency_budget,
     checkpoint_count        = private.cfg_set_checkpoint_count,
     checkpoint_interval     = private.cfg_set_checkpoint_interval,
+    checkpoint_load_window = private.cfg_set_checkpoint_load_window,
     checkpoint_wal_threshold = private.cfg_set_checkpoint_wal_threshold,
+    wal_batch_delay         = private.cfg_set_wal_batch_delay,
+    wal_batch_max_size      = private.cfg_set_wal_batch_max_size,
+    wal_compress_threads    = private.cfg_set_wal_compress_threads,
     worker_pool_threads     = private.cfg_set_worker_pool_threads,
+    worker_pool_dns_threads = private.cfg_set_worker_pool_dns_threads,
+    worker_pool_file_threads = private.cfg_set_worker_pool_file_threads,
+    worker_pool_user_threads = private.cfg_set_worker_pool_user_threads,
     feedback_enabled        = private.feedback_daemon.set_feedback_params,
     feedback_host           = private.feedback_daemon.set_feedback_params,
     feedback_interval       = private.feedback_daemon.set_feedback_params,
@@ -247,19 +331,34 @@ local dynamic_cfg = {
     replication_sync_lag    = private.cfg_set_replication_sync_lag,
     replication_sync_timeout = private.cfg_set_replication_sync_timeout,
     replication_skip_conflict = private.cfg_set_replication_skip_conflict,
+    replication_apply_fibers = private.cfg_set_replication_apply_fibers,
+    replication_compression = private.cfg_set_replication_compression,
+    replication_apply_batch_rows = private.cfg_set_replication_apply_batch_rows,
+    replication_apply_batch_delay = private.cfg_set_replication_apply_batch_delay,
+    replication_synchro_quorum = private.cfg_set_replication_synchro_quorum,
+    replication_synchro_timeout = private.cfg_set_replication_synchro_timeout,
     instance_uuid           = check_instance_uuid,
     replicaset_uuid         = check_replicaset_uuid,
     net_msg_max             = private.cfg_set_net_msg_max,
+    iproto_zero_copy_threshold = private.cfg_set_iproto_zero_copy_threshold,
+    sql_cache_size          = private.cfg_set_sql_cache_size,
+    eval_cache_size         = private.cfg_set_eval_cache_size,
 }
 
 local dynamic_cfg_skip_at_load = {
     listen                  = true,
     memtx_memory            = true,
     memtx_max_tuple_size    = true,
+    memtx_snap_threads      = true,
+    memtx_snap_delta_max    = true,
     vinyl_memory            = true,
     vinyl_max_tuple_size    = true,
     vinyl_cache             = true,
+    vinyl_page_cache        = true,
+    vinyl_read_ahead        = true,
+    vinyl_index_cache       = true,
     vinyl_timeout           = true,
+    vinyl_read_latency_budget = true,
     too_long_threshold      = true,
     replication             = true,
     replication_timeout     = true,
@@ -268,12 +367,21 @@ local dynamic_cfg_skip_at_load = {
     replication_sync_lag    = true,
     replication_sync_timeout = true,
     replication_skip_conflict = true,
+    replication_apply_fibers = true,
+    replication_compression = true,
+    replication_apply_batch_rows = true,
+    replication_apply_batch_delay = true,
+    replication_synchro_quorum = true,
+    replication_synchro_timeout = true,
     wal_dir_rescan_delay    = true,
     custom_proc_title       = true,
     force_recovery          = true,
     instance_uuid           = true,
     replicaset_uuid         = true,
     net_msg_max             = true,
+    iproto_zero_copy_threshold = true,
+    sql_cache_size          = true,
+    eval_cache_size         = true,
 }
 
 local function convert_gb(size)
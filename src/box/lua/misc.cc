@@ -114,6 +114,49 @@ lbox_select(lua_State *L)
 	return 1; /* lua table with tuples */
 }
 
+/**
+ * index:select() with the fields option. Takes an array of
+ * zero-based field numbers to return instead of full tuples.
+ */
+static int
+lbox_select_fields(lua_State *L)
+{
+	if (lua_gettop(L) != 7 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
+	    !lua_isnumber(L, 3) || !lua_isnumber(L, 4) || !lua_isnumber(L, 5) ||
+	    !lua_istable(L, 7)) {
+		return luaL_error(L, "Usage index:select(iterator, offset, "
+				  "limit, key, fields)");
+	}
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+	int iterator = lua_tonumber(L, 3);
+	uint32_t offset = lua_tonumber(L, 4);
+	uint32_t limit = lua_tonumber(L, 5);
+
+	size_t key_len;
+	const char *key = lbox_encode_tuple_on_gc(L, 6, &key_len);
+
+	uint32_t field_count = lua_objlen(L, 7);
+	uint32_t *fields = (uint32_t *)region_alloc_xc(&fiber()->gc,
+					field_count * sizeof(*fields));
+	for (uint32_t i = 0; i < field_count; i++) {
+		lua_rawgeti(L, 7, i + 1);
+		fields[i] = lua_tonumber(L, -1);
+		lua_pop(L, 1);
+	}
+
+	struct port port;
+	if (box_select_fields(space_id, index_id, iterator, offset, limit,
+			      key, key + key_len, fields, field_count,
+			      &port) != 0) {
+		return luaT_error(L);
+	}
+	port_dump_lua(&port, L);
+	port_destroy(&port);
+	return 1;
+}
+
 /* }}} */
 
 void
@@ -121,6 +164,7 @@ box_lua_misc_init(struct lua_State *L)
 {
 	static const struct luaL_Reg boxlib_internal[] = {
 		{"select", lbox_select},
+		{"select_fields", lbox_select_fields},
 		{NULL, NULL}
 	};
 
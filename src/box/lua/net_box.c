@@ -33,6 +33,7 @@
 
 #include <small/ibuf.h>
 #include <msgpuck.h> /* mp_store_u32() */
+#include <zstd.h>
 #include "scramble.h"
 
 #include "box/iproto_constants.h"
@@ -119,6 +120,22 @@ netbox_encode_ping(lua_State *L)
 	return 0;
 }
 
+static int
+netbox_encode_compress(lua_State *L)
+{
+	if (lua_gettop(L) < 3) {
+		return luaL_error(L, "Usage: netbox.encode_compress(ibuf, "
+				     "sync, threshold)");
+	}
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_COMPRESS);
+	mpstream_encode_map(&stream, 1);
+	mpstream_encode_uint(&stream, IPROTO_COMPRESSION);
+	mpstream_encode_uint(&stream, lua_tointeger(L, 3));
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
 static int
 netbox_encode_auth(lua_State *L)
 {
@@ -450,9 +467,8 @@ netbox_decode_greeting(lua_State *L)
 }
 
 /**
- * communicate(fd, send_buf, recv_buf, limit_or_boundary, timeout)
- *  -> errno, error
- *  -> nil, limit/boundary_pos
+ * Send data from @a send_buf and receive data to @a recv_buf
+ * until it has @a limit bytes or @a boundary.
  *
  * The need for this function arises from not wanting to
  * have more than one watcher for a single fd, and thus issue
@@ -462,52 +478,38 @@ netbox_decode_greeting(lua_State *L)
  * Instead, this function takes an fd, input and output buffer,
  * and does sending and receiving on it in a single event loop
  * interaction.
+ *
+ * @param[out] pos Position of @a boundary in @a recv_buf.
+ * @param[out] error Error message.
+ * @retval 0 Success.
+ * @retval Error code.
  */
 static int
-netbox_communicate(lua_State *L)
+netbox_communicate_impl(lua_State *L, int fd, struct ibuf *send_buf,
+			struct ibuf *recv_buf, size_t limit,
+			const void *boundary, size_t boundary_len,
+			ev_tstamp timeout, size_t *pos, const char **error)
 {
-	uint32_t fd = lua_tonumber(L, 1);
 	const int NETBOX_READAHEAD = 16320;
-	struct ibuf *send_buf = (struct ibuf *) lua_topointer(L, 2);
-	struct ibuf *recv_buf = (struct ibuf *) lua_topointer(L, 3);
-
-	/* limit or boundary */
-	size_t limit = SIZE_MAX;
-	const void *boundary = NULL;
-	size_t boundary_len;
-
-	if (lua_type(L, 4) == LUA_TSTRING)
-		boundary = lua_tolstring(L, 4, &boundary_len);
-	else
-		limit = lua_tonumber(L, 4);
-
-	/* timeout */
-	ev_tstamp timeout = TIMEOUT_INFINITY;
-	if (lua_type(L, 5) == LUA_TNUMBER)
-		timeout = lua_tonumber(L, 5);
 	if (timeout < 0) {
-		lua_pushinteger(L, ER_TIMEOUT);
-		lua_pushstring(L, "Timeout exceeded");
-		return 2;
+		*error = "Timeout exceeded";
+		return ER_TIMEOUT;
 	}
 	int revents = COIO_READ;
 	while (true) {
 		/* reader serviced first */
 check_limit:
 		if (ibuf_used(recv_buf) >= limit) {
-			lua_pushnil(L);
-			lua_pushinteger(L, (lua_Integer)limit);
-			return 2;
+			*pos = limit;
+			return 0;
 		}
 		const char *p;
 		if (boundary != NULL && (p = memmem(
 					recv_buf->rpos,
 					ibuf_used(recv_buf),
 					boundary, boundary_len)) != NULL) {
-			lua_pushnil(L);
-			lua_pushinteger(L, (lua_Integer)(
-					p - recv_buf->rpos));
-			return 2;
+			*pos = p - recv_buf->rpos;
+			return 0;
 		}
 
 		while (revents & COIO_READ) {
@@ -517,9 +519,8 @@ check_limit:
 			ssize_t rc = recv(
 				fd, recv_buf->wpos, ibuf_unused(recv_buf), 0);
 			if (rc == 0) {
-				lua_pushinteger(L, ER_NO_CONNECTION);
-				lua_pushstring(L, "Peer closed");
-				return 2;
+				*error = "Peer closed";
+				return ER_NO_CONNECTION;
 			} if (rc > 0) {
 				recv_buf->wpos += rc;
 				goto check_limit;
@@ -547,14 +548,233 @@ check_limit:
 		timeout = deadline - ev_monotonic_now(loop());
 		timeout = MAX(0.0, timeout);
 		if (revents == 0 && timeout == 0.0) {
-			lua_pushinteger(L, ER_TIMEOUT);
-			lua_pushstring(L, "Timeout exceeded");
-			return 2;
+			*error = "Timeout exceeded";
+			return ER_TIMEOUT;
 		}
 	}
 handle_error:
-	lua_pushinteger(L, ER_NO_CONNECTION);
-	lua_pushstring(L, strerror(errno));
+	*error = strerror(errno);
+	return ER_NO_CONNECTION;
+}
+
+/**
+ * communicate(fd, send_buf, recv_buf, limit_or_boundary, timeout)
+ *  -> errno, error
+ *  -> nil, limit/boundary_pos
+ */
+static int
+netbox_communicate(lua_State *L)
+{
+	uint32_t fd = lua_tonumber(L, 1);
+	struct ibuf *send_buf = (struct ibuf *) lua_topointer(L, 2);
+	struct ibuf *recv_buf = (struct ibuf *) lua_topointer(L, 3);
+
+	/* limit or boundary */
+	size_t limit = SIZE_MAX;
+	const void *boundary = NULL;
+	size_t boundary_len = 0;
+
+	if (lua_type(L, 4) == LUA_TSTRING)
+		boundary = lua_tolstring(L, 4, &boundary_len);
+	else
+		limit = lua_tonumber(L, 4);
+
+	/* timeout */
+	ev_tstamp timeout = TIMEOUT_INFINITY;
+	if (lua_type(L, 5) == LUA_TNUMBER)
+		timeout = lua_tonumber(L, 5);
+	size_t pos;
+	const char *error;
+	int rc = netbox_communicate_impl(L, fd, send_buf, recv_buf, limit,
+					 boundary, boundary_len, timeout,
+					 &pos, &error);
+	if (rc != 0) {
+		lua_pushinteger(L, rc);
+		lua_pushstring(L, error);
+		return 2;
+	}
+	lua_pushnil(L);
+	lua_pushinteger(L, (lua_Integer)pos);
+	return 2;
+}
+
+/** Type id of const char *, the type of response positions. */
+static uint32_t CTID_CONST_CHAR_PTR;
+
+/** Stream used to decompress response bodies. */
+static ZSTD_DStream *netbox_zstream;
+
+/**
+ * If a response body is compressed, see IPROTO_COMPRESSED_BODY,
+ * decompress it to @a zbuf and point @a body and @a body_end
+ * to the original body.
+ */
+static int
+netbox_decompress_body(struct ibuf *zbuf, const char **body,
+		       const char **body_end, const char **error)
+{
+	const char *pos = *body;
+	const char *end = *body_end;
+	if (pos == end || mp_typeof(*pos) != MP_MAP ||
+	    mp_check_map(pos, end) > 0 || mp_decode_map(&pos) != 1 ||
+	    pos == end || mp_typeof(*pos) != MP_UINT ||
+	    mp_check_uint(pos, end) > 0 ||
+	    mp_decode_uint(&pos) != IPROTO_COMPRESSED_BODY)
+		return 0;
+	if (pos == end || mp_typeof(*pos) != MP_BIN ||
+	    mp_check_binl(pos, end) > 0) {
+		*error = "Invalid MsgPack - compressed body";
+		return ER_INVALID_MSGPACK;
+	}
+	uint32_t zsize;
+	const char *zdata = mp_decode_bin(&pos, &zsize);
+	if (zbuf == NULL || zdata + zsize > end) {
+		*error = "Invalid MsgPack - compressed body";
+		return ER_INVALID_MSGPACK;
+	}
+	if (netbox_zstream == NULL) {
+		netbox_zstream = ZSTD_createDStream();
+		if (netbox_zstream == NULL) {
+			*error = "Failed to create decompression context";
+			return ER_DECOMPRESSION;
+		}
+	}
+	ZSTD_initDStream(netbox_zstream);
+	ibuf_reset(zbuf);
+	ZSTD_inBuffer input = {zdata, zsize, 0};
+	size_t rc;
+	do {
+		size_t size = ZSTD_DStreamOutSize();
+		void *dst = ibuf_reserve(zbuf, size);
+		if (dst == NULL) {
+			*error = "Failed to allocate decompression buffer";
+			return ER_MEMORY_ISSUE;
+		}
+		ZSTD_outBuffer output = {dst, ibuf_unused(zbuf), 0};
+		rc = ZSTD_decompressStream(netbox_zstream, &output, &input);
+		if (ZSTD_isError(rc)) {
+			*error = ZSTD_getErrorName(rc);
+			return ER_DECOMPRESSION;
+		}
+		zbuf->wpos += output.pos;
+		if (rc != 0 && input.pos == input.size &&
+		    output.pos < output.size) {
+			*error = "Truncated compressed body";
+			return ER_DECOMPRESSION;
+		}
+	} while (rc != 0);
+	*body = zbuf->rpos;
+	*body_end = zbuf->wpos;
+	return 0;
+}
+
+/**
+ * communicate_iproto(fd, send_buf, recv_buf, timeout, zbuf)
+ *  -> errno, error
+ *  -> nil, sync, status, schema_version, body_rpos, body_end
+ *
+ * Send data from send_buf and receive the next iproto response
+ * to recv_buf. The response header is decoded here, so that the
+ * worker fiber of a connection only has to dispatch the response
+ * by its sync and decode the body. A compressed body is
+ * decompressed to zbuf, valid until the next call.
+ */
+static int
+netbox_communicate_iproto(lua_State *L)
+{
+	uint32_t fd = lua_tonumber(L, 1);
+	struct ibuf *send_buf = (struct ibuf *) lua_topointer(L, 2);
+	struct ibuf *recv_buf = (struct ibuf *) lua_topointer(L, 3);
+	ev_tstamp timeout = TIMEOUT_INFINITY;
+	if (lua_type(L, 4) == LUA_TNUMBER)
+		timeout = lua_tonumber(L, 4);
+	struct ibuf *zbuf = NULL;
+	if (lua_gettop(L) >= 5 && !lua_isnil(L, 5))
+		zbuf = (struct ibuf *) lua_topointer(L, 5);
+	ev_tstamp deadline = ev_monotonic_now(loop()) + timeout;
+	const char *error;
+	int rc;
+	while (true) {
+		size_t data_len = ibuf_used(recv_buf);
+		size_t required = 5;
+		if (data_len >= required) {
+			const char *pos = recv_buf->rpos;
+			if (mp_typeof(*pos) != MP_UINT) {
+				error = "Invalid MsgPack - packet length";
+				rc = ER_INVALID_MSGPACK;
+				goto error;
+			}
+			ptrdiff_t missing = mp_check_uint(pos, recv_buf->wpos);
+			if (missing > 0) {
+				required = data_len + missing;
+			} else {
+				uint32_t len = mp_decode_uint(&pos);
+				required = (pos - recv_buf->rpos) + len;
+				if (data_len >= required)
+					break;
+			}
+		}
+		size_t unused;
+		rc = netbox_communicate_impl(L, fd, send_buf, recv_buf,
+					     required, NULL, 0,
+					     deadline - ev_monotonic_now(loop()),
+					     &unused, &error);
+		if (rc != 0)
+			goto error;
+	}
+	const char *pos = recv_buf->rpos;
+	uint32_t len = mp_decode_uint(&pos);
+	const char *body_end = pos + len;
+	uint64_t sync = 0, status = 0, schema_version = 0;
+	if (mp_typeof(*pos) != MP_MAP) {
+		error = "Invalid MsgPack - packet header";
+		rc = ER_INVALID_MSGPACK;
+		goto error;
+	}
+	uint32_t map_size = mp_decode_map(&pos);
+	for (uint32_t i = 0; i < map_size; ++i) {
+		if (mp_typeof(*pos) != MP_UINT) {
+			mp_next(&pos);
+			mp_next(&pos);
+			continue;
+		}
+		uint64_t key = mp_decode_uint(&pos);
+		uint64_t *value;
+		switch (key) {
+		case IPROTO_SYNC:
+			value = &sync;
+			break;
+		case IPROTO_REQUEST_TYPE:
+			value = &status;
+			break;
+		case IPROTO_SCHEMA_VERSION:
+			value = &schema_version;
+			break;
+		default:
+			mp_next(&pos);
+			continue;
+		}
+		if (mp_typeof(*pos) != MP_UINT) {
+			error = "Invalid MsgPack - packet header";
+			rc = ER_INVALID_MSGPACK;
+			goto error;
+		}
+		*value = mp_decode_uint(&pos);
+	}
+	recv_buf->rpos = (char *) body_end;
+	rc = netbox_decompress_body(zbuf, &pos, &body_end, &error);
+	if (rc != 0)
+		goto error;
+	lua_pushnil(L);
+	luaL_pushuint64(L, sync);
+	luaL_pushuint64(L, status);
+	luaL_pushuint64(L, schema_version);
+	*(const char **)luaL_pushcdata(L, CTID_CONST_CHAR_PTR) = pos;
+	*(const char **)luaL_pushcdata(L, CTID_CONST_CHAR_PTR) = body_end;
+	return 6;
+error:
+	lua_pushinteger(L, rc);
+	lua_pushstring(L, error);
 	return 2;
 }
 
@@ -569,10 +789,16 @@ netbox_encode_execute(lua_State *L)
 
 	mpstream_encode_map(&stream, 3);
 
-	size_t len;
-	const char *query = lua_tolstring(L, 3, &len);
-	mpstream_encode_uint(&stream, IPROTO_SQL_TEXT);
-	mpstream_encode_strn(&stream, query, len);
+	if (lua_type(L, 3) == LUA_TNUMBER) {
+		uint32_t stmt_id = lua_tointeger(L, 3);
+		mpstream_encode_uint(&stream, IPROTO_STMT_ID);
+		mpstream_encode_uint(&stream, stmt_id);
+	} else {
+		size_t len;
+		const char *query = lua_tolstring(L, 3, &len);
+		mpstream_encode_uint(&stream, IPROTO_SQL_TEXT);
+		mpstream_encode_strn(&stream, query, len);
+	}
 
 	mpstream_encode_uint(&stream, IPROTO_SQL_BIND);
 	luamp_encode_tuple(L, cfg, &stream, 4);
@@ -584,6 +810,26 @@ netbox_encode_execute(lua_State *L)
 	return 0;
 }
 
+static int
+netbox_encode_prepare(lua_State *L)
+{
+	if (lua_gettop(L) < 3)
+		return luaL_error(L, "Usage: netbox.encode_prepare(ibuf, "\
+				  "sync, query)");
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_PREPARE);
+
+	mpstream_encode_map(&stream, 1);
+
+	size_t len;
+	const char *query = lua_tolstring(L, 3, &len);
+	mpstream_encode_uint(&stream, IPROTO_SQL_TEXT);
+	mpstream_encode_strn(&stream, query, len);
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
 /**
  * Decode IPROTO_DATA into tuples array.
  * @param L Lua stack to push result on.
@@ -632,6 +878,102 @@ netbox_decode_select(struct lua_State *L)
 	return 2;
 }
 
+/**
+ * Find IPROTO_DATA in a response body.
+ * @param data MessagePack body, positioned at IPROTO_DATA
+ *        value on return.
+ * @param[out] end End of the body.
+ * @param[out] count Number of elements in IPROTO_DATA.
+ * @retval Whether the body has IPROTO_DATA.
+ */
+static bool
+netbox_find_data(const char **data, const char **end, uint32_t *count)
+{
+	assert(mp_typeof(**data) == MP_MAP);
+	*end = *data;
+	mp_next(end);
+	uint32_t map_size = mp_decode_map(data);
+	for (uint32_t i = 0; i < map_size; ++i) {
+		uint32_t key = mp_decode_uint(data);
+		if (key == IPROTO_DATA) {
+			*count = mp_decode_array(data);
+			return true;
+		}
+		mp_next(data);
+	}
+	*count = 0;
+	return false;
+}
+
+/**
+ * Decode a response body into the first tuple of IPROTO_DATA,
+ * or nil if it's empty, without creating a table for the rest.
+ * @param Lua stack[1] Raw MessagePack pointer.
+ * @retval Tuple or nil, position of the body end and, if there
+ *         is more than one tuple and it is a get request (stack[2]
+ *         is true), MORE_THAN_ONE_TUPLE error code.
+ */
+static int
+netbox_decode_tuple(struct lua_State *L)
+{
+	uint32_t ctypeid;
+	const char *data = *(const char **)luaL_checkcdata(L, 1, &ctypeid);
+	bool is_get = lua_toboolean(L, 2);
+	const char *end;
+	uint32_t count;
+	if (!netbox_find_data(&data, &end, &count) || count == 0 ||
+	    (is_get && count > 1)) {
+		lua_pushnil(L);
+	} else {
+		const char *begin = data;
+		mp_next(&data);
+		struct tuple *tuple =
+			box_tuple_new(box_tuple_format_default(), begin, data);
+		if (tuple == NULL)
+			luaT_error(L);
+		luaT_pushtuple(L, tuple);
+	}
+	*(const char **)luaL_pushcdata(L, ctypeid) = end;
+	if (is_get && count > 1) {
+		lua_pushinteger(L, ER_MORE_THAN_ONE_TUPLE);
+		return 3;
+	}
+	return 2;
+}
+
+/**
+ * Decode IPROTO_DATA of a response body into a Lua table, or,
+ * if stack[2] is true, only its first element into a Lua
+ * value. Used for call, eval, count and push responses.
+ * @param Lua stack[1] Raw MessagePack pointer.
+ * @retval Lua value and position of the body end.
+ */
+static int
+netbox_decode_data_value(struct lua_State *L)
+{
+	uint32_t ctypeid;
+	const char *data = *(const char **)luaL_checkcdata(L, 1, &ctypeid);
+	bool is_first = lua_toboolean(L, 2);
+	const char *end;
+	uint32_t count;
+	if (!netbox_find_data(&data, &end, &count)) {
+		lua_pushnil(L);
+	} else if (is_first) {
+		if (count == 0)
+			lua_pushnil(L);
+		else
+			luamp_decode(L, cfg, &data);
+	} else {
+		lua_createtable(L, count, 0);
+		for (uint32_t i = 0; i < count; ++i) {
+			luamp_decode(L, cfg, &data);
+			lua_rawseti(L, -2, i + 1);
+		}
+	}
+	*(const char **)luaL_pushcdata(L, ctypeid) = end;
+	return 2;
+}
+
 /**
  * Decode IPROTO_METADATA into array of maps.
  * @param L Lua stack to push result on.
@@ -703,6 +1045,71 @@ netbox_decode_sql_info(struct lua_State *L, const char **data)
 	}
 }
 
+/**
+ * Decode IPROTO_BIND_METADATA into array of maps.
+ * @param L Lua stack to push result on.
+ * @param data MessagePack.
+ */
+static void
+netbox_decode_bind_metadata(struct lua_State *L, const char **data)
+{
+	uint32_t count = mp_decode_array(data);
+	lua_createtable(L, count, 0);
+	for (uint32_t i = 0; i < count; ++i) {
+		uint32_t map_size = mp_decode_map(data);
+		assert(map_size == 1);
+		(void) map_size;
+		uint32_t key = mp_decode_uint(data);
+		assert(key == IPROTO_FIELD_NAME);
+		(void) key;
+		lua_createtable(L, 0, 1);
+		uint32_t len;
+		const char *str = mp_decode_str(data, &len);
+		lua_pushlstring(L, str, len);
+		lua_setfield(L, -2, "name");
+		lua_rawseti(L, -2, i + 1);
+	}
+}
+
+/**
+ * Decode a response on PREPARE into a map with keys stmt_id,
+ * param_count, params and, if the statement returns rows,
+ * metadata.
+ */
+static int
+netbox_decode_prepare(struct lua_State *L)
+{
+	uint32_t ctypeid;
+	const char *data = *(const char **)luaL_checkcdata(L, 1, &ctypeid);
+	assert(mp_typeof(*data) == MP_MAP);
+	uint32_t map_size = mp_decode_map(&data);
+	lua_createtable(L, 0, map_size);
+	for (uint32_t i = 0; i < map_size; ++i) {
+		uint32_t key = mp_decode_uint(&data);
+		switch(key) {
+		case IPROTO_STMT_ID:
+			lua_pushinteger(L, mp_decode_uint(&data));
+			lua_setfield(L, -2, "stmt_id");
+			break;
+		case IPROTO_BIND_COUNT:
+			lua_pushinteger(L, mp_decode_uint(&data));
+			lua_setfield(L, -2, "param_count");
+			break;
+		case IPROTO_BIND_METADATA:
+			netbox_decode_bind_metadata(L, &data);
+			lua_setfield(L, -2, "params");
+			break;
+		default:
+			assert(key == IPROTO_METADATA);
+			netbox_decode_metadata(L, &data);
+			lua_setfield(L, -2, "metadata");
+			break;
+		}
+	}
+	*(const char **)luaL_pushcdata(L, ctypeid) = data;
+	return 2;
+}
+
 static int
 netbox_decode_execute(struct lua_State *L)
 {
@@ -748,6 +1155,8 @@ netbox_decode_execute(struct lua_State *L)
 int
 luaopen_net_box(struct lua_State *L)
 {
+	CTID_CONST_CHAR_PTR = luaL_ctypeid(L, "const char *");
+	assert(CTID_CONST_CHAR_PTR != 0);
 	static const luaL_Reg net_box_lib[] = {
 		{ "encode_ping",    netbox_encode_ping },
 		{ "encode_call_16", netbox_encode_call_16 },
@@ -760,11 +1169,17 @@ luaopen_net_box(struct lua_State *L)
 		{ "encode_update",  netbox_encode_update },
 		{ "encode_upsert",  netbox_encode_upsert },
 		{ "encode_execute", netbox_encode_execute},
+		{ "encode_prepare", netbox_encode_prepare},
 		{ "encode_auth",    netbox_encode_auth },
+		{ "encode_compress", netbox_encode_compress },
 		{ "decode_greeting",netbox_decode_greeting },
 		{ "communicate",    netbox_communicate },
+		{ "communicate_iproto", netbox_communicate_iproto },
 		{ "decode_select",  netbox_decode_select },
+		{ "decode_tuple",   netbox_decode_tuple },
+		{ "decode_data",    netbox_decode_data_value },
 		{ "decode_execute", netbox_decode_execute },
+		{ "decode_prepare", netbox_decode_prepare },
 		{ NULL, NULL}
 	};
 	/* luaL_register_module polutes _G */
@@ -23,23 +23,25 @@ local check_space_arg     = box.internal.check_space_arg
 local check_primary_index = box.internal.check_primary_index
 
 local communicate     = internal.communicate
+local communicate_iproto = internal.communicate_iproto
 local encode_auth     = internal.encode_auth
+local encode_compress = internal.encode_compress
 local encode_select   = internal.encode_select
 local decode_greeting = internal.decode_greeting
 
 local TIMEOUT_INFINITY = 500 * 365 * 86400
+-- Weight of a new response time in the average one.
+local LATENCY_EWMA_WEIGHT = 0.2
 local VSPACE_ID        = 281
 local VINDEX_ID        = 289
 local DEFAULT_CONNECT_TIMEOUT = 10
 
-local IPROTO_STATUS_KEY    = 0x00
 local IPROTO_ERRNO_MASK    = 0x7FFF
-local IPROTO_SYNC_KEY      = 0x01
-local IPROTO_SCHEMA_VERSION_KEY = 0x05
 local IPROTO_METADATA_KEY = 0x32
 local IPROTO_SQL_INFO_KEY = 0x42
 local SQL_INFO_ROW_COUNT_KEY = 0
 local IPROTO_FIELD_NAME_KEY = 0
+local IPROTO_SQL_OPT_CHUNK_SIZE_KEY = 0
 local IPROTO_DATA_KEY      = 0x30
 local IPROTO_ERROR_KEY     = 0x31
 local IPROTO_GREETING_SIZE = 128
@@ -58,28 +60,23 @@ local is_final_state         = {closed = 1, error = 1}
 local function decode_nil(raw_data, raw_data_end)
     return nil, raw_data_end
 end
+local decode_data_value = internal.decode_data
+local decode_tuple_value = internal.decode_tuple
+--
+-- Response bodies are decoded in C right into tuples and Lua
+-- values, without decoding the body map into a Lua table first.
+--
 local function decode_data(raw_data)
-    local response, raw_end = decode(raw_data)
-    return response[IPROTO_DATA_KEY], raw_end
+    return decode_data_value(raw_data, false)
 end
 local function decode_tuple(raw_data)
-    local response, raw_end = internal.decode_select(raw_data)
-    return response[1], raw_end
+    return decode_tuple_value(raw_data, false)
 end
 local function decode_get(raw_data)
-    local body, raw_end = internal.decode_select(raw_data)
-    if body[2] then
-        return nil, raw_end, box.error.MORE_THAN_ONE_TUPLE
-    end
-    return body[1], raw_end
+    return decode_tuple_value(raw_data, true)
 end
-local function decode_count(raw_data)
-    local response, raw_end = decode(raw_data)
-    return response[IPROTO_DATA_KEY][1], raw_end
-end
-local function decode_push(raw_data)
-    local response, raw_end = decode(raw_data)
-    return response[IPROTO_DATA_KEY][1], raw_end
+local function decode_first(raw_data)
+    return decode_data_value(raw_data, true)
 end
 
 local method_encoder = {
@@ -94,6 +91,7 @@ local method_encoder = {
     upsert  = internal.encode_upsert,
     select  = internal.encode_select,
     execute = internal.encode_execute,
+    prepare = internal.encode_prepare,
     get     = internal.encode_select,
     min     = internal.encode_select,
     max     = internal.encode_select,
@@ -118,12 +116,13 @@ local method_decoder = {
     upsert  = decode_nil,
     select  = internal.decode_select,
     execute = internal.decode_execute,
+    prepare = internal.decode_prepare,
     get     = decode_get,
     min     = decode_get,
     max     = decode_get,
-    count   = decode_count,
+    count   = decode_first,
     inject  = decode_data,
-    push    = decode_push,
+    push    = decode_first,
 }
 
 local function next_id(id) return band(id + 1, 0x7FFFFFFF) end
@@ -210,6 +209,8 @@ local function on_push_sync_default(...) end
 --  'did_fetch_schema', schema_version, spaces, indices
 --  'reconnect_timeout'   -> get reconnect timeout if set and > 0,
 --                           else nil is returned.
+--  'compression_threshold' -> minimal size of a response body
+--                           the server should compress, or nil.
 --
 -- Suggestion for callback writers: sleep a few secs before approving
 -- reconnect.
@@ -237,11 +238,22 @@ local function create_transport(host, port, user, password, callback,
     -- Sync requests are implemented as async call + immediate
     -- wait for a result.
     local requests         = setmetatable({}, { __mode = 'v' })
+    -- Requests with a completion callback. They are kept here
+    -- until completion, since nobody may reference them else.
+    local callback_requests = {}
     local next_request_id  = 1
+    -- Number of requests waiting for a response and EWMA of
+    -- response time, used for load-aware routing by a pool.
+    -- Requests collected by GC without a response are counted
+    -- until the next error.
+    local in_flight        = 0
+    local latency          = 0
 
     local worker_fiber
     local send_buf         = buffer.ibuf(buffer.READAHEAD)
     local recv_buf         = buffer.ibuf(buffer.READAHEAD)
+    -- Decompressed body of the last received response.
+    local zbuf             = buffer.ibuf(buffer.READAHEAD)
 
     --
     -- Async request metamethods.
@@ -382,13 +394,60 @@ local function create_transport(host, port, user, password, callback,
         if self.id then
             requests[self.id] = nil
             self.id = nil
+            in_flight = in_flight - 1
             self.errno = box.error.PROC_LUA
             self.response = 'Response is discarded'
+            self.on_complete = nil
+            callback_requests[self] = nil
+        end
+    end
+
+    local function run_on_complete(callback, ...)
+        local ok, err = pcall(callback, ...)
+        if not ok then
+            log.error('net.box: on_complete callback failed: %s', err)
+        end
+    end
+    --
+    -- Call @a callback(result, error) when the request is
+    -- finished, as wait_result() would return. If the request is
+    -- already finished, the callback is called immediately.
+    -- Otherwise it is called by the fiber which completes the
+    -- request, usually the connection worker, so the callback
+    -- should not yield for long. Errors of the callback are
+    -- logged.
+    --
+    function request_index:on_complete(callback)
+        if type(callback) ~= 'function' then
+            error('Usage: future:on_complete(callback)')
+        end
+        if self:is_ready() then
+            run_on_complete(callback, self:result())
+            return
         end
+        self.on_complete = callback
+        callback_requests[self] = true
     end
 
     local request_mt = { __index = request_index }
 
+    --
+    -- Wake up the fibers waiting for a finished request and
+    -- run its completion callback.
+    --
+    local function complete_request(request)
+        in_flight = in_flight - 1
+        latency = latency + LATENCY_EWMA_WEIGHT *
+                  (fiber_clock() - request.start_time - latency)
+        request.cond:broadcast()
+        local callback = request.on_complete
+        if callback ~= nil then
+            request.on_complete = nil
+            callback_requests[request] = nil
+            run_on_complete(callback, request:result())
+        end
+    end
+
     -- STATE SWITCHING --
     local function set_state(new_state, new_errno, new_error)
         state = new_state
@@ -398,13 +457,15 @@ local function create_transport(host, port, user, password, callback,
         state_cond:broadcast()
         if state == 'error' or state == 'error_reconnect' or
            state == 'closed' then
-            for _, request in pairs(requests) do
+            local finished = requests
+            requests = {}
+            for _, request in pairs(finished) do
                 request.id = nil
                 request.errno = new_errno
                 request.response = new_error
-                request.cond:broadcast()
+                complete_request(request)
             end
-            requests = {}
+            in_flight = 0
         end
     end
 
@@ -497,15 +558,17 @@ local function create_transport(host, port, user, password, callback,
         local id = next_request_id
         method_encoder[method](send_buf, id, ...)
         next_request_id = next_id(id)
-        -- Request in most cases has maximum 8 members:
+        -- Request in most cases has maximum 9 members:
         -- method, buffer, id, cond, errno, response, on_push,
-        -- on_push_ctx.
-        local request = setmetatable(table_new(0, 8), request_mt)
+        -- on_push_ctx, start_time.
+        local request = setmetatable(table_new(0, 9), request_mt)
         request.method = method
         request.buffer = buffer
         request.id = id
         request.cond = fiber.cond()
+        request.start_time = fiber_clock()
         requests[id] = request
+        in_flight = in_flight + 1
         request.on_push = on_push
         request.on_push_ctx = on_push_ctx
         return request
@@ -526,13 +589,11 @@ local function create_transport(host, port, user, password, callback,
         return request:wait_result(timeout)
     end
 
-    local function dispatch_response_iproto(hdr, body_rpos, body_end)
-        local id = hdr[IPROTO_SYNC_KEY]
+    local function dispatch_response_iproto(id, status, body_rpos, body_end)
         local request = requests[id]
         if request == nil then -- nobody is waiting for the response
             return
         end
-        local status = hdr[IPROTO_STATUS_KEY]
         local body, body_end_check
 
         if status > IPROTO_CHUNK_KEY then
@@ -543,7 +604,7 @@ local function create_transport(host, port, user, password, callback,
             assert(body_end == body_end_check, "invalid xrow length")
             request.errno = band(status, IPROTO_ERRNO_MASK)
             request.response = body[IPROTO_ERROR_KEY]
-            request.cond:broadcast()
+            complete_request(request)
             return
         end
 
@@ -558,10 +619,11 @@ local function create_transport(host, port, user, password, callback,
                 request.response = body_len
                 requests[id] = nil
                 request.id = nil
+                complete_request(request)
             else
                 request.on_push(request.on_push_ctx, body_len)
+                request.cond:broadcast()
             end
-            request.cond:broadcast()
             return
         end
 
@@ -573,14 +635,15 @@ local function create_transport(host, port, user, password, callback,
             assert(real_end == body_end, "invalid body length")
             requests[id] = nil
             request.id = nil
+            complete_request(request)
         else
             local msg
             msg, real_end, request.errno =
                 method_decoder.push(body_rpos, body_end)
             assert(real_end == body_end, "invalid body length")
             request.on_push(request.on_push_ctx, msg)
+            request.cond:broadcast()
         end
-        request.cond:broadcast()
     end
 
     local function new_request_id()
@@ -595,29 +658,16 @@ local function create_transport(host, port, user, password, callback,
                            limit_or_boundary, timeout)
     end
 
+    --
+    -- Receive the next response. On error the sync is replaced
+    -- with the error message.
+    -- @retval errno, error Error occured.
+    -- @retval nil, sync, status, schema_version, body_rpos,
+    --         body_end The response is received.
+    --
     local function send_and_recv_iproto(timeout)
-        local data_len = recv_buf.wpos - recv_buf.rpos
-        local required = 0
-        if data_len < 5 then
-            required = 5
-        else
-            -- PWN! insufficient input validation
-            local bufpos = recv_buf.rpos
-            local len, rpos = decode(bufpos)
-            required = (rpos - bufpos) + len
-            if data_len >= required then
-                local body_end = rpos + len
-                local hdr, body_rpos = decode(rpos)
-                recv_buf.rpos = body_end
-                return nil, hdr, body_rpos, body_end
-            end
-        end
-        local deadline = fiber_clock() + (timeout or TIMEOUT_INFINITY)
-        local err, extra = send_and_recv(required, timeout)
-        if err then
-            return err, extra
-        end
-        return send_and_recv_iproto(max(0, deadline - fiber_clock()))
+        return communicate_iproto(connection:fd(), send_buf, recv_buf,
+                                  timeout, zbuf)
     end
 
     local function send_and_recv_console(timeout)
@@ -691,29 +741,44 @@ local function create_transport(host, port, user, password, callback,
             request.id = nil
             requests[rid] = nil
             request.response = response
-            request.cond:broadcast()
+            complete_request(request)
             return console_sm(next_id(rid))
         end
     end
 
+    --
+    -- Ask the server to compress big response bodies. The
+    -- response isn't waited for: compressed bodies are decoded
+    -- whenever they come, and a server that doesn't support
+    -- compression replies with an error, which is ignored.
+    --
+    local function request_compression()
+        local threshold = callback('compression_threshold')
+        if threshold then
+            encode_compress(send_buf, new_request_id(), threshold)
+        end
+    end
+
     iproto_auth_sm = function(salt)
         set_state('auth')
         if not user or not password then
+            request_compression()
             set_state('fetch_schema')
             return iproto_schema_sm()
         end
         encode_auth(send_buf, new_request_id(), user, password, salt)
-        local err, hdr, body_rpos, body_end = send_and_recv_iproto()
+        local err, id, status, schema_version, body_rpos =
+            send_and_recv_iproto()
         if err then
-            return error_sm(err, hdr)
+            return error_sm(err, id)
         end
-        if hdr[IPROTO_STATUS_KEY] ~= 0 then
-            local body
-            body, body_end = decode(body_rpos)
+        if status ~= 0 then
+            local body = decode(body_rpos)
             return error_sm(E_NO_CONNECTION, body[IPROTO_ERROR_KEY])
         end
+        request_compression()
         set_state('fetch_schema')
-        return iproto_schema_sm(hdr[IPROTO_SCHEMA_VERSION_KEY])
+        return iproto_schema_sm(schema_version)
     end
 
     iproto_schema_sm = function(schema_version)
@@ -731,17 +796,14 @@ local function create_transport(host, port, user, password, callback,
         schema_version = nil -- any schema_version will do provided that
                              -- it is consistent across responses
         repeat
-            local err, hdr, body_rpos, body_end = send_and_recv_iproto()
-            if err then return error_sm(err, hdr) end
-            dispatch_response_iproto(hdr, body_rpos, body_end)
-            local id = hdr[IPROTO_SYNC_KEY]
+            local err, id, status, response_schema_version, body_rpos,
+                  body_end = send_and_recv_iproto()
+            if err then return error_sm(err, id) end
+            dispatch_response_iproto(id, status, body_rpos, body_end)
             if id == select1_id or id == select2_id then
                 -- response to a schema query we've submitted
-                local status = hdr[IPROTO_STATUS_KEY]
-                local response_schema_version = hdr[IPROTO_SCHEMA_VERSION_KEY]
                 if status ~= 0 then
-                    local body
-                    body, body_end = decode(body_rpos)
+                    local body = decode(body_rpos)
                     return error_sm(E_NO_CONNECTION, body[IPROTO_ERROR_KEY])
                 end
                 if schema_version == nil then
@@ -750,8 +812,7 @@ local function create_transport(host, port, user, password, callback,
                     -- schema changed while fetching schema; restart loader
                     return iproto_schema_sm()
                 end
-                local body
-                body, body_end = decode(body_rpos)
+                local body = decode(body_rpos)
                 response[id] = body[IPROTO_DATA_KEY]
             end
         until response[select1_id] and response[select2_id]
@@ -762,17 +823,14 @@ local function create_transport(host, port, user, password, callback,
     end
 
     iproto_sm = function(schema_version)
-        local err, hdr, body_rpos, body_end = send_and_recv_iproto()
-        if err then return error_sm(err, hdr) end
-        dispatch_response_iproto(hdr, body_rpos, body_end)
-        local status = hdr[IPROTO_STATUS_KEY]
-        local response_schema_version = hdr[IPROTO_SCHEMA_VERSION_KEY]
+        local err, id, status, response_schema_version, body_rpos,
+              body_end = send_and_recv_iproto()
+        if err then return error_sm(err, id) end
+        dispatch_response_iproto(id, status, body_rpos, body_end)
         if response_schema_version > 0 and
            response_schema_version ~= schema_version then
             -- schema_version has been changed - start to load a new version.
             -- Sic: self.schema_version will be updated only after reload.
-            local body
-            body, body_end = decode(body_rpos)
             set_state('fetch_schema')
             return iproto_schema_sm(schema_version)
         end
@@ -783,6 +841,7 @@ local function create_transport(host, port, user, password, callback,
         if connection then connection:close(); connection = nil end
         send_buf:recycle()
         recv_buf:recycle()
+        zbuf:recycle()
         if state ~= 'closed' then
             if callback('reconnect_timeout') then
                 set_state('error_reconnect', err, msg)
@@ -792,12 +851,21 @@ local function create_transport(host, port, user, password, callback,
         end
     end
 
+    --
+    -- Get the number of requests waiting for a response and the
+    -- average response time in seconds.
+    --
+    local function load()
+        return in_flight, latency
+    end
+
     return {
         stop            = stop,
         start           = start,
         wait_state      = wait_state,
         perform_request = perform_request,
         perform_async_request = perform_async_request,
+        load            = load,
     }
 end
 
@@ -923,6 +991,11 @@ local function new_sm(host, port, opts, connection, greeting)
             return not opts.console
         elseif what == 'fetch_connect_timeout' then
             return opts.connect_timeout or DEFAULT_CONNECT_TIMEOUT
+        elseif what == 'compression_threshold' then
+            local threshold = opts.compression_threshold
+            if type(threshold) == 'number' and threshold > 0 then
+                return threshold
+            end
         elseif what == 'did_fetch_schema' then
             remote:_install_schema(...)
         elseif what == 'reconnect_timeout' then
@@ -1138,13 +1211,61 @@ function remote_methods:eval(code, args, opts)
     return unpack(res)
 end
 
+--
+-- With sql_opts.chunk_size the server pushes rows of the result
+-- in chunks as soon as they are ready. The chunks are passed to
+-- netbox_opts.on_push if it is set. Otherwise they are collected
+-- and returned along with the rest of the rows.
+--
 function remote_methods:execute(query, parameters, sql_opts, netbox_opts)
     check_remote_arg(self, "execute")
+    local options = {}
     if sql_opts ~= nil then
-        box.error(box.error.UNSUPPORTED, "execute", "options")
+        for k, v in pairs(sql_opts) do
+            if k ~= 'chunk_size' then
+                box.error(box.error.UNSUPPORTED, "execute", "options")
+            end
+            if type(v) ~= 'number' or v <= 0 or v ~= math.floor(v) then
+                box.error(box.error.ILLEGAL_PARAMS,
+                          "chunk_size should be a positive integer")
+            end
+            options[IPROTO_SQL_OPT_CHUNK_SIZE_KEY] = v
+        end
+    end
+    if next(options) == nil or (netbox_opts ~= nil and
+       (netbox_opts.on_push ~= nil or netbox_opts.is_async or
+        netbox_opts.buffer ~= nil)) then
+        return self:_request('execute', netbox_opts, query, parameters or {},
+                             options)
+    end
+    local chunks = {}
+    local opts = {on_push = table.insert, on_push_ctx = chunks}
+    if netbox_opts ~= nil then
+        opts.timeout = netbox_opts.timeout
+    end
+    local res = self:_request('execute', opts, query, parameters or {},
+                              options)
+    if #chunks > 0 then
+        local rows = {}
+        for _, chunk in ipairs(chunks) do
+            for _, row in ipairs(chunk) do
+                table.insert(rows, row)
+            end
+        end
+        for _, row in ipairs(res.rows or {}) do
+            table.insert(rows, row)
+        end
+        res.rows = rows
     end
-    return self:_request('execute', netbox_opts, query, parameters or {},
-                         sql_opts or {})
+    return res
+end
+
+function remote_methods:prepare(query, netbox_opts)
+    check_remote_arg(self, "prepare")
+    if type(query) ~= 'string' then
+        box.error(box.error.ILLEGAL_PARAMS, "SQL query is expected")
+    end
+    return self:_request('prepare', netbox_opts, query)
 end
 
 function remote_methods:wait_state(state, timeout)
@@ -1264,6 +1385,158 @@ function remote_methods:_install_schema(schema_version, spaces, indices)
     self._on_schema_reload:run(self)
 end
 
+--
+-- A pipeline collects requests and sends them all at once on
+-- flush(). The requests are encoded into the send buffer of the
+-- connection one after another without yields, so the worker
+-- fiber writes them to the socket in one go and there is no
+-- need in a fiber per request to have them all in flight.
+--
+-- Requests are added with the methods of the same names and
+-- arguments as the ones of the connection, except that space
+-- and index requests take the space or index object first:
+--
+--  pipeline:select(conn.space.test, key, opts)
+--  pipeline:update(conn.space.test.index.sk, key, ops, opts)
+--  pipeline:call(func_name, args, opts)
+--
+-- The results are the same as the ones of the futures returned
+-- by the methods with {is_async = true}.
+--
+local pipeline_methods = {}
+local pipeline_mt = { __index = pipeline_methods }
+
+--
+-- Method name -> position of its options argument. Methods
+-- with negative positions are called on the connection itself.
+--
+local pipeline_requests = {
+    select = 2, get = 2, min = 2, max = 2, count = 2, insert = 2,
+    replace = 2, delete = 2, update = 3, upsert = 3,
+    call = -3, eval = -3, execute = -4,
+}
+
+local function check_pipeline_arg(pipeline, method)
+    if type(pipeline) ~= 'table' or getmetatable(pipeline) ~= pipeline_mt then
+        local fmt = 'Use pipeline:%s(...) instead of pipeline.%s(...)'
+        box.error(E_PROC_LUA, string.format(fmt, method, method))
+    end
+end
+
+for method, pos in pairs(pipeline_requests) do
+    pipeline_methods[method] = function(self, ...)
+        check_pipeline_arg(self, method)
+        if self._futures ~= nil then
+            box.error(E_PROC_LUA, 'The pipeline is already flushed')
+        end
+        local object, args, argc
+        local opts_pos = pos
+        if opts_pos < 0 then
+            opts_pos = -opts_pos
+            object = self._remote
+            args, argc = {...}, select('#', ...)
+        else
+            object = ...
+            args, argc = {select(2, ...)}, select('#', ...) - 1
+            if type(object) ~= 'table' or
+               type(object[method]) ~= 'function' then
+                local fmt = 'Usage: pipeline:%s(space_or_index, ...)'
+                box.error(E_PROC_LUA, string.format(fmt, method))
+            end
+        end
+        local opts = args[opts_pos]
+        if opts ~= nil and type(opts) ~= 'table' then
+            local fmt = 'Usage: pipeline:%s(...): opts must be a table'
+            box.error(E_PROC_LUA, string.format(fmt, method))
+        end
+        local async_opts = {}
+        for k, v in pairs(opts or {}) do
+            async_opts[k] = v
+        end
+        async_opts.is_async = true
+        args[opts_pos] = async_opts
+        table.insert(self._requests, {object = object, method = method,
+                                      args = args, argc = max(argc, opts_pos)})
+        return #self._requests
+    end
+end
+
+function remote_methods:pipeline()
+    check_remote_arg(self, 'pipeline')
+    return setmetatable({_remote = self, _requests = {}}, pipeline_mt)
+end
+
+--
+-- Send all the collected requests. A request which can't be
+-- sent fails with the error it raised.
+--
+function pipeline_methods:flush()
+    check_pipeline_arg(self, 'flush')
+    if self._futures ~= nil then
+        return
+    end
+    local count = #self._requests
+    local futures = table_new(count, 0)
+    local errors = {}
+    for i, request in ipairs(self._requests) do
+        local object = request.object
+        local ok, future, err = pcall(object[request.method], object,
+                                      unpack(request.args, 1, request.argc))
+        if not ok then
+            errors[i] = future
+        elseif future == nil then
+            errors[i] = err or box.error.new(E_NO_CONNECTION)
+        else
+            futures[i] = future
+        end
+    end
+    self._futures = futures
+    self._errors = errors
+    self._count = count
+    self._requests = nil
+end
+
+--
+-- Flush the pipeline and wait for responses to all its requests
+-- max timeout seconds.
+-- @param timeout Max seconds to wait.
+-- @retval results, nil Success, the responses are returned in
+--         the order of the requests.
+-- @retval nil, error A request failed or the timeout expired.
+--
+function pipeline_methods:wait_result(timeout)
+    check_pipeline_arg(self, 'wait_result')
+    if timeout ~= nil and (type(timeout) ~= 'number' or timeout < 0) then
+        error('Usage: pipeline:wait_result(timeout)')
+    end
+    self:flush()
+    local deadline = fiber_clock() + (timeout or TIMEOUT_INFINITY)
+    local results = table_new(self._count, 0)
+    for i = 1, self._count do
+        if self._errors[i] ~= nil then
+            return nil, self._errors[i]
+        end
+        local res, err =
+            self._futures[i]:wait_result(max(0, deadline - fiber_clock()))
+        if err then
+            return nil, err
+        end
+        results[i] = res
+    end
+    return results
+end
+
+--
+-- Make the connection forget about responses to the requests
+-- of the pipeline.
+--
+function pipeline_methods:discard()
+    check_pipeline_arg(self, 'discard')
+    for _, future in pairs(self._futures or {}) do
+        future:discard()
+    end
+end
+
 -- console methods
 console_methods.close = remote_methods.close
 console_methods.on_schema_reload = remote_methods.on_schema_reload
@@ -1418,11 +1691,186 @@ index_metatable = function(remote)
     return { __index = methods, __metatable = false }
 end
 
+--
+-- A pool of connections to instances of a replica set. Read
+-- requests are routed to the least loaded connected instance,
+-- write requests to the least loaded master, i.e. an instance
+-- with box.info.ro false. The load of an instance is the number
+-- of requests waiting for a response at its transport times the
+-- average response time. Read only state of instances is fetched
+-- on connect and on each schema reload. An instance with unknown
+-- state, e.g. because the user can't eval, gets writes only if
+-- there is no known master.
+--
+local pool_methods = {}
+local pool_mt
+
+-- Response time of an idle connection, to order idle ones.
+local POOL_MIN_LATENCY = 1e-4
+
+local function pool_fetch_ro(member)
+    local future = member.conn:eval('return box.info.ro', {},
+                                    {is_async = true})
+    if future == nil then
+        return
+    end
+    future:on_complete(function(res, err)
+        if err == nil then
+            member.ro = res[1]
+        end
+    end)
+end
+
+local function pool_check_mode(mode, method)
+    if mode ~= 'read' and mode ~= 'write' then
+        box.error(E_PROC_LUA, string.format("pool:%s(): mode should be "..
+                                            "'read' or 'write'", method))
+    end
+end
+
+--
+-- Get the connection a request should be sent to.
+-- @param mode 'read' or 'write'.
+--
+local function pool_route(pool, mode)
+    local best, best_rank, best_load
+    for _, member in ipairs(pool.members) do
+        local conn = member.conn
+        if not conn:is_connected() or (mode == 'write' and member.ro) then
+            goto continue
+        end
+        do
+            local rank = (mode == 'write' and member.ro == nil) and 1 or 0
+            local in_flight, latency = conn._transport.load()
+            local load = (in_flight + 1) * max(latency, POOL_MIN_LATENCY)
+            if best == nil or rank < best_rank or
+               (rank == best_rank and load < best_load) then
+                best, best_rank, best_load = conn, rank, load
+            end
+        end
+    ::continue::
+    end
+    if best == nil then
+        box.error(E_NO_CONNECTION)
+    end
+    return best
+end
+
+local function check_pool_arg(pool, method)
+    if type(pool) ~= 'table' or getmetatable(pool) ~= pool_mt then
+        local fmt = 'Use pool:%s(...) instead of pool.%s(...)'
+        box.error(E_PROC_LUA, string.format(fmt, method, method))
+    end
+end
+
+--
+-- Get a connection for requests of @a mode, 'read' by default.
+--
+function pool_methods:connection(mode)
+    check_pool_arg(self, 'connection')
+    mode = mode or 'read'
+    pool_check_mode(mode, 'connection')
+    return pool_route(self, mode)
+end
+
+-- Method name -> position of its options and default mode.
+local pool_requests = {
+    call = {3, 'write'}, eval = {3, 'write'}, execute = {4, 'write'},
+}
+-- Space method name -> position of its options and default mode.
+local pool_space_requests = {
+    select = {2, 'read'}, get = {2, 'read'}, insert = {2, 'write'},
+    replace = {2, 'write'}, delete = {2, 'write'}, update = {3, 'write'},
+    upsert = {3, 'write'},
+}
+
+for method, params in pairs(pool_requests) do
+    pool_methods[method] = function(self, ...)
+        check_pool_arg(self, method)
+        local opts = select(params[1], ...)
+        local mode = type(opts) == 'table' and opts.mode or params[2]
+        pool_check_mode(mode, method)
+        local conn = pool_route(self, mode)
+        return conn[method](conn, ...)
+    end
+end
+
+for method, params in pairs(pool_space_requests) do
+    pool_methods[method] = function(self, space_name, ...)
+        check_pool_arg(self, method)
+        local opts = select(params[1], ...)
+        local mode = type(opts) == 'table' and opts.mode or params[2]
+        pool_check_mode(mode, method)
+        local conn = pool_route(self, mode)
+        local space = conn.space[space_name]
+        if space == nil then
+            box.error(box.error.NO_SUCH_SPACE, tostring(space_name))
+        end
+        return space[method](space, ...)
+    end
+end
+
+--
+-- Return state, read only flag, number of requests in flight
+-- and average response time of each connection.
+--
+function pool_methods:info()
+    check_pool_arg(self, 'info')
+    local info = {}
+    for i, member in ipairs(self.members) do
+        local in_flight, latency = member.conn._transport.load()
+        info[i] = {uri = member.uri, state = member.conn.state,
+                   ro = member.ro, in_flight = in_flight, latency = latency}
+    end
+    return info
+end
+
+function pool_methods:close()
+    check_pool_arg(self, 'close')
+    for _, member in ipairs(self.members) do
+        member.conn:close()
+    end
+end
+
+pool_mt = {
+    __index = pool_methods,
+    __serialize = function(pool) return pool:info() end,
+}
+
+--
+-- Create a connection pool.
+-- @param uris Array of URIs of the instances.
+-- @param opts Options of the connections, see connect().
+--
+local function pool(uris, opts)
+    if type(uris) ~= 'table' or #uris == 0 or
+       (opts ~= nil and type(opts) ~= 'table') then
+        error('Usage: netbox.pool({uri1, uri2, ...}, [opts])')
+    end
+    local members = {}
+    for i, uri in ipairs(uris) do
+        -- connect() takes the password out of opts.
+        local conn_opts = {}
+        for k, v in pairs(opts or {}) do
+            conn_opts[k] = v
+        end
+        local member = {uri = uri}
+        member.conn = connect(uri, conn_opts)
+        member.conn:on_schema_reload(function() pool_fetch_ro(member) end)
+        if member.conn:is_connected() then
+            pool_fetch_ro(member)
+        end
+        members[i] = member
+    end
+    return setmetatable({members = members}, pool_mt)
+end
+
 local this_module = {
     create_transport = create_transport,
     connect = connect,
     new = connect, -- Tarantool < 1.7.1 compatibility,
     wrap = wrap,
+    pool = pool,
     establish_connection = establish_connection,
 }
 
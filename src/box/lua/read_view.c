@@ -0,0 +1,284 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "box/lua/read_view.h"
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+#include <msgpuck.h>
+
+#include "diag.h"
+#include "fiber.h"
+#include "trivia/util.h"
+#include "lua/utils.h"
+
+#include "box/box.h"
+#include "box/error.h"
+#include "box/engine.h"
+#include "box/schema.h"
+#include "box/space.h"
+#include "box/tuple.h"
+#include "box/memtx_engine.h"
+#include "box/memtx_read_view.h"
+#include "box/lua/tuple.h"
+#include "box/lua/misc.h" /* lbox_encode_tuple_on_gc() */
+
+static const char *read_viewlib_name = "box.read_view";
+
+static struct memtx_read_view **
+lbox_checkreadview(struct lua_State *L, int narg)
+{
+	return (struct memtx_read_view **)
+		luaL_checkudata(L, narg, read_viewlib_name);
+}
+
+static struct memtx_read_view *
+lbox_checkopenreadview(struct lua_State *L, int narg, const char *src)
+{
+	struct memtx_read_view *rv = *lbox_checkreadview(L, narg);
+	if (rv == NULL)
+		luaL_error(L, "%s: the read view is closed", src);
+	return rv;
+}
+
+/**
+ * Convert a space or index identifier passed to rv:pairs()
+ * to a numeric id. Names are resolved against the current
+ * schema, not the one of the read view.
+ */
+static uint32_t
+lbox_read_view_checkid(struct lua_State *L, int narg, uint32_t space_id)
+{
+	if (lua_type(L, narg) == LUA_TNUMBER)
+		return lua_tointeger(L, narg);
+	size_t len;
+	const char *name = luaL_checklstring(L, narg, &len);
+	if (space_id == BOX_ID_NIL) {
+		uint32_t id = box_space_id_by_name(name, len);
+		if (id == BOX_ID_NIL) {
+			diag_set(ClientError, ER_NO_SUCH_SPACE, name);
+			luaT_error(L);
+		}
+		return id;
+	}
+	struct space *space = space_by_id(space_id);
+	if (space == NULL) {
+		diag_set(ClientError, ER_NO_SUCH_SPACE, int2str(space_id));
+		luaT_error(L);
+	}
+	uint32_t id = box_index_id_by_name(space_id, name, len);
+	if (id == BOX_ID_NIL)
+		luaL_error(L, "No index '%s' is defined in space '%s'",
+			   name, space_name(space));
+	return id;
+}
+
+static int
+lbox_read_view_next(struct lua_State *L)
+{
+	struct memtx_read_view *rv =
+		*lbox_checkreadview(L, lua_upvalueindex(1));
+	struct memtx_read_view_entry *entry =
+		(struct memtx_read_view_entry *)
+		lua_touserdata(L, lua_upvalueindex(2));
+	if (rv == NULL)
+		return luaL_error(L, "read_view: the read view is closed");
+	uint32_t size;
+	const char *data = memtx_read_view_entry_next(entry, &size);
+	if (data == NULL) {
+		if (!diag_is_empty(diag_get()))
+			return luaT_error(L);
+		return 0;
+	}
+	struct tuple *tuple = box_tuple_new(box_tuple_format_default(),
+					    data, data + size);
+	if (tuple == NULL)
+		return luaT_error(L);
+	lua_pushinteger(L, luaL_optinteger(L, 2, 0) + 1);
+	luaT_pushtuple(L, tuple);
+	return 2;
+}
+
+static int
+lbox_read_view_pairs(struct lua_State *L)
+{
+	if (lua_gettop(L) < 2 || lua_gettop(L) > 3)
+		return luaL_error(L, "Usage: read_view:pairs(space[, index])");
+	struct memtx_read_view *rv =
+		lbox_checkopenreadview(L, 1, "read_view:pairs()");
+	uint32_t space_id = lbox_read_view_checkid(L, 2, BOX_ID_NIL);
+	uint32_t index_id = 0;
+	if (!lua_isnoneornil(L, 3))
+		index_id = lbox_read_view_checkid(L, 3, space_id);
+	struct memtx_read_view_entry *entry =
+		memtx_read_view_scan(rv, space_id, index_id);
+	if (entry == NULL)
+		return luaT_error(L);
+	/* The iterator refers to the read view, keep it alive. */
+	lua_pushvalue(L, 1);
+	lua_pushlightuserdata(L, entry);
+	lua_pushcclosure(L, lbox_read_view_next, 2);
+	lua_pushnil(L);
+	lua_pushinteger(L, 0);
+	return 3;
+}
+
+static int
+lbox_read_view_close(struct lua_State *L)
+{
+	struct memtx_read_view **prv = lbox_checkreadview(L, 1);
+	if (*prv != NULL) {
+		memtx_read_view_delete(*prv);
+		*prv = NULL;
+	}
+	return 0;
+}
+
+static int
+lbox_read_view_serialize(struct lua_State *L)
+{
+	struct memtx_read_view *rv = *lbox_checkreadview(L, 1);
+	lua_pushstring(L, rv != NULL ? "read view" : "read view (closed)");
+	return 1;
+}
+
+/**
+ * Encode the key stored in field @a name of the options table
+ * at @a narg. Returns NULL if the field is nil. The key is
+ * allocated on the fiber region.
+ */
+static const char *
+lbox_read_view_checkkey(struct lua_State *L, int narg, const char *name,
+			struct index *index, uint32_t *part_count)
+{
+	lua_getfield(L, narg, name);
+	if (lua_isnil(L, -1)) {
+		lua_pop(L, 1);
+		return NULL;
+	}
+	size_t size;
+	const char *key = lbox_encode_tuple_on_gc(L, lua_gettop(L), &size);
+	lua_pop(L, 1);
+	*part_count = mp_decode_array(&key);
+	if (key_validate(index->def, ITER_GE, key, *part_count) != 0)
+		luaT_error(L);
+	return key;
+}
+
+/**
+ * Open a read view of a key range of one index, see
+ * memtx_read_view_new_range(). The view contains the only
+ * index, which is scanned with rv:pairs() as usual.
+ */
+static struct memtx_read_view *
+lbox_read_view_new_range(struct lua_State *L, int narg,
+			 struct memtx_engine *memtx)
+{
+	lua_getfield(L, narg, "space");
+	if (lua_isnil(L, -1))
+		luaL_error(L, "box.read_view: option 'space' is required");
+	uint32_t space_id = lbox_read_view_checkid(L, lua_gettop(L),
+						   BOX_ID_NIL);
+	lua_pop(L, 1);
+	uint32_t index_id = 0;
+	lua_getfield(L, narg, "index");
+	if (!lua_isnil(L, -1))
+		index_id = lbox_read_view_checkid(L, lua_gettop(L), space_id);
+	lua_pop(L, 1);
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		luaT_error(L);
+	if (!space_is_memtx(space)) {
+		diag_set(ClientError, ER_UNSUPPORTED, space->engine->name,
+			 "read view");
+		luaT_error(L);
+	}
+	struct index *index = index_find(space, index_id);
+	if (index == NULL)
+		luaT_error(L);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t begin_parts = 0, end_parts = 0;
+	const char *begin = lbox_read_view_checkkey(L, narg, "from", index,
+						    &begin_parts);
+	const char *end = lbox_read_view_checkkey(L, narg, "to", index,
+						  &end_parts);
+	struct memtx_read_view *rv = memtx_read_view_new_range(
+		memtx, index, begin, begin_parts, end, end_parts);
+	region_truncate(region, region_svp);
+	return rv;
+}
+
+static int
+lbox_read_view_new(struct lua_State *L)
+{
+	if (!lua_isnoneornil(L, 1) && !lua_istable(L, 1))
+		return luaL_error(L, "Usage: box.read_view([{space = <space>, "
+				  "index = <index>, from = <key>, "
+				  "to = <key>}])");
+	struct memtx_engine *memtx =
+		(struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	struct memtx_read_view **prv = (struct memtx_read_view **)
+		lua_newuserdata(L, sizeof(*prv));
+	*prv = NULL;
+	luaL_getmetatable(L, read_viewlib_name);
+	lua_setmetatable(L, -2);
+	if (lua_istable(L, 1))
+		*prv = lbox_read_view_new_range(L, 1, memtx);
+	else
+		*prv = memtx_read_view_new(memtx);
+	if (*prv == NULL)
+		return luaT_error(L);
+	return 1;
+}
+
+static const struct luaL_Reg lbox_read_view_meta[] = {
+	{"__gc", lbox_read_view_close},
+	{"__serialize", lbox_read_view_serialize},
+	{"__tostring", lbox_read_view_serialize},
+	{"pairs", lbox_read_view_pairs},
+	{"close", lbox_read_view_close},
+	{NULL, NULL}
+};
+
+static const struct luaL_Reg lbox_read_view_lib[] = {
+	{"read_view", lbox_read_view_new},
+	{NULL, NULL}
+};
+
+void
+box_lua_read_view_init(struct lua_State *L)
+{
+	luaL_register_type(L, read_viewlib_name, lbox_read_view_meta);
+	luaL_register(L, "box", lbox_read_view_lib);
+	lua_pop(L, 1);
+}
@@ -40,6 +40,9 @@ ffi.cdef[[
     int
     box_iterator_next(box_iterator_t *itr, box_tuple_t **result);
     void
+    box_iterator_set_auto_yield(box_iterator_t *itr, uint32_t steps,
+                                double timeout);
+    void
     box_iterator_free(box_iterator_t *itr);
     /** \endcond public */
     /** \cond public */
@@ -70,6 +73,8 @@ ffi.cdef[[
     box_txn_id();
     int
     box_txn_begin();
+    int
+    box_txn_begin_ro();
     /** \endcond public */
     typedef struct txn_savepoint box_txn_savepoint_t;
 
@@ -101,6 +106,13 @@ ffi.cdef[[
                const char *key, const char *key_end,
                struct port *port);
 
+    int
+    box_insert(uint32_t space_id, const char *tuple, const char *tuple_end,
+               box_tuple_t **result);
+    int
+    box_replace(uint32_t space_id, const char *tuple, const char *tuple_end,
+                box_tuple_t **result);
+
     void password_prepare(const char *password, int len,
                           char *out, int out_len);
 
@@ -203,6 +215,21 @@ local function sequence_resolve(name_or_id)
     end
 end
 
+-- Return the id of a function used by a functional index.
+local function func_resolve(name_or_id)
+    local _vfunc = box.space[box.schema.VFUNC_ID]
+    local tuple
+    if type(name_or_id) == 'string' then
+        tuple = _vfunc.index.name:get{name_or_id}
+    else
+        tuple = _vfunc:get{name_or_id}
+    end
+    if tuple == nil then
+        box.error(box.error.NO_SUCH_FUNCTION, tostring(name_or_id))
+    end
+    return tuple[1]
+end
+
 -- Revoke all privileges associated with the given object.
 local function revoke_object_privs(object_type, object_id)
     local _vpriv = box.space[box.schema.VPRIV_ID]
@@ -317,8 +344,13 @@ local function update_param_table(table, defaults)
     return new_table
 end
 
-box.begin = function()
-    if builtin.box_txn_begin() == -1 then
+box.begin = function(opts)
+    check_param_table(opts, {read_only = 'boolean'})
+    local begin = builtin.box_txn_begin
+    if opts ~= nil and opts.read_only then
+        begin = builtin.box_txn_begin_ro
+    end
+    if begin() == -1 then
         box.error()
     end
 end
@@ -431,6 +463,10 @@ box.schema.space.create = function(name, options)
         format = 'table',
         is_local = 'boolean',
         temporary = 'boolean',
+        memory_quota = 'number',
+        compression_threshold = 'number',
+        is_sync = 'boolean',
+        fixed_width = 'boolean',
     }
     local options_defaults = {
         engine = 'memtx',
@@ -475,6 +511,10 @@ box.schema.space.create = function(name, options)
     local space_options = setmap({
         group_id = options.is_local and 1 or nil,
         temporary = options.temporary and true or nil,
+        memory_quota = options.memory_quota,
+        compression_threshold = options.compression_threshold,
+        is_sync = options.is_sync and true or nil,
+        fixed_width = options.fixed_width and true or nil,
     })
     _space:insert{id, uid, name, options.engine, options.field_count,
         space_options, format}
@@ -734,6 +774,35 @@ local function update_index_parts(format, parts)
     return result, parts_can_be_simplified
 end
 
+--
+-- Convert a list of field names or one-based numbers passed
+-- in option @name into zero-based field numbers.
+--
+local function resolve_field_list(format, fields, name)
+    if type(fields) ~= 'table' then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "options." .. name .. " parameter should be a table")
+    end
+    local result = {}
+    for i, field in ipairs(fields) do
+        local idx = field
+        if type(field) == 'string' then
+            idx = format_field_index_by_name(format, field)
+            if idx == nil then
+                box.error(box.error.ILLEGAL_PARAMS,
+                          "options." .. name .. "[" .. i .. "]: " ..
+                          "field was not found by name '" .. field .. "'")
+            end
+        elseif type(field) ~= 'number' or field <= 0 then
+            box.error(box.error.ILLEGAL_PARAMS,
+                      "options." .. name .. "[" .. i .. "]: " ..
+                      "field (name or one-based number) is expected")
+        end
+        table.insert(result, idx - 1)
+    end
+    return result
+end
+
 --
 -- Convert index parts into 1.6.6 format if they
 -- doesn't use collation and is_nullable options
@@ -758,9 +827,22 @@ local index_options = {
     distance = 'string',
     run_count_per_level = 'number',
     run_size_ratio = 'number',
+    compaction_strategy = 'string',
     range_size = 'number',
     page_size = 'number',
     bloom_fpr = 'number',
+    covered_fields = 'table',
+    blob_threshold = 'number',
+    page_restart_interval = 'number',
+    columnar = 'boolean',
+    zone_map_fields = 'table',
+    compression_dict_size = 'number',
+    sparse = 'boolean',
+    size_hint = 'number',
+    expire = 'boolean',
+    func = 'number, string',
+    store_key = 'boolean',
+    hash_func = 'string',
 }
 
 --
@@ -865,8 +947,31 @@ box.schema.index.create = function(space_id, name, options)
             range_size = options.range_size,
             run_count_per_level = options.run_count_per_level,
             run_size_ratio = options.run_size_ratio,
+            compaction_strategy = options.compaction_strategy,
             bloom_fpr = options.bloom_fpr,
+            blob_threshold = options.blob_threshold,
+            page_restart_interval = options.page_restart_interval,
+            columnar = options.columnar,
+            compression_dict_size = options.compression_dict_size,
+            sparse = options.sparse,
+            size_hint = options.size_hint,
+            expire = options.expire,
+            store_key = options.store_key,
+            hash_func = options.hash_func,
     }
+    if options.func ~= nil then
+        index_opts.func = func_resolve(options.func)
+    end
+    if options.covered_fields ~= nil then
+        index_opts.covered_fields =
+            resolve_field_list(format, options.covered_fields,
+                               'covered_fields')
+    end
+    if options.zone_map_fields ~= nil then
+        index_opts.zone_map_fields =
+            resolve_field_list(format, options.zone_map_fields,
+                               'zone_map_fields')
+    end
     local field_type_aliases = {
         num = 'unsigned'; -- Deprecated since 1.7.2
         uint = 'unsigned';
@@ -1018,6 +1123,19 @@ box.schema.index.alter = function(space_id, index_id, options)
             index_opts[k] = options[k]
         end
     end
+    if options.func ~= nil then
+        index_opts.func = func_resolve(options.func)
+    end
+    if options.covered_fields ~= nil then
+        index_opts.covered_fields =
+            resolve_field_list(format, options.covered_fields,
+                               'covered_fields')
+    end
+    if options.zone_map_fields ~= nil then
+        index_opts.zone_map_fields =
+            resolve_field_list(format, options.zone_map_fields,
+                               'zone_map_fields')
+    end
     if options.parts then
         local parts_can_be_simplified
         parts, parts_can_be_simplified =
@@ -1080,15 +1198,43 @@ end
 -- a static box_tuple_t ** instance for calling box_index_* API
 local ptuple = ffi.new('box_tuple_t *[1]')
 
+local ibuf_t = ffi.typeof('struct ibuf')
+local tuple_batch_t = ffi.typeof('struct tuple_batch')
+
 local function keify(key)
     if key == nil then
         return {}
     elseif type(key) == "table" or is_tuple(key) then
         return key
+    elseif ffi.istype(ibuf_t, key) then
+        return (msgpack.decode(key.rpos, key.wpos - key.rpos))
     end
     return {key}
 end
 
+--
+-- A key may be passed already encoded in a buffer, so that
+-- a handler can reuse it without encoding per call.
+--
+local function key_encode(key)
+    if ffi.istype(ibuf_t, key) then
+        return key.rpos, key.wpos
+    end
+    return tuple_encode(key)
+end
+
+-- Return the tuple batch to select to, see box.tuple.batch().
+local function check_select_batch(opts)
+    if type(opts) ~= 'table' or opts.batch == nil then
+        return nil
+    end
+    if not ffi.istype(tuple_batch_t, opts.batch) then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "options parameter 'batch' should be a tuple batch")
+    end
+    return opts.batch
+end
+
 local iterator_t = ffi.typeof('struct iterator')
 ffi.metatype(iterator_t, {
     __tostring = function(iterator)
@@ -1180,6 +1326,7 @@ local function check_primary_index(space)
     return pk
 end
 box.internal.check_primary_index = check_primary_index -- for net.box
+box.internal.check_param_table = check_param_table -- for box.transfer
 
 box.internal.schema_version = builtin.box_schema_version
 
@@ -1210,6 +1357,24 @@ end
 
 internal.check_iterator_type = check_iterator_type -- export for net.box
 
+-- Returns auto-yield steps and timeout set in pairs() options.
+local function check_auto_yield(opts)
+    if type(opts) ~= 'table' then
+        return 0, 0
+    end
+    local steps = opts.yield_every or 0
+    local timeout = opts.yield_timeout or 0
+    if type(steps) ~= 'number' or steps < 0 then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "yield_every should be a non-negative number")
+    end
+    if type(timeout) ~= 'number' or timeout < 0 then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "yield_timeout should be a non-negative number")
+    end
+    return steps, timeout
+end
+
 local base_index_mt = {}
 base_index_mt.__index = base_index_mt
 --
@@ -1231,8 +1396,12 @@ setmetatable(base_index_mt, {
     end
 })
 -- __len and __index
-base_index_mt.len = function(index)
+base_index_mt.len = function(index, opts)
     check_index_arg(index, 'len')
+    if type(opts) == 'table' and opts.approximate then
+        return internal.estimate_count(index.space_id, index.id,
+                                       box.index.ALL, {})
+    end
     local ret = builtin.box_index_len(index.space_id, index.id)
     if ret == -1 then
         box.error()
@@ -1307,6 +1476,7 @@ base_index_mt.pairs_ffi = function(index, key, opts)
     check_index_arg(index, 'pairs')
     local pkey, pkey_end = tuple_encode(key)
     local itype = check_iterator_type(opts, pkey + 1 >= pkey_end);
+    local yield_steps, yield_timeout = check_auto_yield(opts)
 
     local keybuf = ffi.string(pkey, pkey_end - pkey)
     local pkeybuf = ffi.cast('const char *', keybuf)
@@ -1315,6 +1485,10 @@ base_index_mt.pairs_ffi = function(index, key, opts)
     if cdata == nil then
         box.error()
     end
+    if yield_steps ~= 0 or yield_timeout ~= 0 then
+        builtin.box_iterator_set_auto_yield(cdata, yield_steps,
+                                            yield_timeout)
+    end
     return fun.wrap(iterator_gen, keybuf,
         ffi.gc(cdata, builtin.box_iterator_free))
 end
@@ -1322,9 +1496,12 @@ base_index_mt.pairs_luac = function(index, key, opts)
     check_index_arg(index, 'pairs')
     key = keify(key)
     local itype = check_iterator_type(opts, #key == 0);
+    local yield_steps, yield_timeout = check_auto_yield(opts)
     local keymp = msgpack.encode(key)
     local keybuf = ffi.string(keymp, #keymp)
-    local cdata = internal.iterator(index.space_id, index.id, itype, keymp);
+    local no_cache_fill = type(opts) == 'table' and opts.fill_cache == false
+    local cdata = internal.iterator(index.space_id, index.id, itype, keymp,
+                                    no_cache_fill, yield_steps, yield_timeout);
     return fun.wrap(iterator_gen_luac, keybuf,
         ffi.gc(cdata, builtin.box_iterator_free))
 end
@@ -1334,6 +1511,10 @@ base_index_mt.count_ffi = function(index, key, opts)
     check_index_arg(index, 'count')
     local pkey, pkey_end = tuple_encode(key)
     local itype = check_iterator_type(opts, pkey + 1 >= pkey_end);
+    if type(opts) == 'table' and opts.approximate then
+        return internal.estimate_count(index.space_id, index.id, itype,
+                                       keify(key))
+    end
     local count = builtin.box_index_count(index.space_id, index.id,
         itype, pkey, pkey_end);
     if count == -1 then
@@ -1345,12 +1526,41 @@ base_index_mt.count_luac = function(index, key, opts)
     check_index_arg(index, 'count')
     key = keify(key)
     local itype = check_iterator_type(opts, #key == 0);
+    if type(opts) == 'table' and opts.approximate then
+        return internal.estimate_count(index.space_id, index.id, itype, key)
+    end
     return internal.count(index.space_id, index.id, itype, key);
 end
 
+base_index_mt.aggregate = function(index, field, key, opts)
+    check_index_arg(index, 'aggregate')
+    local fieldno = field
+    if type(field) == 'string' then
+        fieldno = nil
+        local format = box.space[index.space_id]:format()
+        for i, f in ipairs(format) do
+            if f.name == field then
+                fieldno = i
+                break
+            end
+        end
+        if fieldno == nil then
+            box.error(box.error.ILLEGAL_PARAMS,
+                      "unknown field '" .. field .. "'")
+        end
+    elseif type(field) ~= 'number' or field < 1 then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "field must be a field name or a positive number")
+    end
+    key = keify(key)
+    local itype = check_iterator_type(opts, #key == 0);
+    return internal.aggregate(index.space_id, index.id, itype, key,
+                              fieldno - 1)
+end
+
 base_index_mt.get_ffi = function(index, key)
     check_index_arg(index, 'get')
-    local key, key_end = tuple_encode(key)
+    local key, key_end = key_encode(key)
     if builtin.box_index_get(index.space_id, index.id,
                              key, key_end, ptuple) ~= 0 then
         return box.error() -- error
@@ -1365,6 +1575,17 @@ base_index_mt.get_luac = function(index, key)
     key = keify(key)
     return internal.get(index.space_id, index.id, key)
 end
+base_index_mt.get_many = function(index, keys)
+    check_index_arg(index, 'get_many')
+    if type(keys) ~= 'table' then
+        box.error(box.error.PROC_LUA, "Usage: index:get_many({key, ...})")
+    end
+    local k = {}
+    for i, key in ipairs(keys) do
+        k[i] = keify(key)
+    end
+    return internal.get_many(index.space_id, index.id, k)
+end
 
 local function check_select_opts(opts, key_is_nil)
     local offset = 0
@@ -1381,10 +1602,32 @@ local function check_select_opts(opts, key_is_nil)
     return iterator, offset, limit
 end
 
+--
+-- index:select() with the fields option returns only the given
+-- fields of each tuple. If the index stores all of them, e.g.
+-- they are covered by a vinyl secondary index, full tuples are
+-- not looked up in the primary index.
+--
+local function select_fields(index, key, opts)
+    local format = box.space[index.space_id]:format()
+    local fields = resolve_field_list(format, opts.fields, 'fields')
+    key = keify(key)
+    local iterator, offset, limit = check_select_opts(opts, #key == 0)
+    return internal.select_fields(index.space_id, index.id, iterator,
+                                  offset, limit, key, fields)
+end
+
 base_index_mt.select_ffi = function(index, key, opts)
     check_index_arg(index, 'select')
-    local key, key_end = tuple_encode(key)
+    if opts ~= nil and opts.fields ~= nil then
+        return select_fields(index, key, opts)
+    end
+    local key, key_end = key_encode(key)
     local iterator, offset, limit = check_select_opts(opts, key + 1 >= key_end)
+    local batch = check_select_batch(opts)
+    if batch ~= nil and limit > batch.capacity then
+        limit = batch.capacity
+    end
 
     local port = ffi.cast('struct port *', port_tuple)
 
@@ -1393,6 +1636,19 @@ base_index_mt.select_ffi = function(index, key, opts)
         return box.error()
     end
 
+    if batch ~= nil then
+        batch:reset()
+        local entry = port_tuple.first
+        for i = 0, tonumber(port_tuple.size) - 1 do
+            builtin.box_tuple_ref(entry.tuple)
+            batch.tuples[i] = entry.tuple
+            entry = entry.next
+        end
+        batch.size = port_tuple.size
+        builtin.port_destroy(port)
+        return batch
+    end
+
     local ret = {}
     local entry = port_tuple.first
     for i=1,tonumber(port_tuple.size),1 do
@@ -1405,10 +1661,28 @@ end
 
 base_index_mt.select_luac = function(index, key, opts)
     check_index_arg(index, 'select')
+    if opts ~= nil and opts.fields ~= nil then
+        return select_fields(index, key, opts)
+    end
     local key = keify(key)
     local iterator, offset, limit = check_select_opts(opts, #key == 0)
-    return internal.select(index.space_id, index.id, iterator,
-        offset, limit, key)
+    local batch = check_select_batch(opts)
+    if batch == nil then
+        return internal.select(index.space_id, index.id, iterator,
+            offset, limit, key)
+    end
+    if limit > batch.capacity then
+        limit = batch.capacity
+    end
+    local ret = internal.select(index.space_id, index.id, iterator,
+                                offset, limit, key)
+    batch:reset()
+    for i, tuple in ipairs(ret) do
+        builtin.box_tuple_ref(tuple)
+        batch.tuples[i - 1] = tuple
+    end
+    batch.size = #ret
+    return batch
 end
 
 base_index_mt.update = function(index, key, ops)
@@ -1424,6 +1698,10 @@ base_index_mt.stat = function(index)
     return internal.stat(index.space_id, index.id);
 end
 
+base_index_mt.stat_reset = function(index)
+    return internal.stat_reset(index.space_id, index.id)
+end
+
 base_index_mt.compact = function(index)
     return internal.compact(index.space_id, index.id)
 end
@@ -1456,13 +1734,13 @@ memtx_index_mt.__pairs = memtx_index_mt.pairs
 memtx_index_mt.__ipairs = memtx_index_mt.pairs
 
 local space_mt = {}
-space_mt.len = function(space)
+space_mt.len = function(space, opts)
     check_space_arg(space, 'len')
     local pk = space.index[0]
     if pk == nil then
         return 0 -- empty space without indexes, return 0
     end
-    return space.index[0]:len()
+    return space.index[0]:len(opts)
 end
 space_mt.count = function(space, key, opts)
     check_space_arg(space, 'count')
@@ -1472,6 +1750,11 @@ space_mt.count = function(space, key, opts)
     end
     return pk:count(key, opts)
 end
+space_mt.aggregate = function(space, field, key, opts)
+    check_space_arg(space, 'aggregate')
+    local pk = check_primary_index(space)
+    return pk:aggregate(field, key, opts)
+end
 space_mt.bsize = function(space)
     check_space_arg(space, 'bsize')
     local s = builtin.space_by_id(space.id)
@@ -1485,19 +1768,66 @@ space_mt.get = function(space, key)
     check_space_arg(space, 'get')
     return check_primary_index(space):get(key)
 end
+space_mt.get_many = function(space, keys)
+    check_space_arg(space, 'get_many')
+    return check_primary_index(space):get_many(keys)
+end
 space_mt.select = function(space, key, opts)
     check_space_arg(space, 'select')
     return check_primary_index(space):select(key, opts)
 end
+--
+-- A tuple encoded in a buffer, e.g. by a msgpackffi codec, is
+-- passed to box_insert()/box_replace() as is.
+--
+local function insert_encoded(space, buf, op)
+    if op(space.id, buf.rpos, buf.wpos, ptuple) ~= 0 then
+        return box.error()
+    elseif ptuple[0] ~= nil then
+        return tuple_bless(ptuple[0])
+    end
+end
 space_mt.insert = function(space, tuple)
     check_space_arg(space, 'insert')
+    if ffi.istype(ibuf_t, tuple) then
+        return insert_encoded(space, tuple, builtin.box_insert)
+    end
     return internal.insert(space.id, tuple);
 end
 space_mt.replace = function(space, tuple)
     check_space_arg(space, 'replace')
+    if ffi.istype(ibuf_t, tuple) then
+        return insert_encoded(space, tuple, builtin.box_replace)
+    end
     return internal.replace(space.id, tuple);
 end
 space_mt.put = space_mt.replace; -- put is an alias for replace
+space_mt.insert_many = function(space, tuples)
+    check_space_arg(space, 'insert_many')
+    return internal.insert_many(space.id, tuples);
+end
+space_mt.replace_many = function(space, tuples)
+    check_space_arg(space, 'replace_many')
+    return internal.replace_many(space.id, tuples);
+end
+space_mt.bulk_load = function(space, gen, param, state)
+    check_space_arg(space, 'bulk_load')
+    if type(gen) == 'table' then
+        gen, param, state = ipairs(gen)
+    end
+    local function next_tuple()
+        local v
+        state, v = gen(param, state)
+        if state == nil then
+            return nil
+        end
+        if v == nil then
+            v = state
+        end
+        return is_tuple(v) and v or box.tuple.new(v)
+    end
+    return internal.bulk_load(space.id, next_tuple);
+end
 space_mt.update = function(space, key, ops)
     check_space_arg(space, 'update')
     return check_primary_index(space):update(key, ops)
@@ -1545,10 +1875,61 @@ space_mt.truncate = function(space)
     check_space_arg(space, 'truncate')
     return internal.truncate(space.id)
 end
+space_mt.stat = function(space)
+    check_space_arg(space, 'stat')
+    return internal.space_stat(space.id)
+end
+space_mt.stat_reset = function(space)
+    check_space_arg(space, 'stat_reset')
+    return internal.space_reset_stat(space.id)
+end
 space_mt.format = function(space, format)
     check_space_arg(space, 'format')
     return box.schema.space.format(space.id, format)
 end
+
+--
+-- space:field_accessor() returns a table of field numbers by
+-- field names of the space format. tuple[fields.name] is faster
+-- than tuple.name, since the name isn't hashed and looked up
+-- in the tuple dictionary on each access. The table is shared
+-- by all callers and is refilled after the space is altered.
+--
+local field_accessors = setmetatable({}, {__mode = 'v'})
+
+local function field_accessor_fill(accessor, space_id)
+    local space = box.space[space_id]
+    if space == nil then
+        box.error(box.error.NO_SUCH_SPACE, '#'..tostring(space_id))
+    end
+    for fieldno, field in ipairs(space:format()) do
+        rawset(accessor, field.name, fieldno)
+    end
+    return space
+end
+
+space_mt.field_accessor = function(space)
+    check_space_arg(space, 'field_accessor')
+    local space_id = space.id
+    local accessor = field_accessors[space_id]
+    if accessor ~= nil then
+        return accessor
+    end
+    accessor = setmetatable({}, {
+        __index = function(accessor, name)
+            local space = field_accessor_fill(accessor, space_id)
+            local fieldno = rawget(accessor, name)
+            if fieldno == nil then
+                box.error(box.error.ILLEGAL_PARAMS, string.format(
+                          "space '%s' has no field '%s'", space.name,
+                          tostring(name)))
+            end
+            return fieldno
+        end
+    })
+    field_accessors[space_id] = accessor
+    return accessor
+end
 space_mt.drop = function(space)
     check_space_arg(space, 'drop')
     check_space_exists(space)
@@ -1617,6 +1998,13 @@ function box.schema.space.bless(space)
     local space_mt = wrap_schema_object_mt('space_mt')
 
     setmetatable(space, space_mt)
+    -- The format may have changed, resolve names anew.
+    local accessor = field_accessors[space.id]
+    if accessor ~= nil then
+        for name in pairs(accessor) do
+            accessor[name] = nil
+        end
+    end
     if type(space.index) == 'table' and space.enabled then
         for j, index in pairs(space.index) do
             if type(j) == 'number' then
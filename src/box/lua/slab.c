@@ -32,6 +32,7 @@
 
 #include "box/lua/slab.h"
 #include "lua/utils.h"
+#include "lua/alloc.h"
 
 #include <lua.h>
 #include <lauxlib.h>
@@ -43,6 +44,7 @@
 #include "memory.h"
 #include "box/engine.h"
 #include "box/memtx_engine.h"
+#include "box/tuple.h"
 
 static int
 small_stats_noop_cb(const struct mempool_stats *stats, void *cb_ctx)
@@ -198,6 +200,15 @@ lbox_slab_info(struct lua_State *L)
 	lua_pushstring(L, ratio_buf);
 	lua_settable(L, -3);
 
+	/*
+	 * How much of the arena is actually backed by huge
+	 * pages, see box.cfg.memtx_use_hugepages.
+	 */
+	lua_pushstring(L, "arena_hugepages");
+	luaL_pushuint64(L, memtx->use_hugepages ?
+			tuple_arena_hugepage_size(&memtx->arena) : 0);
+	lua_settable(L, -3);
+
 	/*
 	 * This is pretty much the same as
 	 * box.cfg.slab_alloc_arena, but in bytes
@@ -251,6 +262,23 @@ lbox_runtime_info(struct lua_State *L)
 	lua_pushinteger(L, G(L)->gc.total);
 	lua_settable(L, -3);
 
+	/*
+	 * Lua heap pools, if Lua allocates from small
+	 */
+	if (lua_small_alloc_is_enabled()) {
+		struct lua_small_alloc_stat stat;
+		lua_small_alloc_stat(&stat);
+		lua_pushstring(L, "lua_alloc");
+		lua_newtable(L);
+		lua_pushstring(L, "used");
+		luaL_pushuint64(L, stat.used);
+		lua_settable(L, -3);
+		lua_pushstring(L, "total");
+		luaL_pushuint64(L, stat.total);
+		lua_settable(L, -3);
+		lua_settable(L, -3);
+	}
+
 	return 1;
 }
 
@@ -100,6 +100,36 @@ lbox_pop_txn_stmt(struct lua_State *L, int nret, void *event)
 	return 0;
 }
 
+/**
+ * Push statements of a committed transaction applied to a space
+ * as an array of {old_tuple, new_tuple} pairs.
+ */
+static int
+lbox_push_txn_commit_batch(struct lua_State *L, void *event)
+{
+	struct txn_commit_batch *batch = (struct txn_commit_batch *) event;
+	lua_createtable(L, batch->stmt_count, 0);
+	int i = 0;
+	struct txn_stmt *stmt;
+	stailq_foreach_entry(stmt, &batch->txn->stmts, next) {
+		if (stmt->space != batch->space ||
+		    (stmt->old_tuple == NULL && stmt->new_tuple == NULL))
+			continue;
+		lua_createtable(L, 2, 0);
+		if (stmt->old_tuple != NULL) {
+			luaT_pushtuple(L, stmt->old_tuple);
+			lua_rawseti(L, -2, 1);
+		}
+		if (stmt->new_tuple != NULL) {
+			luaT_pushtuple(L, stmt->new_tuple);
+			lua_rawseti(L, -2, 2);
+		}
+		lua_rawseti(L, -2, ++i);
+	}
+	lua_pushstring(L, batch->space->def->name);
+	return 2;
+}
+
 /**
  * Set/Reset/Get space.on_replace trigger
  */
@@ -121,6 +151,27 @@ lbox_space_on_replace(struct lua_State *L)
 				  lbox_push_txn_stmt, NULL);
 }
 
+/**
+ * Set/Reset/Get space.on_commit_batch trigger
+ */
+static int
+lbox_space_on_commit_batch(struct lua_State *L)
+{
+	int top = lua_gettop(L);
+
+	if (top < 1 || !lua_istable(L, 1)) {
+		luaL_error(L,
+	   "usage: space:on_commit_batch(function | nil, [function | nil])");
+	}
+	lua_getfield(L, 1, "id"); /* Get space id. */
+	uint32_t id = lua_tonumber(L, lua_gettop(L));
+	struct space *space = space_cache_find_xc(id);
+	lua_pop(L, 1);
+
+	return lbox_trigger_reset(L, 3, &space->on_commit_batch,
+				  lbox_push_txn_commit_batch, NULL);
+}
+
 /**
  * Set/Reset/Get space.before_replace trigger
  */
@@ -172,6 +223,11 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 	lua_pushboolean(L, space_is_temporary(space));
 	lua_settable(L, i);
 
+	/* space.is_sync */
+	lua_pushstring(L, "is_sync");
+	lua_pushboolean(L, space->def->opts.is_sync);
+	lua_settable(L, i);
+
 	/* space.name */
 	lua_pushstring(L, "name");
 	lua_pushstring(L, space_name(space));
@@ -192,6 +248,11 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
         lua_pushcfunction(L, lbox_space_on_replace);
         lua_settable(L, i);
 
+        /* space:on_commit_batch */
+        lua_pushstring(L, "on_commit_batch");
+        lua_pushcfunction(L, lbox_space_on_commit_batch);
+        lua_settable(L, i);
+
         /* space:before_replace */
         lua_pushstring(L, "before_replace");
         lua_pushcfunction(L, lbox_space_before_replace);
@@ -264,9 +325,40 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 		if (index_def->type == HASH || index_def->type == TREE) {
 			lua_pushboolean(L, index_opts->is_unique);
 			lua_setfield(L, -2, "unique");
+		}
+		if (index_opts->expire)
+			lua_pushboolean(L, true);
+		else
+			lua_pushnil(L);
+		lua_setfield(L, -2, "expire");
+		if (index_opts->func_id != 0)
+			lua_pushnumber(L, index_opts->func_id);
+		else
+			lua_pushnil(L);
+		lua_setfield(L, -2, "func");
+		if (index_opts->store_key)
+			lua_pushboolean(L, true);
+		else
+			lua_pushnil(L);
+		lua_setfield(L, -2, "store_key");
+		if (index_def->type == HASH) {
+			if (index_opts->size_hint > 0)
+				lua_pushnumber(L, index_opts->size_hint);
+			else
+				lua_pushnil(L);
+			lua_setfield(L, -2, "size_hint");
+			if (index_opts->hash_func != INDEX_HASH_FUNC_MURMUR)
+				lua_pushstring(L, index_hash_func_strs[
+					index_opts->hash_func]);
+			else
+				lua_pushnil(L);
+			lua_setfield(L, -2, "hash_func");
 		} else if (index_def->type == RTREE) {
 			lua_pushnumber(L, index_opts->dimension);
 			lua_setfield(L, -2, "dimension");
+		} else if (index_def->type == BITSET) {
+			lua_pushboolean(L, index_opts->is_sparse);
+			lua_setfield(L, -2, "sparse");
 		}
 
 		lua_pushstring(L, index_type_strs[index_def->type]);
@@ -356,6 +448,61 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 			lua_pushnumber(L, index_opts->bloom_fpr);
 			lua_setfield(L, -2, "bloom_fpr");
 
+			if (index_opts->compaction_strategy !=
+			    INDEX_COMPACTION_STRATEGY_LEVELED) {
+				lua_pushstring(L, index_compaction_strategy_strs[
+					index_opts->compaction_strategy]);
+				lua_setfield(L, -2, "compaction_strategy");
+			}
+
+			if (index_opts->covered_fields != 0) {
+				lua_newtable(L);
+				int n = 0;
+				for (uint32_t i = 0; i < 63; i++) {
+					if ((index_opts->covered_fields &
+					     (1ULL << i)) == 0)
+						continue;
+					lua_pushnumber(L, i + TUPLE_INDEX_BASE);
+					lua_rawseti(L, -2, ++n);
+				}
+				lua_setfield(L, -2, "covered_fields");
+			}
+
+			if (index_opts->blob_threshold > 0) {
+				lua_pushnumber(L, index_opts->blob_threshold);
+				lua_setfield(L, -2, "blob_threshold");
+			}
+
+			if (index_opts->page_restart_interval > 0) {
+				lua_pushnumber(L,
+					index_opts->page_restart_interval);
+				lua_setfield(L, -2, "page_restart_interval");
+			}
+
+			if (index_opts->columnar) {
+				lua_pushboolean(L, true);
+				lua_setfield(L, -2, "columnar");
+			}
+
+			if (index_opts->compression_dict_size > 0) {
+				lua_pushnumber(L,
+					index_opts->compression_dict_size);
+				lua_setfield(L, -2, "compression_dict_size");
+			}
+
+			if (index_opts->zone_map_fields != 0) {
+				lua_newtable(L);
+				int n = 0;
+				for (uint32_t i = 0; i < 63; i++) {
+					if ((index_opts->zone_map_fields &
+					     (1ULL << i)) == 0)
+						continue;
+					lua_pushnumber(L, i + TUPLE_INDEX_BASE);
+					lua_rawseti(L, -2, ++n);
+				}
+				lua_setfield(L, -2, "zone_map_fields");
+			}
+
 			lua_settable(L, -3);
 		}
 		lua_setfield(L, -2, index_def->name);
@@ -31,8 +31,10 @@
  */
 #include "stat.h"
 
+#include <stdio.h>
 #include <string.h>
 #include <rmean.h>
+#include <small/ibuf.h>
 
 #include <lua.h>
 #include <lauxlib.h>
@@ -42,14 +44,17 @@
 #include "box/iproto.h"
 #include "box/engine.h"
 #include "box/vinyl.h"
+#include "box/wal.h"
+#include "box/metrics.h"
+#include "cbus.h"
+#include "coio_task.h"
+#include "fiber.h"
 #include <info.h>
 #include "lua/info.h"
 #include "lua/utils.h"
 
 extern struct rmean *rmean_box;
 extern struct rmean *rmean_error;
-/** network statistics (iproto & cbus) */
-extern struct rmean *rmean_net;
 extern struct rmean *rmean_tx_wal_bus;
 
 static void
@@ -127,6 +132,219 @@ lbox_stat_vinyl(struct lua_State *L)
 	return 1;
 }
 
+static int
+lbox_stat_wal(struct lua_State *L)
+{
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	wal_stat(&h);
+	return 1;
+}
+
+static int
+lbox_stat_worker_pool(struct lua_State *L)
+{
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	info_begin(&h);
+	for (int i = 0; i < coio_pool_id_MAX; i++) {
+		struct coio_pool_stat stat;
+		coio_pool_stat((enum coio_pool_id)i, &stat);
+		info_table_begin(&h, coio_pool_id_strs[i]);
+		info_append_int(&h, "size", stat.size);
+		info_append_int(&h, "running", stat.running);
+		info_append_int(&h, "waiting", stat.waiting);
+		info_append_int(&h, "requests", stat.requests);
+		info_append_double(&h, "queue_time", stat.queue_time);
+		info_append_double(&h, "queue_time_max", stat.queue_time_max);
+		info_table_end(&h);
+	}
+	info_end(&h);
+	return 1;
+}
+
+enum { LOOP_STAT_CORDS_MAX = 64 };
+
+/** Event loop statistics of cords sharing a name. */
+struct loop_stat_entry {
+	char name[FIBER_NAME_MAX];
+	int count;
+	struct cord_loop_stat stat;
+};
+
+struct loop_stat_ctx {
+	struct loop_stat_entry entries[LOOP_STAT_CORDS_MAX];
+	int count;
+};
+
+/**
+ * Collect event loop statistics. Cords sharing a name, like
+ * relays, are merged.
+ */
+static int
+loop_stat_collect_cb(const char *name, const struct cord_loop_stat *stat,
+		     void *cb_ctx)
+{
+	struct loop_stat_ctx *ctx = (struct loop_stat_ctx *) cb_ctx;
+	struct loop_stat_entry *entry = NULL;
+	for (int i = 0; i < ctx->count; i++) {
+		if (strcmp(ctx->entries[i].name, name) == 0) {
+			entry = &ctx->entries[i];
+			break;
+		}
+	}
+	if (entry == NULL) {
+		if (ctx->count == LOOP_STAT_CORDS_MAX)
+			return 0;
+		entry = &ctx->entries[ctx->count++];
+		memset(entry, 0, sizeof(*entry));
+		snprintf(entry->name, sizeof(entry->name), "%s", name);
+	}
+	struct cord_loop_stat *dst = &entry->stat;
+	entry->count++;
+	dst->iterations += stat->iterations;
+	dst->busy += stat->busy;
+	dst->idle += stat->idle;
+	dst->ready += stat->ready;
+	if (stat->busy_max > dst->busy_max)
+		dst->busy_max = stat->busy_max;
+	if (stat->ready_max > dst->ready_max)
+		dst->ready_max = stat->ready_max;
+	for (int i = 0; i < CORD_LOOP_HIST_SIZE; i++)
+		dst->hist[i] += stat->hist[i];
+	return 0;
+}
+
+/**
+ * Return the upper bound of the iteration time below which
+ * the given permille of iterations fall, in seconds.
+ */
+static double
+loop_stat_permille(const struct cord_loop_stat *stat, int permille)
+{
+	uint64_t rank = stat->iterations * permille / 1000;
+	uint64_t count = 0;
+	for (int i = 0; i < CORD_LOOP_HIST_SIZE - 1; i++) {
+		count += stat->hist[i];
+		if (count > rank)
+			return (double)(1ULL << i) / 1e6;
+	}
+	return stat->busy_max / 1e9;
+}
+
+static int
+lbox_stat_loop(struct lua_State *L)
+{
+	struct loop_stat_ctx *ctx = (struct loop_stat_ctx *)
+		lua_newuserdata(L, sizeof(*ctx));
+	ctx->count = 0;
+	cord_stat_foreach(loop_stat_collect_cb, ctx);
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	info_begin(&h);
+	for (int i = 0; i < ctx->count; i++) {
+		struct loop_stat_entry *entry = &ctx->entries[i];
+		struct cord_loop_stat *stat = &entry->stat;
+		uint64_t total = stat->busy + stat->idle;
+		info_table_begin(&h, entry->name);
+		info_append_int(&h, "cords", entry->count);
+		info_append_int(&h, "iterations", stat->iterations);
+		info_append_double(&h, "busy", stat->busy / 1e9);
+		info_append_double(&h, "idle", stat->idle / 1e9);
+		info_append_double(&h, "load", total == 0 ? 0 :
+				   (double)stat->busy / total);
+		info_table_begin(&h, "iteration");
+		info_append_double(&h, "p50", loop_stat_permille(stat, 500));
+		info_append_double(&h, "p99", loop_stat_permille(stat, 990));
+		info_append_double(&h, "p999", loop_stat_permille(stat, 999));
+		info_append_double(&h, "max", stat->busy_max / 1e9);
+		info_table_end(&h);
+		info_table_begin(&h, "ready");
+		info_append_double(&h, "avg", stat->iterations == 0 ? 0 :
+				   (double)stat->ready / stat->iterations);
+		info_append_int(&h, "max", stat->ready_max);
+		info_table_end(&h);
+		info_table_end(&h);
+	}
+	info_end(&h);
+	return 1;
+}
+
+enum { CBUS_STAT_ENDPOINTS_MAX = 64 };
+
+struct cbus_stat_ctx {
+	struct {
+		char name[FIBER_NAME_MAX];
+		struct cbus_endpoint_stat stat;
+	} entries[CBUS_STAT_ENDPOINTS_MAX];
+	int count;
+};
+
+static int
+cbus_stat_collect_cb(const char *name, const struct cbus_endpoint_stat *stat,
+		     void *cb_ctx)
+{
+	struct cbus_stat_ctx *ctx = (struct cbus_stat_ctx *) cb_ctx;
+	if (ctx->count == CBUS_STAT_ENDPOINTS_MAX)
+		return 1;
+	snprintf(ctx->entries[ctx->count].name,
+		 sizeof(ctx->entries[ctx->count].name), "%s", name);
+	ctx->entries[ctx->count].stat = *stat;
+	ctx->count++;
+	return 0;
+}
+
+static int
+lbox_stat_cbus(struct lua_State *L)
+{
+	struct cbus_stat_ctx *ctx = (struct cbus_stat_ctx *)
+		lua_newuserdata(L, sizeof(*ctx));
+	ctx->count = 0;
+	cbus_stat_foreach(cbus_stat_collect_cb, ctx);
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	info_begin(&h);
+	for (int i = 0; i < ctx->count; i++) {
+		struct cbus_endpoint_stat *stat = &ctx->entries[i].stat;
+		info_table_begin(&h, ctx->entries[i].name);
+		info_append_int(&h, "pipes", stat->pipes);
+		info_append_int(&h, "queue", stat->queue);
+		info_append_int(&h, "queue_max", stat->queue_max);
+		info_append_int(&h, "fetched", stat->fetched);
+		info_table_end(&h);
+	}
+	info_end(&h);
+	return 1;
+}
+
+static int
+lbox_stat_latency(struct lua_State *L)
+{
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	iproto_latency_stat(&h);
+	return 1;
+}
+
+/**
+ * box.stat.metrics() - all statistics in the Prometheus text
+ * format, rendered in C to avoid building Lua tables.
+ */
+static int
+lbox_stat_metrics(struct lua_State *L)
+{
+	/* Rendering yields, so the buffer can't be shared. */
+	struct ibuf buf;
+	ibuf_create(&buf, &cord()->slabc, 16 * 1024);
+	if (box_metrics_prometheus(&buf) != 0) {
+		ibuf_destroy(&buf);
+		return luaT_error(L);
+	}
+	lua_pushlstring(L, buf.rpos, ibuf_used(&buf));
+	ibuf_destroy(&buf);
+	return 1;
+}
+
 static int
 lbox_stat_reset(struct lua_State *L)
 {
@@ -140,14 +358,14 @@ static int
 lbox_stat_net_index(struct lua_State *L)
 {
 	luaL_checkstring(L, -1);
-	return rmean_foreach(rmean_net, seek_stat_item, L);
+	return iproto_rmean_foreach(seek_stat_item, L);
 }
 
 static int
 lbox_stat_net_call(struct lua_State *L)
 {
 	lua_newtable(L);
-	rmean_foreach(rmean_net, set_stat_item, L);
+	iproto_rmean_foreach(set_stat_item, L);
 	return 1;
 }
 
@@ -169,6 +387,12 @@ box_lua_stat_init(struct lua_State *L)
 {
 	static const struct luaL_Reg statlib [] = {
 		{"vinyl", lbox_stat_vinyl},
+		{"wal", lbox_stat_wal},
+		{"latency", lbox_stat_latency},
+		{"worker_pool", lbox_stat_worker_pool},
+		{"loop", lbox_stat_loop},
+		{"cbus", lbox_stat_cbus},
+		{"metrics", lbox_stat_metrics},
 		{"reset", lbox_stat_reset},
 		{NULL, NULL}
 	};
@@ -0,0 +1,130 @@
+-- transfer.lua (internal file)
+--
+-- Moving a key range of a space to another instance, e.g. a
+-- bucket on rebalancing. The sender scans a read view of the
+-- range and streams its tuples to the receiver in chunks over
+-- an existing net.box connection. Each chunk is applied on the
+-- receiver with space:replace_many(), i.e. in one transaction
+-- and one journal entry, so that a transfer interrupted midway
+-- can be simply restarted.
+
+local DEFAULT_CHUNK_SIZE = 1000
+local DEFAULT_CHUNK_BSIZE = 1024 * 1024
+local DEFAULT_WINDOW = 4
+
+local send_opts_types = {
+    index = 'number, string',
+    target = 'number, string',
+    from = 'table',
+    to = 'table',
+    chunk_size = 'number',
+    chunk_bsize = 'number',
+    window = 'number',
+    timeout = 'number',
+    on_progress = 'function',
+}
+
+local function receive(space, tuples)
+    local s = box.space[space]
+    if s == nil then
+        box.error(box.error.NO_SUCH_SPACE, tostring(space))
+    end
+    s:replace_many(tuples)
+    return #tuples
+end
+
+--
+-- Send all tuples of the given space with keys of index
+-- opts.index in [opts.from, opts.to) to the instance behind
+-- connection conn, where they are inserted into space
+-- opts.target, by default the space with the same name. The
+-- user of the connection needs the right to execute
+-- box.transfer.receive and to write to the target space.
+--
+-- The sender keeps at most opts.window chunks in flight, each
+-- no larger than opts.chunk_size tuples or opts.chunk_bsize
+-- bytes, and waits for the receiver to acknowledge the oldest
+-- one before sending more. opts.on_progress is called with the
+-- transfer statistics after each acknowledged chunk.
+--
+-- Returns the statistics: {chunks = <count>, tuples = <count>,
+-- bytes = <count>}. Raises an error if a chunk fails.
+--
+local function send(conn, space, opts)
+    if type(conn) ~= 'table' or conn.call == nil then
+        error('Usage: box.transfer.send(conn, space[, opts])')
+    end
+    local s = type(space) == 'table' and space or box.space[space]
+    if s == nil then
+        box.error(box.error.NO_SUCH_SPACE, tostring(space))
+    end
+    opts = opts or {}
+    box.internal.check_param_table(opts, send_opts_types)
+    local chunk_size = opts.chunk_size or DEFAULT_CHUNK_SIZE
+    local chunk_bsize = opts.chunk_bsize or DEFAULT_CHUNK_BSIZE
+    local window = opts.window or DEFAULT_WINDOW
+    if chunk_size < 1 or chunk_bsize < 1 or window < 1 then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  'chunk_size, chunk_bsize and window must be positive')
+    end
+    local rv = box.read_view({space = s.id, index = opts.index,
+                              from = opts.from, to = opts.to})
+    local target = opts.target or s.name
+    local stats = {chunks = 0, tuples = 0, bytes = 0}
+    local in_flight = {}
+
+    local function complete()
+        local chunk = table.remove(in_flight, 1)
+        local res, err = chunk.future:wait_result(opts.timeout)
+        if res == nil then
+            error(err)
+        end
+        stats.chunks = stats.chunks + 1
+        stats.tuples = stats.tuples + chunk.count
+        stats.bytes = stats.bytes + chunk.bsize
+        if opts.on_progress ~= nil then
+            opts.on_progress(stats)
+        end
+    end
+
+    local tuples, bsize = {}, 0
+    local function flush()
+        if #in_flight >= window then
+            complete()
+        end
+        local future = conn:call('box.transfer.receive', {target, tuples},
+                                 {is_async = true})
+        table.insert(in_flight, {future = future, count = #tuples,
+                                 bsize = bsize})
+        tuples, bsize = {}, 0
+    end
+
+    local ok, err = pcall(function()
+        for _, tuple in rv:pairs(s.id, opts.index) do
+            table.insert(tuples, tuple)
+            bsize = bsize + tuple:bsize()
+            if #tuples >= chunk_size or bsize >= chunk_bsize then
+                flush()
+            end
+        end
+        if #tuples > 0 then
+            flush()
+        end
+        while #in_flight > 0 do
+            complete()
+        end
+    end)
+    rv:close()
+    if not ok then
+        for _, chunk in ipairs(in_flight) do
+            chunk.future:discard()
+        end
+        error(err)
+    end
+    return stats
+end
+
+box.transfer = {
+    send = send,
+    receive = receive,
+}
@@ -43,6 +43,7 @@
 #include "box/errcode.h"
 #include "json/json.h"
 #include "mpstream.h"
+#include "third_party/lua-cjson/lua_cjson.h" /* json_encode_msgpack() */
 
 /** {{{ box.tuple Lua library
  *
@@ -332,6 +333,18 @@ error:
 	return 1;
 }
 
+/**
+ * Convert a tuple into a JSON string directly from MsgPack.
+ */
+static int
+lbox_tuple_to_json(struct lua_State *L)
+{
+	if (lua_gettop(L) != 1)
+		luaL_error(L, "Usage: tuple:tojson()");
+	const struct tuple *tuple = lua_checktuple(L, 1);
+	return json_encode_msgpack(L, tuple_data(tuple));
+}
+
 /**
  * Tuple transforming function.
  *
@@ -493,6 +506,10 @@ void
 luaT_pushtuple(struct lua_State *L, box_tuple_t *tuple)
 {
 	assert(CTID_CONST_STRUCT_TUPLE_REF != 0);
+	/* Lua code may access any field of the tuple. */
+	tuple = tuple_unpack(tuple);
+	if (tuple == NULL)
+		luaT_error(L);
 	struct tuple **ptr = (struct tuple **)
 		luaL_pushcdata(L, CTID_CONST_STRUCT_TUPLE_REF);
 	*ptr = tuple;
@@ -508,6 +525,7 @@ static const struct luaL_Reg lbox_tuple_meta[] = {
 	{"slice", lbox_tuple_slice},
 	{"transform", lbox_tuple_transform},
 	{"tuple_to_map", lbox_tuple_to_map},
+	{"tuple_to_json", lbox_tuple_to_json},
 	{"tuple_field_by_path", lbox_tuple_field_by_path},
 	{NULL, NULL}
 };
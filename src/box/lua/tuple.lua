@@ -11,6 +11,13 @@ ffi.cdef[[
 /** \cond public */
 
 typedef struct tuple box_tuple_t;
+typedef struct tuple_format box_tuple_format_t;
+
+box_tuple_format_t *
+box_tuple_format_default(void);
+
+box_tuple_t *
+box_tuple_new(box_tuple_format_t *format, const char *data, const char *end);
 
 int
 box_tuple_ref(box_tuple_t *tuple);
@@ -287,6 +294,7 @@ local methods = {
     ["upsert"]      = tuple_upsert;
     ["bsize"]       = tuple_bsize;
     ["tomap"]       = internal.tuple.tuple_to_map;
+    ["tojson"]      = internal.tuple.tuple_to_json;
 }
 
 -- Aliases for tuple:methods().
@@ -342,6 +350,102 @@ ffi.metatype(tuple_iterator_t, {
     __tostring = function(it) return "<tuple iterator>" end;
 })
 
+--
+-- A fixed size array of tuples, filled by index:select() with
+-- the batch option. The batch references its tuples, so they
+-- are not blessed one by one, and can be reused to select
+-- without allocating a table per call. The tuples are valid
+-- until the batch is filled again or reset.
+--
+ffi.cdef[[
+struct tuple_batch {
+    uint32_t size;
+    uint32_t capacity;
+    box_tuple_t *tuples[?];
+};
+]]
+
+local tuple_batch_t = ffi.typeof('struct tuple_batch')
+
+local function tuple_batch_check(batch, usage)
+    if not ffi.istype(tuple_batch_t, batch) then
+        error('Usage: ' .. usage)
+    end
+end
+
+local function tuple_batch_reset(batch)
+    for i = 0, batch.size - 1 do
+        builtin.box_tuple_unref(batch.tuples[i])
+    end
+    batch.size = 0
+end
+
+local tuple_batch_methods = {
+    reset = function(batch)
+        tuple_batch_check(batch, 'batch:reset()')
+        tuple_batch_reset(batch)
+    end;
+    totable = function(batch)
+        tuple_batch_check(batch, 'batch:totable()')
+        local ret = {}
+        for i = 0, batch.size - 1 do
+            ret[i + 1] = tuple_bless(batch.tuples[i])
+        end
+        return ret
+    end;
+}
+
+ffi.metatype(tuple_batch_t, {
+    __len = function(batch)
+        return batch.size
+    end;
+    __index = function(batch, key)
+        if type(key) == 'number' then
+            if key < 1 or key > batch.size then
+                return nil
+            end
+            return ffi.cast(const_tuple_ref_t, batch.tuples[key - 1])
+        end
+        return tuple_batch_methods[key]
+    end;
+    __tostring = function(batch)
+        return string.format('<tuple batch of %d>', batch.size)
+    end;
+})
+
+local function tuple_batch_new(capacity)
+    if type(capacity) ~= 'number' or capacity < 1 or
+       capacity > 4294967295 then
+        error('Usage: box.tuple.batch(capacity)')
+    end
+    local batch = ffi.new(tuple_batch_t, capacity)
+    batch.size = 0
+    batch.capacity = capacity
+    return ffi.gc(batch, tuple_batch_reset)
+end
+
+box.tuple.batch = tuple_batch_new
+
+--
+-- box.tuple.new() also accepts a tuple already encoded in a
+-- buffer, e.g. by a msgpackffi codec, and creates it without
+-- converting the data to Lua and back.
+--
+local ibuf_t = ffi.typeof('struct ibuf')
+local tuple_new = box.tuple.new
+box.tuple.new = function(...)
+    local buf = ...
+    if ffi.istype(ibuf_t, buf) and select('#', ...) == 1 then
+        local tuple = builtin.box_tuple_new(builtin.box_tuple_format_default(),
+                                            buf.rpos, buf.wpos)
+        if tuple == nil then
+            return box.error()
+        end
+        return tuple_bless(tuple)
+    end
+    return tuple_new(...)
+end
+
 -- internal api for box.select and iterators
 box.tuple.bless = tuple_bless
 box.tuple.encode = tuple_encode
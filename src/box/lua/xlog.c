@@ -31,12 +31,16 @@
 
 #include "xlog.h"
 
+#include <strings.h>
+
 #include <say.h>
+#include <fiber.h>
 #include <diag.h>
 #include <msgpuck/msgpuck.h>
 
 #include <box/error.h>
 #include <box/xlog.h>
+#include <box/xlog_scan.h>
 #include <box/xrow.h>
 #include <box/iproto_constants.h>
 #include <box/tuple.h>
@@ -47,6 +51,7 @@
 /* {{{ Helpers */
 
 static uint32_t CTID_STRUCT_XLOG_CURSOR_REF = 0;
+static uint32_t CTID_STRUCT_XLOG_SCAN_REF = 0;
 static const char *xloglib_name = "xlog";
 
 static int
@@ -103,6 +108,8 @@ lbox_xlog_parse_body_kv(struct lua_State *L, int type, const char **beg, const c
 		lbox_xlog_pushkey(L, vy_page_info_key_name(v));
 	} else if (type == VY_RUN_ROW_INDEX && vy_row_index_key_name(v)) {
 		lbox_xlog_pushkey(L, vy_row_index_key_name(v));
+	} else if (type == VY_RUN_COLUMNS && vy_columns_key_name(v)) {
+		lbox_xlog_pushkey(L, vy_columns_key_name(v));
 	} else {
 		lua_pushinteger(L, v); /* unknown key */
 	}
@@ -300,8 +307,198 @@ lbox_xlog_parser_open_pairs(struct lua_State *L)
 	return 3;
 }
 
+/* {{{ Xlog Scan */
+
+static int
+lbox_xlog_scan_delete_f(va_list ap)
+{
+	struct xlog_scan *scan = va_arg(ap, struct xlog_scan *);
+	xlog_scan_delete(scan);
+	return 0;
+}
+
+static struct xlog_scan **
+lbox_checkscan(struct lua_State *L, int narg, const char *src)
+{
+	uint32_t ctypeid;
+	void *data = luaL_checkcdata(L, narg, &ctypeid);
+	if (ctypeid != CTID_STRUCT_XLOG_SCAN_REF)
+		luaL_error(L, "%s: expecting xlog scan object", src);
+	return (struct xlog_scan **)data;
+}
+
+static int
+lbox_xlog_scan_gc(struct lua_State *L)
+{
+	struct xlog_scan **pscan = lbox_checkscan(L, 1, "xlog.scan:gc()");
+	if (*pscan == NULL)
+		return 0;
+	/*
+	 * Stopping the scan waits for its threads, which must
+	 * not be done in a gc handler, so do it in a fiber.
+	 */
+	struct fiber *f = fiber_new("xlog.scan.gc", lbox_xlog_scan_delete_f);
+	if (f == NULL) {
+		diag_log();
+		say_error("failed to stop xlog scan, leaking it");
+		return 0;
+	}
+	fiber_start(f, *pscan);
+	*pscan = NULL;
+	return 0;
+}
+
+static int
+lbox_xlog_scan_iterate(struct lua_State *L)
+{
+	struct xlog_scan **pscan = lbox_checkscan(L, 1, "xlog.scan()");
+	int64_t n = luaL_checkinteger(L, 2);
+	if (*pscan == NULL)
+		return 0;
+	struct xlog_scan_rows rows;
+	int rc = xlog_scan_next(*pscan, &rows);
+	if (rc != 0) {
+		/* Stop the threads as soon as the scan is over. */
+		struct xlog_scan *scan = *pscan;
+		*pscan = NULL;
+		xlog_scan_delete(scan);
+		return rc < 0 ? luaT_error(L) : 0;
+	}
+	lua_pushinteger(L, n + 1);
+	lua_createtable(L, 0, 3);
+	lua_pushstring(L, rows.filename);
+	lua_setfield(L, -2, "filename");
+	lua_pushinteger(L, rows.count);
+	lua_setfield(L, -2, "count");
+	lua_pushlstring(L, rows.data, rows.data_end - rows.data);
+	lua_setfield(L, -2, "data");
+	return 2;
+}
+
+/** Convert a row type given by name or number to a mask bit. */
+static uint64_t
+lbox_xlog_scan_type_bit(struct lua_State *L, int idx)
+{
+	if (lua_type(L, idx) == LUA_TNUMBER) {
+		lua_Integer type = lua_tointeger(L, idx);
+		if (type >= 0 && type < 64)
+			return 1ULL << type;
+	} else if (lua_type(L, idx) == LUA_TSTRING) {
+		const char *name = lua_tostring(L, idx);
+		for (uint32_t type = 0; type < 64; type++) {
+			const char *type_name = iproto_type_name(type);
+			if (type_name != NULL &&
+			    strcasecmp(type_name, name) == 0)
+				return 1ULL << type;
+		}
+	}
+	luaL_error(L, "xlog.scan: unknown row type '%s'",
+		   luaT_tolstring(L, idx, NULL));
+	unreachable();
+	return 0;
+}
+
+/**
+ * xlog.scan(filenames[, {threads = <count>, part_size = <bytes>,
+ *                        spaces = {<id>, ...}, types = {...}}])
+ * Returns an iterator over batches of raw rows of the files,
+ * see xlog_scan_new().
+ */
+static int
+lbox_xlog_scan_open(struct lua_State *L)
+{
+	const char *usage = "Usage: xlog.scan(filenames[, opts])";
+	int args_n = lua_gettop(L);
+	if (args_n < 1 || args_n > 2 ||
+	    (!lua_isstring(L, 1) && !lua_istable(L, 1)) ||
+	    (args_n == 2 && !lua_isnil(L, 2) && !lua_istable(L, 2)))
+		luaL_error(L, usage);
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	int file_count = 1;
+	if (lua_istable(L, 1))
+		file_count = lua_objlen(L, 1);
+	size_t size = MAX(file_count, 1) * sizeof(const char *);
+	const char **filenames = region_alloc(region, size);
+	if (filenames == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "filenames");
+		return luaT_error(L);
+	}
+	if (lua_isstring(L, 1)) {
+		filenames[0] = lua_tostring(L, 1);
+	} else {
+		/* The table keeps the strings alive during the call. */
+		for (int i = 0; i < file_count; i++) {
+			lua_rawgeti(L, 1, i + 1);
+			if (!lua_isstring(L, -1))
+				luaL_error(L, usage);
+			filenames[i] = lua_tostring(L, -1);
+			lua_pop(L, 1);
+		}
+	}
+
+	struct xlog_scan_opts opts;
+	xlog_scan_opts_create(&opts);
+	if (args_n == 2 && lua_istable(L, 2)) {
+		lua_getfield(L, 2, "threads");
+		if (!lua_isnil(L, -1))
+			opts.thread_count = luaL_checkinteger(L, -1);
+		lua_pop(L, 1);
+		lua_getfield(L, 2, "part_size");
+		if (!lua_isnil(L, -1))
+			opts.part_size = luaL_checkinteger(L, -1);
+		lua_pop(L, 1);
+		lua_getfield(L, 2, "types");
+		if (lua_istable(L, -1)) {
+			int count = lua_objlen(L, -1);
+			for (int i = 0; i < count; i++) {
+				lua_rawgeti(L, -1, i + 1);
+				opts.type_mask |= lbox_xlog_scan_type_bit(L, -1);
+				lua_pop(L, 1);
+			}
+		}
+		lua_pop(L, 1);
+		lua_getfield(L, 2, "spaces");
+		if (lua_istable(L, -1)) {
+			int count = lua_objlen(L, -1);
+			size = MAX(count, 1) * sizeof(uint32_t);
+			uint32_t *space_ids = region_alloc(region, size);
+			if (space_ids == NULL) {
+				diag_set(OutOfMemory, size, "region_alloc",
+					 "space ids");
+				return luaT_error(L);
+			}
+			for (int i = 0; i < count; i++) {
+				lua_rawgeti(L, -1, i + 1);
+				space_ids[i] = luaL_checkinteger(L, -1);
+				lua_pop(L, 1);
+			}
+			opts.space_ids = space_ids;
+			opts.space_id_count = count;
+		}
+		lua_pop(L, 1);
+	}
+
+	struct xlog_scan *scan = xlog_scan_new(filenames, file_count, &opts);
+	region_truncate(region, region_svp);
+	if (scan == NULL)
+		return luaT_error(L);
+	lua_pushcfunction(L, lbox_xlog_scan_iterate);
+	struct xlog_scan **pscan = (struct xlog_scan **)luaL_pushcdata(L,
+			CTID_STRUCT_XLOG_SCAN_REF);
+	*pscan = scan;
+	lua_pushcfunction(L, lbox_xlog_scan_gc);
+	luaL_setcdatagc(L, -2);
+	lua_pushinteger(L, 0);
+	return 3;
+}
+
+/* }}} */
+
 static const struct luaL_Reg lbox_xlog_parser_lib [] = {
 	{ "pairs",	lbox_xlog_parser_open_pairs },
+	{ "scan",	lbox_xlog_scan_open         },
 	{ NULL,		NULL                        }
 };
 
@@ -313,6 +510,9 @@ box_lua_xlog_init(struct lua_State *L)
 	rc = luaL_cdef(L, "struct xlog_cursor;"); assert(rc == 0); (void) rc;
 	CTID_STRUCT_XLOG_CURSOR_REF = luaL_ctypeid(L, "struct xlog_cursor&");
 	assert(CTID_STRUCT_XLOG_CURSOR_REF != 0);
+	rc = luaL_cdef(L, "struct xlog_scan;"); assert(rc == 0); (void) rc;
+	CTID_STRUCT_XLOG_SCAN_REF = luaL_ctypeid(L, "struct xlog_scan&");
+	assert(CTID_STRUCT_XLOG_SCAN_REF != 0);
 
 	luaL_register_module(L, xloglib_name, lbox_xlog_parser_lib);
 
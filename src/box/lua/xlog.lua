@@ -4,6 +4,11 @@ local function xlog_pairs(...)
     return fun.wrap(internal.pairs(...))
 end
 
+local function xlog_scan(...)
+    return fun.wrap(internal.scan(...))
+end
+
 package.loaded['xlog'] = {
     pairs = xlog_pairs,
+    scan = xlog_scan,
 }
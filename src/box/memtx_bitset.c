@@ -457,6 +457,15 @@ memtx_bitset_index_count(struct index *base, enum iterator_type type,
 	return generic_index_count(base, type, key, part_count);
 }
 
+static bool
+memtx_bitset_index_def_change_requires_rebuild(struct index *index,
+					       const struct index_def *new_def)
+{
+	if (index->def->opts.is_sparse != new_def->opts.is_sparse)
+		return true;
+	return memtx_index_def_change_requires_rebuild(index, new_def);
+}
+
 static const struct index_vtab memtx_bitset_index_vtab = {
 	/* .destroy = */ memtx_bitset_index_destroy,
 	/* .commit_create = */ generic_index_commit_create,
@@ -466,16 +475,23 @@ static const struct index_vtab memtx_bitset_index_vtab = {
 	/* .update_def = */ generic_index_update_def,
 	/* .depends_on_pk = */ generic_index_depends_on_pk,
 	/* .def_change_requires_rebuild = */
-		memtx_index_def_change_requires_rebuild,
+		memtx_bitset_index_def_change_requires_rebuild,
 	/* .size = */ memtx_bitset_index_size,
 	/* .bsize = */ memtx_bitset_index_bsize,
 	/* .min = */ generic_index_min,
 	/* .max = */ generic_index_max,
 	/* .random = */ generic_index_random,
 	/* .count = */ memtx_bitset_index_count,
+	/* .estimate_count = */ generic_index_estimate_count,
 	/* .get = */ generic_index_get,
+	/* .get_batch = */ generic_index_get_batch,
 	/* .replace = */ memtx_bitset_index_replace,
+	/* .replace_in_place = */ generic_index_replace_in_place,
 	/* .create_iterator = */ memtx_bitset_index_create_iterator,
+	/* .create_covering_iterator = */
+		generic_index_create_covering_iterator,
+	/* .create_filtered_iterator = */
+		generic_index_create_filtered_iterator,
 	/* .create_snapshot_iterator = */
 		generic_index_create_snapshot_iterator,
 	/* .stat = */ generic_index_stat,
@@ -524,6 +540,9 @@ memtx_bitset_index_new(struct memtx_engine *memtx, struct index_def *def)
 		panic("failed to allocate memtx bitset index");
 #endif /* #ifndef OLD_GOOD_BITSET */
 
-	tt_bitset_index_create(&index->index, realloc);
+	if (def->opts.is_sparse)
+		tt_bitset_index_create_sparse(&index->index, realloc);
+	else
+		tt_bitset_index_create(&index->index, realloc);
 	return index;
 }
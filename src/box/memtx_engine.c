@@ -34,36 +34,97 @@
 #include <small/quota.h>
 #include <small/small.h>
 #include <small/mempool.h>
+#include <zstd.h>
 
 #include "fiber.h"
+#include "coio_task.h"
 #include "errinj.h"
+#include "pmatomic.h"
 #include "coio_file.h"
 #include "tuple.h"
+#include "tuple_update.h"
+#include "column_mask.h"
 #include "txn.h"
 #include "memtx_tree.h"
 #include "iproto_constants.h"
 #include "xrow.h"
 #include "xstream.h"
+#include "xlog_reader.h"
 #include "bootstrap.h"
 #include "replication.h"
 #include "schema.h"
 #include "gc.h"
+#include "assoc.h"
+#include "affinity.h"
+
+/** Memtx-specific data of a multi-statement transaction. */
+struct memtx_tx {
+	/**
+	 * Set if the transaction yielded before changing any
+	 * data, see txn_on_yield().
+	 */
+	bool has_yielded;
+	/** memtx_engine::write_gen at the first such yield. */
+	uint64_t write_gen;
+};
+
+/** Return true if a transaction has changed any tuples. */
+static bool
+memtx_txn_has_changes(struct txn *txn)
+{
+	struct txn_stmt *stmt;
+	stailq_foreach_entry(stmt, &txn->stmts, next) {
+		if (stmt->old_tuple != NULL || stmt->new_tuple != NULL)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Abort a transaction that yielded before changing anything
+ * if memtx data has been changed since then: what it read
+ * before the yield may be stale by now.
+ */
+static void
+memtx_tx_check_yield(struct memtx_engine *memtx, struct txn *txn)
+{
+	struct memtx_tx *tx = (struct memtx_tx *)txn->engine_tx;
+	if (tx->has_yielded && tx->write_gen != memtx->write_gen)
+		txn->is_aborted = true;
+}
 
 /*
  * Memtx yield-in-transaction trigger: roll back the effects
  * of the transaction and mark the transaction as aborted.
+ *
+ * A transaction that hasn't changed anything yet has nothing
+ * to hide from other fibers, so it isn't aborted right away.
+ * It stays valid as long as nobody changes memtx data while
+ * it is waiting, which is checked when it starts writing and
+ * when it commits.
  */
 static void
 txn_on_yield(struct trigger *trigger, void *event)
 {
-	(void) trigger;
 	(void) event;
+	struct memtx_engine *memtx = (struct memtx_engine *)trigger->data;
 
 	struct txn *txn = in_txn();
 	assert(txn && txn->engine_tx);
 	if (txn == NULL || txn->engine_tx == NULL)
 		return;
-	txn_abort(txn);                 /* doesn't yield or fail */
+	if (txn->is_aborted)
+		return;
+	if (memtx_txn_has_changes(txn)) {
+		txn_abort(txn);         /* doesn't yield or fail */
+		return;
+	}
+	struct memtx_tx *tx = (struct memtx_tx *)txn->engine_tx;
+	memtx_tx_check_yield(memtx, txn);
+	if (!tx->has_yielded) {
+		tx->has_yielded = true;
+		tx->write_gen = memtx->write_gen;
+	}
 }
 
 /**
@@ -81,13 +142,23 @@ txn_on_yield(struct trigger *trigger, void *event)
  * So much hassle to be user-friendly until we have a true
  * interactive transaction support in memtx.
  */
-void
-memtx_init_txn(struct txn *txn)
+static int
+memtx_init_txn(struct memtx_engine *memtx, struct txn *txn)
 {
 	struct fiber *fiber = fiber();
 
+	struct memtx_tx *tx = region_alloc_object(&fiber->gc,
+						  struct memtx_tx);
+	if (tx == NULL) {
+		diag_set(OutOfMemory, sizeof(*tx), "region",
+			 "struct memtx_tx");
+		return -1;
+	}
+	tx->has_yielded = false;
+	tx->write_gen = 0;
+
 	trigger_create(&txn->fiber_on_yield, txn_on_yield,
-		       NULL, NULL);
+		       memtx, NULL);
 	trigger_create(&txn->fiber_on_stop, txn_on_stop,
 		       NULL, NULL);
 	/*
@@ -98,10 +169,11 @@ memtx_init_txn(struct txn *txn)
 	trigger_add(&fiber->on_yield, &txn->fiber_on_yield);
 	trigger_add(&fiber->on_stop, &txn->fiber_on_stop);
 	/*
-	 * This serves as a marker that the triggers are
+	 * This also serves as a marker that the triggers are
 	 * initialized.
 	 */
-	txn->engine_tx = txn;
+	txn->engine_tx = tx;
+	return 0;
 }
 
 struct memtx_tuple {
@@ -112,10 +184,36 @@ struct memtx_tuple {
 	 * how smfree_delayed and snapshotting COW works.
 	 */
 	/** Snapshot generation version. */
-	uint32_t version;
+	uint32_t version : 31;
+	/**
+	 * Set if the fields that aren't indexed are compressed,
+	 * see memtx_tuple_pack().
+	 */
+	uint32_t is_packed : 1;
 	struct tuple base;
 };
 
+/**
+ * Header of compressed fields of a packed tuple. Stored right
+ * after the uncompressed fields, which are accounted in the
+ * tuple bsize, and followed by the compressed data.
+ */
+struct PACKED memtx_tuple_tail {
+	/** Size of the compressed data. */
+	uint32_t size;
+	/** Size of the fields when decompressed. */
+	uint32_t raw_size;
+	/** Number of compressed fields. */
+	uint32_t field_count;
+};
+
+static inline struct memtx_tuple_tail *
+memtx_tuple_tail(const struct tuple *tuple)
+{
+	return (struct memtx_tuple_tail *)((char *)tuple +
+					   tuple->data_offset + tuple->bsize);
+}
+
 enum {
 	OBJSIZE_MIN = 16,
 	SLAB_SIZE = 16 * 1024 * 1024,
@@ -135,6 +233,95 @@ memtx_end_build_primary_key(struct space *space, void *param)
 	return 0;
 }
 
+/** Sort the build array of a tree index in a coio thread. */
+static ssize_t
+memtx_tree_index_sort_f(va_list ap)
+{
+	struct memtx_tree_index *index =
+		va_arg(ap, struct memtx_tree_index *);
+	memtx_tree_index_sort_build_array(index);
+	return 0;
+}
+
+static int
+memtx_tree_index_sort_fiber_f(va_list ap)
+{
+	struct memtx_tree_index *index =
+		va_arg(ap, struct memtx_tree_index *);
+	return coio_call(memtx_tree_index_sort_f, index) < 0 ? -1 : 0;
+}
+
+/**
+ * Build all secondary indexes of a space. Unlike index_build()
+ * called for each index in turn, this function scans the primary
+ * key only once, then sorts the build arrays of all tree indexes
+ * in parallel in coio threads.
+ */
+static int
+memtx_build_secondary_indexes(struct space *space)
+{
+	struct index *pk = space->index[0];
+	ssize_t n_tuples = index_size(pk);
+	if (n_tuples < 0)
+		return -1;
+	uint32_t estimated_tuples = n_tuples * 1.2;
+
+	for (uint32_t j = 1; j < space->index_count; j++) {
+		struct index *index = space->index[j];
+		index_begin_build(index);
+		if (index_reserve(index, estimated_tuples) < 0)
+			return -1;
+		if (n_tuples > 0) {
+			say_info("Adding %zd keys to %s index '%s' ...",
+				 n_tuples, index_type_strs[index->def->type],
+				 index->def->name);
+		}
+	}
+
+	struct iterator *it = index_create_iterator(pk, ITER_ALL, NULL, 0);
+	if (it == NULL)
+		return -1;
+	int rc = 0;
+	while (rc == 0) {
+		struct tuple *tuple;
+		rc = iterator_next(it, &tuple);
+		if (rc != 0 || tuple == NULL)
+			break;
+		for (uint32_t j = 1; j < space->index_count && rc == 0; j++)
+			rc = index_build_next(space->index[j], tuple);
+	}
+	iterator_delete(it);
+	if (rc != 0)
+		return -1;
+
+	struct fiber *sorters[BOX_INDEX_MAX];
+	uint32_t sorter_count = 0;
+	for (uint32_t j = 1; j < space->index_count; j++) {
+		struct index *index = space->index[j];
+		if (index->def->type != TREE)
+			continue;
+		struct fiber *f = fiber_new("memtx.sort",
+					    memtx_tree_index_sort_fiber_f);
+		if (f == NULL) {
+			rc = -1;
+			break;
+		}
+		fiber_set_joinable(f, true);
+		fiber_start(f, index);
+		sorters[sorter_count++] = f;
+	}
+	for (uint32_t i = 0; i < sorter_count; i++) {
+		if (fiber_join(sorters[i]) != 0)
+			rc = -1;
+	}
+	if (rc != 0)
+		return -1;
+
+	for (uint32_t j = 1; j < space->index_count; j++)
+		index_end_build(space->index[j]);
+	return 0;
+}
+
 /**
  * Secondary indexes are built in bulk after all data is
  * recovered. This function enables secondary keys on a space.
@@ -159,10 +346,8 @@ memtx_build_secondary_keys(struct space *space, void *param)
 				 space_name(space));
 		}
 
-		for (uint32_t j = 1; j < space->index_count; j++) {
-			if (index_build(space->index[j], pk) < 0)
-				return -1;
-		}
+		if (memtx_build_secondary_indexes(space) != 0)
+			return -1;
 
 		if (n_tuples > 0) {
 			say_info("Space '%s': done", space_name(space));
@@ -172,6 +357,157 @@ memtx_build_secondary_keys(struct space *space, void *param)
 	return 0;
 }
 
+/* {{{ Delta snapshots */
+
+/** A delta snapshot in the snapshot directory. */
+struct memtx_snap_delta {
+	/** Signature of the delta snapshot. */
+	int64_t signature;
+	/** Signature of the snapshot it is based on. */
+	int64_t base_signature;
+	/** Link in memtx_engine::snap_deltas. */
+	struct rlist in_snap_deltas;
+};
+
+static struct memtx_snap_delta *
+memtx_snap_delta_find(struct memtx_engine *memtx, int64_t signature)
+{
+	struct memtx_snap_delta *delta;
+	rlist_foreach_entry(delta, &memtx->snap_deltas, in_snap_deltas) {
+		if (delta->signature == signature)
+			return delta;
+	}
+	return NULL;
+}
+
+static struct memtx_snap_delta *
+memtx_snap_delta_new(int64_t signature, int64_t base_signature)
+{
+	struct memtx_snap_delta *delta = malloc(sizeof(*delta));
+	if (delta == NULL) {
+		diag_set(OutOfMemory, sizeof(*delta),
+			 "malloc", "struct memtx_snap_delta");
+		return NULL;
+	}
+	delta->signature = signature;
+	delta->base_signature = base_signature;
+	rlist_create(&delta->in_snap_deltas);
+	return delta;
+}
+
+static void
+memtx_snap_delta_delete_all(struct memtx_engine *memtx)
+{
+	struct memtx_snap_delta *delta, *tmp;
+	rlist_foreach_entry_safe(delta, &memtx->snap_deltas,
+				 in_snap_deltas, tmp)
+		free(delta);
+	rlist_create(&memtx->snap_deltas);
+}
+
+/**
+ * Return the signature of the full snapshot a snapshot is
+ * based on, directly or through other delta snapshots, and
+ * the number of deltas in between.
+ */
+static int64_t
+memtx_snap_full_signature(struct memtx_engine *memtx, int64_t signature,
+			  int *delta_count)
+{
+	int count = 0;
+	struct memtx_snap_delta *delta;
+	while ((delta = memtx_snap_delta_find(memtx, signature)) != NULL) {
+		signature = delta->base_signature;
+		count++;
+	}
+	if (delta_count != NULL)
+		*delta_count = count;
+	return signature;
+}
+
+/** Decode the space id of a MEMTX_SNAP_BASE_SPACE row. */
+static int
+memtx_snap_decode_base_space(struct xrow_header *row, uint32_t *space_id)
+{
+	if (row->bodycnt == 0)
+		goto error;
+	const char *data = (const char *)row->body[0].iov_base;
+	if (mp_typeof(*data) != MP_MAP || mp_decode_map(&data) != 1 ||
+	    mp_typeof(*data) != MP_UINT ||
+	    mp_decode_uint(&data) != IPROTO_SPACE_ID ||
+	    mp_typeof(*data) != MP_UINT)
+		goto error;
+	*space_id = mp_decode_uint(&data);
+	return 0;
+error:
+	diag_set(ClientError, ER_INVALID_MSGPACK, "base space row");
+	return -1;
+}
+
+static inline bool
+memtx_snap_space_set_has(struct mh_i32ptr_t *set, uint32_t space_id)
+{
+	return mh_i32ptr_find(set, space_id, NULL) != mh_end(set);
+}
+
+static inline int
+memtx_snap_space_set_add(struct mh_i32ptr_t *set, uint32_t space_id)
+{
+	const struct mh_i32ptr_node_t node = { space_id, NULL };
+	if (mh_i32ptr_put(set, &node, NULL, NULL) == mh_end(set)) {
+		diag_set(OutOfMemory, sizeof(node), "mh_i32ptr_put",
+			 "snapshot space set");
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Filter a row of a snapshot file. @a spaces is the set of
+ * spaces to load from the file, NULL means all. Spaces of the
+ * set that the file refers to its base for are added to
+ * @a base_spaces.
+ *
+ * @retval 1 the row should be loaded
+ * @retval 0 the row should be skipped
+ * @retval -1 error
+ */
+static int
+memtx_snap_filter_row(struct xrow_header *row, struct mh_i32ptr_t *spaces,
+		      struct mh_i32ptr_t *base_spaces)
+{
+	uint32_t space_id;
+	if (row->type == MEMTX_SNAP_BASE_SPACE) {
+		if (memtx_snap_decode_base_space(row, &space_id) != 0)
+			return -1;
+		if (spaces != NULL && !memtx_snap_space_set_has(spaces,
+								space_id))
+			return 0;
+		if (memtx_snap_space_set_add(base_spaces, space_id) != 0)
+			return -1;
+		return 0;
+	}
+	if (spaces == NULL)
+		return 1;
+	struct request request;
+	if (xrow_decode_dml(row, &request, dml_request_key_map(row->type)) != 0)
+		return -1;
+	return memtx_snap_space_set_has(spaces, request.space_id) ? 1 : 0;
+}
+
+static int
+memtx_snap_mark_clean(struct space *space, void *data)
+{
+	(void)data;
+	if (!space_is_memtx(space))
+		return 0;
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	memtx_space->snap_write_gen = memtx_space->write_gen;
+	return 0;
+}
+
+/* }}} */
+
 static void
 memtx_engine_shutdown(struct engine *engine)
 {
@@ -189,7 +525,10 @@ memtx_engine_shutdown(struct engine *engine)
 	small_alloc_destroy(&memtx->alloc);
 	slab_cache_destroy(&memtx->slab_cache);
 	tuple_arena_destroy(&memtx->arena);
+	memtx_snap_delta_delete_all(memtx);
 	xdir_destroy(&memtx->snap_dir);
+	ZSTD_freeCCtx(memtx->zcctx);
+	ZSTD_freeDCtx(memtx->zdctx);
 	free(memtx);
 }
 
@@ -197,28 +536,35 @@ static int
 memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 				  struct xrow_header *row);
 
-int
-memtx_engine_recover_snapshot(struct memtx_engine *memtx,
-			      const struct vclock *vclock)
+/**
+ * Load the rows of a snapshot file, see memtx_snap_filter_row()
+ * for the meaning of @a spaces and @a base_spaces.
+ */
+static int
+memtx_engine_recover_snapshot_file(struct memtx_engine *memtx,
+				   int64_t file_signature, int64_t signature,
+				   struct mh_i32ptr_t *spaces,
+				   struct mh_i32ptr_t *base_spaces)
 {
-	/* Process existing snapshot */
-	say_info("recovery start");
-	int64_t signature = vclock_sum(vclock);
 	const char *filename = xdir_format_filename(&memtx->snap_dir,
-						    signature, NONE);
+						    file_signature, NONE);
 
 	say_info("recovering from `%s'", filename);
-	struct xlog_cursor cursor;
-	if (xlog_cursor_open(&cursor, filename) < 0)
+
+	struct xlog_reader *reader = xlog_reader_new(filename,
+						      memtx->force_recovery);
+	if (reader == NULL)
 		return -1;
 
 	int rc;
-	struct xrow_header row;
+	struct xrow_header *row;
 	uint64_t row_count = 0;
-	while ((rc = xlog_cursor_next(&cursor, &row,
-				      memtx->force_recovery)) == 0) {
-		row.lsn = signature;
-		rc = memtx_engine_recover_snapshot_row(memtx, &row);
+	while ((rc = xlog_reader_next(reader, &row)) == 0) {
+		rc = memtx_snap_filter_row(row, spaces, base_spaces);
+		if (rc > 0) {
+			row->lsn = signature;
+			rc = memtx_engine_recover_snapshot_row(memtx, row);
+		}
 		if (rc < 0) {
 			if (!memtx->force_recovery)
 				break;
@@ -232,7 +578,8 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 			fiber_yield_timeout(0);
 		}
 	}
-	xlog_cursor_close(&cursor, false);
+	bool has_eof_marker = xlog_reader_has_eof_marker(reader);
+	xlog_reader_delete(reader);
 	if (rc < 0)
 		return -1;
 
@@ -241,9 +588,68 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 	 * marker - such snapshots are very likely corrupted and
 	 * should not be trusted.
 	 */
-	if (!xlog_cursor_is_eof(&cursor))
-		panic("snapshot `%s' has no EOF marker", filename);
+	if (!has_eof_marker)
+		panic("snapshot `%s' has no EOF marker",
+		      xdir_format_filename(&memtx->snap_dir,
+					   file_signature, NONE));
+	return 0;
+}
+
+int
+memtx_engine_recover_snapshot(struct memtx_engine *memtx,
+			      const struct vclock *vclock)
+{
+	/* Process existing snapshot */
+	say_info("recovery start");
+	int64_t signature = vclock_sum(vclock);
 
+	/*
+	 * Load the snapshot, then load spaces it refers to its
+	 * base for from the base, and so on until there are no
+	 * such spaces left. System spaces are always written in
+	 * full, so all spaces exist by the time a base is read.
+	 */
+	int rc = 0;
+	int64_t file_signature = signature;
+	struct mh_i32ptr_t *spaces = NULL;
+	while (true) {
+		struct mh_i32ptr_t *base_spaces = mh_i32ptr_new();
+		if (base_spaces == NULL) {
+			diag_set(OutOfMemory, sizeof(*base_spaces),
+				 "mh_i32ptr_new", "snapshot space set");
+			rc = -1;
+			break;
+		}
+		rc = memtx_engine_recover_snapshot_file(memtx, file_signature,
+							signature, spaces,
+							base_spaces);
+		if (spaces != NULL)
+			mh_i32ptr_delete(spaces);
+		spaces = base_spaces;
+		if (rc != 0 || mh_size(spaces) == 0)
+			break;
+		struct memtx_snap_delta *delta =
+			memtx_snap_delta_find(memtx, file_signature);
+		if (delta == NULL) {
+			diag_set(XlogError, "snapshot `%s' has no base",
+				 xdir_format_filename(&memtx->snap_dir,
+						      file_signature, NONE));
+			rc = -1;
+			break;
+		}
+		file_signature = delta->base_signature;
+	}
+	if (spaces != NULL)
+		mh_i32ptr_delete(spaces);
+	if (rc != 0)
+		return -1;
+
+	/*
+	 * The data is now the same as in the snapshot, so the
+	 * next snapshot may be a delta on top of it.
+	 */
+	space_foreach(memtx_snap_mark_clean, NULL);
+	memtx->snap_needs_full = false;
 	return 0;
 }
 
@@ -336,6 +742,16 @@ memtx_engine_begin_final_recovery(struct engine *engine)
 	return 0;
 }
 
+int
+memtx_engine_build_secondary_keys(struct memtx_engine *memtx)
+{
+	if (memtx->state == MEMTX_OK)
+		return 0;
+	assert(memtx->state == MEMTX_FINAL_RECOVERY);
+	memtx->state = MEMTX_OK;
+	return space_foreach(memtx_build_secondary_keys, memtx);
+}
+
 static int
 memtx_engine_end_recovery(struct engine *engine)
 {
@@ -346,12 +762,8 @@ memtx_engine_end_recovery(struct engine *engine)
 	 *   is false
 	 * - it's a replication join
 	 */
-	if (memtx->state != MEMTX_OK) {
-		assert(memtx->state == MEMTX_FINAL_RECOVERY);
-		memtx->state = MEMTX_OK;
-		if (space_foreach(memtx_build_secondary_keys, memtx) != 0)
-			return -1;
-	}
+	if (memtx_engine_build_secondary_keys(memtx) != 0)
+		return -1;
 	xdir_collect_inprogress(&memtx->snap_dir);
 	return 0;
 }
@@ -367,9 +779,10 @@ memtx_engine_create_space(struct engine *engine, struct space_def *def,
 static int
 memtx_engine_prepare(struct engine *engine, struct txn *txn)
 {
-	(void)engine;
+	struct memtx_engine *memtx = (struct memtx_engine *)engine;
 	if (txn->engine_tx == 0)
 		return 0;
+	memtx_tx_check_yield(memtx, txn);
 	/*
 	 * These triggers are only used for memtx and only
 	 * when autocommit == false, so we are saving
@@ -388,25 +801,33 @@ memtx_engine_prepare(struct engine *engine, struct txn *txn)
 static int
 memtx_engine_begin(struct engine *engine, struct txn *txn)
 {
-	(void)engine;
+	struct memtx_engine *memtx = (struct memtx_engine *)engine;
 	/*
 	 * Register a trigger to rollback transaction on yield.
 	 * This must be done in begin(), since it's
 	 * the first thing txn invokes after txn->n_stmts++,
 	 * to match with trigger_clear() in rollbackStatement().
 	 */
-	if (txn->is_autocommit == false) {
-		memtx_init_txn(txn);
-	}
+	if (txn->is_autocommit == false)
+		return memtx_init_txn(memtx, txn);
 	return 0;
 }
 
 static int
 memtx_engine_begin_statement(struct engine *engine, struct txn *txn)
 {
-	(void)engine;
-	(void)txn;
-	if (txn->engine_tx == NULL) {
+	struct memtx_engine *memtx = (struct memtx_engine *)engine;
+	if (txn->engine_tx != NULL) {
+		/*
+		 * The statement is going to change data, after
+		 * which the transaction can't survive a yield.
+		 * Check the yields it has survived so far, since
+		 * its own changes are counted in write_gen too.
+		 */
+		struct memtx_tx *tx = (struct memtx_tx *)txn->engine_tx;
+		memtx_tx_check_yield(memtx, txn);
+		tx->has_yielded = false;
+	} else {
 		struct space *space = txn_last_stmt(txn)->space;
 
 		if (space->def->id > BOX_SYSTEM_ID_MAX &&
@@ -416,7 +837,7 @@ memtx_engine_begin_statement(struct engine *engine, struct txn *txn)
 			 * a yield.
 			 */
 			assert(txn->is_autocommit);
-			memtx_init_txn(txn);
+			return memtx_init_txn(memtx, txn);
 		}
 	}
 	return 0;
@@ -456,6 +877,7 @@ memtx_engine_rollback_statement(struct engine *engine, struct txn *txn,
 			panic("failed to rollback change");
 		}
 	}
+	memtx_space_rollback_ddl_stmt(space, stmt);
 
 	memtx_space_update_bsize(space, stmt->new_tuple, stmt->old_tuple);
 	if (stmt->old_tuple != NULL)
@@ -503,21 +925,118 @@ memtx_engine_bootstrap(struct engine *engine)
 	return rc < 0 ? -1 : 0;
 }
 
+struct checkpoint_entry {
+	struct space *space;
+	struct snapshot_iterator *iterator;
+	/**
+	 * Size of the space data at the time the checkpoint
+	 * was started, used to balance checkpoint workers.
+	 */
+	size_t bsize;
+	/**
+	 * Id of the checkpoint worker writing this space or -1
+	 * if the space is written by the checkpoint thread before
+	 * starting workers (system spaces must precede user
+	 * spaces in the snapshot, because recovery of the latter
+	 * depends on the former).
+	 */
+	int worker_id;
+	/**
+	 * Set if the space has changed since the last snapshot.
+	 * Unchanged spaces aren't written to a delta snapshot.
+	 */
+	bool is_dirty;
+	/**
+	 * Set by the checkpoint thread when it is done with the
+	 * space so that tx can release the read view before the
+	 * whole checkpoint completes. Accessed atomically.
+	 */
+	int is_written;
+	struct rlist link;
+};
+
+struct checkpoint {
+	/**
+	 * List of MemTX spaces to snapshot, with consistent
+	 * read view iterators.
+	 */
+	struct rlist entries;
+	uint64_t snap_io_rate_limit;
+	/** Max number of threads writing the snapshot. */
+	int thread_count;
+	struct cord cord;
+	bool waiting_for_snap_thread;
+	/** The vclock of the snapshot file. */
+	struct vclock vclock;
+	struct xdir dir;
+	/**
+	 * Do nothing, just touch the snapshot file - the
+	 * checkpoint already exists.
+	 */
+	bool touch;
+	/** Timestamp of the snapshot rows. */
+	double tm;
+	/**
+	 * Set if the snapshot is a delta on top of the snapshot
+	 * with base_vclock, see memtx_engine::snap_delta_max.
+	 */
+	bool is_delta;
+	struct vclock base_vclock;
+	/** Registered in memtx_engine on commit if is_delta. */
+	struct memtx_snap_delta *delta;
+	/** Total size of all spaces and of changed spaces. */
+	size_t bsize;
+	size_t dirty_bsize;
+	/**
+	 * Number of rows written to the snapshot so far by all
+	 * checkpoint threads. Accessed atomically.
+	 */
+	int64_t rows;
+	/**
+	 * Set if a checkpoint worker failed so that the others
+	 * can stop early. Accessed atomically.
+	 */
+	int is_failed;
+	/**
+	 * Signalled by checkpoint threads whenever a space has
+	 * been written, see checkpoint_release_written().
+	 */
+	struct ev_async release_async;
+	/** The tx event loop, to send release_async to. */
+	struct ev_loop *tx_loop;
+	/**
+	 * Ids of formats of spaces whose read views have been
+	 * released. Tuples of these formats needn't be freed in
+	 * the delayed mode, see memtx_tuple_delete().
+	 */
+	struct mh_i32ptr_t *released_formats;
+};
+
+/**
+ * A thread writing a part of a checkpoint, with its own
+ * compression context, to a file shared with other workers.
+ */
+struct checkpoint_worker {
+	struct checkpoint *ckpt;
+	/** Xlog owning the snapshot file. */
+	struct xlog *snap;
+	/** Id of this worker, @sa checkpoint_entry::worker_id. */
+	int id;
+	/** Total size of spaces written by this worker. */
+	size_t bsize;
+	struct cord cord;
+};
+
 static int
-checkpoint_write_row(struct xlog *l, struct xrow_header *row)
+checkpoint_write_row(struct checkpoint *ckpt, struct xlog *l,
+		     struct xrow_header *row)
 {
 	struct errinj *errinj = errinj(ERRINJ_SNAP_WRITE_ROW_TIMEOUT,
 				       ERRINJ_DOUBLE);
 	if (errinj != NULL && errinj->dparam > 0)
 		usleep(errinj->dparam * 1000000);
 
-	static ev_tstamp last = 0;
-	if (last == 0) {
-		ev_now_update(loop());
-		last = ev_now(loop());
-	}
-
-	row->tm = last;
+	row->tm = ckpt->tm;
 	row->replica_id = 0;
 	/**
 	 * Rows in snapshot are numbered from 1 to %rows.
@@ -526,7 +1045,8 @@ checkpoint_write_row(struct xlog *l, struct xrow_header *row)
 	 * WAL. @sa the place which skips old rows in
 	 * recovery_apply_row().
 	 */
-	row->lsn = l->rows + l->tx_rows;
+	int64_t rows = pm_atomic_fetch_add(&ckpt->rows, 1);
+	row->lsn = rows;
 	row->sync = 0; /* don't write sync to wal */
 
 	ssize_t written = xlog_write_row(l, row);
@@ -534,15 +1054,15 @@ checkpoint_write_row(struct xlog *l, struct xrow_header *row)
 	if (written < 0)
 		return -1;
 
-	if ((l->rows + l->tx_rows) % 100000 == 0)
-		say_crit("%.1fM rows written", (l->rows + l->tx_rows) / 1000000.0);
+	if ((rows + 1) % 100000 == 0)
+		say_crit("%.1fM rows written", (rows + 1) / 1000000.0);
 	return 0;
 
 }
 
 static int
-checkpoint_write_tuple(struct xlog *l, struct space *space,
-		       const char *data, uint32_t size)
+checkpoint_write_tuple(struct checkpoint *ckpt, struct xlog *l,
+		       struct space *space, const char *data, uint32_t size)
 {
 	struct request_replace_body body;
 	body.m_body = 0x82; /* map of two elements. */
@@ -561,36 +1081,47 @@ checkpoint_write_tuple(struct xlog *l, struct space *space,
 	row.body[0].iov_len = sizeof(body);
 	row.body[1].iov_base = (char *)data;
 	row.body[1].iov_len = size;
-	return checkpoint_write_row(l, &row);
+	return checkpoint_write_row(ckpt, l, &row);
 }
 
-struct checkpoint_entry {
-	struct space *space;
-	struct snapshot_iterator *iterator;
-	struct rlist link;
-};
+static int
+checkpoint_write_base_space(struct checkpoint *ckpt, struct xlog *l,
+			    struct space *space)
+{
+	char body[16];
+	char *pos = mp_encode_map(body, 1);
+	pos = mp_encode_uint(pos, IPROTO_SPACE_ID);
+	pos = mp_encode_uint(pos, space_id(space));
 
-struct checkpoint {
-	/**
-	 * List of MemTX spaces to snapshot, with consistent
-	 * read view iterators.
-	 */
-	struct rlist entries;
-	uint64_t snap_io_rate_limit;
-	struct cord cord;
-	bool waiting_for_snap_thread;
-	/** The vclock of the snapshot file. */
-	struct vclock vclock;
-	struct xdir dir;
-	/**
-	 * Do nothing, just touch the snapshot file - the
-	 * checkpoint already exists.
-	 */
-	bool touch;
-};
+	struct xrow_header row;
+	memset(&row, 0, sizeof(struct xrow_header));
+	row.type = MEMTX_SNAP_BASE_SPACE;
+	row.bodycnt = 1;
+	row.body[0].iov_base = body;
+	row.body[0].iov_len = pos - body;
+	return checkpoint_write_row(ckpt, l, &row);
+}
+
+/**
+ * Return true if the tuples of a space are left in the base
+ * snapshot. System spaces are always written, because they
+ * must be recovered before any user space.
+ */
+static inline bool
+checkpoint_entry_is_in_base(struct checkpoint *ckpt,
+			    struct checkpoint_entry *entry)
+{
+	return ckpt->is_delta && !entry->is_dirty &&
+	       !space_is_system(entry->space);
+}
+
+static void
+checkpoint_release_written(struct ev_loop *loop, struct ev_async *watcher,
+			   int revents);
 
 static struct checkpoint *
-checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit)
+checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit,
+	       int thread_count)
 {
 	struct checkpoint *ckpt = malloc(sizeof(*ckpt));
 	if (ckpt == NULL) {
@@ -602,8 +1133,28 @@ checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit)
 	ckpt->waiting_for_snap_thread = false;
 	xdir_create(&ckpt->dir, snap_dirname, SNAP, &INSTANCE_UUID);
 	ckpt->snap_io_rate_limit = snap_io_rate_limit;
+	ckpt->thread_count = thread_count;
 	vclock_create(&ckpt->vclock);
 	ckpt->touch = false;
+	ckpt->tm = 0;
+	ckpt->is_delta = false;
+	vclock_create(&ckpt->base_vclock);
+	ckpt->delta = NULL;
+	ckpt->bsize = 0;
+	ckpt->dirty_bsize = 0;
+	ckpt->rows = 0;
+	ckpt->is_failed = 0;
+	ev_async_init(&ckpt->release_async, checkpoint_release_written);
+	ckpt->release_async.data = ckpt;
+	ckpt->tx_loop = loop();
+	ckpt->released_formats = mh_i32ptr_new();
+	if (ckpt->released_formats == NULL) {
+		diag_set(OutOfMemory, sizeof(*ckpt->released_formats),
+			 "mh_i32ptr_new", "released formats");
+		xdir_destroy(&ckpt->dir);
+		free(ckpt);
+		return NULL;
+	}
 	return ckpt;
 }
 
@@ -612,13 +1163,54 @@ checkpoint_delete(struct checkpoint *ckpt)
 {
 	struct checkpoint_entry *entry, *tmp;
 	rlist_foreach_entry_safe(entry, &ckpt->entries, link, tmp) {
-		entry->iterator->free(entry->iterator);
+		if (entry->iterator != NULL)
+			entry->iterator->free(entry->iterator);
 		free(entry);
 	}
+	ev_async_stop(loop(), &ckpt->release_async);
+	mh_i32ptr_delete(ckpt->released_formats);
 	xdir_destroy(&ckpt->dir);
+	free(ckpt->delta);
 	free(ckpt);
 }
 
+/**
+ * Called in tx when a checkpoint thread signals that it has
+ * written a space. Frees read views of written spaces so that
+ * the memory pinned by the checkpoint is bounded by the spaces
+ * being written rather than by the whole database.
+ */
+static void
+checkpoint_release_written(struct ev_loop *loop, struct ev_async *watcher,
+			   int revents)
+{
+	(void)loop;
+	(void)revents;
+	struct checkpoint *ckpt = (struct checkpoint *)watcher->data;
+	struct checkpoint_entry *entry;
+	rlist_foreach_entry(entry, &ckpt->entries, link) {
+		if (entry->iterator == NULL ||
+		    !pm_atomic_load(&entry->is_written))
+			continue;
+		entry->iterator->free(entry->iterator);
+		entry->iterator = NULL;
+		const struct mh_i32ptr_node_t node = {
+			entry->space->format->id, NULL
+		};
+		/* On OOM tuples are just freed in the delayed mode. */
+		mh_i32ptr_put(ckpt->released_formats, &node, NULL, NULL);
+	}
+}
+
+/** Tell tx that the checkpoint is done with a space. */
+static void
+checkpoint_entry_set_written(struct checkpoint *ckpt,
+			     struct checkpoint_entry *entry)
+{
+	pm_atomic_store(&entry->is_written, 1);
+	ev_async_send(ckpt->tx_loop, &ckpt->release_async);
+}
+
 
 static int
 checkpoint_add_space(struct space *sp, void *data)
@@ -640,6 +1232,17 @@ checkpoint_add_space(struct space *sp, void *data)
 	rlist_add_tail_entry(&ckpt->entries, entry, link);
 
 	entry->space = sp;
+	entry->bsize = space_bsize(sp);
+	entry->worker_id = -1;
+	entry->is_written = 0;
+	entry->iterator = NULL;
+
+	struct memtx_space *memtx_space = (struct memtx_space *)sp;
+	entry->is_dirty = memtx_space->write_gen != memtx_space->snap_write_gen;
+	memtx_space->snap_write_gen = memtx_space->write_gen;
+	ckpt->bsize += entry->bsize;
+	if (entry->is_dirty)
+		ckpt->dirty_bsize += entry->bsize;
 	entry->iterator = index_create_snapshot_iterator(pk);
 	if (entry->iterator == NULL)
 		return -1;
@@ -647,6 +1250,196 @@ checkpoint_add_space(struct space *sp, void *data)
 	return 0;
 };
 
+/** Write all spaces assigned to the given worker to an xlog. */
+static int
+checkpoint_write_entries(struct checkpoint *ckpt, struct xlog *l,
+			 int worker_id)
+{
+	struct checkpoint_entry *entry;
+	rlist_foreach_entry(entry, &ckpt->entries, link) {
+		if (entry->worker_id != worker_id)
+			continue;
+		if (checkpoint_entry_is_in_base(ckpt, entry)) {
+			if (checkpoint_write_base_space(ckpt, l,
+							entry->space) != 0) {
+				pm_atomic_store(&ckpt->is_failed, 1);
+				return -1;
+			}
+			checkpoint_entry_set_written(ckpt, entry);
+			continue;
+		}
+		uint32_t size;
+		const char *data;
+		struct snapshot_iterator *it = entry->iterator;
+		for (data = it->next(it, &size); data != NULL;
+		     data = it->next(it, &size)) {
+			/*
+			 * Another worker failed, the snapshot will
+			 * be discarded anyway. The error is reported
+			 * by the failed worker.
+			 */
+			if (pm_atomic_load(&ckpt->is_failed))
+				return 0;
+			if (checkpoint_write_tuple(ckpt, l, entry->space,
+						   data, size) != 0) {
+				pm_atomic_store(&ckpt->is_failed, 1);
+				return -1;
+			}
+		}
+		checkpoint_entry_set_written(ckpt, entry);
+	}
+	return 0;
+}
+
+static int
+checkpoint_worker_f(va_list ap)
+{
+	struct checkpoint_worker *worker =
+		va_arg(ap, struct checkpoint_worker *);
+	struct xlog l;
+	if (xlog_create_shared(&l, worker->snap) != 0) {
+		pm_atomic_store(&worker->ckpt->is_failed, 1);
+		return -1;
+	}
+	int rc = checkpoint_write_entries(worker->ckpt, &l, worker->id);
+	if (xlog_close_shared(&l) != 0) {
+		pm_atomic_store(&worker->ckpt->is_failed, 1);
+		rc = -1;
+	}
+	return rc;
+}
+
+static int
+checkpoint_entry_cmp_bsize(const void *a, const void *b)
+{
+	const struct checkpoint_entry *entry_a =
+		*(const struct checkpoint_entry **)a;
+	const struct checkpoint_entry *entry_b =
+		*(const struct checkpoint_entry **)b;
+	if (entry_a->bsize > entry_b->bsize)
+		return -1;
+	if (entry_a->bsize < entry_b->bsize)
+		return 1;
+	return 0;
+}
+
+/**
+ * Distribute user spaces among checkpoint workers so that
+ * all workers have about the same amount of data to write:
+ * the largest space not assigned yet goes to the worker that
+ * has the least data assigned so far.
+ *
+ * Returns the number of workers that got anything to write.
+ */
+static int
+checkpoint_assign_workers(struct checkpoint *ckpt,
+			  struct checkpoint_worker *workers, int count)
+{
+	int entry_count = 0;
+	struct checkpoint_entry *entry;
+	rlist_foreach_entry(entry, &ckpt->entries, link) {
+		if (!space_is_system(entry->space) &&
+		    !checkpoint_entry_is_in_base(ckpt, entry))
+			entry_count++;
+	}
+	if (entry_count == 0)
+		return 0;
+	struct checkpoint_entry **entries =
+		malloc(entry_count * sizeof(*entries));
+	if (entries == NULL) {
+		diag_set(OutOfMemory, entry_count * sizeof(*entries),
+			 "malloc", "checkpoint entries");
+		return -1;
+	}
+	int i = 0;
+	rlist_foreach_entry(entry, &ckpt->entries, link) {
+		if (!space_is_system(entry->space) &&
+		    !checkpoint_entry_is_in_base(ckpt, entry))
+			entries[i++] = entry;
+	}
+	qsort(entries, entry_count, sizeof(*entries),
+	      checkpoint_entry_cmp_bsize);
+	if (count > entry_count)
+		count = entry_count;
+	for (i = 0; i < entry_count; i++) {
+		struct checkpoint_worker *worker = &workers[0];
+		for (int j = 1; j < count; j++) {
+			if (workers[j].bsize < worker->bsize)
+				worker = &workers[j];
+		}
+		entries[i]->worker_id = worker->id;
+		worker->bsize += entries[i]->bsize;
+	}
+	free(entries);
+	return count;
+}
+
+/**
+ * Write the checkpoint to the snapshot file owned by @snap
+ * using up to ckpt->thread_count threads. System spaces are
+ * written first by the calling thread, then workers append
+ * user spaces in parallel.
+ */
+static int
+checkpoint_write_parallel(struct checkpoint *ckpt, struct xlog *snap)
+{
+	int count = ckpt->thread_count;
+	struct checkpoint_worker *workers = calloc(count, sizeof(*workers));
+	if (workers == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*workers),
+			 "calloc", "struct checkpoint_worker");
+		return -1;
+	}
+	for (int i = 0; i < count; i++) {
+		workers[i].ckpt = ckpt;
+		workers[i].snap = snap;
+		workers[i].id = i;
+	}
+	count = checkpoint_assign_workers(ckpt, workers, count);
+	if (count < 0 || checkpoint_write_entries(ckpt, snap, -1) != 0 ||
+	    xlog_flush(snap) < 0) {
+		free(workers);
+		return -1;
+	}
+	if (count == 0) {
+		free(workers);
+		return 0;
+	}
+	/*
+	 * Workers throttle independently, so split the rate
+	 * limit evenly between them.
+	 */
+	snap->rate_limit = ckpt->snap_io_rate_limit / count;
+	/* The error of the first failed worker. */
+	struct diag diag;
+	diag_create(&diag);
+	int started;
+	for (started = 0; started < count; started++) {
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "snapshot%d", started);
+		if (cord_costart(&workers[started].cord, name,
+				 checkpoint_worker_f, &workers[started]) != 0) {
+			pm_atomic_store(&ckpt->is_failed, 1);
+			diag_move(diag_get(), &diag);
+			break;
+		}
+	}
+	for (int i = 0; i < started; i++) {
+		if (cord_cojoin(&workers[i].cord) != 0 &&
+		    diag_is_empty(&diag))
+			diag_move(diag_get(), &diag);
+	}
+	int rc = 0;
+	if (!diag_is_empty(&diag)) {
+		diag_move(&diag, diag_get());
+		rc = -1;
+	}
+	diag_destroy(&diag);
+	snap->rate_limit = ckpt->snap_io_rate_limit;
+	free(workers);
+	return rc;
+}
+
 static int
 checkpoint_f(va_list ap)
 {
@@ -657,31 +1450,35 @@ checkpoint_f(va_list ap)
 			return 0;
 		/*
 		 * Failed to touch an existing snapshot, create
-		 * a new one.
+		 * a new one. It can't be a delta on top of itself.
 		 */
 		ckpt->touch = false;
+		ckpt->is_delta = false;
 	}
 
 	struct xlog snap;
-	if (xdir_create_xlog(&ckpt->dir, &snap, &ckpt->vclock) != 0)
+	if (xdir_create_xlog_with_prev(&ckpt->dir, &snap, &ckpt->vclock,
+				       ckpt->is_delta ? &ckpt->base_vclock :
+				       NULL) != 0)
 		return -1;
 
 	snap.rate_limit = ckpt->snap_io_rate_limit;
 
-	say_info("saving snapshot `%s'", snap.filename);
-	struct checkpoint_entry *entry;
-	rlist_foreach_entry(entry, &ckpt->entries, link) {
-		uint32_t size;
-		const char *data;
-		struct snapshot_iterator *it = entry->iterator;
-		for (data = it->next(it, &size); data != NULL;
-		     data = it->next(it, &size)) {
-			if (checkpoint_write_tuple(&snap, entry->space,
-					data, size) != 0) {
-				xlog_close(&snap, false);
-				return -1;
-			}
-		}
+	ev_now_update(loop());
+	ckpt->tm = ev_now(loop());
+
+	if (ckpt->is_delta)
+		say_info("saving delta snapshot `%s'", snap.filename);
+	else
+		say_info("saving snapshot `%s'", snap.filename);
+	int rc;
+	if (ckpt->thread_count > 1)
+		rc = checkpoint_write_parallel(ckpt, &snap);
+	else
+		rc = checkpoint_write_entries(ckpt, &snap, -1);
+	if (rc != 0) {
+		xlog_close(&snap, false);
+		return -1;
 	}
 	if (xlog_flush(&snap) < 0) {
 		xlog_close(&snap, false);
@@ -692,6 +1489,35 @@ checkpoint_f(va_list ap)
 	return 0;
 }
 
+/**
+ * Make the checkpoint a delta on top of the last snapshot
+ * unless there are too many deltas in a row already or most
+ * of the data has changed anyway.
+ */
+static void
+memtx_engine_prepare_delta(struct memtx_engine *memtx,
+			   struct checkpoint *ckpt)
+{
+	if (memtx->snap_delta_max == 0 || memtx->snap_needs_full)
+		return;
+	int64_t base = xdir_last_vclock(&memtx->snap_dir, &ckpt->base_vclock);
+	if (base < 0)
+		return;
+	int delta_count;
+	memtx_snap_full_signature(memtx, base, &delta_count);
+	if (delta_count >= memtx->snap_delta_max)
+		return;
+	if (ckpt->dirty_bsize > ckpt->bsize / 2)
+		return;
+	/* The signature is set when the checkpoint vclock is known. */
+	ckpt->delta = memtx_snap_delta_new(-1, base);
+	if (ckpt->delta == NULL) {
+		diag_log();
+		return;
+	}
+	ckpt->is_delta = true;
+}
+
 static int
 memtx_engine_begin_checkpoint(struct engine *engine)
 {
@@ -699,19 +1525,20 @@ memtx_engine_begin_checkpoint(struct engine *engine)
 
 	assert(memtx->checkpoint == NULL);
 	memtx->checkpoint = checkpoint_new(memtx->snap_dir.dirname,
-					   memtx->snap_io_rate_limit);
+					   memtx->snap_io_rate_limit,
+					   memtx->snap_threads);
 	if (memtx->checkpoint == NULL)
 		return -1;
 
 	if (space_foreach(checkpoint_add_space, memtx->checkpoint) != 0) {
 		checkpoint_delete(memtx->checkpoint);
 		memtx->checkpoint = NULL;
+		memtx->snap_needs_full = true;
 		return -1;
 	}
+	memtx_engine_prepare_delta(memtx, memtx->checkpoint);
 
-	/* increment snapshot version; set tuple deletion to delayed mode */
-	memtx->snapshot_version++;
-	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, true);
+	memtx_engine_enter_delayed_free_mode(memtx);
 	return 0;
 }
 
@@ -732,6 +1559,7 @@ memtx_engine_wait_checkpoint(struct engine *engine,
 	}
 	vclock_copy(&memtx->checkpoint->vclock, vclock);
 
+	ev_async_start(loop(), &memtx->checkpoint->release_async);
 	if (cord_costart(&memtx->checkpoint->cord, "snapshot",
 			 checkpoint_f, memtx->checkpoint)) {
 		return -1;
@@ -742,6 +1570,7 @@ memtx_engine_wait_checkpoint(struct engine *engine,
 	int result = cord_cojoin(&memtx->checkpoint->cord);
 	if (result != 0)
 		diag_log();
+	ev_async_stop(loop(), &memtx->checkpoint->release_async);
 
 	memtx->checkpoint->waiting_for_snap_thread = false;
 	return result;
@@ -759,7 +1588,7 @@ memtx_engine_commit_checkpoint(struct engine *engine,
 	/* waitCheckpoint() must have been done. */
 	assert(!memtx->checkpoint->waiting_for_snap_thread);
 
-	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
+	memtx_engine_leave_delayed_free_mode(memtx);
 
 	if (!memtx->checkpoint->touch) {
 		int64_t lsn = vclock_sum(&memtx->checkpoint->vclock);
@@ -780,6 +1609,15 @@ memtx_engine_commit_checkpoint(struct engine *engine,
 		int rc = coio_rename(from, to);
 		if (rc != 0)
 			panic("can't rename .snap.inprogress");
+		if (memtx->checkpoint->is_delta) {
+			struct memtx_snap_delta *delta = memtx->checkpoint->delta;
+			delta->signature = lsn;
+			rlist_add_tail_entry(&memtx->snap_deltas, delta,
+					     in_snap_deltas);
+			memtx->checkpoint->delta = NULL;
+		} else {
+			memtx->snap_needs_full = false;
+		}
 	}
 
 	struct vclock last;
@@ -808,7 +1646,13 @@ memtx_engine_abort_checkpoint(struct engine *engine)
 		memtx->checkpoint->waiting_for_snap_thread = false;
 	}
 
-	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
+	memtx_engine_leave_delayed_free_mode(memtx);
+
+	/*
+	 * Write generations of spaces were saved as if the
+	 * checkpoint succeeded, so don't trust them anymore.
+	 */
+	memtx->snap_needs_full = true;
 
 	/** Remove garbage .inprogress file. */
 	char *filename =
@@ -825,8 +1669,18 @@ static void
 memtx_engine_collect_garbage(struct engine *engine, const struct vclock *vclock)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
-	xdir_collect_garbage(&memtx->snap_dir, vclock_sum(vclock),
-			     XDIR_GC_ASYNC);
+	/* Keep the snapshots the oldest checkpoint is based on. */
+	int64_t signature = memtx_snap_full_signature(memtx,
+						      vclock_sum(vclock), NULL);
+	xdir_collect_garbage(&memtx->snap_dir, signature, XDIR_GC_ASYNC);
+	struct memtx_snap_delta *delta, *tmp;
+	rlist_foreach_entry_safe(delta, &memtx->snap_deltas,
+				 in_snap_deltas, tmp) {
+		if (delta->signature < signature) {
+			rlist_del_entry(delta, in_snap_deltas);
+			free(delta);
+		}
+	}
 }
 
 static int
@@ -834,9 +1688,19 @@ memtx_engine_backup(struct engine *engine, const struct vclock *vclock,
 		    engine_backup_cb cb, void *cb_arg)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
-	char *filename = xdir_format_filename(&memtx->snap_dir,
-					      vclock_sum(vclock), NONE);
-	return cb(filename, cb_arg);
+	/* A delta snapshot is useless without its bases. */
+	int64_t signature = vclock_sum(vclock);
+	while (true) {
+		char *filename = xdir_format_filename(&memtx->snap_dir,
+						      signature, NONE);
+		if (cb(filename, cb_arg) != 0)
+			return -1;
+		struct memtx_snap_delta *delta =
+			memtx_snap_delta_find(memtx, signature);
+		if (delta == NULL)
+			return 0;
+		signature = delta->base_signature;
+	}
 }
 
 /** Used to pass arguments to memtx_initial_join_f */
@@ -847,31 +1711,27 @@ struct memtx_join_arg {
 };
 
 /**
- * Invoked from a thread to feed snapshot rows.
+ * Feed rows of a snapshot file, see memtx_snap_filter_row()
+ * for the meaning of @a spaces and @a base_spaces. The vclock
+ * of the file base is returned in @a base_vclock.
  */
 static int
-memtx_initial_join_f(va_list ap)
+memtx_initial_join_file(struct xdir *dir, int64_t signature,
+			struct xstream *stream, struct mh_i32ptr_t *spaces,
+			struct mh_i32ptr_t *base_spaces,
+			struct vclock *base_vclock)
 {
-	struct memtx_join_arg *arg = va_arg(ap, struct memtx_join_arg *);
-	const char *snap_dirname = arg->snap_dirname;
-	int64_t checkpoint_lsn = arg->checkpoint_lsn;
-	struct xstream *stream = arg->stream;
-
-	struct xdir dir;
-	/*
-	 * snap_dirname and INSTANCE_UUID don't change after start,
-	 * safe to use in another thread.
-	 */
-	xdir_create(&dir, snap_dirname, SNAP, &INSTANCE_UUID);
 	struct xlog_cursor cursor;
-	int rc = xdir_open_cursor(&dir, checkpoint_lsn, &cursor);
-	xdir_destroy(&dir);
+	int rc = xdir_open_cursor(dir, signature, &cursor);
 	if (rc < 0)
 		return -1;
+	vclock_copy(base_vclock, &cursor.meta.prev_vclock);
 
 	struct xrow_header row;
 	while ((rc = xlog_cursor_next(&cursor, &row, true)) == 0) {
-		rc = xstream_write(stream, &row);
+		rc = memtx_snap_filter_row(&row, spaces, base_spaces);
+		if (rc > 0)
+			rc = xstream_write(stream, &row);
 		if (rc < 0)
 			break;
 	}
@@ -890,6 +1750,57 @@ memtx_initial_join_f(va_list ap)
 	return 0;
 }
 
+/**
+ * Invoked from a thread to feed snapshot rows. A delta
+ * snapshot is followed by the rows of the spaces it refers
+ * to its base for, read from the base.
+ */
+static int
+memtx_initial_join_f(va_list ap)
+{
+	struct memtx_join_arg *arg = va_arg(ap, struct memtx_join_arg *);
+	const char *snap_dirname = arg->snap_dirname;
+	int64_t signature = arg->checkpoint_lsn;
+	struct xstream *stream = arg->stream;
+
+	struct xdir dir;
+	/*
+	 * snap_dirname and INSTANCE_UUID don't change after start,
+	 * safe to use in another thread.
+	 */
+	xdir_create(&dir, snap_dirname, SNAP, &INSTANCE_UUID);
+	int rc = 0;
+	struct mh_i32ptr_t *spaces = NULL;
+	while (true) {
+		struct mh_i32ptr_t *base_spaces = mh_i32ptr_new();
+		if (base_spaces == NULL) {
+			diag_set(OutOfMemory, sizeof(*base_spaces),
+				 "mh_i32ptr_new", "snapshot space set");
+			rc = -1;
+			break;
+		}
+		struct vclock base_vclock;
+		rc = memtx_initial_join_file(&dir, signature, stream, spaces,
+					     base_spaces, &base_vclock);
+		if (spaces != NULL)
+			mh_i32ptr_delete(spaces);
+		spaces = base_spaces;
+		if (rc != 0 || mh_size(spaces) == 0)
+			break;
+		if (!vclock_is_set(&base_vclock)) {
+			diag_set(XlogError, "snapshot `%s' has no base",
+				 xdir_format_filename(&dir, signature, NONE));
+			rc = -1;
+			break;
+		}
+		signature = vclock_sum(&base_vclock);
+	}
+	if (spaces != NULL)
+		mh_i32ptr_delete(spaces);
+	xdir_destroy(&dir);
+	return rc;
+}
+
 static int
 memtx_engine_join(struct engine *engine, const struct vclock *vclock,
 		  struct xstream *stream)
@@ -929,6 +1840,7 @@ memtx_engine_memory_stat(struct engine *engine, struct engine_memory_stat *stat)
 	small_stats(&memtx->alloc, &data_stats, small_stats_noop_cb, NULL);
 	stat->data += data_stats.used;
 	stat->index += index_stats.totals.used;
+	stat->delayed_free += memtx->delayed_free_size;
 }
 
 static const struct engine_vtab memtx_engine_vtab = {
@@ -963,7 +1875,7 @@ static const struct engine_vtab memtx_engine_vtab = {
 static void
 memtx_engine_run_gc(struct memtx_engine *memtx, bool *stop)
 {
-	*stop = stailq_empty(&memtx->gc_queue);
+	*stop = stailq_empty(&memtx->gc_queue) || memtx->gc_pause > 0;
 	if (*stop)
 		return;
 
@@ -977,6 +1889,44 @@ memtx_engine_run_gc(struct memtx_engine *memtx, bool *stop)
 	}
 }
 
+void
+memtx_engine_enter_delayed_free_mode(struct memtx_engine *memtx)
+{
+	/*
+	 * Tuples allocated after this point are not seen by
+	 * the new view, so they may be freed right away, see
+	 * memtx_tuple_delete().
+	 */
+	memtx->snapshot_version++;
+	if (memtx->delayed_free_mode++ == 0)
+		small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, true);
+}
+
+void
+memtx_engine_leave_delayed_free_mode(struct memtx_engine *memtx)
+{
+	assert(memtx->delayed_free_mode > 0);
+	if (--memtx->delayed_free_mode == 0) {
+		small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
+		/* The allocator frees delayed tuples from now on. */
+		memtx->delayed_free_size = 0;
+	}
+}
+
+void
+memtx_engine_pause_gc(struct memtx_engine *memtx)
+{
+	memtx->gc_pause++;
+}
+
+void
+memtx_engine_resume_gc(struct memtx_engine *memtx)
+{
+	assert(memtx->gc_pause > 0);
+	if (--memtx->gc_pause == 0 && !stailq_empty(&memtx->gc_queue))
+		fiber_wakeup(memtx->gc_fiber);
+}
+
 static int
 memtx_engine_gc_f(va_list va)
 {
@@ -1005,8 +1955,8 @@ memtx_engine_gc_f(va_list va)
 
 struct memtx_engine *
 memtx_engine_new(const char *snap_dirname, bool force_recovery,
-		 uint64_t tuple_arena_max_size, uint32_t objsize_min,
-		 float alloc_factor)
+		 uint64_t tuple_arena_max_size, bool use_hugepages,
+		 uint32_t objsize_min, float alloc_factor)
 {
 	struct memtx_engine *memtx = calloc(1, sizeof(*memtx));
 	if (memtx == NULL) {
@@ -1017,6 +1967,7 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 
 	xdir_create(&memtx->snap_dir, snap_dirname, SNAP, &INSTANCE_UUID);
 	memtx->snap_dir.force_recovery = force_recovery;
+	rlist_create(&memtx->snap_deltas);
 
 	if (xdir_scan(&memtx->snap_dir) != 0)
 		goto fail;
@@ -1041,14 +1992,39 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 		xlog_cursor_close(&cursor, false);
 	}
 
-	/* Apprise the garbage collector of available checkpoints. */
+	/*
+	 * Apprise the garbage collector of available checkpoints
+	 * and find out which of them are delta snapshots.
+	 */
 	for (struct vclock *vclock = vclockset_first(&memtx->snap_dir.index);
 	     vclock != NULL;
 	     vclock = vclockset_next(&memtx->snap_dir.index, vclock)) {
 		gc_add_checkpoint(vclock);
+		struct xlog_cursor cursor;
+		if (xdir_open_cursor(&memtx->snap_dir, vclock_sum(vclock),
+				     &cursor) != 0) {
+			if (!force_recovery)
+				goto fail;
+			diag_log();
+			continue;
+		}
+		struct vclock prev_vclock;
+		vclock_copy(&prev_vclock, &cursor.meta.prev_vclock);
+		xlog_cursor_close(&cursor, false);
+		if (!vclock_is_set(&prev_vclock))
+			continue;
+		struct memtx_snap_delta *delta =
+			memtx_snap_delta_new(vclock_sum(vclock),
+					     vclock_sum(&prev_vclock));
+		if (delta == NULL)
+			goto fail;
+		rlist_add_tail_entry(&memtx->snap_deltas, delta,
+				     in_snap_deltas);
 	}
+	memtx->snap_needs_full = true;
 
 	stailq_create(&memtx->gc_queue);
+	rlist_create(&memtx->read_views);
 	memtx->gc_fiber = fiber_new("memtx.gc", memtx_engine_gc_f);
 	if (memtx->gc_fiber == NULL)
 		goto fail;
@@ -1060,7 +2036,8 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 	/* Initialize tuple allocator. */
 	quota_init(&memtx->quota, tuple_arena_max_size);
 	tuple_arena_create(&memtx->arena, &memtx->quota, tuple_arena_max_size,
-			   SLAB_SIZE, "memtx");
+			   SLAB_SIZE, use_hugepages, "memtx");
+	memtx->use_hugepages = use_hugepages;
 	slab_cache_create(&memtx->slab_cache, &memtx->arena);
 	small_alloc_create(&memtx->alloc, &memtx->slab_cache,
 			   objsize_min, alloc_factor);
@@ -1074,6 +2051,8 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 
 	memtx->state = MEMTX_INITIALIZED;
 	memtx->max_tuple_size = MAX_TUPLE_SIZE;
+	memtx->snap_threads = 1;
+	memtx->snap_delta_max = 0;
 	memtx->force_recovery = force_recovery;
 
 	memtx->base.vtab = &memtx_engine_vtab;
@@ -1082,6 +2061,7 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 	fiber_start(memtx->gc_fiber, memtx);
 	return memtx;
 fail:
+	memtx_snap_delta_delete_all(memtx);
 	xdir_destroy(&memtx->snap_dir);
 	free(memtx);
 	return NULL;
@@ -1095,12 +2075,45 @@ memtx_engine_schedule_gc(struct memtx_engine *memtx,
 	fiber_wakeup(memtx->gc_fiber);
 }
 
+void
+memtx_gc_unref_tuples(struct tuple **tuples, int count)
+{
+	for (int i = 0; i < count; i++)
+		__builtin_prefetch(tuples[i], 1);
+	for (int i = 0; i < count; i++)
+		tuple_unref(tuples[i]);
+}
+
 void
 memtx_engine_set_snap_io_rate_limit(struct memtx_engine *memtx, double limit)
 {
 	memtx->snap_io_rate_limit = limit * 1024 * 1024;
 }
 
+int
+memtx_engine_set_numa_policy(struct memtx_engine *memtx, const char *policy)
+{
+	if (numa_set_memory_policy(memtx->arena.arena, memtx->arena.prealloc,
+				   policy) != 0)
+		return -1;
+	say_info("memtx tuple arena NUMA memory policy is '%s'", policy);
+	return 0;
+}
+
+void
+memtx_engine_set_snap_threads(struct memtx_engine *memtx, int threads)
+{
+	assert(threads >= 1 && threads <= MEMTX_SNAP_THREADS_MAX);
+	memtx->snap_threads = threads;
+}
+
+void
+memtx_engine_set_snap_delta_max(struct memtx_engine *memtx, int delta_max)
+{
+	assert(delta_max >= 0);
+	memtx->snap_delta_max = delta_max;
+}
+
 int
 memtx_engine_set_memory(struct memtx_engine *memtx, size_t size)
 {
@@ -1119,12 +2132,14 @@ memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size)
 	memtx->max_tuple_size = max_size;
 }
 
-struct tuple *
-memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
+/**
+ * Allocate a tuple of format @a format with @a tuple_len bytes
+ * of data. The data and the field map are left uninitialized.
+ */
+static struct tuple *
+memtx_tuple_alloc(struct tuple_format *format, size_t tuple_len)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)format->engine;
-	assert(mp_typeof(*data) == MP_ARRAY);
-	size_t tuple_len = end - data;
 	size_t total = sizeof(struct memtx_tuple) + format->field_map_size +
 		tuple_len;
 
@@ -1152,6 +2167,7 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 	struct tuple *tuple = &memtx_tuple->base;
 	tuple->refs = 0;
 	memtx_tuple->version = memtx->snapshot_version;
+	memtx_tuple->is_packed = false;
 	assert(tuple_len <= UINT32_MAX); /* bsize is UINT32_MAX */
 	tuple->bsize = tuple_len;
 	tuple->format_id = tuple_format_id(format);
@@ -1162,41 +2178,377 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 	 * tuple is not the first field of the memtx_tuple.
 	 */
 	tuple->data_offset = sizeof(struct tuple) + format->field_map_size;
+	return tuple;
+}
+
+struct tuple *
+memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
+{
+	assert(mp_typeof(*data) == MP_ARRAY);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	if (unlikely(format->fixed_offsets != NULL)) {
+		data = tuple_format_encode_fixed_width(format, data, region);
+		if (data == NULL)
+			return NULL;
+		end = data + format->fixed_offsets[format->exact_field_count];
+	}
+	size_t tuple_len = end - data;
+	struct tuple *tuple = memtx_tuple_alloc(format, tuple_len);
+	if (tuple == NULL)
+		goto out;
 	char *raw = (char *) tuple + tuple->data_offset;
 	uint32_t *field_map = (uint32_t *) raw;
 	memcpy(raw, data, tuple_len);
 	if (tuple_init_field_map(format, field_map, raw, true)) {
 		memtx_tuple_delete(format, tuple);
-		return NULL;
+		tuple = NULL;
+		goto out;
 	}
-	say_debug("%s(%zu) = %p", __func__, tuple_len, memtx_tuple);
+	say_debug("%s(%zu) = %p", __func__, tuple_len, tuple);
+out:
+	region_truncate(region, region_svp);
 	return tuple;
 }
 
+/**
+ * Check the types of the fields of an updated tuple set in
+ * @a column_mask against the tuple format.
+ *
+ * @retval  0 Success.
+ * @retval  1 A changed field has indexed subfields, so the
+ *            tuple field map has to be rebuilt.
+ * @retval -1 Error.
+ */
+static int
+memtx_tuple_validate_changed(struct tuple_format *format, const char *data,
+			     uint64_t column_mask)
+{
+	uint32_t field_count = mp_decode_array(&data);
+	field_count = MIN(field_count, tuple_format_field_count(format));
+	for (uint32_t i = 0; i < field_count; i++, mp_next(&data)) {
+		uint64_t field_mask = 0;
+		column_mask_set_fieldno(&field_mask, i);
+		if (key_update_can_be_skipped(field_mask, column_mask))
+			continue;
+		struct tuple_field *field = tuple_format_field(format, i);
+		if (!json_token_is_leaf(&field->token))
+			return 1;
+		if (!field_mp_type_is_compatible(field->type, mp_typeof(*data),
+						tuple_field_is_nullable(field))) {
+			diag_set(ClientError, ER_FIELD_TYPE,
+				 tuple_field_path(field),
+				 field_type_strs[field->type]);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int
+memtx_tuple_update_in_place(struct tuple *old_tuple, const char *expr,
+			    const char *expr_end, int index_base,
+			    uint64_t *column_mask, struct tuple **result)
+{
+	*result = NULL;
+	if (memtx_tuple_is_packed(old_tuple))
+		return 0;
+	struct tuple_format *format = tuple_format(old_tuple);
+	struct tuple *tuple = memtx_tuple_alloc(format, old_tuple->bsize);
+	if (tuple == NULL)
+		return -1;
+	/* Copy the data along with the field map preceding it. */
+	memcpy((char *) tuple + sizeof(struct tuple),
+	       (char *) old_tuple + sizeof(struct tuple),
+	       format->field_map_size + old_tuple->bsize);
+	char *data = (char *) tuple + tuple->data_offset;
+	int rc = tuple_update_execute_in_place(region_aligned_alloc_cb,
+					       &fiber()->gc, expr, expr_end,
+					       data, index_base, column_mask);
+	if (rc == 0)
+		rc = memtx_tuple_validate_changed(format, data, *column_mask);
+	if (rc != 0) {
+		memtx_tuple_delete(format, tuple);
+		return rc > 0 ? 0 : -1;
+	}
+	say_debug("%s(%u) = %p", __func__, tuple->bsize, tuple);
+	*result = tuple;
+	return 0;
+}
+
+/**
+ * Return true if a tuple of the given format isn't seen by
+ * any read view, because the only one open is the checkpoint
+ * and it has already written the space the format belongs to.
+ */
+static inline bool
+memtx_tuple_is_released(struct memtx_engine *memtx,
+			struct tuple_format *format)
+{
+	if (memtx->checkpoint == NULL || memtx->delayed_free_mode != 1)
+		return false;
+	struct mh_i32ptr_t *released = memtx->checkpoint->released_formats;
+	return mh_i32ptr_find(released, format->id, NULL) != mh_end(released);
+}
+
 void
 memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)format->engine;
 	say_debug("%s(%p)", __func__, tuple);
 	assert(tuple->refs == 0);
-	size_t total = sizeof(struct memtx_tuple) + format->field_map_size +
-		tuple->bsize;
-	tuple_format_unref(format);
 	struct memtx_tuple *memtx_tuple =
 		container_of(tuple, struct memtx_tuple, base);
+	size_t total = sizeof(struct memtx_tuple) + format->field_map_size +
+		memtx_tuple_data_size(tuple);
 	if (memtx->alloc.free_mode != SMALL_DELAYED_FREE ||
 	    memtx_tuple->version == memtx->snapshot_version ||
-	    format->is_temporary)
+	    format->is_temporary ||
+	    memtx_tuple_is_released(memtx, format)) {
 		smfree(&memtx->alloc, memtx_tuple, total);
-	else
+	} else {
 		smfree_delayed(&memtx->alloc, memtx_tuple, total);
+		memtx->delayed_free_size += total;
+	}
+	tuple_format_unref(format);
 }
 
 struct tuple_format_vtab memtx_tuple_format_vtab = {
 	memtx_tuple_delete,
 	memtx_tuple_new,
+	NULL,
+};
+
+bool
+memtx_tuple_is_packed(const struct tuple *tuple)
+{
+	const struct memtx_tuple *memtx_tuple =
+		container_of(tuple, struct memtx_tuple, base);
+	return memtx_tuple->is_packed;
+}
+
+size_t
+memtx_tuple_data_size(const struct tuple *tuple)
+{
+	size_t size = tuple->bsize;
+	if (memtx_tuple_is_packed(tuple))
+		size += sizeof(struct memtx_tuple_tail) +
+			memtx_tuple_tail(tuple)->size;
+	return size;
+}
+
+/**
+ * Overwrite a MessagePack array header of @a size bytes with
+ * a header of the same size encoding @a count elements.
+ */
+static inline void
+memtx_tuple_store_array(char *data, uint32_t size, uint32_t count)
+{
+	switch (size) {
+	case 1:
+		assert(count <= 15);
+		mp_encode_array(data, count);
+		break;
+	case 3:
+		assert(count <= UINT16_MAX);
+		*data = 0xdc;
+		mp_store_u16(data + 1, count);
+		break;
+	case 5:
+		*data = 0xdd;
+		mp_store_u32(data + 1, count);
+		break;
+	default:
+		unreachable();
+	}
+}
+
+struct tuple *
+memtx_tuple_pack(struct tuple *tuple)
+{
+	assert(tuple->refs == 0);
+	struct tuple_format *format = tuple_format(tuple);
+	struct memtx_engine *memtx = (struct memtx_engine *)format->engine;
+	assert(format->vtab.tuple_unpack != NULL);
+	assert(!memtx_tuple_is_packed(tuple));
+
+	const char *data = tuple_data(tuple);
+	const char *pos = data;
+	uint32_t field_count = mp_decode_array(&pos);
+	uint32_t prefix_count = format->index_field_count;
+	if (field_count <= prefix_count)
+		return tuple;
+	uint32_t header_size = pos - data;
+	for (uint32_t i = 0; i < prefix_count; i++)
+		mp_next(&pos);
+	uint32_t prefix_size = pos - data;
+	uint32_t raw_size = tuple->bsize - prefix_size;
+
+	if (memtx->zcctx == NULL) {
+		memtx->zcctx = ZSTD_createCCtx();
+		if (memtx->zcctx == NULL)
+			return tuple;
+	}
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t bound = ZSTD_compressBound(raw_size);
+	char *buf = (char *)region_alloc(region, bound);
+	if (buf == NULL)
+		return tuple;
+	size_t zsize = ZSTD_compressCCtx(memtx->zcctx, buf, bound,
+					 pos, raw_size, 3);
+	if (ZSTD_isError(zsize) ||
+	    zsize + sizeof(struct memtx_tuple_tail) >= raw_size) {
+		region_truncate(region, region_svp);
+		return tuple;
+	}
+
+	size_t total = sizeof(struct memtx_tuple) + format->field_map_size +
+		prefix_size + sizeof(struct memtx_tuple_tail) + zsize;
+	struct memtx_tuple *memtx_tuple = smalloc(&memtx->alloc, total);
+	if (memtx_tuple == NULL) {
+		region_truncate(region, region_svp);
+		return tuple;
+	}
+	struct tuple *packed = &memtx_tuple->base;
+	packed->refs = 0;
+	memtx_tuple->version = memtx->snapshot_version;
+	memtx_tuple->is_packed = true;
+	packed->bsize = prefix_size;
+	packed->format_id = tuple->format_id;
+	tuple_format_ref(format);
+	packed->data_offset = tuple->data_offset;
+	/*
+	 * Offsets of indexed fields don't change, because
+	 * the array header keeps its size, so the field map
+	 * can be copied as is along with the fields.
+	 */
+	memcpy((char *)packed + sizeof(struct tuple),
+	       (char *)tuple + sizeof(struct tuple),
+	       format->field_map_size + prefix_size);
+	memtx_tuple_store_array((char *)packed + packed->data_offset,
+				header_size, prefix_count);
+	struct memtx_tuple_tail *tail = memtx_tuple_tail(packed);
+	tail->size = zsize;
+	tail->raw_size = raw_size;
+	tail->field_count = field_count - prefix_count;
+	memcpy(tail + 1, buf, zsize);
+	region_truncate(region, region_svp);
+	memtx_tuple_delete(format, tuple);
+	return packed;
+}
+
+/**
+ * Restore all fields of a packed tuple to @a data, which must
+ * have room for the tuple bsize plus the size of decompressed
+ * fields.
+ */
+static int
+memtx_tuple_unpack_data(struct tuple *tuple, ZSTD_DCtx *zdctx, char *data)
+{
+	struct memtx_tuple_tail *tail = memtx_tuple_tail(tuple);
+	const char *prefix = tuple_data(tuple);
+	const char *pos = prefix;
+	uint32_t prefix_count = mp_decode_array(&pos);
+	uint32_t header_size = pos - prefix;
+	memcpy(data, prefix, tuple->bsize);
+	memtx_tuple_store_array(data, header_size,
+				prefix_count + tail->field_count);
+	size_t size = ZSTD_decompressDCtx(zdctx, data + tuple->bsize,
+					  tail->raw_size, tail + 1,
+					  tail->size);
+	if (ZSTD_isError(size) || size != tail->raw_size) {
+		diag_set(ClientError, ER_INVALID_MSGPACK,
+			 "corrupted compressed tuple");
+		return -1;
+	}
+	return 0;
+}
+
+static struct tuple *
+memtx_tuple_unpack(struct tuple_format *format, struct tuple *tuple)
+{
+	if (!memtx_tuple_is_packed(tuple))
+		return tuple;
+	struct memtx_engine *memtx = (struct memtx_engine *)format->engine;
+	if (memtx->zdctx == NULL) {
+		memtx->zdctx = ZSTD_createDCtx();
+		if (memtx->zdctx == NULL) {
+			diag_set(OutOfMemory, 0, "ZSTD_createDCtx", "zdctx");
+			return NULL;
+		}
+	}
+	uint32_t bsize = tuple->bsize + memtx_tuple_tail(tuple)->raw_size;
+	size_t total = sizeof(struct memtx_tuple) + format->field_map_size +
+		bsize;
+	struct memtx_tuple *memtx_tuple;
+	while ((memtx_tuple = smalloc(&memtx->alloc, total)) == NULL) {
+		bool stop;
+		memtx_engine_run_gc(memtx, &stop);
+		if (stop)
+			break;
+	}
+	if (memtx_tuple == NULL) {
+		diag_set(OutOfMemory, total, "slab allocator", "memtx_tuple");
+		return NULL;
+	}
+	struct tuple *unpacked = &memtx_tuple->base;
+	unpacked->refs = 0;
+	memtx_tuple->version = memtx->snapshot_version;
+	memtx_tuple->is_packed = false;
+	unpacked->bsize = bsize;
+	unpacked->format_id = tuple->format_id;
+	tuple_format_ref(format);
+	unpacked->data_offset = tuple->data_offset;
+	memcpy((char *)unpacked + sizeof(struct tuple),
+	       (char *)tuple + sizeof(struct tuple), format->field_map_size);
+	if (memtx_tuple_unpack_data(tuple, memtx->zdctx,
+			(char *)unpacked + unpacked->data_offset) != 0) {
+		memtx_tuple_delete(format, unpacked);
+		return NULL;
+	}
+	tuple_bless(unpacked);
+	return unpacked;
+}
+
+struct tuple_format_vtab memtx_packed_tuple_format_vtab = {
+	memtx_tuple_delete,
+	memtx_tuple_new,
+	memtx_tuple_unpack,
 };
 
+void
+memtx_tuple_buf_destroy(struct memtx_tuple_buf *buf)
+{
+	free(buf->data);
+	ZSTD_freeDCtx(buf->zdctx);
+}
+
+const char *
+memtx_tuple_read(struct tuple *tuple, struct memtx_tuple_buf *buf,
+		 uint32_t *size)
+{
+	if (!memtx_tuple_is_packed(tuple))
+		return tuple_data_range(tuple, size);
+	if (buf->zdctx == NULL) {
+		buf->zdctx = ZSTD_createDCtx();
+		if (buf->zdctx == NULL)
+			panic("failed to allocate zstd context");
+	}
+	size_t bsize = tuple->bsize + memtx_tuple_tail(tuple)->raw_size;
+	if (bsize > buf->capacity) {
+		char *data = (char *)realloc(buf->data, bsize);
+		if (data == NULL)
+			panic("failed to allocate tuple buffer");
+		buf->data = data;
+		buf->capacity = bsize;
+	}
+	if (memtx_tuple_unpack_data(tuple, buf->zdctx, buf->data) != 0)
+		panic("failed to decompress tuple");
+	*size = bsize;
+	return buf->data;
+}
+
 /**
  * Allocate a block of size MEMTX_EXTENT_SIZE for memtx index
  */
@@ -1287,6 +2639,12 @@ memtx_index_def_change_requires_rebuild(struct index *index,
 		return true;
 	if (!old_def->opts.is_unique && new_def->opts.is_unique)
 		return true;
+	if (old_def->opts.func_id != new_def->opts.func_id)
+		return true;
+	if (old_def->opts.store_key != new_def->opts.store_key)
+		return true;
+	if (old_def->opts.hash_func != new_def->opts.hash_func)
+		return true;
 
 	const struct key_def *old_cmp_def, *new_cmp_def;
 	if (index_depends_on_pk(index)) {
@@ -49,6 +49,11 @@ struct index;
 struct fiber;
 struct tuple;
 struct tuple_format;
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+/** Max value of box.cfg.memtx_snap_threads. */
+enum { MEMTX_SNAP_THREADS_MAX = 64 };
 
 /**
  * The state of memtx recovery process.
@@ -97,6 +102,33 @@ struct memtx_engine {
 	struct xdir snap_dir;
 	/** Limit disk usage of checkpointing (bytes per second). */
 	uint64_t snap_io_rate_limit;
+	/**
+	 * Max number of threads writing a snapshot,
+	 * box.cfg.memtx_snap_threads.
+	 */
+	int snap_threads;
+	/**
+	 * Max number of delta snapshots written in a row,
+	 * box.cfg.memtx_snap_delta_max. A delta snapshot only
+	 * has tuples of spaces that changed since the previous
+	 * snapshot, its base, and refers to the base for the
+	 * rest. Zero means that all snapshots are written in
+	 * full.
+	 */
+	int snap_delta_max;
+	/**
+	 * Delta snapshots in snap_dir, linked by
+	 * memtx_snap_delta::in_snap_deltas.
+	 */
+	struct rlist snap_deltas;
+	/**
+	 * Set if the write generations of spaces saved at the
+	 * last snapshot can't be trusted, e.g. because the data
+	 * hasn't been recovered from a snapshot or the last
+	 * checkpoint failed. The next snapshot is written in
+	 * full then.
+	 */
+	bool snap_needs_full;
 	/** Skip invalid snapshot records if this flag is set. */
 	bool force_recovery;
 	/** Common quota for tuples and indexes. */
@@ -108,6 +140,8 @@ struct memtx_engine {
 	 * is reflected in box.slab.info(), @sa lua/slab.c.
 	 */
 	struct slab_arena arena;
+	/** Set if the arena was asked to use huge pages. */
+	bool use_hugepages;
 	/** Slab cache for allocating tuples. */
 	struct slab_cache slab_cache;
 	/** Tuple allocator. */
@@ -127,8 +161,25 @@ struct memtx_engine {
 	void *reserved_extents;
 	/** Maximal allowed tuple size, box.cfg.memtx_max_tuple_size. */
 	size_t max_tuple_size;
-	/** Incremented with each next snapshot. */
+	/**
+	 * Incremented whenever a checkpoint or a read view is
+	 * opened. Tuples allocated before that are freed in
+	 * the delayed mode while it is open.
+	 */
 	uint32_t snapshot_version;
+	/**
+	 * Number of open checkpoints and read views, which need
+	 * the delayed free mode of the tuple allocator.
+	 */
+	int delayed_free_mode;
+	/**
+	 * Size of tuples freed in the delayed mode since it was
+	 * entered, i.e. memory pinned by checkpoints and read
+	 * views.
+	 */
+	size_t delayed_free_size;
+	/** Open read views, linked by memtx_read_view::link. */
+	struct rlist read_views;
 	/** Memory pool for tree index iterator. */
 	struct mempool tree_iterator_pool;
 	/** Memory pool for rtree index iterator. */
@@ -147,6 +198,22 @@ struct memtx_engine {
 	 * memtx_gc_task::link.
 	 */
 	struct stailq gc_queue;
+	/**
+	 * Number of scans of frozen indexes running in other
+	 * threads. Garbage collection is paused while it is
+	 * positive so that the indexes aren't freed under them.
+	 */
+	int gc_pause;
+	/**
+	 * Incremented whenever a tuple is inserted into or
+	 * deleted from a space. Used to check if a transaction
+	 * that yielded may have read stale data.
+	 */
+	uint64_t write_gen;
+	/** Context for compressing tuples, created on demand. */
+	struct ZSTD_CCtx_s *zcctx;
+	/** Context for decompressing tuples, created on demand. */
+	struct ZSTD_DCtx_s *zdctx;
 };
 
 struct memtx_gc_task;
@@ -178,18 +245,91 @@ void
 memtx_engine_schedule_gc(struct memtx_engine *memtx,
 			 struct memtx_gc_task *task);
 
+enum {
+	/** Number of tuples unreferenced by a gc task at once. */
+	MEMTX_GC_BATCH = 16,
+};
+
+/**
+ * Unreference tuples of a dropped primary index. The tuples
+ * are scattered over the arena, so their headers are
+ * prefetched first to overlap cache misses of the batch
+ * instead of stalling on each tuple in turn.
+ */
+void
+memtx_gc_unref_tuples(struct tuple **tuples, int count);
+
+/**
+ * Make the tuple allocator keep tuples deleted from now on
+ * until memtx_engine_leave_delayed_free_mode() is called, so
+ * that frozen index views remain valid. May be nested.
+ */
+void
+memtx_engine_enter_delayed_free_mode(struct memtx_engine *memtx);
+
+/** @sa memtx_engine_enter_delayed_free_mode(). */
+void
+memtx_engine_leave_delayed_free_mode(struct memtx_engine *memtx);
+
+/**
+ * Don't free dropped indexes until memtx_engine_resume_gc()
+ * is called. May be nested.
+ */
+void
+memtx_engine_pause_gc(struct memtx_engine *memtx);
+
+/** @sa memtx_engine_pause_gc(). */
+void
+memtx_engine_resume_gc(struct memtx_engine *memtx);
+
 struct memtx_engine *
 memtx_engine_new(const char *snap_dirname, bool force_recovery,
-		 uint64_t tuple_arena_max_size,
+		 uint64_t tuple_arena_max_size, bool use_hugepages,
 		 uint32_t objsize_min, float alloc_factor);
 
 int
 memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 			      const struct vclock *vclock);
 
+/**
+ * Leave the primary-key-only phase of final recovery and
+ * build all secondary keys right away rather than at the end
+ * of recovery. Used by hot standby so that the standby keeps
+ * fully indexed data while following the WAL and promotion
+ * does not have to rebuild anything. No-op if the keys are
+ * already enabled.
+ */
+int
+memtx_engine_build_secondary_keys(struct memtx_engine *memtx);
+
 void
 memtx_engine_set_snap_io_rate_limit(struct memtx_engine *memtx, double limit);
 
+/**
+ * Set the NUMA memory policy of the tuple arena, see
+ * numa_set_memory_policy(). Must be called before the arena
+ * is populated.
+ */
+int
+memtx_engine_set_numa_policy(struct memtx_engine *memtx, const char *policy);
+
+/**
+ * Set the max number of threads writing a snapshot. User spaces
+ * are distributed among the threads by size, each thread
+ * compresses its own blocks and appends them to the snapshot
+ * file. Takes effect starting from the next checkpoint.
+ */
+void
+memtx_engine_set_snap_threads(struct memtx_engine *memtx, int threads);
+
+/**
+ * Set the max number of delta snapshots written in a row
+ * before a full one. Takes effect starting from the next
+ * checkpoint.
+ */
+void
+memtx_engine_set_snap_delta_max(struct memtx_engine *memtx, int delta_max);
+
 int
 memtx_engine_set_memory(struct memtx_engine *memtx, size_t size);
 
@@ -207,6 +347,87 @@ memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple);
 /** Tuple format vtab for memtx engine. */
 extern struct tuple_format_vtab memtx_tuple_format_vtab;
 
+/**
+ * Tuple format vtab for memtx spaces that compress tuples.
+ * Unlike memtx_tuple_format_vtab, it implements tuple_unpack.
+ */
+extern struct tuple_format_vtab memtx_packed_tuple_format_vtab;
+
+/**
+ * Compress fields of a new tuple that aren't covered by the
+ * indexes of its format. Indexed fields are left as is so that
+ * the tuple can be stored in the indexes, the rest are only
+ * decompressed by tuple_unpack().
+ *
+ * Return the compressed tuple and free the original one or
+ * return the original tuple if it has no fields to compress or
+ * compression doesn't save any memory. Never fails.
+ */
+struct tuple *
+memtx_tuple_pack(struct tuple *tuple);
+
+/** Return true if a tuple was compressed by memtx_tuple_pack(). */
+bool
+memtx_tuple_is_packed(const struct tuple *tuple);
+
+/**
+ * Apply UPDATE operations to a copy of @a old_tuple if they
+ * don't change the size of the tuple fields, see
+ * tuple_update_execute_in_place(). The field map of the old
+ * tuple is reused and only the changed fields are validated.
+ *
+ * Return 0 and set @a result to NULL if the update can't be
+ * done in place, -1 on error. On success @a column_mask is set
+ * to the mask of the changed fields.
+ */
+int
+memtx_tuple_update_in_place(struct tuple *old_tuple, const char *expr,
+			    const char *expr_end, int index_base,
+			    uint64_t *column_mask, struct tuple **result);
+
+/**
+ * Return the amount of memory taken by tuple data, which is
+ * less than the tuple bsize if the tuple is compressed.
+ */
+size_t
+memtx_tuple_data_size(const struct tuple *tuple);
+
+/**
+ * Buffer for reading tuple data outside the tx thread,
+ * see memtx_tuple_read().
+ */
+struct memtx_tuple_buf {
+	/** Decompressed tuple data. */
+	char *data;
+	/** Size of @data. */
+	size_t capacity;
+	/** Decompression context, created on demand. */
+	struct ZSTD_DCtx_s *zdctx;
+};
+
+static inline void
+memtx_tuple_buf_create(struct memtx_tuple_buf *buf)
+{
+	buf->data = NULL;
+	buf->capacity = 0;
+	buf->zdctx = NULL;
+}
+
+void
+memtx_tuple_buf_destroy(struct memtx_tuple_buf *buf);
+
+/**
+ * Return MessagePack data of a tuple and store its size in
+ * @a size. Unlike tuple_data_range(), returns all fields of
+ * a compressed tuple, which are decompressed to @a buf so
+ * the result is valid until the buffer is reused. Doesn't
+ * access the tuple format and so may be called from any
+ * thread for a tuple of a frozen index.
+ */
+const char *
+memtx_tuple_read(struct tuple *tuple, struct memtx_tuple_buf *buf,
+		 uint32_t *size);
+
 enum {
 	MEMTX_EXTENT_SIZE = 16 * 1024,
 	MEMTX_SLAB_SIZE = 4 * 1024 * 1024
@@ -248,12 +469,12 @@ memtx_index_def_change_requires_rebuild(struct index *index,
 
 static inline struct memtx_engine *
 memtx_engine_new_xc(const char *snap_dirname, bool force_recovery,
-		    uint64_t tuple_arena_max_size,
+		    uint64_t tuple_arena_max_size, bool use_hugepages,
 		    uint32_t objsize_min, float alloc_factor)
 {
 	struct memtx_engine *memtx;
 	memtx = memtx_engine_new(snap_dirname, force_recovery,
-				 tuple_arena_max_size,
+				 tuple_arena_max_size, use_hugepages,
 				 objsize_min, alloc_factor);
 	if (memtx == NULL)
 		diag_raise();
@@ -275,6 +496,13 @@ memtx_engine_recover_snapshot_xc(struct memtx_engine *memtx,
 		diag_raise();
 }
 
+static inline void
+memtx_engine_build_secondary_keys_xc(struct memtx_engine *memtx)
+{
+	if (memtx_engine_build_secondary_keys(memtx) != 0)
+		diag_raise();
+}
+
 #endif /* defined(__plusplus) */
 
 #endif /* TARANTOOL_BOX_MEMTX_ENGINE_H_INCLUDED */
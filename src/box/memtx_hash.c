@@ -34,6 +34,7 @@
 #include "tuple.h"
 #include "tuple_hash.h"
 #include "memtx_engine.h"
+#include "memtx_read_view.h"
 #include "space.h"
 #include "schema.h" /* space_cache_find() */
 #include "errinj.h"
@@ -127,16 +128,21 @@ memtx_hash_index_gc_run(struct memtx_gc_task *task, bool *done)
 	struct light_index_core *hash = &index->hash_table;
 	struct light_index_iterator *itr = &index->gc_iterator;
 
+	struct tuple *batch[MEMTX_GC_BATCH];
 	struct tuple **res;
 	unsigned int loops = 0;
-	while ((res = light_index_iterator_get_and_next(hash, itr)) != NULL) {
-		tuple_unref(*res);
-		if (++loops >= YIELD_LOOPS) {
-			*done = false;
-			return;
-		}
-	}
-	*done = true;
+	do {
+		int count = 0;
+		while (count < MEMTX_GC_BATCH &&
+		       (res = light_index_iterator_get_and_next(hash,
+								itr)) != NULL)
+			batch[count++] = *res;
+		if (count == 0)
+			break;
+		memtx_gc_unref_tuples(batch, count);
+		loops += count;
+	} while (loops < YIELD_LOOPS);
+	*done = res == NULL;
 }
 
 static void
@@ -157,6 +163,7 @@ memtx_hash_index_destroy(struct index *base)
 {
 	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
 	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+	memtx_read_view_forget_index(memtx, base);
 	if (base->def->iid == 0) {
 		/*
 		 * Primary index. We need to free all tuples stored
@@ -198,6 +205,14 @@ memtx_hash_index_bsize(struct index *base)
 					MEMTX_EXTENT_SIZE;
 }
 
+static int
+memtx_hash_index_reserve(struct index *base, uint32_t size_hint)
+{
+	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
+	/* The extent allocator sets diag on failure. */
+	return light_index_reserve(&index->hash_table, size_hint);
+}
+
 static int
 memtx_hash_index_random(struct index *base, uint32_t rnd, struct tuple **result)
 {
@@ -303,6 +318,24 @@ memtx_hash_index_replace(struct index *base, struct tuple *old_tuple,
 	return 0;
 }
 
+static int
+memtx_hash_index_replace_in_place(struct index *base, struct tuple *old_tuple,
+				  struct tuple *new_tuple)
+{
+	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
+	struct light_index_core *hash_table = &index->hash_table;
+	uint32_t h = tuple_hash(new_tuple, base->def->key_def);
+	struct tuple *replaced = NULL;
+	uint32_t pos = light_index_replace(hash_table, h, new_tuple, &replaced);
+	if (pos == light_index_end) {
+		diag_set(OutOfMemory, (ssize_t)hash_table->count,
+			 "hash_table", "key");
+		return -1;
+	}
+	assert(replaced == old_tuple); (void) old_tuple;
+	return 0;
+}
+
 static struct iterator *
 memtx_hash_index_create_iterator(struct index *base, enum iterator_type type,
 				 const char *key, uint32_t part_count)
@@ -358,6 +391,8 @@ struct hash_snapshot_iterator {
 	struct snapshot_iterator base;
 	struct light_index_core *hash_table;
 	struct light_index_iterator iterator;
+	/** Buffer for decompressed tuples. */
+	struct memtx_tuple_buf buf;
 };
 
 /**
@@ -372,6 +407,7 @@ hash_snapshot_iterator_free(struct snapshot_iterator *iterator)
 	struct hash_snapshot_iterator *it =
 		(struct hash_snapshot_iterator *) iterator;
 	light_index_iterator_destroy(it->hash_table, &it->iterator);
+	memtx_tuple_buf_destroy(&it->buf);
 	free(iterator);
 }
 
@@ -390,7 +426,7 @@ hash_snapshot_iterator_next(struct snapshot_iterator *iterator, uint32_t *size)
 							       &it->iterator);
 	if (res == NULL)
 		return NULL;
-	return tuple_data_range(*res, size);
+	return memtx_tuple_read(*res, &it->buf, size);
 }
 
 /**
@@ -415,6 +451,7 @@ memtx_hash_index_create_snapshot_iterator(struct index *base)
 	it->hash_table = &index->hash_table;
 	light_index_iterator_begin(it->hash_table, &it->iterator);
 	light_index_iterator_freeze(it->hash_table, &it->iterator);
+	memtx_tuple_buf_create(&it->buf);
 	return (struct snapshot_iterator *) it;
 }
 
@@ -434,16 +471,23 @@ static const struct index_vtab memtx_hash_index_vtab = {
 	/* .max = */ generic_index_max,
 	/* .random = */ memtx_hash_index_random,
 	/* .count = */ memtx_hash_index_count,
+	/* .estimate_count = */ generic_index_estimate_count,
 	/* .get = */ memtx_hash_index_get,
+	/* .get_batch = */ generic_index_get_batch,
 	/* .replace = */ memtx_hash_index_replace,
+	/* .replace_in_place = */ memtx_hash_index_replace_in_place,
 	/* .create_iterator = */ memtx_hash_index_create_iterator,
+	/* .create_covering_iterator = */
+		generic_index_create_covering_iterator,
+	/* .create_filtered_iterator = */
+		generic_index_create_filtered_iterator,
 	/* .create_snapshot_iterator = */
 		memtx_hash_index_create_snapshot_iterator,
 	/* .stat = */ generic_index_stat,
 	/* .compact = */ generic_index_compact,
 	/* .reset_stat = */ generic_index_reset_stat,
 	/* .begin_build = */ generic_index_begin_build,
-	/* .reserve = */ generic_index_reserve,
+	/* .reserve = */ memtx_hash_index_reserve,
 	/* .build_next = */ generic_index_build_next,
 	/* .end_build = */ generic_index_end_build,
 };
@@ -472,6 +516,12 @@ memtx_hash_index_new(struct memtx_engine *memtx, struct index_def *def)
 	light_index_create(&index->hash_table, MEMTX_EXTENT_SIZE,
 			   memtx_index_extent_alloc, memtx_index_extent_free,
 			   memtx, index->base.def->key_def);
+	if (light_index_reserve(&index->hash_table, def->opts.size_hint) != 0) {
+		light_index_destroy(&index->hash_table);
+		index_def_delete(index->base.def);
+		free(index);
+		return NULL;
+	}
 	return index;
 }
 
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "memtx_read_view.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "diag.h"
+#include "trivia/util.h"
+#include "error.h"
+#include "index.h"
+#include "space.h"
+#include "schema.h"
+#include "memtx_engine.h"
+#include "memtx_tree.h"
+
+static void
+memtx_read_view_destroy_entries(struct memtx_read_view *rv)
+{
+	struct memtx_read_view_entry *entry, *next;
+	rlist_foreach_entry_safe(entry, &rv->entries, link, next) {
+		if (entry->iterator != NULL)
+			entry->iterator->free(entry->iterator);
+		free(entry);
+	}
+	rlist_create(&rv->entries);
+}
+
+static int
+memtx_read_view_add_space(struct space *space, void *data)
+{
+	struct memtx_read_view *rv = (struct memtx_read_view *)data;
+	if (space_is_temporary(space) || !space_is_memtx(space))
+		return 0;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct index *index = space->index[i];
+		if (index->def->type != TREE && index->def->type != HASH)
+			continue;
+		struct memtx_read_view_entry *entry = malloc(sizeof(*entry));
+		if (entry == NULL) {
+			diag_set(OutOfMemory, sizeof(*entry),
+				 "malloc", "struct memtx_read_view_entry");
+			return -1;
+		}
+		entry->space_id = space_id(space);
+		entry->index_id = index->def->iid;
+		entry->index = index;
+		entry->is_scanned = false;
+		entry->iterator = index_create_snapshot_iterator(index);
+		if (entry->iterator == NULL) {
+			free(entry);
+			return -1;
+		}
+		rlist_add_tail_entry(&rv->entries, entry, link);
+	}
+	return 0;
+}
+
+struct memtx_read_view *
+memtx_read_view_new(struct memtx_engine *memtx)
+{
+	struct memtx_read_view *rv = malloc(sizeof(*rv));
+	if (rv == NULL) {
+		diag_set(OutOfMemory, sizeof(*rv),
+			 "malloc", "struct memtx_read_view");
+		return NULL;
+	}
+	rv->memtx = memtx;
+	rlist_create(&rv->entries);
+	if (space_foreach(memtx_read_view_add_space, rv) != 0) {
+		memtx_read_view_destroy_entries(rv);
+		free(rv);
+		return NULL;
+	}
+	/*
+	 * Frozen indexes reference tuples that may be deleted
+	 * from the space after this point, so keep the memory.
+	 */
+	memtx_engine_enter_delayed_free_mode(memtx);
+	rlist_add_tail_entry(&memtx->read_views, rv, link);
+	return rv;
+}
+
+struct memtx_read_view *
+memtx_read_view_new_range(struct memtx_engine *memtx, struct index *index,
+			  const char *begin, uint32_t begin_parts,
+			  const char *end, uint32_t end_parts)
+{
+	struct key_def *key_def = index->def->key_def;
+	if (index->def->type != TREE || key_def->is_multikey ||
+	    key_def->func_part_count > 0) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Read view",
+			 "key ranges of indexes other than plain tree");
+		return NULL;
+	}
+	struct memtx_read_view *rv = malloc(sizeof(*rv));
+	if (rv == NULL) {
+		diag_set(OutOfMemory, sizeof(*rv),
+			 "malloc", "struct memtx_read_view");
+		return NULL;
+	}
+	struct memtx_read_view_entry *entry = malloc(sizeof(*entry));
+	if (entry == NULL) {
+		diag_set(OutOfMemory, sizeof(*entry),
+			 "malloc", "struct memtx_read_view_entry");
+		free(rv);
+		return NULL;
+	}
+	entry->space_id = index->def->space_id;
+	entry->index_id = index->def->iid;
+	entry->index = index;
+	entry->is_scanned = false;
+	entry->iterator = memtx_tree_index_create_range_iterator(
+		index, begin, begin_parts, end, end_parts);
+	if (entry->iterator == NULL) {
+		free(entry);
+		free(rv);
+		return NULL;
+	}
+	rv->memtx = memtx;
+	rlist_create(&rv->entries);
+	rlist_add_tail_entry(&rv->entries, entry, link);
+	memtx_engine_enter_delayed_free_mode(memtx);
+	rlist_add_tail_entry(&memtx->read_views, rv, link);
+	return rv;
+}
+
+void
+memtx_read_view_delete(struct memtx_read_view *rv)
+{
+	memtx_read_view_destroy_entries(rv);
+	rlist_del_entry(rv, link);
+	memtx_engine_leave_delayed_free_mode(rv->memtx);
+	free(rv);
+}
+
+struct memtx_read_view_entry *
+memtx_read_view_scan(struct memtx_read_view *rv,
+		     uint32_t space_id, uint32_t index_id)
+{
+	bool space_found = false;
+	struct memtx_read_view_entry *entry;
+	rlist_foreach_entry(entry, &rv->entries, link) {
+		if (entry->space_id != space_id)
+			continue;
+		space_found = true;
+		if (entry->index_id != index_id)
+			continue;
+		if (entry->iterator == NULL)
+			break;
+		if (entry->is_scanned) {
+			diag_set(ClientError, ER_UNSUPPORTED, "Read view",
+				 "scanning the same index twice");
+			return NULL;
+		}
+		entry->is_scanned = true;
+		return entry;
+	}
+	if (space_found)
+		diag_set(ClientError, ER_NO_SUCH_INDEX, index_id,
+			 int2str(space_id));
+	else
+		diag_set(ClientError, ER_NO_SUCH_SPACE, int2str(space_id));
+	return NULL;
+}
+
+const char *
+memtx_read_view_entry_next(struct memtx_read_view_entry *entry,
+			   uint32_t *size)
+{
+	assert(entry->is_scanned);
+	if (entry->iterator == NULL) {
+		diag_set(ClientError, ER_NO_SUCH_INDEX, entry->index_id,
+			 int2str(entry->space_id));
+		return NULL;
+	}
+	return entry->iterator->next(entry->iterator, size);
+}
+
+void
+memtx_read_view_forget_index(struct memtx_engine *memtx,
+			     struct index *index)
+{
+	struct memtx_read_view *rv;
+	rlist_foreach_entry(rv, &memtx->read_views, link) {
+		struct memtx_read_view_entry *entry;
+		rlist_foreach_entry(entry, &rv->entries, link) {
+			if (entry->index != index || entry->iterator == NULL)
+				continue;
+			entry->iterator->free(entry->iterator);
+			entry->iterator = NULL;
+		}
+	}
+}
@@ -0,0 +1,138 @@
+#ifndef TARANTOOL_BOX_MEMTX_READ_VIEW_H_INCLUDED
+#define TARANTOOL_BOX_MEMTX_READ_VIEW_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <small/rlist.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct index;
+struct memtx_engine;
+struct snapshot_iterator;
+
+/** Frozen state of one index in a read view. */
+struct memtx_read_view_entry {
+	/** Link in memtx_read_view::entries. */
+	struct rlist link;
+	/** Space id. */
+	uint32_t space_id;
+	/** Index id. */
+	uint32_t index_id;
+	/** The index the view was taken from. */
+	struct index *index;
+	/**
+	 * Iterator over the frozen index or NULL if the index
+	 * was dropped while the view was open.
+	 */
+	struct snapshot_iterator *iterator;
+	/** Set once a scan of the index has been started. */
+	bool is_scanned;
+};
+
+/**
+ * A consistent view of all memtx tree and hash indexes taken
+ * at a point in time. Changes committed after the view was
+ * opened are not visible through it, which makes it suitable
+ * for long scans that yield. Tuples deleted while a read view
+ * is open are kept in memory until it is closed.
+ *
+ * Each index of a view can be scanned only once.
+ */
+struct memtx_read_view {
+	/** Engine the view was taken from. */
+	struct memtx_engine *memtx;
+	/** Link in memtx_engine::read_views. */
+	struct rlist link;
+	/** List of memtx_read_view_entry objects. */
+	struct rlist entries;
+};
+
+/**
+ * Open a read view of all memtx spaces except temporary ones.
+ * Returns NULL and sets diag on error.
+ */
+struct memtx_read_view *
+memtx_read_view_new(struct memtx_engine *memtx);
+
+/**
+ * Open a read view of the tuples of a single memtx tree index
+ * with keys in [begin, end), see
+ * memtx_tree_index_create_range_iterator(). Unlike a full read
+ * view, it doesn't walk the whole schema, so it is cheap enough
+ * to take per range, e.g. to move a shard to another instance.
+ * Keys must be validated by the caller.
+ *
+ * Returns NULL and sets diag on error.
+ */
+struct memtx_read_view *
+memtx_read_view_new_range(struct memtx_engine *memtx, struct index *index,
+			  const char *begin, uint32_t begin_parts,
+			  const char *end, uint32_t end_parts);
+
+/** Close a read view and release the memory pinned by it. */
+void
+memtx_read_view_delete(struct memtx_read_view *rv);
+
+/**
+ * Start a scan of an index in a read view. Returns NULL and
+ * sets diag if the index is not in the view, has been dropped
+ * or has already been scanned.
+ */
+struct memtx_read_view_entry *
+memtx_read_view_scan(struct memtx_read_view *rv,
+		     uint32_t space_id, uint32_t index_id);
+
+/**
+ * Return the next tuple of a read view index or NULL on EOF.
+ * Sets diag and returns NULL if the index was dropped, so
+ * check diag_is_empty() on NULL.
+ */
+const char *
+memtx_read_view_entry_next(struct memtx_read_view_entry *entry,
+			   uint32_t *size);
+
+/**
+ * Called before a memtx index is destroyed to detach it from
+ * all open read views.
+ */
+void
+memtx_read_view_forget_index(struct memtx_engine *memtx,
+			     struct index *index);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_MEMTX_READ_VIEW_H_INCLUDED */
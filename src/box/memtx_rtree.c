@@ -152,6 +152,7 @@ memtx_rtree_index_destroy(struct index *base)
 {
 	struct memtx_rtree_index *index = (struct memtx_rtree_index *)base;
 	rtree_destroy(&index->tree);
+	free(index->build_array);
 	free(index);
 }
 
@@ -299,6 +300,72 @@ memtx_rtree_index_create_iterator(struct index *base,  enum iterator_type type,
 	return (struct iterator *)it;
 }
 
+static void
+memtx_rtree_index_begin_build(struct index *base)
+{
+	struct memtx_rtree_index *index = (struct memtx_rtree_index *)base;
+	assert(rtree_number_of_records(&index->tree) == 0);
+	(void)index;
+}
+
+static int
+memtx_rtree_index_reserve(struct index *base, uint32_t size_hint)
+{
+	struct memtx_rtree_index *index = (struct memtx_rtree_index *)base;
+	if (size_hint < index->build_array_alloc_size)
+		return 0;
+	size_t size = size_hint * rtree_bulk_item_size(&index->tree);
+	void *tmp = realloc(index->build_array, size);
+	if (tmp == NULL) {
+		diag_set(OutOfMemory, size, "memtx_rtree_index", "reserve");
+		return -1;
+	}
+	index->build_array = tmp;
+	index->build_array_alloc_size = size_hint;
+	return 0;
+}
+
+static int
+memtx_rtree_index_build_next(struct index *base, struct tuple *tuple)
+{
+	struct memtx_rtree_index *index = (struct memtx_rtree_index *)base;
+	struct rtree_rect rect;
+	if (extract_rectangle(&rect, tuple, base->def) != 0)
+		return -1;
+	if (index->build_array_size == index->build_array_alloc_size) {
+		size_t alloc_size = index->build_array_alloc_size +
+				    index->build_array_alloc_size / 2;
+		if (alloc_size < MEMTX_EXTENT_SIZE /
+				 rtree_bulk_item_size(&index->tree))
+			alloc_size = MEMTX_EXTENT_SIZE /
+				     rtree_bulk_item_size(&index->tree);
+		size_t size = alloc_size * rtree_bulk_item_size(&index->tree);
+		void *tmp = realloc(index->build_array, size);
+		if (tmp == NULL) {
+			diag_set(OutOfMemory, size, "memtx_rtree_index",
+				 "build_next");
+			return -1;
+		}
+		index->build_array = tmp;
+		index->build_array_alloc_size = alloc_size;
+	}
+	rtree_bulk_item_set(&index->tree, index->build_array,
+			    index->build_array_size++, &rect, tuple);
+	return 0;
+}
+
+static void
+memtx_rtree_index_end_build(struct index *base)
+{
+	struct memtx_rtree_index *index = (struct memtx_rtree_index *)base;
+	rtree_bulk_load(&index->tree, index->build_array,
+			index->build_array_size);
+	free(index->build_array);
+	index->build_array = NULL;
+	index->build_array_size = 0;
+	index->build_array_alloc_size = 0;
+}
+
 static const struct index_vtab memtx_rtree_index_vtab = {
 	/* .destroy = */ memtx_rtree_index_destroy,
 	/* .commit_create = */ generic_index_commit_create,
@@ -315,18 +382,25 @@ static const struct index_vtab memtx_rtree_index_vtab = {
 	/* .max = */ generic_index_max,
 	/* .random = */ generic_index_random,
 	/* .count = */ memtx_rtree_index_count,
+	/* .estimate_count = */ generic_index_estimate_count,
 	/* .get = */ memtx_rtree_index_get,
+	/* .get_batch = */ generic_index_get_batch,
 	/* .replace = */ memtx_rtree_index_replace,
+	/* .replace_in_place = */ generic_index_replace_in_place,
 	/* .create_iterator = */ memtx_rtree_index_create_iterator,
+	/* .create_covering_iterator = */
+		generic_index_create_covering_iterator,
+	/* .create_filtered_iterator = */
+		generic_index_create_filtered_iterator,
 	/* .create_snapshot_iterator = */
 		generic_index_create_snapshot_iterator,
 	/* .stat = */ generic_index_stat,
 	/* .compact = */ generic_index_compact,
 	/* .reset_stat = */ generic_index_reset_stat,
-	/* .begin_build = */ generic_index_begin_build,
-	/* .reserve = */ generic_index_reserve,
-	/* .build_next = */ generic_index_build_next,
-	/* .end_build = */ generic_index_end_build,
+	/* .begin_build = */ memtx_rtree_index_begin_build,
+	/* .reserve = */ memtx_rtree_index_reserve,
+	/* .build_next = */ memtx_rtree_index_build_next,
+	/* .end_build = */ memtx_rtree_index_end_build,
 };
 
 struct memtx_rtree_index *
@@ -47,6 +47,9 @@ struct memtx_rtree_index {
 	struct index base;
 	unsigned dimension;
 	struct rtree tree;
+	/** Records collected by build_next for rtree_bulk_load(). */
+	void *build_array;
+	size_t build_array_size, build_array_alloc_size;
 };
 
 struct memtx_rtree_index *
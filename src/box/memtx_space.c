@@ -42,6 +42,8 @@
 #include "memtx_engine.h"
 #include "column_mask.h"
 #include "sequence.h"
+#include "func.h"
+#include "schema.h"
 
 static void
 memtx_space_destroy(struct space *space)
@@ -64,10 +66,35 @@ memtx_space_update_bsize(struct space *space,
 			 const struct tuple *new_tuple)
 {
 	struct memtx_space *memtx_space = (struct memtx_space *)space;
-	ssize_t old_bsize = old_tuple ? box_tuple_bsize(old_tuple) : 0;
-	ssize_t new_bsize = new_tuple ? box_tuple_bsize(new_tuple) : 0;
+	ssize_t old_bsize = old_tuple ? memtx_tuple_data_size(old_tuple) : 0;
+	ssize_t new_bsize = new_tuple ? memtx_tuple_data_size(new_tuple) : 0;
 	assert((ssize_t)memtx_space->bsize + new_bsize - old_bsize >= 0);
 	memtx_space->bsize += new_bsize - old_bsize;
+	memtx_space->write_gen++;
+	((struct memtx_engine *)space->engine)->write_gen++;
+}
+
+/**
+ * Check that replacing @a old_tuple with @a new_tuple doesn't
+ * make the space exceed its memory quota. Changes which don't
+ * grow the space are always allowed, so that an over-quota
+ * space (e.g. after the quota was lowered) can be cleaned up.
+ */
+static inline int
+memtx_space_check_quota(struct space *space, const struct tuple *old_tuple,
+			const struct tuple *new_tuple)
+{
+	int64_t quota = space->def->opts.memory_quota;
+	if (quota == 0 || new_tuple == NULL)
+		return 0;
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	ssize_t old_bsize = old_tuple ? memtx_tuple_data_size(old_tuple) : 0;
+	ssize_t new_bsize = memtx_tuple_data_size(new_tuple);
+	if (new_bsize <= old_bsize ||
+	    (int64_t)(memtx_space->bsize + new_bsize - old_bsize) <= quota)
+		return 0;
+	diag_set(ClientError, ER_SPACE_QUOTA, space_name(space));
+	return -1;
 }
 
 /**
@@ -234,12 +261,15 @@ memtx_space_replace_primary_key(struct space *space, struct tuple *old_tuple,
  * old_tuple is given, dup_replace_mode is ignored.
  * Otherwise, it's taken into account only for the
  * primary key.
+ *
+ * When UPDATE changes only the fields set in @a column_mask,
+ * the secondary keys that don't depend on these fields are
+ * replaced in place, see index_vtab::replace_in_place.
  */
-int
-memtx_space_replace_all_keys(struct space *space, struct tuple *old_tuple,
-			     struct tuple *new_tuple,
-			     enum dup_replace_mode mode,
-			     struct tuple **result)
+static int
+memtx_space_replace_masked(struct space *space, struct tuple *old_tuple,
+			   struct tuple *new_tuple, enum dup_replace_mode mode,
+			   uint64_t column_mask, struct tuple **result)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)space->engine;
 	/*
@@ -270,10 +300,25 @@ memtx_space_replace_all_keys(struct space *space, struct tuple *old_tuple,
 	for (i++; i < space->index_count; i++) {
 		struct tuple *unused;
 		struct index *index = space->index[i];
+		if (old_tuple != NULL && new_tuple != NULL &&
+		    index->def->opts.func_id == 0 &&
+		    key_update_can_be_skipped(index->def->key_def->column_mask,
+					      column_mask)) {
+			if (index_replace_in_place(index, old_tuple,
+						   new_tuple) != 0)
+				goto rollback;
+			continue;
+		}
 		if (index_replace(index, old_tuple, new_tuple,
 				  DUP_INSERT, &unused) != 0)
 			goto rollback;
 	}
+	/*
+	 * The size of the replaced tuple is only known once
+	 * the primary key has been updated.
+	 */
+	if (memtx_space_check_quota(space, old_tuple, new_tuple) != 0)
+		goto rollback;
 
 	memtx_space_update_bsize(space, old_tuple, new_tuple);
 	if (new_tuple != NULL)
@@ -296,12 +341,50 @@ rollback:
 	return -1;
 }
 
+int
+memtx_space_replace_all_keys(struct space *space, struct tuple *old_tuple,
+			     struct tuple *new_tuple,
+			     enum dup_replace_mode mode,
+			     struct tuple **result)
+{
+	return memtx_space_replace_masked(space, old_tuple, new_tuple, mode,
+					  COLUMN_MASK_FULL, result);
+}
+
 static inline enum dup_replace_mode
 dup_replace_mode(uint32_t op)
 {
 	return op == IPROTO_INSERT ? DUP_INSERT : DUP_REPLACE_OR_INSERT;
 }
 
+/**
+ * Allocate a tuple for a memtx space. If the tuple is big
+ * enough, compress the fields that aren't indexed, see the
+ * compression_threshold space option.
+ */
+static inline struct tuple *
+memtx_space_tuple_new(struct space *space, const char *data, const char *end)
+{
+	struct tuple *tuple = memtx_tuple_new(space->format, data, end);
+	int64_t threshold = space->def->opts.compression_threshold;
+	if (tuple != NULL && threshold > 0 && tuple->bsize >= threshold)
+		tuple = memtx_tuple_pack(tuple);
+	return tuple;
+}
+
+/**
+ * Return data of an old tuple to be changed by an UPDATE or
+ * UPSERT, with compressed fields restored.
+ */
+static inline const char *
+memtx_space_old_data(struct tuple *old_tuple, uint32_t *bsize)
+{
+	struct tuple *tuple = tuple_unpack(old_tuple);
+	if (tuple == NULL)
+		return NULL;
+	return tuple_data_range(tuple, bsize);
+}
+
 static int
 memtx_space_apply_initial_join_row(struct space *space, struct request *request)
 {
@@ -315,8 +398,8 @@ memtx_space_apply_initial_join_row(struct space *space, struct request *request)
 	if (txn == NULL)
 		return -1;
 	struct txn_stmt *stmt = txn_current_stmt(txn);
-	stmt->new_tuple = memtx_tuple_new(space->format, request->tuple,
-					  request->tuple_end);
+	stmt->new_tuple = memtx_space_tuple_new(space, request->tuple,
+						request->tuple_end);
 	if (stmt->new_tuple == NULL)
 		goto rollback;
 	tuple_ref(stmt->new_tuple);
@@ -338,8 +421,8 @@ memtx_space_execute_replace(struct space *space, struct txn *txn,
 	struct memtx_space *memtx_space = (struct memtx_space *)space;
 	struct txn_stmt *stmt = txn_current_stmt(txn);
 	enum dup_replace_mode mode = dup_replace_mode(request->type);
-	stmt->new_tuple = memtx_tuple_new(space->format, request->tuple,
-					  request->tuple_end);
+	stmt->new_tuple = memtx_space_tuple_new(space, request->tuple,
+						request->tuple_end);
 	if (stmt->new_tuple == NULL)
 		return -1;
 	tuple_ref(stmt->new_tuple);
@@ -378,6 +461,29 @@ memtx_space_execute_delete(struct space *space, struct txn *txn,
 	return 0;
 }
 
+/**
+ * Try to apply an UPDATE without rebuilding the old tuple, see
+ * memtx_tuple_update_in_place(). The tuple must be of the
+ * current space format, since the update result is validated
+ * against the old tuple format, and must not need compression.
+ * Set @a result to NULL if the update can't be done in place.
+ */
+static inline int
+memtx_space_update_in_place(struct space *space, struct tuple *old_tuple,
+			    struct request *request, uint64_t *column_mask,
+			    struct tuple **result)
+{
+	*result = NULL;
+	int64_t threshold = space->def->opts.compression_threshold;
+	if (tuple_format(old_tuple) != space->format ||
+	    (threshold > 0 && old_tuple->bsize >= threshold))
+		return 0;
+	return memtx_tuple_update_in_place(old_tuple, request->tuple,
+					   request->tuple_end,
+					   request->index_base, column_mask,
+					   result);
+}
+
 static int
 memtx_space_execute_update(struct space *space, struct txn *txn,
 			   struct request *request, struct tuple **result)
@@ -402,23 +508,39 @@ memtx_space_execute_update(struct space *space, struct txn *txn,
 	}
 
 	/* Update the tuple; legacy, request ops are in request->tuple */
-	uint32_t new_size = 0, bsize;
-	const char *old_data = tuple_data_range(old_tuple, &bsize);
-	const char *new_data =
-		tuple_update_execute(region_aligned_alloc_cb, &fiber()->gc,
-				     request->tuple, request->tuple_end,
-				     old_data, old_data + bsize,
-				     &new_size, request->index_base, NULL);
-	if (new_data == NULL)
-		return -1;
-
-	stmt->new_tuple = memtx_tuple_new(space->format, new_data,
-					  new_data + new_size);
-	if (stmt->new_tuple == NULL)
+	uint64_t column_mask = COLUMN_MASK_FULL;
+	if (memtx_space_update_in_place(space, old_tuple, request,
+					&column_mask, &stmt->new_tuple) != 0)
 		return -1;
+	if (stmt->new_tuple == NULL) {
+		uint32_t new_size = 0, bsize;
+		const char *old_data = memtx_space_old_data(old_tuple, &bsize);
+		if (old_data == NULL)
+			return -1;
+		const char *new_data =
+			tuple_update_execute(region_aligned_alloc_cb,
+					     &fiber()->gc, request->tuple,
+					     request->tuple_end, old_data,
+					     old_data + bsize, &new_size,
+					     request->index_base, &column_mask);
+		if (new_data == NULL)
+			return -1;
+		stmt->new_tuple = memtx_space_tuple_new(space, new_data,
+							new_data + new_size);
+		if (stmt->new_tuple == NULL)
+			return -1;
+	}
 	tuple_ref(stmt->new_tuple);
-	if (memtx_space->replace(space, old_tuple, stmt->new_tuple,
-				 DUP_REPLACE, &stmt->old_tuple) != 0)
+	int rc;
+	if (memtx_space->replace == memtx_space_replace_all_keys) {
+		rc = memtx_space_replace_masked(space, old_tuple,
+						stmt->new_tuple, DUP_REPLACE,
+						column_mask, &stmt->old_tuple);
+	} else {
+		rc = memtx_space->replace(space, old_tuple, stmt->new_tuple,
+					  DUP_REPLACE, &stmt->old_tuple);
+	}
+	if (rc != 0)
 		return -1;
 	stmt->engine_savepoint = stmt;
 	*result = stmt->new_tuple;
@@ -479,15 +601,17 @@ memtx_space_execute_upsert(struct space *space, struct txn *txn,
 				       request->index_base)) {
 			return -1;
 		}
-		stmt->new_tuple = memtx_tuple_new(space->format,
-						  request->tuple,
-						  request->tuple_end);
+		stmt->new_tuple = memtx_space_tuple_new(space,
+							request->tuple,
+							request->tuple_end);
 		if (stmt->new_tuple == NULL)
 			return -1;
 		tuple_ref(stmt->new_tuple);
 	} else {
 		uint32_t new_size = 0, bsize;
-		const char *old_data = tuple_data_range(old_tuple, &bsize);
+		const char *old_data = memtx_space_old_data(old_tuple, &bsize);
+		if (old_data == NULL)
+			return -1;
 		/*
 		 * Update the tuple.
 		 * tuple_upsert_execute() fails on totally wrong
@@ -505,8 +629,8 @@ memtx_space_execute_upsert(struct space *space, struct txn *txn,
 		if (new_data == NULL)
 			return -1;
 
-		stmt->new_tuple = memtx_tuple_new(space->format, new_data,
-						  new_data + new_size);
+		stmt->new_tuple = memtx_space_tuple_new(space, new_data,
+							new_data + new_size);
 		if (stmt->new_tuple == NULL)
 			return -1;
 		tuple_ref(stmt->new_tuple);
@@ -630,6 +754,50 @@ memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 			return -1;
 		}
 	}
+	if (space->def->opts.is_fixed_width && index_def->type != TREE) {
+		diag_set(ClientError, ER_UNSUPPORTED,
+			 index_type_strs[index_def->type],
+			 "fixed_width spaces");
+		return -1;
+	}
+	if (index_def->key_def->is_multikey && index_def->type != TREE) {
+		diag_set(ClientError, ER_UNSUPPORTED,
+			 index_type_strs[index_def->type],
+			 "multikey indexes");
+		return -1;
+	}
+	if (index_def->opts.store_key && index_def->type != TREE) {
+		diag_set(ClientError, ER_UNSUPPORTED,
+			 index_type_strs[index_def->type], "stored keys");
+		return -1;
+	}
+	if (index_def->opts.func_id != 0) {
+		if (index_def->type != TREE) {
+			diag_set(ClientError, ER_UNSUPPORTED,
+				 index_type_strs[index_def->type],
+				 "functional indexes");
+			return -1;
+		}
+		/*
+		 * _func is recovered after _index, so the function
+		 * is looked up only once the keys are built.
+		 */
+		struct memtx_engine *memtx =
+			(struct memtx_engine *)space->engine;
+		struct func *func = func_by_id(index_def->opts.func_id);
+		if (func == NULL && memtx->state == MEMTX_OK) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "function does not exist");
+			return -1;
+		}
+		if (func != NULL && func->def->language != FUNC_LANGUAGE_C) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "function must be written in C");
+			return -1;
+		}
+	}
 	switch (index_def->type) {
 	case HASH:
 		if (! index_def->opts.is_unique) {
@@ -796,6 +964,19 @@ memtx_space_add_primary_key(struct space *space)
 	return 0;
 }
 
+/**
+ * Check a stored tuple against a new format, which may impose
+ * constraints on fields that are compressed.
+ */
+static int
+memtx_space_validate_tuple(struct tuple_format *format, struct tuple *tuple)
+{
+	struct tuple *unpacked = tuple_unpack(tuple);
+	if (unpacked == NULL)
+		return -1;
+	return tuple_validate(format, unpacked);
+}
+
 static int
 memtx_space_check_format(struct space *space, struct tuple_format *format)
 {
@@ -816,7 +997,7 @@ memtx_space_check_format(struct space *space, struct tuple_format *format)
 		 * Check that the tuple is OK according to the
 		 * new format.
 		 */
-		rc = tuple_validate(format, tuple);
+		rc = memtx_space_validate_tuple(format, tuple);
 		if (rc != 0)
 			break;
 	}
@@ -852,6 +1033,217 @@ memtx_init_ephemeral_space(struct space *space)
 	memtx_space_add_primary_key(space);
 }
 
+/**
+ * Yield after building this many tuples into a new index
+ * so as not to stall the tx thread. Yield more often in
+ * debug mode.
+ */
+#if defined(NDEBUG)
+enum { MEMTX_DDL_YIELD_LOOPS = 1000 };
+#else
+enum { MEMTX_DDL_YIELD_LOOPS = 10 };
+#endif
+
+/** A change made to a space while a new index was bulk loaded. */
+struct memtx_ddl_stmt {
+	struct tuple *old_tuple;
+	struct tuple *new_tuple;
+};
+
+/** State of a new index build, see memtx_build_on_replace(). */
+struct memtx_ddl_state {
+	/** The index being built. */
+	struct index *index;
+	/** Format of the new space. */
+	struct tuple_format *format;
+	/**
+	 * Number of leading fields indexed by the new index.
+	 * They must not be compressed.
+	 */
+	uint32_t field_count;
+	/** Comparator of the primary index of the space. */
+	struct key_def *cmp_def;
+	/**
+	 * The last tuple of the primary index inserted into
+	 * the new index. Tuples up to this one, inclusive, are
+	 * already in the new index and changes made to them
+	 * have to be forwarded to it. NULL if the build hasn't
+	 * started yet.
+	 */
+	struct tuple *cursor;
+	/**
+	 * Set if the new index is bulk loaded. Such an index
+	 * can't be changed until the build is complete, so
+	 * changes are logged in @stmts and replayed afterwards.
+	 */
+	bool is_bulk;
+	/** Logged changes, in the order they were made. */
+	struct memtx_ddl_stmt *stmts;
+	/** Number of logged changes. */
+	uint32_t stmt_count;
+	/** Capacity of @stmts. */
+	uint32_t stmt_capacity;
+	/** Set if a change couldn't be forwarded. */
+	bool is_failed;
+	/** The error that occurred while forwarding a change. */
+	struct diag diag;
+};
+
+/**
+ * Check if a tuple stored in the space can be inserted into
+ * the index being built.
+ */
+static int
+memtx_ddl_state_check(struct memtx_ddl_state *state, struct tuple *tuple)
+{
+	/*
+	 * A compressed tuple is stored with only the fields
+	 * indexed by its own format left intact.
+	 */
+	if (memtx_tuple_is_packed(tuple) &&
+	    tuple_format(tuple)->index_field_count < state->field_count) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Memtx",
+			 "indexing compressed fields");
+		return -1;
+	}
+	return memtx_space_validate_tuple(state->format, tuple);
+}
+
+/**
+ * Insert @new_tuple into the index being built instead of
+ * @old_tuple.
+ */
+static int
+memtx_ddl_state_replace(struct memtx_ddl_state *state,
+			struct tuple *old_tuple, struct tuple *new_tuple)
+{
+	struct index *index = state->index;
+	struct tuple *unused;
+	if (index_replace(index, old_tuple, new_tuple,
+			  DUP_INSERT, &unused) != 0)
+		return -1;
+	/*
+	 * All tuples stored in a memtx space must be
+	 * referenced by the primary index.
+	 */
+	if (index->def->iid == 0) {
+		if (new_tuple != NULL)
+			tuple_ref(new_tuple);
+		if (old_tuple != NULL)
+			tuple_unref(old_tuple);
+	}
+	return 0;
+}
+
+/** Log a change to be replayed after a bulk load. */
+static int
+memtx_ddl_state_log(struct memtx_ddl_state *state,
+		    struct tuple *old_tuple, struct tuple *new_tuple)
+{
+	if (state->stmt_count == state->stmt_capacity) {
+		uint32_t capacity = MAX(state->stmt_capacity * 2, 16);
+		size_t size = capacity * sizeof(*state->stmts);
+		struct memtx_ddl_stmt *stmts = realloc(state->stmts, size);
+		if (stmts == NULL) {
+			diag_set(OutOfMemory, size, "realloc",
+				 "struct memtx_ddl_stmt");
+			return -1;
+		}
+		state->stmts = stmts;
+		state->stmt_capacity = capacity;
+	}
+	struct memtx_ddl_stmt *stmt = &state->stmts[state->stmt_count++];
+	stmt->old_tuple = old_tuple;
+	stmt->new_tuple = new_tuple;
+	if (old_tuple != NULL)
+		tuple_ref(old_tuple);
+	if (new_tuple != NULL)
+		tuple_ref(new_tuple);
+	return 0;
+}
+
+/** Replay changes logged during a bulk load and free the log. */
+static int
+memtx_ddl_state_replay(struct memtx_ddl_state *state)
+{
+	int rc = 0;
+	for (uint32_t i = 0; i < state->stmt_count; i++) {
+		struct memtx_ddl_stmt *stmt = &state->stmts[i];
+		if (rc == 0)
+			rc = memtx_ddl_state_replace(state, stmt->old_tuple,
+						     stmt->new_tuple);
+		if (stmt->old_tuple != NULL)
+			tuple_unref(stmt->old_tuple);
+		if (stmt->new_tuple != NULL)
+			tuple_unref(stmt->new_tuple);
+	}
+	free(state->stmts);
+	state->stmts = NULL;
+	state->stmt_count = state->stmt_capacity = 0;
+	return rc;
+}
+
+/**
+ * The build yields from time to time, and the space may be
+ * changed meanwhile. Forward a change made to the part of
+ * the space that has already been inserted into the new
+ * index. The rest is picked up by the build itself.
+ */
+static void
+memtx_ddl_state_forward(struct memtx_ddl_state *state,
+			struct tuple *old_tuple, struct tuple *new_tuple)
+{
+	if (state->is_failed)
+		return; /* already failed, nothing to do */
+
+	struct tuple *cmp_tuple = new_tuple != NULL ? new_tuple : old_tuple;
+	if (state->cursor == NULL ||
+	    tuple_compare(state->cursor, cmp_tuple, state->cmp_def) < 0)
+		return;
+
+	/* Check new tuples for conformity to the new format. */
+	if (new_tuple != NULL &&
+	    memtx_ddl_state_check(state, new_tuple) != 0)
+		goto err;
+
+	int rc;
+	if (state->is_bulk)
+		rc = memtx_ddl_state_log(state, old_tuple, new_tuple);
+	else
+		rc = memtx_ddl_state_replace(state, old_tuple, new_tuple);
+	if (rc != 0)
+		goto err;
+	return;
+err:
+	state->is_failed = true;
+	diag_move(diag_get(), &state->diag);
+}
+
+static void
+memtx_build_on_replace(struct trigger *trigger, void *event)
+{
+	struct txn *txn = event;
+	struct memtx_ddl_state *state = trigger->data;
+	struct txn_stmt *stmt = txn_current_stmt(txn);
+	memtx_ddl_state_forward(state, stmt->old_tuple, stmt->new_tuple);
+}
+
+void
+memtx_space_rollback_ddl_stmt(struct space *space, struct txn_stmt *stmt)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	if (memtx_space->ddl_state == NULL)
+		return;
+	/*
+	 * If the cursor has passed the tuple, the new index
+	 * has got the change either from the on_replace trigger
+	 * or from the build itself, so undo it there as well.
+	 * Otherwise, the build will find the restored tuple.
+	 */
+	memtx_ddl_state_forward(memtx_space->ddl_state, stmt->new_tuple,
+				stmt->old_tuple);
+}
+
 static int
 memtx_space_build_index(struct space *src_space, struct index *new_index,
 			struct tuple_format *new_format)
@@ -876,11 +1268,63 @@ memtx_space_build_index(struct space *src_space, struct index *new_index,
 		return -1;
 	}
 
+	/*
+	 * R-tree is bulk loaded: it's much faster and gives
+	 * a better tree than insertion of tuples one by one.
+	 */
+	bool is_bulk = new_index->def->type == RTREE;
+	if (is_bulk)
+		index_begin_build(new_index);
+	/*
+	 * A hash table is sized up front so that it doesn't
+	 * grow while the index is being built.
+	 */
+	if (is_bulk || new_index->def->type == HASH) {
+		ssize_t n_tuples = index_size(pk);
+		if (n_tuples < 0 || index_reserve(new_index, n_tuples) != 0)
+			return -1;
+	}
+
 	/* Now deal with any kind of add index during normal operation. */
 	struct iterator *it = index_create_iterator(pk, ITER_ALL, NULL, 0);
 	if (it == NULL)
 		return -1;
 
+	/*
+	 * The build yields periodically unless the engine is
+	 * being recovered. Install an on_replace trigger to
+	 * forward DML requests issued meanwhile. Only a tree
+	 * iterator survives changes of the index it iterates,
+	 * so a space with a HASH primary key is built without
+	 * yields.
+	 */
+	struct memtx_engine *memtx = (struct memtx_engine *)src_space->engine;
+	bool can_yield = memtx->state == MEMTX_OK && pk->def->type == TREE;
+	struct memtx_ddl_state state;
+	state.index = new_index;
+	state.format = new_format;
+	state.field_count = 0;
+	struct key_def *key_def = new_index->def->key_def;
+	for (uint32_t i = key_def->func_part_count;
+	     i < key_def->part_count; i++) {
+		state.field_count = MAX(state.field_count,
+					key_def->parts[i].fieldno + 1);
+	}
+	state.cmp_def = pk->def->key_def;
+	state.cursor = NULL;
+	state.is_bulk = is_bulk;
+	state.stmts = NULL;
+	state.stmt_count = 0;
+	state.stmt_capacity = 0;
+	state.is_failed = false;
+	diag_create(&state.diag);
+	struct trigger on_replace;
+	trigger_create(&on_replace, memtx_build_on_replace, &state, NULL);
+	trigger_add(&src_space->on_replace, &on_replace);
+	struct memtx_space *memtx_space = (struct memtx_space *)src_space;
+	assert(memtx_space->ddl_state == NULL);
+	memtx_space->ddl_state = &state;
+
 	/*
 	 * The index has to be built tuple by tuple, since
 	 * there is no guarantee that all tuples satisfy
@@ -891,32 +1335,66 @@ memtx_space_build_index(struct space *src_space, struct index *new_index,
 	/* Build the new index. */
 	int rc;
 	struct tuple *tuple;
+	size_t count = 0;
 	while ((rc = iterator_next(it, &tuple)) == 0 && tuple != NULL) {
 		/*
 		 * Check that the tuple is OK according to the
 		 * new format.
 		 */
-		rc = tuple_validate(new_format, tuple);
+		rc = memtx_ddl_state_check(&state, tuple);
 		if (rc != 0)
 			break;
+		if (is_bulk) {
+			rc = index_build_next(new_index, tuple);
+			if (rc != 0)
+				break;
+		} else {
+			/*
+			 * @todo: better message if there is a duplicate.
+			 */
+			struct tuple *old_tuple;
+			rc = index_replace(new_index, NULL, tuple,
+					   DUP_INSERT, &old_tuple);
+			if (rc != 0)
+				break;
+			/* Guaranteed by DUP_INSERT. */
+			assert(old_tuple == NULL);
+			(void) old_tuple;
+			/*
+			 * All tuples stored in a memtx space must be
+			 * referenced by the primary index.
+			 */
+			if (new_index->def->iid == 0)
+				tuple_ref(tuple);
+		}
 		/*
-		 * @todo: better message if there is a duplicate.
+		 * The iterator holds a reference to the tuple,
+		 * so it can be used as the cursor until the next
+		 * iteration, i.e. across the yield below.
 		 */
-		struct tuple *old_tuple;
-		rc = index_replace(new_index, NULL, tuple,
-				   DUP_INSERT, &old_tuple);
-		if (rc != 0)
-			break;
-		assert(old_tuple == NULL); /* Guaranteed by DUP_INSERT. */
-		(void) old_tuple;
+		state.cursor = tuple;
+		if (can_yield && ++count % MEMTX_DDL_YIELD_LOOPS == 0)
+			fiber_sleep(0);
 		/*
-		 * All tuples stored in a memtx space must be
-		 * referenced by the primary index.
+		 * The on_replace trigger may have failed
+		 * during the yield.
 		 */
-		if (new_index->def->iid == 0)
-			tuple_ref(tuple);
+		if (state.is_failed) {
+			diag_move(&state.diag, diag_get());
+			rc = -1;
+			break;
+		}
 	}
 	iterator_delete(it);
+	trigger_clear(&on_replace);
+	memtx_space->ddl_state = NULL;
+	if (rc == 0 && is_bulk) {
+		index_end_build(new_index);
+		rc = memtx_ddl_state_replay(&state);
+	} else {
+		memtx_ddl_state_replay(&state);
+	}
+	diag_destroy(&state.diag);
 	return rc;
 }
 
@@ -938,6 +1416,21 @@ memtx_space_prepare_alter(struct space *old_space, struct space *new_space)
 	return 0;
 }
 
+static void
+memtx_space_finish_alter(struct space *old_space, struct space *new_space)
+{
+	struct memtx_space *old_memtx_space = (struct memtx_space *)old_space;
+	struct memtx_space *new_memtx_space = (struct memtx_space *)new_space;
+	/*
+	 * The old space could have been changed while new
+	 * indexes were being built. Unless the space data was
+	 * dropped, take its actual size.
+	 */
+	if (new_space->index_count != 0 &&
+	    index_size(new_space->index[0]) != 0)
+		new_memtx_space->bsize = old_memtx_space->bsize;
+}
+
 /* }}} DDL */
 
 static const struct space_vtab memtx_space_vtab = {
@@ -961,6 +1454,8 @@ static const struct space_vtab memtx_space_vtab = {
 	/* .build_index = */ memtx_space_build_index,
 	/* .swap_index = */ generic_space_swap_index,
 	/* .prepare_alter = */ memtx_space_prepare_alter,
+	/* .finish_alter = */ memtx_space_finish_alter,
+	/* .bulk_load = */ generic_space_bulk_load,
 };
 
 struct space *
@@ -986,14 +1481,33 @@ memtx_space_new(struct memtx_engine *memtx,
 		return NULL;
 	}
 	key_count = 0;
-	rlist_foreach_entry(index_def, key_list, link)
+	rlist_foreach_entry(index_def, key_list, link) {
+		if (def->opts.is_fixed_width && index_def->type != TREE) {
+			diag_set(ClientError, ER_UNSUPPORTED,
+				 index_type_strs[index_def->type],
+				 "fixed_width spaces");
+			free(memtx_space);
+			return NULL;
+		}
 		keys[key_count++] = index_def->key_def;
+	}
+	if (def->opts.is_fixed_width &&
+	    def->opts.compression_threshold > 0) {
+		diag_set(ClientError, ER_ALTER_SPACE, def->name,
+			 "fixed_width is incompatible with "
+			 "compression_threshold");
+		free(memtx_space);
+		return NULL;
+	}
 
+	struct tuple_format_vtab *vtab = def->opts.compression_threshold > 0 ?
+		&memtx_packed_tuple_format_vtab : &memtx_tuple_format_vtab;
 	struct tuple_format *format =
-		tuple_format_new(&memtx_tuple_format_vtab, memtx, keys, key_count,
+		tuple_format_new(vtab, memtx, keys, key_count,
 				 def->fields, def->field_count,
 				 def->exact_field_count, def->dict,
-				 def->opts.is_temporary, def->opts.is_ephemeral);
+				 def->opts.is_temporary, def->opts.is_ephemeral,
+				 true, def->opts.is_fixed_width);
 	if (format == NULL) {
 		free(memtx_space);
 		return NULL;
@@ -1011,7 +1525,11 @@ memtx_space_new(struct memtx_engine *memtx,
 	tuple_format_unref(format);
 
 	memtx_space->bsize = 0;
+	/* A new space isn't in the last snapshot. */
+	memtx_space->write_gen = 1;
+	memtx_space->snap_write_gen = 0;
 	memtx_space->rowid = 0;
 	memtx_space->replace = memtx_space_replace_no_keys;
+	memtx_space->ddl_state = NULL;
 	return (struct space *)memtx_space;
 }
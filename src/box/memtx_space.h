@@ -37,11 +37,24 @@ extern "C" {
 #endif /* defined(__cplusplus) */
 
 struct memtx_engine;
+struct memtx_ddl_state;
+struct txn_stmt;
 
 struct memtx_space {
 	struct space base;
 	/* Number of bytes used in memory by tuples in the space. */
 	size_t bsize;
+	/**
+	 * Incremented whenever a tuple is inserted into or
+	 * deleted from the space.
+	 */
+	uint64_t write_gen;
+	/**
+	 * write_gen at the time of the last snapshot. A space
+	 * that hasn't changed since then isn't written to a
+	 * delta snapshot, see memtx_engine::snap_delta_max.
+	 */
+	uint64_t snap_write_gen;
 	/**
 	 * This counter is used to generate unique ids for
 	 * ephemeral spaces. Mostly used by SQL: values of this
@@ -55,6 +68,11 @@ struct memtx_space {
 	 */
 	int (*replace)(struct space *, struct tuple *, struct tuple *,
 		       enum dup_replace_mode, struct tuple **);
+	/**
+	 * State of a new index build in progress, NULL if
+	 * there's none. See memtx_space_build_index().
+	 */
+	struct memtx_ddl_state *ddl_state;
 };
 
 /**
@@ -71,6 +89,14 @@ memtx_space_update_bsize(struct space *space,
 			 const struct tuple *old_tuple,
 			 const struct tuple *new_tuple);
 
+/**
+ * Undo a statement in the index being built for the space,
+ * if there is one. Called on statement rollback, after the
+ * space indexes have been restored.
+ */
+void
+memtx_space_rollback_ddl_stmt(struct space *space, struct txn_stmt *stmt);
+
 int
 memtx_space_replace_no_keys(struct space *, struct tuple *, struct tuple *,
 			    enum dup_replace_mode, struct tuple **);
@@ -30,12 +30,16 @@
  */
 #include "memtx_tree.h"
 #include "memtx_engine.h"
+#include "memtx_read_view.h"
 #include "space.h"
 #include "schema.h" /* space_cache_find() */
 #include "errinj.h"
 #include "memory.h"
 #include "fiber.h"
 #include "tuple.h"
+#include "func.h"
+#include "call.h"
+#include "port.h"
 #include <third_party/qsort_arg.h>
 #include <small/mempool.h>
 
@@ -44,8 +48,11 @@
 static int
 memtx_tree_qcompare(const void* a, const void *b, void *c)
 {
-	return tuple_compare(*(struct tuple **)a,
-		*(struct tuple **)b, (struct key_def *)c);
+	const struct memtx_tree_data *data_a = a;
+	const struct memtx_tree_data *data_b = b;
+	struct key_def *key_def = c;
+	return tuple_compare_hinted(data_a->tuple, data_a->hint, data_b->tuple,
+				    data_b->hint, key_def);
 }
 
 /* {{{ MemtxTree Iterators ****************************************/
@@ -56,7 +63,8 @@ struct tree_iterator {
 	struct memtx_tree_iterator tree_iterator;
 	enum iterator_type type;
 	struct memtx_tree_key_data key_data;
-	struct tuple *current_tuple;
+	/** Last returned tuple and its comparison hint. */
+	struct memtx_tree_data current;
 	/** Memory pool the iterator was allocated from. */
 	struct mempool *pool;
 };
@@ -71,12 +79,50 @@ tree_iterator(struct iterator *it)
 	return (struct tree_iterator *) it;
 }
 
+/**
+ * True if the index stores the key of each tuple in place of
+ * the comparison hint, see key_def::stored_part_count.
+ */
+static inline bool
+memtx_tree_index_def_stores_keys(const struct index_def *def)
+{
+	return def->key_def->stored_part_count > 0;
+}
+
+/**
+ * Remember the last returned tuple. An iterator over an index
+ * storing keys also references the stored key of the tuple,
+ * because the key is freed once the tuple is deleted from the
+ * index, while the iterator still needs it to find its position
+ * in the tree.
+ */
+static inline void
+tree_iterator_set_current(struct tree_iterator *it,
+			  const struct memtx_tree_data *res)
+{
+	it->current = *res;
+	tuple_ref(it->current.tuple);
+	if (memtx_tree_index_def_stores_keys(it->index_def))
+		tuple_ref((struct tuple *)(uintptr_t)it->current.hint);
+}
+
+/** Forget the last returned tuple. */
+static inline void
+tree_iterator_clear_current(struct tree_iterator *it)
+{
+	assert(it->current.tuple != NULL);
+	tuple_unref(it->current.tuple);
+	if (memtx_tree_index_def_stores_keys(it->index_def))
+		tuple_unref((struct tuple *)(uintptr_t)it->current.hint);
+	it->current.tuple = NULL;
+}
+
 static void
 tree_iterator_free(struct iterator *iterator)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	if (it->current_tuple != NULL)
-		tuple_unref(it->current_tuple);
+	if (it->current.tuple != NULL)
+		tree_iterator_clear_current(it);
 	mempool_free(it->pool, it);
 }
 
@@ -91,25 +137,25 @@ tree_iterator_dummie(struct iterator *iterator, struct tuple **ret)
 static int
 tree_iterator_next(struct iterator *iterator, struct tuple **ret)
 {
-	struct tuple **res;
+	struct memtx_tree_data *res;
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
+	assert(it->current.tuple != NULL);
+	struct memtx_tree_data *check =
+		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	if (check == NULL || !memtx_tree_data_identical(check, &it->current))
 		it->tree_iterator =
-			memtx_tree_upper_bound_elem(it->tree, it->current_tuple,
+			memtx_tree_upper_bound_elem(it->tree, it->current,
 						    NULL);
 	else
 		memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
+	tree_iterator_clear_current(it);
 	res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (res == NULL) {
 		iterator->next = tree_iterator_dummie;
 		*ret = NULL;
 	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
+		tree_iterator_set_current(it, res);
+		*ret = it->current.tuple;
 	}
 	return 0;
 }
@@ -118,22 +164,23 @@ static int
 tree_iterator_prev(struct iterator *iterator, struct tuple **ret)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
+	assert(it->current.tuple != NULL);
+	struct memtx_tree_data *check =
+		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	if (check == NULL || !memtx_tree_data_identical(check, &it->current))
 		it->tree_iterator =
-			memtx_tree_lower_bound_elem(it->tree, it->current_tuple,
+			memtx_tree_lower_bound_elem(it->tree, it->current,
 						    NULL);
 	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	tree_iterator_clear_current(it);
+	struct memtx_tree_data *res =
+		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res) {
 		iterator->next = tree_iterator_dummie;
 		*ret = NULL;
 	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
+		tree_iterator_set_current(it, res);
+		*ret = it->current.tuple;
 	}
 	return 0;
 }
@@ -142,27 +189,26 @@ static int
 tree_iterator_next_equal(struct iterator *iterator, struct tuple **ret)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
+	assert(it->current.tuple != NULL);
+	struct memtx_tree_data *check =
+		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	if (check == NULL || !memtx_tree_data_identical(check, &it->current))
 		it->tree_iterator =
-			memtx_tree_upper_bound_elem(it->tree, it->current_tuple,
+			memtx_tree_upper_bound_elem(it->tree, it->current,
 						    NULL);
 	else
 		memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
+	tree_iterator_clear_current(it);
+	struct memtx_tree_data *res =
+		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	/* Use user key def to save a few loops. */
-	if (!res || memtx_tree_compare_key(*res, &it->key_data,
+	if (!res || memtx_tree_compare_key(res, &it->key_data,
 					   it->index_def->key_def) != 0) {
 		iterator->next = tree_iterator_dummie;
 		*ret = NULL;
 	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
+		tree_iterator_set_current(it, res);
+		*ret = it->current.tuple;
 	}
 	return 0;
 }
@@ -171,26 +217,25 @@ static int
 tree_iterator_prev_equal(struct iterator *iterator, struct tuple **ret)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
+	assert(it->current.tuple != NULL);
+	struct memtx_tree_data *check =
+		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	if (check == NULL || !memtx_tree_data_identical(check, &it->current))
 		it->tree_iterator =
-			memtx_tree_lower_bound_elem(it->tree, it->current_tuple,
+			memtx_tree_lower_bound_elem(it->tree, it->current,
 						    NULL);
 	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
+	tree_iterator_clear_current(it);
+	struct memtx_tree_data *res =
+		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	/* Use user key def to save a few loops. */
-	if (!res || memtx_tree_compare_key(*res, &it->key_data,
+	if (!res || memtx_tree_compare_key(res, &it->key_data,
 					   it->index_def->key_def) != 0) {
 		iterator->next = tree_iterator_dummie;
 		*ret = NULL;
 	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
+		tree_iterator_set_current(it, res);
+		*ret = it->current.tuple;
 	}
 	return 0;
 }
@@ -198,7 +243,7 @@ tree_iterator_prev_equal(struct iterator *iterator, struct tuple **ret)
 static void
 tree_iterator_set_next_method(struct tree_iterator *it)
 {
-	assert(it->current_tuple != NULL);
+	assert(it->current.tuple != NULL);
 	switch (it->type) {
 	case ITER_EQ:
 		it->base.next = tree_iterator_next_equal;
@@ -232,7 +277,7 @@ tree_iterator_start(struct iterator *iterator, struct tuple **ret)
 	const struct memtx_tree *tree = it->tree;
 	enum iterator_type type = it->type;
 	bool exact = false;
-	assert(it->current_tuple == NULL);
+	assert(it->current.tuple == NULL);
 	if (it->key_data.key == 0) {
 		if (iterator_type_is_reverse(it->type))
 			it->tree_iterator = memtx_tree_iterator_last(tree);
@@ -269,12 +314,81 @@ tree_iterator_start(struct iterator *iterator, struct tuple **ret)
 		}
 	}
 
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
+	struct memtx_tree_data *res =
+		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res)
 		return 0;
-	*ret = it->current_tuple = *res;
-	tuple_ref(it->current_tuple);
+	tree_iterator_set_current(it, res);
+	*ret = it->current.tuple;
+	tree_iterator_set_next_method(it);
+	return 0;
+}
+
+/**
+ * Find the range [*begin, *end) of offsets of the tree elements
+ * matching the iterator type and key.
+ */
+static void
+memtx_tree_key_range(const struct memtx_tree *tree, enum iterator_type type,
+		     struct memtx_tree_key_data *key_data,
+		     size_t *begin, size_t *end)
+{
+	*begin = 0;
+	*end = memtx_tree_size(tree);
+	if (key_data->key == NULL)
+		return;
+	switch (type) {
+	case ITER_EQ:
+	case ITER_REQ:
+		memtx_tree_lower_bound_get_offset(tree, key_data, NULL, begin);
+		memtx_tree_upper_bound_get_offset(tree, key_data, NULL, end);
+		break;
+	case ITER_ALL:
+	case ITER_GE:
+		memtx_tree_lower_bound_get_offset(tree, key_data, NULL, begin);
+		break;
+	case ITER_GT:
+		memtx_tree_upper_bound_get_offset(tree, key_data, NULL, begin);
+		break;
+	case ITER_LE:
+		memtx_tree_upper_bound_get_offset(tree, key_data, NULL, end);
+		break;
+	case ITER_LT:
+		memtx_tree_lower_bound_get_offset(tree, key_data, NULL, end);
+		break;
+	default:
+		unreachable();
+	}
+}
+
+static int
+tree_iterator_skip(struct iterator *iterator, uint32_t count)
+{
+	struct tree_iterator *it = tree_iterator(iterator);
+	assert(iterator->next == tree_iterator_start);
+	assert(it->current.tuple == NULL);
+	if (count == 0)
+		return 0;
+	const struct memtx_tree *tree = it->tree;
+	size_t begin, end;
+	memtx_tree_key_range(tree, it->type, &it->key_data, &begin, &end);
+	if (end - begin <= count) {
+		iterator->next = tree_iterator_dummie;
+		return 0;
+	}
+	/*
+	 * Position the iterator at the last skipped tuple, so
+	 * that the next call returns the first tuple after it.
+	 */
+	if (iterator_type_is_reverse(it->type))
+		it->tree_iterator = memtx_tree_iterator_at(tree, end - count);
+	else
+		it->tree_iterator = memtx_tree_iterator_at(tree,
+							   begin + count - 1);
+	struct memtx_tree_data *res =
+		memtx_tree_iterator_get_elem(tree, &it->tree_iterator);
+	assert(res != NULL);
+	tree_iterator_set_current(it, res);
 	tree_iterator_set_next_method(it);
 	return 0;
 }
@@ -303,6 +417,21 @@ memtx_tree_index_cmp_def(struct memtx_tree_index *index)
 static void
 memtx_tree_index_free(struct memtx_tree_index *index)
 {
+	if (memtx_tree_index_def_stores_keys(index->base.def)) {
+		/* Stored keys are owned by the index. */
+		struct memtx_tree *tree = &index->tree;
+		struct memtx_tree_iterator itr = memtx_tree_iterator_first(tree);
+		while (!memtx_tree_iterator_is_invalid(&itr)) {
+			struct memtx_tree_data *res =
+				memtx_tree_iterator_get_elem(tree, &itr);
+			tuple_unref((struct tuple *)(uintptr_t)res->hint);
+			memtx_tree_iterator_next(tree, &itr);
+		}
+		for (size_t i = 0; i < index->build_array_size; i++) {
+			struct memtx_tree_data *elem = &index->build_array[i];
+			tuple_unref((struct tuple *)(uintptr_t)elem->hint);
+		}
+	}
 	memtx_tree_destroy(&index->tree);
 	free(index->build_array);
 	free(index);
@@ -326,17 +455,21 @@ memtx_tree_index_gc_run(struct memtx_gc_task *task, bool *done)
 	struct memtx_tree *tree = &index->tree;
 	struct memtx_tree_iterator *itr = &index->gc_iterator;
 
+	struct tuple *batch[MEMTX_GC_BATCH];
 	unsigned int loops = 0;
-	while (!memtx_tree_iterator_is_invalid(itr)) {
-		struct tuple *tuple = *memtx_tree_iterator_get_elem(tree, itr);
-		memtx_tree_iterator_next(tree, itr);
-		tuple_unref(tuple);
-		if (++loops >= YIELD_LOOPS) {
-			*done = false;
-			return;
+	while (!memtx_tree_iterator_is_invalid(itr) && loops < YIELD_LOOPS) {
+		int count = 0;
+		while (count < MEMTX_GC_BATCH &&
+		       !memtx_tree_iterator_is_invalid(itr)) {
+			struct memtx_tree_data *res =
+				memtx_tree_iterator_get_elem(tree, itr);
+			batch[count++] = res->tuple;
+			memtx_tree_iterator_next(tree, itr);
 		}
+		memtx_gc_unref_tuples(batch, count);
+		loops += count;
 	}
-	*done = true;
+	*done = memtx_tree_iterator_is_invalid(itr);
 }
 
 static void
@@ -357,6 +490,7 @@ memtx_tree_index_destroy(struct index *base)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
 	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+	memtx_read_view_forget_index(memtx, base);
 	if (base->def->iid == 0) {
 		/*
 		 * Primary index. We need to free all tuples stored
@@ -408,8 +542,8 @@ static int
 memtx_tree_index_random(struct index *base, uint32_t rnd, struct tuple **result)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
-	struct tuple **res = memtx_tree_random(&index->tree, rnd);
-	*result = res != NULL ? *res : NULL;
+	struct memtx_tree_data *res = memtx_tree_random(&index->tree, rnd);
+	*result = res != NULL ? res->tuple : NULL;
 	return 0;
 }
 
@@ -419,7 +553,17 @@ memtx_tree_index_count(struct index *base, enum iterator_type type,
 {
 	if (type == ITER_ALL)
 		return memtx_tree_index_size(base); /* optimization */
-	return generic_index_count(base, type, key, part_count);
+	if (type > ITER_GT)
+		return generic_index_count(base, type, key, part_count);
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct memtx_tree_key_data key_data;
+	key_data.key = part_count > 0 ? key : NULL;
+	key_data.part_count = part_count;
+	key_data.hint = key_hint(key, part_count,
+				 memtx_tree_index_cmp_def(index));
+	size_t begin, end;
+	memtx_tree_key_range(&index->tree, type, &key_data, &begin, &end);
+	return end - begin;
 }
 
 static int
@@ -429,12 +573,381 @@ memtx_tree_index_get(struct index *base, const char *key,
 	assert(base->def->opts.is_unique &&
 	       part_count == base->def->key_def->part_count);
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
 	struct memtx_tree_key_data key_data;
 	key_data.key = key;
 	key_data.part_count = part_count;
-	struct tuple **res = memtx_tree_find(&index->tree, &key_data);
-	*result = res != NULL ? *res : NULL;
+	key_data.hint = key_hint(key, part_count, cmp_def);
+	struct memtx_tree_data *res = memtx_tree_find(&index->tree, &key_data);
+	*result = res != NULL ? res->tuple : NULL;
+	return 0;
+}
+
+static int
+memtx_tree_index_get_batch(struct index *base, const char *keys,
+			   uint32_t key_count, struct tuple **results)
+{
+	assert(base->def->opts.is_unique);
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t size = key_count * (sizeof(struct memtx_tree_key_data) +
+				   sizeof(struct memtx_tree_key_data *) +
+				   sizeof(struct memtx_tree_data *));
+	char *buf = (char *)region_alloc(region, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region", "keys");
+		return -1;
+	}
+	struct memtx_tree_key_data *key_data =
+		(struct memtx_tree_key_data *)buf;
+	struct memtx_tree_key_data **key_ptrs =
+		(struct memtx_tree_key_data **)(key_data + key_count);
+	struct memtx_tree_data **found =
+		(struct memtx_tree_data **)(key_ptrs + key_count);
+	for (uint32_t i = 0; i < key_count; i++) {
+		uint32_t part_count = mp_decode_array(&keys);
+		assert(part_count == base->def->key_def->part_count);
+		key_data[i].key = keys;
+		key_data[i].part_count = part_count;
+		key_data[i].hint = key_hint(keys, part_count, cmp_def);
+		key_ptrs[i] = &key_data[i];
+		for (uint32_t j = 0; j < part_count; j++)
+			mp_next(&keys);
+	}
+	memtx_tree_find_batch(&index->tree, key_ptrs, key_count, found);
+	for (uint32_t i = 0; i < key_count; i++) {
+		results[i] = found[i] != NULL ? found[i]->tuple : NULL;
+		if (results[i] != NULL)
+			tuple_ref(results[i]);
+	}
+	region_truncate(region, region_svp);
+	return 0;
+}
+
+/**
+ * Delete an element from the tree unless the tree stores
+ * another element equal to it, e.g. an entry of a new version
+ * of the tuple that has the same key.
+ */
+static void
+memtx_tree_delete_identical(struct memtx_tree *tree,
+			    struct memtx_tree_data data)
+{
+	bool exact = false;
+	struct memtx_tree_iterator it =
+		memtx_tree_lower_bound_elem(tree, data, &exact);
+	struct memtx_tree_data *elem = memtx_tree_iterator_get_elem(tree, &it);
+	if (exact && memtx_tree_data_identical(elem, &data))
+		memtx_tree_delete(tree, data);
+}
+
+/**
+ * Replace a tuple in a multikey index. A tuple is stored once
+ * per element of the indexed array, with the element position
+ * in place of the comparison hint. Elements of the same tuple
+ * having equal keys share one entry.
+ */
+static int
+memtx_tree_index_replace_multikey(struct memtx_tree_index *index,
+				  struct tuple *old_tuple,
+				  struct tuple *new_tuple,
+				  enum dup_replace_mode mode,
+				  struct tuple **result)
+{
+	struct index *base = &index->base;
+	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
+	*result = old_tuple;
+	if (new_tuple != NULL) {
+		uint32_t count = tuple_multikey_count(new_tuple, cmp_def);
+		size_t size = count * sizeof(struct memtx_tree_data);
+		struct memtx_tree_data *replaced = (struct memtx_tree_data *)
+			region_alloc(&fiber()->gc, size);
+		if (replaced == NULL && count > 0) {
+			diag_set(OutOfMemory, size, "region",
+				 "memtx_tree_index");
+			return -1;
+		}
+		uint32_t i;
+		uint32_t errcode = 0;
+		for (i = 0; i < count; i++) {
+			struct memtx_tree_data new_data;
+			new_data.tuple = new_tuple;
+			new_data.hint = i;
+			replaced[i].tuple = NULL;
+			if (memtx_tree_insert(&index->tree, new_data,
+					      &replaced[i]) != 0) {
+				diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
+					 "memtx_tree_index", "replace");
+				goto rollback;
+			}
+			if (replaced[i].tuple == new_tuple) {
+				/* The key repeats in the array. */
+				continue;
+			}
+			errcode = replace_check_dup(old_tuple,
+						    replaced[i].tuple, mode);
+			if (errcode != 0) {
+				memtx_tree_delete(&index->tree, new_data);
+				if (replaced[i].tuple != NULL)
+					memtx_tree_insert(&index->tree,
+							  replaced[i], NULL);
+				goto rollback;
+			}
+			if (replaced[i].tuple != NULL)
+				*result = replaced[i].tuple;
+		}
+		goto delete_old;
+rollback:
+		while (i-- > 0) {
+			struct memtx_tree_data new_data;
+			new_data.tuple = new_tuple;
+			new_data.hint = i;
+			memtx_tree_delete_identical(&index->tree, new_data);
+			if (replaced[i].tuple != NULL &&
+			    replaced[i].tuple != new_tuple)
+				memtx_tree_insert(&index->tree, replaced[i],
+						  NULL);
+		}
+		if (errcode != 0) {
+			struct space *sp = space_cache_find(base->def->space_id);
+			if (sp != NULL)
+				diag_set(ClientError, errcode, base->def->name,
+					 space_name(sp));
+		}
+		return -1;
+	}
+delete_old:
+	if (old_tuple != NULL) {
+		uint32_t count = tuple_multikey_count(old_tuple, cmp_def);
+		for (uint32_t i = 0; i < count; i++) {
+			struct memtx_tree_data old_data;
+			old_data.tuple = old_tuple;
+			old_data.hint = i;
+			memtx_tree_delete_identical(&index->tree, old_data);
+		}
+	}
+	return 0;
+}
+
+/** Set diag on failure to build a key for a functional index. */
+static void
+memtx_tree_index_func_error(struct memtx_tree_index *index,
+			    const char *reason)
+{
+	struct index_def *def = index->base.def;
+	struct space *space = space_cache_find(def->space_id);
+	if (space != NULL)
+		diag_set(ClientError, ER_FUNC_INDEX_FUNC, def->name,
+			 space_name(space), reason);
+}
+
+/**
+ * Compute the key of a tuple in a functional index by calling
+ * the index function. The function is passed the tuple and
+ * returns a tuple, fields of which are referred to by the index
+ * parts. The key is stored as a runtime tuple, an array of the
+ * part values in the order of the parts.
+ *
+ * Return the key referenced once, or NULL with diag set.
+ */
+static struct tuple *
+memtx_tree_index_func_key(struct memtx_tree_index *index,
+			  struct tuple *tuple)
+{
+	struct index_def *def = index->base.def;
+	struct key_def *key_def = def->key_def;
+	struct func *func = func_by_id(def->opts.func_id);
+	if (func == NULL) {
+		memtx_tree_index_func_error(index, "function not found");
+		return NULL;
+	}
+	/* The function may read any field of the tuple. */
+	tuple = tuple_unpack(tuple);
+	if (tuple == NULL)
+		return NULL;
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	struct tuple *key = NULL;
+	struct port port;
+	port_tuple_create(&port);
+
+	uint32_t bsize;
+	const char *data = tuple_data_range(tuple, &bsize);
+	size_t size = mp_sizeof_array(1) + bsize;
+	char *args = (char *)region_alloc(region, size);
+	if (args == NULL) {
+		diag_set(OutOfMemory, size, "region", "args");
+		goto out;
+	}
+	char *args_end = mp_encode_array(args, 1);
+	memcpy(args_end, data, bsize);
+	args_end += bsize;
+	box_function_ctx_t ctx = { &port };
+	if (func_call(func, &ctx, args, args_end) != 0)
+		goto out;
+	if (port_tuple(&port)->size == 0) {
+		memtx_tree_index_func_error(index, "function returned nothing");
+		goto out;
+	}
+	struct tuple *ret = port_tuple(&port)->first->tuple;
+
+	/* Collect the fields referred to by the parts. */
+	size = mp_sizeof_array(key_def->part_count) +
+	       key_def->part_count * mp_sizeof_nil();
+	for (uint32_t i = 0; i < key_def->part_count; i++) {
+		const char *field = tuple_field_by_part(ret,
+							&key_def->parts[i]);
+		if (field != NULL) {
+			const char *field_end = field;
+			mp_next(&field_end);
+			size += field_end - field;
+		}
+	}
+	char *key_data = (char *)region_alloc(region, size);
+	if (key_data == NULL) {
+		diag_set(OutOfMemory, size, "region", "key");
+		goto out;
+	}
+	char *key_end = mp_encode_array(key_data, key_def->part_count);
+	const char *parts = key_end;
+	for (uint32_t i = 0; i < key_def->part_count; i++) {
+		const char *field = tuple_field_by_part(ret,
+							&key_def->parts[i]);
+		if (field == NULL) {
+			key_end = mp_encode_nil(key_end);
+			continue;
+		}
+		const char *field_end = field;
+		mp_next(&field_end);
+		memcpy(key_end, field, field_end - field);
+		key_end += field_end - field;
+	}
+	if (key_validate_parts(key_def, parts, key_def->part_count,
+			       true) != 0)
+		goto out;
+	key = tuple_new(tuple_format_runtime, key_data, key_end);
+	if (key != NULL)
+		tuple_ref(key);
+out:
+	port_destroy(&port);
+	region_truncate(region, region_svp);
+	return key;
+}
+
+/**
+ * Build the key of a tuple to store in an index entry. Return
+ * the key referenced once, or NULL with diag set.
+ */
+static struct tuple *
+memtx_tree_index_stored_key(struct memtx_tree_index *index,
+			    struct tuple *tuple)
+{
+	struct index_def *def = index->base.def;
+	if (def->opts.func_id != 0)
+		return memtx_tree_index_func_key(index, tuple);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t size;
+	const char *data = tuple_extract_key(tuple, def->key_def, &size);
+	struct tuple *key = NULL;
+	if (data != NULL) {
+		key = tuple_new(tuple_format_runtime, data, data + size);
+		if (key != NULL)
+			tuple_ref(key);
+	}
+	region_truncate(region, region_svp);
+	return key;
+}
+
+/**
+ * Replace a tuple in an index storing keys. The key of a tuple
+ * is built once, when the tuple is inserted, and stored in place
+ * of the comparison hint, so that lookups and comparisons never
+ * look into the tuple for it, nor call the function of a
+ * functional index.
+ */
+static int
+memtx_tree_index_replace_stored(struct memtx_tree_index *index,
+			      struct tuple *old_tuple,
+			      struct tuple *new_tuple,
+			      enum dup_replace_mode mode,
+			      struct tuple **result)
+{
+	struct index *base = &index->base;
+	/* Compute the keys first not to fail halfway. */
+	struct memtx_tree_data new_data, old_data;
+	new_data.tuple = new_tuple;
+	new_data.hint = 0;
+	old_data.tuple = old_tuple;
+	old_data.hint = 0;
+	if (new_tuple != NULL) {
+		struct tuple *key = memtx_tree_index_stored_key(index,
+								new_tuple);
+		if (key == NULL)
+			return -1;
+		new_data.hint = (hint_t)(uintptr_t)key;
+	}
+	if (old_tuple != NULL) {
+		struct tuple *key = memtx_tree_index_stored_key(index,
+								old_tuple);
+		if (key == NULL)
+			goto fail;
+		old_data.hint = (hint_t)(uintptr_t)key;
+	}
+	if (new_tuple != NULL) {
+		struct memtx_tree_data dup_data;
+		dup_data.tuple = NULL;
+		if (memtx_tree_insert(&index->tree, new_data, &dup_data) != 0) {
+			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
+				 "memtx_tree_index", "replace");
+			goto fail;
+		}
+		uint32_t errcode = replace_check_dup(old_tuple,
+						     dup_data.tuple, mode);
+		if (errcode) {
+			memtx_tree_delete(&index->tree, new_data);
+			if (dup_data.tuple != NULL)
+				memtx_tree_insert(&index->tree, dup_data, NULL);
+			struct space *sp = space_cache_find(base->def->space_id);
+			if (sp != NULL)
+				diag_set(ClientError, errcode, base->def->name,
+					 space_name(sp));
+			goto fail;
+		}
+		if (dup_data.tuple != NULL) {
+			/* The replaced element owned its key. */
+			tuple_unref((struct tuple *)(uintptr_t)dup_data.hint);
+			if (old_tuple != NULL)
+				tuple_unref((struct tuple *)(uintptr_t)
+					    old_data.hint);
+			*result = dup_data.tuple;
+			return 0;
+		}
+	}
+	if (old_tuple != NULL) {
+		bool exact = false;
+		struct memtx_tree_iterator it =
+			memtx_tree_lower_bound_elem(&index->tree, old_data,
+						    &exact);
+		struct memtx_tree_data *elem =
+			memtx_tree_iterator_get_elem(&index->tree, &it);
+		if (exact && elem->tuple == old_tuple) {
+			struct memtx_tree_data stored = *elem;
+			memtx_tree_delete(&index->tree, stored);
+			tuple_unref((struct tuple *)(uintptr_t)stored.hint);
+		}
+		tuple_unref((struct tuple *)(uintptr_t)old_data.hint);
+	}
+	*result = old_tuple;
 	return 0;
+fail:
+	if (new_tuple != NULL)
+		tuple_unref((struct tuple *)(uintptr_t)new_data.hint);
+	if (old_tuple != NULL && old_data.hint != 0)
+		tuple_unref((struct tuple *)(uintptr_t)old_data.hint);
+	return -1;
 }
 
 static int
@@ -443,12 +956,26 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 			 struct tuple **result)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
+	if (memtx_tree_index_def_stores_keys(base->def)) {
+		return memtx_tree_index_replace_stored(index, old_tuple,
+						     new_tuple, mode, result);
+	}
+	if (cmp_def->is_multikey) {
+		return memtx_tree_index_replace_multikey(index, old_tuple,
+							 new_tuple, mode,
+							 result);
+	}
 	if (new_tuple) {
-		struct tuple *dup_tuple = NULL;
+		struct memtx_tree_data new_data;
+		new_data.tuple = new_tuple;
+		new_data.hint = tuple_hint(new_tuple, cmp_def);
+		struct memtx_tree_data dup_data;
+		dup_data.tuple = NULL;
 
 		/* Try to optimistically replace the new_tuple. */
-		int tree_res = memtx_tree_insert(&index->tree,
-						 new_tuple, &dup_tuple);
+		int tree_res = memtx_tree_insert(&index->tree, new_data,
+						 &dup_data);
 		if (tree_res) {
 			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
 				 "memtx_tree_index", "replace");
@@ -456,29 +983,74 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 		}
 
 		uint32_t errcode = replace_check_dup(old_tuple,
-						     dup_tuple, mode);
+						     dup_data.tuple, mode);
 		if (errcode) {
-			memtx_tree_delete(&index->tree, new_tuple);
-			if (dup_tuple)
-				memtx_tree_insert(&index->tree, dup_tuple, 0);
+			memtx_tree_delete(&index->tree, new_data);
+			if (dup_data.tuple != NULL)
+				memtx_tree_insert(&index->tree, dup_data, NULL);
 			struct space *sp = space_cache_find(base->def->space_id);
 			if (sp != NULL)
 				diag_set(ClientError, errcode, base->def->name,
 					 space_name(sp));
 			return -1;
 		}
-		if (dup_tuple) {
-			*result = dup_tuple;
+		if (dup_data.tuple != NULL) {
+			*result = dup_data.tuple;
 			return 0;
 		}
 	}
 	if (old_tuple) {
-		memtx_tree_delete(&index->tree, old_tuple);
+		struct memtx_tree_data old_data;
+		old_data.tuple = old_tuple;
+		old_data.hint = tuple_hint(old_tuple, cmp_def);
+		memtx_tree_delete(&index->tree, old_data);
 	}
 	*result = old_tuple;
 	return 0;
 }
 
+static int
+memtx_tree_index_replace_in_place(struct index *base, struct tuple *old_tuple,
+				  struct tuple *new_tuple)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
+	if (memtx_tree_index_def_stores_keys(base->def))
+		return generic_index_replace_in_place(base, old_tuple,
+						      new_tuple);
+	/*
+	 * The new tuple entries replace the equal entries of the
+	 * old tuple on insertion, so unlike replace() we don't
+	 * need to look up the old entries to delete them.
+	 */
+	uint32_t count = cmp_def->is_multikey ?
+			 tuple_multikey_count(new_tuple, cmp_def) : 1;
+	for (uint32_t i = 0; i < count; i++) {
+		struct memtx_tree_data new_data;
+		new_data.tuple = new_tuple;
+		new_data.hint = cmp_def->is_multikey ? i :
+				tuple_hint(new_tuple, cmp_def);
+		struct memtx_tree_data replaced;
+		replaced.tuple = NULL;
+		if (memtx_tree_insert(&index->tree, new_data, &replaced) == 0) {
+			assert(replaced.tuple == old_tuple ||
+			       replaced.tuple == new_tuple);
+			continue;
+		}
+		/* Restore the old tuple entries replaced so far. */
+		while (i-- > 0) {
+			struct memtx_tree_data old_data;
+			old_data.tuple = old_tuple;
+			old_data.hint = i;
+			memtx_tree_insert(&index->tree, old_data, NULL);
+		}
+		diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
+			 "memtx_tree_index", "replace");
+		return -1;
+	}
+	return 0;
+}
+
 static struct iterator *
 memtx_tree_index_create_iterator(struct index *base, enum iterator_type type,
 				 const char *key, uint32_t part_count)
@@ -511,14 +1083,17 @@ memtx_tree_index_create_iterator(struct index *base, enum iterator_type type,
 	iterator_create(&it->base, base);
 	it->pool = &memtx->tree_iterator_pool;
 	it->base.next = tree_iterator_start;
+	it->base.skip = tree_iterator_skip;
 	it->base.free = tree_iterator_free;
 	it->type = type;
 	it->key_data.key = key;
 	it->key_data.part_count = part_count;
+	it->key_data.hint = key_hint(key, part_count,
+				     memtx_tree_index_cmp_def(index));
 	it->index_def = base->def;
 	it->tree = &index->tree;
 	it->tree_iterator = memtx_tree_invalid_iterator();
-	it->current_tuple = NULL;
+	it->current.tuple = NULL;
 	return (struct iterator *)it;
 }
 
@@ -536,8 +1111,9 @@ memtx_tree_index_reserve(struct index *base, uint32_t size_hint)
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
 	if (size_hint < index->build_array_alloc_size)
 		return 0;
-	struct tuple **tmp = (struct tuple **)realloc(index->build_array,
-						      size_hint * sizeof(*tmp));
+	struct memtx_tree_data *tmp =
+		(struct memtx_tree_data *)realloc(index->build_array,
+						  size_hint * sizeof(*tmp));
 	if (tmp == NULL) {
 		diag_set(OutOfMemory, size_hint * sizeof(*tmp),
 			 "memtx_tree_index", "reserve");
@@ -548,25 +1124,27 @@ memtx_tree_index_reserve(struct index *base, uint32_t size_hint)
 	return 0;
 }
 
+/** Append an element to the build array, growing it if needed. */
 static int
-memtx_tree_index_build_next(struct index *base, struct tuple *tuple)
+memtx_tree_index_build_array_append(struct memtx_tree_index *index,
+				    struct tuple *tuple, hint_t hint)
 {
-	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
 	if (index->build_array == NULL) {
-		index->build_array = (struct tuple **)malloc(MEMTX_EXTENT_SIZE);
+		index->build_array =
+			(struct memtx_tree_data *)malloc(MEMTX_EXTENT_SIZE);
 		if (index->build_array == NULL) {
 			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
 				 "memtx_tree_index", "build_next");
 			return -1;
 		}
 		index->build_array_alloc_size =
-			MEMTX_EXTENT_SIZE / sizeof(struct tuple*);
+			MEMTX_EXTENT_SIZE / sizeof(struct memtx_tree_data);
 	}
 	assert(index->build_array_size <= index->build_array_alloc_size);
 	if (index->build_array_size == index->build_array_alloc_size) {
 		index->build_array_alloc_size = index->build_array_alloc_size +
 					index->build_array_alloc_size / 2;
-		struct tuple **tmp = (struct tuple **)
+		struct memtx_tree_data *tmp = (struct memtx_tree_data *)
 			realloc(index->build_array,
 				index->build_array_alloc_size * sizeof(*tmp));
 		if (tmp == NULL) {
@@ -576,18 +1154,75 @@ memtx_tree_index_build_next(struct index *base, struct tuple *tuple)
 		}
 		index->build_array = tmp;
 	}
-	index->build_array[index->build_array_size++] = tuple;
+	index->build_array_is_sorted = false;
+	struct memtx_tree_data *elem =
+		&index->build_array[index->build_array_size++];
+	elem->tuple = tuple;
+	elem->hint = hint;
 	return 0;
 }
 
-static void
-memtx_tree_index_end_build(struct index *base)
+static int
+memtx_tree_index_build_next(struct index *base, struct tuple *tuple)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
+	if (memtx_tree_index_def_stores_keys(base->def)) {
+		struct tuple *key = memtx_tree_index_stored_key(index, tuple);
+		if (key == NULL)
+			return -1;
+		if (memtx_tree_index_build_array_append(index, tuple,
+				(hint_t)(uintptr_t)key) != 0) {
+			tuple_unref(key);
+			return -1;
+		}
+		return 0;
+	}
+	if (!cmp_def->is_multikey) {
+		return memtx_tree_index_build_array_append(index, tuple,
+						tuple_hint(tuple, cmp_def));
+	}
+	uint32_t count = tuple_multikey_count(tuple, cmp_def);
+	for (uint32_t i = 0; i < count; i++) {
+		if (memtx_tree_index_build_array_append(index, tuple, i) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+void
+memtx_tree_index_sort_build_array(struct memtx_tree_index *index)
+{
 	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
 	qsort_arg(index->build_array, index->build_array_size,
-		  sizeof(struct tuple *),
+		  sizeof(struct memtx_tree_data),
 		  memtx_tree_qcompare, cmp_def);
+	if (cmp_def->is_multikey && index->build_array_size > 1) {
+		/*
+		 * Leave one entry for elements of the same tuple
+		 * having equal keys, like replace() does.
+		 */
+		size_t w = 1;
+		for (size_t r = 1; r < index->build_array_size; r++) {
+			struct memtx_tree_data *prev =
+				&index->build_array[w - 1];
+			struct memtx_tree_data *cur = &index->build_array[r];
+			if (cur->tuple == prev->tuple &&
+			    memtx_tree_qcompare(cur, prev, cmp_def) == 0)
+				continue;
+			index->build_array[w++] = *cur;
+		}
+		index->build_array_size = w;
+	}
+	index->build_array_is_sorted = true;
+}
+
+static void
+memtx_tree_index_end_build(struct index *base)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	if (!index->build_array_is_sorted)
+		memtx_tree_index_sort_build_array(index);
 	memtx_tree_build(&index->tree, index->build_array,
 			 index->build_array_size);
 
@@ -595,12 +1230,17 @@ memtx_tree_index_end_build(struct index *base)
 	index->build_array = NULL;
 	index->build_array_size = 0;
 	index->build_array_alloc_size = 0;
+	index->build_array_is_sorted = false;
 }
 
 struct tree_snapshot_iterator {
 	struct snapshot_iterator base;
 	struct memtx_tree *tree;
 	struct memtx_tree_iterator tree_iterator;
+	/** First tuple past the scanned range or NULL. */
+	struct tuple *end;
+	/** Buffer for decompressed tuples. */
+	struct memtx_tuple_buf buf;
 };
 
 static void
@@ -611,6 +1251,7 @@ tree_snapshot_iterator_free(struct snapshot_iterator *iterator)
 		(struct tree_snapshot_iterator *)iterator;
 	struct memtx_tree *tree = (struct memtx_tree *)it->tree;
 	memtx_tree_iterator_destroy(tree, &it->tree_iterator);
+	memtx_tuple_buf_destroy(&it->buf);
 	free(iterator);
 }
 
@@ -620,12 +1261,12 @@ tree_snapshot_iterator_next(struct snapshot_iterator *iterator, uint32_t *size)
 	assert(iterator->free == tree_snapshot_iterator_free);
 	struct tree_snapshot_iterator *it =
 		(struct tree_snapshot_iterator *)iterator;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
-	if (res == NULL)
+	struct memtx_tree_data *res =
+		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	if (res == NULL || res->tuple == it->end)
 		return NULL;
 	memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	return tuple_data_range(*res, size);
+	return memtx_tuple_read(res->tuple, &it->buf, size);
 }
 
 /**
@@ -650,9 +1291,164 @@ memtx_tree_index_create_snapshot_iterator(struct index *base)
 	it->tree = &index->tree;
 	it->tree_iterator = memtx_tree_iterator_first(&index->tree);
 	memtx_tree_iterator_freeze(&index->tree, &it->tree_iterator);
+	memtx_tuple_buf_create(&it->buf);
 	return (struct snapshot_iterator *) it;
 }
 
+/** Position a tree iterator at the first element >= key. */
+static struct memtx_tree_iterator
+memtx_tree_index_lower_bound(struct memtx_tree_index *index,
+			     const char *key, uint32_t part_count)
+{
+	if (part_count == 0)
+		return memtx_tree_iterator_first(&index->tree);
+	struct memtx_tree_key_data key_data;
+	key_data.key = key;
+	key_data.part_count = part_count;
+	key_data.hint = key_hint(key, part_count,
+				 memtx_tree_index_cmp_def(index));
+	bool exact;
+	return memtx_tree_lower_bound(&index->tree, &key_data, &exact);
+}
+
+struct snapshot_iterator *
+memtx_tree_index_create_range_iterator(struct index *base,
+				       const char *begin, uint32_t begin_parts,
+				       const char *end, uint32_t end_parts)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	assert(!memtx_tree_index_cmp_def(index)->is_multikey);
+	assert(base->def->key_def->func_part_count == 0);
+	struct tree_snapshot_iterator *it = (struct tree_snapshot_iterator *)
+		calloc(1, sizeof(*it));
+	if (it == NULL) {
+		diag_set(OutOfMemory, sizeof(struct tree_snapshot_iterator),
+			 "memtx_tree_index", "create_range_iterator");
+		return NULL;
+	}
+	it->base.free = tree_snapshot_iterator_free;
+	it->base.next = tree_snapshot_iterator_next;
+	it->tree = &index->tree;
+	it->tree_iterator = memtx_tree_index_lower_bound(index, begin,
+							 begin_parts);
+	if (end != NULL) {
+		struct memtx_tree_iterator end_iterator =
+			memtx_tree_index_lower_bound(index, end, end_parts);
+		struct memtx_tree_data *res =
+			memtx_tree_iterator_get_elem(&index->tree,
+						     &end_iterator);
+		if (res != NULL)
+			it->end = res->tuple;
+	}
+	memtx_tree_iterator_freeze(&index->tree, &it->tree_iterator);
+	memtx_tuple_buf_create(&it->buf);
+	return (struct snapshot_iterator *) it;
+}
+
+/** Compare tree elements sampled to split an index. */
+static int
+memtx_tree_sample_cmp(const void *a, const void *b, void *arg)
+{
+	return memtx_tree_data_compare((const struct memtx_tree_data *)a,
+				       (const struct memtx_tree_data *)b,
+				       (struct key_def *)arg);
+}
+
+struct memtx_tree_range *
+memtx_tree_index_split(struct index *base, uint32_t count,
+		       uint32_t *range_count)
+{
+	assert(base->def->iid == 0);
+	assert(count > 0);
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+	struct memtx_tree *tree = &index->tree;
+	enum { SAMPLES_PER_RANGE = 8 };
+	/*
+	 * Range bounds are picked from random samples, which
+	 * are evenly spread in the index on average.
+	 */
+	uint32_t sample_count = 0;
+	struct memtx_tree_data *samples = NULL;
+	if (count > 1 && memtx_tree_size(tree) >= count) {
+		sample_count = (count - 1) * SAMPLES_PER_RANGE;
+		size_t size = sample_count * sizeof(*samples);
+		samples = (struct memtx_tree_data *)malloc(size);
+		if (samples == NULL) {
+			diag_set(OutOfMemory, size, "malloc", "samples");
+			return NULL;
+		}
+		for (uint32_t i = 0; i < sample_count; i++)
+			samples[i] = *memtx_tree_random(tree, rand());
+		qsort_arg(samples, sample_count, sizeof(*samples),
+			  memtx_tree_sample_cmp, tree->arg);
+	}
+	size_t size = count * sizeof(struct memtx_tree_range);
+	struct memtx_tree_range *ranges =
+		(struct memtx_tree_range *)malloc(size);
+	if (ranges == NULL) {
+		free(samples);
+		diag_set(OutOfMemory, size, "malloc", "ranges");
+		return NULL;
+	}
+	uint32_t n = 0;
+	ranges[n].tree = tree;
+	ranges[n].iterator = memtx_tree_iterator_first(tree);
+	for (uint32_t i = SAMPLES_PER_RANGE - 1; i < sample_count;
+	     i += SAMPLES_PER_RANGE) {
+		struct tuple *bound = samples[i].tuple;
+		if (n > 0 && ranges[n - 1].end == bound)
+			continue;
+		if (memtx_tree_iterator_get_elem(tree,
+				&ranges[n].iterator)->tuple == bound)
+			continue;
+		ranges[n].end = bound;
+		n++;
+		bool exact;
+		ranges[n].tree = tree;
+		ranges[n].iterator = memtx_tree_lower_bound_elem(tree,
+								 samples[i],
+								 &exact);
+		assert(exact);
+	}
+	ranges[n].end = NULL;
+	*range_count = n + 1;
+	free(samples);
+	for (uint32_t i = 0; i < *range_count; i++) {
+		memtx_tree_iterator_freeze(tree, &ranges[i].iterator);
+		memtx_tuple_buf_create(&ranges[i].buf);
+	}
+	memtx_engine_enter_delayed_free_mode(memtx);
+	memtx_engine_pause_gc(memtx);
+	return ranges;
+}
+
+const char *
+memtx_tree_range_next(struct memtx_tree_range *range, uint32_t *size)
+{
+	struct memtx_tree_data *res =
+		memtx_tree_iterator_get_elem(range->tree, &range->iterator);
+	if (res == NULL || res->tuple == range->end)
+		return NULL;
+	memtx_tree_iterator_next(range->tree, &range->iterator);
+	return memtx_tuple_read(res->tuple, &range->buf, size);
+}
+
+void
+memtx_tree_index_delete_ranges(struct index *base,
+			       struct memtx_tree_range *ranges,
+			       uint32_t range_count)
+{
+	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+	for (uint32_t i = 0; i < range_count; i++) {
+		memtx_tree_iterator_destroy(ranges[i].tree, &ranges[i].iterator);
+		memtx_tuple_buf_destroy(&ranges[i].buf);
+	}
+	free(ranges);
+	memtx_engine_resume_gc(memtx);
+	memtx_engine_leave_delayed_free_mode(memtx);
+}
+
 static const struct index_vtab memtx_tree_index_vtab = {
 	/* .destroy = */ memtx_tree_index_destroy,
 	/* .commit_create = */ generic_index_commit_create,
@@ -669,9 +1465,16 @@ static const struct index_vtab memtx_tree_index_vtab = {
 	/* .max = */ generic_index_max,
 	/* .random = */ memtx_tree_index_random,
 	/* .count = */ memtx_tree_index_count,
+	/* .estimate_count = */ generic_index_estimate_count,
 	/* .get = */ memtx_tree_index_get,
+	/* .get_batch = */ memtx_tree_index_get_batch,
 	/* .replace = */ memtx_tree_index_replace,
+	/* .replace_in_place = */ memtx_tree_index_replace_in_place,
 	/* .create_iterator = */ memtx_tree_index_create_iterator,
+	/* .create_covering_iterator = */
+		generic_index_create_covering_iterator,
+	/* .create_filtered_iterator = */
+		generic_index_create_filtered_iterator,
 	/* .create_snapshot_iterator = */
 		memtx_tree_index_create_snapshot_iterator,
 	/* .stat = */ generic_index_stat,
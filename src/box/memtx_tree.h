@@ -51,12 +51,44 @@ struct memtx_tree_key_data
 	const char *key;
 	/** Number of msgpacked search fields */
 	uint32_t part_count;
+	/** Comparison hint, see key_hint(). */
+	hint_t hint;
 };
 
+/**
+ * Struct that is used as an element in BPS tree definition.
+ */
+struct memtx_tree_data {
+	/** Tuple that this node represents. */
+	struct tuple *tuple;
+	/**
+	 * Comparison hint, see tuple_hint(). In a multikey
+	 * index it is the position of the indexed array element
+	 * in the tuple instead.
+	 */
+	hint_t hint;
+};
+
+/**
+ * Test whether BPS tree elements are identical i.e. represent
+ * the same tuple at the same position in the tree.
+ * @param a - First BPS tree element to compare.
+ * @param b - Second BPS tree element to compare.
+ * @retval true - When elements a and b are identical.
+ * @retval false - Otherwise.
+ */
+static inline bool
+memtx_tree_data_identical(const struct memtx_tree_data *a,
+			  const struct memtx_tree_data *b)
+{
+	return a->tuple == b->tuple && a->hint == b->hint;
+}
+
 /**
  * BPS tree element vs key comparator.
  * Defined in header in order to allow compiler to inline it.
- * @param tuple - tuple to compare.
+ * Unlike memtx_tree_data_compare_key() doesn't use the key hint.
+ * @param data - BPS tree element to compare.
  * @param key_data - key to compare with.
  * @param def - key definition.
  * @retval 0  if tuple == key in terms of def.
@@ -64,22 +96,53 @@ struct memtx_tree_key_data
  * @retval >0 if tuple > key in terms of def.
  */
 static inline int
-memtx_tree_compare_key(const struct tuple *tuple,
+memtx_tree_compare_key(const struct memtx_tree_data *data,
 		       const struct memtx_tree_key_data *key_data,
 		       struct key_def *def)
 {
-	return tuple_compare_with_key(tuple, key_data->key,
-				      key_data->part_count, def);
+	return tuple_compare_with_key_hinted(data->tuple, data->hint,
+					     key_data->key,
+					     key_data->part_count,
+					     HINT_NONE, def);
+}
+
+/**
+ * BPS tree element comparator. Uses comparison hints to avoid
+ * dereferencing tuples when possible.
+ */
+static inline int
+memtx_tree_data_compare(const struct memtx_tree_data *a,
+			const struct memtx_tree_data *b,
+			struct key_def *def)
+{
+	return tuple_compare_hinted(a->tuple, a->hint, b->tuple, b->hint, def);
+}
+
+/**
+ * BPS tree element vs key comparator. Uses comparison hints
+ * to avoid dereferencing the tuple when possible.
+ */
+static inline int
+memtx_tree_data_compare_key(const struct memtx_tree_data *data,
+			    const struct memtx_tree_key_data *key_data,
+			    struct key_def *def)
+{
+	return tuple_compare_with_key_hinted(data->tuple, data->hint,
+					     key_data->key,
+					     key_data->part_count,
+					     key_data->hint, def);
 }
 
 #define BPS_TREE_NAME memtx_tree
 #define BPS_TREE_BLOCK_SIZE (512)
 #define BPS_TREE_EXTENT_SIZE MEMTX_EXTENT_SIZE
-#define BPS_TREE_COMPARE(a, b, arg) tuple_compare(a, b, arg)
-#define BPS_TREE_COMPARE_KEY(a, b, arg) memtx_tree_compare_key(a, b, arg)
-#define bps_tree_elem_t struct tuple *
+#define BPS_TREE_COMPARE(a, b, arg) memtx_tree_data_compare(&(a), &(b), arg)
+#define BPS_TREE_COMPARE_KEY(a, b, arg) memtx_tree_data_compare_key(&(a), b, arg)
+#define bps_tree_elem_t struct memtx_tree_data
 #define bps_tree_key_t struct memtx_tree_key_data *
 #define bps_tree_arg_t struct key_def *
+/* Maintain subtree sizes for count() and select() offset. */
+#define BPS_INNER_CARD
 
 #include "salad/bps_tree.h"
 
@@ -91,12 +154,15 @@ memtx_tree_compare_key(const struct tuple *tuple,
 #undef bps_tree_elem_t
 #undef bps_tree_key_t
 #undef bps_tree_arg_t
+#undef BPS_INNER_CARD
 
 struct memtx_tree_index {
 	struct index base;
 	struct memtx_tree tree;
-	struct tuple **build_array;
+	struct memtx_tree_data *build_array;
 	size_t build_array_size, build_array_alloc_size;
+	/** Set if the build array has been sorted already. */
+	bool build_array_is_sorted;
 	struct memtx_gc_task gc_task;
 	struct memtx_tree_iterator gc_iterator;
 };
@@ -104,6 +170,78 @@ struct memtx_tree_index {
 struct memtx_tree_index *
 memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def);
 
+/**
+ * Sort tuples accumulated by index_build_next() so that
+ * index_end_build() only has to fill the tree. Touches nothing
+ * but the build array and the key definition, so it may be
+ * called from any thread as long as nobody else uses the index.
+ */
+void
+memtx_tree_index_sort_build_array(struct memtx_tree_index *index);
+
+/**
+ * Create a snapshot iterator over the tuples of a tree index
+ * with keys in [begin, end). A NULL end means the range is not
+ * bounded from above; a key with no parts matches the index
+ * start. Like a regular snapshot iterator, it sees the index as
+ * it is at the time of the call and must be freed with its
+ * free() method. Multikey and functional indexes aren't
+ * supported, because they may store a tuple more than once.
+ *
+ * Returns NULL and sets diag on memory error.
+ */
+struct snapshot_iterator *
+memtx_tree_index_create_range_iterator(struct index *index,
+				       const char *begin, uint32_t begin_parts,
+				       const char *end, uint32_t end_parts);
+
+/**
+ * A range of a frozen primary tree index. Ranges are scanned
+ * with memtx_tree_range_next(), which may be called from any
+ * thread, like a snapshot iterator.
+ */
+struct memtx_tree_range {
+	/** Tree the range belongs to. */
+	struct memtx_tree *tree;
+	/** Frozen iterator positioned at the next tuple. */
+	struct memtx_tree_iterator iterator;
+	/** First tuple past the range or NULL for the last one. */
+	struct tuple *end;
+	/** Buffer for decompressed tuples. */
+	struct memtx_tuple_buf buf;
+};
+
+/**
+ * Split a primary tree index into at most @a count adjacent
+ * ranges of roughly the same size. Together the ranges cover
+ * the whole index in the state it has at the time of the call:
+ * changes made after that aren't seen by them. Keeps the frozen
+ * tuples and the index itself in memory until the ranges are
+ * deleted with memtx_tree_index_delete_ranges().
+ *
+ * @param index Primary tree index.
+ * @param count Maximal number of ranges.
+ * @param[out] range_count Number of returned ranges.
+ *
+ * @retval Array of ranges or NULL on memory error.
+ */
+struct memtx_tree_range *
+memtx_tree_index_split(struct index *index, uint32_t count,
+		       uint32_t *range_count);
+
+/**
+ * Return the data of the next tuple of a range, or NULL if
+ * the range is over.
+ */
+const char *
+memtx_tree_range_next(struct memtx_tree_range *range, uint32_t *size);
+
+/** Delete ranges returned by memtx_tree_index_split(). */
+void
+memtx_tree_index_delete_ranges(struct index *index,
+			       struct memtx_tree_range *ranges,
+			       uint32_t range_count);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
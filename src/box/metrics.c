@@ -0,0 +1,385 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "metrics.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <small/ibuf.h>
+
+#include "trivia/util.h"
+#include "main.h"
+#include "diag.h"
+#include "info.h"
+#include "rmean.h"
+#include "box.h"
+#include "vclock.h"
+#include "engine.h"
+#include "memtx_engine.h"
+#include "vinyl.h"
+#include "wal.h"
+#include "iproto.h"
+#include "schema.h"
+#include "space.h"
+#include "index.h"
+
+extern struct rmean *rmean_box;
+extern struct rmean *rmean_error;
+
+enum {
+	/** Max length of a metric name. */
+	METRICS_NAME_MAX = 256,
+	/** Max length of rendered labels. */
+	METRICS_LABELS_MAX = 512,
+	/** Max nesting of info tables. */
+	METRICS_DEPTH_MAX = 16,
+};
+
+/**
+ * An info handler that renders values as metrics instead of
+ * building tables. Tables nest into the metric name.
+ */
+struct metrics_writer {
+	struct info_handler handler;
+	struct ibuf *buf;
+	/** Name of the current table, e.g. "tnt_vinyl_memory". */
+	char name[METRICS_NAME_MAX];
+	int name_len;
+	/** Lengths of the name of outer tables. */
+	int name_stack[METRICS_DEPTH_MAX];
+	int depth;
+	/** Labels of values, e.g. {space="test"}, or empty. */
+	char labels[METRICS_LABELS_MAX];
+	/** Set if the buffer failed to grow. */
+	bool is_oom;
+};
+
+static void
+metrics_printf(struct metrics_writer *w, const char *format, ...)
+{
+	if (w->is_oom)
+		return;
+	va_list ap;
+	va_start(ap, format);
+	int len = vsnprintf(NULL, 0, format, ap);
+	va_end(ap);
+	char *data = ibuf_reserve(w->buf, len + 1);
+	if (data == NULL) {
+		w->is_oom = true;
+		return;
+	}
+	va_start(ap, format);
+	vsnprintf(data, len + 1, format, ap);
+	va_end(ap);
+	ibuf_alloc(w->buf, len);
+}
+
+/**
+ * Append a key to the metric name. Characters not allowed in
+ * metric names are replaced with '_'. Returns the length of
+ * the name before the key.
+ */
+static int
+metrics_name_push(struct metrics_writer *w, const char *key)
+{
+	int len = w->name_len;
+	if (key == NULL)
+		return len;
+	char *name = w->name;
+	int i = w->name_len;
+	if (i > 0 && i < METRICS_NAME_MAX - 1)
+		name[i++] = '_';
+	for (const char *c = key; *c != '\0' && i < METRICS_NAME_MAX - 1;
+	     c++)
+		name[i++] = isalnum((unsigned char)*c) ?
+			    tolower((unsigned char)*c) : '_';
+	name[i] = '\0';
+	w->name_len = i;
+	return len;
+}
+
+static void
+metrics_name_pop(struct metrics_writer *w, int len)
+{
+	w->name_len = len;
+	w->name[len] = '\0';
+}
+
+/** Start a new section of metrics named @a name. */
+static void
+metrics_name_set(struct metrics_writer *w, const char *name)
+{
+	metrics_name_pop(w, 0);
+	w->depth = 0;
+	metrics_name_push(w, name);
+}
+
+static void
+metrics_int(struct metrics_writer *w, const char *key, int64_t value)
+{
+	int len = metrics_name_push(w, key);
+	metrics_printf(w, "%s%s %lld\n", w->name, w->labels,
+		       (long long)value);
+	metrics_name_pop(w, len);
+}
+
+static void
+metrics_double(struct metrics_writer *w, const char *key, double value)
+{
+	int len = metrics_name_push(w, key);
+	metrics_printf(w, "%s%s %.15g\n", w->name, w->labels, value);
+	metrics_name_pop(w, len);
+}
+
+/** Append a label value, escaped as the text format requires. */
+static int
+metrics_label_escape(char *buf, int size, const char *value)
+{
+	int i = 0;
+	for (const char *c = value; *c != '\0' && i < size - 2; c++) {
+		if (*c == '\\' || *c == '"') {
+			buf[i++] = '\\';
+			buf[i++] = *c;
+		} else if (*c == '\n') {
+			buf[i++] = '\\';
+			buf[i++] = 'n';
+		} else {
+			buf[i++] = *c;
+		}
+	}
+	buf[i] = '\0';
+	return i;
+}
+
+/** Label values with the names of a space and, if set, an index. */
+static void
+metrics_labels_set(struct metrics_writer *w, const char *space,
+		   const char *index)
+{
+	char *buf = w->labels;
+	int size = sizeof(w->labels);
+	char value[METRICS_NAME_MAX];
+	metrics_label_escape(value, sizeof(value), space);
+	int len = snprintf(buf, size, "{space=\"%s\"", value);
+	if (index != NULL && len < size) {
+		metrics_label_escape(value, sizeof(value), index);
+		len += snprintf(buf + len, size - len, ",index=\"%s\"", value);
+	}
+	if (len < size)
+		snprintf(buf + len, size - len, "}");
+}
+
+/* {{{ Info handler */
+
+static void
+metrics_info_begin(struct info_handler *h)
+{
+	(void)h;
+}
+
+static void
+metrics_info_end(struct info_handler *h)
+{
+	(void)h;
+}
+
+static void
+metrics_info_begin_table(struct info_handler *h, const char *key)
+{
+	struct metrics_writer *w = (struct metrics_writer *)h->ctx;
+	assert(w->depth < METRICS_DEPTH_MAX);
+	w->name_stack[w->depth++] = metrics_name_push(w, key);
+}
+
+static void
+metrics_info_end_table(struct info_handler *h)
+{
+	struct metrics_writer *w = (struct metrics_writer *)h->ctx;
+	assert(w->depth > 0);
+	metrics_name_pop(w, w->name_stack[--w->depth]);
+}
+
+static void
+metrics_info_append_str(struct info_handler *h, const char *key,
+			const char *value)
+{
+	/* Only numbers make metrics. */
+	(void)h;
+	(void)key;
+	(void)value;
+}
+
+static void
+metrics_info_append_int(struct info_handler *h, const char *key,
+			int64_t value)
+{
+	metrics_int((struct metrics_writer *)h->ctx, key, value);
+}
+
+static void
+metrics_info_append_double(struct info_handler *h, const char *key,
+			   double value)
+{
+	metrics_double((struct metrics_writer *)h->ctx, key, value);
+}
+
+static struct info_handler_vtab metrics_info_vtab = {
+	.begin = metrics_info_begin,
+	.end = metrics_info_end,
+	.begin_table = metrics_info_begin_table,
+	.end_table = metrics_info_end_table,
+	.append_str = metrics_info_append_str,
+	.append_int = metrics_info_append_int,
+	.append_double = metrics_info_append_double,
+};
+
+/* }}} */
+
+static void
+metrics_info(struct metrics_writer *w)
+{
+	metrics_name_set(w, "tnt_info");
+	metrics_double(w, "uptime", tarantool_uptime());
+	metrics_int(w, "ro", box_is_ro());
+	metrics_int(w, "signature", vclock_sum(box_vclock));
+	struct vclock_iterator it;
+	vclock_iterator_init(&it, box_vclock);
+	vclock_foreach(&it, replica) {
+		snprintf(w->labels, sizeof(w->labels), "{id=\"%u\"}",
+			 (unsigned)replica.id);
+		metrics_int(w, "vclock", replica.lsn);
+	}
+	w->labels[0] = '\0';
+
+	struct engine_memory_stat stat;
+	engine_memory_stat(&stat);
+	metrics_name_set(w, "tnt_info_memory");
+	metrics_int(w, "data", stat.data);
+	metrics_int(w, "index", stat.index);
+	metrics_int(w, "cache", stat.cache);
+	metrics_int(w, "tx", stat.tx);
+	metrics_int(w, "delayed_free", stat.delayed_free);
+	metrics_int(w, "net", iproto_mem_used());
+}
+
+static int
+metrics_rmean_cb(const char *name, int rps, int64_t total, void *cb_ctx)
+{
+	struct metrics_writer *w = (struct metrics_writer *)cb_ctx;
+	int len = metrics_name_push(w, name);
+	metrics_int(w, "rps", rps);
+	metrics_int(w, "total", total);
+	metrics_name_pop(w, len);
+	return 0;
+}
+
+static int
+metrics_small_stats_cb(const struct mempool_stats *stats, void *cb_ctx)
+{
+	(void)stats;
+	(void)cb_ctx;
+	return 0;
+}
+
+static void
+metrics_slab(struct metrics_writer *w)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	struct small_stats totals;
+	small_stats(&memtx->alloc, &totals, metrics_small_stats_cb, NULL);
+	struct mempool_stats index_stats;
+	mempool_stats(&memtx->index_extent_pool, &index_stats);
+	metrics_name_set(w, "tnt_slab");
+	metrics_int(w, "items_size", totals.total);
+	metrics_int(w, "items_used", totals.used);
+	metrics_int(w, "arena_size", memtx->arena.used);
+	metrics_int(w, "arena_used", totals.used + index_stats.totals.used);
+	metrics_int(w, "quota_size", quota_total(&memtx->quota));
+	metrics_int(w, "quota_used", quota_used(&memtx->quota));
+}
+
+static int
+metrics_space_cb(struct space *space, void *udata)
+{
+	struct metrics_writer *w = (struct metrics_writer *)udata;
+	if (space_id(space) <= BOX_SYSTEM_ID_MAX)
+		return 0;
+	metrics_labels_set(w, space_name(space), NULL);
+	metrics_name_set(w, "tnt_space");
+	if (box_space_stat(space_id(space), &w->handler) != 0)
+		return -1;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct index *index = space->index[i];
+		metrics_labels_set(w, space_name(space), index->def->name);
+		metrics_name_set(w, "tnt_index");
+		index_stat(index, &w->handler);
+	}
+	return 0;
+}
+
+int
+box_metrics_prometheus(struct ibuf *buf)
+{
+	struct metrics_writer w;
+	w.handler.vtab = &metrics_info_vtab;
+	w.handler.ctx = &w;
+	w.buf = buf;
+	w.name_len = 0;
+	w.name[0] = '\0';
+	w.depth = 0;
+	w.labels[0] = '\0';
+	w.is_oom = false;
+
+	metrics_info(&w);
+	metrics_name_set(&w, "tnt_stats_op");
+	rmean_foreach(rmean_box, metrics_rmean_cb, &w);
+	rmean_foreach(rmean_error, metrics_rmean_cb, &w);
+	metrics_name_set(&w, "tnt_stats_net");
+	iproto_rmean_foreach(metrics_rmean_cb, &w);
+	metrics_slab(&w);
+	metrics_name_set(&w, "tnt_vinyl");
+	vinyl_engine_stat((struct vinyl_engine *)engine_by_name("vinyl"),
+			  &w.handler);
+	metrics_name_set(&w, "tnt_wal");
+	wal_stat(&w.handler);
+	metrics_name_set(&w, "tnt_latency");
+	iproto_latency_stat(&w.handler);
+	if (space_foreach(metrics_space_cb, &w) != 0)
+		return -1;
+	if (w.is_oom) {
+		diag_set(OutOfMemory, ibuf_used(buf), "ibuf", "metrics");
+		return -1;
+	}
+	return 0;
+}
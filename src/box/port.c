@@ -44,6 +44,9 @@ port_tuple_add(struct port *base, struct tuple *tuple)
 {
 	struct port_tuple *port = port_tuple(base);
 	struct port_tuple_entry *e;
+	tuple = tuple_unpack(tuple);
+	if (tuple == NULL)
+		return -1;
 	if (port->size == 0) {
 		tuple_ref(tuple);
 		e = &port->first_entry;
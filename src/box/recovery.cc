@@ -35,6 +35,7 @@
 #include "trigger.h"
 #include "fiber.h"
 #include "xlog.h"
+#include "xlog_reader.h"
 #include "xrow.h"
 #include "xstream.h"
 #include "wal.h" /* wal_watcher */
@@ -200,6 +201,11 @@ out:
 	 */
 	if (vclock_compare(&r->vclock, vclock) < 0)
 		vclock_copy(&r->vclock, vclock);
+	/*
+	 * Rows up to the recovery clock are skipped anyway,
+	 * so don't read them if possible.
+	 */
+	xlog_cursor_seek(&r->cursor, &r->vclock);
 	return;
 
 gap_error:
@@ -229,6 +235,47 @@ recovery_delete(struct recovery *r)
 	free(r);
 }
 
+/**
+ * Apply a row read from the current WAL unless it has already
+ * been applied. Returns -1 if the row failed to apply and
+ * force_recovery isn't set, in which case the error is in diag.
+ */
+static int
+recover_row(struct recovery *r, struct xstream *stream,
+	    struct xrow_header *row, uint64_t *row_count)
+{
+	int64_t current_lsn = vclock_get(&r->vclock, row->replica_id);
+	if (row->lsn <= current_lsn)
+		return 0; /* already applied, skip */
+
+	/*
+	 * All rows in xlog files have an assigned
+	 * replica id.
+	 */
+	assert(row->replica_id != 0);
+	/*
+	 * We can promote the vclock either before or
+	 * after xstream_write(): it only makes any impact
+	 * in case of forced recovery, when we skip the
+	 * failed row anyway.
+	 */
+	vclock_follow_xrow(&r->vclock, row);
+	if (xstream_write(stream, row) == 0) {
+		++*row_count;
+		if (*row_count % 100000 == 0)
+			say_info("%.1fM rows processed",
+				 *row_count / 1000000.);
+	} else {
+		if (!r->wal_dir.force_recovery)
+			return -1;
+
+		say_error("skipping row {%u: %lld}",
+			  (unsigned)row->replica_id, (long long)row->lsn);
+		diag_log();
+	}
+	return 0;
+}
+
 /**
  * Read all rows in a file starting from the last position.
  * Advance the position. If end of file is reached,
@@ -255,36 +302,46 @@ recover_xlog(struct recovery *r, struct xstream *stream,
 		if (stop_vclock != NULL &&
 		    r->vclock.signature >= stop_vclock->signature)
 			return;
-		int64_t current_lsn = vclock_get(&r->vclock, row.replica_id);
-		if (row.lsn <= current_lsn)
-			continue; /* already applied, skip */
+		if (recover_row(r, stream, &row, &row_count) != 0)
+			diag_raise();
+	}
+}
 
-		/*
-		 * All rows in xlog files have an assigned
-		 * replica id.
-		 */
-		assert(row.replica_id != 0);
-		/*
-		 * We can promote the vclock either before or
-		 * after xstream_write(): it only makes any impact
-		 * in case of forced recovery, when we skip the
-		 * failed row anyway.
-		 */
-		vclock_follow_xrow(&r->vclock, &row);
-		if (xstream_write(stream, &row) == 0) {
-			++row_count;
-			if (row_count % 100000 == 0)
-				say_info("%.1fM rows processed",
-					 row_count / 1000000.);
-		} else {
-			if (!r->wal_dir.force_recovery)
-				diag_raise();
-
-			say_error("skipping row {%u: %lld}",
-				  (unsigned)row.replica_id, (long long)row.lsn);
-			diag_log();
+/**
+ * Read all rows of the current WAL, which was just opened,
+ * in a separate thread, see xlog_reader_new(), and apply them
+ * as they arrive. Only WALs that aren't written to anymore
+ * are read this way, since the rows are read ahead of the
+ * current WAL cursor, which isn't advanced.
+ */
+static void
+recover_xlog_pipelined(struct recovery *r, struct xstream *stream)
+{
+	struct xlog_reader *reader = xlog_reader_new(r->cursor.name,
+						     r->wal_dir.force_recovery);
+	if (reader == NULL)
+		diag_raise();
+	int rc;
+	struct xrow_header *row;
+	uint64_t row_count = 0;
+	while ((rc = xlog_reader_next(reader, &row)) == 0) {
+		if (recover_row(r, stream, row, &row_count) != 0) {
+			rc = -1;
+			break;
 		}
 	}
+	bool has_eof_marker = xlog_reader_has_eof_marker(reader);
+	xlog_reader_delete(reader);
+	if (rc < 0)
+		diag_raise();
+	/*
+	 * The file has been read up by the reader, so mark
+	 * the current WAL cursor as such. Otherwise leave it
+	 * open at the start as if reading had stopped at
+	 * a broken tail.
+	 */
+	if (has_eof_marker)
+		r->cursor.state = XLOG_CURSOR_EOF;
 }
 
 /**
@@ -343,6 +400,18 @@ recover_remaining_wals(struct recovery *r, struct xstream *stream,
 
 		say_info("recover from `%s'", r->cursor.name);
 
+		/*
+		 * A WAL followed by another one is complete, so
+		 * it can be read ahead in a separate thread while
+		 * tx is busy applying rows. The reader hands rows
+		 * to tx over cbus, hence tx only.
+		 */
+		if (stop_vclock == NULL && cord_is_main() &&
+		    vclockset_next(&r->wal_dir.index, clock) != NULL) {
+			recover_xlog_pipelined(r, stream);
+			continue;
+		}
+
 recover_current_wal:
 		recover_xlog(r, stream, stop_vclock);
 	}
@@ -356,6 +425,22 @@ recover_current_wal:
 	region_free(&fiber()->gc);
 }
 
+void
+recovery_forget_log(struct recovery *r)
+{
+	if (xlog_cursor_is_open(&r->cursor)) {
+		xlog_cursor_close(&r->cursor, false);
+		trigger_run_xc(&r->on_close_log, NULL);
+	}
+	/*
+	 * The rows following the recovery vclock may be in any
+	 * file now, so look it up by the vclock next time like
+	 * on the first scan, without checking for gaps against
+	 * the file we've just closed.
+	 */
+	r->cursor.state = XLOG_CURSOR_NEW;
+}
+
 void
 recovery_finalize(struct recovery *r)
 {
@@ -107,4 +107,14 @@ void
 recover_remaining_wals(struct recovery *r, struct xstream *stream,
 		       const struct vclock *stop_vclock, bool scan_dir);
 
+/**
+ * Close the current WAL, if any, without reading it up.
+ * Used when the rows are received from elsewhere and the
+ * recovery vclock is advanced by the caller. The next call
+ * to recover_remaining_wals() will resume from the file
+ * containing the rows following the recovery vclock.
+ */
+void
+recovery_forget_log(struct recovery *r);
+
 #endif /* TARANTOOL_RECOVERY_H_INCLUDED */
@@ -46,6 +46,7 @@
 #include "iproto_constants.h"
 #include "recovery.h"
 #include "replication.h"
+#include "synchro.h"
 #include "trigger.h"
 #include "vclock.h"
 #include "version.h"
@@ -53,6 +54,10 @@
 #include "xrow_io.h"
 #include "xstream.h"
 #include "wal.h"
+#include "wal_ring.h"
+
+#include <msgpuck.h>
+#include <zstd.h>
 
 /**
  * Cbus message to send status updates from relay to tx thread.
@@ -64,6 +69,12 @@ struct relay_status_msg {
 	struct relay *relay;
 	/** Replica vclock. */
 	struct vclock vclock;
+	/** Bytes saved by compression so far. */
+	uint64_t bytes_saved;
+	/** Rows sent so far. */
+	uint64_t rows_sent;
+	/** Socket writes made so far. */
+	uint64_t write_count;
 };
 
 /**
@@ -83,6 +94,53 @@ struct relay_gc_msg {
 	struct vclock vclock;
 };
 
+/**
+ * A buffer for batching rows. Unlike ibuf, it is allocated
+ * with malloc() rather than from a cord's slab cache, so it
+ * may be filled in any thread: memtx sends rows of initial
+ * join from a thread reading the snapshot.
+ */
+struct relay_buf {
+	char *data;
+	size_t used;
+	size_t capacity;
+};
+
+static inline void
+relay_buf_create(struct relay_buf *buf)
+{
+	buf->data = NULL;
+	buf->used = 0;
+	buf->capacity = 0;
+}
+
+static inline void
+relay_buf_destroy(struct relay_buf *buf)
+{
+	free(buf->data);
+	relay_buf_create(buf);
+}
+
+/**
+ * Make sure there are at least @a size bytes available past
+ * the used part of the buffer and return a pointer to them.
+ */
+static char *
+relay_buf_reserve(struct relay_buf *buf, size_t size)
+{
+	if (buf->used + size <= buf->capacity)
+		return buf->data + buf->used;
+	size_t capacity = MAX(buf->capacity, (size_t)16 * 1024);
+	while (capacity < buf->used + size)
+		capacity *= 2;
+	char *data = (char *)realloc(buf->data, capacity);
+	if (data == NULL)
+		tnt_raise(OutOfMemory, capacity, "realloc", "relay batch");
+	buf->data = data;
+	buf->capacity = capacity;
+	return buf->data + buf->used;
+}
+
 /** State of a replication relay. */
 struct relay {
 	/** The thread in which we relay data to the replica. */
@@ -99,6 +157,17 @@ struct relay {
 	struct vclock stop_vclock;
 	/** Remote replica */
 	struct replica *replica;
+	/**
+	 * Filter of a change data capture subscription, NULL
+	 * unless the relay feeds a CDC consumer.
+	 */
+	const struct cdc_filter *cdc_filter;
+	/**
+	 * Garbage collector consumer of a peer which isn't
+	 * registered in _cluster: an anonymous replica or
+	 * a CDC consumer.
+	 */
+	struct gc_consumer *anon_gc;
 	/** WAL event watcher. */
 	struct wal_watcher wal_watcher;
 	/** Relay reader cond. */
@@ -132,12 +201,53 @@ struct relay {
 	double last_row_tm;
 	/** Relay sync state. */
 	enum relay_state state;
+	/**
+	 * Set if the relay sends rows from the WAL ring rather
+	 * than from files, see relay_send_from_ring().
+	 */
+	bool is_in_ring;
+	/** Position of the relay in the WAL ring. */
+	struct wal_ring_cursor ring_cursor;
+	/** Buffer for rows copied from the WAL ring. */
+	struct ibuf ring_buf;
+	/**
+	 * Set if rows are accumulated in a batch and written to
+	 * the socket at once rather than one by one, see
+	 * relay_flush().
+	 */
+	bool use_batch;
+	/**
+	 * Set if the replica asked to compress rows. Batches
+	 * are then sent in zstd frames.
+	 */
+	bool compress;
+	/** Encoded rows waiting to be sent. */
+	struct relay_buf batch;
+	/** Buffer for the compressed batch. */
+	struct relay_buf zbuf;
+	/** zstd compression context. */
+	ZSTD_CCtx *zctx;
+	/** Number of bytes saved by compression. */
+	uint64_t bytes_saved;
+	/** Number of rows sent to the peer. */
+	uint64_t rows_sent;
+	/**
+	 * Number of socket writes made to send the rows. The
+	 * ratio to rows_sent shows how well rows are batched.
+	 */
+	uint64_t write_count;
 
 	struct {
 		/* Align to prevent false-sharing with tx thread */
 		alignas(CACHELINE_SIZE)
 		/** Known relay vclock. */
 		struct vclock vclock;
+		/** Known number of bytes saved by compression. */
+		uint64_t bytes_saved;
+		/** Known number of rows sent. */
+		uint64_t rows_sent;
+		/** Known number of socket writes. */
+		uint64_t write_count;
 	} tx;
 };
 
@@ -159,9 +269,35 @@ relay_vclock(const struct relay *relay)
 	return &relay->tx.vclock;
 }
 
+bool
+relay_is_compressed(const struct relay *relay)
+{
+	return relay->compress;
+}
+
+uint64_t
+relay_bytes_saved(const struct relay *relay)
+{
+	return relay->tx.bytes_saved;
+}
+
+uint64_t
+relay_rows_sent(const struct relay *relay)
+{
+	return relay->tx.rows_sent;
+}
+
+uint64_t
+relay_write_count(const struct relay *relay)
+{
+	return relay->tx.write_count;
+}
+
 static void
 relay_send(struct relay *relay, struct xrow_header *packet);
 static void
+relay_flush(struct relay *relay);
+static void
 relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row);
 static void
 relay_send_row(struct xstream *stream, struct xrow_header *row);
@@ -184,7 +320,7 @@ relay_new(struct replica *replica)
 }
 
 static void
-relay_start(struct relay *relay, int fd, uint64_t sync,
+relay_start(struct relay *relay, int fd, uint64_t sync, bool compress,
 	     void (*stream_write)(struct xstream *, struct xrow_header *))
 {
 	xstream_create(&relay->stream, stream_write);
@@ -196,9 +332,49 @@ relay_start(struct relay *relay, int fd, uint64_t sync,
 	diag_clear(&relay->diag);
 	coio_create(&relay->io, fd);
 	relay->sync = sync;
+	relay->compress = compress;
+	/*
+	 * Always batch rows: the batch is flushed with a single
+	 * write after each WAL event, which saves a syscall per
+	 * row when the replica keeps up with the master.
+	 */
+	relay->use_batch = true;
 	relay->state = RELAY_FOLLOW;
 }
 
+/**
+ * Prepare the relay for batching rows. If the compression
+ * context can't be created, the relay sends plain rows.
+ */
+static void
+relay_create_batch(struct relay *relay)
+{
+	if (!relay->use_batch)
+		return;
+	if (relay->compress) {
+		relay->zctx = ZSTD_createCCtx();
+		if (relay->zctx == NULL) {
+			say_warn("failed to create compression context, "
+				 "sending uncompressed rows");
+			relay->compress = false;
+		}
+	}
+	relay_buf_create(&relay->batch);
+	relay_buf_create(&relay->zbuf);
+}
+
+static void
+relay_destroy_batch(struct relay *relay)
+{
+	if (!relay->use_batch)
+		return;
+	relay_buf_destroy(&relay->batch);
+	relay_buf_destroy(&relay->zbuf);
+	if (relay->zctx != NULL)
+		ZSTD_freeCCtx(relay->zctx);
+	relay->zctx = NULL;
+}
+
 void
 relay_cancel(struct relay *relay)
 {
@@ -262,42 +438,57 @@ relay_delete(struct relay *relay)
 	free(relay);
 }
 
+/** Format the address of the peer connected to @a fd. */
 static void
-relay_set_cord_name(int fd)
+relay_get_peer_name(int fd, char *name, size_t size)
 {
-	char name[FIBER_NAME_MAX];
 	struct sockaddr_storage peer;
 	socklen_t addrlen = sizeof(peer);
 	if (getpeername(fd, ((struct sockaddr*)&peer), &addrlen) == 0) {
-		snprintf(name, sizeof(name), "relay/%s",
+		snprintf(name, size, "%s",
 			 sio_strfaddr((struct sockaddr *)&peer, addrlen));
 	} else {
-		snprintf(name, sizeof(name), "relay/<unknown>");
+		snprintf(name, size, "<unknown>");
 	}
-	cord_set_name(name);
+}
+
+static void
+relay_set_cord_name(int fd)
+{
+	char peer[FIBER_NAME_MAX];
+	relay_get_peer_name(fd, peer, sizeof(peer));
+	cord_set_name(tt_sprintf("relay/%s", peer));
 }
 
 void
-relay_initial_join(int fd, uint64_t sync, struct vclock *vclock)
+relay_initial_join(int fd, uint64_t sync, struct vclock *vclock,
+		   bool compress)
 {
 	struct relay *relay = relay_new(NULL);
 	if (relay == NULL)
 		diag_raise();
 
-	relay_start(relay, fd, sync, relay_send_initial_join_row);
+	relay_start(relay, fd, sync, compress, relay_send_initial_join_row);
+	relay_create_batch(relay);
 	auto relay_guard = make_scoped_guard([=] {
+		relay_destroy_batch(relay);
 		relay_stop(relay);
 		relay_delete(relay);
 	});
 
 	engine_join_xc(vclock, &relay->stream);
+	relay_flush(relay);
 }
 
 int
 relay_final_join_f(va_list ap)
 {
 	struct relay *relay = va_arg(ap, struct relay *);
-	auto guard = make_scoped_guard([=] { relay_exit(relay); });
+	relay_create_batch(relay);
+	auto guard = make_scoped_guard([=] {
+		relay_destroy_batch(relay);
+		relay_exit(relay);
+	});
 
 	coio_enable();
 	relay_set_cord_name(relay->io.fd);
@@ -306,19 +497,20 @@ relay_final_join_f(va_list ap)
 	assert(relay->stream.write != NULL);
 	recover_remaining_wals(relay->r, &relay->stream,
 			       &relay->stop_vclock, true);
+	relay_flush(relay);
 	assert(vclock_compare(&relay->r->vclock, &relay->stop_vclock) == 0);
 	return 0;
 }
 
 void
 relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
-		 struct vclock *stop_vclock)
+		 struct vclock *stop_vclock, bool compress)
 {
 	struct relay *relay = relay_new(NULL);
 	if (relay == NULL)
 		diag_raise();
 
-	relay_start(relay, fd, sync, relay_send_row);
+	relay_start(relay, fd, sync, compress, relay_send_row);
 	auto relay_guard = make_scoped_guard([=] {
 		relay_stop(relay);
 		relay_delete(relay);
@@ -362,6 +554,11 @@ tx_status_update(struct cmsg *msg)
 {
 	struct relay_status_msg *status = (struct relay_status_msg *)msg;
 	vclock_copy(&status->relay->tx.vclock, &status->vclock);
+	status->relay->tx.bytes_saved = status->bytes_saved;
+	status->relay->tx.rows_sent = status->rows_sent;
+	status->relay->tx.write_count = status->write_count;
+	/* The replica may have confirmed synchronous transactions. */
+	synchro_update();
 	static const struct cmsg_hop route[] = {
 		{relay_status_update, NULL}
 	};
@@ -376,17 +573,23 @@ static void
 tx_gc_advance(struct cmsg *msg)
 {
 	struct relay_gc_msg *m = (struct relay_gc_msg *)msg;
-	gc_consumer_advance(m->relay->replica->gc, &m->vclock);
+	struct relay *relay = m->relay;
+	gc_consumer_advance(relay->replica != NULL ? relay->replica->gc :
+			    relay->anon_gc, &m->vclock);
 	free(m);
 }
 
+/**
+ * Queue a garbage collection request for the rows sent so far.
+ * It is invoked once the replica confirms it has received them,
+ * see relay_schedule_pending_gc().
+ */
 static void
-relay_on_close_log_f(struct trigger *trigger, void * /* event */)
+relay_add_pending_gc(struct relay *relay)
 {
 	static const struct cmsg_hop route[] = {
 		{tx_gc_advance, NULL}
 	};
-	struct relay *relay = (struct relay *)trigger->data;
 	struct relay_gc_msg *m = (struct relay_gc_msg *)malloc(sizeof(*m));
 	if (m == NULL) {
 		say_warn("failed to allocate relay gc message");
@@ -403,6 +606,12 @@ relay_on_close_log_f(struct trigger *trigger, void * /* event */)
 	stailq_add_tail_entry(&relay->pending_gc, m, in_pending);
 }
 
+static void
+relay_on_close_log_f(struct trigger *trigger, void * /* event */)
+{
+	relay_add_pending_gc((struct relay *)trigger->data);
+}
+
 /**
  * Invoke pending garbage collection requests.
  *
@@ -434,6 +643,61 @@ relay_set_error(struct relay *relay, struct error *e)
 		diag_add_error(&relay->diag, e);
 }
 
+/**
+ * Send rows written since the last WAL event from the WAL ring.
+ * Return false if the ring is disabled or the relay lags behind
+ * it, in which case the rows have to be read from files.
+ */
+static bool
+relay_send_from_ring(struct relay *relay, unsigned events)
+{
+	struct wal_ring *ring = wal_get_ring();
+	struct recovery *r = relay->r;
+	if (ring == NULL)
+		return false;
+	if (!relay->is_in_ring) {
+		if (wal_ring_cursor_create(ring, &relay->ring_cursor,
+					   &r->vclock) != 0)
+			return false;
+		/*
+		 * The replica has got all rows evicted from
+		 * the ring, so the current file isn't needed
+		 * anymore. Closing it lets it be collected.
+		 */
+		recovery_forget_log(r);
+		relay->is_in_ring = true;
+	}
+	ibuf_reset(&relay->ring_buf);
+	int rc = wal_ring_read(ring, &relay->ring_cursor, &relay->ring_buf);
+	if (rc < 0)
+		diag_raise();
+	if (rc > 0) {
+		/* The relay was too slow to keep up with the ring. */
+		relay->is_in_ring = false;
+		return false;
+	}
+	const char *pos = relay->ring_buf.rpos;
+	const char *end = relay->ring_buf.wpos;
+	while (pos < end) {
+		struct xrow_header row;
+		if (wal_ring_decode_row(&pos, end, &row) != 0)
+			diag_raise();
+		/* The ring may start before the relay position. */
+		if (row.lsn <= vclock_get(&r->vclock, row.replica_id))
+			continue;
+		vclock_follow_xrow(&r->vclock, &row);
+		xstream_write_xc(&relay->stream, &row);
+	}
+	/*
+	 * No file is closed while the relay reads the ring,
+	 * so let the garbage collector know about the files
+	 * the replica doesn't need once the WAL is rotated.
+	 */
+	if ((events & WAL_EVENT_ROTATE) != 0)
+		relay_add_pending_gc(relay);
+	return true;
+}
+
 static void
 relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 {
@@ -451,8 +715,18 @@ relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 		return;
 	}
 	try {
-		recover_remaining_wals(relay->r, &relay->stream, NULL,
-				       (events & WAL_EVENT_ROTATE) != 0);
+		/*
+		 * Files may have been created while the relay
+		 * was reading the ring, rescan the directory
+		 * when falling back on them.
+		 */
+		bool scan_dir = relay->is_in_ring ||
+				(events & WAL_EVENT_ROTATE) != 0;
+		if (!relay_send_from_ring(relay, events)) {
+			recover_remaining_wals(relay->r, &relay->stream,
+					       NULL, scan_dir);
+		}
+		relay_flush(relay);
 	} catch (Exception *e) {
 		relay_set_error(relay, e);
 		fiber_cancel(fiber());
@@ -501,6 +775,7 @@ relay_send_heartbeat(struct relay *relay)
 	xrow_encode_timestamp(&row, instance_id, ev_now(loop()));
 	try {
 		relay_send(relay, &row);
+		relay_flush(relay);
 	} catch (Exception *e) {
 		relay_set_error(relay, e);
 		fiber_cancel(fiber());
@@ -533,6 +808,10 @@ relay_subscribe_f(va_list ap)
 	};
 	trigger_add(&r->on_close_log, &on_close_log);
 
+	relay->is_in_ring = false;
+	ibuf_create(&relay->ring_buf, &cord()->slabc, 16 * 1024);
+	relay_create_batch(relay);
+
 	/* Setup WAL watcher for sending new rows to the replica. */
 	wal_set_watcher(&relay->wal_watcher, relay->endpoint.name,
 			relay_process_wal_event, cbus_process);
@@ -594,6 +873,9 @@ relay_subscribe_f(va_list ap)
 		};
 		cmsg_init(&relay->status_msg.msg, route);
 		vclock_copy(&relay->status_msg.vclock, send_vclock);
+		relay->status_msg.bytes_saved = relay->bytes_saved;
+		relay->status_msg.rows_sent = relay->rows_sent;
+		relay->status_msg.write_count = relay->write_count;
 		relay->status_msg.relay = relay;
 		cpipe_push(&relay->tx_pipe, &relay->status_msg.msg);
 		/* Collect xlog files received by the replica. */
@@ -612,6 +894,8 @@ relay_subscribe_f(va_list ap)
 	/* Clear garbage collector trigger and WAL watcher. */
 	trigger_clear(&on_close_log);
 	wal_clear_watcher(&relay->wal_watcher, cbus_process);
+	ibuf_destroy(&relay->ring_buf);
+	relay_destroy_batch(relay);
 
 	/* Join ack reader fiber. */
 	fiber_cancel(reader);
@@ -629,7 +913,8 @@ relay_subscribe_f(va_list ap)
 /** Replication acceptor fiber handler. */
 void
 relay_subscribe(struct replica *replica, int fd, uint64_t sync,
-		struct vclock *replica_clock, uint32_t replica_version_id)
+		struct vclock *replica_clock, uint32_t replica_version_id,
+		bool compress)
 {
 	assert(replica->id != REPLICA_ID_NIL);
 	struct relay *relay = replica->relay;
@@ -646,7 +931,7 @@ relay_subscribe(struct replica *replica, int fd, uint64_t sync,
 			diag_raise();
 	}
 
-	relay_start(relay, fd, sync, relay_send_row);
+	relay_start(relay, fd, sync, compress, relay_send_row);
 	vclock_copy(&relay->local_vclock_at_subscribe, &replicaset.vclock);
 	relay->r = recovery_new(cfg_gets("wal_dir"), false,
 			        replica_clock);
@@ -665,6 +950,146 @@ relay_subscribe(struct replica *replica, int fd, uint64_t sync,
 		diag_raise();
 }
 
+/**
+ * Feed rows starting from @a start_vclock to a peer which isn't
+ * registered in _cluster until it disconnects. Unlike replicas,
+ * such peers pin xlogs they haven't acked yet only while they
+ * are connected, so they don't hold garbage collection when gone.
+ */
+static void
+relay_subscribe_anon_impl(int fd, uint64_t sync, struct vclock *start_vclock,
+			  uint32_t version_id, bool compress,
+			  const struct cdc_filter *filter,
+			  const char *gc_name, const char *cord_name)
+{
+	struct gc_consumer *gc = gc_consumer_register(start_vclock, "%s",
+						      gc_name);
+	if (gc == NULL)
+		diag_raise();
+	struct relay *relay = relay_new(NULL);
+	if (relay == NULL) {
+		gc_consumer_unregister(gc);
+		diag_raise();
+	}
+	relay->cdc_filter = filter;
+	relay->anon_gc = gc;
+	auto relay_guard = make_scoped_guard([=] {
+		gc_consumer_unregister(relay->anon_gc);
+		relay_delete(relay);
+	});
+
+	relay_start(relay, fd, sync, compress, relay_send_row);
+	vclock_copy(&relay->local_vclock_at_subscribe, &replicaset.vclock);
+	relay->r = recovery_new(cfg_gets("wal_dir"), false, start_vclock);
+	vclock_copy(&relay->tx.vclock, start_vclock);
+	relay->version_id = version_id;
+
+	int rc = cord_costart(&relay->cord, cord_name,
+			      relay_subscribe_f, relay);
+	if (rc == 0)
+		rc = cord_cojoin(&relay->cord);
+	relay_stop(relay);
+	if (rc != 0)
+		diag_raise();
+}
+
+void
+relay_subscribe_anon(const struct tt_uuid *replica_uuid, int fd,
+		     uint64_t sync, struct vclock *replica_vclock,
+		     uint32_t replica_version_id, bool compress)
+{
+	say_info("subscribing anonymous replica %s",
+		 tt_uuid_str(replica_uuid));
+	relay_subscribe_anon_impl(fd, sync, replica_vclock,
+				  replica_version_id, compress, NULL,
+				  tt_sprintf("anonymous replica %s",
+					     tt_uuid_str(replica_uuid)),
+				  "subscribe");
+}
+
+void
+relay_cdc_subscribe(int fd, uint64_t sync, struct vclock *start_vclock,
+		    const struct cdc_filter *filter)
+{
+	char name[FIBER_NAME_MAX];
+	relay_get_peer_name(fd, name, sizeof(name));
+	relay_subscribe_anon_impl(fd, sync, start_vclock,
+				  tarantool_version_id(), false, filter,
+				  tt_sprintf("cdc %s", name), "cdc_subscribe");
+}
+
+/**
+ * Send the rows accumulated by relay_batch_row() to the
+ * replica, compressing them into a zstd frame if requested.
+ */
+static void
+relay_flush(struct relay *relay)
+{
+	if (!relay->use_batch)
+		return;
+	size_t size = relay->batch.used;
+	if (size == 0)
+		return;
+	relay->write_count++;
+	if (!relay->compress) {
+		coio_write(&relay->io, relay->batch.data, size);
+		relay->batch.used = 0;
+		return;
+	}
+	size_t zmax_size = ZSTD_compressBound(size);
+	char *zdata = relay_buf_reserve(&relay->zbuf, zmax_size);
+	/* 3 is compression level, same as for xlog files. */
+	ZSTD_compressBegin(relay->zctx, 3);
+	size_t zsize = ZSTD_compressEnd(relay->zctx, zdata, zmax_size,
+					relay->batch.data, size);
+	if (ZSTD_isError(zsize)) {
+		tnt_raise(ClientError, ER_COMPRESSION,
+			  ZSTD_getErrorName(zsize));
+	}
+	relay->batch.used = 0;
+	if (zsize < size)
+		relay->bytes_saved += size - zsize;
+
+	char header[16];
+	char *d = mp_encode_map(header, 1);
+	d = mp_encode_uint(d, IPROTO_DATA);
+	d = mp_encode_binl(d, zsize);
+	assert(d <= header + sizeof(header));
+
+	struct xrow_header row;
+	memset(&row, 0, sizeof(row));
+	row.type = IPROTO_COMPRESSED_ROWS;
+	row.sync = relay->sync;
+	row.body[0].iov_base = header;
+	row.body[0].iov_len = d - header;
+	row.body[1].iov_base = zdata;
+	row.body[1].iov_len = zsize;
+	row.bodycnt = 2;
+	coio_write_xrow(&relay->io, &row);
+	fiber_gc();
+}
+
+/**
+ * Append a row to the batch. The batch is flushed when it
+ * is big enough or when there are no more rows to send for
+ * now.
+ */
+static void
+relay_batch_row(struct relay *relay, struct xrow_header *packet)
+{
+	enum { RELAY_BATCH_SIZE_MAX = 128 * 1024 };
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_to_iovec_xc(packet, iov);
+	for (int i = 0; i < iovcnt; i++) {
+		char *data = relay_buf_reserve(&relay->batch,
+					       iov[i].iov_len);
+		memcpy(data, iov[i].iov_base, iov[i].iov_len);
+		relay->batch.used += iov[i].iov_len;
+	}
+	if (relay->batch.used >= RELAY_BATCH_SIZE_MAX)
+		relay_flush(relay);
+}
+
 static void
 relay_send(struct relay *relay, struct xrow_header *packet)
 {
@@ -674,7 +1099,13 @@ relay_send(struct relay *relay, struct xrow_header *packet)
 
 	packet->sync = relay->sync;
 	relay->last_row_tm = ev_monotonic_now(loop());
-	coio_write_xrow(&relay->io, packet);
+	relay->rows_sent++;
+	if (relay->use_batch) {
+		relay_batch_row(relay, packet);
+	} else {
+		relay->write_count++;
+		coio_write_xrow(&relay->io, packet);
+	}
 	fiber_gc();
 
 	inj = errinj(ERRINJ_RELAY_TIMEOUT, ERRINJ_DOUBLE);
@@ -694,12 +1125,89 @@ relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row)
 		relay_send(relay, row);
 }
 
+/**
+ * Cut the tuple of @a request to the fields listed in
+ * @a filter. Missing fields are replaced with nil so that
+ * the consumer can rely on field positions.
+ */
+static void
+relay_cdc_project_tuple(struct request *request,
+			const struct cdc_filter *filter)
+{
+	struct region *region = &fiber()->gc;
+	const char *data = request->tuple;
+	uint32_t field_count = mp_decode_array(&data);
+	const char **fields = (const char **)
+		region_alloc_xc(region, (field_count + 1) * sizeof(*fields));
+	for (uint32_t i = 0; i < field_count; i++) {
+		fields[i] = data;
+		mp_next(&data);
+	}
+	fields[field_count] = data;
+
+	size_t size = mp_sizeof_array(filter->field_count);
+	for (uint32_t i = 0; i < filter->field_count; i++) {
+		uint32_t fieldno = filter->fields[i];
+		size += fieldno < field_count ?
+			fields[fieldno + 1] - fields[fieldno] :
+			mp_sizeof_nil();
+	}
+	char *tuple = (char *)region_alloc_xc(region, size);
+	char *pos = mp_encode_array(tuple, filter->field_count);
+	for (uint32_t i = 0; i < filter->field_count; i++) {
+		uint32_t fieldno = filter->fields[i];
+		if (fieldno >= field_count) {
+			pos = mp_encode_nil(pos);
+			continue;
+		}
+		size_t len = fields[fieldno + 1] - fields[fieldno];
+		memcpy(pos, fields[fieldno], len);
+		pos += len;
+	}
+	assert(pos == tuple + size);
+	request->tuple = tuple;
+	request->tuple_end = pos;
+}
+
+/**
+ * Send a row to a change data capture consumer. Rows of
+ * spaces the consumer isn't subscribed to are sent as
+ * IPROTO_NOP without a body so that the consumer's vclock,
+ * and hence its acks, still advance.
+ */
+static void
+relay_send_cdc_row(struct relay *relay, struct xrow_header *packet)
+{
+	const struct cdc_filter *filter = relay->cdc_filter;
+	struct request request;
+	bool skip = packet->type == IPROTO_NOP ||
+		    packet->group_id == GROUP_LOCAL;
+	if (!skip) {
+		xrow_decode_dml_xc(packet, &request,
+				   dml_request_key_map(packet->type));
+		skip = !cdc_filter_has_space(filter, request.space_id);
+	}
+	if (skip) {
+		packet->type = IPROTO_NOP;
+		packet->group_id = GROUP_DEFAULT;
+		packet->bodycnt = 0;
+	} else if (filter->fields != NULL && request.tuple != NULL) {
+		relay_cdc_project_tuple(&request, filter);
+		packet->bodycnt = xrow_encode_dml_xc(&request, packet->body);
+	}
+	relay_send(relay, packet);
+}
+
 /** Send a single row to the client. */
 static void
 relay_send_row(struct xstream *stream, struct xrow_header *packet)
 {
 	struct relay *relay = container_of(stream, struct relay, stream);
 	assert(iproto_type_is_dml(packet->type));
+	if (relay->cdc_filter != NULL) {
+		relay_send_cdc_row(relay, packet);
+		return;
+	}
 	/*
 	 * Transform replica local requests to IPROTO_NOP so as to
 	 * promote vclock on the replica without actually modifying
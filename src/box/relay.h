@@ -31,12 +31,14 @@
  * SUCH DAMAGE.
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #if defined(__cplusplus)
 extern "C" {
 #endif /* defined(__cplusplus) */
 
+struct cdc_filter;
 struct relay;
 struct replica;
 struct tt_uuid;
@@ -85,6 +87,32 @@ relay_get_state(const struct relay *relay);
 const struct vclock *
 relay_vclock(const struct relay *relay);
 
+/**
+ * Return true if the relay sends rows to the replica in
+ * compressed batches, see IPROTO_COMPRESSED_ROWS.
+ */
+bool
+relay_is_compressed(const struct relay *relay);
+
+/**
+ * Return the number of bytes the relay has saved on the
+ * network by compressing rows.
+ */
+uint64_t
+relay_bytes_saved(const struct relay *relay);
+
+/** Return the number of rows the relay has sent. */
+uint64_t
+relay_rows_sent(const struct relay *relay);
+
+/**
+ * Return the number of socket writes the relay has made to
+ * send rows. Several rows are sent in one write if they are
+ * batched.
+ */
+uint64_t
+relay_write_count(const struct relay *relay);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -95,19 +123,22 @@ relay_vclock(const struct relay *relay);
  * @param fd        client connection
  * @param sync      sync from incoming JOIN request
  * @param vclock    vclock of the last checkpoint
+ * @param compress  send rows in compressed batches
  */
 void
-relay_initial_join(int fd, uint64_t sync, struct vclock *vclock);
+relay_initial_join(int fd, uint64_t sync, struct vclock *vclock,
+		   bool compress);
 
 /**
  * Send final JOIN rows to the replica.
  *
  * @param fd        client connection
  * @param sync      sync from incoming JOIN request
+ * @param compress  send rows in compressed batches
  */
 void
 relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
-		 struct vclock *stop_vclock);
+		 struct vclock *stop_vclock, bool compress);
 
 /**
  * Subscribe a replica to updates.
@@ -116,6 +147,26 @@ relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
  */
 void
 relay_subscribe(struct replica *replica, int fd, uint64_t sync,
-		struct vclock *replica_vclock, uint32_t replica_version_id);
+		struct vclock *replica_vclock, uint32_t replica_version_id,
+		bool compress);
+
+/**
+ * Subscribe an anonymous replica, which isn't registered in
+ * _cluster, to updates. Returns when the replica disconnects.
+ */
+void
+relay_subscribe_anon(const struct tt_uuid *replica_uuid, int fd,
+		     uint64_t sync, struct vclock *replica_vclock,
+		     uint32_t replica_version_id, bool compress);
+
+/**
+ * Stream rows starting from @a start_vclock to a change data
+ * capture consumer, which doesn't belong to the replica set,
+ * until it disconnects. Only rows passing @a filter are sent
+ * in full.
+ */
+void
+relay_cdc_subscribe(int fd, uint64_t sync, struct vclock *start_vclock,
+		    const struct cdc_filter *filter);
 
 #endif /* TARANTOOL_REPLICATION_RELAY_H_INCLUDED */
@@ -53,6 +53,14 @@ int replication_connect_quorum = REPLICATION_CONNECT_QUORUM_ALL;
 double replication_sync_lag = 10.0; /* seconds */
 double replication_sync_timeout = 300.0; /* seconds */
 bool replication_skip_conflict = false;
+int replication_apply_fibers = 1;
+bool replication_compression = false;
+int replication_apply_batch_rows = 1;
+double replication_apply_batch_delay = 0; /* seconds */
+int replication_synchro_quorum = 1;
+double replication_synchro_timeout = 5.0; /* seconds */
+bool replication_anon = false;
+bool replication_join_from_replica = false;
 
 struct replicaset replicaset;
 
@@ -87,9 +95,11 @@ replication_init(void)
 	replica_hash_new(&replicaset.hash);
 	rlist_create(&replicaset.anon);
 	vclock_create(&replicaset.vclock);
+	fiber_cond_create(&replicaset.vclock_cond);
 	fiber_cond_create(&replicaset.applier.cond);
 	replicaset.replica_by_id = (struct replica **)calloc(VCLOCK_MAX, sizeof(struct replica *));
 	latch_create(&replicaset.applier.order_latch);
+	fiber_cond_create(&replicaset.applier.apply_cond);
 }
 
 void
@@ -155,6 +165,7 @@ replica_new(void)
 		       replica_on_applier_state_f, NULL, NULL);
 	replica->applier_sync_state = APPLIER_DISCONNECTED;
 	latch_create(&replica->order_latch);
+	replica->parallel_lsn = 0;
 	return replica;
 }
 
@@ -738,6 +749,23 @@ replicaset_follow(void)
 	}
 }
 
+int
+replicaset_wait_vclock(const struct vclock *vclock, double timeout)
+{
+	double deadline = ev_monotonic_now(loop()) + timeout;
+	while (true) {
+		int cmp = vclock_compare(vclock, &replicaset.vclock);
+		if (cmp == 0 || cmp == -1)
+			return 0;
+		if (fiber_cond_wait_deadline(&replicaset.vclock_cond,
+					     deadline) != 0) {
+			if (!fiber_is_cancelled())
+				diag_set(ClientError, ER_TIMEOUT);
+			return -1;
+		}
+	}
+}
+
 void
 replicaset_sync(void)
 {
@@ -887,6 +915,59 @@ replicaset_leader(void)
 	return leader;
 }
 
+/**
+ * Max number of rows a replica may lag behind the master to
+ * be chosen as a donor for JOIN. The donor has to receive the
+ * rows up to the registration of the new replica before it
+ * can serve the request, so a lagging donor delays the join.
+ */
+enum { REPLICASET_JOIN_DONOR_MAX_LAG = 1000 };
+
+struct replica *
+replicaset_join_donor(struct replica *master)
+{
+	assert(master->applier != NULL);
+	const struct ballot *master_ballot = &master->applier->ballot;
+	struct replica *donor = NULL;
+	replicaset_foreach(replica) {
+		struct applier *applier = replica->applier;
+		if (replica == master || applier == NULL ||
+		    applier->state != APPLIER_READY ||
+		    tt_uuid_is_equal(&replica->uuid, &INSTANCE_UUID))
+			continue;
+		const struct ballot *ballot = &applier->ballot;
+		if (!ballot->is_ro)
+			continue;
+		if (vclock_sum(&master_ballot->vclock) -
+		    vclock_sum(&ballot->vclock) > REPLICASET_JOIN_DONOR_MAX_LAG)
+			continue;
+		if (donor == NULL) {
+			donor = replica;
+			continue;
+		}
+		/*
+		 * Prefer the least loaded replica, then the most
+		 * advanced one, then the one with the lowest uuid.
+		 */
+		const struct ballot *best = &donor->applier->ballot;
+		if (ballot->relay_count != best->relay_count) {
+			if (ballot->relay_count < best->relay_count)
+				donor = replica;
+			continue;
+		}
+		int64_t sum = vclock_sum(&ballot->vclock);
+		int64_t best_sum = vclock_sum(&best->vclock);
+		if (sum != best_sum) {
+			if (sum > best_sum)
+				donor = replica;
+			continue;
+		}
+		if (tt_uuid_compare(&replica->uuid, &donor->uuid) < 0)
+			donor = replica;
+	}
+	return donor;
+}
+
 struct replica *
 replica_by_uuid(const struct tt_uuid *uuid)
 {
@@ -137,6 +137,64 @@ extern double replication_sync_timeout;
  */
 extern bool replication_skip_conflict;
 
+/**
+ * Number of fibers an applier uses to apply rows of its master
+ * in parallel. 1 means rows are applied one by one in the applier
+ * fiber.
+ */
+extern int replication_apply_fibers;
+
+enum { REPLICATION_APPLY_FIBERS_MAX = 256 };
+
+/**
+ * Ask masters to compress rows sent to appliers on JOIN and
+ * SUBSCRIBE, see IPROTO_COMPRESSED_ROWS.
+ */
+extern bool replication_compression;
+
+/**
+ * Max number of rows of a master an applier applies in one
+ * transaction and so writes to WAL at once. 1 means each row
+ * is applied in its own transaction.
+ */
+extern int replication_apply_batch_rows;
+
+enum { REPLICATION_APPLY_BATCH_ROWS_MAX = 65536 };
+
+/**
+ * How long an applier waits for the next row of a batch, see
+ * replication_apply_batch_rows.
+ */
+extern double replication_apply_batch_delay;
+
+/**
+ * Number of instances, this one included, which must write
+ * a transaction of a synchronous space before its commit
+ * returns. 1 means synchronous spaces behave like others.
+ */
+extern int replication_synchro_quorum;
+
+/**
+ * How long a synchronous transaction waits for the quorum
+ * before its commit fails.
+ */
+extern double replication_synchro_timeout;
+
+/**
+ * Set if this instance is an anonymous replica: it joins
+ * and follows masters without registering in _cluster, so
+ * it has no replica id and must be read-only.
+ */
+extern bool replication_anon;
+
+/**
+ * Set if a new instance may fetch the initial data from an
+ * up-to-date read-only replica instead of the master, only
+ * registering in _cluster of the master. See
+ * replicaset_join_donor().
+ */
+extern bool replication_join_from_replica;
+
 /**
  * Wait for the given period of time before trying to reconnect
  * to a master.
@@ -192,6 +250,11 @@ struct replicaset {
 	 * of the cluster as maintained by appliers.
 	 */
 	struct vclock vclock;
+	/**
+	 * Signalled whenever the vclock is advanced, see
+	 * replicaset_wait_vclock().
+	 */
+	struct fiber_cond vclock_cond;
 	/** Applier state. */
 	struct {
 		/**
@@ -227,6 +290,11 @@ struct replicaset {
 		 * struct replica object).
 		 */
 		struct latch order_latch;
+		/**
+		 * Signaled whenever a row applied by a parallel
+		 * applier fiber is done.
+		 */
+		struct fiber_cond apply_cond;
 	} applier;
 	/** Map of all known replica_id's to correspponding replica's. */
 	struct replica **replica_by_id;
@@ -274,6 +342,13 @@ struct replica {
 	enum applier_state applier_sync_state;
 	/* The latch is used to order replication requests. */
 	struct latch order_latch;
+	/**
+	 * LSN of the last row of this replica submitted to
+	 * parallel applier fibers. The rows up to this LSN may
+	 * still be in flight if it's greater than the replica
+	 * component of the replicaset vclock.
+	 */
+	int64_t parallel_lsn;
 };
 
 enum {
@@ -302,6 +377,17 @@ replica_by_id(uint32_t replica_id);
 struct replica *
 replicaset_leader(void);
 
+/**
+ * Return a replica to fetch the initial data from instead
+ * of the bootstrap leader @a master, or NULL if there is no
+ * suitable one. A donor must be a connected read-only peer
+ * lagging behind the master by no more than a few rows. Of
+ * those, the one sending rows to the least number of replicas
+ * is preferred.
+ */
+struct replica *
+replicaset_join_donor(struct replica *master);
+
 struct replica *
 replicaset_first(void);
 
@@ -333,6 +419,15 @@ replica_clear_id(struct replica *replica);
 void
 replica_on_relay_stop(struct replica *replica);
 
+/**
+ * Wait until the instance has applied all changes up to
+ * @a vclock, i.e. replicaset.vclock is greater than or equal
+ * to it component-wise. Returns -1 and sets diag on timeout
+ * or if the fiber is cancelled.
+ */
+int
+replicaset_wait_vclock(const struct vclock *vclock, double timeout);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 
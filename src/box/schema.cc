@@ -68,6 +68,7 @@ uint32_t schema_version = 0;
  * non-existent space objects on space:truncate() operation.
  */
 uint32_t space_cache_version = 0;
+uint32_t access_version = 0;
 
 struct rlist on_alter_space = RLIST_HEAD_INITIALIZER(on_alter_space);
 struct rlist on_alter_sequence = RLIST_HEAD_INITIALIZER(on_alter_sequence);
@@ -538,6 +539,7 @@ schema_free(void)
 void
 func_cache_replace(struct func_def *def)
 {
+	access_version++;
 	struct func *old = func_by_id(def->fid);
 	if (old) {
 		func_update(old, def);
@@ -578,6 +580,7 @@ func_cache_delete(uint32_t fid)
 	mh_int_t k = mh_i32ptr_find(funcs, fid, NULL);
 	if (k == mh_end(funcs))
 		return;
+	access_version++;
 	struct func *func = (struct func *)
 		mh_i32ptr_node(funcs, k)->val;
 	mh_i32ptr_del(funcs, k, NULL);
@@ -658,6 +661,8 @@ sequence_cache_replace(struct sequence_def *def)
 	} else {
 		/* Update an existing sequence. */
 		free(seq->def);
+		/* The reserved block may not fit the new definition. */
+		seq->has_reserved = false;
 	}
 	seq->def = def;
 	return;
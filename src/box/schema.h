@@ -43,6 +43,11 @@ extern "C" {
 
 extern uint32_t schema_version;
 extern uint32_t space_cache_version;
+/**
+ * Change counter of functions, users and privileges. Used to
+ * invalidate cached results of access checks.
+ */
+extern uint32_t access_version;
 
 /**
  * Lock of schema modification
@@ -130,6 +130,7 @@ sequence_free(void)
 void
 sequence_reset(struct sequence *seq)
 {
+	seq->has_reserved = false;
 	uint32_t key = seq->def->id;
 	uint32_t hash = sequence_hash(key);
 	uint32_t pos = light_sequence_find_key(&sequence_data_index, hash, key);
@@ -140,6 +141,7 @@ sequence_reset(struct sequence *seq)
 int
 sequence_set(struct sequence *seq, int64_t value)
 {
+	seq->has_reserved = false;
 	uint32_t key = seq->def->id;
 	uint32_t hash = sequence_hash(key);
 	struct sequence_data new_data, old_data;
@@ -241,10 +243,45 @@ overflow:
 		diag_set(ClientError, ER_SEQUENCE_OVERFLOW, def->name);
 		return -1;
 	}
+	/* Values after the wrap must be reserved anew. */
+	seq->has_reserved = false;
 	value = def->step > 0 ? def->min : def->max;
 	goto done;
 }
 
+int64_t
+sequence_reserve(struct sequence *seq, int64_t value)
+{
+	struct sequence_def *def = seq->def;
+	if (def->cache <= 1) {
+		seq->has_reserved = false;
+		return value;
+	}
+	/*
+	 * Take as many steps as fit in the block and between
+	 * the value and the sequence limit. Unsigned arithmetic
+	 * doesn't overflow here.
+	 */
+	uint64_t room, step;
+	if (def->step > 0) {
+		room = (uint64_t)def->max - (uint64_t)value;
+		step = def->step;
+	} else {
+		room = (uint64_t)value - (uint64_t)def->min;
+		step = -(uint64_t)def->step;
+	}
+	uint64_t steps = room / step;
+	if (steps > (uint64_t)def->cache - 1)
+		steps = def->cache - 1;
+	int64_t last = def->step > 0 ?
+		       (int64_t)((uint64_t)value + steps * step) :
+		       (int64_t)((uint64_t)value - steps * step);
+	seq->has_reserved = true;
+	seq->reserved_min = MIN(value, last);
+	seq->reserved_max = MAX(value, last);
+	return last;
+}
+
 int
 access_check_sequence(struct sequence *seq)
 {
@@ -63,7 +63,11 @@ struct sequence_def {
 	int64_t max;
 	/** Initial sequence value. */
 	int64_t start;
-	/** Number of values to preallocate. Not implemented yet. */
+	/**
+	 * Number of values to reserve in _sequence_data at once.
+	 * Only the last value of a reserved block is persisted,
+	 * values left unused on restart are skipped.
+	 */
 	int64_t cache;
 	/**
 	 * If this flag is set, the sequence will wrap
@@ -81,6 +85,13 @@ struct sequence {
 	struct sequence_def *def;
 	/** Set if the sequence is automatically generated. */
 	bool is_generated;
+	/**
+	 * Set if values from reserved_min to reserved_max were
+	 * reserved in _sequence_data, see sequence_def::cache.
+	 */
+	bool has_reserved;
+	int64_t reserved_min;
+	int64_t reserved_max;
 	/** Cached runtime access information. */
 	struct access access[BOX_USER_MAX];
 };
@@ -133,6 +144,27 @@ sequence_update(struct sequence *seq, int64_t value);
 int
 sequence_next(struct sequence *seq, int64_t *result);
 
+/**
+ * Check if a value returned by sequence_next() belongs to the
+ * block reserved by sequence_reserve(), so it doesn't need to
+ * be persisted.
+ */
+static inline bool
+sequence_is_reserved(struct sequence *seq, int64_t value)
+{
+	return seq->has_reserved && value >= seq->reserved_min &&
+	       value <= seq->reserved_max;
+}
+
+/**
+ * Reserve a block of sequence_def::cache values starting at
+ * @a value, which was just returned by sequence_next(). Return
+ * the last value of the block, which must be persisted instead
+ * of @a value.
+ */
+int64_t
+sequence_reserve(struct sequence *seq, int64_t value);
+
 /**
  * Check whether or not the current user can be granted
  * access to the sequence.
@@ -136,6 +136,7 @@ space_create(struct space *space, struct engine *engine,
 	space->index_id_max = index_id_max;
 	rlist_create(&space->before_replace);
 	rlist_create(&space->on_replace);
+	rlist_create(&space->on_commit_batch);
 	rlist_create(&space->on_stmt_begin);
 	space->run_triggers = true;
 
@@ -216,6 +217,7 @@ space_delete(struct space *space)
 		tuple_format_unref(space->format);
 	trigger_destroy(&space->before_replace);
 	trigger_destroy(&space->on_replace);
+	trigger_destroy(&space->on_commit_batch);
 	trigger_destroy(&space->on_stmt_begin);
 	space_def_delete(space->def);
 	/*
@@ -334,6 +336,9 @@ space_before_replace(struct space *space, struct txn *txn,
 	if (index != NULL &&
 	    index_get(index, key, part_count, &old_tuple) != 0)
 		return -1;
+	/* Triggers and update operations may access any field. */
+	if (old_tuple != NULL && (old_tuple = tuple_unpack(old_tuple)) == NULL)
+		return -1;
 
 	/*
 	 * Create the new tuple.
@@ -406,6 +411,12 @@ space_before_replace(struct space *space, struct txn *txn,
 	}
 
 	assert(old_tuple != NULL || new_tuple != NULL);
+	/*
+	 * An unpacked old tuple is only blessed, so pin it
+	 * while the triggers are running.
+	 */
+	if (old_tuple != NULL)
+		tuple_ref(old_tuple);
 
 	/*
 	 * Execute all registered BEFORE triggers.
@@ -460,6 +471,8 @@ space_before_replace(struct space *space, struct txn *txn,
 		rc = request_create_from_tuple(request, space,
 					       old_tuple, new_tuple);
 out:
+	if (old_tuple != NULL)
+		tuple_unref(old_tuple);
 	if (new_tuple != NULL)
 		tuple_unref(new_tuple);
 	return rc;
@@ -469,6 +482,27 @@ int
 space_execute_dml(struct space *space, struct txn *txn,
 		  struct request *request, struct tuple **result)
 {
+	uint64_t start = op_latency_start();
+	switch (request->type) {
+	case IPROTO_INSERT:
+		space->op_stat.insert++;
+		break;
+	case IPROTO_REPLACE:
+		space->op_stat.replace++;
+		break;
+	case IPROTO_UPDATE:
+		space->op_stat.update++;
+		break;
+	case IPROTO_UPSERT:
+		space->op_stat.upsert++;
+		break;
+	case IPROTO_DELETE:
+		space->op_stat.del++;
+		break;
+	default:
+		break;
+	}
+
 	if (unlikely(space->sequence != NULL) &&
 	    (request->type == IPROTO_INSERT ||
 	     request->type == IPROTO_REPLACE)) {
@@ -528,6 +562,7 @@ space_execute_dml(struct space *space, struct txn *txn,
 	default:
 		*result = NULL;
 	}
+	op_latency_collect(&space->op_stat.latency, start);
 	return 0;
 }
 
@@ -637,4 +672,20 @@ generic_space_prepare_alter(struct space *old_space, struct space *new_space)
 	return 0;
 }
 
+void
+generic_space_finish_alter(struct space *old_space, struct space *new_space)
+{
+	(void)old_space;
+	(void)new_space;
+}
+
+int
+generic_space_bulk_load(struct space *space, struct bulk_load_source *source)
+{
+	(void)source;
+	diag_set(ClientError, ER_UNSUPPORTED, space->engine->name,
+		 "bulk load");
+	return -1;
+}
+
 /* }}} */
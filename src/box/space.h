@@ -51,6 +51,15 @@ struct port;
 struct tuple;
 struct tuple_format;
 
+/** Source of tuples for space_bulk_load(). */
+struct bulk_load_source {
+	/**
+	 * Return the next tuple in @a ret or NULL at the end.
+	 * The tuple stays valid until the next call.
+	 */
+	int (*next)(struct bulk_load_source *source, struct tuple **ret);
+};
+
 struct space_vtab {
 	/** Free a space instance. */
 	void (*destroy)(struct space *);
@@ -133,6 +142,34 @@ struct space_vtab {
 	 */
 	int (*prepare_alter)(struct space *old_space,
 			     struct space *new_space);
+	/**
+	 * Notify the engine that the new space is about to
+	 * replace the old one, after new indexes have been
+	 * built. Since building indexes may yield, this is
+	 * the place to carry over changes made to the old
+	 * space meanwhile. Must not fail.
+	 */
+	void (*finish_alter)(struct space *old_space,
+			     struct space *new_space);
+	/**
+	 * Load tuples sorted by the primary key into an empty
+	 * space bypassing the transaction and the write ahead
+	 * log, see box_space_bulk_load().
+	 */
+	int (*bulk_load)(struct space *space,
+			 struct bulk_load_source *source);
+};
+
+/** Request counters of a space, see space:stat(). */
+struct space_op_stat {
+	uint64_t select;
+	uint64_t insert;
+	uint64_t replace;
+	uint64_t update;
+	uint64_t upsert;
+	uint64_t del;
+	/** Sampled latency of successful DML requests. */
+	struct op_latency latency;
 };
 
 struct space {
@@ -146,6 +183,12 @@ struct space {
 	struct rlist before_replace;
 	/** Triggers fired after space_replace() -- see txn_commit_stmt(). */
 	struct rlist on_replace;
+	/**
+	 * Triggers fired once per committed transaction with all
+	 * statements the transaction applied to the space, see
+	 * struct txn_commit_batch.
+	 */
+	struct rlist on_commit_batch;
 	/** Triggers fired before space statement */
 	struct rlist on_stmt_begin;
 	/** SQL Trigger list. */
@@ -200,6 +243,8 @@ struct space {
 	 * of parent constraints as well as child ones.
 	 */
 	uint64_t fkey_mask;
+	/** Request counters, see space:stat(). */
+	struct space_op_stat op_stat;
 };
 
 /** Initialize a base space instance. */
@@ -391,6 +436,12 @@ space_build_index(struct space *src_space, struct index *new_index,
 	return src_space->vtab->build_index(src_space, new_index, new_format);
 }
 
+static inline int
+space_bulk_load(struct space *space, struct bulk_load_source *source)
+{
+	return space->vtab->bulk_load(space, source);
+}
+
 static inline void
 space_swap_index(struct space *old_space, struct space *new_space,
 		 uint32_t old_index_id, uint32_t new_index_id)
@@ -407,6 +458,13 @@ space_prepare_alter(struct space *old_space, struct space *new_space)
 	return new_space->vtab->prepare_alter(old_space, new_space);
 }
 
+static inline void
+space_finish_alter(struct space *old_space, struct space *new_space)
+{
+	assert(old_space->vtab == new_space->vtab);
+	new_space->vtab->finish_alter(old_space, new_space);
+}
+
 static inline bool
 space_is_memtx(struct space *space) { return space->engine->id == 0; }
 
@@ -469,6 +527,8 @@ int generic_space_check_format(struct space *, struct tuple_format *);
 int generic_space_build_index(struct space *, struct index *,
 			      struct tuple_format *);
 int generic_space_prepare_alter(struct space *, struct space *);
+void generic_space_finish_alter(struct space *, struct space *);
+int generic_space_bulk_load(struct space *, struct bulk_load_source *);
 
 #if defined(__cplusplus)
 } /* extern "C" */
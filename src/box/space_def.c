@@ -55,6 +55,10 @@ const struct space_opts space_opts_default = {
 	/* .is_temporary = */ false,
 	/* .is_ephemeral = */ false,
 	/* .view = */ false,
+	/* .memory_quota = */ 0,
+	/* .compression_threshold = */ 0,
+	/* .is_sync = */ false,
+	/* .is_fixed_width = */ false,
 	/* .sql        = */ NULL,
 	/* .checks     = */ NULL,
 };
@@ -63,6 +67,11 @@ const struct opt_def space_opts_reg[] = {
 	OPT_DEF("group_id", OPT_UINT32, struct space_opts, group_id),
 	OPT_DEF("temporary", OPT_BOOL, struct space_opts, is_temporary),
 	OPT_DEF("view", OPT_BOOL, struct space_opts, is_view),
+	OPT_DEF("memory_quota", OPT_INT64, struct space_opts, memory_quota),
+	OPT_DEF("compression_threshold", OPT_INT64, struct space_opts,
+		compression_threshold),
+	OPT_DEF("is_sync", OPT_BOOL, struct space_opts, is_sync),
+	OPT_DEF("fixed_width", OPT_BOOL, struct space_opts, is_fixed_width),
 	OPT_DEF("sql", OPT_STRPTR, struct space_opts, sql),
 	OPT_DEF_ARRAY("checks", struct space_opts, checks,
 		      checks_array_decode),
@@ -69,6 +69,32 @@ struct space_opts {
 	 * this flag can't be changed after space creation.
 	 */
 	bool is_view;
+	/**
+	 * Limit on the total size of tuples stored in a memtx
+	 * space, in bytes. A change that would grow the space
+	 * beyond the limit fails with ER_SPACE_QUOTA. 0 means
+	 * the space is limited by memtx_memory only.
+	 */
+	int64_t memory_quota;
+	/**
+	 * Memtx tuples of this size or larger have the fields
+	 * that aren't indexed compressed. 0 disables compression.
+	 */
+	int64_t compression_threshold;
+	/**
+	 * Commit of a transaction changing this space waits
+	 * until the transaction is written by
+	 * replication_synchro_quorum instances.
+	 */
+	bool is_sync;
+	/**
+	 * Memtx tuples of this space are stored in fixed-width
+	 * MessagePack so that fields are accessed at offsets
+	 * known from the format. Only allowed for formats of
+	 * non-nullable unsigned, integer, number and boolean
+	 * fields, see tuple_format::fixed_offsets.
+	 */
+	bool is_fixed_width;
 	/** SQL statement that produced this space. */
 	char *sql;
 	/** SQL Checks expressions list. */
@@ -52,6 +52,8 @@
 #include "xrow.h"
 #include "iproto_constants.h"
 #include "fkey.h"
+#include "coll_id_cache.h"
+#include "sql_stmt_cache.h"
 #include "mpstream.h"
 
 static sql *db = NULL;
@@ -74,6 +76,7 @@ sql_init()
 		panic("failed to initialize SQL subsystem");
 
 	assert(db != NULL);
+	sql_stmt_cache_init();
 }
 
 void
@@ -356,9 +359,155 @@ int tarantoolsqlCount(BtCursor *pCur, i64 *pnEntry)
 	return SQL_OK;
 }
 
+enum {
+	/** Max number of ephemeral spaces kept for reuse. */
+	SQL_EPHEMERAL_CACHE_SIZE = 16,
+	/**
+	 * Max number of tuples an ephemeral space may hold to
+	 * be emptied and kept for reuse rather than deleted.
+	 */
+	SQL_EPHEMERAL_CACHE_MAX_TUPLES = 256,
+};
+
+/**
+ * Empty ephemeral spaces of finished statements. Creating an
+ * ephemeral space takes a key definition, an index definition,
+ * a space definition, a tuple format lookup and a new index,
+ * which for a small query costs more than the query itself.
+ * So small spaces are emptied on close and reused by the next
+ * statement needing a space of the same shape.
+ */
+static struct space *sql_ephemeral_cache[SQL_EPHEMERAL_CACHE_SIZE];
+/** Number of spaces in sql_ephemeral_cache. */
+static int sql_ephemeral_cache_size;
+/**
+ * Key definitions of cached spaces point to collations without
+ * referencing them, so the cache is valid only as long as the
+ * collation cache doesn't change.
+ */
+static uint32_t sql_ephemeral_cache_coll_version;
+
+/** Delete all cached ephemeral spaces. */
+static void
+sql_ephemeral_cache_flush(void)
+{
+	for (int i = 0; i < sql_ephemeral_cache_size; i++)
+		space_delete(sql_ephemeral_cache[i]);
+	sql_ephemeral_cache_size = 0;
+}
+
+/**
+ * Find a cached ephemeral space with the given key parts and
+ * index type and remove it from the cache. Returns NULL if
+ * there's none.
+ */
+static struct space *
+sql_ephemeral_cache_get(const struct key_part_def *parts,
+			uint32_t part_count, enum index_type type)
+{
+	if (sql_ephemeral_cache_coll_version != coll_id_cache_version) {
+		sql_ephemeral_cache_flush();
+		sql_ephemeral_cache_coll_version = coll_id_cache_version;
+	}
+	for (int i = 0; i < sql_ephemeral_cache_size; i++) {
+		struct space *space = sql_ephemeral_cache[i];
+		struct key_def *key_def = space->index[0]->def->key_def;
+		if (space->index[0]->def->type != type ||
+		    key_def->part_count != part_count)
+			continue;
+		uint32_t j;
+		for (j = 0; j < part_count; j++) {
+			if (key_def->parts[j].type != parts[j].type ||
+			    key_def->parts[j].coll_id != parts[j].coll_id)
+				break;
+		}
+		if (j < part_count)
+			continue;
+		sql_ephemeral_cache[i] =
+			sql_ephemeral_cache[--sql_ephemeral_cache_size];
+		return space;
+	}
+	return NULL;
+}
+
+/**
+ * Delete all tuples from an ephemeral space. Keys are collected
+ * before deleting anything, because a HASH index iterator can't
+ * survive deletions.
+ */
+static int
+sql_ephemeral_space_clear(struct space *space)
+{
+	struct index *index = space->index[0];
+	uint32_t count = index_size(index);
+	if (count == 0)
+		return 0;
+	const char **keys = region_alloc(&fiber()->gc, count * sizeof(*keys));
+	if (keys == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*keys), "region", "keys");
+		return -1;
+	}
+	struct iterator *it = index_create_iterator(index, ITER_ALL,
+						    nil_key, 0);
+	if (it == NULL)
+		return -1;
+	struct tuple *tuple;
+	uint32_t key_count = 0;
+	while (key_count < count && iterator_next(it, &tuple) == 0 &&
+	       tuple != NULL) {
+		uint32_t key_size;
+		keys[key_count] = tuple_extract_key(tuple, index->def->key_def,
+						    &key_size);
+		if (keys[key_count] == NULL) {
+			iterator_delete(it);
+			return -1;
+		}
+		key_count++;
+	}
+	iterator_delete(it);
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (space_ephemeral_delete(space, keys[i]) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * Delete an ephemeral space or, if it is small, empty it and
+ * put it to the cache for reuse.
+ */
+static void
+sql_ephemeral_space_delete(struct space *space)
+{
+	/* The space may refer to a dropped collation. */
+	if (sql_ephemeral_cache_coll_version == coll_id_cache_version &&
+	    sql_ephemeral_cache_size < SQL_EPHEMERAL_CACHE_SIZE &&
+	    index_size(space->index[0]) <= SQL_EPHEMERAL_CACHE_MAX_TUPLES) {
+		size_t svp = region_used(&fiber()->gc);
+		int rc = sql_ephemeral_space_clear(space);
+		region_truncate(&fiber()->gc, svp);
+		if (rc == 0) {
+			/* Start row ids over as in a new space. */
+			((struct memtx_space *)space)->rowid = 0;
+			sql_ephemeral_cache[sql_ephemeral_cache_size++] = space;
+			return;
+		}
+		diag_clear(diag_get());
+	}
+	space_delete(space);
+}
+
+void
+sql_free()
+{
+	sql_ephemeral_cache_flush();
+}
+
 struct space *
-sql_ephemeral_space_create(uint32_t field_count, struct sql_key_info *key_info)
+sql_ephemeral_space_create(uint32_t field_count, struct sql_key_info *key_info,
+			   bool is_hash)
 {
+	enum index_type type = is_hash ? HASH : TREE;
 	struct key_def *def = NULL;
 	if (key_info != NULL) {
 		def = sql_key_info_to_key_def(key_info);
@@ -389,13 +538,17 @@ sql_ephemeral_space_create(uint32_t field_count, struct sql_key_info *key_info)
 			part->type = FIELD_TYPE_SCALAR;
 		}
 	}
+	struct space *space = sql_ephemeral_cache_get(ephemer_key_parts,
+						      field_count, type);
+	if (space != NULL)
+		return space;
 	struct key_def *ephemer_key_def = key_def_new(ephemer_key_parts,
 						      field_count);
 	if (ephemer_key_def == NULL)
 		return NULL;
 
 	struct index_def *ephemer_index_def =
-		index_def_new(0, 0, "ephemer_idx", strlen("ephemer_idx"), TREE,
+		index_def_new(0, 0, "ephemer_idx", strlen("ephemer_idx"), type,
 			      &index_opts_default, ephemer_key_def, NULL);
 	key_def_delete(ephemer_key_def);
 	if (ephemer_index_def == NULL)
@@ -430,12 +583,12 @@ int tarantoolsqlEphemeralInsert(struct space *space, const char *tuple,
 	return SQL_OK;
 }
 
-/* Simply delete ephemeral space by calling space_delete(). */
+/* Delete ephemeral space or put it to the cache for reuse. */
 int tarantoolsqlEphemeralDrop(BtCursor *pCur)
 {
 	assert(pCur);
 	assert(pCur->curFlags & BTCF_TEphemCursor);
-	space_delete(pCur->space);
+	sql_ephemeral_space_delete(pCur->space);
 	pCur->space = NULL;
 	return SQL_OK;
 }
@@ -776,16 +929,24 @@ tarantoolsqlIdxKeyCompare(struct BtCursor *cursor,
 		if (fieldno != next_fieldno) {
 			struct tuple_field *field =
 				tuple_format_field(format, fieldno);
-			if (fieldno >= field_count ||
-			    field->offset_slot == TUPLE_OFFSET_SLOT_NIL) {
-				/* Outdated field_map. */
+			uint32_t offset = TUPLE_FIELD_MAP_OFFSET_UNKNOWN;
+			if (fieldno < field_count &&
+			    field->offset_slot != TUPLE_OFFSET_SLOT_NIL) {
+				offset = tuple_field_map_get(format, field_map,
+							     field->offset_slot);
+			}
+			if (offset == TUPLE_FIELD_MAP_OFFSET_UNKNOWN) {
+				/*
+				 * Outdated field_map or the offset
+				 * doesn't fit in a compact one.
+				 */
 				uint32_t j = 0;
 
 				p = field0;
 				while (j++ != fieldno)
 					mp_next(&p);
 			} else {
-				p = base + field_map[field->offset_slot];
+				p = base + offset;
 			}
 		}
 		next_fieldno = fieldno + 1;
@@ -900,6 +1061,7 @@ cursor_seek(BtCursor *pCur, int *pRes)
 		box_iterator_free(pCur->iter);
 		pCur->iter = NULL;
 	}
+	sql_cursor_batch_drop(pCur);
 	const char *key = (const char *)pCur->key;
 	uint32_t part_count = mp_decode_array(&key);
 	if (key_validate(pCur->index->def, pCur->iter_type, key, part_count)) {
@@ -911,9 +1073,19 @@ cursor_seek(BtCursor *pCur, int *pRes)
 	struct txn *txn = NULL;
 	if (space->def->id != 0 && txn_begin_ro_stmt(space, &txn) != 0)
 		return SQL_TARANTOOL_ERROR;
-	struct iterator *it =
-		index_create_iterator(pCur->index, pCur->iter_type, key,
-				      part_count);
+	struct iterator *it;
+	if ((pCur->curFlags & BTCF_TaCovering) != 0) {
+		assert(pCur->filter_count == 0);
+		it = index_create_covering_iterator(pCur->index,
+						    pCur->iter_type, key,
+						    part_count,
+						    pCur->field_mask);
+	} else {
+		it = index_create_filtered_iterator(pCur->index,
+						    pCur->iter_type, key,
+						    part_count, pCur->filter,
+						    pCur->filter_count);
+	}
 	if (it == NULL) {
 		if (txn != NULL)
 			txn_rollback_stmt();
@@ -928,6 +1100,107 @@ cursor_seek(BtCursor *pCur, int *pRes)
 	return cursor_advance(pCur, pRes);
 }
 
+int
+sql_cursor_add_filter(struct BtCursor *cur, uint32_t fieldno,
+		      enum field_type type, uint32_t coll_id,
+		      enum iterator_type op, struct Mem *value)
+{
+	assert(cur->iter == NULL);
+	size_t size = (cur->filter_count + 1) * sizeof(cur->filter[0]);
+	struct iterator_filter *filter =
+		(struct iterator_filter *) realloc(cur->filter, size);
+	if (filter == NULL) {
+		diag_set(OutOfMemory, size, "realloc", "filter");
+		return -1;
+	}
+	cur->filter = filter;
+	struct key_part_def part = key_part_def_default;
+	part.fieldno = fieldno;
+	part.type = type;
+	part.coll_id = coll_id;
+	part.is_nullable = true;
+	part.nullable_action = ON_CONFLICT_ACTION_NONE;
+	struct key_def *key_def = key_def_new(&part, 1);
+	if (key_def == NULL)
+		return -1;
+	/* Fields missing in a tuple compare as NULLs. */
+	key_def_update_optionality(key_def, 0);
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	uint32_t mp_size;
+	const char *mp = sql_vdbe_mem_encode_tuple(value, 1, &mp_size, region);
+	if (mp == NULL)
+		goto error;
+	const char *mp_end = mp + mp_size;
+	mp_decode_array(&mp);
+	char *buf = (char *) malloc(mp_end - mp);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, mp_end - mp, "malloc", "filter value");
+		goto error;
+	}
+	memcpy(buf, mp, mp_end - mp);
+	region_truncate(region, used);
+	filter = &cur->filter[cur->filter_count++];
+	filter->key_def = key_def;
+	filter->value = buf;
+	filter->type = op;
+	return 0;
+error:
+	region_truncate(region, used);
+	key_def_delete(key_def);
+	return -1;
+}
+
+/**
+ * Return the next tuple of a cursor with BTCF_TaBatch flag.
+ * When the tuples fetched ahead are over, read the next batch
+ * from the iterator in one go instead of stepping it on every
+ * advance of the cursor. The returned tuple is referenced.
+ *
+ * @param pCur Cursor which fetches tuples in batches.
+ * @param[out] tuple Next tuple, or NULL if the end is reached.
+ *
+ * @retval 0 on success, -1 on iterator or memory error.
+ */
+static int
+cursor_batch_next(BtCursor *pCur, struct tuple **tuple)
+{
+	if (pCur->batch_pos == pCur->batch_count) {
+		pCur->batch_pos = 0;
+		pCur->batch_count = 0;
+		uint32_t cap = pCur->batch_cap == 0 ? SQL_CURSOR_BATCH_MIN :
+			       MIN(pCur->batch_cap * 2, SQL_CURSOR_BATCH_MAX);
+		if (cap > pCur->batch_cap) {
+			size_t size = cap * sizeof(pCur->batch[0]);
+			struct tuple **batch =
+				(struct tuple **) realloc(pCur->batch, size);
+			if (batch == NULL) {
+				diag_set(OutOfMemory, size, "realloc", "batch");
+				return -1;
+			}
+			pCur->batch = batch;
+			pCur->batch_cap = cap;
+		}
+		while (pCur->batch_count < pCur->batch_cap) {
+			struct tuple *next;
+			if (iterator_next(pCur->iter, &next) != 0)
+				return -1;
+			if (next == NULL)
+				break;
+			next = tuple_unpack(next);
+			if (next == NULL)
+				return -1;
+			box_tuple_ref(next);
+			pCur->batch[pCur->batch_count++] = next;
+		}
+	}
+	if (pCur->batch_pos < pCur->batch_count)
+		*tuple = pCur->batch[pCur->batch_pos++];
+	else
+		*tuple = NULL;
+	return 0;
+}
+
 /*
  * Move cursor to the next entry in space.
  * New tuple is refed and saved in cursor.
@@ -944,12 +1217,21 @@ cursor_advance(BtCursor *pCur, int *pRes)
 	assert(pCur->iter != NULL);
 
 	struct tuple *tuple;
-	if (iterator_next(pCur->iter, &tuple) != 0)
-		return SQL_TARANTOOL_ITERATOR_FAIL;
+	if ((pCur->curFlags & BTCF_TaBatch) != 0) {
+		if (cursor_batch_next(pCur, &tuple) != 0)
+			return SQL_TARANTOOL_ITERATOR_FAIL;
+	} else {
+		if (iterator_next(pCur->iter, &tuple) != 0)
+			return SQL_TARANTOOL_ITERATOR_FAIL;
+		if (tuple != NULL &&
+		    (tuple = tuple_unpack(tuple)) == NULL)
+			return SQL_TARANTOOL_ITERATOR_FAIL;
+		if (tuple != NULL)
+			box_tuple_ref(tuple);
+	}
 	if (pCur->last_tuple)
 		box_tuple_unref(pCur->last_tuple);
 	if (tuple) {
-		box_tuple_ref(tuple);
 		*pRes = 0;
 	} else {
 		pCur->eState = CURSOR_INVALID;
@@ -41,6 +41,10 @@ extern "C" {
 void
 sql_init();
 
+/** Free resources cached by the SQL subsystem. */
+void
+sql_free();
+
 void
 sql_load_schema();
 
@@ -110,6 +110,8 @@
 #include "box/key_def.h"
 #include "box/tuple_compare.h"
 #include "box/schema.h"
+#include "box/space.h"
+#include "box/tuple.h"
 #include "third_party/qsort_arg.h"
 
 #include "sqlInt.h"
@@ -756,6 +758,118 @@ callStatGet(Vdbe * v, int regStat4, int iParam, int regOut)
 	sqlVdbeChangeP5(v, 2);
 }
 
+/**
+ * Implementation of the stat_sample(S, I, N) SQL function. It
+ * returns the value for the stat column of _sql_stat1 for index
+ * I of space S estimated from N random tuples, or NULL if the
+ * index is small or can't be sampled, so that it has to be
+ * scanned.
+ *
+ * The size of the group of tuples sharing the first K key parts
+ * with each sampled tuple is counted by the index. Tuples from
+ * big groups are picked more often, so the number of rows per
+ * distinct key is estimated with the harmonic mean of the group
+ * sizes, which is unbiased for such picking. _sql_stat4 samples
+ * are not collected for a sampled index.
+ */
+static void
+statSample(sql_context *context, int argc, sql_value **argv)
+{
+	assert(argc == 3);
+	(void) argc;
+	struct space *space = space_by_id(sql_value_int(argv[0]));
+	int sample_count = sql_value_int(argv[2]);
+	if (space == NULL || !space_is_memtx(space))
+		return;
+	struct index *index = space_index(space, sql_value_int(argv[1]));
+	if (index == NULL || index->def->type != TREE)
+		return;
+	ssize_t size = index_size(index);
+	if (size <= sample_count)
+		return;
+	struct key_def *key_def = index->def->key_def;
+	uint32_t part_count = key_def->part_count;
+	double inv_sum[part_count];
+	memset(inv_sum, 0, sizeof(inv_sum));
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	int sampled = 0;
+	for (; sampled < sample_count; ++sampled) {
+		struct tuple *tuple;
+		if (index_random(index, rand(), &tuple) != 0)
+			goto error;
+		if (tuple == NULL)
+			break;
+		const char *key = tuple_extract_key(tuple, key_def, NULL);
+		if (key == NULL)
+			goto error;
+		mp_decode_array(&key);
+		for (uint32_t k = 0; k < part_count; ++k) {
+			ssize_t n = index_count(index, ITER_EQ, key, k + 1);
+			if (n < 0)
+				goto error;
+			inv_sum[k] += 1.0 / MAX(n, 1);
+		}
+		region_truncate(region, region_svp);
+	}
+	if (sampled == 0)
+		return;
+	char *stat = sqlMallocZero((part_count + 1) * 25);
+	if (stat == NULL) {
+		sql_result_error_nomem(context);
+		return;
+	}
+	sql_snprintf(24, stat, "%llu", (u64) size);
+	char *z = stat + sqlStrlen30(stat);
+	for (uint32_t k = 0; k < part_count; ++k) {
+		u64 avg = (u64) (sampled / inv_sum[k] + 0.5);
+		if (k == part_count - 1 && index->def->opts.is_unique)
+			avg = 1;
+		sql_snprintf(24, z, " %llu", MAX(avg, 1));
+		z += sqlStrlen30(z);
+	}
+	sql_result_text(context, stat, -1, sql_free);
+	return;
+error:
+	region_truncate(region, region_svp);
+	sql_result_error(context, diag_last_error(diag_get())->errmsg, -1);
+}
+
+static const FuncDef statSampleFuncdef = {
+	3,			/* nArg */
+	0,			/* funcFlags */
+	0,			/* pUserData */
+	0,			/* pNext */
+	statSample,		/* xSFunc */
+	0,			/* xFinalize */
+	"stat_sample",		/* zName */
+	{0},
+	0
+};
+
+/**
+ * Generate code to insert a row into _sql_stat1.
+ *
+ * @param v VDBE.
+ * @param stat1 _sql_stat1 space.
+ * @param reg First of the registers with the table name, the
+ *        index name and the stat column value.
+ * @param tmp_reg Register for the record.
+ */
+static void
+vdbe_emit_stat1_insert(struct Vdbe *v, struct space *stat1, int reg,
+		       int tmp_reg)
+{
+	enum field_type types[4] = { FIELD_TYPE_STRING,
+				     FIELD_TYPE_STRING,
+				     FIELD_TYPE_STRING,
+				     field_type_MAX };
+	sqlVdbeAddOp4(v, OP_MakeRecord, reg, 4, tmp_reg,
+			  (char *)types, sizeof(types));
+	sqlVdbeAddOp4(v, OP_IdxInsert, tmp_reg, 0, 0,
+			  (char *)stat1, P4_SPACEPTR);
+}
+
 /**
  * Generate code to do an analysis of all indices associated with
  * a single table.
@@ -872,6 +986,36 @@ vdbe_emit_analyze_space(struct Parse *parse, struct space *space)
 			/* We have already opened cursor on PK. */
 			idx_cursor = tab_cursor;
 		}
+		/*
+		 * With sql_analysis_limit set, a big index is
+		 * sampled instead of being scanned:
+		 *
+		 *   stat1_reg = stat_sample(space, index, limit)
+		 *   if stat1_reg is NULL goto full_scan
+		 *   insert into _sql_stat1
+		 *   goto end_of_analysis
+		 *  full_scan:
+		 */
+		int end_label = sqlVdbeMakeLabel(v);
+		int sample_limit = parse->db->nAnalysisLimit;
+		if (sample_limit > 0) {
+			sqlVdbeAddOp2(v, OP_Integer, space->def->id,
+				      stat4_reg + 1);
+			sqlVdbeAddOp2(v, OP_Integer, idx->def->iid,
+				      stat4_reg + 2);
+			sqlVdbeAddOp2(v, OP_Integer, sample_limit,
+				      stat4_reg + 3);
+			sqlVdbeAddOp4(v, OP_Function0, 0, stat4_reg + 1,
+				      stat1_reg, (char *)&statSampleFuncdef,
+				      P4_FUNCDEF);
+			sqlVdbeChangeP5(v, 3);
+			int full_scan_addr =
+				sqlVdbeAddOp1(v, OP_IsNull, stat1_reg);
+			vdbe_emit_stat1_insert(v, stat1, tab_name_reg,
+					       tmp_reg);
+			sqlVdbeGoto(v, end_label);
+			sqlVdbeJumpHere(v, full_scan_addr);
+		}
 		/*
 		 * Invoke the stat_init() function.
 		 * The arguments are:
@@ -993,14 +1137,7 @@ vdbe_emit_analyze_space(struct Parse *parse, struct space *space)
 		sqlVdbeAddOp2(v, OP_Next, idx_cursor, next_row_addr);
 		/* Add the entry to the stat1 table. */
 		callStatGet(v, stat4_reg, STAT_GET_STAT1, stat1_reg);
-		enum field_type types[4] = { FIELD_TYPE_STRING,
-					     FIELD_TYPE_STRING,
-					     FIELD_TYPE_STRING,
-					     field_type_MAX };
-		sqlVdbeAddOp4(v, OP_MakeRecord, tab_name_reg, 4, tmp_reg,
-				  (char *)types, sizeof(types));
-		sqlVdbeAddOp4(v, OP_IdxInsert, tmp_reg, 0, 0,
-				  (char *)stat1, P4_SPACEPTR);
+		vdbe_emit_stat1_insert(v, stat1, tab_name_reg, tmp_reg);
 		/* Add the entries to the stat4 table. */
 		int eq_reg = stat1_reg;
 		int lt_reg = stat1_reg + 1;
@@ -1040,6 +1177,7 @@ vdbe_emit_analyze_space(struct Parse *parse, struct space *space)
 		sqlVdbeJumpHere(v, is_null_addr);
 		/* End of analysis. */
 		sqlVdbeJumpHere(v, rewind_addr);
+		sqlVdbeResolveLabel(v, end_label);
 	}
 }
 
@@ -1601,7 +1739,136 @@ sql_space_tuple_log_count(struct Table *tab)
 	/* If space represents VIEW, return default number. */
 	if (pk == NULL)
 		return DEFAULT_TUPLE_LOG_COUNT;
-	return sqlLogEst(pk->vtab->size(pk));
+	/*
+	 * Vinyl's size() counts statements, including DELETEs,
+	 * so use the estimate, which is O(1) for all engines.
+	 */
+	ssize_t count = index_estimate_count(pk, ITER_ALL, NULL, 0);
+	if (count < 0) {
+		diag_clear(diag_get());
+		return DEFAULT_TUPLE_LOG_COUNT;
+	}
+	return sqlLogEst(count);
+}
+
+/**
+ * The planner samples indexes without statistics collected by
+ * ANALYZE only if they have at least this many tuples. For
+ * smaller ones the default estimates are good enough.
+ */
+enum {
+	SAMPLE_MIN_INDEX_SIZE = 4096,
+	/** Number of random tuples per sampling. */
+	SAMPLE_TUPLE_COUNT = 16,
+	/** Tuples matching a sampled key which are counted. */
+	SAMPLE_MAX_EQ = 1024,
+};
+
+/**
+ * Sample an index to estimate the average number of tuples
+ * with the same first N key parts, for every N. For each of a
+ * few random tuples the tuples matching its key prefixes are
+ * counted, up to SAMPLE_MAX_EQ. Tuples from big groups are
+ * picked more often, so the estimates lean to the pessimistic
+ * side for skewed data, which is fine for a planner.
+ *
+ * The estimates are scaled to DEFAULT_TUPLE_LOG_COUNT, the
+ * size unanalyzed indexes are assumed to have, so that they
+ * keep the proportions against the estimates of the other
+ * indexes.
+ *
+ * @param index Memtx tree index to sample.
+ * @param size Number of tuples in the index.
+ * @param[out] est Estimates, part_count + 1 values.
+ *
+ * @retval 0 Success.
+ * @retval -1 Error, diag is set.
+ */
+static int
+index_sample_tuple_est(struct index *index, ssize_t size, log_est_t *est)
+{
+	struct key_def *key_def = index->def->key_def;
+	uint32_t part_count = key_def->part_count;
+	uint64_t eq_count[part_count + 1];
+	memset(eq_count, 0, sizeof(eq_count));
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t sampled = 0;
+	for (uint32_t i = 0; i < SAMPLE_TUPLE_COUNT; ++i) {
+		struct tuple *tuple;
+		if (index_random(index, rand(), &tuple) != 0)
+			goto error;
+		if (tuple == NULL)
+			break;
+		const char *key = tuple_extract_key(tuple, key_def, NULL);
+		if (key == NULL)
+			goto error;
+		mp_decode_array(&key);
+		for (uint32_t k = 1; k <= part_count; ++k) {
+			struct iterator *it =
+				index_create_iterator(index, ITER_EQ, key, k);
+			if (it == NULL)
+				goto error;
+			uint32_t n = 0;
+			struct tuple *match;
+			while (n < SAMPLE_MAX_EQ &&
+			       iterator_next(it, &match) == 0 && match != NULL)
+				++n;
+			iterator_delete(it);
+			eq_count[k] += n;
+		}
+		++sampled;
+	}
+	region_truncate(region, region_svp);
+	if (sampled == 0)
+		return -1;
+	est[0] = DEFAULT_TUPLE_LOG_COUNT;
+	log_est_t log_size = sqlLogEst(size);
+	for (uint32_t k = 1; k <= part_count; ++k) {
+		log_est_t avg = sqlLogEst(MAX(eq_count[k] / sampled, 1));
+		log_est_t e = DEFAULT_TUPLE_LOG_COUNT - log_size + avg;
+		est[k] = MAX(MIN(e, est[k - 1]), 0);
+	}
+	if (index->def->opts.is_unique)
+		est[part_count] = 0;
+	return 0;
+error:
+	region_truncate(region, region_svp);
+	return -1;
+}
+
+/**
+ * Return estimates sampled from an index without statistics
+ * collected by ANALYZE, or NULL if defaults should be used.
+ * The estimates are sampled anew once the index size, which
+ * engines maintain on every replace, has changed twice since
+ * the last sampling.
+ */
+static const log_est_t *
+index_sampled_tuple_est(struct space *space, struct index *index)
+{
+	if (index->def->type != TREE || !space_is_memtx(space))
+		return NULL;
+	ssize_t size = index_size(index);
+	if (size < SAMPLE_MIN_INDEX_SIZE)
+		return NULL;
+	if (index->sampled_tuple_log_est != NULL &&
+	    size <= 2 * index->sampled_size && 2 * size >= index->sampled_size)
+		return index->sampled_tuple_log_est;
+	uint32_t part_count = index->def->key_def->part_count;
+	size_t est_size = (part_count + 1) * sizeof(log_est_t);
+	log_est_t *est = (log_est_t *) malloc(est_size);
+	if (est == NULL)
+		return index->sampled_tuple_log_est;
+	if (index_sample_tuple_est(index, size, est) != 0) {
+		free(est);
+		diag_clear(diag_get());
+		return index->sampled_tuple_log_est;
+	}
+	free(index->sampled_tuple_log_est);
+	index->sampled_tuple_log_est = est;
+	index->sampled_size = size;
+	return est;
 }
 
 log_est_t
@@ -1624,6 +1891,11 @@ index_field_tuple_est(const struct index_def *idx_def, uint32_t field)
 		if (field == idx_def->key_def->part_count &&
 		    idx_def->opts.is_unique)
 			return 0;
+		const log_est_t *est = NULL;
+		if (field > 0)
+			est = index_sampled_tuple_est(space, tnt_idx);
+		if (est != NULL)
+			return est[field];
 		return default_tuple_est[field + 1 >= 6 ? 6 : field];
 	}
 	return tnt_idx->def->opts.stat->tuple_log_est[field];
@@ -1681,6 +1953,8 @@ stat_copy(struct index_stat *dest, const struct index_stat *src)
 	}
 }
 
+uint32_t sql_stat_version = 0;
+
 int
 sql_analysis_load(struct sql *db)
 {
@@ -1707,6 +1981,7 @@ sql_analysis_load(struct sql *db)
 		goto fail;
 	if (info.index_count == 0) {
 		box_txn_commit();
+		sql_stat_version++;
 		return SQL_OK;
 	}
 	/*
@@ -1767,6 +2042,7 @@ sql_analysis_load(struct sql *db)
 		goto fail;
 	if (box_txn_commit() != 0)
 		return SQL_TARANTOOL_ERROR;
+	sql_stat_version++;
 	return SQL_OK;
 fail:
 	box_txn_rollback();
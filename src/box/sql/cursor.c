@@ -32,10 +32,15 @@
 #include "sqlInt.h"
 #include "tarantoolInt.h"
 #include "box/tuple.h"
+#include "box/index.h"
 
 void
 sql_cursor_cleanup(struct BtCursor *cursor)
 {
+	sql_cursor_batch_drop(cursor);
+	free(cursor->batch);
+	cursor->batch = NULL;
+	cursor->batch_cap = 0;
 	if (cursor->iter)
 		iterator_delete(cursor->iter);
 	if (cursor->last_tuple)
@@ -47,6 +52,15 @@ sql_cursor_cleanup(struct BtCursor *cursor)
 	cursor->eState = CURSOR_INVALID;
 }
 
+void
+sql_cursor_batch_drop(struct BtCursor *cursor)
+{
+	for (uint32_t i = cursor->batch_pos; i < cursor->batch_count; ++i)
+		tuple_unref(cursor->batch[i]);
+	cursor->batch_pos = 0;
+	cursor->batch_count = 0;
+}
+
 /*
  * Initialize memory that will be converted into a BtCursor object.
  */
@@ -65,6 +79,13 @@ sql_cursor_close(struct BtCursor *cursor)
 	if (cursor->curFlags & BTCF_TEphemCursor)
 		tarantoolsqlEphemeralDrop(cursor);
 	sql_cursor_cleanup(cursor);
+	for (uint32_t i = 0; i < cursor->filter_count; ++i) {
+		key_def_delete(cursor->filter[i].key_def);
+		free((char *) cursor->filter[i].value);
+	}
+	free(cursor->filter);
+	cursor->filter = NULL;
+	cursor->filter_count = 0;
 }
 
 #ifndef NDEBUG			/* The next routine used only within assert() statements */
@@ -50,6 +50,28 @@ struct BtCursor {
 	enum iterator_type iter_type;
 	struct tuple *last_tuple;
 	char *key;		/* Saved key that was cursor last known position */
+	/**
+	 * Tuples fetched ahead for a cursor with BTCF_TaBatch
+	 * flag. Every tuple in [batch_pos, batch_count) is
+	 * referenced and is returned by the next advances of
+	 * the cursor.
+	 */
+	struct tuple **batch;
+	uint32_t batch_pos;
+	uint32_t batch_count;
+	/** Number of tuples @batch can hold. */
+	uint32_t batch_cap;
+	/**
+	 * Filters passed to the iterator of the cursor, see
+	 * OP_IteratorFilter. Kept until the cursor is closed.
+	 */
+	struct iterator_filter *filter;
+	uint32_t filter_count;
+	/**
+	 * Fields read from a cursor with BTCF_TaCovering flag,
+	 * see OP_IteratorFields.
+	 */
+	uint64_t field_mask;
 };
 
 void sqlCursorZero(BtCursor *);
@@ -75,6 +97,13 @@ int sqlCursorPayload(BtCursor *, u32 offset, u32 amt, void *);
 void
 sql_cursor_cleanup(struct BtCursor *cursor);
 
+/**
+ * Release tuples fetched ahead by the cursor and not returned
+ * yet. Must be called before the cursor is repositioned.
+ */
+void
+sql_cursor_batch_drop(struct BtCursor *cursor);
+
 #ifndef NDEBUG
 int sqlCursorIsValid(BtCursor *);
 #endif
@@ -85,6 +114,17 @@ int sqlCursorIsValidNN(BtCursor *);
  */
 #define BTCF_TaCursor     0x80	/* Tarantool cursor, pTaCursor valid */
 #define BTCF_TEphemCursor 0x40	/* Tarantool cursor to ephemeral table  */
+#define BTCF_TaBatch      0x20	/* Fetch tuples ahead in batches */
+#define BTCF_TaCovering   0x10	/* Only fields in field_mask are read */
+
+/*
+ * Bounds of the number of tuples fetched at once by a cursor
+ * with BTCF_TaBatch flag. The batch starts small, so that
+ * short scans (e.g. with LIMIT) don't read much ahead, and
+ * doubles with every refill.
+ */
+#define SQL_CURSOR_BATCH_MIN 16
+#define SQL_CURSOR_BATCH_MAX 1024
 
 /*
  * Potential values for BtCursor.eState.
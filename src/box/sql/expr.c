@@ -2536,8 +2536,16 @@ sqlFindInIndex(Parse * pParse,	/* Parsing context */
 
 		} else if (prRhsHasNull) {
 			*prRhsHasNull = rMayHaveNull = ++pParse->nMem;
+		} else {
+			/*
+			 * The table is neither scanned in order
+			 * nor checked for NULLs, so it may be
+			 * hashed.
+			 */
+			ExprSetProperty(pX, EP_InLookup);
 		}
 		sqlCodeSubselect(pParse, pX, rMayHaveNull);
+		ExprClearProperty(pX, EP_InLookup);
 		pParse->nQueryLoop = savedNQueryLoop;
 	} else {
 		pX->iTable = iTab;
@@ -2710,6 +2718,8 @@ sqlCodeSubselect(Parse * pParse,	/* Parsing context */
 			int reg_eph = ++pParse->nMem;
 			addr = sqlVdbeAddOp2(v, OP_OpenTEphemeral,
 						 reg_eph, nVal);
+			if (ExprHasProperty(pExpr, EP_InLookup))
+				sqlVdbeChangeP5(v, OPFLAG_HASH_INDEX);
 			sqlVdbeAddOp3(v, OP_IteratorOpen, pExpr->iTable, 0,
 					  reg_eph);
 			struct sql_key_info *key_info = sql_key_info_new(pParse->db, nVal);
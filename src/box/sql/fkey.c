@@ -184,6 +184,13 @@
  * These operations are identified in the comment at the top of
  * this file as "I.1" and "D.1".
  *
+ * When rows are inserted into a child table without triggers,
+ * nothing can delete a parent row in the middle of the
+ * statement. So the key of the last parent row found is kept
+ * in a register and consecutive child rows referring to the
+ * same parent skip the lookup. It makes bulk loads sorted by
+ * the parent key probe each parent only once.
+ *
  * @param parse_context Current parsing context.
  * @param parent Parent table of FK constraint.
  * @param fk_def FK constraint definition.
@@ -252,11 +259,12 @@ fkey_lookup_parent(struct Parse *parse_context, struct space *parent,
 	 * And since the foreign key has already detected a
 	 * conflict, fk counter must be increased.
 	 */
+	int found_label = ok_label;
+	int rec_reg = 0;
+	int cache_reg = 0;
 	if (!(fkey_is_self_referenced(fk_def) && is_update)) {
 		int temp_regs = sqlGetTempRange(parse_context, field_count);
-		int rec_reg = sqlGetTempReg(parse_context);
-		vdbe_emit_open_cursor(parse_context, cursor, referenced_idx,
-				      parent);
+		rec_reg = sqlGetTempReg(parse_context);
 		link = fk_def->links;
 		for (uint32_t i = 0; i < field_count; ++i, ++link) {
 			sqlVdbeAddOp2(v, OP_Copy,
@@ -270,8 +278,22 @@ fkey_lookup_parent(struct Parse *parse_context, struct space *parent,
 				  (char *) sql_index_type_str(parse_context->db,
 							      idx->def),
 				  P4_DYNAMIC);
-		sqlVdbeAddOp4Int(v, OP_Found, cursor, ok_label, rec_reg, 0);
-		sqlReleaseTempReg(parse_context, rec_reg);
+		struct space *child = space_by_id(fk_def->child_id);
+		assert(child != NULL);
+		if (incr_count > 0 && !is_update &&
+		    !fkey_is_self_referenced(fk_def) &&
+		    child->sql_triggers == NULL) {
+			cache_reg = ++parse_context->nMem;
+			int addr_once = sqlVdbeAddOp0(v, OP_Once);
+			sqlVdbeAddOp2(v, OP_Null, 0, cache_reg);
+			sqlVdbeJumpHere(v, addr_once);
+			sqlVdbeAddOp3(v, OP_Eq, cache_reg, ok_label, rec_reg);
+			found_label = sqlVdbeMakeLabel(v);
+		}
+		vdbe_emit_open_cursor(parse_context, cursor, referenced_idx,
+				      parent);
+		sqlVdbeAddOp4Int(v, OP_Found, cursor, found_label, rec_reg, 0);
+		sqlVdbeChangeP5(v, SQL_STMTSTATUS_FK_CHECK);
 		sqlReleaseTempRange(parse_context, temp_regs, field_count);
 	}
 	struct session *session = current_session();
@@ -297,8 +319,15 @@ fkey_lookup_parent(struct Parse *parse_context, struct space *parent,
 		sqlVdbeAddOp2(v, OP_FkCounter, fk_def->is_deferred,
 				  incr_count);
 	}
+	if (cache_reg != 0) {
+		sqlVdbeGoto(v, ok_label);
+		sqlVdbeResolveLabel(v, found_label);
+		sqlVdbeAddOp2(v, OP_Copy, rec_reg, cache_reg);
+	}
 	sqlVdbeResolveLabel(v, ok_label);
 	sqlVdbeAddOp1(v, OP_Close, cursor);
+	if (rec_reg != 0)
+		sqlReleaseTempReg(parse_context, rec_reg);
 }
 
 /*
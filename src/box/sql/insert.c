@@ -107,7 +107,8 @@ sql_space_autoinc_fieldno(struct space *space)
  * SELECT.
  *
  * @param parser Parse context.
- * @param table Table AST object.
+ * @param table Table AST object or NULL to check for any
+ *        non-ephemeral space.
  * @retval  true if the table table in database or any of its
  *          indices have been opened at any point in the VDBE
  *          program.
@@ -131,7 +132,7 @@ vdbe_has_table_read(struct Parse *parser, const struct Table *table)
 				space = op->p4.space;
 			else
 				continue;
-			if (space->def->id == table->def->id)
+			if (table == NULL || space->def->id == table->def->id)
 				return true;
 		}
 	}
@@ -446,10 +447,13 @@ sqlInsert(Parse * pParse,	/* Parser context */
 		 *
 		 * A temp table must be used if the table being
 		 * updated is also one of the tables being read by
-		 * the SELECT statement. Also use a temp table in
-		 * the case of row triggers.
+		 * the SELECT statement. In the case of row
+		 * triggers any table read by the SELECT may be
+		 * changed by them, but a multi-row VALUES list or
+		 * any other SELECT which reads no tables at all
+		 * is still inserted row by row without staging.
 		 */
-		if (trigger != NULL || vdbe_has_table_read(pParse, pTab))
+		if (vdbe_has_table_read(pParse, trigger != NULL ? NULL : pTab))
 			useTempTable = 1;
 
 		if (useTempTable) {
@@ -573,8 +577,7 @@ sqlInsert(Parse * pParse,	/* Parser context */
 						break;
 				}
 			}
-			if ((!useTempTable && !pList)
-			    || (pColumn && j >= pColumn->nId)) {
+			if (nColumn == 0 || (pColumn && j >= pColumn->nId)) {
 				if (i == (int) autoinc_fieldno) {
 					sqlVdbeAddOp2(v, OP_Integer, -1,
 							  regCols + i + 1);
@@ -590,8 +593,10 @@ sqlInsert(Parse * pParse,	/* Parser context */
 			} else if (useTempTable) {
 				sqlVdbeAddOp3(v, OP_Column, srcTab, j,
 						  regCols + i + 1);
+			} else if (pSelect) {
+				sqlVdbeAddOp2(v, OP_Copy, regFromSelect + j,
+						  regCols + i + 1);
 			} else {
-				assert(pSelect == 0);	/* Otherwise useTempTable is true */
 				sqlExprCodeAndCache(pParse,
 							pList->a[j].pExpr,
 							regCols + i + 1);
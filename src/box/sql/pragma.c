@@ -621,6 +621,23 @@ sqlPragma(Parse * pParse, Token * pId,	/* First part of [schema.]id field */
 		break;
 	}
 
+	/*
+	 *   PRAGMA sql_analysis_limit
+	 *   PRAGMA sql_analysis_limit = N
+	 *
+	 * Make ANALYZE estimate statistics of an index bigger
+	 * than N tuples from N random tuples instead of scanning
+	 * it. 0 (the default) turns sampling off.
+	 */
+	case PragTyp_ANALYSIS_LIMIT: {
+		if (zRight != NULL) {
+			int limit = sqlAtoi(zRight);
+			db->nAnalysisLimit = limit > 0 ? limit : 0;
+		}
+		returnSingleInt(v, db->nAnalysisLimit);
+		break;
+	}
+
 	/* *   PRAGMA busy_timeout *   PRAGMA busy_timeout = N *
 	 *
 	 * Call sql_busy_timeout(db, N).  Return the current
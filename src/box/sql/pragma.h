@@ -17,6 +17,7 @@
 #define PragTyp_PARSER_TRACE                  24
 #define PragTyp_DEFAULT_ENGINE                25
 #define PragTyp_COMPOUND_SELECT_LIMIT         26
+#define PragTyp_ANALYSIS_LIMIT                27
 
 /* Property flags associated with various pragma. */
 #define PragFlg_NeedSchema 0x01	/* Force schema load before running */
@@ -87,6 +88,13 @@ typedef struct PragmaName {
  * to be sorted. For more info see pragma_locate function.
  */
 static const PragmaName aPragmaName[] = {
+#if !defined(SQL_OMIT_FLAG_PRAGMAS) && !defined(SQL_OMIT_AUTOMATIC_INDEX)
+	{ /* zName:     */ "automatic_index",
+	 /* ePragTyp:  */ PragTyp_FLAG,
+	 /* ePragFlg:  */ PragFlg_Result0 | PragFlg_NoColumns1,
+	 /* ColNames:  */ 0, 0,
+	 /* iArg:      */ SQL_AutoIndex},
+#endif
 	{ /* zName:     */ "busy_timeout",
 	 /* ePragTyp:  */ PragTyp_BUSY_TIMEOUT,
 	 /* ePragFlg:  */ PragFlg_Result0,
@@ -190,6 +198,11 @@ static const PragmaName aPragmaName[] = {
 	 /* ColNames:  */ 0, 0,
 	 /* iArg:      */ SQL_ShortColNames},
 #endif
+	{ /* zName:     */ "sql_analysis_limit",
+	/* ePragTyp:  */ PragTyp_ANALYSIS_LIMIT,
+	/* ePragFlg:  */ PragFlg_Result0,
+	/* ColNames:  */ 0, 0,
+	/* iArg:      */ 0},
 	{ /* zName:     */ "sql_compound_select_limit",
 	/* ePragTyp:  */ PragTyp_COMPOUND_SELECT_LIMIT,
 	/* ePragFlg:  */ PragFlg_Result0,
@@ -264,4 +277,4 @@ static const PragmaName aPragmaName[] = {
 	/* iArg:      */ SQL_WhereTrace},
 #endif
 };
-/* Number of pragmas: 36 on by default, 47 total. */
+/* Number of pragmas: 37 on by default, 48 total. */
@@ -712,6 +712,7 @@ pushOntoSorter(Parse * pParse,		/* Parser context */
 	int regRecord = ++pParse->nMem;	/* Assembled sorter record */
 	int nOBSat = pSort->nOBSat;	/* ORDER BY terms to skip */
 	int iLimit;		/* LIMIT counter */
+	int iSkip = 0;		/* Jump to skip a row not fitting LIMIT */
 
 	assert(bSeq == 0 || bSeq == 1);
 	assert(nData == 1 || regData == regOrigData || regOrigData == 0);
@@ -736,8 +737,6 @@ pushOntoSorter(Parse * pParse,		/* Parser context */
 		sqlExprCodeMove(pParse, regData, regBase + nExpr + bSeq,
 				    nData);
 	}
-	sqlVdbeAddOp3(v, OP_MakeRecord, regBase + nOBSat, nBase - nOBSat,
-			  regRecord);
 	if (nOBSat > 0) {
 		int regPrevKey;	/* The first nOBSat columns of the previous row */
 		int addrFirst;	/* Address of the OP_IfNot opcode */
@@ -787,6 +786,35 @@ pushOntoSorter(Parse * pParse,		/* Parser context */
 		sqlExprCodeMove(pParse, regBase, regPrevKey, pSort->nOBSat);
 		sqlVdbeJumpHere(v, addrJmp);
 	}
+	if (iLimit) {
+		/*
+		 * Once the sorter holds LIMIT+OFFSET entries, a new
+		 * row is only inserted if it goes before the last
+		 * of them, which is deleted afterwards. Otherwise
+		 * the row is skipped without being packed into a
+		 * record and inserted into the sorter only to be
+		 * deleted right away.
+		 */
+		int addrFull = sqlVdbeAddOp1(v, OP_If, iLimit);
+		VdbeCoverage(v);
+		if (pSort->sortFlags & SORTFLAG_DESC) {
+			int iNextInstr = sqlVdbeCurrentAddr(v) + 2;
+			sqlVdbeAddOp2(v, OP_Rewind, pSort->iECursor,
+				      iNextInstr);
+			iSkip = sqlVdbeAddOp4Int(v, OP_IdxGE, pSort->iECursor,
+						 0, regBase + nOBSat,
+						 nExpr - nOBSat);
+		} else {
+			sqlVdbeAddOp1(v, OP_Last, pSort->iECursor);
+			iSkip = sqlVdbeAddOp4Int(v, OP_IdxLE, pSort->iECursor,
+						 0, regBase + nOBSat,
+						 nExpr - nOBSat);
+		}
+		VdbeCoverage(v);
+		sqlVdbeJumpHere(v, addrFull);
+	}
+	sqlVdbeAddOp3(v, OP_MakeRecord, regBase + nOBSat, nBase - nOBSat,
+			  regRecord);
 	if (pSort->sortFlags & SORTFLAG_UseSorter) {
 		sqlVdbeAddOp2(v, OP_SorterInsert, pSort->iECursor,
 				  regRecord);
@@ -831,6 +859,8 @@ pushOntoSorter(Parse * pParse,		/* Parser context */
 		}
 		sqlVdbeJumpHere(v, addr);
 	}
+	if (iSkip)
+		sqlVdbeJumpHere(v, iSkip);
 }
 
 /*
@@ -4404,6 +4434,186 @@ is_simple_count(struct Select *select, struct AggInfo *agg_info)
 	return space;
 }
 
+/**
+ * Check if a WHERE condition is an AND of comparisons of columns
+ * of table @a cursor defined by @a def with literals, which OP_ScanAggregate can
+ * evaluate itself: numeric columns are compared with numbers and
+ * string columns with strings. Store the comparisons to
+ * @a terms, unless there are more than @a max of them.
+ *
+ * @retval Number of the comparisons or -1 if @a expr doesn't
+ *         fit.
+ */
+static int
+scan_agg_collect_filters(struct Expr *expr, struct space_def *def, int cursor,
+			 struct Expr **terms, int count, int max)
+{
+	if (expr->op == TK_AND) {
+		count = scan_agg_collect_filters(expr->pLeft, def, cursor,
+						 terms, count, max);
+		if (count < 0)
+			return -1;
+		return scan_agg_collect_filters(expr->pRight, def, cursor,
+						terms, count, max);
+	}
+	switch (expr->op) {
+	case TK_EQ:
+	case TK_LT:
+	case TK_LE:
+	case TK_GE:
+	case TK_GT:
+		break;
+	default:
+		return -1;
+	}
+	struct Expr *column = expr->pLeft;
+	struct Expr *value = expr->pRight;
+	if (column->op != TK_COLUMN)
+		SWAP(column, value);
+	if (column->op != TK_COLUMN || column->iTable != cursor ||
+	    column->iColumn < 0 || count == max)
+		return -1;
+	struct field_def *field = &def->fields[column->iColumn];
+	if (value->op == TK_STRING) {
+		if (field->type != FIELD_TYPE_STRING)
+			return -1;
+	} else if (value->op != TK_INTEGER && value->op != TK_FLOAT) {
+		return -1;
+	} else if (field->type != FIELD_TYPE_INTEGER &&
+		   field->type != FIELD_TYPE_UNSIGNED &&
+		   field->type != FIELD_TYPE_NUMBER) {
+		return -1;
+	}
+	terms[count] = expr;
+	return count + 1;
+}
+
+/**
+ * Check if an aggregate query without GROUP BY is of the form
+ *
+ *   SELECT <aggregates> FROM <tbl> [WHERE <filters>]
+ *
+ * where the table is a memtx space with a tree primary index,
+ * each aggregate is count(*), count(x), sum(x), total(x) or
+ * avg(x) of a column and the filters are comparisons which
+ * scan_agg_collect_filters() accepts. If so, code the literals
+ * of the filters and return the description of the aggregates
+ * for OP_ScanAggregate.
+ *
+ * @param parse Parsing context.
+ * @param select The select statement in form of aggregate query.
+ * @param agg_info The associated aggregate-info object.
+ * @param[out] space Aggregated space.
+ * @retval Aggregates allocated with sqlDbMalloc() or NULL.
+ */
+static struct scan_agg *
+scan_agg_prepare(struct Parse *parse, struct Select *select,
+		 struct AggInfo *agg_info, struct space **space)
+{
+	enum { MAX_FILTERS = 16 };
+	assert(select->pGroupBy == NULL);
+	struct SrcList_item *src = &select->pSrc->a[0];
+	if (select->pSrc->nSrc != 1 || src->pSelect != NULL ||
+	    agg_info->nAccumulator != 0 || agg_info->nFunc == 0)
+		return NULL;
+	*space = space_by_id(src->pTab->def->id);
+	assert(*space != NULL && !(*space)->def->opts.is_view);
+	if (!space_is_memtx(*space) || (*space)->index_count == 0 ||
+	    (*space)->index[0]->def->type != TREE)
+		return NULL;
+	struct space_def *def = (*space)->def;
+	for (int i = 0; i < agg_info->nFunc; i++) {
+		struct AggInfo_func *func = &agg_info->aFunc[i];
+		const char *name = func->pFunc->zName;
+		if (sqlStrICmp(name, "count") != 0 &&
+		    sqlStrICmp(name, "sum") != 0 &&
+		    sqlStrICmp(name, "total") != 0 &&
+		    sqlStrICmp(name, "avg") != 0)
+			return NULL;
+		if (ExprHasProperty(func->pExpr, EP_Distinct))
+			return NULL;
+		struct ExprList *args = func->pExpr->x.pList;
+		if (args == NULL) {
+			if (sqlStrICmp(name, "count") != 0)
+				return NULL;
+			continue;
+		}
+		struct Expr *arg = args->a[0].pExpr;
+		if (args->nExpr != 1 || (arg->op != TK_COLUMN &&
+		    arg->op != TK_AGG_COLUMN) || arg->iTable != src->iCursor ||
+		    arg->iColumn < 0)
+			return NULL;
+		enum field_type type = def->fields[arg->iColumn].type;
+		if (sqlStrICmp(name, "count") != 0 &&
+		    type != FIELD_TYPE_INTEGER &&
+		    type != FIELD_TYPE_UNSIGNED && type != FIELD_TYPE_NUMBER)
+			return NULL;
+	}
+	struct Expr *terms[MAX_FILTERS];
+	int filter_count = 0;
+	if (select->pWhere != NULL) {
+		filter_count = scan_agg_collect_filters(select->pWhere, def,
+							src->iCursor, terms,
+							0, MAX_FILTERS);
+		if (filter_count < 0)
+			return NULL;
+	}
+	size_t size = sizeof(struct scan_agg) +
+		      filter_count * sizeof(struct scan_agg_filter) +
+		      agg_info->nFunc * sizeof(struct scan_agg_item);
+	struct scan_agg *agg =
+		(struct scan_agg *) sqlDbMallocZero(parse->db, size);
+	if (agg == NULL)
+		return NULL;
+	agg->filters = (struct scan_agg_filter *) (agg + 1);
+	agg->filter_count = filter_count;
+	agg->items = (struct scan_agg_item *) (agg->filters + filter_count);
+	agg->item_count = agg_info->nFunc;
+	for (int i = 0; i < filter_count; i++) {
+		struct Expr *column = terms[i]->pLeft;
+		struct Expr *value = terms[i]->pRight;
+		int op = terms[i]->op;
+		if (column->op != TK_COLUMN) {
+			SWAP(column, value);
+			if (op == TK_LT)
+				op = TK_GT;
+			else if (op == TK_LE)
+				op = TK_GE;
+			else if (op == TK_GE)
+				op = TK_LE;
+			else if (op == TK_GT)
+				op = TK_LT;
+		}
+		struct scan_agg_filter *filter = &agg->filters[i];
+		filter->fieldno = column->iColumn;
+		filter->op = op;
+		filter->coll_id = def->fields[column->iColumn].coll_id;
+		filter->reg = ++parse->nMem;
+		sqlExprCode(parse, value, filter->reg);
+	}
+	for (int i = 0; i < agg_info->nFunc; i++) {
+		struct AggInfo_func *func = &agg_info->aFunc[i];
+		const char *name = func->pFunc->zName;
+		struct ExprList *args = func->pExpr->x.pList;
+		struct scan_agg_item *item = &agg->items[i];
+		item->reg = func->iMem;
+		if (args == NULL) {
+			item->func = SCAN_AGG_COUNT_ALL;
+			continue;
+		}
+		item->fieldno = args->a[0].pExpr->iColumn;
+		if (sqlStrICmp(name, "count") == 0)
+			item->func = SCAN_AGG_COUNT;
+		else if (sqlStrICmp(name, "sum") == 0)
+			item->func = SCAN_AGG_SUM;
+		else if (sqlStrICmp(name, "total") == 0)
+			item->func = SCAN_AGG_TOTAL;
+		else
+			item->func = SCAN_AGG_AVG;
+	}
+	return agg;
+}
+
 /*
  * If the source-list item passed as an argument was augmented with an
  * INDEXED BY clause, then try to locate the specified index. If there
@@ -5279,6 +5489,7 @@ resetAccumulator(Parse * pParse, AggInfo * pAggInfo)
 				sqlVdbeAddOp4(v, OP_OpenTEphemeral,
 						  pFunc->reg_eph, 1, 0,
 						  (char *)key_info, P4_KEYINFO);
+				sqlVdbeChangeP5(v, OPFLAG_HASH_INDEX);
 				sqlVdbeAddOp3(v, OP_IteratorOpen,
 						  pFunc->iDistinct, 0, pFunc->reg_eph);
 			}
@@ -5849,6 +6060,8 @@ sqlSelect(Parse * pParse,		/* The parser context */
 						       key_info->part_count,
 						       0, (char *)key_info,
 						       P4_KEYINFO);
+		/* The table is only probed with OP_Found. */
+		sqlVdbeChangeP5(v, OPFLAG_HASH_INDEX);
 		sqlVdbeAddOp3(v, OP_IteratorOpen, sDistinct.cur_eph, 0,
 				  sDistinct.reg_eph);
 		VdbeComment((v, "Distinct table"));
@@ -6343,6 +6556,27 @@ sqlSelect(Parse * pParse,		/* The parser context */
 					}
 				}
 
+				/*
+				 * Big memtx spaces are aggregated in
+				 * the coio thread pool if possible,
+				 * see OP_ScanAggregate.
+				 */
+				int addr_scan_done = 0;
+				struct space *agg_space;
+				struct scan_agg *scan_agg = flag != 0 ? NULL :
+					scan_agg_prepare(pParse, p, &sAggInfo,
+							 &agg_space);
+				if (scan_agg != NULL) {
+					const int cursor = pParse->nTab++;
+					vdbe_emit_open_cursor(pParse, cursor, 0,
+							      agg_space);
+					addr_scan_done = sqlVdbeMakeLabel(v);
+					sqlVdbeAddOp4(v, OP_ScanAggregate,
+						      cursor, addr_scan_done, 0,
+						      (char *) scan_agg,
+						      P4_DYNAMIC);
+				}
+
 				/* This case runs if the aggregate has no GROUP BY clause.  The
 				 * processing is much simpler since there is only a single row
 				 * of output.
@@ -6369,6 +6603,8 @@ sqlSelect(Parse * pParse,		/* The parser context */
 				sqlWhereEnd(pWInfo);
 				finalizeAggFunctions(pParse, &sAggInfo);
 				sql_expr_list_delete(db, pDel);
+				if (addr_scan_done != 0)
+					sqlVdbeResolveLabel(v, addr_scan_done);
 			}
 
 			sSort.pOrderBy = 0;
@@ -890,6 +890,7 @@ sql_free_table(char **result);
 #define SQL_STMTSTATUS_SORT              2
 #define SQL_STMTSTATUS_AUTOINDEX         3
 #define SQL_STMTSTATUS_VM_STEP           4
+#define SQL_STMTSTATUS_FK_CHECK          5
 
 void
 sql_interrupt(sql *);
@@ -935,6 +936,9 @@ sql_bind_zeroblob64(sql_stmt *, int,
 int
 sql_stmt_busy(sql_stmt *);
 
+size_t
+sql_stmt_est_size(const sql_stmt *stmt);
+
 int
 sql_init_db(sql **db);
 
@@ -1522,6 +1526,11 @@ struct sql {
 	int nChange;
 	int aLimit[SQL_N_LIMIT];	/* Limits */
 	int nMaxSorterMmap;	/* Maximum size of regions mapped by sorter */
+	/**
+	 * Number of tuples ANALYZE samples from an index
+	 * instead of scanning it, 0 to always scan.
+	 */
+	int nAnalysisLimit;
 	struct sqlInitInfo {	/* Information used during initialization */
 		uint32_t space_id;
 		uint32_t index_id;
@@ -2154,6 +2163,7 @@ struct Expr {
 #define EP_DblQuoted 0x000040	/* token.z was originally in "..." */
 #define EP_InfixFunc 0x000080	/* True for an infix function: LIKE, etc */
 #define EP_Collate   0x000100	/* Tree contains a TK_COLLATE operator */
+#define EP_InLookup  0x000200	/* IN RHS is only probed by equality */
 #define EP_IntValue  0x000400	/* Integer value contained in u.iValue */
 #define EP_xIsSelect 0x000800	/* x.pSelect is valid (otherwise x.pList is) */
 #define EP_Skip      0x001000	/* COLLATE, AS, or UNLIKELY */
@@ -2830,6 +2840,7 @@ struct Parse {
 #define OPFLAG_TYPEOFARG     0x80	/* OP_Column only used for typeof() */
 #define OPFLAG_SEEKEQ        0x02	/* OP_Open** cursor uses EQ seek only */
 #define OPFLAG_FORDELETE     0x08	/* OP_Open should use BTREE_FORDELETE */
+#define OPFLAG_HASH_INDEX    0x08	/* OP_OpenTEphemeral: use HASH index */
 #define OPFLAG_P2ISREG       0x10	/* P2 to OP_Open** is a register number */
 #define OPFLAG_PERMUTE       0x01	/* OP_Compare: use the permutation */
 #define OPFLAG_SAVEPOSITION  0x02	/* OP_Delete: keep cursor position */
@@ -2844,6 +2855,10 @@ struct Parse {
 #define OPFLAG_SYSTEMSP      0x20	/* OP_Open**: set if space pointer
 					 * points to system space.
 					 */
+#define OPFLAG_SCAN_BATCH    0x04	/* OP_IteratorOpen: the cursor
+					 * is only scanned forward and
+					 * can fetch tuples ahead.
+					 */
 
 /**
  * Prepare vdbe P5 flags for OP_{IdxInsert, IdxReplace, Update}
@@ -3574,6 +3589,21 @@ sql_table_delete_from(struct Parse *parse, struct SrcList *tab_list,
 void
 sql_table_truncate(struct Parse *parse, struct SrcList *tab_list);
 
+/**
+ * A field update passed to OP_Update and executed as a
+ * tuple_update() operation.
+ */
+struct sql_update_op {
+	/** Number of the updated field. */
+	uint32_t fieldno;
+	/**
+	 * tuple_update() operation: '=' to assign the new
+	 * value of the field, '+' or '-' to add or subtract
+	 * it from the old one.
+	 */
+	char op;
+};
+
 void sqlUpdate(Parse *, SrcList *, ExprList *, Expr *,
 		   enum on_conflict_action);
 WhereInfo *sqlWhereBegin(Parse *, SrcList *, Expr *, ExprList *, ExprList *,
@@ -4508,6 +4538,13 @@ sql_index_tuple_size(struct space *space, struct index *idx);
 int
 sql_analysis_load(struct sql *db);
 
+/**
+ * Version of the index statistics, bumped each time they are
+ * reloaded. Cached statements compiled with older statistics
+ * are recompiled to get the planner to choose a new plan.
+ */
+extern uint32_t sql_stat_version;
+
 /**
  * An instance of the following structure controls how keys
  * are compared by VDBE, see P4_KEYINFO.
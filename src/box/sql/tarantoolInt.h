@@ -30,6 +30,25 @@ const void *tarantoolsqlPayloadFetch(BtCursor * pCur, u32 * pAmt);
 const void *
 tarantoolsqlTupleColumnFast(BtCursor *pCur, u32 fieldno, u32 *field_size);
 
+/**
+ * Make the iterator of a cursor skip tuples whose field doesn't
+ * compare with a value as the given iterator type requires. The
+ * cursor must not be positioned yet.
+ *
+ * @param cur Cursor to add the filter to.
+ * @param fieldno Number of the checked field.
+ * @param type Type the field is compared as.
+ * @param coll_id Collation of the field.
+ * @param op ITER_EQ, ITER_LT, ITER_LE, ITER_GE or ITER_GT.
+ * @param value Value the field is compared with.
+ *
+ * @retval 0 on success, -1 on memory error.
+ */
+int
+sql_cursor_add_filter(struct BtCursor *cur, uint32_t fieldno,
+		      enum field_type type, uint32_t coll_id,
+		      enum iterator_type op, struct Mem *value);
+
 int tarantoolsqlFirst(BtCursor * pCur, int *pRes);
 int tarantoolsqlLast(BtCursor * pCur, int *pRes);
 int tarantoolsqlNext(BtCursor * pCur, int *pRes);
@@ -83,11 +102,15 @@ int tarantoolsqlRenameTrigger(const char *zTriggerName,
  *
  * @param field_count Number of fields in ephemeral space.
  * @param key_info Keys description for new ephemeral space.
+ * @param is_hash Build a HASH primary index instead of TREE.
+ *        Such a space can only be probed with a full key and
+ *        can't be iterated in order.
  *
  * @retval Pointer to created space, NULL if error.
  */
 struct space *
-sql_ephemeral_space_create(uint32_t filed_count, struct sql_key_info *key_info);
+sql_ephemeral_space_create(uint32_t filed_count, struct sql_key_info *key_info,
+			   bool is_hash);
 
 /**
  * Insert tuple into ephemeral space.
@@ -66,6 +66,48 @@ sqlColumnDefault(Vdbe *v, struct space_def *def, int i, int ireg)
 	}
 }
 
+/**
+ * Check if an UPDATE of column @a fieldno with expression
+ * @a expr may be done with a tuple_update() arithmetic
+ * operation, i.e. the expression is "col + value",
+ * "value + col" or "col - value", where value does not depend
+ * on the row. The column must be NOT NULL and of INTEGER type,
+ * so the arithmetic has the same result in SQL and in
+ * tuple_update() and the value alone may be checked with the
+ * NOT NULL constraint and the column type.
+ *
+ * @param expr SET expression of the column.
+ * @param cursor Cursor the table columns are resolved to.
+ * @param def Space definition.
+ * @param fieldno Updated column number.
+ * @param[out] op '+' or '-'.
+ *
+ * @retval Value expression to pass to the operation.
+ * @retval NULL The column must be assigned.
+ */
+static struct Expr *
+update_arith_operand(struct Expr *expr, int cursor, struct space_def *def,
+		     int fieldno, char *op)
+{
+	struct field_def *field = &def->fields[fieldno];
+	if (field->type != FIELD_TYPE_INTEGER || field->is_nullable ||
+	    field->nullable_action == ON_CONFLICT_ACTION_REPLACE)
+		return NULL;
+	if (expr->op != TK_PLUS && expr->op != TK_MINUS)
+		return NULL;
+	struct Expr *column = expr->pLeft;
+	struct Expr *value = expr->pRight;
+	if (expr->op == TK_PLUS && value->op == TK_COLUMN) {
+		column = expr->pRight;
+		value = expr->pLeft;
+	}
+	if (column->op != TK_COLUMN || column->iTable != cursor ||
+	    column->iColumn != fieldno || !sqlExprIsConstant(value))
+		return NULL;
+	*op = expr->op == TK_PLUS ? '+' : '-';
+	return value;
+}
+
 /*
  * Process an UPDATE statement.
  *
@@ -203,6 +245,25 @@ sqlUpdate(Parse * pParse,		/* The parser context */
 	pTabList->a[0].colUsed = 0;
 
 	hasFK = fkey_is_required(pTab->def->id, aXRef);
+	/*
+	 * A plain UPDATE needs neither the old row nor unchanged
+	 * fields of the new one: box_update() gets the changed
+	 * fields only and does the rest on its own. Triggers,
+	 * foreign keys, CHECK constraints and REPLACE or IGNORE
+	 * conflict handling work with whole rows though.
+	 */
+	bool is_plain_update = !is_view && trigger == NULL && hasFK == 0 &&
+			       !is_pk_modified &&
+			       on_error != ON_CONFLICT_ACTION_REPLACE &&
+			       on_error != ON_CONFLICT_ACTION_IGNORE &&
+			       space_checks_expr_list(def->id) == NULL;
+	/* tuple_update() operations for changed fields. */
+	char *upd_ops = region_alloc(&pParse->region, def->field_count);
+	if (upd_ops == NULL) {
+		diag_set(OutOfMemory, def->field_count, "region_alloc",
+			 "upd_ops");
+		goto update_cleanup;
+	}
 
 	/* Begin generating code. */
 	v = sqlGetVdbe(pParse);
@@ -372,8 +433,25 @@ sqlUpdate(Parse * pParse,		/* The parser context */
 	for (i = 0; i < (int)def->field_count; i++) {
 		j = aXRef[i];
 		if (j >= 0) {
-			sqlExprCode(pParse, pChanges->a[j].pExpr,
-					regNew + i);
+			struct Expr *expr = pChanges->a[j].pExpr;
+			struct Expr *value = NULL;
+			upd_ops[i] = '=';
+			if (is_plain_update) {
+				value = update_arith_operand(expr, pk_cursor,
+							     def, i,
+							     &upd_ops[i]);
+			}
+			/*
+			 * For an arithmetic operation the register
+			 * holds the operand rather than the new
+			 * value. It is still subject to NOT NULL
+			 * and type checks, which fail exactly when
+			 * they would fail for the result.
+			 */
+			sqlExprCode(pParse, value != NULL ? value : expr,
+				    regNew + i);
+		} else if (is_plain_update) {
+			sqlVdbeAddOp2(v, OP_Null, 0, regNew + i);
 		} else if (0 == (tmask & TRIGGER_BEFORE) || i > 31
 			   || (newmask & MASKBIT32(i))) {
 			/* This branch loads the value of a column that will not be changed
@@ -474,15 +552,19 @@ sqlUpdate(Parse * pParse,		/* The parser context */
 			}
 
 			/* Prepare array of changed fields. */
-			uint32_t upd_cols_sz = upd_cols_cnt * sizeof(uint32_t);
-			uint32_t *upd_cols = sqlDbMallocRaw(db, upd_cols_sz);
+			uint32_t upd_cols_sz =
+				upd_cols_cnt * sizeof(struct sql_update_op);
+			struct sql_update_op *upd_cols =
+				sqlDbMallocRaw(db, upd_cols_sz);
 			if (upd_cols == NULL)
 				goto update_cleanup;
 			upd_cols_cnt = 0;
 			for (uint32_t i = 0; i < def->field_count; i++) {
 				if (aXRef[i] == -1)
 					continue;
-				upd_cols[upd_cols_cnt++] = i;
+				upd_cols[upd_cols_cnt].fieldno = i;
+				upd_cols[upd_cols_cnt].op = upd_ops[i];
+				upd_cols_cnt++;
 			}
 			int upd_cols_reg = sqlGetTempReg(pParse);
 			sqlVdbeAddOp4(v, OP_Blob, upd_cols_sz, upd_cols_reg,
@@ -569,6 +569,52 @@ registerTrace(int iReg, Mem *p) {
 
 #endif
 
+/*
+ * Some opcodes almost always come in fixed sequences: a seek is
+ * followed by an index range check, a range check by column
+ * reads, and a column read by another one, by a comparison or
+ * by OP_ResultRow. At the end of such an opcode the next one is
+ * checked against the prediction and, on a hit, its code is
+ * jumped to directly, skipping the loop header and the switch
+ * dispatch. The switch jump is a single indirect branch shared
+ * by all opcodes, so it's predicted poorly by the CPU, while a
+ * predicted jump has its own branch, so a hot sequence runs as
+ * one superinstruction.
+ *
+ * Debugging, profiling and testing code lives in the loop
+ * header, so there the prediction is disabled.
+ */
+#if defined(SQL_DEBUG) || defined(VDBE_PROFILE) || \
+    defined(SQL_ENABLE_STMT_SCANSTATUS) || defined(SQL_TEST)
+#  define VDBE_PREDICT_ENABLED 0
+#else
+#  define VDBE_PREDICT_ENABLED 1
+#endif
+
+#define VDBE_PREDICT(is_predicted, label) do {				\
+	if (VDBE_PREDICT_ENABLED && (is_predicted)) {			\
+		pOp++;							\
+		nVmStep++;						\
+		goto label;						\
+	}								\
+} while (0)
+
+/** Check if @a opcode is a comparison: OP_Eq, OP_Lt, etc. */
+static inline bool
+vdbe_op_is_compare(u8 opcode)
+{
+	return opcode == OP_Eq || opcode == OP_Ne || opcode == OP_Lt ||
+	       opcode == OP_Le || opcode == OP_Gt || opcode == OP_Ge;
+}
+
+/** Check if @a opcode is an index check: OP_IdxGT, etc. */
+static inline bool
+vdbe_op_is_idx_compare(u8 opcode)
+{
+	return opcode == OP_IdxLE || opcode == OP_IdxGT ||
+	       opcode == OP_IdxLT || opcode == OP_IdxGE;
+}
+
 /*
  * Return the register of pOp->p2 after first preparing it to be
  * overwritten with an integer value.
@@ -1427,6 +1473,7 @@ case OP_IntCopy: {            /* out2 */
  * structure to provide access to the r(P1)..r(P1+P2-1) values as
  * the result row.
  */
+			op_result_row:
 case OP_ResultRow: {
 	Mem *pMem;
 	int i;
@@ -1635,6 +1682,7 @@ case OP_Remainder: {           /* same as TK_REM, in1, in2, out3 */
 		}
 		pOut->u.i = iB;
 		MemSetTypeFlag(pOut, MEM_Int);
+		VDBE_PREDICT(vdbe_op_is_compare(pOp[1].opcode), op_compare);
 	} else {
 		bIntint = 0;
 	fp_math:
@@ -2100,6 +2148,7 @@ case OP_Cast: {                  /* in1 */
  * the content of register P3 is greater than or equal to the content of
  * register P1.  See the Lt opcode for additional information.
  */
+			op_compare:
 case OP_Eq:               /* same as TK_EQ, jump, in1, in3 */
 case OP_Ne:               /* same as TK_NE, jump, in1, in3 */
 case OP_Lt:               /* same as TK_LT, jump, in1, in3 */
@@ -2600,6 +2649,7 @@ case OP_NotNull: {            /* same as TK_NOTNULL, jump, in1 */
  * or typeof() function, respectively.  The loading of large blobs can be
  * skipped for length() and all content loading can be skipped for typeof().
  */
+			op_column:
 case OP_Column: {
 	int p2;            /* column number to retrieve */
 	VdbeCursor *pC;    /* The VDBE cursor */
@@ -2783,6 +2833,9 @@ case OP_Column: {
 			op_column_out:
 	UPDATE_MAX_BLOBSIZE(pDest);
 	REGISTER_TRACE(pOp->p3, pDest);
+	VDBE_PREDICT(pOp[1].opcode == OP_Column, op_column);
+	VDBE_PREDICT(vdbe_op_is_compare(pOp[1].opcode), op_compare);
+	VDBE_PREDICT(pOp[1].opcode == OP_ResultRow, op_result_row);
 	break;
 
 			op_column_error:
@@ -3184,6 +3237,9 @@ case OP_TTransaction: {
  * small integers. It is an error for P1 to be negative.
  * If P4 was not set, then P3 supposed to be the register
  * containing space pointer.
+ *
+ * If P5 contains OPFLAG_SCAN_BATCH and the space is a memtx
+ * one, the cursor reads tuples from the iterator in batches.
  */
 case OP_IteratorReopen: {
 	assert(pOp->p5 == 0);
@@ -3227,6 +3283,8 @@ case OP_IteratorOpen:
 	struct BtCursor *bt_cur = cur->uc.pCursor;
 	bt_cur->curFlags |= space->def->id == 0 ? BTCF_TEphemCursor :
 				BTCF_TaCursor;
+	if ((pOp->p5 & OPFLAG_SCAN_BATCH) != 0 && space_is_memtx(space))
+		bt_cur->curFlags |= BTCF_TaBatch;
 	bt_cur->space = space;
 	bt_cur->index = index;
 	bt_cur->eState = CURSOR_INVALID;
@@ -3240,12 +3298,86 @@ open_cursor_set_hints:
 	break;
 }
 
+/* Opcode: IteratorFilter P1 P2 P3 P4 P5
+ * Synopsis: field[P3] P5 r[P2]
+ *
+ * Make the iterator of cursor P1 skip tuples whose field P3
+ * doesn't compare with the value of register P2 as iterator
+ * type P5 (ITER_EQ, ITER_LT, ITER_LE, ITER_GE or ITER_GT)
+ * requires. P4 is the collation id of the field. Must follow
+ * OP_IteratorOpen of the cursor.
+ *
+ * The filter only lets the engine skip rows early: the rows
+ * it passes are checked by the WHERE clause code anyway. A
+ * value which is neither a number nor a string is ignored.
+ */
+case OP_IteratorFilter: {
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_TARANTOOL);
+	struct Mem *value = &aMem[pOp->p2];
+	enum field_type type;
+	if ((value->flags & (MEM_Int | MEM_Real)) != 0)
+		type = FIELD_TYPE_NUMBER;
+	else if ((value->flags & MEM_Str) != 0)
+		type = FIELD_TYPE_STRING;
+	else
+		break;
+	if (sql_cursor_add_filter(cur->uc.pCursor, pOp->p3, type,
+				  pOp->p4.i, pOp->p5, value) != 0) {
+		rc = SQL_TARANTOOL_ERROR;
+		goto abort_due_to_error;
+	}
+	break;
+}
+
+/* Opcode: IteratorFields P1 * * P4 *
+ * Synopsis: fields(P4) of cursor P1
+ *
+ * Tell the iterator of cursor P1 that only the fields set in
+ * the column mask P4 (P4_INT64) are read from it, so that the
+ * engine may return tuples which lack other fields, e.g. the
+ * ones stored in a vinyl secondary index, without looking up
+ * full tuples in the primary index. Must follow OP_IteratorOpen
+ * of the cursor.
+ */
+case OP_IteratorFields: {
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_TARANTOOL);
+	assert(pOp->p4type == P4_INT64);
+	struct BtCursor *bt_cur = cur->uc.pCursor;
+	assert(bt_cur->iter == NULL);
+	bt_cur->curFlags |= BTCF_TaCovering;
+	bt_cur->field_mask = *pOp->p4.pI64;
+	break;
+}
+
+/* Opcode: ScanAggregate P1 P2 * P4 *
+ * Synopsis: aggregate(P4) over cursor P1
+ *
+ * Try to compute the aggregates described by P4 (a struct
+ * scan_agg) over the space of cursor P1 in the coio thread
+ * pool. On success store the final values of the aggregates
+ * and jump to P2. Otherwise fall through to the usual loop,
+ * which is also used for small or non-memtx spaces.
+ */
+case OP_ScanAggregate: {
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_TARANTOOL);
+	assert(pOp->p4type == P4_DYNAMIC);
+	const struct scan_agg *agg = (const struct scan_agg *) pOp->p4.z;
+	if (sql_scan_aggregate(cur->uc.pCursor->space, agg, aMem))
+		goto jump_to_p2;
+	break;
+}
+
 /**
- * Opcode: OpenTEphemeral P1 P2 * P4 *
+ * Opcode: OpenTEphemeral P1 P2 * P4 P5
  * Synopsis:
  * @param P1 register, where pointer to new space is stored.
  * @param P2 number of columns in a new table.
  * @param P4 key def for new table, NULL is allowed.
+ * @param P5 OPFLAG_HASH_INDEX if the table is only probed for
+ *        equality to a full key, so a HASH index can be used.
  *
  * This opcode creates Tarantool's ephemeral table and stores pointer
  * to it into P1 register.
@@ -3255,8 +3387,10 @@ case OP_OpenTEphemeral: {
 	assert(pOp->p2 > 0);
 	assert(pOp->p4type != P4_KEYINFO || pOp->p4.key_info != NULL);
 
+	bool is_hash = (pOp->p5 & OPFLAG_HASH_INDEX) != 0;
 	struct space *space = sql_ephemeral_space_create(pOp->p2,
-							 pOp->p4.key_info);
+							 pOp->p4.key_info,
+							 is_hash);
 
 	if (space == NULL) {
 		rc = SQL_TARANTOOL_ERROR;
@@ -3643,10 +3777,12 @@ case OP_SeekGT: {       /* jump, in3 */
 		assert(pOp[1].opcode==OP_IdxLT || pOp[1].opcode==OP_IdxGT);
 		pOp++; /* Skip the OP_IdxLt or OP_IdxGT that follows */
 	}
+	VDBE_PREDICT(vdbe_op_is_idx_compare(pOp[1].opcode), op_idx_compare);
+	VDBE_PREDICT(pOp[1].opcode == OP_Column, op_column);
 	break;
 }
 
-/* Opcode: Found P1 P2 P3 P4 *
+/* Opcode: Found P1 P2 P3 P4 P5
  * Synopsis: key=r[P3@P4]
  *
  * If P4==0 then register P3 holds a blob constructed by MakeRecord.  If
@@ -3657,6 +3793,9 @@ case OP_SeekGT: {       /* jump, in3 */
  * is a prefix of any entry in P1 then a jump is made to P2 and
  * P1 is left pointing at the matching entry.
  *
+ * P5 is the index of the statement status counter incremented
+ * on each lookup (SQL_STMTSTATUS_FK_CHECK for foreign key checks).
+ *
  * This operation leaves the cursor in a state where it can be
  * advanced in the forward direction.  The Next instruction will work,
  * but not the Prev instruction.
@@ -3772,6 +3911,8 @@ case OP_Found: {        /* jump, in3 */
 	if (rc!=SQL_OK) {
 		goto abort_due_to_error;
 	}
+	assert(pOp->p5<ArraySize(p->aCounter));
+	p->aCounter[pOp->p5]++;
 	pC->seekResult = res;
 	alreadyExists = (res==0);
 	pC->nullRow = 1-alreadyExists;
@@ -4467,9 +4608,11 @@ case OP_IdxInsert: {
  *           in @P3 array.
  * @param P2 P2 Encoded key to be passed to box_update().
  * @param P3 Index of a register with upd_fields blob.
- *           It's items are numbers of fields to be replaced with
- *           new values from P1. They must be sorted in ascending
- *           order.
+ *           It's an array of struct sql_update_op: numbers of
+ *           fields to be updated with values from P1 and
+ *           operations to apply: assignment, addition or
+ *           subtraction. They must be sorted in ascending
+ *           order of field numbers.
  * @param P4 Pointer to the struct space to be updated.
  * @param P5 Flags. If P5 contains OPFLAG_NCHANGE, then VDBE
  *           accounts the change in a case of successful
@@ -4491,8 +4634,9 @@ case OP_Update: {
 
 	struct Mem *upd_fields_mem = &aMem[pOp->p3];
 	assert((upd_fields_mem->flags & MEM_Blob) != 0);
-	uint32_t *upd_fields = (uint32_t *)upd_fields_mem->z;
-	uint32_t upd_fields_cnt = upd_fields_mem->n / sizeof(uint32_t);
+	struct sql_update_op *upd_fields =
+		(struct sql_update_op *)upd_fields_mem->z;
+	uint32_t upd_fields_cnt = upd_fields_mem->n / sizeof(*upd_fields);
 
 	/* Prepare Tarantool update ops msgpack. */
 	struct region *region = &fiber()->gc;
@@ -4503,10 +4647,10 @@ case OP_Update: {
 		      set_encode_error, &is_error);
 	mpstream_encode_array(&stream, upd_fields_cnt);
 	for (uint32_t i = 0; i < upd_fields_cnt; i++) {
-		uint32_t field_idx = upd_fields[i];
+		uint32_t field_idx = upd_fields[i].fieldno;
 		assert(field_idx < space->def->field_count);
 		mpstream_encode_array(&stream, 3);
-		mpstream_encode_strn(&stream, "=", 1);
+		mpstream_encode_strn(&stream, &upd_fields[i].op, 1);
 		mpstream_encode_uint(&stream, field_idx);
 		mpstream_encode_vdbe_mem(&stream, new_tuple + field_idx);
 	}
@@ -4694,6 +4838,7 @@ case OP_IdxDelete: {
  * If the P1 index entry is less than or equal to the key value then jump
  * to P2. Otherwise fall through to the next instruction.
  */
+			op_idx_compare:
 case OP_IdxLE:          /* jump */
 case OP_IdxGT:          /* jump */
 case OP_IdxLT:          /* jump */
@@ -4732,6 +4877,7 @@ case OP_IdxGE:  {       /* jump */
 	}
 	VdbeBranchTaken(res>0,2);
 	if (res>0) goto jump_to_p2;
+	VDBE_PREDICT(pOp[1].opcode == OP_Column, op_column);
 	break;
 }
 
@@ -408,7 +408,7 @@ struct Vdbe {
 	bft changeCntOn:1;	/* True to update the change-counter */
 	bft runOnlyOnce:1;	/* Automatically expire on reset */
 	bft isPrepareV2:1;	/* True if prepared with prepare_v2() */
-	u32 aCounter[5];	/* Counters used by sql_stmt_status() */
+	u32 aCounter[6];	/* Counters used by sql_stmt_status() */
 	char *zSql;		/* Text of the SQL statement that generated this */
 	void *pFree;		/* Free this when deleting the vdbe */
 	VdbeFrame *pFrame;	/* Parent frame */
@@ -503,6 +503,68 @@ int sqlVdbeSorterRewind(const VdbeCursor *, int *);
 int sqlVdbeSorterWrite(const VdbeCursor *, Mem *);
 int sqlVdbeSorterCompare(const VdbeCursor *, Mem *, int, int *);
 
+int sqlIntFloatCompare(i64 i, double r);
+
+/** Aggregate function computed by OP_ScanAggregate. */
+enum scan_agg_func {
+	/** count(*) */
+	SCAN_AGG_COUNT_ALL,
+	SCAN_AGG_COUNT,
+	SCAN_AGG_SUM,
+	SCAN_AGG_TOTAL,
+	SCAN_AGG_AVG,
+};
+
+/** A condition of OP_ScanAggregate: field <op> r[reg]. */
+struct scan_agg_filter {
+	/** Number of the compared field. */
+	uint32_t fieldno;
+	/** TK_EQ, TK_LT, TK_LE, TK_GE or TK_GT. */
+	int op;
+	/** Collation of the field. */
+	uint32_t coll_id;
+	/** Register holding the number or string compared with. */
+	int reg;
+};
+
+/** An aggregate computed by OP_ScanAggregate into r[reg]. */
+struct scan_agg_item {
+	enum scan_agg_func func;
+	/** Aggregated field, unused by count(*). */
+	uint32_t fieldno;
+	/** Register the final value is stored to. */
+	int reg;
+};
+
+/**
+ * Aggregates over the rows of a space passing all the filters,
+ * see OP_ScanAggregate. Allocated in one block with the arrays.
+ */
+struct scan_agg {
+	struct scan_agg_filter *filters;
+	uint32_t filter_count;
+	struct scan_agg_item *items;
+	uint32_t item_count;
+};
+
+/**
+ * Compute aggregates over a memtx space in the coio thread pool,
+ * each thread scanning a range of a frozen primary index. The
+ * calling fiber yields until they are done.
+ *
+ * @param space Scanned space.
+ * @param agg Aggregates and filters.
+ * @param aMem Registers of the VDBE.
+ *
+ * @retval true if the results are stored to the registers,
+ *         false if the aggregates must be computed by the
+ *         usual loop: the space is small, the statement can't
+ *         yield, or the computation failed.
+ */
+bool
+sql_scan_aggregate(struct space *space, const struct scan_agg *agg,
+		   struct Mem *aMem);
+
 #ifdef SQL_DEBUG
 void sqlVdbeMemAboutToChange(Vdbe *, Mem *);
 int sqlVdbeCheckMemInvariants(Mem *);
@@ -0,0 +1,449 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * This file contains code for OP_ScanAggregate, which computes
+ * aggregates over a full scan of a big memtx space in the coio
+ * thread pool instead of the tx thread.
+ */
+#include "sqlInt.h"
+#include "vdbeInt.h"
+#include "box/coll_id_cache.h"
+#include "box/memtx_tree.h"
+#include "box/space.h"
+#include "box/txn.h"
+#include "coll.h"
+#include "coio_task.h"
+#include "fiber.h"
+#include "msgpuck/msgpuck.h"
+
+enum {
+	/** Spaces smaller than that are aggregated in place. */
+	SCAN_AGG_MIN_SIZE = 100000,
+	/** Maximal number of threads scanning a space. */
+	SCAN_AGG_MAX_PARTS = 4,
+};
+
+/** A number stored in a tuple or compared with. */
+struct scan_agg_num {
+	bool is_int;
+	union {
+		int64_t i;
+		double d;
+	};
+};
+
+/** A decoded value of a filter. */
+struct scan_agg_value {
+	bool is_str;
+	struct scan_agg_num num;
+	const char *str;
+	uint32_t len;
+	/** Collation of strings or NULL for binary comparison. */
+	struct coll *coll;
+};
+
+/** Partial state of an aggregate, see struct SumCtx. */
+struct scan_agg_acc {
+	double r_sum;
+	int64_t i_sum;
+	int64_t count;
+	bool overflow;
+	bool approx;
+};
+
+/** A range of the space aggregated by one thread. */
+struct scan_agg_part {
+	struct memtx_tree_range *range;
+	const struct scan_agg *agg;
+	/** Decoded values of agg->filters. */
+	const struct scan_agg_value *values;
+	/** Accumulators of agg->items. */
+	struct scan_agg_acc *acc;
+	/** Fields of the current tuple. */
+	const char **fields;
+	/** Number of the first fields of a tuple in use. */
+	uint32_t field_count;
+	/** Set when the whole range has been aggregated. */
+	bool is_done;
+};
+
+/** Decode a number, return false if the field isn't a number. */
+static bool
+scan_agg_decode_num(const char *field, struct scan_agg_num *num)
+{
+	switch (mp_typeof(*field)) {
+	case MP_UINT: {
+		uint64_t u = mp_decode_uint(&field);
+		num->is_int = u <= INT64_MAX;
+		if (num->is_int)
+			num->i = u;
+		else
+			num->d = u;
+		return true;
+	}
+	case MP_INT:
+		num->is_int = true;
+		num->i = mp_decode_int(&field);
+		return true;
+	case MP_FLOAT:
+		num->is_int = false;
+		num->d = mp_decode_float(&field);
+		return true;
+	case MP_DOUBLE:
+		num->is_int = false;
+		num->d = mp_decode_double(&field);
+		return true;
+	default:
+		return false;
+	}
+}
+
+/** Compare numbers the way sqlMemCompare() does. */
+static int
+scan_agg_num_cmp(const struct scan_agg_num *a, const struct scan_agg_num *b)
+{
+	if (a->is_int && b->is_int)
+		return a->i < b->i ? -1 : a->i > b->i;
+	if (!a->is_int && !b->is_int)
+		return a->d < b->d ? -1 : a->d > b->d;
+	if (a->is_int)
+		return sqlIntFloatCompare(a->i, b->d);
+	return -sqlIntFloatCompare(b->i, a->d);
+}
+
+/** Check if a field passes a filter. NULL never passes. */
+static bool
+scan_agg_filter_match(const struct scan_agg_value *value, int op,
+		      const char *field)
+{
+	if (field == NULL || mp_typeof(*field) == MP_NIL)
+		return false;
+	int rc;
+	if (value->is_str) {
+		if (mp_typeof(*field) != MP_STR)
+			return false;
+		uint32_t len;
+		const char *str = mp_decode_str(&field, &len);
+		if (value->coll != NULL) {
+			rc = value->coll->cmp(str, len, value->str, value->len,
+					      value->coll);
+		} else {
+			rc = memcmp(str, value->str, MIN(len, value->len));
+			if (rc == 0)
+				rc = len < value->len ? -1 : len > value->len;
+		}
+	} else {
+		struct scan_agg_num num;
+		if (!scan_agg_decode_num(field, &num))
+			return false;
+		rc = scan_agg_num_cmp(&num, &value->num);
+	}
+	switch (op) {
+	case TK_EQ:
+		return rc == 0;
+	case TK_LT:
+		return rc < 0;
+	case TK_LE:
+		return rc <= 0;
+	case TK_GE:
+		return rc >= 0;
+	case TK_GT:
+		return rc > 0;
+	default:
+		unreachable();
+		return false;
+	}
+}
+
+/** Add a field to an accumulator, like countStep() and sumStep(). */
+static void
+scan_agg_step(struct scan_agg_acc *acc, enum scan_agg_func func,
+	      const char *field)
+{
+	if (func == SCAN_AGG_COUNT_ALL) {
+		acc->count++;
+		return;
+	}
+	if (field == NULL || mp_typeof(*field) == MP_NIL)
+		return;
+	if (func == SCAN_AGG_COUNT) {
+		acc->count++;
+		return;
+	}
+	struct scan_agg_num num;
+	if (!scan_agg_decode_num(field, &num))
+		return;
+	acc->count++;
+	if (num.is_int) {
+		acc->r_sum += num.i;
+		if (!acc->approx && !acc->overflow &&
+		    sqlAddInt64(&acc->i_sum, num.i) != 0)
+			acc->overflow = true;
+	} else {
+		acc->r_sum += num.d;
+		acc->approx = true;
+	}
+}
+
+/** Aggregate a range of the space. */
+static void
+scan_agg_part_run(struct scan_agg_part *part)
+{
+	const struct scan_agg *agg = part->agg;
+	const char *data;
+	uint32_t size;
+	while ((data = memtx_tree_range_next(part->range, &size)) != NULL) {
+		uint32_t count = MIN(mp_decode_array(&data),
+				     part->field_count);
+		uint32_t i;
+		for (i = 0; i < count; i++) {
+			part->fields[i] = data;
+			mp_next(&data);
+		}
+		for (; i < part->field_count; i++)
+			part->fields[i] = NULL;
+		for (i = 0; i < agg->filter_count; i++) {
+			const struct scan_agg_filter *f = &agg->filters[i];
+			if (!scan_agg_filter_match(&part->values[i], f->op,
+						   part->fields[f->fieldno]))
+				break;
+		}
+		if (i < agg->filter_count)
+			continue;
+		for (i = 0; i < agg->item_count; i++) {
+			const struct scan_agg_item *item = &agg->items[i];
+			scan_agg_step(&part->acc[i], item->func,
+				      item->func == SCAN_AGG_COUNT_ALL ? NULL :
+				      part->fields[item->fieldno]);
+		}
+	}
+	part->is_done = true;
+}
+
+static ssize_t
+scan_agg_part_f(va_list ap)
+{
+	struct scan_agg_part *part = va_arg(ap, struct scan_agg_part *);
+	scan_agg_part_run(part);
+	return 0;
+}
+
+static int
+scan_agg_part_fiber_f(va_list ap)
+{
+	struct scan_agg_part *part = va_arg(ap, struct scan_agg_part *);
+	return coio_call(scan_agg_part_f, part) < 0 ? -1 : 0;
+}
+
+/**
+ * Check if the statement may yield, see vdbeSorterCanYield().
+ * A memtx transaction with changes is aborted on yield.
+ */
+static bool
+scan_agg_can_yield(void)
+{
+	if (fiber() == &cord()->sched)
+		return false;
+	struct txn *txn = in_txn();
+	return txn == NULL || stailq_empty(&txn->stmts);
+}
+
+/**
+ * Decode values of filters from registers. Return false if
+ * a value is neither a number nor a string.
+ */
+static bool
+scan_agg_decode_values(const struct scan_agg *agg, struct Mem *aMem,
+		       struct scan_agg_value *values)
+{
+	for (uint32_t i = 0; i < agg->filter_count; i++) {
+		const struct scan_agg_filter *f = &agg->filters[i];
+		struct Mem *mem = &aMem[f->reg];
+		struct scan_agg_value *v = &values[i];
+		v->is_str = false;
+		v->coll = NULL;
+		if ((mem->flags & MEM_Int) != 0) {
+			v->num.is_int = true;
+			v->num.i = mem->u.i;
+		} else if ((mem->flags & MEM_Real) != 0) {
+			v->num.is_int = false;
+			v->num.d = mem->u.r;
+		} else if ((mem->flags & MEM_Str) != 0) {
+			v->is_str = true;
+			v->str = mem->z;
+			v->len = mem->n;
+			if (f->coll_id != COLL_NONE) {
+				struct coll_id *coll_id = coll_by_id(f->coll_id);
+				if (coll_id == NULL)
+					return false;
+				v->coll = coll_id->coll;
+			}
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Merge accumulators of the parts and store the final values
+ * to the registers. Return false on integer overflow, which
+ * is reported by the usual loop.
+ */
+static bool
+scan_agg_finalize(const struct scan_agg *agg, struct scan_agg_part *parts,
+		  uint32_t part_count, struct Mem *aMem)
+{
+	for (uint32_t i = 0; i < agg->item_count; i++) {
+		struct scan_agg_acc *acc = &parts[0].acc[i];
+		for (uint32_t j = 1; j < part_count; j++) {
+			struct scan_agg_acc *a = &parts[j].acc[i];
+			acc->count += a->count;
+			acc->r_sum += a->r_sum;
+			acc->approx = acc->approx || a->approx;
+			acc->overflow = acc->overflow || a->overflow;
+			if (!acc->approx && !acc->overflow &&
+			    sqlAddInt64(&acc->i_sum, a->i_sum) != 0)
+				acc->overflow = true;
+		}
+		if (agg->items[i].func == SCAN_AGG_SUM && acc->overflow)
+			return false;
+	}
+	for (uint32_t i = 0; i < agg->item_count; i++) {
+		struct scan_agg_acc acc = parts[0].acc[i];
+		const struct scan_agg_item *item = &agg->items[i];
+		struct Mem *mem = &aMem[item->reg];
+		switch (item->func) {
+		case SCAN_AGG_COUNT_ALL:
+		case SCAN_AGG_COUNT:
+			sqlVdbeMemSetInt64(mem, acc.count);
+			break;
+		case SCAN_AGG_SUM:
+			if (acc.count == 0)
+				sqlVdbeMemSetNull(mem);
+			else if (acc.approx)
+				sqlVdbeMemSetDouble(mem, acc.r_sum);
+			else
+				sqlVdbeMemSetInt64(mem, acc.i_sum);
+			break;
+		case SCAN_AGG_TOTAL:
+			sqlVdbeMemSetDouble(mem, acc.r_sum);
+			break;
+		case SCAN_AGG_AVG:
+			if (acc.count == 0)
+				sqlVdbeMemSetNull(mem);
+			else
+				sqlVdbeMemSetDouble(mem, acc.r_sum / acc.count);
+			break;
+		}
+	}
+	return true;
+}
+
+bool
+sql_scan_aggregate(struct space *space, const struct scan_agg *agg,
+		   struct Mem *aMem)
+{
+	if (!space_is_memtx(space) || space->index_count == 0)
+		return false;
+	struct index *pk = space->index[0];
+	if (pk->def->type != TREE || index_size(pk) < SCAN_AGG_MIN_SIZE ||
+	    !scan_agg_can_yield())
+		return false;
+
+	uint32_t field_count = 0;
+	for (uint32_t i = 0; i < agg->filter_count; i++)
+		field_count = MAX(field_count, agg->filters[i].fieldno + 1);
+	for (uint32_t i = 0; i < agg->item_count; i++) {
+		if (agg->items[i].func != SCAN_AGG_COUNT_ALL)
+			field_count = MAX(field_count,
+					  agg->items[i].fieldno + 1);
+	}
+	size_t per_part = agg->item_count * sizeof(struct scan_agg_acc) +
+			  field_count * sizeof(const char *);
+	size_t size = SCAN_AGG_MAX_PARTS * (sizeof(struct scan_agg_part) +
+					    per_part) +
+		      agg->filter_count * sizeof(struct scan_agg_value);
+	char *buf = (char *) calloc(1, size);
+	if (buf == NULL)
+		return false;
+	struct scan_agg_part *parts = (struct scan_agg_part *) buf;
+	struct scan_agg_value *values = (struct scan_agg_value *)
+		(parts + SCAN_AGG_MAX_PARTS);
+	bool is_done = false;
+	if (!scan_agg_decode_values(agg, aMem, values))
+		goto out;
+	uint32_t part_count;
+	struct memtx_tree_range *ranges =
+		memtx_tree_index_split(pk, SCAN_AGG_MAX_PARTS, &part_count);
+	if (ranges == NULL) {
+		diag_clear(diag_get());
+		goto out;
+	}
+	char *pos = (char *) (values + agg->filter_count);
+	for (uint32_t i = 0; i < part_count; i++) {
+		struct scan_agg_part *part = &parts[i];
+		part->range = &ranges[i];
+		part->agg = agg;
+		part->values = values;
+		part->acc = (struct scan_agg_acc *) pos;
+		pos += agg->item_count * sizeof(struct scan_agg_acc);
+		part->fields = (const char **) pos;
+		pos += field_count * sizeof(const char *);
+		part->field_count = field_count;
+	}
+
+	struct fiber *fibers[SCAN_AGG_MAX_PARTS];
+	for (uint32_t i = 1; i < part_count; i++) {
+		fibers[i] = fiber_new("sql_scan_agg", scan_agg_part_fiber_f);
+		if (fibers[i] == NULL)
+			continue;
+		fiber_set_joinable(fibers[i], true);
+		fiber_start(fibers[i], &parts[i]);
+	}
+	(void) coio_call(scan_agg_part_f, &parts[0]);
+	for (uint32_t i = 1; i < part_count; i++) {
+		if (fibers[i] != NULL)
+			(void) fiber_join(fibers[i]);
+	}
+	/* Parts which couldn't get a thread are scanned in place. */
+	for (uint32_t i = 0; i < part_count; i++) {
+		if (!parts[i].is_done)
+			scan_agg_part_run(&parts[i]);
+	}
+	diag_clear(diag_get());
+	is_done = scan_agg_finalize(agg, parts, part_count, aMem);
+	memtx_tree_index_delete_ranges(pk, ranges, part_count);
+out:
+	free(buf);
+	return is_done;
+}
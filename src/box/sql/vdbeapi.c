@@ -1558,6 +1558,23 @@ sql_stmt_busy(sql_stmt * pStmt)
 	return v != 0 && v->magic == VDBE_MAGIC_RUN && v->pc >= 0;
 }
 
+/*
+ * Return an estimate of the memory taken by the prepared
+ * statement: the program, its registers and result column names.
+ */
+size_t
+sql_stmt_est_size(const sql_stmt *stmt)
+{
+	const Vdbe *v = (const Vdbe *) stmt;
+	size_t size = sizeof(*v);
+	size += v->nOp * sizeof(VdbeOp);
+	size += (v->nMem + v->nVar) * sizeof(Mem);
+	size += v->nResColumn * COLNAME_N * sizeof(Mem);
+	if (v->zSql != NULL)
+		size += strlen(v->zSql) + 1;
+	return size;
+}
+
 /*
  * Return a pointer to the next prepared statement after pStmt associated
  * with database connection pDb.  If pStmt is NULL, return the first
@@ -3313,7 +3313,7 @@ sqlBlobCompare(const Mem * pB1, const Mem * pB2)
  * number.  Return negative, zero, or positive if the first (i64) is less than,
  * equal to, or greater than the second (double).
  */
-static int
+int
 sqlIntFloatCompare(i64 i, double r)
 {
 	if (sizeof(LONGDOUBLE_TYPE) > 8) {
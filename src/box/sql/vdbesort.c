@@ -158,6 +158,9 @@
  */
 #include "sqlInt.h"
 #include "vdbeInt.h"
+#include "box/txn.h"
+#include "coio_task.h"
+#include "fiber.h"
 
 /*
  * If SQL_DEBUG_SORTER_THREADS is defined, this module outputs various
@@ -1334,42 +1337,28 @@ vdbeSorterGetCompare(VdbeSorter * p)
 }
 
 /*
- * Sort the linked list of records headed at pTask->pList. Return
- * SQL_OK if successful, or an sql error code (i.e. SQL_NOMEM) if
- * an error occurs.
+ * Sort the records of a list headed at @a p using @a aSlot, an
+ * array of 64 NULL pointers, as the merge state. If @a aMemory
+ * is not NULL, the list is linked by SorterRecord.u.iNext
+ * offsets within it, otherwise by SorterRecord.u.pNext. The
+ * result is always linked by SorterRecord.u.pNext.
+ *
+ * The routine doesn't allocate memory, so it can be run in a
+ * coio thread.
  */
-static int
-vdbeSorterSort(SortSubtask * pTask, SorterList * pList)
+static SorterRecord *
+vdbeSorterSortRecords(SortSubtask * pTask, SorterRecord * p, u8 * aMemory,
+		      SorterRecord ** aSlot)
 {
 	int i;
-	SorterRecord **aSlot;
-	SorterRecord *p;
-	int rc;
-
-	rc = vdbeSortAllocUnpacked(pTask);
-	if (rc != SQL_OK)
-		return rc;
-
-	p = pList->pList;
-	pTask->xCompare = vdbeSorterGetCompare(pTask->pSorter);
-
-	aSlot =
-	    (SorterRecord **) sqlMallocZero(64 * sizeof(SorterRecord *));
-	if (!aSlot) {
-		return SQL_NOMEM_BKPT;
-	}
-
 	while (p) {
 		SorterRecord *pNext;
-		if (pList->aMemory) {
-			if ((u8 *) p == pList->aMemory) {
+		if (aMemory) {
+			if ((u8 *) p == aMemory) {
 				pNext = 0;
 			} else {
-				assert(p->u.iNext <
-				       sqlMallocSize(pList->aMemory));
-				pNext =
-				    (SorterRecord *) & pList->aMemory[p->u.
-								      iNext];
+				assert(p->u.iNext < sqlMallocSize(aMemory));
+				pNext = (SorterRecord *) & aMemory[p->u.iNext];
 			}
 		} else {
 			pNext = p->u.pNext;
@@ -1390,8 +1379,214 @@ vdbeSorterSort(SortSubtask * pTask, SorterList * pList)
 			continue;
 		p = p ? vdbeSorterMerge(pTask, p, aSlot[i]) : aSlot[i];
 	}
-	pList->pList = p;
+	return p;
+}
+
+/*
+ * Lists which take at least this many bytes are sorted in the
+ * coio thread pool, so that the tx thread keeps serving other
+ * requests meanwhile. Smaller lists are sorted in place, since
+ * a thread hop would cost more than the sort itself.
+ */
+#define SORTER_OFFLOAD_SIZE (1 << 20)
+
+/*
+ * Maximal number of parts of a list sorted in parallel by
+ * separate coio threads.
+ */
+#define SORTER_MAX_PARTS 4
+
+/*
+ * A part of a list sorted in a coio thread. Each part has its
+ * own subtask, because the comparator unpacks records into
+ * SortSubtask.pUnpacked.
+ */
+struct SorterPart {
+	SortSubtask task;	/* Comparison context of the part */
+	SorterRecord *pList;	/* Records of the part */
+	SorterRecord *aSlot[64];	/* Merge state */
+	int bSorted;		/* True if pList is sorted */
+};
+
+/*
+ * Return true if the current fiber may yield while sorting.
+ * A memtx transaction which has changed data is aborted by a
+ * yield, so lists of such transactions are sorted in place.
+ */
+static bool
+vdbeSorterCanYield(void)
+{
+	if (fiber() == &cord()->sched)
+		return false;
+	struct txn *txn = in_txn();
+	return txn == NULL || stailq_empty(&txn->stmts);
+}
+
+/* Sort a part of a list, runs in a coio thread. */
+static ssize_t
+vdbeSorterSortPartF(va_list ap)
+{
+	struct SorterPart *pPart = va_arg(ap, struct SorterPart *);
+	pPart->pList = vdbeSorterSortRecords(&pPart->task, pPart->pList, 0,
+					     pPart->aSlot);
+	pPart->bSorted = 1;
+	return 0;
+}
+
+/*
+ * Merge sorted parts of a list. Merge from the last part so
+ * that records which are equal keep the order which
+ * vdbeSorterSortRecords() gives them.
+ */
+static SorterRecord *
+vdbeSorterMergeParts(struct SorterPart * aPart, int nPart)
+{
+	SorterRecord *p = aPart[nPart - 1].pList;
+	for (int i = nPart - 2; i >= 0; i--) {
+		if (p == 0)
+			p = aPart[i].pList;
+		else if (aPart[i].pList != 0)
+			p = vdbeSorterMerge(&aPart[0].task, p, aPart[i].pList);
+	}
+	return p;
+}
+
+/* Merge sorted parts of a list, runs in a coio thread. */
+static ssize_t
+vdbeSorterMergePartsF(va_list ap)
+{
+	struct SorterPart *aPart = va_arg(ap, struct SorterPart *);
+	int nPart = va_arg(ap, int);
+	SorterRecord **ppList = va_arg(ap, SorterRecord **);
+	*ppList = vdbeSorterMergeParts(aPart, nPart);
+	return 0;
+}
+
+static int
+vdbeSorterSortPartFiberF(va_list ap)
+{
+	struct SorterPart *pPart = va_arg(ap, struct SorterPart *);
+	return coio_call(vdbeSorterSortPartF, pPart) < 0 ? -1 : 0;
+}
+
+/*
+ * Sort a big list in the coio thread pool: split it into parts,
+ * sort them in parallel by separate threads, each waited for by
+ * its own fiber, and merge the results in one more thread. The
+ * calling fiber yields until the list is sorted. A part which
+ * can't be handed over to a thread is sorted in place.
+ */
+static int
+vdbeSorterSortOffload(SortSubtask * pTask, SorterList * pList)
+{
+	sql *db = pTask->pSorter->db;
+	struct SorterPart *aPart;
+	struct fiber *aFiber[SORTER_MAX_PARTS];
+	int nPart = SORTER_MAX_PARTS;
+	int nRecord = 0;
+	int i, rc = SQL_OK;
+	SorterRecord *p;
+
+	aPart = (struct SorterPart *) sqlMallocZero(nPart * sizeof(*aPart));
+	if (aPart == 0)
+		return SQL_NOMEM_BKPT;
+	for (i = 0; i < nPart; i++) {
+		aPart[i].task.pSorter = pTask->pSorter;
+		aPart[i].task.xCompare = pTask->xCompare;
+		rc = vdbeSortAllocUnpacked(&aPart[i].task);
+		if (rc != SQL_OK)
+			goto out;
+	}
 
+	/*
+	 * Link the records by pointers, so that the parts don't
+	 * depend on aMemory, and split the list into parts of
+	 * the same size keeping the order of the records.
+	 */
+	for (p = pList->pList; p != 0; nRecord++) {
+		SorterRecord *pNext;
+		if (pList->aMemory == 0)
+			pNext = p->u.pNext;
+		else if ((u8 *) p == pList->aMemory)
+			pNext = 0;
+		else
+			pNext = (SorterRecord *) & pList->aMemory[p->u.iNext];
+		p->u.pNext = pNext;
+		p = pNext;
+	}
+	int nPerPart = (nRecord + nPart - 1) / nPart;
+	p = pList->pList;
+	for (i = 0; i < nPart && p != 0; i++) {
+		aPart[i].pList = p;
+		for (int j = 1; j < nPerPart && p->u.pNext != 0; j++)
+			p = p->u.pNext;
+		SorterRecord *pNext = p->u.pNext;
+		p->u.pNext = 0;
+		p = pNext;
+	}
+	nPart = i;
+
+	for (i = 1; i < nPart; i++) {
+		aFiber[i] = fiber_new("sql_sort", vdbeSorterSortPartFiberF);
+		if (aFiber[i] == 0)
+			continue;
+		fiber_set_joinable(aFiber[i], true);
+		fiber_start(aFiber[i], &aPart[i]);
+	}
+	(void) coio_call(vdbeSorterSortPartF, &aPart[0]);
+	for (i = 1; i < nPart; i++) {
+		if (aFiber[i] != 0)
+			(void) fiber_join(aFiber[i]);
+	}
+	for (i = 0; i < nPart; i++) {
+		if (!aPart[i].bSorted) {
+			aPart[i].pList =
+				vdbeSorterSortRecords(&aPart[i].task,
+						      aPart[i].pList, 0,
+						      aPart[i].aSlot);
+		}
+	}
+	if (coio_call(vdbeSorterMergePartsF, aPart, nPart,
+		      &pList->pList) < 0)
+		pList->pList = vdbeSorterMergeParts(aPart, nPart);
+	for (i = 0; i < nPart; i++) {
+		if (aPart[i].task.pUnpacked->errCode != SQL_OK)
+			rc = aPart[i].task.pUnpacked->errCode;
+	}
+out:
+	for (i = 0; i < SORTER_MAX_PARTS; i++)
+		sqlDbFree(db, aPart[i].task.pUnpacked);
+	sql_free(aPart);
+	return rc;
+}
+
+/*
+ * Sort the linked list of records headed at pTask->pList. Return
+ * SQL_OK if successful, or an sql error code (i.e. SQL_NOMEM) if
+ * an error occurs.
+ */
+static int
+vdbeSorterSort(SortSubtask * pTask, SorterList * pList)
+{
+	SorterRecord **aSlot;
+	int rc;
+
+	rc = vdbeSortAllocUnpacked(pTask);
+	if (rc != SQL_OK)
+		return rc;
+
+	pTask->xCompare = vdbeSorterGetCompare(pTask->pSorter);
+
+	if (pList->szPMA >= SORTER_OFFLOAD_SIZE && vdbeSorterCanYield())
+		return vdbeSorterSortOffload(pTask, pList);
+
+	aSlot =
+	    (SorterRecord **) sqlMallocZero(64 * sizeof(SorterRecord *));
+	if (!aSlot) {
+		return SQL_NOMEM_BKPT;
+	}
+	pList->pList = vdbeSorterSortRecords(pTask, pList->pList,
+					     pList->aMemory, aSlot);
 	sql_free(aSlot);
 	assert(pTask->pUnpacked->errCode == SQL_OK
 	       || pTask->pUnpacked->errCode == SQL_NOMEM);
@@ -43,6 +43,7 @@
 #include "vdbeInt.h"
 #include "whereInt.h"
 #include "box/coll_id_cache.h"
+#include "box/column_mask.h"
 #include "box/session.h"
 #include "box/schema.h"
 
@@ -618,7 +619,7 @@ isDistinctRedundant(Parse * pParse,		/* Parsing context */
 	 */
 	for (uint32_t j = 0; j < pTab->space->index_count; ++j) {
 		struct index_def *def = pTab->space->index[j]->def;
-		if (!def->opts.is_unique)
+		if (!def->opts.is_unique || def->opts.func_id != 0)
 			continue;
 		uint32_t col_count = def->key_def->part_count;
 		uint32_t i;
@@ -709,10 +710,51 @@ termCanDriveIndex(WhereTerm * pTerm,	/* WHERE clause term to check */
 #endif
 
 #ifndef SQL_OMIT_AUTOMATIC_INDEX
+/**
+ * Check if all columns of @a def marked in @a col_used can be
+ * stored in an automatic index. The index is an ephemeral space
+ * with a key over all its fields, so the values must be
+ * comparable.
+ */
+static bool
+auto_index_columns_are_comparable(struct space_def *def, Bitmask col_used)
+{
+	for (uint32_t i = 0; i < def->field_count; ++i) {
+		Bitmask mask = i >= BMS - 1 ? MASKBIT(BMS - 1) : MASKBIT(i);
+		if ((col_used & mask) == 0)
+			continue;
+		enum field_type type = def->fields[i].type;
+		if (type == FIELD_TYPE_ANY || type == FIELD_TYPE_ARRAY ||
+		    type == FIELD_TYPE_MAP)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Return the number of the field of an automatic index holding
+ * table column @a column, or -1 if the index has no such field.
+ */
+static int
+auto_index_column(const struct index_def *def, int column)
+{
+	for (uint32_t i = 0; i < def->key_def->part_count; ++i) {
+		if (def->key_def->parts[i].fieldno == (uint32_t)column)
+			return i;
+	}
+	return -1;
+}
+
 /*
- * Generate code to construct the Index object for an automatic index
- * and to set up the WhereLevel object pLevel so that the code generator
- * makes use of the automatic index.
+ * Generate code to construct the automatic index and to set up
+ * the WhereLevel object pLevel so that the code generator makes
+ * use of the automatic index.
+ *
+ * The index is an ephemeral space filled with the columns of the
+ * equality constraints followed by all other columns used by the
+ * query and by a unique row id. It is built once per statement
+ * execution and is probed by the inner loop of the join instead
+ * of scanning the whole table on each iteration of the outer one.
  */
 static void
 constructAutomaticIndex(Parse * pParse,			/* The parsing context */
@@ -724,7 +766,6 @@ constructAutomaticIndex(Parse * pParse,			/* The parsing context */
 	int nKeyCol;		/* Number of columns in the constructed index */
 	WhereTerm *pTerm;	/* A single term of the WHERE clause */
 	WhereTerm *pWCEnd;	/* End of pWC->a[] */
-	Index *pIdx;		/* Object describing the transient index */
 	Vdbe *v;		/* Prepared statement under construction */
 	int addrInit;		/* Address of the initialization bypass jump */
 	Table *pTable;		/* The table being indexed */
@@ -733,15 +774,9 @@ constructAutomaticIndex(Parse * pParse,			/* The parsing context */
 	int n;			/* Column counter */
 	int i;			/* Loop counter */
 	int mxBitCol;		/* Maximum column in pSrc->colUsed */
-	struct coll *pColl;		/* Collating sequence to on a column */
 	WhereLoop *pLoop;	/* The Loop object */
-	char *zNotUsed;		/* Extra space on the end of pIdx */
 	Bitmask idxCols;	/* Bitmap of columns used for indexing */
 	Bitmask extraCols;	/* Bitmap of additional columns */
-	u8 sentWarning = 0;	/* True if a warnning has been issued */
-	int iContinue = 0;	/* Jump here to skip excluded rows */
-	struct SrcList_item *pTabItem;	/* FROM clause term being indexed */
-	int addrCounter = 0;	/* Address where integer counter is initialized */
 	int regBase;		/* Array of registers where record is assembled */
 
 	/* Generate code to skip over the creation and initialization of the
@@ -757,6 +792,7 @@ constructAutomaticIndex(Parse * pParse,			/* The parsing context */
 	 */
 	nKeyCol = 0;
 	pTable = pSrc->pTab;
+	struct space_def *space_def = pTable->def;
 	pWCEnd = &pWC->a[pWC->nTerm];
 	pLoop = pLevel->pWLoop;
 	idxCols = 0;
@@ -767,17 +803,10 @@ constructAutomaticIndex(Parse * pParse,			/* The parsing context */
 			    iCol >= BMS ? MASKBIT(BMS - 1) : MASKBIT(iCol);
 			testcase(iCol == BMS);
 			testcase(iCol == BMS - 1);
-			if (!sentWarning) {
-				sql_log(SQL_WARNING_AUTOINDEX,
-					    "automatic index on %s(%s)",
-					    pTable->def->name,
-					    pTable->aCol[iCol].zName);
-				sentWarning = 1;
-			}
 			if ((idxCols & cMask) == 0) {
 				if (whereLoopResize
 				    (pParse->db, pLoop, nKeyCol + 1)) {
-					goto end_auto_index_create;
+					return;
 				}
 				pLoop->aLTerm[nKeyCol++] = pTerm;
 				idxCols |= cMask;
@@ -798,104 +827,108 @@ constructAutomaticIndex(Parse * pParse,			/* The parsing context */
 	 * if they go out of sync.
 	 */
 	extraCols = pSrc->colUsed & (~idxCols | MASKBIT(BMS - 1));
-	mxBitCol = MIN(BMS - 1, pTable->def->field_count);
-	testcase(pTable->def->field_count == BMS - 1);
-	testcase(pTable->def->field_count == BMS - 2);
+	mxBitCol = MIN(BMS - 1, (int)space_def->field_count);
 	for (i = 0; i < mxBitCol; i++) {
 		if (extraCols & MASKBIT(i))
 			nKeyCol++;
 	}
-	if (pSrc->colUsed & MASKBIT(BMS - 1)) {
-		nKeyCol += pTable->def->field_count - BMS + 1;
+	if (pSrc->colUsed & MASKBIT(BMS - 1))
+		nKeyCol += space_def->field_count - BMS + 1;
+
+	/* Describe the index. Part fieldno-s refer to the table. */
+	size_t size = sizeof(struct key_part_def) * nKeyCol;
+	struct key_part_def *parts =
+		(struct key_part_def *) region_alloc(&pParse->region, size);
+	if (parts == NULL) {
+		diag_set(OutOfMemory, size, "region", "key parts");
+		goto error;
 	}
-
-	/* Construct the Index object to describe this index */
-	pIdx = sqlDbMallocZero(pParse->db, sizeof(*pIdx));
-	if (pIdx == 0)
-		goto end_auto_index_create;
-	pLoop->pIndex = pIdx;
-	pIdx->zName = "auto-index";
-	pIdx->pTable = pTable;
 	n = 0;
-	idxCols = 0;
-	for (pTerm = pWC->a; pTerm < pWCEnd; pTerm++) {
-		if (termCanDriveIndex(pTerm, pSrc, notReady)) {
-			int iCol = pTerm->u.leftColumn;
-			Bitmask cMask =
-			    iCol >= BMS ? MASKBIT(BMS - 1) : MASKBIT(iCol);
-			testcase(iCol == BMS - 1);
-			testcase(iCol == BMS);
-			if ((idxCols & cMask) == 0) {
-				Expr *pX = pTerm->pExpr;
-				idxCols |= cMask;
-				pIdx->aiColumn[n] = pTerm->u.leftColumn;
-				n++;
-			}
-		}
+	for (uint32_t j = 0; j < pLoop->nEq; j++) {
+		Expr *pX = pLoop->aLTerm[j]->pExpr;
+		struct key_part_def *part = &parts[n++];
+		part->fieldno = pLoop->aLTerm[j]->u.leftColumn;
+		part->type = space_def->fields[part->fieldno].type;
+		part->nullable_action = ON_CONFLICT_ACTION_NONE;
+		part->is_nullable = true;
+		part->sort_order = SORT_ORDER_ASC;
+		part->path = NULL;
+		/* Keys are compared as the constraint does. */
+		if (sql_binary_compare_coll_seq(pParse, pX->pLeft, pX->pRight,
+						&part->coll_id) == NULL &&
+		    pParse->nErr != 0)
+			return;
 	}
-	assert((u32) n == pLoop->nEq);
 
 	/* Add additional columns needed to make the automatic index into
 	 * a covering index
 	 */
-	for (i = 0; i < mxBitCol; i++) {
-		if (extraCols & MASKBIT(i)) {
-			pIdx->aiColumn[n] = i;
-			n++;
-		}
-	}
-	if (pSrc->colUsed & MASKBIT(BMS - 1)) {
-		for (i = BMS - 1; i < (int)pTable->def->field_count; i++) {
-			pIdx->aiColumn[n] = i;
-			n++;
-		}
+	for (i = 0; i < (int)space_def->field_count; i++) {
+		Bitmask mask = i >= BMS - 1 ? MASKBIT(BMS - 1) : MASKBIT(i);
+		if ((extraCols & mask) == 0)
+			continue;
+		struct key_part_def *part = &parts[n++];
+		part->fieldno = i;
+		part->type = space_def->fields[i].type;
+		part->nullable_action = ON_CONFLICT_ACTION_NONE;
+		part->is_nullable = true;
+		part->sort_order = SORT_ORDER_ASC;
+		part->coll_id = COLL_NONE;
+		part->path = NULL;
 	}
 	assert(n == nKeyCol);
-	pIdx->aiColumn[n] = XN_ROWID;
-
-	/* Create the automatic index */
+	struct key_def *key_def = key_def_new(parts, nKeyCol);
+	if (key_def == NULL)
+		goto error;
+	struct index_def *idx_def =
+		index_def_new(space_def->id, 0, "auto-index",
+			      strlen("auto-index"), TREE, &index_opts_default,
+			      key_def, NULL);
+	key_def_delete(key_def);
+	if (idx_def == NULL)
+		goto error;
+	pLoop->index_def = idx_def;
+
+	/* Create the automatic index. The last field is a row id. */
 	assert(pLevel->iIdxCur >= 0);
 	pLevel->iIdxCur = pParse->nTab++;
-	sqlVdbeAddOp2(v, OP_OpenAutoindex, pLevel->iIdxCur, nKeyCol + 1);
-	sql_vdbe_set_p4_key_def(pParse, pIdx->key_def);
-	VdbeComment((v, "for %s", pTable->def->name));
+	int reg_eph = ++pParse->nMem;
+	struct sql_key_info *key_info =
+		sql_key_info_new_from_key_def(pParse->db, idx_def->key_def);
+	if (key_info == NULL)
+		return;
+	sqlVdbeAddOp4(v, OP_OpenTEphemeral, reg_eph, nKeyCol + 1, 0,
+		      (char *)key_info, P4_KEYINFO);
+	sqlVdbeAddOp3(v, OP_IteratorOpen, pLevel->iIdxCur, 0, reg_eph);
+	VdbeComment((v, "for %s", space_def->name));
 
 	/* Fill the automatic index with content */
 	sqlExprCachePush(pParse);
-	pTabItem = &pWC->pWInfo->pTabList->a[pLevel->iFrom];
-	if (pTabItem->fg.viaCoroutine) {
-		int regYield = pTabItem->regReturn;
-		addrCounter = sqlVdbeAddOp2(v, OP_Integer, 0, 0);
-		sqlVdbeAddOp3(v, OP_InitCoroutine, regYield, 0,
-				  pTabItem->addrFillSub);
-		addrTop = sqlVdbeAddOp1(v, OP_Yield, regYield);
-		VdbeCoverage(v);
-		VdbeComment((v, "next row of \"%s\"", pTabItem->pTab->zName));
-	} else {
-		addrTop = sqlVdbeAddOp1(v, OP_Rewind, pLevel->iTabCur);
-		VdbeCoverage(v);
-	}
+	addrTop = sqlVdbeAddOp1(v, OP_Rewind, pLevel->iTabCur);
+	VdbeCoverage(v);
 	regRecord = sqlGetTempReg(pParse);
-	regBase = sql_generate_index_key(pParse, pIdx, pLevel->iTabCur,
-					 regRecord, NULL, 0);
-	sqlVdbeAddOp2(v, OP_IdxInsert, pLevel->iIdxCur, regRecord);
-	if (pTabItem->fg.viaCoroutine) {
-		sqlVdbeChangeP2(v, addrCounter, regBase + n);
-		translateColumnToCopy(v, addrTop, pLevel->iTabCur,
-				      pTabItem->regResult, 1);
-		sqlVdbeGoto(v, addrTop);
-		pTabItem->fg.viaCoroutine = 0;
-	} else {
-		sqlVdbeAddOp2(v, OP_Next, pLevel->iTabCur, addrTop + 1);
-		VdbeCoverage(v);
+	regBase = sqlGetTempRange(pParse, nKeyCol + 1);
+	for (i = 0; i < nKeyCol; i++) {
+		sqlExprCodeGetColumnOfTable(v, space_def, pLevel->iTabCur,
+					    parts[i].fieldno, regBase + i);
 	}
+	sqlVdbeAddOp2(v, OP_NextIdEphemeral, reg_eph, regBase + nKeyCol);
+	sqlVdbeAddOp3(v, OP_MakeRecord, regBase, nKeyCol + 1, regRecord);
+	sqlVdbeAddOp2(v, OP_IdxInsert, regRecord, reg_eph);
+	sqlVdbeAddOp2(v, OP_Next, pLevel->iTabCur, addrTop + 1);
+	VdbeCoverage(v);
 	sqlVdbeChangeP5(v, SQL_STMTSTATUS_AUTOINDEX);
 	sqlVdbeJumpHere(v, addrTop);
+	sqlReleaseTempRange(pParse, regBase, nKeyCol + 1);
 	sqlReleaseTempReg(pParse, regRecord);
 	sqlExprCachePop(pParse);
 
 	/* Jump here when skipping the initialization */
 	sqlVdbeJumpHere(v, addrInit);
+	return;
+error:
+	pParse->rc = SQL_TARANTOOL_ERROR;
+	pParse->nErr++;
 }
 #endif				/* SQL_OMIT_AUTOMATIC_INDEX */
 
@@ -1732,7 +1765,7 @@ whereLoopInit(WhereLoop * p)
 static void
 whereLoopClearUnion(WhereLoop * p)
 {
-	if ((p->wsFlags & WHERE_AUTO_INDEX) != 0) {
+	if ((p->wsFlags & WHERE_AUTO_INDEX) != 0 && p->index_def != NULL) {
 		index_def_delete(p->index_def);
 		p->index_def = NULL;
 	}
@@ -2833,17 +2866,24 @@ tnt_error:
 	}
 
 #ifndef SQL_OMIT_AUTOMATIC_INDEX
-	/* Automatic indexes */
-	LogEst rSize = pTab->nRowLogEst;
-	LogEst rLogSize = estLog(rSize);
+	/*
+	 * Automatic indexes. The table size comes from ANALYZE
+	 * statistics if they were collected.
+	 */
 	struct session *user_session = current_session();
 	if (!pBuilder->pOrSet	/* Not part of an OR optimization */
-	    && (pWInfo->wctrlFlags & WHERE_OR_SUBCLAUSE) == 0 && (user_session->sql_flags & SQL_AutoIndex) != 0 && pSrc->pIBIndex == 0	/* Has no INDEXED BY clause */
+	    && (pWInfo->wctrlFlags & WHERE_OR_SUBCLAUSE) == 0
+	    && (user_session->sql_flags & SQL_AutoIndex) != 0
+	    && pSrc->pIBIndex == 0	/* Has no INDEXED BY clause */
 	    && !pSrc->fg.notIndexed	/* Has no NOT INDEXED clause */
-	    && HasRowid(pTab)	/* Not WITHOUT ROWID table. (FIXME: Why not?) */
-	    &&!pSrc->fg.isCorrelated	/* Not a correlated subquery */
+	    && pTab->def->id != 0	/* Not a subquery */
+	    && !pTab->def->opts.is_view
+	    && !pSrc->fg.isCorrelated	/* Not a correlated subquery */
 	    && !pSrc->fg.isRecursive	/* Not a recursive common table expression. */
+	    && auto_index_columns_are_comparable(pTab->def, pSrc->colUsed)
 	    ) {
+		LogEst rSize = index_field_tuple_est(probe, 0);
+		LogEst rLogSize = estLog(rSize);
 		/* Generate auto-index WhereLoops */
 		WhereTerm *pTerm;
 		WhereTerm *pWCEnd = pWC->a + pWC->nTerm;
@@ -2853,22 +2893,14 @@ tnt_error:
 			if (termCanDriveIndex(pTerm, pSrc, 0)) {
 				pNew->nEq = 1;
 				pNew->nSkip = 0;
-				pNew->pIndex = 0;
+				pNew->index_def = NULL;
 				pNew->nLTerm = 1;
 				pNew->aLTerm[0] = pTerm;
 				/* TUNING: One-time cost for computing the automatic index is
 				 * estimated to be X*N*log2(N) where N is the number of rows in
-				 * the table being indexed and where X is 7 (LogEst=28) for normal
-				 * tables or 1.375 (LogEst=4) for views and subqueries.  The value
-				 * of X is smaller for views and subqueries so that the query planner
-				 * will be more aggressive about generating automatic indexes for
-				 * those objects, since there is no opportunity to add schema
-				 * indexes on subqueries and views.
+				 * the table being indexed and where X is 7 (LogEst=28).
 				 */
-				pNew->rSetup = rLogSize + rSize + 4;
-				if (!pTab->def->opts.is_view &&
-				    pTab->def->id == 0)
-					pNew->rSetup += 24;
+				pNew->rSetup = rLogSize + rSize + 28;
 				if (pNew->rSetup < 0)
 					pNew->rSetup = 0;
 				/* TUNING: Each index lookup yields 20 rows in the table.  This
@@ -2896,6 +2928,12 @@ tnt_error:
 	for (uint32_t i = 0; i < idx_count; iSortIdx++, i++) {
 		if (i > 0)
 			probe = pTab->space->index[i]->def;
+		/*
+		 * Parts of a functional index don't refer to
+		 * table columns.
+		 */
+		if (probe->opts.func_id != 0)
+			continue;
 		rSize = index_field_tuple_est(probe, 0);
 		pNew->nEq = 0;
 		pNew->nBtm = 0;
@@ -4101,7 +4139,8 @@ where_loop_builder_shortcut(struct WhereLoopBuilder *builder)
 			for (uint32_t i = 0; i < space->index_count; ++i) {
 				struct index_def *idx_def =
 					space->index[i]->def;
-				if (!idx_def->opts.is_unique)
+				if (!idx_def->opts.is_unique ||
+				    idx_def->opts.func_id != 0)
 					continue;
 				if (where_loop_assign_terms(loop, clause,
 							    cursor, space_def,
@@ -4135,6 +4174,80 @@ where_loop_builder_shortcut(struct WhereLoopBuilder *builder)
 	return 0;
 }
 
+/**
+ * Push comparisons of columns of a fully scanned table with
+ * literals down to the iterator of the table cursor, see
+ * OP_IteratorFilter, so that the engine skips rows which can't
+ * satisfy them. Only comparisons of numeric columns with
+ * numbers and of string columns with strings are pushed, since
+ * they compare the same way in SQL and in the engine. The terms
+ * are still checked by the loop code.
+ *
+ * @param pParse Parsing context.
+ * @param pWC WHERE clause of the loop.
+ * @param pTabItem Fully scanned table.
+ */
+static void
+whereEmitIteratorFilters(Parse *pParse, WhereClause *pWC,
+			 struct SrcList_item *pTabItem)
+{
+	Vdbe *v = pParse->pVdbe;
+	int iCur = pTabItem->iCursor;
+	struct space_def *def = pTabItem->pTab->def;
+	for (int i = 0; i < pWC->nTerm; i++) {
+		WhereTerm *pTerm = &pWC->a[i];
+		Expr *pExpr = pTerm->pExpr;
+		if ((pTerm->wtFlags & TERM_VIRTUAL) != 0 ||
+		    pTerm->leftCursor != iCur ||
+		    ExprHasProperty(pExpr, EP_FromJoin))
+			continue;
+		enum iterator_type type;
+		switch (pTerm->eOperator) {
+		case WO_EQ:
+			type = ITER_EQ;
+			break;
+		case WO_LT:
+			type = ITER_LT;
+			break;
+		case WO_LE:
+			type = ITER_LE;
+			break;
+		case WO_GE:
+			type = ITER_GE;
+			break;
+		case WO_GT:
+			type = ITER_GT;
+			break;
+		default:
+			continue;
+		}
+		Expr *pLeft = pExpr->pLeft;
+		Expr *pRight = pExpr->pRight;
+		if (pLeft->op != TK_COLUMN || pLeft->iTable != iCur ||
+		    pLeft->iColumn < 0)
+			continue;
+		struct field_def *field = &def->fields[pLeft->iColumn];
+		bool is_numeric = field->type == FIELD_TYPE_INTEGER ||
+				  field->type == FIELD_TYPE_UNSIGNED ||
+				  field->type == FIELD_TYPE_NUMBER;
+		if (pRight->op == TK_STRING) {
+			if (field->type != FIELD_TYPE_STRING)
+				continue;
+		} else if (pRight->op != TK_INTEGER &&
+			   pRight->op != TK_FLOAT) {
+			continue;
+		} else if (!is_numeric) {
+			continue;
+		}
+		int reg = sqlGetTempReg(pParse);
+		sqlExprCode(pParse, pRight, reg);
+		sqlVdbeAddOp4Int(v, OP_IteratorFilter, iCur, reg,
+				 pLeft->iColumn, field->coll_id);
+		sqlVdbeChangeP5(v, type);
+		sqlReleaseTempReg(pParse, reg);
+	}
+}
+
 /*
  * Generate the beginning of the loop used for WHERE clause processing.
  * The return value is a pointer to an opaque structure that contains
@@ -4568,7 +4681,21 @@ sqlWhereBegin(Parse * pParse,	/* The parser context */
 				 && pTab->nCol == BMS - 1);
 			testcase(pWInfo->eOnePass == ONEPASS_OFF
 				 && pTab->nCol == BMS);
-			sqlVdbeChangeP5(v, bFordelete);
+			/*
+			 * A full scan which doesn't modify the
+			 * space can read it ahead in batches.
+			 */
+			if ((pLoop->wsFlags &
+			     (WHERE_INDEXED | WHERE_MULTI_OR)) == 0 &&
+			    (wctrlFlags & WHERE_ONEPASS_DESIRED) == 0)
+				sqlVdbeChangeP5(v, bFordelete |
+						   OPFLAG_SCAN_BATCH);
+			else
+				sqlVdbeChangeP5(v, bFordelete);
+			if ((pLoop->wsFlags &
+			     (WHERE_INDEXED | WHERE_MULTI_OR)) == 0)
+				whereEmitIteratorFilters(pParse, &pWInfo->sWC,
+							 pTabItem);
 #ifdef SQL_ENABLE_COLUMN_USED_MASK
 			sqlVdbeAddOp4Dup8(v, OP_ColumnsUsed,
 					      pTabItem->iCursor, 0, 0,
@@ -4648,6 +4775,26 @@ sqlWhereBegin(Parse * pParse,	/* The parser context */
 					sqlVdbeChangeP5(v, OPFLAG_SEEKEQ);	/* Hint to COMDB2 */
 				}
 				VdbeComment((v, "%s", idx_def->name));
+				/*
+				 * A vinyl secondary index can skip
+				 * primary index lookups if the loop
+				 * only reads fields it stores. The
+				 * fields are known when the loop body
+				 * is coded, see sqlWhereEnd().
+				 */
+				if (op == OP_IteratorOpen && idx_def->iid != 0 &&
+				    (pLoop->wsFlags & WHERE_IDX_ONLY) != 0 &&
+				    pWInfo->eOnePass == ONEPASS_OFF &&
+				    (wctrlFlags & WHERE_OR_SUBCLAUSE) == 0 &&
+				    space_is_vinyl(space)) {
+					u64 field_mask = 0;
+					pLevel->addrFields =
+						sqlVdbeAddOp4Dup8(v,
+							OP_IteratorFields,
+							iIndexCur, 0, 0,
+							(u8 *)&field_mask,
+							P4_INT64);
+				}
 #ifdef SQL_ENABLE_COLUMN_USED_MASK
 				{
 					u64 colUsed = 0;
@@ -4694,7 +4841,7 @@ sqlWhereBegin(Parse * pParse,	/* The parser context */
 			constructAutomaticIndex(pParse, &pWInfo->sWC,
 						&pTabList->a[pLevel->iFrom],
 						notReady, pLevel);
-			if (db->mallocFailed)
+			if (db->mallocFailed || pParse->nErr != 0)
 				goto whereBeginError;
 		}
 #endif
@@ -4724,6 +4871,46 @@ sqlWhereBegin(Parse * pParse,	/* The parser context */
 	return 0;
 }
 
+/**
+ * Account an opcode of the body of a WHERE loop level which
+ * uses the index cursor of the level opened with fields set by
+ * OP_IteratorFields. OP_Column adds its field to the set, while
+ * an opcode that may need the whole tuple turns OP_IteratorFields
+ * into no-op.
+ *
+ * @param v VDBE.
+ * @param level WHERE loop level.
+ * @param op Opcode using level->iIdxCur.
+ */
+static void
+where_level_add_fields(struct Vdbe *v, struct WhereLevel *level,
+		       struct VdbeOp *op)
+{
+	struct VdbeOp *fields = sqlVdbeGetOp(v, level->addrFields);
+	assert(fields->opcode == OP_IteratorFields);
+	switch (op->opcode) {
+	case OP_Column:
+		column_mask_set_fieldno((uint64_t *)fields->p4.pI64, op->p2);
+		break;
+	case OP_Next:
+	case OP_Prev:
+	case OP_NullRow:
+	case OP_Close:
+	case OP_SeekGE:
+	case OP_SeekGT:
+	case OP_SeekLE:
+	case OP_SeekLT:
+	case OP_IdxGE:
+	case OP_IdxGT:
+	case OP_IdxLE:
+	case OP_IdxLT:
+		break;
+	default:
+		sqlVdbeChangeToNoop(v, level->addrFields);
+		level->addrFields = 0;
+	}
+}
+
 /*
  * Generate the end of the WHERE loop.  See comments on
  * sqlWhereBegin() for additional information.
@@ -4866,12 +5053,20 @@ sqlWhereEnd(WhereInfo * pWInfo)
 			k = pLevel->addrBody;
 			pOp = sqlVdbeGetOp(v, k);
 			for (; k < last; k++, pOp++) {
+				if (pLevel->addrFields != 0 &&
+				    pOp->p1 == pLevel->iIdxCur)
+					where_level_add_fields(v, pLevel, pOp);
 				if (pOp->p1 != pLevel->iTabCur)
 					continue;
 				if (pOp->opcode == OP_Column) {
 					int x = pOp->p2;
 					assert(def == NULL ||
 					       def->space_id == pTab->def->id);
+#ifndef SQL_OMIT_AUTOMATIC_INDEX
+					if ((pLoop->wsFlags &
+					     WHERE_AUTO_INDEX) != 0)
+						x = auto_index_column(def, x);
+#endif
 					if (x >= 0) {
 						pOp->p2 = x;
 						pOp->p1 = pLevel->iIdxCur;
@@ -4879,6 +5074,9 @@ sqlWhereEnd(WhereInfo * pWInfo)
 					assert((pLoop->
 						wsFlags & WHERE_IDX_ONLY) == 0
 					       || x >= 0);
+					if (pLevel->addrFields != 0 && x >= 0)
+						where_level_add_fields(v, pLevel,
+								       pOp);
 				}
 			}
 		}
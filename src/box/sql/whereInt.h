@@ -86,6 +86,7 @@ struct WhereLevel {
 	int addrCont;		/* Jump here to continue with the next loop cycle */
 	int addrFirst;		/* First instruction of interior of the loop */
 	int addrBody;		/* Beginning of the body of this loop */
+	int addrFields;		/* OP_IteratorFields of iIdxCur, or 0 */
 #ifndef SQL_LIKE_DOESNT_MATCH_BLOBS
 	u32 iLikeRepCntr;	/* LIKE range processing counter register (times 2) */
 	int addrLikeRep;	/* LIKE range processing address */
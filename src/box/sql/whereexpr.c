@@ -229,6 +229,14 @@ operatorMask(int op)
  * never a number. The collating sequence for the column on the
  * LHS must be appropriate for the operator.
  *
+ * A case sensitive LIKE is optimized only for a column without
+ * collation, since its range follows the byte order. A case
+ * insensitive LIKE on such column is optimized with a binary
+ * range from the all-uppercase to the all-lowercase prefix, which
+ * holds all case variants of an ASCII prefix. Non-ASCII
+ * characters and 'i', 'k', which also match non-ASCII
+ * characters ignoring case, end the prefix.
+ *
  * @param pParse      Parsing and code generating context.
  * @param pExpr       Test this expression.
  * @param ppPrefix    Pointer to TK_STRING expression with
@@ -236,13 +244,14 @@ operatorMask(int op)
  * @param pisComplete True if the only wildcard is '%' in the
  *                    last character.
  * @param pnoCase     True if case insensitive.
+ * @param pisBinary   True if the column has no collation.
  *
  * @retval True if the given expr is a LIKE operator & is
  *         optimizable using inequality constraints.
  */
 static int
 like_optimization_is_valid(Parse *pParse, Expr *pExpr, Expr **ppPrefix,
-			   int *pisComplete, int *pnoCase)
+			   int *pisComplete, int *pnoCase, bool *pisBinary)
 {
 	/* String on RHS of LIKE operator. */
 	const char *z = 0;
@@ -277,6 +286,12 @@ like_optimization_is_valid(Parse *pParse, Expr *pExpr, Expr **ppPrefix,
 		return 0;
 	}
 	assert(pLeft->iColumn != (-1));	/* Because IPK never has AFF_TEXT */
+	bool unused;
+	uint32_t coll_id;
+	sql_expr_coll(pParse, pLeft, &unused, &coll_id);
+	*pisBinary = coll_id == COLL_NONE;
+	if (!*pnoCase && !*pisBinary)
+		return 0;
 
 	pRight = sqlExprSkipCollate(pList->a[0].pExpr);
 	op = pRight->op;
@@ -299,10 +314,20 @@ like_optimization_is_valid(Parse *pParse, Expr *pExpr, Expr **ppPrefix,
 		while ((c = z[cnt]) != 0 && c != MATCH_ONE_WILDCARD &&
 		       c != MATCH_ALL_WILDCARD)
 			cnt++;
-		if (cnt != 0 && 255 != (u8) z[cnt - 1]) {
+		int prefix_len = cnt;
+		if (*pnoCase && *pisBinary) {
+			prefix_len = 0;
+			while (prefix_len < cnt &&
+			       (u8) z[prefix_len] < 0x80 &&
+			       strchr("iIkK", z[prefix_len]) == NULL)
+				prefix_len++;
+		}
+		if (prefix_len != 0 && 255 != (u8) z[prefix_len - 1]) {
 			Expr *pPrefix;
 			*pisComplete = c == MATCH_ALL_WILDCARD &&
-				       z[cnt + 1] == 0;
+				       z[cnt + 1] == 0 &&
+				       !(*pnoCase && *pisBinary);
+			cnt = prefix_len;
 			pPrefix = sqlExpr(db, TK_STRING, z);
 			if (pPrefix)
 				pPrefix->u.zToken[cnt] = 0;
@@ -974,6 +999,8 @@ exprAnalyze(SrcList * pSrc,	/* the FROM clause */
 	int isComplete = 0;
 	/* uppercase equivalent to lowercase. */
 	int noCase = 0;
+	/* LIKE column has no collation. */
+	bool is_binary = false;
 	/* Top-level operator. pExpr->op. */
 	int op;
 	/* Parsing context. */
@@ -1149,11 +1176,13 @@ exprAnalyze(SrcList * pSrc,	/* the FROM clause */
 	 * not significant (the default for LIKE) then the
 	 * lower-bound is made all uppercase and the upper-bound
 	 * is made all lowercase so that the bounds also work
-	 * when comparing BLOBs.
+	 * when comparing BLOBs and columns without collation.
+	 * In the latter case the bounds are compared in byte
+	 * order and the LIKE is still checked for each row.
 	 */
 	if (pWC->op == TK_AND &&
 	    like_optimization_is_valid(pParse, pExpr, &pStr1,
-				       &isComplete, &noCase)) {
+				       &isComplete, &noCase, &is_binary)) {
 		Expr *pLeft;
 		/* Copy of pStr1 - RHS of LIKE operator. */
 		Expr *pStr2;
@@ -1201,7 +1230,7 @@ exprAnalyze(SrcList * pSrc,	/* the FROM clause */
 			*pC = c + 1;
 		}
 		pNewExpr1 = sqlExprDup(db, pLeft, 0);
-		if (noCase) {
+		if (noCase && !is_binary) {
 			pNewExpr1 =
 				sqlExprAddCollateString(pParse, pNewExpr1,
 							    "unicode_ci");
@@ -1212,7 +1241,7 @@ exprAnalyze(SrcList * pSrc,	/* the FROM clause */
 		testcase(idxNew1 == 0);
 		exprAnalyze(pSrc, pWC, idxNew1);
 		pNewExpr2 = sqlExprDup(db, pLeft, 0);
-		if (noCase) {
+		if (noCase && !is_binary) {
 			pNewExpr2 =
 				sqlExprAddCollateString(pParse, pNewExpr2,
 							    "unicode_ci");
@@ -0,0 +1,247 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "sql_stmt_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "assoc.h"
+#include "diag.h"
+#include "say.h"
+#include "sql/sqlInt.h"
+
+/** Statement cache, accessed from the tx thread only. */
+struct stmt_cache {
+	/** Query text -> struct stmt_cache_entry. */
+	struct mh_strnptr_t *by_text;
+	/** Statement id -> struct stmt_cache_entry. */
+	struct mh_i32ptr_t *by_id;
+	/** Entries, most recently used first. */
+	struct rlist lru;
+	/** Memory taken by cached statements. */
+	size_t mem_used;
+	/** Memory limit. */
+	size_t mem_quota;
+	/** Id of the next added statement. */
+	uint32_t next_id;
+};
+
+static struct stmt_cache stmt_cache;
+
+void
+sql_stmt_cache_init(void)
+{
+	stmt_cache.by_text = mh_strnptr_new();
+	stmt_cache.by_id = mh_i32ptr_new();
+	if (stmt_cache.by_text == NULL || stmt_cache.by_id == NULL)
+		panic("failed to allocate SQL statement cache");
+	rlist_create(&stmt_cache.lru);
+	stmt_cache.mem_used = 0;
+	stmt_cache.mem_quota = 0;
+	stmt_cache.next_id = 1;
+}
+
+static void
+stmt_cache_entry_delete(struct stmt_cache_entry *entry)
+{
+	sql_finalize(entry->stmt);
+	free(entry->sql);
+	free(entry);
+}
+
+/**
+ * Remove an entry from the cache. A busy entry is freed by
+ * the request executing it.
+ */
+static void
+stmt_cache_evict(struct stmt_cache_entry *entry)
+{
+	struct stmt_cache *cache = &stmt_cache;
+	mh_int_t k = mh_strnptr_find_inp(cache->by_text, entry->sql,
+					 entry->sql_len);
+	assert(k != mh_end(cache->by_text));
+	mh_strnptr_del(cache->by_text, k, NULL);
+	k = mh_i32ptr_find(cache->by_id, entry->id, NULL);
+	assert(k != mh_end(cache->by_id));
+	mh_i32ptr_del(cache->by_id, k, NULL);
+	rlist_del_entry(entry, in_lru);
+	assert(cache->mem_used >= entry->size);
+	cache->mem_used -= entry->size;
+	if (entry->is_busy)
+		entry->is_evicted = true;
+	else
+		stmt_cache_entry_delete(entry);
+}
+
+/**
+ * Evict least recently used entries until the cache fits in
+ * its quota. @a keep is never evicted.
+ */
+static void
+stmt_cache_shrink(struct stmt_cache_entry *keep)
+{
+	struct stmt_cache *cache = &stmt_cache;
+	while (cache->mem_used > cache->mem_quota) {
+		struct stmt_cache_entry *victim =
+			rlist_last_entry(&cache->lru, struct stmt_cache_entry,
+					 in_lru);
+		if (victim == keep)
+			break;
+		stmt_cache_evict(victim);
+	}
+}
+
+void
+sql_stmt_cache_set_size(size_t size)
+{
+	stmt_cache.mem_quota = size;
+	stmt_cache_shrink(NULL);
+}
+
+static inline struct stmt_cache_entry *
+stmt_cache_touch(struct stmt_cache_entry *entry)
+{
+	rlist_move_entry(&stmt_cache.lru, entry, in_lru);
+	return entry;
+}
+
+struct stmt_cache_entry *
+sql_stmt_cache_find(const char *sql, uint32_t len)
+{
+	struct mh_strnptr_t *h = stmt_cache.by_text;
+	mh_int_t k = mh_strnptr_find_inp(h, sql, len);
+	if (k == mh_end(h))
+		return NULL;
+	return stmt_cache_touch(mh_strnptr_node(h, k)->val);
+}
+
+struct stmt_cache_entry *
+sql_stmt_cache_find_by_id(uint32_t id)
+{
+	struct mh_i32ptr_t *h = stmt_cache.by_id;
+	mh_int_t k = mh_i32ptr_find(h, id, NULL);
+	if (k == mh_end(h))
+		return NULL;
+	return stmt_cache_touch(mh_i32ptr_node(h, k)->val);
+}
+
+/** Memory accounted for a statement compiled from @a len bytes. */
+static inline size_t
+stmt_cache_entry_size(struct sql_stmt *stmt, uint32_t len)
+{
+	return sizeof(struct stmt_cache_entry) + len + sql_stmt_est_size(stmt);
+}
+
+int
+sql_stmt_cache_insert(struct sql_stmt *stmt, const char *sql, uint32_t len,
+		      uint32_t schema_version, uint32_t stat_version,
+		      struct stmt_cache_entry **entry)
+{
+	struct stmt_cache *cache = &stmt_cache;
+	*entry = NULL;
+	size_t size = stmt_cache_entry_size(stmt, len);
+	if (size > cache->mem_quota)
+		return 0;
+	struct stmt_cache_entry *e =
+		(struct stmt_cache_entry *) malloc(sizeof(*e));
+	char *text = (char *) malloc(len);
+	if (e == NULL || text == NULL) {
+		free(e);
+		free(text);
+		diag_set(OutOfMemory, sizeof(*e) + len, "malloc",
+			 "struct stmt_cache_entry");
+		return -1;
+	}
+	memcpy(text, sql, len);
+	/* Skip ids which are still taken after a wrap around. */
+	uint32_t id;
+	do {
+		id = cache->next_id++;
+	} while (id == 0 || mh_i32ptr_find(cache->by_id, id, NULL) !=
+			    mh_end(cache->by_id));
+	e->id = id;
+	e->stmt = stmt;
+	e->sql = text;
+	e->sql_len = len;
+	e->size = size;
+	e->schema_version = schema_version;
+	e->stat_version = stat_version;
+	e->is_busy = false;
+	e->is_evicted = false;
+
+	const struct mh_i32ptr_node_t id_node = { id, e };
+	const struct mh_strnptr_node_t text_node = {
+		text, len, mh_strn_hash(text, len), e
+	};
+	mh_int_t k = mh_i32ptr_put(cache->by_id, &id_node, NULL, NULL);
+	if (k == mh_end(cache->by_id))
+		goto error;
+	if (mh_strnptr_put(cache->by_text, &text_node, NULL, NULL) ==
+	    mh_end(cache->by_text)) {
+		mh_i32ptr_del(cache->by_id, k, NULL);
+		goto error;
+	}
+	rlist_add_entry(&cache->lru, e, in_lru);
+	cache->mem_used += size;
+	stmt_cache_shrink(e);
+	*entry = e;
+	return 0;
+error:
+	free(text);
+	free(e);
+	diag_set(OutOfMemory, 0, "mhash", "stmt_cache");
+	return -1;
+}
+
+void
+sql_stmt_cache_update(struct stmt_cache_entry *entry, struct sql_stmt *stmt,
+		      uint32_t schema_version, uint32_t stat_version)
+{
+	assert(!entry->is_busy && !entry->is_evicted);
+	sql_finalize(entry->stmt);
+	entry->stmt = stmt;
+	entry->schema_version = schema_version;
+	entry->stat_version = stat_version;
+	size_t size = stmt_cache_entry_size(stmt, entry->sql_len);
+	stmt_cache.mem_used = stmt_cache.mem_used - entry->size + size;
+	entry->size = size;
+	stmt_cache_shrink(entry);
+}
+
+void
+sql_stmt_cache_release(struct stmt_cache_entry *entry)
+{
+	assert(entry->is_busy);
+	entry->is_busy = false;
+	if (entry->is_evicted)
+		stmt_cache_entry_delete(entry);
+}
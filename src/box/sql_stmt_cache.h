@@ -0,0 +1,145 @@
+#ifndef TARANTOOL_BOX_SQL_STMT_CACHE_H_INCLUDED
+#define TARANTOOL_BOX_SQL_STMT_CACHE_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "small/rlist.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct sql_stmt;
+
+/**
+ * A compiled SQL statement shared by all sessions. Entries are
+ * looked up by query text for EXECUTE and by id for statements
+ * compiled with PREPARE.
+ */
+struct stmt_cache_entry {
+	/** Unique statement id, returned by PREPARE. */
+	uint32_t id;
+	/** Compiled statement. */
+	struct sql_stmt *stmt;
+	/** Query text, not null-terminated. */
+	char *sql;
+	/** Length of @sql. */
+	uint32_t sql_len;
+	/** Memory accounted for the entry. */
+	size_t size;
+	/** Schema version the statement was compiled for. */
+	uint32_t schema_version;
+	/** Version of index statistics used to plan the statement. */
+	uint32_t stat_version;
+	/**
+	 * Set while the statement is being executed. A running
+	 * statement can't be shared, so a concurrent request
+	 * for the same query compiles a private copy.
+	 */
+	bool is_busy;
+	/**
+	 * Set if the entry was evicted while being executed.
+	 * Such an entry is freed when its execution completes.
+	 */
+	bool is_evicted;
+	/** Link in the LRU list of the cache. */
+	struct rlist in_lru;
+};
+
+/** Initialize the statement cache. */
+void
+sql_stmt_cache_init(void);
+
+/**
+ * Set the memory limit of the cache. Evicts least recently
+ * used statements if they don't fit anymore.
+ */
+void
+sql_stmt_cache_set_size(size_t size);
+
+/**
+ * Find a statement by query text and mark it as most recently
+ * used. Return NULL if the query isn't cached.
+ */
+struct stmt_cache_entry *
+sql_stmt_cache_find(const char *sql, uint32_t len);
+
+/**
+ * Find a statement by id and mark it as most recently used.
+ * Return NULL if there's no statement with such id.
+ */
+struct stmt_cache_entry *
+sql_stmt_cache_find_by_id(uint32_t id);
+
+/**
+ * Add a compiled statement to the cache, evicting least recently
+ * used statements to make room for it. On success the cache
+ * takes over the statement.
+ *
+ * @param stmt Compiled statement.
+ * @param sql Query text.
+ * @param len Length of @a sql.
+ * @param schema_version Schema version of @a stmt.
+ * @param stat_version Statistics version of @a stmt.
+ * @param[out] entry New cache entry, or NULL if the statement
+ *        doesn't fit in the cache and is left to the caller.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+sql_stmt_cache_insert(struct sql_stmt *stmt, const char *sql, uint32_t len,
+		      uint32_t schema_version, uint32_t stat_version,
+		      struct stmt_cache_entry **entry);
+
+/**
+ * Replace the statement of an idle entry with a new one,
+ * recompiled after a schema or statistics change.
+ */
+void
+sql_stmt_cache_update(struct stmt_cache_entry *entry, struct sql_stmt *stmt,
+		      uint32_t schema_version, uint32_t stat_version);
+
+/**
+ * Mark an entry as not executed anymore. Frees the entry if it
+ * was evicted during execution.
+ */
+void
+sql_stmt_cache_release(struct stmt_cache_entry *entry);
+
+#if defined(__cplusplus)
+} /* extern "C" { */
+#endif
+
+#endif /* TARANTOOL_BOX_SQL_STMT_CACHE_H_INCLUDED */
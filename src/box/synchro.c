@@ -0,0 +1,115 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "synchro.h"
+
+#include <stdlib.h>
+
+#include "fiber.h"
+#include "diag.h"
+#include "errcode.h"
+#include "replication.h"
+#include "relay.h"
+#include "vclock.h"
+
+struct synchro synchro;
+
+void
+synchro_init(void)
+{
+	synchro.confirmed_lsn = 0;
+	fiber_cond_create(&synchro.cond);
+}
+
+void
+synchro_free(void)
+{
+	fiber_cond_destroy(&synchro.cond);
+}
+
+static int
+synchro_cmp_lsn_desc(const void *a, const void *b)
+{
+	int64_t lsn_a = *(const int64_t *)a;
+	int64_t lsn_b = *(const int64_t *)b;
+	return lsn_a < lsn_b ? 1 : lsn_a > lsn_b ? -1 : 0;
+}
+
+void
+synchro_update(void)
+{
+	if (replication_synchro_quorum <= 1) {
+		/* Nothing to wait for, release all waiters. */
+		fiber_cond_broadcast(&synchro.cond);
+		return;
+	}
+	if (instance_id == REPLICA_ID_NIL)
+		return;
+	int64_t acks[VCLOCK_MAX];
+	int count = 0;
+	replicaset_foreach(replica) {
+		if (replica->id == REPLICA_ID_NIL ||
+		    replica->id == instance_id || replica->relay == NULL)
+			continue;
+		acks[count++] = vclock_get(relay_vclock(replica->relay),
+					   instance_id);
+	}
+	/* This instance is a part of the quorum. */
+	int needed = replication_synchro_quorum - 1;
+	if (count < needed)
+		return;
+	qsort(acks, count, sizeof(acks[0]), synchro_cmp_lsn_desc);
+	int64_t lsn = acks[needed - 1];
+	if (lsn > synchro.confirmed_lsn) {
+		synchro.confirmed_lsn = lsn;
+		fiber_cond_broadcast(&synchro.cond);
+	}
+}
+
+int
+synchro_wait(int64_t lsn)
+{
+	double deadline = ev_monotonic_now(loop()) +
+			  replication_synchro_timeout;
+	synchro_update();
+	while (replication_synchro_quorum > 1 &&
+	       synchro.confirmed_lsn < lsn) {
+		if (fiber_cond_wait_deadline(&synchro.cond, deadline) == 0)
+			continue;
+		if (fiber_is_cancelled())
+			return -1;
+		if (replication_synchro_quorum > 1 &&
+		    synchro.confirmed_lsn < lsn) {
+			diag_set(ClientError, ER_SYNC_QUORUM_TIMEOUT);
+			return -1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,96 @@
+#ifndef TARANTOOL_BOX_SYNCHRO_H_INCLUDED
+#define TARANTOOL_BOX_SYNCHRO_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdint.h>
+
+#include "fiber_cond.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Synchronous replication.
+ *
+ * A transaction that changes a space with is_sync option is
+ * written to the local WAL as usual, but its commit returns
+ * only after replication_synchro_quorum instances, this one
+ * included, have written it. Replicas report what they have
+ * written with the vclock they send to relays, so no extra
+ * messages are needed: each acknowledgement confirms all
+ * transactions preceding it, and any number of transactions
+ * may wait for a quorum at the same time.
+ */
+struct synchro {
+	/**
+	 * Max LSN of this instance which is known to be
+	 * written by the quorum.
+	 */
+	int64_t confirmed_lsn;
+	/** Signaled when confirmed_lsn or the quorum changes. */
+	struct fiber_cond cond;
+};
+
+extern struct synchro synchro;
+
+void
+synchro_init(void);
+
+void
+synchro_free(void);
+
+/**
+ * Recalculate the confirmed LSN from the vclocks acknowledged
+ * by replicas and wake up transactions waiting for it. Called
+ * when a relay receives a new vclock from its replica and when
+ * the quorum is reconfigured.
+ */
+void
+synchro_update(void);
+
+/**
+ * Wait until a row of this instance with the given LSN is
+ * written by the quorum.
+ *
+ * @retval  0 Success.
+ * @retval -1 replication_synchro_timeout has passed or the
+ *            fiber was cancelled. Note, the transaction is
+ *            committed locally anyway.
+ */
+int
+synchro_wait(int64_t lsn);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_SYNCHRO_H_INCLUDED */
@@ -192,9 +192,16 @@ static const struct index_vtab sysview_index_vtab = {
 	/* .max = */ generic_index_max,
 	/* .random = */ generic_index_random,
 	/* .count = */ generic_index_count,
+	/* .estimate_count = */ generic_index_estimate_count,
 	/* .get = */ sysview_index_get,
+	/* .get_batch = */ generic_index_get_batch,
 	/* .replace = */ generic_index_replace,
+	/* .replace_in_place = */ generic_index_replace_in_place,
 	/* .create_iterator = */ sysview_index_create_iterator,
+	/* .create_covering_iterator = */
+		generic_index_create_covering_iterator,
+	/* .create_filtered_iterator = */
+		generic_index_create_filtered_iterator,
 	/* .create_snapshot_iterator = */
 		generic_index_create_snapshot_iterator,
 	/* .stat = */ generic_index_stat,
@@ -495,6 +502,8 @@ static const struct space_vtab sysview_space_vtab = {
 	/* .build_index = */ generic_space_build_index,
 	/* .swap_index = */ generic_space_swap_index,
 	/* .prepare_alter = */ generic_space_prepare_alter,
+	/* .finish_alter = */ generic_space_finish_alter,
+	/* .bulk_load = */ generic_space_bulk_load,
 };
 
 static void
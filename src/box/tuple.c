@@ -30,12 +30,17 @@
  */
 #include "tuple.h"
 
+#include <inttypes.h>
+#include <stdio.h>
+#include <sys/mman.h>
+
 #include "trivia/util.h"
 #include "memory.h"
 #include "fiber.h"
 #include "tt_uuid.h"
 #include "small/quota.h"
 #include "small/small.h"
+#include "small/slab_cache.h"
 
 #include "tuple_update.h"
 #include "coll_id_cache.h"
@@ -46,8 +51,104 @@ static struct small_alloc runtime_alloc;
 enum {
 	/** Lowest allowed slab_alloc_minimal */
 	OBJSIZE_MIN = 16,
+	/** Size of a slab of the runtime tuple arena. */
+	RUNTIME_ARENA_SLAB_SIZE = 16 * 1024,
+	/**
+	 * Biggest runtime tuple allocated from the arena.
+	 * Bigger ones are allocated with runtime_alloc.
+	 */
+	RUNTIME_ARENA_OBJSIZE_MAX = 1024,
 };
 
+/**
+ * A slab of the runtime tuple arena.
+ *
+ * Lua procedures tend to create lots of short-lived tuples with
+ * box.tuple.new() and tuple:update(). Small runtime tuples are
+ * carved out of the current slab by bumping a pointer, and the
+ * slab only counts how many of them are still alive. Deleting
+ * such a tuple is a decrement. When the last tuple of a slab is
+ * deleted, the slab is either reused from the start, if it's
+ * still the current one, or returned to the slab cache.
+ */
+struct runtime_slab {
+	/** Slab header, must go first. */
+	struct slab slab;
+	/** Number of bytes used, including this header. */
+	uint32_t used;
+	/** Number of tuples allocated from the slab and not freed. */
+	uint32_t live_count;
+};
+
+static struct runtime_arena {
+	/** Slab tuples are allocated from. */
+	struct runtime_slab *current;
+	/** Order of arena slabs in the cord slab cache. */
+	uint8_t slab_order;
+	/** Mask to get a slab by a pointer to a tuple. */
+	intptr_t slab_ptr_mask;
+} runtime_arena;
+
+static void
+runtime_arena_create(struct runtime_arena *arena)
+{
+	struct slab_cache *cache = &cord()->slabc;
+	arena->current = NULL;
+	arena->slab_order = slab_order(cache, RUNTIME_ARENA_SLAB_SIZE);
+	arena->slab_ptr_mask =
+		~((intptr_t)slab_order_size(cache, arena->slab_order) - 1);
+}
+
+static void
+runtime_arena_destroy(struct runtime_arena *arena)
+{
+	/*
+	 * Slabs with live tuples are released along with
+	 * the cord slab cache.
+	 */
+	if (arena->current != NULL && arena->current->live_count == 0)
+		slab_put_with_order(&cord()->slabc, &arena->current->slab);
+	arena->current = NULL;
+}
+
+static void *
+runtime_arena_alloc(struct runtime_arena *arena, size_t size)
+{
+	assert(size <= RUNTIME_ARENA_OBJSIZE_MAX);
+	size = small_align(size, sizeof(intptr_t));
+	struct runtime_slab *rs = arena->current;
+	if (rs == NULL || rs->used + size > rs->slab.size) {
+		struct slab *slab = slab_get_with_order(&cord()->slabc,
+							arena->slab_order);
+		if (slab == NULL)
+			return NULL;
+		if (rs != NULL && rs->live_count == 0)
+			slab_put_with_order(&cord()->slabc, &rs->slab);
+		rs = (struct runtime_slab *)slab;
+		rs->used = small_align(sizeof(*rs), sizeof(intptr_t));
+		rs->live_count = 0;
+		arena->current = rs;
+	}
+	void *ptr = (char *)rs + rs->used;
+	rs->used += size;
+	rs->live_count++;
+	return ptr;
+}
+
+static void
+runtime_arena_free(struct runtime_arena *arena, void *ptr)
+{
+	struct runtime_slab *rs =
+		(struct runtime_slab *)slab_from_ptr(ptr, arena->slab_ptr_mask);
+	assert(rs->live_count > 0);
+	if (--rs->live_count > 0)
+		return;
+	if (rs == arena->current)
+		rs->used = small_align(sizeof(*rs), sizeof(intptr_t));
+	else
+		slab_put_with_order(&cord()->slabc, &rs->slab);
+}
+
 static const double ALLOC_FACTOR = 1.05;
 
 /**
@@ -68,6 +169,7 @@ runtime_tuple_new(struct tuple_format *format, const char *data, const char *end
 static struct tuple_format_vtab tuple_format_runtime_vtab = {
 	runtime_tuple_delete,
 	runtime_tuple_new,
+	NULL,
 };
 
 static struct tuple *
@@ -80,7 +182,12 @@ runtime_tuple_new(struct tuple_format *format, const char *data, const char *end
 	size_t total = sizeof(struct tuple) + format->field_map_size +
 		data_len;
 
-	struct tuple *tuple = (struct tuple *) smalloc(&runtime_alloc, total);
+	struct tuple *tuple;
+	if (total <= RUNTIME_ARENA_OBJSIZE_MAX)
+		tuple = (struct tuple *) runtime_arena_alloc(&runtime_arena,
+							     total);
+	else
+		tuple = (struct tuple *) smalloc(&runtime_alloc, total);
 	if (tuple == NULL) {
 		diag_set(OutOfMemory, (unsigned) total,
 			 "malloc", "tuple");
@@ -112,7 +219,10 @@ runtime_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 	size_t total = sizeof(struct tuple) + format->field_map_size +
 		tuple->bsize;
 	tuple_format_unref(format);
-	smfree(&runtime_alloc, tuple, total);
+	if (total <= RUNTIME_ARENA_OBJSIZE_MAX)
+		runtime_arena_free(&runtime_arena, tuple);
+	else
+		smfree(&runtime_alloc, tuple, total);
 }
 
 int
@@ -302,7 +412,7 @@ tuple_init(field_name_hash_f hash)
 	 */
 	tuple_format_runtime = tuple_format_new(&tuple_format_runtime_vtab, NULL,
 						NULL, 0, NULL, 0, 0, NULL, false,
-						false);
+						false, false, false);
 	if (tuple_format_runtime == NULL)
 		return -1;
 
@@ -311,6 +421,7 @@ tuple_init(field_name_hash_f hash)
 
 	small_alloc_create(&runtime_alloc, &cord()->slabc, OBJSIZE_MIN,
 			   ALLOC_FACTOR);
+	runtime_arena_create(&runtime_arena);
 
 	mempool_create(&tuple_iterator_pool, &cord()->slabc,
 		       sizeof(struct tuple_iterator));
@@ -328,7 +439,7 @@ tuple_init(field_name_hash_f hash)
 void
 tuple_arena_create(struct slab_arena *arena, struct quota *quota,
 		   uint64_t arena_max_size, uint32_t slab_size,
-		   const char *arena_name)
+		   bool use_hugepages, const char *arena_name)
 {
 	/*
 	 * Ensure that quota is a multiple of slab_size, to
@@ -339,6 +450,24 @@ tuple_arena_create(struct slab_arena *arena, struct quota *quota,
 	say_info("mapping %zu bytes for %s tuple arena...", prealloc,
 		 arena_name);
 
+#ifdef MAP_HUGETLB
+	/*
+	 * Slabs are aligned by slab_size, which is a multiple of
+	 * the huge page size, so the arena can be mapped to
+	 * hugetlbfs as is, provided enough pages are reserved.
+	 */
+	if (use_hugepages) {
+		if (slab_arena_create(arena, quota, prealloc, slab_size,
+				      MAP_PRIVATE | MAP_HUGETLB) == 0) {
+			say_info("%s tuple arena is backed by hugetlb pages",
+				 arena_name);
+			return;
+		}
+		say_warn("failed to map %s tuple arena to hugetlb pages: %s, "
+			 "falling back to transparent huge pages",
+			 arena_name, strerror(errno));
+	}
+#endif
 	if (slab_arena_create(arena, quota, prealloc, slab_size,
 			      MAP_PRIVATE) != 0) {
 		if (errno == ENOMEM) {
@@ -350,6 +479,45 @@ tuple_arena_create(struct slab_arena *arena, struct quota *quota,
 				       " tuple arena", prealloc, arena_name);
 		}
 	}
+	if (!use_hugepages)
+		return;
+#ifdef MADV_HUGEPAGE
+	if (madvise(arena->arena, arena->prealloc, MADV_HUGEPAGE) == 0)
+		return;
+#else
+	errno = ENOTSUP;
+#endif
+	say_warn("failed to enable transparent huge pages for %s tuple "
+		 "arena: %s", arena_name, strerror(errno));
+}
+
+size_t
+tuple_arena_hugepage_size(struct slab_arena *arena)
+{
+#ifdef MAP_HUGETLB
+	if ((arena->flags & MAP_HUGETLB) != 0)
+		return arena->used;
+#endif
+	size_t size = 0;
+	FILE *f = fopen("/proc/self/smaps", "r");
+	if (f == NULL)
+		return 0;
+	uintptr_t begin = (uintptr_t)arena->arena;
+	uintptr_t end = begin + arena->prealloc;
+	bool is_arena = false;
+	char line[256];
+	while (fgets(line, sizeof(line), f) != NULL) {
+		uintptr_t vma_begin, vma_end;
+		size_t kb;
+		if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR,
+			   &vma_begin, &vma_end) == 2)
+			is_arena = vma_begin < end && vma_end > begin;
+		else if (is_arena &&
+			 sscanf(line, "AnonHugePages: %zu kB", &kb) == 1)
+			size += kb * 1024;
+	}
+	fclose(f);
+	return size;
 }
 
 void
@@ -368,6 +536,7 @@ tuple_free(void)
 	}
 
 	mempool_destroy(&tuple_iterator_pool);
+	runtime_arena_destroy(&runtime_arena);
 	small_alloc_destroy(&runtime_alloc);
 
 	tuple_format_free();
@@ -471,6 +640,13 @@ tuple_go_to_path(const char **data, const char *path, uint32_t path_len)
 		case JSON_TOKEN_STR:
 			rc = tuple_field_go_to_key(data, token.str, token.len);
 			break;
+		case JSON_TOKEN_ANY:
+			/*
+			 * [*] stands for any array element and
+			 * can't be used to access a single field.
+			 */
+			rc = -1;
+			break;
 		default:
 			assert(token.type == JSON_TOKEN_END);
 			return 0;
@@ -529,7 +705,8 @@ tuple_field_raw_by_full_path(struct tuple_format *format, const char *tuple,
 		break;
 	}
 	default:
-		assert(token.type == JSON_TOKEN_END);
+		assert(token.type == JSON_TOKEN_END ||
+		       token.type == JSON_TOKEN_ANY);
 		return NULL;
 	}
 	return tuple_field_raw_by_path(format, tuple, field_map, fieldno,
@@ -553,7 +730,7 @@ box_tuple_format_new(struct key_def **keys, uint16_t key_count)
 	box_tuple_format_t *format =
 		tuple_format_new(&tuple_format_runtime_vtab, NULL,
 				 keys, key_count, NULL, 0, 0, NULL, false,
-				 false);
+				 false, false, false);
 	if (format != NULL)
 		tuple_format_ref(format);
 	return format;
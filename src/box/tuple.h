@@ -64,12 +64,23 @@ tuple_free(void);
  * @param arena[out] Arena to initialize.
  * @param quota Arena's quota.
  * @param arena_max_size Maximal size of @arena.
+ * @param use_hugepages Try to back @arena with huge pages:
+ *        hugetlb ones if reserved in the system, transparent
+ *        huge pages otherwise.
  * @param arena_name Name of @arena for logs.
  */
 void
 tuple_arena_create(struct slab_arena *arena, struct quota *quota,
 		   uint64_t arena_max_size, uint32_t slab_size,
-		   const char *arena_name);
+		   bool use_hugepages, const char *arena_name);
+
+/**
+ * Return the size of memory of @arena backed by huge pages.
+ * For transparent huge pages it is taken from /proc/self/smaps
+ * and so is rather expensive to get.
+ */
+size_t
+tuple_arena_hugepage_size(struct slab_arena *arena);
 
 void
 tuple_arena_destroy(struct slab_arena *arena);
@@ -296,7 +307,9 @@ box_tuple_upsert(const box_tuple_t *tuple, const char *expr, const
  * |                                            ^
  * +---------------------------------------data_offset
  *
- * Each 'off_i' is the offset to the i-th indexed field.
+ * Each 'off_i' is the offset to the i-th indexed field. Offsets
+ * take 16 bits instead of 32 if tuple_format::is_field_map_compact
+ * is set.
  */
 struct PACKED tuple
 {
@@ -534,6 +547,7 @@ tuple_field_raw_by_path(struct tuple_format *format, const char *tuple,
 			int32_t *offset_slot_hint)
 {
 	int32_t offset_slot;
+	uint32_t offset;
 	if (offset_slot_hint != NULL &&
 	    *offset_slot_hint != TUPLE_OFFSET_SLOT_NIL) {
 		offset_slot = *offset_slot_hint;
@@ -557,9 +571,12 @@ tuple_field_raw_by_path(struct tuple_format *format, const char *tuple,
 			*offset_slot_hint = offset_slot;
 offset_slot_access:
 		/* Indexed field */
-		if (field_map[offset_slot] == 0)
+		offset = tuple_field_map_get(format, field_map, offset_slot);
+		if (offset == 0)
 			return NULL;
-		tuple += field_map[offset_slot];
+		if (unlikely(offset == TUPLE_FIELD_MAP_OFFSET_UNKNOWN))
+			goto parse;
+		tuple += offset;
 	} else {
 		uint32_t field_count;
 parse:
@@ -670,6 +687,87 @@ tuple_field_by_part(const struct tuple *tuple, struct key_part *part)
 				       tuple_field_map(tuple), part);
 }
 
+/**
+ * Get an indexed array of a multikey key part, see
+ * key_part::multikey_path_len.
+ * @param format Tuple format.
+ * @param data A pointer to MessagePack array.
+ * @param field_map A pointer to the LAST element of field map.
+ * @param part Multikey index part to use.
+ * @retval Array data if the array exists or NULL.
+ */
+static inline const char *
+tuple_multikey_array_raw(struct tuple_format *format, const char *data,
+			 const uint32_t *field_map, struct key_part *part)
+{
+	assert(key_part_is_multikey(part));
+	if (unlikely(part->format_epoch != format->epoch)) {
+		assert(format->epoch != 0);
+		part->format_epoch = format->epoch;
+		part->offset_slot_cache = TUPLE_OFFSET_SLOT_NIL;
+	}
+	const char *path = part->multikey_path_len > 0 ? part->path : NULL;
+	const char *array =
+		tuple_field_raw_by_path(format, data, field_map, part->fieldno,
+					path, part->multikey_path_len,
+					&part->offset_slot_cache);
+	if (array == NULL || mp_typeof(*array) != MP_ARRAY)
+		return NULL;
+	return array;
+}
+
+/**
+ * Get a tuple field pointed to by a multikey index part.
+ * @param format Tuple format.
+ * @param data A pointer to MessagePack array.
+ * @param field_map A pointer to the LAST element of field map.
+ * @param part Multikey index part to use.
+ * @param multikey_idx Position of the indexed array element.
+ * @retval Field data if the field exists or NULL.
+ */
+static inline const char *
+tuple_field_raw_by_part_multikey(struct tuple_format *format, const char *data,
+				 const uint32_t *field_map,
+				 struct key_part *part, uint32_t multikey_idx)
+{
+	const char *field = tuple_multikey_array_raw(format, data,
+						     field_map, part);
+	if (field == NULL)
+		return NULL;
+	uint32_t size = mp_decode_array(&field);
+	if (multikey_idx >= size)
+		return NULL;
+	for (uint32_t i = 0; i < multikey_idx; i++)
+		mp_next(&field);
+	/* Follow the rest of the path after [*]. */
+	uint32_t offset = part->multikey_path_len + strlen("[*]");
+	if (offset < part->path_len &&
+	    tuple_go_to_path(&field, part->path + offset,
+			     part->path_len - offset) != 0)
+		return NULL;
+	return field;
+}
+
+/**
+ * Return the number of keys a tuple has in a multikey index,
+ * i.e. the size of the indexed array.
+ * @param tuple Tuple to count keys of.
+ * @param key_def Multikey key definition.
+ */
+static inline uint32_t
+tuple_multikey_count(const struct tuple *tuple, struct key_def *key_def)
+{
+	assert(key_def->is_multikey);
+	struct key_part *part = key_def->parts;
+	while (!key_part_is_multikey(part))
+		part++;
+	const char *array = tuple_multikey_array_raw(tuple_format(tuple),
+						     tuple_data(tuple),
+						     tuple_field_map(tuple),
+						     part);
+	return array != NULL ? mp_decode_array(&array) : 0;
+}
+
 /**
  * @brief Tuple Interator
  */
@@ -1006,6 +1104,24 @@ tuple_bless(struct tuple *tuple)
 	return tuple;
 }
 
+/**
+ * An engine may store fields that aren't indexed compressed.
+ * Such a tuple must be unpacked before its fields are read by
+ * anyone but the engine's indexes.
+ *
+ * Return the tuple itself if it isn't compressed, otherwise a
+ * new tuple with all fields in place, which is blessed, see
+ * tuple_bless(). Return NULL on memory error.
+ */
+static inline struct tuple *
+tuple_unpack(struct tuple *tuple)
+{
+	struct tuple_format *format = tuple_format(tuple);
+	if (likely(format->vtab.tuple_unpack == NULL))
+		return tuple;
+	return format->vtab.tuple_unpack(format, tuple);
+}
+
 /**
  * \copydoc box_tuple_to_buf()
  */
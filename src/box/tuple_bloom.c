@@ -125,6 +125,7 @@ tuple_bloom_new(struct tuple_bloom_builder *builder, double fpr)
 	}
 
 	bloom->is_legacy = false;
+	bloom->type = BLOOM_SPLIT_BLOCK;
 	bloom->part_count = 0;
 
 	for (uint32_t i = 0; i < part_count; i++) {
@@ -142,7 +143,8 @@ tuple_bloom_new(struct tuple_bloom_builder *builder, double fpr)
 		for (uint32_t j = 0; j < i; j++)
 			part_fpr /= bloom_fpr(&bloom->parts[j], count);
 		part_fpr = MIN(part_fpr, 0.5);
-		if (bloom_create(&bloom->parts[i], count, part_fpr) != 0) {
+		if (bloom_create_split_block(&bloom->parts[i], count,
+					     part_fpr) != 0) {
 			diag_set(OutOfMemory, 0, "bloom_create",
 				 "tuple bloom part");
 			tuple_bloom_delete(bloom);
@@ -240,11 +242,13 @@ tuple_bloom_encode_part(const struct bloom *part, char *buf)
 }
 
 static int
-tuple_bloom_decode_part(struct bloom *part, const char **data)
+tuple_bloom_decode_part(struct bloom *part, enum bloom_type type,
+			const char **data)
 {
 	memset(part, 0, sizeof(*part));
 	if (mp_decode_array(data) != 3)
 		unreachable();
+	part->type = type;
 	part->table_size = mp_decode_uint(data);
 	part->hash_count = mp_decode_uint(data);
 	size_t store_size = mp_decode_binl(data);
@@ -278,7 +282,7 @@ tuple_bloom_encode(const struct tuple_bloom *bloom, char *buf)
 }
 
 struct tuple_bloom *
-tuple_bloom_decode(const char **data)
+tuple_bloom_decode(const char **data, enum bloom_type type)
 {
 	uint32_t part_count = mp_decode_array(data);
 	struct tuple_bloom *bloom = malloc(sizeof(*bloom) +
@@ -291,10 +295,12 @@ tuple_bloom_decode(const char **data)
 	}
 
 	bloom->is_legacy = false;
+	bloom->type = type;
 	bloom->part_count = 0;
 
 	for (uint32_t i = 0; i < part_count; i++) {
-		if (tuple_bloom_decode_part(&bloom->parts[i], data) != 0) {
+		if (tuple_bloom_decode_part(&bloom->parts[i], type,
+					    data) != 0) {
 			tuple_bloom_delete(bloom);
 			return NULL;
 		}
@@ -315,6 +321,7 @@ tuple_bloom_decode_legacy(const char **data)
 	}
 
 	bloom->is_legacy = true;
+	bloom->type = BLOOM_BLOCKED;
 	bloom->part_count = 1;
 
 	if (mp_decode_array(data) != 4)
@@ -322,6 +329,7 @@ tuple_bloom_decode_legacy(const char **data)
 	if (mp_decode_uint(data) != 0) /* version */
 		unreachable();
 
+	bloom->parts[0].type = BLOOM_BLOCKED;
 	bloom->parts[0].table_size = mp_decode_uint(data);
 	bloom->parts[0].hash_count = mp_decode_uint(data);
 
@@ -58,6 +58,12 @@ struct tuple_bloom {
 	 * (see tuple_bloom_decode_legacy).
 	 */
 	bool is_legacy;
+	/**
+	 * Layout of bloom filters of all parts. New filters
+	 * are always created with BLOOM_SPLIT_BLOCK, filters
+	 * of the other type may only be loaded from old runs.
+	 */
+	enum bloom_type type;
 	/** Number of key parts. */
 	uint32_t part_count;
 	/** Array of bloom filters, one per each partial key. */
@@ -183,10 +189,12 @@ tuple_bloom_encode(const struct tuple_bloom *bloom, char *buf);
  * Decode a tuple bloom filter from MsgPack.
  * @param data - pointer to buffer storing encoded bloom filter;
  *  on success it is advanced by the number of decoded bytes
+ * @param type - layout of the encoded filters, it isn't stored
+ *  in the encoding and must be passed by the caller
  * @return the decoded bloom on success or NULL on OOM
  */
 struct tuple_bloom *
-tuple_bloom_decode(const char **data);
+tuple_bloom_decode(const char **data, enum bloom_type type);
 
 /**
  * Decode a legacy bloom filter from MsgPack.
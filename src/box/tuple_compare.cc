@@ -458,12 +458,36 @@ tuple_common_key_parts(const struct tuple *tuple_a, const struct tuple *tuple_b,
 	return i;
 }
 
-template<bool is_nullable, bool has_optional_parts, bool has_json_paths>
+/**
+ * Get a tuple field indexed by a key part. For a multikey key
+ * part @a multikey_idx is the position of the indexed element
+ * in the array.
+ */
+template<bool has_json_paths, bool is_multikey>
+static inline const char *
+tuple_field_raw_by_key_part(struct tuple_format *format, const char *data,
+			    const uint32_t *field_map, struct key_part *part,
+			    hint_t multikey_idx)
+{
+	if (is_multikey && key_part_is_multikey(part)) {
+		return tuple_field_raw_by_part_multikey(format, data,
+							field_map, part,
+							(uint32_t)multikey_idx);
+	}
+	if (has_json_paths)
+		return tuple_field_raw_by_part(format, data, field_map, part);
+	return tuple_field_raw(format, data, field_map, part->fieldno);
+}
+
+template<bool is_nullable, bool has_optional_parts, bool has_json_paths,
+	 bool is_multikey>
 static inline int
-tuple_compare_slowpath(const struct tuple *tuple_a, const struct tuple *tuple_b,
+tuple_compare_slowpath(const struct tuple *tuple_a, hint_t tuple_a_hint,
+		       const struct tuple *tuple_b, hint_t tuple_b_hint,
 		       struct key_def *key_def)
 {
 	assert(has_json_paths == key_def->has_json_paths);
+	assert(!is_multikey || key_def->is_multikey);
 	assert(!has_optional_parts || is_nullable);
 	assert(is_nullable == key_def->is_nullable);
 	assert(has_optional_parts == key_def->has_optional_parts);
@@ -509,17 +533,14 @@ tuple_compare_slowpath(const struct tuple *tuple_a, const struct tuple *tuple_b,
 		end = part + key_def->part_count;
 
 	for (; part < end; part++) {
-		if (has_json_paths) {
-			field_a = tuple_field_raw_by_part(format_a, tuple_a_raw,
-							  field_map_a, part);
-			field_b = tuple_field_raw_by_part(format_b, tuple_b_raw,
-							  field_map_b, part);
-		} else {
-			field_a = tuple_field_raw(format_a, tuple_a_raw,
-						  field_map_a, part->fieldno);
-			field_b = tuple_field_raw(format_b, tuple_b_raw,
-						  field_map_b, part->fieldno);
-		}
+		field_a = tuple_field_raw_by_key_part<has_json_paths,
+						      is_multikey>(
+				format_a, tuple_a_raw, field_map_a, part,
+				tuple_a_hint);
+		field_b = tuple_field_raw_by_key_part<has_json_paths,
+						      is_multikey>(
+				format_b, tuple_b_raw, field_map_b, part,
+				tuple_b_hint);
 		assert(has_optional_parts ||
 		       (field_a != NULL && field_b != NULL));
 		if (! is_nullable) {
@@ -566,17 +587,14 @@ tuple_compare_slowpath(const struct tuple *tuple_a, const struct tuple *tuple_b,
 	 */
 	end = key_def->parts + key_def->part_count;
 	for (; part < end; ++part) {
-		if (has_json_paths) {
-			field_a = tuple_field_raw_by_part(format_a, tuple_a_raw,
-							  field_map_a, part);
-			field_b = tuple_field_raw_by_part(format_b, tuple_b_raw,
-							  field_map_b, part);
-		} else {
-			field_a = tuple_field_raw(format_a, tuple_a_raw,
-						  field_map_a, part->fieldno);
-			field_b = tuple_field_raw(format_b, tuple_b_raw,
-						  field_map_b, part->fieldno);
-		}
+		field_a = tuple_field_raw_by_key_part<has_json_paths,
+						      is_multikey>(
+				format_a, tuple_a_raw, field_map_a, part,
+				tuple_a_hint);
+		field_b = tuple_field_raw_by_key_part<has_json_paths,
+						      is_multikey>(
+				format_b, tuple_b_raw, field_map_b, part,
+				tuple_b_hint);
 		/*
 		 * Extended parts are primary, and they can not
 		 * be absent or be NULLs.
@@ -592,10 +610,24 @@ tuple_compare_slowpath(const struct tuple *tuple_a, const struct tuple *tuple_b,
 
 template<bool is_nullable, bool has_optional_parts, bool has_json_paths>
 static inline int
-tuple_compare_with_key_slowpath(const struct tuple *tuple, const char *key,
-				uint32_t part_count, struct key_def *key_def)
+tuple_compare_slowpath(const struct tuple *tuple_a, const struct tuple *tuple_b,
+		       struct key_def *key_def)
 {
+	return tuple_compare_slowpath<is_nullable, has_optional_parts,
+				      has_json_paths, false>(
+			tuple_a, HINT_NONE, tuple_b, HINT_NONE, key_def);
+}
+
+template<bool is_nullable, bool has_optional_parts, bool has_json_paths,
+	 bool is_multikey>
+static inline int
+tuple_compare_with_key_slowpath(const struct tuple *tuple, hint_t tuple_h,
+				const char *key, uint32_t part_count,
+				hint_t key_h, struct key_def *key_def)
+{
+	(void)key_h;
 	assert(has_json_paths == key_def->has_json_paths);
+	assert(!is_multikey || key_def->is_multikey);
 	assert(!has_optional_parts || is_nullable);
 	assert(is_nullable == key_def->is_nullable);
 	assert(has_optional_parts == key_def->has_optional_parts);
@@ -608,13 +640,10 @@ tuple_compare_with_key_slowpath(const struct tuple *tuple, const char *key,
 	enum mp_type a_type, b_type;
 	if (likely(part_count == 1)) {
 		const char *field;
-		if (has_json_paths) {
-			field = tuple_field_raw_by_part(format, tuple_raw,
-							field_map, part);
-		} else {
-			field = tuple_field_raw(format, tuple_raw, field_map,
-						part->fieldno);
-		}
+		field = tuple_field_raw_by_key_part<has_json_paths,
+						    is_multikey>(
+				format, tuple_raw, field_map, part,
+				tuple_h);
 		if (! is_nullable) {
 			return tuple_compare_field(field, key, part->type,
 						   part->coll);
@@ -639,13 +668,10 @@ tuple_compare_with_key_slowpath(const struct tuple *tuple, const char *key,
 	int rc;
 	for (; part < end; ++part, mp_next(&key)) {
 		const char *field;
-		if (has_json_paths) {
-			field = tuple_field_raw_by_part(format, tuple_raw,
-							field_map, part);
-		} else {
-			field = tuple_field_raw(format, tuple_raw, field_map,
-						part->fieldno);
-		}
+		field = tuple_field_raw_by_key_part<has_json_paths,
+						    is_multikey>(
+				format, tuple_raw, field_map, part,
+				tuple_h);
 		if (! is_nullable) {
 			rc = tuple_compare_field(field, key, part->type,
 						 part->coll);
@@ -675,6 +701,16 @@ tuple_compare_with_key_slowpath(const struct tuple *tuple, const char *key,
 	return 0;
 }
 
+template<bool is_nullable, bool has_optional_parts, bool has_json_paths>
+static inline int
+tuple_compare_with_key_slowpath(const struct tuple *tuple, const char *key,
+				uint32_t part_count, struct key_def *key_def)
+{
+	return tuple_compare_with_key_slowpath<is_nullable, has_optional_parts,
+					       has_json_paths, false>(
+			tuple, HINT_NONE, key, part_count, HINT_NONE, key_def);
+}
+
 template<bool is_nullable>
 static inline int
 key_compare_parts(const char *key_a, const char *key_b, uint32_t part_count,
@@ -883,6 +919,14 @@ field_compare<FIELD_TYPE_STRING>(const char **field_a, const char **field_b)
 	return r;
 }
 
+template <>
+inline int
+field_compare<FIELD_TYPE_INTEGER>(const char **field_a, const char **field_b)
+{
+	return mp_compare_integer_with_hint(*field_a, mp_typeof(**field_a),
+					    *field_b, mp_typeof(**field_b));
+}
+
 template <int TYPE>
 static inline int
 field_compare_and_next(const char **field_a, const char **field_b);
@@ -1007,6 +1051,113 @@ struct TupleCompare<0, TYPE, MORE_TYPES...> {
 					format_a, format_b, field_a, field_b);
 	}
 };
+/**
+ * Comparator specialized by part types only: field numbers
+ * are taken from the key definition at run time, so it fits
+ * any layout of a key whose types match TYPES.
+ */
+template <int ...TYPES> struct TypedFieldCompare { };
+
+template <int TYPE, int ...MORE_TYPES>
+struct TypedFieldCompare<TYPE, MORE_TYPES...>
+{
+	inline static int compare(struct tuple_format *format_a,
+				  const char *data_a,
+				  const uint32_t *field_map_a,
+				  struct tuple_format *format_b,
+				  const char *data_b,
+				  const uint32_t *field_map_b,
+				  const struct key_part *part)
+	{
+		const char *field_a = tuple_field_raw(format_a, data_a,
+						      field_map_a,
+						      part->fieldno);
+		const char *field_b = tuple_field_raw(format_b, data_b,
+						      field_map_b,
+						      part->fieldno);
+		int r = field_compare<TYPE>(&field_a, &field_b);
+		if (r != 0)
+			return r;
+		return TypedFieldCompare<MORE_TYPES...>::
+			compare(format_a, data_a, field_map_a,
+				format_b, data_b, field_map_b, part + 1);
+	}
+};
+
+template <>
+struct TypedFieldCompare<>
+{
+	inline static int compare(struct tuple_format *, const char *,
+				  const uint32_t *, struct tuple_format *,
+				  const char *, const uint32_t *,
+				  const struct key_part *)
+	{
+		return 0;
+	}
+};
+
+template <int ...TYPES>
+struct TypedTupleCompare
+{
+	static int compare(const struct tuple *tuple_a,
+			   const struct tuple *tuple_b,
+			   struct key_def *key_def)
+	{
+		assert(key_def->part_count == sizeof...(TYPES));
+		return TypedFieldCompare<TYPES...>::
+			compare(tuple_format(tuple_a), tuple_data(tuple_a),
+				tuple_field_map(tuple_a),
+				tuple_format(tuple_b), tuple_data(tuple_b),
+				tuple_field_map(tuple_b), key_def->parts);
+	}
+};
+
+/**
+ * Max number of parts of a key for which a comparator
+ * specialized by part types is instantiated. The number of
+ * instantiations grows as 3^N, so do not set it high.
+ */
+enum { TYPED_COMPARATOR_PART_COUNT_MAX = 4 };
+
+/**
+ * Pick an instantiation of CMP matching the types of key parts
+ * starting from the given one. DEPTH limits the recursion.
+ * Returns NULL if the key has a part of an unsupported type
+ * or too many parts.
+ */
+template <template <int ...> class CMP, typename F, int DEPTH,
+	  int ...TYPES>
+struct TypedComparatorSelector
+{
+	static F select(const struct key_def *def, uint32_t i)
+	{
+		if (i == def->part_count)
+			return CMP<TYPES...>::compare;
+		switch (def->parts[i].type) {
+		case FIELD_TYPE_UNSIGNED:
+			return TypedComparatorSelector<CMP, F, DEPTH - 1,
+				TYPES..., FIELD_TYPE_UNSIGNED>::select(def, i + 1);
+		case FIELD_TYPE_STRING:
+			return TypedComparatorSelector<CMP, F, DEPTH - 1,
+				TYPES..., FIELD_TYPE_STRING>::select(def, i + 1);
+		case FIELD_TYPE_INTEGER:
+			return TypedComparatorSelector<CMP, F, DEPTH - 1,
+				TYPES..., FIELD_TYPE_INTEGER>::select(def, i + 1);
+		default:
+			return NULL;
+		}
+	}
+};
+
+template <template <int ...> class CMP, typename F, int ...TYPES>
+struct TypedComparatorSelector<CMP, F, 0, TYPES...>
+{
+	static F select(const struct key_def *def, uint32_t i)
+	{
+		return i == def->part_count ? CMP<TYPES...>::compare : NULL;
+	}
+};
+
 } /* end of anonymous namespace */
 
 struct comparator_signature {
@@ -1081,6 +1232,11 @@ tuple_compare_create(const struct key_def *def)
 			    cmp_arr[k].p[i * 2] == UINT32_MAX)
 				return cmp_arr[k].f;
 		}
+		tuple_compare_t cmp = TypedComparatorSelector<
+			TypedTupleCompare, tuple_compare_t,
+			TYPED_COMPARATOR_PART_COUNT_MAX>::select(def, 0);
+		if (cmp != NULL)
+			return cmp;
 	}
 	return key_def_is_sequential(def) ?
 	       tuple_compare_sequential<false, false> :
@@ -1114,6 +1270,14 @@ field_compare_with_key<FIELD_TYPE_STRING>(const char **field, const char **key)
 	return r;
 }
 
+template <>
+inline int
+field_compare_with_key<FIELD_TYPE_INTEGER>(const char **field, const char **key)
+{
+	return mp_compare_integer_with_hint(*field, mp_typeof(**field),
+					    *key, mp_typeof(**key));
+}
+
 template <int TYPE>
 static inline int
 field_compare_with_key_and_next(const char **field_a, const char **field_b);
@@ -1237,6 +1401,63 @@ struct TupleCompareWithKey<0, 0, TYPE, MORE_TYPES...>
 	}
 };
 
+/**
+ * Tuple with key comparator specialized by part types only,
+ * see TypedFieldCompare.
+ */
+template <int ...TYPES> struct TypedFieldCompareWithKey { };
+
+template <int TYPE, int ...MORE_TYPES>
+struct TypedFieldCompareWithKey<TYPE, MORE_TYPES...>
+{
+	inline static int compare(struct tuple_format *format,
+				  const char *data,
+				  const uint32_t *field_map,
+				  const char *key, uint32_t part_count,
+				  const struct key_part *part)
+	{
+		const char *field = tuple_field_raw(format, data, field_map,
+						    part->fieldno);
+		const char *key_field = key;
+		int r = field_compare_with_key<TYPE>(&field, &key_field);
+		if (r != 0 || part_count == 1)
+			return r;
+		mp_next(&key);
+		return TypedFieldCompareWithKey<MORE_TYPES...>::
+			compare(format, data, field_map, key,
+				part_count - 1, part + 1);
+	}
+};
+
+template <>
+struct TypedFieldCompareWithKey<>
+{
+	inline static int compare(struct tuple_format *, const char *,
+				  const uint32_t *, const char *, uint32_t,
+				  const struct key_part *)
+	{
+		return 0;
+	}
+};
+
+template <int ...TYPES>
+struct TypedTupleCompareWithKey
+{
+	static int compare(const struct tuple *tuple, const char *key,
+			   uint32_t part_count, struct key_def *key_def)
+	{
+		assert(key_def->part_count == sizeof...(TYPES));
+		assert(part_count <= key_def->part_count);
+		/* Part count can be 0 in wildcard searches. */
+		if (part_count == 0)
+			return 0;
+		return TypedFieldCompareWithKey<TYPES...>::
+			compare(tuple_format(tuple), tuple_data(tuple),
+				tuple_field_map(tuple), key, part_count,
+				key_def->parts);
+	}
+};
+
 } /* end of anonymous namespace */
 
 struct comparator_with_key_signature
@@ -1315,6 +1536,11 @@ tuple_compare_with_key_create(const struct key_def *def)
 			if (i == def->part_count)
 				return cmp_wk_arr[k].f;
 		}
+		tuple_compare_with_key_t cmp = TypedComparatorSelector<
+			TypedTupleCompareWithKey, tuple_compare_with_key_t,
+			TYPED_COMPARATOR_PART_COUNT_MAX>::select(def, 0);
+		if (cmp != NULL)
+			return cmp;
 	}
 	return key_def_is_sequential(def) ?
 	       tuple_compare_with_key_sequential<false, false> :
@@ -1322,3 +1548,440 @@ tuple_compare_with_key_create(const struct key_def *def)
 }
 
 /* }}} tuple_compare_with_key */
+
+/* {{{ tuple_compare_custom */
+
+static const tuple_compare_hinted_t compare_multikey_funcs[] = {
+	tuple_compare_slowpath<false, false, true, true>,
+	tuple_compare_slowpath<true, false, true, true>,
+	tuple_compare_slowpath<false, true, true, true>,
+	tuple_compare_slowpath<true, true, true, true>
+};
+
+static const tuple_compare_with_key_hinted_t compare_with_key_multikey_funcs[] = {
+	tuple_compare_with_key_slowpath<false, false, true, true>,
+	tuple_compare_with_key_slowpath<true, false, true, true>,
+	tuple_compare_with_key_slowpath<false, true, true, true>,
+	tuple_compare_with_key_slowpath<true, true, true, true>
+};
+
+/**
+ * Compare tuples of an index storing keys, e.g. a functional
+ * one. The stored keys are compared first, then the tuples are
+ * compared by the rest of the parts, i.e. by primary key parts.
+ */
+template<bool is_nullable>
+static int
+stored_key_compare(const struct tuple *tuple_a, hint_t tuple_a_hint,
+		   const struct tuple *tuple_b, hint_t tuple_b_hint,
+		   struct key_def *key_def)
+{
+	assert(key_def->stored_part_count > 0);
+	assert(is_nullable == key_def->is_nullable);
+	uint32_t stored_part_count = key_def->stored_part_count;
+	const char *key_a = tuple_data((struct tuple *)(uintptr_t)tuple_a_hint);
+	const char *key_b = tuple_data((struct tuple *)(uintptr_t)tuple_b_hint);
+	mp_decode_array(&key_a);
+	mp_decode_array(&key_b);
+	int rc = key_compare_parts<is_nullable>(key_a, key_b,
+						stored_part_count, key_def);
+	if (rc != 0 || key_def->part_count == stored_part_count)
+		return rc;
+	if (key_def->unique_part_count <= stored_part_count) {
+		/*
+		 * Keys of a unique index are equal unless they
+		 * contain NULLs, see tuple_compare_slowpath().
+		 */
+		if (!is_nullable)
+			return 0;
+		uint32_t i = 0;
+		for (; i < stored_part_count; i++, mp_next(&key_a)) {
+			if (mp_typeof(*key_a) == MP_NIL)
+				break;
+		}
+		if (i == stored_part_count)
+			return 0;
+	}
+	struct key_part *part = key_def->parts + stored_part_count;
+	struct key_part *end = key_def->parts + key_def->part_count;
+	for (; part < end; part++) {
+		const char *field_a = tuple_field_by_part(tuple_a, part);
+		const char *field_b = tuple_field_by_part(tuple_b, part);
+		/* Primary key parts can't be absent. */
+		assert(field_a != NULL && field_b != NULL);
+		rc = tuple_compare_field(field_a, field_b, part->type,
+					 part->coll);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
+/**
+ * Compare the stored key of a tuple with a key. Only stored
+ * parts can be looked up.
+ */
+template<bool is_nullable>
+static int
+stored_key_compare_with_key(const struct tuple *tuple, hint_t tuple_hint,
+			    const char *key, uint32_t part_count,
+			    hint_t key_hint, struct key_def *key_def)
+{
+	(void)tuple;
+	(void)key_hint;
+	assert(part_count <= key_def->stored_part_count);
+	assert(is_nullable == key_def->is_nullable);
+	const char *stored_key =
+		tuple_data((struct tuple *)(uintptr_t)tuple_hint);
+	mp_decode_array(&stored_key);
+	return key_compare_parts<is_nullable>(stored_key, key, part_count,
+					      key_def);
+}
+
+void
+key_def_set_custom_compare_func(struct key_def *def)
+{
+	def->tuple_compare_custom = NULL;
+	def->tuple_compare_with_key_custom = NULL;
+	if (def->stored_part_count > 0) {
+		if (def->is_nullable) {
+			def->tuple_compare_custom = stored_key_compare<true>;
+			def->tuple_compare_with_key_custom =
+				stored_key_compare_with_key<true>;
+		} else {
+			def->tuple_compare_custom = stored_key_compare<false>;
+			def->tuple_compare_with_key_custom =
+				stored_key_compare_with_key<false>;
+		}
+		return;
+	}
+	if (!def->is_multikey)
+		return;
+	assert(def->has_json_paths);
+	int cmp_func_idx = (def->is_nullable ? 1 : 0) +
+			   2 * (def->has_optional_parts ? 1 : 0);
+	def->tuple_compare_custom = compare_multikey_funcs[cmp_func_idx];
+	def->tuple_compare_with_key_custom =
+		compare_with_key_multikey_funcs[cmp_func_idx];
+}
+
+/* }}} tuple_compare_custom */
+
+/* {{{ tuple_hint */
+
+/**
+ * A comparison hint is an unsigned integer number that has
+ * the following layout:
+ *
+ *     [         class         |         value         ]
+ *      <-- HINT_CLASS_BITS --> <-- HINT_VALUE_BITS -->
+ *      <----------------- HINT_BITS ----------------->
+ *
+ * Only the first key part is used to construct a hint, so hints
+ * are useless if the first key part doesn't differ among indexed
+ * tuples.
+ *
+ * Hint class stores one of mp_class enum values corresponding to
+ * the type of the first key field. Since MsgPack values of
+ * different classes are ordered by class, so are hints.
+ *
+ * Hint value is a lossy, order preserving projection of the
+ * field value onto HINT_VALUE_BITS bits: a number is shifted
+ * right, a string or a binary blob is truncated to its first
+ * bytes, a string compared by a collation is replaced with a
+ * prefix of its sort key. The projection of a value depends only
+ * on the value itself and the collation, not on the field type,
+ * so hints stay valid if the field type is changed to a
+ * compatible one without rebuilding the index.
+ */
+#define HINT_BITS (sizeof(hint_t) * CHAR_BIT)
+#define HINT_CLASS_BITS 4
+#define HINT_VALUE_BITS (HINT_BITS - HINT_CLASS_BITS)
+#define HINT_VALUE_MAX (((hint_t)1 << HINT_VALUE_BITS) - 1)
+#define HINT(class, value) (((hint_t)(class) << HINT_VALUE_BITS) | (value))
+
+/** Number of string bytes that fit in a hint value. */
+enum { HINT_STR_BYTES = HINT_VALUE_BITS / CHAR_BIT };
+
+static_assert(MP_CLASS_MAP < (1 << HINT_CLASS_BITS),
+	      "mp_class must fit in tuple hint");
+
+static inline hint_t
+hint_nil(void)
+{
+	return HINT(MP_CLASS_NIL, 0);
+}
+
+static inline hint_t
+hint_bool(bool b)
+{
+	return HINT(MP_CLASS_BOOL, b ? 1 : 0);
+}
+
+/*
+ * Integers are mapped onto [0, 2^64) by adding 2^63 so that
+ * a negative MP_INT compares less than any MP_UINT, and
+ * MP_UINT values that don't fit in int64_t are saturated.
+ */
+static inline hint_t
+hint_int(int64_t i)
+{
+	uint64_t val = (uint64_t)i - (uint64_t)INT64_MIN;
+	return HINT(MP_CLASS_NUMBER, val >> HINT_CLASS_BITS);
+}
+
+static inline hint_t
+hint_uint(uint64_t u)
+{
+	if (u > (uint64_t)INT64_MAX)
+		return HINT(MP_CLASS_NUMBER, HINT_VALUE_MAX);
+	return hint_int((int64_t)u);
+}
+
+/*
+ * A double is truncated to an integer, which is a monotonic
+ * transformation. NaN is less than any number.
+ */
+static inline hint_t
+hint_double(double d)
+{
+	if (isnan(d) || d <= (double)INT64_MIN)
+		return HINT(MP_CLASS_NUMBER, 0);
+	if (d >= (double)INT64_MAX)
+		return HINT(MP_CLASS_NUMBER, HINT_VALUE_MAX);
+	return hint_int((int64_t)d);
+}
+
+static inline uint64_t
+hint_str_value(const char *s, uint32_t len)
+{
+	uint64_t val = 0;
+	for (uint32_t i = 0; i < HINT_STR_BYTES; i++) {
+		val <<= CHAR_BIT;
+		if (i < len)
+			val |= (unsigned char)s[i];
+	}
+	return val << (HINT_VALUE_BITS - HINT_STR_BYTES * CHAR_BIT);
+}
+
+static inline hint_t
+hint_str(const char *s, uint32_t len)
+{
+	return HINT(MP_CLASS_STR, hint_str_value(s, len));
+}
+
+static inline hint_t
+hint_str_coll(const char *s, uint32_t len, struct coll *coll)
+{
+	char buf[HINT_STR_BYTES];
+	uint32_t buf_len = coll->hint(s, len, buf, sizeof(buf), coll);
+	return HINT(MP_CLASS_STR, hint_str_value(buf, buf_len));
+}
+
+static inline hint_t
+hint_bin(const char *s, uint32_t len)
+{
+	return HINT(MP_CLASS_BIN, hint_str_value(s, len));
+}
+
+static inline hint_t
+field_hint_boolean(const char *field)
+{
+	assert(mp_typeof(*field) == MP_BOOL);
+	return hint_bool(mp_decode_bool(&field));
+}
+
+static inline hint_t
+field_hint_unsigned(const char *field)
+{
+	assert(mp_typeof(*field) == MP_UINT);
+	return hint_uint(mp_decode_uint(&field));
+}
+
+static inline hint_t
+field_hint_integer(const char *field)
+{
+	switch (mp_typeof(*field)) {
+	case MP_UINT:
+		return hint_uint(mp_decode_uint(&field));
+	case MP_INT:
+		return hint_int(mp_decode_int(&field));
+	default:
+		unreachable();
+	}
+	return HINT_NONE;
+}
+
+static inline hint_t
+field_hint_number(const char *field)
+{
+	switch (mp_typeof(*field)) {
+	case MP_UINT:
+		return hint_uint(mp_decode_uint(&field));
+	case MP_INT:
+		return hint_int(mp_decode_int(&field));
+	case MP_FLOAT:
+		return hint_double(mp_decode_float(&field));
+	case MP_DOUBLE:
+		return hint_double(mp_decode_double(&field));
+	default:
+		unreachable();
+	}
+	return HINT_NONE;
+}
+
+static inline hint_t
+field_hint_string(const char *field, struct coll *coll)
+{
+	assert(mp_typeof(*field) == MP_STR);
+	uint32_t len;
+	const char *s = mp_decode_str(&field, &len);
+	return coll != NULL ? hint_str_coll(s, len, coll) : hint_str(s, len);
+}
+
+static inline hint_t
+field_hint_scalar(const char *field, struct coll *coll)
+{
+	uint32_t len;
+	const char *s;
+	switch (mp_typeof(*field)) {
+	case MP_NIL:
+		return hint_nil();
+	case MP_BOOL:
+		return field_hint_boolean(field);
+	case MP_UINT:
+	case MP_INT:
+	case MP_FLOAT:
+	case MP_DOUBLE:
+		return field_hint_number(field);
+	case MP_STR:
+		return field_hint_string(field, coll);
+	case MP_BIN:
+		s = mp_decode_bin(&field, &len);
+		return hint_bin(s, len);
+	default:
+		unreachable();
+	}
+	return HINT_NONE;
+}
+
+template <enum field_type type, bool is_nullable>
+static inline hint_t
+field_hint(const char *field, struct coll *coll)
+{
+	if (is_nullable && mp_typeof(*field) == MP_NIL)
+		return hint_nil();
+	switch (type) {
+	case FIELD_TYPE_BOOLEAN:
+		return field_hint_boolean(field);
+	case FIELD_TYPE_UNSIGNED:
+		return field_hint_unsigned(field);
+	case FIELD_TYPE_INTEGER:
+		return field_hint_integer(field);
+	case FIELD_TYPE_NUMBER:
+		return field_hint_number(field);
+	case FIELD_TYPE_STRING:
+		return field_hint_string(field, coll);
+	case FIELD_TYPE_SCALAR:
+		return field_hint_scalar(field, coll);
+	default:
+		unreachable();
+	}
+	return HINT_NONE;
+}
+
+template <enum field_type type, bool is_nullable>
+static hint_t
+key_hint(const char *key, uint32_t part_count, struct key_def *key_def)
+{
+	if (part_count == 0)
+		return HINT_NONE;
+	/*
+	 * A search key may contain NULL for a non-nullable
+	 * part too, so check it unconditionally.
+	 */
+	if (mp_typeof(*key) == MP_NIL)
+		return hint_nil();
+	return field_hint<type, false>(key, key_def->parts->coll);
+}
+
+template <enum field_type type, bool is_nullable>
+static hint_t
+tuple_hint(const struct tuple *tuple, struct key_def *key_def)
+{
+	const char *field = tuple_field_by_part(tuple, key_def->parts);
+	if (is_nullable && field == NULL)
+		return hint_nil();
+	assert(field != NULL);
+	return field_hint<type, is_nullable>(field, key_def->parts->coll);
+}
+
+static hint_t
+key_hint_none(const char *key, uint32_t part_count, struct key_def *key_def)
+{
+	(void)key;
+	(void)part_count;
+	(void)key_def;
+	return HINT_NONE;
+}
+
+static hint_t
+tuple_hint_none(const struct tuple *tuple, struct key_def *key_def)
+{
+	(void)tuple;
+	(void)key_def;
+	return HINT_NONE;
+}
+
+template <enum field_type type>
+static void
+key_def_set_hint_func_for_type(struct key_def *def)
+{
+	if (key_part_is_nullable(def->parts)) {
+		def->key_hint = key_hint<type, true>;
+		def->tuple_hint = tuple_hint<type, true>;
+	} else {
+		def->key_hint = key_hint<type, false>;
+		def->tuple_hint = tuple_hint<type, false>;
+	}
+}
+
+void
+key_def_set_hint_func(struct key_def *def)
+{
+	def->key_hint = key_hint_none;
+	def->tuple_hint = tuple_hint_none;
+	/*
+	 * Multikey indexes and indexes storing keys use hints
+	 * to store positions of indexed array elements and the
+	 * keys respectively.
+	 */
+	if (def->part_count == 0 || def->is_multikey ||
+	    def->stored_part_count > 0)
+		return;
+	switch (def->parts->type) {
+	case FIELD_TYPE_UNSIGNED:
+		key_def_set_hint_func_for_type<FIELD_TYPE_UNSIGNED>(def);
+		break;
+	case FIELD_TYPE_INTEGER:
+		key_def_set_hint_func_for_type<FIELD_TYPE_INTEGER>(def);
+		break;
+	case FIELD_TYPE_NUMBER:
+		key_def_set_hint_func_for_type<FIELD_TYPE_NUMBER>(def);
+		break;
+	case FIELD_TYPE_BOOLEAN:
+		key_def_set_hint_func_for_type<FIELD_TYPE_BOOLEAN>(def);
+		break;
+	case FIELD_TYPE_STRING:
+		key_def_set_hint_func_for_type<FIELD_TYPE_STRING>(def);
+		break;
+	case FIELD_TYPE_SCALAR:
+		key_def_set_hint_func_for_type<FIELD_TYPE_SCALAR>(def);
+		break;
+	default:
+		/* Hints are not supported for the field type. */
+		break;
+	}
+}
+
+/* }}} tuple_hint */
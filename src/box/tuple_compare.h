@@ -67,6 +67,23 @@ tuple_compare_create(const struct key_def *key_def);
 tuple_compare_with_key_t
 tuple_compare_with_key_create(const struct key_def *key_def);
 
+/**
+ * Initialize tuple_hint() and key_hint() functions for the
+ * key_def.
+ * @param key_def key definition to set up.
+ */
+void
+key_def_set_hint_func(struct key_def *def);
+
+/**
+ * Initialize comparators of a multikey or a functional key
+ * definition, see key_def::tuple_compare_custom. Set them to
+ * NULL for other key definitions.
+ * @param key_def key definition to set up.
+ */
+void
+key_def_set_custom_compare_func(struct key_def *def);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
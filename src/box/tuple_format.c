@@ -80,6 +80,12 @@ tuple_format_cmp(const struct tuple_format *format1,
 		return a->exact_field_count - b->exact_field_count;
 	if (a->total_field_count != b->total_field_count)
 		return a->total_field_count - b->total_field_count;
+	if (a->is_field_map_compact != b->is_field_map_compact)
+		return (int)a->is_field_map_compact -
+			(int)b->is_field_map_compact;
+	if ((a->fixed_offsets != NULL) != (b->fixed_offsets != NULL))
+		return (int)(a->fixed_offsets != NULL) -
+			(int)(b->fixed_offsets != NULL);
 
 	struct tuple_field *field_a;
 	json_tree_foreach_entry_preorder(field_a, &a->fields.root,
@@ -176,6 +182,21 @@ tuple_field_path(const struct tuple_field *field)
 	return path;
 }
 
+/**
+ * Return true if a field is an element of an array indexed by
+ * a multikey index or a part of such an element.
+ */
+static bool
+tuple_field_is_multikey_member(const struct tuple_field *field)
+{
+	for (const struct json_token *token = &field->token;
+	     token->type != JSON_TOKEN_END; token = token->parent) {
+		if (token->type == JSON_TOKEN_ANY)
+			return true;
+	}
+	return false;
+}
+
 /**
  * Look up field metadata by identifier.
  *
@@ -245,6 +266,17 @@ tuple_format_add_field(struct tuple_format *format, uint32_t fieldno,
 				 field_type_strs[expected_type]);
 			goto fail;
 		}
+		/*
+		 * An array can't be indexed by element numbers
+		 * and by [*] at the same time.
+		 */
+		bool is_multikey = field->token.type == JSON_TOKEN_ANY;
+		if (!json_token_is_leaf(&parent->token) &&
+		    is_multikey != json_token_is_multikey(&parent->token)) {
+			diag_set(ClientError, ER_MULTIKEY_INDEX_MISMATCH,
+				 tuple_field_path(parent));
+			goto fail;
+		}
 		struct tuple_field *next =
 			json_tree_lookup_entry(tree, &parent->token,
 					       &field->token,
@@ -345,6 +377,20 @@ tuple_format_use_key_part(struct tuple_format *format, uint32_t field_count,
 		return -1;
 	}
 	field->is_key_part = true;
+	bool has_path = part->path != NULL;
+	if (key_part_is_multikey(part)) {
+		/*
+		 * Elements of an array indexed by a multikey
+		 * index are looked up by position, so store
+		 * an offset of the array itself.
+		 */
+		struct json_token *token = &field->token;
+		while (token->type != JSON_TOKEN_ANY)
+			token = token->parent;
+		field = json_tree_entry(token->parent, struct tuple_field,
+					token);
+		has_path = part->multikey_path_len > 0;
+	}
 	/*
 	 * In the tuple, store only offsets necessary to access
 	 * fields of non-sequential keys. First field is always
@@ -352,7 +398,7 @@ tuple_format_use_key_part(struct tuple_format *format, uint32_t field_count,
 	 */
 	if (field->offset_slot == TUPLE_OFFSET_SLOT_NIL &&
 	    is_sequential == false &&
-	    (part->fieldno > 0 || part->path != NULL)) {
+	    (part->fieldno > 0 || has_path)) {
 		*current_slot = *current_slot - 1;
 		field->offset_slot = *current_slot;
 	}
@@ -406,8 +452,11 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 	for (uint16_t key_no = 0; key_no < key_count; ++key_no) {
 		const struct key_def *key_def = keys[key_no];
 		bool is_sequential = key_def_is_sequential(key_def);
-		const struct key_part *part = key_def->parts;
-		const struct key_part *parts_end = part + key_def->part_count;
+		/* Parts of a functional key don't index the tuple. */
+		const struct key_part *part =
+			key_def->parts + key_def->func_part_count;
+		const struct key_part *parts_end =
+			key_def->parts + key_def->part_count;
 
 		for (; part < parts_end; part++) {
 			if (tuple_format_use_key_part(format, field_count, part,
@@ -420,7 +469,9 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 
 	assert(tuple_format_field(format, 0)->offset_slot ==
 	       TUPLE_OFFSET_SLOT_NIL);
-	size_t field_map_size = -current_slot * sizeof(uint32_t);
+	size_t slot_size = format->is_field_map_compact ?
+			   sizeof(uint16_t) : sizeof(uint32_t);
+	size_t field_map_size = -current_slot * slot_size;
 	if (field_map_size > UINT16_MAX) {
 		/** tuple->data_offset is 16 bits */
 		diag_set(ClientError, ER_INDEX_FIELD_COUNT_LIMIT,
@@ -440,6 +491,14 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 	struct tuple_field *field;
 	json_tree_foreach_entry_preorder(field, &format->fields.root,
 					 struct tuple_field, token) {
+		/*
+		 * Elements of a multikey array are optional as
+		 * the array may be empty. Fields of an element
+		 * are checked when the element is met in a tuple,
+		 * see tuple_init_field_map().
+		 */
+		if (tuple_field_is_multikey_member(field))
+			continue;
 		/*
 		 * Mark all leaf non-nullable fields as required
 		 * by setting the corresponding bit in the bitmap
@@ -479,6 +538,8 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 		int max_child_idx = field->token.max_child_idx;
 		if (json_token_is_leaf(&field->token)) {
 			format->min_tuple_size += mp_sizeof_nil();
+		} else if (json_token_is_multikey(&field->token)) {
+			format->min_tuple_size += mp_sizeof_array(0);
 		} else if (field->type == FIELD_TYPE_ARRAY) {
 			format->min_tuple_size +=
 				mp_sizeof_array(max_child_idx + 1);
@@ -568,8 +629,10 @@ tuple_format_alloc(struct key_def * const *keys, uint16_t key_count,
 	/* find max max field no */
 	for (uint16_t key_no = 0; key_no < key_count; ++key_no) {
 		const struct key_def *key_def = keys[key_no];
-		const struct key_part *part = key_def->parts;
-		const struct key_part *pend = part + key_def->part_count;
+		const struct key_part *part =
+			key_def->parts + key_def->func_part_count;
+		const struct key_part *pend =
+			key_def->parts + key_def->part_count;
 		for (; part < pend; part++) {
 			index_field_count = MAX(index_field_count,
 						part->fieldno + 1);
@@ -617,6 +680,7 @@ tuple_format_alloc(struct key_def * const *keys, uint16_t key_count,
 	}
 	format->total_field_count = field_count;
 	format->required_fields = NULL;
+	format->fixed_offsets = NULL;
 	format->fields_depth = 1;
 	format->min_tuple_size = 0;
 	format->refs = 0;
@@ -632,11 +696,146 @@ error:
 	return NULL;
 }
 
+/**
+ * Return the number of bytes a field of a fixed-width format
+ * takes in a tuple or 0 if the field can't have a fixed width.
+ */
+static uint32_t
+tuple_field_fixed_width(const struct tuple_field *field)
+{
+	if (!json_token_is_leaf(&field->token) ||
+	    tuple_field_is_nullable(field))
+		return 0;
+	switch (field->type) {
+	case FIELD_TYPE_UNSIGNED:
+	case FIELD_TYPE_INTEGER:
+	case FIELD_TYPE_NUMBER:
+		/* 0xcf, 0xd3 or 0xcb followed by 8 bytes. */
+		return 9;
+	case FIELD_TYPE_BOOLEAN:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * Make a format fixed-width: compute field offsets and drop
+ * the field map, see tuple_format::fixed_offsets.
+ */
+static int
+tuple_format_init_fixed_width(struct tuple_format *format)
+{
+	uint32_t field_count = tuple_format_field_count(format);
+	if (field_count == 0) {
+		diag_set(ClientError, ER_UNSUPPORTED, "fixed_width",
+			 "a space without format");
+		return -1;
+	}
+	if (format->exact_field_count != 0 &&
+	    format->exact_field_count != field_count) {
+		diag_set(ClientError, ER_UNSUPPORTED, "fixed_width",
+			 "field_count different from the format");
+		return -1;
+	}
+	for (uint32_t i = 0; i < field_count; i++) {
+		struct tuple_field *field = tuple_format_field(format, i);
+		if (tuple_field_fixed_width(field) == 0) {
+			diag_set(ClientError, ER_UNSUPPORTED, "fixed_width",
+				 tt_sprintf("%sfield %s of type %s",
+					    tuple_field_is_nullable(field) ?
+					    "nullable " : "",
+					    tuple_field_path(field),
+					    field_type_strs[field->type]));
+			return -1;
+		}
+	}
+	size_t size = (field_count + 1) * sizeof(uint32_t);
+	uint32_t *offsets = malloc(size);
+	if (offsets == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "fixed_offsets");
+		return -1;
+	}
+	uint32_t offset = mp_sizeof_array(field_count);
+	for (uint32_t i = 0; i < field_count; i++) {
+		struct tuple_field *field = tuple_format_field(format, i);
+		field->offset_slot = TUPLE_OFFSET_SLOT_NIL;
+		offsets[i] = offset;
+		offset += tuple_field_fixed_width(field);
+	}
+	offsets[field_count] = offset;
+	format->fixed_offsets = offsets;
+	format->exact_field_count = field_count;
+	format->field_map_size = 0;
+	return 0;
+}
+
+char *
+tuple_format_encode_fixed_width(struct tuple_format *format,
+				const char *data, struct region *region)
+{
+	assert(format->fixed_offsets != NULL);
+	uint32_t field_count = tuple_format_field_count(format);
+	uint32_t size = format->fixed_offsets[field_count];
+	if (mp_typeof(*data) != MP_ARRAY) {
+		diag_set(ClientError, ER_TUPLE_NOT_ARRAY);
+		return NULL;
+	}
+	uint32_t count = mp_decode_array(&data);
+	if (count != field_count) {
+		diag_set(ClientError, ER_EXACT_FIELD_COUNT, count,
+			 field_count);
+		return NULL;
+	}
+	char *buf = region_alloc(region, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region", "tuple");
+		return NULL;
+	}
+	char *pos = mp_encode_array(buf, field_count);
+	for (uint32_t i = 0; i < field_count; i++) {
+		struct tuple_field *field = tuple_format_field(format, i);
+		enum mp_type type = mp_typeof(*data);
+		if (!field_mp_type_is_compatible(field->type, type, false)) {
+			diag_set(ClientError, ER_FIELD_TYPE,
+				 tuple_field_path(field),
+				 field_type_strs[field->type]);
+			return NULL;
+		}
+		switch (type) {
+		case MP_UINT:
+			pos = mp_store_u8(pos, 0xcf);
+			pos = mp_store_u64(pos, mp_decode_uint(&data));
+			break;
+		case MP_INT:
+			pos = mp_store_u8(pos, 0xd3);
+			pos = mp_store_u64(pos, mp_decode_int(&data));
+			break;
+		case MP_FLOAT:
+			pos = mp_store_u8(pos, 0xcb);
+			pos = mp_store_double(pos, mp_decode_float(&data));
+			break;
+		case MP_DOUBLE:
+			pos = mp_store_u8(pos, 0xcb);
+			pos = mp_store_double(pos, mp_decode_double(&data));
+			break;
+		case MP_BOOL:
+			pos = mp_encode_bool(pos, mp_decode_bool(&data));
+			break;
+		default:
+			unreachable();
+		}
+		assert(pos == buf + format->fixed_offsets[i + 1]);
+	}
+	return buf;
+}
+
 /** Free tuple format resources, doesn't unregister. */
 static inline void
 tuple_format_destroy(struct tuple_format *format)
 {
 	free(format->required_fields);
+	free(format->fixed_offsets);
 	tuple_format_destroy_fields(format);
 	tuple_dictionary_unref(format->dict);
 }
@@ -726,7 +925,8 @@ tuple_format_new(struct tuple_format_vtab *vtab, void *engine,
 		 const struct field_def *space_fields,
 		 uint32_t space_field_count, uint32_t exact_field_count,
 		 struct tuple_dictionary *dict, bool is_temporary,
-		 bool is_ephemeral)
+		 bool is_ephemeral, bool is_field_map_compact,
+		 bool is_fixed_width)
 {
 	struct tuple_format *format =
 		tuple_format_alloc(keys, key_count, space_field_count, dict);
@@ -736,11 +936,14 @@ tuple_format_new(struct tuple_format_vtab *vtab, void *engine,
 	format->engine = engine;
 	format->is_temporary = is_temporary;
 	format->is_ephemeral = is_ephemeral;
+	format->is_field_map_compact = is_field_map_compact;
 	format->exact_field_count = exact_field_count;
 	format->epoch = ++formats_epoch;
 	if (tuple_format_create(format, keys, key_count, space_fields,
 				space_field_count) < 0)
 		goto err;
+	if (is_fixed_width && tuple_format_init_fixed_width(format) != 0)
+		goto err;
 	if (tuple_format_reuse(&format))
 		return format;
 	if (tuple_format_register(format) < 0)
@@ -756,11 +959,28 @@ err:
 	return NULL;
 }
 
+/**
+ * Return the number of the top-level tuple field containing
+ * a given format field.
+ */
+static uint32_t
+tuple_field_root_fieldno(struct tuple_format *format,
+			 struct tuple_field *field)
+{
+	struct json_token *token = &field->token;
+	while (token->parent != &format->fields.root)
+		token = token->parent;
+	assert(token->type == JSON_TOKEN_NUM);
+	return token->num;
+}
+
 bool
 tuple_format1_can_store_format2_tuples(struct tuple_format *format1,
 				       struct tuple_format *format2)
 {
-	if (format1->exact_field_count != format2->exact_field_count)
+	/* Dropping the field count constraint needs no check. */
+	if (format1->exact_field_count != 0 &&
+	    format1->exact_field_count != format2->exact_field_count)
 		return false;
 	struct tuple_field *field1;
 	json_tree_foreach_entry_preorder(field1, &format1->fields.root,
@@ -781,11 +1001,21 @@ tuple_format1_can_store_format2_tuples(struct tuple_format *format1,
 			 * check, since old data may contain
 			 * NULLs or miss the subject field.
 			 */
-			if (field1->type == FIELD_TYPE_ANY &&
-			    tuple_field_is_nullable(field1))
-				continue;
-			else
+			if (!tuple_field_is_nullable(field1))
 				return false;
+			if (field1->type == FIELD_TYPE_ANY)
+				continue;
+			/*
+			 * A nullable field of any type can be
+			 * appended past the exact field count of
+			 * format2: such a field is absent in all
+			 * its tuples.
+			 */
+			if (format2->exact_field_count != 0 &&
+			    tuple_field_root_fieldno(format1, field1) >=
+			    format2->exact_field_count)
+				continue;
+			return false;
 		}
 		if (! field_type1_contains_type2(field1->type, field2->type))
 			return false;
@@ -800,6 +1030,34 @@ tuple_format1_can_store_format2_tuples(struct tuple_format *format1,
 	return true;
 }
 
+/**
+ * Start validation of a multikey array element, given its
+ * [*] field and the bitmap of fields missing in the tuple.
+ * Fail if the previous element of the array misses a field
+ * required by the format, then mark the fields as missing
+ * for the element. Missing fields of the last element are
+ * reported by a check of the bitmap at the end of the tuple.
+ */
+static int
+tuple_field_check_multikey_element(struct tuple_field *multikey_field,
+				   void *required_fields)
+{
+	struct tuple_field *field;
+	json_tree_foreach_entry_preorder(field, &multikey_field->token,
+					 struct tuple_field, token) {
+		if (!json_token_is_leaf(&field->token) ||
+		    tuple_field_is_nullable(field))
+			continue;
+		if (bit_test(required_fields, field->id)) {
+			diag_set(ClientError, ER_FIELD_MISSING,
+				 tuple_field_path(field));
+			return -1;
+		}
+		bit_set(required_fields, field->id);
+	}
+	return 0;
+}
+
 /** @sa declaration for details. */
 int
 tuple_init_field_map(struct tuple_format *format, uint32_t *field_map,
@@ -897,8 +1155,13 @@ tuple_init_field_map(struct tuple_format *format, uint32_t *field_map,
 		struct json_token token;
 		switch (mp_stack_type(&stack)) {
 		case MP_ARRAY:
-			token.type = JSON_TOKEN_NUM;
-			token.num = idx;
+			if (json_token_is_multikey(parent)) {
+				/* All elements share [*] metadata. */
+				token.type = JSON_TOKEN_ANY;
+			} else {
+				token.type = JSON_TOKEN_NUM;
+				token.num = idx;
+			}
 			break;
 		case MP_MAP:
 			if (mp_typeof(*pos) != MP_STR) {
@@ -936,8 +1199,16 @@ tuple_init_field_map(struct tuple_format *format, uint32_t *field_map,
 					 field_type_strs[field->type]);
 				goto error;
 			}
-			if (field->offset_slot != TUPLE_OFFSET_SLOT_NIL)
-				field_map[field->offset_slot] = pos - tuple;
+			if (field->offset_slot != TUPLE_OFFSET_SLOT_NIL) {
+				tuple_field_map_set(format, field_map,
+						    field->offset_slot,
+						    pos - tuple);
+			}
+			if (required_fields != NULL &&
+			    field->token.type == JSON_TOKEN_ANY &&
+			    tuple_field_check_multikey_element(field,
+							required_fields) != 0)
+				goto error;
 			if (required_fields != NULL)
 				bit_clear(required_fields, field->id);
 		}
@@ -997,7 +1268,8 @@ tuple_format_min_field_count(struct key_def * const *keys, uint16_t key_count,
 	}
 	for (uint32_t i = 0; i < key_count; ++i) {
 		const struct key_def *kd = keys[i];
-		for (uint32_t j = 0; j < kd->part_count; ++j) {
+		for (uint32_t j = kd->func_part_count; j < kd->part_count;
+		     ++j) {
 			const struct key_part *kp = &kd->parts[j];
 			if (!key_part_is_nullable(kp) &&
 			    kp->fieldno + 1 > min_field_count)
@@ -61,6 +61,17 @@ enum { TUPLE_INDEX_BASE = 1 };
  * an offset for a field_id.
  */
 enum { TUPLE_OFFSET_SLOT_NIL = INT32_MAX };
+/*
+ * A value stored in a slot of a compact field map when the field
+ * offset doesn't fit in 16 bits, see tuple_field_map_get().
+ */
+enum { TUPLE_FIELD_MAP_COMPACT_OVERFLOW = UINT16_MAX };
+/*
+ * Returned by tuple_field_map_get() when a field offset isn't
+ * stored in the field map and the field has to be looked up by
+ * decoding the tuple.
+ */
+#define TUPLE_FIELD_MAP_OFFSET_UNKNOWN UINT32_MAX
 
 struct tuple;
 struct tuple_format;
@@ -81,6 +92,13 @@ struct tuple_format_vtab {
 	struct tuple*
 	(*tuple_new)(struct tuple_format *format, const char *data,
 	             const char *end);
+	/**
+	 * Return a tuple with all fields accessible, see
+	 * tuple_unpack(). May be NULL if the engine never
+	 * compresses tuple fields.
+	 */
+	struct tuple *
+	(*tuple_unpack)(struct tuple_format *format, struct tuple *tuple);
 };
 
 /** Tuple field meta information for tuple_format. */
@@ -168,6 +186,25 @@ struct tuple_format {
 	 * be shared with other ephemeral spaces.
 	 */
 	bool is_ephemeral;
+	/**
+	 * If set, field map slots take 16 bits rather than 32.
+	 * Offsets that don't fit are not stored, and such fields
+	 * are looked up by decoding the tuple. That is, a tuple
+	 * under 64 KB gets its field map halved at no cost,
+	 * while a bigger one pays for access to fields beyond
+	 * the first 64 KB.
+	 */
+	bool is_field_map_compact;
+	/**
+	 * Offsets of fields in tuples of a fixed-width format or
+	 * NULL. Tuples of such a format store every field in
+	 * fixed-width MessagePack, see
+	 * tuple_format_encode_fixed_width(), so a field is at the
+	 * same offset in all of them and there's no field map.
+	 * The last of tuple_format_field_count() + 1 elements is
+	 * the size of a tuple.
+	 */
+	uint32_t *fixed_offsets;
 	/**
 	 * Size of field map of tuple in bytes.
 	 * \sa struct tuple
@@ -310,9 +347,15 @@ tuple_format_unref(struct tuple_format *format)
  * @param exact_field_count Exact field count for format.
  * @param is_temporary Set if format belongs to temporary space.
  * @param is_ephemeral Set if format belongs to ephemeral space.
+ * @param is_field_map_compact Set if tuples of the format should
+ *        store 16-bit field offsets.
+ * @param is_fixed_width Set if tuples of the format should be
+ *        stored in fixed-width MessagePack. Only formats of
+ *        non-nullable unsigned, integer, number and boolean
+ *        fields can be fixed-width.
  *
  * @retval not NULL Tuple format.
- * @retval     NULL Memory error.
+ * @retval     NULL Memory error or unsupported fixed-width format.
  */
 struct tuple_format *
 tuple_format_new(struct tuple_format_vtab *vtab, void *engine,
@@ -320,14 +363,19 @@ tuple_format_new(struct tuple_format_vtab *vtab, void *engine,
 		 const struct field_def *space_fields,
 		 uint32_t space_field_count, uint32_t exact_field_count,
 		 struct tuple_dictionary *dict, bool is_temporary,
-		 bool is_ephemeral);
+		 bool is_ephemeral, bool is_field_map_compact,
+		 bool is_fixed_width);
 
 /**
  * Check, if @a format1 can store any tuples of @a format2. For
  * example, if a field is not nullable in format1 and the same
  * field is nullable in format2, or the field type is integer
  * in format1 and unsigned in format2, then format1 can not store
- * format2 tuples.
+ * format2 tuples. On the other hand, dropping the exact field
+ * count, widening a field type, making a field nullable or
+ * appending nullable fields past the exact field count of
+ * format2 never invalidates format2 tuples, so such changes
+ * don't need a data check.
  * @param format1 tuple format to check for compatibility of
  * @param format2 tuple format to check compatibility with
  *
@@ -406,6 +454,70 @@ int
 tuple_init_field_map(struct tuple_format *format, uint32_t *field_map,
 		     const char *tuple, bool validate);
 
+/**
+ * Encode a MessagePack array in the fixed-width representation
+ * of a format: integers are stored as 64-bit values, floating
+ * point numbers as doubles, so that each field takes the same
+ * number of bytes in any tuple. The field count and field
+ * types are checked against the format.
+ * @param format Fixed-width tuple format.
+ * @param data   MessagePack array to encode.
+ * @param region Region to allocate the result on.
+ *
+ * @retval NULL Error, diag is set.
+ * @retval Encoded array of format->fixed_offsets[field_count]
+ *         bytes otherwise.
+ */
+char *
+tuple_format_encode_fixed_width(struct tuple_format *format,
+				const char *data, struct region *region);
+
+/**
+ * Store a field offset in a field map slot.
+ * @param format    Tuple format.
+ * @param field_map A pointer behind the last element of the field
+ *                  map.
+ * @param slot      Offset slot of the field.
+ * @param offset    Offset of the field in the tuple data.
+ */
+static inline void
+tuple_field_map_set(const struct tuple_format *format, uint32_t *field_map,
+		    int32_t slot, uint32_t offset)
+{
+	if (format->is_field_map_compact) {
+		((uint16_t *)field_map)[slot] =
+			offset < TUPLE_FIELD_MAP_COMPACT_OVERFLOW ?
+			offset : TUPLE_FIELD_MAP_COMPACT_OVERFLOW;
+	} else {
+		field_map[slot] = offset;
+	}
+}
+
+/**
+ * Get a field offset stored in a field map slot.
+ * @param format    Tuple format.
+ * @param field_map A pointer behind the last element of the field
+ *                  map.
+ * @param slot      Offset slot of the field.
+ *
+ * @retval 0 The field is absent.
+ * @retval TUPLE_FIELD_MAP_OFFSET_UNKNOWN The offset doesn't fit
+ *         in a compact field map.
+ * @retval Offset of the field in the tuple data otherwise.
+ */
+static inline uint32_t
+tuple_field_map_get(const struct tuple_format *format,
+		    const uint32_t *field_map, int32_t slot)
+{
+	if (format->is_field_map_compact) {
+		uint16_t offset = ((const uint16_t *)field_map)[slot];
+		if (unlikely(offset == TUPLE_FIELD_MAP_COMPACT_OVERFLOW))
+			return TUPLE_FIELD_MAP_OFFSET_UNKNOWN;
+		return offset;
+	}
+	return field_map[slot];
+}
+
 /**
  * Initialize tuple format subsystem.
  * @retval 0 on success, -1 otherwise.
@@ -33,6 +33,7 @@
 #include "third_party/PMurHash.h"
 #include "coll.h"
 #include <math.h>
+#include <string.h>
 
 /* Tuple and key hasher */
 namespace {
@@ -180,15 +181,218 @@ struct TupleHash<FIELD_TYPE_UNSIGNED> {
 	}
 };
 
+/*
+ * wyhash, see https://github.com/wangyi-fudan/wyhash.
+ *
+ * Unlike MurmurHash, it consumes up to 48 bytes per iteration
+ * using 64x64->128 bit multiplication, so it is much faster
+ * on long strings. It isn't incremental, so it is only used
+ * to hash whole fields, and field hashes are chained through
+ * the seed.
+ */
+static const uint64_t wyp[4] = {
+	0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+	0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL
+};
+
+static inline void
+wy_mum128(uint64_t *a, uint64_t *b)
+{
+#if defined(__SIZEOF_INT128__)
+	__uint128_t r = (__uint128_t)*a * *b;
+	*a = (uint64_t)r;
+	*b = (uint64_t)(r >> 64);
+#else
+	uint64_t ha = *a >> 32, hb = *b >> 32;
+	uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+	uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint64_t t = rl + (rm0 << 32);
+	uint64_t c = t < rl;
+	uint64_t lo = t + (rm1 << 32);
+	c += lo < t;
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t
+wy_mix(uint64_t a, uint64_t b)
+{
+	wy_mum128(&a, &b);
+	return a ^ b;
+}
+
+static inline uint64_t
+wy_read8(const char *p)
+{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t
+wy_read4(const char *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t
+wy_read3(const char *p, size_t k)
+{
+	return ((uint64_t)(uint8_t)p[0] << 16) |
+	       ((uint64_t)(uint8_t)p[k >> 1] << 8) | (uint8_t)p[k - 1];
+}
+
+static inline uint64_t
+wyhash(const char *p, size_t len, uint64_t seed)
+{
+	seed ^= wy_mix(seed ^ wyp[0], wyp[1]);
+	uint64_t a, b;
+	if (likely(len <= 16)) {
+		if (likely(len >= 4)) {
+			size_t off = (len >> 3) << 2;
+			a = (wy_read4(p) << 32) | wy_read4(p + off);
+			b = (wy_read4(p + len - 4) << 32) |
+			    wy_read4(p + len - 4 - off);
+		} else if (likely(len > 0)) {
+			a = wy_read3(p, len);
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		size_t i = len;
+		if (unlikely(i > 48)) {
+			uint64_t see1 = seed, see2 = seed;
+			do {
+				seed = wy_mix(wy_read8(p) ^ wyp[1],
+					      wy_read8(p + 8) ^ seed);
+				see1 = wy_mix(wy_read8(p + 16) ^ wyp[2],
+					      wy_read8(p + 24) ^ see1);
+				see2 = wy_mix(wy_read8(p + 32) ^ wyp[3],
+					      wy_read8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (likely(i > 48));
+			seed ^= see1 ^ see2;
+		}
+		while (unlikely(i > 16)) {
+			seed = wy_mix(wy_read8(p) ^ wyp[1],
+				      wy_read8(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+		a = wy_read8(p + i - 16);
+		b = wy_read8(p + i - 8);
+	}
+	a ^= wyp[1];
+	b ^= seed;
+	wy_mum128(&a, &b);
+	return wy_mix(a ^ wyp[0] ^ len, b ^ wyp[1]);
+}
+
+static inline uint32_t
+wyhash_result(uint64_t h)
+{
+	return (uint32_t)(h ^ (h >> 32));
+}
+
+/**
+ * Same as field_hash(), but with wyhash. Fields are hashed
+ * the same way, i.e. strings without MsgPack header and other
+ * fields along with it.
+ */
+template <int TYPE>
+static inline uint64_t
+field_wyhash(uint64_t h, const char **field)
+{
+	const char *f = *field;
+	mp_next(field);
+	return wyhash(f, *field - f, h);
+}
+
+template <>
+inline uint64_t
+field_wyhash<FIELD_TYPE_STRING>(uint64_t h, const char **field)
+{
+	uint32_t size;
+	const char *f = mp_decode_str(field, &size);
+	return wyhash(f, size, h);
+}
+
+template <int TYPE, int ...MORE_TYPES> struct FieldWyHash {};
+
+template <int TYPE, int TYPE2, int ...MORE_TYPES>
+struct FieldWyHash<TYPE, TYPE2, MORE_TYPES...> {
+	static uint64_t hash(uint64_t h, const char **pfield)
+	{
+		h = field_wyhash<TYPE>(h, pfield);
+		return FieldWyHash<TYPE2, MORE_TYPES...>::hash(h, pfield);
+	}
+};
+
+template <int TYPE>
+struct FieldWyHash<TYPE> {
+	static uint64_t hash(uint64_t h, const char **pfield)
+	{
+		return field_wyhash<TYPE>(h, pfield);
+	}
+};
+
+template <int TYPE, int ...MORE_TYPES>
+struct KeyWyHash {
+	static uint32_t hash(const char *key, struct key_def *)
+	{
+		return wyhash_result(FieldWyHash<TYPE, MORE_TYPES...>::
+				     hash(HASH_SEED, &key));
+	}
+};
+
+/* A single unsigned key is its own hash, as with MurmurHash. */
+template <>
+struct KeyWyHash<FIELD_TYPE_UNSIGNED> {
+	static uint32_t hash(const char *key, struct key_def *key_def)
+	{
+		return KeyHash<FIELD_TYPE_UNSIGNED>::hash(key, key_def);
+	}
+};
+
+template <int TYPE, int ...MORE_TYPES>
+struct TupleWyHash {
+	static uint32_t hash(const struct tuple *tuple,
+			     struct key_def *key_def)
+	{
+		const char *field =
+			tuple_field_by_part(tuple, key_def->parts);
+		return wyhash_result(FieldWyHash<TYPE, MORE_TYPES...>::
+				     hash(HASH_SEED, &field));
+	}
+};
+
+template <>
+struct TupleWyHash<FIELD_TYPE_UNSIGNED> {
+	static uint32_t hash(const struct tuple *tuple,
+			     struct key_def *key_def)
+	{
+		return TupleHash<FIELD_TYPE_UNSIGNED>::hash(tuple, key_def);
+	}
+};
+
 }; /* namespace { */
 
 #define HASHER(...) \
 	{ KeyHash<__VA_ARGS__>::hash, TupleHash<__VA_ARGS__>::hash, \
+	  KeyWyHash<__VA_ARGS__>::hash, TupleWyHash<__VA_ARGS__>::hash, \
 		{ __VA_ARGS__, UINT32_MAX } },
 
 struct hasher_signature {
 	key_hash_t kf;
 	tuple_hash_t tf;
+	/** Same as kf and tf, but with wyhash. */
+	key_hash_t wy_kf;
+	tuple_hash_t wy_tf;
 	uint32_t p[64];
 };
 
@@ -210,6 +414,12 @@ static const hasher_signature hash_arr[] = {
 	HASHER(FIELD_TYPE_STRING  , FIELD_TYPE_UNSIGNED, FIELD_TYPE_STRING)
 	HASHER(FIELD_TYPE_UNSIGNED, FIELD_TYPE_STRING  , FIELD_TYPE_STRING)
 	HASHER(FIELD_TYPE_STRING  , FIELD_TYPE_STRING  , FIELD_TYPE_STRING)
+	HASHER(FIELD_TYPE_INTEGER)
+	HASHER(FIELD_TYPE_INTEGER , FIELD_TYPE_INTEGER)
+	HASHER(FIELD_TYPE_STRING  , FIELD_TYPE_INTEGER)
+	HASHER(FIELD_TYPE_INTEGER , FIELD_TYPE_STRING)
+	HASHER(FIELD_TYPE_UNSIGNED, FIELD_TYPE_INTEGER)
+	HASHER(FIELD_TYPE_INTEGER , FIELD_TYPE_UNSIGNED)
 };
 
 #undef HASHER
@@ -221,6 +431,54 @@ tuple_hash_slowpath(const struct tuple *tuple, struct key_def *key_def);
 uint32_t
 key_hash_slowpath(const char *key, struct key_def *key_def);
 
+/**
+ * Check if a key definition having sequential parts without
+ * collations can be hashed with wyhash by fields. Floating
+ * point numbers have to be converted to integers before being
+ * hashed, see tuple_hash_field(), so only types that can't
+ * store them are allowed.
+ */
+static bool
+key_def_is_wyhashable(const struct key_def *key_def)
+{
+	for (uint32_t i = 0; i < key_def->part_count; i++) {
+		enum field_type type = key_def->parts[i].type;
+		if (type != FIELD_TYPE_UNSIGNED &&
+		    type != FIELD_TYPE_INTEGER &&
+		    type != FIELD_TYPE_STRING &&
+		    type != FIELD_TYPE_BOOLEAN)
+			return false;
+	}
+	return true;
+}
+
+/** Hash sequential fields starting at @a field with wyhash. */
+static inline uint32_t
+fields_wyhash(const char *field, struct key_def *key_def)
+{
+	uint64_t h = HASH_SEED;
+	for (uint32_t i = 0; i < key_def->part_count; i++) {
+		if (key_def->parts[i].type == FIELD_TYPE_STRING)
+			h = field_wyhash<FIELD_TYPE_STRING>(h, &field);
+		else
+			h = field_wyhash<FIELD_TYPE_ANY>(h, &field);
+	}
+	return wyhash_result(h);
+}
+
+static uint32_t
+tuple_wyhash_sequential(const struct tuple *tuple, struct key_def *key_def)
+{
+	return fields_wyhash(tuple_field_by_part(tuple, key_def->parts),
+			     key_def);
+}
+
+static uint32_t
+key_wyhash_sequential(const char *key, struct key_def *key_def)
+{
+	return fields_wyhash(key, key_def);
+}
+
 void
 tuple_hash_func_set(struct key_def *key_def) {
 	if (key_def->is_nullable || key_def->has_json_paths)
@@ -250,11 +508,21 @@ tuple_hash_func_set(struct key_def *key_def) {
 			}
 		}
 		if (i == key_def->part_count && hash_arr[k].p[i] == UINT32_MAX){
-			key_def->tuple_hash = hash_arr[k].tf;
-			key_def->key_hash = hash_arr[k].kf;
+			if (key_def->use_wyhash) {
+				key_def->tuple_hash = hash_arr[k].wy_tf;
+				key_def->key_hash = hash_arr[k].wy_kf;
+			} else {
+				key_def->tuple_hash = hash_arr[k].tf;
+				key_def->key_hash = hash_arr[k].kf;
+			}
 			return;
 		}
 	}
+	if (key_def->use_wyhash && key_def_is_wyhashable(key_def)) {
+		key_def->tuple_hash = tuple_wyhash_sequential;
+		key_def->key_hash = key_wyhash_sequential;
+		return;
+	}
 
 slowpath:
 	if (key_def->has_optional_parts) {
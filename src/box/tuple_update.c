@@ -498,6 +498,56 @@ make_arith_operation(struct op_arith_arg arg1, struct op_arith_arg arg2,
 	return 0;
 }
 
+/**
+ * Apply an arithmetic operation to the old value of its field
+ * and set the new field length.
+ */
+static int
+update_op_do_arith(struct tuple_update *update, struct update_op *op,
+		   const char *old)
+{
+	struct op_arith_arg left_arg;
+	if (mp_read_arith_arg(update->index_base, op, &old, &left_arg))
+		return -1;
+
+	struct op_arith_arg right_arg = op->arg.arith;
+	if (make_arith_operation(left_arg, right_arg, op->opcode,
+				 update->index_base + op->field_no,
+				 &op->arg.arith))
+		return -1;
+	op->new_field_len = mp_sizeof_op_arith_arg(op->arg.arith);
+	return 0;
+}
+
+/**
+ * Apply a bitwise operation to the old value of its field and
+ * set the new field length.
+ */
+static int
+update_op_do_bit(struct tuple_update *update, struct update_op *op,
+		 const char *old)
+{
+	struct op_bit_arg *arg = &op->arg.bit;
+	uint64_t val;
+	if (mp_read_uint(update->index_base, op, &old, &val))
+		return -1;
+	switch (op->opcode) {
+	case '&':
+		arg->val &= val;
+		break;
+	case '^':
+		arg->val ^= val;
+		break;
+	case '|':
+		arg->val |= val;
+		break;
+	default:
+		unreachable(); /* checked by update_read_ops */
+	}
+	op->new_field_len = mp_sizeof_uint(arg->val);
+	return 0;
+}
+
 /* }}} do_op helpers */
 
 /* {{{ do_op */
@@ -571,18 +621,9 @@ do_op_arith(struct tuple_update *update, struct update_op *op)
 			 "double update of the same field");
 		return -1;
 	}
-	const char *old = field->old;
-	struct op_arith_arg left_arg;
-	if (mp_read_arith_arg(update->index_base, op, &old, &left_arg))
-		return -1;
-
-	struct op_arith_arg right_arg = op->arg.arith;
-	if (make_arith_operation(left_arg, right_arg, op->opcode,
-				 update->index_base + op->field_no,
-				 &op->arg.arith))
+	if (update_op_do_arith(update, op, field->old) != 0)
 		return -1;
 	field->op = op;
-	op->new_field_len = mp_sizeof_op_arith_arg(op->arg.arith);
 	return 0;
 }
 
@@ -595,32 +636,15 @@ do_op_bit(struct tuple_update *update, struct update_op *op)
 		rope_extract(update->rope, op->field_no);
 	if (field == NULL)
 		return -1;
-	struct op_bit_arg *arg = &op->arg.bit;
 	if (field->op) {
 		diag_set(ClientError, ER_UPDATE_FIELD,
 			 update->index_base + op->field_no,
 			 "double update of the same field");
 		return -1;
 	}
-	const char *old = field->old;
-	uint64_t val;
-	if (mp_read_uint(update->index_base, op, &old, &val))
+	if (update_op_do_bit(update, op, field->old) != 0)
 		return -1;
-	switch (op->opcode) {
-	case '&':
-		arg->val &= val;
-		break;
-	case '^':
-		arg->val ^= val;
-		break;
-	case '|':
-		arg->val |= val;
-		break;
-	default:
-		unreachable(); /* checked by update_read_ops */
-	}
 	field->op = op;
-	op->new_field_len = mp_sizeof_uint(arg->val);
 	return 0;
 }
 
@@ -1213,6 +1237,82 @@ tuple_update_execute(tuple_update_alloc_func alloc, void *alloc_ctx,
 	return update_finish(&update, p_tuple_len);
 }
 
+/**
+ * Apply an update operation to the old field value at
+ * @a old in place. The operation must not change the field
+ * size.
+ *
+ * @retval  0 Success.
+ * @retval  1 The operation can't be applied in place.
+ * @retval -1 Error.
+ */
+static int
+update_op_do_in_place(struct tuple_update *update, struct update_op *op,
+		      char *old, uint32_t old_len)
+{
+	int rc;
+	if (op->meta == &op_set) {
+		op->new_field_len = op->arg.set.length;
+		rc = 0;
+	} else if (op->meta == &op_arith) {
+		rc = update_op_do_arith(update, op, old);
+	} else if (op->meta == &op_bit) {
+		rc = update_op_do_bit(update, op, old);
+	} else {
+		return 1;
+	}
+	if (rc != 0)
+		return -1;
+	if (op->new_field_len != old_len)
+		return 1;
+	op->meta->store(&op->arg, old, old);
+	return 0;
+}
+
+int
+tuple_update_execute_in_place(tuple_update_alloc_func alloc, void *alloc_ctx,
+			      const char *expr, const char *expr_end,
+			      char *data, int index_base, uint64_t *column_mask)
+{
+	struct tuple_update update;
+	update_init(&update, alloc, alloc_ctx, index_base);
+	const char *pos = data;
+	int32_t field_count = mp_decode_array(&pos);
+
+	if (update_read_ops(&update, expr, expr_end, field_count) != 0)
+		return -1;
+	/*
+	 * The fields are patched in a single pass over the
+	 * tuple, so the operations must go in the order of
+	 * field numbers. An update that fails this check or
+	 * refers to a missing field takes the generic path,
+	 * which reports the error.
+	 */
+	int32_t field_no = 0;
+	int32_t prev_field_no = -1;
+	struct update_op *op = update.ops;
+	struct update_op *ops_end = op + update.op_count;
+	for (; op < ops_end; op++) {
+		if (op->field_no < 0)
+			op->field_no += field_count;
+		if (op->field_no <= prev_field_no ||
+		    op->field_no >= field_count)
+			return 1;
+		prev_field_no = op->field_no;
+		for (; field_no < op->field_no; field_no++)
+			mp_next(&pos);
+		const char *end = pos;
+		mp_next(&end);
+		int rc = update_op_do_in_place(&update, op, (char *) pos,
+					       end - pos);
+		if (rc != 0)
+			return rc;
+	}
+	if (column_mask)
+		*column_mask = update.column_mask;
+	return 0;
+}
+
 const char *
 tuple_upsert_execute(tuple_update_alloc_func alloc, void *alloc_ctx,
 		     const char *expr,const char *expr_end,
@@ -1315,12 +1415,34 @@ tuple_upsert_squash(tuple_update_alloc_func alloc, void *alloc_ctx,
 		}
 		/* merge: apply second '+' or '-' */
 		assert(op[1]->opcode == '+' || op[1]->opcode == '-');
+		struct op_arith_arg arg;
+		if (op[0]->opcode == '=') {
+			/*
+			 * Fold the second op into the assigned
+			 * value unless it isn't a number.
+			 */
+			const char *value = op[0]->arg.set.value;
+			enum mp_type type = mp_typeof(*value);
+			if (type != MP_UINT && type != MP_INT &&
+			    type != MP_FLOAT && type != MP_DOUBLE)
+				return NULL;
+			if (mp_read_arith_arg(update[0].index_base, op[0],
+					      &value, &arg) != 0)
+				return NULL;
+		} else {
+			arg = op[0]->arg.arith;
+		}
 		if (op[0]->opcode == '-') {
 			op[0]->opcode = '+';
-			int96_invert(&op[0]->arg.arith.int96);
+			if (arg.type == AT_INT)
+				int96_invert(&arg.int96);
+			else if (arg.type == AT_DOUBLE)
+				arg.dbl = -arg.dbl;
+			else
+				arg.flt = -arg.flt;
 		}
 		struct op_arith_arg res;
-		if (make_arith_operation(op[0]->arg.arith, op[1]->arg.arith,
+		if (make_arith_operation(arg, op[1]->arg.arith,
 					 op[1]->opcode,
 					 update[0].index_base +
 					 op[0]->field_no, &res))
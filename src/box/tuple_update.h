@@ -57,6 +57,26 @@ tuple_update_execute(tuple_update_alloc_func alloc, void *alloc_ctx,
 		     uint32_t *p_new_size, int index_base,
 		     uint64_t *column_mask);
 
+/**
+ * Apply update operations to a tuple without rebuilding it.
+ * This is only possible if the operations don't change the
+ * tuple field count or the size of any field, i.e. they are
+ * SET, arithmetic or bitwise operations on existing fields
+ * producing values of the same encoded size as the old ones.
+ *
+ * @param data MessagePack array of the tuple to update.
+ * @param[out] column_mask Mask of the changed fields.
+ *
+ * @retval  0 Success, @a data is updated.
+ * @retval  1 The update can't be done in place, @a data may be
+ *            partially changed and should be discarded.
+ * @retval -1 Error, diag is set.
+ */
+int
+tuple_update_execute_in_place(tuple_update_alloc_func alloc, void *alloc_ctx,
+			      const char *expr, const char *expr_end,
+			      char *data, int index_base, uint64_t *column_mask);
+
 const char *
 tuple_upsert_execute(tuple_update_alloc_func alloc, void *alloc_ctx,
 		     const char *expr, const char *expr_end,
@@ -34,6 +34,7 @@
 #include "journal.h"
 #include <fiber.h>
 #include "xrow.h"
+#include "synchro.h"
 
 double too_long_threshold;
 
@@ -142,11 +143,15 @@ txn_begin(bool is_autocommit)
 	stailq_create(&txn->stmts);
 	txn->n_rows = 0;
 	txn->is_autocommit = is_autocommit;
+	txn->is_read_only = false;
 	txn->has_triggers  = false;
+	txn->has_commit_batch = false;
 	txn->is_aborted = false;
+	txn->is_sync = false;
 	txn->in_sub_stmt = 0;
 	txn->id = ++txn_id;
 	txn->signature = -1;
+	txn->sync_lsn = 0;
 	txn->engine = NULL;
 	txn->engine_tx = NULL;
 	txn->psql_txn = NULL;
@@ -185,6 +190,9 @@ txn_begin_stmt(struct space *space)
 	} else if (txn->in_sub_stmt > TXN_SUB_STMT_MAX) {
 		diag_set(ClientError, ER_SUB_STMT_MAX);
 		return NULL;
+	} else if (txn->is_read_only) {
+		diag_set(ClientError, ER_TRANSACTION_IS_READ_ONLY);
+		return NULL;
 	}
 
 	struct txn_stmt *stmt = txn_stmt_new(txn);
@@ -204,6 +212,8 @@ txn_begin_stmt(struct space *space)
 		goto fail;
 
 	stmt->space = space;
+	if (space->def->opts.is_sync)
+		txn->is_sync = true;
 	if (engine_begin_statement(engine, txn) != 0)
 		goto fail;
 
@@ -249,6 +259,9 @@ txn_commit_stmt(struct txn *txn, struct request *request)
 		if (trigger_run(&stmt->space->on_replace, txn) != 0)
 			goto fail;
 	}
+	if (stmt->space != NULL &&
+	    !rlist_empty(&stmt->space->on_commit_batch))
+		txn->has_commit_batch = true;
 	--txn->in_sub_stmt;
 	if (txn->is_autocommit && txn->in_sub_stmt == 0) {
 		int rc = txn_commit(txn);
@@ -272,17 +285,22 @@ txn_write_to_wal(struct txn *txn)
 
 	struct txn_stmt *stmt;
 	struct xrow_header **row = req->rows;
+	/* The last row to be assigned an LSN of this instance. */
+	struct xrow_header *last_local_row = NULL;
 	stailq_foreach_entry(stmt, &txn->stmts, next) {
 		if (stmt->row == NULL)
 			continue; /* A read (e.g. select) request */
 		*row++ = stmt->row;
 		req->approx_len += xrow_approx_len(stmt->row);
+		if (stmt->row->replica_id == 0)
+			last_local_row = stmt->row;
 	}
 	assert(row == req->rows + req->n_rows);
 
 	ev_tstamp start = ev_monotonic_now(loop());
 	int64_t res = journal_write(req);
 	ev_tstamp stop = ev_monotonic_now(loop());
+	fiber()->storage.wal_wait += stop - start;
 
 	if (res < 0) {
 		/* Cascading rollback. */
@@ -295,17 +313,75 @@ txn_write_to_wal(struct txn *txn)
 		fiber_reschedule();
 		diag_set(ClientError, ER_WAL_IO);
 		diag_log();
-	} else if (stop - start > too_long_threshold) {
+		return res;
+	}
+	if (stop - start > too_long_threshold) {
 		say_warn_ratelimited("too long WAL write: %d rows at "
 				     "LSN %lld: %.3f sec", txn->n_rows,
 				     res - txn->n_rows + 1, stop - start);
 	}
+	if (last_local_row != NULL)
+		txn->sync_lsn = last_local_row->lsn;
 	/*
 	 * Use vclock_sum() from WAL writer as transaction signature.
 	 */
 	return res;
 }
 
+/**
+ * Run on_commit_batch triggers of the spaces changed by
+ * a transaction, once per space.
+ */
+static void
+txn_run_commit_batch_triggers(struct txn *txn)
+{
+	struct region *region = &fiber()->gc;
+	struct stailq batches;
+	stailq_create(&batches);
+	struct txn_commit_batch *batch = NULL;
+	struct txn_stmt *stmt;
+	stailq_foreach_entry(stmt, &txn->stmts, next) {
+		struct space *space = stmt->space;
+		if (space == NULL || rlist_empty(&space->on_commit_batch) ||
+		    !space->run_triggers ||
+		    (stmt->old_tuple == NULL && stmt->new_tuple == NULL))
+			continue;
+		/*
+		 * Statements of a transaction usually go to one
+		 * or a few spaces, so a linear search is fine.
+		 */
+		if (batch == NULL || batch->space != space) {
+			struct txn_commit_batch *b;
+			batch = NULL;
+			stailq_foreach_entry(b, &batches, next) {
+				if (b->space == space) {
+					batch = b;
+					break;
+				}
+			}
+		}
+		if (batch == NULL) {
+			batch = region_alloc_object(region,
+						    struct txn_commit_batch);
+			if (batch == NULL) {
+				diag_set(OutOfMemory, sizeof(*batch),
+					 "region", "struct txn_commit_batch");
+				diag_log();
+				return;
+			}
+			batch->txn = txn;
+			batch->space = space;
+			batch->stmt_count = 0;
+			stailq_add_tail_entry(&batches, batch, next);
+		}
+		batch->stmt_count++;
+	}
+	stailq_foreach_entry(batch, &batches, next) {
+		if (trigger_run(&batch->space->on_commit_batch, batch) != 0)
+			diag_log();
+	}
+}
+
 int
 txn_commit(struct txn *txn)
 {
@@ -324,13 +400,22 @@ txn_commit(struct txn *txn)
 	}
 	/*
 	 * Perform transaction conflict resolution. Engine == NULL when
-	 * we have a bunch of IPROTO_NOP statements.
+	 * we have a bunch of IPROTO_NOP statements. A read-only
+	 * transaction has nothing to resolve.
 	 */
-	if (txn->engine != NULL) {
+	if (txn->engine != NULL && !txn->is_read_only) {
 		if (engine_prepare(txn->engine, txn) != 0)
 			goto fail;
 	}
 
+	/*
+	 * A yield is safe here: the engine has already
+	 * prepared the transaction.
+	 */
+	if (txn->has_triggers &&
+	    trigger_run(&txn->on_wal_write, txn) != 0)
+		goto fail;
+
 	if (txn->n_rows > 0) {
 		txn->signature = txn_write_to_wal(txn);
 		if (txn->signature < 0)
@@ -341,6 +426,8 @@ txn_commit(struct txn *txn)
 	 * may throw. In case an error has happened, there is
 	 * no other option but terminate.
 	 */
+	if (txn->has_commit_batch)
+		txn_run_commit_batch_triggers(txn);
 	if (txn->has_triggers &&
 	    trigger_run(&txn->on_commit, txn) != 0) {
 		diag_log();
@@ -358,8 +445,18 @@ txn_commit(struct txn *txn)
 	stailq_foreach_entry(stmt, &txn->stmts, next)
 		txn_stmt_unref_tuples(stmt);
 
+	int64_t sync_lsn = txn->is_sync ? txn->sync_lsn : 0;
 	TRASH(txn);
 	fiber_set_txn(fiber(), NULL);
+	/*
+	 * The transaction is committed locally and visible to
+	 * others, replicas acknowledge it in the background.
+	 * Wait for them after releasing the fiber so that the
+	 * WAL is not blocked and other transactions may wait for
+	 * the quorum at the same time.
+	 */
+	if (sync_lsn > 0 && synchro_wait(sync_lsn) != 0)
+		return -1;
 	return 0;
 fail:
 	txn_rollback();
@@ -450,6 +547,15 @@ box_txn_begin()
 	return 0;
 }
 
+int
+box_txn_begin_ro()
+{
+	if (box_txn_begin() != 0)
+		return -1;
+	in_txn()->is_read_only = true;
+	return 0;
+}
+
 int
 box_txn_commit()
 {
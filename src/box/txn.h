@@ -78,6 +78,28 @@ struct txn_stmt {
 	struct xrow_header *row;
 };
 
+/**
+ * Event passed to space::on_commit_batch triggers: statements
+ * of a committed transaction applied to a space. The statements
+ * are those of txn::stmts that have txn_stmt::space set to
+ * @space and either old or new tuple set.
+ *
+ * The triggers are run after the transaction is written to WAL
+ * and before it is committed in the engine, so, like on_commit
+ * triggers, they must not yield. An error returned by a trigger
+ * is logged and ignored.
+ */
+struct txn_commit_batch {
+	/** Committed transaction. */
+	struct txn *txn;
+	/** Space the statements were applied to. */
+	struct space *space;
+	/** Number of statements in the batch. */
+	uint32_t stmt_count;
+	/** Link in the list of batches of the transaction. */
+	struct stailq_entry next;
+};
+
 /**
  * Transaction savepoint object. Allocated on a transaction
  * region and becames invalid after the transaction's end.
@@ -152,8 +174,24 @@ struct txn {
 	 * rolled back at commit.
 	 */
 	bool is_aborted;
+	/**
+	 * True if the transaction was declared read-only on
+	 * begin. Such a transaction fails writes up front and
+	 * skips engine prepare on commit.
+	 */
+	bool is_read_only;
 	/** True if on_commit and on_rollback lists are non-empty. */
 	bool has_triggers;
+	/**
+	 * True if the transaction changes a space that has
+	 * on_commit_batch triggers.
+	 */
+	bool has_commit_batch;
+	/**
+	 * True if the transaction changes a synchronous space
+	 * so its commit waits for a quorum of replicas.
+	 */
+	bool is_sync;
 	/** The number of active nested statement-level transactions. */
 	int8_t in_sub_stmt;
 	/**
@@ -163,6 +201,14 @@ struct txn {
 	struct stailq_entry *sub_stmt_begin[TXN_SUB_STMT_MAX];
 	/** LSN of this transaction when written to WAL. */
 	int64_t signature;
+	/**
+	 * LSN of the last row of this transaction originating
+	 * from this instance, which must be written by the quorum
+	 * before a synchronous transaction is committed. 0 if the
+	 * transaction has no such rows, e.g. is being recovered
+	 * or received from a master.
+	 */
+	int64_t sync_lsn;
 	/** Engine involved in multi-statement transaction. */
 	struct engine *engine;
 	/** Engine-specific transaction data */
@@ -179,6 +225,11 @@ struct txn {
 	struct trigger fiber_on_stop;
 	 /** Commit and rollback triggers */
 	struct rlist on_commit, on_rollback;
+	/**
+	 * Triggers fired after the transaction is prepared and
+	 * right before it is submitted to WAL. They may yield.
+	 */
+	struct rlist on_wal_write;
 	struct sql_txn *psql_txn;
 };
 
@@ -232,6 +283,7 @@ txn_init_triggers(struct txn *txn)
 	if (txn->has_triggers == false) {
 		rlist_create(&txn->on_commit);
 		rlist_create(&txn->on_rollback);
+		rlist_create(&txn->on_wal_write);
 		txn->has_triggers = true;
 	}
 }
@@ -250,6 +302,13 @@ txn_on_rollback(struct txn *txn, struct trigger *trigger)
 	trigger_add(&txn->on_rollback, trigger);
 }
 
+static inline void
+txn_on_wal_write(struct txn *txn, struct trigger *trigger)
+{
+	txn_init_triggers(txn);
+	trigger_add(&txn->on_wal_write, trigger);
+}
+
 /**
  * Start a new statement. If no current transaction,
  * start a new transaction with autocommit = true.
@@ -398,6 +457,21 @@ box_txn(void);
 API_EXPORT int
 box_txn_begin(void);
 
+/**
+ * Begin a read-only transaction in the current fiber.
+ *
+ * Any attempt to modify data in such a transaction fails.
+ * In exchange, it doesn't need conflict tracking: a vinyl
+ * transaction reads from a consistent read view opened on
+ * first access.
+ *
+ * @retval 0 - success
+ * @retval -1 - failed, perhaps a transaction has already been
+ * started
+ */
+API_EXPORT int
+box_txn_begin_ro(void);
+
 /**
  * Commit the current transaction.
  * @retval 0 - success
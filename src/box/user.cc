@@ -431,6 +431,7 @@ auth_token_put(uint8_t auth_token)
 struct user *
 user_cache_replace(struct user_def *def)
 {
+	access_version++;
 	struct user *user = user_by_id(def->uid);
 	if (user == NULL) {
 		uint8_t auth_token = auth_token_get();
@@ -448,6 +449,7 @@ user_cache_replace(struct user_def *def)
 void
 user_cache_delete(uint32_t uid)
 {
+	access_version++;
 	mh_int_t k = mh_i32ptr_find(user_registry, uid, NULL);
 	if (k != mh_end(user_registry)) {
 		struct user *user = (struct user *)
@@ -603,6 +605,7 @@ role_check(struct user *grantee, struct user *role)
 void
 rebuild_effective_grants(struct user *grantee)
 {
+	access_version++;
 	/*
 	 * Recurse over all roles to which grantee is granted
 	 * and mark them as dirty - in need for rebuild.
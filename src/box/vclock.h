@@ -245,26 +245,30 @@ enum { VCLOCK_ORDER_UNDEFINED = INT_MAX };
 static inline int
 vclock_compare(const struct vclock *a, const struct vclock *b)
 {
-	bool le = true, ge = true;
+	/*
+	 * Components missing from the map are always zero, so
+	 * it's enough to scan the lsn arrays up to the highest
+	 * component set in either vclock. The loop body has no
+	 * data dependent branches, which lets the compiler
+	 * vectorize it: this is considerably faster than walking
+	 * the map bit by bit when many replica ids are in use.
+	 */
 	unsigned int map = a->map | b->map;
-	struct bit_iterator it;
-	bit_iterator_init(&it, &map, sizeof(map), true);
-
-	for (size_t replica_id = bit_iterator_next(&it); replica_id < VCLOCK_MAX;
-	     replica_id = bit_iterator_next(&it)) {
-
-		int64_t lsn_a = a->lsn[replica_id];
-		int64_t lsn_b = b->lsn[replica_id];
-		le = le && lsn_a <= lsn_b;
-		ge = ge && lsn_a >= lsn_b;
-		if (!ge && !le)
-			return VCLOCK_ORDER_UNDEFINED;
+	if (map == 0)
+		return 0;
+	int count = sizeof(map) * CHAR_BIT - bit_clz_u32(map);
+	bool le = true, ge = true;
+	for (int i = 0; i < count; i++) {
+		le &= a->lsn[i] <= b->lsn[i];
+		ge &= a->lsn[i] >= b->lsn[i];
 	}
 	if (ge && !le)
 		return 1;
 	if (le && !ge)
 		return -1;
-	return 0;
+	if (le && ge)
+		return 0;
+	return VCLOCK_ORDER_UNDEFINED;
 }
 
 /**
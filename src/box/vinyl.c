@@ -134,6 +134,11 @@ struct vy_env {
 	int64_t join_lsn;
 	/** Path to the data directory. */
 	char *path;
+	/**
+	 * Path to the directory for last level runs (capacity
+	 * storage tier), NULL if not configured.
+	 */
+	char *cold_path;
 	/** Max time a transaction may wait for memory. */
 	double timeout;
 	/** Try to recover corrupted data if set. */
@@ -201,6 +206,15 @@ struct vinyl_iterator {
 	struct vy_tx tx_autocommit;
 	/** Trigger invoked when tx ends to close the iterator. */
 	struct trigger on_tx_destroy;
+	/** Filters tuples must pass to be returned. */
+	const struct iterator_filter *filter;
+	uint32_t filter_count;
+	/**
+	 * Set if all filters check fields stored in secondary
+	 * index statements, so a statement can be filtered out
+	 * before the primary index lookup.
+	 */
+	bool filter_is_stored;
 };
 
 static const struct engine_vtab vinyl_engine_vtab;
@@ -276,6 +290,9 @@ vy_info_append_regulator(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "dump_watermark", r->dump_watermark);
 	info_append_int(h, "rate_limit", vy_quota_get_rate_limit(r->quota,
 							VY_QUOTA_CONSUMER_TX));
+	info_append_double(h, "read_latency", r->read_latency_p99);
+	info_append_double(h, "read_latency_budget", r->read_latency_budget);
+	info_append_int(h, "compaction_rate_limit", r->compaction_rate_limit);
 	info_table_end(h); /* regulator */
 }
 
@@ -289,6 +306,11 @@ vy_info_append_tx(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "commit", xm->stat.commit);
 	info_append_int(h, "rollback", xm->stat.rollback);
 	info_append_int(h, "conflict", xm->stat.conflict);
+	info_table_begin(h, "conflict_check");
+	info_append_int(h, "statements", xm->stat.conflict_check.statements);
+	info_append_int(h, "points", xm->stat.conflict_check.points);
+	info_append_int(h, "intervals", xm->stat.conflict_check.intervals);
+	info_table_end(h); /* conflict_check */
 
 	struct mempool_stats mstats;
 	mempool_stats(&xm->tx_mempool, &mstats);
@@ -310,11 +332,35 @@ vy_info_append_memory(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "tx", tx_manager_mem_used(env->xm));
 	info_append_int(h, "level0", lsregion_used(&env->mem_env.allocator));
 	info_append_int(h, "tuple_cache", env->cache_env.mem_used);
-	info_append_int(h, "page_index", env->lsm_env.page_index_size);
-	info_append_int(h, "bloom_filter", env->lsm_env.bloom_size);
+	info_append_int(h, "page_index", env->run_env.page_index_mem);
+	info_append_int(h, "bloom_filter", env->run_env.bloom_mem);
 	info_table_end(h); /* memory */
 }
 
+static void
+vy_info_append_page_cache(struct vy_env *env, struct info_handler *h)
+{
+	struct vy_page_cache *cache = &env->run_env.page_cache;
+
+	info_table_begin(h, "page_cache");
+	info_append_int(h, "used", cache->mem_used);
+	info_append_int(h, "hit", cache->hit);
+	info_append_int(h, "miss", cache->miss);
+	info_append_int(h, "evict", cache->evict);
+	info_table_end(h); /* page_cache */
+}
+
+static void
+vy_info_append_read_ahead(struct vy_env *env, struct info_handler *h)
+{
+	struct vy_run_env *run_env = &env->run_env;
+
+	info_table_begin(h, "read_ahead");
+	info_append_int(h, "used", run_env->read_ahead_mem);
+	info_append_int(h, "pages", run_env->read_ahead_pages);
+	info_table_end(h); /* read_ahead */
+}
+
 static void
 vy_info_append_disk(struct vy_env *env, struct info_handler *h)
 {
@@ -333,6 +379,8 @@ vinyl_engine_stat(struct vinyl_engine *vinyl, struct info_handler *h)
 	info_begin(h);
 	vy_info_append_tx(env, h);
 	vy_info_append_memory(env, h);
+	vy_info_append_page_cache(env, h);
+	vy_info_append_read_ahead(env, h);
 	vy_info_append_disk(env, h);
 	vy_info_append_scheduler(env, h);
 	vy_info_append_regulator(env, h);
@@ -396,6 +444,11 @@ vinyl_index_stat(struct index *index, struct info_handler *h)
 	info_append_int(h, "applied", stat->upsert.applied);
 	info_table_end(h); /* upsert */
 
+	info_table_begin(h, "deferred_delete");
+	vy_info_append_stmt_counter(h, NULL, &stat->deferred_delete.count);
+	info_append_int(h, "skipped", stat->deferred_delete.skipped);
+	info_table_end(h); /* deferred_delete */
+
 	info_table_begin(h, "memory");
 	vy_info_append_stmt_counter(h, NULL, &stat->memory.count);
 	info_table_begin(h, "iterator");
@@ -437,6 +490,16 @@ vinyl_index_stat(struct index *index, struct info_handler *h)
 	vy_info_append_disk_stmt_counter(h, "output", &stat->disk.compaction.output);
 	vy_info_append_disk_stmt_counter(h, "queue", &stat->disk.compaction.queue);
 	info_table_end(h); /* compaction */
+	/*
+	 * Total number of bytes written to disk per byte dumped,
+	 * see the write amplification definition in vy_regulator.c.
+	 */
+	double write_amplification = 0;
+	if (stat->disk.dump.output.bytes > 0)
+		write_amplification = 1 +
+			(double)stat->disk.compaction.output.bytes /
+			stat->disk.dump.output.bytes;
+	info_append_double(h, "write_amplification", write_amplification);
 	info_append_int(h, "index_size", lsm->page_index_size);
 	info_append_int(h, "bloom_size", lsm->bloom_size);
 	info_table_end(h); /* disk */
@@ -485,6 +548,8 @@ vinyl_index_reset_stat(struct index *index)
 	vy_stmt_counter_reset(&stat->get);
 	vy_stmt_counter_reset(&stat->put);
 	memset(&stat->upsert, 0, sizeof(stat->upsert));
+	vy_stmt_counter_reset(&stat->deferred_delete.count);
+	stat->deferred_delete.skipped = 0;
 
 	/* Iterator */
 	memset(&stat->txw.iterator, 0, sizeof(stat->txw.iterator));
@@ -519,8 +584,8 @@ vinyl_engine_memory_stat(struct engine *engine, struct engine_memory_stat *stat)
 	stat->data += lsregion_used(&env->mem_env.allocator) -
 				env->mem_env.tree_extent_size;
 	stat->index += env->mem_env.tree_extent_size;
-	stat->index += env->lsm_env.bloom_size;
-	stat->index += env->lsm_env.page_index_size;
+	stat->index += env->run_env.bloom_mem;
+	stat->index += env->run_env.page_index_mem;
 	stat->cache += env->cache_env.mem_used;
 	stat->tx += tx_manager_mem_used(env->xm);
 }
@@ -533,6 +598,10 @@ vinyl_engine_reset_stat(struct engine *engine)
 	struct tx_manager *xm = env->xm;
 	memset(&xm->stat, 0, sizeof(xm->stat));
 
+	struct vy_page_cache *page_cache = &env->run_env.page_cache;
+	page_cache->hit = page_cache->miss = page_cache->evict = 0;
+	env->run_env.read_ahead_pages = 0;
+
 	vy_scheduler_reset_stat(&env->scheduler);
 	vy_regulator_reset_stat(&env->regulator);
 }
@@ -595,6 +664,21 @@ vinyl_engine_check_space_def(struct space_def *def)
 			 def->name, "engine does not support temporary flag");
 		return -1;
 	}
+	if (def->opts.memory_quota != 0) {
+		diag_set(ClientError, ER_ALTER_SPACE,
+			 def->name, "engine does not support memory_quota");
+		return -1;
+	}
+	if (def->opts.compression_threshold != 0) {
+		diag_set(ClientError, ER_ALTER_SPACE, def->name,
+			 "engine does not support compression_threshold");
+		return -1;
+	}
+	if (def->opts.is_fixed_width) {
+		diag_set(ClientError, ER_ALTER_SPACE, def->name,
+			 "engine does not support fixed_width");
+		return -1;
+	}
 	return 0;
 }
 
@@ -628,7 +712,7 @@ vinyl_engine_create_space(struct engine *engine, struct space_def *def,
 		tuple_format_new(&vy_tuple_format_vtab, NULL, keys, key_count,
 				 def->fields, def->field_count,
 				 def->exact_field_count, def->dict, false,
-				 false);
+				 false, false, false);
 	if (format == NULL) {
 		free(space);
 		return NULL;
@@ -686,6 +770,21 @@ vinyl_space_check_index_def(struct space *space, struct index_def *index_def)
 		diag_set(ClientError, ER_NULLABLE_PRIMARY, space_name(space));
 		return -1;
 	}
+	if (index_def->key_def->is_multikey) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "multikey indexes");
+		return -1;
+	}
+	if (index_def->opts.func_id != 0) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "functional indexes");
+		return -1;
+	}
+	if (index_def->opts.store_key) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "stored keys");
+		return -1;
+	}
 	/* Check that there are no ANY, ARRAY, MAP parts */
 	for (uint32_t i = 0; i < index_def->key_def->part_count; i++) {
 		struct key_part *part = &index_def->key_def->parts[i];
@@ -698,6 +797,45 @@ vinyl_space_check_index_def(struct space *space, struct index_def *index_def)
 			return -1;
 		}
 	}
+	/*
+	 * Covered fields are stored in the index along with
+	 * key parts so they must be declared in the space format
+	 * with a type that can be compared, see vy_lsm_new().
+	 */
+	uint64_t covered_fields = index_def->opts.covered_fields;
+	if (covered_fields != 0 && index_def->iid == 0) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "primary key can't have covered fields");
+		return -1;
+	}
+	if (index_def->opts.blob_threshold != 0 && index_def->iid != 0) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "only primary key can have blob_threshold");
+		return -1;
+	}
+	if (index_def->opts.zone_map_fields != 0 && index_def->iid != 0) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "only primary key can have zone_map_fields");
+		return -1;
+	}
+	for (uint32_t i = 0; covered_fields != 0; i++, covered_fields >>= 1) {
+		if ((covered_fields & 1) == 0)
+			continue;
+		struct field_def *field = i < space->def->field_count ?
+					  &space->def->fields[i] : NULL;
+		if (field == NULL || field->type <= FIELD_TYPE_ANY ||
+		    field->type >= FIELD_TYPE_ARRAY) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 tt_sprintf("covered field %u must have "
+					    "a scalar type in the space format",
+					    i + TUPLE_INDEX_BASE));
+			return -1;
+		}
+	}
 	return 0;
 }
 
@@ -766,6 +904,10 @@ vinyl_index_open(struct index *index)
 		diag_set(SystemError, "can not access vinyl data directory");
 		return -1;
 	}
+	if (env->cold_path != NULL && access(env->cold_path, F_OK) != 0) {
+		diag_set(SystemError, "can not access vinyl cold directory");
+		return -1;
+	}
 	switch (env->status) {
 	case VINYL_ONLINE:
 		/*
@@ -983,6 +1125,8 @@ vinyl_index_def_change_requires_rebuild(struct index *index,
 
 	if (!old_def->opts.is_unique && new_def->opts.is_unique)
 		return true;
+	if (old_def->opts.covered_fields != new_def->opts.covered_fields)
+		return true;
 
 	assert(index_depends_on_pk(index));
 	const struct key_def *old_cmp_def = old_def->cmp_def;
@@ -1219,6 +1363,37 @@ vinyl_index_size(struct index *index)
 	return lsm->stat.memory.count.rows + lsm->stat.disk.count.rows;
 }
 
+static ssize_t
+vinyl_index_estimate_count(struct index *index, enum iterator_type type,
+			   const char *key, uint32_t part_count)
+{
+	struct vy_lsm *lsm = vy_lsm(index);
+	if (part_count == 0)
+		return vy_lsm_estimate_size(lsm);
+	/*
+	 * A lookup by a full unique key reads at most one tuple
+	 * so it's cheaper to count than to estimate. Count as well
+	 * if nothing has been dumped yet, because then the key
+	 * distribution can't be estimated while all statements
+	 * are in memory anyway.
+	 */
+	if (lsm->stat.disk.count.rows == 0 ||
+	    ((type == ITER_EQ || type == ITER_REQ) &&
+	     index->def->opts.is_unique &&
+	     part_count >= lsm->key_def->part_count))
+		return generic_index_count(index, type, key, part_count);
+	struct tuple *stmt = vy_stmt_new_select(lsm->env->key_format,
+						key, part_count);
+	if (stmt == NULL)
+		return -1;
+	int64_t count;
+	int rc = vy_lsm_estimate_count(lsm, type, stmt, &count);
+	tuple_unref(stmt);
+	if (rc != 0)
+		return -1;
+	return count;
+}
+
 static ssize_t
 vinyl_index_bsize(struct index *index)
 {
@@ -1644,6 +1819,27 @@ vy_unique_key_validate(struct vy_lsm *lsm, const char *key,
 	return key_validate_parts(lsm->cmp_def, key, part_count, false);
 }
 
+/**
+ * Return true if REPLACE and DELETE must look up the overwritten
+ * tuple in the primary index, so that DELETE statements get into
+ * secondary indexes right away rather than deferred until primary
+ * index compaction. This is the case if the space has on_replace
+ * triggers, which need the old tuple, or an index with covered
+ * fields, which is read without checking the primary index and
+ * so must not keep overwritten statements.
+ */
+static bool
+vy_space_needs_old_tuple(struct space *space)
+{
+	if (!rlist_empty(&space->on_replace))
+		return true;
+	for (uint32_t i = 1; i < space->index_count; i++) {
+		if (space->index[i]->def->opts.covered_fields != 0)
+			return true;
+	}
+	return false;
+}
+
 /**
  * Execute DELETE in a vinyl space.
  * @param env     Vinyl environment.
@@ -1676,11 +1872,11 @@ vy_delete(struct vy_env *env, struct vy_tx *tx, struct txn_stmt *stmt,
 	/*
 	 * There are two cases when need to get the full tuple
 	 * before deletion.
-	 * - if the space has on_replace triggers and need to pass
-	 *   to them the old tuple.
+	 * - if the space needs the old tuple, see
+	 *   vy_space_needs_old_tuple().
 	 * - if deletion is done by a secondary index.
 	 */
-	if (lsm->index_id > 0 || !rlist_empty(&space->on_replace)) {
+	if (lsm->index_id > 0 || vy_space_needs_old_tuple(space)) {
 		if (vy_get_by_raw_key(lsm, tx, vy_tx_read_view(tx),
 				      key, part_count, &stmt->old_tuple) != 0)
 			return -1;
@@ -2201,10 +2397,9 @@ vy_replace(struct vy_env *env, struct vy_tx *tx, struct txn_stmt *stmt,
 		return -1;
 	/*
 	 * Get the overwritten tuple from the primary index if
-	 * the space has on_replace triggers, in which case we
-	 * need to pass the old tuple to trigger callbacks.
+	 * the space needs it, see vy_space_needs_old_tuple().
 	 */
-	if (!rlist_empty(&space->on_replace)) {
+	if (vy_space_needs_old_tuple(space)) {
 		if (vy_get(pk, tx, vy_tx_read_view(tx),
 			   stmt->new_tuple, &stmt->old_tuple) != 0)
 			return -1;
@@ -2318,6 +2513,12 @@ vinyl_engine_begin(struct engine *engine, struct txn *txn)
 	txn->engine_tx = vy_tx_begin(env->xm);
 	if (txn->engine_tx == NULL)
 		return -1;
+	if (txn->is_read_only &&
+	    vy_tx_open_read_view(txn->engine_tx) != 0) {
+		vy_tx_rollback(txn->engine_tx);
+		txn->engine_tx = NULL;
+		return -1;
+	}
 	if (!txn->is_autocommit) {
 		trigger_create(&txn->fiber_on_stop, txn_on_stop, NULL, NULL);
 		trigger_add(&fiber()->on_stop, &txn->fiber_on_stop);
@@ -2442,6 +2643,14 @@ vy_env_quota_exceeded_cb(struct vy_quota *quota)
 	vy_regulator_quota_exceeded(&env->regulator);
 }
 
+static void
+vy_env_set_compaction_rate_limit_cb(struct vy_regulator *regulator,
+				    size_t limit)
+{
+	struct vy_env *env = container_of(regulator, struct vy_env, regulator);
+	vy_scheduler_set_compaction_rate_limit(&env->scheduler, limit);
+}
+
 static int
 vy_env_trigger_dump_cb(struct vy_regulator *regulator)
 {
@@ -2497,7 +2706,7 @@ vy_squash_schedule(struct vy_lsm *lsm, struct tuple *stmt,
 		   void /* struct vy_env */ *arg);
 
 static struct vy_env *
-vy_env_new(const char *path, size_t memory,
+vy_env_new(const char *path, const char *cold_path, size_t memory,
 	   int read_threads, int write_threads, bool force_recovery)
 {
 	struct vy_env *e = malloc(sizeof(*e));
@@ -2515,6 +2724,14 @@ vy_env_new(const char *path, size_t memory,
 			 "malloc", "env->path");
 		goto error_path;
 	}
+	if (cold_path != NULL) {
+		e->cold_path = strdup(cold_path);
+		if (e->cold_path == NULL) {
+			diag_set(OutOfMemory, strlen(cold_path),
+				 "malloc", "env->cold_path");
+			goto error_cold_path;
+		}
+	}
 
 	e->xm = tx_manager_new();
 	if (e->xm == NULL)
@@ -2528,14 +2745,16 @@ vy_env_new(const char *path, size_t memory,
 			    vy_env_dump_complete_cb,
 			    &e->run_env, &e->xm->read_views);
 
-	if (vy_lsm_env_create(&e->lsm_env, e->path,
+	if (vy_lsm_env_create(&e->lsm_env, e->path, e->cold_path,
 			      &e->scheduler.generation,
 			      vy_squash_schedule, e) != 0)
 		goto error_lsm_env;
 
 	vy_quota_create(&e->quota, memory, vy_env_quota_exceeded_cb);
 	vy_regulator_create(&e->regulator, &e->quota,
-			    vy_env_trigger_dump_cb);
+			    &e->run_env.read_latency,
+			    vy_env_trigger_dump_cb,
+			    vy_env_set_compaction_rate_limit_cb);
 
 	struct slab_cache *slab_cache = cord_slab_cache();
 	mempool_create(&e->iterator_pool, slab_cache,
@@ -2552,6 +2771,8 @@ error_lsm_env:
 error_squash_queue:
 	tx_manager_delete(e->xm);
 error_xm:
+	free(e->cold_path);
+error_cold_path:
 	free(e->path);
 error_path:
 	free(e);
@@ -2566,6 +2787,7 @@ vy_env_delete(struct vy_env *e)
 	vy_squash_queue_delete(e->squash_queue);
 	tx_manager_delete(e->xm);
 	free(e->path);
+	free(e->cold_path);
 	mempool_destroy(&e->iterator_pool);
 	vy_run_env_destroy(&e->run_env);
 	vy_lsm_env_destroy(&e->lsm_env);
@@ -2592,7 +2814,7 @@ vy_env_complete_recovery(struct vy_env *env)
 }
 
 struct vinyl_engine *
-vinyl_engine_new(const char *dir, size_t memory,
+vinyl_engine_new(const char *dir, const char *cold_dir, size_t memory,
 		 int read_threads, int write_threads, bool force_recovery)
 {
 	struct vinyl_engine *vinyl = calloc(1, sizeof(*vinyl));
@@ -2602,7 +2824,7 @@ vinyl_engine_new(const char *dir, size_t memory,
 		return NULL;
 	}
 
-	vinyl->env = vy_env_new(dir, memory, read_threads,
+	vinyl->env = vy_env_new(dir, cold_dir, memory, read_threads,
 				write_threads, force_recovery);
 	if (vinyl->env == NULL) {
 		free(vinyl);
@@ -2628,6 +2850,24 @@ vinyl_engine_set_cache(struct vinyl_engine *vinyl, size_t quota)
 	vy_cache_env_set_quota(&vinyl->env->cache_env, quota);
 }
 
+void
+vinyl_engine_set_page_cache(struct vinyl_engine *vinyl, size_t quota)
+{
+	vy_run_env_set_page_cache(&vinyl->env->run_env, quota);
+}
+
+void
+vinyl_engine_set_read_ahead(struct vinyl_engine *vinyl, size_t quota)
+{
+	vy_run_env_set_read_ahead(&vinyl->env->run_env, quota);
+}
+
+void
+vinyl_engine_set_index_cache(struct vinyl_engine *vinyl, size_t quota)
+{
+	vy_run_env_set_index_cache(&vinyl->env->run_env, quota);
+}
+
 int
 vinyl_engine_set_memory(struct vinyl_engine *vinyl, size_t size)
 {
@@ -2670,6 +2910,13 @@ vinyl_engine_set_snap_io_rate_limit(struct vinyl_engine *vinyl, double limit)
 					  limit_in_bytes);
 }
 
+void
+vinyl_engine_set_read_latency_budget(struct vinyl_engine *vinyl,
+				     double budget)
+{
+	vy_regulator_set_read_latency_budget(&vinyl->env->regulator, budget);
+}
+
 /** }}} Environment */
 
 /* {{{ Checkpoint */
@@ -2914,7 +3161,10 @@ vy_prepare_send_slice(struct vy_join_ctx *ctx,
 	run = vy_run_new(&ctx->env->run_env, slice_info->run->id);
 	if (run == NULL)
 		goto out;
-	if (vy_run_recover(run, ctx->env->path, ctx->space_id, 0) != 0)
+	run->is_cold = slice_info->run->is_cold;
+	if (vy_run_recover(run, vy_lsm_env_run_dir(&ctx->env->lsm_env,
+						   run->is_cold),
+			   ctx->space_id, 0) != 0)
 		goto out;
 
 	if (slice_info->begin != NULL) {
@@ -2953,22 +3203,37 @@ vy_send_range_f(struct cbus_call_msg *cmsg)
 	struct vy_join_ctx *ctx = container_of(cmsg, struct vy_join_ctx, cmsg);
 
 	struct tuple *stmt;
+	struct vy_run_blob *blobs;
+	uint32_t blob_count;
+	vy_write_iterator_blobs(ctx->wi, &blobs, &blob_count);
 	int rc = ctx->wi->iface->start(ctx->wi);
 	if (rc != 0)
 		goto err;
 	while ((rc = ctx->wi->iface->next(ctx->wi, &stmt)) == 0 &&
 	       stmt != NULL) {
+		struct tuple *blob_stmt = NULL;
+		if ((vy_stmt_flags(stmt) & VY_STMT_BLOB_REF) != 0) {
+			/* Send the tuple instead of its stub. */
+			blob_stmt = vy_run_blob_read(blobs, blob_count, stmt);
+			if (blob_stmt == NULL) {
+				rc = -1;
+				break;
+			}
+			stmt = blob_stmt;
+		}
 		struct xrow_header xrow;
 		rc = vy_stmt_encode_primary(stmt, ctx->key_def,
 					    ctx->space_id, &xrow);
-		if (rc != 0)
-			break;
-		/*
-		 * Reset the LSN as the replica will ignore it
-		 * anyway - see comment to vy_env::join_lsn.
-		 */
-		xrow.lsn = 0;
-		rc = xstream_write(ctx->stream, &xrow);
+		if (rc == 0) {
+			/*
+			 * Reset the LSN as the replica will ignore it
+			 * anyway - see comment to vy_env::join_lsn.
+			 */
+			xrow.lsn = 0;
+			rc = xstream_write(ctx->stream, &xrow);
+		}
+		if (blob_stmt != NULL)
+			tuple_unref(blob_stmt);
 		if (rc != 0)
 			break;
 		fiber_gc();
@@ -3061,7 +3326,7 @@ vy_send_lsm(struct vy_join_ctx *ctx, struct vy_lsm_recovery_info *lsm_info)
 		goto out;
 	ctx->format = tuple_format_new(&vy_tuple_format_vtab, NULL,
 				       &ctx->key_def, 1, NULL, 0, 0, NULL,
-				       false, false);
+				       false, false, false, false);
 	if (ctx->format == NULL)
 		goto out_free_key_def;
 	tuple_format_ref(ctx->format);
@@ -3242,9 +3507,15 @@ vy_gc_run(struct vy_env *env,
 	  struct vy_lsm_recovery_info *lsm_info,
 	  struct vy_run_recovery_info *run_info)
 {
+	/* Cold run files can't be found without vinyl_cold_dir. */
+	if (run_info->is_cold && env->cold_path == NULL)
+		return;
+
 	/* Try to delete files. */
-	if (vy_run_remove_files(env->path, lsm_info->space_id,
-				lsm_info->index_id, run_info->id) != 0)
+	if (vy_run_remove_files(vy_lsm_env_run_dir(&env->lsm_env,
+						   run_info->is_cold),
+				lsm_info->space_id, lsm_info->index_id,
+				run_info->id) != 0)
 		return;
 
 	/* Forget the run on success. */
@@ -3388,13 +3659,21 @@ vinyl_engine_backup(struct engine *engine, const struct vclock *vclock,
 		rlist_foreach_entry(run_info, &lsm_info->runs, in_lsm) {
 			if (run_info->is_dropped || run_info->is_incomplete)
 				continue;
+			if (run_info->is_cold && env->cold_path == NULL) {
+				say_error("vinyl_cold_dir is required to "
+					  "backup run %lld",
+					  (long long)run_info->id);
+				rc = -1;
+				goto out;
+			}
+			const char *dir = vy_lsm_env_run_dir(&env->lsm_env,
+							     run_info->is_cold);
 			char path[PATH_MAX];
 			for (int type = 0; type < vy_file_MAX; type++) {
 				if (type == VY_FILE_RUN_INPROGRESS ||
 				    type == VY_FILE_INDEX_INPROGRESS)
 					continue;
-				vy_run_snprint_path(path, sizeof(path),
-						    env->path,
+				vy_run_snprint_path(path, sizeof(path), dir,
 						    lsm_info->space_id,
 						    lsm_info->index_id,
 						    run_info->id, type);
@@ -3402,6 +3681,12 @@ vinyl_engine_backup(struct engine *engine, const struct vclock *vclock,
 				if (rc != 0)
 					goto out;
 			}
+			rc = vy_run_foreach_blob_file(dir,
+						      lsm_info->space_id,
+						      lsm_info->index_id,
+						      run_info->id, cb, cb_arg);
+			if (rc != 0)
+				goto out;
 			if (loops % VY_YIELD_LOOPS == 0)
 				fiber_sleep(0);
 		}
@@ -3699,6 +3984,17 @@ vinyl_iterator_check_tx(struct vinyl_iterator *it)
 	return 0;
 }
 
+/**
+ * Add a tuple returned by the iterator to the cache unless
+ * the caller asked not to, see iterator::no_cache_fill.
+ */
+static void
+vinyl_iterator_cache_add(struct vinyl_iterator *it, struct tuple *stmt)
+{
+	it->iterator.no_cache_fill = it->base.no_cache_fill;
+	vy_read_iterator_cache_add(&it->iterator, stmt);
+}
+
 static int
 vinyl_iterator_primary_next(struct iterator *base, struct tuple **ret)
 {
@@ -3706,15 +4002,19 @@ vinyl_iterator_primary_next(struct iterator *base, struct tuple **ret)
 	struct vinyl_iterator *it = (struct vinyl_iterator *)base;
 	assert(it->lsm->index_id == 0);
 
+next:
 	if (vinyl_iterator_check_tx(it) != 0)
 		goto fail;
 	if (vy_read_iterator_next(&it->iterator, ret) != 0)
 		goto fail;
-	vy_read_iterator_cache_add(&it->iterator, *ret);
+	vinyl_iterator_cache_add(it, *ret);
 	if (*ret == NULL) {
 		/* EOF. Close the iterator immediately. */
 		vinyl_iterator_close(it);
 	} else {
+		if (!iterator_filter_match(it->filter, it->filter_count,
+					   *ret))
+			goto next;
 		tuple_bless(*ret);
 	}
 	return 0;
@@ -3740,11 +4040,20 @@ next:
 
 	if (tuple == NULL) {
 		/* EOF. Close the iterator immediately. */
-		vy_read_iterator_cache_add(&it->iterator, NULL);
+		vinyl_iterator_cache_add(it, NULL);
 		vinyl_iterator_close(it);
 		*ret = NULL;
 		return 0;
 	}
+	if (it->filter_is_stored &&
+	    !iterator_filter_match(it->filter, it->filter_count, tuple)) {
+		/*
+		 * The skipped tuple isn't added to the cache,
+		 * so the cached chain must be broken here.
+		 */
+		vy_read_iterator_cache_break(&it->iterator);
+		goto next;
+	}
 #ifndef NDEBUG
 	struct errinj *delay = errinj(ERRINJ_VY_DELAY_PK_LOOKUP,
 				      ERRINJ_BOOL);
@@ -3760,7 +4069,12 @@ next:
 		goto fail;
 	if (*ret == NULL)
 		goto next;
-	vy_read_iterator_cache_add(&it->iterator, *ret);
+	vinyl_iterator_cache_add(it, *ret);
+	if (!it->filter_is_stored &&
+	    !iterator_filter_match(it->filter, it->filter_count, *ret)) {
+		tuple_unref(*ret);
+		goto next;
+	}
 	tuple_bless(*ret);
 	tuple_unref(*ret);
 	return 0;
@@ -3769,6 +4083,36 @@ fail:
 	return -1;
 }
 
+/**
+ * Iterator over a secondary index that returns its statements
+ * as is without looking up full tuples in the primary index.
+ * Used when the caller only needs fields stored in the index,
+ * see vinyl_index_create_covering_iterator().
+ */
+static int
+vinyl_iterator_covering_next(struct iterator *base, struct tuple **ret)
+{
+	assert(base->next = vinyl_iterator_covering_next);
+	struct vinyl_iterator *it = (struct vinyl_iterator *)base;
+	assert(it->lsm->index_id > 0);
+
+	if (vinyl_iterator_check_tx(it) != 0)
+		goto fail;
+	if (vy_read_iterator_next(&it->iterator, ret) != 0)
+		goto fail;
+	vinyl_iterator_cache_add(it, *ret);
+	if (*ret == NULL) {
+		/* EOF. Close the iterator immediately. */
+		vinyl_iterator_close(it);
+	} else {
+		tuple_bless(*ret);
+	}
+	return 0;
+fail:
+	vinyl_iterator_close(it);
+	return -1;
+}
+
 static void
 vinyl_iterator_free(struct iterator *base)
 {
@@ -3813,6 +4157,9 @@ vinyl_index_create_iterator(struct index *base, enum iterator_type type,
 
 	it->env = env;
 	it->lsm = lsm;
+	it->filter = NULL;
+	it->filter_count = 0;
+	it->filter_is_stored = false;
 	vy_lsm_ref(lsm);
 
 	struct vy_tx *tx = in_txn() ? in_txn()->engine_tx : NULL;
@@ -3836,6 +4183,74 @@ vinyl_index_create_iterator(struct index *base, enum iterator_type type,
 	return (struct iterator *)it;
 }
 
+static struct iterator *
+vinyl_index_create_covering_iterator(struct index *base,
+				     enum iterator_type type,
+				     const char *key, uint32_t part_count,
+				     uint64_t field_mask)
+{
+	struct iterator *it = vinyl_index_create_iterator(base, type,
+							  key, part_count);
+	struct vy_lsm *lsm = vy_lsm(base);
+	if (it == NULL || lsm->index_id == 0)
+		return it;
+	/*
+	 * Statements of a secondary index store all fields
+	 * indexed by it, the primary key fields, and covered
+	 * fields, except those indexed by JSON path, which are
+	 * only stored partially. If the caller doesn't need
+	 * any other fields, skip the primary index lookup.
+	 */
+	uint64_t stored_mask = 0;
+	for (uint32_t i = 0; i < lsm->cmp_def->part_count; i++) {
+		struct key_part *part = &lsm->cmp_def->parts[i];
+		if (part->path == NULL && part->fieldno < 63)
+			column_mask_set_fieldno(&stored_mask, part->fieldno);
+	}
+	if ((field_mask & ~stored_mask) == 0)
+		it->next = vinyl_iterator_covering_next;
+	return it;
+}
+
+static struct iterator *
+vinyl_index_create_filtered_iterator(struct index *base,
+				     enum iterator_type type,
+				     const char *key, uint32_t part_count,
+				     const struct iterator_filter *filter,
+				     uint32_t filter_count)
+{
+	struct iterator *base_it = vinyl_index_create_iterator(base, type,
+							       key, part_count);
+	if (base_it == NULL)
+		return NULL;
+	struct vinyl_iterator *it = (struct vinyl_iterator *)base_it;
+	it->filter = filter;
+	it->filter_count = filter_count;
+	/*
+	 * A secondary index statement stores the fields indexed
+	 * by it. If the filters only check such fields, they
+	 * are applied before the primary index lookup, so that
+	 * filtered out tuples are never read from the primary
+	 * index.
+	 */
+	struct key_def *cmp_def = it->lsm->cmp_def;
+	it->filter_is_stored = it->lsm->index_id > 0;
+	for (uint32_t i = 0; i < filter_count && it->filter_is_stored; i++) {
+		struct key_part *fpart = &filter[i].key_def->parts[0];
+		bool is_stored = false;
+		for (uint32_t j = 0; j < cmp_def->part_count; j++) {
+			struct key_part *part = &cmp_def->parts[j];
+			if (fpart->path == NULL && part->path == NULL &&
+			    part->fieldno == fpart->fieldno) {
+				is_stored = true;
+				break;
+			}
+		}
+		it->filter_is_stored = is_stored;
+	}
+	return base_it;
+}
+
 static int
 vinyl_index_get(struct index *index, const char *key,
 		uint32_t part_count, struct tuple **ret)
@@ -3858,6 +4273,131 @@ vinyl_index_get(struct index *index, const char *key,
 	return 0;
 }
 
+/**
+ * Max number of fibers looking up keys of a batch concurrently.
+ * Each fiber waits for one disk read at a time, so this limits
+ * the number of page reads a batch has in flight.
+ */
+enum { VY_GET_BATCH_FIBER_MAX = 32 };
+
+/** State shared by fibers looking up a batch of keys. */
+struct vy_get_batch {
+	struct vy_lsm *lsm;
+	struct vy_tx *tx;
+	const struct vy_read_view **rv;
+	/** Keys to look up, encoded as MsgPack arrays. */
+	const char **keys;
+	/** Number of keys in the batch. */
+	uint32_t key_count;
+	/** Index of the next key to look up. */
+	uint32_t next_key;
+	/** Found tuples, one per key. */
+	struct tuple **results;
+	/** Set if a lookup failed. */
+	bool is_failed;
+	/** Error of the failed lookup. */
+	struct diag diag;
+};
+
+/** Look up keys of a batch until there are none left. */
+static void
+vy_get_batch_run(struct vy_get_batch *batch)
+{
+	while (!batch->is_failed && batch->next_key < batch->key_count) {
+		uint32_t i = batch->next_key++;
+		const char *key = batch->keys[i];
+		uint32_t part_count = mp_decode_array(&key);
+		if (vy_get_by_raw_key(batch->lsm, batch->tx, batch->rv, key,
+				      part_count, &batch->results[i]) != 0) {
+			batch->is_failed = true;
+			diag_move(diag_get(), &batch->diag);
+		}
+	}
+}
+
+static int
+vy_get_batch_f(va_list ap)
+{
+	struct vy_get_batch *batch = va_arg(ap, struct vy_get_batch *);
+	vy_get_batch_run(batch);
+	return 0;
+}
+
+static int
+vinyl_index_get_batch(struct index *index, const char *keys,
+		      uint32_t key_count, struct tuple **results)
+{
+	assert(index->def->opts.is_unique);
+
+	struct vy_lsm *lsm = vy_lsm(index);
+	struct vy_env *env = vy_env(index->engine);
+	struct vy_tx *tx = in_txn() ? in_txn()->engine_tx : NULL;
+	const struct vy_read_view **rv = (tx != NULL ? vy_tx_read_view(tx) :
+					  &env->xm->p_global_read_view);
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t size = key_count * sizeof(const char *);
+	const char **key_array = region_alloc(region, size);
+	if (key_array == NULL) {
+		diag_set(OutOfMemory, size, "region", "keys");
+		return -1;
+	}
+	for (uint32_t i = 0; i < key_count; i++) {
+		key_array[i] = keys;
+		mp_next(&keys);
+		results[i] = NULL;
+	}
+
+	struct vy_get_batch batch;
+	batch.lsm = lsm;
+	batch.tx = tx;
+	batch.rv = rv;
+	batch.keys = key_array;
+	batch.key_count = key_count;
+	batch.next_key = 0;
+	batch.results = results;
+	batch.is_failed = false;
+	diag_create(&batch.diag);
+
+	/*
+	 * A started fiber looks up keys until it has to wait for
+	 * a disk read, then the next fiber takes over, so reads
+	 * of different keys are in flight at the same time while
+	 * keys found in memory or cache don't need extra fibers.
+	 * Concurrent reads of the same page are merged by the run
+	 * iterator.
+	 */
+	struct fiber *fibers[VY_GET_BATCH_FIBER_MAX];
+	int fiber_count = 0;
+	while (!batch.is_failed && batch.next_key < key_count &&
+	       fiber_count < VY_GET_BATCH_FIBER_MAX) {
+		struct fiber *f = fiber_new("vinyl.get_batch", vy_get_batch_f);
+		if (f == NULL) {
+			batch.is_failed = true;
+			diag_move(diag_get(), &batch.diag);
+			break;
+		}
+		fiber_set_joinable(f, true);
+		fibers[fiber_count++] = f;
+		fiber_start(f, &batch);
+	}
+	vy_get_batch_run(&batch);
+	for (int i = 0; i < fiber_count; i++)
+		fiber_join(fibers[i]);
+	region_truncate(region, region_svp);
+
+	if (batch.is_failed) {
+		diag_move(&batch.diag, diag_get());
+		for (uint32_t i = 0; i < key_count; i++) {
+			if (results[i] != NULL)
+				tuple_unref(results[i]);
+		}
+		return -1;
+	}
+	return 0;
+}
+
 /*** }}} Cursor */
 
 /* {{{ Index build */
@@ -3955,6 +4495,8 @@ vy_build_insert_stmt(struct vy_lsm *lsm, struct vy_mem *mem,
 		return -1;
 	vy_mem_commit_stmt(mem, region_stmt);
 	vy_stmt_counter_acct_tuple(&lsm->stat.memory.count, region_stmt);
+	vy_stmt_stat_acct(&mem->stmt_stat, vy_stmt_type(region_stmt));
+	vy_stmt_stat_acct(&lsm->stat.memory.stmt, vy_stmt_type(region_stmt));
 	return 0;
 }
 
@@ -4269,6 +4811,130 @@ out:
 
 /* }}} Index build */
 
+/* {{{ Bulk load */
+
+/**
+ * Statement stream that converts tuples returned by a bulk load
+ * source to REPLACE statements and checks that they are sorted.
+ */
+struct vy_bulk_load_stream {
+	/** Base class. */
+	struct vy_stmt_stream base;
+	/** Source of tuples to load. */
+	struct bulk_load_source *source;
+	/** Space the tuples are loaded into. */
+	struct space *space;
+	/** Primary LSM tree of the space. */
+	struct vy_lsm *pk;
+	/** LSN assigned to loaded statements. */
+	int64_t lsn;
+	/** Last returned statement, referenced. */
+	struct tuple *last;
+};
+
+static int
+vy_bulk_load_stream_start(struct vy_stmt_stream *virt_stream)
+{
+	(void)virt_stream;
+	return 0;
+}
+
+static int
+vy_bulk_load_stream_next(struct vy_stmt_stream *virt_stream,
+			 struct tuple **ret)
+{
+	struct vy_bulk_load_stream *stream =
+		(struct vy_bulk_load_stream *)virt_stream;
+	struct vy_lsm *pk = stream->pk;
+	*ret = NULL;
+	struct tuple *tuple;
+	if (stream->source->next(stream->source, &tuple) != 0)
+		return -1;
+	if (tuple == NULL)
+		return 0;
+	uint32_t bsize;
+	const char *data = tuple_data_range(tuple, &bsize);
+	if (tuple_validate_raw(stream->space->format, data) != 0)
+		return -1;
+	struct tuple *stmt = vy_stmt_new_replace(pk->mem_format, data,
+						 data + bsize);
+	if (stmt == NULL)
+		return -1;
+	vy_stmt_set_lsn(stmt, stream->lsn);
+	if (stream->last != NULL) {
+		if (vy_stmt_compare(stream->last, stmt, pk->cmp_def) >= 0) {
+			diag_set(ClientError, ER_ILLEGAL_PARAMS,
+				 "bulk load tuples are not sorted");
+			tuple_unref(stmt);
+			return -1;
+		}
+		tuple_unref(stream->last);
+	}
+	stream->last = stmt;
+	*ret = stmt;
+	return 0;
+}
+
+static void
+vy_bulk_load_stream_stop(struct vy_stmt_stream *virt_stream)
+{
+	struct vy_bulk_load_stream *stream =
+		(struct vy_bulk_load_stream *)virt_stream;
+	if (stream->last != NULL) {
+		tuple_unref(stream->last);
+		stream->last = NULL;
+	}
+}
+
+static const struct vy_stmt_stream_iface vy_bulk_load_stream_iface = {
+	.start = vy_bulk_load_stream_start,
+	.next = vy_bulk_load_stream_next,
+	.stop = vy_bulk_load_stream_stop,
+	.close = vy_bulk_load_stream_stop,
+};
+
+/**
+ * Load tuples sorted by the primary key into an empty space.
+ * The tuples are written directly to a run file, bypassing
+ * the WAL and the memory level, so they are neither replicated
+ * nor passed to space triggers.
+ */
+static int
+vinyl_space_bulk_load(struct space *space, struct bulk_load_source *source)
+{
+	struct vy_env *env = vy_env(space->engine);
+	if (env->status != VINYL_ONLINE) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "bulk load during recovery");
+		return -1;
+	}
+	if (space->index_count != 1) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "bulk load into a space with secondary indexes");
+		return -1;
+	}
+	struct vy_lsm *pk = vy_lsm(space->index[0]);
+	if (!vy_lsm_is_empty(pk)) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "bulk load into a non-empty space");
+		return -1;
+	}
+	struct vy_bulk_load_stream stream;
+	stream.base.iface = &vy_bulk_load_stream_iface;
+	stream.source = source;
+	stream.space = space;
+	stream.pk = pk;
+	stream.lsn = env->xm->lsn;
+	stream.last = NULL;
+	vy_lsm_ref(pk);
+	int rc = vy_scheduler_load_run(&env->scheduler, pk, stream.lsn,
+				       &stream.base);
+	vy_lsm_unref(pk);
+	return rc;
+}
+
+/* }}} Bulk load */
+
 /* {{{ Deferred DELETE handling */
 
 static void
@@ -4513,6 +5179,8 @@ static const struct space_vtab vinyl_space_vtab = {
 	/* .build_index = */ vinyl_space_build_index,
 	/* .swap_index = */ vinyl_space_swap_index,
 	/* .prepare_alter = */ vinyl_space_prepare_alter,
+	/* .finish_alter = */ generic_space_finish_alter,
+	/* .bulk_load = */ vinyl_space_bulk_load,
 };
 
 static const struct index_vtab vinyl_index_vtab = {
@@ -4531,9 +5199,16 @@ static const struct index_vtab vinyl_index_vtab = {
 	/* .max = */ generic_index_max,
 	/* .random = */ generic_index_random,
 	/* .count = */ generic_index_count,
+	/* .estimate_count = */ vinyl_index_estimate_count,
 	/* .get = */ vinyl_index_get,
+	/* .get_batch = */ vinyl_index_get_batch,
 	/* .replace = */ generic_index_replace,
+	/* .replace_in_place = */ generic_index_replace_in_place,
 	/* .create_iterator = */ vinyl_index_create_iterator,
+	/* .create_covering_iterator = */
+		vinyl_index_create_covering_iterator,
+	/* .create_filtered_iterator = */
+		vinyl_index_create_filtered_iterator,
 	/* .create_snapshot_iterator = */
 		generic_index_create_snapshot_iterator,
 	/* .stat = */ vinyl_index_stat,
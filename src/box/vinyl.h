@@ -41,8 +41,13 @@ extern "C" {
 struct info_handler;
 struct vinyl_engine;
 
+/**
+ * Create a vinyl engine storing data in @a dir. If @a cold_dir
+ * is not NULL, last level runs are written to it instead, see
+ * vy_lsm_env::cold_path.
+ */
 struct vinyl_engine *
-vinyl_engine_new(const char *dir, size_t memory,
+vinyl_engine_new(const char *dir, const char *cold_dir, size_t memory,
 		 int read_threads, int write_threads, bool force_recovery);
 
 /**
@@ -57,6 +62,26 @@ vinyl_engine_stat(struct vinyl_engine *vinyl, struct info_handler *handler);
 void
 vinyl_engine_set_cache(struct vinyl_engine *vinyl, size_t quota);
 
+/**
+ * Update vinyl page cache size.
+ */
+void
+vinyl_engine_set_page_cache(struct vinyl_engine *vinyl, size_t quota);
+
+/**
+ * Update the max memory that pages read ahead by vinyl
+ * sequential scans may take.
+ */
+void
+vinyl_engine_set_read_ahead(struct vinyl_engine *vinyl, size_t quota);
+
+/**
+ * Update the max memory that page indexes and bloom filters
+ * of vinyl runs may take, 0 means no limit.
+ */
+void
+vinyl_engine_set_index_cache(struct vinyl_engine *vinyl, size_t quota);
+
 /**
  * Update vinyl memory size.
  */
@@ -88,17 +113,24 @@ vinyl_engine_set_too_long_threshold(struct vinyl_engine *vinyl,
 void
 vinyl_engine_set_snap_io_rate_limit(struct vinyl_engine *vinyl, double limit);
 
+/**
+ * Update the target disk read latency.
+ */
+void
+vinyl_engine_set_read_latency_budget(struct vinyl_engine *vinyl,
+				     double budget);
+
 #ifdef __cplusplus
 } /* extern "C" */
 
 #include "diag.h"
 
 static inline struct vinyl_engine *
-vinyl_engine_new_xc(const char *dir, size_t memory,
+vinyl_engine_new_xc(const char *dir, const char *cold_dir, size_t memory,
 		    int read_threads, int write_threads, bool force_recovery)
 {
 	struct vinyl_engine *vinyl;
-	vinyl = vinyl_engine_new(dir, memory, read_threads,
+	vinyl = vinyl_engine_new(dir, cold_dir, memory, read_threads,
 				 write_threads, force_recovery);
 	if (vinyl == NULL)
 		diag_raise();
@@ -50,12 +50,16 @@ enum {
 	/* Max number of deletes that are made by cleanup action per one
 	 * cache operation */
 	VY_CACHE_CLEANUP_MAX_STEPS = 10,
+	/* Max size of the protected LRU segment, in percent of quota */
+	VY_CACHE_PROTECTED_PERCENT = 80,
 };
 
 void
 vy_cache_env_create(struct vy_cache_env *e, struct slab_cache *slab_cache)
 {
 	rlist_create(&e->cache_lru);
+	rlist_create(&e->protected_lru);
+	e->protected_mem_used = 0;
 	e->mem_used = 0;
 	e->mem_quota = 0;
 	mempool_create(&e->cache_entry_mempool, slab_cache,
@@ -96,6 +100,7 @@ vy_cache_entry_new(struct vy_cache_env *env, struct vy_cache *cache,
 	entry->flags = 0;
 	entry->left_boundary_level = cache->cmp_def->part_count;
 	entry->right_boundary_level = cache->cmp_def->part_count;
+	entry->is_protected = false;
 	rlist_add(&env->cache_lru, &entry->in_lru);
 	env->mem_used += vy_cache_entry_size(entry);
 	vy_stmt_counter_acct_tuple(&cache->stat.count, stmt);
@@ -108,12 +113,42 @@ vy_cache_entry_delete(struct vy_cache_env *env, struct vy_cache_entry *entry)
 	vy_stmt_counter_unacct_tuple(&entry->cache->stat.count, entry->stmt);
 	assert(env->mem_used >= vy_cache_entry_size(entry));
 	env->mem_used -= vy_cache_entry_size(entry);
+	if (entry->is_protected) {
+		assert(env->protected_mem_used >= vy_cache_entry_size(entry));
+		env->protected_mem_used -= vy_cache_entry_size(entry);
+	}
 	tuple_unref(entry->stmt);
 	rlist_del(&entry->in_lru);
 	TRASH(entry);
 	mempool_free(&env->cache_entry_mempool, entry);
 }
 
+/**
+ * Mark a cache entry as recently used. An entry accessed for
+ * the second time is moved from the probationary LRU segment
+ * to the protected one. If the protected segment grows too big,
+ * its least recently used entries are moved back to probation.
+ */
+static void
+vy_cache_entry_touch(struct vy_cache_env *env, struct vy_cache_entry *entry)
+{
+	rlist_move(&env->protected_lru, &entry->in_lru);
+	if (entry->is_protected)
+		return;
+	entry->is_protected = true;
+	env->protected_mem_used += vy_cache_entry_size(entry);
+	size_t limit = env->mem_quota / 100 * VY_CACHE_PROTECTED_PERCENT;
+	while (env->protected_mem_used > limit) {
+		struct vy_cache_entry *last =
+			rlist_last_entry(&env->protected_lru,
+					 struct vy_cache_entry, in_lru);
+		assert(last->is_protected);
+		last->is_protected = false;
+		env->protected_mem_used -= vy_cache_entry_size(last);
+		rlist_move(&env->cache_lru, &last->in_lru);
+	}
+}
+
 static void *
 vy_cache_tree_page_alloc(void *ctx)
 {
@@ -166,7 +201,10 @@ vy_cache_destroy(struct vy_cache *cache)
 static void
 vy_cache_gc_step(struct vy_cache_env *env)
 {
+	/* Evict probationary entries first. */
 	struct rlist *lru = &env->cache_lru;
+	if (rlist_empty(lru))
+		lru = &env->protected_lru;
 	struct vy_cache_entry *entry =
 	rlist_last_entry(lru, struct vy_cache_entry, in_lru);
 	struct vy_cache *cache = entry->cache;
@@ -321,6 +359,8 @@ vy_cache_add(struct vy_cache *cache, struct tuple *stmt,
 		entry->left_boundary_level = replaced->left_boundary_level;
 		entry->right_boundary_level = replaced->right_boundary_level;
 		vy_cache_entry_delete(cache->env, replaced);
+		/* The statement was read again, protect it. */
+		vy_cache_entry_touch(cache->env, entry);
 	}
 	if (direction > 0 && boundary_level < entry->left_boundary_level)
 		entry->left_boundary_level = boundary_level;
@@ -407,7 +447,10 @@ vy_cache_add(struct vy_cache *cache, struct tuple *stmt,
 		prev_entry->flags = replaced->flags;
 		prev_entry->left_boundary_level = replaced->left_boundary_level;
 		prev_entry->right_boundary_level = replaced->right_boundary_level;
+		bool is_protected = replaced->is_protected;
 		vy_cache_entry_delete(cache->env, replaced);
+		if (is_protected)
+			vy_cache_entry_touch(cache->env, prev_entry);
 	}
 
 	/* Set proper flags */
@@ -424,6 +467,7 @@ vy_cache_get(struct vy_cache *cache, const struct tuple *key)
 		vy_cache_tree_find(&cache->cache_tree, key);
 	if (entry == NULL)
 		return NULL;
+	vy_cache_entry_touch(cache->env, *entry);
 	return (*entry)->stmt;
 }
 
@@ -65,6 +65,8 @@ struct vy_cache_entry {
 	uint8_t left_boundary_level;
 	/* Number of parts in key when the value was the last in EQ search */
 	uint8_t right_boundary_level;
+	/** Set if the entry is in the protected LRU segment. */
+	bool is_protected;
 };
 
 /**
@@ -113,10 +115,26 @@ vy_cache_tree_key_cmp(struct vy_cache_entry *a,
 
 /**
  * Environment of the cache
+ *
+ * Cache entries are evicted in segmented LRU order. A new entry
+ * is put to the probationary segment and is moved to the protected
+ * segment only when it is accessed again, so that a long scan,
+ * which touches each entry once, evicts other probationary entries
+ * rather than the working set of frequently read entries.
  */
 struct vy_cache_env {
-	/** Common LRU list of read cache. The first element is the newest */
+	/**
+	 * Common LRU list of probationary entries of read cache.
+	 * The first element is the newest.
+	 */
 	struct rlist cache_lru;
+	/**
+	 * Common LRU list of protected entries of read cache.
+	 * The first element is the most recently used.
+	 */
+	struct rlist protected_lru;
+	/** Size of memory occupied by protected entries. */
+	size_t protected_mem_used;
 	/** Common mempool for vy_cache_entry struct */
 	struct mempool cache_entry_mempool;
 	/** Size of memory occupied by cached tuples */
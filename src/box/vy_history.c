@@ -72,6 +72,98 @@ vy_history_cleanup(struct vy_history *history)
 	rlist_create(&history->stmts);
 }
 
+/**
+ * Return true if UPSERT operations, normalized to index base 0,
+ * may change the key.
+ */
+static bool
+vy_history_upsert_changes_key(const char *ops, struct key_def *cmp_def)
+{
+	uint64_t column_mask = 0;
+	uint32_t op_count = mp_decode_array(&ops);
+	for (uint32_t i = 0; i < op_count; i++) {
+		uint32_t arg_count = mp_decode_array(&ops);
+		if (arg_count < 2)
+			return true;
+		mp_next(&ops); /* opcode */
+		if (mp_typeof(*ops) != MP_UINT)
+			return true;
+		column_mask_set_fieldno(&column_mask, mp_decode_uint(&ops));
+		for (uint32_t j = 2; j < arg_count; j++)
+			mp_next(&ops);
+	}
+	return !key_update_can_be_skipped(cmp_def->column_mask, column_mask);
+}
+
+/**
+ * Apply UPSERT statements, starting from @a node in the order
+ * of increasing LSN, to @a curr_stmt, which must be a REPLACE
+ * or INSERT. Operations of consecutive UPSERTs that can be
+ * merged, e.g. '+' applied to the same counter, are squashed
+ * with tuple_upsert_squash() so that the result is built once
+ * rather than a tuple per UPSERT. The operations of a squashed
+ * series must not change the key, because an UPSERT changing
+ * the key is ignored as a whole.
+ *
+ * Return the result and advance @a node past the applied
+ * statements.
+ */
+static struct tuple *
+vy_history_apply_upserts(struct vy_history *history,
+			 struct vy_history_node **node, struct tuple *curr_stmt,
+			 struct key_def *cmp_def, struct tuple_format *format,
+			 int *upserts_applied)
+{
+	struct tuple *upsert = (*node)->stmt;
+	struct tuple *last = upsert;
+	uint32_t size;
+	const char *ops = vy_stmt_upsert_ops(upsert, &size);
+	const char *ops_end = ops + size;
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	int count = 1;
+
+	*node = rlist_prev_entry_safe(*node, &history->stmts, link);
+	while (*node != NULL) {
+		const char *next_ops = vy_stmt_upsert_ops((*node)->stmt, &size);
+		size_t squashed_size;
+		const char *squashed =
+			tuple_upsert_squash(region_aligned_alloc_cb, region,
+					    ops, ops_end, next_ops,
+					    next_ops + size, &squashed_size, 0);
+		if (squashed == NULL ||
+		    vy_history_upsert_changes_key(squashed, cmp_def))
+			break;
+		ops = squashed;
+		ops_end = squashed + squashed_size;
+		last = (*node)->stmt;
+		count++;
+		*node = rlist_prev_entry_safe(*node, &history->stmts, link);
+	}
+	*upserts_applied += count;
+
+	struct tuple *result = NULL;
+	if (count > 1) {
+		struct iovec operations[1];
+		operations[0].iov_base = (void *)ops;
+		operations[0].iov_len = ops_end - ops;
+		const char *data = vy_upsert_data_range(last, &size);
+		upsert = vy_stmt_new_upsert(format, data, data + size,
+					    operations, 1);
+		if (upsert != NULL) {
+			vy_stmt_set_lsn(upsert, vy_stmt_lsn(last));
+			result = vy_apply_upsert(upsert, curr_stmt, cmp_def,
+						 format, true);
+			tuple_unref(upsert);
+		}
+	} else {
+		result = vy_apply_upsert(upsert, curr_stmt, cmp_def,
+					 format, true);
+	}
+	region_truncate(region, region_svp);
+	return result;
+}
+
 int
 vy_history_apply(struct vy_history *history, struct key_def *cmp_def,
 		 struct tuple_format *format, bool keep_delete,
@@ -100,15 +192,25 @@ vy_history_apply(struct vy_history *history, struct key_def *cmp_def,
 		node = rlist_prev_entry_safe(node, &history->stmts, link);
 	}
 	while (node != NULL) {
-		struct tuple *stmt = vy_apply_upsert(node->stmt, curr_stmt,
-						     cmp_def, format, true);
-		++*upserts_applied;
+		struct tuple *stmt;
+		if (curr_stmt != NULL &&
+		    vy_stmt_type(curr_stmt) != IPROTO_DELETE) {
+			stmt = vy_history_apply_upserts(history, &node,
+							curr_stmt, cmp_def,
+							format,
+							upserts_applied);
+		} else {
+			stmt = vy_apply_upsert(node->stmt, curr_stmt,
+					       cmp_def, format, true);
+			++*upserts_applied;
+			node = rlist_prev_entry_safe(node, &history->stmts,
+						     link);
+		}
 		if (curr_stmt != NULL)
 			tuple_unref(curr_stmt);
 		if (stmt == NULL)
 			return -1;
 		curr_stmt = stmt;
-		node = rlist_prev_entry_safe(node, &history->stmts, link);
 	}
 	*ret = curr_stmt;
 	return 0;
@@ -85,6 +85,7 @@ enum vy_log_key {
 	VY_LOG_KEY_DROP_LSN		= 14,
 	VY_LOG_KEY_GROUP_ID		= 15,
 	VY_LOG_KEY_DUMP_COUNT		= 16,
+	VY_LOG_KEY_IS_COLD		= 17,
 };
 
 /** vy_log_key -> human readable name. */
@@ -106,6 +107,7 @@ static const char *vy_log_key_name[] = {
 	[VY_LOG_KEY_DROP_LSN]		= "drop_lsn",
 	[VY_LOG_KEY_GROUP_ID]		= "group_id",
 	[VY_LOG_KEY_DUMP_COUNT]		= "dump_count",
+	[VY_LOG_KEY_IS_COLD]		= "is_cold",
 };
 
 /** vy_log_type -> human readable name. */
@@ -128,6 +130,7 @@ static const char *vy_log_type_name[] = {
 	[VY_LOG_PREPARE_LSM]		= "prepare_lsm",
 	[VY_LOG_REBOOTSTRAP]		= "rebootstrap",
 	[VY_LOG_ABORT_REBOOTSTRAP]	= "abort_rebootstrap",
+	[VY_LOG_COMPACT]		= "compact",
 };
 
 /** Metadata log object. */
@@ -178,6 +181,24 @@ struct vy_log {
 	 * only relevant if @tx_failed is set.
 	 */
 	struct diag tx_diag;
+	/**
+	 * Number of records appended to the current log file
+	 * after the checkpoint snapshot, including records
+	 * written by the last compaction.
+	 */
+	int64_t tail_size;
+	/**
+	 * Approximate number of records written to the current
+	 * log file by the last compaction, see vy_log_compact().
+	 */
+	int64_t compacted_size;
+	/**
+	 * Set if the log has a rebootstrap section that hasn't
+	 * been finished by rotation yet. Such a log can't be
+	 * compacted, because whether the section is committed
+	 * or aborted is only known at rotation or recovery.
+	 */
+	bool in_rebootstrap;
 };
 static struct vy_log vy_log;
 
@@ -191,6 +212,9 @@ vy_recovery_process_record(struct vy_recovery *recovery,
 static int
 vy_log_create(const struct vclock *vclock, struct vy_recovery *recovery);
 
+static void
+vy_log_maybe_compact(void);
+
 int
 vy_log_rotate(const struct vclock *vclock);
 
@@ -291,6 +315,9 @@ vy_log_record_snprint(char *buf, int size, const struct vy_log_record *record)
 		SNPRINT(total, snprintf, buf, size, "%s=%"PRIu32", ",
 			vy_log_key_name[VY_LOG_KEY_DUMP_COUNT],
 			record->dump_count);
+	if (record->is_cold)
+		SNPRINT(total, snprintf, buf, size, "%s=true, ",
+			vy_log_key_name[VY_LOG_KEY_IS_COLD]);
 	SNPRINT(total, snprintf, buf, size, "}");
 	return total;
 }
@@ -422,6 +449,11 @@ vy_log_record_encode(const struct vy_log_record *record,
 		size += mp_sizeof_uint(record->dump_count);
 		n_keys++;
 	}
+	if (record->is_cold) {
+		size += mp_sizeof_uint(VY_LOG_KEY_IS_COLD);
+		size += mp_sizeof_bool(true);
+		n_keys++;
+	}
 	size += mp_sizeof_map(n_keys);
 
 	/*
@@ -508,6 +540,10 @@ vy_log_record_encode(const struct vy_log_record *record,
 		pos = mp_encode_uint(pos, VY_LOG_KEY_DUMP_COUNT);
 		pos = mp_encode_uint(pos, record->dump_count);
 	}
+	if (record->is_cold) {
+		pos = mp_encode_uint(pos, VY_LOG_KEY_IS_COLD);
+		pos = mp_encode_bool(pos, true);
+	}
 	assert(pos == tuple + size);
 
 	/*
@@ -639,6 +675,9 @@ vy_log_record_decode(struct vy_log_record *record,
 		case VY_LOG_KEY_DUMP_COUNT:
 			record->dump_count = mp_decode_uint(&pos);
 			break;
+		case VY_LOG_KEY_IS_COLD:
+			record->is_cold = mp_decode_bool(&pos);
+			break;
 		default:
 			mp_next(&pos); /* unknown key, ignore */
 			break;
@@ -806,6 +845,7 @@ vy_log_flush(void)
 	/* Success. Free flushed records. */
 	region_reset(&vy_log.pool);
 	stailq_create(&vy_log.tx);
+	vy_log.tail_size += tx_size;
 	region_truncate(&fiber()->gc, used);
 	return 0;
 err:
@@ -887,6 +927,8 @@ vy_log_rebootstrap(void)
 	vy_log.next_id = recovery->max_id + 1;
 	vy_recovery_delete(recovery);
 
+	vy_log.in_rebootstrap = true;
+
 	struct vy_log_record record;
 	vy_log_record_init(&record);
 	record.type = VY_LOG_REBOOTSTRAP;
@@ -1072,6 +1114,9 @@ vy_log_rotate(const struct vclock *vclock)
 	 */
 	wal_rotate_vy_log();
 	vclock_copy(&vy_log.last_checkpoint, vclock);
+	vy_log.tail_size = 0;
+	vy_log.compacted_size = 0;
+	vy_log.in_rebootstrap = false;
 
 	/* Add the new vclock to the xdir so that we can track it. */
 	xdir_add_vclock(&vy_log.dir, vclock);
@@ -1174,8 +1219,9 @@ vy_log_tx_do_commit(bool no_discard)
 		 */
 		struct error *e = diag_last_error(diag_get());
 		say_warn("failed to flush vylog: %s", e->errmsg);
+		goto done;
 	}
-
+	vy_log_maybe_compact();
 done:
 	say_verbose("commit vylog transaction");
 	latch_unlock(&vy_log.latch);
@@ -1612,6 +1658,7 @@ vy_recovery_do_create_run(struct vy_recovery *recovery, int64_t run_id)
 	run->dump_lsn = -1;
 	run->gc_lsn = -1;
 	run->dump_count = 0;
+	run->is_cold = false;
 	run->is_incomplete = false;
 	run->is_dropped = false;
 	run->data = NULL;
@@ -1630,7 +1677,7 @@ vy_recovery_do_create_run(struct vy_recovery *recovery, int64_t run_id)
  */
 static int
 vy_recovery_prepare_run(struct vy_recovery *recovery, int64_t lsm_id,
-			int64_t run_id)
+			int64_t run_id, bool is_cold)
 {
 	struct vy_lsm_recovery_info *lsm;
 	lsm = vy_recovery_lookup_lsm(recovery, lsm_id);
@@ -1651,6 +1698,7 @@ vy_recovery_prepare_run(struct vy_recovery *recovery, int64_t lsm_id,
 	run = vy_recovery_do_create_run(recovery, run_id);
 	if (run == NULL)
 		return -1;
+	run->is_cold = is_cold;
 	run->is_incomplete = true;
 	rlist_add_entry(&lsm->runs, run, in_lsm);
 	return 0;
@@ -1666,7 +1714,8 @@ vy_recovery_prepare_run(struct vy_recovery *recovery, int64_t lsm_id,
  */
 static int
 vy_recovery_create_run(struct vy_recovery *recovery, int64_t lsm_id,
-		       int64_t run_id, int64_t dump_lsn, uint32_t dump_count)
+		       int64_t run_id, int64_t dump_lsn, uint32_t dump_count,
+		       bool is_cold)
 {
 	struct vy_lsm_recovery_info *lsm;
 	lsm = vy_recovery_lookup_lsm(recovery, lsm_id);
@@ -1692,6 +1741,7 @@ vy_recovery_create_run(struct vy_recovery *recovery, int64_t lsm_id,
 	}
 	run->dump_lsn = dump_lsn;
 	run->dump_count = dump_count;
+	run->is_cold = is_cold;
 	run->is_incomplete = false;
 	rlist_move_entry(&lsm->runs, run, in_lsm);
 	return 0;
@@ -2049,12 +2099,12 @@ vy_recovery_process_record(struct vy_recovery *recovery,
 		break;
 	case VY_LOG_PREPARE_RUN:
 		rc = vy_recovery_prepare_run(recovery, record->lsm_id,
-					     record->run_id);
+					     record->run_id, record->is_cold);
 		break;
 	case VY_LOG_CREATE_RUN:
 		rc = vy_recovery_create_run(recovery, record->lsm_id,
 					    record->run_id, record->dump_lsn,
-					    record->dump_count);
+					    record->dump_count, record->is_cold);
 		break;
 	case VY_LOG_DROP_RUN:
 		rc = vy_recovery_drop_run(recovery, record->run_id,
@@ -2182,20 +2232,15 @@ vy_recovery_build_index_id_hash(struct vy_recovery *recovery)
 	return 0;
 }
 
-static ssize_t
-vy_recovery_new_f(va_list ap)
+/** Allocate an empty recovery context. */
+static struct vy_recovery *
+vy_recovery_alloc(void)
 {
-	int64_t signature = va_arg(ap, int64_t);
-	int flags = va_arg(ap, int);
-	struct vy_recovery **p_recovery = va_arg(ap, struct vy_recovery **);
-
-	say_verbose("loading vylog %lld", (long long)signature);
-
 	struct vy_recovery *recovery = malloc(sizeof(*recovery));
 	if (recovery == NULL) {
 		diag_set(OutOfMemory, sizeof(*recovery),
 			 "malloc", "struct vy_recovery");
-		goto fail;
+		return NULL;
 	}
 
 	rlist_create(&recovery->lsms);
@@ -2218,8 +2263,24 @@ vy_recovery_new_f(va_list ap)
 	    recovery->run_hash == NULL ||
 	    recovery->slice_hash == NULL) {
 		diag_set(OutOfMemory, 0, "mh_i64ptr_new", "mh_i64ptr_t");
-		goto fail_free;
+		vy_recovery_delete(recovery);
+		return NULL;
 	}
+	return recovery;
+}
+
+static ssize_t
+vy_recovery_new_f(va_list ap)
+{
+	int64_t signature = va_arg(ap, int64_t);
+	int flags = va_arg(ap, int);
+	struct vy_recovery **p_recovery = va_arg(ap, struct vy_recovery **);
+
+	say_verbose("loading vylog %lld", (long long)signature);
+
+	struct vy_recovery *recovery = vy_recovery_alloc();
+	if (recovery == NULL)
+		goto fail;
 
 	/*
 	 * We don't create a log file if there are no objects to
@@ -2248,6 +2309,21 @@ vy_recovery_new_f(va_list ap)
 				break;
 			continue;
 		}
+		if (record.type == VY_LOG_COMPACT) {
+			/*
+			 * The log was compacted: the following
+			 * records describe the current state in full.
+			 */
+			struct vy_recovery *compacted = vy_recovery_alloc();
+			if (compacted == NULL) {
+				rc = -1;
+				break;
+			}
+			compacted->max_id = recovery->max_id;
+			vy_recovery_delete(recovery);
+			recovery = compacted;
+			continue;
+		}
 		rc = vy_recovery_process_record(recovery, &record);
 		if (rc < 0)
 			break;
@@ -2408,6 +2484,7 @@ vy_log_append_lsm(struct xlog *xlog, struct vy_lsm_recovery_info *lsm)
 		}
 		record.lsm_id = lsm->id;
 		record.run_id = run->id;
+		record.is_cold = run->is_cold;
 		if (vy_log_append_record(xlog, &record) != 0)
 			return -1;
 
@@ -2521,3 +2598,128 @@ err_write_xlog:
 err_create_xlog:
 	return -1;
 }
+
+/**
+ * Min number of records that must be appended to a log file
+ * after the checkpoint before the file is compacted.
+ */
+enum { VY_LOG_COMPACT_MIN = 10000 };
+
+static ssize_t
+vy_log_compact_f(va_list ap)
+{
+	struct vy_recovery *checkpoint = va_arg(ap, struct vy_recovery *);
+	struct vy_recovery *current = va_arg(ap, struct vy_recovery *);
+	const struct vclock *vclock = &vy_log.last_checkpoint;
+
+	say_verbose("compacting vylog %lld", (long long)vclock_sum(vclock));
+
+	struct xlog xlog;
+	if (xdir_create_xlog(&vy_log.dir, &xlog, vclock) != 0)
+		return -1;
+
+	/* Copy the checkpoint snapshot as is. */
+	struct vy_lsm_recovery_info *lsm;
+	rlist_foreach_entry(lsm, &checkpoint->lsms, in_recovery) {
+		if (vy_log_append_lsm(&xlog, lsm) != 0)
+			goto err;
+	}
+	struct vy_log_record record;
+	vy_log_record_init(&record);
+	record.type = VY_LOG_SNAPSHOT;
+	if (vy_log_append_record(&xlog, &record) != 0)
+		goto err;
+
+	/* Replace the records written after it with the current state. */
+	vy_log_record_init(&record);
+	record.type = VY_LOG_COMPACT;
+	if (vy_log_append_record(&xlog, &record) != 0)
+		goto err;
+	rlist_foreach_entry(lsm, &current->lsms, in_recovery) {
+		if (vy_log_append_lsm(&xlog, lsm) != 0)
+			goto err;
+	}
+
+	/*
+	 * Renaming the new file atomically replaces the old one,
+	 * so a crash at any point leaves a consistent log.
+	 */
+	if (xlog_flush(&xlog) < 0 ||
+	    xlog_sync(&xlog) < 0 ||
+	    xlog_rename(&xlog) < 0)
+		goto err;
+
+	xlog_close(&xlog, false);
+	say_verbose("done compacting vylog");
+	return 0;
+err:
+	if (unlink(xlog.filename) < 0)
+		say_syserror("failed to delete file '%s'", xlog.filename);
+	xlog_close(&xlog, false);
+	return -1;
+}
+
+/**
+ * Compact the current log file: rewrite all records appended
+ * to it after the checkpoint as a snapshot of the current state
+ * so that recovery doesn't need to replay all of them.
+ * Must be called with the log latch held.
+ */
+static int
+vy_log_compact(void)
+{
+	int64_t signature = vclock_sum(&vy_log.last_checkpoint);
+	struct vy_recovery *checkpoint, *current;
+	checkpoint = vy_recovery_new_locked(signature,
+					    VY_RECOVERY_LOAD_CHECKPOINT);
+	if (checkpoint == NULL)
+		return -1;
+	current = vy_recovery_new_locked(signature, 0);
+	if (current == NULL) {
+		vy_recovery_delete(checkpoint);
+		return -1;
+	}
+	int64_t size = mh_size(current->lsm_hash) +
+		       mh_size(current->range_hash) +
+		       mh_size(current->run_hash) +
+		       mh_size(current->slice_hash);
+
+	/* Do actual work from coio so as not to stall tx thread. */
+	int rc = coio_call(vy_log_compact_f, checkpoint, current);
+	vy_recovery_delete(checkpoint);
+	vy_recovery_delete(current);
+	if (rc < 0) {
+		diag_log();
+		say_error("failed to compact `%s'",
+			  vy_log_filename(signature));
+		return -1;
+	}
+	/*
+	 * Close the old file. The new one will be opened on
+	 * the next write (see wal_write_vy_log()).
+	 */
+	wal_rotate_vy_log();
+	vy_log.tail_size = size;
+	vy_log.compacted_size = size;
+	return 0;
+}
+
+/**
+ * Compact the current log file if enough records have been
+ * appended to it since the checkpoint or the last compaction.
+ * Compaction is triggered when the number of records after the
+ * checkpoint doubles so that its cost is amortized over writes.
+ */
+static void
+vy_log_maybe_compact(void)
+{
+	assert(latch_owner(&vy_log.latch) == fiber());
+	if (vy_log.in_rebootstrap ||
+	    vy_log.tail_size < MAX((int64_t)VY_LOG_COMPACT_MIN,
+				   2 * vy_log.compacted_size))
+		return;
+	if (vy_log_compact() != 0) {
+		/* Don't retry until the log doubles again. */
+		vy_log.compacted_size = vy_log.tail_size;
+	}
+}
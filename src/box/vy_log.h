@@ -88,6 +88,7 @@ enum vy_log_record_type {
 	/**
 	 * Prepare a vinyl run file.
 	 * Requires vy_log_record::lsm_id, run_id.
+	 * Optional vy_log_record::is_cold.
 	 *
 	 * Record of this type is written before creating a run file.
 	 * It is needed to keep track of unfinished due to errors run
@@ -97,6 +98,7 @@ enum vy_log_record_type {
 	/**
 	 * Commit a vinyl run file creation.
 	 * Requires vy_log_record::lsm_id, run_id, dump_lsn, dump_count.
+	 * Optional vy_log_record::is_cold.
 	 *
 	 * Written after a run file was successfully created.
 	 */
@@ -217,6 +219,15 @@ enum vy_log_record_type {
 	 * See also VY_LOG_REBOOTSTRAP.
 	 */
 	VY_LOG_ABORT_REBOOTSTRAP	= 17,
+	/**
+	 * This record is written after VY_LOG_SNAPSHOT when the
+	 * log file is compacted, see vy_log_compact(). It means
+	 * that all objects loaded so far must be discarded, because
+	 * the following records describe the current state from
+	 * scratch. It is ignored when only the checkpoint is loaded,
+	 * because loading stops at VY_LOG_SNAPSHOT then.
+	 */
+	VY_LOG_COMPACT			= 18,
 
 	vy_log_record_type_MAX
 };
@@ -273,6 +284,8 @@ struct vy_log_record {
 	int64_t gc_lsn;
 	/** For runs: number of dumps it took to create the run. */
 	uint32_t dump_count;
+	/** For runs: set if the run is stored on the cold tier. */
+	bool is_cold;
 	/** Link in vy_log::tx. */
 	struct stailq_entry in_tx;
 };
@@ -393,6 +406,8 @@ struct vy_run_recovery_info {
 	int64_t gc_lsn;
 	/** Number of dumps it took to create the run. */
 	uint32_t dump_count;
+	/** True if the run is stored on the cold tier. */
+	bool is_cold;
 	/**
 	 * True if the run was not committed (there's
 	 * VY_LOG_PREPARE_RUN, but no VY_LOG_CREATE_RUN).
@@ -702,20 +717,21 @@ vy_log_delete_range(int64_t range_id)
 
 /** Helper to log a vinyl run file creation. */
 static inline void
-vy_log_prepare_run(int64_t lsm_id, int64_t run_id)
+vy_log_prepare_run(int64_t lsm_id, int64_t run_id, bool is_cold)
 {
 	struct vy_log_record record;
 	vy_log_record_init(&record);
 	record.type = VY_LOG_PREPARE_RUN;
 	record.lsm_id = lsm_id;
 	record.run_id = run_id;
+	record.is_cold = is_cold;
 	vy_log_write(&record);
 }
 
 /** Helper to log a vinyl run creation. */
 static inline void
-vy_log_create_run(int64_t lsm_id, int64_t run_id,
-		  int64_t dump_lsn, uint32_t dump_count)
+vy_log_create_run(int64_t lsm_id, int64_t run_id, int64_t dump_lsn,
+		  uint32_t dump_count, bool is_cold)
 {
 	struct vy_log_record record;
 	vy_log_record_init(&record);
@@ -724,6 +740,7 @@ vy_log_create_run(int64_t lsm_id, int64_t run_id,
 	record.run_id = run_id;
 	record.dump_lsn = dump_lsn;
 	record.dump_count = dump_count;
+	record.is_cold = is_cold;
 	vy_log_write(&record);
 }
 
@@ -68,15 +68,27 @@ static const int64_t VY_MIN_RANGE_SIZE = 16 * 1024 * 1024;
  */
 static const int64_t VY_MAX_RANGE_SIZE = 2LL * 1024 * 1024 * 1024;
 
+/**
+ * A range is considered hot and split early if its access load
+ * is this many times greater than the average range load.
+ */
+static const uint64_t VY_HOT_RANGE_LOAD_FACTOR = 4;
+
+/**
+ * Min access load of a hot range. Prevents ranges from being
+ * split due to a handful of accesses to an idle LSM tree.
+ */
+static const uint64_t VY_HOT_RANGE_MIN_LOAD = 1000;
+
 int
 vy_lsm_env_create(struct vy_lsm_env *env, const char *path,
-		  int64_t *p_generation,
+		  const char *cold_path, int64_t *p_generation,
 		  vy_upsert_thresh_cb upsert_thresh_cb,
 		  void *upsert_thresh_arg)
 {
 	env->key_format = tuple_format_new(&vy_tuple_format_vtab, NULL,
 					   NULL, 0, NULL, 0, 0, NULL, false,
-					   false);
+					   false, false, false);
 	if (env->key_format == NULL)
 		return -1;
 	tuple_format_ref(env->key_format);
@@ -86,6 +98,7 @@ vy_lsm_env_create(struct vy_lsm_env *env, const char *path,
 		return -1;
 	}
 	env->path = path;
+	env->cold_path = cold_path;
 	env->p_generation = p_generation;
 	env->upsert_thresh_cb = upsert_thresh_cb;
 	env->upsert_thresh_arg = upsert_thresh_arg;
@@ -123,6 +136,50 @@ vy_lsm_mem_tree_size(struct vy_lsm *lsm)
 	return size;
 }
 
+/**
+ * Create the key definition used for comparing statements of
+ * an LSM tree. Fields covered by a secondary index are appended
+ * to its key parts merged with the primary key parts, so they
+ * get stored in the index statements. Since the primary key
+ * parts make a key unique, covered fields never affect the order
+ * of different tuples. They only tell apart statements written
+ * for different versions of the same tuple, and an overwritten
+ * version is always deleted explicitly, see vy_replace().
+ */
+static struct key_def *
+vy_lsm_cmp_def_new(struct index_def *index_def, struct tuple_format *format)
+{
+	uint64_t covered_fields = index_def->opts.covered_fields;
+	if (covered_fields == 0)
+		return key_def_dup(index_def->cmp_def);
+
+	assert(index_def->iid > 0);
+	struct key_part_def parts[63];
+	uint32_t part_count = 0;
+	for (uint32_t i = 0; covered_fields != 0; i++, covered_fields >>= 1) {
+		if ((covered_fields & 1) == 0)
+			continue;
+		struct tuple_field *field = tuple_format_field(format, i);
+		assert(field != NULL);
+		struct key_part_def *part = &parts[part_count++];
+		*part = key_part_def_default;
+		part->fieldno = i;
+		part->type = field->type;
+		part->nullable_action = field->nullable_action;
+		part->is_nullable = tuple_field_is_nullable(field);
+	}
+	struct key_def *covered_def = key_def_new(parts, part_count);
+	if (covered_def == NULL)
+		return NULL;
+	struct key_def *cmp_def = key_def_merge(index_def->cmp_def,
+						covered_def);
+	key_def_delete(covered_def);
+	if (cmp_def == NULL)
+		return NULL;
+	key_def_update_optionality(cmp_def, format->min_field_count);
+	return cmp_def;
+}
+
 struct vy_lsm *
 vy_lsm_new(struct vy_lsm_env *lsm_env, struct vy_cache_env *cache_env,
 	   struct vy_mem_env *mem_env, struct index_def *index_def,
@@ -154,7 +211,7 @@ vy_lsm_new(struct vy_lsm_env *lsm_env, struct vy_cache_env *cache_env,
 	if (key_def == NULL)
 		goto fail_key_def;
 
-	struct key_def *cmp_def = key_def_dup(index_def->cmp_def);
+	struct key_def *cmp_def = vy_lsm_cmp_def_new(index_def, format);
 	if (cmp_def == NULL)
 		goto fail_cmp_def;
 
@@ -170,7 +227,8 @@ vy_lsm_new(struct vy_lsm_env *lsm_env, struct vy_cache_env *cache_env,
 	} else {
 		lsm->disk_format = tuple_format_new(&vy_tuple_format_vtab, NULL,
 						    &cmp_def, 1, NULL, 0, 0,
-						    NULL, false, false);
+						    NULL, false, false, false,
+						    false);
 		if (lsm->disk_format == NULL)
 			goto fail_format;
 	}
@@ -211,6 +269,7 @@ vy_lsm_new(struct vy_lsm_env *lsm_env, struct vy_cache_env *cache_env,
 	lsm->opts = index_def->opts;
 	lsm->check_is_unique = lsm->opts.is_unique;
 	vy_lsm_read_set_new(&lsm->read_set);
+	vy_read_point_set_create(&lsm->point_read_set);
 
 	lsm_env->lsm_count++;
 	return lsm;
@@ -252,6 +311,8 @@ vy_lsm_delete(struct vy_lsm *lsm)
 	assert(lsm->in_dump.pos == UINT32_MAX);
 	assert(lsm->in_compaction.pos == UINT32_MAX);
 	assert(vy_lsm_read_set_empty(&lsm->read_set));
+	assert(vy_read_point_set_empty(&lsm->point_read_set));
+	vy_read_point_set_destroy(&lsm->point_read_set);
 	assert(lsm->env->lsm_count > 0);
 
 	lsm->env->lsm_count--;
@@ -281,18 +342,19 @@ vy_lsm_delete(struct vy_lsm *lsm)
 	vy_lsm_stat_destroy(&lsm->stat);
 	vy_cache_destroy(&lsm->cache);
 	tuple_format_unref(lsm->mem_format);
+	free(lsm->zdict);
 	free(lsm->tree);
 	TRASH(lsm);
 	free(lsm);
 }
 
 int
-vy_lsm_create(struct vy_lsm *lsm)
+vy_lsm_make_dir(struct vy_lsm *lsm, bool is_cold)
 {
-	/* Make LSM tree directory. */
 	int rc;
 	char path[PATH_MAX];
-	vy_lsm_snprint_path(path, sizeof(path), lsm->env->path,
+	vy_lsm_snprint_path(path, sizeof(path),
+			    vy_lsm_env_run_dir(lsm->env, is_cold),
 			    lsm->space_id, lsm->index_id);
 	char *path_sep = path;
 	while (*path_sep == '/') {
@@ -318,6 +380,15 @@ vy_lsm_create(struct vy_lsm *lsm)
 			 path);
 		return -1;
 	}
+	return 0;
+}
+
+int
+vy_lsm_create(struct vy_lsm *lsm)
+{
+	/* Make LSM tree directory. */
+	if (vy_lsm_make_dir(lsm, false) != 0)
+		return -1;
 
 	/*
 	 * Allocate a unique id for the new LSM tree, but don't assign
@@ -368,10 +439,19 @@ vy_lsm_recover_run(struct vy_lsm *lsm, struct vy_run_recovery_info *run_info,
 
 	run->dump_lsn = run_info->dump_lsn;
 	run->dump_count = run_info->dump_count;
-	if (vy_run_recover(run, lsm->env->path,
-			   lsm->space_id, lsm->index_id) != 0 &&
+	run->is_cold = run_info->is_cold;
+	if (run->is_cold && lsm->env->cold_path == NULL) {
+		diag_set(ClientError, ER_INVALID_VYLOG_FILE,
+			 tt_sprintf("Run %lld is stored on the cold tier "
+				    "but vinyl_cold_dir is not set",
+				    (long long)run->id));
+		vy_run_unref(run);
+		return NULL;
+	}
+	const char *dir = vy_lsm_env_run_dir(lsm->env, run->is_cold);
+	if (vy_run_recover(run, dir, lsm->space_id, lsm->index_id) != 0 &&
 	    (!force_recovery ||
-	     vy_run_rebuild_index(run, lsm->env->path,
+	     vy_run_rebuild_index(run, dir,
 				  lsm->space_id, lsm->index_id,
 				  lsm->cmp_def, lsm->key_def,
 				  lsm->disk_format, &lsm->opts) != 0)) {
@@ -715,6 +795,68 @@ vy_lsm_range_size(struct vy_lsm *lsm)
 	return range_size;
 }
 
+int64_t
+vy_lsm_estimate_size(struct vy_lsm *lsm)
+{
+	/*
+	 * INSERTs are written only for keys that don't exist
+	 * while DELETEs remove keys. REPLACEs and UPSERTs may
+	 * overwrite keys stored in older runs, in which case
+	 * they are counted more than once until compaction
+	 * merges the runs.
+	 */
+	struct vy_stmt_stat stat = lsm->stat.disk.stmt;
+	vy_stmt_stat_add(&stat, &lsm->stat.memory.stmt);
+	int64_t count = stat.inserts + stat.replaces + stat.upserts -
+			stat.deletes;
+	return MAX(count, 0);
+}
+
+int
+vy_lsm_estimate_count(struct vy_lsm *lsm, enum iterator_type type,
+		      const struct tuple *key, int64_t *count)
+{
+	int64_t size = vy_lsm_estimate_size(lsm);
+	int64_t disk_rows = lsm->stat.disk.count.rows;
+	if (tuple_field_count(key) == 0 || disk_rows == 0) {
+		*count = size;
+		return 0;
+	}
+	/*
+	 * Assume that in-memory statements have the same key
+	 * distribution as those stored on disk, so the share of
+	 * the key range in runs is the share in the whole tree.
+	 */
+	double rows = 0;
+	struct vy_range *range;
+	for (range = vy_range_tree_first(lsm->tree); range != NULL;
+	     range = vy_range_tree_next(lsm->tree, range)) {
+		struct vy_slice *slice;
+		rlist_foreach_entry(slice, &range->slices, in_range) {
+			double slice_rows;
+			if (vy_slice_estimate_rows(slice, type, key,
+						   lsm->cmp_def,
+						   &slice_rows) != 0)
+				return -1;
+			rows += slice_rows;
+		}
+	}
+	*count = MIN(size, (int64_t)(size * rows / disk_rows + 0.5));
+	return 0;
+}
+
+/**
+ * Return the min access load of a hot range of an LSM tree,
+ * see vy_range_needs_split().
+ */
+static uint64_t
+vy_lsm_hot_range_load(struct vy_lsm *lsm)
+{
+	uint64_t avg_load = lsm->sum_range_load / lsm->range_count;
+	return MAX(avg_load * VY_HOT_RANGE_LOAD_FACTOR,
+		   VY_HOT_RANGE_MIN_LOAD);
+}
+
 void
 vy_lsm_add_run(struct vy_lsm *lsm, struct vy_run *run)
 {
@@ -725,6 +867,7 @@ vy_lsm_add_run(struct vy_lsm *lsm, struct vy_run *run)
 	assert(rlist_empty(&run->in_lsm));
 	rlist_add_entry(&lsm->runs, run, in_lsm);
 	lsm->run_count++;
+	vy_run_cache_index(run);
 	vy_disk_stmt_counter_add(&lsm->stat.disk.count, &run->count);
 	vy_stmt_stat_add(&lsm->stat.disk.stmt, &run->info.stmt_stat);
 
@@ -741,6 +884,15 @@ vy_lsm_add_run(struct vy_lsm *lsm, struct vy_run *run)
 	env->disk_index_size += bloom_size + page_index_size;
 	if (lsm->index_id > 0)
 		env->disk_index_size += run->count.bytes;
+
+	/* Compress next runs with the dictionary trained on this one. */
+	if (run->new_zdict != NULL) {
+		free(lsm->zdict);
+		lsm->zdict = run->new_zdict;
+		lsm->zdict_size = run->new_zdict_size;
+		run->new_zdict = NULL;
+		run->new_zdict_size = 0;
+	}
 }
 
 void
@@ -806,6 +958,7 @@ vy_lsm_acct_range(struct vy_lsm *lsm, struct vy_range *range)
 		if (lsm->index_id == 0)
 			lsm->env->compacted_data_size += slice->count.bytes;
 	}
+	lsm->sum_range_load += vy_range_load(range);
 }
 
 void
@@ -824,6 +977,23 @@ vy_lsm_unacct_range(struct vy_lsm *lsm, struct vy_range *range)
 		if (lsm->index_id == 0)
 			lsm->env->compacted_data_size -= slice->count.bytes;
 	}
+	assert(lsm->sum_range_load >= vy_range_load(range));
+	lsm->sum_range_load -= vy_range_load(range);
+}
+
+void
+vy_lsm_decay_range_load(struct vy_lsm *lsm)
+{
+	struct vy_range *range;
+	struct vy_range_tree_iterator it;
+
+	lsm->sum_range_load = 0;
+	vy_range_tree_ifirst(lsm->tree, &it);
+	while ((range = vy_range_tree_inext(&it)) != NULL) {
+		range->read_load /= 2;
+		range->write_load /= 2;
+		lsm->sum_range_load += vy_range_load(range);
+	}
 }
 
 void
@@ -871,6 +1041,7 @@ vy_lsm_delete_mem(struct vy_lsm *lsm, struct vy_mem *mem)
 	assert(!rlist_empty(&mem->in_sealed));
 	rlist_del_entry(mem, in_sealed);
 	vy_stmt_counter_sub(&lsm->stat.memory.count, &mem->count);
+	vy_stmt_stat_sub(&lsm->stat.memory.stmt, &mem->stmt_stat);
 	vy_mem_delete(mem);
 	lsm->mem_list_version++;
 }
@@ -1049,6 +1220,8 @@ vy_lsm_commit_stmt(struct vy_lsm *lsm, struct vy_mem *mem,
 	vy_mem_commit_stmt(mem, stmt);
 
 	lsm->stat.memory.count.rows++;
+	vy_stmt_stat_acct(&mem->stmt_stat, vy_stmt_type(stmt));
+	vy_stmt_stat_acct(&lsm->stat.memory.stmt, vy_stmt_type(stmt));
 
 	if (vy_stmt_type(stmt) == IPROTO_UPSERT)
 		vy_lsm_commit_upsert(lsm, mem, stmt);
@@ -1076,7 +1249,7 @@ vy_lsm_split_range(struct vy_lsm *lsm, struct vy_range *range)
 
 	const char *split_key_raw;
 	if (!vy_range_needs_split(range, vy_lsm_range_size(lsm),
-				  &split_key_raw))
+				  vy_lsm_hot_range_load(lsm), &split_key_raw))
 		return false;
 
 	/* Split a range in two parts. */
@@ -1121,6 +1294,9 @@ vy_lsm_split_range(struct vy_lsm *lsm, struct vy_range *range)
 				vy_range_add_slice(part, new_slice);
 		}
 		part->needs_compaction = range->needs_compaction;
+		/* We don't know how the load is distributed. */
+		part->read_load = range->read_load / n_parts;
+		part->write_load = range->write_load / n_parts;
 		vy_range_update_compaction_priority(part, &lsm->opts);
 		vy_range_update_dumps_per_compaction(part);
 	}
@@ -1185,7 +1361,7 @@ vy_lsm_coalesce_range(struct vy_lsm *lsm, struct vy_range *range)
 {
 	struct vy_range *first, *last;
 	if (!vy_range_needs_coalesce(range, lsm->tree, vy_lsm_range_size(lsm),
-				     &first, &last))
+				     vy_lsm_hot_range_load(lsm), &first, &last))
 		return false;
 
 	struct vy_range *result = vy_range_new(vy_log_next_id(),
@@ -1229,6 +1405,8 @@ vy_lsm_coalesce_range(struct vy_lsm *lsm, struct vy_range *range)
 		rlist_splice(&result->slices, &it->slices);
 		result->slice_count += it->slice_count;
 		vy_disk_stmt_counter_add(&result->count, &it->count);
+		result->read_load += it->read_load;
+		result->write_load += it->write_load;
 		if (it->needs_compaction)
 			result->needs_compaction = true;
 		vy_range_delete(it);
@@ -67,6 +67,15 @@ typedef void
 struct vy_lsm_env {
 	/** Path to the data directory. */
 	const char *path;
+	/**
+	 * Path to the directory on the capacity storage tier,
+	 * NULL if tiering is disabled. Runs written by major
+	 * compaction go here while dumps and minor compaction
+	 * output stay in the data directory, which is supposed
+	 * to reside on fast storage. The tier of each run is
+	 * recorded in the metadata log, see vy_run::is_cold.
+	 */
+	const char *cold_path;
 	/** Memory generation counter. */
 	int64_t *p_generation;
 	/** Tuple format for keys (SELECT). */
@@ -130,7 +139,7 @@ struct vy_lsm_env {
 /** Create a common LSM tree environment. */
 int
 vy_lsm_env_create(struct vy_lsm_env *env, const char *path,
-		  int64_t *p_generation,
+		  const char *cold_path, int64_t *p_generation,
 		  vy_upsert_thresh_cb upsert_thresh_cb,
 		  void *upsert_thresh_arg);
 
@@ -138,6 +147,17 @@ vy_lsm_env_create(struct vy_lsm_env *env, const char *path,
 void
 vy_lsm_env_destroy(struct vy_lsm_env *env);
 
+/**
+ * Return the directory where files of a run stored on
+ * the given storage tier live.
+ */
+static inline const char *
+vy_lsm_env_run_dir(struct vy_lsm_env *env, bool is_cold)
+{
+	assert(!is_cold || env->cold_path != NULL);
+	return is_cold ? env->cold_path : env->path;
+}
+
 /**
  * A struct for primary and secondary Vinyl indexes.
  * Named after the data structure used for organizing
@@ -195,6 +215,15 @@ struct vy_lsm {
 	uint32_t group_id;
 	/** Index options. */
 	struct index_opts opts;
+	/**
+	 * Zstd dictionary trained on the pages of the last run
+	 * written for this LSM tree, used to compress pages of
+	 * the next runs, see index_opts::compression_dict_size.
+	 * NULL until the first run is written.
+	 */
+	char *zdict;
+	/** Size of the zdict. */
+	uint32_t zdict_size;
 	/** Key definition used to compare tuples. */
 	struct key_def *cmp_def;
 	/** Key definition passed by the user. */
@@ -253,6 +282,8 @@ struct vy_lsm {
 	int range_count;
 	/** Sum dumps_per_compaction across all ranges. */
 	int sum_dumps_per_compaction;
+	/** Sum access load across all ranges, see vy_range_load(). */
+	uint64_t sum_range_load;
 	/** Heap of ranges, prioritized by compaction_priority. */
 	heap_t range_heap;
 	/**
@@ -317,6 +348,12 @@ struct vy_lsm {
 	 * this LSM tree.
 	 */
 	vy_lsm_read_set_t read_set;
+	/**
+	 * Point reads from this LSM tree done by all active
+	 * transactions. Such reads are stored here instead of
+	 * the read_set interval tree.
+	 */
+	struct vy_read_point_set point_read_set;
 };
 
 /** Extract vy_lsm from an index object. */
@@ -404,6 +441,13 @@ vy_lsm_update_pk(struct vy_lsm *lsm, struct vy_lsm *pk)
 	lsm->pk = pk;
 }
 
+/**
+ * Make the directory for files of an LSM tree on the given
+ * storage tier unless it already exists.
+ */
+int
+vy_lsm_make_dir(struct vy_lsm *lsm, bool is_cold);
+
 /**
  * Create a new LSM tree.
  *
@@ -454,6 +498,27 @@ vy_lsm_compaction_priority(struct vy_lsm *lsm);
 int64_t
 vy_lsm_range_size(struct vy_lsm *lsm);
 
+/**
+ * Estimate the number of tuples stored in an LSM tree from
+ * statement statistics of its runs and in-memory trees, adjusted
+ * for DELETEs. Takes O(1) time.
+ */
+int64_t
+vy_lsm_estimate_size(struct vy_lsm *lsm);
+
+/**
+ * Estimate the number of tuples of an LSM tree matching @key
+ * and iterator @type. The share of the key range in runs is
+ * taken from the page index, see vy_slice_estimate_rows(), and
+ * applied to vy_lsm_estimate_size(). Doesn't read any data, but
+ * may load page index blocks.
+ *
+ * Returns 0 and sets @count on success, -1 on error.
+ */
+int
+vy_lsm_estimate_count(struct vy_lsm *lsm, enum iterator_type type,
+		      const struct tuple *key, int64_t *count);
+
 /** Add a run to the list of runs of an LSM tree. */
 void
 vy_lsm_add_run(struct vy_lsm *lsm, struct vy_run *run);
@@ -485,6 +550,7 @@ vy_lsm_remove_range(struct vy_lsm *lsm, struct vy_range *range);
  *  - vy_lsm::stat::disk::compaction::queue after compaction priority
  *    of a range is updated.
  *  - vy_lsm::stat::disk::last_level_count after a range is compacted.
+ *  - vy_lsm::sum_range_load after a range is created or deleted.
  */
 void
 vy_lsm_acct_range(struct vy_lsm *lsm, struct vy_range *range);
@@ -497,6 +563,27 @@ vy_lsm_acct_range(struct vy_lsm *lsm, struct vy_range *range);
 void
 vy_lsm_unacct_range(struct vy_lsm *lsm, struct vy_range *range);
 
+/**
+ * Account disk lookups done in a range of an LSM tree
+ * or statements dumped to it, see vy_range::read_load.
+ */
+static inline void
+vy_lsm_acct_range_load(struct vy_lsm *lsm, struct vy_range *range,
+		       uint64_t reads, uint64_t writes)
+{
+	range->read_load += reads;
+	range->write_load += writes;
+	lsm->sum_range_load += reads + writes;
+}
+
+/**
+ * Halve the access load of all ranges of an LSM tree.
+ * Called on each dump so that old accesses don't count
+ * as much as recent ones.
+ */
+void
+vy_lsm_decay_range_load(struct vy_lsm *lsm);
+
 /**
  * Account dump in LSM tree statistics.
  */
@@ -530,8 +617,8 @@ void
 vy_lsm_delete_mem(struct vy_lsm *lsm, struct vy_mem *mem);
 
 /**
- * Split a range if it has grown too big, return true if the range
- * was split. Splitting is done by making slices of the runs used
+ * Split a range if it has grown too big or if it's much hotter
+ * than other ranges, return true if the range was split. Splitting is done by making slices of the runs used
  * by the original range, adding them to new ranges, and reflecting
  * the change in the metadata log, i.e. it doesn't involve heavy
  * operations, like writing a run file, and is done immediately.
@@ -166,6 +166,8 @@ struct vy_mem {
 	size_t tree_extent_size;
 	/** Number of statements. */
 	struct vy_stmt_counter count;
+	/** Committed statements by type. */
+	struct vy_stmt_stat stmt_stat;
 	/**
 	 * Max LSN covered by this in-memory tree.
 	 *
@@ -191,6 +191,43 @@ vy_point_lookup_scan_slices(struct vy_lsm *lsm, const struct vy_read_view **rv,
 	return rc;
 }
 
+/**
+ * If a lookup had to apply a long series of UPSERTs, schedule
+ * squashing of the key so that subsequent reads don't replay
+ * the series again. Only a series ending with a committed
+ * statement in memory is squashed, as vy_squash_process()
+ * inserts the result into the active in-memory tree.
+ *
+ * Squashing is triggered by VY_UPSERT_THRESHOLD successive
+ * UPSERTs on write as well, so we skip the key if it is about
+ * to be squashed anyway. To avoid scheduling the same key
+ * again, the newest UPSERT is marked with VY_UPSERT_INF, which
+ * is the n_upserts value of statements being squashed.
+ */
+static void
+vy_point_lookup_squash_upserts(struct vy_lsm *lsm, struct vy_history *history,
+			       int upserts_applied)
+{
+	if (upserts_applied < VY_UPSERT_READ_THRESHOLD ||
+	    lsm->index_id != 0 || lsm->env->upsert_thresh_cb == NULL)
+		return;
+	struct vy_history_node *node = rlist_first_entry(&history->stmts,
+					struct vy_history_node, link);
+	struct tuple *stmt = node->stmt;
+	if (node->is_refable || vy_stmt_type(stmt) != IPROTO_UPSERT ||
+	    vy_stmt_lsn(stmt) >= MAX_LSN ||
+	    vy_stmt_n_upserts(stmt) >= VY_UPSERT_THRESHOLD)
+		return;
+	struct tuple *dup = vy_stmt_dup(stmt);
+	if (dup == NULL) {
+		/* The optimization is good, but not necessary. */
+		return;
+	}
+	vy_stmt_set_n_upserts(stmt, VY_UPSERT_INF);
+	lsm->env->upsert_thresh_cb(lsm, dup, lsm->env->upsert_thresh_arg);
+	tuple_unref(dup);
+}
+
 int
 vy_point_lookup(struct vy_lsm *lsm, struct vy_tx *tx,
 		const struct vy_read_view **rv,
@@ -276,6 +313,9 @@ done:
 		rc = vy_history_apply(&history, lsm->cmp_def, lsm->mem_format,
 				      false, &upserts_applied, ret);
 		lsm->stat.upsert.applied += upserts_applied;
+		if (rc == 0)
+			vy_point_lookup_squash_upserts(lsm, &history,
+						       upserts_applied);
 	}
 	vy_history_cleanup(&history);
 
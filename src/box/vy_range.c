@@ -265,6 +265,81 @@ vy_range_remove_slice(struct vy_range *range, struct vy_slice *slice)
 	range->version++;
 }
 
+/**
+ * Size-tiered compaction: runs in a range are divided into groups
+ * called tiers, newer runs first:
+ *
+ *   tier 1: runs 1 .. T_1
+ *   tier 2: runs T_1 + 1 .. T_2
+ *   ...
+ *
+ * A tier is started by the newest run not fitting in the previous
+ * tier and includes all following runs that are at most
+ * run_size_ratio times larger than that run. When the number of
+ * runs in a tier exceeds run_count_per_level, we compact all its
+ * runs along with all runs from the upper tiers, just like the
+ * leveled strategy does. Unlike the leveled strategy, there's no
+ * limit on the number of runs in the last tier, so the biggest
+ * runs are only rewritten when enough similar-sized runs pile up
+ * next to them. This trades space amplification for lower write
+ * amplification, which pays off for append-mostly workloads.
+ */
+static void
+vy_range_update_compaction_priority_tiered(struct vy_range *range,
+					   const struct index_opts *opts)
+{
+	/* Total number of statements in checked runs. */
+	struct vy_disk_stmt_counter total_stmt_count;
+	vy_disk_stmt_counter_reset(&total_stmt_count);
+	/* Total number of checked runs. */
+	uint32_t total_run_count = 0;
+	/* Estimated size of a compacted run, if compaction is scheduled. */
+	uint64_t est_new_run_size = 0;
+	/* The number of runs in the current tier. */
+	uint32_t tier_run_count = 0;
+	/* The max size of a run that fits in the current tier. */
+	uint64_t tier_max_run_size = 0;
+
+	struct vy_slice *slice;
+	rlist_foreach_entry(slice, &range->slices, in_range) {
+		uint64_t size = slice->count.bytes;
+		total_run_count++;
+		vy_disk_stmt_counter_add(&total_stmt_count, &slice->count);
+		if (tier_run_count == 0 || size > tier_max_run_size) {
+			/*
+			 * The run is too big for the current tier.
+			 * Start a new one. If the run produced by
+			 * an already scheduled compaction would fall
+			 * in this tier, count it right away to avoid
+			 * a cascading compaction.
+			 */
+			tier_run_count = 1;
+			uint64_t tier_min_run_size = size;
+			if (est_new_run_size > 0 &&
+			    size <= est_new_run_size * opts->run_size_ratio) {
+				tier_run_count++;
+				tier_min_run_size = MIN(size, est_new_run_size);
+			}
+			tier_max_run_size = MAX(tier_min_run_size, 1) *
+					    opts->run_size_ratio;
+		} else {
+			tier_run_count++;
+		}
+		/*
+		 * Randomize compaction pace among ranges,
+		 * see vy_range_update_compaction_priority().
+		 */
+		uint32_t max_run_count = opts->run_count_per_level;
+		if (slice->seed < RAND_MAX / 10)
+			max_run_count++;
+		if (tier_run_count > max_run_count) {
+			range->compaction_priority = total_run_count;
+			range->compaction_queue = total_stmt_count;
+			est_new_run_size = total_stmt_count.bytes;
+		}
+	}
+}
+
 /**
  * To reduce write amplification caused by compaction, we follow
  * the LSM tree design. Runs in each range are divided into groups
@@ -287,6 +362,10 @@ vy_range_remove_slice(struct vy_range *range, struct vy_slice *slice)
  * Given a range, this function computes the maximal level that needs
  * to be compacted and sets @compaction_priority to the number of runs
  * in this level and all preceding levels.
+ *
+ * This is the default, leveled, strategy. If the index is configured
+ * to use the tiered strategy, the priority is computed by
+ * vy_range_update_compaction_priority_tiered().
  */
 void
 vy_range_update_compaction_priority(struct vy_range *range,
@@ -310,6 +389,11 @@ vy_range_update_compaction_priority(struct vy_range *range,
 		return;
 	}
 
+	if (opts->compaction_strategy == INDEX_COMPACTION_STRATEGY_TIERED) {
+		vy_range_update_compaction_priority_tiered(range, opts);
+		return;
+	}
+
 	/* Total number of statements in checked runs. */
 	struct vy_disk_stmt_counter total_stmt_count;
 	vy_disk_stmt_counter_reset(&total_stmt_count);
@@ -453,10 +537,14 @@ vy_range_update_dumps_per_compaction(struct vy_range *range)
  * - We should split around the last run middle key.
  * - We should only split if the last run size is greater than
  *   4/3 * range_size.
+ * - A hot range, i.e. one with access load >= hot_load, is split
+ *   as soon as its last run is greater than 1/4 * range_size so
+ *   that its dumps and compactions stay small and don't compete
+ *   with those of cold data. 0 disables load-based split.
  */
 bool
 vy_range_needs_split(struct vy_range *range, int64_t range_size,
-		     const char **p_split_key)
+		     uint64_t hot_load, const char **p_split_key)
 {
 	struct vy_slice *slice;
 
@@ -469,7 +557,9 @@ vy_range_needs_split(struct vy_range *range, int64_t range_size,
 	slice = rlist_last_entry(&range->slices, struct vy_slice, in_range);
 
 	/* The range is too small to be split. */
-	if (slice->count.bytes < range_size * 4 / 3)
+	bool is_hot = hot_load > 0 && vy_range_load(range) >= hot_load;
+	if (slice->count.bytes < (is_hot ? range_size / 4 :
+					   range_size * 4 / 3))
 		return false;
 
 	/* Find the median key in the oldest run (approximately). */
@@ -480,6 +570,10 @@ vy_range_needs_split(struct vy_range *range, int64_t range_size,
 
 	struct vy_page_info *first_page = vy_run_page_info(slice->run,
 						slice->first_page_no);
+	if (mid_page == NULL || first_page == NULL) {
+		diag_log();
+		return false;
+	}
 
 	/* No point in splitting if a new range is going to be empty. */
 	if (key_compare(first_page->min_key, mid_page->min_key,
@@ -522,11 +616,14 @@ vy_range_needs_split(struct vy_range *range, int64_t range_size,
  *
  * We coalesce ranges together when they become too small, less than
  * half the target range size to avoid split-coalesce oscillations.
+ * Hot ranges, i.e. those with access load >= hot_load, are never
+ * coalesced, because they may have been split due to the load,
+ * see vy_range_needs_split(). 0 disables the check.
  */
 bool
 vy_range_needs_coalesce(struct vy_range *range, vy_range_tree_t *tree,
-			int64_t range_size, struct vy_range **p_first,
-			struct vy_range **p_last)
+			int64_t range_size, uint64_t hot_load,
+			struct vy_range **p_first, struct vy_range **p_last)
 {
 	struct vy_range *it;
 
@@ -543,9 +640,13 @@ vy_range_needs_coalesce(struct vy_range *range, vy_range_tree_t *tree,
 	assert(!vy_range_is_scheduled(range));
 
 	*p_first = *p_last = range;
+	if (hot_load > 0 && vy_range_load(range) >= hot_load)
+		return false;
 	for (it = vy_range_tree_next(tree, range);
 	     it != NULL && !vy_range_is_scheduled(it);
 	     it = vy_range_tree_next(tree, it)) {
+		if (hot_load > 0 && vy_range_load(it) >= hot_load)
+			break;
 		uint64_t size = it->count.bytes;
 		if (total_size + size > max_size)
 			break;
@@ -555,6 +656,8 @@ vy_range_needs_coalesce(struct vy_range *range, vy_range_tree_t *tree,
 	for (it = vy_range_tree_prev(tree, range);
 	     it != NULL && !vy_range_is_scheduled(it);
 	     it = vy_range_tree_prev(tree, it)) {
+		if (hot_load > 0 && vy_range_load(it) >= hot_load)
+			break;
 		uint64_t size = it->count.bytes;
 		if (total_size + size > max_size)
 			break;
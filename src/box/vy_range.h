@@ -124,6 +124,16 @@ struct vy_range {
 	 * this range, see vy_run::dump_count for more details.
 	 */
 	int dumps_per_compaction;
+	/**
+	 * Access load of the range: the number of disk lookups
+	 * done in it and the number of statements dumped to it.
+	 * The counters are halved on each dump of the LSM tree
+	 * so that they reflect recent load, see
+	 * vy_lsm_decay_range_load(). Used to split hot ranges
+	 * and to avoid coalescing them.
+	 */
+	uint64_t read_load;
+	uint64_t write_load;
 	/** Link in vy_lsm->tree. */
 	rb_node(struct vy_range) tree_node;
 	/** Link in vy_lsm->range_heap. */
@@ -159,6 +169,13 @@ vy_range_is_scheduled(struct vy_range *range)
 	return range->heap_node.pos == UINT32_MAX;
 }
 
+/** Return the total access load of a range. */
+static inline uint64_t
+vy_range_load(const struct vy_range *range)
+{
+	return range->read_load + range->write_load;
+}
+
 /**
  * Search tree of all ranges of the same LSM tree, sorted by
  * vy_range->begin. Ranges in a tree are supposed to span
@@ -258,13 +275,14 @@ vy_range_update_dumps_per_compaction(struct vy_range *range);
  *
  * @param range             The range.
  * @param range_size        Target range size.
+ * @param hot_load          Min load of a hot range or 0.
  * @param[out] p_split_key  Key to split the range by.
  *
  * @retval true             If the range needs to be split.
  */
 bool
 vy_range_needs_split(struct vy_range *range, int64_t range_size,
-		     const char **p_split_key);
+		     uint64_t hot_load, const char **p_split_key);
 
 /**
  * Check if a range needs to be coalesced with adjacent
@@ -273,6 +291,7 @@ vy_range_needs_split(struct vy_range *range, int64_t range_size,
  * @param range         The range.
  * @param tree          The range tree.
  * @param range_size    Target range size.
+ * @param hot_load      Min load of a hot range or 0.
  * @param[out] p_first  The first range in the tree to coalesce.
  * @param[out] p_last   The last range in the tree to coalesce.
  *
@@ -280,8 +299,8 @@ vy_range_needs_split(struct vy_range *range, int64_t range_size,
  */
 bool
 vy_range_needs_coalesce(struct vy_range *range, vy_range_tree_t *tree,
-			int64_t range_size, struct vy_range **p_first,
-			struct vy_range **p_last);
+			int64_t range_size, uint64_t hot_load,
+			struct vy_range **p_first, struct vy_range **p_last);
 
 #if defined(__cplusplus)
 } /* extern "C" */
@@ -611,12 +611,25 @@ vy_read_iterator_add_disk(struct vy_read_iterator *itr)
 					    itr->iterator_type : ITER_LE);
 	struct vy_lsm *lsm = itr->lsm;
 	struct vy_slice *slice;
+	vy_lsm_acct_range_load(lsm, itr->curr_range, 1, 0);
 	/*
 	 * The format of the statement must be exactly the space
 	 * format with the same identifier to fully match the
 	 * format in vy_mem.
 	 */
 	rlist_foreach_entry(slice, &itr->curr_range->slices, in_range) {
+		/*
+		 * Run iterators substitute ITER_LE for ITER_REQ
+		 * and so can't use bloom filters. Check the filter
+		 * here to skip runs that have no statements equal
+		 * to the key.
+		 */
+		if (itr->iterator_type == ITER_REQ &&
+		    !vy_run_maybe_has_key(slice->run, itr->key,
+					  lsm->key_def)) {
+			lsm->stat.disk.iterator.bloom_hit++;
+			continue;
+		}
 		struct vy_read_src *sub_src = vy_read_iterator_add_src(itr);
 		vy_run_iterator_open(&sub_src->run_iterator,
 				     &lsm->stat.disk.iterator, slice,
@@ -901,7 +914,7 @@ next_key:
 void
 vy_read_iterator_cache_add(struct vy_read_iterator *itr, struct tuple *stmt)
 {
-	if ((**itr->read_view).vlsn != INT64_MAX) {
+	if ((**itr->read_view).vlsn != INT64_MAX || itr->no_cache_fill) {
 		if (itr->last_cached_stmt != NULL)
 			tuple_unref(itr->last_cached_stmt);
 		itr->last_cached_stmt = NULL;
@@ -916,6 +929,14 @@ vy_read_iterator_cache_add(struct vy_read_iterator *itr, struct tuple *stmt)
 	itr->last_cached_stmt = stmt;
 }
 
+void
+vy_read_iterator_cache_break(struct vy_read_iterator *itr)
+{
+	if (itr->last_cached_stmt != NULL)
+		tuple_unref(itr->last_cached_stmt);
+	itr->last_cached_stmt = NULL;
+}
+
 /**
  * Close the iterator and free resources
  */
@@ -69,6 +69,12 @@ struct vy_read_iterator {
 	 * vy_read_iterator_cache_add().
 	 */
 	struct tuple *last_cached_stmt;
+	/**
+	 * Set if vy_read_iterator_cache_add() should not add
+	 * statements to the tuple cache, e.g. for a one-off
+	 * scan that would otherwise evict the working set.
+	 */
+	bool no_cache_fill;
 	/**
 	 * Copy of lsm->range_tree_version.
 	 * Used for detecting range tree changes.
@@ -161,10 +167,21 @@ vy_read_iterator_next(struct vy_read_iterator *itr, struct tuple **result);
  *   to the partial tuple returned by the iterator.
  * - Call vy_read_iterator_cache_add() on the full tuple to add
  *   the result to the cache.
+ *
+ * Does nothing if vy_read_iterator::no_cache_fill is set.
  */
 void
 vy_read_iterator_cache_add(struct vy_read_iterator *itr, struct tuple *stmt);
 
+/**
+ * Forget the last tuple added to the cache. Must be called if
+ * a tuple returned by the iterator is skipped without adding
+ * it to the cache, so that the next added tuple isn't linked
+ * to the previous one as if there were nothing in between.
+ */
+void
+vy_read_iterator_cache_break(struct vy_read_iterator *itr);
+
 /**
  * Close the iterator and free resources.
  */
@@ -37,9 +37,21 @@
 
 #include "trivia/util.h"
 #include "tuple.h"
+#include "tuple_hash.h"
 #include "vy_lsm.h"
 #include "vy_stmt.h"
 
+#define MH_SOURCE 1
+#define mh_name _vy_read_point
+#define mh_key_t uint32_t
+#define mh_node_t struct vy_read_interval *
+#define mh_arg_t void *
+#define mh_hash(a, arg) ((*(a))->point_hash)
+#define mh_hash_key(a, arg) (a)
+#define mh_cmp(a, b, arg) ((*(a))->point_hash != (*(b))->point_hash)
+#define mh_cmp_key(a, b, arg) ((a) != (*(b))->point_hash)
+#include "salad/mhash.h"
+
 int
 vy_read_interval_cmpl(const struct vy_read_interval *a,
 		      const struct vy_read_interval *b)
@@ -112,15 +124,175 @@ vy_read_interval_should_merge(const struct vy_read_interval *l,
 		return l_parts >= r_parts;
 }
 
+void
+vy_read_point_set_destroy(struct vy_read_point_set *set)
+{
+	if (set->hash != NULL) {
+		assert(mh_size(set->hash) == 0);
+		mh_vy_read_point_delete(set->hash);
+	}
+}
+
+bool
+vy_read_point_set_empty(struct vy_read_point_set *set)
+{
+	return set->hash == NULL || mh_size(set->hash) == 0;
+}
+
+/**
+ * Return true if point reads of an LSM tree can be stored in
+ * the hash. Hashes of multikey indexes can't be computed from
+ * a tuple while hashes of nullable keys may differ for a tuple
+ * and a key if the tuple lacks optional fields.
+ */
+static inline bool
+vy_lsm_can_hash_reads(struct vy_lsm *lsm)
+{
+	return !lsm->cmp_def->is_multikey && !lsm->cmp_def->is_nullable;
+}
+
+/** Return the hash of a full key, given as a tuple or a key. */
+static inline uint32_t
+vy_read_point_hash(const struct tuple *stmt, struct key_def *cmp_def)
+{
+	if (vy_stmt_type(stmt) != IPROTO_SELECT)
+		return tuple_hash(stmt, cmp_def);
+	const char *key = tuple_data(stmt);
+	mp_decode_array(&key);
+	return key_hash(key, cmp_def);
+}
+
+/** Add a point read to the hash, return -1 on OOM. */
+static int
+vy_read_point_set_insert(struct vy_read_point_set *set,
+			 struct vy_read_interval *interval)
+{
+	if (set->hash == NULL) {
+		set->hash = mh_vy_read_point_new();
+		if (set->hash == NULL)
+			return -1;
+	}
+	rlist_create(&interval->in_point);
+	mh_int_t k = mh_vy_read_point_find(set->hash, interval->point_hash,
+					   NULL);
+	if (k != mh_end(set->hash)) {
+		struct vy_read_interval *first;
+		first = *mh_vy_read_point_node(set->hash, k);
+		rlist_add_tail(&first->in_point, &interval->in_point);
+		return 0;
+	}
+	if (mh_vy_read_point_put(set->hash, &interval, NULL,
+				 NULL) == mh_end(set->hash))
+		return -1;
+	return 0;
+}
+
+static void
+vy_read_point_set_remove(struct vy_read_point_set *set,
+			 struct vy_read_interval *interval)
+{
+	mh_int_t k = mh_vy_read_point_find(set->hash, interval->point_hash,
+					   NULL);
+	assert(k != mh_end(set->hash));
+	struct vy_read_interval **first = mh_vy_read_point_node(set->hash, k);
+	if (*first == interval) {
+		if (rlist_empty(&interval->in_point)) {
+			mh_vy_read_point_del(set->hash, k, NULL);
+			return;
+		}
+		*first = rlist_next_entry(interval, in_point);
+	}
+	rlist_del(&interval->in_point);
+}
+
+void
+vy_read_interval_link(struct vy_read_interval *interval)
+{
+	struct vy_lsm *lsm = interval->lsm;
+	struct key_def *cmp_def = lsm->cmp_def;
+	interval->is_point = false;
+	if (interval->left == interval->right &&
+	    interval->left_belongs && interval->right_belongs &&
+	    tuple_field_count(interval->left) >= cmp_def->part_count &&
+	    vy_lsm_can_hash_reads(lsm)) {
+		interval->point_hash = vy_read_point_hash(interval->left,
+							  cmp_def);
+		/* Fall back on the interval tree on OOM. */
+		if (vy_read_point_set_insert(&lsm->point_read_set,
+					     interval) == 0) {
+			interval->is_point = true;
+			return;
+		}
+	}
+	vy_lsm_read_set_insert(&lsm->read_set, interval);
+}
+
+void
+vy_read_interval_unlink(struct vy_read_interval *interval)
+{
+	struct vy_lsm *lsm = interval->lsm;
+	if (interval->is_point)
+		vy_read_point_set_remove(&lsm->point_read_set, interval);
+	else
+		vy_lsm_read_set_remove(&lsm->read_set, interval);
+}
+
+void
+vy_tx_conflict_iterator_init(struct vy_tx_conflict_iterator *it,
+			     struct vy_lsm *lsm, const struct tuple *stmt)
+{
+	it->stmt = stmt;
+	it->lsm = lsm;
+	it->point_first = NULL;
+	struct vy_read_point_set *point_set = &lsm->point_read_set;
+	if (!vy_read_point_set_empty(point_set)) {
+		uint32_t hash = vy_read_point_hash(stmt, lsm->cmp_def);
+		mh_int_t k = mh_vy_read_point_find(point_set->hash,
+						   hash, NULL);
+		if (k != mh_end(point_set->hash)) {
+			it->point_first = *mh_vy_read_point_node(
+						point_set->hash, k);
+		}
+	}
+	it->point_next = it->point_first;
+	vy_lsm_read_set_walk_init(&it->tree_walk, &lsm->read_set);
+	it->tree_dir = 0;
+	it->point_count = 0;
+	it->interval_count = 0;
+}
+
+/** Return the next transaction that read the statement key or NULL. */
+static struct vy_tx *
+vy_tx_conflict_iterator_next_point(struct vy_tx_conflict_iterator *it)
+{
+	struct key_def *cmp_def = it->lsm->cmp_def;
+	while (it->point_next != NULL) {
+		struct vy_read_interval *curr = it->point_next;
+		it->point_next = rlist_next_entry(curr, in_point);
+		if (it->point_next == it->point_first)
+			it->point_next = NULL;
+		it->point_count++;
+		if (vy_stmt_compare(it->stmt, curr->left, cmp_def) == 0)
+			return curr->tx;
+	}
+	return NULL;
+}
+
 struct vy_tx *
 vy_tx_conflict_iterator_next(struct vy_tx_conflict_iterator *it)
 {
+	struct vy_tx *tx = vy_tx_conflict_iterator_next_point(it);
+	if (tx != NULL)
+		return tx;
+
 	struct vy_read_interval *curr, *left, *right;
 	while ((curr = vy_lsm_read_set_walk_next(&it->tree_walk, it->tree_dir,
 						 &left, &right)) != NULL) {
 		struct key_def *cmp_def = curr->lsm->cmp_def;
 		const struct vy_read_interval *last = curr->subtree_last;
 
+		it->interval_count++;
+
 		assert(left == NULL || left->lsm == curr->lsm);
 		assert(right == NULL || right->lsm == curr->lsm);
 
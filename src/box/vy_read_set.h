@@ -38,6 +38,7 @@
 
 #define RB_COMPACT 1
 #include <small/rb.h>
+#include <small/rlist.h>
 
 #include "salad/stailq.h"
 #include "trivia/util.h"
@@ -49,6 +50,7 @@ extern "C" {
 struct tuple;
 struct vy_tx;
 struct vy_lsm;
+struct mh_vy_read_point_t;
 
 /**
  * A tuple interval read by a transaction.
@@ -66,6 +68,19 @@ struct vy_read_interval {
 	bool left_belongs;
 	/** Set if the right boundary belongs to the interval. */
 	bool right_belongs;
+	/**
+	 * Set if the interval is a read of one full key, in which
+	 * case it is stored in vy_lsm->point_read_set rather than
+	 * in vy_lsm->read_set.
+	 */
+	bool is_point;
+	/** Hash of the key of a point read. */
+	uint32_t point_hash;
+	/**
+	 * Link in the ring of point reads with the same key
+	 * hash, see vy_read_point_set.
+	 */
+	struct rlist in_point;
 	/**
 	 * The interval with the max right boundary over
 	 * all nodes in the subtree rooted at this node.
@@ -182,12 +197,59 @@ rb_gen_aug(MAYBE_UNUSED static inline, vy_lsm_read_set_, vy_lsm_read_set_t,
 	   struct vy_read_interval, in_lsm, vy_lsm_read_set_cmp,
 	   vy_lsm_read_set_aug);
 
+/**
+ * Hash that contains point reads done from an LSM tree by all
+ * active transactions, i.e. intervals consisting of one full key.
+ * Checking a write against it takes one hash lookup rather than
+ * an interval tree walk, and keeps the interval tree, which then
+ * only stores range reads, small. Maps a key hash to a ring of
+ * intervals linked by vy_read_interval->in_point.
+ */
+struct vy_read_point_set {
+	/** Hash table, created on the first insertion. */
+	struct mh_vy_read_point_t *hash;
+};
+
+static inline void
+vy_read_point_set_create(struct vy_read_point_set *set)
+{
+	set->hash = NULL;
+}
+
+void
+vy_read_point_set_destroy(struct vy_read_point_set *set);
+
+/** Return true if the set contains no reads. */
+bool
+vy_read_point_set_empty(struct vy_read_point_set *set);
+
+/**
+ * Add an interval to the read set of the LSM tree it was
+ * read from, i.e. either to the point read hash or to the
+ * interval tree.
+ */
+void
+vy_read_interval_link(struct vy_read_interval *interval);
+
+/** Remove an interval from the read set of its LSM tree. */
+void
+vy_read_interval_unlink(struct vy_read_interval *interval);
+
 /**
  * Iterator over transactions that conflict with a statement.
  */
 struct vy_tx_conflict_iterator {
 	/** The statement. */
 	const struct tuple *stmt;
+	/** LSM tree the statement is written to. */
+	struct vy_lsm *lsm;
+	/**
+	 * The first point read with the same key hash as the
+	 * statement or NULL.
+	 */
+	struct vy_read_interval *point_first;
+	/** The next point read to check or NULL. */
+	struct vy_read_interval *point_next;
 	/**
 	 * Iterator over the interval tree checked
 	 * for intersections with the statement.
@@ -198,17 +260,15 @@ struct vy_tx_conflict_iterator {
 	 * next iteration.
 	 */
 	int tree_dir;
+	/** Number of point reads compared with the statement. */
+	int64_t point_count;
+	/** Number of interval tree nodes visited. */
+	int64_t interval_count;
 };
 
-static inline void
+void
 vy_tx_conflict_iterator_init(struct vy_tx_conflict_iterator *it,
-			     vy_lsm_read_set_t *read_set,
-			     const struct tuple *stmt)
-{
-	vy_lsm_read_set_walk_init(&it->tree_walk, read_set);
-	it->tree_dir = 0;
-	it->stmt = stmt;
-}
+			     struct vy_lsm *lsm, const struct tuple *stmt);
 
 /**
  * Return the next conflicting transaction or NULL.
@@ -39,6 +39,7 @@
 
 #include "fiber.h"
 #include "histogram.h"
+#include "latency.h"
 #include "say.h"
 #include "trivia/util.h"
 
@@ -83,6 +84,18 @@ static const size_t VY_DUMP_SIZE_ACCT_MIN = 1024 * 1024;
  */
 static const int VY_RECENT_DUMP_COUNT = 100;
 
+/**
+ * Percentile of disk read latency that is compared against
+ * box.cfg.vinyl_read_latency_budget.
+ */
+static const int VY_READ_LATENCY_PCT = 99;
+
+/**
+ * Compaction is never throttled below this rate so that
+ * it still makes progress while reads are slow.
+ */
+static const size_t VY_COMPACTION_RATE_LIMIT_MIN = 1024 * 1024;
+
 static void
 vy_regulator_trigger_dump(struct vy_regulator *regulator)
 {
@@ -164,6 +177,57 @@ vy_regulator_update_dump_watermark(struct vy_regulator *regulator)
 			(regulator->dump_bandwidth + regulator->write_rate + 1);
 }
 
+static void
+vy_regulator_set_compaction_rate_limit(struct vy_regulator *regulator,
+				       size_t limit)
+{
+	if (regulator->compaction_rate_limit == limit)
+		return;
+	regulator->compaction_rate_limit = limit;
+	regulator->set_compaction_rate_limit_cb(regulator, limit);
+}
+
+/*
+ * Compaction competes with reads for disk bandwidth so a burst
+ * of compaction can make select latency skyrocket. To prevent
+ * that, we observe the 99th percentile of disk read latency over
+ * each timer period and adjust the compaction rate limit: if the
+ * latency exceeds the configured budget, the limit is halved
+ * (starting from the dump bandwidth, which is our estimate of
+ * the disk write bandwidth); otherwise it's gradually raised by
+ * one eighth per period until it exceeds twice the dump bandwidth,
+ * at which point the limit is lifted. Dumps are never throttled, because they free
+ * memory and so throttling them would only stall transactions.
+ *
+ * Note, throttled compaction takes longer so the transaction rate
+ * limit, which is derived from compaction speed, see
+ * vy_regulator_update_rate_limit(), goes down accordingly.
+ */
+static void
+vy_regulator_update_compaction_rate_limit(struct vy_regulator *regulator)
+{
+	regulator->read_latency_p99 = latency_get(regulator->read_latency,
+						  VY_READ_LATENCY_PCT);
+	latency_reset(regulator->read_latency);
+
+	if (regulator->read_latency_budget <= 0) {
+		vy_regulator_set_compaction_rate_limit(regulator, 0);
+		return;
+	}
+
+	size_t limit = regulator->compaction_rate_limit;
+	if (regulator->read_latency_p99 > regulator->read_latency_budget) {
+		if (limit == 0)
+			limit = regulator->dump_bandwidth;
+		limit = MAX(limit / 2, VY_COMPACTION_RATE_LIMIT_MIN);
+	} else if (limit != 0) {
+		limit += limit / 8;
+		if (limit > 2 * regulator->dump_bandwidth)
+			limit = 0;
+	}
+	vy_regulator_set_compaction_rate_limit(regulator, limit);
+}
+
 static void
 vy_regulator_timer_cb(ev_loop *loop, ev_timer *timer, int events)
 {
@@ -175,11 +239,14 @@ vy_regulator_timer_cb(ev_loop *loop, ev_timer *timer, int events)
 	vy_regulator_update_write_rate(regulator);
 	vy_regulator_update_dump_watermark(regulator);
 	vy_regulator_check_dump_watermark(regulator);
+	vy_regulator_update_compaction_rate_limit(regulator);
 }
 
 void
 vy_regulator_create(struct vy_regulator *regulator, struct vy_quota *quota,
-		    vy_trigger_dump_f trigger_dump_cb)
+		    struct latency *read_latency,
+		    vy_trigger_dump_f trigger_dump_cb,
+		    vy_set_compaction_rate_limit_f set_compaction_rate_limit_cb)
 {
 	enum { KB = 1024, MB = KB * KB };
 	static int64_t dump_bandwidth_buckets[] = {
@@ -199,7 +266,9 @@ vy_regulator_create(struct vy_regulator *regulator, struct vy_quota *quota,
 		panic("failed to allocate dump bandwidth histogram");
 
 	regulator->quota = quota;
+	regulator->read_latency = read_latency;
 	regulator->trigger_dump_cb = trigger_dump_cb;
+	regulator->set_compaction_rate_limit_cb = set_compaction_rate_limit_cb;
 	ev_timer_init(&regulator->timer, vy_regulator_timer_cb, 0,
 		      VY_REGULATOR_TIMER_PERIOD);
 	regulator->timer.data = regulator;
@@ -278,6 +347,15 @@ vy_regulator_reset_dump_bandwidth(struct vy_regulator *regulator, size_t max)
 				regulator->dump_bandwidth);
 }
 
+void
+vy_regulator_set_read_latency_budget(struct vy_regulator *regulator,
+				     double budget)
+{
+	regulator->read_latency_budget = budget;
+	if (budget <= 0)
+		vy_regulator_set_compaction_rate_limit(regulator, 0);
+}
+
 void
 vy_regulator_reset_stat(struct vy_regulator *regulator)
 {
@@ -42,12 +42,17 @@ extern "C" {
 #endif /* defined(__cplusplus) */
 
 struct histogram;
+struct latency;
 struct vy_quota;
 struct vy_regulator;
 
 typedef int
 (*vy_trigger_dump_f)(struct vy_regulator *regulator);
 
+typedef void
+(*vy_set_compaction_rate_limit_f)(struct vy_regulator *regulator,
+				  size_t limit);
+
 /**
  * The regulator is supposed to keep track of vinyl memory usage
  * and dump/compaction progress and adjust transaction write rate
@@ -65,6 +70,12 @@ struct vy_regulator {
 	 * memory dump and return 0 on success, -1 on failure.
 	 */
 	vy_trigger_dump_f trigger_dump_cb;
+	/**
+	 * Called when the regulator changes the compaction rate
+	 * limit. Supposed to apply the new limit to compaction
+	 * tasks. 0 means that compaction isn't throttled.
+	 */
+	vy_set_compaction_rate_limit_f set_compaction_rate_limit_cb;
 	/**
 	 * Periodic timer that updates the memory watermark
 	 * basing on accumulated statistics.
@@ -119,11 +130,36 @@ struct vy_regulator {
 	 * Used for calculating the rate limit.
 	 */
 	struct vy_scheduler_stat sched_stat_recent;
+	/**
+	 * Latency of disk reads, collected by run iterators.
+	 * The regulator resets it on each timer tick so that
+	 * it only accounts reads done in the last period.
+	 */
+	struct latency *read_latency;
+	/**
+	 * 99th percentile of disk read latency over the last
+	 * timer period, in seconds.
+	 */
+	double read_latency_p99;
+	/**
+	 * Target 99th percentile of disk read latency, in seconds.
+	 * If the observed latency exceeds it, compaction is slowed
+	 * down to leave more disk bandwidth to reads. 0 disables
+	 * compaction throttling. Set by box.cfg.vinyl_read_latency_budget.
+	 */
+	double read_latency_budget;
+	/**
+	 * Max rate at which compaction may write to disk, in bytes
+	 * per second, or 0 if compaction isn't throttled.
+	 */
+	size_t compaction_rate_limit;
 };
 
 void
 vy_regulator_create(struct vy_regulator *regulator, struct vy_quota *quota,
-		    vy_trigger_dump_f trigger_dump_cb);
+		    struct latency *read_latency,
+		    vy_trigger_dump_f trigger_dump_cb,
+		    vy_set_compaction_rate_limit_f set_compaction_rate_limit_cb);
 
 void
 vy_regulator_start(struct vy_regulator *regulator);
@@ -158,6 +194,14 @@ vy_regulator_dump_complete(struct vy_regulator *regulator,
 void
 vy_regulator_reset_dump_bandwidth(struct vy_regulator *regulator, size_t max);
 
+/**
+ * Set the target disk read latency.
+ * Called when box.cfg.vinyl_read_latency_budget is updated.
+ */
+void
+vy_regulator_set_read_latency_budget(struct vy_regulator *regulator,
+				     double budget);
+
 /**
  * Called when global statistics are reset by box.stat.reset().
  */
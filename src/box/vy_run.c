@@ -30,7 +30,10 @@
  */
 #include "vy_run.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <zstd.h>
+#include <zdict.h>
 
 #include "fiber.h"
 #include "fiber_cond.h"
@@ -38,7 +41,10 @@
 #include "cbus.h"
 #include "memory.h"
 #include "coio_file.h"
+#include "io_ring.h"
+#include "gc_remove.h"
 
+#include "probe.h"
 #include "replication.h"
 #include "tuple_bloom.h"
 #include "tuple_compare.h"
@@ -158,6 +164,15 @@ vy_run_env_stop_readers(struct vy_run_env *env)
 	free(env->reader_pool);
 }
 
+static void
+vy_page_cache_create(struct vy_page_cache *cache);
+
+static void
+vy_page_cache_destroy(struct vy_page_cache *cache);
+
+static void
+vy_page_cache_purge_run(struct vy_page_cache *cache, struct vy_run *run);
+
 /**
  * Initialize vinyl run environment
  */
@@ -169,6 +184,11 @@ vy_run_env_create(struct vy_run_env *env, int read_threads)
 	tt_pthread_key_create(&env->zdctx_key, vy_free_zdctx);
 	mempool_create(&env->read_task_pool, cord_slab_cache(),
 		       sizeof(struct vy_page_read_task));
+	vy_page_cache_create(&env->page_cache);
+	rlist_create(&env->page_index_lru);
+	rlist_create(&env->bloom_lru);
+	if (latency_create(&env->read_latency) != 0)
+		panic("failed to allocate vinyl read latency histogram");
 }
 
 /**
@@ -179,6 +199,8 @@ vy_run_env_destroy(struct vy_run_env *env)
 {
 	if (env->reader_pool != NULL)
 		vy_run_env_stop_readers(env);
+	vy_page_cache_destroy(&env->page_cache);
+	latency_destroy(&env->read_latency);
 	mempool_destroy(&env->read_task_pool);
 	tt_pthread_key_delete(env->zdctx_key);
 }
@@ -191,6 +213,13 @@ vy_run_env_enable_coio(struct vy_run_env *env)
 {
 	if (env->reader_pool != NULL)
 		return; /* already enabled */
+	/*
+	 * If tx has an io_uring instance, pages are read with
+	 * it directly from the calling fiber, see vy_page_read(),
+	 * and reader threads aren't needed.
+	 */
+	if (io_ring_is_enabled())
+		return;
 	vy_run_env_start_readers(env);
 }
 
@@ -207,6 +236,7 @@ vy_page_info_create(struct vy_page_info *page_info, uint64_t offset,
 	memset(page_info, 0, sizeof(*page_info));
 	page_info->offset = offset;
 	page_info->unpacked_size = 0;
+	page_info->version = VY_PAGE_VERSION_PLAIN;
 	page_info->min_key = vy_key_dup(min_key);
 	return page_info->min_key == NULL ? -1 : 0;
 }
@@ -219,6 +249,163 @@ vy_page_info_destroy(struct vy_page_info *page_info)
 {
 	if (page_info->min_key != NULL)
 		free(page_info->min_key);
+	free(page_info->zone_map);
+}
+
+/** Return the size of a page zone map, 0 if there's none. */
+static size_t
+vy_page_info_zone_map_size(const struct vy_page_info *page_info)
+{
+	const char *end = page_info->zone_map;
+	if (end == NULL)
+		return 0;
+	mp_next(&end);
+	return end - page_info->zone_map;
+}
+
+/** Return the memory taken by a page info. */
+static size_t
+vy_page_info_size(const struct vy_page_info *page_info)
+{
+	const char *min_key_end = page_info->min_key;
+	mp_next(&min_key_end);
+	return sizeof(*page_info) + (min_key_end - page_info->min_key) +
+	       vy_page_info_zone_map_size(page_info);
+}
+
+/**
+ * Allocate a page index block. The page infos of the block
+ * are not initialized.
+ */
+static struct vy_page_index_block *
+vy_page_index_block_new(struct vy_run *run, uint32_t block_no)
+{
+	uint32_t first_page_no = block_no * VY_PAGE_INDEX_BLOCK_SIZE;
+	assert(first_page_no < run->info.page_count);
+	uint32_t page_count = MIN(run->info.page_count - first_page_no,
+				  (uint32_t)VY_PAGE_INDEX_BLOCK_SIZE);
+	size_t size = sizeof(struct vy_page_index_block) +
+		      page_count * sizeof(struct vy_page_info);
+	struct vy_page_index_block *block = malloc(size);
+	if (block == NULL) {
+		diag_set(OutOfMemory, size, "malloc",
+			 "struct vy_page_index_block");
+		return NULL;
+	}
+	block->run = run;
+	block->block_no = block_no;
+	block->page_count = page_count;
+	block->mem = 0;
+	block->last_used = 0;
+	rlist_create(&block->in_lru);
+	return block;
+}
+
+/** Free a page index block and its page infos. */
+static void
+vy_page_index_block_delete(struct vy_page_index_block *block)
+{
+	for (uint32_t i = 0; i < block->page_count; i++)
+		vy_page_info_destroy(&block->pages[i]);
+	free(block);
+}
+
+/**
+ * Return the kind of a field value a zone map can store: MP_INT
+ * for integers, MP_STR for strings, MP_EXT for anything else.
+ */
+static inline enum mp_type
+vy_zone_map_type(const char *value)
+{
+	switch (mp_typeof(*value)) {
+	case MP_UINT:
+	case MP_INT:
+		return MP_INT;
+	case MP_STR:
+		return MP_STR;
+	default:
+		return MP_EXT;
+	}
+}
+
+/**
+ * Decode a MsgPack integer. Return true if it's negative.
+ * A negative value is cast to uint64_t, which preserves its
+ * order relative to other negative values.
+ */
+static inline bool
+vy_zone_map_decode_int(const char *data, uint64_t *value)
+{
+	if (mp_typeof(*data) == MP_UINT) {
+		*value = mp_decode_uint(&data);
+		return false;
+	}
+	int64_t v = mp_decode_int(&data);
+	*value = (uint64_t)v;
+	return v < 0;
+}
+
+/**
+ * Compare two field values of the same vy_zone_map_type().
+ * Integers are compared by value, strings byte-wise.
+ */
+static int
+vy_zone_map_value_cmp(const char *a, const char *b)
+{
+	assert(vy_zone_map_type(a) == vy_zone_map_type(b));
+	if (mp_typeof(*a) == MP_STR) {
+		uint32_t a_len, b_len;
+		a = mp_decode_str(&a, &a_len);
+		b = mp_decode_str(&b, &b_len);
+		int rc = memcmp(a, b, MIN(a_len, b_len));
+		if (rc != 0)
+			return rc;
+		return a_len < b_len ? -1 : a_len > b_len;
+	}
+	uint64_t a_val, b_val;
+	bool a_neg = vy_zone_map_decode_int(a, &a_val);
+	bool b_neg = vy_zone_map_decode_int(b, &b_val);
+	if (a_neg != b_neg)
+		return a_neg ? -1 : 1;
+	return a_val < b_val ? -1 : a_val > b_val;
+}
+
+/**
+ * Check if a page zone map shows that no statement of the page
+ * matches a filter.
+ */
+static bool
+vy_page_info_is_filtered(const struct vy_page_info *page_info,
+			 const struct vy_run_filter *filter)
+{
+	const char *pos = page_info->zone_map;
+	if (pos == NULL)
+		return false;
+	uint32_t size = mp_decode_map(&pos);
+	for (uint32_t i = 0; i < size; i++) {
+		uint32_t fieldno = mp_decode_uint(&pos);
+		if (fieldno != filter->fieldno) {
+			mp_next(&pos);
+			continue;
+		}
+		uint32_t len = mp_decode_array(&pos);
+		assert(len == 2);
+		(void)len;
+		const char *min = pos;
+		mp_next(&pos);
+		const char *max = pos;
+		enum mp_type type = vy_zone_map_type(min);
+		if (filter->min != NULL &&
+		    vy_zone_map_type(filter->min) == type &&
+		    vy_zone_map_value_cmp(max, filter->min) < 0)
+			return true;
+		if (filter->max != NULL &&
+		    vy_zone_map_type(filter->max) == type &&
+		    vy_zone_map_value_cmp(min, filter->max) > 0)
+			return true;
+		return false;
+	}
+	return false;
 }
 
 struct vy_run *
@@ -237,12 +424,15 @@ vy_run_new(struct vy_run_env *env, int64_t id)
 	run->refs = 1;
 	rlist_create(&run->in_lsm);
 	rlist_create(&run->in_unused);
+	rlist_create(&run->cached_pages);
+	rlist_create(&run->in_bloom_lru);
 	return run;
 }
 
 static void
 vy_run_clear(struct vy_run *run)
 {
+	vy_page_cache_purge_run(&run->env->page_cache, run);
 	if (run->page_info != NULL) {
 		uint32_t page_no;
 		for (page_no = 0; page_no < run->info.page_count; ++page_no)
@@ -250,16 +440,190 @@ vy_run_clear(struct vy_run *run)
 		free(run->page_info);
 	}
 	run->page_info = NULL;
+	if (run->page_index != NULL) {
+		uint32_t block_count = DIV_ROUND_UP(run->info.page_count,
+						    VY_PAGE_INDEX_BLOCK_SIZE);
+		for (uint32_t i = 0; i < block_count; i++) {
+			struct vy_page_index_fence *fence = &run->page_index[i];
+			struct vy_page_index_block *block = fence->block;
+			free(fence->min_key);
+			if (block == NULL)
+				continue;
+			if (run->is_index_cached) {
+				assert(run->env->page_index_mem >= block->mem);
+				run->env->page_index_mem -= block->mem;
+				rlist_del_entry(block, in_lru);
+			}
+			vy_page_index_block_delete(block);
+		}
+		free(run->page_index);
+	}
+	run->page_index = NULL;
 	run->page_index_size = 0;
 	run->info.page_count = 0;
 	if (run->info.bloom != NULL) {
+		if (run->is_index_cached) {
+			assert(run->env->bloom_mem >= run->bloom_size);
+			run->env->bloom_mem -= run->bloom_size;
+			rlist_del_entry(run, in_bloom_lru);
+		}
 		tuple_bloom_delete(run->info.bloom);
 		run->info.bloom = NULL;
 	}
+	run->bloom_size = 0;
+	run->is_index_cached = false;
+	free(run->index_path);
+	run->index_path = NULL;
 	free(run->info.min_key);
 	run->info.min_key = NULL;
 	free(run->info.max_key);
 	run->info.max_key = NULL;
+	for (uint32_t i = 0; i < run->info.blob_count; i++) {
+		struct vy_run_blob *blob = &run->info.blobs[i];
+		if (blob->fd >= 0 && close(blob->fd) < 0)
+			say_syserror("close failed");
+	}
+	free(run->info.blobs);
+	run->info.blobs = NULL;
+	run->info.blob_count = 0;
+	ZSTD_freeDDict(run->zddict);
+	run->zddict = NULL;
+	free(run->info.zdict);
+	run->info.zdict = NULL;
+	run->info.zdict_size = 0;
+	free(run->new_zdict);
+	run->new_zdict = NULL;
+	run->new_zdict_size = 0;
+}
+
+/**
+ * Digest the compression dictionary of a run for reading
+ * its pages.
+ */
+static int
+vy_run_load_zdict(struct vy_run *run)
+{
+	assert(run->zddict == NULL);
+	if (run->info.zdict == NULL)
+		return 0;
+	run->zddict = ZSTD_createDDict(run->info.zdict,
+				       run->info.zdict_size);
+	if (run->zddict == NULL) {
+		diag_set(ClientError, ER_DECOMPRESSION,
+			 "failed to load dictionary");
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Append an entry for a blob file linked to a run.
+ * Returns NULL on memory allocation error.
+ */
+static struct vy_run_blob *
+vy_run_add_blob(struct vy_run *run, int64_t blob_id)
+{
+	uint32_t count = run->info.blob_count + 1;
+	size_t size = count * sizeof(*run->info.blobs);
+	struct vy_run_blob *blobs = realloc(run->info.blobs, size);
+	if (blobs == NULL) {
+		diag_set(OutOfMemory, size, "realloc", "struct vy_run_blob");
+		return NULL;
+	}
+	struct vy_run_blob *blob = &blobs[count - 1];
+	blob->id = blob_id;
+	blob->run_id = run->id;
+	blob->size = 0;
+	blob->ref_bytes = 0;
+	blob->fd = -1;
+	run->info.blobs = blobs;
+	run->info.blob_count = count;
+	return blob;
+}
+
+/**
+ * Open the blob files listed in the run info.
+ */
+static int
+vy_run_open_blobs(struct vy_run *run, const char *dir,
+		  uint32_t space_id, uint32_t iid)
+{
+	char path[PATH_MAX];
+	for (uint32_t i = 0; i < run->info.blob_count; i++) {
+		struct vy_run_blob *blob = &run->info.blobs[i];
+		assert(blob->fd < 0);
+		blob->run_id = run->id;
+		vy_blob_snprint_path(path, sizeof(path), dir, space_id, iid,
+				     run->id, blob->id);
+		blob->fd = open(path, O_RDONLY);
+		if (blob->fd < 0) {
+			diag_set(SystemError, "failed to open file '%s'",
+				 path);
+			return -1;
+		}
+		struct stat st;
+		if (fstat(blob->fd, &st) < 0) {
+			diag_set(SystemError, "failed to stat file '%s'",
+				 path);
+			return -1;
+		}
+		blob->size = st.st_size;
+	}
+	return 0;
+}
+
+struct vy_run_blob *
+vy_run_blob_find(struct vy_run_blob *blobs, uint32_t blob_count,
+		 int64_t blob_id)
+{
+	for (uint32_t i = 0; i < blob_count; i++) {
+		if (blobs[i].id == blob_id)
+			return &blobs[i];
+	}
+	return NULL;
+}
+
+struct tuple *
+vy_run_blob_read(struct vy_run_blob *blobs, uint32_t blob_count,
+		 const struct tuple *stub)
+{
+	struct vy_blob_ref ref;
+	if (vy_stmt_blob_ref(stub, &ref) != 0)
+		return NULL;
+	struct vy_run_blob *blob = vy_run_blob_find(blobs, blob_count,
+						    ref.blob_id);
+	if (blob == NULL || blob->fd < 0 ||
+	    ref.offset + ref.size > blob->size) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 tt_sprintf("Invalid blob reference: %s",
+				    vy_stmt_str(stub)));
+		return NULL;
+	}
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	char *data = region_alloc(region, ref.size);
+	if (data == NULL) {
+		diag_set(OutOfMemory, ref.size, "region", "blob");
+		return NULL;
+	}
+	ssize_t readen;
+	if (io_ring_is_enabled())
+		readen = io_ring_pread(blob->fd, data, ref.size, ref.offset);
+	else if (cord_is_main())
+		readen = coio_preadn(blob->fd, data, ref.size, ref.offset);
+	else
+		readen = fio_pread(blob->fd, data, ref.size, ref.offset);
+	struct tuple *stmt = NULL;
+	if (readen < 0) {
+		diag_set(SystemError, "failed to read from file");
+	} else if (readen != (ssize_t)ref.size) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 "Unexpected end of file");
+	} else {
+		stmt = vy_stmt_new_from_blob(stub, data, data + ref.size);
+	}
+	region_truncate(region, region_svp);
+	return stmt;
 }
 
 void
@@ -276,7 +640,7 @@ vy_run_delete(struct vy_run *run)
 size_t
 vy_run_bloom_size(struct vy_run *run)
 {
-	return run->info.bloom == NULL ? 0 : tuple_bloom_size(run->info.bloom);
+	return run->bloom_size;
 }
 
 /**
@@ -294,13 +658,15 @@ vy_run_bloom_size(struct vy_run *run)
  * @param itype - iterator type (see above)
  * @param equal_key: *equal_key is set to true if there is a page
  *  with min_key equal to the given key.
- * @return offset of the page in page index OR run->info.page_count if
- *  there no pages fulfilling the conditions.
+ * @param[out] page_no offset of the page in page index OR
+ *  run->info.page_count if there no pages fulfilling the conditions.
+ * @retval 0 success
+ * @retval -1 failed to load a page index block
  */
-static uint32_t
+static int
 vy_page_index_find_page(struct vy_run *run, const struct tuple *key,
 			struct key_def *cmp_def, enum iterator_type itype,
-			bool *equal_key)
+			bool *equal_key, uint32_t *page_no)
 {
 	if (itype == ITER_EQ)
 		itype = ITER_GE; /* One day it'll become obsolete */
@@ -333,12 +699,34 @@ vy_page_index_find_page(struct vy_run *run, const struct tuple *key,
 	bool is_lower_bound = itype == ITER_LT || itype == ITER_GE;
 
 	assert(run->info.page_count > 0);
-	/* Initially the range is set with virtual positions */
-	int32_t range[2] = { -1, run->info.page_count };
-	assert(run->info.page_count > 0);
-	do {
+	/*
+	 * First do the search in the fences, which are the min
+	 * keys of the first pages of page index blocks. This
+	 * narrows the range down to pages of one block.
+	 */
+	int32_t block_count = DIV_ROUND_UP(run->info.page_count,
+					   VY_PAGE_INDEX_BLOCK_SIZE);
+	int32_t range[2] = { -1, block_count };
+	while (range[1] - range[0] > 1) {
+		int32_t mid = range[0] + (range[1] - range[0]) / 2;
+		int cmp = vy_stmt_compare_with_raw_key(key,
+				run->page_index[mid].min_key, cmp_def);
+		if (is_lower_bound)
+			range[cmp <= 0] = mid;
+		else
+			range[cmp < 0] = mid;
+		*equal_key = *equal_key || cmp == 0;
+	}
+	/* Convert block numbers to page numbers. */
+	if (range[0] >= 0)
+		range[0] *= VY_PAGE_INDEX_BLOCK_SIZE;
+	range[1] = MIN(range[1] * VY_PAGE_INDEX_BLOCK_SIZE,
+		       (int32_t)run->info.page_count);
+	while (range[1] - range[0] > 1) {
 		int32_t mid = range[0] + (range[1] - range[0]) / 2;
 		struct vy_page_info *info = vy_run_page_info(run, mid);
+		if (info == NULL)
+			return -1;
 		int cmp = vy_stmt_compare_with_raw_key(key, info->min_key,
 						       cmp_def);
 		if (is_lower_bound)
@@ -346,7 +734,7 @@ vy_page_index_find_page(struct vy_run *run, const struct tuple *key,
 		else
 			range[cmp < 0] = mid;
 		*equal_key = *equal_key || cmp == 0;
-	} while (range[1] - range[0] > 1);
+	}
 	if (range[0] < 0)
 		range[0] = run->info.page_count;
 	uint32_t page = range[dir > 0];
@@ -357,8 +745,9 @@ vy_page_index_find_page(struct vy_run *run, const struct tuple *key,
 	 *  the point where iteration must be started.
 	 */
 	if (page > 0 && dir > 0)
-		return page - 1;
-	return page;
+		page--;
+	*page_no = page;
+	return 0;
 }
 
 struct vy_slice *
@@ -394,17 +783,19 @@ vy_slice_new(int64_t id, struct vy_run *run, struct tuple *begin,
 	if (slice->begin == NULL) {
 		slice->first_page_no = 0;
 	} else {
-		slice->first_page_no =
-			vy_page_index_find_page(run, slice->begin, cmp_def,
-						ITER_GE, &unused);
+		if (vy_page_index_find_page(run, slice->begin, cmp_def,
+					    ITER_GE, &unused,
+					    &slice->first_page_no) != 0)
+			goto fail;
 		assert(slice->first_page_no < run->info.page_count);
 	}
 	if (slice->end == NULL) {
 		slice->last_page_no = run->info.page_count - 1;
 	} else {
-		slice->last_page_no =
-			vy_page_index_find_page(run, slice->end, cmp_def,
-						ITER_LT, &unused);
+		if (vy_page_index_find_page(run, slice->end, cmp_def,
+					    ITER_LT, &unused,
+					    &slice->last_page_no) != 0)
+			goto fail;
 		if (slice->last_page_no == run->info.page_count) {
 			/* It's an empty slice */
 			slice->first_page_no = 0;
@@ -424,6 +815,9 @@ vy_slice_new(int64_t id, struct vy_run *run, struct tuple *begin,
 	slice->count.bytes_compressed = DIV_ROUND_UP(
 		run->count.bytes_compressed * slice_pages, run_pages);
 	return slice;
+fail:
+	vy_slice_delete(slice);
+	return NULL;
 }
 
 void
@@ -474,6 +868,73 @@ vy_slice_cut(struct vy_slice *slice, int64_t id, struct tuple *begin,
 	return 0;
 }
 
+int
+vy_slice_estimate_rows(struct vy_slice *slice, enum iterator_type type,
+		       const struct tuple *key, struct key_def *cmp_def,
+		       double *rows)
+{
+	*rows = 0;
+	struct vy_run *run = slice->run;
+	if (run->info.page_count == 0 || slice->count.rows == 0)
+		return 0;
+	enum iterator_type lower_type = ITER_ALL;
+	enum iterator_type upper_type = ITER_ALL;
+	if (tuple_field_count(key) == 0)
+		type = ITER_ALL;
+	switch (type) {
+	case ITER_EQ:
+	case ITER_REQ:
+		lower_type = ITER_GE;
+		upper_type = ITER_LE;
+		break;
+	case ITER_GE:
+	case ITER_GT:
+		lower_type = type;
+		break;
+	case ITER_LE:
+	case ITER_LT:
+		upper_type = type;
+		break;
+	default:
+		break;
+	}
+	uint32_t first = slice->first_page_no;
+	uint32_t last = slice->last_page_no;
+	/*
+	 * A page that a bound falls into is assumed to be half
+	 * in the range.
+	 */
+	double partial = 0;
+	bool unused;
+	uint32_t page_no;
+	if (lower_type != ITER_ALL) {
+		if (vy_page_index_find_page(run, key, cmp_def, lower_type,
+					    &unused, &page_no) != 0)
+			return -1;
+		if (page_no > last)
+			return 0;
+		if (page_no >= first) {
+			first = page_no;
+			partial += 0.5;
+		}
+	}
+	if (upper_type != ITER_ALL) {
+		if (vy_page_index_find_page(run, key, cmp_def, upper_type,
+					    &unused, &page_no) != 0)
+			return -1;
+		if (page_no >= run->info.page_count || page_no < first)
+			return 0;
+		if (page_no <= last) {
+			last = page_no;
+			partial += 0.5;
+		}
+	}
+	double pages = MAX(last - first + 1 - partial, 0.5);
+	*rows = slice->count.rows * pages /
+		(slice->last_page_no - slice->first_page_no + 1);
+	return 0;
+}
+
 /**
  * Decode page information from xrow.
  *
@@ -491,6 +952,7 @@ vy_page_info_decode(struct vy_page_info *page, const struct xrow_header *xrow,
 	assert(xrow->type == VY_INDEX_PAGE_INFO);
 	const char *pos = xrow->body->iov_base;
 	memset(page, 0, sizeof(*page));
+	page->version = VY_PAGE_VERSION_PLAIN;
 	uint64_t key_map = vy_page_info_key_map;
 	uint32_t map_size = mp_decode_map(&pos);
 	uint32_t map_item;
@@ -521,6 +983,26 @@ vy_page_info_decode(struct vy_page_info *page, const struct xrow_header *xrow,
 		case VY_PAGE_INFO_ROW_INDEX_OFFSET:
 			page->row_index_offset = mp_decode_uint(&pos);
 			break;
+		case VY_PAGE_INFO_VERSION:
+			page->version = mp_decode_uint(&pos);
+			break;
+		case VY_PAGE_INFO_RESTART_INTERVAL:
+			page->restart_interval = mp_decode_uint(&pos);
+			break;
+		case VY_PAGE_INFO_ROWS_SIZE:
+			page->rows_size = mp_decode_uint(&pos);
+			break;
+		case VY_PAGE_INFO_ZONE_MAP:
+			key_beg = pos;
+			mp_next(&pos);
+			page->zone_map = malloc(pos - key_beg);
+			if (page->zone_map == NULL) {
+				diag_set(OutOfMemory, pos - key_beg,
+					 "malloc", "page zone map");
+				return -1;
+			}
+			memcpy(page->zone_map, key_beg, pos - key_beg);
+			break;
 		default:
 			mp_next(&pos); /* unknown key, ignore */
 			break;
@@ -534,6 +1016,17 @@ vy_page_info_decode(struct vy_page_info *page, const struct xrow_header *xrow,
 				    vy_page_info_key_name(key)));
 		return -1;
 	}
+	if (page->version != VY_PAGE_VERSION_PLAIN &&
+	    (page->version != VY_PAGE_VERSION_PREFIX ||
+	     page->restart_interval == 0) &&
+	    (page->version != VY_PAGE_VERSION_COLUMNAR ||
+	     page->rows_size == 0)) {
+		diag_set(ClientError, ER_INVALID_INDEX_FILE, filename,
+			 tt_sprintf("Can't decode page info: "
+				    "unsupported page version %u",
+				    (unsigned)page->version));
+		return -1;
+	}
 
 	return 0;
 }
@@ -565,6 +1058,38 @@ vy_stmt_stat_decode(struct vy_stmt_stat *stat, const char **data)
 	}
 }
 
+/**
+ * Decode the list of blob files referenced by a run.
+ * The files are opened by vy_run_open_blobs().
+ */
+static int
+vy_run_info_decode_blobs(struct vy_run_info *run_info, const char **pos)
+{
+	uint32_t count = mp_decode_array(pos);
+	if (count == 0)
+		return 0;
+	size_t size = count * sizeof(*run_info->blobs);
+	run_info->blobs = malloc(size);
+	if (run_info->blobs == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "struct vy_run_blob");
+		return -1;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		struct vy_run_blob *blob = &run_info->blobs[i];
+		uint32_t n = mp_decode_array(pos);
+		assert(n >= 2);
+		blob->id = mp_decode_uint(pos);
+		blob->ref_bytes = mp_decode_uint(pos);
+		for (uint32_t j = 2; j < n; j++)
+			mp_next(pos);
+		blob->run_id = 0;
+		blob->size = 0;
+		blob->fd = -1;
+	}
+	run_info->blob_count = count;
+	return 0;
+}
+
 /**
  * Decode the run metadata from xrow.
  *
@@ -622,13 +1147,34 @@ vy_run_info_decode(struct vy_run_info *run_info,
 				return -1;
 			break;
 		case VY_RUN_INFO_BLOOM:
-			run_info->bloom = tuple_bloom_decode(&pos);
+			run_info->bloom = tuple_bloom_decode(&pos,
+							     BLOOM_BLOCKED);
+			if (run_info->bloom == NULL)
+				return -1;
+			break;
+		case VY_RUN_INFO_BLOOM_SPLIT_BLOCK:
+			run_info->bloom = tuple_bloom_decode(&pos,
+							     BLOOM_SPLIT_BLOCK);
 			if (run_info->bloom == NULL)
 				return -1;
 			break;
 		case VY_RUN_INFO_STMT_STAT:
 			vy_stmt_stat_decode(&run_info->stmt_stat, &pos);
 			break;
+		case VY_RUN_INFO_BLOBS:
+			if (vy_run_info_decode_blobs(run_info, &pos) != 0)
+				return -1;
+			break;
+		case VY_RUN_INFO_ZSTD_DICT:
+			tmp = mp_decode_bin(&pos, &run_info->zdict_size);
+			run_info->zdict = malloc(run_info->zdict_size);
+			if (run_info->zdict == NULL) {
+				diag_set(OutOfMemory, run_info->zdict_size,
+					 "malloc", "zstd dictionary");
+				return -1;
+			}
+			memcpy(run_info->zdict, tmp, run_info->zdict_size);
+			break;
 		default:
 			mp_next(&pos); /* unknown key, ignore */
 			break;
@@ -645,56 +1191,724 @@ vy_run_info_decode(struct vy_run_info *run_info,
 	return 0;
 }
 
-static struct vy_page *
-vy_page_new(const struct vy_page_info *page_info)
+/* {{{ Page index cache */
+
+/**
+ * Decode the bloom filter from the run info stored in xrow.
+ * Sets @a bloom to NULL if the run doesn't have a bloom filter.
+ */
+static int
+vy_run_info_decode_bloom(const struct xrow_header *xrow,
+			 struct tuple_bloom **bloom)
 {
-	struct vy_page *page = malloc(sizeof(*page));
-	if (page == NULL) {
-		diag_set(OutOfMemory, sizeof(*page),
-			 "load_page", "page cache");
-		return NULL;
-	}
-	page->unpacked_size = page_info->unpacked_size;
-	page->row_count = page_info->row_count;
-	page->row_index = calloc(page_info->row_count, sizeof(uint32_t));
-	if (page->row_index == NULL) {
-		diag_set(OutOfMemory, page_info->row_count * sizeof(uint32_t),
-			 "malloc", "page->row_index");
-		free(page);
-		return NULL;
+	assert(xrow->type == VY_INDEX_RUN_INFO);
+	const char *pos = xrow->body->iov_base;
+	uint32_t map_size = mp_decode_map(&pos);
+	*bloom = NULL;
+	for (uint32_t i = 0; i < map_size; i++) {
+		uint32_t key = mp_decode_uint(&pos);
+		switch (key) {
+		case VY_RUN_INFO_BLOOM_LEGACY:
+			*bloom = tuple_bloom_decode_legacy(&pos);
+			return *bloom == NULL ? -1 : 0;
+		case VY_RUN_INFO_BLOOM:
+			*bloom = tuple_bloom_decode(&pos, BLOOM_BLOCKED);
+			return *bloom == NULL ? -1 : 0;
+		case VY_RUN_INFO_BLOOM_SPLIT_BLOCK:
+			*bloom = tuple_bloom_decode(&pos, BLOOM_SPLIT_BLOCK);
+			return *bloom == NULL ? -1 : 0;
+		default:
+			mp_next(&pos);
+			break;
+		}
 	}
+	return 0;
+}
 
-	page->data = (char *)malloc(page_info->unpacked_size);
-	if (page->data == NULL) {
-		diag_set(OutOfMemory, page_info->unpacked_size,
-			 "malloc", "page->data");
-		free(page->row_index);
-		free(page);
-		return NULL;
+/**
+ * Allocate the fences of a run page index. Block offsets are
+ * set to -1 and should be filled in by the caller.
+ */
+static int
+vy_run_alloc_page_index(struct vy_run *run)
+{
+	assert(run->page_index == NULL);
+	uint32_t block_count = DIV_ROUND_UP(run->info.page_count,
+					    VY_PAGE_INDEX_BLOCK_SIZE);
+	if (block_count == 0)
+		return 0;
+	size_t size = block_count * sizeof(*run->page_index);
+	run->page_index = calloc(block_count, sizeof(*run->page_index));
+	if (run->page_index == NULL) {
+		diag_set(OutOfMemory, size, "calloc",
+			 "struct vy_page_index_fence");
+		return -1;
 	}
-	return page;
+	for (uint32_t i = 0; i < block_count; i++)
+		run->page_index[i].offset = -1;
+	return 0;
 }
 
-static void
-vy_page_delete(struct vy_page *page)
+/**
+ * Split the page info array of a run that has just been
+ * written or loaded into page index blocks. The fences must
+ * have been allocated with vy_run_alloc_page_index().
+ */
+static int
+vy_run_build_page_index(struct vy_run *run)
 {
-	uint32_t *row_index = page->row_index;
-	char *data = page->data;
-#if !defined(NDEBUG)
-	memset(row_index, '#', sizeof(uint32_t) * page->row_count);
-	memset(data, '#', page->unpacked_size);
-	memset(page, '#', sizeof(*page));
-#endif /* !defined(NDEBUG) */
-	free(row_index);
-	free(data);
-	free(page);
+	uint32_t block_count = DIV_ROUND_UP(run->info.page_count,
+					    VY_PAGE_INDEX_BLOCK_SIZE);
+	assert(block_count == 0 || run->page_index != NULL);
+	for (uint32_t i = 0; i < block_count; i++) {
+		struct vy_page_index_fence *fence = &run->page_index[i];
+		fence->block = vy_page_index_block_new(run, i);
+		if (fence->block == NULL)
+			goto fail;
+		const char *min_key =
+			run->page_info[i * VY_PAGE_INDEX_BLOCK_SIZE].min_key;
+		fence->min_key = vy_key_dup(min_key);
+		if (fence->min_key == NULL)
+			goto fail;
+	}
+	/* Can't fail from here, move the page infos to the blocks. */
+	for (uint32_t i = 0; i < block_count; i++) {
+		struct vy_page_index_block *block = run->page_index[i].block;
+		memcpy(block->pages,
+		       run->page_info + i * VY_PAGE_INDEX_BLOCK_SIZE,
+		       block->page_count * sizeof(struct vy_page_info));
+		for (uint32_t j = 0; j < block->page_count; j++)
+			block->mem += vy_page_info_size(&block->pages[j]);
+	}
+	free(run->page_info);
+	run->page_info = NULL;
+	return 0;
+fail:
+	for (uint32_t i = 0; i < block_count; i++) {
+		struct vy_page_index_fence *fence = &run->page_index[i];
+		/* The page infos are still owned by the array. */
+		free(fence->block);
+		fence->block = NULL;
+		free(fence->min_key);
+		fence->min_key = NULL;
+	}
+	return -1;
 }
 
-static int
-vy_page_xrow(struct vy_page *page, uint32_t stmt_no,
-	     struct xrow_header *xrow)
+/**
+ * Read a page index block from the index file of a run. The
+ * block isn't added to the run page index. Doesn't touch the
+ * run environment so may be called from any thread.
+ */
+static struct vy_page_index_block *
+vy_run_read_page_index_block(struct vy_run *run, uint32_t block_no)
 {
-	assert(stmt_no < page->row_count);
+	const char *path = run->index_path;
+	struct vy_page_index_fence *fence = &run->page_index[block_no];
+	assert(path != NULL && fence->offset >= 0);
+	struct vy_page_index_block *block = vy_page_index_block_new(run,
+								   block_no);
+	if (block == NULL)
+		return NULL;
+	uint32_t page_count = block->page_count;
+	block->page_count = 0;
+
+	struct xlog_cursor cursor;
+	if (xlog_cursor_open(&cursor, path) != 0)
+		goto fail;
+	xlog_cursor_seek_offset(&cursor, fence->offset);
+	int rc = xlog_cursor_next_tx(&cursor);
+	while (block->page_count < page_count) {
+		struct xrow_header xrow;
+		if (rc == 0)
+			rc = xlog_cursor_next_row(&cursor, &xrow);
+		if (rc != 0) {
+			if (rc > 0)
+				diag_set(ClientError, ER_INVALID_INDEX_FILE,
+					 path, "Unexpected end of file");
+			goto fail_close;
+		}
+		if (xrow.type != VY_INDEX_PAGE_INFO) {
+			diag_set(ClientError, ER_INVALID_INDEX_FILE, path,
+				 tt_sprintf("Wrong xrow type "
+					    "(expected %d, got %u)",
+					    VY_INDEX_PAGE_INFO,
+					    (unsigned)xrow.type));
+			goto fail_close;
+		}
+		struct vy_page_info *page = &block->pages[block->page_count];
+		if (vy_page_info_decode(page, &xrow, path) != 0)
+			goto fail_close;
+		block->mem += vy_page_info_size(page);
+		block->page_count++;
+	}
+	xlog_cursor_close(&cursor, false);
+	return block;
+fail_close:
+	xlog_cursor_close(&cursor, false);
+fail:
+	vy_page_index_block_delete(block);
+	return NULL;
+}
+
+/** Free an evicted page index block. */
+static void
+vy_run_evict_page_index_block(struct vy_page_index_block *block)
+{
+	struct vy_run *run = block->run;
+	struct vy_run_env *env = run->env;
+	assert(run->is_index_cached);
+	assert(env->page_index_mem >= block->mem);
+	env->page_index_mem -= block->mem;
+	rlist_del_entry(block, in_lru);
+	run->page_index[block->block_no].block = NULL;
+	vy_page_index_block_delete(block);
+}
+
+/** Free an evicted bloom filter. */
+static void
+vy_run_evict_bloom(struct vy_run *run)
+{
+	struct vy_run_env *env = run->env;
+	assert(run->is_index_cached);
+	assert(env->bloom_mem >= run->bloom_size);
+	env->bloom_mem -= run->bloom_size;
+	rlist_del_entry(run, in_bloom_lru);
+	tuple_bloom_delete(run->info.bloom);
+	run->info.bloom = NULL;
+}
+
+/**
+ * Evict least recently used page index blocks and bloom
+ * filters until the memory they take fits in the quota.
+ * The most recently used block is never evicted, because
+ * a page info of it may still be in use, see vy_run_page_info().
+ */
+static void
+vy_run_env_trim_index_cache(struct vy_run_env *env)
+{
+	if (env->index_cache_quota == 0)
+		return;
+	while (env->page_index_mem + env->bloom_mem >
+	       env->index_cache_quota) {
+		struct vy_page_index_block *block = NULL;
+		struct vy_run *run = NULL;
+		if (rlist_first(&env->page_index_lru) !=
+		    rlist_last(&env->page_index_lru)) {
+			block = rlist_last_entry(&env->page_index_lru,
+						 struct vy_page_index_block,
+						 in_lru);
+		}
+		if (!rlist_empty(&env->bloom_lru)) {
+			run = rlist_last_entry(&env->bloom_lru,
+					       struct vy_run, in_bloom_lru);
+		}
+		if (block != NULL &&
+		    (run == NULL || block->last_used < run->bloom_last_used))
+			vy_run_evict_page_index_block(block);
+		else if (run != NULL)
+			vy_run_evict_bloom(run);
+		else
+			break;
+	}
+}
+
+void
+vy_run_env_set_index_cache(struct vy_run_env *env, size_t quota)
+{
+	env->index_cache_quota = quota;
+	vy_run_env_trim_index_cache(env);
+}
+
+void
+vy_run_cache_index(struct vy_run *run)
+{
+	struct vy_run_env *env = run->env;
+	assert(cord_is_main());
+	if (run->is_index_cached)
+		return;
+	run->is_index_cached = true;
+	uint32_t block_count = DIV_ROUND_UP(run->info.page_count,
+					    VY_PAGE_INDEX_BLOCK_SIZE);
+	for (uint32_t i = 0; i < block_count; i++) {
+		struct vy_page_index_fence *fence = &run->page_index[i];
+		struct vy_page_index_block *block = fence->block;
+		assert(block != NULL);
+		env->page_index_mem += block->mem;
+		/* Blocks that can't be read separately are pinned. */
+		if (fence->offset < 0)
+			continue;
+		block->last_used = ++env->index_cache_clock;
+		rlist_add_entry(&env->page_index_lru, block, in_lru);
+	}
+	if (run->info.bloom != NULL) {
+		env->bloom_mem += run->bloom_size;
+		run->bloom_last_used = ++env->index_cache_clock;
+		rlist_add_entry(&env->bloom_lru, run, in_bloom_lru);
+	}
+	vy_run_env_trim_index_cache(env);
+}
+
+struct vy_page_index_block *
+vy_run_load_page_index_block(struct vy_run *run, uint32_t block_no)
+{
+	struct vy_run_env *env = run->env;
+	assert(cord_is_main());
+	assert(run->is_index_cached);
+	assert(run->page_index[block_no].block == NULL);
+	struct vy_page_index_block *block =
+		vy_run_read_page_index_block(run, block_no);
+	if (block == NULL)
+		return NULL;
+	/*
+	 * Trim the cache before adding the new block so that
+	 * the block used before this one survives.
+	 */
+	vy_run_env_trim_index_cache(env);
+	run->page_index[block_no].block = block;
+	block->last_used = ++env->index_cache_clock;
+	rlist_add_entry(&env->page_index_lru, block, in_lru);
+	env->page_index_mem += block->mem;
+	return block;
+}
+
+/** Load an evicted bloom filter of a run from its index file. */
+static int
+vy_run_load_bloom(struct vy_run *run)
+{
+	struct vy_run_env *env = run->env;
+	const char *path = run->index_path;
+	assert(run->is_index_cached && run->info.bloom == NULL);
+	struct xlog_cursor cursor;
+	if (xlog_cursor_open(&cursor, path) != 0)
+		return -1;
+	struct xrow_header xrow;
+	struct tuple_bloom *bloom = NULL;
+	int rc = xlog_cursor_next_tx(&cursor);
+	if (rc == 0)
+		rc = xlog_cursor_next_row(&cursor, &xrow);
+	if (rc > 0 || (rc == 0 && xrow.type != VY_INDEX_RUN_INFO)) {
+		diag_set(ClientError, ER_INVALID_INDEX_FILE, path,
+			 "Can't find run info");
+		rc = -1;
+	}
+	if (rc == 0 && vy_run_info_decode_bloom(&xrow, &bloom) != 0)
+		rc = -1;
+	if (rc == 0 && bloom == NULL) {
+		diag_set(ClientError, ER_INVALID_INDEX_FILE, path,
+			 "Can't find bloom filter");
+		rc = -1;
+	}
+	xlog_cursor_close(&cursor, false);
+	if (rc != 0)
+		return -1;
+	vy_run_env_trim_index_cache(env);
+	run->info.bloom = bloom;
+	run->bloom_last_used = ++env->index_cache_clock;
+	rlist_add_entry(&env->bloom_lru, run, in_bloom_lru);
+	env->bloom_mem += run->bloom_size;
+	return 0;
+}
+
+/* }}} Page index cache */
+
+static struct vy_page *
+vy_page_new(const struct vy_page_info *page_info)
+{
+	struct vy_page *page = malloc(sizeof(*page));
+	if (page == NULL) {
+		diag_set(OutOfMemory, sizeof(*page),
+			 "load_page", "page cache");
+		return NULL;
+	}
+	/* Columnar pages are kept in memory as rows. */
+	page->unpacked_size = page_info->version == VY_PAGE_VERSION_COLUMNAR ?
+			      page_info->rows_size : page_info->unpacked_size;
+	page->disk_size = page_info->size;
+	page->decompressed_size = page_info->unpacked_size;
+	page->row_count = page_info->row_count;
+	page->restart_interval = page_info->restart_interval;
+	page->refs = 1;
+	page->run_id = -1;
+	page->in_cache = false;
+	page->row_index = calloc(page_info->row_count, sizeof(uint32_t));
+	if (page->row_index == NULL) {
+		diag_set(OutOfMemory, page_info->row_count * sizeof(uint32_t),
+			 "malloc", "page->row_index");
+		free(page);
+		return NULL;
+	}
+
+	page->data = (char *)malloc(page->unpacked_size);
+	if (page->data == NULL) {
+		diag_set(OutOfMemory, page->unpacked_size,
+			 "malloc", "page->data");
+		free(page->row_index);
+		free(page);
+		return NULL;
+	}
+	return page;
+}
+
+static void
+vy_page_delete(struct vy_page *page)
+{
+	uint32_t *row_index = page->row_index;
+	char *data = page->data;
+#if !defined(NDEBUG)
+	memset(row_index, '#', sizeof(uint32_t) * page->row_count);
+	memset(data, '#', page->unpacked_size);
+	memset(page, '#', sizeof(*page));
+#endif /* !defined(NDEBUG) */
+	free(row_index);
+	free(data);
+	free(page);
+}
+
+static inline void
+vy_page_ref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	page->refs++;
+}
+
+static inline void
+vy_page_unref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	if (--page->refs == 0)
+		vy_page_delete(page);
+}
+
+/* {{{ vy_page_cache */
+
+static inline uint32_t
+vy_page_cache_hash(int64_t run_id, uint32_t page_no)
+{
+	uint64_t h = (uint64_t)run_id * 0x9E3779B97F4A7C15ULL + page_no;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	return (uint32_t)h;
+}
+
+struct vy_page_cache_key {
+	int64_t run_id;
+	uint32_t page_no;
+};
+
+#define MH_SOURCE 1
+#define mh_name _vy_page
+#define mh_key_t const struct vy_page_cache_key *
+#define mh_node_t struct vy_page *
+#define mh_arg_t void *
+#define mh_hash(a, arg) (vy_page_cache_hash((*(a))->run_id, (*(a))->page_no))
+#define mh_hash_key(a, arg) (vy_page_cache_hash((a)->run_id, (a)->page_no))
+#define mh_cmp(a, b, arg) ((*(a))->run_id != (*(b))->run_id || \
+			   (*(a))->page_no != (*(b))->page_no)
+#define mh_cmp_key(a, b, arg) ((a)->run_id != (*(b))->run_id || \
+			       (a)->page_no != (*(b))->page_no)
+#include "salad/mhash.h"
+
+/** Memory accounted to a cached page. */
+static inline size_t
+vy_page_mem_size(struct vy_page *page)
+{
+	return sizeof(*page) + page->unpacked_size +
+		page->row_count * sizeof(*page->row_index);
+}
+
+static void
+vy_page_cache_create(struct vy_page_cache *cache)
+{
+	memset(cache, 0, sizeof(*cache));
+	cache->hash = mh_vy_page_new();
+	if (cache->hash == NULL)
+		panic("failed to allocate vinyl page cache");
+	rlist_create(&cache->lru);
+	rlist_create(&cache->pending);
+}
+
+static void
+vy_page_cache_remove(struct vy_page_cache *cache, struct vy_page *page)
+{
+	assert(page->in_cache);
+	struct vy_page_cache_key key = {
+		.run_id = page->run_id,
+		.page_no = page->page_no,
+	};
+	mh_int_t k = mh_vy_page_find(cache->hash, &key, NULL);
+	assert(k != mh_end(cache->hash));
+	mh_vy_page_del(cache->hash, k, NULL);
+	rlist_del_entry(page, in_lru);
+	rlist_del_entry(page, in_run);
+	page->in_cache = false;
+	assert(cache->mem_used >= vy_page_mem_size(page));
+	cache->mem_used -= vy_page_mem_size(page);
+	vy_page_unref(page);
+}
+
+static void
+vy_page_cache_destroy(struct vy_page_cache *cache)
+{
+	struct vy_page *page, *tmp;
+	rlist_foreach_entry_safe(page, &cache->lru, in_lru, tmp)
+		vy_page_cache_remove(cache, page);
+	mh_vy_page_delete(cache->hash);
+	assert(rlist_empty(&cache->pending));
+}
+
+/** Evict least recently used pages until the cache fits in quota. */
+static void
+vy_page_cache_evict(struct vy_page_cache *cache)
+{
+	while (cache->mem_used > cache->quota) {
+		assert(!rlist_empty(&cache->lru));
+		struct vy_page *page = rlist_last_entry(&cache->lru,
+							struct vy_page,
+							in_lru);
+		vy_page_cache_remove(cache, page);
+		cache->evict++;
+	}
+}
+
+/**
+ * Look up a page in the cache without updating statistics
+ * and LRU. Returns NULL if the page isn't cached.
+ */
+static struct vy_page *
+vy_page_cache_find(struct vy_page_cache *cache, struct vy_run *run,
+		   uint32_t page_no)
+{
+	struct vy_page_cache_key key = {
+		.run_id = run->id,
+		.page_no = page_no,
+	};
+	mh_int_t k = mh_vy_page_find(cache->hash, &key, NULL);
+	if (k == mh_end(cache->hash))
+		return NULL;
+	return *mh_vy_page_node(cache->hash, k);
+}
+
+/**
+ * Look up a page in the cache. Returns a referenced page
+ * on success, NULL if the page isn't cached.
+ */
+static struct vy_page *
+vy_page_cache_get(struct vy_page_cache *cache, struct vy_run *run,
+		  uint32_t page_no)
+{
+	struct vy_page *page = vy_page_cache_find(cache, run, page_no);
+	if (page == NULL) {
+		cache->miss++;
+		return NULL;
+	}
+	cache->hit++;
+	rlist_move_entry(&cache->lru, page, in_lru);
+	vy_page_ref(page);
+	return page;
+}
+
+/**
+ * Add a page read from disk to the cache. Failure to insert
+ * a page isn't critical and so is silently ignored.
+ */
+static void
+vy_page_cache_put(struct vy_page_cache *cache, struct vy_run *run,
+		  struct vy_page *page)
+{
+	assert(!page->in_cache);
+	size_t size = vy_page_mem_size(page);
+	if (size > cache->quota)
+		return;
+	page->run_id = run->id;
+	if (mh_vy_page_put(cache->hash, &page, NULL,
+			   NULL) == mh_end(cache->hash))
+		return;
+	vy_page_ref(page);
+	page->in_cache = true;
+	rlist_add_entry(&cache->lru, page, in_lru);
+	rlist_add_entry(&run->cached_pages, page, in_run);
+	cache->mem_used += size;
+	vy_page_cache_evict(cache);
+}
+
+/** Drop all cached pages of a run. */
+static void
+vy_page_cache_purge_run(struct vy_page_cache *cache, struct vy_run *run)
+{
+	struct vy_page *page, *tmp;
+	rlist_foreach_entry_safe(page, &run->cached_pages, in_run, tmp)
+		vy_page_cache_remove(cache, page);
+}
+
+void
+vy_run_env_set_page_cache(struct vy_run_env *env, size_t quota)
+{
+	env->page_cache.quota = quota;
+	vy_page_cache_evict(&env->page_cache);
+}
+
+void
+vy_run_env_set_read_ahead(struct vy_run_env *env, size_t quota)
+{
+	env->read_ahead_quota = quota;
+}
+
+/**
+ * A page read in progress. Allocated on the stack of the fiber
+ * doing the read. Other fibers that need the same page wait for
+ * it to complete instead of reading the page themselves.
+ */
+struct vy_page_read_pending {
+	/** ID of the run the page belongs to. */
+	int64_t run_id;
+	/** Page number. */
+	uint32_t page_no;
+	/** Fibers waiting for the read, see vy_page_read_waiter. */
+	struct rlist waiters;
+	/** Signalled when the read completes. */
+	struct fiber_cond cond;
+	/** Link in vy_page_cache::pending. */
+	struct rlist in_cache;
+};
+
+/** A fiber waiting for a page read done by another fiber. */
+struct vy_page_read_waiter {
+	/** The page read, referenced, or NULL if the read failed. */
+	struct vy_page *page;
+	/** Set when the read completes. */
+	bool done;
+	/** Link in vy_page_read_pending::waiters. */
+	struct rlist in_pending;
+};
+
+static void
+vy_page_read_pending_create(struct vy_page_read_pending *pending,
+			    struct vy_page_cache *cache, struct vy_run *run,
+			    uint32_t page_no)
+{
+	pending->run_id = run->id;
+	pending->page_no = page_no;
+	rlist_create(&pending->waiters);
+	fiber_cond_create(&pending->cond);
+	rlist_add_entry(&cache->pending, pending, in_cache);
+}
+
+/**
+ * Complete a page read and wake up all fibers waiting for it.
+ * @page is the page read or NULL on failure.
+ */
+static void
+vy_page_read_pending_complete(struct vy_page_read_pending *pending,
+			      struct vy_page *page)
+{
+	rlist_del_entry(pending, in_cache);
+	struct vy_page_read_waiter *waiter, *tmp;
+	rlist_foreach_entry_safe(waiter, &pending->waiters, in_pending, tmp) {
+		if (page != NULL)
+			vy_page_ref(page);
+		waiter->page = page;
+		waiter->done = true;
+		rlist_del_entry(waiter, in_pending);
+	}
+	fiber_cond_broadcast(&pending->cond);
+	fiber_cond_destroy(&pending->cond);
+}
+
+/** Look up a read in progress of the given page. */
+static struct vy_page_read_pending *
+vy_page_cache_find_pending(struct vy_page_cache *cache, struct vy_run *run,
+			   uint32_t page_no)
+{
+	struct vy_page_read_pending *pending;
+	rlist_foreach_entry(pending, &cache->pending, in_cache) {
+		if (pending->run_id == run->id && pending->page_no == page_no)
+			return pending;
+	}
+	return NULL;
+}
+
+/**
+ * Wait for a page read done by another fiber. On success
+ * returns the page read, referenced, or NULL if the read
+ * failed and the caller should retry it.
+ */
+static int
+vy_page_read_pending_wait(struct vy_page_read_pending *pending,
+			  struct vy_page **page)
+{
+	struct vy_page_read_waiter waiter = { .page = NULL, .done = false };
+	rlist_add_tail_entry(&pending->waiters, &waiter, in_pending);
+	/*
+	 * Note, @pending is destroyed once the read completes so
+	 * we may only access it while the waiter isn't done.
+	 */
+	do {
+		fiber_cond_wait(&pending->cond);
+		if (!waiter.done && fiber_is_cancelled()) {
+			rlist_del_entry(&waiter, in_pending);
+			diag_set(FiberIsCancelled);
+			return -1;
+		}
+	} while (!waiter.done);
+	*page = waiter.page;
+	return 0;
+}
+
+/* }}} vy_page_cache */
+
+/**
+ * Return true if @a xrow is a prefix-compressed row rather than
+ * a restart point, see VY_PAGE_VERSION_PREFIX.
+ */
+static inline bool
+vy_page_row_is_compressed(const struct xrow_header *xrow)
+{
+	return xrow->bodycnt == 1 &&
+	       mp_typeof(*(const char *)xrow->body[0].iov_base) == MP_ARRAY;
+}
+
+/**
+ * Restore the body of a prefix-compressed row given the body of
+ * the previous row of the page. The restored body is allocated
+ * on the fiber region.
+ */
+static int
+vy_page_row_restore(struct xrow_header *xrow, const char *prev_body,
+		    uint32_t prev_body_size)
+{
+	assert(vy_page_row_is_compressed(xrow));
+	const char *pos = xrow->body[0].iov_base;
+	if (mp_decode_array(&pos) != 2 || mp_typeof(*pos) != MP_UINT) {
+error:
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 "Invalid prefix-compressed statement");
+		return -1;
+	}
+	uint64_t shared = mp_decode_uint(&pos);
+	if (shared > prev_body_size || mp_typeof(*pos) != MP_BIN)
+		goto error;
+	uint32_t suffix_size;
+	const char *suffix = mp_decode_bin(&pos, &suffix_size);
+	size_t size = shared + suffix_size;
+	char *body = region_alloc(&fiber()->gc, size);
+	if (body == NULL) {
+		diag_set(OutOfMemory, size, "region", "statement body");
+		return -1;
+	}
+	memcpy(body, prev_body, shared);
+	memcpy(body + shared, suffix, suffix_size);
+	xrow->body[0].iov_base = body;
+	xrow->body[0].iov_len = size;
+	return 0;
+}
+
+static int
+vy_page_raw_xrow(struct vy_page *page, uint32_t stmt_no,
+		 struct xrow_header *xrow)
+{
+	assert(stmt_no < page->row_count);
 	const char *data = page->data + page->row_index[stmt_no];
 	const char *data_end = stmt_no + 1 < page->row_count ?
 			       page->data + page->row_index[stmt_no + 1] :
@@ -702,6 +1916,38 @@ vy_page_xrow(struct vy_page *page, uint32_t stmt_no,
 	return xrow_header_decode(xrow, &data, data_end);
 }
 
+/**
+ * Decode a statement of a page. If the page is prefix-compressed,
+ * the body is restored starting from the closest restart point
+ * and allocated on the fiber region.
+ */
+static int
+vy_page_xrow(struct vy_page *page, uint32_t stmt_no,
+	     struct xrow_header *xrow)
+{
+	uint32_t row_no = stmt_no;
+	if (page->restart_interval > 0)
+		row_no -= stmt_no % page->restart_interval;
+	if (vy_page_raw_xrow(page, row_no, xrow) != 0)
+		return -1;
+	while (row_no < stmt_no) {
+		if (xrow->bodycnt != 1) {
+			diag_set(ClientError, ER_INVALID_RUN_FILE,
+				 "Invalid prefix-compressed statement");
+			return -1;
+		}
+		const char *prev_body = xrow->body[0].iov_base;
+		uint32_t prev_body_size = xrow->body[0].iov_len;
+		if (vy_page_raw_xrow(page, ++row_no, xrow) != 0)
+			return -1;
+		if (vy_page_row_is_compressed(xrow) &&
+		    vy_page_row_restore(xrow, prev_body,
+					prev_body_size) != 0)
+			return -1;
+	}
+	return 0;
+}
+
 /* {{{ vy_run_iterator vy_run_iterator support functions */
 
 /**
@@ -720,10 +1966,14 @@ vy_page_stmt(struct vy_page *page, uint32_t stmt_no,
 	     const struct key_def *cmp_def, struct tuple_format *format,
 	     bool is_primary)
 {
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
 	struct xrow_header xrow;
-	if (vy_page_xrow(page, stmt_no, &xrow) != 0)
-		return NULL;
-	return vy_stmt_decode(&xrow, cmp_def, format, is_primary);
+	struct tuple *stmt = NULL;
+	if (vy_page_xrow(page, stmt_no, &xrow) == 0)
+		stmt = vy_stmt_decode(&xrow, cmp_def, format, is_primary);
+	region_truncate(region, region_svp);
+	return stmt;
 }
 
 /**
@@ -737,11 +1987,12 @@ vy_run_iterator_stop(struct vy_run_iterator *itr)
 		itr->curr_stmt = NULL;
 	}
 	if (itr->curr_page != NULL) {
-		vy_page_delete(itr->curr_page);
+		vy_page_unref(itr->curr_page);
 		if (itr->prev_page != NULL)
-			vy_page_delete(itr->prev_page);
+			vy_page_unref(itr->prev_page);
 		itr->curr_page = itr->prev_page = NULL;
 	}
+	vy_run_iterator_reset_read_ahead(itr);
 	itr->search_ended = true;
 }
 
@@ -777,6 +2028,161 @@ vy_row_index_decode(uint32_t *row_index, uint32_t row_count,
 	return 0;
 }
 
+/** Column chunks of a page, see VY_PAGE_VERSION_COLUMNAR. */
+struct vy_page_columns {
+	/** Chunk of row prefixes. */
+	const char *rows;
+	const char *rows_end;
+	/** Current position in each column chunk and its end. */
+	const char **pos;
+	const char **end;
+	/** Number of column chunks. */
+	uint32_t column_count;
+	/** Number of rows stored in the chunks. */
+	uint32_t row_count;
+	/** Size of the rows restored from the chunks. */
+	size_t rows_size;
+};
+
+/**
+ * Parse the body of a VY_RUN_COLUMNS row. Chunk positions are
+ * allocated on the fiber region.
+ */
+static int
+vy_page_columns_create(struct vy_page_columns *columns,
+		       const struct xrow_header *xrow)
+{
+	memset(columns, 0, sizeof(*columns));
+	assert(xrow->type == VY_RUN_COLUMNS);
+	if (xrow->bodycnt != 1) {
+error:
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 "Invalid page columns");
+		return -1;
+	}
+	const char *pos = xrow->body[0].iov_base;
+	if (mp_typeof(*pos) != MP_MAP)
+		goto error;
+	const char *chunks = NULL;
+	uint32_t map_size = mp_decode_map(&pos);
+	for (uint32_t i = 0; i < map_size; i++) {
+		if (mp_typeof(*pos) != MP_UINT)
+			goto error;
+		uint64_t key = mp_decode_uint(&pos);
+		if (key == VY_COLUMNS_DATA && mp_typeof(*pos) == MP_ARRAY)
+			chunks = pos;
+		mp_next(&pos);
+	}
+	if (chunks == NULL)
+		goto error;
+	uint32_t chunk_count = mp_decode_array(&chunks);
+	if (chunk_count == 0 || mp_typeof(*chunks) != MP_BIN)
+		goto error;
+	uint32_t size;
+	columns->rows = mp_decode_bin(&chunks, &size);
+	columns->rows_end = columns->rows + size;
+	columns->column_count = chunk_count - 1;
+	size_t alloc_size = 2 * sizeof(const char *) * columns->column_count;
+	columns->pos = region_alloc(&fiber()->gc, alloc_size);
+	if (columns->pos == NULL && alloc_size > 0) {
+		diag_set(OutOfMemory, alloc_size, "region", "page columns");
+		return -1;
+	}
+	columns->end = columns->pos + columns->column_count;
+	for (uint32_t i = 0; i < columns->column_count; i++) {
+		if (mp_typeof(*chunks) != MP_BIN)
+			goto error;
+		columns->pos[i] = mp_decode_bin(&chunks, &size);
+		columns->end[i] = columns->pos[i] + size;
+		columns->rows_size += size;
+	}
+	/* Account row prefixes and check that they are sane. */
+	pos = columns->rows;
+	while (pos < columns->rows_end) {
+		const char *tmp = pos;
+		if (mp_typeof(*pos) != MP_BIN ||
+		    mp_check(&tmp, columns->rows_end) != 0)
+			goto error;
+		columns->rows_size += mp_decode_binl(&pos);
+		pos = tmp;
+		if (pos >= columns->rows_end || mp_typeof(*pos) != MP_UINT ||
+		    mp_check(&tmp, columns->rows_end) != 0 ||
+		    mp_decode_uint(&pos) > columns->column_count)
+			goto error;
+		columns->row_count++;
+	}
+	return 0;
+}
+
+/**
+ * Restore the rows stored in column chunks to @a data, which
+ * must be vy_page_columns::rows_size bytes long. If @a row_index
+ * is not NULL, it is filled with offsets of the rows.
+ */
+static int
+vy_page_columns_restore(struct vy_page_columns *columns, char *data,
+			uint32_t *row_index)
+{
+	char *out = data;
+	const char *pos = columns->rows;
+	for (uint32_t i = 0; i < columns->row_count; i++) {
+		if (row_index != NULL)
+			row_index[i] = out - data;
+		uint32_t size;
+		const char *prefix = mp_decode_bin(&pos, &size);
+		memcpy(out, prefix, size);
+		out += size;
+		uint32_t field_count = mp_decode_uint(&pos);
+		for (uint32_t j = 0; j < field_count; j++) {
+			const char *field = columns->pos[j];
+			if (field >= columns->end[j] ||
+			    mp_check(&columns->pos[j], columns->end[j]) != 0)
+				goto error;
+			memcpy(out, field, columns->pos[j] - field);
+			out += columns->pos[j] - field;
+		}
+	}
+	for (uint32_t j = 0; j < columns->column_count; j++) {
+		if (columns->pos[j] != columns->end[j])
+			goto error;
+	}
+	assert(out == data + columns->rows_size);
+	return 0;
+error:
+	diag_set(ClientError, ER_INVALID_RUN_FILE, "Invalid page columns");
+	return -1;
+}
+
+/**
+ * Restore the rows of a columnar page from its VY_RUN_COLUMNS
+ * row unpacked to [data, data_end).
+ */
+static int
+vy_page_decode_columns(struct vy_page *page, const char *data,
+		       const char *data_end)
+{
+	struct xrow_header xrow;
+	if (xrow_header_decode(&xrow, &data, data_end) != 0)
+		return -1;
+	if (xrow.type != VY_RUN_COLUMNS) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 tt_sprintf("Wrong page columns type "
+				    "(expected %d, got %u)",
+				    VY_RUN_COLUMNS, (unsigned)xrow.type));
+		return -1;
+	}
+	struct vy_page_columns columns;
+	if (vy_page_columns_create(&columns, &xrow) != 0)
+		return -1;
+	if (columns.row_count != page->row_count ||
+	    columns.rows_size != page->unpacked_size) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 "Page columns do not match page info");
+		return -1;
+	}
+	return vy_page_columns_restore(&columns, page->data, page->row_index);
+}
+
 /** Return the name of a run data file. */
 static inline const char *
 vy_run_filename(struct vy_run *run)
@@ -797,14 +2203,22 @@ vy_page_read(struct vy_page *page, const struct vy_page_info *page_info,
 	     struct vy_run *run, ZSTD_DStream *zdctx)
 {
 	/* read xlog tx from xlog file */
+	PROBE3(vy_page_read_start, run->id, page_info->offset,
+	       page_info->size);
 	size_t region_svp = region_used(&fiber()->gc);
 	char *data = (char *)region_alloc(&fiber()->gc, page_info->size);
 	if (data == NULL) {
 		diag_set(OutOfMemory, page_info->size, "region gc", "page");
 		return -1;
 	}
-	ssize_t readen = fio_pread(run->fd, data, page_info->size,
+	ssize_t readen;
+	if (io_ring_is_enabled()) {
+		readen = io_ring_pread(run->fd, data, page_info->size,
+				       page_info->offset);
+	} else {
+		readen = fio_pread(run->fd, data, page_info->size,
 				   page_info->offset);
+	}
 	ERROR_INJECT(ERRINJ_VYRUN_DATA_READ, {
 		readen = -1;
 		errno = EIO;});
@@ -823,11 +2237,28 @@ vy_page_read(struct vy_page *page, const struct vy_page_info *page_info,
 		usleep(inj->dparam * 1000000);
 
 	/* decode xlog tx */
+	PROBE2(vy_page_decompress_start, run->id, page_info->unpacked_size);
 	const char *data_pos = data;
 	const char *data_end = data + readen;
+	if (page_info->version == VY_PAGE_VERSION_COLUMNAR) {
+		char *columns = region_alloc(&fiber()->gc,
+					     page_info->unpacked_size);
+		if (columns == NULL) {
+			diag_set(OutOfMemory, page_info->unpacked_size,
+				 "region gc", "page columns");
+			goto error;
+		}
+		char *columns_end = columns + page_info->unpacked_size;
+		if (xlog_tx_decode(data, data_end, columns, columns_end,
+				   zdctx, run->zddict) != 0 ||
+		    vy_page_decode_columns(page, columns, columns_end) != 0)
+			goto error;
+		goto done;
+	}
 	char *rows = page->data;
 	char *rows_end = rows + page_info->unpacked_size;
-	if (xlog_tx_decode(data, data_end, rows, rows_end, zdctx) != 0)
+	if (xlog_tx_decode(data, data_end, rows, rows_end, zdctx,
+			   run->zddict) != 0)
 		goto error;
 
 	struct xrow_header xrow;
@@ -844,6 +2275,8 @@ vy_page_read(struct vy_page *page, const struct vy_page_info *page_info,
 	}
 	if (vy_row_index_decode(page->row_index, page->row_count, &xrow) != 0)
 		goto error;
+done:
+	PROBE2(vy_page_read_done, run->id, page_info->offset);
 	region_truncate(&fiber()->gc, region_svp);
 	ERROR_INJECT(ERRINJ_VY_READ_PAGE, {
 		diag_set(ClientError, ER_INJECTION, "vinyl page read");
@@ -878,35 +2311,342 @@ vy_env_get_zdctx(struct vy_run_env *env)
 }
 
 /**
- * vinyl read task callback
+ * vinyl read task callback
+ */
+static int
+vy_page_read_cb(struct cbus_call_msg *base)
+{
+	struct vy_page_read_task *task = (struct vy_page_read_task *)base;
+	ZSTD_DStream *zdctx = vy_env_get_zdctx(task->run->env);
+	if (zdctx == NULL)
+		return -1;
+	return vy_page_read(task->page, &task->page_info, task->run, zdctx);
+}
+
+/**
+ * vinyl read task cleanup callback
+ */
+static int
+vy_page_read_cb_free(struct cbus_call_msg *base)
+{
+	struct vy_page_read_task *task = (struct vy_page_read_task *)base;
+	struct vy_run_env *env = task->run->env;
+	vy_page_delete(task->page);
+	vy_run_unref(task->run);
+	mempool_free(&env->read_task_pool, task);
+	return 0;
+}
+
+/**
+ * Read a page from disk, in a reader thread if there are any.
+ */
+static NODISCARD int
+vy_run_read_page(struct vy_run *run, uint32_t page_no,
+		 struct vy_page **result)
+{
+	struct vy_run_env *env = run->env;
+
+	/*
+	 * Copy the page info, because its page index block
+	 * may be evicted while the fiber waits for the read.
+	 */
+	struct vy_page_info *page_info = vy_run_page_info(run, page_no);
+	if (page_info == NULL)
+		return -1;
+	struct vy_page_info info = *page_info;
+
+	/* Allocate buffers */
+	struct vy_page *page = vy_page_new(&info);
+	if (page == NULL)
+		return -1;
+
+	/* Read page data from the disk */
+	int rc;
+	double read_start = ev_monotonic_time();
+	if (env->reader_pool != NULL) {
+		/* Allocate a cbus task. */
+		struct vy_page_read_task *task;
+		task = mempool_alloc(&env->read_task_pool);
+		if (task == NULL) {
+			diag_set(OutOfMemory, sizeof(*task), "mempool",
+				 "vy_page_read_task");
+			vy_page_delete(page);
+			return -1;
+		}
+
+		/* Pick a reader thread. */
+		struct vy_run_reader *reader;
+		reader = &env->reader_pool[env->next_reader++];
+		env->next_reader %= env->reader_pool_size;
+
+		task->run = run;
+		task->page_info = info;
+		task->page = page;
+		vy_run_ref(task->run);
+
+		/* Post task to the reader thread. */
+		rc = cbus_call(&reader->reader_pipe, &reader->tx_pipe,
+			       &task->base, vy_page_read_cb,
+			       vy_page_read_cb_free, TIMEOUT_INFINITY);
+		if (!task->base.complete)
+			return -1; /* timed out or cancelled */
+
+		vy_run_unref(task->run);
+		mempool_free(&env->read_task_pool, task);
+
+		if (rc != 0) {
+			/* posted, but failed */
+			vy_page_delete(page);
+			return -1;
+		}
+	} else {
+		/*
+		 * Optimization: use blocked I/O for non-TX threads or
+		 * during WAL recovery (env->status != VINYL_ONLINE).
+		 * If tx has an io_uring instance, the read only
+		 * blocks the current fiber.
+		 */
+		ZSTD_DStream *zdctx = vy_env_get_zdctx(env);
+		if (zdctx == NULL) {
+			vy_page_delete(page);
+			return -1;
+		}
+		if (vy_page_read(page, &info, run, zdctx) != 0) {
+			vy_page_delete(page);
+			return -1;
+		}
+	}
+
+	page->page_no = page_no;
+
+	if (cord_is_main()) {
+		latency_collect(&env->read_latency,
+				ev_monotonic_time() - read_start);
+	}
+	*result = page;
+	return 0;
+}
+
+/** Account a page read from disk to iterator statistics. */
+static void
+vy_run_iterator_acct_read(struct vy_run_iterator *itr,
+			  struct vy_page *page)
+{
+	itr->stat->read.rows += page->row_count;
+	itr->stat->read.bytes += page->decompressed_size;
+	itr->stat->read.bytes_compressed += page->disk_size;
+	itr->stat->read.pages++;
+}
+
+/**
+ * A page read ahead by a sequential scan. The read is done by
+ * a separate fiber so that the scan can process the current
+ * page meanwhile. The object is owned by both the iterator
+ * and the fiber, and is freed when both are done with it.
+ */
+struct vy_page_read_ahead {
+	/** Run the page belongs to, referenced. */
+	struct vy_run *run;
+	/** Page number. */
+	uint32_t page_no;
+	/** Memory accounted to vy_run_env::read_ahead_mem. */
+	size_t mem;
+	/** The page read or NULL if the read isn't done or failed. */
+	struct vy_page *page;
+	/** Set when the read is done. */
+	bool is_done;
+	/** Set when the iterator doesn't need the page anymore. */
+	bool is_dropped;
+};
+
+/**
+ * Number of page switches after which an iterator is
+ * considered to be doing a sequential scan.
+ */
+enum { VY_RUN_READ_AHEAD_TRIGGER = 2 };
+
+static void
+vy_page_read_ahead_delete(struct vy_page_read_ahead *ra)
+{
+	struct vy_run_env *env = ra->run->env;
+	assert(env->read_ahead_mem >= ra->mem);
+	env->read_ahead_mem -= ra->mem;
+	if (ra->page != NULL)
+		vy_page_unref(ra->page);
+	vy_run_unref(ra->run);
+	free(ra);
+}
+
+static int
+vy_page_read_ahead_f(va_list ap)
+{
+	struct vy_page_read_ahead *ra = va_arg(ap, struct vy_page_read_ahead *);
+	struct vy_run *run = ra->run;
+	/*
+	 * Register the read so that the iterator waits for it
+	 * if it reaches the page before the read is done.
+	 */
+	struct vy_page_read_pending read;
+	vy_page_read_pending_create(&read, &run->env->page_cache,
+				    run, ra->page_no);
+	struct vy_page *page;
+	if (vy_run_read_page(run, ra->page_no, &page) == 0) {
+		ra->page = page;
+		run->env->read_ahead_pages++;
+	}
+	/* On failure the iterator will retry the read itself. */
+	vy_page_read_pending_complete(&read, ra->page);
+	ra->is_done = true;
+	if (ra->is_dropped)
+		vy_page_read_ahead_delete(ra);
+	return 0;
+}
+
+/** Release a page read ahead by an iterator. */
+static void
+vy_page_read_ahead_drop(struct vy_page_read_ahead *ra)
+{
+	ra->is_dropped = true;
+	if (ra->is_done)
+		vy_page_read_ahead_delete(ra);
+}
+
+/**
+ * Drop the first @count pages read ahead by an iterator.
+ */
+static void
+vy_run_iterator_drop_read_ahead(struct vy_run_iterator *itr, int count)
+{
+	assert(count <= itr->read_ahead_count);
+	for (int i = 0; i < count; i++)
+		vy_page_read_ahead_drop(itr->read_ahead[i]);
+	itr->read_ahead_count -= count;
+	memmove(itr->read_ahead, itr->read_ahead + count,
+		itr->read_ahead_count * sizeof(itr->read_ahead[0]));
+}
+
+/** Stop reading ahead, e.g. on seek. */
+static void
+vy_run_iterator_reset_read_ahead(struct vy_run_iterator *itr)
+{
+	vy_run_iterator_drop_read_ahead(itr, itr->read_ahead_count);
+	itr->read_ahead_window = 0;
+	itr->seq_page_count = 0;
+}
+
+/**
+ * Called when a scan switches to the next page in its order.
+ * Once the scan has switched pages a few times in a row, it's
+ * considered sequential and the following pages are read in
+ * the background. The number of pages read ahead doubles with
+ * each page switch, up to VY_RUN_READ_AHEAD_MAX, and is also
+ * limited by vy_run_env::read_ahead_quota.
  */
-static int
-vy_page_read_cb(struct cbus_call_msg *base)
+static void
+vy_run_iterator_read_ahead(struct vy_run_iterator *itr,
+			   enum iterator_type iterator_type, uint32_t page_no)
 {
-	struct vy_page_read_task *task = (struct vy_page_read_task *)base;
-	ZSTD_DStream *zdctx = vy_env_get_zdctx(task->run->env);
-	if (zdctx == NULL)
-		return -1;
-	return vy_page_read(task->page, &task->page_info, task->run, zdctx);
+	struct vy_run *run = itr->slice->run;
+	struct vy_run_env *env = run->env;
+	/*
+	 * Reading ahead needs reader threads, otherwise reads
+	 * would block tx. The page cache may only be accessed
+	 * from tx.
+	 */
+	if (env->read_ahead_quota == 0 || env->reader_pool == NULL ||
+	    !cord_is_main())
+		return;
+
+	int dir = iterator_direction(iterator_type);
+	/* Drop pages the scan has skipped. */
+	int skipped = 0;
+	while (skipped < itr->read_ahead_count &&
+	       dir * ((int64_t)itr->read_ahead[skipped]->page_no -
+		      page_no) < 0)
+		skipped++;
+	vy_run_iterator_drop_read_ahead(itr, skipped);
+
+	if (++itr->seq_page_count < VY_RUN_READ_AHEAD_TRIGGER)
+		return;
+	itr->read_ahead_window = MIN(MAX(itr->read_ahead_window * 2, 1),
+				     VY_RUN_READ_AHEAD_MAX);
+
+	/* Continue from where the previous read-ahead stopped. */
+	int64_t next = page_no;
+	if (itr->read_ahead_count > 0)
+		next = itr->read_ahead[itr->read_ahead_count - 1]->page_no;
+	next += dir;
+	struct vy_page_cache *cache = &env->page_cache;
+	for (; itr->read_ahead_count < itr->read_ahead_window &&
+	       next >= 0 && next < run->info.page_count; next += dir) {
+		struct vy_page_info *page_info = vy_run_page_info(run, next);
+		if (page_info == NULL) {
+			/* Reading ahead is optional. */
+			diag_clear(diag_get());
+			break;
+		}
+		if (itr->filter != NULL &&
+		    vy_page_info_is_filtered(page_info, itr->filter))
+			continue;
+		if (vy_page_cache_find(cache, run, next) != NULL ||
+		    vy_page_cache_find_pending(cache, run, next) != NULL)
+			continue;
+		size_t mem = page_info->unpacked_size;
+		if (env->read_ahead_mem + mem > env->read_ahead_quota)
+			break;
+		struct vy_page_read_ahead *ra = malloc(sizeof(*ra));
+		if (ra == NULL)
+			break;
+		struct fiber *f = fiber_new("vinyl.read_ahead",
+					    vy_page_read_ahead_f);
+		if (f == NULL) {
+			/* Reading ahead is optional. */
+			diag_clear(diag_get());
+			free(ra);
+			break;
+		}
+		ra->run = run;
+		ra->page_no = next;
+		ra->mem = mem;
+		ra->page = NULL;
+		ra->is_done = false;
+		ra->is_dropped = false;
+		vy_run_ref(run);
+		env->read_ahead_mem += mem;
+		itr->read_ahead[itr->read_ahead_count++] = ra;
+		fiber_start(f, ra);
+	}
 }
 
 /**
- * vinyl read task cleanup callback
+ * Take a page read ahead by an iterator. Returns a referenced
+ * page or NULL if the page wasn't read ahead or the read isn't
+ * done yet.
  */
-static int
-vy_page_read_cb_free(struct cbus_call_msg *base)
+static struct vy_page *
+vy_run_iterator_take_read_ahead(struct vy_run_iterator *itr,
+				uint32_t page_no)
 {
-	struct vy_page_read_task *task = (struct vy_page_read_task *)base;
-	struct vy_run_env *env = task->run->env;
-	vy_page_delete(task->page);
-	vy_run_unref(task->run);
-	mempool_free(&env->read_task_pool, task);
-	return 0;
+	for (int i = 0; i < itr->read_ahead_count; i++) {
+		struct vy_page_read_ahead *ra = itr->read_ahead[i];
+		if (ra->page_no != page_no || ra->page == NULL)
+			continue;
+		struct vy_page *page = ra->page;
+		vy_page_ref(page);
+		/* Pages before this one were skipped. */
+		vy_run_iterator_drop_read_ahead(itr, i + 1);
+		return page;
+	}
+	return NULL;
 }
 
 /**
  * Read a page from disk given its number.
  * The function caches two most recently read pages.
+ * Pages are also looked up in and added to the page cache
+ * shared by all iterators, see vy_page_cache. If another fiber
+ * is already reading the same page, wait for it instead of
+ * issuing a duplicate read.
  *
  * @retval 0 success
  * @retval -1 critical error
@@ -932,78 +2672,53 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		}
 	}
 
-	/* Allocate buffers */
-	struct vy_page_info *page_info = vy_run_page_info(slice->run, page_no);
-	struct vy_page *page = vy_page_new(page_info);
-	if (page == NULL)
-		return -1;
-
-	/* Read page data from the disk */
-	int rc;
-	if (env->reader_pool != NULL) {
-		/* Allocate a cbus task. */
-		struct vy_page_read_task *task;
-		task = mempool_alloc(&env->read_task_pool);
-		if (task == NULL) {
-			diag_set(OutOfMemory, sizeof(*task), "mempool",
-				 "vy_page_read_task");
-			vy_page_delete(page);
-			return -1;
-		}
-
-		/* Pick a reader thread. */
-		struct vy_run_reader *reader;
-		reader = &env->reader_pool[env->next_reader++];
-		env->next_reader %= env->reader_pool_size;
-
-		task->run = slice->run;
-		task->page_info = *page_info;
-		task->page = page;
-		vy_run_ref(task->run);
-
-		/* Post task to the reader thread. */
-		rc = cbus_call(&reader->reader_pipe, &reader->tx_pipe,
-			       &task->base, vy_page_read_cb,
-			       vy_page_read_cb_free, TIMEOUT_INFINITY);
-		if (!task->base.complete)
-			return -1; /* timed out or cancelled */
-
-		vy_run_unref(task->run);
-		mempool_free(&env->read_task_pool, task);
-
-		if (rc != 0) {
-			/* posted, but failed */
-			vy_page_delete(page);
-			return -1;
-		}
-	} else {
-		/*
-		 * Optimization: use blocked I/O for non-TX threads or
-		 * during WAL recovery (env->status != VINYL_ONLINE).
-		 */
-		ZSTD_DStream *zdctx = vy_env_get_zdctx(env);
-		if (zdctx == NULL) {
-			vy_page_delete(page);
-			return -1;
-		}
-		if (vy_page_read(page, page_info, slice->run, zdctx) != 0) {
-			vy_page_delete(page);
+	struct vy_page *page;
+	struct vy_page_cache *cache = &env->page_cache;
+	/* The page cache may only be accessed from tx. */
+	bool is_tx = cord_is_main();
+	bool use_cache = cache->quota > 0 && is_tx;
+	if (use_cache) {
+		page = vy_page_cache_get(cache, slice->run, page_no);
+		if (page != NULL)
+			goto out;
+	}
+	if (itr->read_ahead_count > 0) {
+		page = vy_run_iterator_take_read_ahead(itr, page_no);
+		if (page != NULL)
+			goto acct;
+	}
+	struct vy_page_read_pending *pending = NULL;
+	if (is_tx) {
+		pending = vy_page_cache_find_pending(cache, slice->run,
+						     page_no);
+	}
+	if (pending != NULL) {
+		if (vy_page_read_pending_wait(pending, &page) != 0)
 			return -1;
-		}
+		if (page != NULL)
+			goto acct;
+		/* The read failed, retry it. */
 	}
 
+	struct vy_page_read_pending read;
+	if (is_tx)
+		vy_page_read_pending_create(&read, cache, slice->run, page_no);
+	int rc = vy_run_read_page(slice->run, page_no, &page);
+	if (is_tx)
+		vy_page_read_pending_complete(&read, rc == 0 ? page : NULL);
+	if (rc != 0)
+		return -1;
+acct:
+	vy_run_iterator_acct_read(itr, page);
+	/* A page read by another fiber may be cached already. */
+	if (use_cache && !page->in_cache)
+		vy_page_cache_put(cache, slice->run, page);
+out:
 	/* Update cache */
 	if (itr->prev_page != NULL)
-		vy_page_delete(itr->prev_page);
+		vy_page_unref(itr->prev_page);
 	itr->prev_page = itr->curr_page;
 	itr->curr_page = page;
-	page->page_no = page_no;
-
-	/* Update read statistics. */
-	itr->stat->read.rows += page_info->row_count;
-	itr->stat->read.bytes += page_info->unpacked_size;
-	itr->stat->read.bytes_compressed += page_info->size;
-	itr->stat->read.pages++;
 
 	*result = page;
 	return 0;
@@ -1051,6 +2766,38 @@ vy_run_iterator_search_in_page(struct vy_run_iterator *itr,
 	/* for upper bound we change zero comparison result to -1 */
 	int zero_cmp = (iterator_type == ITER_GT ||
 			iterator_type == ITER_LE ? -1 : 0);
+	/*
+	 * Restart points of a prefix-compressed page are cheap
+	 * to decode, unlike the rows between them, so first find
+	 * the interval between two restart points that contains
+	 * the key, then do the binary search within it.
+	 */
+	uint32_t step = page->restart_interval;
+	if (step > 0 && page->row_count > step) {
+		uint32_t restart_beg = 0;
+		uint32_t restart_end = (page->row_count - 1) / step + 1;
+		while (restart_beg != restart_end) {
+			uint32_t mid = restart_beg +
+				       (restart_end - restart_beg) / 2;
+			struct tuple *fnd_key = vy_page_stmt(page, mid * step,
+						itr->cmp_def, itr->format,
+						itr->is_primary);
+			if (fnd_key == NULL)
+				return end;
+			int cmp = vy_stmt_compare(fnd_key, key, itr->cmp_def);
+			cmp = cmp ? cmp : zero_cmp;
+			*equal_key = *equal_key || cmp == 0;
+			if (cmp < 0)
+				restart_beg = mid + 1;
+			else
+				restart_end = mid;
+			tuple_unref(fnd_key);
+		}
+		/* The result is in (restart_end - 1, restart_end]. */
+		if (restart_end > 0)
+			beg = (restart_end - 1) * step + 1;
+		end = MIN(restart_end * step, page->row_count);
+	}
 	while (beg != end) {
 		uint32_t mid = beg + (end - beg) / 2;
 		struct tuple *fnd_key = vy_page_stmt(page, mid, itr->cmp_def,
@@ -1086,9 +2833,10 @@ vy_run_iterator_search(struct vy_run_iterator *itr,
 		       const struct tuple *key,
 		       struct vy_run_iterator_pos *pos, bool *equal_key)
 {
-	pos->page_no = vy_page_index_find_page(itr->slice->run, key,
-					       itr->cmp_def, iterator_type,
-					       equal_key);
+	if (vy_page_index_find_page(itr->slice->run, key, itr->cmp_def,
+				    iterator_type, equal_key,
+				    &pos->page_no) != 0)
+		return -1;
 	if (pos->page_no == itr->slice->run->info.page_count) {
 		itr->search_ended = true;
 		return 0;
@@ -1110,11 +2858,55 @@ vy_run_iterator_search(struct vy_run_iterator *itr,
 	return 0;
 }
 
+/**
+ * Move a position past the pages excluded by the iterator filter,
+ * in the iteration order. A position moved forward points to the
+ * first statement of a page, a position moved backward points to
+ * the last one.
+ * @retval 0 success, *pos is in a page that may match the filter
+ * @retval 1 EOF
+ * @retval -1 failed to load a page index block
+ */
+static NODISCARD int
+vy_run_iterator_skip_filtered(struct vy_run_iterator *itr,
+			      enum iterator_type iterator_type,
+			      struct vy_run_iterator_pos *pos)
+{
+	if (itr->filter == NULL)
+		return 0;
+	struct vy_run *run = itr->slice->run;
+	assert(pos->page_no < run->info.page_count);
+	while (true) {
+		struct vy_page_info *page_info =
+			vy_run_page_info(run, pos->page_no);
+		if (page_info == NULL)
+			return -1;
+		if (!vy_page_info_is_filtered(page_info, itr->filter))
+			break;
+		if (iterator_type == ITER_LE || iterator_type == ITER_LT) {
+			if (pos->page_no == 0)
+				return 1;
+			pos->page_no--;
+			page_info = vy_run_page_info(run, pos->page_no);
+			if (page_info == NULL)
+				return -1;
+			pos->pos_in_page = page_info->row_count - 1;
+		} else {
+			pos->page_no++;
+			pos->pos_in_page = 0;
+			if (pos->page_no == run->info.page_count)
+				return 1;
+		}
+	}
+	return 0;
+}
+
 /**
  * Increment (or decrement, depending on the order) the current
  * wide position.
  * @retval 0 success, set *pos to new value
  * @retval 1 EOF
+ * @retval -1 failed to load a page index block
  * Affects: curr_loaded_page
  */
 static NODISCARD int
@@ -1123,6 +2915,7 @@ vy_run_iterator_next_pos(struct vy_run_iterator *itr,
 			 struct vy_run_iterator_pos *pos)
 {
 	struct vy_run *run = itr->slice->run;
+	int rc;
 	*pos = itr->curr_pos;
 	if (iterator_type == ITER_LE || iterator_type == ITER_LT) {
 		assert(pos->page_no <= run->info.page_count);
@@ -1134,8 +2927,11 @@ vy_run_iterator_next_pos(struct vy_run_iterator *itr,
 			pos->page_no--;
 			struct vy_page_info *page_info =
 				vy_run_page_info(run, pos->page_no);
+			if (page_info == NULL)
+				return -1;
 			assert(page_info->row_count > 0);
 			pos->pos_in_page = page_info->row_count - 1;
+			goto next_page;
 		}
 	} else {
 		assert(iterator_type == ITER_GE || iterator_type == ITER_GT ||
@@ -1143,6 +2939,8 @@ vy_run_iterator_next_pos(struct vy_run_iterator *itr,
 		assert(pos->page_no < run->info.page_count);
 		struct vy_page_info *page_info =
 			vy_run_page_info(run, pos->page_no);
+		if (page_info == NULL)
+			return -1;
 		assert(page_info->row_count > 0);
 		pos->pos_in_page++;
 		if (pos->pos_in_page >= page_info->row_count) {
@@ -1150,9 +2948,16 @@ vy_run_iterator_next_pos(struct vy_run_iterator *itr,
 			pos->pos_in_page = 0;
 			if (pos->page_no == run->info.page_count)
 				return 1;
+			goto next_page;
 		}
 	}
 	return 0;
+next_page:
+	rc = vy_run_iterator_skip_filtered(itr, iterator_type, pos);
+	if (rc != 0)
+		return rc;
+	vy_run_iterator_read_ahead(itr, iterator_type, pos->page_no);
+	return 0;
 }
 
 /**
@@ -1179,10 +2984,14 @@ vy_run_iterator_find_lsn(struct vy_run_iterator *itr,
 	assert(itr->curr_stmt != NULL);
 	assert(itr->curr_pos.page_no < slice->run->info.page_count);
 
+	int rc;
 	while (vy_stmt_lsn(itr->curr_stmt) > (**itr->read_view).vlsn ||
 	       vy_stmt_flags(itr->curr_stmt) & VY_STMT_SKIP_READ) {
-		if (vy_run_iterator_next_pos(itr, iterator_type,
-					     &itr->curr_pos) != 0) {
+		rc = vy_run_iterator_next_pos(itr, iterator_type,
+					      &itr->curr_pos);
+		if (rc < 0)
+			return -1;
+		if (rc > 0) {
 			vy_run_iterator_stop(itr);
 			return 0;
 		}
@@ -1199,8 +3008,8 @@ vy_run_iterator_find_lsn(struct vy_run_iterator *itr,
 	}
 	if (iterator_type == ITER_LE || iterator_type == ITER_LT) {
 		struct vy_run_iterator_pos test_pos;
-		while (vy_run_iterator_next_pos(itr, iterator_type,
-						&test_pos) == 0) {
+		while ((rc = vy_run_iterator_next_pos(itr, iterator_type,
+						      &test_pos)) == 0) {
 			struct tuple *test_stmt;
 			if (vy_run_iterator_read(itr, test_pos,
 						 &test_stmt) != 0)
@@ -1216,6 +3025,8 @@ vy_run_iterator_find_lsn(struct vy_run_iterator *itr,
 			itr->curr_stmt = test_stmt;
 			itr->curr_pos = test_pos;
 		}
+		if (rc < 0)
+			return -1;
 	}
 	/* Check if the result is within the slice boundaries. */
 	if (iterator_type == ITER_LE || iterator_type == ITER_LT) {
@@ -1240,6 +3051,32 @@ vy_run_iterator_find_lsn(struct vy_run_iterator *itr,
 	return 0;
 }
 
+bool
+vy_run_maybe_has_key(struct vy_run *run, const struct tuple *key,
+		     struct key_def *key_def)
+{
+	if (run->bloom_size == 0)
+		return true;
+	if (run->info.bloom == NULL) {
+		/* The bloom filter was evicted, load it back. */
+		if (vy_run_load_bloom(run) != 0) {
+			diag_log();
+			return true;
+		}
+	} else if (!rlist_empty(&run->in_bloom_lru)) {
+		run->bloom_last_used = ++run->env->index_cache_clock;
+		rlist_move_entry(&run->env->bloom_lru, run, in_bloom_lru);
+	}
+	struct tuple_bloom *bloom = run->info.bloom;
+	if (vy_stmt_type(key) == IPROTO_SELECT) {
+		const char *data = tuple_data(key);
+		uint32_t part_count = mp_decode_array(&data);
+		return tuple_bloom_maybe_has_key(bloom, data, part_count,
+						 key_def);
+	}
+	return tuple_bloom_maybe_has(bloom, key, key_def);
+}
+
 static NODISCARD int
 vy_run_iterator_do_seek(struct vy_run_iterator *itr,
 			enum iterator_type iterator_type,
@@ -1249,24 +3086,11 @@ vy_run_iterator_do_seek(struct vy_run_iterator *itr,
 
 	*ret = NULL;
 
-	struct tuple_bloom *bloom = run->info.bloom;
-	struct key_def *key_def = itr->key_def;
-	if (iterator_type == ITER_EQ && bloom != NULL) {
-		bool need_lookup;
-		if (vy_stmt_type(key) == IPROTO_SELECT) {
-			const char *data = tuple_data(key);
-			uint32_t part_count = mp_decode_array(&data);
-			need_lookup = tuple_bloom_maybe_has_key(bloom, data,
-							part_count, key_def);
-		} else {
-			need_lookup = tuple_bloom_maybe_has(bloom, key,
-							    key_def);
-		}
-		if (!need_lookup) {
-			itr->search_ended = true;
-			itr->stat->bloom_hit++;
-			return 0;
-		}
+	if (iterator_type == ITER_EQ &&
+	    !vy_run_maybe_has_key(run, key, itr->key_def)) {
+		itr->search_ended = true;
+		itr->stat->bloom_hit++;
+		return 0;
 	}
 
 	itr->stat->lookup++;
@@ -1288,7 +3112,7 @@ vy_run_iterator_do_seek(struct vy_run_iterator *itr,
 	}
 	if (iterator_type == ITER_EQ && !equal_found) {
 		vy_run_iterator_stop(itr);
-		if (bloom != NULL)
+		if (run->bloom_size > 0)
 			itr->stat->bloom_miss++;
 		return 0;
 	}
@@ -1305,8 +3129,11 @@ vy_run_iterator_do_seek(struct vy_run_iterator *itr,
 		 * given (special branch of code in vy_run_iterator_search),
 		 * so we need to make a step on previous key
 		 */
-		if (vy_run_iterator_next_pos(itr, iterator_type,
-					     &itr->curr_pos) > 0) {
+		rc = vy_run_iterator_next_pos(itr, iterator_type,
+					      &itr->curr_pos);
+		if (rc < 0)
+			return -1;
+		if (rc > 0) {
 			vy_run_iterator_stop(itr);
 			return 0;
 		}
@@ -1321,12 +3148,30 @@ vy_run_iterator_do_seek(struct vy_run_iterator *itr,
 		 * value >= given, so we need just to find proper lsn
 		 */
 	}
+	uint32_t found_page_no = itr->curr_pos.page_no;
+	rc = vy_run_iterator_skip_filtered(itr, iterator_type, &itr->curr_pos);
+	if (rc < 0)
+		return -1;
+	if (rc > 0) {
+		vy_run_iterator_stop(itr);
+		return 0;
+	}
 	if (itr->curr_stmt != NULL) {
 		tuple_unref(itr->curr_stmt);
 		itr->curr_stmt = NULL;
 	}
 	if (vy_run_iterator_read(itr, itr->curr_pos, &itr->curr_stmt) != 0)
 		return -1;
+	/*
+	 * The page the key was found in may have been skipped
+	 * by the filter.
+	 */
+	if (iterator_type == ITER_EQ &&
+	    itr->curr_pos.page_no != found_page_no &&
+	    vy_stmt_compare(itr->curr_stmt, key, itr->cmp_def) != 0) {
+		vy_run_iterator_stop(itr);
+		return 0;
+	}
 
 	return vy_run_iterator_find_lsn(itr, iterator_type, key, ret);
 }
@@ -1345,6 +3190,8 @@ vy_run_iterator_seek(struct vy_run_iterator *itr,
 	const struct tuple *check_eq_key = NULL;
 	int cmp;
 
+	vy_run_iterator_reset_read_ahead(itr);
+
 	if (slice->begin != NULL &&
 	    (iterator_type == ITER_GT || iterator_type == ITER_GE ||
 	     iterator_type == ITER_EQ)) {
@@ -1433,11 +3280,23 @@ vy_run_iterator_open(struct vy_run_iterator *itr,
 	itr->curr_pos.page_no = slice->run->info.page_count;
 	itr->curr_page = NULL;
 	itr->prev_page = NULL;
+	itr->filter = NULL;
+	itr->read_ahead_count = 0;
+	itr->read_ahead_window = 0;
+	itr->seq_page_count = 0;
 
 	itr->search_started = false;
 	itr->search_ended = false;
 }
 
+void
+vy_run_iterator_set_filter(struct vy_run_iterator *itr,
+			   const struct vy_run_filter *filter)
+{
+	assert(!itr->search_started);
+	itr->filter = filter;
+}
+
 /**
  * Advance a run iterator to the newest statement for the next key.
  * The statement is returned in @ret (NULL if EOF).
@@ -1462,8 +3321,11 @@ vy_run_iterator_next_key(struct vy_run_iterator *itr, struct tuple **ret)
 	do {
 		if (next_key != NULL)
 			tuple_unref(next_key);
-		if (vy_run_iterator_next_pos(itr, itr->iterator_type,
-					     &itr->curr_pos) != 0) {
+		int rc = vy_run_iterator_next_pos(itr, itr->iterator_type,
+						  &itr->curr_pos);
+		if (rc < 0)
+			return -1;
+		if (rc > 0) {
 			vy_run_iterator_stop(itr);
 			return 0;
 		}
@@ -1501,8 +3363,12 @@ vy_run_iterator_next_lsn(struct vy_run_iterator *itr, struct tuple **ret)
 	assert(itr->curr_pos.page_no < itr->slice->run->info.page_count);
 
 	struct vy_run_iterator_pos next_pos;
+	int rc;
 next:
-	if (vy_run_iterator_next_pos(itr, ITER_GE, &next_pos) != 0) {
+	rc = vy_run_iterator_next_pos(itr, ITER_GE, &next_pos);
+	if (rc < 0)
+		return -1;
+	if (rc > 0) {
 		vy_run_iterator_stop(itr);
 		return 0;
 	}
@@ -1527,6 +3393,26 @@ next:
 	return 0;
 }
 
+/**
+ * Append a statement read from the run to a history,
+ * replacing a stub with the tuple it refers to.
+ */
+static NODISCARD int
+vy_run_iterator_append(struct vy_run_iterator *itr, struct tuple *stmt,
+		       struct vy_history *history)
+{
+	if ((vy_stmt_flags(stmt) & VY_STMT_BLOB_REF) == 0)
+		return vy_history_append_stmt(history, stmt);
+	struct vy_run *run = itr->slice->run;
+	struct tuple *tuple = vy_run_blob_read(run->info.blobs,
+					       run->info.blob_count, stmt);
+	if (tuple == NULL)
+		return -1;
+	int rc = vy_history_append_stmt(history, tuple);
+	tuple_unref(tuple);
+	return rc;
+}
+
 NODISCARD int
 vy_run_iterator_next(struct vy_run_iterator *itr,
 		     struct vy_history *history)
@@ -1536,7 +3422,7 @@ vy_run_iterator_next(struct vy_run_iterator *itr,
 	if (vy_run_iterator_next_key(itr, &stmt) != 0)
 		return -1;
 	while (stmt != NULL) {
-		if (vy_history_append_stmt(history, stmt) != 0)
+		if (vy_run_iterator_append(itr, stmt, history) != 0)
 			return -1;
 		if (vy_history_is_terminal(history))
 			break;
@@ -1588,7 +3474,7 @@ vy_run_iterator_skip(struct vy_run_iterator *itr,
 	}
 
 	while (stmt != NULL) {
-		if (vy_history_append_stmt(history, stmt) != 0)
+		if (vy_run_iterator_append(itr, stmt, history) != 0)
 			return -1;
 		if (vy_history_is_terminal(history))
 			break;
@@ -1615,6 +3501,7 @@ vy_run_acct_page(struct vy_run *run, struct vy_page_info *page)
 	mp_next(&min_key_end);
 	run->page_index_size += sizeof(struct vy_page_info);
 	run->page_index_size += min_key_end - page->min_key;
+	run->page_index_size += vy_page_info_zone_map_size(page);
 	run->count.rows += page->row_count;
 	run->count.bytes += page->unpacked_size;
 	run->count.bytes_compressed += page->size;
@@ -1672,7 +3559,12 @@ vy_run_recover(struct vy_run *run, const char *dir,
 		goto fail_close;
 	}
 
-	if (vy_run_info_decode(&run->info, &xrow, path) != 0)
+	if (vy_run_info_decode(&run->info, &xrow, path) != 0 ||
+	    vy_run_load_zdict(run) != 0)
+		goto fail_close;
+	if (run->info.bloom != NULL)
+		run->bloom_size = tuple_bloom_size(run->info.bloom);
+	if (vy_run_alloc_page_index(run) != 0)
 		goto fail_close;
 
 	/* Allocate buffer for page info. */
@@ -1687,6 +3579,21 @@ vy_run_recover(struct vy_run *run, const char *dir,
 
 	for (uint32_t page_no = 0; page_no < run->info.page_count; page_no++) {
 		int rc = xlog_cursor_next_row(&cursor, &xrow);
+		if (rc > 0) {
+			/*
+			 * Page index blocks are written in separate
+			 * transactions, remember where they start.
+			 */
+			off_t offset = xlog_cursor_pos(&cursor);
+			rc = xlog_cursor_next_tx(&cursor);
+			if (rc == 0)
+				rc = xlog_cursor_next_row(&cursor, &xrow);
+			if (rc == 0 && page_no % VY_PAGE_INDEX_BLOCK_SIZE == 0) {
+				uint32_t block_no = page_no /
+						    VY_PAGE_INDEX_BLOCK_SIZE;
+				run->page_index[block_no].offset = offset;
+			}
+		}
 		if (rc != 0) {
 			if (rc > 0) {
 				/** To few pages in file */
@@ -1701,7 +3608,7 @@ vy_run_recover(struct vy_run *run, const char *dir,
 			goto fail_close;
 		}
 		if (xrow.type != VY_INDEX_PAGE_INFO) {
-			diag_set(ClientError, ER_INVALID_INDEX_FILE,
+			diag_set(ClientError, ER_INVALID_INDEX_FILE, path,
 				 tt_sprintf("Wrong xrow type "
 					    "(expected %d, got %u)",
 					    VY_INDEX_PAGE_INFO,
@@ -1723,6 +3630,14 @@ vy_run_recover(struct vy_run *run, const char *dir,
 	/* We don't need to keep metadata file open any longer. */
 	xlog_cursor_close(&cursor, false);
 
+	if (vy_run_build_page_index(run) != 0)
+		goto fail;
+	run->index_path = strdup(path);
+	if (run->index_path == NULL) {
+		diag_set(OutOfMemory, strlen(path) + 1, "strdup", "path");
+		goto fail;
+	}
+
 	/* Prepare data file for reading. */
 	vy_run_snprint_path(path, sizeof(path), dir,
 			    space_id, iid, run->id, VY_FILE_RUN);
@@ -1736,6 +3651,8 @@ vy_run_recover(struct vy_run *run, const char *dir,
 	}
 	run->fd = cursor.fd;
 	xlog_cursor_close(&cursor, true);
+	if (vy_run_open_blobs(run, dir, space_id, iid) != 0)
+		goto fail;
 	return 0;
 
 fail_close:
@@ -1747,21 +3664,229 @@ fail:
 	return -1;
 }
 
+/**
+ * Replace the body of a statement that is about to be written
+ * to a VY_PAGE_VERSION_PREFIX page with [shared, suffix] unless
+ * the statement is a restart point. The full body is remembered
+ * to compress the next statement against it.
+ */
+static int
+vy_run_writer_compress_stmt(struct vy_run_writer *writer,
+			    const struct vy_page_info *info,
+			    struct xrow_header *xrow)
+{
+	size_t size = 0;
+	for (int i = 0; i < xrow->bodycnt; i++)
+		size += xrow->body[i].iov_len;
+	char *body = region_alloc(&fiber()->gc, size);
+	if (body == NULL) {
+		diag_set(OutOfMemory, size, "region", "statement body");
+		return -1;
+	}
+	char *pos = body;
+	for (int i = 0; i < xrow->bodycnt; i++) {
+		memcpy(pos, xrow->body[i].iov_base, xrow->body[i].iov_len);
+		pos += xrow->body[i].iov_len;
+	}
+	bool is_restart = info->row_count % writer->restart_interval == 0;
+	size_t shared = 0;
+	if (!is_restart) {
+		const char *prev = writer->prev_body.rpos;
+		size_t max_shared = MIN(size, ibuf_used(&writer->prev_body));
+		while (shared < max_shared && body[shared] == prev[shared])
+			shared++;
+	}
+	ibuf_reset(&writer->prev_body);
+	if (ibuf_alloc(&writer->prev_body, size) == NULL) {
+		diag_set(OutOfMemory, size, "ibuf", "statement body");
+		return -1;
+	}
+	memcpy(writer->prev_body.rpos, body, size);
+	if (is_restart)
+		return 0;
+
+	size_t suffix_size = size - shared;
+	size_t encoded_size = mp_sizeof_array(2) + mp_sizeof_uint(shared) +
+			      mp_sizeof_bin(suffix_size);
+	pos = region_alloc(&fiber()->gc, encoded_size);
+	if (pos == NULL) {
+		diag_set(OutOfMemory, encoded_size, "region",
+			 "statement body");
+		return -1;
+	}
+	xrow->body[0].iov_base = pos;
+	xrow->body[0].iov_len = encoded_size;
+	xrow->bodycnt = 1;
+	pos = mp_encode_array(pos, 2);
+	pos = mp_encode_uint(pos, shared);
+	pos = mp_encode_bin(pos, body + shared, suffix_size);
+	assert(pos == (char *)xrow->body[0].iov_base + encoded_size);
+	return 0;
+}
+
+/**
+ * Make sure the writer has chunks for columns [0, @a count] of
+ * a columnar page.
+ */
+static int
+vy_run_writer_reserve_columns(struct vy_run_writer *writer, uint32_t count)
+{
+	if (count < writer->column_count)
+		return 0;
+	uint32_t new_count = MAX(count + 1, 2 * writer->column_count);
+	struct ibuf *columns = realloc(writer->columns,
+				       new_count * sizeof(*columns));
+	if (columns == NULL) {
+		diag_set(OutOfMemory, new_count * sizeof(*columns),
+			 "realloc", "page columns");
+		return -1;
+	}
+	for (uint32_t i = writer->column_count; i < new_count; i++)
+		ibuf_create(&columns[i], &cord()->slabc, 1024);
+	writer->columns = columns;
+	writer->column_count = new_count;
+	return 0;
+}
+
+/** Append @a size bytes at @a data to a chunk of a columnar page. */
+static int
+vy_run_writer_append_column(struct ibuf *column, const char *data,
+			    size_t size)
+{
+	char *pos = ibuf_alloc(column, size);
+	if (pos == NULL) {
+		diag_set(OutOfMemory, size, "ibuf", "page columns");
+		return -1;
+	}
+	memcpy(pos, data, size);
+	return 0;
+}
+
+/**
+ * Append a statement to the chunks of the current columnar
+ * page. The statement body produced by xrow_encode_dml() has
+ * the tuple, if any, in its own iovec, so the fields are split
+ * off without parsing the rest of the row.
+ */
+static int
+vy_run_writer_split_stmt(struct vy_run_writer *writer,
+			 struct vy_page_info *info,
+			 const struct xrow_header *xrow)
+{
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_header_encode(xrow, 0, iov, 0);
+	if (iovcnt < 0)
+		return -1;
+	/* Row header, body and the tuple array header. */
+	size_t prefix_size = 0;
+	const char *field = NULL;
+	uint32_t field_count = 0;
+	if (iovcnt == 3 && mp_typeof(*(char *)iov[2].iov_base) == MP_ARRAY) {
+		field = iov[2].iov_base;
+		field_count = mp_decode_array(&field);
+		iov[2].iov_len = field - (char *)iov[2].iov_base;
+	}
+	for (int i = 0; i < iovcnt; i++)
+		prefix_size += iov[i].iov_len;
+	if (vy_run_writer_reserve_columns(writer, field_count) != 0)
+		return -1;
+
+	struct ibuf *rows = &writer->columns[0];
+	size_t size = mp_sizeof_binl(prefix_size) + prefix_size +
+		      mp_sizeof_uint(field_count);
+	char *pos = ibuf_alloc(rows, size);
+	if (pos == NULL) {
+		diag_set(OutOfMemory, size, "ibuf", "page columns");
+		return -1;
+	}
+	pos = mp_encode_binl(pos, prefix_size);
+	for (int i = 0; i < iovcnt; i++) {
+		memcpy(pos, iov[i].iov_base, iov[i].iov_len);
+		pos += iov[i].iov_len;
+	}
+	pos = mp_encode_uint(pos, field_count);
+	assert(pos == rows->wpos);
+	info->rows_size += prefix_size;
+
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field_end = field;
+		mp_next(&field_end);
+		if (vy_run_writer_append_column(&writer->columns[i + 1], field,
+						field_end - field) != 0)
+			return -1;
+		info->rows_size += field_end - field;
+		field = field_end;
+	}
+	return 0;
+}
+
+/**
+ * Write the chunks of the current columnar page as a single
+ * VY_RUN_COLUMNS row and return its size.
+ */
+static ssize_t
+vy_run_writer_write_columns(struct vy_run_writer *writer)
+{
+	uint32_t count = writer->column_count;
+	while (count > 1 && ibuf_used(&writer->columns[count - 1]) == 0)
+		count--;
+	size_t size = mp_sizeof_map(1) + mp_sizeof_uint(VY_COLUMNS_DATA) +
+		      mp_sizeof_array(count);
+	for (uint32_t i = 0; i < count; i++)
+		size += mp_sizeof_bin(ibuf_used(&writer->columns[i]));
+	char *pos = region_alloc(&fiber()->gc, size);
+	if (pos == NULL) {
+		diag_set(OutOfMemory, size, "region", "page columns");
+		return -1;
+	}
+	struct xrow_header xrow;
+	memset(&xrow, 0, sizeof(xrow));
+	xrow.type = VY_RUN_COLUMNS;
+	xrow.body->iov_base = pos;
+	xrow.body->iov_len = size;
+	xrow.bodycnt = 1;
+	pos = mp_encode_map(pos, 1);
+	pos = mp_encode_uint(pos, VY_COLUMNS_DATA);
+	pos = mp_encode_array(pos, count);
+	for (uint32_t i = 0; i < count; i++) {
+		struct ibuf *column = &writer->columns[i];
+		pos = mp_encode_bin(pos, column->rpos, ibuf_used(column));
+		ibuf_reset(column);
+	}
+	assert(pos == (char *)xrow.body->iov_base + size);
+	return xlog_write_row(&writer->data_xlog, &xrow);
+}
+
 /* dump statement to the run page buffers (stmt header and data) */
 static int
-vy_run_dump_stmt(const struct tuple *value, struct xlog *data_xlog,
-		 struct vy_page_info *info, struct key_def *key_def,
-		 bool is_primary)
+vy_run_dump_stmt(struct vy_run_writer *writer, const struct tuple *value,
+		 const struct vy_blob_ref *ref)
 {
+	struct vy_run *run = writer->run;
+	struct vy_page_info *info = run->page_info + run->info.page_count;
+	struct key_def *key_def = writer->cmp_def;
 	struct xrow_header xrow;
-	int rc = (is_primary ?
-		  vy_stmt_encode_primary(value, key_def, 0, &xrow) :
-		  vy_stmt_encode_secondary(value, key_def, &xrow));
+	int rc;
+	if (ref != NULL)
+		rc = vy_stmt_encode_blob_ref(value, key_def, ref, &xrow);
+	else if (writer->iid == 0)
+		rc = vy_stmt_encode_primary(value, key_def, 0, &xrow);
+	else
+		rc = vy_stmt_encode_secondary(value, key_def, &xrow);
 	if (rc != 0)
 		return -1;
+	if (writer->columnar) {
+		if (vy_run_writer_split_stmt(writer, info, &xrow) != 0)
+			return -1;
+		info->row_count++;
+		return 0;
+	}
+	if (writer->restart_interval > 0 &&
+	    vy_run_writer_compress_stmt(writer, info, &xrow) != 0)
+		return -1;
 
 	ssize_t row_size;
-	if ((row_size = xlog_write_row(data_xlog, &xrow)) < 0)
+	if ((row_size = xlog_write_row(&writer->data_xlog, &xrow)) < 0)
 		return -1;
 
 	info->unpacked_size += row_size;
@@ -1849,10 +3974,18 @@ vy_page_info_encode(const struct vy_page_info *page_info,
 	mp_next(&tmp);
 	min_key_size = tmp - page_info->min_key;
 
+	/* Plain pages are written in the original format. */
+	bool is_plain = page_info->version == VY_PAGE_VERSION_PLAIN;
+	bool is_prefix = page_info->version == VY_PAGE_VERSION_PREFIX;
+	bool is_columnar = page_info->version == VY_PAGE_VERSION_COLUMNAR;
+	size_t zone_map_size = vy_page_info_zone_map_size(page_info);
+	uint32_t map_size = 6 + !is_plain + is_prefix + is_columnar +
+			    (zone_map_size > 0);
+
 	/* calc tuple size */
 	uint32_t size;
 	/* 3 items: page offset, size, and map */
-	size = mp_sizeof_map(6) +
+	size = mp_sizeof_map(map_size) +
 	       mp_sizeof_uint(VY_PAGE_INFO_OFFSET) +
 	       mp_sizeof_uint(page_info->offset) +
 	       mp_sizeof_uint(VY_PAGE_INFO_SIZE) +
@@ -1865,6 +3998,20 @@ vy_page_info_encode(const struct vy_page_info *page_info,
 	       mp_sizeof_uint(page_info->unpacked_size) +
 	       mp_sizeof_uint(VY_PAGE_INFO_ROW_INDEX_OFFSET) +
 	       mp_sizeof_uint(page_info->row_index_offset);
+	if (!is_plain) {
+		size += mp_sizeof_uint(VY_PAGE_INFO_VERSION) +
+			mp_sizeof_uint(page_info->version);
+	}
+	if (is_prefix) {
+		size += mp_sizeof_uint(VY_PAGE_INFO_RESTART_INTERVAL) +
+			mp_sizeof_uint(page_info->restart_interval);
+	}
+	if (is_columnar) {
+		size += mp_sizeof_uint(VY_PAGE_INFO_ROWS_SIZE) +
+			mp_sizeof_uint(page_info->rows_size);
+	}
+	if (zone_map_size > 0)
+		size += mp_sizeof_uint(VY_PAGE_INFO_ZONE_MAP) + zone_map_size;
 
 	char *pos = region_alloc(region, size);
 	if (pos == NULL) {
@@ -1875,7 +4022,7 @@ vy_page_info_encode(const struct vy_page_info *page_info,
 	memset(xrow, 0, sizeof(*xrow));
 	/* encode page */
 	xrow->body->iov_base = pos;
-	pos = mp_encode_map(pos, 6);
+	pos = mp_encode_map(pos, map_size);
 	pos = mp_encode_uint(pos, VY_PAGE_INFO_OFFSET);
 	pos = mp_encode_uint(pos, page_info->offset);
 	pos = mp_encode_uint(pos, VY_PAGE_INFO_SIZE);
@@ -1889,6 +4036,23 @@ vy_page_info_encode(const struct vy_page_info *page_info,
 	pos = mp_encode_uint(pos, page_info->unpacked_size);
 	pos = mp_encode_uint(pos, VY_PAGE_INFO_ROW_INDEX_OFFSET);
 	pos = mp_encode_uint(pos, page_info->row_index_offset);
+	if (!is_plain) {
+		pos = mp_encode_uint(pos, VY_PAGE_INFO_VERSION);
+		pos = mp_encode_uint(pos, page_info->version);
+	}
+	if (is_prefix) {
+		pos = mp_encode_uint(pos, VY_PAGE_INFO_RESTART_INTERVAL);
+		pos = mp_encode_uint(pos, page_info->restart_interval);
+	}
+	if (is_columnar) {
+		pos = mp_encode_uint(pos, VY_PAGE_INFO_ROWS_SIZE);
+		pos = mp_encode_uint(pos, page_info->rows_size);
+	}
+	if (zone_map_size > 0) {
+		pos = mp_encode_uint(pos, VY_PAGE_INFO_ZONE_MAP);
+		memcpy(pos, page_info->zone_map, zone_map_size);
+		pos += zone_map_size;
+	}
 	xrow->body->iov_len = (void *)pos - xrow->body->iov_base;
 	xrow->bodycnt = 1;
 
@@ -1931,6 +4095,15 @@ vy_stmt_stat_encode(const struct vy_stmt_stat *stat, char *buf)
 	return buf;
 }
 
+/** Return the run info key the bloom filter is stored under. */
+static enum vy_run_info_key
+vy_run_info_bloom_key(const struct vy_run_info *run_info)
+{
+	assert(!run_info->bloom->is_legacy);
+	return run_info->bloom->type == BLOOM_SPLIT_BLOCK ?
+	       VY_RUN_INFO_BLOOM_SPLIT_BLOCK : VY_RUN_INFO_BLOOM;
+}
+
 /**
  * Encode vy_run_info as xrow
  * Allocates using region alloc
@@ -1956,6 +4129,10 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	uint32_t key_count = 6;
 	if (run_info->bloom != NULL)
 		key_count++;
+	if (run_info->blob_count > 0)
+		key_count++;
+	if (run_info->zdict != NULL)
+		key_count++;
 
 	size_t size = mp_sizeof_map(key_count);
 	size += mp_sizeof_uint(VY_RUN_INFO_MIN_KEY) + min_key_size;
@@ -1967,10 +4144,23 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	size += mp_sizeof_uint(VY_RUN_INFO_PAGE_COUNT) +
 		mp_sizeof_uint(run_info->page_count);
 	if (run_info->bloom != NULL)
-		size += mp_sizeof_uint(VY_RUN_INFO_BLOOM) +
+		size += mp_sizeof_uint(vy_run_info_bloom_key(run_info)) +
 			tuple_bloom_size(run_info->bloom);
 	size += mp_sizeof_uint(VY_RUN_INFO_STMT_STAT) +
 		vy_stmt_stat_sizeof(&run_info->stmt_stat);
+	if (run_info->blob_count > 0) {
+		size += mp_sizeof_uint(VY_RUN_INFO_BLOBS) +
+			mp_sizeof_array(run_info->blob_count);
+		for (uint32_t i = 0; i < run_info->blob_count; i++) {
+			const struct vy_run_blob *blob = &run_info->blobs[i];
+			size += mp_sizeof_array(2) +
+				mp_sizeof_uint(blob->id) +
+				mp_sizeof_uint(blob->ref_bytes);
+		}
+	}
+	if (run_info->zdict != NULL)
+		size += mp_sizeof_uint(VY_RUN_INFO_ZSTD_DICT) +
+			mp_sizeof_bin(run_info->zdict_size);
 
 	char *pos = region_alloc(&fiber()->gc, size);
 	if (pos == NULL) {
@@ -1994,11 +4184,26 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	pos = mp_encode_uint(pos, VY_RUN_INFO_PAGE_COUNT);
 	pos = mp_encode_uint(pos, run_info->page_count);
 	if (run_info->bloom != NULL) {
-		pos = mp_encode_uint(pos, VY_RUN_INFO_BLOOM);
+		pos = mp_encode_uint(pos, vy_run_info_bloom_key(run_info));
 		pos = tuple_bloom_encode(run_info->bloom, pos);
 	}
 	pos = mp_encode_uint(pos, VY_RUN_INFO_STMT_STAT);
 	pos = vy_stmt_stat_encode(&run_info->stmt_stat, pos);
+	if (run_info->blob_count > 0) {
+		pos = mp_encode_uint(pos, VY_RUN_INFO_BLOBS);
+		pos = mp_encode_array(pos, run_info->blob_count);
+		for (uint32_t i = 0; i < run_info->blob_count; i++) {
+			const struct vy_run_blob *blob = &run_info->blobs[i];
+			pos = mp_encode_array(pos, 2);
+			pos = mp_encode_uint(pos, blob->id);
+			pos = mp_encode_uint(pos, blob->ref_bytes);
+		}
+	}
+	if (run_info->zdict != NULL) {
+		pos = mp_encode_uint(pos, VY_RUN_INFO_ZSTD_DICT);
+		pos = mp_encode_bin(pos, run_info->zdict,
+				    run_info->zdict_size);
+	}
 	xrow->body->iov_len = (void *)pos - xrow->body->iov_base;
 	xrow->bodycnt = 1;
 	xrow->type = VY_INDEX_RUN_INFO;
@@ -2008,7 +4213,10 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 /* vy_run_info }}} */
 
 /**
- * Write run index to file.
+ * Write run index to file. Each page index block is written
+ * in a separate transaction so that it can be loaded on demand,
+ * see vy_run_read_page_index_block(). Allocates the fences of
+ * the run page index and fills in their offsets.
  */
 static int
 vy_run_write_index(struct vy_run *run, const char *dirpath,
@@ -2020,6 +4228,9 @@ vy_run_write_index(struct vy_run *run, const char *dirpath,
 
 	say_info("writing `%s'", path);
 
+	if (vy_run_alloc_page_index(run) != 0)
+		return -1;
+
 	struct xlog index_xlog;
 	struct xlog_meta meta;
 	xlog_meta_create(&meta, XLOG_META_TYPE_INDEX, &INSTANCE_UUID,
@@ -2039,7 +4250,16 @@ vy_run_write_index(struct vy_run *run, const char *dirpath,
 		goto fail_rollback;
 
 	for (uint32_t page_no = 0; page_no < run->info.page_count; ++page_no) {
-		struct vy_page_info *page_info = vy_run_page_info(run, page_no);
+		if (page_no % VY_PAGE_INDEX_BLOCK_SIZE == 0) {
+			region_truncate(region, mem_used);
+			if (xlog_tx_commit(&index_xlog) < 0 ||
+			    xlog_flush(&index_xlog) < 0)
+				goto fail;
+			uint32_t block_no = page_no / VY_PAGE_INDEX_BLOCK_SIZE;
+			run->page_index[block_no].offset = index_xlog.offset;
+			xlog_tx_begin(&index_xlog);
+		}
+		struct vy_page_info *page_info = run->page_info + page_no;
 		if (vy_page_info_encode(page_info, &xrow) < 0) {
 			goto fail_rollback;
 		}
@@ -2062,6 +4282,11 @@ vy_run_write_index(struct vy_run *run, const char *dirpath,
 		goto fail;
 
 	xlog_close(&index_xlog, false);
+	run->index_path = strdup(path);
+	if (run->index_path == NULL) {
+		diag_set(OutOfMemory, strlen(path) + 1, "strdup", "path");
+		return -1;
+	}
 	return 0;
 
 fail_rollback:
@@ -2077,7 +4302,12 @@ int
 vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 		     const char *dirpath, uint32_t space_id, uint32_t iid,
 		     struct key_def *cmp_def, struct key_def *key_def,
-		     uint64_t page_size, double bloom_fpr)
+		     uint64_t page_size, double bloom_fpr,
+		     int64_t blob_threshold, struct vy_run_blob *src_blobs,
+		     uint32_t src_blob_count, uint32_t restart_interval,
+		     bool columnar, uint64_t zone_map_fields,
+		     const char *zdict, uint32_t zdict_size,
+		     uint32_t zdict_train_size)
 {
 	memset(writer, 0, sizeof(*writer));
 	writer->run = run;
@@ -2088,18 +4318,75 @@ vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 	writer->key_def = key_def;
 	writer->page_size = page_size;
 	writer->bloom_fpr = bloom_fpr;
+	writer->blob_threshold = blob_threshold;
+	writer->src_blobs = src_blobs;
+	writer->src_blob_count = src_blob_count;
+	writer->restart_interval = restart_interval;
+	writer->columnar = columnar;
+	if (zone_map_fields != 0) {
+		uint32_t count = bit_count_u64(zone_map_fields);
+		writer->zone_map = calloc(count, sizeof(*writer->zone_map));
+		if (writer->zone_map == NULL) {
+			diag_set(OutOfMemory, count * sizeof(*writer->zone_map),
+				 "calloc", "struct vy_zone_map_entry");
+			return -1;
+		}
+		for (uint32_t i = 0; zone_map_fields != 0; i++,
+		     zone_map_fields >>= 1) {
+			if ((zone_map_fields & 1) == 0)
+				continue;
+			struct vy_zone_map_entry *entry =
+				&writer->zone_map[writer->zone_map_size++];
+			entry->fieldno = i;
+			entry->type = MP_NIL;
+			ibuf_create(&entry->min, &cord()->slabc, 64);
+			ibuf_create(&entry->max, &cord()->slabc, 64);
+		}
+	}
 	if (bloom_fpr < 1) {
 		writer->bloom = tuple_bloom_builder_new(key_def->part_count);
-		if (writer->bloom == NULL)
+		if (writer->bloom == NULL) {
+			free(writer->zone_map);
 			return -1;
+		}
+	}
+	if (zdict != NULL) {
+		assert(run->info.zdict == NULL);
+		run->info.zdict = malloc(zdict_size);
+		if (run->info.zdict == NULL) {
+			diag_set(OutOfMemory, zdict_size, "malloc",
+				 "zstd dictionary");
+			goto fail;
+		}
+		memcpy(run->info.zdict, zdict, zdict_size);
+		run->info.zdict_size = zdict_size;
+		/* 3 is compression level, see xlog_tx_write_zstd(). */
+		writer->zcdict = ZSTD_createCDict(zdict, zdict_size, 3);
+		if (writer->zcdict == NULL) {
+			diag_set(ClientError, ER_COMPRESSION,
+				 "failed to load dictionary");
+			goto fail;
+		}
 	}
+	writer->zdict_train_size = zdict_train_size;
+	ibuf_create(&writer->zdict_samples, &cord()->slabc, 16 * 1024);
+	ibuf_create(&writer->zdict_sample_sizes, &cord()->slabc, 1024);
 	xlog_clear(&writer->data_xlog);
 	ibuf_create(&writer->row_index_buf, &cord()->slabc,
 		    4096 * sizeof(uint32_t));
+	ibuf_create(&writer->prev_body, &cord()->slabc, 1024);
 	run->info.min_lsn = INT64_MAX;
 	run->info.max_lsn = -1;
 	assert(run->page_info == NULL);
 	return 0;
+fail:
+	if (writer->bloom != NULL)
+		tuple_bloom_builder_delete(writer->bloom);
+	free(writer->zone_map);
+	free(run->info.zdict);
+	run->info.zdict = NULL;
+	run->info.zdict_size = 0;
+	return -1;
 }
 
 /**
@@ -2123,6 +4410,7 @@ vy_run_writer_create_xlog(struct vy_run_writer *writer)
 	if (xlog_create(&writer->data_xlog, path, 0, &meta) != 0)
 		return -1;
 	writer->data_xlog.rate_limit = writer->run->env->snap_io_rate_limit;
+	writer->data_xlog.zcdict = writer->zcdict;
 	return 0;
 }
 
@@ -2154,10 +4442,280 @@ vy_run_writer_start_page(struct vy_run_writer *writer,
 	struct vy_page_info *page = run->page_info + run->info.page_count;
 	if (vy_page_info_create(page, writer->data_xlog.offset, key) != 0)
 		return -1;
+	if (writer->columnar) {
+		page->version = VY_PAGE_VERSION_COLUMNAR;
+	} else if (writer->restart_interval > 0) {
+		page->version = VY_PAGE_VERSION_PREFIX;
+		page->restart_interval = writer->restart_interval;
+	}
+	enum mp_type zone_map_type = MP_NIL;
+	if (writer->last_stmt != NULL &&
+	    vy_stmt_compare(first_stmt, writer->last_stmt,
+			    writer->cmp_def) == 0) {
+		/*
+		 * The history of the key spans two pages. A filter
+		 * may skip neither of them, because otherwise it
+		 * would only skip a part of the history.
+		 */
+		struct vy_page_info *prev = page - 1;
+		run->page_index_size -= vy_page_info_zone_map_size(prev);
+		free(prev->zone_map);
+		prev->zone_map = NULL;
+		zone_map_type = MP_EXT;
+	}
+	vy_run_writer_reset_zone_map(writer, zone_map_type);
 	xlog_tx_begin(&writer->data_xlog);
 	return 0;
 }
 
+/**
+ * Append the tuple of a statement to the blob file of the run
+ * being written and return its location in @a ref.
+ */
+static int
+vy_run_writer_append_blob(struct vy_run_writer *writer,
+			  const struct tuple *stmt, struct vy_blob_ref *ref)
+{
+	struct vy_run *run = writer->run;
+	struct vy_run_blob *blob = vy_run_blob_find(run->info.blobs,
+						    run->info.blob_count,
+						    run->id);
+	if (blob == NULL) {
+		char path[PATH_MAX];
+		vy_blob_snprint_path(path, sizeof(path), writer->dirpath,
+				     writer->space_id, writer->iid,
+				     run->id, run->id);
+		say_info("writing `%s'", path);
+		blob = vy_run_add_blob(run, run->id);
+		if (blob == NULL)
+			return -1;
+		blob->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (blob->fd < 0) {
+			diag_set(SystemError, "failed to create file '%s'",
+				 path);
+			return -1;
+		}
+	}
+	uint32_t size;
+	const char *data = tuple_data_range(stmt, &size);
+	if (fio_writen(blob->fd, data, size) != 0) {
+		diag_set(SystemError, "failed to write blob file");
+		return -1;
+	}
+	ref->blob_id = blob->id;
+	ref->offset = blob->size;
+	ref->size = size;
+	blob->size += size;
+	blob->ref_bytes += size;
+	return 0;
+}
+
+/**
+ * Link a blob file of a source run to the run being written
+ * unless it has already been linked.
+ */
+static int
+vy_run_writer_link_blob(struct vy_run_writer *writer,
+			const struct vy_run_blob *src,
+			const struct vy_blob_ref *ref)
+{
+	struct vy_run *run = writer->run;
+	struct vy_run_blob *blob = vy_run_blob_find(run->info.blobs,
+						    run->info.blob_count,
+						    src->id);
+	if (blob == NULL) {
+		char src_path[PATH_MAX];
+		char path[PATH_MAX];
+		vy_blob_snprint_path(src_path, sizeof(src_path),
+				     writer->dirpath, writer->space_id,
+				     writer->iid, src->run_id, src->id);
+		vy_blob_snprint_path(path, sizeof(path), writer->dirpath,
+				     writer->space_id, writer->iid,
+				     run->id, src->id);
+		if (link(src_path, path) != 0) {
+			diag_set(SystemError, "failed to link file '%s' "
+				 "to '%s'", src_path, path);
+			return -1;
+		}
+		blob = vy_run_add_blob(run, src->id);
+		if (blob == NULL)
+			return -1;
+		blob->fd = dup(src->fd);
+		if (blob->fd < 0) {
+			diag_set(SystemError, "failed to dup file '%s'",
+				 path);
+			return -1;
+		}
+		blob->size = src->size;
+	}
+	blob->ref_bytes += ref->size;
+	return 0;
+}
+
+/**
+ * Store the tuple of a primary index statement in a blob file
+ * if it is big enough, see index_opts::blob_threshold.
+ *
+ * A stub read from a source run is carried over along with
+ * a link to its blob file, unless less than half of the blob
+ * is referenced by the source runs. In the latter case the
+ * tuple is moved to the blob file of the new run so that the
+ * old file is reclaimed once the source runs are deleted.
+ *
+ * On success @a ref is set to the location of the tuple to
+ * store in the run instead, or its size is set to 0 if the
+ * statement should be written as is.
+ */
+static int
+vy_run_writer_prepare_blob(struct vy_run_writer *writer,
+			   struct tuple *stmt, struct vy_blob_ref *ref)
+{
+	ref->size = 0;
+	if (vy_stmt_flags(stmt) & VY_STMT_BLOB_REF) {
+		if (vy_stmt_blob_ref(stmt, ref) != 0)
+			return -1;
+		struct vy_run_blob *src;
+		src = vy_run_blob_find(writer->src_blobs,
+				       writer->src_blob_count, ref->blob_id);
+		if (src == NULL) {
+			diag_set(ClientError, ER_INVALID_RUN_FILE,
+				 tt_sprintf("Invalid blob reference: %s",
+					    vy_stmt_str(stmt)));
+			return -1;
+		}
+		if (src->ref_bytes * 2 >= src->size)
+			return vy_run_writer_link_blob(writer, src, ref);
+		struct tuple *tuple = vy_run_blob_read(writer->src_blobs,
+						       writer->src_blob_count,
+						       stmt);
+		if (tuple == NULL)
+			return -1;
+		int rc = vy_run_writer_append_blob(writer, tuple, ref);
+		tuple_unref(tuple);
+		return rc;
+	}
+	enum iproto_type type = vy_stmt_type(stmt);
+	if (writer->iid == 0 && writer->blob_threshold > 0 &&
+	    (type == IPROTO_REPLACE || type == IPROTO_INSERT) &&
+	    stmt->bsize >= writer->blob_threshold)
+		return vy_run_writer_append_blob(writer, stmt, ref);
+	return 0;
+}
+
+/** Store a copy of a MsgPack value in a zone map buffer. */
+static int
+vy_zone_map_entry_set(struct ibuf *buf, const char *value)
+{
+	const char *end = value;
+	mp_next(&end);
+	size_t size = end - value;
+	ibuf_reset(buf);
+	char *data = ibuf_alloc(buf, size);
+	if (data == NULL) {
+		diag_set(OutOfMemory, size, "ibuf", "zone map");
+		return -1;
+	}
+	memcpy(data, value, size);
+	return 0;
+}
+
+/** Set the type of all zone map entries of a run writer. */
+static void
+vy_run_writer_reset_zone_map(struct vy_run_writer *writer,
+			     enum mp_type type)
+{
+	for (uint32_t i = 0; i < writer->zone_map_size; i++)
+		writer->zone_map[i].type = type;
+}
+
+/**
+ * Account the zone map fields of a statement written to the
+ * current page. A page containing anything but full REPLACE or
+ * INSERT statements can't be skipped by a filter, because they
+ * don't carry the value of a key, so it gets no zone map.
+ */
+static int
+vy_run_writer_update_zone_map(struct vy_run_writer *writer,
+			      struct tuple *stmt)
+{
+	enum iproto_type type = vy_stmt_type(stmt);
+	bool is_replace = (type == IPROTO_REPLACE ||
+			   type == IPROTO_INSERT) &&
+			  (vy_stmt_flags(stmt) & VY_STMT_BLOB_REF) == 0;
+	for (uint32_t i = 0; i < writer->zone_map_size; i++) {
+		struct vy_zone_map_entry *entry = &writer->zone_map[i];
+		if (entry->type == MP_EXT)
+			continue;
+		const char *value = is_replace ?
+				    tuple_field(stmt, entry->fieldno) : NULL;
+		enum mp_type value_type = value != NULL ?
+					  vy_zone_map_type(value) : MP_EXT;
+		if (value_type == MP_EXT ||
+		    (entry->type != MP_NIL && entry->type != value_type)) {
+			entry->type = MP_EXT;
+			continue;
+		}
+		if (entry->type == MP_NIL) {
+			if (vy_zone_map_entry_set(&entry->min, value) != 0 ||
+			    vy_zone_map_entry_set(&entry->max, value) != 0)
+				return -1;
+			entry->type = value_type;
+		} else if (vy_zone_map_value_cmp(value,
+						 entry->min.rpos) < 0) {
+			if (vy_zone_map_entry_set(&entry->min, value) != 0)
+				return -1;
+		} else if (vy_zone_map_value_cmp(value,
+						 entry->max.rpos) > 0) {
+			if (vy_zone_map_entry_set(&entry->max, value) != 0)
+				return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Encode the zone map of the current page and store it in
+ * the page info.
+ */
+static int
+vy_run_writer_encode_zone_map(struct vy_run_writer *writer,
+			      struct vy_page_info *page)
+{
+	uint32_t count = 0;
+	size_t size = 0;
+	for (uint32_t i = 0; i < writer->zone_map_size; i++) {
+		struct vy_zone_map_entry *entry = &writer->zone_map[i];
+		if (entry->type != MP_INT && entry->type != MP_STR)
+			continue;
+		count++;
+		size += mp_sizeof_uint(entry->fieldno) + mp_sizeof_array(2) +
+			ibuf_used(&entry->min) + ibuf_used(&entry->max);
+	}
+	if (count == 0)
+		return 0;
+	size += mp_sizeof_map(count);
+	char *pos = malloc(size);
+	if (pos == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "page zone map");
+		return -1;
+	}
+	page->zone_map = pos;
+	pos = mp_encode_map(pos, count);
+	for (uint32_t i = 0; i < writer->zone_map_size; i++) {
+		struct vy_zone_map_entry *entry = &writer->zone_map[i];
+		if (entry->type != MP_INT && entry->type != MP_STR)
+			continue;
+		pos = mp_encode_uint(pos, entry->fieldno);
+		pos = mp_encode_array(pos, 2);
+		memcpy(pos, entry->min.rpos, ibuf_used(&entry->min));
+		pos += ibuf_used(&entry->min);
+		memcpy(pos, entry->max.rpos, ibuf_used(&entry->max));
+		pos += ibuf_used(&entry->max);
+	}
+	assert(pos == page->zone_map + size);
+	return 0;
+}
+
 /**
  * Write @a stmt into a current page.
  * @param writer Run writer.
@@ -2189,8 +4747,12 @@ vy_run_writer_write_to_page(struct vy_run_writer *writer, struct tuple *stmt)
 		return -1;
 	}
 	*offset = page->unpacked_size;
-	if (vy_run_dump_stmt(stmt, &writer->data_xlog, page,
-			     writer->cmp_def, writer->iid == 0) != 0)
+	if (vy_run_writer_update_zone_map(writer, stmt) != 0)
+		return -1;
+	struct vy_blob_ref ref;
+	if (vy_run_writer_prepare_blob(writer, stmt, &ref) != 0)
+		return -1;
+	if (vy_run_dump_stmt(writer, stmt, ref.size > 0 ? &ref : NULL) != 0)
 		return -1;
 	int64_t lsn = vy_stmt_lsn(stmt);
 	run->info.min_lsn = MIN(run->info.min_lsn, lsn);
@@ -2199,6 +4761,86 @@ vy_run_writer_write_to_page(struct vy_run_writer *writer, struct tuple *stmt)
 	return 0;
 }
 
+enum {
+	/**
+	 * Samples to train a dictionary on are taken until they
+	 * are this many times bigger than the dictionary, which
+	 * is what zstd recommends.
+	 */
+	VY_ZDICT_SAMPLES_RATIO = 100,
+};
+
+/**
+ * Save the data of the page being written, which is still
+ * buffered in the xlog, as a sample to train the compression
+ * dictionary on.
+ */
+static int
+vy_run_writer_sample_page(struct vy_run_writer *writer)
+{
+	if (writer->zdict_train_size == 0 ||
+	    ibuf_used(&writer->zdict_samples) >=
+	    (size_t)writer->zdict_train_size * VY_ZDICT_SAMPLES_RATIO)
+		return 0;
+	struct obuf *obuf = &writer->data_xlog.obuf;
+	size_t size = obuf_size(obuf) - XLOG_FIXHEADER_SIZE;
+	char *sample = ibuf_alloc(&writer->zdict_samples, size);
+	size_t *sample_size = ibuf_alloc(&writer->zdict_sample_sizes,
+					 sizeof(size_t));
+	if (sample == NULL || sample_size == NULL) {
+		diag_set(OutOfMemory, size, "ibuf", "zstd dictionary sample");
+		return -1;
+	}
+	*sample_size = size;
+	/* Skip the fixheader reserved in front of the rows. */
+	size_t offset = XLOG_FIXHEADER_SIZE;
+	for (struct iovec *iov = obuf->iov; iov->iov_len; ++iov) {
+		memcpy(sample, (char *)iov->iov_base + offset,
+		       iov->iov_len - offset);
+		sample += iov->iov_len - offset;
+		offset = 0;
+		if (iov == obuf->iov + obuf->pos)
+			break;
+	}
+	return 0;
+}
+
+/**
+ * Train a compression dictionary on the pages sampled by the
+ * writer and store it in vy_run::new_zdict. Too few samples
+ * are not an error: the dictionary is not created then.
+ */
+static int
+vy_run_writer_train_zdict(struct vy_run_writer *writer)
+{
+	struct vy_run *run = writer->run;
+	uint32_t sample_count = ibuf_used(&writer->zdict_sample_sizes) /
+				sizeof(size_t);
+	if (writer->zdict_train_size == 0 || sample_count == 0)
+		return 0;
+	char *zdict = malloc(writer->zdict_train_size);
+	if (zdict == NULL) {
+		diag_set(OutOfMemory, writer->zdict_train_size, "malloc",
+			 "zstd dictionary");
+		return -1;
+	}
+	size_t size = ZDICT_trainFromBuffer(zdict, writer->zdict_train_size,
+				writer->zdict_samples.rpos,
+				(size_t *)writer->zdict_sample_sizes.rpos,
+				sample_count);
+	if (ZDICT_isError(size)) {
+		say_verbose("failed to train zstd dictionary for run %lld: "
+			    "%s", (long long)run->id,
+			    ZDICT_getErrorName(size));
+		free(zdict);
+		return 0;
+	}
+	assert(run->new_zdict == NULL);
+	run->new_zdict = zdict;
+	run->new_zdict_size = size;
+	return 0;
+}
+
 /**
  * Finish a current page.
  * @param writer Run writer.
@@ -2215,15 +4857,31 @@ vy_run_writer_end_page(struct vy_run_writer *writer)
 	assert(ibuf_used(&writer->row_index_buf) ==
 	       sizeof(uint32_t) * page->row_count);
 
-	struct xrow_header xrow;
-	uint32_t *row_index = (uint32_t *)writer->row_index_buf.rpos;
-	if (vy_row_index_encode(row_index, page->row_count, &xrow) < 0)
+	if (vy_run_writer_encode_zone_map(writer, page) != 0)
 		return -1;
-	ssize_t written = xlog_write_row(&writer->data_xlog, &xrow);
-	if (written < 0)
+
+	ssize_t written;
+	if (writer->columnar) {
+		/* Row offsets are restored along with rows. */
+		written = vy_run_writer_write_columns(writer);
+		if (written < 0)
+			return -1;
+		page->unpacked_size = written;
+	} else {
+		struct xrow_header xrow;
+		uint32_t *row_index = (uint32_t *)writer->row_index_buf.rpos;
+		if (vy_row_index_encode(row_index, page->row_count,
+					&xrow) < 0)
+			return -1;
+		written = xlog_write_row(&writer->data_xlog, &xrow);
+		if (written < 0)
+			return -1;
+		page->row_index_offset = page->unpacked_size;
+		page->unpacked_size += written;
+	}
+
+	if (vy_run_writer_sample_page(writer) != 0)
 		return -1;
-	page->row_index_offset = page->unpacked_size;
-	page->unpacked_size += written;
 
 	written = xlog_tx_commit(&writer->data_xlog);
 	if (written == 0)
@@ -2250,7 +4908,11 @@ vy_run_writer_append_stmt(struct vy_run_writer *writer, struct tuple *stmt)
 		goto out;
 	if (vy_run_writer_write_to_page(writer, stmt) != 0)
 		goto out;
-	if (obuf_size(&writer->data_xlog.obuf) >= writer->page_size &&
+	struct vy_run *run = writer->run;
+	size_t page_size = writer->columnar ?
+		run->page_info[run->info.page_count].rows_size :
+		obuf_size(&writer->data_xlog.obuf);
+	if (page_size >= writer->page_size &&
 	    vy_run_writer_end_page(writer) != 0)
 		goto out;
 	rc = 0;
@@ -2275,6 +4937,18 @@ vy_run_writer_destroy(struct vy_run_writer *writer, bool reuse_fd)
 	if (writer->bloom != NULL)
 		tuple_bloom_builder_delete(writer->bloom);
 	ibuf_destroy(&writer->row_index_buf);
+	ibuf_destroy(&writer->prev_body);
+	ibuf_destroy(&writer->zdict_samples);
+	ibuf_destroy(&writer->zdict_sample_sizes);
+	ZSTD_freeCDict(writer->zcdict);
+	for (uint32_t i = 0; i < writer->column_count; i++)
+		ibuf_destroy(&writer->columns[i]);
+	free(writer->columns);
+	for (uint32_t i = 0; i < writer->zone_map_size; i++) {
+		ibuf_destroy(&writer->zone_map[i].min);
+		ibuf_destroy(&writer->zone_map[i].max);
+	}
+	free(writer->zone_map);
 }
 
 int
@@ -2315,14 +4989,27 @@ vy_run_writer_commit(struct vy_run_writer *writer)
 	    xlog_rename(&writer->data_xlog) < 0)
 		goto out;
 
+	struct vy_run_blob *blob = vy_run_blob_find(run->info.blobs,
+						    run->info.blob_count,
+						    run->id);
+	if (blob != NULL && fdatasync(blob->fd) < 0) {
+		diag_set(SystemError, "failed to sync blob file");
+		goto out;
+	}
+
 	if (writer->bloom != NULL) {
 		run->info.bloom = tuple_bloom_new(writer->bloom,
 						  writer->bloom_fpr);
 		if (run->info.bloom == NULL)
 			goto out;
+		run->bloom_size = tuple_bloom_size(run->info.bloom);
 	}
 	if (vy_run_write_index(run, writer->dirpath,
-			       writer->space_id, writer->iid) != 0)
+			       writer->space_id, writer->iid) != 0 ||
+	    vy_run_build_page_index(run) != 0)
+		goto out;
+	if (vy_run_load_zdict(run) != 0 ||
+	    vy_run_writer_train_zdict(writer) != 0)
 		goto out;
 
 	run->fd = writer->data_xlog.fd;
@@ -2339,6 +5026,77 @@ vy_run_writer_abort(struct vy_run_writer *writer)
 	vy_run_writer_destroy(writer, false);
 }
 
+/**
+ * Account a stub found while rebuilding a run index to
+ * the blob file it refers to.
+ */
+static int
+vy_run_rebuild_blob_ref(struct vy_run *run, const struct tuple *stub)
+{
+	struct vy_blob_ref ref;
+	if (vy_stmt_blob_ref(stub, &ref) != 0)
+		return -1;
+	struct vy_run_blob *blob = vy_run_blob_find(run->info.blobs,
+						    run->info.blob_count,
+						    ref.blob_id);
+	if (blob == NULL) {
+		blob = vy_run_add_blob(run, ref.blob_id);
+		if (blob == NULL)
+			return -1;
+	}
+	blob->ref_bytes += ref.size;
+	return 0;
+}
+
+/** Rows restored from a columnar page while rebuilding an index. */
+struct vy_run_rebuild_rows {
+	/** Position of the next row. */
+	const char *pos;
+	/** End of the rows. */
+	const char *end;
+	/** Size of all rows, 0 if the page isn't columnar. */
+	size_t size;
+};
+
+/**
+ * Read the next statement of a page. If the page is columnar,
+ * it is restored on the fiber region on the first call, and
+ * then its rows are returned one by one.
+ */
+static int
+vy_run_rebuild_next_row(struct xlog_cursor *cursor,
+			struct vy_run_rebuild_rows *rows,
+			struct xrow_header *xrow)
+{
+	if (rows->pos == rows->end) {
+		int rc = xlog_cursor_next_row(cursor, xrow);
+		if (rc != 0 || xrow->type != VY_RUN_COLUMNS)
+			return rc;
+		if (rows->size != 0) {
+			diag_set(ClientError, ER_INVALID_RUN_FILE,
+				 "Invalid page columns");
+			return -1;
+		}
+		struct vy_page_columns columns;
+		if (vy_page_columns_create(&columns, xrow) != 0)
+			return -1;
+		if (columns.row_count == 0)
+			return xlog_cursor_next_row(cursor, xrow);
+		char *data = region_alloc(&fiber()->gc, columns.rows_size);
+		if (data == NULL) {
+			diag_set(OutOfMemory, columns.rows_size, "region",
+				 "page rows");
+			return -1;
+		}
+		if (vy_page_columns_restore(&columns, data, NULL) != 0)
+			return -1;
+		rows->pos = data;
+		rows->end = data + columns.rows_size;
+		rows->size = columns.rows_size;
+	}
+	return xrow_header_decode(xrow, &rows->pos, rows->end);
+}
+
 int
 vy_run_rebuild_index(struct vy_run *run, const char *dir,
 		     uint32_t space_id, uint32_t iid,
@@ -2387,19 +5145,57 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 		uint32_t page_row_count = 0;
 		uint64_t page_row_index_offset = 0;
 		uint64_t row_offset = xlog_cursor_tx_pos(&cursor);
+		/*
+		 * Prefix-compressed pages have restart points at
+		 * a fixed distance, so the distance is the number
+		 * of the second uncompressed row of the page.
+		 */
+		bool page_is_compressed = false;
+		uint32_t page_restart_interval = 0;
+		const char *prev_body = NULL;
+		uint32_t prev_body_size = 0;
+		struct vy_run_rebuild_rows rows = {NULL, NULL, 0};
 
 		struct xrow_header xrow;
-		while ((rc = xlog_cursor_next_row(&cursor, &xrow)) == 0) {
+		while ((rc = vy_run_rebuild_next_row(&cursor, &rows,
+						     &xrow)) == 0) {
 			if (xrow.type == VY_RUN_ROW_INDEX) {
 				page_row_index_offset = row_offset;
 				row_offset = xlog_cursor_tx_pos(&cursor);
 				continue;
 			}
+			if (vy_page_row_is_compressed(&xrow)) {
+				if (prev_body == NULL) {
+					diag_set(ClientError,
+						 ER_INVALID_RUN_FILE,
+						 "Invalid prefix-compressed "
+						 "statement");
+					goto close_err;
+				}
+				if (vy_page_row_restore(&xrow, prev_body,
+							prev_body_size) != 0)
+					goto close_err;
+				page_is_compressed = true;
+			} else if (page_row_count > 0 &&
+				   page_restart_interval == 0) {
+				page_restart_interval = page_row_count;
+			}
+			if (xrow.bodycnt == 1) {
+				prev_body = xrow.body[0].iov_base;
+				prev_body_size = xrow.body[0].iov_len;
+			} else {
+				prev_body = NULL;
+			}
 			++page_row_count;
 			struct tuple *tuple = vy_stmt_decode(&xrow, cmp_def,
 							     format, iid == 0);
 			if (tuple == NULL)
 				goto close_err;
+			if ((vy_stmt_flags(tuple) & VY_STMT_BLOB_REF) != 0 &&
+			    vy_run_rebuild_blob_ref(run, tuple) != 0) {
+				tuple_unref(tuple);
+				goto close_err;
+			}
 			if (bloom_builder != NULL) {
 				uint32_t hashed_parts = prev_tuple == NULL ? 0 :
 					tuple_common_key_parts(prev_tuple,
@@ -2434,6 +5230,14 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 		info->size = next_page_offset - page_offset;
 		info->unpacked_size = xlog_cursor_tx_pos(&cursor);
 		info->row_index_offset = page_row_index_offset;
+		if (rows.size > 0) {
+			info->version = VY_PAGE_VERSION_COLUMNAR;
+			info->rows_size = rows.size;
+		} else if (page_is_compressed) {
+			info->version = VY_PAGE_VERSION_PREFIX;
+			info->restart_interval = page_restart_interval > 0 ?
+					page_restart_interval : page_row_count;
+		}
 		++run->info.page_count;
 		vy_run_acct_page(run, info);
 	}
@@ -2460,10 +5264,14 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 						  opts->bloom_fpr);
 		if (run->info.bloom == NULL)
 			goto close_err;
+		run->bloom_size = tuple_bloom_size(run->info.bloom);
 		tuple_bloom_builder_delete(bloom_builder);
 		bloom_builder = NULL;
 	}
 
+	if (vy_run_open_blobs(run, dir, space_id, iid) != 0)
+		goto close_err;
+
 	/* New run index is ready for write, unlink old file if exists */
 	vy_run_snprint_path(path, sizeof(path), dir,
 			    space_id, iid, run->id, VY_FILE_INDEX);
@@ -2472,7 +5280,8 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 			 path);
 		goto close_err;
 	}
-	if (vy_run_write_index(run, dir, space_id, iid) != 0)
+	if (vy_run_write_index(run, dir, space_id, iid) != 0 ||
+	    vy_run_build_page_index(run) != 0)
 		goto close_err;
 	return 0;
 close_err:
@@ -2487,6 +5296,72 @@ close_err:
 	return -1;
 }
 
+int
+vy_run_foreach_blob_file(const char *dir, uint32_t space_id,
+			 uint32_t iid, int64_t run_id,
+			 int (*cb)(const char *path, void *arg), void *arg)
+{
+	char path[PATH_MAX];
+	int dir_len = vy_lsm_snprint_path(path, sizeof(path), dir,
+					  space_id, iid);
+	char *names;
+	if (coio_readdir(path, &names) < 0) {
+		if (errno == ENOENT)
+			return 0;
+		diag_set(SystemError, "failed to read directory '%s'", path);
+		return -1;
+	}
+	char prefix[32];
+	size_t prefix_len = snprintf(prefix, sizeof(prefix), "%020lld.",
+				     (long long)run_id);
+	const char *suffix = ".blob";
+	size_t suffix_len = strlen(suffix);
+	int rc = 0;
+	char *saveptr;
+	for (char *name = strtok_r(names, "\n", &saveptr); name != NULL;
+	     name = strtok_r(NULL, "\n", &saveptr)) {
+		size_t len = strlen(name);
+		if (len <= prefix_len + suffix_len ||
+		    strncmp(name, prefix, prefix_len) != 0 ||
+		    strcmp(name + len - suffix_len, suffix) != 0)
+			continue;
+		snprintf(path + dir_len, sizeof(path) - dir_len, "/%s", name);
+		rc = cb(path, arg);
+		if (rc != 0)
+			break;
+	}
+	free(names);
+	return rc;
+}
+
+/**
+ * Remove a run file, throttling the removal if configured,
+ * see gc_remove_file().
+ */
+static int
+vy_run_remove_file(const char *path)
+{
+	if (gc_remove_file(path))
+		return 0;
+	if (coio_unlink(path) < 0) {
+		if (errno != ENOENT) {
+			say_syserror("error while removing %s", path);
+			return -1;
+		}
+	} else
+		say_info("removed %s", path);
+	return 0;
+}
+
+static int
+vy_run_remove_blob_file(const char *path, void *arg)
+{
+	int *ret = arg;
+	if (vy_run_remove_file(path) != 0)
+		*ret = -1;
+	return 0;
+}
+
 int
 vy_run_remove_files(const char *dir, uint32_t space_id,
 		    uint32_t iid, int64_t run_id)
@@ -2499,17 +5374,49 @@ vy_run_remove_files(const char *dir, uint32_t space_id,
 	for (int type = 0; type < vy_file_MAX; type++) {
 		vy_run_snprint_path(path, sizeof(path), dir,
 				    space_id, iid, run_id, type);
-		if (coio_unlink(path) < 0) {
-			if (errno != ENOENT) {
-				say_syserror("error while removing %s", path);
-				ret = -1;
-			}
-		} else
-			say_info("removed %s", path);
+		if (vy_run_remove_file(path) != 0)
+			ret = -1;
+	}
+	if (vy_run_foreach_blob_file(dir, space_id, iid, run_id,
+				     vy_run_remove_blob_file, &ret) != 0) {
+		diag_log();
+		ret = -1;
 	}
 	return ret;
 }
 
+/**
+ * Return the info of a page of the run a slice stream reads.
+ * Slice streams are used by worker threads, which must not
+ * touch the shared page index cache, so evictable blocks are
+ * read into the stream's private copy.
+ * @return the page info or NULL on error (diag is set).
+ */
+static struct vy_page_info *
+vy_slice_stream_page_info(struct vy_slice_stream *stream, uint32_t page_no)
+{
+	struct vy_run *run = stream->slice->run;
+	uint32_t block_no = page_no / VY_PAGE_INDEX_BLOCK_SIZE;
+	struct vy_page_index_fence *fence = &run->page_index[block_no];
+	struct vy_page_index_block *block;
+	if (!run->is_index_cached || fence->offset < 0) {
+		/* The block can't be evicted. */
+		block = fence->block;
+		assert(block != NULL);
+	} else if (stream->block != NULL &&
+		   stream->block->block_no == block_no) {
+		block = stream->block;
+	} else {
+		block = vy_run_read_page_index_block(run, block_no);
+		if (block == NULL)
+			return NULL;
+		if (stream->block != NULL)
+			vy_page_index_block_delete(stream->block);
+		stream->block = block;
+	}
+	return &block->pages[page_no % VY_PAGE_INDEX_BLOCK_SIZE];
+}
+
 /**
  * Read a page with stream->page_no from the run and save it in stream->page.
  * Support function of slice stream.
@@ -2526,7 +5433,10 @@ vy_slice_stream_read_page(struct vy_slice_stream *stream)
 	if (zdctx == NULL)
 		return -1;
 
-	struct vy_page_info *page_info = vy_run_page_info(run, stream->page_no);
+	struct vy_page_info *page_info = vy_slice_stream_page_info(stream,
+							stream->page_no);
+	if (page_info == NULL)
+		return -1;
 	stream->page = vy_page_new(page_info);
 	if (stream->page == NULL)
 		return -1;
@@ -2642,9 +5552,7 @@ vy_slice_stream_next(struct vy_stmt_stream *virt_stream, struct tuple **ret)
 	stream->pos_in_page++;
 
 	/* Check whether the position is out of page */
-	struct vy_page_info *page_info = vy_run_page_info(stream->slice->run,
-							  stream->page_no);
-	if (stream->pos_in_page >= page_info->row_count) {
+	if (stream->pos_in_page >= stream->page->row_count) {
 		/**
 		 * Out of page. Free page, move the position to the next page
 		 * and * nullify page pointer to read it on the next iteration.
@@ -2674,6 +5582,10 @@ vy_slice_stream_close(struct vy_stmt_stream *virt_stream)
 		tuple_unref(stream->tuple);
 		stream->tuple = NULL;
 	}
+	if (stream->block != NULL) {
+		vy_page_index_block_delete(stream->block);
+		stream->block = NULL;
+	}
 }
 
 static const struct vy_stmt_stream_iface vy_slice_stream_iface = {
@@ -2694,6 +5606,7 @@ vy_slice_stream_open(struct vy_slice_stream *stream, struct vy_slice *slice,
 	stream->pos_in_page = 0; /* We'll find it later */
 	stream->page = NULL;
 	stream->tuple = NULL;
+	stream->block = NULL;
 
 	stream->slice = slice;
 	stream->cmp_def = cmp_def;
@@ -51,6 +51,38 @@ extern "C" {
 
 struct vy_history;
 struct vy_run_reader;
+struct mh_vy_page_t;
+
+/**
+ * Cache of decompressed run pages shared by all run iterators.
+ * Unlike the tuple cache (vy_cache), which stores chains of
+ * statements of a particular LSM tree, it caches whole pages,
+ * so that pages hit by many lookups are neither read from disk
+ * nor decompressed more than once. Pages are evicted in LRU
+ * order as soon as the cache size exceeds the quota.
+ */
+struct vy_page_cache {
+	/** Cached pages, indexed by run id and page number. */
+	struct mh_vy_page_t *hash;
+	/** LRU list of cached pages, most recently used first. */
+	struct rlist lru;
+	/** Memory used by cached pages, in bytes. */
+	size_t mem_used;
+	/** Max memory the cache may use, 0 disables the cache. */
+	size_t quota;
+	/** Number of lookups that found a page in the cache. */
+	int64_t hit;
+	/** Number of lookups that had to read a page from disk. */
+	int64_t miss;
+	/** Number of pages evicted from the cache. */
+	int64_t evict;
+	/**
+	 * Page reads currently in progress, linked by
+	 * vy_page_read_pending::in_cache. Used to avoid reading
+	 * the same page from several fibers at once.
+	 */
+	struct rlist pending;
+};
 
 /** Part of vinyl environment for run read/write */
 struct vy_run_env {
@@ -69,6 +101,65 @@ struct vy_run_env {
 	 * processing the next read request.
 	 */
 	int next_reader;
+	/** Cache of decompressed pages. */
+	struct vy_page_cache page_cache;
+	/**
+	 * Latency of page reads issued from tx. Used by
+	 * the regulator to throttle compaction, see
+	 * vy_regulator::read_latency_budget.
+	 */
+	struct latency read_latency;
+	/**
+	 * Max memory that pages read ahead by sequential scans
+	 * may take, 0 disables read-ahead.
+	 */
+	size_t read_ahead_quota;
+	/** Memory taken by pages read ahead, see vy_page_read_ahead. */
+	size_t read_ahead_mem;
+	/** Number of pages read ahead. */
+	int64_t read_ahead_pages;
+	/**
+	 * Max memory that page index blocks and bloom filters
+	 * of runs may take, 0 means no limit. When it's exceeded,
+	 * least recently used blocks and bloom filters are
+	 * evicted and loaded back from index files on demand,
+	 * see vy_run_page_info().
+	 */
+	size_t index_cache_quota;
+	/**
+	 * Memory taken by page index blocks and bloom filters
+	 * of runs added to LSM trees, see vy_run_cache_index().
+	 */
+	size_t page_index_mem;
+	size_t bloom_mem;
+	/** Evictable page index blocks, least recently used last. */
+	struct rlist page_index_lru;
+	/** Runs with evictable bloom filters, least recently used last. */
+	struct rlist bloom_lru;
+	/** Counter used to order entries of the two LRU lists. */
+	uint64_t index_cache_clock;
+};
+
+/**
+ * A blob file referenced by a primary index run, see
+ * index_opts::blob_threshold. A run writes big tuples to its
+ * own blob file, which has the same id as the run. When a stub
+ * is carried over from one run to another by compaction, the
+ * blob file is hard-linked to the new run under the name
+ * <run_id>.<blob_id>.blob so the file is deleted only when all
+ * runs referencing it are.
+ */
+struct vy_run_blob {
+	/** ID of the blob, i.e. ID of the run that created it. */
+	int64_t id;
+	/** ID of the run the file is linked to. */
+	int64_t run_id;
+	/** Size of the file. */
+	uint64_t size;
+	/** Total size of the tuples referenced by the run. */
+	uint64_t ref_bytes;
+	/** File descriptor, not persisted. */
+	int fd;
 };
 
 /**
@@ -89,6 +180,45 @@ struct vy_run_info {
 	struct tuple_bloom *bloom;
 	/** Statement statistics. */
 	struct vy_stmt_stat stmt_stat;
+	/** Blob files referenced by the run. */
+	struct vy_run_blob *blobs;
+	/** Number of entries in the blobs array. */
+	uint32_t blob_count;
+	/**
+	 * Zstd dictionary the run pages are compressed with,
+	 * NULL if none.
+	 */
+	char *zdict;
+	/** Size of the zdict. */
+	uint32_t zdict_size;
+};
+
+/** Format of statements stored in a run page. */
+enum vy_page_version {
+	/** Each statement is a self-contained xrow. */
+	VY_PAGE_VERSION_PLAIN = 1,
+	/**
+	 * Statement bodies are prefix-compressed, like keys in
+	 * LevelDB blocks. Every vy_page_info::restart_interval-th
+	 * row (a restart point) is stored as is, while the body
+	 * of any other row is replaced with [shared, suffix]: the
+	 * number of leading bytes it has in common with the body
+	 * of the previous row, and the rest of it as MP_BIN. Row
+	 * headers are never compressed.
+	 */
+	VY_PAGE_VERSION_PREFIX = 2,
+	/**
+	 * Statements are split into columns (PAX layout). A page
+	 * consists of a single VY_RUN_COLUMNS row, which holds an
+	 * array of chunks. The first chunk stores for each row
+	 * [prefix, field_count]: the row header and the body up
+	 * to the tuple fields as MP_BIN, and the number of tuple
+	 * fields. Chunk i + 1 stores field i of all rows that
+	 * have it. Each chunk holds values of the same kind, so
+	 * it compresses better than rows. The page is converted
+	 * back to rows when it is read from disk.
+	 */
+	VY_PAGE_VERSION_COLUMNAR = 3,
 };
 
 /**
@@ -107,6 +237,91 @@ struct vy_page_info {
 	char *min_key;
 	/** Offset of the row index in the page. */
 	uint32_t row_index_offset;
+	/** Page format version, see enum vy_page_version. */
+	uint32_t version;
+	/**
+	 * VY_PAGE_VERSION_PREFIX only: every restart_interval-th
+	 * row of the page is stored in full.
+	 */
+	uint32_t restart_interval;
+	/**
+	 * VY_PAGE_VERSION_COLUMNAR only: size of the page rows
+	 * restored from columns.
+	 */
+	uint32_t rows_size;
+	/**
+	 * Zone map of the page: MsgPack map {fieldno: [min, max]}
+	 * of the non-key fields every statement of the page has a
+	 * value of, see vy_run_writer::zone_map. NULL if the page
+	 * has no zone map.
+	 */
+	char *zone_map;
+};
+
+/**
+ * Predicate on a non-key field checked against page zone maps,
+ * see vy_run_iterator_set_filter(). The bounds are inclusive
+ * MsgPack integers or strings, NULL stands for no bound.
+ * Strings are compared byte-wise.
+ */
+struct vy_run_filter {
+	/** Zero-based number of the field. */
+	uint32_t fieldno;
+	/** Lower bound of the field value or NULL. */
+	const char *min;
+	/** Upper bound of the field value or NULL. */
+	const char *max;
+};
+
+/**
+ * Number of pages in a block of a run page index. The index
+ * file stores each block in a separate xlog tx so that it can
+ * be read separately, see vy_page_index_fence::offset.
+ */
+enum { VY_PAGE_INDEX_BLOCK_SIZE = 128 };
+
+/**
+ * Block of VY_PAGE_INDEX_BLOCK_SIZE consecutive entries of
+ * a run page index. Blocks of runs added to LSM trees may be
+ * evicted to free memory and are loaded back on demand.
+ */
+struct vy_page_index_block {
+	/** Run the block belongs to. */
+	struct vy_run *run;
+	/** Number of the block in the run page index. */
+	uint32_t block_no;
+	/** Number of pages in the block. */
+	uint32_t page_count;
+	/** Memory taken by the page infos, see vy_page_info_size(). */
+	size_t mem;
+	/** Value of vy_run_env::index_cache_clock on last access. */
+	uint64_t last_used;
+	/**
+	 * Link in vy_run_env::page_index_lru. Empty if the block
+	 * can't be evicted.
+	 */
+	struct rlist in_lru;
+	/** Pages of the block. */
+	struct vy_page_info pages[0];
+};
+
+/**
+ * Top level entry of a run page index, one per block. Fences
+ * are always kept in memory: they are enough to find the block
+ * a key belongs to.
+ */
+struct vy_page_index_fence {
+	/** Minimal key stored in the first page of the block. */
+	char *min_key;
+	/**
+	 * Offset of the xlog tx in the index file the block
+	 * starts with or -1 if the block doesn't start a tx, as
+	 * is the case for index files written before blocks
+	 * were introduced. Such blocks are never evicted.
+	 */
+	off_t offset;
+	/** The block or NULL if it's evicted. */
+	struct vy_page_index_block *block;
 };
 
 /**
@@ -117,8 +332,33 @@ struct vy_run {
 	struct vy_run_env *env;
 	/** Info about the run stored in the index file. */
 	struct vy_run_info info;
-	/** Info about the run pages stored in the index file. */
+	/**
+	 * Info about the run pages, only used while the run is
+	 * being written or loaded. Then it's split into blocks,
+	 * see vy_run::page_index.
+	 */
 	struct vy_page_info *page_info;
+	/**
+	 * Two-level page index: VY_PAGE_INDEX_BLOCK_SIZE pages
+	 * per fence, see vy_run_page_info().
+	 */
+	struct vy_page_index_fence *page_index;
+	/** Path to the index file, used to load evicted metadata. */
+	char *index_path;
+	/** Size of the bloom filter, even if it's evicted. */
+	size_t bloom_size;
+	/** Value of vy_run_env::index_cache_clock on bloom access. */
+	uint64_t bloom_last_used;
+	/**
+	 * Link in vy_run_env::bloom_lru. Empty if the bloom
+	 * filter isn't loaded or can't be evicted.
+	 */
+	struct rlist in_bloom_lru;
+	/**
+	 * Set if the page index and the bloom filter of the run
+	 * are accounted to vy_run_env, see vy_run_cache_index().
+	 */
+	bool is_index_cached;
 	/** Run data file. */
 	int fd;
 	/** Unique ID of this run. */
@@ -144,6 +384,11 @@ struct vy_run {
 	 * it last time.
 	 */
 	uint32_t dump_count;
+	/**
+	 * Set if the run files are stored on the capacity
+	 * storage tier, see vy_lsm_env::cold_path.
+	 */
+	bool is_cold;
 	/**
 	 * Run reference counter, the run is deleted once it hits 0.
 	 * A new run is created with the reference counter set to 1.
@@ -166,6 +411,19 @@ struct vy_run {
 	struct rlist in_unused;
 	/** Link in vy_lsm::runs list. */
 	struct rlist in_lsm;
+	/** Pages of this run stored in the page cache. */
+	struct rlist cached_pages;
+	/** Digested vy_run_info::zdict, used to read pages. */
+	ZSTD_DDict *zddict;
+	/**
+	 * Dictionary trained on the pages of this run by the run
+	 * writer. It is handed over to the LSM tree when the run
+	 * is written and used for the next runs of the tree, see
+	 * vy_lsm::zdict.
+	 */
+	char *new_zdict;
+	/** Size of the new_zdict. */
+	uint32_t new_zdict_size;
 };
 
 /**
@@ -223,6 +481,11 @@ struct vy_run_iterator_pos {
 	uint32_t pos_in_page;
 };
 
+/** Max number of pages a run iterator may read ahead. */
+enum { VY_RUN_READ_AHEAD_MAX = 8 };
+
+struct vy_page_read_ahead;
+
 /**
  * Return statements from vy_run based on initial search key,
  * iteration order and view lsn.
@@ -279,6 +542,20 @@ struct vy_run_iterator {
 	 */
 	struct vy_page *curr_page;
 	struct vy_page *prev_page;
+	/** Predicate used to skip pages or NULL. */
+	const struct vy_run_filter *filter;
+	/**
+	 * Pages read ahead by a sequential scan, in scan order.
+	 * An array rather than a list, because run iterators are
+	 * moved with memcpy() by the read iterator.
+	 */
+	struct vy_page_read_ahead *read_ahead[VY_RUN_READ_AHEAD_MAX];
+	/** Number of entries in the read_ahead array. */
+	int read_ahead_count;
+	/** Number of pages to read ahead, 0 if not reading ahead. */
+	int read_ahead_window;
+	/** Number of page switches since the last seek. */
+	int seq_page_count;
 	/** Is false until first .._get or .._next_.. method is called */
 	bool search_started;
 	/** Search is finished, you will not get more values from iterator */
@@ -293,12 +570,36 @@ struct vy_page {
 	uint32_t page_no;
 	/** Size of page data in memory, i.e. unpacked. */
 	uint32_t unpacked_size;
+	/**
+	 * Sizes of page data in the run file and after
+	 * decompression, copied from vy_page_info for statistics.
+	 */
+	uint32_t disk_size;
+	uint32_t decompressed_size;
 	/** Number of statements in the page. */
 	uint32_t row_count;
+	/**
+	 * Distance between restart points of a prefix-compressed
+	 * page, 0 if statements are stored as is.
+	 */
+	uint32_t restart_interval;
 	/** Array of row offsets. */
 	uint32_t *row_index;
 	/** Pointer to the page data. */
 	char *data;
+	/**
+	 * Reference counter. A page is referenced by each run
+	 * iterator that has it loaded and by the page cache.
+	 */
+	int refs;
+	/** ID of the run the page belongs to. */
+	int64_t run_id;
+	/** Set if the page is stored in the page cache. */
+	bool in_cache;
+	/** Link in vy_page_cache::lru. */
+	struct rlist in_lru;
+	/** Link in vy_run::cached_pages. */
+	struct rlist in_run;
 };
 
 /**
@@ -317,6 +618,28 @@ vy_run_env_create(struct vy_run_env *env, int read_threads);
 void
 vy_run_env_destroy(struct vy_run_env *env);
 
+/**
+ * Set the size of the page cache of a vinyl run environment,
+ * evicting pages that don't fit anymore.
+ */
+void
+vy_run_env_set_page_cache(struct vy_run_env *env, size_t quota);
+
+/**
+ * Set the max memory that pages read ahead by sequential
+ * scans may take, 0 disables read-ahead.
+ */
+void
+vy_run_env_set_read_ahead(struct vy_run_env *env, size_t quota);
+
+/**
+ * Set the max memory that page index blocks and bloom filters
+ * may take, evicting those that don't fit anymore. 0 means no
+ * limit.
+ */
+void
+vy_run_env_set_index_cache(struct vy_run_env *env, size_t quota);
+
 /**
  * Enable coio reads for a vinyl run environment.
  *
@@ -327,6 +650,10 @@ vy_run_env_destroy(struct vy_run_env *env);
  * The number of background reader threads is configured when
  * the environment is created, see vy_run_env_create().
  *
+ * If the calling cord has an io_uring instance, no threads
+ * are started: the run iterator submits reads to the ring
+ * and waits for them without blocking other fibers.
+ *
  * Subsequent calls to this function will silently return.
  */
 void
@@ -338,11 +665,56 @@ vy_run_env_enable_coio(struct vy_run_env *env);
 size_t
 vy_run_bloom_size(struct vy_run *run);
 
+/**
+ * Check the run bloom filter to see if the run may store
+ * statements matching a key. The key may be partial, in which
+ * case the filter of the key prefix is checked.
+ *
+ * @retval true if there may be matching statements in the run
+ *  or the run has no bloom filter.
+ * @retval false if there are definitely no matching statements.
+ */
+bool
+vy_run_maybe_has_key(struct vy_run *run, const struct tuple *key,
+		     struct key_def *key_def);
+
+/**
+ * Account the page index and the bloom filter of a run to
+ * the run environment and make them evictable. Called from
+ * tx when the run is added to an LSM tree.
+ */
+void
+vy_run_cache_index(struct vy_run *run);
+
+/**
+ * Load an evicted page index block of a run, see
+ * vy_run_page_info(). Returns NULL on error.
+ */
+struct vy_page_index_block *
+vy_run_load_page_index_block(struct vy_run *run, uint32_t block_no);
+
+/**
+ * Return the info of a run page, loading the page index block
+ * it belongs to from disk if it was evicted. May only be called
+ * from tx for runs added to LSM trees. The returned pointer
+ * stays valid until the fiber yields or infos of pages from
+ * two other blocks are looked up. Returns NULL on error.
+ */
 static inline struct vy_page_info *
 vy_run_page_info(struct vy_run *run, uint32_t pos)
 {
 	assert(pos < run->info.page_count);
-	return &run->page_info[pos];
+	uint32_t block_no = pos / VY_PAGE_INDEX_BLOCK_SIZE;
+	struct vy_page_index_block *block = run->page_index[block_no].block;
+	if (unlikely(block == NULL)) {
+		block = vy_run_load_page_index_block(run, block_no);
+		if (block == NULL)
+			return NULL;
+	} else if (!rlist_empty(&block->in_lru)) {
+		block->last_used = ++run->env->index_cache_clock;
+		rlist_move_entry(&run->env->page_index_lru, block, in_lru);
+	}
+	return &block->pages[pos % VY_PAGE_INDEX_BLOCK_SIZE];
 }
 
 static inline bool
@@ -442,8 +814,50 @@ vy_run_snprint_path(char *buf, int size, const char *dir,
 	return total;
 }
 
+static inline int
+vy_blob_snprint_path(char *buf, int size, const char *dir,
+		     uint32_t space_id, uint32_t iid,
+		     int64_t run_id, int64_t blob_id)
+{
+	int total = 0;
+	SNPRINT(total, vy_lsm_snprint_path, buf, size,
+		dir, (unsigned)space_id, (unsigned)iid);
+	SNPRINT(total, snprintf, buf, size, "/%020lld.%020lld.blob",
+		(long long)run_id, (long long)blob_id);
+	return total;
+}
+
+/**
+ * Invoke @a cb for the path of each blob file linked to a run
+ * with the given id. Stops at the first callback returning
+ * non-zero and returns its value. Returns 0 if the run has no
+ * blob files, -1 if the directory can't be read.
+ */
+int
+vy_run_foreach_blob_file(const char *dir, uint32_t space_id,
+			 uint32_t iid, int64_t run_id,
+			 int (*cb)(const char *path, void *arg), void *arg);
+
+/**
+ * Find a blob file by id in an array.
+ * Returns NULL if there's no such blob.
+ */
+struct vy_run_blob *
+vy_run_blob_find(struct vy_run_blob *blobs, uint32_t blob_count,
+		 int64_t blob_id);
+
+/**
+ * Read the tuple a stub refers to from one of the given blob
+ * files. Returns a new statement replacing the stub, see
+ * vy_stmt_new_from_blob(), or NULL on error. In tx the read is
+ * offloaded to coio unless tx has an io_uring instance.
+ */
+struct tuple *
+vy_run_blob_read(struct vy_run_blob *blobs, uint32_t blob_count,
+		 const struct tuple *stub);
+
 /**
- * Remove all files (data, index) corresponding to a run
+ * Remove all files (data, index, blobs) corresponding to a run
  * with the given id. Return 0 on success, -1 if unlink()
  * failed.
  */
@@ -499,6 +913,21 @@ vy_slice_wait_pinned(struct vy_slice *slice)
 		fiber_cond_wait(&slice->pin_cond);
 }
 
+/**
+ * Estimate the number of statements of a slice that match
+ * @key and iterator @type. The estimate is taken from the page
+ * index only, which is a binary search, so it is accurate up
+ * to a page: the slice is assumed to have the same number of
+ * statements in each page.
+ *
+ * Returns 0 and sets @rows on success, -1 if a page index
+ * block fails to load.
+ */
+int
+vy_slice_estimate_rows(struct vy_slice *slice, enum iterator_type type,
+		       const struct tuple *key, struct key_def *cmp_def,
+		       double *rows);
+
 /**
  * Cut a sub-slice of @slice starting at @begin and ending at @end.
  * Return 0 on success, -1 on OOM.
@@ -525,6 +954,25 @@ vy_run_iterator_open(struct vy_run_iterator *itr,
 		     struct key_def *cmp_def, struct key_def *key_def,
 		     struct tuple_format *format, bool is_primary);
 
+/**
+ * Make a run iterator skip pages whose zone maps show that no
+ * statement stored in them satisfies @a filter. Must be called
+ * before the iterator is first used. @a filter must stay valid
+ * until the iterator is closed.
+ *
+ * A page is skipped only if every statement in it is a REPLACE
+ * or INSERT that doesn't match the predicate and the page holds
+ * complete key histories, so the iterator still returns either
+ * the newest visible version of a key or nothing. This is only
+ * correct if the run is the sole source of the keys: otherwise
+ * skipping a newer version would expose an older one stored in
+ * another source. Returned statements may not match @a filter,
+ * the caller must check them.
+ */
+void
+vy_run_iterator_set_filter(struct vy_run_iterator *itr,
+			   const struct vy_run_filter *filter);
+
 /**
  * Advance a run iterator to the next key.
  * The key history is returned in @history (empty if EOF).
@@ -564,6 +1012,12 @@ struct vy_slice_stream {
 	struct vy_page *page;
 	/** The last tuple returned to user */
 	struct tuple *tuple;
+	/**
+	 * Page index block of the current page read by the
+	 * stream itself, because the block cached by the run
+	 * may be evicted from tx, see vy_slice_stream_page_info().
+	 */
+	struct vy_page_index_block *block;
 
 	/** Members needed for memory allocation and disk access */
 	/** Slice to stream */
@@ -587,6 +1041,26 @@ vy_slice_stream_open(struct vy_slice_stream *stream, struct vy_slice *slice,
 		     struct key_def *cmp_def, struct tuple_format *format,
 		     bool is_primary);
 
+/**
+ * Min/max values of a field accumulated by a run writer for
+ * the page being written.
+ */
+struct vy_zone_map_entry {
+	/** Zero-based number of the field. */
+	uint32_t fieldno;
+	/**
+	 * MP_INT if the field of all statements added so far is
+	 * an integer, MP_STR if it is a string, MP_NIL if no
+	 * statements have been added, MP_EXT if the page can't
+	 * have a zone map for the field.
+	 */
+	enum mp_type type;
+	/** MsgPack of the min field value. */
+	struct ibuf min;
+	/** MsgPack of the max field value. */
+	struct ibuf max;
+};
+
 /**
  * Run_writer fills a created run with statements one by one,
  * splitting them into pages.
@@ -630,14 +1104,76 @@ struct vy_run_writer {
 	 * of max key of a finished run.
 	 */
 	struct tuple *last_stmt;
+	/**
+	 * Primary index tuples of this size or bigger are stored
+	 * in the blob file of the run, 0 if disabled.
+	 */
+	int64_t blob_threshold;
+	/**
+	 * Blob files referenced by the source runs, see
+	 * vy_write_iterator_blobs().
+	 */
+	struct vy_run_blob *src_blobs;
+	uint32_t src_blob_count;
+	/**
+	 * Distance between restart points of prefix-compressed
+	 * pages, 0 to write plain pages.
+	 */
+	uint32_t restart_interval;
+	/** Body of the last statement written to the page. */
+	struct ibuf prev_body;
+	/** Write pages in VY_PAGE_VERSION_COLUMNAR format. */
+	bool columnar;
+	/**
+	 * Chunks of the current columnar page, the first one is
+	 * for row prefixes, see VY_PAGE_VERSION_COLUMNAR.
+	 */
+	struct ibuf *columns;
+	/** Number of entries in the columns array. */
+	uint32_t column_count;
+	/**
+	 * Min/max values of the zone map fields over statements
+	 * of the current page, one entry per field.
+	 */
+	struct vy_zone_map_entry *zone_map;
+	/** Number of entries in the zone_map array. */
+	uint32_t zone_map_size;
+	/** Digested dictionary to compress pages with, or NULL. */
+	ZSTD_CDict *zcdict;
+	/**
+	 * Max size of the dictionary to train on the pages
+	 * written, 0 if training is disabled.
+	 */
+	uint32_t zdict_train_size;
+	/** Page samples to train the dictionary on. */
+	struct ibuf zdict_samples;
+	/** Sizes of the samples, size_t each. */
+	struct ibuf zdict_sample_sizes;
 };
 
-/** Create a run writer to fill a run with statements. */
+/**
+ * Create a run writer to fill a run with statements.
+ * @a src_blobs is the array of blob files that stubs passed
+ * to the writer may refer to. If @a restart_interval is not
+ * zero, pages are written in VY_PAGE_VERSION_PREFIX format.
+ * If @a columnar is set, pages are written in
+ * VY_PAGE_VERSION_COLUMNAR format. Pages get zone maps for
+ * the fields set in the @a zone_map_fields column mask.
+ * Pages are compressed with the zstd dictionary @a zdict if it
+ * isn't NULL. If @a zdict_train_size is not zero, a dictionary
+ * of up to this size is trained on the pages written and
+ * stored in vy_run::new_zdict on commit.
+ */
 int
 vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 		     const char *dirpath, uint32_t space_id, uint32_t iid,
 		     struct key_def *cmp_def, struct key_def *key_def,
-		     uint64_t page_size, double bloom_fpr);
+		     uint64_t page_size, double bloom_fpr,
+		     int64_t blob_threshold, struct vy_run_blob *src_blobs,
+		     uint32_t src_blob_count, uint32_t restart_interval,
+		     bool columnar, uint64_t zone_map_fields,
+		     const char *zdict, uint32_t zdict_size,
+		     uint32_t zdict_train_size);
 
 /**
  * Write a specified statement into a run.
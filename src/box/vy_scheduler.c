@@ -36,6 +36,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <pmatomic.h>
 #include <small/rlist.h>
 #include <tarantool_ev.h>
 
@@ -46,6 +47,7 @@
 #include "fiber_cond.h"
 #include "cbus.h"
 #include "salad/stailq.h"
+#include "probe.h"
 #include "say.h"
 #include "txn.h"
 #include "space.h"
@@ -56,6 +58,7 @@
 #include "vy_mem.h"
 #include "vy_range.h"
 #include "vy_run.h"
+#include "vy_stmt.h"
 #include "vy_write_iterator.h"
 #include "trivia/util.h"
 
@@ -69,6 +72,7 @@ static void vy_task_execute_f(struct cmsg *);
 static void vy_task_complete_f(struct cmsg *);
 static void vy_deferred_delete_batch_process_f(struct cmsg *);
 static void vy_deferred_delete_batch_free_f(struct cmsg *);
+static void vy_worker_pool_put(struct vy_worker *);
 
 static const struct cmsg_hop vy_task_execute_route[] = {
 	{ vy_task_execute_f, NULL },
@@ -80,6 +84,27 @@ static const struct cmsg_hop vy_task_complete_route[] = {
 
 struct vy_task;
 
+/**
+ * Max number of parts a compaction task can be split into,
+ * @sa vy_task_compaction_split().
+ */
+enum { VY_COMPACTION_PART_MAX = 8 };
+
+/**
+ * Min size of a compaction part. Splitting a smaller compaction
+ * isn't worth the extra ranges it creates.
+ */
+enum { VY_COMPACTION_PART_SIZE_MIN = 64 * 1024 * 1024 };
+
+/**
+ * Max number of LSM trees dumped by a single task group,
+ * @sa vy_scheduler_group_dump().
+ */
+enum { VY_DUMP_GROUP_MAX = 16 };
+
+/** Max number of parts a task can consist of. */
+enum { VY_TASK_PART_MAX = MAX(VY_COMPACTION_PART_MAX, VY_DUMP_GROUP_MAX) };
+
 /** Vinyl worker thread. */
 struct vy_worker {
 	struct cord cord;
@@ -100,8 +125,11 @@ struct vy_worker {
 	struct cmsg_hop deferred_delete_route[2];
 };
 
-/** Max number of statements in a batch of deferred DELETEs. */
-enum { VY_DEFERRED_DELETE_BATCH_MAX = 100 };
+/**
+ * Max number of statements in a batch of deferred DELETEs.
+ * Each batch is written to WAL in one transaction.
+ */
+enum { VY_DEFERRED_DELETE_BATCH_MAX = 1000 };
 
 /** Deferred DELETE statement. */
 struct vy_deferred_delete_stmt {
@@ -187,6 +215,13 @@ struct vy_task {
 	struct vy_range *range;
 	/** Run written by this task. */
 	struct vy_run *new_run;
+	/**
+	 * Slices of the dumped run to insert into ranges
+	 * [dump_begin_range, dump_end_range), allocated on dump
+	 * completion before logging the dump.
+	 */
+	struct vy_slice **dump_slices;
+	struct vy_range *dump_begin_range, *dump_end_range;
 	/** Write iterator producing statements for the new run. */
 	struct vy_stmt_stream *wi;
 	/**
@@ -204,6 +239,18 @@ struct vy_task {
 	 */
 	double bloom_fpr;
 	int64_t page_size;
+	int64_t blob_threshold;
+	uint32_t page_restart_interval;
+	bool columnar;
+	uint64_t zone_map_fields;
+	/**
+	 * Copy of the LSM tree compression dictionary the new run
+	 * is compressed with or NULL, see vy_task_set_zdict().
+	 */
+	char *zdict;
+	uint32_t zdict_size;
+	/** Size of the dictionary to train on the new run or 0. */
+	uint32_t zdict_train_size;
 	/**
 	 * Deferred DELETE handler passed to the write iterator.
 	 * It sends deferred DELETE statements generated during
@@ -219,6 +266,30 @@ struct vy_task {
 	int deferred_delete_in_progress;
 	/** Link in vy_scheduler::processed_tasks. */
 	struct stailq_entry in_processed;
+	/**
+	 * If a compaction task is split into parts executed by
+	 * different workers in parallel or dumps of several LSM
+	 * trees are grouped together, this array stores all the
+	 * parts, the first of which is the task itself. Otherwise
+	 * part_count is 0.
+	 *
+	 * A dump group part that couldn't get a worker of its own
+	 * has the worker set to NULL and is executed by the worker
+	 * of the first part after it's done with its own run.
+	 */
+	struct vy_task *parts[VY_TASK_PART_MAX];
+	int part_count;
+	/** Task this task is a part of or NULL. */
+	struct vy_task *parent;
+	/**
+	 * Number of parts of this task that haven't been
+	 * executed yet, including the task itself.
+	 */
+	int parts_in_progress;
+	/** Key span of a compaction part. NULL means unbounded. */
+	struct tuple *begin, *end;
+	/** Slices of compacted runs cut by the part key span. */
+	struct rlist cut_slices;
 };
 
 static const struct vy_deferred_delete_handler_iface
@@ -261,22 +332,86 @@ vy_task_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	vy_lsm_ref(lsm);
 	diag_create(&task->diag);
 	task->deferred_delete_handler.iface = &vy_task_deferred_delete_iface;
+	task->parts_in_progress = 1;
+	rlist_create(&task->cut_slices);
 	return task;
 }
 
-/** Free a task allocated with vy_task_new(). */
+/** Free slices of compacted runs cut for a compaction part. */
+static void
+vy_task_delete_cut_slices(struct vy_task *task)
+{
+	while (!rlist_empty(&task->cut_slices)) {
+		struct vy_slice *slice = rlist_shift_entry(&task->cut_slices,
+						struct vy_slice, in_range);
+		vy_slice_delete(slice);
+	}
+}
+
+/**
+ * Free a task allocated with vy_task_new(). If the task is
+ * split into parts, the parts are freed too and their workers
+ * are returned to the pool.
+ */
 static void
 vy_task_delete(struct vy_task *task)
 {
 	assert(task->deferred_delete_batch == NULL);
 	assert(task->deferred_delete_in_progress == 0);
+	for (int i = 1; i < task->part_count; i++) {
+		struct vy_task *part = task->parts[i];
+		if (part->worker != NULL)
+			vy_worker_pool_put(part->worker);
+		vy_task_delete(part);
+	}
+	vy_task_delete_cut_slices(task);
+	if (task->begin != NULL)
+		tuple_unref(task->begin);
+	if (task->end != NULL)
+		tuple_unref(task->end);
 	key_def_delete(task->cmp_def);
 	key_def_delete(task->key_def);
 	vy_lsm_unref(task->lsm);
 	diag_destroy(&task->diag);
+	free(task->zdict);
 	free(task);
 }
 
+/**
+ * Copy a compression dictionary to a task. The dictionary is
+ * duplicated, because the LSM tree may switch to a new one
+ * while the task is in progress.
+ */
+static int
+vy_task_set_zdict(struct vy_task *task, const char *zdict,
+		  uint32_t zdict_size, uint32_t zdict_train_size)
+{
+	task->zdict_train_size = zdict_train_size;
+	if (zdict == NULL)
+		return 0;
+	task->zdict = malloc(zdict_size);
+	if (task->zdict == NULL) {
+		diag_set(OutOfMemory, zdict_size, "malloc", "zdict");
+		return -1;
+	}
+	memcpy(task->zdict, zdict, zdict_size);
+	task->zdict_size = zdict_size;
+	return 0;
+}
+
+/**
+ * Set the compression dictionary of a task writing a run
+ * of the given LSM tree.
+ */
+static int
+vy_task_set_lsm_zdict(struct vy_task *task, struct vy_lsm *lsm)
+{
+	if (lsm->opts.compression_dict_size <= 0)
+		return 0;
+	return vy_task_set_zdict(task, lsm->zdict, lsm->zdict_size,
+				 lsm->opts.compression_dict_size);
+}
+
 static bool
 vy_dump_heap_less(struct heap_node *a, struct heap_node *b)
 {
@@ -517,6 +652,14 @@ vy_scheduler_reset_stat(struct vy_scheduler *scheduler)
 	stat->compaction_output = 0;
 }
 
+void
+vy_scheduler_set_compaction_rate_limit(struct vy_scheduler *scheduler,
+				       size_t limit)
+{
+	pm_atomic_store_explicit(&scheduler->compaction_rate_limit, limit,
+				 pm_memory_order_relaxed);
+}
+
 void
 vy_scheduler_add_lsm(struct vy_scheduler *scheduler, struct vy_lsm *lsm)
 {
@@ -761,16 +904,18 @@ vy_scheduler_end_checkpoint(struct vy_scheduler *scheduler)
  * Allocate a new run for an LSM tree and write the information
  * about it to the metadata log so that we could still find
  * and delete it in case a write error occured. This function
- * is called from dump/compaction task constructor.
+ * is called from dump/compaction task constructor. @a is_cold
+ * selects the storage tier the run files will be written to.
  */
 static struct vy_run *
-vy_run_prepare(struct vy_run_env *run_env, struct vy_lsm *lsm)
+vy_run_prepare(struct vy_run_env *run_env, struct vy_lsm *lsm, bool is_cold)
 {
 	struct vy_run *run = vy_run_new(run_env, vy_log_next_id());
 	if (run == NULL)
 		return NULL;
+	run->is_cold = is_cold;
 	vy_log_tx_begin();
-	vy_log_prepare_run(lsm->id, run->id);
+	vy_log_prepare_run(lsm->id, run->id, is_cold);
 	if (vy_log_tx_commit() < 0) {
 		vy_run_unref(run);
 		return NULL;
@@ -808,6 +953,178 @@ vy_run_discard(struct vy_run *run)
 	vy_log_tx_try_commit();
 }
 
+int
+vy_scheduler_load_run(struct vy_scheduler *scheduler, struct vy_lsm *lsm,
+		      int64_t lsn, struct vy_stmt_stream *stream)
+{
+	enum { YIELD_LOOPS = 32 };
+
+	struct vy_run *run = vy_run_prepare(scheduler->run_env, lsm, false);
+	if (run == NULL)
+		return -1;
+	run->dump_count = 1;
+	run->dump_lsn = lsn;
+
+	/*
+	 * Statements are written in the tx thread, so yield
+	 * periodically in order not to stall other fibers.
+	 */
+	struct vy_run_writer writer;
+	if (vy_run_writer_create(&writer, run,
+				 vy_lsm_env_run_dir(lsm->env, false),
+				 lsm->space_id, lsm->index_id,
+				 lsm->cmp_def, lsm->key_def,
+				 lsm->opts.page_size, lsm->opts.bloom_fpr,
+				 lsm->opts.blob_threshold, NULL, 0,
+				 lsm->opts.page_restart_interval,
+				 lsm->opts.columnar,
+				 lsm->opts.zone_map_fields, NULL, 0, 0) != 0)
+		goto fail;
+	if (stream->iface->start(stream) != 0)
+		goto fail_abort_writer;
+	int rc;
+	int loops = 0;
+	struct tuple *stmt = NULL;
+	while ((rc = stream->iface->next(stream, &stmt)) == 0 &&
+	       stmt != NULL) {
+		rc = vy_run_writer_append_stmt(&writer, stmt);
+		if (rc != 0)
+			break;
+		if (++loops % YIELD_LOOPS == 0)
+			fiber_sleep(0);
+		if (fiber_is_cancelled()) {
+			diag_set(FiberIsCancelled);
+			rc = -1;
+			break;
+		}
+	}
+	stream->iface->stop(stream);
+	if (rc == 0)
+		rc = vy_run_writer_commit(&writer);
+	if (rc != 0)
+		goto fail_abort_writer;
+	if (vy_run_is_empty(run)) {
+		vy_run_discard(run);
+		return 0;
+	}
+
+	/*
+	 * Do not log the new run while a checkpoint or a dump
+	 * of the LSM tree is in progress, then pin the LSM tree
+	 * so that no other run appears in it until the new one
+	 * is added. With no runs, ranges are not compacted and
+	 * so not split or coalesced either.
+	 */
+	while (scheduler->checkpoint_in_progress || lsm->is_dumping)
+		fiber_cond_wait(&scheduler->dump_cond);
+	if (!vy_lsm_is_empty(lsm) || lsm->is_dropped) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "writing to a space during bulk load");
+		goto fail;
+	}
+	vy_scheduler_pin_lsm(scheduler, lsm);
+
+	struct tuple_format *key_format = lsm->env->key_format;
+	struct tuple *min_key = vy_key_from_msgpack(key_format,
+						    run->info.min_key);
+	if (min_key == NULL)
+		goto fail_unpin;
+	struct tuple *max_key = vy_key_from_msgpack(key_format,
+						    run->info.max_key);
+	if (max_key == NULL) {
+		tuple_unref(min_key);
+		goto fail_unpin;
+	}
+	struct vy_range *begin_range = vy_range_tree_psearch(lsm->tree,
+							     min_key);
+	struct vy_range *end_range = vy_range_tree_psearch(lsm->tree,
+							   max_key);
+	end_range = vy_range_tree_next(lsm->tree, end_range);
+	tuple_unref(min_key);
+	tuple_unref(max_key);
+
+	struct vy_slice **slices = calloc(lsm->range_count, sizeof(*slices));
+	if (slices == NULL) {
+		diag_set(OutOfMemory, lsm->range_count * sizeof(*slices),
+			 "malloc", "struct vy_slice *");
+		goto fail_unpin;
+	}
+	struct vy_range *range;
+	int i;
+	for (range = begin_range, i = 0; range != end_range;
+	     range = vy_range_tree_next(lsm->tree, range), i++) {
+		slices[i] = vy_slice_new(vy_log_next_id(), run, range->begin,
+					 range->end, lsm->cmp_def);
+		if (slices[i] == NULL)
+			goto fail_free_slices;
+	}
+
+	vy_log_tx_begin();
+	vy_log_create_run(lsm->id, run->id, run->dump_lsn, run->dump_count,
+			  run->is_cold);
+	for (range = begin_range, i = 0; range != end_range;
+	     range = vy_range_tree_next(lsm->tree, range), i++) {
+		vy_log_insert_slice(range->id, run->id, slices[i]->id,
+				    tuple_data_or_null(slices[i]->begin),
+				    tuple_data_or_null(slices[i]->end));
+	}
+	vy_log_dump_lsm(lsm->id, lsn);
+	if (vy_log_tx_commit() != 0)
+		goto fail_free_slices;
+
+	/* The LSM tree is pinned, so the ranges are still there. */
+	vy_lsm_add_run(lsm, run);
+	vy_run_unref(run);
+	for (range = begin_range, i = 0; range != end_range;
+	     range = vy_range_tree_next(lsm->tree, range), i++) {
+		vy_lsm_unacct_range(lsm, range);
+		vy_range_add_slice(range, slices[i]);
+		vy_range_update_compaction_priority(range, &lsm->opts);
+		vy_range_update_dumps_per_compaction(range);
+		vy_lsm_acct_range(lsm, range);
+	}
+	vy_range_heap_update_all(&lsm->range_heap);
+	free(slices);
+	lsm->dump_lsn = MAX(lsm->dump_lsn, lsn);
+	vy_scheduler_unpin_lsm(scheduler, lsm);
+	say_info("%s: loaded %lld statements", vy_lsm_name(lsm),
+		 (long long)run->count.rows);
+	return 0;
+
+fail_free_slices:
+	for (i = 0; i < lsm->range_count && slices[i] != NULL; i++)
+		vy_slice_delete(slices[i]);
+	free(slices);
+fail_unpin:
+	vy_scheduler_unpin_lsm(scheduler, lsm);
+	goto fail;
+fail_abort_writer:
+	vy_run_writer_abort(&writer);
+fail:
+	vy_run_discard(run);
+	return -1;
+}
+
+/**
+ * Check if a deferred DELETE needs to be written, i.e. if
+ * the statement that overwrote the tuple is a DELETE or
+ * changes a secondary key of the space.
+ */
+static bool
+vy_deferred_delete_is_needed(struct space *space,
+			     struct vy_deferred_delete_stmt *stmt)
+{
+	if (vy_stmt_type(stmt->new_stmt) == IPROTO_DELETE)
+		return true;
+	for (uint32_t i = 1; i < space->index_count; i++) {
+		struct key_def *cmp_def = space->index[i]->def->cmp_def;
+		if (!vy_stmt_key_is_unchanged(stmt->old_stmt,
+					      stmt->new_stmt, cmp_def))
+			return true;
+	}
+	return false;
+}
+
 /**
  * Encode and write a single deferred DELETE statement to
  * _vinyl_deferred_delete system space. The rest will be
@@ -896,19 +1213,36 @@ vy_deferred_delete_batch_process_f(struct cmsg *cmsg)
 	deferred_delete_space = space_by_id(BOX_VINYL_DEFERRED_DELETE_ID);
 	assert(deferred_delete_space != NULL);
 
-	struct txn *txn = txn_begin(false);
-	if (txn == NULL)
-		goto fail;
+	struct space *space = space_by_id(pk->space_id);
+	assert(space != NULL);
 
+	struct txn *txn = NULL;
+	struct vy_stmt_counter count = { 0, 0 };
+	int64_t skipped = 0;
 	for (int i = 0; i < batch->count; i++) {
+		struct vy_deferred_delete_stmt *stmt = &batch->stmt[i];
+		/*
+		 * Don't waste WAL bandwidth on DELETEs that
+		 * would be overwritten in all secondary indexes
+		 * by the statement that generated them.
+		 */
+		if (!vy_deferred_delete_is_needed(space, stmt)) {
+			skipped++;
+			continue;
+		}
+		if (txn == NULL && (txn = txn_begin(false)) == NULL)
+			goto fail;
 		if (vy_deferred_delete_process_one(deferred_delete_space,
 						   pk->space_id, pk->mem_format,
-						   &batch->stmt[i]) != 0)
+						   stmt) != 0)
 			goto fail;
+		vy_stmt_counter_acct_tuple(&count, stmt->old_stmt);
 	}
 
-	if (txn_commit(txn) != 0)
+	if (txn != NULL && txn_commit(txn) != 0)
 		goto fail;
+	vy_stmt_counter_add(&pk->stat.deferred_delete.count, &count);
+	pk->stat.deferred_delete.skipped += skipped;
 	fiber_gc();
 	return;
 fail:
@@ -1039,13 +1373,49 @@ vy_task_deferred_delete_iface = {
 	.destroy = vy_task_deferred_delete_destroy,
 };
 
+/**
+ * Sleep if a compaction task writes faster than allowed by
+ * vy_scheduler::compaction_rate_limit. The limit is shared
+ * evenly among all compaction threads. @window_start and
+ * @window_bytes are the time and the amount of data written
+ * by the task at the beginning of the current throttling
+ * window. The window is restarted after each sleep so that
+ * a limit change takes effect quickly.
+ */
+static void
+vy_task_throttle_compaction(struct vy_task *task, double *window_start,
+			    size_t *window_bytes)
+{
+	struct vy_scheduler *scheduler = task->scheduler;
+	size_t limit = pm_atomic_load_explicit(
+			&scheduler->compaction_rate_limit,
+			pm_memory_order_relaxed);
+	double now = ev_monotonic_time();
+	size_t bytes = task->new_run->count.bytes_compressed;
+	if (limit > 0) {
+		limit = MAX(limit / scheduler->compaction_pool.size, 1);
+		double elapsed = now - *window_start;
+		double expected = (double)(bytes - *window_bytes) / limit;
+		if (expected <= elapsed && elapsed < 1)
+			return;
+		if (expected > elapsed) {
+			fiber_sleep(expected - elapsed);
+			now = ev_monotonic_time();
+		}
+	}
+	*window_start = now;
+	*window_bytes = bytes;
+}
+
 static int
-vy_task_write_run(struct vy_task *task)
+vy_task_write_run(struct vy_task *task, bool is_compaction)
 {
 	enum { YIELD_LOOPS = 32 };
 
 	struct vy_lsm *lsm = task->lsm;
 	struct vy_stmt_stream *wi = task->wi;
+	double throttle_start = ev_monotonic_time();
+	size_t throttle_bytes = 0;
 
 	ERROR_INJECT(ERRINJ_VY_RUN_WRITE,
 		     {diag_set(ClientError, ER_INJECTION,
@@ -1057,11 +1427,25 @@ vy_task_write_run(struct vy_task *task)
 			usleep(10000);
 	}
 
+	struct vy_run_blob *blobs;
+	uint32_t blob_count;
+	vy_write_iterator_blobs(wi, &blobs, &blob_count);
+
+	if (task->new_run->is_cold && vy_lsm_make_dir(lsm, true) != 0)
+		goto fail;
+
 	struct vy_run_writer writer;
-	if (vy_run_writer_create(&writer, task->new_run, lsm->env->path,
+	if (vy_run_writer_create(&writer, task->new_run,
+				 vy_lsm_env_run_dir(lsm->env,
+						    task->new_run->is_cold),
 				 lsm->space_id, lsm->index_id,
 				 task->cmp_def, task->key_def,
-				 task->page_size, task->bloom_fpr) != 0)
+				 task->page_size, task->bloom_fpr,
+				 task->blob_threshold, blobs, blob_count,
+				 task->page_restart_interval,
+				 task->columnar, task->zone_map_fields,
+				 task->zdict, task->zdict_size,
+				 task->zdict_train_size) != 0)
 		goto fail;
 
 	if (wi->iface->start(wi) != 0)
@@ -1078,8 +1462,13 @@ vy_task_write_run(struct vy_task *task)
 		if (rc != 0)
 			break;
 
-		if (++loops % YIELD_LOOPS == 0)
+		if (++loops % YIELD_LOOPS == 0) {
+			if (is_compaction)
+				vy_task_throttle_compaction(task,
+						&throttle_start,
+						&throttle_bytes);
 			fiber_sleep(0);
+		}
 		if (fiber_is_cancelled()) {
 			diag_set(FiberIsCancelled);
 			rc = -1;
@@ -1104,44 +1493,56 @@ fail:
 static int
 vy_task_dump_execute(struct vy_task *task)
 {
-	return vy_task_write_run(task);
+	if (vy_task_write_run(task, false) != 0)
+		return -1;
+	/*
+	 * Write runs of the dump group parts that didn't get
+	 * a worker of their own.
+	 */
+	for (int i = 1; i < task->part_count; i++) {
+		struct vy_task *part = task->parts[i];
+		if (part->worker == NULL &&
+		    vy_task_write_run(part, false) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/** Free slices allocated by vy_task_dump_prepare(). */
+static void
+vy_task_dump_free_slices(struct vy_task *task)
+{
+	if (task->dump_slices == NULL)
+		return;
+	for (int i = 0; i < task->lsm->range_count; i++) {
+		struct vy_slice *slice = task->dump_slices[i];
+		if (slice != NULL)
+			vy_slice_delete(slice);
+	}
+	free(task->dump_slices);
+	task->dump_slices = NULL;
 }
 
+/**
+ * Allocate a slice of the dumped run for each range of
+ * the LSM tree intersecting the run.
+ *
+ * Returns 0 on success, -1 on failure.
+ */
 static int
-vy_task_dump_complete(struct vy_task *task)
+vy_task_dump_prepare(struct vy_task *task)
 {
-	struct vy_scheduler *scheduler = task->scheduler;
 	struct vy_lsm *lsm = task->lsm;
 	struct vy_run *new_run = task->new_run;
-	int64_t dump_lsn = new_run->dump_lsn;
-	double dump_time = ev_monotonic_now(loop()) - task->start_time;
-	struct vy_disk_stmt_counter dump_output = new_run->count;
-	struct vy_stmt_counter dump_input;
 	struct tuple_format *key_format = lsm->env->key_format;
-	struct vy_mem *mem, *next_mem;
-	struct vy_slice **new_slices, *slice;
 	struct vy_range *range, *begin_range, *end_range;
 	struct tuple *min_key, *max_key;
 	int i;
 
-	assert(lsm->is_dumping);
-
-	if (vy_run_is_empty(new_run)) {
-		/*
-		 * In case the run is empty, we can discard the run
-		 * and delete dumped in-memory trees right away w/o
-		 * inserting slices into ranges. However, we need
-		 * to log LSM tree dump anyway.
-		 */
-		vy_log_tx_begin();
-		vy_log_dump_lsm(lsm->id, dump_lsn);
-		if (vy_log_tx_commit() < 0)
-			goto fail;
-		vy_run_discard(new_run);
-		goto delete_mems;
-	}
+	if (vy_run_is_empty(new_run))
+		return 0;
 
-	assert(new_run->info.max_lsn <= dump_lsn);
+	assert(new_run->info.max_lsn <= new_run->dump_lsn);
 
 	/*
 	 * Figure out which ranges intersect the new run.
@@ -1152,11 +1553,11 @@ vy_task_dump_complete(struct vy_task *task)
 	 */
 	min_key = vy_key_from_msgpack(key_format, new_run->info.min_key);
 	if (min_key == NULL)
-		goto fail;
+		return -1;
 	max_key = vy_key_from_msgpack(key_format, new_run->info.max_key);
 	if (max_key == NULL) {
 		tuple_unref(min_key);
-		goto fail;
+		return -1;
 	}
 	begin_range = vy_range_tree_psearch(lsm->tree, min_key);
 	end_range = vy_range_tree_psearch(lsm->tree, max_key);
@@ -1171,39 +1572,92 @@ vy_task_dump_complete(struct vy_task *task)
 	/*
 	 * For each intersected range allocate a slice of the new run.
 	 */
-	new_slices = calloc(lsm->range_count, sizeof(*new_slices));
-	if (new_slices == NULL) {
-		diag_set(OutOfMemory, lsm->range_count * sizeof(*new_slices),
+	task->dump_slices = calloc(lsm->range_count,
+				   sizeof(*task->dump_slices));
+	if (task->dump_slices == NULL) {
+		diag_set(OutOfMemory, lsm->range_count *
+			 sizeof(*task->dump_slices),
 			 "malloc", "struct vy_slice *");
-		goto fail;
+		return -1;
 	}
 	for (range = begin_range, i = 0; range != end_range;
 	     range = vy_range_tree_next(lsm->tree, range), i++) {
-		slice = vy_slice_new(vy_log_next_id(), new_run,
-				     range->begin, range->end, lsm->cmp_def);
-		if (slice == NULL)
-			goto fail_free_slices;
-
+		struct vy_slice *slice = vy_slice_new(vy_log_next_id(),
+				new_run, range->begin, range->end,
+				lsm->cmp_def);
+		if (slice == NULL) {
+			vy_task_dump_free_slices(task);
+			return -1;
+		}
 		assert(i < lsm->range_count);
-		new_slices[i] = slice;
+		task->dump_slices[i] = slice;
 	}
+	task->dump_begin_range = begin_range;
+	task->dump_end_range = end_range;
+	return 0;
+}
 
-	/*
-	 * Log change in metadata.
-	 */
-	vy_log_tx_begin();
-	vy_log_create_run(lsm->id, new_run->id, dump_lsn, new_run->dump_count);
-	for (range = begin_range, i = 0; range != end_range;
+/**
+ * Write the dump to the metadata log. Must be called within
+ * a metadata log transaction after vy_task_dump_prepare().
+ */
+static void
+vy_task_dump_log(struct vy_task *task)
+{
+	struct vy_lsm *lsm = task->lsm;
+	struct vy_run *new_run = task->new_run;
+	struct vy_range *range;
+	int i;
+
+	if (task->dump_slices == NULL) {
+		/*
+		 * In case the run is empty, we can discard the run
+		 * and delete dumped in-memory trees right away w/o
+		 * inserting slices into ranges. However, we need
+		 * to log LSM tree dump anyway.
+		 */
+		assert(vy_run_is_empty(new_run));
+		vy_log_dump_lsm(lsm->id, new_run->dump_lsn);
+		return;
+	}
+	vy_log_create_run(lsm->id, new_run->id, new_run->dump_lsn,
+			  new_run->dump_count, new_run->is_cold);
+	for (range = task->dump_begin_range, i = 0;
+	     range != task->dump_end_range;
 	     range = vy_range_tree_next(lsm->tree, range), i++) {
 		assert(i < lsm->range_count);
-		slice = new_slices[i];
+		struct vy_slice *slice = task->dump_slices[i];
 		vy_log_insert_slice(range->id, new_run->id, slice->id,
 				    tuple_data_or_null(slice->begin),
 				    tuple_data_or_null(slice->end));
 	}
-	vy_log_dump_lsm(lsm->id, dump_lsn);
-	if (vy_log_tx_commit() < 0)
-		goto fail_free_slices;
+	vy_log_dump_lsm(lsm->id, new_run->dump_lsn);
+}
+
+/**
+ * Apply a logged dump to the LSM tree: add the new run to
+ * ranges and delete dumped in-memory trees.
+ */
+static void
+vy_task_dump_apply(struct vy_task *task)
+{
+	struct vy_scheduler *scheduler = task->scheduler;
+	struct vy_lsm *lsm = task->lsm;
+	struct vy_run *new_run = task->new_run;
+	int64_t dump_lsn = new_run->dump_lsn;
+	double dump_time = ev_monotonic_now(loop()) - task->start_time;
+	struct vy_disk_stmt_counter dump_output = new_run->count;
+	struct vy_stmt_counter dump_input;
+	struct vy_mem *mem, *next_mem;
+	struct vy_range *range;
+	int i;
+
+	assert(lsm->is_dumping);
+
+	if (task->dump_slices == NULL) {
+		vy_run_discard(new_run);
+		goto delete_mems;
+	}
 
 	/* Account the new run. */
 	vy_lsm_add_run(lsm, new_run);
@@ -1218,18 +1672,22 @@ vy_task_dump_complete(struct vy_task *task)
 	 * LSM tree state, when the same statement is present twice,
 	 * in memory and on disk.
 	 */
-	for (range = begin_range, i = 0; range != end_range;
+	for (range = task->dump_begin_range, i = 0;
+	     range != task->dump_end_range;
 	     range = vy_range_tree_next(lsm->tree, range), i++) {
 		assert(i < lsm->range_count);
-		slice = new_slices[i];
+		struct vy_slice *slice = task->dump_slices[i];
 		vy_lsm_unacct_range(lsm, range);
 		vy_range_add_slice(range, slice);
 		vy_range_update_compaction_priority(range, &lsm->opts);
 		vy_range_update_dumps_per_compaction(range);
 		vy_lsm_acct_range(lsm, range);
+		vy_lsm_acct_range_load(lsm, range, 0, slice->count.rows);
 	}
 	vy_range_heap_update_all(&lsm->range_heap);
-	free(new_slices);
+	free(task->dump_slices);
+	task->dump_slices = NULL;
+	vy_lsm_decay_range_load(lsm);
 
 delete_mems:
 	/*
@@ -1269,21 +1727,14 @@ delete_mems:
 	say_info("%s: dump completed", vy_lsm_name(lsm));
 
 	vy_scheduler_complete_dump(scheduler);
-	return 0;
-
-fail_free_slices:
-	for (i = 0; i < lsm->range_count; i++) {
-		slice = new_slices[i];
-		if (slice != NULL)
-			vy_slice_delete(slice);
-	}
-	free(new_slices);
-fail:
-	return -1;
 }
 
+/**
+ * Abort dump of a single LSM tree. @e is the error that
+ * caused the failure or NULL if the dump was cancelled.
+ */
 static void
-vy_task_dump_abort(struct vy_task *task)
+vy_task_dump_abort_one(struct vy_task *task, struct error *e)
 {
 	struct vy_scheduler *scheduler = task->scheduler;
 	struct vy_lsm *lsm = task->lsm;
@@ -1297,12 +1748,12 @@ vy_task_dump_abort(struct vy_task *task)
 	 * It's no use alerting the user if the server is
 	 * shutting down or the LSM tree was dropped.
 	 */
-	if (!lsm->is_dropped) {
-		struct error *e = diag_last_error(&task->diag);
+	if (!lsm->is_dropped && e != NULL) {
 		error_log(e);
 		say_error("%s: dump failed", vy_lsm_name(lsm));
 	}
 
+	vy_task_dump_free_slices(task);
 	vy_run_discard(task->new_run);
 
 	lsm->is_dumping = false;
@@ -1327,6 +1778,64 @@ vy_task_dump_abort(struct vy_task *task)
 		vy_scheduler_complete_dump(scheduler);
 }
 
+/**
+ * Complete a dump task. If the task is a group of dumps of
+ * several LSM trees, all of them are written to the metadata
+ * log in one transaction so that the group costs one log
+ * write and fsync rather than one per LSM tree.
+ */
+static int
+vy_task_dump_complete(struct vy_task *task)
+{
+	struct vy_task **parts = task->part_count > 0 ? task->parts : &task;
+	int part_count = MAX(task->part_count, 1);
+	int i;
+
+	for (i = 0; i < part_count; i++) {
+		struct vy_task *part = parts[i];
+		if (!part->lsm->is_dropped &&
+		    vy_task_dump_prepare(part) != 0)
+			goto fail;
+	}
+
+	/*
+	 * Log change in metadata.
+	 */
+	vy_log_tx_begin();
+	for (i = 0; i < part_count; i++) {
+		struct vy_task *part = parts[i];
+		if (!part->lsm->is_dropped)
+			vy_task_dump_log(part);
+	}
+	if (vy_log_tx_commit() < 0)
+		goto fail;
+
+	for (i = 0; i < part_count; i++) {
+		struct vy_task *part = parts[i];
+		if (part->lsm->is_dropped)
+			vy_task_dump_abort_one(part, NULL);
+		else
+			vy_task_dump_apply(part);
+	}
+	return 0;
+fail:
+	for (i = 0; i < part_count; i++)
+		vy_task_dump_free_slices(parts[i]);
+	return -1;
+}
+
+static void
+vy_task_dump_abort(struct vy_task *task)
+{
+	struct error *e = diag_last_error(&task->diag);
+	if (task->part_count == 0) {
+		vy_task_dump_abort_one(task, e);
+		return;
+	}
+	for (int i = 0; i < task->part_count; i++)
+		vy_task_dump_abort_one(task->parts[i], e);
+}
+
 /**
  * Create a task to dump an LSM tree.
  *
@@ -1392,7 +1901,8 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	if (task == NULL)
 		goto err;
 
-	struct vy_run *new_run = vy_run_prepare(scheduler->run_env, lsm);
+	struct vy_run *new_run = vy_run_prepare(scheduler->run_env,
+						lsm, false);
 	if (new_run == NULL)
 		goto err_run;
 
@@ -1422,7 +1932,13 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	task->new_run = new_run;
 	task->wi = wi;
 	task->bloom_fpr = lsm->opts.bloom_fpr;
+	task->blob_threshold = lsm->opts.blob_threshold;
+	task->page_restart_interval = lsm->opts.page_restart_interval;
+	task->columnar = lsm->opts.columnar;
+	task->zone_map_fields = lsm->opts.zone_map_fields;
 	task->page_size = lsm->opts.page_size;
+	if (vy_task_set_lsm_zdict(task, lsm) != 0)
+		goto err_wi_sub;
 
 	lsm->is_dumping = true;
 	vy_scheduler_update_lsm(scheduler, lsm);
@@ -1465,12 +1981,230 @@ vy_task_compaction_execute(struct vy_task *task)
 		while (errinj->bparam)
 			fiber_sleep(0.01);
 	}
-	return vy_task_write_run(task);
+	return vy_task_write_run(task, true);
+}
+
+/**
+ * Complete a compaction task split into parts. Each part produces
+ * a run covering its key span, so the compacted range is replaced
+ * with one range per part. Slices that weren't compacted, e.g.
+ * added by a concurrent dump, are cut by the new range boundaries.
+ * All changes are committed to the metadata log in one transaction.
+ */
+static int
+vy_task_compaction_complete_split(struct vy_task *task)
+{
+	struct vy_scheduler *scheduler = task->scheduler;
+	struct vy_lsm *lsm = task->lsm;
+	struct vy_range *range = task->range;
+	double compaction_time = ev_monotonic_now(loop()) - task->start_time;
+	struct vy_disk_stmt_counter compaction_output;
+	struct vy_disk_stmt_counter compaction_input;
+	struct vy_slice *first_slice = task->first_slice;
+	struct vy_slice *last_slice = task->last_slice;
+	struct vy_range *new_ranges[VY_COMPACTION_PART_MAX] = {NULL, };
+	int part_count = task->part_count;
+	struct vy_slice *slice, *new_slice;
+	struct vy_run *run;
+
+	/*
+	 * The write iterators have been stopped in workers
+	 * so slices cut for them aren't used any more.
+	 */
+	for (int i = 0; i < part_count; i++)
+		vy_task_delete_cut_slices(task->parts[i]);
+
+	/*
+	 * Allocate new ranges and fill them with slices: the run
+	 * written by the part goes where the compacted slices
+	 * were, other slices of the compacted range are cut by
+	 * the part key span.
+	 */
+	for (int i = 0; i < part_count; i++) {
+		struct vy_task *part = task->parts[i];
+		struct vy_range *new_range = vy_range_new(vy_log_next_id(),
+				part->begin, part->end, lsm->cmp_def);
+		if (new_range == NULL)
+			goto fail;
+		new_ranges[i] = new_range;
+		/*
+		 * vy_range_add_slice() adds a slice to the list head,
+		 * so to preserve the order of the slices list, we have
+		 * to iterate backward.
+		 */
+		bool is_compacted = false;
+		rlist_foreach_entry_reverse(slice, &range->slices, in_range) {
+			if (slice == last_slice)
+				is_compacted = true;
+			if (is_compacted) {
+				if (slice != first_slice)
+					continue;
+				is_compacted = false;
+				if (vy_run_is_empty(part->new_run))
+					continue;
+				new_slice = vy_slice_new(vy_log_next_id(),
+						part->new_run, NULL, NULL,
+						lsm->cmp_def);
+				if (new_slice == NULL)
+					goto fail;
+				vy_range_add_slice(new_range, new_slice);
+				continue;
+			}
+			if (vy_slice_cut(slice, vy_log_next_id(),
+					 new_range->begin, new_range->end,
+					 lsm->cmp_def, &new_slice) != 0)
+				goto fail;
+			if (new_slice != NULL)
+				vy_range_add_slice(new_range, new_slice);
+		}
+		new_range->n_compactions = range->n_compactions + 1;
+		/* We don't know how the load is distributed. */
+		new_range->read_load = range->read_load / part_count;
+		new_range->write_load = range->write_load / part_count;
+		vy_range_update_compaction_priority(new_range, &lsm->opts);
+		vy_range_update_dumps_per_compaction(new_range);
+	}
+
+	/*
+	 * Build the list of runs that became unused
+	 * as a result of compaction.
+	 */
+	RLIST_HEAD(unused_runs);
+	vy_disk_stmt_counter_reset(&compaction_input);
+	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
+		slice->run->compacted_slice_count++;
+		vy_disk_stmt_counter_add(&compaction_input, &slice->count);
+		if (slice == last_slice)
+			break;
+	}
+	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
+		run = slice->run;
+		if (run->compacted_slice_count == run->slice_count)
+			rlist_add_entry(&unused_runs, run, in_unused);
+		slice->run->compacted_slice_count = 0;
+		if (slice == last_slice)
+			break;
+	}
+
+	/*
+	 * Log change in metadata.
+	 */
+	vy_log_tx_begin();
+	rlist_foreach_entry(slice, &range->slices, in_range)
+		vy_log_delete_slice(slice->id);
+	vy_log_delete_range(range->id);
+	int64_t gc_lsn = vy_log_signature();
+	rlist_foreach_entry(run, &unused_runs, in_unused)
+		vy_log_drop_run(run->id, gc_lsn);
+	for (int i = 0; i < part_count; i++) {
+		struct vy_run *new_run = task->parts[i]->new_run;
+		if (!vy_run_is_empty(new_run))
+			vy_log_create_run(lsm->id, new_run->id,
+					  new_run->dump_lsn,
+					  new_run->dump_count,
+					  new_run->is_cold);
+	}
+	for (int i = 0; i < part_count; i++) {
+		struct vy_range *new_range = new_ranges[i];
+		vy_log_insert_range(lsm->id, new_range->id,
+				    tuple_data_or_null(new_range->begin),
+				    tuple_data_or_null(new_range->end));
+		rlist_foreach_entry(slice, &new_range->slices, in_range)
+			vy_log_insert_slice(new_range->id, slice->run->id,
+					    slice->id,
+					    tuple_data_or_null(slice->begin),
+					    tuple_data_or_null(slice->end));
+	}
+	if (vy_log_tx_commit() < 0)
+		goto fail;
+
+	/*
+	 * Remove compacted run files that were created after
+	 * the last checkpoint (and hence are not referenced
+	 * by any checkpoint) immediately to save disk space.
+	 */
+	vy_log_tx_begin();
+	rlist_foreach_entry(run, &unused_runs, in_unused) {
+		if (run->dump_lsn > gc_lsn &&
+		    vy_run_remove_files(vy_lsm_env_run_dir(lsm->env,
+							   run->is_cold),
+					lsm->space_id, lsm->index_id,
+					run->id) == 0) {
+			vy_log_forget_run(run->id);
+		}
+	}
+	vy_log_tx_try_commit();
+
+	/*
+	 * Account new runs that are not empty,
+	 * discard the rest.
+	 */
+	vy_disk_stmt_counter_reset(&compaction_output);
+	for (int i = 0; i < part_count; i++) {
+		struct vy_run *new_run = task->parts[i]->new_run;
+		vy_disk_stmt_counter_add(&compaction_output, &new_run->count);
+		if (!vy_run_is_empty(new_run)) {
+			vy_lsm_add_run(lsm, new_run);
+			/* Drop the reference held by the task. */
+			vy_run_unref(new_run);
+		} else
+			vy_run_discard(new_run);
+	}
+
+	/*
+	 * Replace the compacted range in the LSM tree. The range
+	 * was removed from the heap when the task was scheduled,
+	 * put it back so that it can be removed from the tree.
+	 */
+	vy_range_heap_insert(&lsm->range_heap, &range->heap_node);
+	vy_lsm_unacct_range(lsm, range);
+	vy_lsm_remove_range(lsm, range);
+	for (int i = 0; i < part_count; i++) {
+		vy_lsm_add_range(lsm, new_ranges[i]);
+		vy_lsm_acct_range(lsm, new_ranges[i]);
+	}
+	lsm->range_tree_version++;
+
+	vy_lsm_acct_compaction(lsm, compaction_time,
+			       &compaction_input, &compaction_output);
+	scheduler->stat.compaction_input += compaction_input.bytes;
+	scheduler->stat.compaction_output += compaction_output.bytes;
+	scheduler->stat.compaction_time += compaction_time;
+
+	/*
+	 * Unaccount unused runs and delete the compacted range
+	 * along with its slices.
+	 */
+	rlist_foreach_entry(run, &unused_runs, in_unused)
+		vy_lsm_remove_run(lsm, run);
+
+	say_info("%s: completed compacting range %s in %d parts",
+		 vy_lsm_name(lsm), vy_range_str(range), part_count);
+
+	rlist_foreach_entry(slice, &range->slices, in_range)
+		vy_slice_wait_pinned(slice);
+	vy_range_delete(range);
+
+	/* The iterators have been cleaned up in workers. */
+	for (int i = 0; i < part_count; i++)
+		task->parts[i]->wi->iface->close(task->parts[i]->wi);
+
+	vy_scheduler_update_lsm(scheduler, lsm);
+	return 0;
+fail:
+	for (int i = 0; i < part_count; i++) {
+		if (new_ranges[i] != NULL)
+			vy_range_delete(new_ranges[i]);
+	}
+	return -1;
 }
 
 static int
 vy_task_compaction_complete(struct vy_task *task)
 {
+	if (task->part_count > 0)
+		return vy_task_compaction_complete_split(task);
+
 	struct vy_scheduler *scheduler = task->scheduler;
 	struct vy_lsm *lsm = task->lsm;
 	struct vy_range *range = task->range;
@@ -1530,7 +2264,7 @@ vy_task_compaction_complete(struct vy_task *task)
 		vy_log_drop_run(run->id, gc_lsn);
 	if (new_slice != NULL) {
 		vy_log_create_run(lsm->id, new_run->id, new_run->dump_lsn,
-				  new_run->dump_count);
+				  new_run->dump_count, new_run->is_cold);
 		vy_log_insert_slice(range->id, new_run->id, new_slice->id,
 				    tuple_data_or_null(new_slice->begin),
 				    tuple_data_or_null(new_slice->end));
@@ -1549,8 +2283,10 @@ vy_task_compaction_complete(struct vy_task *task)
 	vy_log_tx_begin();
 	rlist_foreach_entry(run, &unused_runs, in_unused) {
 		if (run->dump_lsn > gc_lsn &&
-		    vy_run_remove_files(lsm->env->path, lsm->space_id,
-					lsm->index_id, run->id) == 0) {
+		    vy_run_remove_files(vy_lsm_env_run_dir(lsm->env,
+							   run->is_cold),
+					lsm->space_id, lsm->index_id,
+					run->id) == 0) {
 			vy_log_forget_run(run->id);
 		}
 	}
@@ -1631,6 +2367,11 @@ vy_task_compaction_abort(struct vy_task *task)
 
 	/* The iterator has been cleaned up in worker. */
 	task->wi->iface->close(task->wi);
+	for (int i = 1; i < task->part_count; i++) {
+		struct vy_task *part = task->parts[i];
+		part->wi->iface->close(part->wi);
+		vy_run_discard(part->new_run);
+	}
 
 	/*
 	 * It's no use alerting the user if the server is
@@ -1650,6 +2391,222 @@ vy_task_compaction_abort(struct vy_task *task)
 	vy_scheduler_update_lsm(scheduler, lsm);
 }
 
+/**
+ * Create the write iterator for a compaction task. If the task
+ * is a part of a split compaction, the compacted slices are cut
+ * by the part key span.
+ */
+static int
+vy_task_compaction_create_wi(struct vy_task *task, bool is_last_level)
+{
+	struct vy_scheduler *scheduler = task->scheduler;
+	struct vy_lsm *lsm = task->lsm;
+	bool is_part = task->begin != NULL || task->end != NULL;
+	struct vy_stmt_stream *wi;
+	wi = vy_write_iterator_new(task->cmp_def, lsm->disk_format,
+				   lsm->index_id == 0, is_last_level,
+				   scheduler->read_views,
+				   lsm->index_id > 0 ? NULL :
+				   &task->deferred_delete_handler);
+	if (wi == NULL)
+		return -1;
+
+	struct vy_slice *slice = task->first_slice;
+	while (true) {
+		struct vy_slice *src = slice;
+		if (is_part) {
+			if (vy_slice_cut(slice, vy_log_next_id(), task->begin,
+					 task->end, lsm->cmp_def, &src) != 0)
+				goto fail;
+			if (src != NULL)
+				rlist_add_tail_entry(&task->cut_slices,
+						     src, in_range);
+		}
+		if (src != NULL && vy_write_iterator_new_slice(wi, src) != 0)
+			goto fail;
+		if (slice == task->last_slice)
+			break;
+		slice = rlist_next_entry(slice, in_range);
+	}
+	task->wi = wi;
+	return 0;
+fail:
+	wi->iface->close(wi);
+	return -1;
+}
+
+/**
+ * Split a compaction task into parts by key so that they can be
+ * executed by several workers in parallel. This is only done if
+ * there are idle compaction workers and the data to compact is
+ * big enough for each part to make a range of its own, because
+ * the compacted range is replaced with one range per part on
+ * completion, see vy_task_compaction_complete_split().
+ * A part is never smaller than VY_COMPACTION_PART_SIZE_MIN.
+ *
+ * Split keys are taken from the page index of the oldest
+ * compacted run, which is usually the biggest one, so that
+ * the parts are of roughly the same size.
+ *
+ * On success sets task->parts and task->part_count, unless
+ * the task can't be split, in which case the latter stays 0.
+ * Returns -1 on memory allocation or metadata log error.
+ */
+static int
+vy_task_compaction_split(struct vy_task *task)
+{
+	struct vy_scheduler *scheduler = task->scheduler;
+	struct vy_lsm *lsm = task->lsm;
+	struct vy_range *range = task->range;
+	struct vy_slice *slice = task->last_slice;
+
+	int64_t part_size = MAX(vy_lsm_range_size(lsm),
+				VY_COMPACTION_PART_SIZE_MIN);
+	uint64_t max_part_count = range->compaction_queue.bytes / part_size;
+	max_part_count = MIN(max_part_count, VY_COMPACTION_PART_MAX);
+	max_part_count = MIN(max_part_count, (uint64_t)(slice->last_page_no -
+						slice->first_page_no + 1));
+	if (max_part_count < 2)
+		return 0;
+
+	struct vy_worker *workers[VY_COMPACTION_PART_MAX];
+	int worker_count = 0;
+	while ((uint64_t)worker_count < max_part_count - 1) {
+		struct vy_worker *worker;
+		worker = vy_worker_pool_get(&scheduler->compaction_pool);
+		if (worker == NULL)
+			break;
+		workers[worker_count++] = worker;
+	}
+
+	/*
+	 * Pick split keys at page boundaries. Skip keys that
+	 * don't fall strictly inside the range and between
+	 * the previously chosen keys.
+	 */
+	struct tuple *keys[VY_COMPACTION_PART_MAX + 1];
+	int part_count = 0;
+	keys[part_count++] = range->begin;
+	uint32_t page_count = slice->last_page_no - slice->first_page_no + 1;
+	for (int i = 1; i <= worker_count; i++) {
+		uint32_t page_no = slice->first_page_no +
+				   page_count * i / (worker_count + 1);
+		struct vy_page_info *page = vy_run_page_info(slice->run,
+							     page_no);
+		if (page == NULL)
+			goto fail;
+		struct tuple *key = vy_key_from_msgpack(lsm->env->key_format,
+							page->min_key);
+		if (key == NULL)
+			goto fail;
+		struct tuple *prev = keys[part_count - 1];
+		if ((prev != NULL &&
+		     vy_key_compare(key, prev, lsm->cmp_def) <= 0) ||
+		    (range->end != NULL &&
+		     vy_key_compare(key, range->end, lsm->cmp_def) >= 0)) {
+			tuple_unref(key);
+			continue;
+		}
+		keys[part_count++] = key;
+	}
+	keys[part_count] = range->end;
+	/* Return workers we don't need to the pool. */
+	while (worker_count > part_count - 1)
+		vy_worker_pool_put(workers[--worker_count]);
+	if (part_count < 2)
+		goto out;
+
+	task->parts[0] = task;
+	for (int i = 1; i < part_count; i++) {
+		struct vy_task *part = vy_task_new(scheduler, workers[i - 1],
+						   lsm, task->ops);
+		if (part == NULL)
+			goto fail_parts;
+		part->new_run = vy_run_prepare(scheduler->run_env, lsm,
+					       task->new_run->is_cold);
+		if (part->new_run == NULL) {
+			vy_task_delete(part);
+			goto fail_parts;
+		}
+		part->new_run->dump_lsn = task->new_run->dump_lsn;
+		part->new_run->dump_count = task->new_run->dump_count;
+		part->parent = task;
+		part->range = range;
+		part->first_slice = task->first_slice;
+		part->last_slice = task->last_slice;
+		part->bloom_fpr = task->bloom_fpr;
+		part->page_size = task->page_size;
+		part->blob_threshold = task->blob_threshold;
+		part->page_restart_interval = task->page_restart_interval;
+		part->columnar = task->columnar;
+		part->zone_map_fields = task->zone_map_fields;
+		if (vy_task_set_zdict(part, task->zdict, task->zdict_size,
+				      task->zdict_train_size) != 0) {
+			vy_run_discard(part->new_run);
+			vy_task_delete(part);
+			goto fail_parts;
+		}
+		task->parts[i] = part;
+		task->part_count = i + 1;
+	}
+	task->part_count = part_count;
+	task->parts_in_progress = part_count;
+	for (int i = 0; i < part_count; i++) {
+		struct vy_task *part = task->parts[i];
+		part->begin = keys[i];
+		if (part->begin != NULL)
+			tuple_ref(part->begin);
+		part->end = keys[i + 1];
+		if (part->end != NULL)
+			tuple_ref(part->end);
+	}
+out:
+	for (int i = 1; i < part_count; i++)
+		tuple_unref(keys[i]);
+	return 0;
+
+fail_parts:
+	for (int i = 1; i < task->part_count; i++) {
+		struct vy_task *part = task->parts[i];
+		vy_run_discard(part->new_run);
+		vy_task_delete(part);
+	}
+	task->part_count = 0;
+fail:
+	for (int i = 1; i < part_count; i++)
+		tuple_unref(keys[i]);
+	while (worker_count > 0)
+		vy_worker_pool_put(workers[--worker_count]);
+	return -1;
+}
+
+/**
+ * Return true if the run produced by compaction of the given
+ * range should be written to the cold storage tier. We only
+ * move runs there on major compaction, i.e. when the output
+ * is going to be the last level of the range, so that data
+ * that was recently dumped stays on fast storage. Blob files
+ * are shared between runs by hard links, which can't cross
+ * devices, so LSM trees using blobs always stay on the fast
+ * tier.
+ */
+static bool
+vy_task_compaction_is_cold(struct vy_lsm *lsm, struct vy_range *range)
+{
+	if (lsm->env->cold_path == NULL)
+		return false;
+	if (range->compaction_priority != range->slice_count)
+		return false;
+	if (lsm->opts.blob_threshold > 0)
+		return false;
+	struct vy_slice *slice;
+	rlist_foreach_entry(slice, &range->slices, in_range) {
+		if (slice->run->info.blob_count > 0)
+			return false;
+	}
+	return true;
+}
+
 static int
 vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 		       struct vy_lsm *lsm, struct vy_task **p_task)
@@ -1681,26 +2638,16 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	if (task == NULL)
 		goto err_task;
 
-	struct vy_run *new_run = vy_run_prepare(scheduler->run_env, lsm);
+	bool is_cold = vy_task_compaction_is_cold(lsm, range);
+	struct vy_run *new_run = vy_run_prepare(scheduler->run_env,
+						lsm, is_cold);
 	if (new_run == NULL)
 		goto err_run;
 
-	struct vy_stmt_stream *wi;
-	bool is_last_level = (range->compaction_priority == range->slice_count);
-	wi = vy_write_iterator_new(task->cmp_def, lsm->disk_format,
-				   lsm->index_id == 0, is_last_level,
-				   scheduler->read_views,
-				   lsm->index_id > 0 ? NULL :
-				   &task->deferred_delete_handler);
-	if (wi == NULL)
-		goto err_wi;
-
 	struct vy_slice *slice;
 	int32_t dump_count = 0;
 	int n = range->compaction_priority;
 	rlist_foreach_entry(slice, &range->slices, in_range) {
-		if (vy_write_iterator_new_slice(wi, slice) != 0)
-			goto err_wi_sub;
 		new_run->dump_lsn = MAX(new_run->dump_lsn,
 					slice->run->dump_lsn);
 		dump_count += slice->run->dump_count;
@@ -1714,7 +2661,8 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	}
 	assert(n == 0);
 	assert(new_run->dump_lsn >= 0);
-	if (range->compaction_priority == range->slice_count)
+	bool is_last_level = (range->compaction_priority == range->slice_count);
+	if (is_last_level)
 		dump_count -= slice->run->dump_count;
 	/*
 	 * Do not update dumps_per_compaction in case compaction
@@ -1726,13 +2674,29 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	else
 		new_run->dump_count = dump_count;
 
-	range->needs_compaction = false;
-
 	task->range = range;
 	task->new_run = new_run;
-	task->wi = wi;
 	task->bloom_fpr = lsm->opts.bloom_fpr;
+	task->blob_threshold = lsm->opts.blob_threshold;
+	task->page_restart_interval = lsm->opts.page_restart_interval;
+	task->columnar = lsm->opts.columnar;
+	task->zone_map_fields = lsm->opts.zone_map_fields;
 	task->page_size = lsm->opts.page_size;
+	if (vy_task_set_lsm_zdict(task, lsm) != 0)
+		goto err_split;
+
+	if (vy_task_compaction_split(task) != 0)
+		goto err_split;
+
+	int part_count = MAX(task->part_count, 1);
+	for (int i = 0; i < part_count; i++) {
+		struct vy_task *part = task->part_count > 0 ?
+				       task->parts[i] : task;
+		if (vy_task_compaction_create_wi(part, is_last_level) != 0)
+			goto err_wi;
+	}
+
+	range->needs_compaction = false;
 
 	/*
 	 * Remove the range we are going to compact from the heap
@@ -1742,15 +2706,28 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	range_node->pos = UINT32_MAX;
 	vy_scheduler_update_lsm(scheduler, lsm);
 
-	say_info("%s: started compacting range %s, runs %d/%d",
-		 vy_lsm_name(lsm), vy_range_str(range),
-                 range->compaction_priority, range->slice_count);
+	if (task->part_count > 0)
+		say_info("%s: started compacting range %s, runs %d/%d, "
+			 "parts %d", vy_lsm_name(lsm), vy_range_str(range),
+			 range->compaction_priority, range->slice_count,
+			 task->part_count);
+	else
+		say_info("%s: started compacting range %s, runs %d/%d",
+			 vy_lsm_name(lsm), vy_range_str(range),
+			 range->compaction_priority, range->slice_count);
 	*p_task = task;
 	return 0;
 
-err_wi_sub:
-	task->wi->iface->close(wi);
 err_wi:
+	for (int i = 0; i < part_count; i++) {
+		struct vy_task *part = task->part_count > 0 ?
+				       task->parts[i] : task;
+		if (part->wi != NULL)
+			part->wi->iface->close(part->wi);
+		if (part != task)
+			vy_run_discard(part->new_run);
+	}
+err_split:
 	vy_run_discard(new_run);
 err_run:
 	vy_task_delete(task);
@@ -1775,12 +2752,17 @@ vy_task_f(va_list va)
 	assert(worker->task == task);
 	assert(&worker->cord == cord());
 
+	bool is_dump = task->ops->execute == vy_task_dump_execute;
+	PROBE3(vy_task_start, is_dump, task->lsm->space_id,
+	       task->lsm->index_id);
 	if (task->ops->execute(task) != 0 && !task->is_failed) {
 		struct diag *diag = diag_get();
 		assert(!diag_is_empty(diag));
 		task->is_failed = true;
 		diag_move(diag, &task->diag);
 	}
+	PROBE4(vy_task_done, is_dump, task->lsm->space_id,
+	       task->lsm->index_id, task->is_failed);
 	cmsg_init(&task->cmsg, vy_task_complete_route);
 	cpipe_push(&worker->tx_pipe, &task->cmsg);
 	task->fiber = NULL;
@@ -1825,11 +2807,65 @@ static void
 vy_task_complete_f(struct cmsg *cmsg)
 {
 	struct vy_task *task = container_of(cmsg, struct vy_task, cmsg);
+	/*
+	 * A task split into parts is completed when the last
+	 * of its parts has been executed.
+	 */
+	if (task->parent != NULL)
+		task = task->parent;
+	assert(task->parts_in_progress > 0);
+	if (--task->parts_in_progress > 0)
+		return;
 	stailq_add_tail_entry(&task->scheduler->processed_tasks,
 			      task, in_processed);
 	fiber_cond_signal(&task->scheduler->scheduler_cond);
 }
 
+/**
+ * Add dumps of other LSM trees eligible for dump at the current
+ * round to a dump task so that they are completed together,
+ * with a single metadata log write, see vy_task_dump_complete().
+ * Each added dump is given an idle dump worker if there's one.
+ * Otherwise it is executed by the worker of the task itself
+ * after it's done with its own run.
+ */
+static void
+vy_scheduler_group_dump(struct vy_scheduler *scheduler, struct vy_task *task)
+{
+	assert(task->part_count == 0);
+	while (task->part_count < VY_DUMP_GROUP_MAX) {
+		struct heap_node *pn = vy_dump_heap_top(&scheduler->dump_heap);
+		if (pn == NULL)
+			break;
+		struct vy_lsm *lsm = container_of(pn, struct vy_lsm, in_dump);
+		if (lsm->is_dumping || lsm->pin_count > 0 ||
+		    vy_lsm_generation(lsm) != scheduler->dump_generation)
+			break;
+		struct vy_worker *worker;
+		worker = vy_worker_pool_get(&scheduler->dump_pool);
+		struct vy_task *part;
+		if (vy_task_dump_new(scheduler, worker, lsm, &part) != 0) {
+			/* The LSM tree will be retried on its own. */
+			diag_clear(diag_get());
+			if (worker != NULL)
+				vy_worker_pool_put(worker);
+			break;
+		}
+		if (part == NULL) {
+			/* All in-memory trees were empty. */
+			if (worker != NULL)
+				vy_worker_pool_put(worker);
+			continue;
+		}
+		if (task->part_count == 0)
+			task->parts[task->part_count++] = task;
+		task->parts[task->part_count++] = part;
+		part->parent = task;
+		if (worker != NULL)
+			task->parts_in_progress++;
+	}
+}
+
 /**
  * Create a task for dumping an LSM tree. The new task is returned
  * in @ptask. If there's no LSM tree that needs to be dumped or all
@@ -1884,8 +2920,10 @@ retry:
 			vy_worker_pool_put(worker);
 			return -1;
 		}
-		if (*ptask != NULL)
+		if (*ptask != NULL) {
+			vy_scheduler_group_dump(scheduler, *ptask);
 			return 0; /* new task */
+		}
 		/*
 		 * All in-memory trees eligible for dump were empty
 		 * and so were deleted without involving a worker
@@ -1989,6 +3027,15 @@ vy_task_complete(struct vy_task *task)
 		goto out;
 	}
 
+	/* A task split into parts fails if any of its parts fails. */
+	for (int i = 1; i < task->part_count; i++) {
+		struct vy_task *part = task->parts[i];
+		if (part->is_failed && !task->is_failed) {
+			task->is_failed = true;
+			diag_move(&part->diag, &task->diag);
+		}
+	}
+
 	struct diag *diag = &task->diag;
 	if (task->is_failed) {
 		assert(!diag_is_empty(diag));
@@ -2072,6 +3119,13 @@ vy_scheduler_f(va_list va)
 		/* Queue the task for execution. */
 		cmsg_init(&task->cmsg, vy_task_execute_route);
 		cpipe_push(&task->worker->worker_pipe, &task->cmsg);
+		for (int i = 1; i < task->part_count; i++) {
+			struct vy_task *part = task->parts[i];
+			if (part->worker == NULL)
+				continue; /* executed by the first part */
+			cmsg_init(&part->cmsg, vy_task_execute_route);
+			cpipe_push(&part->worker->worker_pipe, &part->cmsg);
+		}
 
 		fiber_reschedule();
 		continue;
@@ -50,6 +50,7 @@ extern "C" {
 struct fiber;
 struct vy_lsm;
 struct vy_run_env;
+struct vy_stmt_stream;
 struct vy_worker;
 struct vy_scheduler;
 
@@ -152,6 +153,12 @@ struct vy_scheduler {
 	struct rlist *read_views;
 	/** Context needed for writing runs. */
 	struct vy_run_env *run_env;
+	/**
+	 * Max rate at which all compaction tasks taken together
+	 * may write to disk, in bytes per second, or 0 if there's
+	 * no limit. Read by worker threads.
+	 */
+	size_t compaction_rate_limit;
 };
 
 /**
@@ -192,6 +199,14 @@ vy_scheduler_destroy(struct vy_scheduler *scheduler);
 void
 vy_scheduler_reset_stat(struct vy_scheduler *scheduler);
 
+/**
+ * Limit the rate at which compaction writes to disk.
+ * 0 means no limit.
+ */
+void
+vy_scheduler_set_compaction_rate_limit(struct vy_scheduler *scheduler,
+				       size_t limit);
+
 /**
  * Add an LSM tree to scheduler dump/compaction queues.
  */
@@ -224,6 +239,16 @@ void
 vy_scheduler_force_compaction(struct vy_scheduler *scheduler,
 			      struct vy_lsm *lsm);
 
+/**
+ * Write statements of @a stream, which are sorted by the key of
+ * LSM tree @a lsm and have LSN @a lsn, to a new run and add it to
+ * the LSM tree bypassing the memory level. The LSM tree must have
+ * no runs. Used for bulk loading, see box_space_bulk_load().
+ */
+int
+vy_scheduler_load_run(struct vy_scheduler *scheduler, struct vy_lsm *lsm,
+		      int64_t lsn, struct vy_stmt_stream *stream);
+
 /**
  * Schedule a checkpoint. Please call vy_scheduler_wait_checkpoint()
  * after that.
@@ -128,10 +128,26 @@ struct vy_lsm_stat {
 		/** How many upserts have been applied on read. */
 		int64_t applied;
 	} upsert;
+	/**
+	 * Deferred DELETE statistics. Maintained only for
+	 * the primary index, compaction of which generates
+	 * deferred DELETEs for secondary indexes.
+	 */
+	struct {
+		/** DELETEs written to _vinyl_deferred_delete. */
+		struct vy_stmt_counter count;
+		/**
+		 * Number of DELETEs that were not written,
+		 * because no secondary key was changed.
+		 */
+		int64_t skipped;
+	} deferred_delete;
 	/** Memory related statistics. */
 	struct {
 		/** Number of statements stored in memory. */
 		struct vy_stmt_counter count;
+		/** Statement statistics. */
+		struct vy_stmt_stat stmt;
 		/** Memory iterator statistics. */
 		struct vy_mem_iterator_stat iterator;
 	} memory;
@@ -209,6 +225,15 @@ struct vy_tx_stat {
 	int64_t rollback;
 	/** Number of transactions aborted on conflict. */
 	int64_t conflict;
+	/** Conflict checking cost. */
+	struct {
+		/** Number of written statements checked. */
+		int64_t statements;
+		/** Number of point reads compared with statements. */
+		int64_t points;
+		/** Number of range reads visited in interval trees. */
+		int64_t intervals;
+	} conflict_check;
 };
 
 /**
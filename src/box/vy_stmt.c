@@ -97,6 +97,7 @@ vy_tuple_new(struct tuple_format *format, const char *data, const char *end)
 struct tuple_format_vtab vy_tuple_format_vtab = {
 	vy_tuple_delete,
 	vy_tuple_new,
+	NULL,
 };
 
 size_t vy_max_tuple_size = 1024 * 1024;
@@ -466,8 +467,10 @@ vy_stmt_new_surrogate_from_key(const char *key, enum iproto_type type,
 				       iov[field->id].iov_len);
 				uint32_t data_offset = wpos - raw;
 				int32_t slot = field->offset_slot;
-				if (slot != TUPLE_OFFSET_SLOT_NIL)
-					field_map[slot] = data_offset;
+				if (slot != TUPLE_OFFSET_SLOT_NIL) {
+					tuple_field_map_set(format, field_map,
+							    slot, data_offset);
+				}
 				wpos += iov[field->id].iov_len;
 			}
 		} else if (field->type == FIELD_TYPE_ARRAY) {
@@ -572,8 +575,10 @@ vy_stmt_new_surrogate_delete_raw(struct tuple_format *format,
 			pos = mp_encode_nil(pos);
 			continue;
 		}
-		if (field->offset_slot != TUPLE_OFFSET_SLOT_NIL)
-			field_map[field->offset_slot] = pos - data;
+		if (field->offset_slot != TUPLE_OFFSET_SLOT_NIL) {
+			tuple_field_map_set(format, field_map,
+					    field->offset_slot, pos - data);
+		}
 		enum mp_type type = mp_typeof(*src_pos);
 		if ((type == MP_ARRAY || type == MP_MAP) &&
 		    !mp_stack_is_full(&stack)) {
@@ -647,14 +652,12 @@ vy_stmt_extract_key_raw(const char *data, const char *data_end,
 }
 
 /**
- * Encode the given statement meta data in a request.
+ * Encode the given statement flags in a request meta data.
  * Returns 0 on success, -1 on memory allocation error.
  */
 static int
-vy_stmt_meta_encode(const struct tuple *stmt, struct request *request,
-		    bool is_primary)
+vy_stmt_meta_encode(uint8_t flags, struct request *request)
 {
-	uint8_t flags = vy_stmt_persistent_flags(stmt, is_primary);
 	if (flags == 0)
 		return 0; /* nothing to encode */
 
@@ -737,7 +740,8 @@ vy_stmt_encode_primary(const struct tuple *value, struct key_def *key_def,
 	default:
 		unreachable();
 	}
-	if (vy_stmt_meta_encode(value, &request, true) != 0)
+	if (vy_stmt_meta_encode(vy_stmt_persistent_flags(value, true),
+				&request) != 0)
 		return -1;
 	xrow->bodycnt = xrow_encode_dml(&request, xrow->body);
 	if (xrow->bodycnt < 0)
@@ -769,7 +773,8 @@ vy_stmt_encode_secondary(const struct tuple *value, struct key_def *cmp_def,
 		request.key = extracted;
 		request.key_end = extracted + size;
 	}
-	if (vy_stmt_meta_encode(value, &request, false) != 0)
+	if (vy_stmt_meta_encode(vy_stmt_persistent_flags(value, false),
+				&request) != 0)
 		return -1;
 	xrow->bodycnt = xrow_encode_dml(&request, xrow->body);
 	if (xrow->bodycnt < 0)
@@ -778,6 +783,117 @@ vy_stmt_encode_secondary(const struct tuple *value, struct key_def *cmp_def,
 		return 0;
 }
 
+int
+vy_stmt_encode_blob_ref(const struct tuple *value, struct key_def *cmp_def,
+			const struct vy_blob_ref *ref,
+			struct xrow_header *xrow)
+{
+	enum iproto_type type = vy_stmt_type(value);
+	assert(type == IPROTO_REPLACE || type == IPROTO_INSERT);
+	memset(xrow, 0, sizeof(*xrow));
+	xrow->type = type;
+	xrow->lsn = vy_stmt_lsn(value);
+
+	/* Keep all fields up to the last key part. */
+	uint32_t field_count = 0;
+	for (uint32_t i = 0; i < cmp_def->part_count; i++)
+		field_count = MAX(field_count, cmp_def->parts[i].fieldno + 1);
+
+	uint32_t bsize;
+	const char *data = tuple_data_range(value, &bsize);
+	size_t size = bsize + mp_sizeof_array(field_count + 1) +
+		      field_count * mp_sizeof_nil() + mp_sizeof_array(3) +
+		      mp_sizeof_uint(ref->blob_id) +
+		      mp_sizeof_uint(ref->offset) +
+		      mp_sizeof_uint(ref->size);
+	char *buf = region_alloc(&fiber()->gc, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region", "blob ref");
+		return -1;
+	}
+	char *pos = mp_encode_array(buf, field_count + 1);
+	uint32_t count = mp_decode_array(&data);
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = data;
+		if (i < count)
+			mp_next(&data);
+		if (i < count &&
+		    (cmp_def->column_mask & (1ULL << MIN(i, 63))) != 0) {
+			memcpy(pos, field, data - field);
+			pos += data - field;
+		} else {
+			pos = mp_encode_nil(pos);
+		}
+	}
+	pos = mp_encode_array(pos, 3);
+	pos = mp_encode_uint(pos, ref->blob_id);
+	pos = mp_encode_uint(pos, ref->offset);
+	pos = mp_encode_uint(pos, ref->size);
+	assert(pos <= buf + size);
+
+	struct request request;
+	memset(&request, 0, sizeof(request));
+	request.type = type;
+	request.tuple = buf;
+	request.tuple_end = pos;
+	uint8_t flags = vy_stmt_persistent_flags(value, true);
+	if (vy_stmt_meta_encode(flags | VY_STMT_BLOB_REF, &request) != 0)
+		return -1;
+	xrow->bodycnt = xrow_encode_dml(&request, xrow->body);
+	if (xrow->bodycnt < 0)
+		return -1;
+	return 0;
+}
+
+int
+vy_stmt_blob_ref(const struct tuple *stub, struct vy_blob_ref *ref)
+{
+	assert(vy_stmt_flags(stub) & VY_STMT_BLOB_REF);
+	const char *data = tuple_data(stub);
+	uint32_t count = mp_decode_array(&data);
+	if (count == 0)
+		goto error;
+	for (uint32_t i = 0; i < count - 1; i++)
+		mp_next(&data);
+	if (mp_typeof(*data) != MP_ARRAY || mp_decode_array(&data) != 3 ||
+	    mp_typeof(*data) != MP_UINT)
+		goto error;
+	ref->blob_id = mp_decode_uint(&data);
+	if (mp_typeof(*data) != MP_UINT)
+		goto error;
+	ref->offset = mp_decode_uint(&data);
+	if (mp_typeof(*data) != MP_UINT)
+		goto error;
+	ref->size = mp_decode_uint(&data);
+	return 0;
+error:
+	diag_set(ClientError, ER_INVALID_RUN_FILE,
+		 tt_sprintf("Invalid blob reference: %s", vy_stmt_str(stub)));
+	return -1;
+}
+
+struct tuple *
+vy_stmt_new_from_blob(const struct tuple *stub, const char *data,
+		      const char *data_end)
+{
+	const char *pos = data;
+	if (mp_typeof(*data) != MP_ARRAY ||
+	    mp_check(&pos, data_end) != 0 || pos != data_end) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 tt_sprintf("Invalid blob data for %s",
+				    vy_stmt_str(stub)));
+		return NULL;
+	}
+	struct tuple *stmt = vy_stmt_new_with_ops(tuple_format(stub),
+						  data, data_end, NULL, 0,
+						  vy_stmt_type(stub));
+	if (stmt == NULL)
+		return NULL;
+	vy_stmt_set_lsn(stmt, vy_stmt_lsn(stub));
+	vy_stmt_set_flags(stmt, vy_stmt_flags(stub) & ~VY_STMT_BLOB_REF);
+	return stmt;
+}
+
 struct tuple *
 vy_stmt_decode(struct xrow_header *xrow, const struct key_def *key_def,
 	       struct tuple_format *format, bool is_primary)
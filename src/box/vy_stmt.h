@@ -54,6 +54,11 @@ struct iovec;
 #define MAX_LSN (INT64_MAX / 2)
 
 enum {
+	/**
+	 * Number of UPSERTs applied by a point lookup after
+	 * which the key is squashed in background.
+	 */
+	VY_UPSERT_READ_THRESHOLD = 16,
 	VY_UPSERT_THRESHOLD = 128,
 	VY_UPSERT_INF,
 };
@@ -105,11 +110,31 @@ enum {
 	 * compaction. It is never written to disk.
 	 */
 	VY_STMT_UPDATE			= 1 << 2,
+	/**
+	 * This flag is set for REPLACE and INSERT statements
+	 * that were stored in a primary index run as stubs
+	 * referring to a tuple in a blob file, see
+	 * index_opts::blob_threshold. A stub has the same key
+	 * fields as the tuple, nil in place of other fields,
+	 * and a reference to the tuple as the last field.
+	 * Stubs are only seen by the run and write iterators.
+	 */
+	VY_STMT_BLOB_REF		= 1 << 3,
 	/**
 	 * Bit mask of all statement flags.
 	 */
 	VY_STMT_FLAGS_ALL = (VY_STMT_DEFERRED_DELETE | VY_STMT_SKIP_READ |
-			     VY_STMT_UPDATE),
+			     VY_STMT_UPDATE | VY_STMT_BLOB_REF),
+};
+
+/** Location of a tuple stored in a blob file. */
+struct vy_blob_ref {
+	/** ID of the blob file, see struct vy_run_blob. */
+	int64_t blob_id;
+	/** Offset of the tuple in the file. */
+	uint64_t offset;
+	/** Size of the tuple. */
+	uint32_t size;
 };
 
 /**
@@ -140,8 +165,16 @@ enum {
  * +--------------+-----------------+
  *
  * Field 'operations' is used for storing operations of UPSERT statement.
+ *
+ * The header is packed: it is a part of every statement stored
+ * in vy_mem, the tuple cache and transaction write sets, and
+ * without packing the compiler would pad it from 20 to 32 bytes
+ * to align the LSN. This is significant for small key-value
+ * statements, which would otherwise fill box.cfg.vinyl_memory
+ * faster and trigger dumps more often. Fields are accessed only
+ * by value through the helpers below.
  */
-struct vy_stmt {
+struct PACKED vy_stmt {
 	struct tuple base;
 	int64_t lsn;
 	uint8_t  type; /* IPROTO_SELECT/REPLACE/UPSERT/DELETE */
@@ -396,6 +429,23 @@ vy_stmt_compare(const struct tuple *a, const struct tuple *b,
 	}
 }
 
+/**
+ * Return true if a REPLACE of @a old_tuple with @a new_tuple
+ * doesn't change the key of an index with comparison definition
+ * @a cmp_def, in which case the REPLACE overwrites @a old_tuple
+ * in the index and so no DELETE is needed for it. Multikey and
+ * functional indexes are never considered unchanged.
+ */
+static inline bool
+vy_stmt_key_is_unchanged(const struct tuple *old_tuple,
+			 const struct tuple *new_tuple,
+			 struct key_def *cmp_def)
+{
+	if (cmp_def->is_multikey || cmp_def->func_part_count > 0)
+		return false;
+	return vy_tuple_compare(old_tuple, new_tuple, cmp_def) == 0;
+}
+
 /** @sa tuple_compare_with_raw_key. */
 static inline int
 vy_stmt_compare_with_raw_key(const struct tuple *stmt, const char *key,
@@ -651,6 +701,44 @@ int
 vy_stmt_encode_secondary(const struct tuple *value, struct key_def *cmp_def,
 			 struct xrow_header *xrow);
 
+/**
+ * Encode a stub for a primary index REPLACE or INSERT statement
+ * whose tuple is stored in a blob file, see VY_STMT_BLOB_REF.
+ *
+ * @param value statement to encode
+ * @param cmp_def key definition of the primary index
+ * @param ref location of the tuple in the blob file
+ * @param xrow[out] xrow to fill
+ *
+ * @retval 0 if OK
+ * @retval -1 if error
+ */
+int
+vy_stmt_encode_blob_ref(const struct tuple *value, struct key_def *cmp_def,
+			const struct vy_blob_ref *ref,
+			struct xrow_header *xrow);
+
+/**
+ * Decode the blob reference stored in a stub.
+ *
+ * @retval 0 if OK
+ * @retval -1 if the stub is malformed
+ */
+int
+vy_stmt_blob_ref(const struct tuple *stub, struct vy_blob_ref *ref);
+
+/**
+ * Create a statement replacing a stub given the tuple read
+ * from a blob file. The new statement has the type, LSN and
+ * flags of the stub, sans VY_STMT_BLOB_REF.
+ *
+ * @retval stmt on success
+ * @retval NULL on error
+ */
+struct tuple *
+vy_stmt_new_from_blob(const struct tuple *stub, const char *data,
+		      const char *data_end);
+
 /**
  * Reconstruct vinyl tuple info and data from xrow
  *
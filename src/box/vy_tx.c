@@ -270,6 +270,9 @@ vy_read_interval_new(struct vy_tx *tx, struct vy_lsm *lsm,
 	interval->right = right;
 	interval->right_belongs = right_belongs;
 	interval->subtree_last = NULL;
+	interval->is_point = false;
+	interval->point_hash = 0;
+	rlist_create(&interval->in_point);
 	xm->read_set_size += tuple_size(left);
 	if (left != right)
 		xm->read_set_size += tuple_size(right);
@@ -295,7 +298,7 @@ vy_tx_read_set_free_cb(vy_tx_read_set_t *read_set,
 {
 	(void)arg;
 	(void)read_set;
-	vy_lsm_read_set_remove(&interval->lsm->read_set, interval);
+	vy_read_interval_unlink(interval);
 	vy_read_interval_delete(interval);
 	return NULL;
 }
@@ -349,6 +352,16 @@ vy_tx_is_in_read_view(struct vy_tx *tx)
 	return tx->read_view->vlsn != INT64_MAX;
 }
 
+/** Account the cost of a conflict check to tx manager statistics. */
+static void
+vy_tx_acct_conflict_check(struct tx_manager *xm,
+			  struct vy_tx_conflict_iterator *it)
+{
+	xm->stat.conflict_check.statements++;
+	xm->stat.conflict_check.points += it->point_count;
+	xm->stat.conflict_check.intervals += it->interval_count;
+}
+
 /**
  * Send to read view all transactions that are reading key @v
  * modified by transaction @tx.
@@ -357,7 +370,7 @@ static int
 vy_tx_send_to_read_view(struct vy_tx *tx, struct txv *v)
 {
 	struct vy_tx_conflict_iterator it;
-	vy_tx_conflict_iterator_init(&it, &v->lsm->read_set, v->stmt);
+	vy_tx_conflict_iterator_init(&it, v->lsm, v->stmt);
 	struct vy_tx *abort;
 	while ((abort = vy_tx_conflict_iterator_next(&it)) != NULL) {
 		/* Don't abort self. */
@@ -374,6 +387,7 @@ vy_tx_send_to_read_view(struct vy_tx *tx, struct txv *v)
 			return -1;
 		abort->read_view = rv;
 	}
+	vy_tx_acct_conflict_check(tx->xm, &it);
 	return 0;
 }
 
@@ -385,7 +399,7 @@ static void
 vy_tx_abort_readers(struct vy_tx *tx, struct txv *v)
 {
 	struct vy_tx_conflict_iterator it;
-	vy_tx_conflict_iterator_init(&it, &v->lsm->read_set, v->stmt);
+	vy_tx_conflict_iterator_init(&it, v->lsm, v->stmt);
 	struct vy_tx *abort;
 	while ((abort = vy_tx_conflict_iterator_next(&it)) != NULL) {
 		/* Don't abort self. */
@@ -396,6 +410,7 @@ vy_tx_abort_readers(struct vy_tx *tx, struct txv *v)
 			continue;
 		abort->state = VINYL_TX_ABORT;
 	}
+	vy_tx_acct_conflict_check(tx->xm, &it);
 }
 
 struct vy_tx *
@@ -410,6 +425,17 @@ vy_tx_begin(struct tx_manager *xm)
 	return tx;
 }
 
+int
+vy_tx_open_read_view(struct vy_tx *tx)
+{
+	assert(!vy_tx_is_in_read_view(tx));
+	struct vy_read_view *rv = tx_manager_read_view(tx->xm);
+	if (rv == NULL)
+		return -1;
+	tx->read_view = rv;
+	return 0;
+}
+
 /**
  * Rotate the active in-memory tree if necessary and pin it to make
  * sure it is not dumped until the transaction is complete.
@@ -591,6 +617,14 @@ vy_tx_handle_deferred_delete(struct vy_tx *tx, struct txv *v)
 	int rc = 0;
 	for (uint32_t i = 1; i < space->index_count; i++) {
 		struct vy_lsm *lsm = vy_lsm(space->index[i]);
+		/*
+		 * No need to delete the old tuple from an index
+		 * if its key isn't changed: the new statement
+		 * will overwrite it.
+		 */
+		if (vy_stmt_type(stmt) != IPROTO_DELETE &&
+		    vy_stmt_key_is_unchanged(delete_stmt, stmt, lsm->cmp_def))
+			continue;
 		struct txv *delete_txv = txv_new(tx, lsm, delete_stmt,
 						 UINT64_MAX);
 		if (delete_txv == NULL) {
@@ -657,9 +691,13 @@ vy_tx_prepare(struct vy_tx *tx)
 		if (v->is_overwritten)
 			continue;
 
-		/* Skip statements which don't change this secondary key. */
+		/*
+		 * Skip statements which don't change this secondary
+		 * key or the fields covered by it.
+		 */
 		if (lsm->index_id > 0 &&
-		    key_update_can_be_skipped(lsm->key_def->column_mask,
+		    key_update_can_be_skipped(lsm->key_def->column_mask |
+					      lsm->opts.covered_fields,
 					      v->column_mask))
 			continue;
 
@@ -930,13 +968,13 @@ vy_tx_track(struct vy_tx *tx, struct vy_lsm *lsm,
 		stailq_foreach_entry_safe(interval, next_interval, &merge,
 					  in_merge) {
 			vy_tx_read_set_remove(&tx->read_set, interval);
-			vy_lsm_read_set_remove(&lsm->read_set, interval);
+			vy_read_interval_unlink(interval);
 			vy_read_interval_delete(interval);
 		}
 	}
 
 	vy_tx_read_set_insert(&tx->read_set, new_interval);
-	vy_lsm_read_set_insert(&lsm->read_set, new_interval);
+	vy_read_interval_link(new_interval);
 	return 0;
 }
 
@@ -295,6 +295,17 @@ vy_tx_destroy(struct vy_tx *tx);
 struct vy_tx *
 vy_tx_begin(struct tx_manager *xm);
 
+/**
+ * Send a transaction to a read view of the current database
+ * state. The transaction will see a consistent snapshot and
+ * won't track reads, but it will be aborted if it tries to
+ * write. Used for transactions declared read-only.
+ *
+ * Returns 0 on success, -1 on memory allocation error.
+ */
+int
+vy_tx_open_read_view(struct vy_tx *tx);
+
 /** Prepare a transaction to be committed. */
 int
 vy_tx_prepare(struct vy_tx *tx);
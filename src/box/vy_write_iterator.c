@@ -184,6 +184,14 @@ struct vy_write_iterator {
 	 * of the old tuple from secondary indexes.
 	 */
 	struct tuple *deferred_delete_stmt;
+	/**
+	 * Blob files referenced by the source runs. File
+	 * descriptors are borrowed from the runs, while
+	 * ref_bytes is summed over all of them.
+	 */
+	struct vy_run_blob *blobs;
+	/** Number of entries in the blobs array. */
+	uint32_t blob_count;
 	/** Length of the @read_views. */
 	int rv_count;
 	/**
@@ -444,6 +452,7 @@ vy_write_iterator_close(struct vy_stmt_stream *vstream)
 	vy_write_iterator_stop(vstream);
 	vy_source_heap_destroy(&stream->src_heap);
 	tuple_format_unref(stream->format);
+	free(stream->blobs);
 	free(stream);
 }
 
@@ -471,6 +480,27 @@ vy_write_iterator_new_slice(struct vy_stmt_stream *vstream,
 			    struct vy_slice *slice)
 {
 	struct vy_write_iterator *stream = (struct vy_write_iterator *)vstream;
+	struct vy_run_info *info = &slice->run->info;
+	for (uint32_t i = 0; i < info->blob_count; i++) {
+		struct vy_run_blob *blob = &info->blobs[i];
+		struct vy_run_blob *found = vy_run_blob_find(stream->blobs,
+							     stream->blob_count,
+							     blob->id);
+		if (found != NULL) {
+			found->ref_bytes += blob->ref_bytes;
+			continue;
+		}
+		size_t size = (stream->blob_count + 1) *
+			      sizeof(*stream->blobs);
+		struct vy_run_blob *blobs = realloc(stream->blobs, size);
+		if (blobs == NULL) {
+			diag_set(OutOfMemory, size, "realloc",
+				 "struct vy_run_blob");
+			return -1;
+		}
+		blobs[stream->blob_count++] = *blob;
+		stream->blobs = blobs;
+	}
 	struct vy_write_src *src = vy_write_iterator_new_src(stream);
 	if (src == NULL)
 		return -1;
@@ -479,6 +509,30 @@ vy_write_iterator_new_slice(struct vy_stmt_stream *vstream,
 	return 0;
 }
 
+void
+vy_write_iterator_blobs(struct vy_stmt_stream *vstream,
+			struct vy_run_blob **blobs, uint32_t *blob_count)
+{
+	struct vy_write_iterator *stream = (struct vy_write_iterator *)vstream;
+	*blobs = stream->blobs;
+	*blob_count = stream->blob_count;
+}
+
+/**
+ * Read the tuple a stub refers to, see VY_STMT_BLOB_REF.
+ * Returns @a stmt with an extra reference if it isn't a stub.
+ */
+static struct tuple *
+vy_write_iterator_resolve(struct vy_write_iterator *stream,
+			  struct tuple *stmt)
+{
+	if ((vy_stmt_flags(stmt) & VY_STMT_BLOB_REF) == 0) {
+		vy_stmt_ref_if_possible(stmt);
+		return stmt;
+	}
+	return vy_run_blob_read(stream->blobs, stream->blob_count, stmt);
+}
+
 /**
  * Go to the next tuple in terms of sorted (merged) input steams.
  * @return 0 on success or not 0 on error (diag is set).
@@ -608,10 +662,17 @@ vy_write_iterator_deferred_delete(struct vy_write_iterator *stream,
 	if (stream->deferred_delete_stmt != NULL) {
 		struct vy_deferred_delete_handler *handler =
 				stream->deferred_delete_handler;
-		if (handler != NULL && vy_stmt_type(stmt) != IPROTO_DELETE &&
-		    handler->iface->process(handler, stmt,
-					    stream->deferred_delete_stmt) != 0)
-			return -1;
+		if (handler != NULL && vy_stmt_type(stmt) != IPROTO_DELETE) {
+			struct tuple *old = vy_write_iterator_resolve(stream,
+								      stmt);
+			if (old == NULL)
+				return -1;
+			int rc = handler->iface->process(handler, old,
+					stream->deferred_delete_stmt);
+			vy_stmt_unref_if_possible(old);
+			if (rc != 0)
+				return -1;
+		}
 		vy_stmt_unref_if_possible(stream->deferred_delete_stmt);
 		stream->deferred_delete_stmt = NULL;
 	}
@@ -848,8 +909,16 @@ vy_read_view_merge(struct vy_write_iterator *stream, struct tuple *hint,
 	     vy_stmt_type(hint) != IPROTO_UPSERT))) {
 		assert(!stream->is_last_level || hint == NULL ||
 		       vy_stmt_type(hint) != IPROTO_UPSERT);
-		struct tuple *applied = vy_apply_upsert(h->tuple, hint,
+		struct tuple *base = NULL;
+		if (hint != NULL) {
+			base = vy_write_iterator_resolve(stream, hint);
+			if (base == NULL)
+				return -1;
+		}
+		struct tuple *applied = vy_apply_upsert(h->tuple, base,
 				stream->cmp_def, stream->format, false);
+		if (base != NULL)
+			vy_stmt_unref_if_possible(base);
 		if (applied == NULL)
 			return -1;
 		vy_stmt_unref_if_possible(h->tuple);
@@ -858,6 +927,14 @@ vy_read_view_merge(struct vy_write_iterator *stream, struct tuple *hint,
 	/* Squash the rest of UPSERTs. */
 	struct vy_write_history *result = h;
 	h = h->next;
+	if (h != NULL) {
+		struct tuple *base = vy_write_iterator_resolve(stream,
+							       result->tuple);
+		if (base == NULL)
+			return -1;
+		vy_stmt_unref_if_possible(result->tuple);
+		result->tuple = base;
+	}
 	while (h != NULL) {
 		assert(h->tuple != NULL &&
 		       vy_stmt_type(h->tuple) == IPROTO_UPSERT);
@@ -934,6 +1011,8 @@ vy_read_view_merge(struct vy_write_iterator *stream, struct tuple *hint,
 		if (copy == NULL)
 			return -1;
 		vy_stmt_set_lsn(copy, vy_stmt_lsn(rv->tuple));
+		vy_stmt_set_flags(copy, vy_stmt_flags(rv->tuple) &
+					VY_STMT_BLOB_REF);
 		vy_stmt_unref_if_possible(rv->tuple);
 		rv->tuple = copy;
 	}
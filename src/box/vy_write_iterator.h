@@ -199,6 +199,7 @@ struct tuple_format;
 struct tuple;
 struct vy_mem;
 struct vy_slice;
+struct vy_run_blob;
 
 /**
  * Callback invoked by the write iterator for tuples that were
@@ -269,5 +270,14 @@ NODISCARD int
 vy_write_iterator_new_slice(struct vy_stmt_stream *stream,
 			    struct vy_slice *slice);
 
+/**
+ * Return the blob files referenced by the run slices added to
+ * the iterator. Stubs returned by the iterator refer to them,
+ * see VY_STMT_BLOB_REF.
+ */
+void
+vy_write_iterator_blobs(struct vy_stmt_stream *stream,
+			struct vy_run_blob **blobs, uint32_t *blob_count);
+
 #endif /* INCLUDES_TARANTOOL_BOX_VY_WRITE_STREAM_H */
 
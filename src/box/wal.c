@@ -43,6 +43,14 @@
 #include "cbus.h"
 #include "coio_task.h"
 #include "replication.h"
+#include "histogram.h"
+#include "latency.h"
+#include "info.h"
+#include "io_ring.h"
+#include "wal_ring.h"
+#include "wal_spare.h"
+#include "pmatomic.h"
+#include "probe.h"
 
 enum {
 	/**
@@ -54,6 +62,12 @@ enum {
 	 * latency. 1 MB seems to be a well balanced choice.
 	 */
 	WAL_FALLOCATE_LEN = 1024 * 1024,
+	/**
+	 * Size of the WAL thread io_uring instance. Writes are
+	 * synchronous, so the ring doesn't need to hold more
+	 * than a write and its sync.
+	 */
+	WAL_IO_RING_ENTRIES = 2,
 };
 
 const char *wal_mode_STRS[] = { "none", "write", "fsync", NULL };
@@ -89,6 +103,21 @@ struct wal_writer
 	struct stailq rollback;
 	/** A pipe from 'tx' thread to 'wal' */
 	struct cpipe wal_pipe;
+	/**
+	 * A setting from instance configuration - wal_batch_delay.
+	 * If greater than zero, a batch of write requests is held
+	 * in tx for up to this many seconds so that more requests
+	 * could join it (group commit).
+	 */
+	double batch_delay;
+	/**
+	 * Another one - wal_batch_max_size. A batch held back by
+	 * group commit is sent to WAL as soon as its approximate
+	 * size reaches this value.
+	 */
+	int64_t batch_max_size;
+	/** Timer flushing a batch held back by group commit. */
+	struct ev_timer batch_timer;
 	/* ----------------- wal ------------------- */
 	/** A setting from instance configuration - rows_per_wal */
 	int64_t wal_max_rows;
@@ -125,6 +154,11 @@ struct wal_writer
 	struct vclock checkpoint_vclock;
 	/** Total size of WAL files written since the last checkpoint. */
 	int64_t checkpoint_wal_size;
+	/**
+	 * Total size of data written to WAL files. Updated by
+	 * the WAL thread, read by tx, see wal_bytes_written().
+	 */
+	int64_t bytes_written;
 	/**
 	 * Checkpoint threshold: when the total size of WAL files
 	 * written since the last checkpoint exceeds the value of
@@ -154,6 +188,29 @@ struct wal_writer
 	 * Used for replication relays.
 	 */
 	struct rlist watchers;
+	/** Sizes of batches written to disk, in bytes. */
+	struct histogram *batch_size_hist;
+	/**
+	 * Time it takes to write a batch to disk in the fsync
+	 * mode, i.e. the time it takes to sync it, because WAL
+	 * files are opened with O_SYNC or synced after each
+	 * write in this mode.
+	 */
+	struct latency fsync_latency;
+	/** Submit writes through io_uring, see io_ring.h. */
+	bool use_io_ring;
+	/**
+	 * Ring of recently written rows shared with relays,
+	 * see wal_ring.h. NULL if disabled.
+	 */
+	struct wal_ring *ring;
+	/** Number of spare WAL files to keep, wal_spare_files. */
+	int spare_files;
+	/**
+	 * Pool of preallocated files used on rotation, see
+	 * wal_spare.h. NULL if disabled.
+	 */
+	struct wal_spare_pool *spare_pool;
 };
 
 struct wal_msg {
@@ -284,6 +341,7 @@ tx_schedule_commit(struct cmsg *msg)
 	}
 	/* Update the tx vclock to the latest written by wal. */
 	vclock_copy(&replicaset.vclock, &batch->vclock);
+	fiber_cond_broadcast(&replicaset.vclock_cond);
 	tx_schedule_queue(&batch->commit);
 }
 
@@ -335,6 +393,16 @@ tx_notify_checkpoint(struct cmsg *msg)
 	free(msg);
 }
 
+/** Send a batch held back by group commit to WAL. */
+static void
+wal_batch_timer_cb(ev_loop *loop, struct ev_timer *timer, int events)
+{
+	(void)loop;
+	(void)events;
+	struct wal_writer *writer = (struct wal_writer *)timer->data;
+	cpipe_flush_input(&writer->wal_pipe);
+}
+
 /**
  * Initialize WAL writer context. Even though it's a singleton,
  * encapsulate the details just in case we may use
@@ -345,9 +413,14 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 		  const char *wal_dirname, int64_t wal_max_rows,
 		  int64_t wal_max_size, const struct tt_uuid *instance_uuid,
 		  wal_on_garbage_collection_f on_garbage_collection,
-		  wal_on_checkpoint_threshold_f on_checkpoint_threshold)
+		  wal_on_checkpoint_threshold_f on_checkpoint_threshold,
+		  bool use_io_ring, int spare_files, bool direct_io)
 {
 	writer->wal_mode = wal_mode;
+	writer->use_io_ring = use_io_ring;
+	writer->ring = NULL;
+	writer->spare_files = spare_files;
+	writer->spare_pool = NULL;
 	writer->wal_max_rows = wal_max_rows;
 	writer->wal_max_size = wal_max_size;
 	journal_create(&writer->base, wal_mode == WAL_NONE ?
@@ -355,8 +428,26 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 
 	xdir_create(&writer->wal_dir, wal_dirname, XLOG, instance_uuid);
 	xlog_clear(&writer->current_wal);
-	if (wal_mode == WAL_FSYNC)
-		writer->wal_dir.open_wflags |= O_SYNC;
+	if (direct_io && wal_mode != WAL_NONE) {
+		/*
+		 * Writes bypass both io_uring and the page
+		 * cache, see xlog_set_direct_io(). Metadata
+		 * needed to read the data back is synced by
+		 * O_DSYNC, so O_SYNC isn't needed.
+		 */
+		writer->wal_dir.direct_io = true;
+		if (wal_mode == WAL_FSYNC)
+			writer->wal_dir.open_wflags |= O_DSYNC;
+	} else if (wal_mode == WAL_FSYNC) {
+		/*
+		 * With io_uring, a write and its sync are
+		 * submitted together, see io_ring_writev().
+		 */
+		if (use_io_ring)
+			writer->wal_dir.datasync_on_write = true;
+		else
+			writer->wal_dir.open_wflags |= O_SYNC;
+	}
 
 	stailq_create(&writer->rollback);
 	cmsg_init(&writer->in_rollback, NULL);
@@ -369,6 +460,24 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 	vclock_create(&writer->checkpoint_vclock);
 	rlist_create(&writer->watchers);
 
+	writer->batch_delay = 0;
+	writer->batch_max_size = INT64_MAX;
+	ev_timer_init(&writer->batch_timer, wal_batch_timer_cb, 0, 0);
+	writer->batch_timer.data = writer;
+
+	enum { KB = 1024, MB = 1024 * KB };
+	static const int64_t batch_size_buckets[] = {
+		256, 512, 1 * KB, 2 * KB, 4 * KB, 8 * KB, 16 * KB, 32 * KB,
+		64 * KB, 128 * KB, 256 * KB, 512 * KB, 1 * MB, 2 * MB,
+		4 * MB, 8 * MB, 16 * MB, 32 * MB, 64 * MB,
+	};
+	writer->batch_size_hist = histogram_new(batch_size_buckets,
+						lengthof(batch_size_buckets));
+	if (writer->batch_size_hist == NULL)
+		panic("failed to allocate WAL batch size histogram");
+	if (latency_create(&writer->fsync_latency) != 0)
+		panic("failed to allocate WAL fsync latency histogram");
+
 	writer->on_garbage_collection = on_garbage_collection;
 	writer->on_checkpoint_threshold = on_checkpoint_threshold;
 }
@@ -377,6 +486,11 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 static void
 wal_writer_destroy(struct wal_writer *writer)
 {
+	ev_timer_stop(loop(), &writer->batch_timer);
+	histogram_delete(writer->batch_size_hist);
+	latency_destroy(&writer->fsync_latency);
+	if (writer->spare_pool != NULL)
+		wal_spare_pool_delete(writer->spare_pool);
 	xdir_destroy(&writer->wal_dir);
 }
 
@@ -392,7 +506,21 @@ wal_open_f(struct cbus_call_msg *msg)
 	const char *path = xdir_format_filename(&writer->wal_dir,
 				vclock_sum(&writer->vclock), NONE);
 	assert(!xlog_is_open(&writer->current_wal));
-	return xlog_open(&writer->current_wal, path);
+	if (xlog_open(&writer->current_wal, path) != 0)
+		return -1;
+	writer->current_wal.compress_threads =
+		writer->wal_dir.compress_threads;
+	writer->current_wal.datasync_on_write =
+		writer->wal_dir.datasync_on_write;
+	if (writer->wal_dir.direct_io) {
+		if ((writer->wal_dir.open_wflags & O_DSYNC) != 0)
+			writer->current_wal.datasync_on_write = true;
+		if (xlog_set_direct_io(&writer->current_wal) != 0) {
+			xlog_close(&writer->current_wal, false);
+			return -1;
+		}
+	}
+	return 0;
 }
 
 /**
@@ -457,7 +585,9 @@ int
 wal_init(enum wal_mode wal_mode, const char *wal_dirname, int64_t wal_max_rows,
 	 int64_t wal_max_size, const struct tt_uuid *instance_uuid,
 	 wal_on_garbage_collection_f on_garbage_collection,
-	 wal_on_checkpoint_threshold_f on_checkpoint_threshold)
+	 wal_on_checkpoint_threshold_f on_checkpoint_threshold,
+	 bool use_io_ring, int64_t ring_size, int spare_files,
+	 bool direct_io)
 {
 	assert(wal_max_rows > 1);
 
@@ -465,7 +595,14 @@ wal_init(enum wal_mode wal_mode, const char *wal_dirname, int64_t wal_max_rows,
 	struct wal_writer *writer = &wal_writer_singleton;
 	wal_writer_create(writer, wal_mode, wal_dirname, wal_max_rows,
 			  wal_max_size, instance_uuid, on_garbage_collection,
-			  on_checkpoint_threshold);
+			  on_checkpoint_threshold, use_io_ring, spare_files,
+			  direct_io);
+
+	if (ring_size > 0 && wal_mode != WAL_NONE) {
+		writer->ring = wal_ring_new(ring_size);
+		if (writer->ring == NULL)
+			return -1;
+	}
 
 	/* Start WAL thread. */
 	if (cord_costart(&writer->cord, "wal", wal_writer_f, NULL) != 0)
@@ -485,6 +622,10 @@ wal_enable(void)
 	/* Initialize the writer vclock from the recovery state. */
 	vclock_copy(&writer->vclock, &replicaset.vclock);
 
+	/* Rows written before this point are in files only. */
+	if (writer->ring != NULL)
+		wal_ring_reset(writer->ring, &writer->vclock);
+
 	/*
 	 * Scan the WAL directory to build an index of all
 	 * existing WAL files. Required for garbage collection,
@@ -493,6 +634,18 @@ wal_enable(void)
 	if (xdir_scan(&writer->wal_dir))
 		return -1;
 
+	/*
+	 * Start preparing spare files once the WAL directory
+	 * is known to exist.
+	 */
+	if (writer->spare_files > 0 && writer->wal_mode != WAL_NONE) {
+		writer->spare_pool = wal_spare_pool_new(
+			writer->wal_dir.dirname, writer->spare_files,
+			writer->wal_max_size);
+		if (writer->spare_pool == NULL)
+			return -1;
+	}
+
 	/* Open the most recent WAL file. */
 	if (wal_open(writer) != 0)
 		return -1;
@@ -639,6 +792,12 @@ wal_set_checkpoint_threshold_f(struct cbus_call_msg *data)
 	return 0;
 }
 
+int64_t
+wal_bytes_written(void)
+{
+	return pm_atomic_load(&wal_writer_singleton.bytes_written);
+}
+
 void
 wal_set_checkpoint_threshold(int64_t threshold)
 {
@@ -654,12 +813,164 @@ wal_set_checkpoint_threshold(int64_t threshold)
 	fiber_set_cancellable(cancellable);
 }
 
+void
+wal_set_batch_delay(double delay)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	writer->batch_delay = delay;
+	if (delay <= 0 && ev_is_active(&writer->batch_timer)) {
+		ev_timer_stop(loop(), &writer->batch_timer);
+		cpipe_flush_input(&writer->wal_pipe);
+	}
+}
+
+void
+wal_set_batch_max_size(int64_t size)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	writer->batch_max_size = size;
+}
+
+struct wal_set_compress_threads_msg {
+	struct cbus_call_msg base;
+	int threads;
+};
+
+static int
+wal_set_compress_threads_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_set_compress_threads_msg *msg;
+	msg = (struct wal_set_compress_threads_msg *)data;
+	/*
+	 * Blocks are only queued while a batch is being
+	 * written, so it's safe to update the current WAL.
+	 */
+	writer->wal_dir.compress_threads = msg->threads;
+	if (xlog_is_open(&writer->current_wal)) {
+		assert(writer->current_wal.block_count == 0);
+		writer->current_wal.compress_threads = msg->threads;
+	}
+	return 0;
+}
+
+void
+wal_set_compress_threads(int threads)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_set_compress_threads_msg msg;
+	msg.threads = threads;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+		  &msg.base, wal_set_compress_threads_f, NULL,
+		  TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+struct wal_stat_msg {
+	struct cbus_call_msg base;
+	int64_t batch_count;
+	int64_t batch_size[3];
+	double fsync_latency[3];
+};
+
+/** Percentiles reported by box.stat.wal(). */
+static const int wal_stat_pct[] = { 50, 90, 99 };
+static const char *wal_stat_pct_strs[] = { "p50", "p90", "p99" };
+
+static int
+wal_stat_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_stat_msg *msg = (struct wal_stat_msg *)data;
+	msg->batch_count = writer->batch_size_hist->total;
+	for (int i = 0; i < (int)lengthof(wal_stat_pct); i++) {
+		msg->batch_size[i] = histogram_percentile(
+				writer->batch_size_hist, wal_stat_pct[i]);
+		msg->fsync_latency[i] = latency_get(&writer->fsync_latency,
+						    wal_stat_pct[i]);
+	}
+	return 0;
+}
+
+void
+wal_stat(struct info_handler *h)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_stat_msg msg;
+	memset(&msg, 0, sizeof(msg));
+	if (writer->wal_mode != WAL_NONE) {
+		bool cancellable = fiber_set_cancellable(false);
+		cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+			  &msg.base, wal_stat_f, NULL, TIMEOUT_INFINITY);
+		fiber_set_cancellable(cancellable);
+	}
+	info_begin(h);
+	info_append_int(h, "batches", msg.batch_count);
+	info_table_begin(h, "batch_size");
+	for (int i = 0; i < (int)lengthof(wal_stat_pct); i++)
+		info_append_int(h, wal_stat_pct_strs[i], msg.batch_size[i]);
+	info_table_end(h);
+	info_table_begin(h, "fsync_latency");
+	for (int i = 0; i < (int)lengthof(wal_stat_pct); i++)
+		info_append_double(h, wal_stat_pct_strs[i],
+				   msg.fsync_latency[i]);
+	info_table_end(h);
+	info_end(h);
+}
+
+static int
+wal_reset_stat_f(struct cbus_call_msg *data)
+{
+	(void)data;
+	struct wal_writer *writer = &wal_writer_singleton;
+	histogram_reset(writer->batch_size_hist);
+	latency_reset(&writer->fsync_latency);
+	return 0;
+}
+
+void
+wal_reset_stat(void)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct cbus_call_msg msg;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe, &msg,
+		  wal_reset_stat_f, NULL, TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
 struct wal_gc_msg
 {
 	struct cbus_call_msg base;
 	const struct vclock *vclock;
 };
 
+/**
+ * Hand WAL files older than @a signature over to the spare
+ * pool while it takes them. The rest is deleted as usual.
+ */
+static void
+wal_recycle_garbage(struct wal_writer *writer, int64_t signature)
+{
+	struct xdir *dir = &writer->wal_dir;
+	struct vclock *vclock;
+	while ((vclock = vclockset_first(&dir->index)) != NULL &&
+	       vclock_sum(vclock) < signature) {
+		const char *filename = xdir_format_filename(dir,
+					vclock_sum(vclock), NONE);
+		if (!wal_spare_pool_recycle(writer->spare_pool, filename))
+			break;
+		say_info("recycling %s", filename);
+		vclockset_remove(&dir->index, vclock);
+		free(vclock);
+	}
+}
+
 static int
 wal_collect_garbage_f(struct cbus_call_msg *data)
 {
@@ -681,9 +992,13 @@ wal_collect_garbage_f(struct cbus_call_msg *data)
 		 */
 		vclock = vclockset_psearch(&writer->wal_dir.index, vclock);
 	}
-	if (vclock != NULL)
-		xdir_collect_garbage(&writer->wal_dir, vclock_sum(vclock),
+	if (vclock != NULL) {
+		int64_t signature = vclock_sum(vclock);
+		if (writer->spare_pool != NULL)
+			wal_recycle_garbage(writer, signature);
+		xdir_collect_garbage(&writer->wal_dir, signature,
 				     XDIR_GC_ASYNC);
+	}
 
 	return 0;
 }
@@ -740,11 +1055,24 @@ wal_opt_rotate(struct wal_writer *writer)
 	if (xlog_is_open(&writer->current_wal))
 		return 0;
 
+	struct wal_spare spare;
+	if (writer->spare_pool != NULL &&
+	    wal_spare_pool_take(writer->spare_pool, &spare)) {
+		if (xdir_create_xlog_from_spare(&writer->wal_dir,
+						&writer->current_wal,
+						&writer->vclock, spare.fd,
+						spare.path,
+						spare.allocated) == 0)
+			goto created;
+		/* Fall back on creating a file from scratch. */
+		diag_log();
+	}
 	if (xdir_create_xlog(&writer->wal_dir, &writer->current_wal,
 			     &writer->vclock) != 0) {
 		diag_log();
 		return -1;
 	}
+created:
 	/*
 	 * Keep track of the new WAL vclock. Required for garbage
 	 * collection, see wal_collect_garbage().
@@ -901,6 +1229,30 @@ wal_assign_lsn(struct vclock *vclock, struct xrow_header **row,
 	}
 }
 
+/**
+ * Copy rows that have been written to disk to the WAL ring
+ * so that relays can send them without reading files.
+ */
+static void
+wal_feed_ring(struct wal_writer *writer, struct stailq *commit)
+{
+	struct journal_entry *entry;
+	stailq_foreach_entry(entry, commit, fifo) {
+		for (int i = 0; i < entry->n_rows; i++) {
+			if (wal_ring_append(writer->ring, entry->rows[i]) == 0)
+				continue;
+			/*
+			 * Relays can't skip a row. Pretend all rows
+			 * written so far have been evicted so that
+			 * they read the rest from files.
+			 */
+			diag_log();
+			wal_ring_reset(writer->ring, &writer->vclock);
+			return;
+		}
+	}
+}
+
 static void
 wal_write_to_disk(struct cmsg *msg)
 {
@@ -961,6 +1313,9 @@ wal_write_to_disk(struct cmsg *msg)
 	 */
 
 	struct xlog *l = &writer->current_wal;
+	double write_start = ev_monotonic_time();
+	int64_t batch_size = 0;
+	PROBE1(wal_write_to_disk_start, wal_msg->approx_len);
 
 	/*
 	 * Iterate over requests (transactions)
@@ -976,6 +1331,7 @@ wal_write_to_disk(struct cmsg *msg)
 			goto done;
 		if (rc > 0) {
 			writer->checkpoint_wal_size += rc;
+			batch_size += rc;
 			last_committed = &entry->fifo;
 			vclock_copy(&writer->vclock, &vclock);
 		}
@@ -986,9 +1342,16 @@ wal_write_to_disk(struct cmsg *msg)
 		goto done;
 
 	writer->checkpoint_wal_size += rc;
+	batch_size += rc;
 	last_committed = stailq_last(&wal_msg->commit);
 	vclock_copy(&writer->vclock, &vclock);
 
+	histogram_collect(writer->batch_size_hist, batch_size);
+	pm_atomic_fetch_add(&writer->bytes_written, batch_size);
+	if (writer->wal_mode == WAL_FSYNC)
+		latency_collect(&writer->fsync_latency,
+				ev_monotonic_time() - write_start);
+
 	/*
 	 * Notify TX if the checkpoint threshold has been exceeded.
 	 * Use malloc() for allocating the notification message and
@@ -1012,6 +1375,7 @@ wal_write_to_disk(struct cmsg *msg)
 	}
 
 done:
+	PROBE1(wal_write_to_disk_done, batch_size);
 	error = diag_last_error(diag_get());
 	if (error) {
 		/* Until we can pass the error to tx, log it and clear. */
@@ -1034,6 +1398,9 @@ done:
 	struct stailq rollback;
 	stailq_cut_tail(&wal_msg->commit, last_committed, &rollback);
 
+	if (writer->ring != NULL)
+		wal_feed_ring(writer, &wal_msg->commit);
+
 	if (!stailq_empty(&rollback)) {
 		/* Update status of the successfully committed requests. */
 		stailq_foreach_entry(entry, &rollback, fifo)
@@ -1046,6 +1413,12 @@ done:
 	wal_notify_watchers(writer, WAL_EVENT_WRITE);
 }
 
+struct wal_ring *
+wal_get_ring(void)
+{
+	return wal_writer_singleton.ring;
+}
+
 /** WAL writer main loop.  */
 static int
 wal_writer_f(va_list ap)
@@ -1056,6 +1429,12 @@ wal_writer_f(va_list ap)
 	/** Initialize eio in this thread */
 	coio_enable();
 
+	if (writer->use_io_ring && io_ring_create(WAL_IO_RING_ENTRIES) != 0) {
+		diag_log();
+		say_warn("failed to set up io_uring for WAL, "
+			 "using regular writes");
+	}
+
 	struct cbus_endpoint endpoint;
 	cbus_endpoint_create(&endpoint, "wal", fiber_schedule_cb, fiber());
 	/*
@@ -1091,9 +1470,35 @@ wal_writer_f(va_list ap)
 		xlog_close(&vy_log_writer.xlog, false);
 
 	cpipe_destroy(&writer->tx_prio_pipe);
+	io_ring_destroy();
 	return 0;
 }
 
+/**
+ * Send pending write requests to WAL unless group commit is
+ * enabled and the current batch is still small, in which case
+ * the batch is held in the tx->wal pipe for at most
+ * wal_batch_delay seconds, letting more transactions join it
+ * and hence share a single write and sync.
+ */
+static void
+wal_flush_input(struct wal_writer *writer, struct wal_msg *batch)
+{
+	struct cpipe *pipe = &writer->wal_pipe;
+	if (writer->batch_delay > 0 &&
+	    (int64_t)batch->approx_len < writer->batch_max_size &&
+	    pipe->n_input < pipe->max_input) {
+		if (!ev_is_active(&writer->batch_timer)) {
+			ev_timer_set(&writer->batch_timer,
+				     writer->batch_delay, 0);
+			ev_timer_start(loop(), &writer->batch_timer);
+		}
+		return;
+	}
+	ev_timer_stop(loop(), &writer->batch_timer);
+	cpipe_flush_input(pipe);
+}
+
 /**
  * WAL writer main entry point: queue a single request
  * to be written to disk and wait until this task is completed.
@@ -1136,15 +1541,16 @@ wal_write(struct journal *journal, struct journal_entry *entry)
 		wal_msg_create(batch);
 		/*
 		 * Sic: first add a request, then push the batch,
-		 * since cpipe_push() may pass the batch to WAL
-		 * thread right away.
+		 * since flushing the pipe may pass the batch to
+		 * WAL thread right away.
 		 */
 		stailq_add_tail_entry(&batch->commit, entry, fifo);
-		cpipe_push(&writer->wal_pipe, &batch->base);
+		cpipe_push_input(&writer->wal_pipe, &batch->base);
 	}
 	batch->approx_len += entry->approx_len;
 	writer->wal_pipe.n_input += entry->n_rows * XROW_IOVMAX;
-	cpipe_flush_input(&writer->wal_pipe);
+	PROBE2(wal_write_queue, entry->n_rows, entry->approx_len);
+	wal_flush_input(writer, batch);
 	/**
 	 * It's not safe to spuriously wakeup this fiber
 	 * since in that case it will ignore a possible
@@ -1152,8 +1558,11 @@ wal_write(struct journal *journal, struct journal_entry *entry)
 	 * transaction.
 	 */
 	bool cancellable = fiber_set_cancellable(false);
+	enum fiber_wait_reason reason = fiber_set_wait_reason(FIBER_WAIT_WAL);
 	fiber_yield(); /* Request was inserted. */
+	fiber_set_wait_reason(reason);
 	fiber_set_cancellable(cancellable);
+	PROBE1(wal_write_done, entry->res);
 	return entry->res;
 }
 
@@ -1164,6 +1573,7 @@ wal_write_in_wal_mode_none(struct journal *journal,
 	struct wal_writer *writer = (struct wal_writer *) journal;
 	wal_assign_lsn(&writer->vclock, entry->rows, entry->rows + entry->n_rows);
 	vclock_copy(&replicaset.vclock, &writer->vclock);
+	fiber_cond_broadcast(&replicaset.vclock_cond);
 	return vclock_sum(&writer->vclock);
 }
 
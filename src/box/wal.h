@@ -40,9 +40,13 @@
 struct fiber;
 struct wal_writer;
 struct tt_uuid;
+struct wal_ring;
+struct info_handler;
 
 enum wal_mode { WAL_NONE = 0, WAL_WRITE, WAL_FSYNC, WAL_MODE_MAX };
 
+enum { WAL_COMPRESS_THREADS_MAX = 64 };
+
 /** String constants for the supported modes. */
 extern const char *wal_mode_STRS[];
 
@@ -70,12 +74,23 @@ typedef void (*wal_on_checkpoint_threshold_f)(void);
 
 /**
  * Start WAL thread and initialize WAL writer.
+ * If @use_io_ring is set, the WAL thread submits writes
+ * through io_uring, see io_ring.h.
+ * If @ring_size is positive, the WAL thread keeps the last
+ * @ring_size bytes of written rows in memory for relays,
+ * see wal_get_ring().
+ * If @spare_files is positive, the WAL thread keeps that many
+ * preallocated files to switch to on rotation, see wal_spare.h.
+ * If @direct_io is set, WAL files are written with O_DIRECT
+ * and, in the fsync mode, O_DSYNC, see xlog_set_direct_io().
  */
 int
 wal_init(enum wal_mode wal_mode, const char *wal_dirname, int64_t wal_max_rows,
 	 int64_t wal_max_size, const struct tt_uuid *instance_uuid,
 	 wal_on_garbage_collection_f on_garbage_collection,
-	 wal_on_checkpoint_threshold_f on_checkpoint_threshold);
+	 wal_on_checkpoint_threshold_f on_checkpoint_threshold,
+	 bool use_io_ring, int64_t ring_size, int spare_files,
+	 bool direct_io);
 
 /**
  * Setup WAL writer as journaling subsystem.
@@ -152,6 +167,14 @@ wal_set_watcher(struct wal_watcher *watcher, const char *name,
 		void (*watcher_cb)(struct wal_watcher *, unsigned events),
 		void (*process_cb)(struct cbus_endpoint *));
 
+/**
+ * Return the ring of recently written rows or NULL if it is
+ * disabled, see wal_init(). The ring is shared by all relays
+ * and lives until exit.
+ */
+struct wal_ring *
+wal_get_ring(void);
+
 /**
  * Unsubscribe from WAL events.
  *
@@ -218,6 +241,48 @@ wal_commit_checkpoint(struct wal_checkpoint *checkpoint);
 void
 wal_set_checkpoint_threshold(int64_t threshold);
 
+/**
+ * Return the total size of data written to WAL files since
+ * the start, in bytes. Used for tracking the WAL write rate.
+ */
+int64_t
+wal_bytes_written(void);
+
+/**
+ * Set the group commit window: a batch of write requests is
+ * held in tx for up to @delay seconds before being sent to WAL.
+ * Zero disables group commit.
+ */
+void
+wal_set_batch_delay(double delay);
+
+/**
+ * Set the size of a batch of write requests, in bytes, that
+ * makes group commit send it to WAL without waiting for the
+ * window to expire.
+ */
+void
+wal_set_batch_max_size(int64_t size);
+
+/**
+ * Set the number of threads compressing WAL blocks. With more
+ * than one thread, blocks of a WAL write batch are compressed
+ * in parallel before being appended to the current WAL file.
+ */
+void
+wal_set_compress_threads(int threads);
+
+/**
+ * Dump WAL writer statistics: sizes of written batches and
+ * sync latency.
+ */
+void
+wal_stat(struct info_handler *h);
+
+/** Reset WAL writer statistics. */
+void
+wal_reset_stat(void);
+
 /**
  * Remove WAL files that are not needed by consumers reading
  * rows at @vclock or newer.
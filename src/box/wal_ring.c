@@ -0,0 +1,219 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "wal_ring.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <small/ibuf.h>
+
+#include "trivia/util.h"
+#include "diag.h"
+#include "xrow.h"
+
+/** Fixed header of a row stored in a WAL ring. */
+struct wal_ring_entry {
+	/** Size of the encoded row following the header. */
+	uint32_t len;
+	/** Replica id and LSN of the row, used on eviction. */
+	uint32_t replica_id;
+	int64_t lsn;
+};
+
+struct wal_ring *
+wal_ring_new(size_t size)
+{
+	struct wal_ring *ring = malloc(sizeof(*ring));
+	if (ring == NULL) {
+		diag_set(OutOfMemory, sizeof(*ring), "malloc",
+			 "struct wal_ring");
+		return NULL;
+	}
+	ring->buf = malloc(size);
+	if (ring->buf == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "wal ring buffer");
+		free(ring);
+		return NULL;
+	}
+	ring->size = size;
+	ring->begin = ring->end = 0;
+	vclock_create(&ring->vclock);
+	tt_pthread_mutex_init(&ring->mutex, NULL);
+	return ring;
+}
+
+void
+wal_ring_delete(struct wal_ring *ring)
+{
+	tt_pthread_mutex_destroy(&ring->mutex);
+	free(ring->buf);
+	free(ring);
+}
+
+void
+wal_ring_reset(struct wal_ring *ring, const struct vclock *vclock)
+{
+	tt_pthread_mutex_lock(&ring->mutex);
+	/*
+	 * Don't rewind the offsets, so that the cursors
+	 * positioned before the reset see their rows as
+	 * evicted.
+	 */
+	ring->begin = ring->end;
+	vclock_copy(&ring->vclock, vclock);
+	tt_pthread_mutex_unlock(&ring->mutex);
+}
+
+/** Copy data to the ring at the given absolute offset. */
+static void
+wal_ring_write(struct wal_ring *ring, uint64_t pos,
+	       const void *data, size_t size)
+{
+	size_t offset = pos % ring->size;
+	size_t n = MIN(size, ring->size - offset);
+	memcpy(ring->buf + offset, data, n);
+	memcpy(ring->buf, (const char *)data + n, size - n);
+}
+
+/** Copy data from the ring at the given absolute offset. */
+static void
+wal_ring_copy(struct wal_ring *ring, uint64_t pos, void *data, size_t size)
+{
+	size_t offset = pos % ring->size;
+	size_t n = MIN(size, ring->size - offset);
+	memcpy(data, ring->buf + offset, n);
+	memcpy((char *)data + n, ring->buf, size - n);
+}
+
+/** Evict the oldest row from the ring. */
+static void
+wal_ring_evict(struct wal_ring *ring)
+{
+	assert(ring->begin < ring->end);
+	struct wal_ring_entry entry;
+	wal_ring_copy(ring, ring->begin, &entry, sizeof(entry));
+	vclock_follow(&ring->vclock, entry.replica_id, entry.lsn);
+	ring->begin += sizeof(entry) + entry.len;
+}
+
+int
+wal_ring_append(struct wal_ring *ring, const struct xrow_header *row)
+{
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_header_encode(row, 0, iov, 0);
+	if (iovcnt < 0)
+		return -1;
+	struct wal_ring_entry entry;
+	entry.len = 0;
+	for (int i = 0; i < iovcnt; i++)
+		entry.len += iov[i].iov_len;
+	entry.replica_id = row->replica_id;
+	entry.lsn = row->lsn;
+	size_t size = sizeof(entry) + entry.len;
+
+	tt_pthread_mutex_lock(&ring->mutex);
+	if (size > ring->size) {
+		while (ring->begin < ring->end)
+			wal_ring_evict(ring);
+		vclock_follow(&ring->vclock, row->replica_id, row->lsn);
+		tt_pthread_mutex_unlock(&ring->mutex);
+		return 0;
+	}
+	while (ring->end - ring->begin + size > ring->size)
+		wal_ring_evict(ring);
+	uint64_t pos = ring->end;
+	wal_ring_write(ring, pos, &entry, sizeof(entry));
+	pos += sizeof(entry);
+	for (int i = 0; i < iovcnt; i++) {
+		wal_ring_write(ring, pos, iov[i].iov_base, iov[i].iov_len);
+		pos += iov[i].iov_len;
+	}
+	ring->end = pos;
+	tt_pthread_mutex_unlock(&ring->mutex);
+	return 0;
+}
+
+int
+wal_ring_cursor_create(struct wal_ring *ring, struct wal_ring_cursor *cursor,
+		       const struct vclock *vclock)
+{
+	int rc = -1;
+	tt_pthread_mutex_lock(&ring->mutex);
+	if (vclock_compare(&ring->vclock, vclock) <= 0) {
+		cursor->pos = ring->begin;
+		rc = 0;
+	}
+	tt_pthread_mutex_unlock(&ring->mutex);
+	return rc;
+}
+
+int
+wal_ring_read(struct wal_ring *ring, struct wal_ring_cursor *cursor,
+	      struct ibuf *buf)
+{
+	int rc = 0;
+	tt_pthread_mutex_lock(&ring->mutex);
+	if (cursor->pos < ring->begin) {
+		rc = 1;
+		goto out;
+	}
+	size_t size = ring->end - cursor->pos;
+	if (size == 0)
+		goto out;
+	void *data = ibuf_alloc(buf, size);
+	if (data == NULL) {
+		diag_set(OutOfMemory, size, "ibuf_alloc", "wal ring rows");
+		rc = -1;
+		goto out;
+	}
+	wal_ring_copy(ring, cursor->pos, data, size);
+	cursor->pos = ring->end;
+out:
+	tt_pthread_mutex_unlock(&ring->mutex);
+	return rc;
+}
+
+int
+wal_ring_decode_row(const char **pos, const char *end,
+		    struct xrow_header *row)
+{
+	struct wal_ring_entry entry;
+	assert((size_t)(end - *pos) >= sizeof(entry));
+	memcpy(&entry, *pos, sizeof(entry));
+	*pos += sizeof(entry);
+	assert((size_t)(end - *pos) >= entry.len);
+	(void) end;
+	const char *row_end = *pos + entry.len;
+	if (xrow_header_decode(row, pos, row_end) != 0)
+		return -1;
+	assert(*pos == row_end);
+	return 0;
+}
@@ -0,0 +1,151 @@
+#ifndef TARANTOOL_BOX_WAL_RING_H_INCLUDED
+#define TARANTOOL_BOX_WAL_RING_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tt_pthread.h"
+#include "vclock.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct ibuf;
+struct xrow_header;
+
+/**
+ * A ring buffer of rows recently written to WAL.
+ *
+ * The WAL thread appends rows to the ring after writing them
+ * to disk. Relays that are caught up copy new rows from the
+ * ring instead of reading them back from xlog files. When the
+ * ring is full, the oldest rows are evicted; a relay that lags
+ * behind the ring falls back to reading files.
+ *
+ * Rows are identified by their absolute offset in the stream
+ * of all rows ever appended to the ring. The ring is shared by
+ * threads, all its members are protected by the mutex.
+ */
+struct wal_ring {
+	pthread_mutex_t mutex;
+	/** Memory for rows. */
+	char *buf;
+	/** Size of the buffer. */
+	size_t size;
+	/** Absolute offset of the oldest row in the ring. */
+	uint64_t begin;
+	/** Absolute offset following the newest row in the ring. */
+	uint64_t end;
+	/**
+	 * WAL vclock before the oldest row in the ring,
+	 * i.e. the vclock of all evicted rows.
+	 */
+	struct vclock vclock;
+};
+
+/** A position of a reader in a WAL ring. */
+struct wal_ring_cursor {
+	/** Absolute offset of the next row to read. */
+	uint64_t pos;
+};
+
+/**
+ * Allocate a ring of the given size.
+ * @retval NULL memory error, diag is set.
+ */
+struct wal_ring *
+wal_ring_new(size_t size);
+
+void
+wal_ring_delete(struct wal_ring *ring);
+
+/**
+ * Drop all rows from the ring and set the WAL vclock the
+ * next appended row follows.
+ */
+void
+wal_ring_reset(struct wal_ring *ring, const struct vclock *vclock);
+
+/**
+ * Append a row written to WAL to the ring, evicting the oldest
+ * rows if there isn't enough space. A row that doesn't fit in
+ * the ring at all evicts everything, including itself.
+ *
+ * @retval 0 success.
+ * @retval -1 memory error, diag is set.
+ */
+int
+wal_ring_append(struct wal_ring *ring, const struct xrow_header *row);
+
+/**
+ * Position a cursor at the oldest row of the ring. This is only
+ * possible if all evicted rows are included in the given vclock,
+ * i.e. the reader has already got every row before the ring.
+ *
+ * @retval 0 success.
+ * @retval -1 some rows the reader hasn't got yet were evicted.
+ */
+int
+wal_ring_cursor_create(struct wal_ring *ring, struct wal_ring_cursor *cursor,
+		       const struct vclock *vclock);
+
+/**
+ * Copy all rows following the cursor position to a buffer and
+ * advance the cursor. Use wal_ring_decode_row() to read the
+ * rows from the buffer.
+ *
+ * @retval 0 success, the buffer may be empty if there's
+ *           no new rows.
+ * @retval 1 rows following the cursor were evicted.
+ * @retval -1 memory error, diag is set.
+ */
+int
+wal_ring_read(struct wal_ring *ring, struct wal_ring_cursor *cursor,
+	      struct ibuf *buf);
+
+/**
+ * Decode a row copied by wal_ring_read(). The row body
+ * points to the buffer.
+ *
+ * @retval 0 success, *pos points to the next row.
+ * @retval -1 decode error, diag is set.
+ */
+int
+wal_ring_decode_row(const char **pos, const char *end,
+		    struct xrow_header *row);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_WAL_RING_H_INCLUDED */
@@ -0,0 +1,314 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "wal_spare.h"
+
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "trivia/config.h"
+#include "trivia/util.h"
+#include "third_party/tarantool_eio.h"
+#include "tt_pthread.h"
+#include "diag.h"
+#include "say.h"
+
+enum {
+	/** Max number of files in a spare pool. */
+	WAL_SPARE_POOL_MAX = 16,
+};
+
+struct wal_spare_pool {
+	pthread_mutex_t mutex;
+	/** Directory of the files. */
+	char dirname[PATH_MAX];
+	/** Number of files to keep ready. */
+	int size;
+	/** Size to preallocate for each file. */
+	int64_t file_size;
+	/**
+	 * Prepared files. New files are created to keep @size
+	 * of them, recycled ones may top it up to twice that.
+	 */
+	struct wal_spare spares[2 * WAL_SPARE_POOL_MAX];
+	int spare_count;
+	/** Number of files being prepared by eio threads. */
+	int pending_count;
+	/** Sequence number for names of new spare files. */
+	uint64_t seq;
+	/**
+	 * Number of references: one of the WAL thread plus one
+	 * per file being prepared.
+	 */
+	int refs;
+	/** Set when the pool is deleted by the WAL thread. */
+	bool is_deleted;
+};
+
+/** A request to prepare a spare file, run by an eio thread. */
+struct wal_spare_task {
+	struct wal_spare_pool *pool;
+	/** File to recycle or an empty string to create one. */
+	char old_path[PATH_MAX];
+	/** Path of the spare file. */
+	char path[PATH_MAX];
+};
+
+static void
+wal_spare_pool_unref(struct wal_spare_pool *pool)
+{
+	tt_pthread_mutex_lock(&pool->mutex);
+	bool is_last = --pool->refs == 0;
+	tt_pthread_mutex_unlock(&pool->mutex);
+	if (is_last) {
+		tt_pthread_mutex_destroy(&pool->mutex);
+		free(pool);
+	}
+}
+
+/**
+ * Create or recycle a spare file and preallocate disk space
+ * for it. Runs in an eio thread.
+ */
+static void
+wal_spare_prepare_f(eio_req *req)
+{
+	struct wal_spare_task *task = (struct wal_spare_task *)req->data;
+	struct wal_spare_pool *pool = task->pool;
+	int fd = -1;
+	if (task->old_path[0] != '\0' &&
+	    strcmp(task->old_path, task->path) != 0 &&
+	    rename(task->old_path, task->path) != 0) {
+		say_syserror("failed to recycle %s", task->old_path);
+		if (unlink(task->old_path) != 0 && errno != ENOENT)
+			say_syserror("error while removing %s",
+				     task->old_path);
+		task->old_path[0] = '\0';
+	}
+	int flags = O_RDWR | O_CREAT;
+	if (task->old_path[0] == '\0')
+		flags |= O_EXCL;
+	fd = open(task->path, flags, 0644);
+	if (fd < 0) {
+		say_syserror("failed to create spare WAL file %s",
+			     task->path);
+		goto fail;
+	}
+	/*
+	 * A recycled file must be empty, because xlog readers
+	 * assume everything before EOF is valid data. So the
+	 * space is preallocated without changing the file size.
+	 */
+	if (ftruncate(fd, 0) != 0) {
+		say_syserror("failed to truncate %s", task->path);
+		goto fail;
+	}
+	int64_t allocated = 0;
+#ifdef HAVE_FALLOCATE
+	if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, pool->file_size) == 0)
+		allocated = pool->file_size;
+	else if (errno != ENOSYS && errno != EOPNOTSUPP)
+		say_syserror("failed to preallocate %s", task->path);
+#endif
+	if (fsync(fd) != 0) {
+		say_syserror("failed to sync %s", task->path);
+		goto fail;
+	}
+	tt_pthread_mutex_lock(&pool->mutex);
+	pool->pending_count--;
+	if (!pool->is_deleted) {
+		assert(pool->spare_count < 2 * WAL_SPARE_POOL_MAX);
+		struct wal_spare *spare = &pool->spares[pool->spare_count++];
+		spare->fd = fd;
+		spare->allocated = allocated;
+		snprintf(spare->path, sizeof(spare->path), "%s", task->path);
+		fd = -1;
+	}
+	tt_pthread_mutex_unlock(&pool->mutex);
+	if (fd >= 0) {
+		close(fd);
+		unlink(task->path);
+	}
+	goto out;
+fail:
+	if (fd >= 0)
+		close(fd);
+	unlink(task->path);
+	tt_pthread_mutex_lock(&pool->mutex);
+	pool->pending_count--;
+	tt_pthread_mutex_unlock(&pool->mutex);
+out:
+	free(task);
+	wal_spare_pool_unref(pool);
+}
+
+/**
+ * Submit a task preparing a spare file to eio, recycling
+ * @a old_path unless it is NULL. Must be called under the
+ * pool mutex. Returns false on memory allocation error.
+ */
+static bool
+wal_spare_pool_submit(struct wal_spare_pool *pool, const char *old_path)
+{
+	struct wal_spare_task *task = malloc(sizeof(*task));
+	if (task == NULL) {
+		say_warn("failed to allocate spare WAL file task");
+		return false;
+	}
+	task->pool = pool;
+	const char *ext = old_path != NULL ? strrchr(old_path, '.') : NULL;
+	if (ext != NULL && strcmp(ext, ".spare") == 0) {
+		/* A spare file left from the previous run. */
+		snprintf(task->path, sizeof(task->path), "%s", old_path);
+	} else {
+		snprintf(task->path, sizeof(task->path), "%s/%020llu.spare",
+			 pool->dirname, (unsigned long long)pool->seq++);
+	}
+	snprintf(task->old_path, sizeof(task->old_path), "%s",
+		 old_path != NULL ? old_path : "");
+	pool->pending_count++;
+	pool->refs++;
+	eio_custom(wal_spare_prepare_f, EIO_PRI_DEFAULT, NULL, task);
+	return true;
+}
+
+/**
+ * Start preparing files missing in a pool. Must be called
+ * under the pool mutex.
+ */
+static void
+wal_spare_pool_refill(struct wal_spare_pool *pool)
+{
+	while (pool->spare_count + pool->pending_count < pool->size) {
+		if (!wal_spare_pool_submit(pool, NULL))
+			break;
+	}
+}
+
+/**
+ * Adopt spare files left from the previous run and find the
+ * sequence number for new ones. Must be called under the pool
+ * mutex.
+ */
+static void
+wal_spare_pool_adopt(struct wal_spare_pool *pool)
+{
+	DIR *dh = opendir(pool->dirname);
+	if (dh == NULL)
+		return;
+	struct dirent *dent;
+	while ((dent = readdir(dh)) != NULL) {
+		char *dot;
+		unsigned long long seq = strtoull(dent->d_name, &dot, 10);
+		if (dot == dent->d_name || strcmp(dot, ".spare") != 0)
+			continue;
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/%s",
+			 pool->dirname, dent->d_name);
+		if (seq >= pool->seq)
+			pool->seq = seq + 1;
+		if (pool->spare_count + pool->pending_count < pool->size &&
+		    wal_spare_pool_submit(pool, path))
+			continue;
+		if (unlink(path) != 0)
+			say_syserror("error while removing %s", path);
+	}
+	closedir(dh);
+}
+
+struct wal_spare_pool *
+wal_spare_pool_new(const char *dirname, int size, int64_t file_size)
+{
+	assert(size > 0);
+	struct wal_spare_pool *pool = calloc(1, sizeof(*pool));
+	if (pool == NULL) {
+		diag_set(OutOfMemory, sizeof(*pool), "calloc",
+			 "struct wal_spare_pool");
+		return NULL;
+	}
+	tt_pthread_mutex_init(&pool->mutex, NULL);
+	snprintf(pool->dirname, sizeof(pool->dirname), "%s", dirname);
+	pool->size = MIN(size, (int)WAL_SPARE_POOL_MAX);
+	pool->file_size = file_size;
+	pool->refs = 1;
+	tt_pthread_mutex_lock(&pool->mutex);
+	wal_spare_pool_adopt(pool);
+	wal_spare_pool_refill(pool);
+	tt_pthread_mutex_unlock(&pool->mutex);
+	return pool;
+}
+
+void
+wal_spare_pool_delete(struct wal_spare_pool *pool)
+{
+	tt_pthread_mutex_lock(&pool->mutex);
+	pool->is_deleted = true;
+	for (int i = 0; i < pool->spare_count; i++) {
+		struct wal_spare *spare = &pool->spares[i];
+		close(spare->fd);
+		unlink(spare->path);
+	}
+	pool->spare_count = 0;
+	tt_pthread_mutex_unlock(&pool->mutex);
+	wal_spare_pool_unref(pool);
+}
+
+bool
+wal_spare_pool_take(struct wal_spare_pool *pool, struct wal_spare *spare)
+{
+	tt_pthread_mutex_lock(&pool->mutex);
+	bool found = pool->spare_count > 0;
+	if (found) {
+		*spare = pool->spares[0];
+		memmove(&pool->spares[0], &pool->spares[1],
+			--pool->spare_count * sizeof(*spare));
+	}
+	/* Files that failed to be prepared are retried, too. */
+	wal_spare_pool_refill(pool);
+	tt_pthread_mutex_unlock(&pool->mutex);
+	return found;
+}
+
+bool
+wal_spare_pool_recycle(struct wal_spare_pool *pool, const char *path)
+{
+	tt_pthread_mutex_lock(&pool->mutex);
+	bool recycle = (pool->spare_count + pool->pending_count <
+			2 * pool->size) &&
+		       wal_spare_pool_submit(pool, path);
+	tt_pthread_mutex_unlock(&pool->mutex);
+	return recycle;
+}
@@ -0,0 +1,107 @@
+#ifndef TARANTOOL_BOX_WAL_SPARE_H_INCLUDED
+#define TARANTOOL_BOX_WAL_SPARE_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * A pool of spare WAL files.
+ *
+ * Creating a WAL file on rotation takes a file creation
+ * and extent allocation as the file grows, both of which are
+ * file system metadata operations done right on the commit
+ * path. With a spare pool, files are created and preallocated
+ * in the background by eio threads, so rotation only takes a
+ * prepared file, writes the meta to it and renames it, see
+ * xdir_create_xlog_from_spare().
+ *
+ * Old WAL files are recycled instead of being deleted while
+ * the pool has fewer than twice its size files.
+ *
+ * Spare files are named <seq>.spare and are adopted by the
+ * pool on the next start.
+ *
+ * The pool is used by the WAL thread and by eio threads, all
+ * its members are protected by a mutex.
+ */
+struct wal_spare_pool;
+
+/** A spare file taken from the pool. */
+struct wal_spare {
+	/** Descriptor of the file open for writing. */
+	int fd;
+	/** Path to the file. */
+	char path[PATH_MAX];
+	/** Size of disk space preallocated for the file. */
+	int64_t allocated;
+};
+
+/**
+ * Create a pool keeping @a size files in @a dirname, each
+ * preallocated to @a file_size bytes, and start preparing
+ * them. Returns NULL on memory allocation error.
+ */
+struct wal_spare_pool *
+wal_spare_pool_new(const char *dirname, int size, int64_t file_size);
+
+/**
+ * Delete a pool. Prepared files are removed. Files being
+ * prepared are removed when eio threads are done with them.
+ */
+void
+wal_spare_pool_delete(struct wal_spare_pool *pool);
+
+/**
+ * Take a prepared file from a pool and start preparing
+ * another one in its stead. Returns false if the pool is
+ * empty.
+ */
+bool
+wal_spare_pool_take(struct wal_spare_pool *pool, struct wal_spare *spare);
+
+/**
+ * Offer a pool an old WAL file instead of deleting it.
+ * Returns true if the pool takes over the file, in which
+ * case the file is going to be renamed and truncated in
+ * the background.
+ */
+bool
+wal_spare_pool_recycle(struct wal_spare_pool *pool, const char *path);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_WAL_SPARE_H_INCLUDED */
@@ -41,11 +41,16 @@
 #include <msgpuck.h>
 
 #include "coio_file.h"
+#include "io_ring.h"
+#include "gc_remove.h"
+#include "pmatomic.h"
+#include "probe.h"
 
 #include "error.h"
 #include "xrow.h"
 #include "iproto_constants.h"
 #include "errinj.h"
+#include "trivia/config.h"
 
 /*
  * FALLOC_FL_KEEP_SIZE flag has existed since fallocate() was
@@ -87,6 +92,10 @@ enum {
 	 * Maybe this should be a configuration option.
 	 */
 	XLOG_TX_COMPRESS_THRESHOLD = 2 * 1024,
+	/** Distance between positions in the seek index. */
+	XLOG_SEEK_INDEX_STEP = 1024 * 1024,
+	/** Max number of files in the seek index. */
+	XLOG_SEEK_INDEX_FILES_MAX = 32,
 };
 
 /* {{{ struct xlog_meta */
@@ -390,22 +399,13 @@ xdir_destroy(struct xdir *dir)
 }
 
 /**
- * Add a single log file to the index of all log files
- * in a given log directory.
+ * Append the clock describing a log file to the directory
+ * index.
  */
-static inline int
-xdir_index_file(struct xdir *dir, int64_t signature)
+static int
+xdir_index_vclock(struct xdir *dir, const struct vclock *file_vclock,
+		  const char *filename)
 {
-	/*
-	 * Open xlog and parse vclock in its text header.
-	 * The vclock stores the state of the log at the
-	 * time it is created.
-	 */
-	struct xlog_cursor cursor;
-	if (xdir_open_cursor(dir, signature, &cursor) < 0)
-		return -1;
-	struct xlog_meta *meta = &cursor.meta;
-
 	/*
 	 * All log files in a directory must satisfy Lamport's
 	 * eventual order: events in each log file must be
@@ -414,30 +414,47 @@ xdir_index_file(struct xdir *dir, int64_t signature)
 	 * log1: {1, 1, 0, 1}, log2: {1, 2, 0, 2} -- good
 	 * log2: {1, 1, 0, 1}, log2: {2, 0, 2, 0} -- bad
 	 */
-	struct vclock *dup = vclockset_search(&dir->index, &meta->vclock);
+	struct vclock *dup = vclockset_search(&dir->index, file_vclock);
 	if (dup != NULL) {
-		diag_set(XlogError, "%s: invalid xlog order", cursor.name);
-		xlog_cursor_close(&cursor, false);
+		diag_set(XlogError, "%s: invalid xlog order", filename);
 		return -1;
 	}
-
-	/*
-	 * Append the clock describing the file to the
-	 * directory index.
-	 */
 	struct vclock *vclock = (struct vclock *) malloc(sizeof(*vclock));
 	if (vclock == NULL) {
 		diag_set(OutOfMemory, sizeof(*vclock), "malloc", "vclock");
-		xlog_cursor_close(&cursor, false);
 		return -1;
 	}
-
-	vclock_copy(vclock, &meta->vclock);
-	xlog_cursor_close(&cursor, false);
+	vclock_copy(vclock, file_vclock);
 	vclockset_insert(&dir->index, vclock);
 	return 0;
 }
 
+/**
+ * Add a single log file to the index of all log files
+ * in a given log directory. The vclock of the file is
+ * returned in @a file_vclock unless it is NULL.
+ */
+static inline int
+xdir_index_file(struct xdir *dir, int64_t signature,
+		struct vclock *file_vclock)
+{
+	/*
+	 * Open xlog and parse vclock in its text header.
+	 * The vclock stores the state of the log at the
+	 * time it is created.
+	 */
+	struct xlog_cursor cursor;
+	if (xdir_open_cursor(dir, signature, &cursor) < 0)
+		return -1;
+	struct xlog_meta *meta = &cursor.meta;
+
+	int rc = xdir_index_vclock(dir, &meta->vclock, cursor.name);
+	if (rc == 0 && file_vclock != NULL)
+		vclock_copy(file_vclock, &meta->vclock);
+	xlog_cursor_close(&cursor, false);
+	return rc;
+}
+
 int
 xdir_open_cursor(struct xdir *dir, int64_t signature,
 		 struct xlog_cursor *cursor)
@@ -488,6 +505,248 @@ cmp_i64(const void *_a, const void *_b)
 	return (*a > *b) ? 1 : -1;
 }
 
+/* {{{ Index file */
+
+/**
+ * The first scan of a directory reads the header of every
+ * file in it, which takes long when thousands of files are
+ * retained. So the result of the scan is saved to a text
+ * file in the directory, named after the file type, e.g.
+ * xlog.index:
+ *
+ *   XDIR INDEX
+ *   <instance uuid>
+ *   <signature> <size> <mtime> <inode> <vclock>
+ *   ...
+ *
+ * The next first scan takes the vclock of a file from the
+ * index file if the size, mtime and inode of the file are
+ * the same, and opens only the files that are new or have
+ * changed since then.
+ */
+static const char xdir_index_magic[] = "XDIR INDEX";
+
+/** A log file as seen by the scan that saved the index file. */
+struct xdir_index_entry {
+	int64_t signature;
+	uint64_t size;
+	int64_t mtime;
+	uint64_t ino;
+	struct vclock vclock;
+};
+
+/** Contents of an index file and the index file to save. */
+struct xdir_index_cache {
+	/** Entries loaded from the index file, by signature. */
+	struct xdir_index_entry *loaded;
+	size_t loaded_count;
+	/** Entries of the files found by the scan. */
+	struct xdir_index_entry *found;
+	size_t found_count;
+	size_t found_capacity;
+	/** Set if the index file must be rewritten. */
+	bool is_dirty;
+};
+
+static void
+xdir_index_cache_create(struct xdir_index_cache *cache)
+{
+	memset(cache, 0, sizeof(*cache));
+}
+
+static void
+xdir_index_cache_destroy(struct xdir_index_cache *cache)
+{
+	free(cache->loaded);
+	free(cache->found);
+}
+
+static void
+xdir_index_filename(struct xdir *dir, char *buf, size_t size)
+{
+	/* Skip the dot of the file name extension. */
+	snprintf(buf, size, "%s/%s.index", dir->dirname,
+		 dir->filename_ext + 1);
+}
+
+/**
+ * Parse a line of an index file.
+ * Return 0 on success, -1 if the line is malformed.
+ */
+static int
+xdir_index_entry_parse(struct xdir_index_entry *entry, char *line)
+{
+	int n;
+	if (sscanf(line, "%" SCNd64 " %" SCNu64 " %" SCNd64 " %" SCNu64 " %n",
+		   &entry->signature, &entry->size, &entry->mtime,
+		   &entry->ino, &n) != 4)
+		return -1;
+	char *str = line + n;
+	str[strcspn(str, "\n")] = '\0';
+	if (vclock_from_string(&entry->vclock, str) != 0 ||
+	    vclock_sum(&entry->vclock) != entry->signature)
+		return -1;
+	return 0;
+}
+
+/**
+ * Load the index file of a directory. The file is a mere
+ * cache, so if it is missing or can't be read for whatever
+ * reason, the directory is scanned as if there were none.
+ */
+static void
+xdir_index_cache_load(struct xdir *dir, struct xdir_index_cache *cache)
+{
+	if (tt_uuid_is_nil(dir->instance_uuid))
+		return;
+	char filename[PATH_MAX];
+	xdir_index_filename(dir, filename, sizeof(filename));
+	FILE *f = fopen(filename, "r");
+	if (f == NULL)
+		return;
+	char line[2 * VCLOCK_STR_LEN_MAX];
+	if (fgets(line, sizeof(line), f) == NULL ||
+	    strncmp(line, xdir_index_magic, strlen(xdir_index_magic)) != 0)
+		goto invalid;
+	/* The index of another instance is of no use. */
+	struct tt_uuid uuid;
+	if (fgets(line, sizeof(line), f) == NULL)
+		goto invalid;
+	line[strcspn(line, "\n")] = '\0';
+	if (tt_uuid_from_string(line, &uuid) != 0 ||
+	    !tt_uuid_is_equal(&uuid, dir->instance_uuid))
+		goto invalid;
+	size_t capacity = 0;
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (cache->loaded_count == capacity) {
+			capacity = capacity > 0 ? 2 * capacity : 16;
+			struct xdir_index_entry *loaded = realloc(cache->loaded,
+					capacity * sizeof(*loaded));
+			if (loaded == NULL)
+				goto invalid;
+			cache->loaded = loaded;
+		}
+		struct xdir_index_entry *entry =
+			&cache->loaded[cache->loaded_count];
+		if (xdir_index_entry_parse(entry, line) != 0 ||
+		    (cache->loaded_count > 0 &&
+		     entry[-1].signature >= entry->signature))
+			goto invalid;
+		cache->loaded_count++;
+	}
+	fclose(f);
+	return;
+invalid:
+	say_warn("ignoring invalid index file `%s'", filename);
+	fclose(f);
+	free(cache->loaded);
+	cache->loaded = NULL;
+	cache->loaded_count = 0;
+}
+
+static int
+xdir_index_entry_cmp(const void *key, const void *elem)
+{
+	int64_t signature = *(const int64_t *)key;
+	const struct xdir_index_entry *entry = elem;
+	if (signature == entry->signature)
+		return 0;
+	return signature > entry->signature ? 1 : -1;
+}
+
+/**
+ * Same as xdir_index_file(), but take the vclock from the
+ * index file if the log file hasn't changed since it was
+ * saved, and remember the file for the next index file.
+ */
+static int
+xdir_index_file_cached(struct xdir *dir, int64_t signature,
+		       struct xdir_index_cache *cache)
+{
+	const char *filename = xdir_format_filename(dir, signature, NONE);
+	struct stat st;
+	if (stat(filename, &st) != 0)
+		return xdir_index_file(dir, signature, NULL);
+	if (cache->found_count == cache->found_capacity) {
+		size_t capacity = cache->found_capacity > 0 ?
+				  2 * cache->found_capacity : 16;
+		struct xdir_index_entry *found = realloc(cache->found,
+				capacity * sizeof(*found));
+		if (found == NULL) {
+			diag_set(OutOfMemory, capacity * sizeof(*found),
+				 "realloc", "xdir index entries");
+			return -1;
+		}
+		cache->found = found;
+		cache->found_capacity = capacity;
+	}
+	struct xdir_index_entry *entry = &cache->found[cache->found_count];
+	struct xdir_index_entry *cached = bsearch(&signature, cache->loaded,
+						  cache->loaded_count,
+						  sizeof(*cache->loaded),
+						  xdir_index_entry_cmp);
+	if (cached != NULL && cached->size == (uint64_t)st.st_size &&
+	    cached->mtime == (int64_t)st.st_mtime &&
+	    cached->ino == (uint64_t)st.st_ino) {
+		if (xdir_index_vclock(dir, &cached->vclock, filename) != 0)
+			return -1;
+		*entry = *cached;
+	} else {
+		if (xdir_index_file(dir, signature, &entry->vclock) != 0)
+			return -1;
+		entry->signature = signature;
+		entry->size = st.st_size;
+		entry->mtime = st.st_mtime;
+		entry->ino = st.st_ino;
+		cache->is_dirty = true;
+	}
+	cache->found_count++;
+	return 0;
+}
+
+/**
+ * Save the files found by the scan to the index file. The
+ * file is written under a temporary name and then renamed
+ * so that a crash never leaves a partially written index.
+ * Errors are only logged.
+ */
+static void
+xdir_index_cache_save(struct xdir *dir, struct xdir_index_cache *cache)
+{
+	char filename[PATH_MAX];
+	char tmp_filename[PATH_MAX];
+	xdir_index_filename(dir, filename, sizeof(filename));
+	snprintf(tmp_filename, sizeof(tmp_filename), "%s%s",
+		 filename, inprogress_suffix);
+	FILE *f = fopen(tmp_filename, "w");
+	if (f == NULL)
+		goto error;
+	fprintf(f, "%s\n%s\n", xdir_index_magic,
+		tt_uuid_str(dir->instance_uuid));
+	for (size_t i = 0; i < cache->found_count; i++) {
+		struct xdir_index_entry *entry = &cache->found[i];
+		char *vstr = vclock_to_string(&entry->vclock);
+		if (vstr == NULL) {
+			fclose(f);
+			goto error;
+		}
+		fprintf(f, "%" PRId64 " %" PRIu64 " %" PRId64 " %" PRIu64
+			" %s\n", entry->signature, entry->size, entry->mtime,
+			entry->ino, vstr);
+		free(vstr);
+	}
+	if (ferror(f) != 0 || fclose(f) != 0)
+		goto error;
+	if (rename(tmp_filename, filename) != 0)
+		goto error;
+	return;
+error:
+	say_syserror("failed to save index file `%s'", filename);
+	unlink(tmp_filename);
+}
+
+/* }}} */
+
 /**
  * Scan (or rescan) a directory with snapshot or write ahead logs.
  * Read all files matching a pattern from the directory -
@@ -520,6 +779,9 @@ cmp_i64(const void *_a, const void *_b)
  * silence conditions such as out of memory or lack of OS
  * resources.
  *
+ * The first scan of a directory uses the index file, see
+ * xdir_index_cache_load(), and saves it if anything changed.
+ *
  * @return nothing.
  */
 int
@@ -528,12 +790,23 @@ xdir_scan(struct xdir *dir)
 	DIR *dh = opendir(dir->dirname);        /* log dir */
 	int64_t *signatures = NULL;             /* log file names */
 	size_t s_count = 0, s_capacity = 0;
+	/*
+	 * Later scans only open files that appeared since the
+	 * previous one anyway. Relay threads scan the WAL
+	 * directory too, so only tx maintains the index file.
+	 */
+	bool use_cache = vclockset_first(&dir->index) == NULL &&
+			 cord_is_main() && !tt_uuid_is_nil(dir->instance_uuid);
+	struct xdir_index_cache cache;
+	xdir_index_cache_create(&cache);
 
 	if (dh == NULL) {
 		diag_set(SystemError, "error reading directory '%s'",
 			  dir->dirname);
 		return -1;
 	}
+	if (use_cache)
+		xdir_index_cache_load(dir, &cache);
 
 	int rc = -1;
 	struct vclock *vclock;
@@ -610,7 +883,9 @@ xdir_scan(struct xdir *dir)
 			vclock = next;
 		} else if (s_old > s_new) {
 			/** Add a new file. */
-			if (xdir_index_file(dir, s_new) != 0) {
+			if ((use_cache ?
+			     xdir_index_file_cached(dir, s_new, &cache) :
+			     xdir_index_file(dir, s_new, NULL)) != 0) {
 				/*
 				 * force_recovery must not affect OOM
 				 */
@@ -620,6 +895,7 @@ xdir_scan(struct xdir *dir)
 					goto exit;
 				/** Skip a corrupted file */
 				error_log(e);
+				cache.is_dirty = true;
 			}
 			i++;
 		} else {
@@ -630,8 +906,12 @@ xdir_scan(struct xdir *dir)
 		}
 	}
 	rc = 0;
+	if (use_cache && (cache.is_dirty ||
+			  cache.found_count != cache.loaded_count))
+		xdir_index_cache_save(dir, &cache);
 
 exit:
+	xdir_index_cache_destroy(&cache);
 	closedir(dh);
 	free(signatures);
 	return rc;
@@ -689,9 +969,10 @@ xdir_collect_garbage(struct xdir *dir, int64_t signature, unsigned flags)
 	       vclock_sum(vclock) < signature) {
 		char *filename = xdir_format_filename(dir, vclock_sum(vclock),
 						      NONE);
-		if (flags & XDIR_GC_ASYNC)
-			eio_unlink(filename, 0, xdir_complete_gc, NULL);
-		else
+		if (flags & XDIR_GC_ASYNC) {
+			if (!gc_remove_file(filename))
+				eio_unlink(filename, 0, xdir_complete_gc, NULL);
+		} else
 			xdir_say_gc(unlink(filename), errno, filename);
 		vclockset_remove(&dir->index, vclock);
 		free(vclock);
@@ -777,6 +1058,7 @@ xlog_init(struct xlog *xlog)
 	xlog->is_autocommit = true;
 	obuf_create(&xlog->obuf, &cord()->slabc, XLOG_TX_AUTOCOMMIT_THRESHOLD);
 	obuf_create(&xlog->zbuf, &cord()->slabc, XLOG_TX_AUTOCOMMIT_THRESHOLD);
+	tt_pthread_mutex_init(&xlog->write_mutex, NULL);
 	xlog->zctx = ZSTD_createCCtx();
 	if (xlog->zctx == NULL) {
 		diag_set(ClientError, ER_COMPRESSION,
@@ -793,14 +1075,20 @@ xlog_clear(struct xlog *l)
 	l->fd = -1;
 }
 
+static void
+xlog_free_blocks(struct xlog *xlog);
+
 static void
 xlog_destroy(struct xlog *xlog)
 {
 	assert(xlog->obuf.slabc == &cord()->slabc);
 	assert(xlog->zbuf.slabc == &cord()->slabc);
+	xlog_free_blocks(xlog);
+	free(xlog->direct_buf);
 	obuf_destroy(&xlog->obuf);
 	obuf_destroy(&xlog->zbuf);
 	ZSTD_freeCCtx(xlog->zctx);
+	tt_pthread_mutex_destroy(&xlog->write_mutex);
 	TRASH(xlog);
 	xlog->fd = -1;
 }
@@ -874,6 +1162,41 @@ err:
 	return -1;
 }
 
+int
+xlog_create_shared(struct xlog *xlog, struct xlog *owner)
+{
+	assert(owner->owner == NULL);
+	if (xlog_init(xlog) != 0) {
+		xlog_destroy(xlog);
+		return -1;
+	}
+	xlog->owner = owner;
+	xlog->meta = owner->meta;
+	xlog->fd = owner->fd;
+	xlog->is_inprogress = owner->is_inprogress;
+	strcpy(xlog->filename, owner->filename);
+	xlog->sync_is_async = owner->sync_is_async;
+	xlog->sync_interval = owner->sync_interval;
+	xlog->rate_limit = owner->rate_limit;
+	return 0;
+}
+
+int
+xlog_close_shared(struct xlog *xlog)
+{
+	assert(xlog->owner != NULL);
+	int rc = xlog_flush(xlog) < 0 ? -1 : 0;
+	struct xlog *owner = xlog->owner;
+	tt_pthread_mutex_lock(&owner->write_mutex);
+	owner->rows += xlog->rows;
+	tt_pthread_mutex_unlock(&owner->write_mutex);
+	xlog_destroy(xlog);
+	return rc;
+}
+
+static off_t
+xlog_find_padding(int fd, off_t offset, off_t size);
+
 int
 xlog_open(struct xlog *xlog, const char *name)
 {
@@ -928,6 +1251,21 @@ no_eof:
 				 xlog->filename);
 			goto err_read;
 		}
+		/*
+		 * Cut off zero padding left after the last tx
+		 * by an O_DIRECT writer, otherwise it would hide
+		 * the txs appended after it from readers.
+		 */
+		off_t data_end = xlog_find_padding(xlog->fd,
+					meta - meta_buf, xlog->offset);
+		if (data_end < xlog->offset &&
+		    (ftruncate(xlog->fd, data_end) != 0 ||
+		     fio_lseek(xlog->fd, data_end, SEEK_SET) < 0)) {
+			diag_set(SystemError, "failed to truncate file '%s'",
+				 xlog->filename);
+			goto err_read;
+		}
+		xlog->offset = data_end;
 	} else {
 		/* Truncate the file to erase the EOF marker. */
 		if (ftruncate(xlog->fd, xlog->offset) != 0) {
@@ -969,14 +1307,24 @@ xdir_touch_xlog(struct xdir *dir, const struct vclock *vclock)
  * In case of error, writes a message to the error log
  * and sets errno.
  */
+/** Inherit xdir settings by a new xlog. */
+static void
+xdir_inherit_xlog_settings(struct xdir *dir, struct xlog *xlog)
+{
+	xlog->sync_is_async = dir->sync_is_async;
+	xlog->sync_interval = dir->sync_interval;
+	xlog->compress_threads = dir->compress_threads;
+	xlog->datasync_on_write = dir->datasync_on_write;
+
+	/* free file cache if dir should be synced */
+	xlog->free_cache = dir->sync_interval != 0 ? true: false;
+	xlog->rate_limit = 0;
+}
+
 int
 xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 		 const struct vclock *vclock)
 {
-	int64_t signature = vclock_sum(vclock);
-	assert(signature >= 0);
-	assert(!tt_uuid_is_nil(dir->instance_uuid));
-
 	/*
 	 * For WAL dir: store vclock of the previous xlog file
 	 * to check for gaps on recovery.
@@ -984,6 +1332,17 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 	const struct vclock *prev_vclock = NULL;
 	if (dir->type == XLOG && !vclockset_empty(&dir->index))
 		prev_vclock = vclockset_last(&dir->index);
+	return xdir_create_xlog_with_prev(dir, xlog, vclock, prev_vclock);
+}
+
+int
+xdir_create_xlog_with_prev(struct xdir *dir, struct xlog *xlog,
+			   const struct vclock *vclock,
+			   const struct vclock *prev_vclock)
+{
+	int64_t signature = vclock_sum(vclock);
+	assert(signature >= 0);
+	assert(!tt_uuid_is_nil(dir->instance_uuid));
 
 	struct xlog_meta meta;
 	xlog_meta_create(&meta, dir->filetype, dir->instance_uuid,
@@ -993,13 +1352,15 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 	if (xlog_create(xlog, filename, dir->open_wflags, &meta) != 0)
 		return -1;
 
-	/* Inherit xdir settings. */
-	xlog->sync_is_async = dir->sync_is_async;
-	xlog->sync_interval = dir->sync_interval;
+	xdir_inherit_xlog_settings(dir, xlog);
 
-	/* free file cache if dir should be synced */
-	xlog->free_cache = dir->sync_interval != 0 ? true: false;
-	xlog->rate_limit = 0;
+	if (dir->direct_io && xlog_set_direct_io(xlog) != 0) {
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s", xlog->filename);
+		xlog_close(xlog, false);
+		unlink(path);
+		return -1;
+	}
 
 	/* Rename xlog file */
 	if (dir->suffix != INPROGRESS && xlog_rename(xlog)) {
@@ -1012,6 +1373,73 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 	return 0;
 }
 
+int
+xdir_create_xlog_from_spare(struct xdir *dir, struct xlog *xlog,
+			    const struct vclock *vclock, int fd,
+			    const char *spare_path, int64_t allocated)
+{
+	assert(dir->type == XLOG);
+	assert(!tt_uuid_is_nil(dir->instance_uuid));
+	const struct vclock *prev_vclock = NULL;
+	if (!vclockset_empty(&dir->index))
+		prev_vclock = vclockset_last(&dir->index);
+
+	char meta_buf[XLOG_META_LEN_MAX];
+	int meta_len;
+	char *filename = xdir_format_filename(dir, vclock_sum(vclock), NONE);
+	if (access(filename, F_OK) == 0) {
+		errno = EEXIST;
+		diag_set(SystemError, "file '%s' already exists", filename);
+		goto err;
+	}
+	if (xlog_init(xlog) != 0)
+		goto err_init;
+	xlog_meta_create(&xlog->meta, dir->filetype, dir->instance_uuid,
+			 vclock, prev_vclock);
+	snprintf(xlog->filename, PATH_MAX, "%s", filename);
+	xlog->is_inprogress = false;
+	xlog->fd = fd;
+
+	meta_len = xlog_meta_format(&xlog->meta, meta_buf, sizeof(meta_buf));
+	if (meta_len < 0)
+		goto err_init;
+	assert(meta_len < (int)sizeof(meta_buf));
+	/*
+	 * Write the meta before renaming the file so that
+	 * relays never see a file without one.
+	 */
+	if (fio_writen(fd, meta_buf, meta_len) < 0) {
+		diag_set(SystemError, "%s: failed to write xlog meta",
+			 spare_path);
+		goto err_init;
+	}
+	if (rename(spare_path, filename) != 0) {
+		diag_set(SystemError, "failed to rename '%s' file",
+			 spare_path);
+		goto err_init;
+	}
+	xlog->offset = meta_len;
+	xlog->allocated = allocated > meta_len ? allocated - meta_len : 0;
+	xdir_inherit_xlog_settings(dir, xlog);
+	/*
+	 * O_SYNC can't be set on an open file, sync each
+	 * write explicitly instead.
+	 */
+	if ((dir->open_wflags & (O_SYNC | O_DSYNC)) != 0)
+		xlog->datasync_on_write = true;
+	if (dir->direct_io && xlog_set_direct_io(xlog) != 0) {
+		xlog_close(xlog, false);
+		return -1;
+	}
+	return 0;
+err_init:
+	xlog_destroy(xlog);
+err:
+	close(fd);
+	unlink(spare_path);
+	return -1;
+}
+
 ssize_t
 xlog_fallocate(struct xlog *log, size_t len)
 {
@@ -1047,6 +1475,159 @@ xlog_fallocate(struct xlog *log, size_t len)
 #endif /* HAVE_FALLOCATE */
 }
 
+/**
+ * Write a block of xrow objects to the file. If the file is
+ * shared with other writers, append the block under the owner
+ * lock and advance the owner's write offset. If the current
+ * cord has an io_uring instance, submit the write to it.
+ */
+enum {
+	/** Alignment of O_DIRECT writes, see xlog_set_direct_io(). */
+	XLOG_DIRECT_IO_ALIGN = 4096,
+};
+
+/**
+ * Make sure the O_DIRECT buffer of an xlog has room for
+ * @a size bytes, preserving its content.
+ */
+static int
+xlog_direct_buf_reserve(struct xlog *log, size_t size)
+{
+	if (size <= log->direct_buf_size)
+		return 0;
+	size_t new_size = MAX(log->direct_buf_size, XLOG_DIRECT_IO_ALIGN);
+	while (new_size < size)
+		new_size *= 2;
+	void *buf;
+	if (posix_memalign(&buf, XLOG_DIRECT_IO_ALIGN, new_size) != 0) {
+		diag_set(OutOfMemory, new_size, "posix_memalign",
+			 "xlog direct buffer");
+		return -1;
+	}
+	if (log->direct_buf != NULL) {
+		memcpy(buf, log->direct_buf, log->offset % XLOG_DIRECT_IO_ALIGN);
+		free(log->direct_buf);
+	}
+	log->direct_buf = buf;
+	log->direct_buf_size = new_size;
+	return 0;
+}
+
+int
+xlog_set_direct_io(struct xlog *log)
+{
+	assert(log->owner == NULL);
+#ifdef O_DIRECT
+	if (xlog_direct_buf_reserve(log, XLOG_DIRECT_IO_ALIGN) != 0)
+		return -1;
+	/*
+	 * Load the partially filled last block before O_DIRECT
+	 * is set, since O_DIRECT reads must be aligned, too.
+	 */
+	size_t tail = log->offset % XLOG_DIRECT_IO_ALIGN;
+	if (tail > 0 && fio_pread(log->fd, log->direct_buf, tail,
+				  log->offset - tail) != (ssize_t)tail) {
+		diag_set(SystemError, "failed to read file '%s'",
+			 log->filename);
+		return -1;
+	}
+	int flags = fcntl(log->fd, F_GETFL);
+	if (flags < 0 || fcntl(log->fd, F_SETFL, flags | O_DIRECT) != 0) {
+		diag_set(SystemError, "failed to set O_DIRECT on '%s'",
+			 log->filename);
+		return -1;
+	}
+	log->is_direct_io = true;
+	return 0;
+#else
+	diag_set(ClientError, ER_UNSUPPORTED, "this platform", "O_DIRECT");
+	return -1;
+#endif /* O_DIRECT */
+}
+
+/** fdatasync() wrapped in tracepoints. */
+static int
+xlog_fdatasync(int fd)
+{
+	PROBE1(xlog_fsync_start, fd);
+	int rc = fdatasync(fd);
+	PROBE2(xlog_fsync_done, fd, rc);
+	return rc;
+}
+
+/**
+ * Write data to a file open with O_DIRECT. The data is
+ * appended to the last partially filled block and padded
+ * with zeros to the block size. Returns the number of
+ * bytes of data written.
+ */
+static ssize_t
+xlog_writev_direct(struct xlog *log, struct iovec *iov, int iovcnt)
+{
+	size_t tail = log->offset % XLOG_DIRECT_IO_ALIGN;
+	size_t len = 0;
+	for (int i = 0; i < iovcnt; i++)
+		len += iov[i].iov_len;
+	size_t size = tail + len;
+	size_t padded_size = (size + XLOG_DIRECT_IO_ALIGN - 1) &
+			     ~((size_t)XLOG_DIRECT_IO_ALIGN - 1);
+	if (xlog_direct_buf_reserve(log, padded_size) != 0)
+		return -1;
+	char *pos = log->direct_buf + tail;
+	for (int i = 0; i < iovcnt; i++) {
+		memcpy(pos, iov[i].iov_base, iov[i].iov_len);
+		pos += iov[i].iov_len;
+	}
+	memset(pos, 0, padded_size - size);
+	off_t offset = log->offset - tail;
+	size_t done = 0;
+	while (done < padded_size) {
+		ssize_t rc = pwrite(log->fd, log->direct_buf + done,
+				    padded_size - done, offset + done);
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			diag_set(SystemError, "failed to write to '%s'",
+				 log->filename);
+			return -1;
+		}
+		done += rc;
+	}
+	if (log->datasync_on_write && xlog_fdatasync(log->fd) != 0) {
+		diag_set(SystemError, "failed to sync '%s'", log->filename);
+		return -1;
+	}
+	/* Keep the new partially filled block for the next write. */
+	size_t new_tail = size % XLOG_DIRECT_IO_ALIGN;
+	memmove(log->direct_buf, log->direct_buf + size - new_tail,
+		new_tail);
+	return len;
+}
+
+static ssize_t
+xlog_writev(struct xlog *log, struct iovec *iov, int iovcnt)
+{
+	struct xlog *owner = log->owner;
+	if (log->is_direct_io)
+		return xlog_writev_direct(log, iov, iovcnt);
+	if (owner == NULL) {
+		if (io_ring_is_enabled())
+			return io_ring_writev(log->fd, iov, iovcnt,
+					      log->datasync_on_write);
+		ssize_t written = fio_writevn(log->fd, iov, iovcnt);
+		if (written >= 0 && log->datasync_on_write &&
+		    xlog_fdatasync(log->fd) != 0)
+			return -1;
+		return written;
+	}
+	tt_pthread_mutex_lock(&owner->write_mutex);
+	ssize_t written = fio_writevn(owner->fd, iov, iovcnt);
+	if (written >= 0)
+		owner->offset += written;
+	tt_pthread_mutex_unlock(&owner->write_mutex);
+	return written;
+}
+
 /**
  * Write a sequence of uncompressed xrow objects.
  *
@@ -1054,25 +1635,24 @@ xlog_fallocate(struct xlog *log, size_t len)
  * @retval >= 0 the number of bytes written
  */
 static off_t
-xlog_tx_write_plain(struct xlog *log)
+xlog_tx_write_plain(struct xlog *log, struct obuf *obuf)
 {
 	/**
 	 * We created an obuf savepoint at start of xlog_tx,
 	 * now populate it with data.
 	 */
-	char *fixheader = (char *)log->obuf.iov[0].iov_base;
+	char *fixheader = (char *)obuf->iov[0].iov_base;
 	*(log_magic_t *)fixheader = row_marker;
 	char *data = fixheader + sizeof(log_magic_t);
 
-	data = mp_encode_uint(data,
-			      obuf_size(&log->obuf) - XLOG_FIXHEADER_SIZE);
+	data = mp_encode_uint(data, obuf_size(obuf) - XLOG_FIXHEADER_SIZE);
 	/* Encode crc32 for previous row */
 	data = mp_encode_uint(data, 0);
 	/* Encode crc32 for current row */
 	uint32_t crc32c = 0;
 	struct iovec *iov;
 	size_t offset = XLOG_FIXHEADER_SIZE;
-	for (iov = log->obuf.iov; iov->iov_len; ++iov) {
+	for (iov = obuf->iov; iov->iov_len; ++iov) {
 		crc32c = crc32_calc(crc32c,
 				    (char *)iov->iov_base + offset,
 				    iov->iov_len - offset);
@@ -1097,13 +1677,13 @@ xlog_tx_write_plain(struct xlog *log)
 		return -1;
 	});
 
-	ssize_t written = fio_writevn(log->fd, log->obuf.iov, log->obuf.pos + 1);
+	ssize_t written = xlog_writev(log, obuf->iov, obuf->pos + 1);
 	if (written < 0) {
 		diag_set(SystemError, "failed to write to '%s' file",
 			 log->filename);
 		return -1;
 	}
-	return obuf_size(&log->obuf);
+	return obuf_size(obuf);
 }
 
 /**
@@ -1120,7 +1700,10 @@ xlog_tx_write_zstd(struct xlog *log)
 	uint32_t crc32c = 0;
 	struct iovec *iov;
 	/* 3 is compression level. */
-	ZSTD_compressBegin(log->zctx, 3);
+	if (log->zcdict != NULL)
+		ZSTD_compressBegin_usingCDict(log->zctx, log->zcdict);
+	else
+		ZSTD_compressBegin(log->zctx, 3);
 	size_t offset = XLOG_FIXHEADER_SIZE;
 	for (iov = log->obuf.iov; iov->iov_len; ++iov) {
 		/* Estimate max output buffer size. */
@@ -1187,8 +1770,7 @@ xlog_tx_write_zstd(struct xlog *log)
 	});
 
 	ssize_t written;
-	written = fio_writevn(log->fd, log->zbuf.iov,
-			      log->zbuf.pos + 1);
+	written = xlog_writev(log, log->zbuf.iov, log->zbuf.pos + 1);
 	if (written < 0) {
 		diag_set(SystemError, "failed to write to '%s' file",
 			 log->filename);
@@ -1207,32 +1789,53 @@ error:
 #define SYNC_ROUND_UP(size)	(SYNC_ROUND_DOWN(size + SYNC_MASK))
 
 /**
- * Writes xlog batch to file
+ * Update the write position after appending data to the file
+ * and sync the file if needed. On write error, i.e. if @written
+ * is negative, discard whatever has been appended since the
+ * last successful write.
  */
-static ssize_t
-xlog_tx_write(struct xlog *log)
+/** See xlog_set_priority_rate(). */
+static uint64_t xlog_priority_rate;
+
+void
+xlog_set_priority_rate(uint64_t rate)
 {
-	if (obuf_size(&log->obuf) == XLOG_FIXHEADER_SIZE)
-		return 0;
-	ssize_t written;
+	pm_atomic_store(&xlog_priority_rate, rate);
+}
 
-	if (obuf_size(&log->obuf) >= XLOG_TX_COMPRESS_THRESHOLD) {
-		written = xlog_tx_write_zstd(log);
-	} else {
-		written = xlog_tx_write_plain(log);
-	}
-	ERROR_INJECT(ERRINJ_WAL_WRITE, {
-		diag_set(ClientError, ER_INJECTION, "xlog write injection");
-		written = -1;
-	});
+/**
+ * Return the rate limit of an xlog reduced by the rate of
+ * writes that have priority over it, see
+ * xlog_set_priority_rate().
+ */
+static uint64_t
+xlog_rate_limit(struct xlog *log)
+{
+	if (log->rate_limit == 0)
+		return 0;
+	uint64_t priority_rate = pm_atomic_load(&xlog_priority_rate);
+	uint64_t min_limit = log->rate_limit / XLOG_RATE_LIMIT_MIN_RATIO;
+	if (priority_rate >= log->rate_limit - min_limit)
+		return MAX(min_limit, 1);
+	return log->rate_limit - priority_rate;
+}
 
-	obuf_reset(&log->obuf);
+static ssize_t
+xlog_tx_write_complete(struct xlog *log, ssize_t written)
+{
 	/*
 	 * Simplify recovery after a temporary write failure:
 	 * truncate the file to the best known good write
 	 * position.
 	 */
 	if (written < 0) {
+		/*
+		 * A shared file can't be truncated as other
+		 * writers may have appended to it since. The
+		 * owner is supposed to discard the whole file.
+		 */
+		if (log->owner != NULL)
+			return -1;
 		if (lseek(log->fd, log->offset, SEEK_SET) < 0 ||
 		    ftruncate(log->fd, log->offset) != 0)
 			panic_syserror("failed to truncate xlog after write error");
@@ -1244,22 +1847,31 @@ xlog_tx_write(struct xlog *log)
 	else
 		log->allocated = 0;
 	log->offset += written;
-	log->rows += log->tx_rows;
-	log->tx_rows = 0;
+	uint64_t rate_limit = xlog_rate_limit(log);
 	if ((log->sync_interval && log->offset >=
 	    (off_t)(log->synced_size + log->sync_interval)) ||
-	    (log->rate_limit && log->offset >=
-	    (off_t)(log->synced_size + log->rate_limit))) {
+	    (rate_limit && log->offset >=
+	    (off_t)(log->synced_size + rate_limit))) {
 		off_t sync_from = SYNC_ROUND_DOWN(log->synced_size);
 		size_t sync_len = SYNC_ROUND_UP(log->offset) -
 				  sync_from;
-		if (log->rate_limit > 0) {
+		if (rate_limit > 0) {
 			double throttle_time;
-			throttle_time = (double)sync_len / log->rate_limit -
+			throttle_time = (double)sync_len / rate_limit -
 					(ev_monotonic_time() - log->sync_time);
 			if (throttle_time > 0)
 				ev_sleep(throttle_time);
 		}
+		/*
+		 * Offsets of a shared writer don't match the
+		 * file layout, so sync the whole file.
+		 */
+		if (log->owner != NULL) {
+			xlog_fdatasync(log->fd);
+			log->sync_time = ev_monotonic_time();
+			log->synced_size = log->offset;
+			return written;
+		}
 		/** sync data from cache to disk */
 #ifdef HAVE_SYNC_FILE_RANGE
 		sync_file_range(log->fd, sync_from, sync_len,
@@ -1267,7 +1879,7 @@ xlog_tx_write(struct xlog *log)
 				SYNC_FILE_RANGE_WRITE |
 				SYNC_FILE_RANGE_WAIT_AFTER);
 #else
-		fdatasync(log->fd);
+		xlog_fdatasync(log->fd);
 #endif /* HAVE_SYNC_FILE_RANGE */
 		log->sync_time = ev_monotonic_time();
 		if (log->free_cache) {
@@ -1287,6 +1899,295 @@ xlog_tx_write(struct xlog *log)
 	return written;
 }
 
+/* {{{ Parallel compression */
+
+/**
+ * A complete tx block waiting in the xlog queue for parallel
+ * compression, see xlog_tx_queue().
+ */
+struct xlog_block {
+	/** Block rows, with a fixheader reserved in front. */
+	struct obuf obuf;
+	/** Number of rows in the block. */
+	int64_t rows;
+	/** Compression context used by a worker thread. */
+	ZSTD_CCtx *zctx;
+	/**
+	 * Compressed block, with fixheader. Allocated with
+	 * malloc(), because worker threads may not use the
+	 * cord's slab cache.
+	 */
+	char *zdata;
+	/** Size of @zdata buffer. */
+	size_t zdata_capacity;
+	/** Size of compressed block, zero if not compressed. */
+	size_t zsize;
+	/** ZSTD error code if compression failed, 0 otherwise. */
+	size_t zerror;
+};
+
+static void
+xlog_free_blocks(struct xlog *xlog)
+{
+	for (int i = 0; i < xlog->block_alloc; i++) {
+		struct xlog_block *block = &xlog->blocks[i];
+		obuf_destroy(&block->obuf);
+		ZSTD_freeCCtx(block->zctx);
+		free(block->zdata);
+	}
+	free(xlog->blocks);
+	xlog->blocks = NULL;
+	xlog->block_count = 0;
+	xlog->block_alloc = 0;
+}
+
+/** Allocate one more entry in the block queue. */
+static int
+xlog_alloc_block(struct xlog *log)
+{
+	int alloc = log->block_alloc + 1;
+	struct xlog_block *blocks = realloc(log->blocks,
+					    alloc * sizeof(*blocks));
+	if (blocks == NULL) {
+		diag_set(OutOfMemory, alloc * sizeof(*blocks),
+			 "realloc", "xlog blocks");
+		return -1;
+	}
+	log->blocks = blocks;
+	struct xlog_block *block = &blocks[log->block_alloc];
+	memset(block, 0, sizeof(*block));
+	block->zctx = ZSTD_createCCtx();
+	if (block->zctx == NULL) {
+		diag_set(ClientError, ER_COMPRESSION,
+			 "failed to create context");
+		return -1;
+	}
+	obuf_create(&block->obuf, &cord()->slabc,
+		    XLOG_TX_AUTOCOMMIT_THRESHOLD);
+	log->block_alloc = alloc;
+	return 0;
+}
+
+/**
+ * Make sure the compression buffer of a block is big enough
+ * to store the block compressed, with fixheader.
+ */
+static int
+xlog_block_reserve(struct xlog_block *block)
+{
+	size_t size = XLOG_FIXHEADER_SIZE;
+	size_t offset = XLOG_FIXHEADER_SIZE;
+	for (int i = 0; i <= block->obuf.pos; i++) {
+		size += ZSTD_compressBound(block->obuf.iov[i].iov_len -
+					   offset);
+		offset = 0;
+	}
+	if (block->zdata_capacity >= size)
+		return 0;
+	char *zdata = realloc(block->zdata, size);
+	if (zdata == NULL) {
+		diag_set(OutOfMemory, size, "realloc",
+			 "compression buffer");
+		return -1;
+	}
+	block->zdata = zdata;
+	block->zdata_capacity = size;
+	return 0;
+}
+
+/**
+ * Compress a queued block. Called from a worker thread, so
+ * it neither allocates memory nor sets diag: an error code
+ * is stored in xlog_block::zerror instead.
+ */
+static void
+xlog_block_compress(struct xlog_block *block)
+{
+	struct obuf *obuf = &block->obuf;
+	char *fixheader = block->zdata;
+	char *zdst = fixheader + XLOG_FIXHEADER_SIZE;
+	char *zdst_end = block->zdata + block->zdata_capacity;
+	uint32_t crc32c = 0;
+	/* 3 is compression level. */
+	ZSTD_compressBegin(block->zctx, 3);
+	size_t offset = XLOG_FIXHEADER_SIZE;
+	for (int i = 0; i <= obuf->pos; i++) {
+		struct iovec *iov = &obuf->iov[i];
+		size_t (*fcompress)(ZSTD_CCtx *, void *, size_t,
+				    const void *, size_t);
+		fcompress = i == obuf->pos ? ZSTD_compressEnd :
+					     ZSTD_compressContinue;
+		size_t zsize = fcompress(block->zctx, zdst, zdst_end - zdst,
+					 (char *)iov->iov_base + offset,
+					 iov->iov_len - offset);
+		if (ZSTD_isError(zsize)) {
+			block->zerror = zsize;
+			return;
+		}
+		crc32c = crc32_calc(crc32c, zdst, zsize);
+		zdst += zsize;
+		offset = 0;
+	}
+	block->zsize = zdst - block->zdata;
+
+	*(log_magic_t *)fixheader = zrow_marker;
+	char *data = fixheader + sizeof(log_magic_t);
+	data = mp_encode_uint(data, block->zsize - XLOG_FIXHEADER_SIZE);
+	/* Encode crc32 for previous row */
+	data = mp_encode_uint(data, 0);
+	/* Encode crc32 for current row */
+	data = mp_encode_uint(data, crc32c);
+	/* Encode padding */
+	ssize_t padding = XLOG_FIXHEADER_SIZE - (data - fixheader);
+	if (padding > 0) {
+		data = mp_encode_strl(data, padding - 1);
+		if (padding > 1)
+			memset(data, 0, padding - 1);
+	}
+}
+
+/**
+ * Compress queued blocks in parallel and append them to the
+ * file in order.
+ *
+ * @retval -1  error
+ * @retval >= 0 the number of bytes written
+ */
+static ssize_t
+xlog_write_blocks(struct xlog *log)
+{
+	int count = log->block_count;
+	ssize_t written = 0;
+	for (int i = 0; i < count; i++) {
+		struct xlog_block *block = &log->blocks[i];
+		block->zsize = 0;
+		block->zerror = 0;
+		if (obuf_size(&block->obuf) >= XLOG_TX_COMPRESS_THRESHOLD &&
+		    xlog_block_reserve(block) != 0)
+			goto error;
+	}
+#if defined(HAVE_OPENMP)
+#pragma omp parallel for num_threads(log->compress_threads) schedule(dynamic)
+#endif
+	for (int i = 0; i < count; i++) {
+		struct xlog_block *block = &log->blocks[i];
+		if (obuf_size(&block->obuf) >= XLOG_TX_COMPRESS_THRESHOLD)
+			xlog_block_compress(block);
+	}
+	for (int i = 0; i < count; i++) {
+		struct xlog_block *block = &log->blocks[i];
+		if (block->zerror != 0) {
+			diag_set(ClientError, ER_COMPRESSION,
+				 ZSTD_getErrorName(block->zerror));
+			goto error;
+		}
+		ssize_t rc;
+		if (block->zsize > 0) {
+			struct iovec iov = {
+				.iov_base = block->zdata,
+				.iov_len = block->zsize,
+			};
+			ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
+				diag_set(ClientError, ER_INJECTION,
+					 "xlog write injection");
+				goto error;
+			});
+			rc = xlog_writev(log, &iov, 1);
+			if (rc < 0) {
+				diag_set(SystemError,
+					 "failed to write to '%s' file",
+					 log->filename);
+			}
+		} else {
+			rc = xlog_tx_write_plain(log, &block->obuf);
+		}
+		if (rc < 0)
+			goto error;
+		written += rc;
+	}
+	ERROR_INJECT(ERRINJ_WAL_WRITE, {
+		diag_set(ClientError, ER_INJECTION, "xlog write injection");
+		goto error;
+	});
+	for (int i = 0; i < count; i++) {
+		log->rows += log->blocks[i].rows;
+		obuf_reset(&log->blocks[i].obuf);
+	}
+	log->block_count = 0;
+	return xlog_tx_write_complete(log, written);
+error:
+	for (int i = 0; i < count; i++)
+		obuf_reset(&log->blocks[i].obuf);
+	log->block_count = 0;
+	return xlog_tx_write_complete(log, -1);
+}
+
+/**
+ * Move the current tx block to the queue of blocks waiting for
+ * parallel compression. Once the queue is full, write it out.
+ *
+ * @retval -1  error
+ * @retval >= 0 the number of bytes written
+ */
+static ssize_t
+xlog_tx_queue(struct xlog *log)
+{
+	if (log->block_count == log->block_alloc &&
+	    xlog_alloc_block(log) != 0) {
+		/* Discard the queue along with the current block. */
+		for (int i = 0; i < log->block_count; i++)
+			obuf_reset(&log->blocks[i].obuf);
+		log->block_count = 0;
+		obuf_reset(&log->obuf);
+		return -1;
+	}
+	struct xlog_block *block = &log->blocks[log->block_count++];
+	struct obuf tmp = block->obuf;
+	block->obuf = log->obuf;
+	log->obuf = tmp;
+	block->rows = log->tx_rows;
+	log->tx_rows = 0;
+	/*
+	 * Queue a few blocks per thread so that threads
+	 * compressing smaller blocks don't stay idle.
+	 */
+	if (log->block_count < 2 * log->compress_threads)
+		return 0;
+	return xlog_write_blocks(log);
+}
+
+/* }}} */
+
+/**
+ * Writes xlog batch to file
+ */
+static ssize_t
+xlog_tx_write(struct xlog *log)
+{
+	if (obuf_size(&log->obuf) == XLOG_FIXHEADER_SIZE)
+		return 0;
+	if (log->compress_threads > 1 && log->owner == NULL)
+		return xlog_tx_queue(log);
+	ssize_t written;
+
+	if (obuf_size(&log->obuf) >= XLOG_TX_COMPRESS_THRESHOLD) {
+		written = xlog_tx_write_zstd(log);
+	} else {
+		written = xlog_tx_write_plain(log, &log->obuf);
+	}
+	ERROR_INJECT(ERRINJ_WAL_WRITE, {
+		diag_set(ClientError, ER_INJECTION, "xlog write injection");
+		written = -1;
+	});
+
+	obuf_reset(&log->obuf);
+	if (written >= 0) {
+		log->rows += log->tx_rows;
+		log->tx_rows = 0;
+	}
+	return xlog_tx_write_complete(log, written);
+}
+
 /*
  * Add a row to a log and possibly flush the log.
  *
@@ -1397,9 +2298,19 @@ ssize_t
 xlog_flush(struct xlog *log)
 {
 	assert(log->is_autocommit);
-	if (log->obuf.used == 0)
-		return 0;
-	return xlog_tx_write(log);
+	ssize_t written = 0;
+	if (log->obuf.used > 0) {
+		written = xlog_tx_write(log);
+		if (written < 0)
+			return -1;
+	}
+	if (log->block_count > 0) {
+		ssize_t rc = xlog_write_blocks(log);
+		if (rc < 0)
+			return -1;
+		written += rc;
+	}
+	return written;
 }
 
 static int
@@ -1426,9 +2337,14 @@ xlog_sync(struct xlog *l)
 			return -1;
 		}
 		eio_fsync(fd, 0, sync_cb, (void *) (intptr_t) fd);
-	} else if (fsync(l->fd) < 0) {
-		say_syserror("%s: fsync failed", l->filename);
-		return -1;
+	} else {
+		PROBE1(xlog_fsync_start, l->fd);
+		int rc = fsync(l->fd);
+		PROBE2(xlog_fsync_done, l->fd, rc);
+		if (rc < 0) {
+			say_syserror("%s: fsync failed", l->filename);
+			return -1;
+		}
 	}
 	return 0;
 }
@@ -1451,6 +2367,20 @@ xlog_write_eof(struct xlog *l)
 		return -1;
 	}
 
+	if (l->is_direct_io) {
+		/* Cut off the padding after the eof marker. */
+		struct iovec iov = {
+			.iov_base = (void *)&eof_marker,
+			.iov_len = sizeof(eof_marker),
+		};
+		if (xlog_writev_direct(l, &iov, 1) < 0)
+			return -1;
+		if (ftruncate(l->fd, l->offset + sizeof(eof_marker)) < 0) {
+			diag_set(SystemError, "ftruncate() failed");
+			return -1;
+		}
+		return 0;
+	}
 	if (fio_writen(l->fd, &eof_marker, sizeof(eof_marker)) < 0) {
 		diag_set(SystemError, "write() failed");
 		return -1;
@@ -1671,9 +2601,43 @@ xlog_fixheader_decode(struct xlog_fixheader *fixheader,
 	return 0;
 }
 
+/**
+ * Find zero padding written after the last tx of a file
+ * by an O_DIRECT writer, see xlog_set_direct_io(). Txs are
+ * looked up starting from @a offset by their fixheaders.
+ * Returns @a size if there's no padding.
+ */
+static off_t
+xlog_find_padding(int fd, off_t offset, off_t size)
+{
+	char magic[sizeof(log_magic_t)];
+	if (size - offset < (off_t)sizeof(magic) ||
+	    fio_pread(fd, magic, sizeof(magic), size - sizeof(magic)) !=
+	    sizeof(magic) || load_u32(magic) != 0)
+		return size;
+	char buf[XLOG_FIXHEADER_SIZE];
+	while (offset < size) {
+		ssize_t rc = fio_pread(fd, buf, sizeof(buf), offset);
+		if (rc < (ssize_t)sizeof(magic))
+			break;
+		if (load_u32(buf) == 0)
+			return offset;
+		const char *data = buf;
+		struct xlog_fixheader fixheader;
+		if (xlog_fixheader_decode(&fixheader, &data,
+					  buf + rc) != 0) {
+			diag_clear(diag_get());
+			break;
+		}
+		offset += XLOG_FIXHEADER_SIZE + fixheader.len;
+	}
+	return size;
+}
+
 int
 xlog_tx_decode(const char *data, const char *data_end,
-	       char *rows, char *rows_end, ZSTD_DStream *zdctx)
+	       char *rows, char *rows_end, ZSTD_DStream *zdctx,
+	       const ZSTD_DDict *zddict)
 {
 	/* Decode fixheader */
 	struct xlog_fixheader fixheader;
@@ -1712,7 +2676,10 @@ xlog_tx_decode(const char *data, const char *data_end,
 
 	/* Decompress zstd rows */
 	assert(fixheader.magic == zrow_marker);
-	ZSTD_initDStream(zdctx);
+	if (zddict != NULL)
+		ZSTD_initDStream_usingDDict(zdctx, zddict);
+	else
+		ZSTD_initDStream(zdctx);
 	int rc = xlog_cursor_decompress(&rows, rows_end, &data, data_end,
 					zdctx);
 	if (rc < 0) {
@@ -1855,11 +2822,146 @@ xlog_cursor_find_tx_magic(struct xlog_cursor *i)
 	return 0;
 }
 
+/* {{{ Seek index */
+
+/** A position in a WAL file. */
+struct xlog_seek_point {
+	/** Offset of a tx in the file. */
+	off_t offset;
+	/** Vclock of the rows preceding the tx. */
+	struct vclock vclock;
+};
+
+/** Positions in a WAL file, by offset. */
+struct xlog_seek_file {
+	char name[PATH_MAX];
+	struct tt_uuid instance_uuid;
+	struct xlog_seek_point *points;
+	int point_count;
+	int point_capacity;
+	/** Last time the file was looked up, for eviction. */
+	uint64_t used;
+};
+
+static struct xlog_seek_file xlog_seek_files[XLOG_SEEK_INDEX_FILES_MAX];
+static uint64_t xlog_seek_clock;
+static pthread_mutex_t xlog_seek_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Find the file of a cursor in the seek index. If it isn't
+ * there and @a create is set, replace the least recently used
+ * file with it. Must be called under xlog_seek_mutex.
+ */
+static struct xlog_seek_file *
+xlog_seek_file_find(struct xlog_cursor *cursor, bool create)
+{
+	struct xlog_seek_file *lru = &xlog_seek_files[0];
+	for (int i = 0; i < XLOG_SEEK_INDEX_FILES_MAX; i++) {
+		struct xlog_seek_file *file = &xlog_seek_files[i];
+		if (strcmp(file->name, cursor->name) == 0 &&
+		    tt_uuid_is_equal(&file->instance_uuid,
+				     &cursor->meta.instance_uuid)) {
+			file->used = ++xlog_seek_clock;
+			return file;
+		}
+		if (file->used < lru->used)
+			lru = file;
+	}
+	if (!create)
+		return NULL;
+	snprintf(lru->name, sizeof(lru->name), "%s", cursor->name);
+	lru->instance_uuid = cursor->meta.instance_uuid;
+	lru->point_count = 0;
+	lru->used = ++xlog_seek_clock;
+	return lru;
+}
+
+/** Add the current position of a WAL cursor to the seek index. */
+static void
+xlog_seek_index_add(struct xlog_cursor *cursor)
+{
+	off_t offset = xlog_cursor_pos(cursor);
+	if (offset < cursor->indexed_offset + XLOG_SEEK_INDEX_STEP)
+		return;
+	cursor->indexed_offset = offset;
+	tt_pthread_mutex_lock(&xlog_seek_mutex);
+	struct xlog_seek_file *file = xlog_seek_file_find(cursor, true);
+	/* Another cursor may have indexed this part already. */
+	if (file->point_count > 0 &&
+	    file->points[file->point_count - 1].offset >= offset)
+		goto out;
+	if (file->point_count == file->point_capacity) {
+		int capacity = file->point_capacity > 0 ?
+			       2 * file->point_capacity : 16;
+		struct xlog_seek_point *points = realloc(file->points,
+					capacity * sizeof(*points));
+		/* The index is an optimization, ignore OOM. */
+		if (points == NULL)
+			goto out;
+		file->points = points;
+		file->point_capacity = capacity;
+	}
+	struct xlog_seek_point *point = &file->points[file->point_count++];
+	point->offset = offset;
+	vclock_copy(&point->vclock, &cursor->vclock);
+out:
+	tt_pthread_mutex_unlock(&xlog_seek_mutex);
+}
+
+void
+xlog_cursor_seek(struct xlog_cursor *cursor, const struct vclock *vclock)
+{
+	assert(cursor->state == XLOG_CURSOR_ACTIVE);
+	if (!cursor->is_indexed)
+		return;
+	tt_pthread_mutex_lock(&xlog_seek_mutex);
+	struct xlog_seek_file *file = xlog_seek_file_find(cursor, false);
+	if (file == NULL || file->point_count == 0)
+		goto out;
+	/*
+	 * Vclocks of the points grow monotonically, so find
+	 * the last one that isn't greater than the requested
+	 * one with a binary search.
+	 */
+	int begin = 0, end = file->point_count;
+	while (begin < end) {
+		int mid = begin + (end - begin) / 2;
+		if (vclock_compare(&file->points[mid].vclock, vclock) <= 0)
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	if (begin == 0)
+		goto out;
+	struct xlog_seek_point *point = &file->points[begin - 1];
+	if (point->offset <= xlog_cursor_pos(cursor))
+		goto out;
+	ibuf_reset(&cursor->rbuf);
+	cursor->read_offset = point->offset;
+	cursor->indexed_offset = point->offset;
+	vclock_copy(&cursor->vclock, &point->vclock);
+out:
+	tt_pthread_mutex_unlock(&xlog_seek_mutex);
+}
+
+/* }}} */
+
+void
+xlog_cursor_seek_offset(struct xlog_cursor *cursor, off_t offset)
+{
+	assert(cursor->state == XLOG_CURSOR_ACTIVE);
+	assert(cursor->fd >= 0);
+	ibuf_reset(&cursor->rbuf);
+	cursor->read_offset = offset;
+}
+
 int
 xlog_cursor_next_tx(struct xlog_cursor *i)
 {
 	int rc;
 	assert(xlog_cursor_is_open(i));
+	if (i->is_indexed)
+		xlog_seek_index_add(i);
 
 	/* load at least magic to check eof */
 	rc = xlog_cursor_ensure(i, sizeof(log_magic_t));
@@ -1871,6 +2973,17 @@ xlog_cursor_next_tx(struct xlog_cursor *i)
 		/* eof marker found */
 		goto eof_found;
 	}
+	if (load_u32(i->rbuf.rpos) == 0) {
+		/*
+		 * Zero padding after the last tx written by an
+		 * O_DIRECT writer, see xlog_set_direct_io(). It's
+		 * going to be overwritten by the next tx, so drop
+		 * it to reread the file from here next time.
+		 */
+		i->read_offset -= ibuf_used(&i->rbuf);
+		ibuf_reset(&i->rbuf);
+		return 1;
+	}
 
 	ssize_t to_load;
 	while ((to_load = xlog_tx_cursor_create(&i->tx_cursor,
@@ -1917,6 +3030,9 @@ xlog_cursor_next_row(struct xlog_cursor *cursor, struct xrow_header *xrow)
 	if (rc != 0) {
 		cursor->state = XLOG_CURSOR_ACTIVE;
 		xlog_tx_cursor_destroy(&cursor->tx_cursor);
+	} else if (cursor->is_indexed && xrow->replica_id < VCLOCK_MAX &&
+		   xrow->lsn > vclock_get(&cursor->vclock, xrow->replica_id)) {
+		vclock_follow(&cursor->vclock, xrow->replica_id, xrow->lsn);
 	}
 	return rc;
 }
@@ -1981,6 +3097,9 @@ xlog_cursor_openfd(struct xlog_cursor *i, int fd, const char *name)
 		goto error;
 	}
 	snprintf(i->name, PATH_MAX, "%s", name);
+	i->is_indexed = strcmp(i->meta.filetype, "XLOG") == 0;
+	vclock_copy(&i->vclock, &i->meta.vclock);
+	i->indexed_offset = xlog_cursor_pos(i);
 	i->zdctx = ZSTD_createDStream();
 	if (i->zdctx == NULL) {
 		diag_set(ClientError, ER_DECOMPRESSION,
@@ -33,6 +33,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <sys/stat.h>
+#include <pthread.h>
 #include "tt_uuid.h"
 #include "vclock.h"
 
@@ -44,6 +45,7 @@
 
 struct iovec;
 struct xrow_header;
+struct xlog_block;
 
 #if defined(__cplusplus)
 extern "C" {
@@ -140,6 +142,22 @@ struct xdir {
 	 * corresponding file cache will be marked as free
 	 */
 	uint64_t sync_interval;
+	/**
+	 * Number of threads used for compressing blocks of
+	 * log files created in this directory, see
+	 * xlog::compress_threads.
+	 */
+	int compress_threads;
+	/**
+	 * Flush data to disk after each write to a log file
+	 * created in this directory, see xlog::datasync_on_write.
+	 */
+	bool datasync_on_write;
+	/**
+	 * Write log files created in this directory bypassing
+	 * the page cache, see xlog_set_direct_io().
+	 */
+	bool direct_io;
 };
 
 /**
@@ -358,6 +376,12 @@ struct xlog {
 	struct obuf obuf;
 	/** The context of zstd compression */
 	ZSTD_CCtx *zctx;
+	/**
+	 * Optional dictionary to compress transactions with,
+	 * not owned by the xlog. Ignored by parallel compression
+	 * (compress_threads > 1).
+	 */
+	const ZSTD_CDict *zcdict;
 	/**
 	 * Compressed output buffer
 	 */
@@ -385,6 +409,48 @@ struct xlog {
 	uint64_t rate_limit;
 	/** Time when xlog wast synced last time */
 	double sync_time;
+	/**
+	 * If this xlog appends to a file owned by another
+	 * xlog, see xlog_create_shared(), points to the owner.
+	 */
+	struct xlog *owner;
+	/**
+	 * Serializes writes of xlogs sharing this xlog's file,
+	 * so that a block written by one of them is never
+	 * interleaved with a block written by another.
+	 */
+	pthread_mutex_t write_mutex;
+	/**
+	 * Number of threads used for compressing tx blocks.
+	 * If greater than 1, complete blocks are queued rather
+	 * than written right away. The queue is compressed in
+	 * parallel and appended to the file in order when it
+	 * gets full or on xlog_flush().
+	 */
+	int compress_threads;
+	/**
+	 * Call fdatasync(2) after each write. Used instead of
+	 * O_SYNC when writes go through io_uring, so that a
+	 * write and the following sync are submitted to the
+	 * kernel in one system call.
+	 */
+	bool datasync_on_write;
+	/** Blocks queued for parallel compression. */
+	struct xlog_block *blocks;
+	/** Number of queued blocks. */
+	int block_count;
+	/** Number of allocated entries of @blocks. */
+	int block_alloc;
+	/** Set if the file is written with O_DIRECT. */
+	bool is_direct_io;
+	/**
+	 * O_DIRECT write buffer aligned to the file system
+	 * block. Starts with the last partially filled block
+	 * of the file, which is rewritten by the next write.
+	 */
+	char *direct_buf;
+	/** Size of @direct_buf. */
+	size_t direct_buf_size;
 };
 
 /**
@@ -418,6 +484,28 @@ int
 xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 		 const struct vclock *vclock);
 
+/**
+ * Same as xdir_create_xlog(), but instead of creating a new
+ * file, write the meta to an empty file open as @a fd, which
+ * has @a allocated bytes of disk space preallocated, and
+ * rename it from @a spare_path, see wal_spare_pool. For WAL
+ * directories only. The file is closed and removed on error.
+ */
+int
+xdir_create_xlog_from_spare(struct xdir *dir, struct xlog *xlog,
+			    const struct vclock *vclock, int fd,
+			    const char *spare_path, int64_t allocated);
+
+/**
+ * Same as xdir_create_xlog(), but store the given vclock of
+ * the previous file in the file meta, whatever the directory
+ * type. Used for delta snapshots, which refer to their base.
+ */
+int
+xdir_create_xlog_with_prev(struct xdir *dir, struct xlog *xlog,
+			   const struct vclock *vclock,
+			   const struct vclock *prev_vclock);
+
 /**
  * Create new xlog writer based on fd.
  * @param fd            file descriptor
@@ -433,6 +521,37 @@ int
 xlog_create(struct xlog *xlog, const char *name, int flags,
 	    const struct xlog_meta *meta);
 
+/**
+ * Create an xlog writer appending to the file of another
+ * xlog, possibly from another thread. Each shared writer
+ * accumulates and compresses rows in its own buffers and
+ * appends whole blocks to the file, so rows written by
+ * different writers are interleaved at block granularity.
+ * The owner must not write to the file until all shared
+ * writers are closed with xlog_close_shared(). The rate
+ * limit and the sync interval of a shared writer account
+ * only for the bytes written by it.
+ *
+ * @param xlog          xlog descriptor
+ * @param owner         xlog owning the file
+ *
+ * @retval 0 success
+ * @retval -1 error
+ */
+int
+xlog_create_shared(struct xlog *xlog, struct xlog *owner);
+
+/**
+ * Flush and destroy a writer created with xlog_create_shared().
+ * Neither closes the file nor writes the EOF marker, which
+ * is up to the owner.
+ *
+ * @retval 0 success
+ * @retval -1 error, the written data may be incomplete
+ */
+int
+xlog_close_shared(struct xlog *xlog);
+
 /**
  * Open an existing xlog file for appending.
  * @param xlog          xlog descriptor
@@ -482,6 +601,37 @@ xlog_rename(struct xlog *l);
 ssize_t
 xlog_fallocate(struct xlog *log, size_t size);
 
+/**
+ * Switch an xlog open for writing to O_DIRECT. Each write
+ * is then padded with zeros to the file system block and
+ * the last partially filled block is rewritten by the next
+ * write, so that readers see zero padding after the last
+ * tx until it is overwritten. The padding is cut off when
+ * the file is closed.
+ *
+ * Returns -1 and sets diag if O_DIRECT isn't supported.
+ */
+int
+xlog_set_direct_io(struct xlog *log);
+
+enum {
+	/**
+	 * A rate-limited xlog is never throttled below this
+	 * fraction of its limit, see xlog_set_priority_rate().
+	 */
+	XLOG_RATE_LIMIT_MIN_RATIO = 10,
+};
+
+/**
+ * Set the rate of writes that have priority over rate-limited
+ * xlogs, in bytes per second. The rate limit of each xlog is
+ * reduced by this rate, but not below a fraction of it, so
+ * that the disk bandwidth is shared with WAL writes. May be
+ * called from any thread.
+ */
+void
+xlog_set_priority_rate(uint64_t rate);
+
 /**
  * Write a row to xlog, 
  *
@@ -609,13 +759,15 @@ xlog_tx_cursor_pos(struct xlog_tx_cursor *tx_cursor)
  * @param data_end the end of @a data buffer
  * @param[out] rows a buffer to store decoded rows
  * @param[out] rows_end the end of @a rows buffer
+ * @param zdctx zstd decompression context
+ * @param zddict dictionary the rows were compressed with, or NULL
  * @retval  0 success
  * @retval -1 error, check diag
  */
 int
 xlog_tx_decode(const char *data, const char *data_end,
 	       char *rows, char *rows_end,
-	       ZSTD_DStream *zdctx);
+	       ZSTD_DStream *zdctx, const ZSTD_DDict *zddict);
 
 /* }}} */
 
@@ -656,6 +808,15 @@ struct xlog_cursor
 	struct xlog_tx_cursor tx_cursor;
 	/** ZSTD context for decompression */
 	ZSTD_DStream *zdctx;
+	/**
+	 * Set if the positions of a WAL file read by the cursor
+	 * are added to the seek index, see xlog_cursor_seek().
+	 */
+	bool is_indexed;
+	/** Vclock of the rows read so far. */
+	struct vclock vclock;
+	/** Position last added to the seek index. */
+	off_t indexed_offset;
 };
 
 /**
@@ -692,6 +853,28 @@ xlog_cursor_is_eof(const struct xlog_cursor *cursor)
 int
 xlog_cursor_openfd(struct xlog_cursor *cursor, int fd, const char *name);
 
+/**
+ * Skip the rows of a just opened WAL file that are known to
+ * be not greater than @a vclock without reading them.
+ *
+ * WAL cursors remember every XLOG_SEEK_INDEX_STEP bytes
+ * the position of the next tx along with the vclock of the
+ * rows before it in an index shared by all threads, so that
+ * relays of replicas subscribing from the middle of a file
+ * don't decode it from the beginning over and over again.
+ */
+void
+xlog_cursor_seek(struct xlog_cursor *cursor, const struct vclock *vclock);
+
+/**
+ * Make a just opened cursor continue reading from the tx
+ * stored at @a offset in the file. The offset must have been
+ * obtained with xlog_cursor_pos() before a tx was read or
+ * from xlog::offset after the file was flushed.
+ */
+void
+xlog_cursor_seek_offset(struct xlog_cursor *cursor, off_t offset);
+
 /**
  * Open cursor from file
  * @param cursor cursor
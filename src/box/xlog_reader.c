@@ -0,0 +1,338 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "xlog_reader.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "trivia/util.h"
+#include "fiber.h"
+#include "fiber_cond.h"
+#include "cbus.h"
+#include "diag.h"
+#include "say.h"
+#include "xlog.h"
+#include "xrow.h"
+
+enum {
+	/** Max number of rows in a batch. */
+	XLOG_READER_BATCH_ROWS_MAX = 1024,
+	/** Approximate max size of row data in a batch. */
+	XLOG_READER_BATCH_SIZE_MAX = 1024 * 1024,
+	/** Number of batches read ahead by the reader thread. */
+	XLOG_READER_BATCH_COUNT = 4,
+};
+
+/**
+ * A batch of rows read, decompressed and decoded by the reader
+ * thread. Row bodies point to the batch data buffer, so the
+ * rows stay valid until the batch is reused.
+ */
+struct xlog_reader_batch {
+	struct cmsg base;
+	struct xlog_reader *reader;
+	struct xrow_header rows[XLOG_READER_BATCH_ROWS_MAX];
+	int row_count;
+	/** Buffer storing row bodies. */
+	char *data;
+	size_t data_size;
+	size_t data_capacity;
+	/** Set in tx when the batch is back from the reader. */
+	bool is_ready;
+	/** Set if there are no more rows in the file. */
+	bool is_eof;
+	/** Set if the file has the EOF marker. */
+	bool has_eof_marker;
+	/** Reader error, if any. */
+	struct diag diag;
+};
+
+struct xlog_reader {
+	/** Reader thread. */
+	struct cord cord;
+	/** Pipe from tx to the reader thread. */
+	struct cpipe reader_pipe;
+	/** Pipe from the reader thread to tx. */
+	struct cpipe tx_pipe;
+	/** Route of a batch: reader thread, then back to tx. */
+	struct cmsg_hop route[2];
+	/** Signalled when a batch is back in tx. */
+	struct fiber_cond cond;
+	/** Name of the file. */
+	char filename[PATH_MAX];
+	bool force_recovery;
+	struct xlog_reader_batch batches[XLOG_READER_BATCH_COUNT];
+	/** Batch rows are currently fetched from. */
+	struct xlog_reader_batch *batch;
+	/** Index of the next row to fetch from the batch. */
+	int row_idx;
+	/** Set once the last batch has been fetched. */
+	bool is_eof;
+	/** Members below are accessed by the reader thread only. */
+	struct xlog_cursor cursor;
+	bool is_open;
+	/** Set on EOF or error, no more rows will be read. */
+	bool is_done;
+};
+
+static void
+xlog_reader_close_cursor(struct xlog_reader *reader)
+{
+	if (reader->is_open)
+		xlog_cursor_close(&reader->cursor, false);
+	reader->is_open = false;
+	reader->is_done = true;
+}
+
+/** Copy row bodies to the batch data buffer. */
+static int
+xlog_reader_batch_add_row(struct xlog_reader_batch *batch,
+			  struct xrow_header *row)
+{
+	for (int i = 0; i < row->bodycnt; i++) {
+		size_t len = row->body[i].iov_len;
+		if (batch->data_size + len > batch->data_capacity) {
+			size_t capacity = MAX(batch->data_capacity * 2,
+					      batch->data_size + len);
+			char *data = realloc(batch->data, capacity);
+			if (data == NULL) {
+				diag_set(OutOfMemory, capacity, "realloc",
+					 "xlog reader batch");
+				return -1;
+			}
+			batch->data = data;
+			batch->data_capacity = capacity;
+		}
+		memcpy(batch->data + batch->data_size,
+		       row->body[i].iov_base, len);
+		/*
+		 * The buffer may be reallocated, so store the
+		 * offset until the batch is complete.
+		 */
+		row->body[i].iov_base = (void *)(uintptr_t)batch->data_size;
+		batch->data_size += len;
+	}
+	batch->row_count++;
+	return 0;
+}
+
+/** Fill a batch with rows, called in the reader thread. */
+static void
+xlog_reader_batch_read(struct cmsg *m)
+{
+	struct xlog_reader_batch *batch = (struct xlog_reader_batch *)m;
+	struct xlog_reader *reader = batch->reader;
+	batch->row_count = 0;
+	batch->data_size = 0;
+	if (reader->is_done) {
+		batch->is_eof = true;
+		return;
+	}
+	if (!reader->is_open) {
+		if (xlog_cursor_open(&reader->cursor, reader->filename) < 0)
+			goto fail;
+		reader->is_open = true;
+	}
+	while (batch->row_count < XLOG_READER_BATCH_ROWS_MAX &&
+	       batch->data_size < XLOG_READER_BATCH_SIZE_MAX) {
+		struct xrow_header *row = &batch->rows[batch->row_count];
+		int rc = xlog_cursor_next(&reader->cursor, row,
+					  reader->force_recovery);
+		if (rc < 0)
+			goto fail;
+		if (rc > 0) {
+			batch->is_eof = true;
+			batch->has_eof_marker =
+				xlog_cursor_is_eof(&reader->cursor);
+			xlog_reader_close_cursor(reader);
+			break;
+		}
+		if (xlog_reader_batch_add_row(batch, row) != 0)
+			goto fail;
+	}
+	for (int i = 0; i < batch->row_count; i++) {
+		struct xrow_header *row = &batch->rows[i];
+		for (int j = 0; j < row->bodycnt; j++) {
+			uintptr_t offset = (uintptr_t)row->body[j].iov_base;
+			row->body[j].iov_base = batch->data + offset;
+		}
+	}
+	return;
+fail:
+	diag_move(diag_get(), &batch->diag);
+	xlog_reader_close_cursor(reader);
+}
+
+/** Called in tx when a batch is back from the reader thread. */
+static void
+xlog_reader_batch_complete(struct cmsg *m)
+{
+	struct xlog_reader_batch *batch = (struct xlog_reader_batch *)m;
+	batch->is_ready = true;
+	fiber_cond_signal(&batch->reader->cond);
+}
+
+/** Send a batch to the reader thread to be filled with rows. */
+static void
+xlog_reader_batch_request(struct xlog_reader_batch *batch)
+{
+	struct xlog_reader *reader = batch->reader;
+	batch->is_ready = false;
+	batch->is_eof = false;
+	batch->has_eof_marker = false;
+	cmsg_init(&batch->base, reader->route);
+	cpipe_push(&reader->reader_pipe, &batch->base);
+}
+
+/** Reader thread function. */
+static int
+xlog_reader_f(va_list ap)
+{
+	struct xlog_reader *reader = va_arg(ap, struct xlog_reader *);
+	struct cbus_endpoint endpoint;
+
+	cpipe_create(&reader->tx_pipe, "tx_prio");
+	cbus_endpoint_create(&endpoint, cord_name(cord()),
+			     fiber_schedule_cb, fiber());
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	cpipe_destroy(&reader->tx_pipe);
+	xlog_reader_close_cursor(reader);
+	return 0;
+}
+
+static void
+xlog_reader_free(struct xlog_reader *reader)
+{
+	fiber_cond_destroy(&reader->cond);
+	for (int i = 0; i < XLOG_READER_BATCH_COUNT; i++) {
+		free(reader->batches[i].data);
+		diag_destroy(&reader->batches[i].diag);
+	}
+	free(reader);
+}
+
+struct xlog_reader *
+xlog_reader_new(const char *filename, bool force_recovery)
+{
+	assert(cord_is_main());
+	struct xlog_reader *reader = calloc(1, sizeof(*reader));
+	if (reader == NULL) {
+		diag_set(OutOfMemory, sizeof(*reader), "calloc",
+			 "struct xlog_reader");
+		return NULL;
+	}
+	snprintf(reader->filename, sizeof(reader->filename), "%s", filename);
+	reader->force_recovery = force_recovery;
+	reader->route[0].f = xlog_reader_batch_read;
+	reader->route[0].pipe = &reader->tx_pipe;
+	reader->route[1].f = xlog_reader_batch_complete;
+	reader->route[1].pipe = NULL;
+	for (int i = 0; i < XLOG_READER_BATCH_COUNT; i++) {
+		reader->batches[i].reader = reader;
+		diag_create(&reader->batches[i].diag);
+	}
+	fiber_cond_create(&reader->cond);
+
+	if (cord_costart(&reader->cord, "xlog.reader",
+			 xlog_reader_f, reader) != 0) {
+		xlog_reader_free(reader);
+		return NULL;
+	}
+	cpipe_create(&reader->reader_pipe, "xlog.reader");
+
+	for (int i = 0; i < XLOG_READER_BATCH_COUNT; i++)
+		xlog_reader_batch_request(&reader->batches[i]);
+	reader->batch = NULL;
+	return reader;
+}
+
+void
+xlog_reader_delete(struct xlog_reader *reader)
+{
+	/* Wait for batches in flight before stopping the reader. */
+	for (int i = 0; i < XLOG_READER_BATCH_COUNT; i++) {
+		while (!reader->batches[i].is_ready)
+			fiber_cond_wait(&reader->cond);
+	}
+	/* Joining the reader clears the diagnostics area. */
+	struct diag diag;
+	diag_create(&diag);
+	diag_move(diag_get(), &diag);
+	cbus_stop_loop(&reader->reader_pipe);
+	cpipe_destroy(&reader->reader_pipe);
+	if (cord_cojoin(&reader->cord) != 0)
+		panic("failed to join xlog reader thread");
+	diag_move(&diag, diag_get());
+	diag_destroy(&diag);
+	xlog_reader_free(reader);
+}
+
+int
+xlog_reader_next(struct xlog_reader *reader, struct xrow_header **row)
+{
+	struct xlog_reader_batch *batch = reader->batch;
+	while (batch == NULL || reader->row_idx >= batch->row_count) {
+		if (reader->is_eof)
+			return 1;
+		int idx = 0;
+		if (batch != NULL) {
+			/* Done with the batch, let it be refilled. */
+			idx = (batch - reader->batches + 1) %
+			      XLOG_READER_BATCH_COUNT;
+			xlog_reader_batch_request(batch);
+		}
+		batch = &reader->batches[idx];
+		reader->batch = batch;
+		reader->row_idx = 0;
+		while (!batch->is_ready)
+			fiber_cond_wait(&reader->cond);
+		if (!diag_is_empty(&batch->diag)) {
+			diag_move(&batch->diag, diag_get());
+			reader->is_eof = true;
+			batch->row_count = 0;
+			return -1;
+		}
+		if (batch->is_eof)
+			reader->is_eof = true;
+	}
+	*row = &batch->rows[reader->row_idx++];
+	return 0;
+}
+
+bool
+xlog_reader_has_eof_marker(struct xlog_reader *reader)
+{
+	return reader->is_eof && reader->batch != NULL &&
+	       reader->batch->has_eof_marker;
+}
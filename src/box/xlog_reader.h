@@ -0,0 +1,88 @@
+#ifndef TARANTOOL_BOX_XLOG_READER_H_INCLUDED
+#define TARANTOOL_BOX_XLOG_READER_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdbool.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct xrow_header;
+struct xlog_reader;
+
+/**
+ * Start reading an xlog file in a separate thread.
+ *
+ * The reader thread reads the file, verifies checksums,
+ * decompresses tx blocks and decodes row headers ahead of
+ * the caller, handing rows to tx in batches. This way disk
+ * I/O and decoding overlap with applying rows in tx.
+ *
+ * Must be called from the tx thread.
+ *
+ * @param filename path to the file
+ * @param force_recovery skip corrupted tx blocks
+ * @retval NULL on error, check diag
+ */
+struct xlog_reader *
+xlog_reader_new(const char *filename, bool force_recovery);
+
+/**
+ * Stop the reader thread and free the reader.
+ * Doesn't touch the diagnostics area of the caller.
+ */
+void
+xlog_reader_delete(struct xlog_reader *reader);
+
+/**
+ * Fetch the next row of the file. The row stays valid until
+ * the next call. Yields while the reader thread is behind.
+ *
+ * @retval 0 success
+ * @retval 1 no more rows
+ * @retval -1 error, check diag
+ */
+int
+xlog_reader_next(struct xlog_reader *reader, struct xrow_header **row);
+
+/**
+ * Return true if the file was read up to the EOF marker.
+ * Only meaningful after xlog_reader_next() returned 1.
+ */
+bool
+xlog_reader_has_eof_marker(struct xlog_reader *reader);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_XLOG_READER_H_INCLUDED */
@@ -0,0 +1,694 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "xlog_scan.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include <sys/stat.h>
+
+#include "trivia/util.h"
+#include "pmatomic.h"
+#include "salad/stailq.h"
+#include "fiber.h"
+#include "fiber_cond.h"
+#include "cbus.h"
+#include "diag.h"
+#include "say.h"
+#include "msgpuck.h"
+#include "error.h"
+#include "xlog.h"
+#include "xrow.h"
+#include "iproto_constants.h"
+
+enum {
+	/** Max number of rows in a batch. */
+	XLOG_SCAN_BATCH_ROWS_MAX = 1024,
+	/** Approximate max size of row data in a batch. */
+	XLOG_SCAN_BATCH_SIZE_MAX = 1024 * 1024,
+	/** Number of batches read ahead by each scan thread. */
+	XLOG_SCAN_BATCH_COUNT = 4,
+	/** Default number of scan threads. */
+	XLOG_SCAN_THREAD_COUNT_DEFAULT = 4,
+};
+
+/** Default size of a part of a file scanned by one thread. */
+static const int64_t XLOG_SCAN_PART_SIZE_DEFAULT = 64 * 1024 * 1024;
+
+/** Used to give scan threads and endpoints unique names. */
+static unsigned xlog_scan_id;
+
+/** A byte range of a file scanned by one thread. */
+struct xlog_scan_part {
+	const char *filename;
+	/** Tx blocks beginning in [begin, end) belong to the part. */
+	int64_t begin;
+	int64_t end;
+};
+
+/**
+ * A batch of raw rows read by a scan thread. Rows are copied
+ * from the decompressed tx block to the batch data buffer.
+ */
+struct xlog_scan_batch {
+	struct cmsg base;
+	struct xlog_scan_thread *thread;
+	/** Link in xlog_scan::ready. */
+	struct stailq_entry in_ready;
+	/** Name of the file the rows were read from. */
+	const char *filename;
+	int row_count;
+	char *data;
+	size_t data_size;
+	size_t data_capacity;
+	/** Set if the thread has no more rows. */
+	bool is_eof;
+	/** Scan thread error, if any. */
+	struct diag diag;
+};
+
+struct xlog_scan_thread {
+	struct xlog_scan *scan;
+	struct cord cord;
+	/** Pipe from tx to the scan thread. */
+	struct cpipe thread_pipe;
+	/** Pipe from the scan thread to tx. */
+	struct cpipe tx_pipe;
+	/** Route of a batch: scan thread, then back to tx. */
+	struct cmsg_hop route[2];
+	struct xlog_scan_batch batches[XLOG_SCAN_BATCH_COUNT];
+	/** Number of batches sent to the thread. */
+	int in_flight;
+	/** Set in tx once an empty batch is back from the thread. */
+	bool is_eof;
+	/** Members below are accessed by the scan thread only. */
+	struct xlog_cursor cursor;
+	/** Part being scanned, NULL if none. */
+	struct xlog_scan_part *part;
+	/** Set when there are no more parts or on error. */
+	bool is_done;
+};
+
+struct xlog_scan {
+	/** Endpoint in tx receiving batches from the threads. */
+	struct cbus_endpoint endpoint;
+	bool has_endpoint;
+	struct xlog_scan_thread *threads;
+	int thread_count;
+	/** Signalled when a batch is back in tx. */
+	struct fiber_cond cond;
+	/** Batches back from the threads, not fetched yet. */
+	struct stailq ready;
+	/** Batch rows are currently fetched from. */
+	struct xlog_scan_batch *batch;
+	/** Number of threads that may have rows. */
+	int active_thread_count;
+	/** Set once an error has been returned. */
+	bool is_failed;
+	/** Filter, see struct xlog_scan_opts. */
+	uint64_t type_mask;
+	/** Sorted space ids or NULL. */
+	uint32_t *space_ids;
+	int space_id_count;
+	/** Copies of file names. */
+	char **filenames;
+	int file_count;
+	struct xlog_scan_part *parts;
+	int part_count;
+	/** Index of the next part to scan, taken by threads. */
+	int next_part;
+};
+
+void
+xlog_scan_opts_create(struct xlog_scan_opts *opts)
+{
+	opts->thread_count = XLOG_SCAN_THREAD_COUNT_DEFAULT;
+	opts->part_size = XLOG_SCAN_PART_SIZE_DEFAULT;
+	opts->type_mask = 0;
+	opts->space_ids = NULL;
+	opts->space_id_count = 0;
+}
+
+static int
+xlog_scan_space_id_cmp(const void *a, const void *b)
+{
+	uint32_t id_a = *(const uint32_t *)a;
+	uint32_t id_b = *(const uint32_t *)b;
+	return id_a < id_b ? -1 : id_a > id_b;
+}
+
+/**
+ * Look up the space id in the body of a row without decoding
+ * the rest of it. The body comes from a tx block that passed
+ * the checksum check, so it isn't validated.
+ */
+static bool
+xlog_scan_row_space_id(const struct xrow_header *row, uint32_t *space_id)
+{
+	if (row->bodycnt == 0)
+		return false;
+	const char *data = row->body[0].iov_base;
+	if (mp_typeof(*data) != MP_MAP)
+		return false;
+	uint32_t size = mp_decode_map(&data);
+	for (uint32_t i = 0; i < size; i++) {
+		if (mp_typeof(*data) != MP_UINT)
+			return false;
+		uint64_t key = mp_decode_uint(&data);
+		if (key == IPROTO_SPACE_ID) {
+			if (mp_typeof(*data) != MP_UINT)
+				return false;
+			*space_id = mp_decode_uint(&data);
+			return true;
+		}
+		mp_next(&data);
+	}
+	return false;
+}
+
+/** Check if a row passes the scan filter. */
+static bool
+xlog_scan_match(const struct xlog_scan *scan, const struct xrow_header *row)
+{
+	if (scan->type_mask != 0 &&
+	    (row->type >= 64 || (scan->type_mask & (1ULL << row->type)) == 0))
+		return false;
+	if (scan->space_ids == NULL)
+		return true;
+	uint32_t space_id;
+	if (!xlog_scan_row_space_id(row, &space_id))
+		return false;
+	return bsearch(&space_id, scan->space_ids, scan->space_id_count,
+		       sizeof(*scan->space_ids),
+		       xlog_scan_space_id_cmp) != NULL;
+}
+
+static void
+xlog_scan_thread_close(struct xlog_scan_thread *thread)
+{
+	if (thread->part != NULL)
+		xlog_cursor_close(&thread->cursor, false);
+	thread->part = NULL;
+}
+
+/**
+ * Position the cursor at the first tx block beginning in the
+ * part. The tx magic may occur inside tx data, so a block that
+ * fails to load is skipped.
+ *
+ * @retval 0 success
+ * @retval 1 no tx block begins in the part
+ * @retval -1 error
+ */
+static int
+xlog_scan_thread_seek(struct xlog_scan_thread *thread)
+{
+	struct xlog_cursor *cursor = &thread->cursor;
+	struct xlog_scan_part *part = thread->part;
+	/* The search for the magic starts from the next byte. */
+	xlog_cursor_seek_offset(cursor, part->begin - 1);
+	while (true) {
+		int rc = xlog_cursor_find_tx_magic(cursor);
+		if (rc != 0)
+			return rc;
+		if (xlog_cursor_pos(cursor) >= part->end)
+			return 1;
+		rc = xlog_cursor_next_tx(cursor);
+		if (rc == 0)
+			return 0;
+		if (rc > 0) {
+			if (xlog_cursor_is_eof(cursor))
+				return 1;
+			/* A false block running past the end of file. */
+			continue;
+		}
+		struct error *e = diag_last_error(diag_get());
+		if (e->type != &type_XlogError)
+			return -1;
+		diag_clear(diag_get());
+	}
+}
+
+/**
+ * Open the next part not taken by other threads.
+ * Leaves thread->part NULL if there are no more parts.
+ */
+static int
+xlog_scan_thread_open(struct xlog_scan_thread *thread)
+{
+	struct xlog_scan *scan = thread->scan;
+	struct xlog_cursor *cursor = &thread->cursor;
+	while (true) {
+		int idx = pm_atomic_fetch_add(&scan->next_part, 1);
+		if (idx >= scan->part_count)
+			return 0;
+		struct xlog_scan_part *part = &scan->parts[idx];
+		if (xlog_cursor_open(cursor, part->filename) != 0)
+			return -1;
+		thread->part = part;
+		if (part->begin == 0)
+			return 0;
+		/*
+		 * The vclock of a cursor started in the middle
+		 * of a file is unknown, don't index it.
+		 */
+		cursor->is_indexed = false;
+		int rc = xlog_scan_thread_seek(thread);
+		if (rc < 0)
+			return -1;
+		if (rc == 0)
+			return 0;
+		xlog_scan_thread_close(thread);
+	}
+}
+
+/**
+ * Read the next row of the current part. On success @a begin
+ * and @a end point to the raw row in the tx cursor buffer.
+ *
+ * @retval 0 success
+ * @retval 1 end of the part
+ * @retval -1 error
+ */
+static int
+xlog_scan_thread_next_row(struct xlog_scan_thread *thread,
+			  struct xrow_header *row,
+			  const char **begin, const char **end)
+{
+	struct xlog_cursor *cursor = &thread->cursor;
+	struct ibuf *rows = &cursor->tx_cursor.rows;
+	while (true) {
+		if (cursor->state == XLOG_CURSOR_TX) {
+			*begin = rows->rpos;
+			int rc = xlog_cursor_next_row(cursor, row);
+			if (rc == 0) {
+				*end = rows->rpos;
+				return 0;
+			}
+			if (rc < 0)
+				return -1;
+		}
+		/* Tx blocks beginning past the end are another part's. */
+		if (xlog_cursor_pos(cursor) >= thread->part->end)
+			return 1;
+		int rc = xlog_cursor_next_tx(cursor);
+		if (rc != 0)
+			return rc;
+	}
+}
+
+/** Append a raw row prefixed with its size to a batch. */
+static int
+xlog_scan_batch_add_row(struct xlog_scan_batch *batch,
+			const char *begin, const char *end)
+{
+	uint32_t len = end - begin;
+	size_t size = mp_sizeof_uint(len) + len;
+	if (batch->data_size + size > batch->data_capacity) {
+		size_t capacity = MAX(batch->data_capacity * 2,
+				      batch->data_size + size);
+		char *data = realloc(batch->data, capacity);
+		if (data == NULL) {
+			diag_set(OutOfMemory, capacity, "realloc",
+				 "xlog scan batch");
+			return -1;
+		}
+		batch->data = data;
+		batch->data_capacity = capacity;
+	}
+	char *data = mp_encode_uint(batch->data + batch->data_size, len);
+	memcpy(data, begin, len);
+	batch->data_size += size;
+	batch->row_count++;
+	return 0;
+}
+
+/** Fill a batch with rows, called in a scan thread. */
+static void
+xlog_scan_batch_read(struct cmsg *m)
+{
+	struct xlog_scan_batch *batch = (struct xlog_scan_batch *)m;
+	struct xlog_scan_thread *thread = batch->thread;
+	struct xlog_scan *scan = thread->scan;
+	batch->row_count = 0;
+	batch->data_size = 0;
+	batch->filename = NULL;
+	while (batch->row_count < XLOG_SCAN_BATCH_ROWS_MAX &&
+	       batch->data_size < XLOG_SCAN_BATCH_SIZE_MAX) {
+		if (thread->part == NULL) {
+			/* Rows of a batch come from one file. */
+			if (batch->row_count > 0 || thread->is_done)
+				break;
+			if (xlog_scan_thread_open(thread) != 0)
+				goto fail;
+			if (thread->part == NULL) {
+				thread->is_done = true;
+				break;
+			}
+		}
+		batch->filename = thread->part->filename;
+		struct xrow_header row;
+		const char *begin, *end;
+		int rc = xlog_scan_thread_next_row(thread, &row, &begin, &end);
+		if (rc < 0)
+			goto fail;
+		if (rc > 0) {
+			xlog_scan_thread_close(thread);
+			continue;
+		}
+		if (!xlog_scan_match(scan, &row))
+			continue;
+		if (xlog_scan_batch_add_row(batch, begin, end) != 0)
+			goto fail;
+	}
+	batch->is_eof = batch->row_count == 0;
+	return;
+fail:
+	diag_move(diag_get(), &batch->diag);
+	xlog_scan_thread_close(thread);
+	thread->is_done = true;
+}
+
+/** Called in tx when a batch is back from a scan thread. */
+static void
+xlog_scan_batch_complete(struct cmsg *m)
+{
+	struct xlog_scan_batch *batch = (struct xlog_scan_batch *)m;
+	struct xlog_scan *scan = batch->thread->scan;
+	batch->thread->in_flight--;
+	stailq_add_tail_entry(&scan->ready, batch, in_ready);
+	fiber_cond_signal(&scan->cond);
+}
+
+/** Send a batch to its thread to be filled with rows. */
+static void
+xlog_scan_batch_request(struct xlog_scan_batch *batch)
+{
+	struct xlog_scan_thread *thread = batch->thread;
+	thread->in_flight++;
+	batch->is_eof = false;
+	cmsg_init(&batch->base, thread->route);
+	cpipe_push(&thread->thread_pipe, &batch->base);
+}
+
+/** Scan thread function. */
+static int
+xlog_scan_thread_f(va_list ap)
+{
+	struct xlog_scan_thread *thread = va_arg(ap, struct xlog_scan_thread *);
+	struct cbus_endpoint endpoint;
+
+	cpipe_create(&thread->tx_pipe, thread->scan->endpoint.name);
+	cbus_endpoint_create(&endpoint, cord_name(cord()),
+			     fiber_schedule_cb, fiber());
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	cpipe_destroy(&thread->tx_pipe);
+	xlog_scan_thread_close(thread);
+	return 0;
+}
+
+/**
+ * Process batches coming back from the scan threads. Scans are
+ * used by offline tools, which don't have the tx endpoints set
+ * up by box.cfg(), so each scan has an endpoint of its own.
+ */
+static void
+xlog_scan_endpoint_cb(struct ev_loop *loop, ev_watcher *watcher, int events)
+{
+	(void)loop;
+	(void)events;
+	cbus_process((struct cbus_endpoint *)watcher->data);
+}
+
+/** Split the files into parts, one per part_size bytes. */
+static int
+xlog_scan_make_parts(struct xlog_scan *scan, int64_t part_size)
+{
+	int capacity = 0;
+	for (int i = 0; i < scan->file_count; i++) {
+		const char *filename = scan->filenames[i];
+		struct stat st;
+		if (stat(filename, &st) != 0) {
+			diag_set(SystemError, "failed to stat file '%s'",
+				 filename);
+			return -1;
+		}
+		int64_t count = 1;
+		if (part_size > 0)
+			count = MAX(DIV_ROUND_UP((int64_t)st.st_size,
+						 part_size), 1);
+		if (scan->part_count + count > capacity) {
+			capacity = MAX(capacity * 2, scan->part_count + count);
+			size_t size = capacity * sizeof(*scan->parts);
+			struct xlog_scan_part *parts = realloc(scan->parts,
+							       size);
+			if (parts == NULL) {
+				diag_set(OutOfMemory, size, "realloc",
+					 "xlog scan parts");
+				return -1;
+			}
+			scan->parts = parts;
+		}
+		for (int64_t j = 0; j < count; j++) {
+			struct xlog_scan_part *part =
+				&scan->parts[scan->part_count++];
+			part->filename = filename;
+			part->begin = j * part_size;
+			/* The file may grow while it is scanned. */
+			part->end = j == count - 1 ? INT64_MAX :
+				    (j + 1) * part_size;
+		}
+	}
+	return 0;
+}
+
+static void
+xlog_scan_free(struct xlog_scan *scan)
+{
+	if (scan->has_endpoint)
+		cbus_endpoint_destroy(&scan->endpoint, cbus_process);
+	for (int i = 0; i < scan->thread_count; i++) {
+		struct xlog_scan_thread *thread = &scan->threads[i];
+		for (int j = 0; j < XLOG_SCAN_BATCH_COUNT; j++) {
+			free(thread->batches[j].data);
+			diag_destroy(&thread->batches[j].diag);
+		}
+	}
+	for (int i = 0; i < scan->file_count; i++)
+		free(scan->filenames[i]);
+	fiber_cond_destroy(&scan->cond);
+	free(scan->filenames);
+	free(scan->parts);
+	free(scan->space_ids);
+	free(scan->threads);
+	free(scan);
+}
+
+/** Stop and join the first @a count scan threads. */
+static void
+xlog_scan_stop_threads(struct xlog_scan *scan, int count)
+{
+	/* Joining a thread clears the diagnostics area. */
+	struct diag diag;
+	diag_create(&diag);
+	diag_move(diag_get(), &diag);
+	for (int i = 0; i < count; i++) {
+		struct xlog_scan_thread *thread = &scan->threads[i];
+		cbus_stop_loop(&thread->thread_pipe);
+		cpipe_destroy(&thread->thread_pipe);
+		if (cord_cojoin(&thread->cord) != 0)
+			panic("failed to join xlog scan thread");
+	}
+	diag_move(&diag, diag_get());
+	diag_destroy(&diag);
+}
+
+struct xlog_scan *
+xlog_scan_new(const char **filenames, int file_count,
+	      const struct xlog_scan_opts *opts)
+{
+	assert(cord_is_main());
+	if (opts->thread_count <= 0) {
+		diag_set(IllegalParams, "thread count must be positive");
+		return NULL;
+	}
+	struct xlog_scan *scan = calloc(1, sizeof(*scan));
+	if (scan == NULL) {
+		diag_set(OutOfMemory, sizeof(*scan), "calloc",
+			 "struct xlog_scan");
+		return NULL;
+	}
+	fiber_cond_create(&scan->cond);
+	stailq_create(&scan->ready);
+	scan->type_mask = opts->type_mask;
+
+	size_t size;
+	if (opts->space_ids != NULL) {
+		size = MAX(opts->space_id_count, 1) * sizeof(uint32_t);
+		scan->space_ids = malloc(size);
+		if (scan->space_ids == NULL) {
+			diag_set(OutOfMemory, size, "malloc", "space ids");
+			goto fail;
+		}
+		memcpy(scan->space_ids, opts->space_ids,
+		       opts->space_id_count * sizeof(uint32_t));
+		scan->space_id_count = opts->space_id_count;
+		qsort(scan->space_ids, scan->space_id_count,
+		      sizeof(uint32_t), xlog_scan_space_id_cmp);
+	}
+
+	size = MAX(file_count, 1) * sizeof(*scan->filenames);
+	scan->filenames = calloc(1, size);
+	if (scan->filenames == NULL) {
+		diag_set(OutOfMemory, size, "calloc", "file names");
+		goto fail;
+	}
+	for (int i = 0; i < file_count; i++) {
+		scan->filenames[i] = strdup(filenames[i]);
+		if (scan->filenames[i] == NULL) {
+			diag_set(OutOfMemory, strlen(filenames[i]) + 1,
+				 "strdup", "file name");
+			goto fail;
+		}
+		scan->file_count++;
+	}
+	if (xlog_scan_make_parts(scan, opts->part_size) != 0)
+		goto fail;
+
+	/* No point in having threads without parts to scan. */
+	int thread_count = MIN(opts->thread_count, MAX(scan->part_count, 1));
+	size = thread_count * sizeof(*scan->threads);
+	scan->threads = calloc(1, size);
+	if (scan->threads == NULL) {
+		diag_set(OutOfMemory, size, "calloc", "xlog scan threads");
+		goto fail;
+	}
+	scan->thread_count = thread_count;
+	for (int i = 0; i < thread_count; i++) {
+		struct xlog_scan_thread *thread = &scan->threads[i];
+		thread->scan = scan;
+		thread->route[0].f = xlog_scan_batch_read;
+		thread->route[0].pipe = &thread->tx_pipe;
+		thread->route[1].f = xlog_scan_batch_complete;
+		thread->route[1].pipe = NULL;
+		for (int j = 0; j < XLOG_SCAN_BATCH_COUNT; j++) {
+			thread->batches[j].thread = thread;
+			diag_create(&thread->batches[j].diag);
+		}
+	}
+
+	unsigned id = ++xlog_scan_id;
+	char name[FIBER_NAME_MAX];
+	snprintf(name, sizeof(name), "xlog.scan.%u", id);
+	if (cbus_endpoint_create(&scan->endpoint, name,
+				 xlog_scan_endpoint_cb, &scan->endpoint) != 0) {
+		diag_set(IllegalParams, "cbus endpoint '%s' exists", name);
+		goto fail;
+	}
+	scan->has_endpoint = true;
+
+	for (int i = 0; i < thread_count; i++) {
+		struct xlog_scan_thread *thread = &scan->threads[i];
+		snprintf(name, sizeof(name), "xlog.scan.%u.%d", id, i);
+		if (cord_costart(&thread->cord, name,
+				 xlog_scan_thread_f, thread) != 0) {
+			xlog_scan_stop_threads(scan, i);
+			goto fail;
+		}
+		cpipe_create(&thread->thread_pipe, name);
+	}
+	for (int i = 0; i < thread_count; i++) {
+		struct xlog_scan_thread *thread = &scan->threads[i];
+		for (int j = 0; j < XLOG_SCAN_BATCH_COUNT; j++)
+			xlog_scan_batch_request(&thread->batches[j]);
+	}
+	scan->active_thread_count = thread_count;
+	return scan;
+fail:
+	xlog_scan_free(scan);
+	return NULL;
+}
+
+void
+xlog_scan_delete(struct xlog_scan *scan)
+{
+	/* Wait for batches in flight before stopping the threads. */
+	for (int i = 0; i < scan->thread_count; i++) {
+		while (scan->threads[i].in_flight > 0)
+			fiber_cond_wait(&scan->cond);
+	}
+	xlog_scan_stop_threads(scan, scan->thread_count);
+	xlog_scan_free(scan);
+}
+
+int
+xlog_scan_next(struct xlog_scan *scan, struct xlog_scan_rows *rows)
+{
+	struct xlog_scan_batch *batch = scan->batch;
+	if (batch != NULL) {
+		/* Done with the batch, let it be refilled. */
+		scan->batch = NULL;
+		xlog_scan_batch_request(batch);
+	}
+	while (!scan->is_failed) {
+		if (stailq_empty(&scan->ready)) {
+			if (scan->active_thread_count == 0)
+				break;
+			fiber_cond_wait(&scan->cond);
+			continue;
+		}
+		batch = stailq_shift_entry(&scan->ready,
+					   struct xlog_scan_batch, in_ready);
+		struct xlog_scan_thread *thread = batch->thread;
+		if (!diag_is_empty(&batch->diag)) {
+			diag_move(&batch->diag, diag_get());
+			scan->is_failed = true;
+			return -1;
+		}
+		if (batch->is_eof) {
+			/* Later batches of the thread are empty too. */
+			if (!thread->is_eof) {
+				thread->is_eof = true;
+				scan->active_thread_count--;
+			}
+			continue;
+		}
+		scan->batch = batch;
+		rows->filename = batch->filename;
+		rows->data = batch->data;
+		rows->data_end = batch->data + batch->data_size;
+		rows->count = batch->row_count;
+		return 0;
+	}
+	return 1;
+}
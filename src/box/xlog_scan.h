@@ -0,0 +1,130 @@
+#ifndef TARANTOOL_BOX_XLOG_SCAN_H_INCLUDED
+#define TARANTOOL_BOX_XLOG_SCAN_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct xlog_scan;
+
+/** Options of a parallel scan of xlog files. */
+struct xlog_scan_opts {
+	/** Number of scan threads. */
+	int thread_count;
+	/**
+	 * Files larger than this are split into parts of about
+	 * this size, which are scanned by different threads.
+	 * 0 means don't split files.
+	 */
+	int64_t part_size;
+	/**
+	 * Bit mask of types of rows to return, (1ULL << type).
+	 * Rows of types above 63 are skipped unless the mask
+	 * is 0, which means rows of any type.
+	 */
+	uint64_t type_mask;
+	/**
+	 * Ids of spaces to return rows of. Rows without a space
+	 * id are skipped. NULL means rows of any space.
+	 */
+	const uint32_t *space_ids;
+	/** Number of entries in space_ids. */
+	int space_id_count;
+};
+
+/** Initialize scan options with default values. */
+void
+xlog_scan_opts_create(struct xlog_scan_opts *opts);
+
+/** A batch of rows returned by xlog_scan_next(). */
+struct xlog_scan_rows {
+	/** Name of the file the rows were read from. */
+	const char *filename;
+	/**
+	 * Rows in the order they are stored in the file. Each
+	 * row is its size encoded as MP_UINT followed by the
+	 * row header and body MsgPack as stored in the file.
+	 */
+	const char *data;
+	/** End of the row data. */
+	const char *data_end;
+	/** Number of rows. */
+	int count;
+};
+
+/**
+ * Start scanning the given xlog files in separate threads.
+ *
+ * Each thread takes a file or a part of a file at a time,
+ * reads and decompresses its tx blocks and passes the rows
+ * matching the filter of @a opts to the caller in batches,
+ * without decoding row bodies. A part of a file begins with
+ * the first tx block found at its offset by the tx magic.
+ *
+ * The batches of different files and parts come in no
+ * particular order. Must be called from the main cord.
+ *
+ * @param filenames paths to the files
+ * @param file_count number of files
+ * @param opts scan options
+ * @retval NULL on error, check diag
+ */
+struct xlog_scan *
+xlog_scan_new(const char **filenames, int file_count,
+	      const struct xlog_scan_opts *opts);
+
+/**
+ * Stop the scan threads and free the scan.
+ * Doesn't touch the diagnostics area of the caller.
+ */
+void
+xlog_scan_delete(struct xlog_scan *scan);
+
+/**
+ * Fetch the next batch of rows. The rows stay valid until
+ * the next call. Yields while the scan threads are behind.
+ *
+ * @retval 0 success
+ * @retval 1 no more rows
+ * @retval -1 error, check diag
+ */
+int
+xlog_scan_next(struct xlog_scan *scan, struct xlog_scan_rows *rows);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_XLOG_SCAN_H_INCLUDED */
@@ -36,6 +36,7 @@
 #include "third_party/base64.h"
 
 #include "fiber.h"
+#include "mp_scan.h"
 #include "version.h"
 
 #include "error.h"
@@ -88,10 +89,98 @@ mp_decode_vclock(const char **data, struct vclock *vclock)
 	return 0;
 }
 
+/**
+ * Header layout of WAL and relay rows as produced by
+ * xrow_header_encode() with zero sync and group id:
+ *
+ *   0x84 IPROTO_REQUEST_TYPE <fixuint> IPROTO_REPLICA_ID <fixuint>
+ *   IPROTO_LSN <uint> IPROTO_TIMESTAMP 0xcb <double>
+ *
+ * The first four bytes are matched with a single load: the mask
+ * lets the request type byte through, provided it is a fixuint.
+ */
+#define XROW_ROW_HEADER_WORD \
+	(0x84000000u | (IPROTO_REQUEST_TYPE << 16) | IPROTO_REPLICA_ID)
+#define XROW_ROW_HEADER_MASK 0xffff80ffu
+#define XROW_ROW_TIMESTAMP_WORD ((IPROTO_TIMESTAMP << 8) | 0xcb)
+/** Row header size with the shortest possible LSN. */
+#define XROW_ROW_HEADER_LEN_MIN (4 + 2 + 1 + 2 + (int)sizeof(double))
+
+static_assert(IPROTO_REQUEST_TYPE < 0x80 && IPROTO_SYNC < 0x80 &&
+	      IPROTO_REPLICA_ID < 0x80 && IPROTO_LSN < 0x80 &&
+	      IPROTO_TIMESTAMP < 0x80, "header keys must fit into "\
+	      "one byte");
+
+/**
+ * Decode a header that has one of the layouts dominating real
+ * traffic without going through the generic key loop:
+ *
+ *  - WAL and relay rows, see XROW_ROW_HEADER_WORD;
+ *  - iproto requests, {IPROTO_SYNC, IPROTO_REQUEST_TYPE} in
+ *    either order, as sent by net.box and connectors.
+ *
+ * All bounds are checked here, so the header doesn't need to be
+ * validated with mp_check() beforehand.
+ *
+ * Return true and advance @a pos past the header on success.
+ * Return false and leave @a pos intact if the header has some
+ * other layout or is truncated. In this case the caller falls
+ * back to the generic decoder, which also reports errors.
+ */
+static inline bool
+xrow_header_decode_fast(struct xrow_header *header, const char **pos,
+			const char *end)
+{
+	const char *p = *pos;
+	if (end - p >= XROW_ROW_HEADER_LEN_MIN) {
+		uint32_t word = mp_load_u32(&p);
+		if ((word & XROW_ROW_HEADER_MASK) != XROW_ROW_HEADER_WORD)
+			goto request;
+		if ((uint8_t)p[0] >= 0x80 || p[1] != IPROTO_LSN)
+			return false;
+		header->type = (word >> 8) & 0xff;
+		header->replica_id = (uint8_t)p[0];
+		p += 2;
+		if (mp_typeof(*p) != MP_UINT || mp_check_uint(p, end) > 0)
+			return false;
+		header->lsn = mp_decode_uint(&p);
+		if (end - p < (int)(2 + sizeof(double)) ||
+		    mp_load_u16(&p) != XROW_ROW_TIMESTAMP_WORD)
+			return false;
+		header->tm = mp_load_double(&p);
+		*pos = p;
+		return true;
+	}
+request:
+	p = *pos;
+	if (p == end || (uint8_t)*p != 0x82)
+		return false;
+	p++;
+	for (int i = 0; i < 2; i++) {
+		if (end - p < 2)
+			return false;
+		uint8_t key = *p++;
+		if (mp_typeof(*p) != MP_UINT || mp_check_uint(p, end) > 0)
+			return false;
+		if (key == IPROTO_SYNC)
+			header->sync = mp_decode_uint(&p);
+		else if (key == IPROTO_REQUEST_TYPE)
+			header->type = mp_decode_uint(&p);
+		else
+			return false;
+	}
+	*pos = p;
+	return true;
+}
+
 int
 xrow_header_decode(struct xrow_header *header, const char **pos,
 		   const char *end)
 {
+	memset(header, 0, sizeof(struct xrow_header));
+	if (xrow_header_decode_fast(header, pos, end))
+		goto body;
+	/* The fast path may have filled some fields. */
 	memset(header, 0, sizeof(struct xrow_header));
 	const char *tmp = *pos;
 	if (mp_check(&tmp, end) != 0) {
@@ -133,11 +222,19 @@ error:
 		case IPROTO_SCHEMA_VERSION:
 			header->schema_version = mp_decode_uint(pos);
 			break;
+		case IPROTO_PRIORITY:
+			header->priority = mp_decode_uint(pos);
+			break;
+		case IPROTO_WAIT_VCLOCK:
+			header->wait_vclock = *pos;
+			mp_next(pos);
+			break;
 		default:
 			/* unknown header */
 			mp_next(pos);
 		}
 	}
+body:
 	assert(*pos <= end);
 	/* Nop requests aren't supposed to have a body. */
 	if (*pos < end && header->type != IPROTO_NOP) {
@@ -186,7 +283,25 @@ xrow_header_encode(const struct xrow_header *header, uint64_t sync,
 	char *data = (char *) out->iov_base + fixheader_len;
 
 	/* Header */
-	char *d = data + 1; /* Skip 1 byte for MP_MAP */
+	char *d;
+	if (sync == 0 && header->group_id == 0 && header->type < 0x80 &&
+	    header->replica_id != 0 && header->replica_id < 0x80 &&
+	    header->lsn != 0 && header->tm != 0) {
+		/*
+		 * A WAL or relay row: fill in the template
+		 * recognized by xrow_header_decode_fast().
+		 */
+		d = mp_store_u32(data, XROW_ROW_HEADER_WORD |
+				 (header->type << 8));
+		*d++ = header->replica_id;
+		*d++ = IPROTO_LSN;
+		d = mp_encode_uint(d, header->lsn);
+		d = mp_store_u16(d, XROW_ROW_TIMESTAMP_WORD);
+		d = mp_store_double(d, header->tm);
+		assert(d <= data + XROW_HEADER_LEN_MAX);
+		goto done;
+	}
+	d = data + 1; /* Skip 1 byte for MP_MAP */
 	int map_size = 0;
 	if (true) {
 		d = mp_encode_uint(d, IPROTO_REQUEST_TYPE);
@@ -225,6 +340,7 @@ xrow_header_encode(const struct xrow_header *header, uint64_t sync,
 	}
 	assert(d <= data + XROW_HEADER_LEN_MAX);
 	mp_encode_map(data, map_size);
+done:
 	out->iov_len = d - (char *) out->iov_base;
 	out++;
 
@@ -353,10 +469,11 @@ iproto_reply_vote(struct obuf *out, const struct ballot *ballot,
 		  uint64_t sync, uint32_t schema_version)
 {
 	size_t max_size = IPROTO_HEADER_LEN + mp_sizeof_map(1) +
-		mp_sizeof_uint(UINT32_MAX) + mp_sizeof_map(3) +
+		mp_sizeof_uint(UINT32_MAX) + mp_sizeof_map(4) +
 		mp_sizeof_uint(UINT32_MAX) + mp_sizeof_bool(ballot->is_ro) +
 		mp_sizeof_uint(UINT32_MAX) + mp_sizeof_vclock(&ballot->vclock) +
-		mp_sizeof_uint(UINT32_MAX) + mp_sizeof_vclock(&ballot->gc_vclock);
+		mp_sizeof_uint(UINT32_MAX) + mp_sizeof_vclock(&ballot->gc_vclock) +
+		mp_sizeof_uint(UINT32_MAX) + mp_sizeof_uint(UINT32_MAX);
 
 	char *buf = obuf_reserve(out, max_size);
 	if (buf == NULL) {
@@ -368,13 +485,15 @@ iproto_reply_vote(struct obuf *out, const struct ballot *ballot,
 	char *data = buf + IPROTO_HEADER_LEN;
 	data = mp_encode_map(data, 1);
 	data = mp_encode_uint(data, IPROTO_BALLOT);
-	data = mp_encode_map(data, 3);
+	data = mp_encode_map(data, 4);
 	data = mp_encode_uint(data, IPROTO_BALLOT_IS_RO);
 	data = mp_encode_bool(data, ballot->is_ro);
 	data = mp_encode_uint(data, IPROTO_BALLOT_VCLOCK);
 	data = mp_encode_vclock(data, &ballot->vclock);
 	data = mp_encode_uint(data, IPROTO_BALLOT_GC_VCLOCK);
 	data = mp_encode_vclock(data, &ballot->gc_vclock);
+	data = mp_encode_uint(data, IPROTO_BALLOT_RELAY_COUNT);
+	data = mp_encode_uint(data, ballot->relay_count);
 	size_t size = data - buf;
 	assert(size <= max_size);
 
@@ -446,18 +565,57 @@ iproto_prepare_header(struct obuf *buf, struct obuf_svp *svp, size_t size)
 }
 
 void
-iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
-		    uint32_t schema_version, uint32_t count)
+iproto_encode_select_header(char *buf, uint64_t sync, uint32_t schema_version,
+			    uint32_t count, uint32_t data_size)
 {
-	char *pos = (char *) obuf_svp_to_ptr(buf, svp);
-	iproto_header_encode(pos, IPROTO_OK, sync, schema_version,
-			        obuf_size(buf) - svp->used -
-				IPROTO_HEADER_LEN);
+	iproto_header_encode(buf, IPROTO_OK, sync, schema_version,
+			     sizeof(struct iproto_body_bin) + data_size);
 
 	struct iproto_body_bin body = iproto_body_bin;
 	body.v_data_len = mp_bswap_u32(count);
 
-	memcpy(pos + IPROTO_HEADER_LEN, &body, sizeof(body));
+	memcpy(buf + IPROTO_HEADER_LEN, &body, sizeof(body));
+}
+
+void
+iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
+		    uint32_t schema_version, uint32_t count)
+{
+	char *pos = (char *) obuf_svp_to_ptr(buf, svp);
+	iproto_encode_select_header(pos, sync, schema_version, count,
+				    obuf_size(buf) - svp->used -
+				    IPROTO_SELECT_HEADER_LEN);
+}
+
+/**
+ * Decode IPROTO_OPTIONS of an SQL request. Options unknown to
+ * this version are ignored, and so is anything but a map, e.g.
+ * an empty array sent by clients for an empty Lua table.
+ */
+static int
+xrow_decode_sql_options(const char *data, struct sql_request *request)
+{
+	if (mp_typeof(*data) != MP_MAP)
+		return 0;
+	uint32_t map_size = mp_decode_map(&data);
+	for (uint32_t i = 0; i < map_size; ++i) {
+		if (mp_typeof(*data) != MP_UINT) {
+			mp_next(&data);
+			mp_next(&data);
+			continue;
+		}
+		if (mp_decode_uint(&data) != IPROTO_SQL_OPT_CHUNK_SIZE) {
+			mp_next(&data);
+			continue;
+		}
+		if (mp_typeof(*data) != MP_UINT)
+			return -1;
+		uint64_t chunk_size = mp_decode_uint(&data);
+		if (chunk_size > UINT32_MAX)
+			return -1;
+		request->chunk_size = chunk_size;
+	}
+	return 0;
 }
 
 int
@@ -481,9 +639,12 @@ error:
 	uint32_t map_size = mp_decode_map(&data);
 	request->sql_text = NULL;
 	request->bind = NULL;
+	request->stmt_id = 0;
+	request->chunk_size = 0;
 	for (uint32_t i = 0; i < map_size; ++i) {
 		uint8_t key = *data;
-		if (key != IPROTO_SQL_BIND && key != IPROTO_SQL_TEXT) {
+		if (key != IPROTO_SQL_BIND && key != IPROTO_SQL_TEXT &&
+		    key != IPROTO_STMT_ID && key != IPROTO_OPTIONS) {
 			mp_check(&data, end);   /* skip the key */
 			mp_check(&data, end);   /* skip the value */
 			continue;
@@ -491,12 +652,23 @@ error:
 		const char *value = ++data;     /* skip the key */
 		if (mp_check(&data, end) != 0)  /* check the value */
 			goto error;
-		if (key == IPROTO_SQL_BIND)
+		if (key == IPROTO_SQL_BIND) {
 			request->bind = value;
-		else
+		} else if (key == IPROTO_SQL_TEXT) {
 			request->sql_text = value;
+		} else if (key == IPROTO_OPTIONS) {
+			if (xrow_decode_sql_options(value, request) != 0)
+				goto error;
+		} else {
+			if (mp_typeof(*value) != MP_UINT)
+				goto error;
+			uint64_t id = mp_decode_uint(&value);
+			if (id == 0 || id > UINT32_MAX)
+				goto error;
+			request->stmt_id = id;
+		}
 	}
-	if (request->sql_text == NULL) {
+	if (request->sql_text == NULL && request->stmt_id == 0) {
 		diag_set(ClientError, ER_MISSING_REQUEST_FIELD,
 			 iproto_key_name(IPROTO_SQL_TEXT));
 		return -1;
@@ -559,7 +731,7 @@ error:
 		}
 		uint64_t key = mp_decode_uint(&data);
 		const char *value = data;
-		if (mp_check(&data, end) ||
+		if (mp_check_fast(&data, end) ||
 		    key >= IPROTO_KEY_MAX ||
 		    iproto_key_type[key] != mp_typeof(*value))
 			goto error;
@@ -878,6 +1050,53 @@ error:
 	return 0;
 }
 
+int
+xrow_decode_compress(const struct xrow_header *row, uint32_t *threshold)
+{
+	if (row->bodycnt == 0) {
+		diag_set(ClientError, ER_INVALID_MSGPACK,
+			 "missing request body");
+		return -1;
+	}
+	assert(row->bodycnt == 1);
+	const char *data = (const char *) row->body[0].iov_base;
+	const char *end = data + row->body[0].iov_len;
+	assert((end - data) > 0);
+
+	if (mp_typeof(*data) != MP_MAP || mp_check_map(data, end) > 0) {
+error:
+		diag_set(ClientError, ER_INVALID_MSGPACK, "packet body");
+		return -1;
+	}
+	bool is_set = false;
+	uint32_t map_size = mp_decode_map(&data);
+	for (uint32_t i = 0; i < map_size; ++i) {
+		if ((end - data) < 1 || mp_typeof(*data) != MP_UINT)
+			goto error;
+		uint64_t key = mp_decode_uint(&data);
+		const char *value = data;
+		if (mp_check(&data, end) != 0)
+			goto error;
+		if (key != IPROTO_COMPRESSION)
+			continue; /* unknown key */
+		if (mp_typeof(*value) != MP_UINT)
+			goto error;
+		uint64_t v = mp_decode_uint(&value);
+		*threshold = v > UINT32_MAX ? UINT32_MAX : v;
+		is_set = true;
+	}
+	if (data != end) {
+		diag_set(ClientError, ER_INVALID_MSGPACK, "packet end");
+		return -1;
+	}
+	if (!is_set) {
+		diag_set(ClientError, ER_MISSING_REQUEST_FIELD,
+			 iproto_key_name(IPROTO_COMPRESSION));
+		return -1;
+	}
+	return 0;
+}
+
 int
 xrow_encode_auth(struct xrow_header *packet, const char *salt, size_t salt_len,
 		 const char *login, size_t login_len,
@@ -967,6 +1186,7 @@ int
 xrow_decode_ballot(struct xrow_header *row, struct ballot *ballot)
 {
 	ballot->is_ro = false;
+	ballot->relay_count = 0;
 	vclock_create(&ballot->vclock);
 
 	if (row->bodycnt == 0)
@@ -1016,6 +1236,11 @@ xrow_decode_ballot(struct xrow_header *row, struct ballot *ballot)
 			if (mp_decode_vclock(&data, &ballot->gc_vclock) != 0)
 				goto err;
 			break;
+		case IPROTO_BALLOT_RELAY_COUNT:
+			if (mp_typeof(*data) != MP_UINT)
+				goto err;
+			ballot->relay_count = mp_decode_uint(&data);
+			break;
 		default:
 			mp_next(&data);
 		}
@@ -1030,7 +1255,8 @@ int
 xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
-		      const struct vclock *vclock)
+		      const struct vclock *vclock, bool compress,
+		      bool is_anon)
 {
 	memset(row, 0, sizeof(*row));
 	size_t size = XROW_BODY_LEN_MAX + mp_sizeof_vclock(vclock);
@@ -1040,7 +1266,7 @@ xrow_encode_subscribe(struct xrow_header *row,
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 4);
+	data = mp_encode_map(data, 4 + compress + is_anon);
 	data = mp_encode_uint(data, IPROTO_CLUSTER_UUID);
 	data = xrow_encode_uuid(data, replicaset_uuid);
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
@@ -1049,6 +1275,14 @@ xrow_encode_subscribe(struct xrow_header *row,
 	data = mp_encode_vclock(data, vclock);
 	data = mp_encode_uint(data, IPROTO_SERVER_VERSION);
 	data = mp_encode_uint(data, tarantool_version_id());
+	if (compress) {
+		data = mp_encode_uint(data, IPROTO_COMPRESSION);
+		data = mp_encode_bool(data, true);
+	}
+	if (is_anon) {
+		data = mp_encode_uint(data, IPROTO_REPLICA_ANON);
+		data = mp_encode_bool(data, true);
+	}
 	assert(data <= buf + size);
 	row->body[0].iov_base = buf;
 	row->body[0].iov_len = (data - buf);
@@ -1060,7 +1294,7 @@ xrow_encode_subscribe(struct xrow_header *row,
 int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
-		      uint32_t *version_id)
+		      uint32_t *version_id, bool *compress, bool *is_anon)
 {
 	if (row->bodycnt == 0) {
 		diag_set(ClientError, ER_INVALID_MSGPACK, "request body");
@@ -1116,6 +1350,26 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 			}
 			*version_id = mp_decode_uint(&d);
 			break;
+		case IPROTO_COMPRESSION:
+			if (compress == NULL)
+				goto skip;
+			if (mp_typeof(*d) != MP_BOOL) {
+				diag_set(ClientError, ER_INVALID_MSGPACK,
+					 "invalid COMPRESSION");
+				return -1;
+			}
+			*compress = mp_decode_bool(&d);
+			break;
+		case IPROTO_REPLICA_ANON:
+			if (is_anon == NULL)
+				goto skip;
+			if (mp_typeof(*d) != MP_BOOL) {
+				diag_set(ClientError, ER_INVALID_MSGPACK,
+					 "invalid REPLICA_ANON");
+				return -1;
+			}
+			*is_anon = mp_decode_bool(&d);
+			break;
 		default: skip:
 			mp_next(&d); /* value */
 		}
@@ -1123,28 +1377,240 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 	return 0;
 }
 
+void
+cdc_filter_destroy(struct cdc_filter *filter)
+{
+	free(filter->space_ids);
+	free(filter->fields);
+	memset(filter, 0, sizeof(*filter));
+}
+
+static int
+cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+	return x < y ? -1 : x > y;
+}
+
+bool
+cdc_filter_has_space(const struct cdc_filter *filter, uint32_t space_id)
+{
+	if (filter->space_ids == NULL)
+		return true;
+	return bsearch(&space_id, filter->space_ids, filter->space_count,
+		       sizeof(space_id), cmp_u32) != NULL;
+}
+
+/**
+ * Decode an array of unsigned integers into a malloc'ed list.
+ * @a what is the error message for a malformed list.
+ */
+static int
+xrow_decode_u32_array(const char **data, uint32_t **list, uint32_t *count,
+		      const char *what)
+{
+	if (mp_typeof(**data) != MP_ARRAY)
+		goto error;
+	*count = mp_decode_array(data);
+	free(*list);
+	*list = (uint32_t *)malloc(MAX(*count, 1) * sizeof(**list));
+	if (*list == NULL) {
+		diag_set(OutOfMemory, *count * sizeof(**list), "malloc",
+			 "list");
+		return -1;
+	}
+	for (uint32_t i = 0; i < *count; i++) {
+		if (mp_typeof(**data) != MP_UINT)
+			goto error;
+		uint64_t value = mp_decode_uint(data);
+		if (value > UINT32_MAX)
+			goto error;
+		(*list)[i] = value;
+	}
+	return 0;
+error:
+	diag_set(ClientError, ER_INVALID_MSGPACK, what);
+	return -1;
+}
+
+/** Encode a list of unsigned integers as an array. */
+static char *
+xrow_encode_u32_array(char *data, const uint32_t *list, uint32_t count)
+{
+	data = mp_encode_array(data, count);
+	for (uint32_t i = 0; i < count; i++)
+		data = mp_encode_uint(data, list[i]);
+	return data;
+}
+
+int
+xrow_encode_cdc_subscribe(struct xrow_header *row, const struct vclock *vclock,
+			  const struct cdc_filter *filter)
+{
+	memset(row, 0, sizeof(*row));
+	size_t size = XROW_BODY_LEN_MAX + mp_sizeof_vclock(vclock) +
+		      (filter->space_count + filter->field_count) *
+		      mp_sizeof_uint(UINT32_MAX);
+	char *buf = (char *) region_alloc(&fiber()->gc, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "buf");
+		return -1;
+	}
+	char *data = buf;
+	data = mp_encode_map(data, 1 + (filter->space_ids != NULL) +
+			     (filter->fields != NULL));
+	data = mp_encode_uint(data, IPROTO_VCLOCK);
+	data = mp_encode_vclock(data, vclock);
+	if (filter->space_ids != NULL) {
+		data = mp_encode_uint(data, IPROTO_SPACE_IDS);
+		data = xrow_encode_u32_array(data, filter->space_ids,
+					     filter->space_count);
+	}
+	if (filter->fields != NULL) {
+		data = mp_encode_uint(data, IPROTO_FIELDS);
+		data = xrow_encode_u32_array(data, filter->fields,
+					     filter->field_count);
+	}
+	assert(data <= buf + size);
+	row->body[0].iov_base = buf;
+	row->body[0].iov_len = (data - buf);
+	row->bodycnt = 1;
+	row->type = IPROTO_CDC_SUBSCRIBE;
+	return 0;
+}
+
+int
+xrow_decode_cdc_subscribe(struct xrow_header *row, struct vclock *vclock,
+			  struct cdc_filter *filter)
+{
+	memset(filter, 0, sizeof(*filter));
+	if (row->bodycnt == 0) {
+		diag_set(ClientError, ER_INVALID_MSGPACK, "request body");
+		return -1;
+	}
+	assert(row->bodycnt == 1);
+	const char *data = (const char *) row->body[0].iov_base;
+	const char *end = data + row->body[0].iov_len;
+	const char *d = data;
+	if (mp_check(&d, end) != 0 || mp_typeof(*data) != MP_MAP) {
+		diag_set(ClientError, ER_INVALID_MSGPACK, "request body");
+		return -1;
+	}
+
+	d = data;
+	uint32_t map_size = mp_decode_map(&d);
+	for (uint32_t i = 0; i < map_size; i++) {
+		if (mp_typeof(*d) != MP_UINT) {
+			mp_next(&d); /* key */
+			mp_next(&d); /* value */
+			continue;
+		}
+		uint8_t key = mp_decode_uint(&d);
+		switch (key) {
+		case IPROTO_VCLOCK:
+			if (mp_decode_vclock(&d, vclock) != 0) {
+				diag_set(ClientError, ER_INVALID_MSGPACK,
+					 "invalid VCLOCK");
+				goto error;
+			}
+			break;
+		case IPROTO_SPACE_IDS:
+			if (xrow_decode_u32_array(&d, &filter->space_ids,
+						  &filter->space_count,
+						  "invalid SPACE_IDS") != 0)
+				goto error;
+			qsort(filter->space_ids, filter->space_count,
+			      sizeof(*filter->space_ids), cmp_u32);
+			break;
+		case IPROTO_FIELDS:
+			if (xrow_decode_u32_array(&d, &filter->fields,
+						  &filter->field_count,
+						  "invalid FIELDS") != 0)
+				goto error;
+			break;
+		default:
+			mp_next(&d); /* value */
+		}
+	}
+	return 0;
+error:
+	cdc_filter_destroy(filter);
+	return -1;
+}
+
 int
-xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
+xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid,
+		 const struct vclock *vclock, bool compress, bool is_anon)
 {
 	memset(row, 0, sizeof(*row));
 
 	size_t size = 64;
+	if (vclock != NULL)
+		size += mp_sizeof_uint(IPROTO_VCLOCK) + mp_sizeof_vclock(vclock);
 	char *buf = (char *) region_alloc(&fiber()->gc, size);
 	if (buf == NULL) {
 		diag_set(OutOfMemory, size, "region_alloc", "buf");
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 1);
+	data = mp_encode_map(data, 1 + compress + (vclock != NULL));
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
 	/* Greet the remote replica with our replica UUID */
 	data = xrow_encode_uuid(data, instance_uuid);
+	if (compress) {
+		data = mp_encode_uint(data, IPROTO_COMPRESSION);
+		data = mp_encode_bool(data, true);
+	}
+	if (vclock != NULL) {
+		data = mp_encode_uint(data, IPROTO_VCLOCK);
+		data = mp_encode_vclock(data, vclock);
+	}
 	assert(data <= buf + size);
 
 	row->body[0].iov_base = buf;
 	row->body[0].iov_len = (data - buf);
 	row->bodycnt = 1;
-	row->type = IPROTO_JOIN;
+	row->type = is_anon ? IPROTO_FETCH_SNAPSHOT : IPROTO_JOIN;
+	return 0;
+}
+
+int
+xrow_encode_register(struct xrow_header *row,
+		     const struct tt_uuid *instance_uuid)
+{
+	memset(row, 0, sizeof(*row));
+	size_t size = mp_sizeof_map(1) +
+		      mp_sizeof_uint(IPROTO_INSTANCE_UUID) +
+		      mp_sizeof_str(UUID_STR_LEN);
+	char *buf = (char *) region_alloc(&fiber()->gc, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "buf");
+		return -1;
+	}
+	char *data = buf;
+	data = mp_encode_map(data, 1);
+	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
+	data = xrow_encode_uuid(data, instance_uuid);
+	assert(data <= buf + size);
+	row->body[0].iov_base = buf;
+	row->body[0].iov_len = (data - buf);
+	row->bodycnt = 1;
+	row->type = IPROTO_REGISTER;
+	return 0;
+}
+
+int
+xrow_decode_wait_vclock(const struct xrow_header *row,
+			struct vclock *vclock)
+{
+	assert(row->wait_vclock != NULL);
+	const char *data = row->wait_vclock;
+	if (mp_decode_vclock(&data, vclock) != 0) {
+		diag_set(ClientError, ER_INVALID_MSGPACK,
+			 "invalid WAIT_VCLOCK");
+		return -1;
+	}
 	return 0;
 }
 
@@ -66,6 +66,13 @@ struct xrow_header {
 
 	int bodycnt;
 	uint32_t schema_version;
+	/** IPROTO_PRIORITY of a request, never encoded. */
+	uint32_t priority;
+	/**
+	 * IPROTO_WAIT_VCLOCK of a request, never encoded. Points
+	 * to a MsgPack map in the input buffer, NULL if not set.
+	 */
+	const char *wait_vclock;
 	struct iovec body[XROW_BODY_IOVMAX];
 };
 
@@ -223,6 +230,17 @@ struct auth_request {
 int
 xrow_decode_auth(const struct xrow_header *row, struct auth_request *request);
 
+/**
+ * Decode COMPRESS request from MessagePack.
+ * @param row request header.
+ * @param[out] threshold Minimal size of a response body to
+ *             compress, 0 disables compression.
+ * @retval  0 on success
+ * @retval -1 on error
+ */
+int
+xrow_decode_compress(const struct xrow_header *row, uint32_t *threshold);
+
 /**
  * Encode AUTH command.
  * @param[out] Row.
@@ -249,6 +267,12 @@ struct ballot {
 	struct vclock vclock;
 	/** Oldest vclock available on the instance. */
 	struct vclock gc_vclock;
+	/**
+	 * Number of replicas the instance is sending rows to,
+	 * including the ones joining it. Used to pick the least
+	 * loaded replica to join.
+	 */
+	uint32_t relay_count;
 };
 
 /**
@@ -272,6 +296,8 @@ xrow_encode_vote(struct xrow_header *row);
  * @param replicaset_uuid Replica set uuid.
  * @param instance_uuid Instance uuid.
  * @param vclock Replication clock.
+ * @param compress Ask the master to compress rows.
+ * @param is_anon Subscribe as an anonymous replica.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
@@ -280,7 +306,8 @@ int
 xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
-		      const struct vclock *vclock);
+		      const struct vclock *vclock, bool compress,
+		      bool is_anon);
 
 /**
  * Decode SUBSCRIBE command.
@@ -289,6 +316,8 @@ xrow_encode_subscribe(struct xrow_header *row,
  * @param[out] instance_uuid.
  * @param[out] vclock.
  * @param[out] version_id.
+ * @param[out] compress Set if the replica asks to compress rows.
+ * @param[out] is_anon Set if the replica is anonymous.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
@@ -296,31 +325,117 @@ xrow_encode_subscribe(struct xrow_header *row,
 int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
-		      uint32_t *version_id);
+		      uint32_t *version_id, bool *compress, bool *is_anon);
+
+/** Filter of a change data capture subscription. */
+struct cdc_filter {
+	/** Sorted ids of spaces to send, NULL to send all. */
+	uint32_t *space_ids;
+	uint32_t space_count;
+	/** Numbers of tuple fields to send, NULL to send all. */
+	uint32_t *fields;
+	uint32_t field_count;
+};
+
+/** Free the lists of @a filter. */
+void
+cdc_filter_destroy(struct cdc_filter *filter);
+
+/**
+ * Check if rows of space @a space_id pass @a filter.
+ */
+bool
+cdc_filter_has_space(const struct cdc_filter *filter, uint32_t space_id);
+
+/**
+ * Encode CDC_SUBSCRIBE command.
+ * @param[out] row Row.
+ * @param vclock Vclock to start from.
+ * @param filter Filter of rows.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_cdc_subscribe(struct xrow_header *row, const struct vclock *vclock,
+			  const struct cdc_filter *filter);
+
+/**
+ * Decode CDC_SUBSCRIBE command.
+ * @param row Row to decode.
+ * @param[out] vclock Vclock to start from.
+ * @param[out] filter Filter of rows, allocated with malloc(),
+ *             must be freed with cdc_filter_destroy().
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory or format error.
+ */
+int
+xrow_decode_cdc_subscribe(struct xrow_header *row, struct vclock *vclock,
+			  struct cdc_filter *filter);
 
 /**
  * Encode JOIN command.
  * @param[out] row Row to encode into.
  * @param instance_uuid.
+ * @param vclock If not NULL, the vclock the remote instance
+ *        must reach before serving the request, e.g. the
+ *        vclock of the master after REGISTER.
+ * @param compress Ask the master to compress rows.
+ * @param is_anon Encode FETCH_SNAPSHOT, which has the same
+ *        body, to join without registration.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
  */
 int
-xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid);
+xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid,
+		 const struct vclock *vclock, bool compress, bool is_anon);
 
 /**
  * Decode JOIN command.
  * @param row Row to decode.
  * @param[out] instance_uuid.
+ * @param[out] vclock The vclock to wait for, left intact if
+ *        the request has none.
+ * @param[out] compress Set if the replica asks to compress rows.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
  */
 static inline int
-xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid)
+xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		 struct vclock *vclock, bool *compress)
+{
+	return xrow_decode_subscribe(row, NULL, instance_uuid, vclock, NULL,
+				     compress, NULL);
+}
+
+/**
+ * Encode REGISTER command.
+ * @param[out] row Row to encode into.
+ * @param instance_uuid UUID of the instance to register.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_register(struct xrow_header *row,
+		     const struct tt_uuid *instance_uuid);
+
+/**
+ * Decode REGISTER command.
+ * @param row Row to decode.
+ * @param[out] instance_uuid.
+ *
+ * @retval  0 Success.
+ * @retval -1 Format error.
+ */
+static inline int
+xrow_decode_register(struct xrow_header *row, struct tt_uuid *instance_uuid)
 {
-	return xrow_decode_subscribe(row, NULL, instance_uuid, NULL, NULL);
+	return xrow_decode_subscribe(row, NULL, instance_uuid, NULL, NULL,
+				     NULL, NULL);
 }
 
 /**
@@ -334,6 +449,18 @@ xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid)
 int
 xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock);
 
+/**
+ * Decode IPROTO_WAIT_VCLOCK of a request.
+ * @param row Row to decode.
+ * @param[out] vclock.
+ *
+ * @retval  0 Success.
+ * @retval -1 Format error.
+ */
+int
+xrow_decode_wait_vclock(const struct xrow_header *row,
+			struct vclock *vclock);
+
 /**
  * Decode end of stream command (a response to JOIN command).
  * @param row Row to decode.
@@ -345,7 +472,8 @@ xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock);
 static inline int
 xrow_decode_vclock(struct xrow_header *row, struct vclock *vclock)
 {
-	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL);
+	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL, NULL,
+				     NULL);
 }
 
 /**
@@ -376,7 +504,8 @@ xrow_decode_subscribe_response(struct xrow_header *row,
 			       struct tt_uuid *replicaset_uuid,
 			       struct vclock *vclock)
 {
-	return xrow_decode_subscribe(row, replicaset_uuid, NULL, vclock, NULL);
+	return xrow_decode_subscribe(row, replicaset_uuid, NULL, vclock, NULL,
+				     NULL, NULL);
 }
 
 /**
@@ -434,6 +563,18 @@ iproto_prepare_select(struct obuf *buf, struct obuf_svp *svp)
 	return iproto_prepare_header(buf, svp, IPROTO_SELECT_HEADER_LEN);
 }
 
+/**
+ * Encode select header.
+ * @param buf Buffer of IPROTO_SELECT_HEADER_LEN bytes.
+ * @param sync Request sync.
+ * @param schema_version Current schema version.
+ * @param count Number of tuples in the response.
+ * @param data_size Size of the tuples following the header.
+ */
+void
+iproto_encode_select_header(char *buf, uint64_t sync, uint32_t schema_version,
+			    uint32_t count, uint32_t data_size);
+
 /**
  * Write select header to a preallocated buffer.
  * This function doesn't throw (and we rely on this in iproto.cc).
@@ -497,10 +638,21 @@ struct sql_request {
 	const char *sql_text;
 	/** MessagePack array of parameters. */
 	const char *bind;
+	/**
+	 * Id of a prepared statement to execute instead of
+	 * @sql_text, 0 if not set.
+	 */
+	uint32_t stmt_id;
+	/**
+	 * Number of rows pushed to the client at once, 0 to
+	 * send the whole result in the response.
+	 */
+	uint32_t chunk_size;
 };
 
 /**
- * Parse the EXECUTE request.
+ * Parse the EXECUTE or PREPARE request. Either the statement
+ * text or the id of a prepared statement must be set.
  * @param row Encoded data.
  * @param[out] request Request to decode to.
  *
@@ -738,10 +890,11 @@ static inline void
 xrow_encode_subscribe_xc(struct xrow_header *row,
 			 const struct tt_uuid *replicaset_uuid,
 			 const struct tt_uuid *instance_uuid,
-			 const struct vclock *vclock)
+			 const struct vclock *vclock, bool compress,
+			 bool is_anon)
 {
 	if (xrow_encode_subscribe(row, replicaset_uuid, instance_uuid,
-				  vclock) != 0)
+				  vclock, compress, is_anon) != 0)
 		diag_raise();
 }
 
@@ -750,27 +903,59 @@ static inline void
 xrow_decode_subscribe_xc(struct xrow_header *row,
 			 struct tt_uuid *replicaset_uuid,
 		         struct tt_uuid *instance_uuid, struct vclock *vclock,
-			 uint32_t *replica_version_id)
+			 uint32_t *replica_version_id, bool *compress,
+			 bool *is_anon)
 {
 	if (xrow_decode_subscribe(row, replicaset_uuid, instance_uuid,
-				  vclock, replica_version_id) != 0)
+				  vclock, replica_version_id, compress,
+				  is_anon) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_cdc_subscribe. */
+static inline void
+xrow_decode_cdc_subscribe_xc(struct xrow_header *row, struct vclock *vclock,
+			     struct cdc_filter *filter)
+{
+	if (xrow_decode_cdc_subscribe(row, vclock, filter) != 0)
 		diag_raise();
 }
 
 /** @copydoc xrow_encode_join. */
 static inline void
 xrow_encode_join_xc(struct xrow_header *row,
-		    const struct tt_uuid *instance_uuid)
+		    const struct tt_uuid *instance_uuid,
+		    const struct vclock *vclock, bool compress, bool is_anon)
 {
-	if (xrow_encode_join(row, instance_uuid) != 0)
+	if (xrow_encode_join(row, instance_uuid, vclock, compress,
+			     is_anon) != 0)
 		diag_raise();
 }
 
 /** @copydoc xrow_decode_join. */
 static inline void
-xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid)
+xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		    struct vclock *vclock, bool *compress)
+{
+	if (xrow_decode_join(row, instance_uuid, vclock, compress) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_encode_register. */
+static inline void
+xrow_encode_register_xc(struct xrow_header *row,
+			const struct tt_uuid *instance_uuid)
+{
+	if (xrow_encode_register(row, instance_uuid) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_register. */
+static inline void
+xrow_decode_register_xc(struct xrow_header *row,
+			struct tt_uuid *instance_uuid)
 {
-	if (xrow_decode_join(row, instance_uuid) != 0)
+	if (xrow_decode_register(row, instance_uuid) != 0)
 		diag_raise();
 }
 
@@ -31,6 +31,7 @@
 #include "cbus.h"
 
 #include <limits.h>
+#include <pmatomic.h>
 #include "fiber.h"
 #include "trigger.h"
 
@@ -54,8 +55,142 @@ static struct cbus cbus;
 const char *cbus_stat_strings[CBUS_STAT_LAST] = {
 	"EVENTS",
 	"LOCKS",
+	"WAKEUPS_AVOIDED",
 };
 
+enum {
+	/** The least number of queue polls before sleeping. */
+	CBUS_SPIN_COUNT_MIN = 16,
+	/** The greatest number of queue polls before sleeping. */
+	CBUS_SPIN_COUNT_MAX = 1024,
+};
+
+/** Let the sibling hardware thread run while we busy-wait. */
+static inline void
+cbus_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+/**
+ * Check if the endpoint queue is empty. May be called by both
+ * the consumer and producers.
+ */
+static inline bool
+cbus_endpoint_is_empty(struct cbus_endpoint *endpoint)
+{
+	return pm_atomic_load(&endpoint->tail) == &endpoint->stub;
+}
+
+/**
+ * Append a batch of messages to the endpoint queue. Must be
+ * called by a producer. Leaves the batch empty.
+ *
+ * @retval true if the queue was empty, so the consumer may
+ *         have to be woken up
+ */
+static inline bool
+cbus_endpoint_push(struct cbus_endpoint *endpoint, struct stailq *batch)
+{
+	struct stailq_entry *first = stailq_first(batch);
+	struct stailq_entry *last = stailq_last(batch);
+	assert(first != NULL && last != NULL);
+	last->next = NULL;
+	stailq_create(batch);
+	struct stailq_entry *prev = pm_atomic_exchange(&endpoint->tail, last);
+	/*
+	 * Until the link below is set, the consumer sees the
+	 * queue as non-empty but can't reach the batch yet, so
+	 * it busy-waits in cbus_endpoint_fetch(). The window is
+	 * a couple of instructions long.
+	 */
+	pm_atomic_store_explicit(&prev->next, first,
+				 pm_memory_order_release);
+	return prev == &endpoint->stub;
+}
+
+/**
+ * Wait until a producer links the next message to the given one
+ * in the endpoint queue.
+ */
+static inline struct stailq_entry *
+cbus_endpoint_next(struct stailq_entry *entry)
+{
+	struct stailq_entry *next;
+	while ((next = pm_atomic_load_explicit(&entry->next,
+					pm_memory_order_acquire)) == NULL)
+		cbus_cpu_relax();
+	return next;
+}
+
+void
+cbus_endpoint_fetch(struct cbus_endpoint *endpoint, struct stailq *output)
+{
+	if (cbus_endpoint_is_empty(endpoint))
+		return;
+	struct stailq_entry *stub = &endpoint->stub;
+	struct stailq_entry *first = cbus_endpoint_next(stub);
+	/*
+	 * Only the producer which swapped the stub out of the
+	 * tail may write to stub->next, and it has already done
+	 * so, hence it's safe to reset the link before putting
+	 * the stub back.
+	 */
+	pm_atomic_store_explicit(&stub->next, NULL, pm_memory_order_relaxed);
+	struct stailq_entry *last = pm_atomic_exchange(&endpoint->tail, stub);
+	/* Make sure all batches in the chain are linked. */
+	uint64_t count = 1;
+	for (struct stailq_entry *entry = first; entry != last; count++)
+		entry = cbus_endpoint_next(entry);
+	*output->last = first;
+	output->last = &last->next;
+	/*
+	 * Producers account messages before pushing them, so
+	 * the difference is never negative.
+	 */
+	uint64_t queue = pm_atomic_load(&endpoint->n_pushed) -
+			 endpoint->n_fetched;
+	if (queue > endpoint->queue_max)
+		pm_atomic_store(&endpoint->queue_max, queue);
+	pm_atomic_store(&endpoint->n_fetched, endpoint->n_fetched + count);
+}
+
+/**
+ * Poll the endpoint queue for a while before going to sleep, so
+ * that producers pushing messages meanwhile don't need to wake
+ * the consumer up. The number of polls grows while polling pays
+ * off and shrinks otherwise.
+ *
+ * @retval true if there are messages to process
+ */
+static bool
+cbus_endpoint_spin(struct cbus_endpoint *endpoint)
+{
+	bool found = false;
+	pm_atomic_store(&endpoint->is_spinning, 1);
+	for (int i = 0; i < endpoint->spin_count; i++) {
+		if (! cbus_endpoint_is_empty(endpoint)) {
+			found = true;
+			break;
+		}
+		cbus_cpu_relax();
+	}
+	pm_atomic_store(&endpoint->is_spinning, 0);
+	if (found)
+		endpoint->spin_count = MIN(endpoint->spin_count * 2,
+					   CBUS_SPIN_COUNT_MAX);
+	else
+		endpoint->spin_count = MAX(endpoint->spin_count / 2,
+					   CBUS_SPIN_COUNT_MIN);
+	/*
+	 * A producer may have skipped the wakeup right before
+	 * we cleared the flag, so check the queue once again.
+	 */
+	return ! cbus_endpoint_is_empty(endpoint);
+}
+
 /**
  * Find a joined cbus endpoint by name.
  * This is an internal helper method which should be called
@@ -93,6 +228,7 @@ cpipe_create(struct cpipe *pipe, const char *consumer)
 	stailq_create(&pipe->input);
 
 	pipe->n_input = 0;
+	pipe->n_pushed = 0;
 	pipe->max_input = INT_MAX;
 	pipe->producer = cord()->loop;
 
@@ -149,11 +285,12 @@ cpipe_destroy(struct cpipe *pipe)
 	 * delivered.
 	 */
 	tt_pthread_mutex_lock(&endpoint->mutex);
+	/* Add the pipe shutdown message as the last one. */
+	stailq_add_tail_entry(&pipe->input, poison, msg.fifo);
 	/* Flush input */
-	stailq_concat(&endpoint->output, &pipe->input);
+	pm_atomic_fetch_add(&endpoint->n_pushed, pipe->n_pushed + 1);
+	cbus_endpoint_push(endpoint, &pipe->input);
 	pipe->n_input = 0;
-	/* Add the pipe shutdown message as the last one. */
-	stailq_add_tail_entry(&endpoint->output, poison, msg.fifo);
 	/* Count statistics */
 	rmean_collect(cbus.stats, CBUS_STAT_EVENTS, 1);
 	/*
@@ -218,7 +355,13 @@ cbus_endpoint_create(struct cbus_endpoint *endpoint, const char *name,
 	endpoint->n_pipes = 0;
 	fiber_cond_create(&endpoint->cond);
 	tt_pthread_mutex_init(&endpoint->mutex, NULL);
-	stailq_create(&endpoint->output);
+	endpoint->stub.next = NULL;
+	endpoint->tail = &endpoint->stub;
+	endpoint->is_spinning = 0;
+	endpoint->spin_count = CBUS_SPIN_COUNT_MIN;
+	endpoint->n_pushed = 0;
+	endpoint->n_fetched = 0;
+	endpoint->queue_max = 0;
 	ev_async_init(&endpoint->async,
 		      (void (*)(ev_loop *, struct ev_async *, int)) fetch_cb);
 	endpoint->async.data = fetch_data;
@@ -252,14 +395,14 @@ cbus_endpoint_destroy(struct cbus_endpoint *endpoint,
 	while (true) {
 		if (process_cb)
 			process_cb(endpoint);
-		if (endpoint->n_pipes == 0 && stailq_empty(&endpoint->output))
+		if (endpoint->n_pipes == 0 && cbus_endpoint_is_empty(endpoint))
 			break;
 		 fiber_cond_wait(&endpoint->cond);
 	}
 
 	/*
-	 * Pipe flush func can still lock mutex, so just lock and unlock
-	 * it.
+	 * The last pipe destroy func can still hold the mutex,
+	 * so just lock and unlock it.
 	 */
 	tt_pthread_mutex_lock(&endpoint->mutex);
 	tt_pthread_mutex_unlock(&endpoint->mutex);
@@ -281,22 +424,48 @@ cpipe_flush_cb(ev_loop *loop, struct ev_async *watcher, int events)
 		return;
 
 	trigger_run(&pipe->on_flush, pipe);
-	/* Trigger task processing when the queue becomes non-empty. */
-	bool output_was_empty;
-
-	tt_pthread_mutex_lock(&endpoint->mutex);
-	output_was_empty = stailq_empty(&endpoint->output);
 	/** Flush input */
-	stailq_concat(&endpoint->output, &pipe->input);
-	tt_pthread_mutex_unlock(&endpoint->mutex);
-
+	pm_atomic_fetch_add(&endpoint->n_pushed, pipe->n_pushed);
+	pipe->n_pushed = 0;
+	bool output_was_empty = cbus_endpoint_push(endpoint, &pipe->input);
 	pipe->n_input = 0;
-	if (output_was_empty) {
-		/* Count statistics */
-		rmean_collect(cbus.stats, CBUS_STAT_EVENTS, 1);
+	/*
+	 * Trigger task processing when the queue becomes
+	 * non-empty, unless the consumer is polling the queue
+	 * anyway.
+	 */
+	if (! output_was_empty)
+		return;
+	if (pm_atomic_load(&endpoint->is_spinning)) {
+		rmean_collect(cbus.stats, CBUS_STAT_WAKEUPS_AVOIDED, 1);
+		return;
+	}
+	/* Count statistics */
+	rmean_collect(cbus.stats, CBUS_STAT_EVENTS, 1);
+
+	ev_async_send(endpoint->consumer, &endpoint->async);
+}
 
-		ev_async_send(endpoint->consumer, &endpoint->async);
+int
+cbus_stat_foreach(cbus_stat_cb cb, void *cb_ctx)
+{
+	int rc = 0;
+	struct cbus_endpoint *endpoint;
+	tt_pthread_mutex_lock(&cbus.mutex);
+	rlist_foreach_entry(endpoint, &cbus.endpoints, in_cbus) {
+		struct cbus_endpoint_stat stat;
+		uint64_t fetched = pm_atomic_load(&endpoint->n_fetched);
+		uint64_t pushed = pm_atomic_load(&endpoint->n_pushed);
+		stat.pipes = endpoint->n_pipes;
+		stat.queue = pushed > fetched ? pushed - fetched : 0;
+		stat.queue_max = pm_atomic_load(&endpoint->queue_max);
+		stat.fetched = fetched;
+		rc = cb(endpoint->name, &stat, cb_ctx);
+		if (rc != 0)
+			break;
 	}
+	tt_pthread_mutex_unlock(&cbus.mutex);
+	return rc;
 }
 
 void
@@ -642,6 +811,11 @@ cbus_loop(struct cbus_endpoint *endpoint)
 		cbus_process(endpoint);
 		if (fiber_is_cancelled())
 			break;
+		if (cbus_endpoint_spin(endpoint)) {
+			/* Let other fibers of the cord run. */
+			fiber_reschedule();
+			continue;
+		}
 		fiber_yield();
 	}
 }
@@ -49,6 +49,7 @@ typedef void (*cmsg_f)(struct cmsg *);
 enum cbus_stat_name {
 	CBUS_STAT_EVENTS,
 	CBUS_STAT_LOCKS,
+	CBUS_STAT_WAKEUPS_AVOIDED,
 	CBUS_STAT_LAST,
 };
 
@@ -115,6 +116,12 @@ struct cpipe {
 	struct stailq input;
 	/** Counters are useful for finer-grained scheduling. */
 	int n_input;
+	/**
+	 * Number of messages staged since the last flush.
+	 * Unlike n_input, it is never adjusted by the producer
+	 * and is used to track the endpoint queue depth.
+	 */
+	int n_pushed;
 	/**
 	 * When pushing messages, keep the staged input size under
 	 * this limit (speeds up message delivery and reduces
@@ -218,6 +225,7 @@ cpipe_push_input(struct cpipe *pipe, struct cmsg *msg)
 
 	stailq_add_tail_entry(&pipe->input, msg, fifo);
 	pipe->n_input++;
+	pipe->n_pushed++;
 	if (pipe->n_input >= pipe->max_input)
 		ev_invoke(pipe->producer, &pipe->flush_input, EV_CUSTOM);
 }
@@ -251,10 +259,33 @@ struct cbus_endpoint {
 	char name[FIBER_NAME_MAX];
 	/** Member of cbus->endpoints */
 	struct rlist in_cbus;
-	/** The lock around the pipe. */
+	/**
+	 * The lock held by cpipe_destroy() while it delivers
+	 * the pipe shutdown message, @sa cbus_endpoint_destroy().
+	 * Regular message delivery is lock-free.
+	 */
 	pthread_mutex_t mutex;
-	/** A queue with incoming messages. */
-	struct stailq output;
+	/**
+	 * A lock-free multi-producer queue with incoming
+	 * messages. A producer appends a whole batch by swapping
+	 * the tail and then linking the previous tail to the
+	 * batch head. The consumer takes everything queued after
+	 * the stub and resets the tail back to it.
+	 */
+	struct stailq_entry stub;
+	/** The last queued message or the stub. */
+	struct stailq_entry *tail;
+	/**
+	 * Set while the consumer polls the queue before going
+	 * to sleep, @sa cbus_loop(). Producers need not wake
+	 * it up then.
+	 */
+	int is_spinning;
+	/**
+	 * How many times the consumer polls the queue before
+	 * going to sleep. Grows while polling pays off.
+	 */
+	int spin_count;
 	/** Consumer cord loop */
 	ev_loop *consumer;
 	/** Async to notify the consumer */
@@ -263,18 +294,44 @@ struct cbus_endpoint {
 	uint32_t n_pipes;
 	/** Condition for endpoint destroy */
 	struct fiber_cond cond;
+	/** Number of messages flushed to the queue by producers. */
+	uint64_t n_pushed;
+	/** Number of messages fetched from the queue. */
+	uint64_t n_fetched;
+	/** Max number of messages found in the queue by a fetch. */
+	uint64_t queue_max;
+};
+
+/** Message queue statistics of a cbus endpoint. */
+struct cbus_endpoint_stat {
+	/** Number of connected pipes. */
+	uint32_t pipes;
+	/** Messages flushed by producers, but not fetched yet. */
+	uint64_t queue;
+	/** Max queue depth seen by the consumer. */
+	uint64_t queue_max;
+	/** Number of messages fetched by the consumer. */
+	uint64_t fetched;
 };
 
+typedef int (*cbus_stat_cb)(const char *name,
+			    const struct cbus_endpoint_stat *stat, void *ctx);
+
 /**
- * Fetch incomming messages to output
+ * Invoke a callback with the queue statistics of every cbus
+ * endpoint. Stops at the first callback returning non-zero
+ * and returns its value. The callback is invoked under the
+ * bus lock and must not yield.
  */
-static inline void
-cbus_endpoint_fetch(struct cbus_endpoint *endpoint, struct stailq *output)
-{
-	tt_pthread_mutex_lock(&endpoint->mutex);
-	stailq_concat(output, &endpoint->output);
-	tt_pthread_mutex_unlock(&endpoint->mutex);
-}
+int
+cbus_stat_foreach(cbus_stat_cb cb, void *cb_ctx);
+
+/**
+ * Fetch incomming messages to output. Must be called by the
+ * consumer.
+ */
+void
+cbus_endpoint_fetch(struct cbus_endpoint *endpoint, struct stailq *output);
 
 /** Initialize the global singleton bus. */
 void
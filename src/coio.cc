@@ -63,7 +63,9 @@ static inline bool
 coio_fiber_yield_timeout(struct ev_io *coio, ev_tstamp delay)
 {
 	coio->data = fiber();
+	enum fiber_wait_reason reason = fiber_set_wait_reason(FIBER_WAIT_IO);
 	bool is_timedout = fiber_yield_timeout(delay);
+	fiber_set_wait_reason(reason);
 	coio->data = NULL;
 	return is_timedout;
 }
@@ -728,7 +730,9 @@ coio_wait(int fd, int events, double timeout)
 	ev_set_priority(&io, EV_MAXPRI);
 	ev_io_start(loop(), &io);
 
+	enum fiber_wait_reason reason = fiber_set_wait_reason(FIBER_WAIT_IO);
 	fiber_yield_timeout(timeout);
+	fiber_set_wait_reason(reason);
 
 	ev_io_stop(loop(), &io);
 	return wdata.revents & (EV_READ | EV_WRITE);
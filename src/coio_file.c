@@ -105,10 +105,15 @@ struct coio_file_task {
 	};
 };
 
+/**
+ * Note, this waits for a free slot in the file task class,
+ * see coio_pool_id, which is released by coio_wait_done().
+ */
 #define INIT_COEIO_FILE(name)			\
 	struct coio_file_task name;		\
 	memset(&name, 0, sizeof(name));		\
 	name.fiber = fiber();			\
+	coio_pool_enter(COIO_POOL_FILE, TIMEOUT_INFINITY);	\
 
 /** A callback invoked by eio when a task is complete. */
 static int
@@ -132,12 +137,16 @@ static ssize_t
 coio_wait_done(eio_req *req, struct coio_file_task *eio)
 {
 	if (!req) {
+		coio_pool_leave(COIO_POOL_FILE);
 		errno = ENOMEM;
 		return -1;
 	}
 
+	enum fiber_wait_reason reason = fiber_set_wait_reason(FIBER_WAIT_COIO);
 	while (!eio->done)
 		fiber_yield();
+	fiber_set_wait_reason(reason);
+	coio_pool_leave(COIO_POOL_FILE);
 
 	errno = eio->errorno;
 	return eio->result;
@@ -463,13 +472,13 @@ coio_do_tempdir(eio_req *req)
 int
 coio_tempdir(char *path, size_t path_len)
 {
-	INIT_COEIO_FILE(eio);
-
 	if (path_len < sizeof("/tmp/XXXXXX") + 1) {
 		errno = ENOMEM;
 		return -1;
 	}
 
+	INIT_COEIO_FILE(eio);
+
 	snprintf(path, path_len, "/tmp/XXXXXX");
 
 	eio.tempdir.tpl = path;
@@ -39,6 +39,8 @@
 #include <sys/socket.h>
 
 #include "fiber.h"
+#include "fiber_cond.h"
+#include "clock.h"
 #include "third_party/tarantool_ev.h"
 
 /*
@@ -74,6 +76,87 @@ struct coio_manager {
 
 static __thread struct coio_manager coio_manager;
 
+const char *coio_pool_id_strs[] = {
+	/* [COIO_POOL_DEFAULT] = */ "default",
+	/* [COIO_POOL_DNS]     = */ "dns",
+	/* [COIO_POOL_FILE]    = */ "file",
+	/* [COIO_POOL_USER]    = */ "user",
+};
+
+/** A class of coio tasks, see coio_pool_id. */
+struct coio_pool {
+	/** Signaled when a slot is freed or the pool is resized. */
+	struct fiber_cond cond;
+	/** Statistics, also holds the pool size. */
+	struct coio_pool_stat stat;
+};
+
+static __thread struct coio_pool coio_pools[coio_pool_id_MAX];
+
+static inline bool
+coio_pool_is_full(struct coio_pool *pool)
+{
+	return pool->stat.size > 0 && pool->stat.running >= pool->stat.size;
+}
+
+void
+coio_pool_set_size(enum coio_pool_id id, int size)
+{
+	struct coio_pool *pool = &coio_pools[id];
+	pool->stat.size = size;
+	fiber_cond_broadcast(&pool->cond);
+}
+
+void
+coio_pool_stat(enum coio_pool_id id, struct coio_pool_stat *stat)
+{
+	*stat = coio_pools[id].stat;
+}
+
+int
+coio_pool_enter(enum coio_pool_id id, double timeout)
+{
+	struct coio_pool *pool = &coio_pools[id];
+	pool->stat.requests++;
+	if (!coio_pool_is_full(pool) && pool->stat.waiting == 0) {
+		pool->stat.running++;
+		return 0;
+	}
+	double start = clock_monotonic();
+	double deadline = ev_monotonic_now(loop()) + timeout;
+	pool->stat.waiting++;
+	/*
+	 * Note, we ignore fiber cancellation here, because
+	 * coio_call() isn't cancellable. coio_task_post()
+	 * checks for cancellation after the task is posted.
+	 */
+	while (coio_pool_is_full(pool)) {
+		if (fiber_cond_wait_deadline(&pool->cond, deadline) != 0) {
+			pool->stat.waiting--;
+			return -1;
+		}
+	}
+	pool->stat.waiting--;
+	pool->stat.running++;
+	double queue_time = clock_monotonic() - start;
+	pool->stat.queue_time += queue_time;
+	if (pool->stat.queue_time_max < queue_time)
+		pool->stat.queue_time_max = queue_time;
+	/* Let the next waiter check if there's a free slot. */
+	if (pool->stat.waiting > 0 && !coio_pool_is_full(pool))
+		fiber_cond_signal(&pool->cond);
+	return 0;
+}
+
+void
+coio_pool_leave(enum coio_pool_id id)
+{
+	struct coio_pool *pool = &coio_pools[id];
+	assert(pool->stat.running > 0);
+	pool->stat.running--;
+	fiber_cond_signal(&pool->cond);
+}
+
 static void
 coio_idle_cb(ev_loop *loop, struct ev_idle *w, int events)
 {
@@ -148,6 +231,9 @@ coio_enable(void)
 	ev_async_init(&coio_manager.coio_async, coio_async_cb);
 
 	ev_async_start(loop(), &coio_manager.coio_async);
+
+	for (int i = 0; i < coio_pool_id_MAX; i++)
+		fiber_cond_create(&coio_pools[i].cond);
 }
 
 void
@@ -173,6 +259,7 @@ static int
 coio_on_finish(eio_req *req)
 {
 	struct coio_task *task = (struct coio_task *) req;
+	coio_pool_leave(task->pool);
 	if (task->fiber == NULL) {
 		/*
 		 * Timed out. Resources will be freed by coio_on_destroy.
@@ -218,6 +305,7 @@ coio_task_create(struct coio_task *task,
 	task->task_cb = func;
 	task->timeout_cb = on_timeout;
 	task->complete = 0;
+	task->pool = COIO_POOL_DEFAULT;
 	diag_create(&task->diag);
 }
 
@@ -233,17 +321,32 @@ coio_task_post(struct coio_task *task, double timeout)
 	assert(task->base.type == EIO_CUSTOM);
 	assert(task->fiber == fiber());
 
-	eio_submit(&task->base);
 	if (timeout == 0) {
 		/*
 		* This is a special case:
 		* we don't wait any response from the task
 		* and just perform just asynchronous post.
+		* Such tasks can't wait for a free slot so
+		* they may exceed the class limit.
 		*/
+		coio_pools[task->pool].stat.requests++;
+		coio_pools[task->pool].stat.running++;
 		task->fiber = NULL;
+		eio_submit(&task->base);
 		return 0;
 	}
+	double start = ev_monotonic_now(loop());
+	if (coio_pool_enter(task->pool, timeout) != 0) {
+		/* The task was never submitted, free it now. */
+		task->fiber = NULL;
+		task->timeout_cb(task);
+		return -1;
+	}
+	timeout -= ev_monotonic_now(loop()) - start;
+	eio_submit(&task->base);
+	enum fiber_wait_reason reason = fiber_set_wait_reason(FIBER_WAIT_COIO);
 	fiber_yield_timeout(timeout);
+	fiber_set_wait_reason(reason);
 	if (!task->complete) {
 		/* timed out or cancelled. */
 		task->fiber = NULL;
@@ -265,8 +368,8 @@ coio_on_call(eio_req *req)
 		diag_move(diag_get(), &task->diag);
 }
 
-ssize_t
-coio_call(ssize_t (*func)(va_list ap), ...)
+static ssize_t
+coio_vcall(enum coio_pool_id pool, ssize_t (*func)(va_list ap), va_list ap)
 {
 	struct coio_task *task = (struct coio_task *) calloc(1, sizeof(*task));
 	if (task == NULL)
@@ -281,14 +384,18 @@ coio_call(ssize_t (*func)(va_list ap), ...)
 	task->fiber = fiber();
 	task->call_cb = func;
 	task->complete = 0;
+	task->pool = pool;
 	diag_create(&task->diag);
 
-	va_start(task->ap, func);
+	va_copy(task->ap, ap);
+	coio_pool_enter(pool, TIMEOUT_INFINITY);
 	eio_submit(&task->base);
 
+	enum fiber_wait_reason reason = fiber_set_wait_reason(FIBER_WAIT_COIO);
 	do {
 		fiber_yield();
 	} while (task->complete == 0);
+	fiber_set_wait_reason(reason);
 	va_end(task->ap);
 
 	ssize_t result = task->base.result;
@@ -300,6 +407,26 @@ coio_call(ssize_t (*func)(va_list ap), ...)
 	return result;
 }
 
+ssize_t
+coio_call(ssize_t (*func)(va_list ap), ...)
+{
+	va_list ap;
+	va_start(ap, func);
+	ssize_t result = coio_vcall(COIO_POOL_DEFAULT, func, ap);
+	va_end(ap);
+	return result;
+}
+
+ssize_t
+coio_call_in(enum coio_pool_id pool, ssize_t (*func)(va_list ap), ...)
+{
+	va_list ap;
+	va_start(ap, func);
+	ssize_t result = coio_vcall(pool, func, ap);
+	va_end(ap);
+	return result;
+}
+
 struct async_getaddrinfo_task {
 	struct coio_task base;
 	struct addrinfo *result;
@@ -371,6 +498,7 @@ coio_getaddrinfo(const char *host, const char *port,
 	}
 
 	coio_task_create(&task->base, getaddrinfo_cb, getaddrinfo_free_cb);
+	coio_task_set_pool(&task->base, COIO_POOL_DNS);
 
 	/*
 	 * getaddrinfo() on osx upto osx 10.8 crashes when AI_NUMERICSERV is
@@ -35,6 +35,7 @@
 
 #include <sys/types.h> /* ssize_t */
 #include <stdarg.h>
+#include <stdint.h>
 
 #include "third_party/tarantool_eio.h"
 #include "diag.h"
@@ -53,6 +54,72 @@ void coio_init(void);
 void coio_enable(void);
 void coio_shutdown(void);
 
+/**
+ * Workload classes of coio tasks.
+ *
+ * All tasks are executed by the same eio thread pool, but each
+ * class may be limited in the number of tasks it runs at a time
+ * (see coio_pool_set_size()) so that a burst of tasks of one
+ * class, e.g. slow file writes issued by an application, can't
+ * occupy all threads and delay tasks of another class, e.g.
+ * host name resolution. Tasks above the limit wait in a queue
+ * of their class in the calling thread.
+ */
+enum coio_pool_id {
+	/** Tasks without a class, never limited. */
+	COIO_POOL_DEFAULT,
+	/** Host name resolution, see coio_getaddrinfo(). */
+	COIO_POOL_DNS,
+	/** File operations, see coio_file.h. */
+	COIO_POOL_FILE,
+	/** CPU-bound tasks issued on behalf of Lua code. */
+	COIO_POOL_USER,
+	coio_pool_id_MAX,
+};
+
+extern const char *coio_pool_id_strs[];
+
+/** Statistics of a coio task class. */
+struct coio_pool_stat {
+	/** Max number of running tasks, 0 if unlimited. */
+	int size;
+	/** Number of tasks running now. */
+	int running;
+	/** Number of tasks waiting for a free slot now. */
+	int waiting;
+	/** Number of tasks submitted so far. */
+	int64_t requests;
+	/** Total time tasks spent waiting for a free slot. */
+	double queue_time;
+	/** Max time a task spent waiting for a free slot. */
+	double queue_time_max;
+};
+
+/**
+ * Set the max number of tasks of the given class that may run
+ * at the same time, 0 means unlimited. Takes effect immediately
+ * for queued tasks.
+ */
+void
+coio_pool_set_size(enum coio_pool_id id, int size);
+
+/** Get statistics of the given task class. */
+void
+coio_pool_stat(enum coio_pool_id id, struct coio_pool_stat *stat);
+
+/**
+ * Wait for a free slot in the given task class.
+ * @retval  0 success, coio_pool_leave() must be called when
+ *            the task is complete.
+ * @retval -1 timeout (diag is set).
+ */
+int
+coio_pool_enter(enum coio_pool_id id, double timeout);
+
+/** Release a slot taken with coio_pool_enter(). */
+void
+coio_pool_leave(enum coio_pool_id id);
+
 struct coio_task;
 
 typedef ssize_t (*coio_call_cb)(va_list ap);
@@ -78,6 +145,8 @@ struct coio_task {
 	};
 	/** Callback results. */
 	int complete;
+	/** Task class, see coio_task_set_pool(). */
+	enum coio_pool_id pool;
 	/** Task diag **/
 	struct diag diag;
 };
@@ -101,11 +170,22 @@ coio_task_create(struct coio_task *task, coio_task_cb func,
 void
 coio_task_destroy(struct coio_task *task);
 
+/**
+ * Set the class of a coio task. Must be called before
+ * the task is posted. The default is COIO_POOL_DEFAULT.
+ */
+static inline void
+coio_task_set_pool(struct coio_task *task, enum coio_pool_id pool)
+{
+	task->pool = pool;
+}
+
 /**
  * Post coio task to EIO thread pool.
  *
  * @param task coio task.
- * @param timeout timeout in seconds.
+ * @param timeout timeout in seconds, including the time spent
+ *                waiting for a free slot in the task class.
  * @retval 0  the task completed successfully. Check the result
  *            code in task->base.result and free the task.
  * @retval -1 timeout or the waiting fiber was cancelled (check diag);
@@ -147,6 +227,17 @@ coio_task_post(struct coio_task *task, double timeout);
 ssize_t
 coio_call(ssize_t (*func)(va_list), ...);
 
+/** \endcond public */
+
+/**
+ * Same as coio_call(), but runs the function as a task of
+ * the given class, see coio_pool_id.
+ */
+ssize_t
+coio_call_in(enum coio_pool_id pool, ssize_t (*func)(va_list), ...);
+
+/** \cond public */
+
 struct addrinfo;
 
 /**
@@ -34,6 +34,7 @@
 #include "diag.h"
 #include "assoc.h"
 #include <unicode/ucol.h>
+#include <unicode/uiter.h>
 #include <trivia/config.h>
 
 #define mh_name _coll
@@ -103,11 +104,56 @@ coll_bin_cmp(const char *s, size_t slen, const char *t, size_t tlen,
 	return res;
 }
 
+enum {
+	/** Number of entries in the sort key cache. */
+	COLL_KEY_CACHE_SIZE = 64,
+	/** Max length of a string whose sort key is cached. */
+	COLL_KEY_CACHE_STR_MAX = 32,
+	/** Max length of a cached sort key. */
+	COLL_KEY_CACHE_KEY_MAX = 96,
+};
+
+/** Sort key of a short string, see coll_icu_hash(). */
+struct coll_key_cache_entry {
+	/** Collation id, 0 if the entry is empty. */
+	uint32_t coll_id;
+	uint8_t str_len;
+	uint8_t key_len;
+	char str[COLL_KEY_CACHE_STR_MAX];
+	uint8_t key[COLL_KEY_CACHE_KEY_MAX];
+};
+
+/**
+ * Hashing a string with ICU collation means building its whole
+ * sort key, which costs much more than hashing the string
+ * itself. A HASH index hashes the same key on each lookup and
+ * both old and new tuple on update, so recently seen sort keys
+ * of short strings are cached. The cache is per thread, because
+ * tuples are hashed in vinyl workers too.
+ */
+static __thread struct coll_key_cache_entry
+coll_key_cache[COLL_KEY_CACHE_SIZE];
+
+/** Last assigned collation id. */
+static uint32_t coll_id_max = 0;
+
 /** Get a hash of a string using ICU collation. */
 static uint32_t
 coll_icu_hash(const char *s, size_t s_len, uint32_t *ph, uint32_t *pcarry,
 	      struct coll *coll)
 {
+	struct coll_key_cache_entry *entry = NULL;
+	if (s_len <= COLL_KEY_CACHE_STR_MAX) {
+		uint32_t slot = PMurHash32(coll->id, s, s_len) %
+				COLL_KEY_CACHE_SIZE;
+		entry = &coll_key_cache[slot];
+		if (entry->coll_id == coll->id && entry->str_len == s_len &&
+		    memcmp(entry->str, s, s_len) == 0) {
+			PMurHash32_Process(ph, pcarry, entry->key,
+					   entry->key_len);
+			return entry->key_len;
+		}
+	}
 	uint32_t total_size = 0;
 	UCharIterator itr;
 	uiter_setUTF8(&itr, s, s_len);
@@ -121,6 +167,14 @@ coll_icu_hash(const char *s, size_t s_len, uint32_t *ph, uint32_t *pcarry,
 		PMurHash32_Process(ph, pcarry, buf, got);
 		total_size += got;
 	} while (got == TT_STATIC_BUF_LEN);
+	if (entry != NULL && total_size <= COLL_KEY_CACHE_KEY_MAX) {
+		/* The whole sort key is in buf. */
+		entry->coll_id = coll->id;
+		entry->str_len = s_len;
+		entry->key_len = total_size;
+		memcpy(entry->str, s, s_len);
+		memcpy(entry->key, buf, total_size);
+	}
 	return total_size;
 }
 
@@ -133,6 +187,32 @@ coll_bin_hash(const char *s, size_t s_len, uint32_t *ph, uint32_t *pcarry,
 	return s_len;
 }
 
+/** Get a sort key prefix of a string using ICU collation. */
+static size_t
+coll_icu_hint(const char *s, size_t s_len, char *buf, size_t buf_len,
+	      struct coll *coll)
+{
+	assert(coll->collator != NULL);
+	UCharIterator itr;
+	uiter_setUTF8(&itr, s, s_len);
+	uint32_t state[2] = {0, 0};
+	UErrorCode status = U_ZERO_ERROR;
+	int32_t got = ucol_nextSortKeyPart(coll->collator, &itr, state,
+					   (uint8_t *) buf, buf_len, &status);
+	assert(!U_FAILURE(status));
+	return got;
+}
+
+static size_t
+coll_bin_hint(const char *s, size_t s_len, char *buf, size_t buf_len,
+	      struct coll *coll)
+{
+	(void) coll;
+	size_t len = s_len < buf_len ? s_len : buf_len;
+	memcpy(buf, s, len);
+	return len;
+}
+
 /**
  * Set up ICU collator and init cmp and hash members of collation.
  * @param coll Collation to set up.
@@ -242,6 +322,7 @@ coll_icu_init_cmp(struct coll *coll, const struct coll_def *def)
 	}
 	coll->cmp = coll_icu_cmp;
 	coll->hash = coll_icu_hash;
+	coll->hint = coll_icu_hint;
 	return 0;
 }
 
@@ -320,6 +401,7 @@ coll_new(const struct coll_def *def)
 	}
 	memcpy((char *) coll->fingerprint, fingerprint, fingerprint_len + 1);
 	coll->refs = 1;
+	coll->id = ++coll_id_max;
 	coll->type = def->type;
 	switch (coll->type) {
 	case COLL_TYPE_ICU:
@@ -332,6 +414,7 @@ coll_new(const struct coll_def *def)
 		coll->collator = NULL;
 		coll->cmp = coll_bin_cmp;
 		coll->hash = coll_bin_hash;
+		coll->hint = coll_bin_hint;
 		break;
 	default:
 		unreachable();
@@ -47,6 +47,9 @@ typedef int (*coll_cmp_f)(const char *s, size_t s_len, const char *t,
 typedef uint32_t (*coll_hash_f)(const char *s, size_t s_len, uint32_t *ph,
 				uint32_t *pcarry, struct coll *coll);
 
+typedef size_t (*coll_hint_f)(const char *s, size_t s_len, char *buf,
+			      size_t buf_len, struct coll *coll);
+
 struct UCollator;
 
 /**
@@ -61,6 +64,19 @@ struct coll {
 	/** String comparator. */
 	coll_cmp_f cmp;
 	coll_hash_f hash;
+	/**
+	 * Write at most buf_len leading bytes of the string sort
+	 * key to buf and return the number of bytes written.
+	 * If the zero padded prefix of one string is less than
+	 * that of another in terms of memcmp(), then so is the
+	 * string itself in terms of cmp.
+	 */
+	coll_hint_f hint;
+	/**
+	 * Unique identifier of the collation object, used to
+	 * tag sort keys cached by the hash function.
+	 */
+	uint32_t id;
 	/** Reference counter. */
 	int refs;
 	/**
@@ -229,7 +229,8 @@ curl_multi_sock_cb(CURL *easy, curl_socket_t fd, int what, void *envp,
 
 
 int
-curl_env_create(struct curl_env *env, long max_conns)
+curl_env_create(struct curl_env *env, long max_conns, long max_host_conns,
+		bool http2)
 {
 	memset(env, 0, sizeof(*env));
 	mempool_create(&env->sock_pool, &cord()->slabc,
@@ -253,6 +254,37 @@ curl_env_create(struct curl_env *env, long max_conns)
 
 	curl_multi_setopt(env->multi, CURLMOPT_MAXCONNECTS, max_conns);
 
+	if (max_host_conns > 0) {
+#if LIBCURL_VERSION_NUM >= 0x071e00
+		/* Available starting from libcurl 7.30.0 */
+		curl_multi_setopt(env->multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+				  max_host_conns);
+#else
+		diag_set(IllegalParams, "max_host_connections requires "
+			 "libcurl 7.30.0 or newer");
+		goto error_exit;
+#endif
+	}
+
+	if (http2) {
+#if LIBCURL_VERSION_NUM >= 0x072f00
+		/* CURL_HTTP_VERSION_2TLS is available since 7.47.0 */
+		curl_version_info_data *info =
+			curl_version_info(CURLVERSION_NOW);
+		if ((info->features & CURL_VERSION_HTTP2) == 0) {
+			diag_set(IllegalParams, "libcurl was built "
+				 "without HTTP/2 support");
+			goto error_exit;
+		}
+		curl_multi_setopt(env->multi, CURLMOPT_PIPELINING,
+				  CURLPIPE_MULTIPLEX);
+#else
+		diag_set(IllegalParams, "http2 requires libcurl 7.47.0 "
+			 "or newer");
+		goto error_exit;
+#endif
+	}
+
 	return 0;
 
 error_exit:
@@ -279,6 +311,7 @@ curl_request_create(struct curl_request *curl_request)
 		return -1;
 	}
 	curl_request->in_progress = false;
+	curl_request->env = NULL;
 	curl_request->code = CURLE_OK;
 	fiber_cond_create(&curl_request->cond);
 	return 0;
@@ -287,20 +320,66 @@ curl_request_create(struct curl_request *curl_request)
 void
 curl_request_destroy(struct curl_request *curl_request)
 {
+	if (curl_request->env != NULL)
+		curl_request_finish(curl_request);
 	if (curl_request->easy != NULL)
 		curl_easy_cleanup(curl_request->easy);
 	fiber_cond_destroy(&curl_request->cond);
 }
 
+/** Set diag for a libcurl multi interface error. */
+static void
+curl_multi_error(CURLMcode mcode)
+{
+	switch (mcode) {
+	case CURLM_OUT_OF_MEMORY:
+		diag_set(OutOfMemory, 0, "curl", "internal");
+		break;
+	default:
+		errno = EINVAL;
+		diag_set(SystemError, "curl_multi_error: %s",
+			 curl_multi_strerror(mcode));
+	}
+}
+
+CURLMcode
+curl_request_start(struct curl_request *curl_request, struct curl_env *env)
+{
+	assert(curl_request->env == NULL);
+	curl_request->in_progress = true;
+	CURLMcode mcode = curl_multi_add_handle(env->multi,
+						curl_request->easy);
+	if (mcode != CURLM_OK) {
+		curl_request->in_progress = false;
+		curl_multi_error(mcode);
+		return mcode;
+	}
+	curl_request->env = env;
+	++env->stat.active_requests;
+	return CURLM_OK;
+}
+
+CURLMcode
+curl_request_finish(struct curl_request *curl_request)
+{
+	struct curl_env *env = curl_request->env;
+	assert(env != NULL);
+	curl_request->env = NULL;
+	--env->stat.active_requests;
+	CURLMcode mcode = curl_multi_remove_handle(env->multi,
+						   curl_request->easy);
+	if (mcode != CURLM_OK)
+		curl_multi_error(mcode);
+	return mcode;
+}
+
 CURLMcode
 curl_execute(struct curl_request *curl_request, struct curl_env *env,
 	     double timeout)
 {
-	CURLMcode mcode;
-	curl_request->in_progress = true;
-	mcode = curl_multi_add_handle(env->multi, curl_request->easy);
+	CURLMcode mcode = curl_request_start(curl_request, env);
 	if (mcode != CURLM_OK)
-		goto curl_merror;
+		return mcode;
 #ifndef NDEBUG
 	struct errinj *errinj = errinj(ERRINJ_HTTP_RESPONSE_ADD_WAIT,
 				       ERRINJ_BOOL);
@@ -309,27 +388,9 @@ curl_execute(struct curl_request *curl_request, struct curl_env *env,
 #endif
 	/* Don't wait on a cond if request has already failed or finished. */
 	if (curl_request->code == CURLE_OK && curl_request->in_progress) {
-		++env->stat.active_requests;
 		int rc = fiber_cond_wait_timeout(&curl_request->cond, timeout);
 		if (rc < 0 || fiber_is_cancelled())
 			curl_request->code = CURLE_OPERATION_TIMEDOUT;
-		--env->stat.active_requests;
 	}
-	mcode = curl_multi_remove_handle(env->multi, curl_request->easy);
-	if (mcode != CURLM_OK)
-		goto curl_merror;
-
-	return CURLM_OK;
-
-curl_merror:
-	switch (mcode) {
-	case CURLM_OUT_OF_MEMORY:
-		diag_set(OutOfMemory, 0, "curl", "internal");
-		break;
-	default:
-		errno = EINVAL;
-		diag_set(SystemError, "curl_multi_error: %s",
-			 curl_multi_strerror(mcode));
-	}
-	return mcode;
+	return curl_request_finish(curl_request);
 }
@@ -70,6 +70,11 @@ struct curl_request {
 	int code;
 	/** States that request is running. */
 	bool in_progress;
+	/**
+	 * Environment the request was added to by
+	 * curl_request_start(), NULL if it isn't attached.
+	 */
+	struct curl_env *env;
 	/** Information associated with a specific easy handle. */
 	CURL *easy;
 	/**
@@ -83,11 +88,16 @@ struct curl_request {
  * @brief Create a new CURL environment
  * @param env pointer to a structure to initialize
  * @param max_conn The maximum number of entries in connection cache
+ * @param max_host_conns The maximum number of connections to
+ *        a single host, 0 means unlimited
+ * @param http2 Multiplex requests to the same host over a single
+ *        HTTP/2 connection
  * @retval 0 on success
  * @retval -1 on error, check diag
  */
 int
-curl_env_create(struct curl_env *env, long max_conns);
+curl_env_create(struct curl_env *env, long max_conns, long max_host_conns,
+		bool http2);
 
 /**
  * Destroy HTTP client environment
@@ -122,4 +132,22 @@ CURLMcode
 curl_execute(struct curl_request *curl_request, struct curl_env *env,
 	     double timeout);
 
+/**
+ * Start CURL request without waiting for it to complete
+ * @param curl_request request
+ * @param env environment
+ * @details The request must be finished with curl_request_finish()
+ * once the caller is done with it.
+ */
+CURLMcode
+curl_request_start(struct curl_request *curl_request, struct curl_env *env);
+
+/**
+ * Detach CURL request started with curl_request_start() from
+ * the environment, aborting the transfer if it is still running.
+ * @param curl_request request
+ */
+CURLMcode
+curl_request_finish(struct curl_request *curl_request);
+
 #endif /* TARANTOOL_CURL_H_INCLUDED */
@@ -155,6 +155,11 @@ evio_setsockopt_server(int fd, int family, int type)
 	return 0;
 }
 
+enum {
+	/** Max number of connections accepted per loop iteration. */
+	EVIO_ACCEPT_BATCH_MAX = 64,
+};
+
 static inline const char *
 evio_service_name(struct evio_service *service)
 {
@@ -172,12 +177,14 @@ evio_service_accept_cb(ev_loop *loop, ev_io *watcher, int events)
 	(void) loop;
 	(void) events;
 	struct evio_service *service = (struct evio_service *) watcher->data;
-	int fd;
-	while (1) {
+	int fd = -1;
+	for (int i = 0; i < EVIO_ACCEPT_BATCH_MAX; i++) {
 		/*
-		 * Accept all pending connections from backlog during event
+		 * Accept pending connections from backlog during event
 		 * loop iteration. Significally speed up acceptor with enabled
-		 * io_collect_interval.
+		 * io_collect_interval. The batch is limited so that a
+		 * reconnect storm doesn't stall the rest of the loop:
+		 * the watcher fires again on the next iteration.
 		 */
 		struct sockaddr_storage addr;
 		socklen_t addrlen = sizeof(addr);
@@ -186,16 +193,18 @@ evio_service_accept_cb(ev_loop *loop, ev_io *watcher, int events)
 
 		if (fd < 0) {
 			if (! sio_wouldblock(errno))
-				break;
+				goto error;
 			return;
 		}
 		if (evio_setsockopt_client(fd, service->addr.sa_family,
 					   SOCK_STREAM) != 0)
-			break;
+			goto error;
 		if (service->on_accept(service, fd, (struct sockaddr *)&addr,
 				       addrlen) != 0)
-			break;
+			goto error;
 	}
+	return;
+error:
 	if (fd >= 0)
 		close(fd);
 	diag_log();
@@ -256,6 +265,14 @@ evio_service_bind_addr(struct evio_service *service)
 	if (evio_setsockopt_server(fd, service->addr.sa_family,
 				   SOCK_STREAM) != 0)
 		goto error;
+#ifdef SO_REUSEPORT
+	if (service->reuse_port && service->addr.sa_family != AF_UNIX) {
+		int on = 1;
+		if (sio_setsockopt(fd, SOL_SOCKET, SO_REUSEPORT,
+				   &on, sizeof(on)) != 0)
+			goto error;
+	}
+#endif
 
 	if (sio_bind(fd, &service->addr, service->addr_len)) {
 		if (errno != EADDRINUSE)
@@ -412,3 +429,54 @@ evio_service_stop(struct evio_service *service)
 		}
 	}
 }
+
+void
+evio_service_attach(struct evio_service *dst,
+		    const struct evio_service *src)
+{
+	assert(!ev_is_active(&dst->ev));
+	snprintf(dst->host, sizeof(dst->host), "%s", src->host);
+	snprintf(dst->serv, sizeof(dst->serv), "%s", src->serv);
+	memcpy(&dst->addrstorage, &src->addrstorage, src->addr_len);
+	dst->addr_len = src->addr_len;
+	dst->is_attached = true;
+	ev_io_set(&dst->ev, src->ev.fd, EV_READ);
+	ev_io_start(dst->loop, &dst->ev);
+}
+
+void
+evio_service_detach(struct evio_service *service)
+{
+	if (ev_is_active(&service->ev))
+		ev_io_stop(service->loop, &service->ev);
+	ev_io_set(&service->ev, -1, 0);
+	service->is_attached = false;
+}
+
+int
+evio_service_bind_reuseport(struct evio_service *dst,
+			    const struct evio_service *src)
+{
+	assert(!ev_is_active(&dst->ev));
+#ifdef SO_REUSEPORT
+	if (src->reuse_port && src->addr.sa_family != AF_UNIX) {
+		snprintf(dst->host, sizeof(dst->host), "%s", src->host);
+		snprintf(dst->serv, sizeof(dst->serv), "%s", src->serv);
+		/*
+		 * Use the address the socket is actually bound to:
+		 * the configured port may be 0.
+		 */
+		dst->addr_len = sizeof(dst->addrstorage);
+		if (getsockname(src->ev.fd, &dst->addr, &dst->addr_len) != 0) {
+			diag_set(SocketError, sio_socketname(src->ev.fd),
+				 "getsockname");
+			return -1;
+		}
+		dst->reuse_port = true;
+		return evio_service_bind_addr(dst);
+	}
+#endif
+	diag_set(SocketError, sio_socketname(src->ev.fd),
+		 "SO_REUSEPORT is not available");
+	return -1;
+}
@@ -95,6 +95,18 @@ struct evio_service
 	evio_accept_f on_accept;
 	void *on_accept_param;
 
+	/**
+	 * Set SO_REUSEPORT on the socket so that other services
+	 * may bind the same address, see
+	 * evio_service_bind_reuseport(). Must be set before bind.
+	 */
+	bool reuse_port;
+	/**
+	 * True if the service accepts on the socket of another
+	 * service, see evio_service_attach().
+	 */
+	bool is_attached;
+
 	/** libev io object for the acceptor socket. */
 	struct ev_io ev;
 	ev_loop *loop;
@@ -121,6 +133,31 @@ evio_service_listen(struct evio_service *service);
 void
 evio_service_stop(struct evio_service *service);
 
+/**
+ * Start accepting connections on the socket of another,
+ * already listening service. Both services must belong to
+ * the same process but may run in different event loops.
+ * Only the service which bound the socket closes it.
+ */
+void
+evio_service_attach(struct evio_service *dst,
+		    const struct evio_service *src);
+
+/** Stop accepting on an attached socket, don't close it. */
+void
+evio_service_detach(struct evio_service *service);
+
+/**
+ * Bind a socket of its own to the address another service
+ * is bound to with SO_REUSEPORT, so that the kernel spreads
+ * incoming connections between the services. @a src must
+ * have been bound with reuse_port set. Unlike an attached
+ * service, @a dst owns its socket and must be stopped.
+ */
+int
+evio_service_bind_reuseport(struct evio_service *dst,
+			    const struct evio_service *src);
+
 int
 evio_socket(struct ev_io *coio, int domain, int type, int protocol);
 
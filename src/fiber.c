@@ -36,10 +36,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <pmatomic.h>
 
+#include "affinity.h"
 #include "assoc.h"
+#include "clock.h"
 #include "memory.h"
+#include "probe.h"
 #include "trigger.h"
 
 #include "third_party/valgrind/memcheck.h"
@@ -88,6 +92,10 @@ static struct cord main_cord;
 __thread struct cord *cord_ptr = NULL;
 pthread_t main_thread_id;
 
+/** All cords with an event loop, for statistics. */
+static RLIST_HEAD(cords);
+static pthread_mutex_t cords_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 static size_t page_size;
 static int stack_direction;
 
@@ -95,7 +103,30 @@ enum {
 	/* The minimum allowable fiber stack size in bytes */
 	FIBER_STACK_SIZE_MINIMAL = 16384,
 	/* Default fiber stack size in bytes */
-	FIBER_STACK_SIZE_DEFAULT = 65536
+	FIBER_STACK_SIZE_DEFAULT = 65536,
+	/*
+	 * Stack depth in bytes beyond which the pages of
+	 * a recycled fiber stack are returned to the OS.
+	 */
+	FIBER_STACK_SIZE_WATERMARK = 65536,
+	/*
+	 * Max number of dead fibers with a custom stack size
+	 * kept for reuse, per cord.
+	 */
+	FIBER_DEAD_CUSTOM_MAX = 64
+};
+
+/**
+ * A pattern planted at the watermark depth of a fiber stack.
+ * If it is intact when the fiber is recycled, the pages
+ * beyond the watermark were not touched and there is
+ * nothing to give back to the OS.
+ */
+static const uint64_t poison_pool[] = {
+	0x74f31d37285c4c37, 0xb10269a05bf10c29,
+	0x0994d845bd284e0f, 0x9ffd4f7129c184df,
+	0x357151e6711c4415, 0x8c5e5f41aafe6f28,
+	0x6917dd79e78049d5, 0xba61957c65ca2465,
 };
 
 /** Default fiber attributes */
@@ -153,12 +184,45 @@ fiber_attr_getstacksize(struct fiber_attr *fiber_attr)
 				    fiber_attr_default.stack_size;
 }
 
+const char *fiber_wait_reason_strs[] = {
+	/* [FIBER_WAIT_OTHER]	= */ "other",
+	/* [FIBER_WAIT_SLEEP]	= */ "sleep",
+	/* [FIBER_WAIT_COND]	= */ "cond",
+	/* [FIBER_WAIT_CHANNEL]	= */ "channel",
+	/* [FIBER_WAIT_WAL]	= */ "wal",
+	/* [FIBER_WAIT_IO]	= */ "io",
+	/* [FIBER_WAIT_COIO]	= */ "coio",
+};
+
 static void
 fiber_recycle(struct fiber *fiber);
 
 static void
 fiber_destroy(struct cord *cord, struct fiber *f);
 
+static void
+fiber_stack_recycle(struct fiber *fiber);
+
+/**
+ * Account a switch from caller to callee in the profiler:
+ * the time since the caller was switched in is its CPU time,
+ * the time since the callee was switched out is its wait time
+ * for the reason it yielded with.
+ */
+static void
+fiber_prof_switch(struct cord *cord, struct fiber *caller,
+		  struct fiber *callee)
+{
+	uint64_t now = clock_monotonic64();
+	caller->prof.cpu += now - cord->prof.switch_in;
+	caller->prof.switch_out = now;
+	if (callee->prof.switch_out != 0) {
+		callee->prof.wait[callee->wait_reason] +=
+			now - callee->prof.switch_out;
+	}
+	cord->prof.switch_in = now;
+}
+
 /**
  * Transfer control to callee fiber.
  */
@@ -182,6 +246,9 @@ fiber_call_impl(struct fiber *callee)
 	assert(caller != callee);
 
 	cord->fiber = callee;
+	if (unlikely(cord->prof.is_enabled))
+		fiber_prof_switch(cord, caller, callee);
+	PROBE2(fiber_switch, caller->fid, callee->fid);
 
 	callee->flags &= ~FIBER_IS_READY;
 	callee->csw++;
@@ -435,6 +502,9 @@ fiber_yield(void)
 	assert(callee->flags & FIBER_IS_READY || callee == &cord->sched);
 	assert(! (callee->flags & FIBER_IS_DEAD));
 	cord->fiber = callee;
+	if (unlikely(cord->prof.is_enabled))
+		fiber_prof_switch(cord, caller, callee);
+	PROBE2(fiber_switch, caller->fid, callee->fid);
 	callee->csw++;
 	callee->flags &= ~FIBER_IS_READY;
 	ASAN_START_SWITCH_FIBER(asan_state,
@@ -501,7 +571,9 @@ fiber_sleep(double delay)
 	 * We don't use fiber_wakeup() here to ensure there is
 	 * no infinite wakeup loop in case of fiber_sleep(0).
 	 */
+	enum fiber_wait_reason reason = fiber_set_wait_reason(FIBER_WAIT_SLEEP);
 	fiber_yield_timeout(delay);
+	fiber_set_wait_reason(reason);
 
 	if (delay == 0) {
 		ev_idle_stop(loop(), &cord()->idle_event);
@@ -533,12 +605,15 @@ fiber_schedule_list(struct rlist *list)
 
 	first = last = rlist_shift_entry(list, struct fiber, state);
 	assert(last->flags & FIBER_IS_READY);
+	uint64_t count = 1;
 
 	while (! rlist_empty(list)) {
 		last->caller = rlist_shift_entry(list, struct fiber, state);
 		last = last->caller;
 		assert(last->flags & FIBER_IS_READY);
+		count++;
 	}
+	cord()->loop_ready += count;
 	last->caller = fiber();
 	assert(fiber() == &cord()->sched);
 	fiber_call_impl(first);
@@ -563,6 +638,88 @@ fiber_schedule_idle(ev_loop *loop, ev_idle *watcher,
 	(void) revents;
 }
 
+/** Invoked by the event loop right before polling. */
+static void
+cord_loop_prepare_cb(ev_loop *loop, ev_prepare *watcher, int revents)
+{
+	(void) loop;
+	(void) revents;
+	struct cord *cord = (struct cord *) watcher->data;
+	struct cord_loop_stat *stat = &cord->loop_stat;
+	uint64_t now = clock_monotonic64();
+	if (cord->loop_poll_end != 0) {
+		uint64_t busy = now - cord->loop_poll_end;
+		stat->iterations++;
+		stat->busy += busy;
+		if (busy > stat->busy_max)
+			stat->busy_max = busy;
+		uint64_t usec = busy / 1000;
+		int bucket = usec == 0 ? 0 : 64 - __builtin_clzll(usec);
+		if (bucket >= CORD_LOOP_HIST_SIZE)
+			bucket = CORD_LOOP_HIST_SIZE - 1;
+		stat->hist[bucket]++;
+		stat->ready += cord->loop_ready;
+		if (cord->loop_ready > stat->ready_max)
+			stat->ready_max = cord->loop_ready;
+	}
+	cord->loop_ready = 0;
+	cord->loop_poll_start = now;
+}
+
+/** Invoked by the event loop right after polling. */
+static void
+cord_loop_check_cb(ev_loop *loop, ev_check *watcher, int revents)
+{
+	(void) loop;
+	(void) revents;
+	struct cord *cord = (struct cord *) watcher->data;
+	uint64_t now = clock_monotonic64();
+	if (cord->loop_poll_start != 0)
+		cord->loop_stat.idle += now - cord->loop_poll_start;
+	cord->loop_poll_end = now;
+}
+
+/**
+ * Start collecting event loop statistics of a cord and make
+ * them visible to cord_stat_foreach().
+ */
+static void
+cord_loop_stat_start(struct cord *cord)
+{
+	memset(&cord->loop_stat, 0, sizeof(cord->loop_stat));
+	cord->loop_poll_start = 0;
+	cord->loop_poll_end = 0;
+	cord->loop_ready = 0;
+	ev_prepare_init(&cord->loop_prepare, cord_loop_prepare_cb);
+	cord->loop_prepare.data = cord;
+	ev_check_init(&cord->loop_check, cord_loop_check_cb);
+	cord->loop_check.data = cord;
+	ev_prepare_start(cord->loop, &cord->loop_prepare);
+	ev_check_start(cord->loop, &cord->loop_check);
+	/* Don't keep ev_run() running for the sake of statistics. */
+	ev_unref(cord->loop);
+	ev_unref(cord->loop);
+	tt_pthread_mutex_lock(&cords_mutex);
+	rlist_add_tail(&cords, &cord->in_cords);
+	tt_pthread_mutex_unlock(&cords_mutex);
+}
+
+int
+cord_stat_foreach(cord_stat_cb cb, void *cb_ctx)
+{
+	int rc = 0;
+	struct cord *cord;
+	tt_pthread_mutex_lock(&cords_mutex);
+	rlist_foreach_entry(cord, &cords, in_cords) {
+		struct cord_loop_stat stat = cord->loop_stat;
+		rc = cb(cord->name, &stat, cb_ctx);
+		if (rc != 0)
+			break;
+	}
+	tt_pthread_mutex_unlock(&cords_mutex);
+	return rc;
+}
+
 
 struct fiber *
 fiber_find(uint32_t fid)
@@ -628,15 +785,43 @@ fiber_recycle(struct fiber *fiber)
 	fiber->name[0] = '\0';
 	fiber->f = NULL;
 	fiber->wait_pad = NULL;
+	fiber->wait_reason = FIBER_WAIT_OTHER;
 	memset(&fiber->storage, 0, sizeof(fiber->storage));
 	unregister_fid(fiber);
 	fiber->fid = 0;
 	region_free(&fiber->gc);
+	fiber_stack_recycle(fiber);
+	struct cord *cord = cord();
 	if (!has_custom_stack) {
-		rlist_move_entry(&cord()->dead, fiber, link);
-	} else {
-		fiber_destroy(cord(), fiber);
+		rlist_move_entry(&cord->dead, fiber, link);
+		return;
+	}
+	if (cord->dead_custom_count >= FIBER_DEAD_CUSTOM_MAX) {
+		/* Free the least recently used stack. */
+		struct fiber *oldest = rlist_last_entry(&cord->dead_custom,
+							struct fiber, link);
+		fiber_destroy(cord, oldest);
+		mempool_free(&cord->fiber_mempool, oldest);
+		cord->dead_custom_count--;
+	}
+	rlist_move_entry(&cord->dead_custom, fiber, link);
+	cord->dead_custom_count++;
+}
+
+/**
+ * Find a dead fiber whose stack was created for the given
+ * custom stack size. The list is bounded by
+ * FIBER_DEAD_CUSTOM_MAX, so a linear search is cheap.
+ */
+static struct fiber *
+fiber_find_dead_custom(struct cord *cord, size_t stack_size)
+{
+	struct fiber *fiber;
+	rlist_foreach_entry(fiber, &cord->dead_custom, link) {
+		if (fiber->stack_attr_size == stack_size)
+			return fiber;
 	}
+	return NULL;
 }
 
 static void
@@ -710,9 +895,80 @@ page_align_up(void *ptr)
 	return page_align_down(ptr + page_size - 1);
 }
 
+/** Address of the watermark pattern in a fiber stack. */
+static inline uint64_t *
+fiber_stack_watermark(struct fiber *fiber)
+{
+	if (stack_direction < 0)
+		return fiber->stack + fiber->stack_size -
+		       FIBER_STACK_SIZE_WATERMARK;
+	return fiber->stack + FIBER_STACK_SIZE_WATERMARK - sizeof(poison_pool);
+}
+
+/**
+ * Check whether the stack is big enough to be trimmed
+ * down to the watermark on recycle.
+ */
+static inline bool
+fiber_stack_is_trimmable(struct fiber *fiber)
+{
+#if ENABLE_ASAN
+	/* Shadow memory tracks stack frames, don't touch it. */
+	(void)fiber;
+	return false;
+#else
+	return fiber->stack_size > FIBER_STACK_SIZE_WATERMARK + page_size;
+#endif
+}
+
+static inline void
+fiber_stack_poison(struct fiber *fiber)
+{
+	if (fiber_stack_is_trimmable(fiber))
+		memcpy(fiber_stack_watermark(fiber), poison_pool,
+		       sizeof(poison_pool));
+}
+
+/**
+ * Return the pages of a recycled fiber stack lying deeper
+ * than the watermark to the OS, provided the fiber used
+ * them, and plant the watermark pattern anew. Called on the
+ * stack being recycled, which is shallow at this point.
+ */
+static void
+fiber_stack_recycle(struct fiber *fiber)
+{
+	if (!fiber_stack_is_trimmable(fiber))
+		return;
+	uint64_t *watermark = fiber_stack_watermark(fiber);
+	if (memcmp(watermark, poison_pool, sizeof(poison_pool)) == 0)
+		return;
+	void *start, *end;
+	if (stack_direction < 0) {
+		start = fiber->stack;
+		end = page_align_down(watermark);
+	} else {
+		start = page_align_up(watermark + lengthof(poison_pool));
+		end = fiber->stack + fiber->stack_size;
+	}
+	if (start < end) {
+#ifdef MADV_FREE
+		int advice = MADV_FREE;
+#else
+		int advice = MADV_DONTNEED;
+#endif
+		/* MADV_FREE may be unsupported by the kernel. */
+		if (madvise(start, end - start, advice) != 0 &&
+		    advice != MADV_DONTNEED)
+			madvise(start, end - start, MADV_DONTNEED);
+	}
+	fiber_stack_poison(fiber);
+}
+
 static int
 fiber_stack_create(struct fiber *fiber, size_t stack_size)
 {
+	fiber->stack_attr_size = stack_size;
 	stack_size -= slab_sizeof();
 	fiber->stack_slab = slab_get(&cord()->slabc, stack_size);
 
@@ -751,6 +1007,7 @@ fiber_stack_create(struct fiber *fiber, size_t stack_size)
 						  fiber->stack_size);
 
 	mprotect(guard, page_size, PROT_NONE);
+	fiber_stack_poison(fiber);
 	return 0;
 }
 
@@ -780,12 +1037,18 @@ fiber_new_ex(const char *name, const struct fiber_attr *fiber_attr,
 	struct fiber *fiber = NULL;
 	assert(fiber_attr != NULL);
 
-	/* Now we can not reuse fiber if custom attribute was set */
 	if (!(fiber_attr->flags & FIBER_CUSTOM_STACK) &&
 	    !rlist_empty(&cord->dead)) {
 		fiber = rlist_first_entry(&cord->dead,
 					  struct fiber, link);
 		rlist_move_entry(&cord->alive, fiber, link);
+	} else if ((fiber_attr->flags & FIBER_CUSTOM_STACK) &&
+		   (fiber = fiber_find_dead_custom(cord,
+					fiber_attr->stack_size)) != NULL) {
+		/* The stack is already guarded, just reuse it. */
+		rlist_move_entry(&cord->alive, fiber, link);
+		cord->dead_custom_count--;
+		fiber->flags = fiber_attr->flags;
 	} else {
 		fiber = (struct fiber *)
 			mempool_alloc(&cord->fiber_mempool);
@@ -816,6 +1079,11 @@ fiber_new_ex(const char *name, const struct fiber_attr *fiber_attr,
 	}
 
 	fiber->f = f;
+	/*
+	 * Not done on recycle: a recycled fiber is still
+	 * accounted when it yields for the last time.
+	 */
+	memset(&fiber->prof, 0, sizeof(fiber->prof));
 	/* fids from 0 to 100 are reserved */
 	if (++cord->max_fid < 100)
 		cord->max_fid = 101;
@@ -878,6 +1146,10 @@ fiber_destroy_all(struct cord *cord)
 	while (!rlist_empty(&cord->dead))
 		fiber_destroy(cord, rlist_first_entry(&cord->dead,
 						      struct fiber, link));
+	while (!rlist_empty(&cord->dead_custom))
+		fiber_destroy(cord, rlist_first_entry(&cord->dead_custom,
+						      struct fiber, link));
+	cord->dead_custom_count = 0;
 }
 
 void
@@ -894,6 +1166,8 @@ cord_create(struct cord *cord, const char *name)
 	rlist_create(&cord->alive);
 	rlist_create(&cord->ready);
 	rlist_create(&cord->dead);
+	rlist_create(&cord->dead_custom);
+	cord->dead_custom_count = 0;
 	cord->fiber_registry = mh_i32ptr_new();
 
 	/* sched fiber is not present in alive/ready/dead list. */
@@ -914,6 +1188,12 @@ cord_create(struct cord *cord, const char *name)
 
 	ev_idle_init(&cord->idle_event, fiber_schedule_idle);
 	cord_set_name(name);
+	cord_affinity_apply(name);
+
+	rlist_create(&cord->in_cords);
+	/* Cords of the coio thread pool have no event loop. */
+	if (cord->loop != NULL)
+		cord_loop_stat_start(cord);
 
 #if ENABLE_ASAN
 	/* Record stack extents */
@@ -929,6 +1209,9 @@ void
 cord_destroy(struct cord *cord)
 {
 	slab_cache_set_thread(&cord->slabc);
+	tt_pthread_mutex_lock(&cords_mutex);
+	rlist_del(&cord->in_cords);
+	tt_pthread_mutex_unlock(&cords_mutex);
 	if (cord->loop)
 		ev_loop_destroy(cord->loop);
 	/* Only clean up if initialized. */
@@ -1243,6 +1526,52 @@ fiber_free(void)
 	cord_destroy(&main_cord);
 }
 
+void
+fiber_prof_reset(void)
+{
+	struct cord *cord = cord();
+	uint64_t now = cord->prof.is_enabled ? clock_monotonic64() : 0;
+	struct fiber *fiber;
+	rlist_foreach_entry(fiber, &cord->alive, link) {
+		memset(&fiber->prof, 0, sizeof(fiber->prof));
+		fiber->prof.switch_out = now;
+	}
+	memset(&cord->sched.prof, 0, sizeof(cord->sched.prof));
+	cord->sched.prof.switch_out = now;
+	/* The current fiber is running, not waiting. */
+	fiber()->prof.switch_out = 0;
+	cord->prof.start = now;
+	cord->prof.stop = now;
+	cord->prof.switch_in = now;
+}
+
+void
+fiber_prof_enable(bool yesno)
+{
+	struct cord *cord = cord();
+	if (cord->prof.is_enabled == yesno)
+		return;
+	if (yesno) {
+		cord->prof.is_enabled = true;
+		fiber_prof_reset();
+		return;
+	}
+	/* Account the current fiber up to now. */
+	uint64_t now = clock_monotonic64();
+	fiber()->prof.cpu += now - cord->prof.switch_in;
+	cord->prof.stop = now;
+	cord->prof.is_enabled = false;
+}
+
+uint64_t
+fiber_prof_elapsed(void)
+{
+	struct cord *cord = cord();
+	uint64_t now = cord->prof.is_enabled ? clock_monotonic64() :
+					       cord->prof.stop;
+	return now - cord->prof.start;
+}
+
 int fiber_stat(fiber_stat_cb cb, void *cb_ctx)
 {
 	struct fiber *fiber;
@@ -92,6 +92,31 @@ enum {
 	FIBER_DEFAULT_FLAGS = FIBER_IS_CANCELLABLE
 };
 
+/**
+ * What a fiber is waiting for when it yields. Used by the
+ * fiber profiler to break down the time a fiber spends off
+ * CPU.
+ */
+enum fiber_wait_reason {
+	/** Any yield not attributed to a specific reason. */
+	FIBER_WAIT_OTHER,
+	/** fiber_sleep(). */
+	FIBER_WAIT_SLEEP,
+	/** A condition variable. */
+	FIBER_WAIT_COND,
+	/** A fiber channel put or get. */
+	FIBER_WAIT_CHANNEL,
+	/** A WAL write. */
+	FIBER_WAIT_WAL,
+	/** Socket readiness in the event loop. */
+	FIBER_WAIT_IO,
+	/** A task in the coio thread pool. */
+	FIBER_WAIT_COIO,
+	fiber_wait_reason_MAX
+};
+
+extern const char *fiber_wait_reason_strs[];
+
 /** \cond public */
 
 /**
@@ -174,8 +199,9 @@ fiber_new(const char *name, fiber_func f);
  * the fiber structure or fiber stack.
  *
  * The created fiber automatically returns itself
- * to the fiber cache if has default stack size
- * when its "main" function completes.
+ * to the fiber cache when its "main" function completes.
+ * Fibers with a custom stack size are reused only by
+ * fibers requesting the same stack size.
  *
  * \param name       string with fiber name
  * \param fiber_attr fiber attributes
@@ -350,6 +376,11 @@ struct fiber {
 	void *stack;
 	/** Coro stack size. */
 	size_t stack_size;
+	/**
+	 * Stack size requested in fiber attributes, used to
+	 * find a dead fiber with a suitable custom stack.
+	 */
+	size_t stack_attr_size;
 	/** Valgrind stack id. */
 	unsigned int stack_id;
 	/* A garbage-collected memory pool. */
@@ -365,7 +396,7 @@ struct fiber {
 	uint32_t fid;
 	/** Fiber flags */
 	uint32_t flags;
-	/** Link in cord->alive or cord->dead list. */
+	/** Link in cord->alive, cord->dead or cord->dead_custom list. */
 	struct rlist link;
 	/** Link in cord->ready list. */
 	struct rlist state;
@@ -399,12 +430,15 @@ struct fiber {
 		struct credentials *credentials;
 		struct txn *txn;
 		/**
-		 * Lua stack and the optional
-		 * fiber.storage Lua reference.
+		 * Lua stack, the optional fiber.storage Lua
+		 * reference and the number of bytes allocated
+		 * on the Lua heap by the fiber (maintained only
+		 * by the small Lua allocator, see lua/alloc.h).
 		 */
 		struct {
 			struct lua_State *stack;
 			int ref;
+			uint64_t alloc;
 		} lua;
 		/**
 		 * Iproto sync.
@@ -412,9 +446,28 @@ struct fiber {
 		struct {
 			uint64_t sync;
 		} net;
+		/**
+		 * Time spent waiting for WAL by the request
+		 * being processed, in seconds.
+		 */
+		double wal_wait;
 	} storage;
 	/** An object to wait for incoming message or a reader. */
 	struct ipc_wait_pad *wait_pad;
+	/** What the fiber is waiting for when it yields. */
+	enum fiber_wait_reason wait_reason;
+	/**
+	 * Profiler counters, in nanoseconds. Maintained only
+	 * while the profiler is enabled in the fiber's cord.
+	 */
+	struct {
+		/** Time spent running. */
+		uint64_t cpu;
+		/** Time spent off CPU, by wait reason. */
+		uint64_t wait[fiber_wait_reason_MAX];
+		/** When the fiber was last switched out, or 0. */
+		uint64_t switch_out;
+	} prof;
 	/** Exception which caused this fiber's death. */
 	struct diag diag;
 	char name[FIBER_NAME_MAX];
@@ -422,6 +475,38 @@ struct fiber {
 
 enum { FIBER_CALL_STACK = 16 };
 
+enum {
+	/**
+	 * Number of buckets in the histogram of event loop
+	 * iteration time. Bucket i counts iterations shorter
+	 * than 2^i microseconds, the last one counts the rest.
+	 */
+	CORD_LOOP_HIST_SIZE = 24,
+};
+
+/**
+ * Event loop statistics of a cord. Updated by the cord itself
+ * once per event loop iteration and read by other threads
+ * without synchronization, so a snapshot may be slightly
+ * inconsistent.
+ */
+struct cord_loop_stat {
+	/** Number of event loop iterations. */
+	uint64_t iterations;
+	/** Time spent handling events, in nanoseconds. */
+	uint64_t busy;
+	/** Time spent waiting for events, in nanoseconds. */
+	uint64_t idle;
+	/** The longest iteration, in nanoseconds. */
+	uint64_t busy_max;
+	/** Number of fibers scheduled, summed over iterations. */
+	uint64_t ready;
+	/** Max number of fibers scheduled in one iteration. */
+	uint64_t ready_max;
+	/** Histogram of iteration time, without waiting. */
+	uint64_t hist[CORD_LOOP_HIST_SIZE];
+};
+
 struct cord_on_exit;
 
 /**
@@ -448,6 +533,10 @@ struct cord {
 	struct rlist ready;
 	/** A cache of dead fibers for reuse */
 	struct rlist dead;
+	/** A cache of dead fibers with a custom stack size */
+	struct rlist dead_custom;
+	/** Number of fibers in the dead_custom list */
+	int dead_custom_count;
 	/** A watcher to have a single async event for all ready fibers.
 	 * This technique is necessary to be able to suspend
 	 * a single fiber on a few watchers (for example,
@@ -469,6 +558,29 @@ struct cord {
 	struct slab_cache slabc;
 	/** The "main" fiber of this cord, the scheduler. */
 	struct fiber sched;
+	/** The fiber profiler state. */
+	struct {
+		/** Set if fiber switches are being accounted. */
+		bool is_enabled;
+		/** When the profiler was enabled or reset. */
+		uint64_t start;
+		/** When the profiler was disabled. */
+		uint64_t stop;
+		/** When the current fiber was switched in. */
+		uint64_t switch_in;
+	} prof;
+	/** Event loop statistics. */
+	struct cord_loop_stat loop_stat;
+	/** Watchers invoked before and after polling for events. */
+	ev_prepare loop_prepare;
+	ev_check loop_check;
+	/** When the loop last stopped and started polling. */
+	uint64_t loop_poll_end;
+	uint64_t loop_poll_start;
+	/** Fibers scheduled in the current iteration. */
+	uint64_t loop_ready;
+	/** Link in the list of all cords with an event loop. */
+	struct rlist in_cords;
 	char name[FIBER_NAME_MAX];
 };
 
@@ -550,6 +662,18 @@ cord_name(struct cord *cord)
 bool
 cord_is_main();
 
+typedef int (*cord_stat_cb)(const char *name,
+			    const struct cord_loop_stat *stat, void *ctx);
+
+/**
+ * Invoke a callback with the event loop statistics of every
+ * cord which has an event loop. Stops at the first callback
+ * returning non-zero and returns its value. The callback is
+ * invoked under a lock and must not yield.
+ */
+int
+cord_stat_foreach(cord_stat_cb cb, void *cb_ctx);
+
 void
 fiber_init(int (*fiber_invoke)(fiber_func f, va_list ap));
 
@@ -601,6 +725,45 @@ fiber_is_dead(struct fiber *f)
 	return f->flags & FIBER_IS_DEAD;
 }
 
+/**
+ * Set the reason the current fiber is going to wait for
+ * and return the previous one. Like fiber_set_cancellable(),
+ * meant to wrap a yield and be restored after it.
+ */
+static inline enum fiber_wait_reason
+fiber_set_wait_reason(enum fiber_wait_reason reason)
+{
+	struct fiber *f = fiber();
+	enum fiber_wait_reason prev = f->wait_reason;
+	f->wait_reason = reason;
+	return prev;
+}
+
+/**
+ * Enable or disable the fiber profiler in the current cord.
+ * While it is enabled, every fiber switch reads the monotonic
+ * clock to account the time each fiber spends running and
+ * waiting, see struct fiber::prof. Enabling the profiler
+ * resets all counters.
+ */
+void
+fiber_prof_enable(bool yesno);
+
+/**
+ * Reset the profiler counters of all fibers in the cord.
+ * Counters are kept after the profiler is disabled until
+ * it is reset or enabled again.
+ */
+void
+fiber_prof_reset(void);
+
+/**
+ * Nanoseconds the profiler has been collecting the current
+ * counters for.
+ */
+uint64_t
+fiber_prof_elapsed(void);
+
 typedef int (*fiber_stat_cb)(struct fiber *f, void *ctx);
 
 int
@@ -46,7 +46,16 @@ enum fiber_channel_wait_status {
  * an incoming message or a reader.
  */
 struct ipc_wait_pad {
-	struct ipc_msg *msg;
+	/**
+	 * A waiting writer: the message it offers, in msgs[0].
+	 * A waiting reader: the array to store messages handed
+	 * over to it by writers.
+	 */
+	struct ipc_msg **msgs;
+	/** How many messages a waiting reader can take. */
+	uint32_t size;
+	/** How many messages are handed over to the reader. */
+	uint32_t count;
 	enum fiber_channel_wait_status status;
 };
 
@@ -280,27 +289,27 @@ fiber_channel_get_timeout(struct fiber_channel *ch, void **data,
 	return rc;
 }
 
-int
-fiber_channel_put_msg_timeout(struct fiber_channel *ch,
-			    struct ipc_msg *msg,
-			    ev_tstamp timeout)
+/**
+ * Send as many of @a count messages as possible without
+ * waiting: fill the wait pads of readers, then the buffer.
+ * A reader waiting for several messages gets as many as it
+ * can take with a single wakeup.
+ *
+ * @return the number of messages sent, which is 0 if the
+ *         caller has to wait, or -1 if the channel is closed.
+ */
+static int
+fiber_channel_try_put(struct fiber_channel *ch, struct ipc_msg **msgs,
+		      uint32_t count)
 {
-	/** Ensure delivery fairness in case of prolonged wait. */
-	bool first_try = true;
-	ev_tstamp start_time = ev_monotonic_now(loop());
-
-	while (true) {
+	uint32_t sent = 0;
+	while (sent < count) {
 		/*
 		 * Check if there is a ready reader first, and
 		 * only if there is no reader try to put a message
 		 * into the channel buffer.
 		 */
 		if (fiber_channel_has_readers(ch)) {
-			/**
-			 * There is a reader, push the message
-			 * immediately.
-			 */
-
 			/*
 			 * There can be no reader if there is
 			 * a buffered message or the channel is
@@ -312,29 +321,55 @@ fiber_channel_put_msg_timeout(struct fiber_channel *ch,
 			struct fiber *f = rlist_first_entry(&ch->waiters,
 							    struct fiber,
 							    state);
-			/* Place the message on the pad. */
-			f->wait_pad->msg = msg;
-
+			/* Place the messages on the pad. */
+			struct ipc_wait_pad *pad = f->wait_pad;
+			while (sent < count && pad->count < pad->size)
+				pad->msgs[pad->count++] = msgs[sent++];
 			fiber_channel_waiter_wakeup(f, FIBER_CHANNEL_WAIT_DONE);
-			return 0;
+			continue;
 		}
 		if (ch->count < ch->size) {
-			/*
-			 * No reader, but the channel is buffered.
-			 * Nice, drop the message in the buffer.
-			 */
-
 			/*
 			 * Closed channels, are, well, closed,
 			 * even if there is space in the buffer.
 			 */
 			if (ch->is_closed) {
+				if (sent > 0)
+					break;
 				diag_set(ChannelIsClosed);
 				return -1;
 			}
-			fiber_channel_buffer_push(ch, msg);
-			return 0;
+			fiber_channel_buffer_push(ch, msgs[sent++]);
+			continue;
 		}
+		break;
+	}
+	return sent;
+}
+
+int
+fiber_channel_put_msg_timeout(struct fiber_channel *ch,
+			    struct ipc_msg *msg,
+			    ev_tstamp timeout)
+{
+	return fiber_channel_put_msg_many_timeout(ch, &msg, 1, timeout) < 0 ?
+	       -1 : 0;
+}
+
+int
+fiber_channel_put_msg_many_timeout(struct fiber_channel *ch,
+				   struct ipc_msg **msgs, uint32_t count,
+				   ev_tstamp timeout)
+{
+	assert(count > 0);
+	/** Ensure delivery fairness in case of prolonged wait. */
+	bool first_try = true;
+	ev_tstamp start_time = ev_monotonic_now(loop());
+
+	while (true) {
+		int sent = fiber_channel_try_put(ch, msgs, count);
+		if (sent != 0)
+			return sent;
 		/**
 		 * No reader and no space in the buffer.
 		 * Have to wait.
@@ -347,7 +382,8 @@ fiber_channel_put_msg_timeout(struct fiber_channel *ch,
 		/* Prepare a wait pad. */
 		struct ipc_wait_pad pad;
 		pad.status = FIBER_CHANNEL_WAIT_WRITER;
-		pad.msg = msg;
+		pad.msgs = msgs;
+		pad.size = pad.count = 1;
 		f->wait_pad = &pad;
 
 		if (first_try) {
@@ -356,7 +392,10 @@ fiber_channel_put_msg_timeout(struct fiber_channel *ch,
 		} else {
 			rlist_add_entry(&ch->waiters, f, state);
 		}
+		enum fiber_wait_reason reason =
+			fiber_set_wait_reason(FIBER_WAIT_CHANNEL);
 		fiber_yield_timeout(timeout);
+		fiber_set_wait_reason(reason);
 		/*
 		 * In case of yield timeout, fiber->state
 		 * is in the ch->waiters list, remove.
@@ -374,22 +413,30 @@ fiber_channel_put_msg_timeout(struct fiber_channel *ch,
 			diag_set(ChannelIsClosed);
 			return -1;
 		}
+		/*
+		 * OK, someone took the first message. The rest
+		 * is left to the caller: the channel may be
+		 * gone by now.
+		 */
 		if (pad.status == FIBER_CHANNEL_WAIT_DONE)
-			return 0;  /* OK, someone took the message. */
+			return 1;
 		timeout -= ev_monotonic_now(loop()) - start_time;
 	}
 }
 
-int
-fiber_channel_get_msg_timeout(struct fiber_channel *ch,
-			    struct ipc_msg **msg,
-			    ev_tstamp timeout)
+/**
+ * Take up to @a size messages without waiting: from the
+ * buffer first, then from waiting writers.
+ *
+ * @return the number of messages received, 0 if the caller
+ *         has to wait.
+ */
+static int
+fiber_channel_try_get(struct fiber_channel *ch, struct ipc_msg **msgs,
+		      uint32_t size)
 {
-	/** Ensure delivery fairness in case of prolonged wait. */
-	bool first_try = true;
-	ev_tstamp start_time = ev_monotonic_now(loop());
-
-	while (true) {
+	uint32_t got = 0;
+	while (got < size) {
 		struct fiber *f;
 		/*
 		 * Buffered messages take priority over waiting
@@ -404,7 +451,7 @@ fiber_channel_get_msg_timeout(struct fiber_channel *ch,
 			 */
 			assert(ch->is_closed == false);
 
-			*msg = fiber_channel_buffer_pop(ch);
+			msgs[got++] = fiber_channel_buffer_pop(ch);
 
 			if (fiber_channel_has_writers(ch)) {
 				/*
@@ -416,11 +463,12 @@ fiber_channel_get_msg_timeout(struct fiber_channel *ch,
 				f = rlist_first_entry(&ch->waiters,
 						      struct fiber,
 						      state);
-				fiber_channel_buffer_push(ch, f->wait_pad->msg);
+				fiber_channel_buffer_push(ch,
+							  f->wait_pad->msgs[0]);
 				fiber_channel_waiter_wakeup(f,
 					FIBER_CHANNEL_WAIT_DONE);
 			}
-			return 0;
+			continue;
 		}
 		if (fiber_channel_has_writers(ch)) {
 			/**
@@ -435,19 +483,50 @@ fiber_channel_get_msg_timeout(struct fiber_channel *ch,
 			f = rlist_first_entry(&ch->waiters,
 					      struct fiber,
 					      state);
-			*msg = f->wait_pad->msg;
+			msgs[got++] = f->wait_pad->msgs[0];
 			fiber_channel_waiter_wakeup(f, FIBER_CHANNEL_WAIT_DONE);
-			return 0;
+			continue;
 		}
+		break;
+	}
+	return got;
+}
+
+int
+fiber_channel_get_msg_timeout(struct fiber_channel *ch,
+			    struct ipc_msg **msg,
+			    ev_tstamp timeout)
+{
+	return fiber_channel_get_msg_many_timeout(ch, msg, 1, timeout) < 0 ?
+	       -1 : 0;
+}
+
+int
+fiber_channel_get_msg_many_timeout(struct fiber_channel *ch,
+				   struct ipc_msg **msgs, uint32_t size,
+				   ev_tstamp timeout)
+{
+	assert(size > 0);
+	/** Ensure delivery fairness in case of prolonged wait. */
+	bool first_try = true;
+	ev_tstamp start_time = ev_monotonic_now(loop());
+
+	while (true) {
+		int got = fiber_channel_try_get(ch, msgs, size);
+		if (got > 0)
+			return got;
 		if (fiber_channel_check_wait(ch, start_time, timeout))
 			return -1;
-		f = fiber();
+		struct fiber *f = fiber();
 		/**
 		 * No reader and no space in the buffer.
 		 * Have to wait.
 		 */
 		struct ipc_wait_pad pad;
 		pad.status = FIBER_CHANNEL_WAIT_READER;
+		pad.msgs = msgs;
+		pad.size = size;
+		pad.count = 0;
 		f->wait_pad = &pad;
 		if (first_try) {
 			rlist_add_tail_entry(&ch->waiters, f, state);
@@ -455,7 +534,10 @@ fiber_channel_get_msg_timeout(struct fiber_channel *ch,
 		} else {
 			rlist_add_entry(&ch->waiters, f, state);
 		}
+		enum fiber_wait_reason reason =
+			fiber_set_wait_reason(FIBER_WAIT_CHANNEL);
 		fiber_yield_timeout(timeout);
+		fiber_set_wait_reason(reason);
 		/*
 		 * In case of yield timeout, fiber->state
 		 * is in the ch->waiters list, remove.
@@ -468,8 +550,8 @@ fiber_channel_get_msg_timeout(struct fiber_channel *ch,
 			return -1;
 		}
 		if (pad.status == FIBER_CHANNEL_WAIT_DONE) {
-			*msg = pad.msg;
-			return 0;
+			assert(pad.count > 0);
+			return pad.count;
 		}
 		timeout -= ev_monotonic_now(loop()) - start_time;
 	}
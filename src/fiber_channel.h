@@ -237,6 +237,21 @@ fiber_channel_put_msg_timeout(struct fiber_channel *ch,
 			    struct ipc_msg *msg,
 			    ev_tstamp timeout);
 
+/**
+ * Put up to @a count messages into a channel, waiting no
+ * longer than @a timeout for the first one to be accepted.
+ * The rest are sent only if it's possible without waiting.
+ * A reader blocked in fiber_channel_get_msg_many_timeout()
+ * takes as many messages as it asked for with one wakeup.
+ * Unsent messages stay owned by the caller.
+ * @return the number of messages sent, or -1 on error
+ *         (timeout, channel is closed, fiber is cancelled).
+ */
+int
+fiber_channel_put_msg_many_timeout(struct fiber_channel *ch,
+				   struct ipc_msg **msgs, uint32_t count,
+				   ev_tstamp timeout);
+
 /**
  * Send a message over a channel within given time.
  *
@@ -284,6 +299,20 @@ int
 fiber_channel_get_msg_timeout(struct fiber_channel *ch,
 			    struct ipc_msg **msg,
 			    ev_tstamp timeout);
+/**
+ * Get up to @a size messages from the channel, waiting no
+ * longer than @a timeout for the first one. Once there is
+ * something to read, all messages available without waiting
+ * are taken at once.
+ * The caller is responsible for message destruction.
+ * @return the number of messages received, or -1 on error
+ *         (timeout, channel is closed, fiber is cancelled).
+ */
+int
+fiber_channel_get_msg_many_timeout(struct fiber_channel *ch,
+				   struct ipc_msg **msgs, uint32_t size,
+				   ev_tstamp timeout);
+
 /**
  * Get data from a channel within given time.
  *
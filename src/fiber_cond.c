@@ -104,7 +104,10 @@ fiber_cond_wait_timeout(struct fiber_cond *c, double timeout)
 {
 	struct fiber *f = fiber();
 	rlist_add_tail_entry(&c->waiters, f, state);
-	if (fiber_yield_timeout(timeout)) {
+	enum fiber_wait_reason reason = fiber_set_wait_reason(FIBER_WAIT_COND);
+	bool timed_out = fiber_yield_timeout(timeout);
+	fiber_set_wait_reason(reason);
+	if (timed_out) {
 		diag_set(TimedOut);
 		return -1;
 	}
@@ -89,6 +89,13 @@ histogram_discard(struct histogram *hist, int64_t val);
 int64_t
 histogram_percentile(struct histogram *hist, int pct);
 
+/**
+ * Same as histogram_percentile(), but the rank is given in
+ * permilles, e.g. 999 stands for the 99.9th percentile.
+ */
+int64_t
+histogram_permille(struct histogram *hist, int permille);
+
 /**
  * Same as histogram_percentile(), but return a lower bound
  * estimate of the percentile.
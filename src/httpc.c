@@ -39,6 +39,38 @@
 
 #define MAX_HEADER_LEN 8192
 
+/**
+ * Max size of a streamed response body buffered before
+ * the transfer is paused, see httpc_set_stream().
+ */
+#define HTTPC_STREAM_BUF_SIZE (64 * 1024)
+
+/**
+ * Append a chunk of a streamed response body to the buffer
+ * and wake up the reader, see httpc_read().
+ */
+static size_t
+httpc_stream_write(struct httpc_request *req, char *ptr, size_t bytes)
+{
+	if (ibuf_used(&req->stream_buf) >= HTTPC_STREAM_BUF_SIZE) {
+		/*
+		 * The reader doesn't keep up. Pause the transfer,
+		 * libcurl will pass the same data to us again
+		 * when it is resumed.
+		 */
+		req->stream_paused = true;
+		return CURL_WRITEFUNC_PAUSE;
+	}
+	char *p = ibuf_alloc(&req->stream_buf, bytes);
+	if (p == NULL) {
+		diag_set(OutOfMemory, bytes, "ibuf", "httpc body");
+		return 0;
+	}
+	memcpy(p, ptr, bytes);
+	fiber_cond_signal(&req->curl_request.cond);
+	return bytes;
+}
+
 /**
  * libcurl callback for CURLOPT_WRITEFUNCTION
  * @see https://curl.haxx.se/libcurl/c/CURLOPT_WRITEFUNCTION.html
@@ -49,6 +81,9 @@ curl_easy_write_cb(char *ptr, size_t size, size_t nmemb, void *ctx)
 	struct httpc_request *req = (struct httpc_request *) ctx;
 	const size_t bytes = size * nmemb;
 
+	if (req->stream)
+		return httpc_stream_write(req, ptr, bytes);
+
 	char *p = region_alloc(&req->resp_body, bytes);
 	if (p == NULL) {
 		diag_set(OutOfMemory, bytes, "ibuf", "httpc body");
@@ -77,13 +112,20 @@ curl_easy_header_cb(char *buffer, size_t size, size_t nitems, void *ctx)
 }
 
 int
-httpc_env_create(struct httpc_env *env, int max_conns)
+httpc_env_create(struct httpc_env *env, int max_conns, int max_host_conns,
+		 bool http2)
 {
 	memset(env, 0, sizeof(*env));
 	mempool_create(&env->req_pool, &cord()->slabc,
 			sizeof(struct httpc_request));
+	env->http2 = http2;
 
-	return curl_env_create(&env->curl_env, max_conns);
+	if (curl_env_create(&env->curl_env, max_conns, max_host_conns,
+			    http2) != 0) {
+		mempool_destroy(&env->req_pool);
+		return -1;
+	}
+	return 0;
 }
 
 void
@@ -146,10 +188,23 @@ httpc_request_new(struct httpc_env *env, const char *method,
 	curl_easy_setopt(req->curl_request.easy, CURLOPT_HEADERFUNCTION,
 			 curl_easy_header_cb);
 	curl_easy_setopt(req->curl_request.easy, CURLOPT_NOPROGRESS, 1L);
+	long http_version = CURL_HTTP_VERSION_1_1;
+#if LIBCURL_VERSION_NUM >= 0x072f00
+	if (env->http2) {
+		http_version = CURL_HTTP_VERSION_2TLS;
+		/*
+		 * Wait for a pending connection to the same host to
+		 * find out if it can be multiplexed instead of opening
+		 * a new one.
+		 */
+		curl_easy_setopt(req->curl_request.easy, CURLOPT_PIPEWAIT, 1L);
+	}
+#endif
 	curl_easy_setopt(req->curl_request.easy, CURLOPT_HTTP_VERSION,
-			 CURL_HTTP_VERSION_1_1);
+			 http_version);
 
 	ibuf_create(&req->body, &cord()->slabc, 1);
+	ibuf_create(&req->stream_buf, &cord()->slabc, HTTPC_STREAM_BUF_SIZE);
 
 	return req;
 error:
@@ -166,6 +221,7 @@ httpc_request_delete(struct httpc_request *req)
 	curl_request_destroy(&req->curl_request);
 
 	ibuf_destroy(&req->body);
+	ibuf_destroy(&req->stream_buf);
 	region_destroy(&req->resp_headers);
 	region_destroy(&req->resp_body);
 
@@ -228,11 +284,16 @@ httpc_set_keepalive(struct httpc_request *req, long idle, long interval)
 				     (int) idle) < 0) {
 			return -1;
 		}
-	} else {
-		if (httpc_set_header(req, "Connection: close") < 0) {
-			return -1;
-		}
 	}
+	/*
+	 * Don't send "Connection: close" otherwise: HTTP/1.1
+	 * connections are persistent by default and are returned
+	 * to the connection cache of the multi handle, see
+	 * CURLMOPT_MAXCONNECTS, to be reused by the next request
+	 * to the same host. Closing them would cost a TCP (and
+	 * possibly TLS) handshake per request and leave a socket
+	 * in TIME_WAIT.
+	 */
 #else
 	(void) req;
 	(void) idle;
@@ -318,6 +379,64 @@ httpc_set_interface(struct httpc_request *req, const char *interface)
 	curl_easy_setopt(req->curl_request.easy, CURLOPT_INTERFACE, interface);
 }
 
+void
+httpc_set_stream(struct httpc_request *req)
+{
+	req->stream = true;
+}
+
+/**
+ * Start a request in the streaming mode and wait until
+ * the response starts, i.e. the first chunk of the body
+ * is received, or the request completes.
+ */
+static int
+httpc_start_stream(struct httpc_request *req, double timeout)
+{
+	struct curl_request *curl_request = &req->curl_request;
+	if (curl_request_start(curl_request,
+			       &req->env->curl_env) != CURLM_OK)
+		return -1;
+	double deadline = ev_monotonic_now(loop()) + timeout;
+	while (curl_request->in_progress &&
+	       ibuf_used(&req->stream_buf) == 0) {
+		if (fiber_cond_wait_deadline(&curl_request->cond,
+					     deadline) != 0 ||
+		    fiber_is_cancelled()) {
+			curl_request->code = CURLE_OPERATION_TIMEDOUT;
+			/* Abort the transfer. */
+			curl_request->in_progress = false;
+			curl_request_finish(curl_request);
+			break;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Update connection cache statistics after a request completes.
+ */
+static void
+httpc_account_connection(struct httpc_request *req)
+{
+	struct httpc_stat *stat = &req->env->stat;
+	long num_connects = 0;
+	curl_easy_getinfo(req->curl_request.easy, CURLINFO_NUM_CONNECTS,
+			  &num_connects);
+	if (num_connects == 0) {
+		if (req->curl_request.code == CURLE_OK)
+			++stat->connections_reused;
+		return;
+	}
+	stat->connections_opened += num_connects;
+	/* Application layer connect time is only set for TLS. */
+	double appconnect_time = 0;
+	curl_easy_getinfo(req->curl_request.easy, CURLINFO_APPCONNECT_TIME,
+			  &appconnect_time);
+	if (appconnect_time > 0)
+		++stat->tls_handshakes;
+}
+
 int
 httpc_execute(struct httpc_request *req, double timeout)
 {
@@ -330,8 +449,14 @@ httpc_execute(struct httpc_request *req, double timeout)
 
 	++env->stat.total_requests;
 
-	if (curl_execute(&req->curl_request, &env->curl_env, timeout) != CURLM_OK)
+	if (req->stream) {
+		if (httpc_start_stream(req, timeout) != 0)
+			return -1;
+	} else if (curl_execute(&req->curl_request, &env->curl_env,
+				timeout) != CURLM_OK) {
 		return -1;
+	}
+	httpc_account_connection(req);
 	ERROR_INJECT_RETURN(ERRINJ_HTTPC_EXECUTE);
 	long longval = 0;
 	switch (req->curl_request.code) {
@@ -394,3 +519,44 @@ httpc_execute(struct httpc_request *req, double timeout)
 
 	return 0;
 }
+
+ssize_t
+httpc_read(struct httpc_request *req, char *buf, size_t len, double timeout)
+{
+	assert(req->stream);
+	struct curl_request *curl_request = &req->curl_request;
+	double deadline = ev_monotonic_now(loop()) + timeout;
+	while (ibuf_used(&req->stream_buf) == 0) {
+		if (!curl_request->in_progress) {
+			if (curl_request->code == CURLE_OK)
+				return 0; /* EOF */
+			errno = EINVAL;
+			diag_set(SystemError, "curl: %s",
+				 curl_easy_strerror(curl_request->code));
+			return -1;
+		}
+		if (req->stream_paused) {
+			/*
+			 * The buffer is drained, resume the transfer.
+			 * Note, libcurl may invoke the write callback
+			 * right from curl_easy_pause().
+			 */
+			req->stream_paused = false;
+			curl_easy_pause(curl_request->easy, CURLPAUSE_CONT);
+			continue;
+		}
+		if (fiber_cond_wait_deadline(&curl_request->cond,
+					     deadline) != 0)
+			return -1;
+		if (fiber_is_cancelled()) {
+			diag_set(FiberIsCancelled);
+			return -1;
+		}
+	}
+	size_t size = MIN(len, ibuf_used(&req->stream_buf));
+	memcpy(buf, req->stream_buf.rpos, size);
+	req->stream_buf.rpos += size;
+	if (ibuf_used(&req->stream_buf) == 0)
+		ibuf_reset(&req->stream_buf);
+	return size;
+}
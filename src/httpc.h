@@ -54,6 +54,12 @@ struct httpc_stat {
 	uint64_t http_other_responses;
 	uint64_t failed_requests;
 	uint64_t active_requests;
+	/** Requests served over a cached connection. */
+	uint64_t connections_reused;
+	/** New connections opened by requests. */
+	uint64_t connections_opened;
+	/** TLS handshakes done by requests. */
+	uint64_t tls_handshakes;
 };
 
 /**
@@ -64,6 +70,8 @@ struct httpc_env {
 	struct curl_env curl_env;
 	/** Memory pool for requests */
 	struct mempool req_pool;
+	/** Use HTTP/2 if the server supports it. */
+	bool http2;
 	/** Statistics */
 	struct httpc_stat stat;
 };
@@ -72,11 +80,16 @@ struct httpc_env {
  * @brief Creates  new HTTP client environment
  * @param env pointer to a structure to initialize
  * @param max_conn The maximum number of entries in connection cache
+ * @param max_host_conns The maximum number of connections to
+ *        a single host, 0 means unlimited
+ * @param http2 Negotiate HTTP/2 with TLS servers and multiplex
+ *        concurrent requests to the same host over one connection
  * @retval 0 on success
  * @retval -1 on error, check diag
  */
 int
-httpc_env_create(struct httpc_env *ctx, int max_conns);
+httpc_env_create(struct httpc_env *ctx, int max_conns, int max_host_conns,
+		 bool http2);
 
 /**
  * Destroy HTTP client environment
@@ -109,6 +122,21 @@ struct httpc_request {
 	struct region resp_headers;
 	/** buffer of body */
 	struct region resp_body;
+	/**
+	 * Set if the response body is streamed rather than
+	 * buffered, see httpc_set_stream().
+	 */
+	bool stream;
+	/**
+	 * Part of a streamed response body received, but not
+	 * read with httpc_read() yet.
+	 */
+	struct ibuf stream_buf;
+	/**
+	 * Set if the transfer is paused, because the reader
+	 * doesn't keep up, i.e. stream_buf is full.
+	 */
+	bool stream_paused;
 };
 
 /**
@@ -148,6 +176,10 @@ httpc_set_body(struct httpc_request *req, const char *body, size_t size);
 
 /**
  * Set TCP keep-alive probing
+ * @details If both @a idle and @a interval are 0, probing is
+ * disabled, but the connection is still kept in the connection
+ * cache after the request completes so that the next request to
+ * the same host can reuse it.
  * @param req request
  * @param idle delay, in seconds, that the operating system will wait
  *        while the connection is idle before sending keepalive probes
@@ -281,6 +313,17 @@ httpc_set_ssl_cert(struct httpc_request *req, const char *ssl_cert);
 void
 httpc_set_interface(struct httpc_request *req, const char *interface);
 
+/**
+ * Stream the response body instead of buffering it
+ * @param req request
+ * @details httpc_execute() returns as soon as the response
+ * starts, the body must then be read with httpc_read(). Only
+ * a limited amount of data is buffered: if the reader doesn't
+ * keep up, the transfer is paused until it drains the buffer.
+ */
+void
+httpc_set_stream(struct httpc_request *req);
+
 /**
  * This function does async HTTP request
  * @param request - reference to request object with filled fields
@@ -290,6 +333,19 @@ httpc_set_interface(struct httpc_request *req, const char *interface);
 int
 httpc_execute(struct httpc_request *req, double timeout);
 
+/**
+ * Read the next chunk of a streamed response body
+ * @param req request executed in the streaming mode
+ * @param buf buffer to read to
+ * @param len size of the buffer
+ * @param timeout - timeout of waiting for data
+ * @return the number of bytes read, 0 at the end of the body,
+ *         -1 on error, check diag
+ * @see httpc_set_stream()
+ */
+ssize_t
+httpc_read(struct httpc_request *req, char *buf, size_t len, double timeout);
+
 /** Request }}} */
 
 #endif /* TARANTOOL_HTTPC_H_INCLUDED */
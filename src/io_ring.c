@@ -0,0 +1,466 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "io_ring.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trivia/config.h"
+#include "trivia/util.h"
+#include "diag.h"
+
+#if defined(HAVE_IO_URING)
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <pmatomic.h>
+
+#include "fiber.h"
+#include "fiber_cond.h"
+#include "fio.h"
+#include "say.h"
+
+/** A request submitted to the ring. */
+struct io_ring_req {
+	/** Fiber waiting for the request or NULL. */
+	struct fiber *fiber;
+	/** Result of the request, -errno on failure. */
+	int res;
+	/** Set when the request completion has been reaped. */
+	bool done;
+};
+
+struct io_ring {
+	/** io_uring file descriptor. */
+	int fd;
+	/** Submission queue memory mapping. */
+	void *sq_ptr;
+	size_t sq_size;
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned *sq_array;
+	unsigned sq_mask;
+	/** Submission queue entries, mapped separately. */
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+	/** Completion queue memory mapping. */
+	void *cq_ptr;
+	size_t cq_size;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned cq_mask;
+	struct io_uring_cqe *cqes;
+	/** Max number of requests in flight. */
+	unsigned entries;
+	/** Number of requests in flight. */
+	unsigned pending;
+	/** Signalled when a request completes. */
+	struct fiber_cond slot_cond;
+	/** Polls the ring for completions. */
+	struct ev_io io;
+};
+
+/** io_uring instance of the current cord. */
+static __thread struct io_ring *cord_ring;
+
+static int
+sys_io_uring_setup(unsigned entries, struct io_uring_params *params)
+{
+	return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int
+sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+		   unsigned flags)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+		       flags, NULL, 0);
+}
+
+/** Process all completions available in the ring. */
+static void
+io_ring_reap(struct io_ring *ring)
+{
+	unsigned head = *ring->cq_head;
+	unsigned tail = pm_atomic_load_explicit(ring->cq_tail,
+						pm_memory_order_acquire);
+	if (head == tail)
+		return;
+	while (head != tail) {
+		struct io_uring_cqe *cqe = &ring->cqes[head & ring->cq_mask];
+		struct io_ring_req *req =
+			(struct io_ring_req *)(uintptr_t)cqe->user_data;
+		req->res = cqe->res;
+		req->done = true;
+		if (req->fiber != NULL)
+			fiber_wakeup(req->fiber);
+		assert(ring->pending > 0);
+		ring->pending--;
+		head++;
+	}
+	pm_atomic_store_explicit(ring->cq_head, head,
+				 pm_memory_order_release);
+	fiber_cond_broadcast(&ring->slot_cond);
+}
+
+static void
+io_ring_cb(ev_loop *loop, struct ev_io *watcher, int events)
+{
+	(void)loop;
+	(void)events;
+	io_ring_reap((struct io_ring *)watcher->data);
+}
+
+/** Block the cord until at least one request completes. */
+static void
+io_ring_wait(struct io_ring *ring)
+{
+	if (sys_io_uring_enter(ring->fd, 0, 1,
+			       IORING_ENTER_GETEVENTS) < 0 &&
+	    errno != EINTR)
+		panic_syserror("io_uring_enter");
+	io_ring_reap(ring);
+}
+
+/**
+ * Return the n-th submission queue entry after the queue
+ * tail. The entry isn't visible to the kernel until it is
+ * submitted with io_ring_submit().
+ */
+static struct io_uring_sqe *
+io_ring_sqe(struct io_ring *ring, unsigned n)
+{
+	unsigned idx = (*ring->sq_tail + n) & ring->sq_mask;
+	struct io_uring_sqe *sqe = &ring->sqes[idx];
+	memset(sqe, 0, sizeof(*sqe));
+	ring->sq_array[idx] = idx;
+	return sqe;
+}
+
+/**
+ * Pass count prepared entries to the kernel. If wait is set,
+ * block until they complete.
+ */
+static int
+io_ring_submit(struct io_ring *ring, unsigned count, bool wait)
+{
+	unsigned tail = *ring->sq_tail;
+	pm_atomic_store_explicit(ring->sq_tail, tail + count,
+				 pm_memory_order_release);
+	unsigned submitted = 0;
+	while (submitted < count) {
+		int rc = sys_io_uring_enter(ring->fd, count - submitted,
+					    wait ? count - submitted : 0,
+					    wait ? IORING_ENTER_GETEVENTS : 0);
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			if (submitted > 0)
+				panic_syserror("io_uring_enter");
+			/* Nothing was consumed, take the entries back. */
+			pm_atomic_store_explicit(ring->sq_tail, tail,
+						 pm_memory_order_release);
+			return -1;
+		}
+		submitted += rc;
+	}
+	ring->pending += count;
+	if (wait)
+		io_ring_reap(ring);
+	return 0;
+}
+
+int
+io_ring_create(unsigned entries)
+{
+	assert(cord_ring == NULL);
+	struct io_ring *ring = calloc(1, sizeof(*ring));
+	if (ring == NULL) {
+		diag_set(OutOfMemory, sizeof(*ring), "calloc", "io_ring");
+		return -1;
+	}
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	ring->fd = sys_io_uring_setup(entries, &params);
+	if (ring->fd < 0) {
+		diag_set(SystemError, "failed to set up io_uring");
+		goto error_free;
+	}
+	/* Writes at the current file position need Linux 5.6. */
+	if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+		errno = ENOSYS;
+		diag_set(SystemError, "io_uring is not supported by kernel");
+		goto error_close;
+	}
+	ring->entries = params.sq_entries;
+
+	ring->sq_size = params.sq_off.array +
+			params.sq_entries * sizeof(unsigned);
+	ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+			    MAP_SHARED | MAP_POPULATE, ring->fd,
+			    IORING_OFF_SQ_RING);
+	if (ring->sq_ptr == MAP_FAILED) {
+		diag_set(SystemError, "failed to map io_uring");
+		goto error_close;
+	}
+	char *sq = ring->sq_ptr;
+	ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+	ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+	ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+	ring->sq_mask = *(unsigned *)(sq + params.sq_off.ring_mask);
+
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+			  MAP_SHARED | MAP_POPULATE, ring->fd,
+			  IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED) {
+		diag_set(SystemError, "failed to map io_uring");
+		goto error_unmap_sq;
+	}
+
+	ring->cq_size = params.cq_off.cqes +
+			params.cq_entries * sizeof(struct io_uring_cqe);
+	ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE,
+			    MAP_SHARED | MAP_POPULATE, ring->fd,
+			    IORING_OFF_CQ_RING);
+	if (ring->cq_ptr == MAP_FAILED) {
+		diag_set(SystemError, "failed to map io_uring");
+		goto error_unmap_sqes;
+	}
+	char *cq = ring->cq_ptr;
+	ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+	ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+	ring->cq_mask = *(unsigned *)(cq + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+	fiber_cond_create(&ring->slot_cond);
+	ev_io_init(&ring->io, io_ring_cb, ring->fd, EV_READ);
+	ring->io.data = ring;
+	ev_io_start(loop(), &ring->io);
+	cord_ring = ring;
+	return 0;
+
+error_unmap_sqes:
+	munmap(ring->sqes, ring->sqes_size);
+error_unmap_sq:
+	munmap(ring->sq_ptr, ring->sq_size);
+error_close:
+	close(ring->fd);
+error_free:
+	free(ring);
+	return -1;
+}
+
+void
+io_ring_destroy(void)
+{
+	struct io_ring *ring = cord_ring;
+	if (ring == NULL)
+		return;
+	assert(ring->pending == 0);
+	ev_io_stop(loop(), &ring->io);
+	fiber_cond_destroy(&ring->slot_cond);
+	munmap(ring->cq_ptr, ring->cq_size);
+	munmap(ring->sqes, ring->sqes_size);
+	munmap(ring->sq_ptr, ring->sq_size);
+	close(ring->fd);
+	free(ring);
+	cord_ring = NULL;
+}
+
+bool
+io_ring_is_enabled(void)
+{
+	return cord_ring != NULL;
+}
+
+ssize_t
+io_ring_pread(int fd, void *buf, size_t count, off_t offset)
+{
+	struct io_ring *ring = cord_ring;
+	assert(ring != NULL);
+	size_t n = 0;
+	do {
+		while (ring->pending >= ring->entries)
+			fiber_cond_wait(&ring->slot_cond);
+		struct iovec iov;
+		iov.iov_base = (char *)buf + n;
+		iov.iov_len = count - n;
+		struct io_ring_req req = {
+			.fiber = fiber(),
+			.res = 0,
+			.done = false,
+		};
+		struct io_uring_sqe *sqe = io_ring_sqe(ring, 0);
+		sqe->opcode = IORING_OP_READV;
+		sqe->fd = fd;
+		sqe->off = offset + n;
+		sqe->addr = (uintptr_t)&iov;
+		sqe->len = 1;
+		sqe->user_data = (uintptr_t)&req;
+		if (io_ring_submit(ring, 1, false) != 0)
+			return -1;
+		/* The kernel owns the iovec until completion. */
+		while (!req.done)
+			fiber_yield();
+		if (req.res == -EINTR || req.res == -EAGAIN)
+			continue;
+		if (req.res < 0) {
+			errno = -req.res;
+			return -1;
+		}
+		if (req.res == 0)
+			break; /* EOF */
+		n += req.res;
+	} while (n < count);
+	return n;
+}
+
+ssize_t
+io_ring_writev(int fd, struct iovec *iov, int iovcnt, bool datasync)
+{
+	struct io_ring *ring = cord_ring;
+	assert(ring != NULL);
+	unsigned count = datasync ? 2 : 1;
+	while (ring->pending + count > ring->entries)
+		io_ring_wait(ring);
+	size_t total = 0;
+	for (int i = 0; i < iovcnt; i++)
+		total += iov[i].iov_len;
+
+	struct io_ring_req write_req = {
+		.fiber = NULL,
+		.res = 0,
+		.done = false,
+	};
+	struct io_ring_req sync_req = write_req;
+	struct io_uring_sqe *sqe = io_ring_sqe(ring, 0);
+	sqe->opcode = IORING_OP_WRITEV;
+	sqe->fd = fd;
+	sqe->off = (uint64_t)-1; /* current file position */
+	sqe->addr = (uintptr_t)iov;
+	sqe->len = iovcnt;
+	sqe->user_data = (uintptr_t)&write_req;
+	if (datasync) {
+		sqe->flags = IOSQE_IO_LINK;
+		sqe = io_ring_sqe(ring, 1);
+		sqe->opcode = IORING_OP_FSYNC;
+		sqe->fd = fd;
+		sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+		sqe->user_data = (uintptr_t)&sync_req;
+	}
+	if (io_ring_submit(ring, count, true) != 0)
+		return -1;
+	while (!write_req.done || (datasync && !sync_req.done))
+		io_ring_wait(ring);
+	if (write_req.res < 0) {
+		errno = -write_req.res;
+		return -1;
+	}
+	size_t written = write_req.res;
+	if (written < total) {
+		/*
+		 * Short write. The linked fdatasync was cancelled,
+		 * write the rest the regular way.
+		 */
+		size_t skip = written;
+		while (skip >= iov->iov_len) {
+			skip -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		iov->iov_base = (char *)iov->iov_base + skip;
+		iov->iov_len -= skip;
+		ssize_t rc = fio_writevn(fd, iov, iovcnt);
+		if (rc < 0)
+			return -1;
+		written += rc;
+		if (datasync && fdatasync(fd) != 0)
+			return -1;
+	} else if (datasync && sync_req.res < 0) {
+		errno = -sync_req.res;
+		return -1;
+	}
+	return written;
+}
+
+#else /* !defined(HAVE_IO_URING) */
+
+int
+io_ring_create(unsigned entries)
+{
+	(void)entries;
+	errno = ENOSYS;
+	diag_set(SystemError, "io_uring is not supported by platform");
+	return -1;
+}
+
+void
+io_ring_destroy(void)
+{
+}
+
+bool
+io_ring_is_enabled(void)
+{
+	return false;
+}
+
+ssize_t
+io_ring_pread(int fd, void *buf, size_t count, off_t offset)
+{
+	(void)fd;
+	(void)buf;
+	(void)count;
+	(void)offset;
+	unreachable();
+	errno = ENOSYS;
+	return -1;
+}
+
+ssize_t
+io_ring_writev(int fd, struct iovec *iov, int iovcnt, bool datasync)
+{
+	(void)fd;
+	(void)iov;
+	(void)iovcnt;
+	(void)datasync;
+	unreachable();
+	errno = ENOSYS;
+	return -1;
+}
+
+#endif /* defined(HAVE_IO_URING) */
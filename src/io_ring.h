@@ -0,0 +1,99 @@
+#ifndef TARANTOOL_IO_RING_H_INCLUDED
+#define TARANTOOL_IO_RING_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * File I/O through a Linux io_uring instance owned by the
+ * current cord.
+ *
+ * The ring is polled from the cord event loop, so a fiber
+ * can submit a request without a round trip to a thread pool
+ * and yield until the kernel completes it. Like coio_file,
+ * the API doesn't support timeouts or cancellation and
+ * follows the error reporting convention of the respective
+ * system calls.
+ */
+
+/**
+ * Create an io_uring instance for the current cord.
+ *
+ * @param entries  max number of requests in flight.
+ *
+ * @retval  0 success
+ * @retval -1 io_uring isn't supported by the platform or the
+ *            kernel, or the ring couldn't be set up, check diag
+ */
+int
+io_ring_create(unsigned entries);
+
+/**
+ * Destroy the io_uring instance of the current cord.
+ * Must not be called while there are requests in flight.
+ */
+void
+io_ring_destroy(void);
+
+/** Return true if the current cord has an io_uring instance. */
+bool
+io_ring_is_enabled(void);
+
+/**
+ * Cooperative pread(2): submit the request and yield the
+ * current fiber until it completes.
+ */
+ssize_t
+io_ring_pread(int fd, void *buf, size_t count, off_t offset);
+
+/**
+ * Write the whole iovec array at the current file position,
+ * optionally followed by fdatasync(2) linked to the write, in
+ * a single system call. Blocks the cord until the requests
+ * complete. The iovec array may be modified.
+ *
+ * @retval >= 0 the number of bytes written
+ * @retval -1 error, check errno
+ */
+ssize_t
+io_ring_writev(int fd, struct iovec *iov, int iovcnt, bool datasync);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_IO_RING_H_INCLUDED */
@@ -66,6 +66,69 @@ tt_bitset_destroy(struct tt_bitset *bitset)
 	memset(&bitset->pages, 0, sizeof(bitset->pages));
 }
 
+void
+tt_bitset_create_sparse(struct tt_bitset *bitset,
+			void *(*realloc)(void *ptr, size_t size))
+{
+	tt_bitset_create(bitset, realloc);
+	bitset->is_sparse = true;
+}
+
+/**
+ * Move the bits of @a page to a new array page of @a capacity,
+ * or to a new bitmap page if @a capacity is zero, and put the
+ * new page in place of @a page in the pages tree.
+ * @return the new page or NULL on memory error, in which case
+ * @a page is left intact
+ */
+static struct tt_bitset_page *
+tt_bitset_page_convert(struct tt_bitset *bitset, struct tt_bitset_page *page,
+		       uint32_t capacity)
+{
+	assert(capacity == 0 || capacity >= page->cardinality);
+	size_t size = capacity > 0 ?
+		      tt_bitset_page_array_alloc_size(capacity) :
+		      tt_bitset_page_alloc_size(bitset->realloc);
+	struct tt_bitset_page *new_page = bitset->realloc(NULL, size);
+	if (new_page == NULL)
+		return NULL;
+
+	if (capacity > 0)
+		memset(new_page, 0, sizeof(*new_page));
+	else
+		tt_bitset_page_create(new_page);
+	new_page->first_pos = page->first_pos;
+	new_page->cardinality = page->cardinality;
+	new_page->capacity = capacity;
+
+	if (page->capacity > 0 && capacity > 0) {
+		memcpy(tt_bitset_page_array(new_page),
+		       tt_bitset_page_array(page),
+		       page->cardinality * sizeof(uint16_t));
+	} else if (page->capacity > 0) {
+		void *d = tt_bitset_page_data(new_page);
+		const uint16_t *a = tt_bitset_page_array(page);
+		for (uint32_t i = 0; i < page->cardinality; i++)
+			bit_set(d, a[i]);
+	} else {
+		uint16_t *a = tt_bitset_page_array(new_page);
+		uint32_t n = 0;
+		struct bit_iterator it;
+		bit_iterator_init(&it, tt_bitset_page_data(page),
+				  BITSET_PAGE_DATA_SIZE, true);
+		size_t offset;
+		while ((offset = bit_iterator_next(&it)) != SIZE_MAX)
+			a[n++] = offset;
+		assert(n == page->cardinality);
+	}
+
+	tt_bitset_pages_remove(&bitset->pages, page);
+	tt_bitset_pages_insert(&bitset->pages, new_page);
+	tt_bitset_page_destroy(page);
+	bitset->realloc(page, 0);
+	return new_page;
+}
+
 bool
 tt_bitset_test(struct tt_bitset *bitset, size_t pos)
 {
@@ -80,7 +143,13 @@ tt_bitset_test(struct tt_bitset *bitset, size_t pos)
 
 	assert(page->first_pos <= pos && pos < page->first_pos +
 	       BITSET_PAGE_DATA_SIZE * CHAR_BIT);
-	return bit_test(tt_bitset_page_data(page), pos - page->first_pos);
+	size_t offset = pos - page->first_pos;
+	if (page->capacity > 0) {
+		uint32_t i = tt_bitset_page_array_find(page, offset);
+		return i < page->cardinality &&
+		       tt_bitset_page_array(page)[i] == offset;
+	}
+	return bit_test(tt_bitset_page_data(page), offset);
 }
 
 int
@@ -94,12 +163,19 @@ tt_bitset_set(struct tt_bitset *bitset, size_t pos)
 		tt_bitset_pages_search(&bitset->pages, &key);
 	if (page == NULL) {
 		/* Allocate a new page */
-		size_t size = tt_bitset_page_alloc_size(bitset->realloc);
+		size_t size = bitset->is_sparse ?
+			tt_bitset_page_array_alloc_size(BITSET_PAGE_ARRAY_MIN) :
+			tt_bitset_page_alloc_size(bitset->realloc);
 		page = bitset->realloc(NULL, size);
 		if (page == NULL)
 			return -1;
 
-		tt_bitset_page_create(page);
+		if (bitset->is_sparse) {
+			memset(page, 0, sizeof(*page));
+			page->capacity = BITSET_PAGE_ARRAY_MIN;
+		} else {
+			tt_bitset_page_create(page);
+		}
 		page->first_pos = key.first_pos;
 
 		/* Insert the page into pages tree */
@@ -108,8 +184,37 @@ tt_bitset_set(struct tt_bitset *bitset, size_t pos)
 
 	assert(page->first_pos <= pos && pos < page->first_pos +
 	       BITSET_PAGE_DATA_SIZE * CHAR_BIT);
-	bool prev = bit_set(tt_bitset_page_data(page), pos - page->first_pos);
-	if (prev) {
+	size_t offset = pos - page->first_pos;
+	uint32_t i = 0;
+	if (page->capacity > 0) {
+		i = tt_bitset_page_array_find(page, offset);
+		if (i < page->cardinality &&
+		    tt_bitset_page_array(page)[i] == offset) {
+			/* Value has not changed */
+			return 1;
+		}
+		if (page->cardinality == page->capacity) {
+			/*
+			 * Grow the array or switch to a bitmap
+			 * once the array isn't smaller than it.
+			 */
+			uint32_t capacity = 0;
+			if (page->capacity < BITSET_PAGE_ARRAY_MAX)
+				capacity = page->capacity * 2;
+			if (capacity > BITSET_PAGE_ARRAY_MAX)
+				capacity = BITSET_PAGE_ARRAY_MAX;
+			page = tt_bitset_page_convert(bitset, page, capacity);
+			if (page == NULL)
+				return -1;
+		}
+	}
+
+	if (page->capacity > 0) {
+		uint16_t *a = tt_bitset_page_array(page);
+		memmove(a + i + 1, a + i,
+			(page->cardinality - i) * sizeof(uint16_t));
+		a[i] = offset;
+	} else if (bit_set(tt_bitset_page_data(page), offset)) {
 		/* Value has not changed */
 		return 1;
 	}
@@ -134,8 +239,15 @@ tt_bitset_clear(struct tt_bitset *bitset, size_t pos)
 
 	assert(page->first_pos <= pos && pos < page->first_pos +
 	       BITSET_PAGE_DATA_SIZE * CHAR_BIT);
-	bool prev = bit_clear(tt_bitset_page_data(page), pos - page->first_pos);
-	if (!prev) {
+	size_t offset = pos - page->first_pos;
+	if (page->capacity > 0) {
+		uint16_t *a = tt_bitset_page_array(page);
+		uint32_t i = tt_bitset_page_array_find(page, offset);
+		if (i >= page->cardinality || a[i] != offset)
+			return 0;
+		memmove(a + i, a + i + 1,
+			(page->cardinality - i - 1) * sizeof(uint16_t));
+	} else if (!bit_clear(tt_bitset_page_data(page), offset)) {
 		return 0;
 	}
 
@@ -150,6 +262,14 @@ tt_bitset_clear(struct tt_bitset *bitset, size_t pos)
 		/* Free the page */
 		tt_bitset_page_destroy(page);
 		bitset->realloc(page, 0);
+	} else if (bitset->is_sparse && page->capacity == 0 &&
+		   page->cardinality == BITSET_PAGE_ARRAY_MAX / 2) {
+		/*
+		 * Switch back to an array, leaving room to set
+		 * bits again without converting the page back and
+		 * forth. The bitmap is kept if there's no memory.
+		 */
+		tt_bitset_page_convert(bitset, page, BITSET_PAGE_ARRAY_MAX / 2);
 	}
 
 	return 1;
@@ -170,6 +290,13 @@ tt_bitset_info(struct tt_bitset *bitset, struct tt_bitset_info *info)
 	struct tt_bitset_page *page = tt_bitset_pages_first(&bitset->pages);
 	while (page != NULL) {
 		info->pages++;
+		if (page->capacity > 0) {
+			info->array_pages++;
+			info->mem_size +=
+				tt_bitset_page_array_alloc_size(page->capacity);
+		} else {
+			info->mem_size += info->page_total_size;
+		}
 		cardinality_check += page->cardinality;
 		page = tt_bitset_pages_next(&bitset->pages, page);
 	}
@@ -242,7 +369,7 @@ tt_bitset_dump(struct tt_bitset *bitset, int verbose, FILE *stream)
 
 		fprintf(stream, "utilization = %8.4f%% (%zu/%zu)",
 			(float) page->cardinality * 1e2 / PAGE_BIT,
-			page->cardinality, PAGE_BIT);
+			(size_t) page->cardinality, PAGE_BIT);
 
 		if (verbose < 2) {
 			fprintf(stream, "\n");
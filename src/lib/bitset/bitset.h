@@ -69,7 +69,13 @@ extern "C" {
 struct tt_bitset_page {
 	size_t first_pos;
 	rb_node(struct tt_bitset_page) node;
-	size_t cardinality;
+	uint32_t cardinality;
+	/**
+	 * Zero for a bitmap page. Otherwise the page is an array
+	 * page, which stores up to @a capacity sorted 16-bit
+	 * offsets of the set bits instead of the bitmap.
+	 */
+	uint32_t capacity;
 	uint8_t data[0];
 };
 
@@ -84,6 +90,8 @@ struct tt_bitset {
 	tt_bitset_pages_t pages;
 	size_t cardinality;
 	void *(*realloc)(void *ptr, size_t size);
+	/** Use array pages for sparsely populated pages. */
+	bool is_sparse;
 	/** @endcond */
 };
 
@@ -96,6 +104,18 @@ void
 tt_bitset_create(struct tt_bitset *bitset, void *(*realloc)(void *ptr,
 							    size_t size));
 
+/**
+ * @brief Construct \a bitset which keeps pages with few bits set
+ * as sorted arrays of bit offsets and converts them to bitmaps
+ * only when they fill up. Such a bitset takes much less memory
+ * when set bits are scattered.
+ * @param bitset bitset
+ * @param realloc memory allocator to use
+ */
+void
+tt_bitset_create_sparse(struct tt_bitset *bitset,
+			void *(*realloc)(void *ptr, size_t size));
+
 /**
  * @brief Destruct \a bitset
  * @param bitset bitset
@@ -158,6 +178,10 @@ struct tt_bitset_info {
 	size_t page_total_size;
 	/** A multiplier by which an address of page data is aligned **/
 	size_t page_data_alignment;
+	/** Number of allocated pages stored as arrays */
+	size_t array_pages;
+	/** Memory used by all pages (in bytes) */
+	size_t mem_size;
 };
 
 /**
@@ -47,6 +47,14 @@ tt_bitset_index_create(struct tt_bitset_index *index,
 	index->realloc = realloc;
 }
 
+void
+tt_bitset_index_create_sparse(struct tt_bitset_index *index,
+			      void *(*realloc)(void *ptr, size_t size))
+{
+	tt_bitset_index_create(index, realloc);
+	index->is_sparse = true;
+}
+
 void
 tt_bitset_index_destroy(struct tt_bitset_index *index)
 {
@@ -108,7 +116,11 @@ tt_bitset_index_reserve(struct tt_bitset_index *index, size_t size)
 		if (index->bitsets[b] == NULL)
 			goto error_2;
 
-		tt_bitset_create(index->bitsets[b], index->realloc);
+		if (index->is_sparse)
+			tt_bitset_create_sparse(index->bitsets[b],
+						index->realloc);
+		else
+			tt_bitset_create(index->bitsets[b], index->realloc);
 	}
 
 	index->capacity = capacity;
@@ -386,7 +398,7 @@ tt_bitset_index_bsize(const struct tt_bitset_index *index)
 			continue;
 		struct tt_bitset_info info;
 		tt_bitset_info(index->bitsets[b], &info);
-		result += info.page_total_size * info.pages;
+		result += info.mem_size;
 	}
 	return result;
 }
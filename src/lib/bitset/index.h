@@ -133,6 +133,8 @@ struct tt_bitset_index {
 	void *(*realloc)(void *ptr, size_t size);
 	/* A buffer used for rollback changes in bitset_insert */
 	char *rollback_buf;
+	/* Create sparse bitsets, see tt_bitset_create_sparse() */
+	bool is_sparse;
 	/** @endcond **/
 };
 
@@ -145,6 +147,17 @@ void
 tt_bitset_index_create(struct tt_bitset_index *index,
 		       void *(*realloc)(void *ptr, size_t size));
 
+/**
+ * @brief Construct \a index which stores its bitsets in
+ * the sparse format.
+ * @param index bitset index
+ * @param realloc memory allocator to use
+ * @see tt_bitset_create_sparse
+ */
+void
+tt_bitset_index_create_sparse(struct tt_bitset_index *index,
+			      void *(*realloc)(void *ptr, size_t size));
+
 /**
  * @brief Destruct \a index
  * @param index bitset index
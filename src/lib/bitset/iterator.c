@@ -302,7 +302,11 @@ tt_bitset_iterator_conj_cmp(const void *p1, const void *p2)
 	}
 }
 
-static void
+/**
+ * Compute the result page of a conjunction.
+ * @return false if no bits are set in the result
+ */
+static bool
 tt_bitset_iterator_conj_prepare_page(struct tt_bitset_iterator_conj *conj,
 				     struct tt_bitset_page *dst)
 {
@@ -316,7 +320,8 @@ tt_bitset_iterator_conj_prepare_page(struct tt_bitset_iterator_conj *conj,
 		if (!conj->pre_nots[b]) {
 			/* conj->pages[b] is rewinded to conj->page_first_pos */
 			assert(conj->pages[b]->first_pos == conj->page_first_pos);
-			tt_bitset_page_and(dst, conj->pages[b]);
+			if (!tt_bitset_page_and(dst, conj->pages[b]))
+				return false;
 		} else {
 			/*
 			 * If page is NULL or its position is not equal
@@ -330,9 +335,11 @@ tt_bitset_iterator_conj_prepare_page(struct tt_bitset_iterator_conj *conj,
 			    conj->pages[b]->first_pos != conj->page_first_pos)
 				continue;
 
-			tt_bitset_page_nand(dst, conj->pages[b]);
+			if (!tt_bitset_page_nand(dst, conj->pages[b]))
+				return false;
 		}
 	}
+	return true;
 }
 
 static void
@@ -353,20 +360,26 @@ tt_bitset_iterator_prepare_page(struct tt_bitset_iterator *it)
 		return;
 
 	/* For each conj where conj->page_first_pos == pos */
+	bool is_empty = true;
 	for (size_t c = 0; c < it->size; c++) {
 		if (it->conjs[c].page_first_pos > it->page->first_pos)
 			break;
 
 		/* Get result from conj */
-		tt_bitset_iterator_conj_prepare_page(&it->conjs[c],
-						     it->page_tmp);
+		if (!tt_bitset_iterator_conj_prepare_page(&it->conjs[c],
+							  it->page_tmp))
+			continue;
 		/* OR page from conjunction with it->page */
 		tt_bitset_page_or(it->page, it->page_tmp);
+		is_empty = false;
 	}
 
-	/* Init the bit iterator on it->page */
+	/*
+	 * Init the bit iterator on it->page. Don't scan the page
+	 * if no conjunction matched anything in it.
+	 */
 	bit_iterator_init(&it->page_it, tt_bitset_page_data(it->page),
-		      BITSET_PAGE_DATA_SIZE, true);
+		      is_empty ? 0 : BITSET_PAGE_DATA_SIZE, true);
 }
 
 static void
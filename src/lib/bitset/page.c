@@ -35,6 +35,9 @@
 extern inline size_t
 tt_bitset_page_alloc_size(void *(*realloc_arg)(void *ptr, size_t size));
 
+extern inline bool
+tt_bitset_word_is_zero(tt_bitset_word_t w);
+
 extern inline void *
 tt_bitset_page_data(struct tt_bitset_page *page);
 
@@ -53,10 +56,22 @@ tt_bitset_page_set_zeros(struct tt_bitset_page *page);
 extern inline void
 tt_bitset_page_set_ones(struct tt_bitset_page *page);
 
-extern inline void
+extern inline size_t
+tt_bitset_page_array_alloc_size(uint32_t capacity);
+
+extern inline uint16_t *
+tt_bitset_page_array(struct tt_bitset_page *page);
+
+extern inline uint32_t
+tt_bitset_page_array_find(struct tt_bitset_page *page, uint16_t offset);
+
+extern inline bool
+tt_bitset_page_any(struct tt_bitset_page *page);
+
+extern inline bool
 tt_bitset_page_and(struct tt_bitset_page *dst, struct tt_bitset_page *src);
 
-extern inline void
+extern inline bool
 tt_bitset_page_nand(struct tt_bitset_page *dst, struct tt_bitset_page *src);
 
 extern inline void
@@ -55,13 +55,27 @@ extern "C" {
 
 enum {
 	/** How many bytes to store in one page */
-	BITSET_PAGE_DATA_SIZE = 160
+	BITSET_PAGE_DATA_SIZE = 160,
+	/**
+	 * How many offsets an array page can store. An array page
+	 * with more bits set would take more memory than a bitmap.
+	 */
+	BITSET_PAGE_ARRAY_MAX = BITSET_PAGE_DATA_SIZE / sizeof(uint16_t),
+	/** Capacity of a newly allocated array page. */
+	BITSET_PAGE_ARRAY_MIN = 4,
 };
 
-#if defined(ENABLE_AVX)
+/*
+ * Page operations process a vector register at a time if the
+ * compiler targets SSE2 or AVX (see ENABLE_SSE2 and ENABLE_AVX
+ * in cmake/simd.cmake).
+ */
+#if defined(__AVX__)
+#include <immintrin.h>
 typedef __m256i tt_bitset_word_t;
 #define BITSET_PAGE_DATA_ALIGNMENT 32
-#elif defined(ENABLE_SSE2)
+#elif defined(__SSE2__)
+#include <emmintrin.h>
 typedef __m128i tt_bitset_word_t;
 #define BITSET_PAGE_DATA_ALIGNMENT 16
 #elif defined(__x86_64__)
@@ -107,6 +121,19 @@ tt_bitset_page_alloc_size(void *(*realloc_arg)(void *ptr, size_t size))
 
 #undef MALLOC_ALIGNMENT
 
+inline bool
+tt_bitset_word_is_zero(tt_bitset_word_t w)
+{
+#if defined(__AVX__)
+	return _mm256_testz_si256(w, w);
+#elif defined(__SSE2__)
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(w, _mm_setzero_si128())) ==
+	       0xffff;
+#else
+	return w == 0;
+#endif
+}
+
 inline void *
 tt_bitset_page_data(struct tt_bitset_page *page)
 {
@@ -148,35 +175,127 @@ tt_bitset_page_set_ones(struct tt_bitset_page *page)
 	memset(data, -1, BITSET_PAGE_DATA_SIZE);
 }
 
-inline void
+inline size_t
+tt_bitset_page_array_alloc_size(uint32_t capacity)
+{
+	return sizeof(struct tt_bitset_page) + capacity * sizeof(uint16_t);
+}
+
+/** Sorted offsets of the set bits of an array page. */
+inline uint16_t *
+tt_bitset_page_array(struct tt_bitset_page *page)
+{
+	assert(page->capacity > 0);
+	return (uint16_t *) page->data;
+}
+
+/**
+ * Find @a offset in an array page.
+ * @return the index of @a offset or of the first greater offset
+ */
+inline uint32_t
+tt_bitset_page_array_find(struct tt_bitset_page *page, uint16_t offset)
+{
+	const uint16_t *a = tt_bitset_page_array(page);
+	uint32_t begin = 0, end = page->cardinality;
+	while (begin < end) {
+		uint32_t mid = begin + (end - begin) / 2;
+		if (a[mid] < offset)
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	return begin;
+}
+
+/** @return true if any bit is set in a bitmap page */
+inline bool
+tt_bitset_page_any(struct tt_bitset_page *page)
+{
+	assert(page->capacity == 0);
+	const tt_bitset_word_t *d =
+		(const tt_bitset_word_t *) tt_bitset_page_data(page);
+	tt_bitset_word_t any = d[0];
+	int cnt = BITSET_PAGE_DATA_SIZE / sizeof(tt_bitset_word_t);
+	for (int i = 1; i < cnt; i++)
+		any |= d[i];
+	return !tt_bitset_word_is_zero(any);
+}
+
+/**
+ * dst &= src
+ * @return true if any bit remains set in @a dst
+ */
+inline bool
 tt_bitset_page_and(struct tt_bitset_page *dst, struct tt_bitset_page *src)
 {
+	assert(dst->capacity == 0);
+	if (src->capacity > 0) {
+		/* Keep only the bits listed in the array. */
+		void *d = tt_bitset_page_data(dst);
+		const uint16_t *a = tt_bitset_page_array(src);
+		uint16_t keep[BITSET_PAGE_ARRAY_MAX];
+		uint32_t n = 0;
+		for (uint32_t i = 0; i < src->cardinality; i++) {
+			if (bit_test(d, a[i]))
+				keep[n++] = a[i];
+		}
+		memset(d, 0, BITSET_PAGE_DATA_SIZE);
+		for (uint32_t i = 0; i < n; i++)
+			bit_set(d, keep[i]);
+		return n > 0;
+	}
+
 	tt_bitset_word_t *d = (tt_bitset_word_t *) tt_bitset_page_data(dst);
 	tt_bitset_word_t *s = (tt_bitset_word_t *) tt_bitset_page_data(src);
 
 	assert(BITSET_PAGE_DATA_SIZE % sizeof(tt_bitset_word_t) == 0);
 	int cnt = BITSET_PAGE_DATA_SIZE / sizeof(tt_bitset_word_t);
-	for (int i = 0; i < cnt; i++) {
-		*d++ &= *s++;
-	}
+	tt_bitset_word_t any = *d &= *s;
+	for (int i = 1; i < cnt; i++)
+		any |= d[i] &= s[i];
+	return !tt_bitset_word_is_zero(any);
 }
 
-inline void
+/**
+ * dst &= ~src
+ * @return true if any bit remains set in @a dst
+ */
+inline bool
 tt_bitset_page_nand(struct tt_bitset_page *dst, struct tt_bitset_page *src)
 {
+	assert(dst->capacity == 0);
+	if (src->capacity > 0) {
+		void *d = tt_bitset_page_data(dst);
+		const uint16_t *a = tt_bitset_page_array(src);
+		for (uint32_t i = 0; i < src->cardinality; i++)
+			bit_clear(d, a[i]);
+		return tt_bitset_page_any(dst);
+	}
+
 	tt_bitset_word_t *d = (tt_bitset_word_t *) tt_bitset_page_data(dst);
 	tt_bitset_word_t *s = (tt_bitset_word_t *) tt_bitset_page_data(src);
 
 	assert(BITSET_PAGE_DATA_SIZE % sizeof(tt_bitset_word_t) == 0);
 	int cnt = BITSET_PAGE_DATA_SIZE / sizeof(tt_bitset_word_t);
-	for (int i = 0; i < cnt; i++) {
-		*d++ &= ~*s++;
-	}
+	tt_bitset_word_t any = *d &= ~*s;
+	for (int i = 1; i < cnt; i++)
+		any |= d[i] &= ~s[i];
+	return !tt_bitset_word_is_zero(any);
 }
 
 inline void
 tt_bitset_page_or(struct tt_bitset_page *dst, struct tt_bitset_page *src)
 {
+	assert(dst->capacity == 0);
+	if (src->capacity > 0) {
+		void *d = tt_bitset_page_data(dst);
+		const uint16_t *a = tt_bitset_page_array(src);
+		for (uint32_t i = 0; i < src->cardinality; i++)
+			bit_set(d, a[i]);
+		return;
+	}
+
 	tt_bitset_word_t *d = (tt_bitset_word_t *) tt_bitset_page_data(dst);
 	tt_bitset_word_t *s = (tt_bitset_word_t *) tt_bitset_page_data(src);
 
@@ -38,6 +38,14 @@
 #include <assert.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <errno.h>
+#include <msgpuck.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 static void
 csv_emit_row_empty(void *ctx)
@@ -117,6 +125,56 @@ csv_setopt(struct csv *csv, int opt, ...)
 	va_end(args);
 }
 
+/**
+ * Return the first character in [p, end) equal to one of c1,
+ * c2, c3, c4 or end if there's no such character. Ordinary
+ * characters make up most of the input, so they are skipped
+ * a vector register at a time where SSE2 or AVX2 is available.
+ */
+static inline const char *
+csv_find_special(const char *p, const char *end,
+		 char c1, char c2, char c3, char c4)
+{
+#if defined(__AVX2__)
+	const __m256i v1 = _mm256_set1_epi8(c1);
+	const __m256i v2 = _mm256_set1_epi8(c2);
+	const __m256i v3 = _mm256_set1_epi8(c3);
+	const __m256i v4 = _mm256_set1_epi8(c4);
+	for (; end - p >= 32; p += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)p);
+		__m256i m = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, v1),
+					_mm256_cmpeq_epi8(v, v2)),
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, v3),
+					_mm256_cmpeq_epi8(v, v4)));
+		unsigned mask = (unsigned)_mm256_movemask_epi8(m);
+		if (mask != 0)
+			return p + __builtin_ctz(mask);
+	}
+#elif defined(__SSE2__)
+	const __m128i v1 = _mm_set1_epi8(c1);
+	const __m128i v2 = _mm_set1_epi8(c2);
+	const __m128i v3 = _mm_set1_epi8(c3);
+	const __m128i v4 = _mm_set1_epi8(c4);
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		__m128i m = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(v, v1),
+				     _mm_cmpeq_epi8(v, v2)),
+			_mm_or_si128(_mm_cmpeq_epi8(v, v3),
+				     _mm_cmpeq_epi8(v, v4)));
+		unsigned mask = _mm_movemask_epi8(m);
+		if (mask != 0)
+			return p + __builtin_ctz(mask);
+	}
+#endif
+	for (; p < end; p++) {
+		if (*p == c1 || *p == c2 || *p == c3 || *p == c4)
+			return p;
+	}
+	return end;
+}
+
 /**
   * both of methods (emitting and iterating) are implementing by one function
   * firstonly == true means iteration method.
@@ -206,7 +264,29 @@ csv_parse_impl(struct csv *csv, const char *s, const char *end, bool firstonly)
 			} else if (*p == csv->quote_char) {
 				csv->state = CSV_QUOTE_OPENING;
 			} else {
-				*csv->bufp++ = *p;
+				/*
+				 * Copy the whole run of ordinary
+				 * characters that fits in the buffer.
+				 */
+				size_t avail = csv->buf_len -
+					       (csv->bufp - csv->buf);
+				const char *limit = (size_t)(end - p) > avail ?
+						    p + avail : end;
+				const char *run_end = csv_find_special(
+					p + 1, limit, csv->delimiter,
+					csv->quote_char, '\n', '\r');
+				memcpy(csv->bufp, p, run_end - p);
+				csv->bufp += run_end - p;
+				const char *s = run_end;
+				while (s > p && s[-1] == ' ')
+					s--;
+				if (s == p)
+					csv->ending_spaces += run_end - p;
+				else
+					csv->ending_spaces = run_end - s;
+				csv->prev_symbol = run_end[-1];
+				p = run_end - 1;
+				continue;
 			}
 
 			if (*p == ' ') {
@@ -250,7 +330,20 @@ csv_parse_impl(struct csv *csv, const char *s, const char *end, bool firstonly)
 			if (*p == csv->quote_char) {
 				csv->state = CSV_QUOTE_CLOSING;
 			} else {
-				*csv->bufp++ = *p;
+				/* Copy everything up to the next quote. */
+				size_t avail = csv->buf_len -
+					       (csv->bufp - csv->buf);
+				const char *limit = (size_t)(end - p) > avail ?
+						    p + avail : end;
+				const char *run_end = (const char *)
+					memchr(p + 1, csv->quote_char,
+					       limit - p - 1);
+				if (run_end == NULL)
+					run_end = limit;
+				memcpy(csv->bufp, p, run_end - p);
+				csv->bufp += run_end - p;
+				csv->prev_symbol = run_end[-1];
+				p = run_end - 1;
 			}
 			break;
 		case CSV_NEWFIELD:
@@ -409,3 +502,207 @@ csv_escape_field(struct csv *csv, const char *field,
 	*p = 0;
 	return p - dst;
 }
+
+enum {
+	/** Size of a batch or row header: 0xdd + uint32. */
+	CSV_MP_HEADER_SIZE = 5,
+	/** Max length of a field that can be a number. */
+	CSV_MP_NUMBER_LEN_MAX = 64,
+};
+
+/** Reserve @a size bytes at the end of the encoded data. */
+static char *
+csv_mp_reserve(struct csv_mp *mp, size_t size)
+{
+	if (mp->size + size > mp->capacity) {
+		size_t capacity = mp->capacity > 0 ? mp->capacity : 4096;
+		while (capacity < mp->size + size)
+			capacity *= 2;
+		char *buf = (char *)mp->csv->realloc(mp->buf, capacity);
+		if (buf == NULL) {
+			mp->csv->error_status = CSV_ER_MEMORY_ERROR;
+			return NULL;
+		}
+		mp->buf = buf;
+		mp->capacity = capacity;
+	}
+	return mp->buf + mp->size;
+}
+
+/**
+ * Encode a numeric field. Empty fields are encoded as nil.
+ * @retval 0 success
+ * @retval -1 the field isn't a number or out of memory
+ */
+static int
+csv_mp_encode_number(struct csv_mp *mp, const char *field, size_t len,
+		     bool is_integer)
+{
+	char *data;
+	if (len == 0) {
+		if ((data = csv_mp_reserve(mp, mp_sizeof_nil())) == NULL)
+			return -1;
+		mp->size = mp_encode_nil(data) - mp->buf;
+		return 0;
+	}
+	if (len >= CSV_MP_NUMBER_LEN_MAX)
+		goto invalid;
+	char str[CSV_MP_NUMBER_LEN_MAX];
+	memcpy(str, field, len);
+	str[len] = '\0';
+	char *str_end;
+	errno = 0;
+	if (str[0] == '-') {
+		long long value = strtoll(str, &str_end, 10);
+		if (errno == 0 && *str_end == '\0') {
+			data = csv_mp_reserve(mp, mp_sizeof_int(value));
+			if (data == NULL)
+				return -1;
+			mp->size = mp_encode_int(data, value) - mp->buf;
+			return 0;
+		}
+	} else {
+		unsigned long long value = strtoull(str, &str_end, 10);
+		if (errno == 0 && *str_end == '\0') {
+			data = csv_mp_reserve(mp, mp_sizeof_uint(value));
+			if (data == NULL)
+				return -1;
+			mp->size = mp_encode_uint(data, value) - mp->buf;
+			return 0;
+		}
+	}
+	if (is_integer)
+		goto invalid;
+	errno = 0;
+	double value = strtod(str, &str_end);
+	if (errno != 0 || *str_end != '\0' || str_end == str)
+		goto invalid;
+	if ((data = csv_mp_reserve(mp, mp_sizeof_double(value))) == NULL)
+		return -1;
+	mp->size = mp_encode_double(data, value) - mp->buf;
+	return 0;
+invalid:
+	mp->csv->error_status = CSV_ER_INVALID;
+	return -1;
+}
+
+static void
+csv_mp_emit_field(void *ctx, const char *field, const char *end)
+{
+	struct csv_mp *mp = (struct csv_mp *)ctx;
+	if (mp->csv->error_status != CSV_ER_OK)
+		return;
+	if (mp->skip_rows > 0) {
+		mp->field_count++;
+		return;
+	}
+	if (mp->field_count == 0) {
+		/* Reserve the row header, see csv_mp_emit_row(). */
+		if (csv_mp_reserve(mp, CSV_MP_HEADER_SIZE) == NULL)
+			return;
+		mp->row_begin = mp->size;
+		mp->size += CSV_MP_HEADER_SIZE;
+	}
+	int type = CSV_MP_STRING;
+	if (mp->field_count < mp->type_count)
+		type = mp->types[mp->field_count];
+	mp->field_count++;
+	size_t len = end - field;
+	if (type != CSV_MP_STRING) {
+		csv_mp_encode_number(mp, field, len,
+				     type == CSV_MP_INTEGER);
+		return;
+	}
+	char *data = csv_mp_reserve(mp, mp_sizeof_str(len));
+	if (data == NULL)
+		return;
+	mp->size = mp_encode_str(data, field, len) - mp->buf;
+}
+
+static void
+csv_mp_emit_row(void *ctx)
+{
+	struct csv_mp *mp = (struct csv_mp *)ctx;
+	if (mp->csv->error_status != CSV_ER_OK)
+		return;
+	if (mp->field_count == 0)
+		return;
+	mp->line_count++;
+	if (mp->skip_rows > 0) {
+		mp->skip_rows--;
+		mp->field_count = 0;
+		return;
+	}
+	/*
+	 * The number of fields isn't known until the end of
+	 * the row, so the maximal header is reserved. Shrink
+	 * it to the canonical size to not waste space in every
+	 * stored tuple.
+	 */
+	char *row = mp->buf + mp->row_begin;
+	uint32_t header_size = mp_sizeof_array(mp->field_count);
+	mp_encode_array(row, mp->field_count);
+	memmove(row + header_size, row + CSV_MP_HEADER_SIZE,
+		mp->size - mp->row_begin - CSV_MP_HEADER_SIZE);
+	mp->size -= CSV_MP_HEADER_SIZE - header_size;
+	mp->row_begin = mp->size;
+	mp->field_count = 0;
+	mp->row_count++;
+}
+
+void
+csv_mp_create(struct csv_mp *mp, struct csv *csv,
+	      const int *types, uint32_t type_count)
+{
+	memset(mp, 0, sizeof(*mp));
+	mp->csv = csv;
+	mp->types = types;
+	mp->type_count = type_count;
+	/* The batch header is filled in by csv_mp_batch(). */
+	mp->size = CSV_MP_HEADER_SIZE;
+	mp->row_begin = mp->size;
+	csv_setopt(csv, CSV_OPT_EMIT_CTX, mp);
+	csv_setopt(csv, CSV_OPT_EMIT_FIELD, csv_mp_emit_field);
+	csv_setopt(csv, CSV_OPT_EMIT_ROW, csv_mp_emit_row);
+}
+
+void
+csv_mp_destroy(struct csv_mp *mp)
+{
+	if (mp->buf != NULL) {
+		mp->csv->realloc(mp->buf, 0);
+		mp->buf = NULL;
+	}
+}
+
+const char *
+csv_mp_batch(struct csv_mp *mp, size_t *size)
+{
+	if (mp->buf == NULL) {
+		/* Nothing was parsed, return an empty array. */
+		static const char empty[] = { (char)0x90 };
+		*size = sizeof(empty);
+		return empty;
+	}
+	/*
+	 * Rows are encoded in place, so the batch header has
+	 * the maximal size, which is fine for MsgPack.
+	 */
+	char *data = mp_store_u8(mp->buf, 0xdd);
+	mp_store_u32(data, mp->row_count);
+	*size = mp->row_begin;
+	return mp->buf;
+}
+
+void
+csv_mp_reset(struct csv_mp *mp)
+{
+	size_t tail = mp->size - mp->row_begin;
+	if (tail > 0) {
+		memmove(mp->buf + CSV_MP_HEADER_SIZE,
+			mp->buf + mp->row_begin, tail);
+	}
+	mp->size = CSV_MP_HEADER_SIZE + tail;
+	mp->row_begin = CSV_MP_HEADER_SIZE;
+	mp->row_count = 0;
+}
@@ -31,6 +31,7 @@
  * SUCH DAMAGE.
  */
 #include <stdio.h>
+#include <stdint.h>
 
 #if defined(__cplusplus)
 extern "C" {
@@ -164,6 +165,74 @@ csv_feed(struct csv_iterator *it, const char *buf, size_t buf_len);
 size_t
 csv_escape_field(struct csv *csv, const char *field, size_t field_len, char *dst, size_t dst_size);
 
+/** Type of a field encoded by csv_mp. */
+enum csv_mp_field_type {
+	/** Encode the field as is, as a MsgPack string. */
+	CSV_MP_STRING,
+	/** Signed or unsigned integer. */
+	CSV_MP_INTEGER,
+	/** Integer if the field is integral, double otherwise. */
+	CSV_MP_NUMBER,
+};
+
+/**
+ * CSV to MsgPack encoder. It's installed as emit callbacks
+ * of a csv parser and appends every parsed row to one buffer
+ * as a MsgPack array. The buffer is a MsgPack array of tuples,
+ * which can be passed to box_insert_batch() as is, so bulk
+ * loads don't create a Lua table per row.
+ */
+struct csv_mp {
+	struct csv *csv;
+	/** Batch header followed by encoded rows. */
+	char *buf;
+	/** Size of the encoded data, including the current row. */
+	size_t size;
+	/** Size of the allocated buffer. */
+	size_t capacity;
+	/** Number of complete rows in the batch. */
+	uint32_t row_count;
+	/** Offset of the current row in the buffer. */
+	size_t row_begin;
+	/** Number of fields encoded for the current row. */
+	uint32_t field_count;
+	/** Number of rows parsed so far, including skipped. */
+	uint64_t line_count;
+	/** Number of leading rows to skip, e.g. a header. */
+	int skip_rows;
+	/**
+	 * Types of the first type_count fields of a row, see
+	 * csv_mp_field_type. The rest are strings. The array
+	 * must outlive the encoder.
+	 */
+	const int *types;
+	uint32_t type_count;
+};
+
+/**
+ * Create an encoder and set it as emit callbacks of @a csv.
+ */
+void
+csv_mp_create(struct csv_mp *mp, struct csv *csv,
+	      const int *types, uint32_t type_count);
+
+void
+csv_mp_destroy(struct csv_mp *mp);
+
+/**
+ * Return the batch of complete rows encoded as a MsgPack
+ * array. The batch is valid until the next call to the parser
+ * or csv_mp_reset().
+ * @param[out] size size of the batch
+ */
+const char *
+csv_mp_batch(struct csv_mp *mp, size_t *size);
+
+/**
+ * Start a new batch. A partially parsed row is moved to it.
+ */
+void
+csv_mp_reset(struct csv_mp *mp);
 
 static inline const char *
 csv_iterator_get_field(struct csv_iterator *it)
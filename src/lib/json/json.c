@@ -226,10 +226,15 @@ json_lexer_next_token(struct json_lexer *lexer, struct json_token *token)
 		if (lexer->offset == lexer->src_len)
 			return lexer->symbol_count;
 		c = json_current_char(lexer);
-		if (c == '"' || c == '\'')
+		if (c == '"' || c == '\'') {
 			rc = json_parse_string(lexer, token, c);
-		else
+		} else if (c == '*') {
+			/* Skip * - one byte char. */
+			json_skip_char(lexer);
+			token->type = JSON_TOKEN_ANY;
+		} else {
 			rc = json_parse_integer(lexer, token);
+		}
 		if (rc != 0)
 			return rc;
 		/*
@@ -270,7 +275,8 @@ json_token_cmp(const struct json_token *a, const struct json_token *b)
 	} else if (a->type == JSON_TOKEN_NUM) {
 		ret = a->num - b->num;
 	} else {
-		unreachable();
+		/* All [*] tokens are equal. */
+		assert(a->type == JSON_TOKEN_ANY);
 	}
 	return ret;
 }
@@ -317,6 +323,24 @@ json_path_validate(const char *path, int path_len, int index_base)
 	return rc;
 }
 
+int
+json_path_multikey_offset(const char *path, int path_len, int index_base)
+{
+	struct json_lexer lexer;
+	json_lexer_create(&lexer, path, path_len, index_base);
+	struct json_token token;
+	int rc, last_offset = 0;
+	while ((rc = json_lexer_next_token(&lexer, &token)) == 0 &&
+	       token.type != JSON_TOKEN_END) {
+		if (token.type == JSON_TOKEN_ANY)
+			return last_offset;
+		last_offset = lexer.offset;
+	}
+	/* The path must be valid. */
+	assert(rc == 0);
+	return path_len;
+}
+
 /**
  * An snprint-style helper to print an individual token key.
  */
@@ -332,6 +356,9 @@ json_token_snprint(char *buf, int size, const struct json_token *token,
 	case JSON_TOKEN_STR:
 		len = snprintf(buf, size, "[\"%.*s\"]", token->len, token->str);
 		break;
+	case JSON_TOKEN_ANY:
+		len = snprintf(buf, size, "[*]");
+		break;
 	default:
 		unreachable();
 	}
@@ -420,6 +447,9 @@ json_token_hash(struct json_token *token)
 	} else if (token->type == JSON_TOKEN_NUM) {
 		data = &token->num;
 		data_size = sizeof(token->num);
+	} else if (token->type == JSON_TOKEN_ANY) {
+		data = "*";
+		data_size = 1;
 	} else {
 		unreachable();
 	}
@@ -459,7 +489,8 @@ struct json_token *
 json_tree_lookup_slowpath(struct json_tree *tree, struct json_token *parent,
 			  const struct json_token *token)
 {
-	assert(token->type == JSON_TOKEN_STR);
+	assert(token->type == JSON_TOKEN_STR ||
+	       token->type == JSON_TOKEN_ANY);
 	struct json_token key;
 	key.type = token->type;
 	key.str = token->str;
@@ -505,9 +536,9 @@ json_tree_add(struct json_tree *tree, struct json_token *parent,
 	}
 	/*
 	 * Insert the token into the hash (only for tokens representing
-	 * JSON map entries, see the comment to json_tree::hash).
+	 * JSON map entries and [*], see the comment to json_tree::hash).
 	 */
-	if (token->type == JSON_TOKEN_STR) {
+	if (token->type != JSON_TOKEN_NUM) {
 		mh_int_t id = mh_json_put(tree->hash,
 			(const struct json_token **)&token, NULL, NULL);
 		if (id == mh_end(tree->hash))
@@ -543,9 +574,9 @@ json_tree_del(struct json_tree *tree, struct json_token *token)
 		parent->max_child_idx--;
 	/*
 	 * Remove the token from the hash (only for tokens representing
-	 * JSON map entries, see the comment to json_tree::hash).
+	 * JSON map entries and [*], see the comment to json_tree::hash).
 	 */
-	if (token->type == JSON_TOKEN_STR) {
+	if (token->type != JSON_TOKEN_NUM) {
 		mh_int_t id = mh_json_find(tree->hash, token, NULL);
 		assert(id != mh_end(tree->hash));
 		mh_json_del(tree->hash, id, NULL);
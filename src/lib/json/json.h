@@ -66,6 +66,8 @@ struct json_lexer {
 enum json_token_type {
 	JSON_TOKEN_NUM,
 	JSON_TOKEN_STR,
+	/** Any array element, [*] in a path. */
+	JSON_TOKEN_ANY,
 	/** Lexer reached end of path. */
 	JSON_TOKEN_END,
 };
@@ -73,7 +75,7 @@ enum json_token_type {
 /**
  * Element of a JSON path. It can be either string or number.
  * String idenfiers are in ["..."] and between dots. Numbers are
- * indexes in [...].
+ * indexes in [...]. [*] stands for any element of an array.
  *
  * May be organized in a tree-like structure reflecting a JSON
  * document structure, for more details see the comment to struct
@@ -96,8 +98,8 @@ struct json_token {
 	/**
 	 * Array of child tokens in a JSON tree. Indexes in this
 	 * array match [token.num] index for JSON_TOKEN_NUM type
-	 * and are allocated sequentially for JSON_TOKEN_STR child
-	 * tokens.
+	 * and are allocated sequentially for JSON_TOKEN_STR and
+	 * JSON_TOKEN_ANY child tokens.
 	 */
 	struct json_token **children;
 	/** Allocation size of children array. */
@@ -177,7 +179,8 @@ struct json_tree {
 	 * Hash table that is used to quickly look up a token
 	 * corresponding to a JSON map item given a key and
 	 * a parent token. We store all tokens that have type
-	 * JSON_TOKEN_STR in this hash table. Apparently, we
+	 * JSON_TOKEN_STR or JSON_TOKEN_ANY in this hash table.
+	 * Apparently, we
 	 * don't need to store JSON_TOKEN_NUM tokens as we can
 	 * quickly look them up in the children array anyway.
 	 *
@@ -264,6 +267,25 @@ json_token_is_leaf(struct json_token *token)
 	return token->max_child_idx < 0;
 }
 
+/**
+ * Test if a given JSON token is multikey, i.e. has a single
+ * JSON_TOKEN_ANY child standing for any of its array elements.
+ */
+static inline bool
+json_token_is_multikey(struct json_token *token)
+{
+	return token->max_child_idx == 0 &&
+	       token->children[0]->type == JSON_TOKEN_ANY;
+}
+
+/**
+ * Return the offset of the first [*] token in a JSON path,
+ * or @a path_len if the path doesn't have one. The path
+ * must be valid (may be tested with json_path_validate).
+ */
+int
+json_path_multikey_offset(const char *path, int path_len, int index_base);
+
 /**
  * An snprint-style function to print the path to a token in
  * a JSON tree.
@@ -310,6 +332,9 @@ json_tree_lookup(struct json_tree *tree, struct json_token *parent,
 	if (likely(token->type == JSON_TOKEN_NUM)) {
 		ret = (int)token->num < parent->children_capacity ?
 		      parent->children[token->num] : NULL;
+		/* Children of [*] or keys aren't numbered. */
+		if (ret != NULL && unlikely(ret->type != JSON_TOKEN_NUM))
+			ret = NULL;
 	} else {
 		ret = json_tree_lookup_slowpath(tree, parent, token);
 	}
@@ -39,6 +39,20 @@
 #include <assert.h>
 #include <string.h>
 
+/**
+ * Allocate a table of @a block_count blocks aligned by the cache
+ * line size so that checking a value touches exactly one line.
+ */
+static struct bloom_block *
+bloom_alloc_table(uint32_t block_count)
+{
+	void *table;
+	if (posix_memalign(&table, BLOOM_CACHE_LINE,
+			   block_count * sizeof(struct bloom_block)) != 0)
+		return NULL;
+	return table;
+}
+
 int
 bloom_create(struct bloom *bloom, uint32_t number_of_values,
 	     double false_positive_rate)
@@ -49,12 +63,69 @@ bloom_create(struct bloom *bloom, uint32_t number_of_values,
 	uint32_t block_bits = CHAR_BIT * sizeof(struct bloom_block);
 	uint32_t block_count = (bit_count + block_bits - 1) / block_bits;
 
-	bloom->table = calloc(block_count, sizeof(*bloom->table));
+	bloom->table = bloom_alloc_table(block_count);
 	if (bloom->table == NULL)
 		return -1;
+	memset(bloom->table, 0, block_count * sizeof(*bloom->table));
 
 	bloom->table_size = block_count;
 	bloom->hash_count = hash_count;
+	bloom->type = BLOOM_BLOCKED;
+	return 0;
+}
+
+/**
+ * Return the expected false positive rate of a split block
+ * filter storing @a lambda values per block on average.
+ *
+ * The number of values stored in a block follows the Poisson
+ * distribution. Given c values in a block, a bit of a word is
+ * set with probability 1 - (1 - 1/64)^c independently of other
+ * words.
+ */
+static double
+bloom_split_fpr(double lambda)
+{
+	const double word_bits = sizeof(uint64_t) * CHAR_BIT;
+	uint32_t max_c = lambda + 10 * sqrt(lambda) + 10;
+	double fpr = 0;
+	for (uint32_t c = 1; c <= max_c; c++) {
+		double p_c = exp(c * log(lambda) - lambda - lgamma(c + 1));
+		double p_bit = 1 - pow(1 - 1 / word_bits, c);
+		fpr += p_c * pow(p_bit, BLOOM_SPLIT_WORDS);
+	}
+	return fpr;
+}
+
+int
+bloom_create_split_block(struct bloom *bloom, uint32_t number_of_values,
+			 double false_positive_rate)
+{
+	/*
+	 * There's no closed form for the filter size, so look
+	 * for the least number of blocks that gives the desired
+	 * false positive rate with binary search.
+	 */
+	uint32_t lo = 1;
+	uint32_t hi = number_of_values > 0 ? number_of_values : 1;
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		if (bloom_split_fpr((double)number_of_values / mid) <=
+		    false_positive_rate)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	uint32_t block_count = hi;
+
+	bloom->table = bloom_alloc_table(block_count);
+	if (bloom->table == NULL)
+		return -1;
+	memset(bloom->table, 0, block_count * sizeof(*bloom->table));
+
+	bloom->table_size = block_count;
+	bloom->hash_count = BLOOM_SPLIT_WORDS;
+	bloom->type = BLOOM_SPLIT_BLOCK;
 	return 0;
 }
 
@@ -67,6 +138,10 @@ bloom_destroy(struct bloom *bloom)
 double
 bloom_fpr(const struct bloom *bloom, uint32_t number_of_values)
 {
+	if (bloom->type == BLOOM_SPLIT_BLOCK) {
+		return bloom_split_fpr((double)number_of_values /
+				       bloom->table_size);
+	}
 	/* Number of hash functions. */
 	uint16_t k = bloom->hash_count;
 	/* Number of bits. */
@@ -95,7 +170,7 @@ int
 bloom_load_table(struct bloom *bloom, const char *table)
 {
 	size_t size = bloom->table_size * sizeof(struct bloom_block);
-	bloom->table = malloc(size);
+	bloom->table = bloom_alloc_table(bloom->table_size);
 	if (bloom->table == NULL)
 		return -1;
 	memcpy(bloom->table, table, size);
@@ -41,6 +41,8 @@
  *  "Less Hashing, Same Performance: Building a Better Bloom Filter"
  *   https://www.eecs.harvard.edu/~michaelm/postscripts/tr-02-05.pdf
  * 3) Using only one hash value that is splitted into several independent parts
+ *
+ * A split block variant is also available, see BLOOM_SPLIT_BLOCK.
  */
 
 #include <stdint.h>
@@ -56,15 +58,42 @@ extern "C" {
 enum {
 	/* Expected cache line of target processor */
 	BLOOM_CACHE_LINE = 64,
+	/* Number of words in a block of a split block filter */
+	BLOOM_SPLIT_WORDS = BLOOM_CACHE_LINE / sizeof(uint64_t),
 };
 
 typedef uint32_t bloom_hash_t;
 
+/**
+ * Bloom filter layout.
+ */
+enum bloom_type {
+	/**
+	 * Each value sets hash_count bits chosen by double
+	 * hashing anywhere in one block. The bits are tested
+	 * one by one until the first one that is not set.
+	 */
+	BLOOM_BLOCKED = 0,
+	/**
+	 * A block is split into BLOOM_SPLIT_WORDS 64-bit words
+	 * and each value sets exactly one bit in each word (so
+	 * hash_count is always BLOOM_SPLIT_WORDS). Bit numbers
+	 * are computed independently with multiply-shift, so
+	 * a lookup is a branchless masked compare of the whole
+	 * block that compilers turn into a few vector
+	 * instructions.
+	 */
+	BLOOM_SPLIT_BLOCK = 1,
+};
+
 /**
  * Cache-line-size block of bloom filter
  */
 struct bloom_block {
-	unsigned char bits[BLOOM_CACHE_LINE];
+	union {
+		unsigned char bits[BLOOM_CACHE_LINE];
+		uint64_t words[BLOOM_SPLIT_WORDS];
+	};
 };
 
 /**
@@ -75,7 +104,9 @@ struct bloom {
 	uint32_t table_size;
 	/* Number of hash function per value */
 	uint16_t hash_count;
-	/* Bit field table */
+	/* Layout of the table, see enum bloom_type */
+	uint16_t type;
+	/* Bit field table, aligned by BLOOM_CACHE_LINE */
 	struct bloom_block *table;
 };
 
@@ -93,6 +124,19 @@ int
 bloom_create(struct bloom *bloom, uint32_t number_of_values,
 	     double false_positive_rate);
 
+/**
+ * Allocate and initialize an instance of split block bloom filter
+ * (see BLOOM_SPLIT_BLOCK)
+ *
+ * @param bloom - structure to initialize
+ * @param number_of_values - estimated number of values to be added
+ * @param false_positive_rate - desired false positive rate
+ * @return 0 - OK, -1 - memory error
+ */
+int
+bloom_create_split_block(struct bloom *bloom, uint32_t number_of_values,
+			 double false_positive_rate);
+
 /**
  * Free resources of the bloom filter
  *
@@ -162,9 +206,42 @@ bloom_load_table(struct bloom *bloom, const char *table);
 
 /* {{{ API definition */
 
+/**
+ * Return the mask of the bit set by a value in word @a i
+ * of a split block.
+ */
+static inline uint64_t
+bloom_split_mask(bloom_hash_t hash, int i)
+{
+	/* Odd constants, one per word. */
+	static const uint32_t salt[BLOOM_SPLIT_WORDS] = {
+		0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+		0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+	};
+	/* The upper 6 bits of the product give a bit number. */
+	return (uint64_t)1 << ((bloom_hash_t)(hash * salt[i]) >> 26);
+}
+
+/**
+ * Return the block of a split block filter a value is stored
+ * in. The block is chosen by the upper bits of the hash while
+ * the bits inside the block mostly depend on the lower ones.
+ */
+static inline struct bloom_block *
+bloom_split_block(const struct bloom *bloom, bloom_hash_t hash)
+{
+	return &bloom->table[((uint64_t)hash * bloom->table_size) >> 32];
+}
+
 static inline void
 bloom_add(struct bloom *bloom, bloom_hash_t hash)
 {
+	if (bloom->type == BLOOM_SPLIT_BLOCK) {
+		struct bloom_block *block = bloom_split_block(bloom, hash);
+		for (int i = 0; i < BLOOM_SPLIT_WORDS; i++)
+			block->words[i] |= bloom_split_mask(hash, i);
+		return;
+	}
 	/* Using lower part of the has for finding a block */
 	bloom_hash_t pos = hash % bloom->table_size;
 	hash = hash / bloom->table_size;
@@ -185,6 +262,18 @@ bloom_add(struct bloom *bloom, bloom_hash_t hash)
 static inline bool
 bloom_maybe_has(const struct bloom *bloom, bloom_hash_t hash)
 {
+	if (bloom->type == BLOOM_SPLIT_BLOCK) {
+		const struct bloom_block *block =
+			bloom_split_block(bloom, hash);
+		/*
+		 * Don't break out of the loop early so that
+		 * the compiler can vectorize it.
+		 */
+		uint64_t missing = 0;
+		for (int i = 0; i < BLOOM_SPLIT_WORDS; i++)
+			missing |= bloom_split_mask(hash, i) & ~block->words[i];
+		return missing == 0;
+	}
 	/* Using lower part of the has for finding a block */
 	bloom_hash_t pos = hash % bloom->table_size;
 	hash = hash / bloom->table_size;
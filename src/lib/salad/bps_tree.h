@@ -157,6 +157,12 @@
  * struct bps_tree_iterator bps_tree_upper_bound(tree, key, exact);
  * struct bps_tree_iterator bps_tree_lower_bound_elem(tree, elem, exact);
  * struct bps_tree_iterator bps_tree_upper_bound_elem(tree, elem, exact);
+ * // with BPS_INNER_CARD defined:
+ * struct bps_tree_iterator bps_tree_lower_bound_get_offset(tree, key, exact,
+ *                                                         offset);
+ * struct bps_tree_iterator bps_tree_upper_bound_get_offset(tree, key, exact,
+ *                                                         offset);
+ * struct bps_tree_iterator bps_tree_iterator_at(tree, offset);
  * size_t bps_tree_approxiamte_count(tree, key);
  * bps_tree_elem_t *bps_tree_iterator_get_elem(tree, itr);
  * bool bps_tree_iterator_next(tree, itr);
@@ -290,11 +296,23 @@
  * #define BPS_TREE_DEBUG_BRANCH_VISIT
  */
 
+/**
+ * A switch that makes inner blocks store the number of elements
+ * in each child subtree. It costs a few children per inner block
+ * and a walk along the path on each insertion and deletion, but
+ * lets one find the offset of a key and an element by its offset
+ * in logarithmic time, see bps_tree_lower_bound_get_offset,
+ * bps_tree_upper_bound_get_offset and bps_tree_iterator_at.
+ * To turn it on,
+ * #define BPS_INNER_CARD
+ */
+
 /* }}} */
 
 /* {{{ BPS-tree internal settings */
 typedef int16_t bps_tree_pos_t;
 typedef uint32_t bps_tree_block_id_t;
+typedef uint32_t bps_tree_card_t;
 /* }}} */
 
 /* {{{ Compile time utils */
@@ -349,6 +367,7 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_build _api_name(build)
 #define bps_tree_destroy _api_name(destroy)
 #define bps_tree_find _api_name(find)
+#define bps_tree_find_batch _api_name(find_batch)
 #define bps_tree_insert _api_name(insert)
 #define bps_tree_insert_get_iterator _api_name(insert_get_iterator)
 #define bps_tree_delete _api_name(delete)
@@ -364,6 +383,9 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_upper_bound _api_name(upper_bound)
 #define bps_tree_lower_bound_elem _api_name(lower_bound_elem)
 #define bps_tree_upper_bound_elem _api_name(upper_bound_elem)
+#define bps_tree_lower_bound_get_offset _api_name(lower_bound_get_offset)
+#define bps_tree_upper_bound_get_offset _api_name(upper_bound_get_offset)
+#define bps_tree_iterator_at _api_name(iterator_at)
 #define bps_tree_approximate_count _api_name(approximate_count)
 #define bps_tree_iterator_get_elem _api_name(iterator_get_elem)
 #define bps_tree_iterator_next _api_name(iterator_next)
@@ -389,6 +411,8 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_root _bps_tree(root)
 #define bps_tree_touch_block _bps_tree(touch_block)
 #define bps_tree_find_ins_point_key _bps_tree(find_ins_point_key)
+#define bps_tree_prefetch_block _bps_tree(prefetch_block)
+#define bps_tree_iterator_prefetch _bps_tree(iterator_prefetch)
 #define bps_tree_find_ins_point_elem _bps_tree(find_ins_point_elem)
 #define bps_tree_find_after_ins_point_key _bps_tree(find_after_ins_point_key)
 #define bps_tree_find_after_ins_point_elem _bps_tree(find_after_ins_point_elem)
@@ -404,6 +428,11 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_collect_path _bps_tree(collect_path)
 #define bps_tree_touch_leaf_path_max_elem _bps_tree(touch_leaf_path_max_elem)
 #define bps_tree_touch_path _bps_tree(touch_path_max_elem)
+#define bps_tree_inner_card _bps_tree(inner_card)
+#define bps_tree_block_card _bps_tree(block_card)
+#define bps_tree_add_path_card _bps_tree(add_path_card)
+#define bps_tree_update_leaf_card _bps_tree(update_leaf_card)
+#define bps_tree_update_inner_card _bps_tree(update_inner_card)
 #define bps_tree_process_replace _bps_tree(process_replace)
 #define bps_tree_debug_memmove _bps_tree(debug_memmove)
 #define bps_tree_insert_into_leaf _bps_tree(insert_into_leaf)
@@ -599,6 +628,21 @@ bps_tree_destroy(struct bps_tree *tree);
 static inline bps_tree_elem_t *
 bps_tree_find(const struct bps_tree *tree, bps_tree_key_t key);
 
+/**
+ * @brief Find elements equal to several keys at once. Descents
+ *  of the keys are interleaved level by level and each next
+ *  block is prefetched, so that cache misses of different keys
+ *  overlap.
+ * @param tree - pointer to a tree
+ * @param keys - keys that will be compared with elements
+ * @param count - number of keys
+ * @param results - pointers to the first equal elements or NULL
+ *  for the keys that are not found
+ */
+static inline void
+bps_tree_find_batch(const struct bps_tree *tree, bps_tree_key_t *keys,
+		    size_t count, bps_tree_elem_t **results);
+
 /**
  * @brief Insert an element to the tree or replace an element in the tree
  * In case of replacing, if 'replaced' argument is not null,
@@ -762,6 +806,48 @@ static inline struct bps_tree_iterator
 bps_tree_upper_bound_elem(const struct bps_tree *tree, bps_tree_elem_t key,
 			  bool *exact);
 
+#ifdef BPS_INNER_CARD
+/**
+ * @brief Same as bps_tree_lower_bound, but also returns the offset
+ * of the found element from the beginning of the tree.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @param exact - see bps_tree_lower_bound. Could be NULL.
+ * @param offset - the number of elements that are less than key.
+ * @return - Lower-bound iterator. Invalid if all elements are less than key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_lower_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset);
+
+/**
+ * @brief Same as bps_tree_upper_bound, but also returns the offset
+ * of the found element from the beginning of the tree.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @param exact - see bps_tree_upper_bound. Could be NULL.
+ * @param offset - the number of elements that are less or equal
+ *  than key.
+ * @return - Upper-bound iterator. Invalid if all elements are less or equal
+ *  than the key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_upper_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset);
+
+/**
+ * @brief Get an iterator to the element with the given offset from
+ * the beginning of the tree.
+ * @param tree - pointer to a tree
+ * @param offset - offset of the element
+ * @return - Iterator. Invalid if offset is not less than the tree size.
+ */
+static inline struct bps_tree_iterator
+bps_tree_iterator_at(const struct bps_tree *tree, size_t offset);
+#endif /* BPS_INNER_CARD */
+
 /**
  * @brief Get approximate number of entries that are equal to given key.
  * Accuracy limits:
@@ -884,6 +970,22 @@ bps_tree_debug_check_internal_functions(bool assertme);
 /* Same as BPS_TREE_MEMMOVE but takes count of values instead of memory size */
 #define BPS_TREE_DATAMOVE(dst, src, num, dst_bck, src_bck) \
 	BPS_TREE_MEMMOVE(dst, src, (num) * sizeof((dst)[0]), dst_bck, src_bck)
+/* Moves children of inner blocks along with their cards, if any */
+#ifdef BPS_INNER_CARD
+#define BPS_TREE_CHILDMOVE(dst_bck, dst_pos, src_bck, src_pos, num) do { \
+	BPS_TREE_DATAMOVE((dst_bck)->child_ids + (dst_pos), \
+			  (src_bck)->child_ids + (src_pos), num, \
+			  dst_bck, src_bck); \
+	BPS_TREE_DATAMOVE((dst_bck)->child_cards + (dst_pos), \
+			  (src_bck)->child_cards + (src_pos), num, \
+			  dst_bck, src_bck); \
+} while (0)
+#else
+#define BPS_TREE_CHILDMOVE(dst_bck, dst_pos, src_bck, src_pos, num) \
+	BPS_TREE_DATAMOVE((dst_bck)->child_ids + (dst_pos), \
+			  (src_bck)->child_ids + (src_pos), num, \
+			  dst_bck, src_bck)
+#endif
 
 /**
  * Types of a block
@@ -914,7 +1016,11 @@ enum bps_tree_max_sizes {
 		/ sizeof(bps_tree_elem_t),
 	BPS_TREE_MAX_COUNT_IN_INNER =
 		(BPS_TREE_BLOCK_SIZE - sizeof(struct bps_block))
-		/ (sizeof(bps_tree_elem_t) + sizeof(bps_tree_block_id_t)),
+		/ (sizeof(bps_tree_elem_t) + sizeof(bps_tree_block_id_t)
+#ifdef BPS_INNER_CARD
+		   + sizeof(bps_tree_card_t)
+#endif
+		  ),
 	BPS_TREE_MAX_DEPTH = 16
 };
 
@@ -960,6 +1066,10 @@ struct bps_inner {
 	bps_tree_elem_t elems[BPS_TREE_MAX_COUNT_IN_INNER - 1];
 	/* Corresponding child IDs */
 	bps_tree_block_id_t child_ids[BPS_TREE_MAX_COUNT_IN_INNER];
+#ifdef BPS_INNER_CARD
+	/* Numbers of elements in the corresponding child subtrees */
+	bps_tree_card_t child_cards[BPS_TREE_MAX_COUNT_IN_INNER];
+#endif
 };
 
 /**
@@ -1009,6 +1119,13 @@ struct bps_inner_path_elem {
 	bps_tree_block_id_t max_elem_block_id;
 	/* Holder of max_elem_copy (pos) */
 	bps_tree_pos_t max_elem_pos;
+#ifdef BPS_INNER_CARD
+	/*
+	 * Pointer to the card of the block in parent (NULL for root
+	 * and for a new block, which is not linked to parent yet)
+	 */
+	bps_tree_card_t *card_copy;
+#endif
 };
 
 /**
@@ -1033,8 +1150,22 @@ struct bps_leaf_path_elem {
 	bps_tree_block_id_t max_elem_block_id;
 	/* Holder of max_elem_copy (pos) */
 	bps_tree_pos_t max_elem_pos;
+#ifdef BPS_INNER_CARD
+	/*
+	 * Pointer to the card of the block in parent (NULL for root
+	 * and for a new block, which is not linked to parent yet)
+	 */
+	bps_tree_card_t *card_copy;
+#endif
 };
 
+/* An initializer of an unused path element */
+#ifdef BPS_INNER_CARD
+#define BPS_TREE_PATH_ELEM_INITIALIZER {0, 0, 0, 0, 0, 0, 0, 0, 0}
+#else
+#define BPS_TREE_PATH_ELEM_INITIALIZER {0, 0, 0, 0, 0, 0, 0, 0}
+#endif
+
 /**
  * @brief Tree construction. Fills struct bps_tree members.
  * @param tree - pointer to a tree
@@ -1170,6 +1301,9 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 			}
 			parents[i]->child_ids[parents[i]->header.size] =
 				insert_id;
+#ifdef BPS_INNER_CARD
+			parents[i]->child_cards[parents[i]->header.size] = 0;
+#endif
 			if (new_id == (bps_tree_block_id_t)-1)
 				break;
 			if (i == depth - 2) {
@@ -1179,6 +1313,12 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 			}
 		}
 
+#ifdef BPS_INNER_CARD
+		/* The leaf belongs to the last child of each parent. */
+		for (bps_tree_block_id_t i = 0; i < depth - 1; i++)
+			parents[i]->child_cards[parents[i]->header.size] +=
+				leaf->header.size;
+#endif
 		bps_tree_elem_t insert_value = current[leaf->header.size - 1];
 		for (bps_tree_block_id_t i = 0; i < depth - 1; i++) {
 			parents[i]->header.size++;
@@ -1527,6 +1667,37 @@ bps_tree_iterator_is_invalid(struct bps_tree_iterator *itr)
 	return itr->block_id == (bps_tree_block_id_t)(-1);
 }
 
+/**
+ * @brief Prefetch a whole block into CPU cache.
+ */
+static inline void
+bps_tree_prefetch_block(const struct bps_block *block)
+{
+	/* Stride is the cache line size. */
+	for (size_t offset = 0; offset < BPS_TREE_BLOCK_SIZE; offset += 64)
+		__builtin_prefetch((const char *)block + offset);
+}
+
+/**
+ * @brief Prefetch the leaf that follows (if @a forward) or
+ * precedes the leaf an iterator has just moved to, so that the
+ * next leaf transition doesn't stall on a cache miss.
+ */
+static inline void
+bps_tree_iterator_prefetch(const struct bps_tree *tree,
+			   struct bps_tree_iterator *itr, bool forward)
+{
+	struct bps_block *block =
+		bps_tree_restore_block_ver(tree, itr->block_id, &itr->view);
+	if (block->type != BPS_TREE_BT_LEAF)
+		return;
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_block_id_t id = forward ? leaf->next_id : leaf->prev_id;
+	if (id != (bps_tree_block_id_t)(-1))
+		bps_tree_prefetch_block(bps_tree_restore_block_ver(tree, id,
+								   &itr->view));
+}
+
 /**
  * @brief Check for a validity of an iterator and return pointer
  * to the leaf.  Position is also checked an (-1) is converted to
@@ -1866,6 +2037,162 @@ bps_tree_upper_bound_elem(const struct bps_tree *tree, bps_tree_elem_t key,
 	return res;
 }
 
+#ifdef BPS_INNER_CARD
+/**
+ * @brief Same as bps_tree_lower_bound, but also returns the offset
+ * of the found element from the beginning of the tree.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @param exact - see bps_tree_lower_bound. Could be NULL.
+ * @param offset - the number of elements that are less than key.
+ * @return - Lower-bound iterator. Invalid if all elements are less than key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_lower_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset)
+{
+	struct bps_tree_iterator res;
+	matras_head_read_view(&res.view);
+	bool local_result;
+	if (!exact)
+		exact = &local_result;
+	*exact = false;
+	*offset = 0;
+	if (tree->root_id == (bps_tree_block_id_t)(-1)) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	struct bps_block *block = bps_tree_root(tree);
+	bps_tree_block_id_t block_id = tree->root_id;
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_ins_point_key(tree, inner->elems,
+						  inner->header.size - 1,
+						  key, exact);
+		for (bps_tree_pos_t j = 0; j < pos; j++)
+			*offset += inner->child_cards[j];
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block(tree, block_id);
+	}
+
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_pos_t pos;
+	pos = bps_tree_find_ins_point_key(tree, leaf->elems, leaf->header.size,
+					  key, exact);
+	*offset += pos;
+	if (pos >= leaf->header.size) {
+		res.block_id = leaf->next_id;
+		res.pos = 0;
+	} else {
+		res.block_id = block_id;
+		res.pos = pos;
+	}
+	return res;
+}
+
+/**
+ * @brief Same as bps_tree_upper_bound, but also returns the offset
+ * of the found element from the beginning of the tree.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @param exact - see bps_tree_upper_bound. Could be NULL.
+ * @param offset - the number of elements that are less or equal
+ *  than key.
+ * @return - Upper-bound iterator. Invalid if all elements are less or equal
+ *  than the key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_upper_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset)
+{
+	struct bps_tree_iterator res;
+	matras_head_read_view(&res.view);
+	bool local_result;
+	if (!exact)
+		exact = &local_result;
+	*exact = false;
+	*offset = 0;
+	bool exact_test;
+	if (tree->root_id == (bps_tree_block_id_t)(-1)) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	struct bps_block *block = bps_tree_root(tree);
+	bps_tree_block_id_t block_id = tree->root_id;
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_after_ins_point_key(tree, inner->elems,
+							inner->header.size - 1,
+							key, &exact_test);
+		if (exact_test)
+			*exact = true;
+		for (bps_tree_pos_t j = 0; j < pos; j++)
+			*offset += inner->child_cards[j];
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block(tree, block_id);
+	}
+
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_pos_t pos;
+	pos = bps_tree_find_after_ins_point_key(tree, leaf->elems,
+						leaf->header.size,
+						key, &exact_test);
+	if (exact_test)
+		*exact = true;
+	*offset += pos;
+	if (pos >= leaf->header.size) {
+		res.block_id = leaf->next_id;
+		res.pos = 0;
+	} else {
+		res.block_id = block_id;
+		res.pos = pos;
+	}
+	return res;
+}
+
+/**
+ * @brief Get an iterator to the element with the given offset from
+ * the beginning of the tree.
+ * @param tree - pointer to a tree
+ * @param offset - offset of the element
+ * @return - Iterator. Invalid if offset is not less than the tree size.
+ */
+static inline struct bps_tree_iterator
+bps_tree_iterator_at(const struct bps_tree *tree, size_t offset)
+{
+	struct bps_tree_iterator res;
+	matras_head_read_view(&res.view);
+	if (offset >= tree->size) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	struct bps_block *block = bps_tree_root(tree);
+	bps_tree_block_id_t block_id = tree->root_id;
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos = 0;
+		while (offset >= inner->child_cards[pos]) {
+			offset -= inner->child_cards[pos];
+			pos++;
+			assert(pos < inner->header.size);
+		}
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block(tree, block_id);
+	}
+	assert(offset < (size_t)block->size);
+	res.block_id = block_id;
+	res.pos = (bps_tree_pos_t)offset;
+	return res;
+}
+#endif /* BPS_INNER_CARD */
+
 /**
  * @brief Get approximate number of entries that are equal to given key.
  * Accuracy limits:
@@ -1991,7 +2318,9 @@ bps_tree_iterator_next(const struct bps_tree *tree, struct bps_tree_iterator *it
 	if (itr->pos >= leaf->header.size) {
 		itr->block_id = leaf->next_id;
 		itr->pos = 0;
-		return itr->block_id != (bps_tree_block_id_t)(-1);
+		if (itr->block_id == (bps_tree_block_id_t)(-1))
+			return false;
+		bps_tree_iterator_prefetch(tree, itr, true);
 	}
 	return true;
 }
@@ -2021,7 +2350,9 @@ bps_tree_iterator_prev(const struct bps_tree *tree, struct bps_tree_iterator *it
 	if (itr->pos == 0) {
 		itr->block_id = leaf->prev_id;
 		itr->pos = (bps_tree_pos_t)(-1);
-		return itr->block_id != (bps_tree_block_id_t)(-1);
+		if (itr->block_id == (bps_tree_block_id_t)(-1))
+			return false;
+		bps_tree_iterator_prefetch(tree, itr, false);
 	} else {
 		itr->pos--;
 	}
@@ -2086,6 +2417,55 @@ bps_tree_find(const struct bps_tree *tree, bps_tree_key_t key)
 		return 0;
 }
 
+/**
+ * @sa bps_tree_find_batch description
+ */
+static inline void
+bps_tree_find_batch(const struct bps_tree *tree, bps_tree_key_t *keys,
+		    size_t count, bps_tree_elem_t **results)
+{
+	/* Number of descents interleaved at once. */
+	enum { FIND_BATCH_SIZE = 16 };
+	if (tree->root_id == (bps_tree_block_id_t)(-1)) {
+		for (size_t i = 0; i < count; i++)
+			results[i] = NULL;
+		return;
+	}
+	struct bps_block *root = bps_tree_root(tree);
+	struct bps_block *blocks[FIND_BATCH_SIZE];
+	for (size_t first = 0; first < count; first += FIND_BATCH_SIZE) {
+		size_t n = count - first < FIND_BATCH_SIZE ?
+			   count - first : FIND_BATCH_SIZE;
+		for (size_t i = 0; i < n; i++)
+			blocks[i] = root;
+		for (bps_tree_block_id_t d = 0; d < tree->depth - 1; d++) {
+			for (size_t i = 0; i < n; i++) {
+				struct bps_inner *inner =
+					(struct bps_inner *)blocks[i];
+				bool exact = false;
+				bps_tree_pos_t pos;
+				pos = bps_tree_find_ins_point_key(tree,
+						inner->elems,
+						inner->header.size - 1,
+						keys[first + i], &exact);
+				blocks[i] = bps_tree_restore_block(tree,
+						inner->child_ids[pos]);
+				bps_tree_prefetch_block(blocks[i]);
+			}
+		}
+		for (size_t i = 0; i < n; i++) {
+			struct bps_leaf *leaf = (struct bps_leaf *)blocks[i];
+			bool exact = false;
+			bps_tree_pos_t pos;
+			pos = bps_tree_find_ins_point_key(tree, leaf->elems,
+							  leaf->header.size,
+							  keys[first + i],
+							  &exact);
+			results[first + i] = exact ? leaf->elems + pos : NULL;
+		}
+	}
+}
+
 /**
  * @brief Add a block to the garbage for future reuse
  */
@@ -2259,6 +2639,10 @@ bps_tree_collect_path(struct bps_tree *tree, bps_tree_elem_t new_elem,
 		path[i].max_elem_copy = max_elem_copy;
 		path[i].max_elem_block_id = max_elem_block_id;
 		path[i].max_elem_pos = max_elem_pos;
+#ifdef BPS_INNER_CARD
+		path[i].card_copy = prev_ext != NULL ?
+			prev_ext->block->child_cards + prev_pos : NULL;
+#endif
 
 		if (pos < inner->header.size - 1) {
 			max_elem_copy = inner->elems + pos;
@@ -2288,6 +2672,10 @@ bps_tree_collect_path(struct bps_tree *tree, bps_tree_elem_t new_elem,
 	leaf_path_elem->max_elem_copy = max_elem_copy;
 	leaf_path_elem->max_elem_block_id = max_elem_block_id;
 	leaf_path_elem->max_elem_pos = max_elem_pos;
+#ifdef BPS_INNER_CARD
+	leaf_path_elem->card_copy = prev_ext != NULL ?
+		prev_ext->block->child_cards + prev_pos : NULL;
+#endif
 }
 
 /**
@@ -2323,8 +2711,92 @@ bps_tree_touch_path(struct bps_tree *tree,
 			bps_tree_touch_block(tree, path->max_elem_block_id);
 		path->max_elem_copy = holder->elems + path->max_elem_pos;
 	}
+#ifdef BPS_INNER_CARD
+	struct bps_inner_path_elem *parent = leaf_path_elem->parent;
+	if (parent == NULL)
+		return;
+	leaf_path_elem->card_copy = parent->block->child_cards +
+				    leaf_path_elem->pos_in_parent;
+	for (struct bps_inner_path_elem *path = parent; path->parent != NULL;
+	     path = path->parent) {
+		path->card_copy = path->parent->block->child_cards +
+				  path->pos_in_parent;
+	}
+#endif
+}
+
+#ifdef BPS_INNER_CARD
+/**
+ * @brief Number of elements in the subtree of an inner block
+ */
+static inline bps_tree_card_t
+bps_tree_inner_card(struct bps_inner *inner)
+{
+	bps_tree_card_t card = 0;
+	for (bps_tree_pos_t i = 0; i < inner->header.size; i++)
+		card += inner->child_cards[i];
+	return card;
+}
+
+/**
+ * @brief Number of elements in the subtree of a block by its ID
+ */
+static inline bps_tree_card_t
+bps_tree_block_card(const struct bps_tree *tree, bps_tree_block_id_t id)
+{
+	/* exclusive behaviuor for debug checks */
+	if (tree->root_id == (bps_tree_block_id_t) -1)
+		return 0;
+	struct bps_block *block = bps_tree_restore_block(tree, id);
+	if (block->type == BPS_TREE_BT_LEAF)
+		return block->size;
+	return bps_tree_inner_card((struct bps_inner *)block);
 }
 
+/**
+ * @brief Add a number to the cards of all blocks of a touched path
+ */
+static inline void
+bps_tree_add_path_card(struct bps_leaf_path_elem *leaf_path_elem, int delta)
+{
+	if (leaf_path_elem->card_copy == NULL)
+		return;
+	*leaf_path_elem->card_copy += delta;
+	for (struct bps_inner_path_elem *path = leaf_path_elem->parent;
+	     path->card_copy != NULL; path = path->parent)
+		*path->card_copy += delta;
+}
+
+/**
+ * @brief Write the actual size of a leaf to its card in parent
+ */
+static inline void
+bps_tree_update_leaf_card(struct bps_tree *tree,
+			  struct bps_leaf_path_elem *leaf_path_elem)
+{
+	/* exclusive behaviuor for debug checks */
+	if (tree->root_id == (bps_tree_block_id_t) -1 ||
+	    leaf_path_elem->card_copy == NULL)
+		return;
+	*leaf_path_elem->card_copy = leaf_path_elem->block->header.size;
+}
+
+/**
+ * @brief Write the actual card of an inner block to its parent
+ */
+static inline void
+bps_tree_update_inner_card(struct bps_tree *tree,
+			   struct bps_inner_path_elem *inner_path_elem)
+{
+	/* exclusive behaviuor for debug checks */
+	if (tree->root_id == (bps_tree_block_id_t) -1 ||
+	    inner_path_elem->card_copy == NULL)
+		return;
+	*inner_path_elem->card_copy =
+		bps_tree_inner_card(inner_path_elem->block);
+}
+#endif
+
 /**
  * @brief Replace element by it's path and fill the *replaced argument
  */
@@ -2410,6 +2882,16 @@ bps_tree_debug_memmove(void *dst_arg, void *src_arg, size_t num,
 				assert(src < ((char *)src_inner->elems) +
 				       (BPS_TREE_MAX_COUNT_IN_INNER - 1) *
 				       sizeof(bps_tree_elem_t));
+#ifdef BPS_INNER_CARD
+			} else if (dst >= ((char *)dst_inner->child_cards) &&
+				   dst < ((char *)dst_inner->child_cards) +
+				   BPS_TREE_MAX_COUNT_IN_INNER *
+				   sizeof(bps_tree_card_t)) {
+				assert(src >= (char *)src_inner->child_cards);
+				assert(src < ((char *)src_inner->child_cards) +
+				       BPS_TREE_MAX_COUNT_IN_INNER *
+				       sizeof(bps_tree_card_t));
+#endif
 			} else {
 				assert(dst >= ((char *)dst_inner->child_ids));
 				assert(dst < ((char *)dst_inner->child_ids) +
@@ -2430,6 +2912,17 @@ bps_tree_debug_memmove(void *dst_arg, void *src_arg, size_t num,
 					(BPS_TREE_MAX_COUNT_IN_INNER - 1) *
 					sizeof(bps_tree_elem_t)) {
 				/* nothing to do due to if condition */
+#ifdef BPS_INNER_CARD
+			} else if (dst >= ((char *)dst_inner->child_cards)
+					&& dst <= ((char *)dst_inner->child_cards) +
+					BPS_TREE_MAX_COUNT_IN_INNER *
+					sizeof(bps_tree_card_t)
+					&& src >= (char *)src_inner->child_cards
+					&& src <= ((char *)src_inner->child_cards) +
+					BPS_TREE_MAX_COUNT_IN_INNER *
+					sizeof(bps_tree_card_t)) {
+				/* nothing to do due to if condition */
+#endif
 			} else {
 				assert(dst >= ((char *)dst_inner->child_ids));
 				assert(dst <= ((char *)dst_inner->child_ids) +
@@ -2501,15 +2994,17 @@ bps_tree_insert_into_inner(struct bps_tree *tree,
 		BPS_TREE_DATAMOVE(inner->elems + pos + 1, inner->elems + pos,
 				  inner->header.size - pos - 1, inner, inner);
 		inner->elems[pos] = max_elem;
-		BPS_TREE_DATAMOVE(inner->child_ids + pos + 1,
-				  inner->child_ids + pos,
-				  inner->header.size - pos, inner, inner);
+		BPS_TREE_CHILDMOVE(inner, pos + 1, inner, pos,
+				   inner->header.size - pos);
 	} else {
 		if (pos > 0)
 			inner->elems[pos - 1] = *inner_path_elem->max_elem_copy;
 		*inner_path_elem->max_elem_copy = max_elem;
 	}
 	inner->child_ids[pos] = block_id;
+#ifdef BPS_INNER_CARD
+	inner->child_cards[pos] = bps_tree_block_card(tree, block_id);
+#endif
 
 	inner->header.size++;
 }
@@ -2565,9 +3060,8 @@ bps_tree_delete_from_inner(struct bps_tree *tree,
 	if (pos < inner->header.size - 1) {
 		BPS_TREE_DATAMOVE(inner->elems + pos, inner->elems + pos + 1,
 				  inner->header.size - 2 - pos, inner, inner);
-		BPS_TREE_DATAMOVE(inner->child_ids + pos,
-				  inner->child_ids + pos + 1,
-				  inner->header.size - 1 - pos, inner, inner);
+		BPS_TREE_CHILDMOVE(inner, pos, inner, pos + 1,
+				   inner->header.size - 1 - pos);
 	} else if (pos > 0) {
 		*inner_path_elem->max_elem_copy = inner->elems[pos - 1];
 	}
@@ -2610,6 +3104,10 @@ bps_tree_move_elems_to_right_leaf(struct bps_tree *tree,
 		*a_leaf_path_elem->max_elem_copy =
 			a->elems[a->header.size - 1];
 	*b_leaf_path_elem->max_elem_copy = b->elems[b->header.size - 1];
+#ifdef BPS_INNER_CARD
+	bps_tree_update_leaf_card(tree, a_leaf_path_elem);
+	bps_tree_update_leaf_card(tree, b_leaf_path_elem);
+#endif
 }
 
 /**
@@ -2637,10 +3135,8 @@ bps_tree_move_elems_to_right_inner(struct bps_tree *tree,
 	assert(a->header.size >= num);
 	assert(b->header.size + num <= BPS_TREE_MAX_COUNT_IN_INNER);
 
-	BPS_TREE_DATAMOVE(b->child_ids + num, b->child_ids,
-			  b->header.size, b, b);
-	BPS_TREE_DATAMOVE(b->child_ids, a->child_ids + a->header.size - num,
-			  num, b, a);
+	BPS_TREE_CHILDMOVE(b, num, b, 0, b->header.size);
+	BPS_TREE_CHILDMOVE(b, 0, a, a->header.size - num, num);
 
 	if (!move_to_empty)
 		BPS_TREE_DATAMOVE(b->elems + num, b->elems,
@@ -2658,6 +3154,10 @@ bps_tree_move_elems_to_right_inner(struct bps_tree *tree,
 
 	a->header.size -= num;
 	b->header.size += num;
+#ifdef BPS_INNER_CARD
+	bps_tree_update_inner_card(tree, a_inner_path_elem);
+	bps_tree_update_inner_card(tree, b_inner_path_elem);
+#endif
 }
 
 /**
@@ -2690,6 +3190,10 @@ bps_tree_move_elems_to_left_leaf(struct bps_tree *tree,
 	a->header.size += num;
 	b->header.size -= num;
 	*a_leaf_path_elem->max_elem_copy = a->elems[a->header.size - 1];
+#ifdef BPS_INNER_CARD
+	bps_tree_update_leaf_card(tree, a_leaf_path_elem);
+	bps_tree_update_leaf_card(tree, b_leaf_path_elem);
+#endif
 }
 
 /**
@@ -2717,10 +3221,8 @@ bps_tree_move_elems_to_left_inner(struct bps_tree *tree,
 	assert(b->header.size >= num);
 	assert(a->header.size + num <= BPS_TREE_MAX_COUNT_IN_INNER);
 
-	BPS_TREE_DATAMOVE(a->child_ids + a->header.size, b->child_ids,
-			  num, a, b);
-	BPS_TREE_DATAMOVE(b->child_ids, b->child_ids + num,
-			  b->header.size - num, b, b);
+	BPS_TREE_CHILDMOVE(a, a->header.size, b, 0, num);
+	BPS_TREE_CHILDMOVE(b, 0, b, num, b->header.size - num);
 
 	if (!move_to_empty)
 		a->elems[a->header.size - 1] =
@@ -2737,6 +3239,10 @@ bps_tree_move_elems_to_left_inner(struct bps_tree *tree,
 
 	a->header.size += num;
 	b->header.size -= num;
+#ifdef BPS_INNER_CARD
+	bps_tree_update_inner_card(tree, a_inner_path_elem);
+	bps_tree_update_inner_card(tree, b_inner_path_elem);
+#endif
 }
 
 /**
@@ -2805,6 +3311,10 @@ bps_tree_insert_and_move_elems_to_right_leaf(struct bps_tree *tree,
 		*b_leaf_path_elem->max_elem_copy =
 			b->elems[b->header.size - 1];
 	tree->size++;
+#ifdef BPS_INNER_CARD
+	bps_tree_update_leaf_card(tree, a_leaf_path_elem);
+	bps_tree_update_leaf_card(tree, b_leaf_path_elem);
+#endif
 	return ret;
 }
 
@@ -2841,8 +3351,7 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 	assert(pos >= 0);
 
 	if (!move_to_empty) {
-		BPS_TREE_DATAMOVE(b->child_ids + num, b->child_ids,
-				  b->header.size, b, b);
+		BPS_TREE_CHILDMOVE(b, num, b, 0, b->header.size);
 		BPS_TREE_DATAMOVE(b->elems + num, b->elems,
 				  b->header.size - 1, b, b);
 	}
@@ -2850,12 +3359,13 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 	bps_tree_pos_t mid_part_size = a->header.size - pos;
 	if (mid_part_size > num) {
 		/* In fact insert to 'a' block, to the internal position */
-		BPS_TREE_DATAMOVE(b->child_ids,
-				  a->child_ids + a->header.size - num,
-				  num, b, a);
-		BPS_TREE_DATAMOVE(a->child_ids + pos + 1, a->child_ids + pos,
-				  mid_part_size - num, a, a);
+		BPS_TREE_CHILDMOVE(b, 0, a, a->header.size - num, num);
+		BPS_TREE_CHILDMOVE(a, pos + 1, a, pos, mid_part_size - num);
 		a->child_ids[pos] = block_id;
+#ifdef BPS_INNER_CARD
+		a->child_cards[pos] =
+			bps_tree_block_card(tree, block_id);
+#endif
 
 		BPS_TREE_DATAMOVE(b->elems, a->elems + a->header.size - num,
 				  num - 1, b, a);
@@ -2872,12 +3382,13 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 		a->elems[pos] = max_elem;
 	} else if (mid_part_size == num) {
 		/* In fact insert to 'a' block, to the last position */
-		BPS_TREE_DATAMOVE(b->child_ids,
-				  a->child_ids + a->header.size - num,
-				  num, b, a);
-		BPS_TREE_DATAMOVE(a->child_ids + pos + 1, a->child_ids + pos,
-				  mid_part_size - num, a, a);
+		BPS_TREE_CHILDMOVE(b, 0, a, a->header.size - num, num);
+		BPS_TREE_CHILDMOVE(a, pos + 1, a, pos, mid_part_size - num);
 		a->child_ids[pos] = block_id;
+#ifdef BPS_INNER_CARD
+		a->child_cards[pos] =
+			bps_tree_block_card(tree, block_id);
+#endif
 
 		BPS_TREE_DATAMOVE(b->elems, a->elems + a->header.size - num,
 				  num - 1, b, a);
@@ -2891,12 +3402,13 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 	} else {
 		/* In fact insert to 'b' block */
 		bps_tree_pos_t new_pos = num - mid_part_size - 1;/* Can be 0 */
-		BPS_TREE_DATAMOVE(b->child_ids,
-				  a->child_ids + a->header.size - num + 1,
-				  new_pos, b, a);
+		BPS_TREE_CHILDMOVE(b, 0, a, a->header.size - num + 1, new_pos);
 		b->child_ids[new_pos] = block_id;
-		BPS_TREE_DATAMOVE(b->child_ids + new_pos + 1,
-				  a->child_ids + pos, mid_part_size, b, a);
+#ifdef BPS_INNER_CARD
+		b->child_cards[new_pos] =
+			bps_tree_block_card(tree, block_id);
+#endif
+		BPS_TREE_CHILDMOVE(b, new_pos + 1, a, pos, mid_part_size);
 
 		if (pos == a->header.size) {
 			/* +1 */
@@ -2941,6 +3453,10 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 
 	a->header.size -= (num - 1);
 	b->header.size += num;
+#ifdef BPS_INNER_CARD
+	bps_tree_update_inner_card(tree, a_inner_path_elem);
+	bps_tree_update_inner_card(tree, b_inner_path_elem);
+#endif
 }
 
 /**
@@ -3008,6 +3524,10 @@ bps_tree_insert_and_move_elems_to_left_leaf(struct bps_tree *tree,
 		*b_leaf_path_elem->max_elem_copy =
 			b->elems[b->header.size - 1];
 	tree->size++;
+#ifdef BPS_INNER_CARD
+	bps_tree_update_leaf_card(tree, a_leaf_path_elem);
+	bps_tree_update_leaf_card(tree, b_leaf_path_elem);
+#endif
 	return ret;
 }
 
@@ -3046,14 +3566,15 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 	if (pos >= num) {
 		/* In fact insert to 'b' block */
 		bps_tree_pos_t new_pos = pos - num; /* Can be 0 */
-		BPS_TREE_DATAMOVE(a->child_ids + a->header.size, b->child_ids,
-				  num, a, b);
-		BPS_TREE_DATAMOVE(b->child_ids, b->child_ids + num,
-				  new_pos, b, b);
+		BPS_TREE_CHILDMOVE(a, a->header.size, b, 0, num);
+		BPS_TREE_CHILDMOVE(b, 0, b, num, new_pos);
 		b->child_ids[new_pos] = block_id;
-		BPS_TREE_DATAMOVE(b->child_ids + new_pos + 1,
-				  b->child_ids + pos,
-				  b->header.size - pos, b, b);
+#ifdef BPS_INNER_CARD
+		b->child_cards[new_pos] =
+			bps_tree_block_card(tree, block_id);
+#endif
+		BPS_TREE_CHILDMOVE(b, new_pos + 1, b, pos,
+				   b->header.size - pos);
 
 		if (!move_to_empty)
 			a->elems[a->header.size - 1] =
@@ -3087,14 +3608,16 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 	} else {
 		/* In fact insert to 'a' block */
 		bps_tree_pos_t new_pos = a->header.size + pos; /* Can be 0 */
-		BPS_TREE_DATAMOVE(a->child_ids + a->header.size,
-				  b->child_ids, pos, a, b);
+		BPS_TREE_CHILDMOVE(a, a->header.size, b, 0, pos);
 		a->child_ids[new_pos] = block_id;
-		BPS_TREE_DATAMOVE(a->child_ids + new_pos + 1,
-				  b->child_ids + pos, num - 1 - pos, a, b);
+#ifdef BPS_INNER_CARD
+		a->child_cards[new_pos] =
+			bps_tree_block_card(tree, block_id);
+#endif
+		BPS_TREE_CHILDMOVE(a, new_pos + 1, b, pos, num - 1 - pos);
 		if (!move_all)
-			BPS_TREE_DATAMOVE(b->child_ids, b->child_ids + num - 1,
-					  b->header.size - num + 1, b, b);
+			BPS_TREE_CHILDMOVE(b, 0, b, num - 1,
+					   b->header.size - num + 1);
 
 		if (!move_to_empty)
 			a->elems[a->header.size - 1] =
@@ -3139,6 +3662,10 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 
 	a->header.size += num;
 	b->header.size -= (num - 1);
+#ifdef BPS_INNER_CARD
+	bps_tree_update_inner_card(tree, a_inner_path_elem);
+	bps_tree_update_inner_card(tree, b_inner_path_elem);
+#endif
 }
 
 /**
@@ -3200,6 +3727,10 @@ bps_tree_collect_left_path_elem_leaf(struct bps_tree *tree,
 	new_path_elem->max_elem_copy =
 		parent->block->elems + new_path_elem->pos_in_parent;
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
+#ifdef BPS_INNER_CARD
+	new_path_elem->card_copy =
+		parent->block->child_cards + new_path_elem->pos_in_parent;
+#endif
 	return true;
 }
 
@@ -3227,6 +3758,10 @@ bps_tree_collect_left_path_elem_inner(struct bps_tree *tree,
 	new_path_elem->max_elem_copy = parent->block->elems +
 		new_path_elem->pos_in_parent;
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
+#ifdef BPS_INNER_CARD
+	new_path_elem->card_copy =
+		parent->block->child_cards + new_path_elem->pos_in_parent;
+#endif
 	return true;
 }
 
@@ -3256,6 +3791,10 @@ bps_tree_collect_right_ext_leaf(struct bps_tree *tree,
 		new_path_elem->max_elem_copy = parent->block->elems +
 			new_path_elem->pos_in_parent;
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
+#ifdef BPS_INNER_CARD
+	new_path_elem->card_copy =
+		parent->block->child_cards + new_path_elem->pos_in_parent;
+#endif
 	return true;
 }
 
@@ -3286,6 +3825,10 @@ bps_tree_collect_right_ext_inner(struct bps_tree *tree,
 		new_path_elem->max_elem_copy = parent->block->elems +
 			new_path_elem->pos_in_parent;
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
+#ifdef BPS_INNER_CARD
+	new_path_elem->card_copy =
+		parent->block->child_cards + new_path_elem->pos_in_parent;
+#endif
 	return true;
 }
 
@@ -3305,6 +3848,9 @@ bps_tree_prepare_new_ext_leaf(struct bps_leaf_path_elem *path_elem,
 	new_path_elem->block = new_leaf;
 	new_path_elem->max_elem_copy = max_elem_copy;
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
+#ifdef BPS_INNER_CARD
+	new_path_elem->card_copy = NULL;
+#endif
 }
 
 /**
@@ -3323,6 +3869,9 @@ bps_tree_prepare_new_ext_inner(struct bps_inner_path_elem *path_elem,
 	new_path_elem->block = new_inner;
 	new_path_elem->max_elem_copy = max_elem_copy;
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
+#ifdef BPS_INNER_CARD
+	new_path_elem->card_copy = NULL;
+#endif
 }
 
 /**
@@ -3345,6 +3894,15 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 			     bps_tree_block_id_t *inserted_in_block,
 			     bps_tree_pos_t *inserted_in_pos)
 {
+#ifdef BPS_INNER_CARD
+	/*
+	 * Account the new element in the leaf it is inserted to.
+	 * If it is moved to another block later, the cards of
+	 * both blocks are updated by the move.
+	 */
+	bps_tree_touch_path(tree, leaf_path_elem);
+	bps_tree_add_path_card(leaf_path_elem, 1);
+#endif
 	if (bps_tree_leaf_free_size(leaf_path_elem->block)) {
 		bps_tree_insert_into_leaf(tree, leaf_path_elem, new_elem);
 		BPS_TREE_BRANCH_TRACE(tree, insert_leaf, 1 << 0x0);
@@ -3354,10 +3912,10 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 	}
 	bps_tree_touch_path(tree, leaf_path_elem);
 
-	struct bps_leaf_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-			right_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-			left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-			right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0};
+	struct bps_leaf_path_elem left_ext = BPS_TREE_PATH_ELEM_INITIALIZER,
+			right_ext = BPS_TREE_PATH_ELEM_INITIALIZER,
+			left_left_ext = BPS_TREE_PATH_ELEM_INITIALIZER,
+			right_right_ext = BPS_TREE_PATH_ELEM_INITIALIZER;
 	bool has_left_ext =
 		bps_tree_collect_left_path_elem_leaf(tree, leaf_path_elem,
 						     &left_ext);
@@ -3459,6 +4017,9 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 	}
 
 	if (!bps_tree_reserve_blocks(tree, tree->depth + 1)) {
+#ifdef BPS_INNER_CARD
+		bps_tree_add_path_card(leaf_path_elem, -1);
+#endif
 		return -1;
 	}
 	bps_tree_block_id_t new_block_id = (bps_tree_block_id_t)(-1);
@@ -3704,6 +4265,12 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 		new_root->header.size = 2;
 		new_root->child_ids[0] = tree->root_id;
 		new_root->child_ids[1] = new_block_id;
+#ifdef BPS_INNER_CARD
+		new_root->child_cards[0] =
+			bps_tree_block_card(tree, tree->root_id);
+		new_root->child_cards[1] =
+			bps_tree_block_card(tree, new_block_id);
+#endif
 		new_root->elems[0] = tree->max_elem;
 		tree->root_id = new_root_id;
 		tree->max_elem = new_max_elem;
@@ -3739,10 +4306,10 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 		BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x0);
 		return 0;
 	}
-	struct bps_inner_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0};
+	struct bps_inner_path_elem left_ext = BPS_TREE_PATH_ELEM_INITIALIZER,
+		right_ext = BPS_TREE_PATH_ELEM_INITIALIZER,
+		left_left_ext = BPS_TREE_PATH_ELEM_INITIALIZER,
+		right_right_ext = BPS_TREE_PATH_ELEM_INITIALIZER;
 	bool has_left_ext =
 		bps_tree_collect_left_path_elem_inner(tree, inner_path_elem,
 						      &left_ext);
@@ -4024,6 +4591,12 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 		new_root->header.size = 2;
 		new_root->child_ids[0] = tree->root_id;
 		new_root->child_ids[1] = new_block_id;
+#ifdef BPS_INNER_CARD
+		new_root->child_cards[0] =
+			bps_tree_block_card(tree, tree->root_id);
+		new_root->child_cards[1] =
+			bps_tree_block_card(tree, new_block_id);
+#endif
 		new_root->elems[0] = tree->max_elem;
 		tree->root_id = new_root_id;
 		tree->max_elem = new_max_elem;
@@ -4053,6 +4626,10 @@ static inline void
 bps_tree_process_delete_leaf(struct bps_tree *tree,
 			     struct bps_leaf_path_elem *leaf_path_elem)
 {
+#ifdef BPS_INNER_CARD
+	bps_tree_touch_path(tree, leaf_path_elem);
+	bps_tree_add_path_card(leaf_path_elem, -1);
+#endif
 	bps_tree_delete_from_leaf(tree, leaf_path_elem);
 
 	if (leaf_path_elem->block->header.size >=
@@ -4063,10 +4640,10 @@ bps_tree_process_delete_leaf(struct bps_tree *tree,
 
 	bps_tree_touch_path(tree, leaf_path_elem);
 
-	struct bps_leaf_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0};
+	struct bps_leaf_path_elem left_ext = BPS_TREE_PATH_ELEM_INITIALIZER,
+		right_ext = BPS_TREE_PATH_ELEM_INITIALIZER,
+		left_left_ext = BPS_TREE_PATH_ELEM_INITIALIZER,
+		right_right_ext = BPS_TREE_PATH_ELEM_INITIALIZER;
 	bool has_left_ext =
 		bps_tree_collect_left_path_elem_leaf(tree, leaf_path_elem,
 						     &left_ext);
@@ -4249,10 +4826,10 @@ bps_tree_process_delete_inner(struct bps_tree *tree,
 		return;
 	}
 
-	struct bps_inner_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0};
+	struct bps_inner_path_elem left_ext = BPS_TREE_PATH_ELEM_INITIALIZER,
+		right_ext = BPS_TREE_PATH_ELEM_INITIALIZER,
+		left_left_ext = BPS_TREE_PATH_ELEM_INITIALIZER,
+		right_right_ext = BPS_TREE_PATH_ELEM_INITIALIZER;
 	bool has_left_ext =
 		bps_tree_collect_left_path_elem_inner(tree, inner_path_elem,
 						      &left_ext);
@@ -4619,13 +5196,22 @@ bps_tree_debug_check_block(const struct bps_tree *tree, struct bps_block *block,
 				result |= 0x4000000;
 		}
 
-		for (bps_tree_pos_t i = 0; i < block->size; i++)
+		for (bps_tree_pos_t i = 0; i < block->size; i++) {
+#ifdef BPS_INNER_CARD
+			size_t calc_card = *calc_count;
+#endif
 			result |= bps_tree_debug_check_block(tree,
 				bps_tree_restore_block(tree,
 						       inner->child_ids[i]),
 				inner->child_ids[i], level - 1, calc_count,
 				expected_prev_id, expected_this_id,
 				check_fullness_next);
+#ifdef BPS_INNER_CARD
+			calc_card = *calc_count - calc_card;
+			if (inner->child_cards[i] != calc_card)
+				result |= 0x8000000;
+#endif
+		}
 		return result;
 	}
 }
@@ -6001,6 +6587,8 @@ bps_tree_debug_check_internal_functions(bool assertme)
 
 #undef BPS_TREE_MEMMOVE
 #undef BPS_TREE_DATAMOVE
+#undef BPS_TREE_CHILDMOVE
+#undef BPS_TREE_PATH_ELEM_INITIALIZER
 #undef BPS_TREE_BRANCH_TRACE
 
 /* {{{ Macros for custom naming of structs and functions */
@@ -6023,6 +6611,7 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_build
 #undef bps_tree_destroy
 #undef bps_tree_find
+#undef bps_tree_find_batch
 #undef bps_tree_insert
 #undef bps_tree_delete
 #undef bps_tree_size
@@ -6037,6 +6626,9 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_upper_bound
 #undef bps_tree_lower_bound_elem
 #undef bps_tree_upper_bound_elem
+#undef bps_tree_lower_bound_get_offset
+#undef bps_tree_upper_bound_get_offset
+#undef bps_tree_iterator_at
 #undef bps_tree_approximate_count
 #undef bps_tree_iterator_get_elem
 #undef bps_tree_iterator_next
@@ -6061,6 +6653,8 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_root
 #undef bps_tree_touch_block
 #undef bps_tree_find_ins_point_key
+#undef bps_tree_prefetch_block
+#undef bps_tree_iterator_prefetch
 #undef bps_tree_find_ins_point_elem
 #undef bps_tree_find_after_ins_point_key
 #undef bps_tree_find_after_ins_point_elem
@@ -6076,6 +6670,11 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_collect_path
 #undef bps_tree_touch_leaf_path_max_elem
 #undef bps_tree_touch_path
+#undef bps_tree_inner_card
+#undef bps_tree_block_card
+#undef bps_tree_add_path_card
+#undef bps_tree_update_leaf_card
+#undef bps_tree_update_inner_card
 #undef bps_tree_process_replace
 #undef bps_tree_debug_memmove
 #undef bps_tree_insert_into_leaf
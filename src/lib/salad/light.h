@@ -249,6 +249,16 @@ static inline uint32_t
 LIGHT(replace)(struct LIGHT(core) *ht, uint32_t hash,
 	       LIGHT_DATA_TYPE data, LIGHT_DATA_TYPE *replaced);
 
+/**
+ * @brief Grow a hash table in advance to hold at least the given
+ *  number of records without growing on insertion
+ * @param ht - pointer to a hash table struct
+ * @param size - number of records
+ * @return 0 if ok, -1 on memory error
+ */
+static inline int
+LIGHT(reserve)(struct LIGHT(core) *ht, uint32_t size);
+
 /**
  * @brief Delete a record from a hash table by given record ID
  * @param ht - pointer to a hash table struct
@@ -651,12 +661,13 @@ LIGHT(prepare_first_insert)(struct LIGHT(core) *ht)
 }
 
 /*
- * Enlarge hash table to store more values
+ * Enlarge hash table to store more values. Usually called when
+ * there's no empty slots left, but works on any table.
  */
 static inline int
 LIGHT(grow)(struct LIGHT(core) *ht)
 {
-	assert(ht->empty_slot == LIGHT(end));
+	assert(ht->table_size > 0);
 	uint32_t new_slot;
 	struct LIGHT(record) *new_record = (struct LIGHT(record) *)
 		matras_alloc_range(&ht->mtable, &new_slot, LIGHT_GROW_INCREMENT);
@@ -750,6 +761,20 @@ LIGHT(grow)(struct LIGHT(core) *ht)
 	return 0;
 }
 
+static inline int
+LIGHT(reserve)(struct LIGHT(core) *ht, uint32_t size)
+{
+	if (size == 0)
+		return 0;
+	if (ht->table_size == 0)
+		if (LIGHT(prepare_first_insert)(ht))
+			return -1;
+	while (ht->table_size < size)
+		if (LIGHT(grow)(ht))
+			return -1;
+	return 0;
+}
+
 /**
  * @brief Insert a record with given hash and value
  * @param ht - pointer to a hash table struct
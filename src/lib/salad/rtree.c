@@ -32,9 +32,16 @@
 #include <string.h>
 #include <assert.h>
 #include <limits.h>
+#include <stdlib.h>
 #include <stddef.h>
 #include <sys/types.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+/* Rectangle kernels handle both coords of an axis at once */
+#define RTREE_SSE2 1
+#endif
+
 /*------------------------------------------------------------------------- */
 /* R-tree internal structures definition */
 /*------------------------------------------------------------------------- */
@@ -132,6 +139,68 @@ rtree_set2dp(struct rtree_rect *rect, coord_t x, coord_t y)
 	rect->coords[3] = y;
 }
 
+#ifdef RTREE_SSE2
+
+/*
+ * Coords of an axis are loaded as {low, high}. Negating the high
+ * one turns both range checks of the axis into a single vector
+ * comparison of the same direction.
+ */
+static inline __m128d
+rtree_sign_high(void)
+{
+	return _mm_set_pd(-0.0, 0.0);
+}
+
+/*
+ * Distances from the point to the ranges of axes of the rectangle:
+ * {low - point, point - high} has at most one positive component.
+ */
+static inline __m128d
+rtree_rect_axis_distance(const coord_t *coords, coord_t point)
+{
+	__m128d d = _mm_sub_pd(_mm_loadu_pd(coords), _mm_set1_pd(point));
+	d = _mm_xor_pd(d, rtree_sign_high());
+	return _mm_max_pd(d, _mm_setzero_pd());
+}
+
+static inline sq_coord_t
+rtree_sum_pd(__m128d v)
+{
+	return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+/* Manhattan distance */
+static sq_coord_t
+rtree_rect_neigh_distance(const struct rtree_rect *rect,
+			   const struct rtree_rect *neigh_rect,
+			   unsigned dimension)
+{
+	__m128d sum = _mm_setzero_pd();
+	for (int i = dimension; --i >= 0; ) {
+		sum = _mm_add_pd(sum, rtree_rect_axis_distance(
+			&rect->coords[2 * i], neigh_rect->coords[2 * i]));
+	}
+	return rtree_sum_pd(sum);
+}
+
+/* Euclid distance, squared */
+static sq_coord_t
+rtree_rect_neigh_distance2(const struct rtree_rect *rect,
+			   const struct rtree_rect *neigh_rect,
+			   unsigned dimension)
+{
+	__m128d sum = _mm_setzero_pd();
+	for (int i = dimension; --i >= 0; ) {
+		__m128d d = rtree_rect_axis_distance(&rect->coords[2 * i],
+						     neigh_rect->coords[2 * i]);
+		sum = _mm_add_pd(sum, _mm_mul_pd(d, d));
+	}
+	return rtree_sum_pd(sum);
+}
+
+#else /* !RTREE_SSE2 */
+
 /* Manhattan distance */
 static sq_coord_t
 rtree_rect_neigh_distance(const struct rtree_rect *rect,
@@ -174,6 +243,8 @@ rtree_rect_neigh_distance2(const struct rtree_rect *rect,
 	return result;
 }
 
+#endif /* RTREE_SSE2 */
+
 static area_t
 rtree_rect_area(const struct rtree_rect *rect, unsigned dimension)
 {
@@ -256,6 +327,62 @@ rtree_rect_intersection(const struct rtree_rect *item1,
 	}
 }
 
+#ifdef RTREE_SSE2
+
+static bool
+rtree_rect_intersects_rect(const struct rtree_rect *rt1,
+			   const struct rtree_rect *rt2,
+			   unsigned dimension)
+{
+	/* low1 > high2 || high1 < low2 for any axis */
+	const __m128d sign = rtree_sign_high();
+	__m128d miss = _mm_setzero_pd();
+	for (int i = dimension; --i >= 0; ) {
+		__m128d c1 = _mm_loadu_pd(&rt1->coords[2 * i]);
+		__m128d c2 = _mm_loadu_pd(&rt2->coords[2 * i]);
+		c2 = _mm_shuffle_pd(c2, c2, 1);
+		miss = _mm_or_pd(miss, _mm_cmpgt_pd(_mm_xor_pd(c1, sign),
+						    _mm_xor_pd(c2, sign)));
+	}
+	return _mm_movemask_pd(miss) == 0;
+}
+
+static bool
+rtree_rect_in_rect(const struct rtree_rect *rt1,
+		   const struct rtree_rect *rt2,
+		   unsigned dimension)
+{
+	/* low1 < low2 || high1 > high2 for any axis */
+	const __m128d sign = rtree_sign_high();
+	__m128d miss = _mm_setzero_pd();
+	for (int i = dimension; --i >= 0; ) {
+		__m128d c1 = _mm_loadu_pd(&rt1->coords[2 * i]);
+		__m128d c2 = _mm_loadu_pd(&rt2->coords[2 * i]);
+		miss = _mm_or_pd(miss, _mm_cmplt_pd(_mm_xor_pd(c1, sign),
+						    _mm_xor_pd(c2, sign)));
+	}
+	return _mm_movemask_pd(miss) == 0;
+}
+
+static bool
+rtree_rect_strict_in_rect(const struct rtree_rect *rt1,
+			  const struct rtree_rect *rt2,
+			  unsigned dimension)
+{
+	/* low1 <= low2 || high1 >= high2 for any axis */
+	const __m128d sign = rtree_sign_high();
+	__m128d miss = _mm_setzero_pd();
+	for (int i = dimension; --i >= 0; ) {
+		__m128d c1 = _mm_loadu_pd(&rt1->coords[2 * i]);
+		__m128d c2 = _mm_loadu_pd(&rt2->coords[2 * i]);
+		miss = _mm_or_pd(miss, _mm_cmple_pd(_mm_xor_pd(c1, sign),
+						    _mm_xor_pd(c2, sign)));
+	}
+	return _mm_movemask_pd(miss) == 0;
+}
+
+#else /* !RTREE_SSE2 */
+
 static bool
 rtree_rect_intersects_rect(const struct rtree_rect *rt1,
 			   const struct rtree_rect *rt2,
@@ -298,6 +425,8 @@ rtree_rect_strict_in_rect(const struct rtree_rect *rt1,
 	return true;
 }
 
+#endif /* RTREE_SSE2 */
+
 static bool
 rtree_rect_holds_rect(const struct rtree_rect *rt1,
 		      const struct rtree_rect *rt2,
@@ -870,16 +999,14 @@ rtree_iterator_process_neigh(struct rtree_iterator *itr,
 	struct rtree_page *pg = (struct rtree_page *)child;
 	int level = neighbor->level;
 	rtree_iterator_free_neighbor(itr, neighbor);
+	sq_coord_t (*distance_f)(const struct rtree_rect *,
+				 const struct rtree_rect *, unsigned) =
+		itr->tree->distance_type == RTREE_EUCLID ?
+		rtree_rect_neigh_distance2 : rtree_rect_neigh_distance;
 	for (int i = 0, n = pg->n; i < n; i++) {
 		struct rtree_page_branch *b;
 		b = rtree_branch_get(itr->tree, pg, i);
-		coord_t distance;
-		if (itr->tree->distance_type == RTREE_EUCLID)
-			distance = rtree_rect_neigh_distance2(&b->rect,
-							      &itr->rect, d);
-		else
-			distance = rtree_rect_neigh_distance(&b->rect,
-							     &itr->rect, d);
+		sq_coord_t distance = distance_f(&b->rect, &itr->rect, d);
 		struct rtree_neighbor *neigh =
 			rtree_iterator_new_neighbor(itr, b->data.page,
 						    distance, level - 1);
@@ -1006,6 +1133,160 @@ rtree_insert(struct rtree *tree, struct rtree_rect *rect, record_t obj)
 	tree->n_records++;
 }
 
+/*------------------------------------------------------------------------- */
+/* R-tree bulk loading */
+/*------------------------------------------------------------------------- */
+
+/*
+ * Sort-Tile-Recursive packing: the records are sorted by the
+ * center of the first axis and cut into slabs, each slab is
+ * sorted by the next axis and cut again, and so on. Consecutive
+ * runs of page_max_fill records of the result go to leaf pages.
+ * Upper levels are built the same way from the covers of the
+ * pages of the level below. Items of all levels have the layout
+ * of a page branch, so they are copied to pages as is.
+ */
+
+/* Axis items are sorted by. Sorting doesn't yield. */
+static unsigned rtree_str_axis;
+
+static int
+rtree_str_cmp(const void *a, const void *b)
+{
+	const coord_t *ca = ((const struct rtree_page_branch *)a)->rect.coords;
+	const coord_t *cb = ((const struct rtree_page_branch *)b)->rect.coords;
+	unsigned i = 2 * rtree_str_axis;
+	coord_t center_a = ca[i] + ca[i + 1];
+	coord_t center_b = cb[i] + cb[i + 1];
+	return center_a < center_b ? -1 : center_a > center_b;
+}
+
+/* Minimal number of slabs s such that s ^ k >= n_pages */
+static size_t
+rtree_str_slab_count(size_t n_pages, unsigned k)
+{
+	size_t s = 1;
+	for (;;) {
+		size_t p = 1;
+		for (unsigned i = 0; i < k && p < n_pages; i++)
+			p *= s;
+		if (p >= n_pages)
+			return s;
+		s++;
+	}
+}
+
+static void
+rtree_str_sort(const struct rtree *tree, char *items, size_t n,
+	       unsigned axis)
+{
+	size_t item_size = tree->page_branch_size;
+	unsigned fill = tree->page_max_fill;
+	rtree_str_axis = axis;
+	qsort(items, n, item_size, rtree_str_cmp);
+	if (axis + 1 == tree->dimension || n <= fill)
+		return;
+	size_t n_pages = (n + fill - 1) / fill;
+	size_t n_slabs = rtree_str_slab_count(n_pages,
+					      tree->dimension - axis);
+	size_t slab_size = (n_pages + n_slabs - 1) / n_slabs * fill;
+	for (size_t i = 0; i < n; i += slab_size) {
+		size_t len = n - i < slab_size ? n - i : slab_size;
+		rtree_str_sort(tree, items + i * item_size, len, axis + 1);
+	}
+}
+
+size_t
+rtree_bulk_item_size(const struct rtree *tree)
+{
+	return tree->page_branch_size;
+}
+
+void
+rtree_bulk_item_set(const struct rtree *tree, void *items, size_t i,
+		    const struct rtree_rect *rect, record_t obj)
+{
+	struct rtree_page_branch *b = (struct rtree_page_branch *)
+		((char *)items + i * tree->page_branch_size);
+	b->data.record = obj;
+	rtree_rect_copy(&b->rect, rect, tree->dimension);
+}
+
+void
+rtree_bulk_load(struct rtree *tree, void *items, size_t count)
+{
+	assert(tree->root == NULL);
+	unsigned fill = tree->page_max_fill;
+	size_t item_size = tree->page_branch_size;
+	if (count == 0)
+		return;
+	/*
+	 * Allocate all pages in advance and leave them in the
+	 * free list, so that a memory error is noticed before
+	 * the items are overwritten.
+	 */
+	size_t n_pages = 0;
+	unsigned height = 0;
+	for (size_t n = count; ; n = (n + fill - 1) / fill) {
+		n_pages += (n + fill - 1) / fill;
+		height++;
+		if (n <= fill)
+			break;
+	}
+	assert(height <= RTREE_MAX_HEIGHT);
+	for (size_t i = 0; i < n_pages; i++) {
+		uint32_t unused_id;
+		struct rtree_page *page = (struct rtree_page *)
+			matras_alloc(&tree->mtab, &unused_id);
+		if (page == NULL) {
+			/* Fall back to inserting records one by one */
+			for (size_t j = 0; j < count; j++) {
+				struct rtree_page_branch *b =
+					(struct rtree_page_branch *)
+					((char *)items + j * item_size);
+				rtree_insert(tree, &b->rect, b->data.record);
+			}
+			return;
+		}
+		rtree_page_free(tree, page);
+	}
+
+	char *level = (char *)items;
+	size_t n = count;
+	for (;;) {
+		rtree_str_sort(tree, level, n, 0);
+		size_t n_parents = 0;
+		for (size_t i = 0; i < n; i += fill) {
+			struct rtree_page *page = rtree_page_alloc(tree);
+			page->n = n - i < fill ? n - i : fill;
+			for (unsigned j = 0; j < page->n; j++) {
+				rtree_branch_copy(rtree_branch_get(tree, page, j),
+						  (struct rtree_page_branch *)
+						  (level + (i + j) * item_size),
+						  tree->dimension);
+			}
+			tree->n_pages++;
+			/*
+			 * Branches of the page are copied already, so
+			 * its parent branch can overwrite the items.
+			 */
+			struct rtree_page_branch *parent =
+				(struct rtree_page_branch *)
+				(level + n_parents++ * item_size);
+			parent->data.page = page;
+			rtree_page_cover(tree, page, &parent->rect);
+		}
+		if (n_parents == 1) {
+			tree->root = ((struct rtree_page_branch *)level)->data.page;
+			break;
+		}
+		n = n_parents;
+	}
+	tree->height = height;
+	tree->n_records = count;
+	tree->version++;
+}
+
 bool
 rtree_remove(struct rtree *tree, const struct rtree_rect *rect, record_t obj)
 {
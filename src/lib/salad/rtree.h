@@ -275,6 +275,39 @@ rtree_search(const struct rtree *tree, const struct rtree_rect *rect,
 void
 rtree_insert(struct rtree *tree, struct rtree_rect *rect, record_t obj);
 
+/**
+ * @brief Size of an item of an array passed to rtree_bulk_load()
+ * @param tree - pointer to a tree
+ */
+size_t
+rtree_bulk_item_size(const struct rtree *tree);
+
+/**
+ * @brief Set an item of an array passed to rtree_bulk_load()
+ * @param tree - pointer to a tree
+ * @param items - array of rtree_bulk_item_size() sized items
+ * @param i - index of the item to set
+ * @param rect - rectangle of the record
+ * @param obj - record
+ */
+void
+rtree_bulk_item_set(const struct rtree *tree, void *items, size_t i,
+		    const struct rtree_rect *rect, record_t obj);
+
+/**
+ * @brief Build an empty tree from an array of records at once
+ * Records are packed into full pages with Sort-Tile-Recursive
+ * algorithm, which is much faster than inserting them one by one
+ * and gives a tree with less overlapping pages. If the pages
+ * can't be allocated, the records are inserted one by one.
+ * The array is clobbered.
+ * @param tree - pointer to an empty tree
+ * @param items - array of items set by rtree_bulk_item_set()
+ * @param count - number of items
+ */
+void
+rtree_bulk_load(struct rtree *tree, void *items, size_t count);
+
 /**
  * @brief Remove the record from a tree
  * @return true if the record deleted (false otherwise)
@@ -0,0 +1,549 @@
+/*
+ * *No header guard*: the header is allowed to be included twice
+ * with different sets of defines.
+ */
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Open addressing hash table with one control byte per slot
+ * (a "Swiss table").
+ *
+ * Slots are split into groups of 16. A control byte is either
+ * EMPTY, DELETED or the low 7 bits of the hash of the value
+ * stored in the slot. A lookup compares the control bytes of a
+ * whole group with the wanted 7 bits at once (with SSE2, if
+ * available) and calls the comparison function only for the
+ * matching slots, which are rarely false positives. Groups are
+ * probed quadratically, a lookup stops at the first group that
+ * has an empty slot.
+ *
+ * Unlike light, the table is a plain array and has no support
+ * for consistent read views.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Additional user defined name that appended to prefix 'swiss'
+ *  for all names of structs and functions in this header file.
+ * All names use pattern: swiss<SWISS_NAME>_<name of func/struct>
+ * May be empty, but still have to be defined (just #define SWISS_NAME)
+ * Example:
+ * #define SWISS_NAME _test
+ * ...
+ * struct swiss_test_core hash_table;
+ * swiss_test_create(&hash_table, ...);
+ */
+#ifndef SWISS_NAME
+#error "SWISS_NAME must be defined"
+#endif
+
+/**
+ * Data type that hash table holds.
+ */
+#ifndef SWISS_DATA_TYPE
+#error "SWISS_DATA_TYPE must be defined"
+#endif
+
+/**
+ * Data type that used to for finding values.
+ */
+#ifndef SWISS_KEY_TYPE
+#error "SWISS_KEY_TYPE must be defined"
+#endif
+
+/**
+ * Type of optional third parameter of comparing function.
+ * If not needed, simply use #define SWISS_CMP_ARG_TYPE int
+ */
+#ifndef SWISS_CMP_ARG_TYPE
+#error "SWISS_CMP_ARG_TYPE must be defined"
+#endif
+
+/**
+ * Data comparing function. Takes 3 parameters - value1, value2 and
+ * optional value that stored in hash table struct.
+ */
+#ifndef SWISS_EQUAL
+#error "SWISS_EQUAL must be defined"
+#endif
+
+/**
+ * Data comparing function. Takes 3 parameters - value, key and
+ * optional value that stored in hash table struct.
+ */
+#ifndef SWISS_EQUAL_KEY
+#error "SWISS_EQUAL_KEY must be defined"
+#endif
+
+/**
+ * Hash function of a value. Takes 2 parameters - value and
+ * optional value that stored in hash table struct. Used to
+ * rehash values on grow, the table doesn't store hashes.
+ */
+#ifndef SWISS_HASH
+#error "SWISS_HASH must be defined"
+#endif
+
+/**
+ * Tools for name substitution:
+ */
+#ifndef CONCAT4
+#define CONCAT4_R(a, b, c, d) a##b##c##d
+#define CONCAT4(a, b, c, d) CONCAT4_R(a, b, c, d)
+#endif
+
+#define SWISS(name) CONCAT4(swiss, SWISS_NAME, _, name)
+
+#ifndef SWISS_GROUP_DEFINED
+#define SWISS_GROUP_DEFINED
+
+enum {
+	/** Number of slots in a group. */
+	SWISS_GROUP_SIZE = 16,
+	/** Control byte of a never used slot. */
+	SWISS_CTRL_EMPTY = 0x80,
+	/** Control byte of a slot whose value was deleted. */
+	SWISS_CTRL_DELETED = 0xfe,
+};
+
+/**
+ * Return a bit mask of the control bytes of a group equal
+ * to @a byte, bit i stands for slot i.
+ */
+static inline uint32_t
+swiss_group_match(const uint8_t *ctrl, uint8_t byte)
+{
+#if defined(__SSE2__)
+	__m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(group,
+						_mm_set1_epi8((char)byte)));
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < SWISS_GROUP_SIZE; i++)
+		mask |= (uint32_t)(ctrl[i] == byte) << i;
+	return mask;
+#endif
+}
+
+/**
+ * Return a bit mask of the empty and deleted slots of a group.
+ * Both have the high bit of the control byte set.
+ */
+static inline uint32_t
+swiss_group_match_free(const uint8_t *ctrl)
+{
+#if defined(__SSE2__)
+	__m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+	return _mm_movemask_epi8(group);
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < SWISS_GROUP_SIZE; i++)
+		mask |= (uint32_t)(ctrl[i] >> 7) << i;
+	return mask;
+#endif
+}
+
+#endif /* SWISS_GROUP_DEFINED */
+
+/**
+ * Main struct for holding hash table
+ */
+struct SWISS(core) {
+	/* count of values in hash table */
+	uint32_t count;
+	/* number of slots, power of two, multiple of group size */
+	uint32_t capacity;
+	/* number of values that can be inserted before rehash */
+	uint32_t growth_left;
+	/* control bytes, one per slot */
+	uint8_t *ctrl;
+	/* values */
+	SWISS_DATA_TYPE *slots;
+	/* additional parameter for data comparison */
+	SWISS_CMP_ARG_TYPE arg;
+};
+
+/**
+ * Special result of swiss_find that means that nothing was found
+ * Must be equal or greater than possible hash table size
+ */
+static const uint32_t SWISS(end) = 0xFFFFFFFF;
+
+/** Control byte of a value with the given hash. */
+static inline uint8_t
+SWISS(h2)(uint32_t hash)
+{
+	return hash & 0x7f;
+}
+
+/** Index of the first group to probe for the given hash. */
+static inline uint32_t
+SWISS(h1)(const struct SWISS(core) *ht, uint32_t hash)
+{
+	return (hash >> 7) & (ht->capacity / SWISS_GROUP_SIZE - 1);
+}
+
+/** Max number of values a table of @a capacity slots holds. */
+static inline uint32_t
+SWISS(max_count)(uint32_t capacity)
+{
+	return capacity - capacity / 8;
+}
+
+/**
+ * @brief Hash table construction. No memory is allocated
+ * until the first insertion.
+ * @param ht - pointer to a hash table struct
+ * @param arg - optional parameter to save for comparing function
+ */
+static inline void
+SWISS(create)(struct SWISS(core) *ht, SWISS_CMP_ARG_TYPE arg)
+{
+	ht->count = 0;
+	ht->capacity = 0;
+	ht->growth_left = 0;
+	ht->ctrl = NULL;
+	ht->slots = NULL;
+	ht->arg = arg;
+}
+
+/**
+ * @brief Hash table destruction. Frees all allocated memory
+ * @param ht - pointer to a hash table struct
+ */
+static inline void
+SWISS(destroy)(struct SWISS(core) *ht)
+{
+	free(ht->ctrl);
+	ht->ctrl = NULL;
+	ht->slots = NULL;
+	ht->count = ht->capacity = ht->growth_left = 0;
+}
+
+/**
+ * @brief Find a record with given hash and key
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param key - key to find
+ * @return integer ID of found record or swiss_end if nothing found
+ */
+static inline uint32_t
+SWISS(find_key)(const struct SWISS(core) *ht, uint32_t hash,
+		SWISS_KEY_TYPE key)
+{
+	if (ht->count == 0)
+		return SWISS(end);
+	uint32_t group_mask = ht->capacity / SWISS_GROUP_SIZE - 1;
+	uint32_t group = SWISS(h1)(ht, hash);
+	uint8_t h2 = SWISS(h2)(hash);
+	for (uint32_t step = 1; ; step++) {
+		const uint8_t *ctrl = ht->ctrl + group * SWISS_GROUP_SIZE;
+		uint32_t mask = swiss_group_match(ctrl, h2);
+		while (mask != 0) {
+			uint32_t slot = group * SWISS_GROUP_SIZE +
+					__builtin_ctz(mask);
+			if (SWISS_EQUAL_KEY(ht->slots[slot], key, ht->arg))
+				return slot;
+			mask &= mask - 1;
+		}
+		if (swiss_group_match(ctrl, SWISS_CTRL_EMPTY) != 0)
+			return SWISS(end);
+		if (step > group_mask)
+			return SWISS(end);
+		group = (group + step) & group_mask;
+	}
+}
+
+/**
+ * @brief Find a record with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param data - value to find
+ * @return integer ID of found record or swiss_end if nothing found
+ */
+static inline uint32_t
+SWISS(find)(const struct SWISS(core) *ht, uint32_t hash,
+	    SWISS_DATA_TYPE data)
+{
+	if (ht->count == 0)
+		return SWISS(end);
+	uint32_t group_mask = ht->capacity / SWISS_GROUP_SIZE - 1;
+	uint32_t group = SWISS(h1)(ht, hash);
+	uint8_t h2 = SWISS(h2)(hash);
+	for (uint32_t step = 1; ; step++) {
+		const uint8_t *ctrl = ht->ctrl + group * SWISS_GROUP_SIZE;
+		uint32_t mask = swiss_group_match(ctrl, h2);
+		while (mask != 0) {
+			uint32_t slot = group * SWISS_GROUP_SIZE +
+					__builtin_ctz(mask);
+			if (SWISS_EQUAL(ht->slots[slot], data, ht->arg))
+				return slot;
+			mask &= mask - 1;
+		}
+		if (swiss_group_match(ctrl, SWISS_CTRL_EMPTY) != 0)
+			return SWISS(end);
+		if (step > group_mask)
+			return SWISS(end);
+		group = (group + step) & group_mask;
+	}
+}
+
+/**
+ * Find a free slot for a value with the given hash. The table
+ * must have one.
+ */
+static inline uint32_t
+SWISS(find_free)(const struct SWISS(core) *ht, uint32_t hash)
+{
+	uint32_t group_mask = ht->capacity / SWISS_GROUP_SIZE - 1;
+	uint32_t group = SWISS(h1)(ht, hash);
+	for (uint32_t step = 1; ; step++) {
+		const uint8_t *ctrl = ht->ctrl + group * SWISS_GROUP_SIZE;
+		uint32_t mask = swiss_group_match_free(ctrl);
+		if (mask != 0)
+			return group * SWISS_GROUP_SIZE + __builtin_ctz(mask);
+		assert(step <= group_mask);
+		group = (group + step) & group_mask;
+	}
+}
+
+/** Store a value in a free slot, see swiss_find_free(). */
+static inline void
+SWISS(set)(struct SWISS(core) *ht, uint32_t slot, uint32_t hash,
+	   SWISS_DATA_TYPE data)
+{
+	if (ht->ctrl[slot] == SWISS_CTRL_EMPTY)
+		ht->growth_left--;
+	ht->ctrl[slot] = SWISS(h2)(hash);
+	ht->slots[slot] = data;
+	ht->count++;
+}
+
+/**
+ * Move all values to a table of @a capacity slots.
+ * Drops deleted slots as a side effect.
+ * @return 0 on success, -1 on memory error.
+ */
+static inline int
+SWISS(rehash)(struct SWISS(core) *ht, uint32_t capacity)
+{
+	assert(capacity % SWISS_GROUP_SIZE == 0);
+	assert((capacity & (capacity - 1)) == 0);
+	assert(SWISS(max_count)(capacity) >= ht->count);
+	size_t size = capacity + capacity * sizeof(SWISS_DATA_TYPE);
+	uint8_t *ctrl = (uint8_t *)malloc(size);
+	if (ctrl == NULL)
+		return -1;
+	memset(ctrl, SWISS_CTRL_EMPTY, capacity);
+	struct SWISS(core) old = *ht;
+	ht->ctrl = ctrl;
+	ht->slots = (SWISS_DATA_TYPE *)(ctrl + capacity);
+	ht->capacity = capacity;
+	ht->growth_left = SWISS(max_count)(capacity);
+	ht->count = 0;
+	for (uint32_t i = 0; i < old.capacity; i++) {
+		if (old.ctrl[i] & 0x80)
+			continue;
+		uint32_t h = SWISS_HASH(old.slots[i], ht->arg);
+		SWISS(set)(ht, SWISS(find_free)(ht, h), h, old.slots[i]);
+	}
+	free(old.ctrl);
+	return 0;
+}
+
+/**
+ * @brief Reserve memory for @a count values.
+ * @param ht - pointer to a hash table struct
+ * @param count - number of values
+ * @return 0 on success, -1 on memory error.
+ */
+static inline int
+SWISS(reserve)(struct SWISS(core) *ht, uint32_t count)
+{
+	if (count <= ht->count + ht->growth_left)
+		return 0;
+	uint32_t capacity = ht->capacity != 0 ?
+			    ht->capacity : SWISS_GROUP_SIZE;
+	while (SWISS(max_count)(capacity) < count)
+		capacity *= 2;
+	return SWISS(rehash)(ht, capacity);
+}
+
+/**
+ * @brief Insert a record with the given hash and value.
+ * Duplicates are not checked.
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash of the value
+ * @param data - value to insert
+ * @return integer ID of inserted record or swiss_end on memory error
+ */
+static inline uint32_t
+SWISS(insert)(struct SWISS(core) *ht, uint32_t hash, SWISS_DATA_TYPE data)
+{
+	if (ht->growth_left == 0) {
+		/*
+		 * Grow if the table is more than half full,
+		 * otherwise just get rid of deleted slots.
+		 */
+		uint32_t capacity = ht->capacity;
+		if (capacity == 0)
+			capacity = SWISS_GROUP_SIZE;
+		else if (ht->count >= SWISS(max_count)(capacity) / 2)
+			capacity *= 2;
+		if (SWISS(rehash)(ht, capacity) != 0)
+			return SWISS(end);
+	}
+	uint32_t slot = SWISS(find_free)(ht, hash);
+	SWISS(set)(ht, slot, hash, data);
+	return slot;
+}
+
+/**
+ * @brief Replace a record with the given hash and an equal
+ * value or insert it if there is no such record.
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash of the value
+ * @param data - value to insert
+ * @param[out] replaced - replaced value, if @a is_replaced
+ * @param[out] is_replaced - set if a value was replaced
+ * @return integer ID of the record or swiss_end on memory error
+ */
+static inline uint32_t
+SWISS(replace)(struct SWISS(core) *ht, uint32_t hash, SWISS_DATA_TYPE data,
+	       SWISS_DATA_TYPE *replaced, bool *is_replaced)
+{
+	uint32_t slot = SWISS(find)(ht, hash, data);
+	if (slot != SWISS(end)) {
+		*replaced = ht->slots[slot];
+		*is_replaced = true;
+		ht->slots[slot] = data;
+		return slot;
+	}
+	*is_replaced = false;
+	return SWISS(insert)(ht, hash, data);
+}
+
+/**
+ * @brief Delete a record from a hash table by given record ID
+ * @param ht - pointer to a hash table struct
+ * @param slot - ID of a record to delete
+ */
+static inline void
+SWISS(delete)(struct SWISS(core) *ht, uint32_t slot)
+{
+	assert(slot < ht->capacity && !(ht->ctrl[slot] & 0x80));
+	const uint8_t *ctrl = ht->ctrl + slot / SWISS_GROUP_SIZE *
+			      SWISS_GROUP_SIZE;
+	/*
+	 * Lookups stop at a group with an empty slot, so the
+	 * slot may become empty only if no value was moved past
+	 * the group, i.e. if it has already had an empty slot.
+	 */
+	if (swiss_group_match(ctrl, SWISS_CTRL_EMPTY) != 0) {
+		ht->ctrl[slot] = SWISS_CTRL_EMPTY;
+		ht->growth_left++;
+	} else {
+		ht->ctrl[slot] = SWISS_CTRL_DELETED;
+	}
+	ht->count--;
+}
+
+/**
+ * @brief Get a value from a desired position
+ * @param ht - pointer to a hash table struct
+ * @param slot - ID of a record
+ * @return the value
+ */
+static inline SWISS_DATA_TYPE
+SWISS(get)(const struct SWISS(core) *ht, uint32_t slot)
+{
+	assert(slot < ht->capacity && !(ht->ctrl[slot] & 0x80));
+	return ht->slots[slot];
+}
+
+/**
+ * @brief Get the ID of the next record after @a slot.
+ * Use swiss_next(ht, swiss_end) to start iteration.
+ * @param ht - pointer to a hash table struct
+ * @param slot - ID of the current record or swiss_end
+ * @return ID of the next record or swiss_end if there is none
+ */
+static inline uint32_t
+SWISS(next)(const struct SWISS(core) *ht, uint32_t slot)
+{
+	for (slot++; slot < ht->capacity; slot++) {
+		if (!(ht->ctrl[slot] & 0x80))
+			return slot;
+	}
+	return SWISS(end);
+}
+
+/**
+ * @brief Check the invariants of a hash table.
+ * @param ht - pointer to a hash table struct
+ * @return 0 if OK; bit mask of found errors otherwise
+ */
+static inline int
+SWISS(selfcheck)(const struct SWISS(core) *ht)
+{
+	int res = 0;
+	uint32_t count = 0, empty = 0;
+	for (uint32_t i = 0; i < ht->capacity; i++) {
+		if (ht->ctrl[i] == SWISS_CTRL_EMPTY) {
+			empty++;
+			continue;
+		}
+		if (ht->ctrl[i] == SWISS_CTRL_DELETED)
+			continue;
+		count++;
+		uint32_t h = SWISS_HASH(ht->slots[i], ht->arg);
+		if (ht->ctrl[i] != SWISS(h2)(h))
+			res |= 1; /* wrong control byte */
+		if (SWISS(find)(ht, h, ht->slots[i]) != i)
+			res |= 2; /* value is unreachable */
+	}
+	if (count != ht->count)
+		res |= 4; /* wrong count */
+	if (ht->capacity != 0 &&
+	    ht->growth_left + ht->capacity - empty !=
+	    SWISS(max_count)(ht->capacity))
+		res |= 8; /* wrong growth_left */
+	return res;
+}
@@ -0,0 +1,496 @@
+/*
+ * Copyright 2010-2026, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "lib/salad/xxh3.h"
+
+#include <string.h>
+#include "bit/bit.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(__SSE2__)
+#define XXH3_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__)
+#define XXH3_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+/*
+ * A compact implementation of the 64-bit XXH3 hash function
+ * designed by Yann Collet, see https://github.com/Cyan4973/xxHash.
+ */
+
+enum {
+	/** Bytes consumed by one accumulation round. */
+	XXH3_STRIPE_LEN = 64,
+	/** Secret bytes consumed per stripe. */
+	XXH3_SECRET_CONSUME_RATE = 8,
+	XXH3_SECRET_SIZE = 192,
+	XXH3_SECRET_SIZE_MIN = 136,
+	XXH3_MIDSIZE_MAX = 240,
+	XXH3_MIDSIZE_STARTOFFSET = 3,
+	XXH3_MIDSIZE_LASTOFFSET = 17,
+	XXH3_SECRET_LASTACC_START = 7,
+	XXH3_SECRET_MERGEACCS_START = 11,
+};
+
+static const uint32_t XXH3_PRIME32_1 = 0x9E3779B1U;
+static const uint32_t XXH3_PRIME32_2 = 0x85EBCA77U;
+static const uint32_t XXH3_PRIME32_3 = 0xC2B2AE3DU;
+static const uint64_t XXH3_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t XXH3_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t XXH3_PRIME64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t XXH3_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t XXH3_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+static const uint64_t XXH3_PRIME_MX1 = 0x165667919E3779F9ULL;
+static const uint64_t XXH3_PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+static const uint8_t xxh3_secret[XXH3_SECRET_SIZE] = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe,
+	0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+	0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78,
+	0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e,
+	0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+	0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e,
+	0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f,
+	0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+	0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3,
+	0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49,
+	0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+	0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28,
+	0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static inline uint32_t
+xxh3_read32(const uint8_t *p)
+{
+	uint32_t v = load_u32(p);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = bswap_u32(v);
+#endif
+	return v;
+}
+
+static inline uint64_t
+xxh3_read64(const uint8_t *p)
+{
+	uint64_t v = load_u64(p);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = bswap_u64(v);
+#endif
+	return v;
+}
+
+static inline void
+xxh3_write64(uint8_t *p, uint64_t v)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = bswap_u64(v);
+#endif
+	memcpy(p, &v, sizeof(v));
+}
+
+static inline uint64_t
+xxh3_mul128_fold64(uint64_t lhs, uint64_t rhs)
+{
+#if defined(__SIZEOF_INT128__)
+	__uint128_t product = (__uint128_t)lhs * rhs;
+	return (uint64_t)product ^ (uint64_t)(product >> 64);
+#else
+	uint64_t lo_lo = (lhs & 0xFFFFFFFF) * (rhs & 0xFFFFFFFF);
+	uint64_t hi_lo = (lhs >> 32) * (rhs & 0xFFFFFFFF);
+	uint64_t lo_hi = (lhs & 0xFFFFFFFF) * (rhs >> 32);
+	uint64_t hi_hi = (lhs >> 32) * (rhs >> 32);
+	uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+	uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	uint64_t lower = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+	return lower ^ upper;
+#endif
+}
+
+static inline uint64_t
+xxh64_avalanche(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= XXH3_PRIME64_2;
+	h ^= h >> 29;
+	h *= XXH3_PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+static inline uint64_t
+xxh3_avalanche(uint64_t h)
+{
+	h ^= h >> 37;
+	h *= XXH3_PRIME_MX1;
+	h ^= h >> 32;
+	return h;
+}
+
+static inline uint64_t
+xxh3_rrmxmx(uint64_t h, uint64_t len)
+{
+	h ^= bit_rotl_u64(h, 49) ^ bit_rotl_u64(h, 24);
+	h *= XXH3_PRIME_MX2;
+	h ^= (h >> 35) + len;
+	h *= XXH3_PRIME_MX2;
+	return h ^ (h >> 28);
+}
+
+static inline uint64_t
+xxh3_len_0to16(const uint8_t *p, size_t len, const uint8_t *secret,
+	       uint64_t seed)
+{
+	if (len > 8) {
+		uint64_t bitflip1 = (xxh3_read64(secret + 24) ^
+				     xxh3_read64(secret + 32)) + seed;
+		uint64_t bitflip2 = (xxh3_read64(secret + 40) ^
+				     xxh3_read64(secret + 48)) - seed;
+		uint64_t lo = xxh3_read64(p) ^ bitflip1;
+		uint64_t hi = xxh3_read64(p + len - 8) ^ bitflip2;
+		uint64_t acc = len + bswap_u64(lo) + hi +
+			       xxh3_mul128_fold64(lo, hi);
+		return xxh3_avalanche(acc);
+	}
+	if (len >= 4) {
+		seed ^= (uint64_t)bswap_u32((uint32_t)seed) << 32;
+		uint32_t in1 = xxh3_read32(p);
+		uint32_t in2 = xxh3_read32(p + len - 4);
+		uint64_t bitflip = (xxh3_read64(secret + 8) ^
+				    xxh3_read64(secret + 16)) - seed;
+		uint64_t in64 = in2 + ((uint64_t)in1 << 32);
+		return xxh3_rrmxmx(in64 ^ bitflip, len);
+	}
+	if (len > 0) {
+		uint32_t combined = ((uint32_t)p[0] << 16) |
+				    ((uint32_t)p[len >> 1] << 24) |
+				    ((uint32_t)p[len - 1] << 0) |
+				    ((uint32_t)len << 8);
+		uint64_t bitflip = (xxh3_read32(secret) ^
+				    xxh3_read32(secret + 4)) + seed;
+		return xxh64_avalanche((uint64_t)combined ^ bitflip);
+	}
+	return xxh64_avalanche(seed ^ (xxh3_read64(secret + 56) ^
+				       xxh3_read64(secret + 64)));
+}
+
+static inline uint64_t
+xxh3_mix16(const uint8_t *p, const uint8_t *secret, uint64_t seed)
+{
+	uint64_t lo = xxh3_read64(p);
+	uint64_t hi = xxh3_read64(p + 8);
+	return xxh3_mul128_fold64(lo ^ (xxh3_read64(secret) + seed),
+				  hi ^ (xxh3_read64(secret + 8) - seed));
+}
+
+static inline uint64_t
+xxh3_len_17to128(const uint8_t *p, size_t len, const uint8_t *secret,
+		 uint64_t seed)
+{
+	uint64_t acc = len * XXH3_PRIME64_1;
+	if (len > 32) {
+		if (len > 64) {
+			if (len > 96) {
+				acc += xxh3_mix16(p + 48, secret + 96, seed);
+				acc += xxh3_mix16(p + len - 64, secret + 112,
+						  seed);
+			}
+			acc += xxh3_mix16(p + 32, secret + 64, seed);
+			acc += xxh3_mix16(p + len - 48, secret + 80, seed);
+		}
+		acc += xxh3_mix16(p + 16, secret + 32, seed);
+		acc += xxh3_mix16(p + len - 32, secret + 48, seed);
+	}
+	acc += xxh3_mix16(p, secret, seed);
+	acc += xxh3_mix16(p + len - 16, secret + 16, seed);
+	return xxh3_avalanche(acc);
+}
+
+static uint64_t
+xxh3_len_129to240(const uint8_t *p, size_t len, const uint8_t *secret,
+		  uint64_t seed)
+{
+	uint64_t acc = len * XXH3_PRIME64_1;
+	unsigned rounds = len / 16;
+	for (unsigned i = 0; i < 8; i++)
+		acc += xxh3_mix16(p + 16 * i, secret + 16 * i, seed);
+	acc = xxh3_avalanche(acc);
+	for (unsigned i = 8; i < rounds; i++) {
+		acc += xxh3_mix16(p + 16 * i, secret + 16 * (i - 8) +
+				  XXH3_MIDSIZE_STARTOFFSET, seed);
+	}
+	acc += xxh3_mix16(p + len - 16, secret + XXH3_SECRET_SIZE_MIN -
+			  XXH3_MIDSIZE_LASTOFFSET, seed);
+	return xxh3_avalanche(acc);
+}
+
+/* {{{ Long inputs */
+
+/**
+ * Long inputs are processed in 64-byte stripes by 8 64-bit
+ * accumulators, which map naturally to vector registers.
+ * Every implementation below provides an accumulation and a
+ * scrambling round.
+ */
+typedef void
+(*xxh3_accumulate_f)(uint64_t *acc, const uint8_t *p, const uint8_t *secret);
+
+typedef void
+(*xxh3_scramble_f)(uint64_t *acc, const uint8_t *secret);
+
+static inline void
+xxh3_accumulate_scalar(uint64_t *acc, const uint8_t *p,
+		       const uint8_t *secret)
+{
+	for (int i = 0; i < 8; i++) {
+		uint64_t data = xxh3_read64(p + 8 * i);
+		uint64_t key = data ^ xxh3_read64(secret + 8 * i);
+		acc[i ^ 1] += data;
+		acc[i] += (key & 0xFFFFFFFF) * (key >> 32);
+	}
+}
+
+static inline void
+xxh3_scramble_scalar(uint64_t *acc, const uint8_t *secret)
+{
+	for (int i = 0; i < 8; i++) {
+		uint64_t a = acc[i];
+		a ^= a >> 47;
+		a ^= xxh3_read64(secret + 8 * i);
+		a *= XXH3_PRIME32_1;
+		acc[i] = a;
+	}
+}
+
+#if defined(XXH3_HAVE_SSE2)
+
+static inline void
+xxh3_accumulate_sse2(uint64_t *acc, const uint8_t *p, const uint8_t *secret)
+{
+	__m128i *xacc = (__m128i *)acc;
+	for (int i = 0; i < 4; i++) {
+		__m128i data = _mm_loadu_si128((const __m128i *)p + i);
+		__m128i key = _mm_xor_si128(data,
+			_mm_loadu_si128((const __m128i *)secret + i));
+		__m128i key_hi = _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1));
+		__m128i product = _mm_mul_epu32(key, key_hi);
+		__m128i swap = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+		xacc[i] = _mm_add_epi64(product, _mm_add_epi64(xacc[i], swap));
+	}
+}
+
+static inline void
+xxh3_scramble_sse2(uint64_t *acc, const uint8_t *secret)
+{
+	__m128i *xacc = (__m128i *)acc;
+	const __m128i prime = _mm_set1_epi32(XXH3_PRIME32_1);
+	for (int i = 0; i < 4; i++) {
+		__m128i a = xacc[i];
+		a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+		a = _mm_xor_si128(a,
+			_mm_loadu_si128((const __m128i *)secret + i));
+		__m128i a_hi = _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1));
+		__m128i lo = _mm_mul_epu32(a, prime);
+		__m128i hi = _mm_mul_epu32(a_hi, prime);
+		xacc[i] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+	}
+}
+
+#endif /* defined(XXH3_HAVE_SSE2) */
+
+#if defined(XXH3_HAVE_AVX2)
+
+__attribute__((target("avx2")))
+static inline void
+xxh3_accumulate_avx2(uint64_t *acc, const uint8_t *p, const uint8_t *secret)
+{
+	__m256i *xacc = (__m256i *)acc;
+	for (int i = 0; i < 2; i++) {
+		__m256i data = _mm256_loadu_si256((const __m256i *)p + i);
+		__m256i key = _mm256_xor_si256(data,
+			_mm256_loadu_si256((const __m256i *)secret + i));
+		__m256i key_hi = _mm256_shuffle_epi32(key,
+						      _MM_SHUFFLE(0, 3, 0, 1));
+		__m256i product = _mm256_mul_epu32(key, key_hi);
+		__m256i swap = _mm256_shuffle_epi32(data,
+						    _MM_SHUFFLE(1, 0, 3, 2));
+		xacc[i] = _mm256_add_epi64(product,
+					   _mm256_add_epi64(xacc[i], swap));
+	}
+}
+
+__attribute__((target("avx2")))
+static inline void
+xxh3_scramble_avx2(uint64_t *acc, const uint8_t *secret)
+{
+	__m256i *xacc = (__m256i *)acc;
+	const __m256i prime = _mm256_set1_epi32(XXH3_PRIME32_1);
+	for (int i = 0; i < 2; i++) {
+		__m256i a = xacc[i];
+		a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+		a = _mm256_xor_si256(a,
+			_mm256_loadu_si256((const __m256i *)secret + i));
+		__m256i a_hi = _mm256_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1));
+		__m256i lo = _mm256_mul_epu32(a, prime);
+		__m256i hi = _mm256_mul_epu32(a_hi, prime);
+		xacc[i] = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+	}
+}
+
+#endif /* defined(XXH3_HAVE_AVX2) */
+
+static inline __attribute__((always_inline)) uint64_t
+xxh3_hash_long(const uint8_t *p, size_t len, const uint8_t *secret,
+	       xxh3_accumulate_f accumulate, xxh3_scramble_f scramble)
+{
+	uint64_t acc[8] __attribute__((aligned(32))) = {
+		XXH3_PRIME32_3, XXH3_PRIME64_1, XXH3_PRIME64_2,
+		XXH3_PRIME64_3, XXH3_PRIME64_4, XXH3_PRIME32_2,
+		XXH3_PRIME64_5, XXH3_PRIME32_1,
+	};
+	const size_t stripes_per_block = (XXH3_SECRET_SIZE - XXH3_STRIPE_LEN) /
+					 XXH3_SECRET_CONSUME_RATE;
+	const size_t block_len = XXH3_STRIPE_LEN * stripes_per_block;
+	const size_t block_count = (len - 1) / block_len;
+	for (size_t n = 0; n < block_count; n++) {
+		const uint8_t *block = p + n * block_len;
+		for (size_t s = 0; s < stripes_per_block; s++) {
+			accumulate(acc, block + s * XXH3_STRIPE_LEN,
+				   secret + s * XXH3_SECRET_CONSUME_RATE);
+		}
+		scramble(acc, secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN);
+	}
+	/* The last partial block. */
+	const uint8_t *block = p + block_count * block_len;
+	size_t stripes = ((len - 1) - block_len * block_count) /
+			 XXH3_STRIPE_LEN;
+	for (size_t s = 0; s < stripes; s++) {
+		accumulate(acc, block + s * XXH3_STRIPE_LEN,
+			   secret + s * XXH3_SECRET_CONSUME_RATE);
+	}
+	/* The last stripe, it may overlap with the previous one. */
+	accumulate(acc, p + len - XXH3_STRIPE_LEN,
+		   secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN -
+		   XXH3_SECRET_LASTACC_START);
+	/* Merge the accumulators. */
+	const uint8_t *merge_secret = secret + XXH3_SECRET_MERGEACCS_START;
+	uint64_t result = len * XXH3_PRIME64_1;
+	for (int i = 0; i < 4; i++) {
+		result += xxh3_mul128_fold64(
+			acc[2 * i] ^ xxh3_read64(merge_secret + 16 * i),
+			acc[2 * i + 1] ^ xxh3_read64(merge_secret + 16 * i + 8));
+	}
+	return xxh3_avalanche(result);
+}
+
+static uint64_t
+xxh3_hash_long_scalar(const uint8_t *p, size_t len, const uint8_t *secret)
+{
+	return xxh3_hash_long(p, len, secret, xxh3_accumulate_scalar,
+			      xxh3_scramble_scalar);
+}
+
+#if defined(XXH3_HAVE_SSE2)
+static uint64_t
+xxh3_hash_long_sse2(const uint8_t *p, size_t len, const uint8_t *secret)
+{
+	return xxh3_hash_long(p, len, secret, xxh3_accumulate_sse2,
+			      xxh3_scramble_sse2);
+}
+#endif
+
+#if defined(XXH3_HAVE_AVX2)
+__attribute__((target("avx2")))
+static uint64_t
+xxh3_hash_long_avx2(const uint8_t *p, size_t len, const uint8_t *secret)
+{
+	return xxh3_hash_long(p, len, secret, xxh3_accumulate_avx2,
+			      xxh3_scramble_avx2);
+}
+#endif
+
+typedef uint64_t
+(*xxh3_hash_long_f)(const uint8_t *p, size_t len, const uint8_t *secret);
+
+static xxh3_hash_long_f
+xxh3_hash_long_impl(void)
+{
+#if defined(XXH3_HAVE_AVX2)
+	if (__builtin_cpu_supports("avx2"))
+		return xxh3_hash_long_avx2;
+#endif
+#if defined(XXH3_HAVE_SSE2)
+	return xxh3_hash_long_sse2;
+#endif
+	return xxh3_hash_long_scalar;
+}
+
+/* }}} Long inputs */
+
+uint64_t
+xxh3_64(const void *data, size_t len, uint64_t seed)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	if (len <= 16)
+		return xxh3_len_0to16(p, len, xxh3_secret, seed);
+	if (len <= 128)
+		return xxh3_len_17to128(p, len, xxh3_secret, seed);
+	if (len <= XXH3_MIDSIZE_MAX)
+		return xxh3_len_129to240(p, len, xxh3_secret, seed);
+	static xxh3_hash_long_f hash_long = NULL;
+	if (hash_long == NULL)
+		hash_long = xxh3_hash_long_impl();
+	if (seed == 0)
+		return hash_long(p, len, xxh3_secret);
+	/* Long inputs use a secret derived from the seed. */
+	uint8_t secret[XXH3_SECRET_SIZE];
+	for (int i = 0; i < XXH3_SECRET_SIZE / 16; i++) {
+		xxh3_write64(secret + 16 * i,
+			     xxh3_read64(xxh3_secret + 16 * i) + seed);
+		xxh3_write64(secret + 16 * i + 8,
+			     xxh3_read64(xxh3_secret + 16 * i + 8) - seed);
+	}
+	return hash_long(p, len, secret);
+}
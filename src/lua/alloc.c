@@ -0,0 +1,143 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "lua/alloc.h"
+
+#include <string.h>
+#include <lua.h>
+#include <small/small.h>
+
+#include "fiber.h"
+#include "say.h"
+#include "trivia/util.h"
+
+enum {
+	/** Smallest Lua object: a short string or an upvalue. */
+	LUA_ALLOC_OBJSIZE_MIN = 16,
+};
+
+/** Size-class growth factor of the Lua heap pools. */
+static const float LUA_ALLOC_FACTOR = 1.05;
+
+static struct {
+	/** Size-class pools of the Lua heap. */
+	struct small_alloc alloc;
+	/** Bytes currently allocated by Lua. */
+	size_t used;
+	/** Set once the Lua state is created on top of @alloc. */
+	bool is_enabled;
+} lua_small;
+
+/**
+ * lua_Alloc implementation. Lua always passes the size of the
+ * block being freed or resized in @osize, so the block can be
+ * returned to the right pool without a header.
+ */
+static void *
+lua_small_alloc_f(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+	struct small_alloc *alloc = (struct small_alloc *) ud;
+	if (ptr == NULL)
+		osize = 0;
+	if (nsize == 0) {
+		if (ptr != NULL) {
+			smfree(alloc, ptr, osize);
+			lua_small.used -= osize;
+		}
+		return NULL;
+	}
+	if (nsize == osize)
+		return ptr;
+	void *new_ptr = smalloc(alloc, nsize);
+	if (new_ptr == NULL) {
+		/* Lua assumes that shrinking never fails. */
+		return nsize < osize ? ptr : NULL;
+	}
+	if (ptr != NULL) {
+		memcpy(new_ptr, ptr, MIN(osize, nsize));
+		smfree(alloc, ptr, osize);
+	}
+	lua_small.used += nsize - osize;
+	if (nsize > osize)
+		fiber()->storage.lua.alloc += nsize - osize;
+	return new_ptr;
+}
+
+static int
+lua_small_alloc_panic(struct lua_State *L)
+{
+	const char *msg = lua_tostring(L, -1);
+	panic("PANIC: unprotected error in call to Lua API (%s)",
+	      msg != NULL ? msg : "?");
+	return 0;
+}
+
+struct lua_State *
+lua_small_alloc_newstate(void)
+{
+	small_alloc_create(&lua_small.alloc, &cord()->slabc,
+			   LUA_ALLOC_OBJSIZE_MIN, LUA_ALLOC_FACTOR);
+	struct lua_State *L = lua_newstate(lua_small_alloc_f,
+					   &lua_small.alloc);
+	if (L == NULL) {
+		small_alloc_destroy(&lua_small.alloc);
+		lua_small.used = 0;
+		return NULL;
+	}
+	lua_atpanic(L, lua_small_alloc_panic);
+	lua_small.is_enabled = true;
+	return L;
+}
+
+bool
+lua_small_alloc_is_enabled(void)
+{
+	return lua_small.is_enabled;
+}
+
+static int
+lua_small_stats_noop_cb(const struct mempool_stats *stats, void *cb_ctx)
+{
+	(void) stats;
+	(void) cb_ctx;
+	return 0;
+}
+
+void
+lua_small_alloc_stat(struct lua_small_alloc_stat *stat)
+{
+	memset(stat, 0, sizeof(*stat));
+	if (!lua_small.is_enabled)
+		return;
+	struct small_stats totals;
+	small_stats(&lua_small.alloc, &totals, lua_small_stats_noop_cb, NULL);
+	stat->used = lua_small.used;
+	stat->total = totals.total;
+}
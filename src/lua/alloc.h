@@ -0,0 +1,76 @@
+#ifndef TARANTOOL_LUA_ALLOC_H_INCLUDED
+#define TARANTOOL_LUA_ALLOC_H_INCLUDED
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct lua_State;
+
+/** Lua heap statistics of the small allocator. */
+struct lua_small_alloc_stat {
+	/** Bytes currently allocated by Lua. */
+	size_t used;
+	/** Bytes held in slabs, including free pool space. */
+	size_t total;
+};
+
+/**
+ * Create a Lua state with its heap allocated from a small
+ * allocator over the slab cache of the current (tx) cord,
+ * rather than from the system malloc. Allocations are grouped
+ * into size-class pools, accounted in the runtime arena and
+ * attributed to the fiber performing them.
+ *
+ * Returns NULL if LuaJIT doesn't accept a custom allocator,
+ * which is the case for x86_64 builds without GC64.
+ */
+struct lua_State *
+lua_small_alloc_newstate(void);
+
+/** True if the Lua heap is served by the small allocator. */
+bool
+lua_small_alloc_is_enabled(void);
+
+/** Fill in Lua heap statistics of the small allocator. */
+void
+lua_small_alloc_stat(struct lua_small_alloc_stat *stat);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_LUA_ALLOC_H_INCLUDED */
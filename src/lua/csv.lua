@@ -42,6 +42,42 @@ ffi.cdef[[
     int csv_next(struct csv_iterator *);
     void csv_feed(struct csv_iterator *, const char *, size_t);
     size_t csv_escape_field(struct csv *csv, const char *field, size_t field_len, char *dst, size_t buf_size);
+    void csv_parse_chunk(struct csv *csv, const char *s, const char *end);
+    void csv_finish_parsing(struct csv *csv);
+
+    struct csv_mp {
+        struct csv *csv;
+        char *buf;
+        size_t size;
+        size_t capacity;
+        uint32_t row_count;
+        size_t row_begin;
+        uint32_t field_count;
+        uint64_t line_count;
+        int skip_rows;
+        const int *types;
+        uint32_t type_count;
+    };
+    void csv_mp_create(struct csv_mp *mp, struct csv *csv,
+                       const int *types, uint32_t type_count);
+    void csv_mp_destroy(struct csv_mp *mp);
+    const char *csv_mp_batch(struct csv_mp *mp, size_t *size);
+    void csv_mp_reset(struct csv_mp *mp);
+
+    int box_insert_batch(uint32_t space_id, const char *tuples,
+                         const char *tuples_end);
+    int box_replace_batch(uint32_t space_id, const char *tuples,
+                          const char *tuples_end);
+    enum {
+        CSV_ER_OK,
+        CSV_ER_INVALID,
+        CSV_ER_MEMORY_ERROR
+    };
+    enum {
+        CSV_MP_STRING,
+        CSV_MP_INTEGER,
+        CSV_MP_NUMBER
+    };
     enum {
         CSV_IT_OK,
         CSV_IT_EOL,
@@ -153,6 +189,109 @@ module.load = function(readable, opts)
     return result
 end
 
+local csv_mp_field_types = {
+    string = ffi.C.CSV_MP_STRING,
+    integer = ffi.C.CSV_MP_INTEGER,
+    number = ffi.C.CSV_MP_NUMBER,
+}
+
+--@brief parse csv and insert rows into a space, bypassing Lua tables
+--@param readable must be string or object with method read(num) returns string
+--@param space space object
+--@param opts.chunk_size (default 65536). Parser will read by chunk_size symbols
+--@param opts.delimiter (default ',').
+--@param opts.quote_char (default '"').
+--@param opts.skip_head_lines (default 0). Skip header.
+--@param opts.types (default all 'string'). Types of leading fields:
+--       'string', 'integer' or 'number'. Empty numeric fields are nil.
+--@param opts.batch_size (default 1000). Rows are inserted in batches,
+--       each batch is a separate transaction unless called
+--       inside a transaction, see space:insert_many().
+--@param opts.replace (default false). Replace instead of insert.
+--@return number of loaded rows
+module.load_space = function(readable, space, opts)
+    opts = opts or {}
+    if (type(readable) ~= "string" and type(readable.read) ~= "function") or
+       type(space) ~= "table" or type(space.id) ~= "number" then
+        error("Usage: load_space(string or object with method read(num)" ..
+              "returns string, space[, opts])")
+    end
+    local chunk_size = opts.chunk_size or 65536
+    local batch_size = opts.batch_size or 1000
+    local load_batch = ffi.C.box_insert_batch
+    if opts.replace then
+        load_batch = ffi.C.box_replace_batch
+    end
+
+    local csv = ffi.new('struct csv')
+    ffi.C.csv_create(csv)
+    ffi.gc(csv, ffi.C.csv_destroy)
+    csv.delimiter = string.byte(opts.delimiter or ',')
+    csv.quote_char = string.byte(opts.quote_char or '"')
+
+    local types
+    local type_count = 0
+    if opts.types then
+        type_count = #opts.types
+        types = ffi.new('int[?]', type_count)
+        for i, t in ipairs(opts.types) do
+            if csv_mp_field_types[t] == nil then
+                error("load_space: unknown field type '" .. tostring(t) .. "'")
+            end
+            types[i - 1] = csv_mp_field_types[t]
+        end
+    end
+    local mp = ffi.new('struct csv_mp')
+    ffi.C.csv_mp_create(mp, csv, types, type_count)
+    -- the encoder frees its buffer with csv.realloc,
+    -- so csv must outlive it
+    ffi.gc(mp, function(mp) ffi.C.csv_mp_destroy(mp) csv = nil end)
+    mp.skip_rows = opts.skip_head_lines or 0
+
+    local count = 0
+    local size = ffi.new('size_t[1]')
+    local function check_error()
+        if csv.error_status == ffi.C.CSV_ER_MEMORY_ERROR then
+            error("load_space: not enough memory")
+        elseif csv.error_status ~= ffi.C.CSV_ER_OK then
+            error(string.format("load_space: CSV has errors at line %d",
+                                tonumber(mp.line_count) + 1))
+        end
+    end
+    local function flush()
+        if mp.row_count == 0 then
+            return
+        end
+        local batch = ffi.C.csv_mp_batch(mp, size)
+        if load_batch(space.id, batch, batch + size[0]) ~= 0 then
+            box.error()
+        end
+        count = count + mp.row_count
+        ffi.C.csv_mp_reset(mp)
+    end
+
+    local str = readable
+    if type(readable) ~= "string" then
+        str = readable:read(chunk_size)
+    end
+    while str ~= nil and #str > 0 do
+        local p = ffi.cast('const char *', str)
+        ffi.C.csv_parse_chunk(csv, p, p + #str)
+        check_error()
+        if mp.row_count >= batch_size then
+            flush()
+        end
+        if type(readable) == "string" then
+            break
+        end
+        str = readable:read(chunk_size)
+    end
+    ffi.C.csv_finish_parsing(csv)
+    check_error()
+    flush()
+    return count
+end
+
 --@brief dumps tuple or table as csv
 --@param t is tuple or table
 --@param writable must be object with method write(string) like file or socket
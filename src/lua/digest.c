@@ -32,6 +32,9 @@
 #include <string.h>
 #include <lua/digest.h>
 #include <third_party/sha1.h>
+#include <third_party/PMurHash.h>
+#include <salad/guava.h>
+#include <salad/xxh3.h>
 #include <openssl/evp.h>
 #include <coio_task.h>
 #include <lua.h>
@@ -81,8 +84,9 @@ lua_pbkdf2(lua_State *L)
 	int digest_len = lua_tointeger(L, 4);
 	unsigned char digest[PBKDF2_MAX_DIGEST_SIZE];
 
-	if (coio_call(digest_pbkdf2_f, password, strlen(password), salt,
-				  strlen(salt), digest, num_iterations, digest_len) < 0) {
+	if (coio_call_in(COIO_POOL_USER, digest_pbkdf2_f, password,
+			 strlen(password), salt, strlen(salt), digest,
+			 num_iterations, digest_len) < 0) {
 		lua_pushnil(L);
 		return 1;
 	}
@@ -90,11 +94,78 @@ lua_pbkdf2(lua_State *L)
 	return 1;
 }
 
+/*
+ * Batch hash functions take a Lua array and return an array of
+ * results, so hashing many keys takes one call from Lua.
+ */
+
+static int
+lua_murmur_batch(lua_State *L)
+{
+	luaL_checktype(L, 1, LUA_TTABLE);
+	uint32_t seed = luaL_checkinteger(L, 2);
+	int count = lua_objlen(L, 1);
+	lua_createtable(L, count, 0);
+	for (int i = 1; i <= count; i++) {
+		lua_rawgeti(L, 1, i);
+		size_t len;
+		const char *key = lua_tolstring(L, -1, &len);
+		if (key == NULL)
+			return luaL_error(L, "key %d is not a string", i);
+		uint32_t hash = PMurHash32(seed, key, len);
+		lua_pop(L, 1);
+		lua_pushnumber(L, hash);
+		lua_rawseti(L, -2, i);
+	}
+	return 1;
+}
+
+static int
+lua_xxh3_batch(lua_State *L)
+{
+	luaL_checktype(L, 1, LUA_TTABLE);
+	uint64_t seed = luaL_checkuint64(L, 2);
+	int count = lua_objlen(L, 1);
+	lua_createtable(L, count, 0);
+	for (int i = 1; i <= count; i++) {
+		lua_rawgeti(L, 1, i);
+		size_t len;
+		const char *key = lua_tolstring(L, -1, &len);
+		if (key == NULL)
+			return luaL_error(L, "key %d is not a string", i);
+		uint64_t hash = xxh3_64(key, len, seed);
+		lua_pop(L, 1);
+		luaL_pushuint64(L, hash);
+		lua_rawseti(L, -2, i);
+	}
+	return 1;
+}
+
+static int
+lua_guava_batch(lua_State *L)
+{
+	luaL_checktype(L, 1, LUA_TTABLE);
+	int32_t buckets = luaL_checkinteger(L, 2);
+	int count = lua_objlen(L, 1);
+	lua_createtable(L, count, 0);
+	for (int i = 1; i <= count; i++) {
+		lua_rawgeti(L, 1, i);
+		int64_t state = luaL_checkint64(L, -1);
+		lua_pop(L, 1);
+		lua_pushinteger(L, guava(state, buckets));
+		lua_rawseti(L, -2, i);
+	}
+	return 1;
+}
+
 void
 tarantool_lua_digest_init(struct lua_State *L)
 {
 	static const struct luaL_Reg lua_digest_methods [] = {
 		{"pbkdf2", lua_pbkdf2},
+		{"murmur_batch", lua_murmur_batch},
+		{"xxh3_batch", lua_xxh3_batch},
+		{"guava_batch", lua_guava_batch},
 		{NULL, NULL}
 	};
 	luaL_register_module(L, "digest", lua_digest_methods);
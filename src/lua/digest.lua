@@ -28,6 +28,9 @@ ffi.cdef[[
     void PMurHash32_Process(uint32_t *ph1, uint32_t *pcarry, const void *key, int len);
     uint32_t PMurHash32_Result(uint32_t h1, uint32_t carry, uint32_t total_length);
     uint32_t PMurHash32(uint32_t seed, const void *key, int len);
+
+    /* from lib/salad/xxh3.h */
+    uint64_t xxh3_64(const void *data, size_t len, uint64_t seed);
 ]]
 
 -- @sa base64.h
@@ -225,6 +228,27 @@ local m = {
        return ffi.C.guava(state, buckets)
     end,
 
+    guava_batch = function(states, buckets)
+        if type(states) ~= 'table' or type(buckets) ~= 'number' then
+            error('Usage: digest.guava_batch(table, buckets)')
+        end
+        return internal.guava_batch(states, buckets)
+    end,
+
+    xxh3 = function(str, seed)
+        if type(str) ~= 'string' then
+            error('Usage: digest.xxh3(string[, seed])')
+        end
+        return ffi.C.xxh3_64(str, #str, seed or 0)
+    end,
+
+    xxh3_batch = function(keys, seed)
+        if type(keys) ~= 'table' then
+            error('Usage: digest.xxh3_batch(table[, seed])')
+        end
+        return internal.xxh3_batch(keys, seed or 0)
+    end,
+
     urandom = function(n)
         if n == nil then
             error('Usage: digest.urandom(len)')
@@ -236,6 +260,13 @@ local m = {
 
     murmur = PMurHash,
 
+    murmur_batch = function(keys, seed)
+        if type(keys) ~= 'table' then
+            error('Usage: digest.murmur_batch(table[, seed])')
+        end
+        return internal.murmur_batch(keys, seed or PMurHash.default_seed)
+    end,
+
     pbkdf2 = pbkdf2,
 
     pbkdf2_hex = function(pass, salt, iters, digest_len)
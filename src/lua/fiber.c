@@ -32,11 +32,14 @@
 
 #include <fiber.h>
 #include "lua/utils.h"
+#include "lua/alloc.h"
 #include "backtrace.h"
 
 #include <lua.h>
 #include <lauxlib.h>
 #include <lualib.h>
+#include <limits.h>
+#include <stdlib.h>
 
 void
 luaL_testcancel(struct lua_State *L)
@@ -285,6 +288,11 @@ lbox_fiber_statof(struct fiber *f, void *cb_ctx, bool backtrace)
 	lua_pushnumber(L, region_total(&f->gc) + f->stack_size +
 		       sizeof(struct fiber));
 	lua_settable(L, -3);
+	if (lua_small_alloc_is_enabled()) {
+		lua_pushstring(L, "lua");
+		lua_pushnumber(L, f->storage.lua.alloc);
+		lua_settable(L, -3);
+	}
 	lua_settable(L, -3);
 
 	if (backtrace) {
@@ -355,6 +363,113 @@ lbox_fiber_info(struct lua_State *L)
 	return 1;
 }
 
+static int
+lbox_fiber_top_enable(struct lua_State *L)
+{
+	(void) L;
+	fiber_prof_enable(true);
+	return 0;
+}
+
+static int
+lbox_fiber_top_disable(struct lua_State *L)
+{
+	(void) L;
+	fiber_prof_enable(false);
+	return 0;
+}
+
+static int
+lbox_fiber_top_reset(struct lua_State *L)
+{
+	(void) L;
+	fiber_prof_reset();
+	return 0;
+}
+
+struct lbox_fiber_top_ctx {
+	struct fiber **fibers;
+	int count;
+};
+
+static int
+lbox_fiber_top_collect(struct fiber *f, void *cb_ctx)
+{
+	struct lbox_fiber_top_ctx *ctx = (struct lbox_fiber_top_ctx *) cb_ctx;
+	if (ctx->fibers != NULL)
+		ctx->fibers[ctx->count] = f;
+	ctx->count++;
+	return 0;
+}
+
+static int
+lbox_fiber_top_cmp(const void *a, const void *b)
+{
+	uint64_t cpu_a = (*(struct fiber **) a)->prof.cpu;
+	uint64_t cpu_b = (*(struct fiber **) b)->prof.cpu;
+	return cpu_a < cpu_b ? 1 : cpu_a > cpu_b ? -1 : 0;
+}
+
+/**
+ * Return up to n fibers which consumed the most CPU time
+ * since the profiler was enabled, with a breakdown of the
+ * time they spent waiting. Times are in seconds.
+ */
+static int
+lbox_fiber_top(struct lua_State *L)
+{
+	int limit = INT_MAX;
+	if (!lua_isnoneornil(L, 1)) {
+		limit = lua_tointeger(L, 1);
+		if (limit <= 0)
+			luaL_error(L, "fiber.top(limit): bad arguments");
+	}
+	struct lbox_fiber_top_ctx ctx = { NULL, 0 };
+	fiber_stat(lbox_fiber_top_collect, &ctx);
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	ctx.fibers = (struct fiber **)
+		region_alloc(region, ctx.count * sizeof(ctx.fibers[0]));
+	if (ctx.fibers == NULL && ctx.count > 0) {
+		diag_set(OutOfMemory, ctx.count * sizeof(ctx.fibers[0]),
+			 "region", "fibers");
+		luaT_error(L);
+	}
+	ctx.count = 0;
+	fiber_stat(lbox_fiber_top_collect, &ctx);
+	qsort(ctx.fibers, ctx.count, sizeof(ctx.fibers[0]),
+	      lbox_fiber_top_cmp);
+	if (limit > ctx.count)
+		limit = ctx.count;
+
+	double elapsed = fiber_prof_elapsed() / 1e9;
+	lua_createtable(L, limit, 0);
+	for (int i = 0; i < limit; i++) {
+		struct fiber *f = ctx.fibers[i];
+		double cpu = f->prof.cpu / 1e9;
+		lua_createtable(L, 0, 6);
+		lua_pushnumber(L, f->fid);
+		lua_setfield(L, -2, "fid");
+		lua_pushstring(L, fiber_name(f));
+		lua_setfield(L, -2, "name");
+		lua_pushnumber(L, f->csw);
+		lua_setfield(L, -2, "csw");
+		lua_pushnumber(L, cpu);
+		lua_setfield(L, -2, "cpu");
+		lua_pushnumber(L, elapsed > 0 ? cpu * 100 / elapsed : 0);
+		lua_setfield(L, -2, "cpu_share");
+		lua_createtable(L, 0, fiber_wait_reason_MAX);
+		for (int r = 0; r < fiber_wait_reason_MAX; r++) {
+			lua_pushnumber(L, f->prof.wait[r] / 1e9);
+			lua_setfield(L, -2, fiber_wait_reason_strs[r]);
+		}
+		lua_setfield(L, -2, "wait");
+		lua_rawseti(L, -2, i + 1);
+	}
+	region_truncate(region, used);
+	return 1;
+}
+
 static int
 lua_fiber_run_f(MAYBE_UNUSED va_list ap)
 {
@@ -737,6 +852,10 @@ static const struct luaL_Reg lbox_fiber_meta [] = {
 
 static const struct luaL_Reg fiberlib[] = {
 	{"info", lbox_fiber_info},
+	{"top", lbox_fiber_top},
+	{"top_enable", lbox_fiber_top_enable},
+	{"top_disable", lbox_fiber_top_disable},
+	{"top_reset", lbox_fiber_top_reset},
 	{"sleep", lbox_fiber_sleep},
 	{"yield", lbox_fiber_yield},
 	{"self", lbox_fiber_self},
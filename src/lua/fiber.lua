@@ -30,6 +30,64 @@ local function fiber_clock64()
     return C.fiber_clock64()
 end
 
+--
+-- Sampling profiler of Lua stacks, built on top of the LuaJIT
+-- profiler. Samples are aggregated per fiber name and stack,
+-- and dumped in the folded format understood by flamegraph.pl.
+--
+local profile
+local prof_samples
+local prof_depth
+
+local vmstate_frames = {G = '[gc]', J = '[jit]'}
+
+local function prof_cb(thread, samples, vmstate)
+    local name = fiber.self():name():gsub('[; ]', '_')
+    local key = name
+    local stack = profile.dumpstack(thread, 'pFZ;', -prof_depth)
+    if stack ~= '' then
+        key = key .. ';' .. stack
+    end
+    local frame = vmstate_frames[vmstate]
+    if frame ~= nil then
+        key = key .. ';' .. frame
+    end
+    prof_samples[key] = (prof_samples[key] or 0) + samples
+end
+
+local function profile_start(opts)
+    opts = opts or {}
+    if type(opts) ~= 'table' then
+        error("Usage: fiber.profile_start([{interval = <ms>, depth = <n>}])")
+    end
+    local interval = opts.interval or 10
+    prof_depth = opts.depth or 64
+    if profile == nil then
+        profile = require('jit.profile')
+    end
+    profile.stop()
+    prof_samples = {}
+    profile.start('i' .. interval, prof_cb)
+end
+
+local function profile_stop()
+    if profile ~= nil then
+        profile.stop()
+    end
+end
+
+local function profile_dump()
+    local lines = {}
+    for key, count in pairs(prof_samples or {}) do
+        table.insert(lines, key .. ' ' .. count)
+    end
+    table.sort(lines)
+    return table.concat(lines, '\n')
+end
+
+fiber.profile_start = profile_start
+fiber.profile_stop = profile_stop
+fiber.profile_dump = profile_dump
 fiber.time = fiber_time
 fiber.time64 = fiber_time64
 fiber.clock = fiber_clock
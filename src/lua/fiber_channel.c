@@ -45,6 +45,7 @@ luaL_error(lua_State *L, const char *fmt, ...);
 #include "lua/utils.h"
 #include <fiber.h>
 #include <fiber_channel.h>
+#include <small/mempool.h>
 
 static const char channel_typename[] = "fiber.channel";
 
@@ -113,12 +114,111 @@ luaT_fiber_channel_is_empty(struct lua_State *L)
 	return 1;
 }
 
+/**
+ * A Lua value passed over a channel. Numbers, booleans and nil
+ * are stored in the message itself, anything else is anchored
+ * in the Lua registry until the message is delivered.
+ */
+struct lua_ipc_value {
+	struct ipc_msg base;
+	/** Lua type of the value. */
+	int type;
+	union {
+		double number;
+		bool boolean;
+		int ref;
+	};
+};
+
+enum {
+	/**
+	 * The number of messages put or taken with one call
+	 * of the channel batch API from put_many()/get_many().
+	 */
+	LUA_IPC_BATCH_SIZE = 64,
+};
+
+static __thread struct mempool lua_ipc_value_pool;
+
 static void
 lua_ipc_value_destroy(struct ipc_msg *base)
 {
-	struct ipc_value *value = (struct ipc_value *) base;
-	luaL_unref(tarantool_L, LUA_REGISTRYINDEX, value->i);
-	ipc_value_delete(base);
+	struct lua_ipc_value *value = (struct lua_ipc_value *) base;
+	if (value->type != LUA_TNUMBER && value->type != LUA_TBOOLEAN &&
+	    value->type != LUA_TNIL)
+		luaL_unref(tarantool_L, LUA_REGISTRYINDEX, value->ref);
+	mempool_free(&lua_ipc_value_pool, value);
+}
+
+/** Wrap the Lua value at @a idx into a channel message. */
+static struct ipc_msg *
+lua_ipc_value_new(struct lua_State *L, int idx)
+{
+	if (! mempool_is_initialized(&lua_ipc_value_pool)) {
+		mempool_create(&lua_ipc_value_pool, &cord()->slabc,
+			       sizeof(struct lua_ipc_value));
+	}
+	struct lua_ipc_value *value = (struct lua_ipc_value *)
+		mempool_alloc(&lua_ipc_value_pool);
+	if (value == NULL) {
+		diag_set(OutOfMemory, sizeof(struct lua_ipc_value),
+			 "mempool_alloc", "struct lua_ipc_value");
+		return NULL;
+	}
+	value->base.destroy = lua_ipc_value_destroy;
+	value->type = lua_type(L, idx);
+	switch (value->type) {
+	case LUA_TNUMBER:
+		value->number = lua_tonumber(L, idx);
+		break;
+	case LUA_TBOOLEAN:
+		value->boolean = lua_toboolean(L, idx);
+		break;
+	case LUA_TNIL:
+		break;
+	default:
+		lua_pushvalue(L, idx);
+		value->ref = luaL_ref(L, LUA_REGISTRYINDEX);
+		break;
+	}
+	return &value->base;
+}
+
+/** Push the value carried by a message and destroy it. */
+static void
+lua_ipc_value_push(struct lua_State *L, struct ipc_msg *base)
+{
+	struct lua_ipc_value *value = (struct lua_ipc_value *) base;
+	switch (value->type) {
+	case LUA_TNUMBER:
+		lua_pushnumber(L, value->number);
+		break;
+	case LUA_TBOOLEAN:
+		lua_pushboolean(L, value->boolean);
+		break;
+	case LUA_TNIL:
+		lua_pushnil(L);
+		break;
+	default:
+		lua_rawgeti(L, LUA_REGISTRYINDEX, value->ref);
+		break;
+	}
+	value->base.destroy(&value->base);
+}
+
+/** Parse an optional timeout argument. */
+static ev_tstamp
+luaT_fiber_channel_checktimeout(struct lua_State *L, int idx,
+				const char *usage)
+{
+	if (lua_isnoneornil(L, idx))
+		return TIMEOUT_INFINITY;
+	if (!lua_isnumber(L, idx))
+		luaL_error(L, "usage: %s", usage);
+	ev_tstamp timeout = lua_tonumber(L, idx);
+	if (timeout < 0)
+		luaL_error(L, "usage: %s", usage);
+	return timeout;
 }
 
 static int
@@ -128,34 +228,21 @@ luaT_fiber_channel_put(struct lua_State *L)
 	int rc = -1;
 	struct fiber_channel *ch =
 		luaT_checkfiberchannel(L, 1, usage);
-	ev_tstamp timeout;
 
 	/* val */
 	if (lua_gettop(L) < 2)
 		luaL_error(L, "usage: %s", usage);
 
 	/* timeout (optional) */
-	if (lua_isnoneornil(L, 3)) {
-		timeout = TIMEOUT_INFINITY;
-	} else if (lua_isnumber(L, 3)) {
-		timeout = lua_tonumber(L, 3);
-		if (timeout < 0)
-			luaL_error(L, "usage: %s", usage);
-	} else {
-		luaL_error(L, "usage: %s", usage);
-	}
+	ev_tstamp timeout = luaT_fiber_channel_checktimeout(L, 3, usage);
 
-	struct ipc_value *value = ipc_value_new();
-	if (value == NULL)
+	struct ipc_msg *msg = lua_ipc_value_new(L, 2);
+	if (msg == NULL)
 		goto end;
 
-	value->base.destroy = lua_ipc_value_destroy;
-	lua_pushvalue(L, 2);
-	value->i = luaL_ref(L, LUA_REGISTRYINDEX);
-
-	rc = fiber_channel_put_msg_timeout(ch, &value->base, timeout);
+	rc = fiber_channel_put_msg_timeout(ch, msg, timeout);
 	if (rc) {
-		value->base.destroy(&value->base);
+		msg->destroy(msg);
 #if 0
 		/* Treat everything except timeout as error. */
 		if (!type_cast(TimedOut, diag_last_error(&fiber()->diag)))
@@ -169,28 +256,66 @@ end:
 	return 1;
 }
 
+/**
+ * channel:put_many(values [, timeout]) puts the items of the
+ * array @a values in order. It waits for the first one to be
+ * sent and then sends as many as possible without waiting,
+ * handing them over to a reader blocked in get_many() with
+ * a single wakeup. Returns the number of values sent.
+ */
+static int
+luaT_fiber_channel_put_many(struct lua_State *L)
+{
+	static const char usage[] = "channel:put_many(values [, timeout])";
+	struct fiber_channel *ch = luaT_checkfiberchannel(L, 1, usage);
+	if (lua_type(L, 2) != LUA_TTABLE)
+		luaL_error(L, "usage: %s", usage);
+	ev_tstamp timeout = luaT_fiber_channel_checktimeout(L, 3, usage);
+
+	uint32_t total = lua_objlen(L, 2);
+	uint32_t sent = 0;
+	struct ipc_msg *msgs[LUA_IPC_BATCH_SIZE];
+	while (sent < total) {
+		uint32_t count = MIN(total - sent, (uint32_t)
+				     LUA_IPC_BATCH_SIZE);
+		uint32_t i;
+		for (i = 0; i < count; i++) {
+			lua_rawgeti(L, 2, sent + i + 1);
+			msgs[i] = lua_ipc_value_new(L, -1);
+			lua_pop(L, 1);
+			if (msgs[i] == NULL)
+				break;
+		}
+		int rc = i == 0 ? -1 :
+			 fiber_channel_put_msg_many_timeout(ch, msgs, i,
+							    timeout);
+		uint32_t done = rc > 0 ? rc : 0;
+		for (uint32_t j = done; j < i; j++)
+			msgs[j]->destroy(msgs[j]);
+		sent += done;
+		if (done < count)
+			break;
+		/* Wait only for the first value. */
+		timeout = 0;
+	}
+	if (sent == 0)
+		luaL_testcancel(L);
+	lua_pushinteger(L, sent);
+	return 1;
+}
+
 static int
 luaT_fiber_channel_get(struct lua_State *L)
 {
 	static const char usage[] = "channel:get([timeout])";
 	struct fiber_channel *ch =
 		luaT_checkfiberchannel(L, 1, usage);
-	ev_tstamp timeout;
 
 	/* timeout (optional) */
-	if (lua_isnoneornil(L, 2)) {
-		timeout = TIMEOUT_INFINITY;
-	} else if (lua_isnumber(L, 2)) {
-		timeout = lua_tonumber(L, 2);
-		if (timeout < 0)
-			luaL_error(L, "usage: %s", usage);
-	} else {
-		luaL_error(L, "usage: %s", usage);
-	}
+	ev_tstamp timeout = luaT_fiber_channel_checktimeout(L, 2, usage);
 
-	struct ipc_value *value;
-	if (fiber_channel_get_msg_timeout(ch, (struct ipc_msg **) &value,
-					timeout)) {
+	struct ipc_msg *msg;
+	if (fiber_channel_get_msg_timeout(ch, &msg, timeout)) {
 #if 0
 		/* Treat everything except timeout as error. */
 		if (!type_cast(TimedOut, diag_last_error(&fiber()->diag)))
@@ -201,8 +326,49 @@ luaT_fiber_channel_get(struct lua_State *L)
 		lua_pushnil(L);
 		return 1;
 	}
-	lua_rawgeti(L, LUA_REGISTRYINDEX, value->i);
-	value->base.destroy(&value->base);
+	lua_ipc_value_push(L, msg);
+	return 1;
+}
+
+/**
+ * channel:get_many(limit [, timeout]) waits for at least one
+ * value and returns an array of up to @a limit values that
+ * could be taken without waiting, or nil on timeout.
+ */
+static int
+luaT_fiber_channel_get_many(struct lua_State *L)
+{
+	static const char usage[] = "channel:get_many(limit [, timeout])";
+	struct fiber_channel *ch = luaT_checkfiberchannel(L, 1, usage);
+	if (!lua_isnumber(L, 2) || lua_tointeger(L, 2) <= 0)
+		luaL_error(L, "usage: %s", usage);
+	uint32_t limit = lua_tointeger(L, 2);
+	ev_tstamp timeout = luaT_fiber_channel_checktimeout(L, 3, usage);
+
+	struct ipc_msg *msgs[LUA_IPC_BATCH_SIZE];
+	uint32_t got = 0;
+	while (got < limit) {
+		uint32_t size = MIN(limit - got, (uint32_t)
+				    LUA_IPC_BATCH_SIZE);
+		int rc = fiber_channel_get_msg_many_timeout(ch, msgs, size,
+							    timeout);
+		if (rc < 0)
+			break;
+		if (got == 0)
+			lua_createtable(L, rc, 0);
+		for (int i = 0; i < rc; i++) {
+			lua_ipc_value_push(L, msgs[i]);
+			lua_rawseti(L, -2, ++got);
+		}
+		if ((uint32_t) rc < size)
+			break;
+		/* Wait only for the first value. */
+		timeout = 0;
+	}
+	if (got == 0) {
+		luaL_testcancel(L);
+		lua_pushnil(L);
+	}
 	return 1;
 }
 
@@ -280,6 +446,8 @@ tarantool_lua_fiber_channel_init(struct lua_State *L)
 		{"is_empty",	luaT_fiber_channel_is_empty},
 		{"put",		luaT_fiber_channel_put},
 		{"get",		luaT_fiber_channel_get},
+		{"put_many",	luaT_fiber_channel_put_many},
+		{"get_many",	luaT_fiber_channel_get_many},
 		{"has_readers",	luaT_fiber_channel_has_readers},
 		{"has_writers",	luaT_fiber_channel_has_writers},
 		{"count",	luaT_fiber_channel_count},
@@ -33,6 +33,7 @@
  * Unique name for userdata metatables
  */
 #define DRIVER_LUA_UDATA_NAME	"httpc"
+#define DRIVER_LUA_IO_UDATA_NAME	"httpc.io"
 
 #include <http_parser.h>
 #include "src/httpc.h"
@@ -52,6 +53,20 @@ luaT_httpc_checkenv(lua_State *L)
 			luaL_checkudata(L, 1, DRIVER_LUA_UDATA_NAME);
 }
 
+/**
+ * Return the request a streamed response reader refers to,
+ * raise an error if the reader was closed.
+ */
+static inline struct httpc_request *
+luaT_httpc_checkio(lua_State *L)
+{
+	struct httpc_request **preq = (struct httpc_request **)
+			luaL_checkudata(L, 1, DRIVER_LUA_IO_UDATA_NAME);
+	if (*preq == NULL)
+		luaL_error(L, "response body reader is closed");
+	return *preq;
+}
+
 static inline void
 lua_add_key_u64(lua_State *L, const char *key, uint64_t value)
 {
@@ -276,6 +291,11 @@ luaT_httpc_request(lua_State *L)
 		httpc_set_interface(req, lua_tostring(L, -1));
 	lua_pop(L, 1);
 
+	lua_getfield(L, 5, "chunked");
+	if (lua_toboolean(L, -1))
+		httpc_set_stream(req);
+	lua_pop(L, 1);
+
 	if (httpc_execute(req, timeout) != 0) {
 		httpc_request_delete(req);
 		return luaT_error(L);
@@ -304,6 +324,18 @@ luaT_httpc_request(lua_State *L)
 			diag_log();
 	}
 
+	if (req->stream) {
+		/* The reader owns the request from now on. */
+		lua_pushstring(L, "_io");
+		struct httpc_request **preq = (struct httpc_request **)
+			lua_newuserdata(L, sizeof(*preq));
+		*preq = req;
+		luaL_getmetatable(L, DRIVER_LUA_IO_UDATA_NAME);
+		lua_setmetatable(L, -2);
+		lua_settable(L, -3);
+		return 1;
+	}
+
 	size_t body_len = region_used(&req->resp_body);
 	if (body_len > 0) {
 		char *body = region_join(&req->resp_body, body_len);
@@ -344,10 +376,52 @@ luaT_httpc_stat(lua_State *L)
 			ctx->stat.http_other_responses);
 	lua_add_key_u64(L, "failed_requests",
 			(uint64_t) ctx->stat.failed_requests);
+	lua_add_key_u64(L, "connections_reused",
+			ctx->stat.connections_reused);
+	lua_add_key_u64(L, "connections_opened",
+			ctx->stat.connections_opened);
+	lua_add_key_u64(L, "tls_handshakes",
+			ctx->stat.tls_handshakes);
 
 	return 1;
 }
 
+static int
+luaT_httpc_io_read(lua_State *L)
+{
+	struct httpc_request *req = luaT_httpc_checkio(L);
+	size_t len = luaL_checkinteger(L, 2);
+	double timeout = luaL_optnumber(L, 3, TIMEOUT_INFINITY);
+
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	char *buf = region_alloc(region, len);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, len, "region", "httpc chunk");
+		return luaT_error(L);
+	}
+	ssize_t size = httpc_read(req, buf, len, timeout);
+	if (size < 0) {
+		region_truncate(region, used);
+		return luaT_error(L);
+	}
+	lua_pushlstring(L, buf, size);
+	region_truncate(region, used);
+	return 1;
+}
+
+static int
+luaT_httpc_io_close(lua_State *L)
+{
+	struct httpc_request **preq = (struct httpc_request **)
+			luaL_checkudata(L, 1, DRIVER_LUA_IO_UDATA_NAME);
+	if (*preq != NULL) {
+		httpc_request_delete(*preq);
+		*preq = NULL;
+	}
+	return 0;
+}
+
 static int
 luaT_httpc_new(lua_State *L)
 {
@@ -357,7 +431,9 @@ luaT_httpc_new(lua_State *L)
 		return luaL_error(L, "lua_newuserdata failed: httpc_env");
 
 	long max_conns = luaL_checklong(L, 1);
-	if (httpc_env_create(ctx, max_conns) != 0)
+	long max_host_conns = luaL_optlong(L, 2, 0);
+	bool http2 = lua_toboolean(L, 3);
+	if (httpc_env_create(ctx, max_conns, max_host_conns, http2) != 0)
 		return luaT_error(L);
 
 	luaL_getmetatable(L, DRIVER_LUA_UDATA_NAME);
@@ -400,6 +476,13 @@ static const struct luaL_Reg Client[] = {
 	{NULL, NULL}
 };
 
+static const struct luaL_Reg Io[] = {
+	{"read", luaT_httpc_io_read},
+	{"close", luaT_httpc_io_close},
+	{"__gc", luaT_httpc_io_close},
+	{NULL, NULL}
+};
+
 /*
  * Lib initializer
  */
@@ -407,6 +490,7 @@ LUA_API int
 luaopen_http_client_driver(lua_State *L)
 {
 	luaL_register_type(L, DRIVER_LUA_UDATA_NAME, Client);
+	luaL_register_type(L, DRIVER_LUA_IO_UDATA_NAME, Io);
 	luaL_register_module(L, "http.client", Module);
 	return 1;
 }
@@ -42,6 +42,11 @@ local curl_mt
 --  Parameters:
 --
 --  max_connectionss -  Maximum number of entries in the connection cache */
+--  max_host_connections - Maximum number of connections to a single host,
+--      requests above the limit wait for a connection to be freed;
+--      0 (default) means unlimited
+--  http2 - Negotiate HTTP/2 with TLS servers and multiplex concurrent
+--      requests to the same host over a single connection
 --
 --  Returns:
 --  curl object or raise error()
@@ -52,8 +57,10 @@ local http_new = function(opts)
     opts = opts or {}
 
     opts.max_connections = opts.max_connections or 5
+    opts.max_host_connections = opts.max_host_connections or 0
 
-    local curl = driver.new(opts.max_connections)
+    local curl = driver.new(opts.max_connections, opts.max_host_connections,
+                            opts.http2 == true)
     return setmetatable({ curl = curl, }, curl_mt )
 end
 
@@ -258,6 +265,8 @@ end
 --
 --      keepalive_idle & keepalive_interval -
 --          non-universal keepalive knobs (Linux, AIX, HP-UX, more);
+--          note, connections are kept in the connection cache and
+--          reused by subsequent requests even if these are unset;
 --
 --      low_speed_time & low_speed_limit -
 --          If the download receives less than
@@ -275,6 +284,13 @@ end
 --
 --      verbose - set on/off verbose mode
 --
+--      chunked - stream the response body instead of buffering it;
+--          the request returns as soon as the response starts and
+--          the body is read with resp:read(size[, timeout]), which
+--          returns an empty string at the end of the body; the
+--          transfer is paused while the reader doesn't keep up;
+--          call resp:close() to abort the transfer early
+--
 --  Returns:
 --      {
 --          status=NUMBER,
@@ -287,6 +303,16 @@ end
 --  Raises error() on invalid arguments and OOM
 --
 
+local DEFAULT_READ_SIZE = 64 * 1024
+
+local function response_read(self, size, timeout)
+    return self._io:read(size or DEFAULT_READ_SIZE, timeout)
+end
+
+local function response_close(self)
+    self._io:close()
+end
+
 curl_mt = {
     __index = {
         --
@@ -303,6 +329,12 @@ curl_mt = {
                 end
                 resp.headers = process_headers(resp.headers)
             end
+            if resp and resp._io then
+                -- The reader must not outlive the client.
+                resp._client = self
+                resp.read = response_read
+                resp.close = response_close
+            end
             return resp
         end,
 
@@ -404,6 +436,15 @@ curl_mt = {
         --  failed_requests - this is a total number of requests which have
         --      failed (included systeme erros, curl errors, HTTP
         --      errors and so on)
+        --
+        --  connections_reused - this is a total number of requests
+        --      which were served over a cached connection
+        --
+        --  connections_opened - this is a total number of new
+        --      connections opened by requests
+        --
+        --  tls_handshakes - this is a total number of TLS handshakes
+        --      done by requests
         --  }
         --  or error()
         --
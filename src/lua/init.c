@@ -29,6 +29,7 @@
  * SUCH DAMAGE.
  */
 #include "lua/init.h"
+#include "lua/alloc.h"
 #include "lua/utils.h"
 #include "main.h"
 #if defined(__FreeBSD__) || defined(__NetBSD__) || defined(__APPLE__)
@@ -426,7 +427,23 @@ luaopen_tarantool(lua_State *L)
 void
 tarantool_lua_init(const char *tarantool_bin, int argc, char **argv)
 {
-	lua_State *L = luaL_newstate();
+	lua_State *L = NULL;
+	/*
+	 * The Lua state is created long before box.cfg{}, so
+	 * the allocator can only be chosen from the environment.
+	 */
+	const char *alloc = getenv("TARANTOOL_LUA_ALLOC");
+	if (alloc != NULL && strcmp(alloc, "small") == 0) {
+		L = lua_small_alloc_newstate();
+		if (L == NULL)
+			say_warn("LuaJIT doesn't support custom allocators, "
+				 "falling back to the system one");
+	} else if (alloc != NULL && strcmp(alloc, "system") != 0) {
+		say_warn("unknown TARANTOOL_LUA_ALLOC value '%s', "
+			 "using the system allocator", alloc);
+	}
+	if (L == NULL)
+		L = luaL_newstate();
 	if (L == NULL) {
 		panic("failed to initialize Lua");
 	}
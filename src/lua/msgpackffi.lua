@@ -585,6 +585,196 @@ local function decode_unchecked(str, offset)
     end
 end
 
+--------------------------------------------------------------------------------
+-- Compiled codecs
+--------------------------------------------------------------------------------
+
+--
+-- A codec of records of a fixed shape, e.g. tuples of a space,
+-- is compiled into straight-line Lua code, which encodes and
+-- decodes fields of the expected types without dispatching on
+-- the type of every value and traces well. Values of other
+-- types are still handled by the generic encode_r()/decode_r().
+--
+
+local codec_field_types = {
+    unsigned = 'integer', integer = 'integer', string = 'string',
+    boolean = 'boolean',
+}
+
+-- Field types to generate specialized code for.
+local function codec_types(format)
+    if type(format) ~= 'table' then
+        error("Usage: msgpackffi.codec({type | {name = ..., type = ...}, ...})")
+    end
+    local types = {}
+    for i, field in ipairs(format) do
+        local ftype = field
+        if type(field) == 'table' then
+            ftype = field.type or 'any'
+        end
+        if type(ftype) ~= 'string' then
+            error(string.format("msgpackffi.codec(): invalid type of "..
+                                "field %d", i))
+        end
+        types[i] = codec_field_types[ftype] or 'any'
+    end
+    return types
+end
+
+local encode_field_code = {
+    integer = [[
+    v = obj[%d]
+    if type(v) == 'number' and v %% 1 == 0 then
+        encode_int(buf, v)
+    else
+        encode_r(buf, v, 1)
+    end
+]];
+    string = [[
+    v = obj[%d]
+    if type(v) == 'string' then
+        encode_str(buf, v)
+    else
+        encode_r(buf, v, 1)
+    end
+]];
+    boolean = [[
+    v = obj[%d]
+    if type(v) == 'boolean' then
+        encode_bool(buf, v)
+    else
+        encode_r(buf, v, 1)
+    end
+]];
+    any = [[
+    encode_r(buf, obj[%d], 1)
+]];
+}
+
+local decode_field_code = {
+    integer = [[
+    c = data[0][0]
+    if c <= 0x7f then
+        data[0] = data[0] + 1
+        r[%d] = tonumber(c)
+    else
+        r[%d] = decode_r(data)
+    end
+]];
+    string = [[
+    c = data[0][0]
+    if c >= 0xa0 and c <= 0xbf then
+        data[0] = data[0] + 1
+        r[%d] = decode_str(data, bit.band(c, 0x1f))
+    else
+        r[%d] = decode_r(data)
+    end
+]];
+    any = [[
+    r[%d] = decode_r(data)
+]];
+}
+decode_field_code.boolean = decode_field_code.any
+
+local function codec_compile(types)
+    local count = #types
+    local code = {
+        'local encode_array, encode_int, encode_str, encode_bool, encode_r,',
+        '      decode_r, decode_str, decode_u16, table_new, msgpack = ...',
+        'local function encode(buf, obj)',
+        '    local v',
+        string.format('    encode_array(buf, %d)', count),
+    }
+    for i, ftype in ipairs(types) do
+        table.insert(code, string.format(encode_field_code[ftype], i))
+    end
+    table.insert(code, 'end')
+    table.insert(code, 'local function decode(data)')
+    table.insert(code, '    local p = data[0]')
+    table.insert(code, '    local c = p[0]')
+    if count <= 0xf then
+        table.insert(code, string.format('    if c ~= %d then', 0x90 + count))
+        table.insert(code, '        return decode_r(data)')
+        table.insert(code, '    end')
+        table.insert(code, '    data[0] = p + 1')
+    else
+        -- Longer arrays are encoded with 16-bit size.
+        table.insert(code, '    if c ~= 0xdc then')
+        table.insert(code, '        return decode_r(data)')
+        table.insert(code, '    end')
+        table.insert(code, '    data[0] = p + 1')
+        table.insert(code, string.format('    if decode_u16(data) ~= %d then',
+                                         count))
+        table.insert(code, '        data[0] = p')
+        table.insert(code, '        return decode_r(data)')
+        table.insert(code, '    end')
+    end
+    table.insert(code, string.format('    local r = table_new(%d, 0)', count))
+    for i, ftype in ipairs(types) do
+        table.insert(code, string.format(decode_field_code[ftype], i, i))
+    end
+    table.insert(code, '    if msgpack.cfg.decode_save_metatables then')
+    table.insert(code, '        setmetatable(r, msgpack.array_mt)')
+    table.insert(code, '    end')
+    table.insert(code, '    return r')
+    table.insert(code, 'end')
+    table.insert(code, 'return encode, decode')
+    local chunk = assert(loadstring(table.concat(code, '\n'), '=codec'))
+    return chunk(encode_array, encode_int, encode_str, encode_bool,
+                 encode_r, decode_r, decode_str, decode_u16,
+                 require('table.new'), msgpack)
+end
+
+--
+-- codec(format) -> codec
+--
+-- Compile a codec of arrays, which fields have types given
+-- by format: a list of field types or a space format.
+--
+--  codec.encode(obj) -> string
+--  codec.encode(obj, ibuf) -> size, append to ibuf
+--  codec.decode(str, offset) -> res, new_offset
+--  codec.decode(const char *buf) -> res, new_buf
+--
+local function codec(format)
+    local encode_codec, decode_codec = codec_compile(codec_types(format))
+    local function encode(obj, ibuf)
+        if ibuf ~= nil then
+            local size = ibuf:size()
+            encode_codec(ibuf, obj)
+            return ibuf:size() - size
+        end
+        local tmpbuf = buffer.IBUF_SHARED
+        tmpbuf:reset()
+        encode_codec(tmpbuf, obj)
+        local r = ffi.string(tmpbuf.rpos, tmpbuf:size())
+        tmpbuf:recycle()
+        return r
+    end
+    local function decode(str, offset)
+        if type(str) == "string" then
+            offset = check_offset(offset, #str)
+            local buf = ffi.cast(const_char_ptr_t, str)
+            bufp[0] = buf + offset - 1
+            local r = decode_codec(bufp)
+            return r, bufp[0] - buf + 1
+        elseif ffi.istype(const_char_ptr_t, str) then
+            bufp[0] = str
+            local r = decode_codec(bufp)
+            return r, bufp[0]
+        else
+            error("codec.decode(str, offset) -> res, new_offset | "..
+                  "codec.decode(const char *buf) -> res, new_buf")
+        end
+    end
+    return {
+        field_count = #format;
+        encode = encode;
+        decode = decode;
+    }
+end
+
 --------------------------------------------------------------------------------
 -- exports
 --------------------------------------------------------------------------------
@@ -597,6 +787,7 @@ return {
     on_encode = on_encode;
     decode_unchecked = decode_unchecked;
     decode = decode_unchecked; -- just for tests
+    codec = codec;
     internal = {
         encode_fix = encode_fix;
         encode_array = encode_array;
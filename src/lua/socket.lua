@@ -56,6 +56,12 @@ ffi.cdef[[
 
     void *memmem(const void *haystack, size_t haystacklen,
         const void *needle, size_t needlelen);
+
+    struct iovec {
+        const void *iov_base;
+        size_t iov_len;
+    };
+    ssize_t writev(int fd, const struct iovec *iov, int iovcnt);
 ]]
 
 local gc_socket_t = ffi.metatype(ffi.typeof('struct gc_socket'), {
@@ -654,7 +660,10 @@ local function check_delimiter(self, limit, eols)
     return nil
 end
 
-local function read(self, limit, timeout, check, ...)
+-- Fill the read buffer until check() finds a message in it or
+-- the end of the stream is reached. Returns the length of the
+-- message at rbuf.rpos, or nil on error or timeout.
+local function read_len(self, limit, timeout, check, ...)
     assert(limit >= 0)
     limit = math.min(limit, LIMIT_INFINITY)
     local rbuf = self.rbuf
@@ -666,9 +675,7 @@ local function read(self, limit, timeout, check, ...)
     local len = check(self, limit, ...)
     if len ~= nil then
         self._errno = nil
-        local data = ffi.string(rbuf.rpos, len)
-        rbuf.rpos = rbuf.rpos + len
-        return data
+        return len
     end
 
     local deadline = fiber.clock() + timeout
@@ -680,18 +687,13 @@ local function read(self, limit, timeout, check, ...)
         local res = sysread(self, data, rbuf:unused())
         if res == 0 then -- eof
             self._errno = nil
-            local len = rbuf:size()
-            local data = ffi.string(rbuf.rpos, len)
-            rbuf.rpos = rbuf.rpos + len
-            return data
+            return rbuf:size()
         elseif res ~= nil then
             rbuf.wpos = rbuf.wpos + res
             local len = check(self, limit, ...)
             if len ~= nil then
                 self._errno = nil
-                local data = ffi.string(rbuf.rpos, len)
-                rbuf.rpos = rbuf.rpos + len
-                return data
+                return len
             end
         elseif not errno_is_transient[self._errno] then
             return nil
@@ -700,25 +702,66 @@ local function read(self, limit, timeout, check, ...)
     return nil
 end
 
-local function socket_read(self, opts, timeout)
+local function read(self, limit, timeout, check, ...)
+    local len = read_len(self, limit, timeout, check, ...)
+    if len == nil then
+        return nil
+    end
+    local rbuf = self.rbuf
+    local data = ffi.string(rbuf.rpos, len)
+    rbuf.rpos = rbuf.rpos + len
+    return data
+end
+
+-- Same as read(), but returns a pointer to the message in the
+-- read buffer and its length instead of a Lua string.
+local function read_slice(self, limit, timeout, check, ...)
+    local len = read_len(self, limit, timeout, check, ...)
+    if len == nil then
+        return nil
+    end
+    local rbuf = self.rbuf
+    local data = ffi.cast('const char *', rbuf.rpos)
+    rbuf.rpos = rbuf.rpos + len
+    return data, len
+end
+
+local function do_read(self, reader, opts, timeout, usage)
     check_socket(self)
     timeout = timeout or TIMEOUT_INFINITY
     if type(opts) == 'number' then
-        return read(self, opts, timeout, check_limit)
+        return reader(self, opts, timeout, check_limit)
     elseif type(opts) == 'string' then
-        return read(self, LIMIT_INFINITY, timeout, check_delimiter, { opts })
+        return reader(self, LIMIT_INFINITY, timeout, check_delimiter,
+                      { opts })
     elseif type(opts) == 'table' then
         local chunk = opts.chunk or opts.size or LIMIT_INFINITY
         local delimiter = opts.delimiter or opts.line
         if delimiter == nil then
-            return read(self, chunk, timeout, check_limit)
+            return reader(self, chunk, timeout, check_limit)
         elseif type(delimiter) == 'string' then
-            return read(self, chunk, timeout, check_delimiter, { delimiter })
+            return reader(self, chunk, timeout, check_delimiter,
+                          { delimiter })
         elseif type(delimiter) == 'table' then
-            return read(self, chunk, timeout, check_delimiter, delimiter)
+            return reader(self, chunk, timeout, check_delimiter, delimiter)
         end
     end
-    error('Usage: s:read(delimiter|chunk|{delimiter = x, chunk = x}, timeout)')
+    error(usage)
+end
+
+local function socket_read(self, opts, timeout)
+    return do_read(self, read, opts, timeout,
+        'Usage: s:read(delimiter|chunk|{delimiter = x, chunk = x}, timeout)')
+end
+
+-- Read a message like s:read(), but return it as
+-- const char * and its length without copying it into a Lua
+-- string. The data is only valid until the next read from the
+-- socket.
+local function socket_read_slice(self, opts, timeout)
+    return do_read(self, read_slice, opts, timeout,
+        'Usage: s:read_slice(delimiter|chunk|{delimiter = x, chunk = x}, '..
+        'timeout)')
 end
 
 local function socket_write(self, octets, timeout)
@@ -753,6 +796,65 @@ local function socket_write(self, octets, timeout)
     return nil
 end
 
+-- The number of buffers passed to one writev() call, see IOV_MAX.
+local IOV_MAX = 1024
+local iov = ffi.new('struct iovec[?]', IOV_MAX)
+
+-- Write all strings of a table with as few writev() calls as
+-- possible. Returns the number of bytes written.
+local function socket_writev(self, bufs, timeout)
+    local fd = check_socket(self)
+    if type(bufs) ~= 'table' then
+        error('Usage: s:writev({data, ...}, timeout)')
+    end
+    if timeout == nil then
+        timeout = TIMEOUT_INFINITY
+    end
+    local total = 0
+    -- Index of the first buffer not written yet and the number
+    -- of its bytes already written.
+    local first = 1
+    local offset = 0
+    local deadline = fiber.clock() + timeout
+    while first <= #bufs do
+        local cnt = 0
+        for i = first, math.min(#bufs, first + IOV_MAX - 1) do
+            local buf = bufs[i]
+            if type(buf) ~= 'string' then
+                error('Usage: s:writev({data, ...}, timeout)')
+            end
+            local skip = i == first and offset or 0
+            iov[cnt].iov_base = ffi.cast('const char *', buf) + skip
+            iov[cnt].iov_len = #buf - skip
+            cnt = cnt + 1
+        end
+        self._errno = nil
+        local written = ffi.C.writev(fd, iov, cnt)
+        if written < 0 then
+            self._errno = boxerrno()
+            if not errno_is_transient[self._errno] then
+                return nil
+            end
+            if not socket_writable(self, deadline - fiber.clock()) then
+                return nil
+            end
+        elseif written == 0 then
+            return total -- eof
+        else
+            written = tonumber(written)
+            total = total + written
+            -- Skip the buffers written completely.
+            written = written + offset
+            while first <= #bufs and written >= #bufs[first] do
+                written = written - #bufs[first]
+                first = first + 1
+            end
+            offset = written
+        end
+    end
+    return total
+end
+
 local function socket_send(self, octets, flags)
     local fd = check_socket(self)
     local iflags = get_iflags(internal.SEND_FLAGS, flags)
@@ -1215,7 +1317,9 @@ socket_mt   = {
         linger = socket_linger;
         accept = socket_accept;
         read = socket_read;
+        read_slice = socket_read_slice;
         write = socket_write;
+        writev = socket_writev;
         send = socket_send;
         recv = socket_recv;
         recvfrom = socket_recvfrom;
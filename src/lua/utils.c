@@ -630,6 +630,35 @@ luaL_tofield(struct lua_State *L, struct luaL_serializer *cfg, int index,
 #undef CHECK_NUMBER
 }
 
+int
+luaL_densearrlen(struct lua_State *L, int idx)
+{
+	if (idx < 0)
+		idx = lua_gettop(L) + idx + 1;
+	TValue *o = L->base + idx - 1;
+	if (!tvistab(o))
+		return -1;
+	GCtab *t = tabV(o);
+	if (gcref(t->metatable) != NULL || t->asize <= 1)
+		return -1;
+	/* Key 0 is stored in the array part, too. */
+	if (!tvisnil(arrayslot(t, 0)))
+		return -1;
+	Node *node = noderef(t->node);
+	for (uint32_t i = 0; i <= t->hmask; i++) {
+		if (!tvisnil(&node[i].val))
+			return -1;
+	}
+	uint32_t len = 0;
+	while (len + 1 < t->asize && !tvisnil(arrayslot(t, len + 1)))
+		len++;
+	for (uint32_t i = len + 1; i < t->asize; i++) {
+		if (!tvisnil(arrayslot(t, i)))
+			return -1;
+	}
+	return len > 0 ? (int)len : -1;
+}
+
 void
 luaL_convertfield(struct lua_State *L, struct luaL_serializer *cfg, int idx,
 		  struct luaL_field *field)
@@ -155,6 +155,19 @@ luaL_maplen(struct lua_State *L, int idx)
 	return size;
 }
 
+/**
+ * Return the number of elements of a table without a metatable
+ * that stores values only at keys 1..n, where n > 0, or -1 for
+ * any other value. Such a table is always serialized as an array
+ * of n elements, so serializers may use this function to skip
+ * luaL_tofield(), which iterates over the table with lua_next().
+ * Looks at the table layout directly, so a table built with a
+ * constructor or table.insert() is checked by one pass over its
+ * array part.
+ */
+int
+luaL_densearrlen(struct lua_State *L, int idx);
+
 /**
  * Common configuration options for Lua serializers (MsgPack, YAML, JSON)
  */
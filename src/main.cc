@@ -549,6 +549,14 @@ load_cfg()
 	if (background)
 		daemonize();
 
+	/* The writer thread wouldn't survive daemonizing. */
+	const char *log_async = cfg_gets("log_async");
+	if (log_async != NULL &&
+	    say_logger_async_start(strcmp(log_async, "block_errors") == 0)) {
+		diag_log();
+		panic("failed to start asynchronous logging");
+	}
+
 	/*
 	 * after (optional) daemonising to avoid confusing messages with
 	 * different pids
@@ -0,0 +1,126 @@
+#ifndef TARANTOOL_MP_SCAN_H_INCLUDED
+#define TARANTOOL_MP_SCAN_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <msgpuck.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Return true if the byte is a complete MsgPack value:
+ * a positive or negative fixint, nil or a boolean.
+ */
+static inline bool
+mp_byte_is_scalar(char c)
+{
+	return (int8_t)c >= -32 || c == (char)0xc0 ||
+	       c == (char)0xc2 || c == (char)0xc3;
+}
+
+/**
+ * Return the number of consecutive one-byte MsgPack values
+ * (see mp_byte_is_scalar()) at the beginning of [data, end),
+ * but not more than max. Tuples often consist of long runs of
+ * small integers, so this is done 16 bytes at a time where
+ * SSE2 is available.
+ */
+static inline uint32_t
+mp_scalar_run(const char *data, const char *end, uint32_t max)
+{
+	uint32_t run = 0;
+#if defined(__SSE2__)
+	const __m128i fixint_min = _mm_set1_epi8(-33);
+	const __m128i nil = _mm_set1_epi8((char)0xc0);
+	const __m128i bool_false = _mm_set1_epi8((char)0xc2);
+	const __m128i bool_true = _mm_set1_epi8((char)0xc3);
+	while (max - run >= 16 && end - data - run >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(data + run));
+		__m128i m = _mm_or_si128(
+			_mm_or_si128(_mm_cmpgt_epi8(v, fixint_min),
+				     _mm_cmpeq_epi8(v, nil)),
+			_mm_or_si128(_mm_cmpeq_epi8(v, bool_false),
+				     _mm_cmpeq_epi8(v, bool_true)));
+		unsigned mask = _mm_movemask_epi8(m);
+		if (mask != 0xffff)
+			return run + __builtin_ctz(~mask);
+		run += 16;
+	}
+#endif
+	while (run < max && data + run < end && mp_byte_is_scalar(data[run]))
+		run++;
+	return run;
+}
+
+/**
+ * Same as mp_check(), but skips runs of one-byte elements of
+ * a top-level array in bulk, see mp_scalar_run().
+ *
+ * @retval 0 the buffer contains a valid MsgPack value, *data
+ *         is advanced past it
+ * @retval !0 the value is invalid or truncated
+ */
+static inline int
+mp_check_fast(const char **data, const char *end)
+{
+	if (*data >= end || mp_typeof(**data) != MP_ARRAY)
+		return mp_check(data, end);
+	const char *pos = *data;
+	if (mp_check_array(pos, end) > 0)
+		return 1;
+	uint32_t count = mp_decode_array(&pos);
+	while (count > 0) {
+		uint32_t run = mp_scalar_run(pos, end, count);
+		pos += run;
+		count -= run;
+		if (count == 0)
+			break;
+		if (mp_check(&pos, end) != 0)
+			return 1;
+		count--;
+	}
+	*data = pos;
+	return 0;
+}
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_MP_SCAN_H_INCLUDED */
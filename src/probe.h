@@ -0,0 +1,95 @@
+#ifndef TARANTOOL_PROBE_H_INCLUDED
+#define TARANTOOL_PROBE_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "trivia/config.h"
+
+/**
+ * Static user-space tracepoints (USDT).
+ *
+ * Each PROBEn(name, ...) expands to a single nop instruction
+ * plus a note in the ELF file describing where the probe is and
+ * how to fetch its arguments, so a disabled probe costs next to
+ * nothing. Tools like perf, bpftrace or SystemTap attach to
+ * probes of provider "tarantool" at run time, e.g.
+ *
+ *   bpftrace -e 'usdt:./tarantool:tarantool:wal_write_start
+ *                { @start = nsecs; }'
+ *
+ * Probe arguments must be integers or pointers. When the build
+ * lacks <sys/sdt.h> the macros compile to nothing, and their
+ * arguments are not evaluated.
+ *
+ * Probes:
+ *   iproto_msg_decode(type, sync)      iproto thread, request read
+ *   iproto_reply(sync)                 iproto thread, reply queued
+ *   tx_process_start(type, sync)       tx, request processing
+ *   tx_process_done(type, sync)
+ *   wal_write_queue(n_rows, len)       tx, entry queued to WAL
+ *   wal_write_done(result)             tx, WAL write completed
+ *   wal_write_to_disk_start(len)       WAL thread, batch write
+ *   wal_write_to_disk_done(bytes)
+ *   xlog_fsync_start(fd)               fsync/fdatasync of xlogs
+ *   xlog_fsync_done(fd, rc)
+ *   vy_page_read_start(run, offset, size)
+ *   vy_page_decompress_start(run, unpacked_size)
+ *   vy_page_read_done(run, offset)
+ *   vy_task_start(is_dump, space_id, index_id)
+ *   vy_task_done(is_dump, space_id, index_id, is_failed)
+ *   fiber_switch(caller_fid, callee_fid)
+ */
+#if defined(ENABLE_DTRACE)
+#include <sys/sdt.h>
+
+#define PROBE0(name) DTRACE_PROBE(tarantool, name)
+#define PROBE1(name, a1) DTRACE_PROBE1(tarantool, name, a1)
+#define PROBE2(name, a1, a2) DTRACE_PROBE2(tarantool, name, a1, a2)
+#define PROBE3(name, a1, a2, a3) \
+	DTRACE_PROBE3(tarantool, name, a1, a2, a3)
+#define PROBE4(name, a1, a2, a3, a4) \
+	DTRACE_PROBE4(tarantool, name, a1, a2, a3, a4)
+
+#else /* !defined(ENABLE_DTRACE) */
+
+#define PROBE0(name) do {} while (0)
+#define PROBE1(name, a1) do { (void)sizeof(a1); } while (0)
+#define PROBE2(name, a1, a2) \
+	do { (void)sizeof(a1); (void)sizeof(a2); } while (0)
+#define PROBE3(name, a1, a2, a3) \
+	do { (void)sizeof(a1); (void)sizeof(a2); (void)sizeof(a3); } while (0)
+#define PROBE4(name, a1, a2, a3, a4) \
+	do { (void)sizeof(a1); (void)sizeof(a2); (void)sizeof(a3); \
+	     (void)sizeof(a4); } while (0)
+
+#endif /* !defined(ENABLE_DTRACE) */
+
+#endif /* TARANTOOL_PROBE_H_INCLUDED */
@@ -76,6 +76,13 @@ say_format_syslog(struct log *log, char *buf, int len, int level,
 		  const char *filename, int line, const char *error,
 		  const char *format, va_list ap);
 
+static void
+log_writer_push(struct log_writer *writer, int level,
+		const char *data, int len);
+
+static void
+log_writer_stop(struct log *log);
+
 /** A utility function to handle va_list from different varargs functions. */
 static inline int
 log_vsay(struct log *log, int level, const char *filename, int line,
@@ -607,6 +614,7 @@ log_create(struct log *log, const char *init_str, int nonblock)
 	log->format_func = NULL;
 	log->level = S_INFO;
 	log->rotating_threads = 0;
+	log->writer = NULL;
 	fiber_cond_create(&log->rotate_cond);
 	ev_async_init(&log->log_async, log_rotate_async_cb);
 	setvbuf(stderr, NULL, _IONBF, 0);
@@ -709,6 +717,211 @@ say_logger_free()
 		log_destroy(&log_std);
 }
 
+/** {{{ Background writer */
+
+enum {
+	/** Size of the ring of messages waiting to be written. */
+	SAY_WRITER_RING_SIZE = 1024 * 1024,
+	/** Max amount of data the writer thread writes at once. */
+	SAY_WRITER_CHUNK_SIZE = 64 * 1024,
+};
+
+/**
+ * A thread writing log messages queued by other threads.
+ * The queue is a byte ring, so that a message costs one
+ * memcpy for the logging thread. When the ring is full,
+ * messages are dropped and the writer reports the number
+ * of dropped messages once it catches up.
+ */
+struct log_writer {
+	/** Log the messages are written to. */
+	struct log *log;
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	/** Signaled when a message is queued or on stop. */
+	pthread_cond_t has_data;
+	/** Signaled when the writer frees space in the ring. */
+	pthread_cond_t has_space;
+	/**
+	 * Ring positions: data is read at @head and appended
+	 * at @tail. Both grow monotonically and are taken
+	 * modulo the ring size on access.
+	 */
+	size_t head;
+	size_t tail;
+	/** Number of messages dropped because the ring was full. */
+	uint64_t dropped;
+	/** Value of @dropped last reported to the log. */
+	uint64_t dropped_reported;
+	/** Make error messages wait for space instead of dropping. */
+	bool block_errors;
+	/** Set when the writer thread is asked to drain and exit. */
+	bool is_stopping;
+	char ring[SAY_WRITER_RING_SIZE];
+	char chunk[SAY_WRITER_CHUNK_SIZE];
+};
+
+static void
+log_writer_push(struct log_writer *writer, int level,
+		const char *data, int len)
+{
+	assert(len >= 0 && len < SAY_WRITER_RING_SIZE);
+	tt_pthread_mutex_lock(&writer->mutex);
+	bool block = writer->block_errors && level <= S_ERROR;
+	while (writer->tail - writer->head + len > SAY_WRITER_RING_SIZE) {
+		if (!block || writer->is_stopping) {
+			writer->dropped++;
+			tt_pthread_mutex_unlock(&writer->mutex);
+			return;
+		}
+		tt_pthread_cond_wait(&writer->has_space, &writer->mutex);
+	}
+	size_t pos = writer->tail % SAY_WRITER_RING_SIZE;
+	size_t part = MIN((size_t)len, SAY_WRITER_RING_SIZE - pos);
+	memcpy(writer->ring + pos, data, part);
+	memcpy(writer->ring, data + part, len - part);
+	if (writer->head == writer->tail)
+		tt_pthread_cond_signal(&writer->has_data);
+	writer->tail += len;
+	tt_pthread_mutex_unlock(&writer->mutex);
+}
+
+/** Write the whole buffer, giving up on error. */
+static void
+log_writer_write(int fd, const char *data, size_t len)
+{
+	while (len > 0) {
+		ssize_t r = write(fd, data, len);
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			/* Nothing to report the error to. */
+			return;
+		}
+		data += r;
+		len -= r;
+	}
+}
+
+static void *
+log_writer_f(void *arg)
+{
+	struct log_writer *writer = (struct log_writer *)arg;
+	tt_pthread_mutex_lock(&writer->mutex);
+	while (true) {
+		while (writer->head == writer->tail && !writer->is_stopping)
+			tt_pthread_cond_wait(&writer->has_data,
+					     &writer->mutex);
+		if (writer->head == writer->tail)
+			break;
+		size_t len = MIN(writer->tail - writer->head,
+				 (size_t)SAY_WRITER_CHUNK_SIZE);
+		size_t pos = writer->head % SAY_WRITER_RING_SIZE;
+		size_t part = MIN(len, SAY_WRITER_RING_SIZE - pos);
+		memcpy(writer->chunk, writer->ring + pos, part);
+		memcpy(writer->chunk + part, writer->ring, len - part);
+		writer->head += len;
+		uint64_t dropped = writer->dropped - writer->dropped_reported;
+		writer->dropped_reported = writer->dropped;
+		tt_pthread_cond_broadcast(&writer->has_space);
+		tt_pthread_mutex_unlock(&writer->mutex);
+
+		int fd = writer->log->fd;
+		log_writer_write(fd, writer->chunk, len);
+		if (dropped > 0) {
+			char msg[64];
+			int n = snprintf(msg, sizeof(msg),
+					 "%llu log messages were dropped\n",
+					 (unsigned long long)dropped);
+			log_writer_write(fd, msg, n);
+		}
+		tt_pthread_mutex_lock(&writer->mutex);
+	}
+	tt_pthread_mutex_unlock(&writer->mutex);
+	return NULL;
+}
+
+int
+say_logger_async_start(bool block_errors)
+{
+	struct log *log = log_default;
+	if (log->type != SAY_LOGGER_FILE && log->type != SAY_LOGGER_PIPE) {
+		diag_set(IllegalParams, "asynchronous logging is supported "
+			 "only by file and pipe loggers");
+		return -1;
+	}
+	assert(log->writer == NULL);
+	struct log_writer *writer = calloc(1, sizeof(*writer));
+	if (writer == NULL) {
+		diag_set(OutOfMemory, sizeof(*writer), "calloc",
+			 "struct log_writer");
+		return -1;
+	}
+	writer->log = log;
+	writer->block_errors = block_errors;
+	tt_pthread_mutex_init(&writer->mutex, NULL);
+	tt_pthread_cond_init(&writer->has_data, NULL);
+	tt_pthread_cond_init(&writer->has_space, NULL);
+	int rc = pthread_create(&writer->thread, NULL, log_writer_f, writer);
+	if (rc != 0) {
+		tt_pthread_cond_destroy(&writer->has_space);
+		tt_pthread_cond_destroy(&writer->has_data);
+		tt_pthread_mutex_destroy(&writer->mutex);
+		free(writer);
+		errno = rc;
+		diag_set(SystemError, "failed to start log writer thread");
+		return -1;
+	}
+	log->writer = writer;
+	atexit(say_logger_async_atexit);
+	return 0;
+}
+
+/** Write out all queued messages and wait for the writer thread. */
+static void
+log_writer_join(struct log_writer *writer)
+{
+	tt_pthread_mutex_lock(&writer->mutex);
+	if (writer->is_stopping) {
+		tt_pthread_mutex_unlock(&writer->mutex);
+		return;
+	}
+	writer->is_stopping = true;
+	tt_pthread_cond_signal(&writer->has_data);
+	/* Wake up error messages waiting for space. */
+	tt_pthread_cond_broadcast(&writer->has_space);
+	tt_pthread_mutex_unlock(&writer->mutex);
+	tt_pthread_join(writer->thread, NULL);
+}
+
+/**
+ * Flush the default logger on exit() bypassing tarantool_free().
+ * The writer isn't freed, since other threads may still log:
+ * their messages are dropped.
+ */
+static void
+say_logger_async_atexit(void)
+{
+	if (log_default->writer != NULL)
+		log_writer_join(log_default->writer);
+}
+
+static void
+log_writer_stop(struct log *log)
+{
+	struct log_writer *writer = log->writer;
+	if (writer == NULL)
+		return;
+	log_writer_join(writer);
+	log->writer = NULL;
+	tt_pthread_cond_destroy(&writer->has_space);
+	tt_pthread_cond_destroy(&writer->has_data);
+	tt_pthread_mutex_destroy(&writer->mutex);
+	free(writer);
+}
+
+/** Background writer }}} */
+
 /** {{{ Formatters */
 
 /**
@@ -1171,6 +1384,7 @@ log_destroy(struct log *log)
 	assert(log != NULL);
 	while(log->rotating_threads > 0)
 		fiber_cond_wait(&log->rotate_cond);
+	log_writer_stop(log);
 	pm_atomic_store(&log->type, SAY_LOGGER_BOOT);
 
 	if (log->fd != -1)
@@ -1192,6 +1406,11 @@ log_vsay(struct log *log, int level, const char *filename, int line,
 	}
 	int total = log->format_func(log, buf, sizeof(buf), level,
 				     filename, line, error, format, ap);
+	if (log->writer != NULL && level != S_FATAL) {
+		log_writer_push(log->writer, level, buf, total);
+		errno = errsv; /* Preserve the errno. */
+		return total;
+	}
 	switch (log->type) {
 	case SAY_LOGGER_FILE:
 	case SAY_LOGGER_PIPE:
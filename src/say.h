@@ -174,6 +174,11 @@ struct log {
 	int rotating_threads;
 	enum syslog_facility syslog_facility;
 	struct rlist in_log_list;
+	/**
+	 * Background writer the messages are passed to,
+	 * NULL if messages are written synchronously.
+	 */
+	struct log_writer *writer;
 };
 
 /**
@@ -252,6 +257,20 @@ say_logger_init(const char *init_str,
 		const char *log_format,
 		int background);
 
+/**
+ * Make the default logger hand formatted messages over to
+ * a background thread instead of writing them in the caller.
+ * Only file and pipe loggers are supported. Must be called
+ * after daemonizing, since the thread does not survive fork.
+ *
+ * @param block_errors if set, messages of S_ERROR level
+ *        and more severe wait for space in the writer ring,
+ *        otherwise they are dropped like other messages.
+ * @retval 0 on success, -1 on error (diag is set).
+ */
+int
+say_logger_async_start(bool block_errors);
+
 /** Free default logger */
 void
 say_logger_free();
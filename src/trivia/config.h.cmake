@@ -101,6 +101,14 @@
  * Defined if this platform has GNU specific memrchr().
  */
 #cmakedefine HAVE_MEMRCHR 1
+/*
+ * Defined if this platform has Linux io_uring system calls.
+ */
+#cmakedefine HAVE_IO_URING 1
+/*
+ * Defined if USDT probes are compiled in, see probe.h.
+ */
+#cmakedefine ENABLE_DTRACE 1
 /*
  * Defined if this platform has sendfile(..).
  */
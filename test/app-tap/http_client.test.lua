@@ -190,6 +190,37 @@ local function test_post_and_get(test, url, opts)
         "stats checking")
 end
 
+local function test_connection_reuse(test, url, opts)
+    test:plan(3)
+    local http = client:new()
+    for i = 1, 3 do
+        http:get(url, opts)
+    end
+    local st = http:stat()
+    test:is(st.connections_opened, 1, "connection is opened once")
+    test:is(st.connections_reused, 2, "connection is reused")
+    test:is(st.tls_handshakes, 0, "no TLS handshakes")
+end
+
+local function test_chunked(test, url, opts)
+    test:plan(4)
+    local http = client:new()
+    local r = http:get(url, merge(opts, {chunked = true}))
+    test:is(r.status, 200, "chunked: status")
+    test:isnil(r.body, "chunked: body is not buffered")
+    local chunks = {}
+    while true do
+        local chunk = r:read(4)
+        if chunk == '' then
+            break
+        end
+        table.insert(chunks, chunk)
+    end
+    r:close()
+    test:is(table.concat(chunks), "hello world", "chunked: body")
+    test:is(http:stat().active_requests, 0, "chunked: no active requests")
+end
+
 local function test_errors(test)
     test:plan(3)
     local http = client:new()
@@ -416,11 +447,13 @@ local function test_concurrent(test, url, opts)
 end
 
 function run_tests(test, sock_family, sock_addr)
-    test:plan(9)
+    test:plan(11)
     local server, url, opts = start_server(test, sock_family, sock_addr)
     test:test("http.client", test_http_client, url, opts)
     test:test("cancel and errinj", test_cancel_and_errinj, url .. 'long_query', opts)
     test:test("basic http post/get", test_post_and_get, url, opts)
+    test:test("connection reuse", test_connection_reuse, url, opts)
+    test:test("chunked", test_chunked, url, opts)
     test:test("errors", test_errors)
     test:test("headers", test_headers, url, opts)
     test:test("special methods", test_special_methods, url, opts)
@@ -22,7 +22,7 @@ end
 
 tap.test("json", function(test)
     local serializer = require('json')
-    test:plan(28)
+    test:plan(30)
 
     test:test("unsigned", common.test_unsigned, serializer)
     test:test("signed", common.test_signed, serializer)
@@ -100,4 +100,25 @@ tap.test("json", function(test)
     test:is(serializer.decode('{"var":2.0e+3}')["var"], 2000)
     test:is(serializer.decode('{"var":2.0e+3}')["var"], 2000)
     test:is(serializer.decode('{"var":2.0e+3}')["var"], 2000)
+
+    --
+    -- Long strings are scanned in chunks, check escapes at any
+    -- position inside and across them.
+    --
+    local escapes = {['"'] = '\\"', ['\\'] = '\\\\', ['/'] = '\\/',
+                     ['\n'] = '\\n', ['\0'] = '\\u0000', ['\127'] = '\\u007f'}
+    local ok = true
+    for i = 1, 40 do
+        for c, esc in pairs(escapes) do
+            local a, b = string.rep('a', i), string.rep('b', 40 - i)
+            local enc = serializer.encode(a .. c .. b)
+            if enc ~= '"' .. a .. esc .. b .. '"' or
+               serializer.decode(enc) ~= a .. c .. b then
+                ok = false
+            end
+        end
+    end
+    test:ok(ok, 'escapes in long strings')
+    test:is(serializer.decode('"' .. string.rep('x', 100) .. '\\u0041"'),
+            string.rep('x', 100) .. 'A', 'unicode escape after a long run')
 end)
@@ -0,0 +1,70 @@
+#!/usr/bin/env tarantool
+
+local tap = require('tap')
+local fio = require('fio')
+
+--
+-- The Lua heap allocator is picked by TARANTOOL_LUA_ALLOC before
+-- the script runs, so check it in a child instance.
+--
+local test = tap.test('lua_alloc')
+test:plan(3)
+
+local tarantool_bin = arg[-1]
+local UNSUPPORTED = 2
+
+local function run_script(alloc, code)
+    local dir = fio.tempdir()
+    local script_path = fio.pathjoin(dir, 'script.lua')
+    local script = fio.open(script_path, {'O_CREAT', 'O_WRONLY'},
+        tonumber('0777', 8))
+    script:write(code)
+    script:close()
+    local cmd = [[/bin/sh -c 'cd "%s" && TARANTOOL_LUA_ALLOC=%s "%s" ./script.lua 2> /dev/null']]
+    local res = os.execute(string.format(cmd, dir, alloc, tarantool_bin))
+    fio.rmtree(dir)
+    return res / 256
+end
+
+local code = [[
+local fiber = require('fiber')
+local info = box.runtime.info()
+if info.lua_alloc == nil then
+    os.exit(2)
+end
+if info.lua_alloc.used <= 0 or info.lua_alloc.total < info.lua_alloc.used then
+    os.exit(1)
+end
+local cond = fiber.cond()
+local data = {}
+local f = fiber.new(function()
+    for i = 1, 10000 do data[i] = {i} end
+    cond:wait()
+end)
+fiber.yield()
+local mem = fiber.info()[f:id()].memory
+cond:signal()
+if mem.lua == nil or mem.lua < 10000 * 16 then
+    os.exit(3)
+end
+if box.runtime.info().lua_alloc.used <= info.lua_alloc.used then
+    os.exit(4)
+end
+os.exit(0)
+]]
+
+test:is(run_script('system', code), UNSUPPORTED,
+        'no lua_alloc with the system allocator')
+
+local res = run_script('small', code)
+if res == UNSUPPORTED then
+    -- LuaJIT doesn't accept custom allocators on this build.
+    test:skip('lua_alloc with the small allocator')
+    test:skip('fiber lua memory with the small allocator')
+else
+    test:ok(res ~= 1 and res ~= UNSUPPORTED,
+            'lua_alloc with the small allocator')
+    test:is(res, 0, 'fiber lua memory with the small allocator')
+end
+
+os.exit(test:check() and 0 or 1)
@@ -3,6 +3,8 @@
 package.path = "lua/?.lua;"..package.path
 
 local tap = require('tap')
+local ffi = require('ffi')
+local buffer = require('buffer')
 local common = require('serializer_test')
 
 local function is_map(s)
@@ -70,9 +72,43 @@ local function test_other(test, s)
     test:is(#s.encode(-0x80000001), 9, "len(encode(-0x80000001))")
 end
 
+local function test_codec(test, s)
+    test:plan(11)
+    local codec = s.codec({'unsigned', 'string', {name = 'f', type = 'number'},
+                           'boolean', 'any'})
+    test:is(codec.field_count, 5, "field count")
+    local record = {1, 'abc', 1.5, true, {1, 2}}
+    local data = codec.encode(record)
+    test:is(data, s.encode(record), "encode like the generic encoder")
+    test:is_deeply(codec.decode(data), record, "decode")
+    local _, offset = codec.decode(data..data, #data + 1)
+    test:is(offset, #data * 2 + 1, "decode offset")
+    -- Values of unexpected types are encoded generically.
+    record = {-1, 10, 'str', false, nil}
+    data = codec.encode(record)
+    test:is(data, s.encode({-1, 10, 'str', false, s.NULL}),
+            "encode unexpected types")
+    test:is_deeply(codec.decode(data), {-1, 10, 'str', false, s.NULL},
+                   "decode unexpected types")
+    -- Data of another shape is decoded generically.
+    test:is_deeply(codec.decode(s.encode({1, 2})), {1, 2},
+                   "decode another shape")
+    local buf = buffer.ibuf()
+    test:is(codec.encode({1, 'a', 2, true, 'x'}, buf), 8, "encode to ibuf")
+    test:is_deeply(codec.decode(ffi.cast('const char *', buf.rpos)),
+                   {1, 'a', 2, true, 'x'}, "decode from buffer")
+    -- Longer records have 16-bit array size.
+    local types, long = {}, {}
+    for i = 1, 20 do types[i] = 'unsigned' long[i] = i * 100 end
+    local long_codec = s.codec(types)
+    test:is_deeply(long_codec.decode(long_codec.encode(long)), long,
+                   "long record")
+    test:ok(not pcall(s.codec, 'unsigned'), "invalid format")
+end
+
 tap.test("msgpackffi", function(test)
     local serializer = require('msgpackffi')
-    test:plan(9)
+    test:plan(10)
     test:test("unsigned", common.test_unsigned, serializer)
     test:test("signed", common.test_signed, serializer)
     test:test("double", common.test_double, serializer)
@@ -84,4 +120,5 @@ tap.test("msgpackffi", function(test)
     --test:test("ucdata", common.test_ucdata, serializer)
     test:test("offsets", test_offsets, serializer)
     test:test("other", test_other, serializer)
+    test:test("codec", test_codec, serializer)
 end)
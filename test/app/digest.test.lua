@@ -203,3 +203,18 @@ _ = fiber.create(test_pbkdf2)
 _ = sentry:get()
 _ = sentry:get()
 res
+
+-- xxh3 and batch hashing
+digest.xxh3('')
+digest.xxh3('hello')
+digest.xxh3('hello', 42)
+digest.xxh3(string.rep('a', 1000))
+digest.xxh3(nil)
+digest.xxh3_batch({'', 'hello'})
+digest.xxh3_batch({'hello'}, 42)[1] == digest.xxh3('hello', 42)
+digest.murmur_batch({'1234', 1234})
+mur = digest.murmur.new{seed=14}
+mur:update('1234')
+digest.murmur_batch({'1234'}, 14)[1] == mur:result()
+digest.murmur_batch({'1234', {}})
+digest.guava_batch({10863919174838991, 2016238256797177309, 1673758223894951030}, 11)
@@ -631,3 +631,48 @@ con = require('net.box').connect(box.cfg.listen)
 pcall(con.eval, con, 'fiber.cancel(fiber.self())')
 con:eval('fiber.sleep(0) return "Ok"')
 box.schema.user.revoke('guest', 'execute', 'universe')
+
+-- fiber profiler
+fiber.top_enable()
+ch = fiber.channel(1)
+cond = fiber.cond()
+test_run:cmd("setopt delimiter ';'")
+function waiter()
+    fiber.self():name('prof_waiter')
+    ch:get()
+    cond:wait()
+    fiber.sleep(1000)
+end;
+test_run:cmd("setopt delimiter ''");
+f = fiber.create(waiter)
+fiber.sleep(0.01)
+ch:put(true)
+fiber.sleep(0.01)
+cond:signal()
+fiber.sleep(0)
+w = nil
+for _, t in ipairs(fiber.top()) do if t.name == 'prof_waiter' then w = t end end
+w.wait.channel > 0.005, w.wait.cond > 0.005, w.wait.sleep == 0
+w.cpu_share >= 0 and w.cpu_share <= 100
+#fiber.top(1)
+top = fiber.top()
+top[1].cpu >= top[#top].cpu
+fiber.top(0)
+f:cancel()
+fiber.top_disable()
+fiber.top_reset()
+fiber.top()[1].cpu
+
+test_run:cmd("setopt delimiter ';'")
+function spin()
+    fiber.self():name('prof_spin')
+    local deadline = require('clock').monotonic() + 0.1
+    while require('clock').monotonic() < deadline do end
+end;
+test_run:cmd("setopt delimiter ''");
+fiber.profile_start({interval = 1})
+f = fiber.new(spin)
+f:set_joinable(true)
+f:join()
+fiber.profile_stop()
+fiber.profile_dump():find('prof_spin') ~= nil
@@ -210,3 +210,32 @@ refs
 ch:close()
 collectgarbage('collect')
 refs -- must be zero
+
+-- put_many/get_many
+ch = fiber.channel(4)
+ch:put_many({1, 'a', true, {2}, 3})
+ch:count()
+ch:get_many(10)
+ch:get_many(10, 0)
+ch:put_many({})
+ch:get_many(0)
+ch:put_many(1)
+ch:put_many({1, 2, 3}), ch:get_many(2), ch:get_many(2)
+-- a blocked reader takes a whole batch with one wakeup
+batch = nil
+f = fiber.create(function() batch = ch:get_many(3) end)
+ch:has_readers()
+ch:put_many({4, 5, 6, 7})
+fiber.sleep(0)
+batch
+ch:get()
+-- unbuffered channel
+ch = fiber.channel()
+f = fiber.create(function() batch = ch:get_many(10) end)
+ch:put_many({8, 9})
+fiber.sleep(0)
+batch
+ch:put_many({10}, 0)
+ch:close()
+ch:put_many({1})
+ch:get_many(1)
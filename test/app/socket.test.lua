@@ -972,4 +972,27 @@ fiber.cancel(echo_fiber)
 client:read(1, 0.1) == ''
 server:close()
 
+-- s:read_slice() returns messages without making Lua strings,
+-- s:writev() writes a table of strings at once.
+test_run:cmd("setopt delimiter ';'")
+server = socket.tcp_server('localhost', 0, { handler = function(s)
+    while true do
+        local data, len = s:read_slice('\n')
+        if data == nil or len == 0 then
+            break
+        end
+        s:writev({'got ', ffi.string(data, len)})
+    end
+end, name = 'sliceserv'});
+test_run:cmd("setopt delimiter ''");
+addr = server:name()
+client = socket.tcp_connect(addr.host, addr.port)
+client:writev({'hello', ' ', 'world\n', '', 'bye\n'})
+client:read('\n', 1) == 'got hello world\n'
+ffi.string(client:read_slice('\n', 1)) == 'got bye\n'
+client:writev({})
+(pcall(client.writev, client, 'x'))
+client:close()
+server:close()
+
 test_run:cmd("clear filter")
@@ -6,7 +6,7 @@ local socket = require('socket')
 local fio = require('fio')
 local uuid = require('uuid')
 local msgpack = require('msgpack')
-test:plan(102)
+test:plan(106)
 
 --------------------------------------------------------------------------------
 -- Invalid values
@@ -59,6 +59,9 @@ end
 invalid_combinations("log, log_nonblock", {log = "1.log", log_nonblock = true})
 invalid_combinations("log, log_format", {log = "syslog:identity=tarantool", log_format = 'json'})
 invalid_combinations("log, log_nonblock", {log_nonblock = true})
+invalid_combinations("log, log_async", {log = "1.log", log_async = 'xxx'})
+invalid_combinations("log, log_async", {log = "syslog:identity=tarantool", log_async = 'drop'})
+invalid_combinations("log, log_async", {log_async = 'drop'})
 
 test:is(type(box.cfg), 'function', 'box is not started')
 
@@ -566,5 +569,17 @@ os.exit(0)
 ]]
 test:is(run_script(code), 0, "log_nonblock")
 
+--
+-- Asynchronous logging with a background writer thread
+--
+code=[[
+local log = require('log')
+box.cfg{log = 'tarantool.log', log_async = 'block_errors'}
+for i = 1, 10000 do log.info(string.rep('x', 1000)) end
+for i = 1, 100 do log.error('error') end
+os.exit(0)
+]]
+test:is(run_script(code), 0, "log_async")
+
 test:check()
 os.exit(0)
@@ -0,0 +1,44 @@
+#!/usr/bin/env tarantool
+local tap = require('tap')
+local csv = require('csv')
+
+box.cfg{}
+
+local test = tap.test('csv.load_space')
+test:plan(8)
+
+local s = box.schema.space.create('csv_load')
+s:create_index('pk', {parts = {1, 'unsigned'}})
+
+local data = 'id,name,value\n' ..
+             '1,"Smith, John",1.5\n' ..
+             '2,  Doe  ,\n' ..
+             '3,"quoted ""name""",42\n'
+local function reader(str)
+    return {pos = 1, read = function(self, bytes)
+        local chunk = str:sub(self.pos, self.pos + bytes - 1)
+        self.pos = self.pos + bytes
+        return chunk
+    end}
+end
+
+local opts = {skip_head_lines = 1, types = {'integer', 'string', 'number'},
+              chunk_size = 7, batch_size = 2}
+test:is(csv.load_space(reader(data), s, opts), 3, "row count")
+test:is_deeply({s:get(1):unpack()}, {1, 'Smith, John', 1.5}, "quoted field")
+test:ok(s:get(2)[2] == 'Doe' and s:get(2)[3] == nil, "empty number is nil")
+
+local ok = pcall(csv.load_space, '4,a\n1,b\n', s, {types = {'integer'}})
+test:ok(not ok, "duplicate key")
+test:is(s:count(), 3, "failed batch is not applied")
+
+opts = {types = {'integer'}, replace = true}
+test:is(csv.load_space('1,x\n5,y', s, opts), 2, "replace")
+test:ok(s:get(1)[2] == 'x' and s:get(3)[2] == 'quoted "name"' and
+        s:get(5)[2] == 'y', "replaced tuples")
+
+ok = pcall(csv.load_space, 'abc\n', s, {types = {'integer'}})
+test:ok(not ok, "invalid integer")
+
+s:drop()
+test:check()
@@ -131,5 +131,23 @@ box.schema.func.drop('f2')
 --
 box.session.su('admin', box.session.user)
 box.session.su('admin', box.session.user())
+--
+-- Cached function access is invalidated by privilege and
+-- function changes.
+--
+function f3() return 3 end
+box.schema.func.create('f3')
+box.schema.user.grant('guest', 'execute', 'function', 'f3')
+c = net.connect(box.cfg.listen)
+c:call('f3')
+c:call('f3')
+box.schema.user.revoke('guest', 'execute', 'function', 'f3')
+c:call('f3')
+box.schema.user.grant('guest', 'execute', 'function', 'f3')
+c:call('f3')
+box.schema.func.drop('f3')
+c:call('f3')
+c:close()
+
 -- cleanup
 box.session.su('admin')
@@ -0,0 +1,72 @@
+fio = require('fio')
+test_run = require('test_run').new()
+
+-- Argument checks.
+box.backup.stream()
+box.backup.stream('backup.tar', {checkpoint_idx = -1})
+box.backup.stream('backup.tar', {rate_limit = -1})
+box.backup.stream('backup.tar', {checkpoint_idx = 100})
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 10 do s:replace{i} end
+box.snapshot()
+for i = 11, 20 do s:replace{i} end
+
+BACKUP = fio.pathjoin(fio.cwd(), 'backup.tar')
+BACKUP_DIR = fio.pathjoin(fio.cwd(), 'backup')
+
+_ = test_run:cmd("setopt delimiter ';'")
+-- Check that the archive contains the given files intact.
+function check_backup(files)
+    os.execute(string.format('rm -rf %s && mkdir -p %s && tar -xf %s -C %s',
+                             BACKUP_DIR, BACKUP_DIR, BACKUP, BACKUP_DIR))
+    for _, path in ipairs(files) do
+        local copy = fio.pathjoin(BACKUP_DIR, path)
+        local f1, f2 = fio.open(path), fio.open(copy)
+        if f1 == nil or f2 == nil then
+            return false
+        end
+        local size = f2:stat().size
+        local ok = f1:read(size) == f2:read(size)
+        f1:close()
+        f2:close()
+        if not ok then
+            return false
+        end
+    end
+    return true
+end;
+function count_files(files, suffix)
+    local count = 0
+    for _, path in ipairs(files) do
+        if string.match(path, '%.' .. suffix .. '$') then
+            count = count + 1
+        end
+    end
+    return count
+end;
+_ = test_run:cmd("setopt delimiter ''");
+
+-- Full backup: the last checkpoint and the WALs written since.
+files = box.backup.stream(BACKUP, {rate_limit = 100 * 1024 * 1024})
+count_files(files, 'snap')
+count_files(files, 'xlog') > 0
+check_backup(files)
+
+-- Incremental backup: only the WALs written since the vclock.
+vclock = box.info.vclock
+box.snapshot()
+for i = 21, 30 do s:replace{i} end
+files = box.backup.stream(BACKUP, {since = vclock})
+count_files(files, 'snap')
+count_files(files, 'xlog') > 0
+check_backup(files)
+
+-- A full backup can't be streamed while another one is in progress.
+box.backup.start() ~= nil
+box.backup.stream(BACKUP)
+box.backup.stop()
+
+s:drop()
+os.execute(string.format('rm -rf %s %s', BACKUP_DIR, BACKUP))
@@ -147,3 +147,29 @@ for j=1,100 do check(math.random(9) - 1, {iterator = box.index.BITS_ALL_NOT_SET}
 good
 s:drop()
 s = nil
+
+-- Sparse BITSET index stores pages with few bits set as arrays.
+s = box.schema.space.create('test')
+_ = s:create_index('primary', { type = 'tree', parts = {1, 'unsigned'} })
+dense = s:create_index('dense', { type = 'bitset', parts = {2, 'unsigned'}, unique = false })
+sparse = s:create_index('sparse', { type = 'bitset', parts = {2, 'unsigned'}, unique = false, sparse = true })
+sparse.sparse
+dense.sparse
+for i = 1, 10000 do s:insert{i, bit.lshift(1ULL, i % 64) + i % 3} end
+sparse:bsize() < dense:bsize()
+good = true
+function is_good(key, opts) return #sparse:select({key}, opts) == #dense:select({key}, opts) and sparse:count({key}, opts) == dense:count({key}, opts) end
+function check(key, opts) good = good and is_good(key, opts) end
+for j = 0, 63 do check(bit.lshift(1ULL, j) + 1, {iterator = box.index.BITS_ANY_SET}) end
+for j = 0, 63 do check(bit.lshift(1ULL, j) + 2, {iterator = box.index.BITS_ALL_SET}) end
+for j = 0, 63 do check(bit.lshift(1ULL, j), {iterator = box.index.BITS_ALL_NOT_SET}) end
+good
+for i = 1, 10000, 2 do s:delete{i} end
+good = true
+for j = 0, 63 do check(bit.lshift(1ULL, j) + 1, {iterator = box.index.BITS_ANY_SET}) end
+good
+sparse:alter({sparse = false})
+sparse.sparse
+sparse:count(1, {iterator = box.index.BITS_ALL_SET}) == dense:count(1, {iterator = box.index.BITS_ALL_SET})
+s:drop()
+s = nil
@@ -26,6 +26,7 @@ box.cfg{replication = {}}
 box.cfg{memtx_memory = "100500"}
 box.cfg{memtx_memory = -1}
 box.cfg{vinyl_memory = -1}
+box.cfg{vinyl_read_latency_budget = -1}
 box.cfg{vinyl = "vinyl"}
 box.cfg{vinyl_write_threads = "threads"}
 
@@ -131,6 +132,17 @@ box.cfg{net_msg_max = 2}
 box.cfg{net_msg_max = old + 1000}
 box.cfg{net_msg_max = old}
 
+--
+-- iproto_threads can be set only at startup.
+--
+box.cfg{iproto_threads = 2}
+
+--
+-- Thread and memory placement can be set only at startup.
+--
+box.cfg{thread_affinity = 'tx:0'}
+box.cfg{memtx_numa_policy = 'interleave'}
+
 --
 -- gh-3266: box.cfg{} still not optional on 2.0 brach
 --
@@ -270,3 +270,47 @@ box.rollback()
 
 _ = c:get()
 test_latch:drop() -- this is where everything stops
+
+--
+-- Building a memtx index yields, and the space may be changed
+-- meanwhile.
+--
+s = box.schema.space.create('test_online')
+_ = s:create_index('pk')
+for i = 1, 5000 do s:replace{i, i} end
+ch = fiber.channel(1)
+_ = fiber.create(function() s:create_index('sk', {parts = {2, 'unsigned'}}) ch:put(true) end)
+s:replace{1, 10001}
+s:delete{2}
+s:replace{4999, 20000}
+s:delete{4998}
+s:insert{6000, 6000}
+box.begin() s:replace{3, 30000} box.rollback()
+ch:get()
+s.index.sk:count()
+s.index.sk:select{10001}
+s.index.sk:select{20000}
+s.index.sk:select{30000}
+s.index.sk:select{3}
+s.index.sk:select{6000}
+test_run:cmd("setopt delimiter ';'")
+function check_index(idx)
+    for _, t in s:pairs() do
+        if idx:get{t[2]} ~= t then
+            return t
+        end
+    end
+    return idx:count() == s:count()
+end;
+test_run:cmd("setopt delimiter ''");
+check_index(s.index.sk)
+bsize = 0
+for _, t in s:pairs() do bsize = bsize + t:bsize() end
+s:bsize() == bsize
+s.index.sk:drop()
+-- A concurrent change violating uniqueness fails the build.
+_ = fiber.create(function() ch:put({pcall(s.create_index, s, 'sk', {parts = {2, 'unsigned'}})}) end)
+s:replace{1, 5}
+ch:get()
+s.index.sk
+s:drop()
@@ -0,0 +1,35 @@
+net = require('net.box')
+
+box.cfg{eval_cache_size = -1}
+
+box.schema.user.grant('guest', 'execute', 'universe')
+c = net.connect(box.cfg.listen)
+
+--
+-- A cached expression sees the current values of globals and
+-- gets its own arguments on every call.
+--
+function eval_f(x) return x * 2 end
+c:eval('return eval_f(...)', {1})
+c:eval('return eval_f(...)', {2})
+function eval_f(x) return x * 3 end
+c:eval('return eval_f(...)', {2})
+c:eval('local a, b = ... return a + b', {1, 2})
+c:eval('local a, b = ... return a + b', {3, 4})
+
+-- Compilation errors are not cached.
+c:eval('return +')
+c:eval('return +')
+
+--
+-- Flush the cache. Expressions are compiled on every call then.
+--
+box.cfg{eval_cache_size = 0}
+c:eval('return eval_f(...)', {3})
+box.cfg{eval_cache_size = 100}
+c:eval('return eval_f(...)', {4})
+c:eval('return "' .. string.rep('x', 100) .. '"') == string.rep('x', 100)
+box.cfg{eval_cache_size = 1024 * 1024}
+
+c:close()
+box.schema.user.revoke('guest', 'execute', 'universe')
@@ -0,0 +1,42 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+--
+-- Tuples are deleted once the time stored in the first part
+-- of an index with the expire option is in the past.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('exp', {parts = {2, 'unsigned'}, unique = false, expire = true})
+s.index.exp.expire
+s.index.pk.expire
+now = math.floor(fiber.time())
+for i = 1, 10 do s:insert{i, i % 2 == 0 and now - 10 or now + 3600} end
+test_run:wait_cond(function() return s:count() == 5 end, 10)
+s.index.exp:min()[2] > now
+s:select({}, {iterator = 'GE'})[1][1]
+-- Expired tuples which don't fit in one batch.
+for i = 11, 2500 do s:insert{i, now - 1} end
+test_run:wait_cond(function() return s:count() == 5 end, 10)
+-- Expiration stops once the option is unset.
+s.index.exp:alter({expire = false})
+s.index.exp.expire
+_ = s:insert{100, now - 1}
+fiber.sleep(1.5)
+s:count()
+s.index.exp:alter({expire = true})
+test_run:wait_cond(function() return s:count() == 5 end, 10)
+-- Wrong index definitions.
+s:create_index('e2', {type = 'hash', parts = {2, 'unsigned'}, expire = true})
+s:create_index('e2', {parts = {3, 'string'}, unique = false, expire = true})
+s:create_index('e2', {parts = {{3, 'unsigned', is_nullable = true}}, unique = false, expire = true})
+s:drop()
+--
+-- vinyl.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+_ = s:create_index('exp', {parts = {2, 'unsigned'}, unique = false, expire = true})
+now = math.floor(fiber.time())
+for i = 1, 10 do s:insert{i, i % 2 == 0 and now - 10 or now + 3600} end
+test_run:wait_cond(function() return s:count() == 5 end, 10)
+s:drop()
@@ -0,0 +1,45 @@
+--
+-- Memtx tuples store 16-bit field offsets. Indexed fields that
+-- start beyond the first 64 KB of a tuple are looked up by
+-- decoding the tuple.
+--
+pad = string.rep('x', 70000)
+function ids(tuples) local r = {} for _, t in ipairs(tuples) do table.insert(r, t[1]) end return r end
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+sk = s:create_index('sk', {parts = {3, 'unsigned'}})
+tk = s:create_index('tk', {parts = {4, 'string', 5, 'unsigned'}})
+_ = s:replace{1, pad, 10, 'a', 1}
+_ = s:replace{2, 'y', 20, 'b', 2}
+_ = s:replace{3, pad, 30, 'c', 3}
+ids(sk:select())
+sk:get{30}[1]
+tk:get{'b', 2}[1]
+ids(tk:select({'b'}, {iterator = 'ge'}))
+_ = s:update(1, {{'=', 3, 15}})
+sk:get{15}[1]
+_ = s:update(2, {{'=', 2, pad}})
+ids(sk:select({20}, {iterator = 'le'}))
+_ = s:update(3, {{'=', 2, 'z'}})
+ids(tk:select({'c', 3}, {iterator = 'le'}))
+s:drop()
+
+-- JSON path indexes.
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+sk = s:create_index('sk', {parts = {{3, 'string', path = 'a'}}})
+_ = s:replace{1, pad, {a = 'foo'}}
+_ = s:replace{2, 'y', {a = 'bar'}}
+sk:get{'foo'}[1]
+ids(sk:select())
+s:drop()
+
+-- SQL reads indexed fields by field map, too.
+box.sql.execute('create table t (id int primary key, s text, v int)')
+box.sql.execute('create index tv on t(v)')
+_ = box.space.T:replace{1, pad, 10}
+_ = box.space.T:replace{2, 'y', 20}
+box.sql.execute('select id from t where v = 10')
+box.sql.execute('select id from t where v > 5 order by v')
+box.sql.execute('drop table t')
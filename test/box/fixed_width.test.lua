@@ -0,0 +1,31 @@
+--
+-- Memtx tuples of a fixed_width space are stored in fixed-width
+-- MessagePack and fields are accessed without a field map.
+--
+format = {{'id', 'unsigned'}, {'val', 'integer'}, {'x', 'number'}, {'flag', 'boolean'}}
+s = box.schema.space.create('test', {fixed_width = true, format = format})
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'integer'}, unique = false})
+s:insert{1, -5, 1.5, true}
+s:insert{2, 10, 3, false}
+s:insert{3, 10, -2, true}
+s:get{1}
+s.index.sk:select{10}
+s.index.sk:select({}, {iterator = 'GE'})
+-- Every field takes the same space in any tuple.
+s:get{1}:bsize()
+s:get{3}:bsize()
+s:get{3}.flag
+s:update({1}, {{'+', 2, 100}, {'=', 4, false}})
+s.index.sk:get{95}
+s:insert{4, 1, 1}
+s:insert{4, 'a', 1, true}
+s:create_index('hash', {type = 'hash', parts = {2, 'integer'}})
+s:drop()
+
+-- Unsupported formats and engines.
+box.schema.space.create('test', {fixed_width = true})
+box.schema.space.create('test', {fixed_width = true, format = {{'a', 'string'}}})
+box.schema.space.create('test', {fixed_width = true, format = {{'a', 'unsigned', is_nullable = true}}})
+box.schema.space.create('test', {fixed_width = true, engine = 'vinyl', format = {{'a', 'unsigned'}}})
+box.space.test
@@ -0,0 +1,61 @@
+build_path = os.getenv("BUILDDIR")
+package.cpath = build_path..'/test/box/?.so;'..build_path..'/test/box/?.dylib;'..package.cpath
+
+--
+-- Functional indexes.
+--
+box.schema.func.create('function1.sum', {language = 'C'})
+box.schema.func.create('function1', {language = 'C'})
+box.schema.func.create('lua_sum')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+-- Wrong functional indexes.
+s:create_index('sum', {func = 'no_such_func'})
+s:create_index('sum', {func = 'lua_sum'})
+s:create_index('sum', {type = 'hash', func = 'function1.sum'})
+s2 = box.schema.space.create('test2')
+s2:create_index('pk', {func = 'function1.sum'})
+s2:drop()
+v = box.schema.space.create('vinyl', {engine = 'vinyl'})
+_ = v:create_index('pk')
+v:create_index('sum', {func = 'function1.sum'})
+v:drop()
+
+s:insert{1, 10, 20}
+s:insert{2, 5, 5}
+
+-- Index build.
+idx = s:create_index('sum', {func = 'function1.sum', parts = {{1, 'unsigned'}}})
+s.index.sum.func == box.space._func.index.name:get{'function1.sum'}[1]
+idx:select()
+
+s:insert{3, 1, 2}
+s:insert{4, 15, 15}
+s:insert{5, 'a', 1}
+s:insert{5, 1}
+idx:select()
+idx:get{10}
+idx:select({10}, {iterator = 'GE'})
+s:replace{2, 100, 0}
+idx:select()
+s:delete{1}
+idx:select()
+idx:count()
+
+-- Non-unique index.
+idx:drop()
+idx2 = s:create_index('sum2', {unique = false, func = 'function1.sum', parts = {{1, 'unsigned'}}})
+s:insert{6, 50, 50}
+idx2:select{100}
+idx2:select({}, {iterator = 'REQ'})
+
+-- A function that returns nothing.
+s:create_index('nothing', {func = 'function1', parts = {{1, 'unsigned'}}})
+
+-- A function can't be dropped while an index uses it.
+box.schema.func.drop('function1.sum')
+s:drop()
+box.schema.func.drop('function1.sum')
+box.schema.func.drop('function1')
+box.schema.func.drop('lua_sum')
@@ -177,3 +177,84 @@ test_yield(box_function_ctx_t *ctx, const char *args, const char *args_end)
 	printf("ok - yield\n");
 	return 0;
 }
+
+/*
+ * Functional index key: the sum of the second and the third
+ * fields of the tuple.
+ */
+int
+sum(box_function_ctx_t *ctx, const char *args, const char *args_end)
+{
+	uint32_t arg_count = mp_decode_array(&args);
+	if (arg_count != 1 || mp_typeof(*args) != MP_ARRAY) {
+		return box_error_set(__FILE__, __LINE__, ER_PROC_C, "%s",
+			"expected a tuple");
+	}
+	uint32_t field_count = mp_decode_array(&args);
+	if (field_count < 3) {
+		return box_error_set(__FILE__, __LINE__, ER_PROC_C, "%s",
+			"tuple is too short");
+	}
+	mp_next(&args);
+	uint64_t sum = 0;
+	for (int i = 0; i < 2; i++) {
+		if (mp_typeof(*args) != MP_UINT) {
+			return box_error_set(__FILE__, __LINE__, ER_PROC_C,
+				"%s", "tuple fields must be uint");
+		}
+		sum += mp_decode_uint(&args);
+	}
+
+	char tuple_buf[16];
+	char *d = tuple_buf;
+	d = mp_encode_array(d, 1);
+	d = mp_encode_uint(d, sum);
+	assert(d <= tuple_buf + sizeof(tuple_buf));
+
+	box_tuple_format_t *fmt = box_tuple_format_default();
+	box_tuple_t *tuple = box_tuple_new(fmt, tuple_buf, d);
+	if (tuple == NULL)
+		return -1;
+	return box_return_tuple(ctx, tuple);
+}
+
+/*
+ * Batch entry point of batch(): return {batch size, argument}
+ * for each call, fail calls with a non-uint argument.
+ */
+int
+batch_batch(box_function_call_t *calls, uint32_t count)
+{
+	box_tuple_format_t *fmt = box_tuple_format_default();
+	for (uint32_t i = 0; i < count; i++) {
+		const char *args = calls[i].args;
+		uint32_t arg_count = mp_decode_array(&args);
+		if (arg_count != 1 || mp_typeof(*args) != MP_UINT) {
+			box_error_set(__FILE__, __LINE__, ER_PROC_C, "%s",
+				      "expected a uint argument");
+			box_return_error(calls[i].ctx);
+			continue;
+		}
+		char tuple_buf[32];
+		char *d = tuple_buf;
+		d = mp_encode_array(d, 2);
+		d = mp_encode_uint(d, count);
+		d = mp_encode_uint(d, mp_decode_uint(&args));
+		assert(d <= tuple_buf + sizeof(tuple_buf));
+		box_tuple_t *tuple = box_tuple_new(fmt, tuple_buf, d);
+		if (tuple == NULL ||
+		    box_return_tuple(calls[i].ctx, tuple) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/*
+ * Unbatched entry point of batch(), see batch_batch().
+ */
+int
+batch(box_function_ctx_t *ctx, const char *args, const char *args_end)
+{
+	box_function_call_t call = { ctx, args, args_end };
+	return batch_batch(&call, 1);
+}
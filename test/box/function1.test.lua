@@ -83,6 +83,20 @@ box.schema.func.drop('function1.test_yield')
 ch:get()
 s:drop()
 
+-- Batch entry point of a C function.
+box.schema.func.create('function1.batch', {language = "C"})
+box.schema.user.grant('guest', 'execute', 'function', 'function1.batch')
+c:call('function1.batch', {1})
+futures = {}
+for i = 1, 10 do futures[i] = c:call('function1.batch', {i}, {is_async = true}) end
+err = c:call('function1.batch', {'x'}, {is_async = true})
+res = {}
+for i = 1, 10 do res[i] = futures[i]:wait_result() end
+res[1][1] > 1
+for i = 1, 10 do assert(res[i][1] == res[1][1] and res[i][2] == i) end
+err:wait_result()
+box.schema.func.drop('function1.batch')
+
 -- gh-2914: check identifier constraints.
 test_run = require('test_run').new()
 identifier = require("identifier")
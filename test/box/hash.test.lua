@@ -347,3 +347,19 @@ s:get(-1LL)
 s:get(9007199254740992LL)
 s:get(-9007199254740994LL)
 s:drop()
+
+-- A hash index is sized for size_hint tuples on creation.
+s = box.schema.space.create('test')
+pk = s:create_index('primary', {type = 'hash', size_hint = 10000})
+pk.size_hint
+bsize = pk:bsize()
+bsize > 0
+for i = 1, 10000 do s:insert{i} end
+pk:bsize() == bsize
+sk = s:create_index('secondary', {type = 'hash', parts = {1, 'unsigned'}})
+sk.size_hint
+sk:bsize() == bsize
+pk:alter({size_hint = 0})
+pk.size_hint
+s:create_index('bad', {type = 'hash', size_hint = -1})
+s:drop()
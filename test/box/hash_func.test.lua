@@ -0,0 +1,27 @@
+--
+-- Hash function of a HASH index.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+s:create_index('idx', {hash_func = 'wyhash'})
+s:create_index('idx', {type = 'hash', hash_func = 'md5'})
+
+idx = s:create_index('idx', {type = 'hash', hash_func = 'wyhash', parts = {{2, 'string'}}})
+idx.hash_func
+for i = 1, 100 do s:insert{i, string.rep('x', i)} end
+found = 0
+for i = 1, 100 do if idx:get{string.rep('x', i)}[1] == i then found = found + 1 end end
+found
+idx:get{'y'}
+idx:count()
+
+idx2 = s:create_index('idx2', {type = 'hash', hash_func = 'wyhash', parts = {{2, 'string'}, {1, 'unsigned'}}})
+idx2:get{string.rep('x', 7), 7}[1]
+idx2:get{string.rep('x', 7), 8}
+
+-- Changing the hash function rebuilds the index.
+idx:alter({hash_func = 'murmur'})
+idx.hash_func
+idx:get{string.rep('x', 50)}[1]
+
+s:drop()
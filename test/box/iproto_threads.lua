@@ -0,0 +1,13 @@
+#!/usr/bin/env tarantool
+os = require('os')
+
+box.cfg{
+    listen              = os.getenv("LISTEN"),
+    iproto_threads      = 4,
+    net_msg_max         = 2,
+}
+
+require('console').listen(os.getenv('ADMIN'))
+box.once('init', function()
+    box.schema.user.grant('guest', 'read,write,execute', 'universe')
+end)
@@ -0,0 +1,52 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+net_box = require('net.box')
+
+--
+-- net_msg_max limits messages of each network thread, so the
+-- tx fiber pool must be large enough to serve all threads at
+-- once. Load an instance with several network threads and a
+-- tiny net_msg_max with concurrent long requests.
+--
+test_run:cmd("create server iproto_threads with script='box/iproto_threads.lua'")
+test_run:cmd("start server iproto_threads")
+test_run:cmd("switch iproto_threads")
+fiber = require('fiber')
+box.cfg.iproto_threads
+s = box.schema.space.create('test')
+_ = s:create_index('pk', {parts = {1, 'unsigned', 2, 'unsigned'}})
+function long_call(i, j) fiber.sleep(0.01) s:insert{i, j} return i end
+test_run:cmd("switch default")
+
+uri = test_run:eval('iproto_threads', 'return box.cfg.listen')[1]
+n_errors = 0
+n_workers = 0
+
+test_run:cmd("setopt delimiter ';'")
+function worker(i)
+    n_workers = n_workers + 1
+    local conn = net_box.connect(uri)
+    local futures = {}
+    for j = 1, 10 do
+        table.insert(futures, conn:call('long_call', {i, j},
+                                        {is_async = true}))
+    end
+    for _, future in ipairs(futures) do
+        local res = future:wait_result(10)
+        if res == nil or res[1] ~= i then
+            n_errors = n_errors + 1
+        end
+    end
+    conn:close()
+    n_workers = n_workers - 1
+end;
+test_run:cmd("setopt delimiter ''");
+
+for i = 1, 50 do fiber.create(worker, i) end
+test_run:wait_cond(function() return n_workers == 0 end, 60)
+n_errors
+test_run:eval('iproto_threads', 'return box.space.test:count()')
+
+test_run:cmd("stop server iproto_threads")
+test_run:cmd("cleanup server iproto_threads")
+test_run:cmd("delete server iproto_threads")
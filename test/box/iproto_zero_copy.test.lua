@@ -0,0 +1,46 @@
+test_run = require('test_run').new()
+net = require('net.box')
+fiber = require('fiber')
+json = require('json')
+
+box.cfg{iproto_zero_copy_threshold = -1}
+
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 100 do s:replace{i, string.rep(tostring(i % 10), 1000)} end
+
+--
+-- Select responses above the threshold are sent from tuple
+-- memory. Check that they are intact and are not reordered
+-- with other responses sent from the output buffer.
+--
+box.cfg{iproto_zero_copy_threshold = 4096}
+c = net.connect(box.cfg.listen)
+json.encode(c.space.test:select()) == json.encode(s:select())
+json.encode(c.space.test:select({50}, {iterator = 'ge'})) == json.encode(s:select({50}, {iterator = 'ge'}))
+json.encode(c.space.test:select{1}) == json.encode(s:select{1})
+c.space.test:select{1000}
+
+ok = true
+done = 0
+test_run:cmd("setopt delimiter ';'")
+function select_f(i)
+    for j = 1, 20 do
+        local key = (i + j) % 2 == 0 and {j} or {}
+        local res = c.space.test:select(key)
+        if json.encode(res) ~= json.encode(s:select(key)) then
+            ok = false
+        end
+    end
+    done = done + 1
+end;
+test_run:cmd("setopt delimiter ''");
+for i = 1, 10 do fiber.create(select_f, i) end
+test_run:wait_cond(function() return done == 10 end, 60)
+ok
+
+c:close()
+box.cfg{iproto_zero_copy_threshold = 0}
+s:drop()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
@@ -125,3 +125,18 @@ l = space:select(l[#l][1], {limit=2, iterator="GT"})
 l
 space:drop()
 iterate = nil
+
+--
+-- Auto-yield: a tree iterator restores its position after
+-- a yield and doesn't skip or repeat tuples.
+--
+fiber = require('fiber')
+space = box.schema.space.create('test_yield')
+_ = space:create_index('pk')
+for i = 1, 10 do space:insert{i} end
+res = {}
+_ = fiber.new(function() space:delete{5} space:insert{11} end) for _, t in space:pairs({}, {yield_every = 3}) do table.insert(res, t[1]) end
+res
+space:pairs({}, {yield_every = -1})
+space:pairs({}, {yield_timeout = 'x'})
+space:drop()
@@ -0,0 +1,50 @@
+test_run = require('test_run').new()
+--
+-- Compression of fields that aren't indexed.
+--
+box.schema.space.create('test', {compression_threshold = -1})
+box.schema.space.create('test', {engine = 'vinyl', compression_threshold = 100})
+s = box.schema.space.create('test', {compression_threshold = 100})
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+big = string.rep('a', 1000)
+for i = 1, 10 do s:insert{i, i % 3, big, i} end
+s:count()
+s:bsize() < #big
+-- All fields are accessible.
+s:get(1)[3] == big
+s:get(1)[4]
+#s:get(1)
+s.index.sk:select(1, {limit = 1})[1][3] == big
+s:select({}, {limit = 2})[2][3] == big
+s.index.pk:min()[3] == big
+s.index.pk:max()[3] == big
+s:update(2, {{'=', 4, 20}})[4]
+s:get(2)[3] == big
+s:upsert({2, 2, big, 2}, {{'+', 4, 1}})
+s:get(2)[4]
+s:get(2)[3] == big
+-- Formats are checked against all fields.
+s:format({{'id', 'unsigned'}, {'k', 'unsigned'}, {'data', 'string'}, {'n', 'string'}})
+s:format({{'id', 'unsigned'}, {'k', 'unsigned'}, {'data', 'string'}})
+-- Compressed fields can't be indexed.
+s:create_index('tk', {parts = {4, 'unsigned'}})
+-- Small tuples are stored as is.
+s:insert{11, 0, 'x'}
+s:get(11)
+-- Triggers see all fields.
+old = nil
+f = s:on_replace(function(o, n) old = o end)
+_ = s:replace{1, 1, 'y'}
+old[3] == big
+_ = s:on_replace(nil, f)
+-- Snapshots store all fields.
+box.snapshot()
+test_run:cmd('restart server default')
+s = box.space.test
+big = string.rep('a', 1000)
+s:count()
+s:bsize() < #big
+s:get(3)[3] == big
+s:get(3)[4]
+s:drop()
@@ -0,0 +1,58 @@
+--
+-- Multikey indexes over array elements.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+-- Wrong multikey paths.
+s:create_index('idx', {parts = {{2, 'str', path = '[*][*]'}}})
+s:create_index('idx', {parts = {{2, 'str', path = '[*].a'}, {3, 'str', path = '[*].b'}}})
+s:create_index('idx', {parts = {{2, 'str', path = 'a[*]'}, {2, 'str', path = 'b[*]'}}})
+s:create_index('idx', {type = 'hash', parts = {{2, 'str', path = '[*]'}}})
+s2 = box.schema.space.create('test2')
+s2:create_index('pk', {parts = {{1, 'str', path = '[*]'}}})
+s2:drop()
+v = box.schema.space.create('vinyl', {engine = 'vinyl'})
+_ = v:create_index('pk')
+v:create_index('idx', {parts = {{2, 'str', path = '[*]'}}})
+v:drop()
+
+idx = s:create_index('idx', {unique = false, parts = {{2, 'str', path = '[*]'}}})
+-- An array can't be indexed by [*] and by element number.
+s:create_index('idx2', {parts = {{2, 'str', path = '[1]'}}})
+
+s:insert{1, {'a', 'b'}}
+s:insert{2, {'b', 'c', 'b'}}
+s:insert{3, {}}
+s:insert{4, {'a', 1}}
+idx:select('b')
+idx:select()
+idx:count('b')
+idx:count()
+s:replace{1, {'b', 'd'}}
+idx:select('a')
+idx:select('d')
+idx:select('b')
+s:delete(2)
+idx:select('c')
+idx:select()
+
+-- Elements are maps, one of the indexes is unique.
+idx2 = s:create_index('idx2', {parts = {{3, 'str', path = '[*].name'}}})
+s:replace{1, {}, {{name = 'Ivan'}, {name = 'Petr'}}}
+s:replace{2, {}, {{name = 'Anna'}}}
+s:replace{3, {}, {{name = 'Olga'}, {name = 'Petr'}}}
+idx2:select('Olga')
+s:replace{3, {}, {{name = 'Olga'}, {age = 30}}}
+s:replace{3, {}, {{name = 'Olga'}, {name = 'Olga'}}}
+idx2:select()
+idx2:get('Olga')
+s:delete(1)
+idx2:select()
+
+-- Index build.
+idx3 = s:create_index('idx3', {unique = false, parts = {{3, 'str', path = '[*].name'}}})
+idx3:select()
+idx3:count()
+
+s:drop()
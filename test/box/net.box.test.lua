@@ -1388,6 +1388,81 @@ c = net.connect('8.8.8.8:123456', {wait_connected = false})
 c
 c:close()
 
+--
+-- Pipeline sends many requests in one write and waits for all
+-- the responses at once.
+--
+s = box.schema.space.create('pipeline')
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+box.schema.user.grant('guest', 'read,write', 'space', 'pipeline')
+box.schema.user.grant('guest', 'execute', 'universe')
+c = net.connect(box.cfg.listen)
+p = c:pipeline()
+for i = 1, 4 do p:insert(c.space.pipeline, {i, i % 2}) end
+p:select(c.space.pipeline.index.sk, {1})
+p:update(c.space.pipeline, {1}, {{'=', 3, 'x'}})
+p:call('tostring', {100})
+p:eval('return ...', {1, 2})
+res, err = p:wait_result()
+err
+res
+p:select(c.space.pipeline, {1})
+p = c:pipeline()
+p:insert(c.space.pipeline, {1, 1})
+p:get(c.space.pipeline, {1})
+p:wait_result()
+p = c:pipeline()
+p:count(c.space.pipeline, {1})
+--
+-- Futures run completion callbacks. Responses are decoded in C.
+--
+result = nil
+future = c:call('tostring', {5}, {is_async = true})
+future:on_complete(function(res, err) result = {res, err} end)
+while result == nil do fiber.sleep(0.01) end
+result
+future:on_complete(function(res, err) result = res end)
+result
+result = nil
+future = c.space.pipeline:insert({1, 1}, {is_async = true})
+future:on_complete(function(res, err) result = err end)
+while result == nil do fiber.sleep(0.01) end
+result
+c.space.pipeline:get({2})
+c.space.pipeline.index.sk:get({1})
+c:eval('return 1, nil, 3')
+--
+-- Connection pool routes requests by load and read only state.
+--
+pool = net.pool({box.cfg.listen, box.cfg.listen})
+while pool:info()[1].ro == nil or pool:info()[2].ro == nil do fiber.sleep(0.01) end
+pool:call('tostring', {7})
+pool:select('pipeline', {2})
+pool:replace('pipeline', {5, 1})
+pool:get('pipeline', {5}, {mode = 'write'})
+pool:select('nosuchspace')
+info = pool:info()
+#info, info[1].state, info[1].ro, info[1].in_flight, info[2].in_flight
+pool:connection():ping()
+pool:connection('nosuchmode')
+pool:close()
+pool:info()[1].state
+pool:call('tostring', {7})
+--
+-- Big response bodies are compressed on request of a client.
+--
+for i = 1, 1000 do s:replace({i, i % 10, string.rep('x', 100)}) end
+cc = net.connect(box.cfg.listen, {compression_threshold = 1000})
+#cc.space.pipeline:select()
+cc.space.pipeline:get({1000})[3] == string.rep('x', 100)
+cc.space.pipeline.index.sk:count({3})
+#cc:eval('return box.space.pipeline:select()')
+cc:close()
+c:close()
+s:drop()
+box.schema.user.revoke('guest', 'execute', 'universe')
+
 box.schema.func.drop('do_long')
 box.schema.user.revoke('guest', 'write', 'space', '_schema')
 box.schema.user.revoke('guest', 'read,write', 'space', '_space')
@@ -137,6 +137,33 @@ run_max = 100
 run_workers(conn)
 wait_finished(110)
 
+--
+-- Requests with IPROTO_PRIORITY are sent to tx by a separate
+-- lane.
+--
+socket = require('socket')
+msgpack = require('msgpack')
+uri = require('uri').parse(tostring(box.cfg.listen))
+s = socket.tcp_connect(uri.host, uri.service)
+greeting = s:read(128)
+test_run:cmd("setopt delimiter ';'")
+function request(type, priority, body)
+	local header = msgpack.encode({[0x00] = type, [0x01] = 1,
+				       [0x08] = priority})
+	body = msgpack.encode(body)
+	s:write(msgpack.encode(#header + #body) .. header .. body)
+	local response = s:read(msgpack.decode(s:read(5)))
+	local h, pos = msgpack.decode(response)
+	local data = msgpack.decode(response, pos)[0x30]
+	return h[0x00], data ~= nil and #data or nil
+end;
+test_run:cmd("setopt delimiter ''");
+request(0x40, 1, {})
+request(0x01, 1, {[0x10] = 280, [0x11] = 0, [0x12] = 1, [0x20] = {280}})
+request(0x01, 0, {[0x10] = 280, [0x11] = 0, [0x12] = 1, [0x20] = {280}})
+request(0x0a, 1, {[0x22] = 'do_long_f', [0x21] = {}})
+s:close()
+
 conn2:close()
 conn:close()
 
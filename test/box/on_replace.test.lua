@@ -279,3 +279,23 @@ s3:select()
 s1:drop()
 s2:drop()
 s3:drop()
+
+--
+-- space:on_commit_batch() fires once per committed transaction
+-- with all {old, new} pairs applied to the space.
+--
+s = box.schema.space.create('test_batch')
+_ = s:create_index('pk')
+calls = {}
+function batch_trigger(batch, name) local t = {name} for _, p in ipairs(batch) do table.insert(t, string.format('%s/%s', p[1] and p[1][1] or '-', p[2] and p[2][1] or '-')) end table.insert(calls, table.concat(t, ' ')) end
+_ = s:on_commit_batch(batch_trigger)
+box.begin() s:insert{1} s:insert{2} s:replace{1, 'a'} s:delete{2} box.commit()
+calls
+calls = {}
+box.begin() s:insert{3} box.rollback()
+s:insert{4}
+calls
+s:on_commit_batch(nil, batch_trigger)
+s:insert{5}
+calls
+s:drop()
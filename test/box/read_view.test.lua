@@ -0,0 +1,50 @@
+fiber = require('fiber')
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('sk', {type = 'hash', parts = {2, 'unsigned'}})
+for i = 1, 5 do s:insert{i, i * 10} end
+
+rv = box.read_view()
+rv
+
+-- Changes made after the view was opened are not visible.
+s:delete{1}
+s:replace{2, 200}
+s:insert{6, 60}
+t = {} for _, tuple in rv:pairs(s.id) do table.insert(t, tuple) end
+t
+t = {} for _, tuple in rv:pairs('test', 'sk') do table.insert(t, tuple[2]) end
+table.sort(t)
+t
+
+-- An index can be scanned only once.
+rv:pairs('test', 'pk')
+rv:pairs('no_such_space')
+rv:pairs('test', 'no_such_index')
+rv:close()
+rv
+rv:pairs('test')
+
+-- A scan may yield while the space is being changed.
+rv = box.read_view()
+count = 0
+for _, tuple in rv:pairs('test') do s:delete{tuple[1]} fiber.sleep(0) count = count + 1 end
+count
+s:count()
+rv:close()
+
+-- Dropped indexes cannot be read.
+for i = 1, 5 do s:insert{i, i * 10} end
+rv = box.read_view()
+gen, param, state = rv:pairs(s.id)
+s.index.sk:drop()
+ok, err = pcall(rv.pairs, rv, s.id, 1)
+ok, tostring(err):match('No index #1') ~= nil
+state, tuple = gen(param, state)
+tuple
+s:drop()
+ok, err = pcall(gen, param, state)
+ok, tostring(err):match('No index #0') ~= nil
+rv = nil
+collectgarbage()
@@ -237,3 +237,20 @@ i:select({0, 0, 0}, {iterator = 'neighbor'})
 i:select({1, 2, 3, 4, 5, 6}, {iterator = 'BITS_ALL_SET' } )
 
 s:drop()
+
+-- RTREE index created over existing data is bulk loaded.
+s = box.schema.space.create('bulk')
+_ = s:create_index('pk')
+for k = 1, 1000 do s:insert{k, {k % 37, k % 101}} end
+i = s:create_index('sp', {type = 'rtree', unique = false, parts = {2, 'array'}})
+i:count()
+function inside(p) return p[1] >= 10 and p[1] <= 20 and p[2] >= 10 and p[2] <= 20 end
+n = 0 for _, t in s:pairs() do if inside(t[2]) then n = n + 1 end end
+n > 0
+#i:select({10, 10, 20, 20}, {iterator = 'le'}) == n
+#i:select({0, 0}, {iterator = 'neighbor'})
+s:delete(11)
+n = inside({11 % 37, 11 % 101}) and n - 1 or n
+#i:select({10, 10, 20, 20}, {iterator = 'le'}) == n
+i:count()
+s:drop()
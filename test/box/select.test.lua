@@ -148,3 +148,29 @@ collectgarbage('collect')
 collectgarbage('restart')
 lots_of_links
 s:drop()
+
+--
+-- select() to a reusable tuple batch.
+--
+s = box.schema.space.create('select', { temporary = true })
+index = s:create_index('primary', { type = 'tree' })
+for i = 1, 10 do s:insert{i, i * 10} end
+batch = box.tuple.batch(4)
+#s:select({}, {batch = batch})
+batch[1], batch[4], batch[5]
+s:select({5}, {batch = batch, iterator = 'GE', limit = 2}):totable()
+#batch
+batch[2][2]
+s:select({}, {batch = {}})
+--
+-- A key can be passed encoded in a buffer.
+--
+buffer = require('buffer')
+keybuf = buffer.ibuf()
+_ = msgpack.encode({7}, keybuf)
+s:get(keybuf)
+s:select(keybuf)
+s:select(keybuf, {iterator = 'GT', batch = batch}):totable()
+batch:reset()
+#batch
+s:drop()
@@ -400,6 +400,12 @@ s2:insert{101, 'aaa'}
 sq = box.schema.sequence.create('test', {step = 2, min = 10, max = 20, start = 15, cycle = true})
 sq:next()
 
+-- Only the end of a block of cached values is persisted.
+sq2 = box.schema.sequence.create('test_cache', {cache = 10})
+sq2:next() -- 1
+sq2:next() -- 2
+box.space._sequence_data:get(sq2.id)[2] -- 10
+
 test_run:cmd('restart server default')
 
 sq = box.sequence.test
@@ -408,6 +414,11 @@ sq.step, sq.min, sq.max, sq.start, sq.cycle
 sq:next()
 sq:drop()
 
+-- Values left in the block are skipped after restart.
+sq2 = box.sequence.test_cache
+sq2:next() -- 11
+sq2:drop()
+
 s1 = box.space.test1
 s1.index.pk.sequence_id == box.sequence.test1_seq.id
 s1:insert{nil, 'b'} -- 2
@@ -0,0 +1,43 @@
+--
+-- Per-space memory quota.
+--
+utils = require('utils')
+EMPTY_MAP = utils.setmap({})
+s = box.schema.space.create('quota', {memory_quota = 500})
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'string'}, unique = false})
+-- Each tuple takes 104 bytes.
+for i = 1, 4 do s:insert{i, string.rep('x', 100)} end
+s:bsize()
+s:insert{5, string.rep('x', 100)}
+s:bsize()
+s.index.sk:count()
+-- Changes that don't grow the space are allowed.
+_ = s:replace{1, string.rep('y', 100)}
+_ = s:delete{1}
+_ = s:insert{5, string.rep('x', 100)}
+s:bsize()
+-- A statement rolled back by the quota doesn't affect the
+-- rest of the transaction.
+box.begin() _ = s:insert{6, 'z'} ok = pcall(s.insert, s, {7, string.rep('x', 100)}) _ = s:delete{2} box.commit()
+ok
+s:bsize()
+s:count()
+-- Lowering the quota doesn't delete anything, but the space
+-- can't grow until it fits in the quota again.
+_ = box.space._space:update(s.id, {{'=', 6, {memory_quota = 100}}})
+s = box.space.quota
+s:bsize()
+_ = s:replace{3, 'a'}
+s:insert{8, 'b'}
+s:truncate()
+_ = s:insert{8, 'b'}
+s:bsize()
+-- Disable the quota.
+_ = box.space._space:update(s.id, {{'=', 6, EMPTY_MAP}})
+s = box.space.quota
+for i = 1, 10 do s:replace{i, string.rep('x', 100)} end
+s:bsize()
+s:drop()
+box.schema.space.create('quota', {memory_quota = -1})
+box.schema.space.create('quota', {engine = 'vinyl', memory_quota = 100})
@@ -45,5 +45,82 @@ box.stat.REPLACE.total
 box.stat.SELECT.total
 box.stat.ERROR.total
 
+-- request latency by type
+net_box = require('net.box')
+box.schema.user.grant('guest', 'read,write', 'space', 'tweedledum')
+c = net_box.connect(box.cfg.listen)
+for i = 1, 10 do c.space.tweedledum:replace{i} end
+c:close()
+lat = box.stat.latency()
+lat.REPLACE.exec.p50 > 0 and lat.REPLACE.exec.p999 >= lat.REPLACE.exec.p50
+lat.REPLACE.queue.p99 > 0 and lat.REPLACE.wal.p99 > 0
+lat.SELECT ~= nil and lat.CALL ~= nil and lat.EXECUTE ~= nil
+lat.CONNECT.queue.p50 > 0
+box.schema.user.revoke('guest', 'read,write', 'space', 'tweedledum')
+
+-- worker pool classes
+fio = require('fio')
+fiber = require('fiber')
+box.cfg{worker_pool_file_threads = 1}
+pool = box.stat.worker_pool()
+pool.file.size, pool.dns.size, pool.user.size
+requests = pool.file.requests
+ch = fiber.channel(10)
+for i = 1, 10 do fiber.create(function() fio.stat('.') ch:put(true) end) end
+for i = 1, 10 do ch:get() end
+pool = box.stat.worker_pool()
+pool.file.requests - requests >= 10
+pool.file.running, pool.file.waiting
+pool.file.queue_time_max > 0
+box.cfg{worker_pool_file_threads = 0}
+
+-- event loop and cbus statistics
+loop = box.stat.loop()
+loop.main.iterations > 0 and loop.wal.iterations > 0
+loop.main.busy > 0 and loop.main.load > 0 and loop.main.load <= 1
+loop.main.iteration.p999 >= loop.main.iteration.p50
+loop.main.iteration.max >= loop.main.iteration.p50
+loop.main.ready.max >= 1
+bus = box.stat.cbus()
+bus.wal.pipes > 0 and bus.wal.fetched > 0 and bus.tx.fetched > 0
+bus.wal.queue_max >= 1
+
+-- per-space and per-index request statistics
+s = box.schema.space.create('op_stat')
+_ = s:create_index('pk')
+for i = 1, 10 do s:replace{i} end
+_ = s:insert{11}
+_ = s:get{1}
+_ = s:select({}, {limit = 5})
+_ = s:delete{11}
+st = s:stat()
+st.select, st.insert, st.replace, st.delete
+st.latency.samples >= 0 and st.latency.max >= st.latency.avg
+st = s.index.pk:stat()
+st.select, st.get, st.replace, st.delete, st.rows
+st.bytes > 0 and st.steps >= st.rows
+s.index.pk:stat_reset()
+s.index.pk:stat().get, s:stat().replace
+s:stat_reset()
+s:stat().replace
+s:drop()
+
+-- all statistics in the Prometheus text format
+s = box.schema.space.create('metrics')
+_ = s:create_index('pk')
+_ = s:replace{1}
+m = box.stat.metrics()
+m:match('\ntnt_stats_op_replace_total %d+\n') ~= nil
+m:match('\ntnt_info_vclock{id="1"} %d+\n') ~= nil
+m:match('\ntnt_info_memory_data %d+\n') ~= nil
+m:match('\ntnt_slab_quota_size %d+\n') ~= nil
+m:match('\ntnt_vinyl_memory_tuple_cache %d+\n') ~= nil
+m:match('\ntnt_space_replace{space="metrics"} 1\n') ~= nil
+m:match('\ntnt_index_replace{space="metrics",index="pk"} 1\n') ~= nil
+bad = 0
+for l in m:gmatch('[^\n]+') do if not l:match('^tnt_[a-z0-9_]+ %S+$') and not l:match('^tnt_[a-z0-9_]+{[^}]*} %S+$') then bad = bad + 1 end end
+bad
+s:drop()
+
 -- cleanup
 box.space.tweedledum:drop()
@@ -0,0 +1,41 @@
+--
+-- Indexes storing keys in their entries.
+--
+s = box.schema.space.create('test')
+pk = s:create_index('pk', {store_key = true})
+s:create_index('idx', {type = 'hash', store_key = true})
+s:create_index('idx', {store_key = true, parts = {{2, 'str', path = '[*]'}}})
+v = box.schema.space.create('vinyl', {engine = 'vinyl'})
+v:create_index('pk', {store_key = true})
+v:drop()
+
+s:insert{1, {user = {name = 'b'}}, 30}
+s:insert{2, {user = {name = 'a'}}, 20}
+
+-- Index build.
+idx = s:create_index('name', {store_key = true, parts = {{2, 'str', path = 'user.name'}}})
+idx.store_key
+idx:select()
+
+s:insert{3, {user = {name = 'a'}}, 40}
+s:replace{2, {user = {name = 'c'}}, 20}
+idx:select()
+idx:get{'c'}
+idx:select({'b'}, {iterator = 'GE'})
+s:delete{1}
+idx:select()
+
+-- Non-unique index.
+idx2 = s:create_index('age', {unique = false, store_key = true, parts = {{3, 'unsigned'}}})
+s:insert{4, {user = {name = 'd'}}, 20}
+idx2:select{20}
+idx2:select({}, {iterator = 'REQ'})
+pk:select()
+pk:get{4}
+
+-- Changing the option rebuilds the index.
+idx2:alter({store_key = false})
+idx2.store_key
+idx2:select{20}
+
+s:drop()
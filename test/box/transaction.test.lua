@@ -261,3 +261,55 @@ test_run:cmd("setopt delimiter ''");
 
 space:select()
 space:drop()
+
+--
+-- A memtx transaction that yields before changing any data
+-- isn't aborted unless memtx data is changed during the yield.
+--
+space = box.schema.space.create('test')
+index = space:create_index('primary')
+space:insert{1, 1}
+test_run:cmd("setopt delimiter ';'")
+box.begin()
+t = space:get{1}
+fiber.sleep(0)
+space:replace{1, t[2] + 1}
+box.commit();
+test_run:cmd("setopt delimiter ''");
+space:get{1}
+test_run:cmd("setopt delimiter ';'")
+box.begin()
+t = space:get{1}
+fiber.create(function() space:replace{1, 10} end)
+space:replace{1, t[2] + 1}
+box.commit();
+test_run:cmd("setopt delimiter ''");
+space:get{1}
+-- Read-only transaction.
+test_run:cmd("setopt delimiter ';'")
+box.begin()
+t = space:get{1}
+fiber.create(function() space:replace{1, 20} end)
+box.commit();
+test_run:cmd("setopt delimiter ''");
+space:get{1}
+space:drop()
+
+--
+-- Read-only transactions fail writes up front.
+--
+space = box.schema.space.create('test')
+_ = space:create_index('pk')
+_ = space:insert{1}
+test_run:cmd("setopt delimiter ';'")
+box.begin{read_only = true}
+t = {space:get{1}}
+table.insert(t, {pcall(space.insert, space, {2})})
+table.insert(t, {pcall(space.delete, space, {1})})
+box.commit();
+test_run:cmd("setopt delimiter ''");
+t
+space:select()
+box.begin{read_only = 1}
+box.is_in_txn()
+space:drop()
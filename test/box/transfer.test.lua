@@ -0,0 +1,50 @@
+net_box = require('net.box')
+
+s = box.schema.space.create('src')
+_ = s:create_index('pk')
+_ = s:create_index('bucket', {parts = {2, 'unsigned'}, unique = false})
+for i = 1, 100 do s:insert{i, i % 10} end
+d = box.schema.space.create('dst')
+_ = d:create_index('pk')
+
+-- A read view of a key range.
+rv = box.read_view({space = 'src', index = 'bucket', from = {3}, to = {5}})
+s:delete{3}
+t = {} for _, tuple in rv:pairs('src', 'bucket') do table.insert(t, tuple[1]) end
+#t, t[1], t[#t]
+ok, err = pcall(rv.pairs, rv, 'src', 'pk')
+ok, tostring(err):match('No index #0') ~= nil
+rv:close()
+rv = box.read_view({space = 'src', from = {98}})
+t = {} for _, tuple in rv:pairs('src') do table.insert(t, tuple[1]) end
+t
+rv:close()
+box.read_view({space = 'src', from = {'x'}})
+box.read_view({index = 'pk'})
+s:insert{3, 3}
+
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+c = net_box.connect(box.cfg.listen)
+
+-- Transfer a bucket.
+progress = {}
+stats = box.transfer.send(c, s, {index = 'bucket', from = {7}, to = {8}, target = 'dst', chunk_size = 3, window = 2, on_progress = function(st) table.insert(progress, st.tuples) end})
+stats.chunks, stats.tuples
+progress
+d:count()
+d:select({}, {limit = 3})
+
+-- A transfer can be restarted.
+stats = box.transfer.send(c, 'src', {index = 'bucket', from = {7}, to = {8}, target = 'dst'})
+stats.chunks, stats.tuples
+d:count()
+
+-- Errors are reported to the sender.
+box.transfer.send(c, 'src', {target = 'no_such_space'})
+box.transfer.send(c, 'src', {window = 0})
+box.transfer.send(c, 'src', {foo = 1})
+
+c:close()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
+s:drop()
+d:drop()
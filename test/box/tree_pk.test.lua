@@ -301,3 +301,53 @@ s:drop()
 
 box.internal.collation.drop('test')
 box.internal.collation.drop('test-ci')
+
+--
+-- count() and select() offset are computed in O(log n) using
+-- subtree sizes kept in inner blocks of the tree.
+--
+s = box.schema.space.create('test')
+pk = s:create_index('pk')
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+for i = 1, 1000 do s:replace{i, i % 10} end
+sk:count({5}, {iterator = 'LT'})
+sk:count({5}, {iterator = 'EQ'})
+pk:count({900}, {iterator = 'GT'})
+sk:select({5}, {iterator = 'LE', offset = 150, limit = 2})
+pk:select({}, {iterator = 'GE', offset = 998, limit = 5})
+pk:select({}, {offset = 1000})
+test_run:cmd("setopt delimiter ';'")
+function check_index(idx)
+    local bad = {}
+    local types = {'EQ', 'REQ', 'ALL', 'LT', 'LE', 'GE', 'GT'}
+    local keys = {{}, {0}, {5}, {9}, {10}, {500}}
+    local offsets = {0, 1, 99, 100, 101, 500, 999, 1000, 2000}
+    for _, t in ipairs(types) do
+        for _, k in ipairs(keys) do
+            local all = idx:select(k, {iterator = t})
+            if idx:count(k, {iterator = t}) ~= #all then
+                table.insert(bad, {t, k, 'count'})
+            end
+            for _, off in ipairs(offsets) do
+                local res = idx:select(k, {iterator = t, offset = off,
+                                           limit = 3})
+                local n = math.max(0, math.min(3, #all - off))
+                local ok = #res == n
+                for j = 1, #res do
+                    ok = ok and res[j][1] == all[off + j][1]
+                end
+                if not ok then
+                    table.insert(bad, {t, k, off})
+                end
+            end
+        end
+    end
+    return bad
+end;
+test_run:cmd("setopt delimiter ''");
+check_index(pk)
+check_index(sk)
+for i = 1, 1000, 3 do s:delete{i} end
+check_index(pk)
+check_index(sk)
+s:drop()
@@ -383,4 +383,66 @@ collectgarbage()
 t2 = box.tuple.new(2)
 t1 = t1:update{{'+', 1, 1}}
 
+--
+-- Tuples encoded by a compiled codec are created and inserted
+-- without conversion.
+--
+msgpackffi = require('msgpackffi')
+buffer = require('buffer')
+s = box.schema.space.create('codec', {format = {{'id', 'unsigned'}, {'name', 'string'}}})
+_ = s:create_index('pk')
+codec = msgpackffi.codec(s:format())
+buf = buffer.ibuf()
+_ = codec.encode({1, 'one'}, buf)
+box.tuple.new(buf)
+s:insert(buf)
+s:insert(buf)
+buf:reset()
+_ = codec.encode({1, 'uno'}, buf)
+s:replace(buf)
+s:select()
+s:drop()
+
+--
+-- Field names resolved to field numbers once.
+--
+s = box.schema.space.create('accessor', {format = {{'id', 'unsigned'}, {'name', 'string'}, {'age', 'unsigned'}}})
+_ = s:create_index('pk')
+t = s:replace{1, 'Ann', 30}
+fields = s:field_accessor()
+fields.name, fields.age
+t[fields.name], t[fields.age]
+fields.nick
+s:field_accessor() == fields
+s:format({{'id', 'unsigned'}, {'nick', 'string'}, {'age', 'unsigned'}})
+fields.nick
+fields.name
+s:drop()
+
+--
+-- tuple:tojson() encodes a tuple without converting it to Lua.
+--
+json = require('json')
+t = box.tuple.new({1, -2, 'a"b', {k = 'v'}, {true, false}, box.NULL, 1.5})
+t:tojson()
+t:tojson() == json.encode(t:totable())
+box.tuple.new({}):tojson()
+
+--
+-- Small runtime tuples share slabs. A slab is recycled once all
+-- its tuples are deleted, while tuples kept alive stay intact.
+--
+kept = {}
+for i = 1, 10000 do local t = box.tuple.new({i, string.rep('x', i % 100)}) if i % 1000 == 0 then table.insert(kept, t) end end
+collectgarbage('collect')
+for i = 1, 10000 do local t = box.tuple.new({i}) end
+collectgarbage('collect')
+#kept
+kept[1][1], #kept[1][2], kept[10][1]
+big = box.tuple.new({string.rep('y', 5000)})
+#big[1]
+kept = nil
+big = nil
+collectgarbage('collect')
+
 test_run:cmd("clear filter")
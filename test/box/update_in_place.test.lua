@@ -0,0 +1,61 @@
+--
+-- Updates that don't change the size of the updated fields
+-- are applied to a copy of the old tuple in place.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+sk = s:create_index('sk', {parts = {2, 'unsigned'}})
+s:replace{1, 10, 'abc', 100}
+s:update(1, {{'+', 4, 1}})
+s:update(1, {{'=', 3, 'xyz'}, {'-', -1, 1}})
+s:update(1, {{'^', 2, 1}})
+sk:select{10}
+sk:select{11}
+
+-- The changed fields are validated.
+s:update(1, {{'=', 2, true}})
+s:update(1, {{'+', 3, 1}})
+s:update(1, {{'+', 4, 1}, {'+', 4, 1}})
+s:get{1}
+
+-- Updates changing the size or the number of fields.
+s:update(1, {{'=', 3, 'abcd'}, {'+', 4, 1000}})
+s:update(1, {{'!', 5, 'new'}})
+s:update(1, {{'+', 4, 1}, {'=', 2, 12}})
+sk:select{12}
+s:drop()
+
+-- A changed field with indexed subfields.
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+sk = s:create_index('sk', {parts = {{2, 'unsigned', path = 'a'}}})
+s:replace{1, {a = 1}}
+s:update(1, {{'=', 2, {a = 2}}})
+sk:select{1}
+sk:select{2}
+s:drop()
+
+-- Secondary keys that don't depend on the updated fields are
+-- replaced in place.
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('hash', {type = 'hash', parts = {2, 'unsigned'}})
+_ = s:create_index('tree', {parts = {3, 'string'}, unique = false})
+_ = s:create_index('mk', {parts = {{4, 'unsigned', path = '[*]'}}, unique = false})
+_ = s:create_index('bitset', {type = 'bitset', parts = {2, 'unsigned'}, unique = false})
+s:replace{1, 10, 'a', {1, 2, 2}, 0}
+s:replace{2, 20, 'a', {2, 3}, 0}
+s:update(1, {{'+', 5, 1}})
+s:update(2, {{'=', 5, 'abcdef'}})
+s.index.hash:get{10}
+s.index.tree:select{'a'}
+s.index.mk:select{2}
+s.index.bitset:select{20}
+box.begin() s:update(1, {{'+', 5, 1}}) box.rollback()
+s.index.mk:select{1}
+s:update(1, {{'=', 3, 'b'}})
+s.index.tree:select{'a'}
+s.index.tree:select{'b'}
+s:delete{1}
+s.index.mk:select{2}
+s:drop()
@@ -0,0 +1,56 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+socket = require('socket')
+msgpack = require('msgpack')
+
+--
+-- IPROTO_WAIT_VCLOCK makes a read request wait until the
+-- instance vclock reaches the given one.
+--
+box.schema.user.grant('guest', 'read', 'universe')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+uri = require('uri').parse(tostring(box.cfg.listen))
+sock = socket.tcp_connect(uri.host, uri.service)
+greeting = sock:read(128)
+test_run:cmd("setopt delimiter ';'")
+function select(vclock)
+    local header = msgpack.encode({[0x00] = 0x01, [0x01] = 1,
+                                   [0x09] = setmetatable(vclock,
+                                            {__serialize = 'map'})})
+    local body = msgpack.encode({[0x10] = s.id, [0x11] = 0,
+                                 [0x12] = 100, [0x20] = {}})
+    sock:write(msgpack.encode(#header + #body) .. header .. body)
+    local response = sock:read(msgpack.decode(sock:read(5)))
+    local h, pos = msgpack.decode(response)
+    local b = msgpack.decode(response, pos)
+    if h[0x00] ~= 0 then
+        return b[0x31]
+    end
+    return #b[0x30]
+end;
+test_run:cmd("setopt delimiter ''");
+
+-- The vclock is reached already.
+vclock = table.copy(box.info.vclock)
+select(vclock)
+
+-- The request waits for a write.
+vclock[box.info.id] = vclock[box.info.id] + 1
+_ = fiber.create(function() fiber.sleep(0.1) s:replace{1} end)
+select(vclock)
+
+-- Timeout.
+timeout = box.cfg.replication_sync_timeout
+box.cfg{replication_sync_timeout = 0.1}
+vclock[box.info.id] = vclock[box.info.id] + 100
+select(vclock)
+box.cfg{replication_sync_timeout = timeout}
+
+-- Invalid vclock.
+select({a = 1})
+
+sock:close()
+s:drop()
+box.schema.user.revoke('guest', 'read', 'universe')
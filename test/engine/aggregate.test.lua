@@ -0,0 +1,41 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+sk = s:create_index('sk', {parts = {3, 'unsigned'}, unique = false})
+s:format({{'id', 'unsigned'}, {'val', 'any'}, {'grp', 'unsigned'}})
+
+a = s:aggregate(2)
+a.count, a.sum, a.min, a.max
+
+for i = 1, 1000 do s:insert{i, i, i % 10} end
+a = s:aggregate(2)
+a.count, a.sum, a.min, a.max
+a = s:aggregate('val')
+a.count, a.sum, a.min, a.max
+a = sk:aggregate('val', 3)
+a.count, a.sum, a.min, a.max
+a = s:aggregate('id', 500, {iterator = 'GT'})
+a.count, a.sum, a.min, a.max
+
+-- Nil values are skipped, floating point values are mixed in.
+_ = s:replace{1, box.NULL, 1}
+_ = s:replace{2, 2.5, 2}
+a = s:aggregate('val')
+a.count, a.sum, a.min, a.max
+
+-- Integer overflow switches the sum to floating point.
+s:truncate()
+_ = s:insert{1, 9223372036854775807LL, 1}
+_ = s:insert{2, 9223372036854775807LL, 1}
+a = s:aggregate('val')
+a.count, a.sum, a.min, a.max
+
+-- Errors.
+_ = s:insert{3, 'abc', 1}
+s:aggregate('val')
+s:aggregate('foo')
+s:aggregate(0)
+
+s:drop()
@@ -0,0 +1,24 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+
+-- Composite keys of mixed integer and string parts in an
+-- arbitrary field order.
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk', {parts = {{4, 'integer'}, {2, 'string'}, {1, 'unsigned'}, {3, 'integer'}}})
+_ = s:insert{1, 'b', -1, 10}
+_ = s:insert{2, 'a', 0, 10}
+_ = s:insert{1, 'a', 5, -10}
+_ = s:insert{1, 'a', -5, -10}
+_ = s:insert{0, 'a', 0, -10}
+_ = s:insert{1, 'b', 1, 10}
+s:select()
+s:select({-10, 'a', 1}, {iterator = 'GE'})
+s:select({10, 'b'}, {iterator = 'LT'})
+s:get{-10, 'a', 1, -5}
+s:insert{1, 'a', 5, -10}
+
+-- Secondary key is extended with the primary key parts.
+sk = s:create_index('sk', {parts = {{3, 'integer'}, {2, 'string'}}, unique = false})
+sk:select()
+sk:select({0}, {iterator = 'EQ'})
+s:drop()
@@ -775,3 +775,22 @@ s.index.i1:select()
 box.snapshot()
 
 s:drop()
+
+--
+-- Dropping field_count and appending a typed nullable field
+-- past it can't invalidate existing tuples and needs no check.
+--
+s = box.schema.space.create('test', {engine = engine, field_count = 2})
+_ = s:create_index('pk')
+_ = s:insert{1, 'a'}
+fmt = {{name = 'a', type = 'unsigned'}, {name = 'b', type = 'any'}}
+fmt[3] = {name = 'c', type = 'string', is_nullable = true}
+_ = box.space._space:update(s.id, {{'=', 5, 0}, {'=', 7, fmt}})
+s:insert{2, 'b', 'c'}
+s:insert{3, 'b', 4}
+s:select()
+-- Without field_count existing tuples still have to be checked.
+s:format({})
+s:insert{4, 'd', 5}
+s:format(fmt)
+s:drop()
@@ -123,3 +123,23 @@ s:select{}
 s:drop()
 fiber = nil
 
+
+--
+-- space:insert_many() and space:replace_many() apply a batch
+-- of tuples atomically.
+--
+s = box.schema.space.create('batch', {engine = engine})
+_ = s:create_index('pk')
+s:insert_many({{3, 'c'}, {1, 'a'}, {2, 'b'}})
+s:select{}
+s:insert_many({{4, 'd'}, {2, 'x'}})
+s:insert_many({{4, 'd'}, {'x'}})
+s:select{}
+s:replace_many({{2, 'x'}, {5, 'e'}, {2, 'y'}})
+s:select{}
+box.begin() s:insert{6} s:insert_many({{7}, {1}}) box.commit()
+box.rollback()
+s:count()
+s:insert_many({})
+s:insert_many(1)
+s:drop()
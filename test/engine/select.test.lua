@@ -111,3 +111,17 @@ index2:get{104}
 index3:get{9}
 index3:select{1235}
 space:drop()
+
+--
+-- index:get_many() looks up a batch of keys at once.
+--
+space = box.schema.space.create('test', { engine = engine })
+index1 = space:create_index('primary')
+index2 = space:create_index('secondary', { parts = {2, 'string'} })
+for i = 1, 10 do space:insert({i, tostring(i)}) end
+space:get_many({1, {5}, 11, 3})
+index2:get_many({'2', 'x', '10'})
+space:get_many({})
+space:get_many({{'a'}})
+space:get_many(1)
+space:drop()
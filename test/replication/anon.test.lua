@@ -0,0 +1,38 @@
+env = require('test_run')
+test_run = env.new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+for i = 1, 10 do s:insert{i} end
+box.snapshot()
+for i = 11, 20 do s:insert{i} end
+
+test_run:cmd("create server replica_anon with rpl_master=default, script='replication/replica_anon.lua'")
+test_run:cmd("start server replica_anon")
+test_run:cmd("switch replica_anon")
+box.info.id
+box.info.status
+box.space.test:count()
+box.cfg{read_only = false}
+box.cfg{replication_anon = false}
+
+test_run:cmd("switch default")
+-- The anonymous replica isn't registered.
+box.space._cluster:count()
+for i = 21, 30 do s:insert{i} end
+vclock = test_run:get_vclock('default')
+_ = test_run:wait_vclock('replica_anon', vclock)
+
+test_run:cmd("switch replica_anon")
+box.space.test:count()
+box.info.replication[1].upstream.status
+
+test_run:cmd("switch default")
+test_run:cmd("stop server replica_anon")
+test_run:cmd("cleanup server replica_anon")
+test_run:cmd("delete server replica_anon")
+test_run:cleanup_cluster()
+s:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,84 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+socket = require('socket')
+msgpack = require('msgpack')
+
+--
+-- CDC_SUBSCRIBE with space and field filters.
+--
+old_replication_timeout = box.cfg.replication_timeout
+box.cfg{replication_timeout = 10}
+box.schema.user.grant('guest', 'read', 'universe')
+
+s1 = box.schema.space.create('cdc1', {engine = engine})
+_ = s1:create_index('pk')
+s2 = box.schema.space.create('cdc2', {engine = engine})
+_ = s2:create_index('pk')
+
+test_run:cmd("setopt delimiter ';'")
+function cdc_consumer_count()
+    local count = 0
+    for _, consumer in ipairs(box.info.gc().consumers) do
+        if consumer.name:startswith('cdc ') then
+            count = count + 1
+        end
+    end
+    return count
+end;
+function read_row(s)
+    local packet = s:read(msgpack.decode(s:read(5)))
+    local header, pos = msgpack.decode(packet)
+    local body = nil
+    if pos <= #packet then
+        body = msgpack.decode(packet, pos)
+    end
+    return header, body
+end;
+-- Skip heartbeats.
+function read_dml(s)
+    while true do
+        local header, body = read_row(s)
+        if header[0x00] ~= 0 then
+            return header, body
+        end
+    end
+end;
+test_run:cmd("setopt delimiter ''");
+
+cdc_consumer_count()
+
+uri = require('uri').parse(tostring(box.cfg.listen))
+sock = socket.tcp_connect(uri.host, uri.service)
+greeting = sock:read(128)
+-- Subscribe to cdc1 only and ask for fields 2 and 0.
+header = msgpack.encode({[0x00] = 71, [0x01] = 1})
+body = msgpack.encode({[0x26] = {[box.info.id] = box.info.lsn}, [0x2d] = {s1.id}, [0x2e] = {2, 0}})
+_ = sock:write(msgpack.encode(#header + #body) .. header .. body)
+h = read_row(sock)
+h[0x00], h[0x01]
+
+-- The consumer pins xlogs while connected.
+test_run:wait_cond(function() return cdc_consumer_count() == 1 end, 10)
+
+_ = s1:replace{1, 'a', 'b'}
+_ = s2:replace{1, 'x'}
+_ = s1:insert{2, 'c'}
+
+-- Projected tuple of the subscribed space.
+h, b = read_dml(sock)
+h[0x00], b[0x10] == s1.id, b[0x21]
+-- Rows of other spaces are sent as NOPs without a body.
+h, b = read_dml(sock)
+h[0x00], b == nil
+-- Missing fields are replaced with nil.
+h, b = read_dml(sock)
+h[0x00], b[0x10] == s1.id, b[0x21]
+
+-- The consumer is released after disconnect.
+sock:close()
+test_run:wait_cond(function() return cdc_consumer_count() == 0 end, 10)
+
+s1:drop()
+s2:drop()
+box.schema.user.revoke('guest', 'read', 'universe')
+box.cfg{replication_timeout = old_replication_timeout}
@@ -0,0 +1,60 @@
+env = require('test_run')
+test_run = env.new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+for i = 1, 100 do s:replace{i, string.rep('x', 100)} end
+box.snapshot()
+for i = 101, 200 do s:replace{i, string.rep('x', 100)} end
+
+-- The replica asks for compressed rows on JOIN and SUBSCRIBE.
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica_compression.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+box.cfg.replication_compression
+box.space.test:count()
+box.info.replication[1].upstream.status
+box.info.replication[1].upstream.bytes_saved > 0
+
+test_run:cmd("switch default")
+for i = 201, 300 do s:replace{i, string.rep('x', 100)} end
+vclock = test_run:get_vclock('default')
+_ = test_run:wait_vclock("replica", vclock)
+id = test_run:eval('replica', 'return box.info.id')[1]
+test_run:wait_cond(function() return (box.info.replication[id].downstream.bytes_saved or 0) > 0 end, 10)
+
+test_run:cmd("switch replica")
+box.space.test:count()
+box.space.test:get{300}[2] == string.rep('x', 100)
+
+-- Switch compression off on reconnect.
+replication = box.cfg.replication
+box.cfg{replication_compression = false}
+box.cfg{replication = {}}
+box.cfg{replication = replication}
+box.info.replication[1].upstream.status
+box.info.replication[1].upstream.bytes_saved
+test_run:cmd("switch default")
+for i = 301, 400 do s:replace{i, string.rep('x', 100)} end
+vclock = test_run:get_vclock('default')
+_ = test_run:wait_vclock("replica", vclock)
+box.info.replication[id].downstream.bytes_saved
+test_run:cmd("switch replica")
+box.space.test:count()
+
+test_run:cmd("switch default")
+-- Rows are sent in batches even without compression.
+downstream = box.info.replication[id].downstream
+rows, writes = downstream.rows_sent, downstream.writes
+box.begin() for i = 401, 500 do s:replace{i} end box.commit()
+test_run:wait_cond(function() return box.info.replication[id].downstream.rows_sent >= rows + 100 end, 10)
+box.info.replication[id].downstream.writes - writes < 100
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+s:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,49 @@
+env = require('test_run')
+test_run = env.new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+for i = 1, 10 do s:insert{i} end
+box.snapshot()
+for i = 11, 20 do s:insert{i} end
+
+-- A read-only replica to join from.
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+box.cfg{read_only = true}
+test_run:cmd("switch default")
+donor_uri = test_run:eval('replica', 'return box.cfg.listen')[1]
+donor_uuid = test_run:eval('replica', 'return box.info.uuid')[1]
+
+--
+-- A new instance registers on the master and fetches the data
+-- from the replica, then follows both of them.
+--
+test_run:cmd("create server joiner with rpl_master=default, script='replication/replica_join_from_replica.lua'")
+test_run:cmd("start server joiner with args='" .. donor_uri .. "'")
+test_run:grep_log('joiner', 'registering replica at master') ~= nil
+test_run:grep_log('joiner', 'bootstrapping replica from ' .. donor_uuid) ~= nil
+box.space._cluster:count()
+for i = 21, 30 do s:insert{i} end
+vclock = test_run:get_vclock('default')
+_ = test_run:wait_vclock('joiner', vclock)
+
+test_run:cmd("switch joiner")
+box.info.id
+box.space.test:count()
+box.info.replication[1].upstream.status
+box.cfg{replication_join_from_replica = false}
+
+test_run:cmd("switch default")
+test_run:cmd("stop server joiner")
+test_run:cmd("cleanup server joiner")
+test_run:cmd("delete server joiner")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+s:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,107 @@
+env = require('test_run')
+test_run = env.new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+
+box.cfg{replication_apply_fibers = 0}
+box.cfg{replication_apply_fibers = 1000}
+box.cfg.replication_apply_fibers
+
+-- Rows of this space are applied in parallel by primary key.
+s1 = box.schema.space.create('test1', {engine = engine})
+_ = s1:create_index('pk', {parts = {1, 'unsigned', 2, 'string'}})
+_ = s1:create_index('sk', {parts = {3, 'unsigned'}, unique = false})
+-- Rows of this space depend on each other through the unique
+-- secondary index and so are applied one by one.
+s2 = box.schema.space.create('test2', {engine = engine})
+_ = s2:create_index('pk')
+_ = s2:create_index('sk', {parts = {2, 'unsigned'}})
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+replication = box.cfg.replication
+box.cfg{replication_apply_fibers = 4}
+box.cfg{replication = {}}
+box.cfg{replication = replication}
+box.info.replication[1].upstream.status
+
+test_run:cmd("switch default")
+test_run:cmd("setopt delimiter ';'")
+for i = 1, 1000 do
+    s1:replace{i % 100, tostring(i % 7), i}
+    s1:update({i % 50, tostring(i % 7)}, {{'=', 3, i * 2}})
+    if i % 3 == 0 then
+        s1:delete{i % 30, tostring(i % 7)}
+    end
+    s2:delete{(i + 1) % 10}
+    s2:replace{i % 10, i % 20}
+    if i % 100 == 0 then
+        box.schema.space.create('test' .. (i + 1000) / 100):drop()
+    end
+end;
+test_run:cmd("setopt delimiter ''");
+vclock = test_run:get_vclock('default')
+_ = test_run:wait_vclock("replica", vclock)
+
+function digest(s) local d = {} for _, t in s:pairs() do table.insert(d, t) end return d end
+master = {digest(s1), digest(s2)}
+
+test_run:cmd("switch replica")
+box.info.replication[1].upstream.status
+box.info.replication[1].upstream.message
+function digest(s) local d = {} for _, t in s:pairs() do table.insert(d, t) end return d end
+replica = {digest(box.space.test1), digest(box.space.test2)}
+test_run:cmd("switch default")
+replica = test_run:eval('replica', 'return replica')[1]
+#master[1] > 0
+#master[2] > 0
+test_run:cmd("setopt delimiter ';'")
+function equal(a, b)
+    if #a ~= #b then return false end
+    for i = 1, #a do
+        if #a[i] ~= #b[i] then return false end
+        for j = 1, #a[i] do
+            if #a[i][j] ~= #b[i][j] then return false end
+            for k = 1, #a[i][j] do
+                if a[i][j][k] ~= b[i][j][k] then return false end
+            end
+        end
+    end
+    return true
+end;
+test_run:cmd("setopt delimiter ''");
+equal(master, replica)
+
+-- A failed row stops the applier and the rows following it
+-- aren't applied.
+test_run:cmd("switch replica")
+box.space.test1:insert{5000, 'x', 1}
+lsn = box.info.vclock[1]
+test_run:cmd("switch default")
+s1:insert{5000, 'x', 2}
+s1:insert{5001, 'x', 3}
+test_run:cmd("switch replica")
+test_run:wait_cond(function() return box.info.replication[1].upstream.status == 'stopped' end, 10)
+box.info.replication[1].upstream.message
+box.info.vclock[1] == lsn
+box.space.test1:get{5001, 'x'}
+box.space.test1:delete{5000, 'x'}
+box.cfg{replication = {}}
+box.cfg{replication = replication}
+test_run:cmd("switch default")
+vclock = test_run:get_vclock('default')
+_ = test_run:wait_vclock("replica", vclock)
+test_run:cmd("switch replica")
+box.space.test1:get{5000, 'x'}
+box.space.test1:get{5001, 'x'}
+
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+s1:drop()
+s2:drop()
+box.schema.user.revoke('guest', 'replication')
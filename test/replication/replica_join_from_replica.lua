@@ -0,0 +1,13 @@
+#!/usr/bin/env tarantool
+
+-- The URI of the replica to join from is passed in arg[1].
+box.cfg({
+    listen              = os.getenv("LISTEN"),
+    replication         = {os.getenv("MASTER"), arg[1]},
+    memtx_memory        = 107374182,
+    replication_timeout = 0.1,
+    replication_connect_timeout = 0.5,
+    replication_join_from_replica = true,
+})
+
+require('console').listen(os.getenv('ADMIN'))
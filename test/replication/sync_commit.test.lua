@@ -0,0 +1,62 @@
+env = require('test_run')
+test_run = env.new()
+engine = test_run:get_cfg('engine')
+fiber = require('fiber')
+
+box.schema.user.grant('guest', 'replication')
+
+box.cfg{replication_synchro_quorum = 0}
+box.cfg{replication_synchro_quorum = 100}
+box.cfg{replication_synchro_timeout = 0}
+box.cfg.replication_synchro_quorum
+box.cfg.replication_synchro_timeout
+
+s = box.schema.space.create('test', {engine = engine, is_sync = true})
+s.is_sync
+_ = s:create_index('pk')
+s2 = box.schema.space.create('test2', {engine = engine})
+s2.is_sync
+_ = s2:create_index('pk')
+
+-- No replicas to make a quorum: the commit fails on timeout,
+-- but the transaction is committed locally.
+box.cfg{replication_synchro_quorum = 2, replication_synchro_timeout = 0.1}
+s:insert{1}
+s:get{1}
+-- Transactions of other spaces don't wait.
+s2:insert{1}
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+
+box.cfg{replication_synchro_timeout = 10}
+s:insert{2}
+-- The commit returns when the replica has the transaction.
+test_run:cmd("switch replica")
+box.space.test:get{2}
+test_run:cmd("switch default")
+
+-- Many transactions wait for the quorum at the same time.
+ch = fiber.channel(100)
+for i = 3, 102 do fiber.create(function() ch:put((pcall(s.insert, s, {i}))) end) end
+ok = true
+for i = 1, 100 do ok = ch:get() and ok end
+ok
+s:count()
+
+-- Lowering the quorum releases waiting transactions.
+test_run:cmd("stop server replica")
+box.cfg{replication_synchro_timeout = 1000}
+f = fiber.create(function() s:insert{103} end)
+f:status()
+box.cfg{replication_synchro_quorum = 1}
+while f:status() ~= 'dead' do fiber.sleep(0.01) end
+s:get{103}
+
+box.cfg{replication_synchro_timeout = 5}
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+s:drop()
+s2:drop()
+box.schema.user.revoke('guest', 'replication')
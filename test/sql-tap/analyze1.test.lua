@@ -1,6 +1,6 @@
 #!/usr/bin/env tarantool
 test = require("sqltester")
-test:plan(38)
+test:plan(40)
 
 --!./tcltestrunner.lua
 -- 2005 July 22
@@ -546,6 +546,38 @@ test:do_execsql_test(
     -- </analyze-6.1.4>
 })
 
+-- With sql_analysis_limit set, indexes bigger than the limit are
+-- sampled. All tuples of T7 share the value of A, so any sample
+-- gives exact estimates.
+test:do_execsql_test(
+    "analyze-7.1",
+    [[
+        PRAGMA sql_analysis_limit = 10;
+        PRAGMA sql_analysis_limit;
+    ]], {
+    -- <analyze-7.1>
+    10
+    -- </analyze-7.1>
+})
+
+test:do_test(
+    "analyze-7.2",
+    function()
+        test:execsql("CREATE TABLE t7(id INT PRIMARY KEY, a INT);")
+        test:execsql("CREATE INDEX t7a ON t7(a);")
+        for i = 1, 100 do
+            box.sql.execute(string.format("INSERT INTO t7 VALUES(%s, 1);", i))
+        end
+        test:execsql("ANALYZE t7;")
+        test:execsql("PRAGMA sql_analysis_limit = 0;")
+        return test:execsql([[SELECT "idx", "stat" FROM "_sql_stat1"
+                              WHERE "tbl" = 'T7' ORDER BY "idx";]])
+    end, {
+    -- <analyze-7.2>
+    "T7", "100 1", "T7A", "100 100"
+    -- </analyze-7.2>
+})
+
 -- # This test corrupts the database file so it must be the last test
 -- # in the series.
 -- #
@@ -0,0 +1,115 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(8)
+
+--
+-- Joins on columns without an index are executed with an
+-- automatic index built on the inner table instead of scanning
+-- it for each row of the outer one.
+--
+test:do_test(
+    "autoindex1-1.0",
+    function()
+        test:execsql([[
+            CREATE TABLE t1(a INT PRIMARY KEY, b INT);
+            CREATE TABLE t2(c INT PRIMARY KEY, d INT);
+        ]])
+        for i = 1, 100 do
+            test:execsql(string.format("INSERT INTO t1 VALUES(%d, %d);",
+                                       i, i % 10))
+            test:execsql(string.format("INSERT INTO t2 VALUES(%d, %d);",
+                                       i, i % 10))
+        end
+        return test:execsql("SELECT count(*) FROM t1, t2;")
+    end, {
+        -- <autoindex1-1.0>
+        10000
+        -- </autoindex1-1.0>
+    })
+
+test:do_eqp_test(
+    "autoindex1-1.1",
+    [[
+        SELECT count(*) FROM t1, t2 WHERE t1.b = t2.d;
+    ]], {
+        -- <autoindex1-1.1>
+        {0, 0, 0, "SCAN TABLE T1"},
+        {0, 1, 1, "SEARCH TABLE T2 USING AUTOMATIC COVERING INDEX (D=?)"}
+        -- </autoindex1-1.1>
+    })
+
+test:do_execsql_test(
+    "autoindex1-1.2",
+    [[
+        SELECT count(*) FROM t1, t2 WHERE t1.b = t2.d;
+    ]], {
+        -- <autoindex1-1.2>
+        1000
+        -- </autoindex1-1.2>
+    })
+
+test:do_execsql_test(
+    "autoindex1-1.3",
+    [[
+        SELECT t2.c FROM t1, t2 WHERE t1.b = t2.d AND t1.a = 1
+        ORDER BY t2.c;
+    ]], {
+        -- <autoindex1-1.3>
+        1, 11, 21, 31, 41, 51, 61, 71, 81, 91
+        -- </autoindex1-1.3>
+    })
+
+test:do_execsql_test(
+    "autoindex1-1.4",
+    [[
+        PRAGMA automatic_index = 0;
+        SELECT count(*) FROM t1, t2 WHERE t1.b = t2.d;
+    ]], {
+        -- <autoindex1-1.4>
+        1000
+        -- </autoindex1-1.4>
+    })
+
+test:do_eqp_test(
+    "autoindex1-1.5",
+    [[
+        SELECT count(*) FROM t1, t2 WHERE t1.b = t2.d;
+    ]], {
+        -- <autoindex1-1.5>
+        {0, 0, 0, "SCAN TABLE T1"},
+        {0, 1, 1, "SCAN TABLE T2"}
+        -- </autoindex1-1.5>
+    })
+
+--
+-- The automatic index compares keys using the collation of
+-- the join constraint.
+--
+test:do_execsql_test(
+    "autoindex1-2.0",
+    [[
+        PRAGMA automatic_index = 1;
+        CREATE TABLE t3(id INT PRIMARY KEY, s TEXT);
+        CREATE TABLE t4(id INT PRIMARY KEY, s TEXT COLLATE "unicode_ci");
+        INSERT INTO t3 VALUES(1, 'a'), (2, 'B'), (3, 'c');
+        INSERT INTO t4 VALUES(1, 'A'), (2, 'b'), (3, 'd');
+        SELECT t3.id, t4.id FROM t3, t4 WHERE t3.s = t4.s ORDER BY 1;
+    ]], {
+        -- <autoindex1-2.0>
+        1, 1, 2, 2
+        -- </autoindex1-2.0>
+    })
+
+test:do_execsql_test(
+    "autoindex1-2.1",
+    [[
+        DROP TABLE t1;
+        DROP TABLE t2;
+        DROP TABLE t3;
+        DROP TABLE t4;
+    ]], {
+        -- <autoindex1-2.1>
+        -- </autoindex1-2.1>
+    })
+
+test:finish_test()
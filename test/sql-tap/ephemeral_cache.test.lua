@@ -0,0 +1,119 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(9)
+
+--
+-- Small ephemeral spaces are emptied and reused by later
+-- statements needing a space of the same shape. Check that a
+-- reused space holds no rows of a previous statement and that
+-- spaces with a different key definition are not reused.
+--
+test:do_execsql_test(
+    "ephemeral-cache-1.1",
+    [[
+        CREATE TABLE t1(id INT PRIMARY KEY, a INT, s TEXT);
+        INSERT INTO t1 VALUES (1, 1, 'a'), (2, 1, 'A'), (3, 2, 'b');
+        CREATE TABLE t2(id INT PRIMARY KEY, a INT);
+        INSERT INTO t2 VALUES (1, 10), (2, 20), (3, 10);
+        SELECT COUNT(DISTINCT a) FROM t1;
+    ]], {
+        -- <ephemeral-cache-1.1>
+        2
+        -- <ephemeral-cache-1.1>
+    })
+
+test:do_execsql_test(
+    "ephemeral-cache-1.2",
+    [[
+        SELECT COUNT(DISTINCT a) FROM t2;
+    ]], {
+        -- <ephemeral-cache-1.2>
+        2
+        -- <ephemeral-cache-1.2>
+    })
+
+test:do_execsql_test(
+    "ephemeral-cache-1.3",
+    [[
+        DELETE FROM t1 WHERE id = 3;
+        SELECT COUNT(DISTINCT a) FROM t1;
+    ]], {
+        -- <ephemeral-cache-1.3>
+        1
+        -- <ephemeral-cache-1.3>
+    })
+
+test:do_execsql_test(
+    "ephemeral-cache-1.4",
+    [[
+        SELECT a FROM t2 WHERE a IN (SELECT a FROM t1 UNION SELECT 20);
+    ]], {
+        -- <ephemeral-cache-1.4>
+        20
+        -- <ephemeral-cache-1.4>
+    })
+
+-- A space keyed by a case-insensitive collation is not reused
+-- for a binary one and vice versa.
+test:do_execsql_test(
+    "ephemeral-cache-2.1",
+    [[
+        SELECT COUNT(DISTINCT s COLLATE "unicode_ci") FROM t1;
+    ]], {
+        -- <ephemeral-cache-2.1>
+        1
+        -- <ephemeral-cache-2.1>
+    })
+
+test:do_execsql_test(
+    "ephemeral-cache-2.2",
+    [[
+        SELECT COUNT(DISTINCT s COLLATE "binary") FROM t1;
+    ]], {
+        -- <ephemeral-cache-2.2>
+        2
+        -- <ephemeral-cache-2.2>
+    })
+
+test:do_execsql_test(
+    "ephemeral-cache-2.3",
+    [[
+        SELECT COUNT(DISTINCT s COLLATE "unicode_ci") FROM t1;
+    ]], {
+        -- <ephemeral-cache-2.3>
+        1
+        -- <ephemeral-cache-2.3>
+    })
+
+-- A collation dropped and created again with the same id and
+-- different properties is not used through a cached space.
+box.internal.collation.create('eph_coll', 'ICU', 'en-US', {strength='primary'})
+test:do_execsql_test(
+    "ephemeral-cache-3.1",
+    [[
+        SELECT COUNT(DISTINCT s COLLATE "eph_coll") FROM t1;
+    ]], {
+        -- <ephemeral-cache-3.1>
+        1
+        -- <ephemeral-cache-3.1>
+    })
+
+local id = box.space._collation.index.name:get{'eph_coll'}.id
+box.internal.collation.drop('eph_coll')
+box.internal.collation.create('eph_coll', 'ICU', 'en-US', {strength='tertiary'})
+assert(box.space._collation.index.name:get{'eph_coll'}.id == id)
+test:do_execsql_test(
+    "ephemeral-cache-3.2",
+    [[
+        SELECT COUNT(DISTINCT s COLLATE "eph_coll") FROM t1;
+    ]], {
+        -- <ephemeral-cache-3.2>
+        2
+        -- <ephemeral-cache-3.2>
+    })
+
+box.internal.collation.drop('eph_coll')
+box.execute("DROP TABLE t1;")
+box.execute("DROP TABLE t2;")
+
+test:finish_test()
@@ -1,6 +1,6 @@
 #!/usr/bin/env tarantool
 test = require("sqltester")
-test:plan(25)
+test:plan(28)
 
 -- This file implements regression tests for foreign keys.
 
@@ -256,4 +256,41 @@ test:do_select_tests(
         {"6", "SELECT * FROM T13", {1, ""}},
     })
 
+-- Consecutive child rows referring to the same parent row skip
+-- the parent lookup, make sure a missing parent is still found.
+test:do_execsql_test(
+    "fkey1-8.1",
+    [[
+        CREATE TABLE p8 (id INT PRIMARY KEY);
+        CREATE TABLE c8 (id INT PRIMARY KEY, p INT REFERENCES p8);
+        INSERT INTO p8 VALUES (1), (2);
+        INSERT INTO c8 VALUES (1, 1), (2, 1), (3, 2), (4, 2), (5, 1);
+        SELECT count(*) FROM c8;
+    ]], {
+        -- <fkey1-8.1>
+        5
+        -- </fkey1-8.1>
+    })
+
+test:do_catchsql_test(
+    "fkey1-8.2",
+    [[
+        INSERT INTO c8 VALUES (6, 1), (7, 1), (8, 3);
+    ]], {
+        -- <fkey1-8.2>
+        1, "FOREIGN KEY constraint failed"
+        -- </fkey1-8.2>
+    })
+
+test:do_execsql_test(
+    "fkey1-8.3",
+    [[
+        INSERT INTO c8 SELECT id + 10, id FROM p8;
+        SELECT id, p FROM c8 WHERE id > 5;
+    ]], {
+        -- <fkey1-8.3>
+        11, 1, 12, 2
+        -- </fkey1-8.3>
+    })
+
 test:finish_test()
@@ -1,6 +1,6 @@
 #!/usr/bin/env tarantool
 test = require("sqltester")
-test:plan(18)
+test:plan(19)
 
 --!./tcltestrunner.lua
 -- 2005 January 13
@@ -114,6 +114,20 @@ test:do_execsql_test(
         -- </insert3-1.5>
 })
 
+-- Multi-row VALUES into a table with triggers is not staged in
+-- a temporary space, make sure all the triggers still fire.
+test:do_execsql_test(
+    "insert3-1.6",
+    [[
+            INSERT INTO t1(a, b) VALUES('m', 7), ('m', 8);
+            SELECT x, y FROM log WHERE x = 'm' UNION ALL
+                SELECT x, y FROM log2 WHERE x IN ('7', '8') ORDER BY x;
+    ]], {
+        -- <insert3-1.6>
+        "7",1,"8",1,"m",2
+        -- </insert3-1.6>
+})
+
 
 
 test:do_execsql_test(
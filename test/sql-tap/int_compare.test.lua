@@ -0,0 +1,135 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(12)
+
+--
+-- Comparison of two integers is done without conversions.
+--
+test:do_execsql_test(
+    "int-compare-1.1",
+    [[
+        CREATE TABLE t1(id INT PRIMARY KEY, a INT, s TEXT);
+        INSERT INTO t1 VALUES (1, 10, '10'), (2, 9, '9'), (3, -5, '-5');
+        SELECT id FROM t1 WHERE a > 9;
+    ]], {
+        -- <int-compare-1.1>
+        1
+        -- <int-compare-1.1>
+    })
+
+test:do_execsql_test(
+    "int-compare-1.2",
+    [[
+        SELECT id FROM t1 WHERE a < 9;
+    ]], {
+        -- <int-compare-1.2>
+        3
+        -- <int-compare-1.2>
+    })
+
+test:do_execsql_test(
+    "int-compare-1.3",
+    [[
+        SELECT id FROM t1 WHERE a = 9;
+    ]], {
+        -- <int-compare-1.3>
+        2
+        -- <int-compare-1.3>
+    })
+
+test:do_execsql_test(
+    "int-compare-1.4",
+    [[
+        SELECT id FROM t1 WHERE a <> 9;
+    ]], {
+        -- <int-compare-1.4>
+        1, 3
+        -- <int-compare-1.4>
+    })
+
+test:do_execsql_test(
+    "int-compare-1.5",
+    [[
+        SELECT id FROM t1 WHERE a >= -5 AND a <= 9;
+    ]], {
+        -- <int-compare-1.5>
+        2, 3
+        -- <int-compare-1.5>
+    })
+
+test:do_execsql_test(
+    "int-compare-1.6",
+    [[
+        SELECT id FROM t1 WHERE a + 1 > 10;
+    ]], {
+        -- <int-compare-1.6>
+        1
+        -- <int-compare-1.6>
+    })
+
+test:do_execsql_test(
+    "int-compare-1.7",
+    [[
+        SELECT id FROM t1 WHERE a IN (9, 10);
+    ]], {
+        -- <int-compare-1.7>
+        1, 2
+        -- <int-compare-1.7>
+    })
+
+--
+-- A string operand is converted to a number when compared
+-- with an integer, while integers converted to strings are
+-- compared as strings.
+--
+test:do_execsql_test(
+    "int-compare-2.1",
+    [[
+        SELECT id FROM t1 WHERE a > '9';
+    ]], {
+        -- <int-compare-2.1>
+        1
+        -- <int-compare-2.1>
+    })
+
+test:do_execsql_test(
+    "int-compare-2.2",
+    [[
+        SELECT id FROM t1 WHERE a = '10';
+    ]], {
+        -- <int-compare-2.2>
+        1
+        -- <int-compare-2.2>
+    })
+
+test:do_execsql_test(
+    "int-compare-2.3",
+    [[
+        SELECT id FROM t1 WHERE s > 9;
+    ]], {
+        -- <int-compare-2.3>
+        1
+        -- <int-compare-2.3>
+    })
+
+test:do_execsql_test(
+    "int-compare-2.4",
+    [[
+        SELECT id FROM t1 WHERE CAST(a AS TEXT) < '9';
+    ]], {
+        -- <int-compare-2.4>
+        1, 3
+        -- <int-compare-2.4>
+    })
+
+test:do_execsql_test(
+    "int-compare-2.5",
+    [[
+        SELECT id FROM t1 WHERE s < '9';
+    ]], {
+        -- <int-compare-2.5>
+        1, 3
+        -- <int-compare-2.5>
+    })
+
+test:finish_test()
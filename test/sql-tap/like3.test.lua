@@ -1,6 +1,6 @@
 #!/usr/bin/env tarantool
 test = require("sqltester")
-test:plan(7)
+test:plan(8)
 
 --!./tcltestrunner.lua
 -- 2015-03-06
@@ -79,6 +79,17 @@ test:do_execsql_test(
         1, "abc", 2, "ABX", 4, "abc", 5, "ABX"
         -- </like3-2.0>
     })
+-- Case insensitive LIKE on a column without collation uses a
+-- binary range from the uppercase to the lowercase prefix.
+test:do_eqp_test(
+    "like3-2.0.1",
+    [[
+        SELECT a FROM t2 WHERE b LIKE 'ab%';
+    ]], {
+        -- <like3-2.0.1>
+        {0, 0, 0, "SEARCH TABLE T2 USING COVERING INDEX T2BA (B>? AND B<?)"}
+        -- </like3-2.0.1>
+    })
 test:do_execsql_test(
     "like3-2.1",
     [[
@@ -1,6 +1,6 @@
 #!/usr/bin/env tarantool
 test = require("sqltester")
-test:plan(111)
+test:plan(115)
 
 --!./tcltestrunner.lua
 -- 2001 November 6
@@ -1358,4 +1358,53 @@ test:do_execsql_test(
     -- </limit-14.7.2>
 })
 
+--
+-- Once the sorting table holds LIMIT+OFFSET rows, rows which
+-- don't fit are skipped instead of being inserted.
+--
+test:do_execsql_test(
+    "limit-15.1",
+    [[
+        CREATE TABLE t15(id INT PRIMARY KEY, s INT);
+        INSERT INTO t15 VALUES(1, 1), (2, 2), (3, 3), (4, 4), (5, 0),
+                              (6, 1), (7, 2), (8, 3), (9, 4), (10, 0),
+                              (11, 1), (12, 2), (13, 3), (14, 4), (15, 0),
+                              (16, 1), (17, 2), (18, 3), (19, 4), (20, 0);
+        SELECT id FROM t15 ORDER BY s DESC, id LIMIT 3;
+    ]], {
+    -- <limit-15.1>
+    4, 9, 14
+    -- </limit-15.1>
+})
+
+test:do_execsql_test(
+    "limit-15.2",
+    [[
+        SELECT s FROM t15 ORDER BY s LIMIT 4 OFFSET 2;
+    ]], {
+    -- <limit-15.2>
+    0, 0, 1, 1
+    -- </limit-15.2>
+})
+
+test:do_execsql_test(
+    "limit-15.3",
+    [[
+        SELECT id FROM t15 ORDER BY s, id DESC LIMIT 5;
+    ]], {
+    -- <limit-15.3>
+    20, 15, 10, 5, 16
+    -- </limit-15.3>
+})
+
+test:do_execsql_test(
+    "limit-15.4",
+    [[
+        SELECT id, s FROM t15 ORDER BY s DESC, id LIMIT 1 OFFSET 19;
+    ]], {
+    -- <limit-15.4>
+    20, 0
+    -- </limit-15.4>
+})
+
 test:finish_test()
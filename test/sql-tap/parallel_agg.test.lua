@@ -0,0 +1,123 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(9)
+
+--
+-- Aggregates over a full scan of a big memtx space are computed
+-- in the coio thread pool, see OP_ScanAggregate. The results
+-- must be the same as the ones of the usual loop.
+--
+test:do_test(
+    "parallel_agg-1.0",
+    function()
+        test:execsql([[
+            CREATE TABLE t1(id INT PRIMARY KEY, a INT, b NUMBER, s TEXT);
+        ]])
+        local space = box.space.T1
+        for i = 1, 100000, 1000 do
+            box.begin()
+            for j = i, i + 999 do
+                local a = j % 10 ~= 0 and j % 100 or box.NULL
+                space:insert{j, a, j * 0.5, tostring(j % 10)}
+            end
+            box.commit()
+        end
+        return test:execsql("SELECT count(*), count(a) FROM t1;")
+    end, {
+        -- <parallel_agg-1.0>
+        100000, 90000
+        -- </parallel_agg-1.0>
+    })
+
+local function uses_op_scan_aggregate(sql)
+    if test:lsearch(test:execsql("EXPLAIN "..sql), "ScanAggregate") > 0 then
+        return 1
+    end
+    return 0
+end
+
+test:do_test(
+    "parallel_agg-1.1",
+    function()
+        return uses_op_scan_aggregate("SELECT sum(a) FROM t1 WHERE s = '1'")
+    end, {
+        -- <parallel_agg-1.1>
+        box.space.T1.engine == 'memtx' and 1 or 0
+        -- </parallel_agg-1.1>
+    })
+
+test:do_execsql_test(
+    "parallel_agg-1.2",
+    [[
+        SELECT sum(id), sum(a), total(b), avg(a) FROM t1;
+    ]], {
+        -- <parallel_agg-1.2>
+        5000050000, 4500000, 2500025000, 50
+        -- </parallel_agg-1.2>
+    })
+
+test:do_execsql_test(
+    "parallel_agg-1.3",
+    [[
+        SELECT count(*), sum(id), total(b) FROM t1 WHERE a > 50;
+    ]], {
+        -- <parallel_agg-1.3>
+        45000, 2251125000, 1125562500
+        -- </parallel_agg-1.3>
+    })
+
+test:do_execsql_test(
+    "parallel_agg-1.4",
+    [[
+        SELECT count(*), sum(id), total(b) FROM t1 WHERE 50 < a;
+    ]], {
+        -- <parallel_agg-1.4>
+        45000, 2251125000, 1125562500
+        -- </parallel_agg-1.4>
+    })
+
+test:do_execsql_test(
+    "parallel_agg-1.5",
+    [[
+        SELECT count(*), sum(id), avg(a) FROM t1 WHERE s = '3' AND id <= 50000;
+    ]], {
+        -- <parallel_agg-1.5>
+        5000, 124990000, 48
+        -- </parallel_agg-1.5>
+    })
+
+test:do_execsql_test(
+    "parallel_agg-1.6",
+    [[
+        SELECT count(*), sum(id) FROM t1 WHERE b >= 100.5 AND b < 200;
+    ]], {
+        -- <parallel_agg-1.6>
+        199, 59700
+        -- </parallel_agg-1.6>
+    })
+
+test:do_execsql_test(
+    "parallel_agg-1.7",
+    [[
+        SELECT count(*), sum(a), total(a), avg(a) FROM t1 WHERE id < 0;
+    ]], {
+        -- <parallel_agg-1.7>
+        0, "", 0, ""
+        -- </parallel_agg-1.7>
+    })
+
+--
+-- Integer overflow is reported the same way.
+--
+test:do_catchsql_test(
+    "parallel_agg-1.8",
+    [[
+        UPDATE t1 SET a = 9223372036854775807 WHERE id <= 2;
+        SELECT sum(a) FROM t1;
+    ]], {
+        -- <parallel_agg-1.8>
+        1, "integer overflow"
+        -- </parallel_agg-1.8>
+    })
+
+test:finish_test()
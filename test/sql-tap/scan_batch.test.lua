@@ -0,0 +1,64 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(4)
+
+--
+-- Full scans of memtx spaces fetch tuples ahead in batches.
+-- Make sure scans longer than a batch, rewound scans of inner
+-- loops and scans stopped by LIMIT return the same rows as
+-- before.
+--
+test:do_test(
+    "scan_batch-1.0",
+    function()
+        test:execsql([[
+            CREATE TABLE t1(a INT PRIMARY KEY, b INT);
+            CREATE TABLE t2(c INT PRIMARY KEY, d INT);
+        ]])
+        box.begin()
+        for i = 1, 3000 do
+            box.space.T1:insert({i, i % 7})
+        end
+        for i = 1, 50 do
+            box.space.T2:insert({i, i % 5})
+        end
+        box.commit()
+        return test:execsql("SELECT count(*), sum(a) FROM t1 WHERE b > 3;")
+    end, {
+        -- <scan_batch-1.0>
+        1285, 1928358
+        -- </scan_batch-1.0>
+    })
+
+test:do_execsql_test(
+    "scan_batch-1.1",
+    [[
+        SELECT a FROM t1 WHERE b = 2 LIMIT 3;
+    ]], {
+        -- <scan_batch-1.1>
+        2, 9, 16
+        -- </scan_batch-1.1>
+    })
+
+test:do_execsql_test(
+    "scan_batch-1.2",
+    [[
+        SELECT count(*) FROM t2 WHERE d + 1 IN (SELECT b FROM t1);
+    ]], {
+        -- <scan_batch-1.2>
+        50
+        -- </scan_batch-1.2>
+    })
+
+test:do_execsql_test(
+    "scan_batch-1.3",
+    [[
+        SELECT c, (SELECT count(*) FROM t1 WHERE b = d) FROM t2
+        WHERE c < 3;
+    ]], {
+        -- <scan_batch-1.3>
+        1, 429, 2, 429
+        -- </scan_batch-1.3>
+    })
+
+test:finish_test()
@@ -0,0 +1,91 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(7)
+
+--
+-- Comparisons of columns with literals in the WHERE clause of
+-- a full scan are pushed down to the engine iterator. Make sure
+-- the rows it returns are the same as before.
+--
+test:do_execsql_test(
+    "scan_filter-1.0",
+    [[
+        CREATE TABLE t1(id INT PRIMARY KEY, a INT, b NUMBER, s TEXT,
+                        c TEXT COLLATE "unicode_ci");
+        INSERT INTO t1 VALUES(1, 5, 1.5, 'x', 'A');
+        INSERT INTO t1 VALUES(2, 10, 2.5, 'y', 'b');
+        INSERT INTO t1 VALUES(3, NULL, 10, 'z', 'a');
+        INSERT INTO t1 VALUES(4, 20, NULL, NULL, 'B');
+        INSERT INTO t1 VALUES(5, 15, 7, 'x', NULL);
+        SELECT id FROM t1 WHERE a > 9 ORDER BY id;
+    ]], {
+        -- <scan_filter-1.0>
+        2, 4, 5
+        -- </scan_filter-1.0>
+    })
+
+test:do_execsql_test(
+    "scan_filter-1.1",
+    [[
+        SELECT id FROM t1 WHERE a <= 10.5 ORDER BY id;
+    ]], {
+        -- <scan_filter-1.1>
+        1, 2
+        -- </scan_filter-1.1>
+    })
+
+test:do_execsql_test(
+    "scan_filter-1.2",
+    [[
+        SELECT id FROM t1 WHERE b >= 2 AND b < 10 ORDER BY id;
+    ]], {
+        -- <scan_filter-1.2>
+        2, 5
+        -- </scan_filter-1.2>
+    })
+
+test:do_execsql_test(
+    "scan_filter-1.3",
+    [[
+        SELECT id FROM t1 WHERE s = 'x' ORDER BY id;
+    ]], {
+        -- <scan_filter-1.3>
+        1, 5
+        -- </scan_filter-1.3>
+    })
+
+-- The collation of the column is used by the filter.
+test:do_execsql_test(
+    "scan_filter-1.4",
+    [[
+        SELECT id FROM t1 WHERE c = 'a' ORDER BY id;
+    ]], {
+        -- <scan_filter-1.4>
+        1, 3
+        -- </scan_filter-1.4>
+    })
+
+-- ON terms of an outer join don't filter the outer table.
+test:do_execsql_test(
+    "scan_filter-1.5",
+    [[
+        SELECT x.id, count(y.id) FROM t1 AS x LEFT JOIN t1 AS y
+        ON x.a = 5 WHERE x.s = 'x' GROUP BY x.id ORDER BY x.id;
+    ]], {
+        -- <scan_filter-1.5>
+        1, 5, 5, 0
+        -- </scan_filter-1.5>
+    })
+
+test:do_execsql_test(
+    "scan_filter-1.6",
+    [[
+        DELETE FROM t1 WHERE a > 12;
+        SELECT id FROM t1 ORDER BY id;
+    ]], {
+        -- <scan_filter-1.6>
+        1, 2, 3
+        -- </scan_filter-1.6>
+    })
+
+test:finish_test()
@@ -0,0 +1,62 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(3)
+local fiber = require("fiber")
+
+--
+-- Big lists of the sorter are sorted in the coio thread pool
+-- and the tx thread keeps serving other fibers meanwhile.
+--
+local N = 20000
+test:do_test(
+    "sort_offload-1.0",
+    function()
+        test:execsql("CREATE TABLE t1(id INT PRIMARY KEY, s TEXT);")
+        box.begin()
+        for i = 1, N do
+            local key = string.format("%08d", (i * 7919) % N)
+            box.space.T1:insert({i, key .. string.rep("x", 100)})
+        end
+        box.commit()
+        return test:execsql("SELECT count(*) FROM t1;")
+    end, {
+        -- <sort_offload-1.0>
+        N
+        -- </sort_offload-1.0>
+    })
+
+local counter = 0
+local is_running = true
+fiber.create(function()
+    while is_running do
+        counter = counter + 1
+        fiber.sleep(0)
+    end
+end)
+
+local rows
+test:do_test(
+    "sort_offload-1.1",
+    function()
+        local before = counter
+        rows = test:execsql("SELECT s FROM t1 ORDER BY s;")
+        is_running = false
+        return counter > before
+    end,
+    true)
+
+test:do_test(
+    "sort_offload-1.2",
+    function()
+        for i = 1, #rows - 1 do
+            if rows[i] >= rows[i + 1] then
+                return {i, rows[i], rows[i + 1]}
+            end
+        end
+        return #rows
+    end,
+    N)
+
+test:execsql("DROP TABLE t1;")
+
+test:finish_test()
@@ -0,0 +1,52 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(3)
+
+--
+-- Without ANALYZE the planner samples big indexes to estimate
+-- how many rows match a key, so it tells selective indexes
+-- from non-selective ones.
+--
+test:do_test(
+    "stat_sample-1.0",
+    function()
+        test:execsql([[
+            CREATE TABLE t1(id INT PRIMARY KEY, a INT, b INT);
+            CREATE INDEX ia ON t1(a);
+            CREATE INDEX ib ON t1(b);
+        ]])
+        box.begin()
+        for i = 1, 10000 do
+            box.space.T1:insert({i, i % 2, i})
+        end
+        box.commit()
+        return test:execsql("SELECT count(*) FROM t1;")
+    end, {
+        -- <stat_sample-1.0>
+        10000
+        -- </stat_sample-1.0>
+    })
+
+test:do_eqp_test(
+    "stat_sample-1.1",
+    [[
+        SELECT id FROM t1 WHERE a = 1 AND b = 5;
+    ]], {
+        -- <stat_sample-1.1>
+        {0, 0, 0, "SEARCH TABLE T1 USING COVERING INDEX IB (B=?)"}
+        -- </stat_sample-1.1>
+    })
+
+test:do_execsql_test(
+    "stat_sample-1.2",
+    [[
+        SELECT id FROM t1 WHERE a = 1 AND b = 5;
+    ]], {
+        -- <stat_sample-1.2>
+        5
+        -- </stat_sample-1.2>
+    })
+
+test:execsql("DROP TABLE t1;")
+
+test:finish_test()
@@ -0,0 +1,31 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+box.sql.execute('pragma sql_default_engine=\''..engine..'\'')
+
+--
+-- A scan of a vinyl secondary index which only reads fields
+-- stored in the index doesn't look up full tuples in the
+-- primary index.
+--
+box.sql.execute("CREATE TABLE t (id INT PRIMARY KEY, b INT, c TEXT);")
+box.sql.execute("CREATE INDEX tb ON t (b);")
+box.sql.execute("INSERT INTO t VALUES (1, 30, 'a'), (2, 10, 'b'), (3, 20, 'c');")
+test_run:cmd("setopt delimiter ';'")
+function pk_lookups()
+    if engine ~= 'vinyl' then
+        return 0
+    end
+    return box.space.T.index[0]:stat().lookup
+end;
+test_run:cmd("setopt delimiter ''");
+
+lookups = pk_lookups()
+box.sql.execute("SELECT b FROM t INDEXED BY tb WHERE b > 10;")
+box.sql.execute("SELECT id, b FROM t INDEXED BY tb WHERE b >= 10;")
+pk_lookups() - lookups
+
+-- Other fields are read from the primary index.
+box.sql.execute("SELECT b, c FROM t INDEXED BY tb WHERE b > 10;")
+engine == 'memtx' or pk_lookups() - lookups > 0
+
+box.sql.execute("DROP TABLE t;")
@@ -273,6 +273,64 @@ for i = 0, 1000 do cn:execute("INSERT INTO t1 VALUES (null)") end
 _ = cn:execute("INSERT INTO t1 SELECT NULL from t1")
 box.sql.execute('DROP TABLE t1')
 
+--
+-- Prepared statements.
+--
+box.sql.execute('CREATE TABLE t1(id INTEGER PRIMARY KEY, a INTEGER)')
+cn:execute('INSERT INTO t1 VALUES (1, 10), (2, 20)')
+stmt = cn:prepare('SELECT a FROM t1 WHERE id = ?')
+stmt.stmt_id > 0
+stmt.param_count
+stmt.metadata
+cn:execute(stmt.stmt_id, {1})
+cn:execute(stmt.stmt_id, {2})
+-- The same query text gives the same statement.
+cn:prepare('SELECT a FROM t1 WHERE id = ?').stmt_id == stmt.stmt_id
+-- The statement is recompiled after a schema change.
+box.sql.execute('CREATE INDEX t1a ON t1(a)')
+cn:execute(stmt.stmt_id, {2})
+ins = cn:prepare('INSERT INTO t1 VALUES (:id, :a)')
+ins.param_count
+ins.params[1].name == ':id' and ins.params[2].name == ':a'
+ins.metadata
+cn:execute(ins.stmt_id, {{[':id'] = 3}, {[':a'] = 30}})
+cn:execute(stmt.stmt_id, {3})
+-- Statements are recompiled after ANALYZE changes the plan.
+box.sql.execute('CREATE TABLE t2(id INTEGER PRIMARY KEY, a INTEGER, b INTEGER)')
+box.sql.execute('CREATE INDEX t2a ON t2(a)')
+box.sql.execute('CREATE INDEX t2b ON t2(b)')
+for i = 1, 100 do cn:execute('INSERT INTO t2 VALUES (?, 1, ?)', {i, i}) end
+eqp_sql = 'EXPLAIN QUERY PLAN SELECT * FROM t2 WHERE a = 1 AND b < 50'
+eqp = cn:prepare(eqp_sql)
+cn:execute(eqp.stmt_id).rows[1][4]
+cn:execute(eqp_sql).rows[1][4]
+box.sql.execute('ANALYZE')
+cn:execute(eqp.stmt_id).rows[1][4]
+cn:execute(eqp_sql).rows[1][4]
+box.sql.execute('DROP TABLE t2')
+-- Statements are evicted when the cache is shrunk.
+box.cfg{sql_cache_size = 0}
+ok, err = pcall(cn.execute, cn, stmt.stmt_id, {1})
+ok, err.code == box.error.WRONG_QUERY_ID
+cn:prepare('SELECT a FROM t1')
+cn:execute('SELECT a FROM t1 WHERE id = ?', {1})
+box.cfg{sql_cache_size = 5 * 1024 * 1024}
+box.sql.execute('DROP TABLE t1')
+
+--
+-- Streaming of result sets.
+--
+box.sql.execute('CREATE TABLE t1(id INTEGER PRIMARY KEY)')
+for i = 1, 5 do box.sql.execute('INSERT INTO t1 VALUES ('..i..')') end
+chunks = {}
+res = cn:execute('SELECT id FROM t1', nil, {chunk_size = 2}, {on_push = table.insert, on_push_ctx = chunks})
+#chunks, chunks[1][1][1], chunks[2][2][1]
+res.rows
+res = cn:execute('SELECT id FROM t1', nil, {chunk_size = 2})
+#res.rows, res.rows[1][1], res.rows[5][1]
+cn:execute('SELECT id FROM t1', nil, {chunk_size = 0})
+box.sql.execute('DROP TABLE t1')
+
 cn:close()
 
 box.schema.user.revoke('guest', 'read,write,execute', 'universe')
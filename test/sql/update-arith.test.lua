@@ -0,0 +1,30 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+box.sql.execute('pragma sql_default_engine=\''..engine..'\'')
+
+--
+-- UPDATE of an INTEGER NOT NULL column with "col + value" or
+-- "col - value" is done with a tuple_update() arithmetic
+-- operation. Check that the result is the same as before.
+--
+box.sql.execute("CREATE TABLE t (id INT PRIMARY KEY, cnt INT NOT NULL, s TEXT);")
+box.sql.execute("INSERT INTO t VALUES (1, 10, 'a'), (2, 20, 'b');")
+box.sql.execute("UPDATE t SET cnt = cnt + 1 WHERE id = 1;")
+box.sql.execute("UPDATE t SET cnt = 5 + cnt, s = 'c' WHERE id = 2;")
+box.sql.execute("UPDATE t SET cnt = cnt - ? WHERE id = 2;", {3})
+box.sql.execute("UPDATE t SET cnt = cnt + '2';")
+box.sql.execute("UPDATE t SET cnt = cnt + 1.0 WHERE id = 1;")
+box.space.T:select()
+
+-- NULL and non-integer operands fail as the result would.
+box.sql.execute("UPDATE t SET cnt = cnt + NULL WHERE id = 1;")
+box.sql.execute("UPDATE t SET cnt = cnt + 1.5 WHERE id = 1;")
+box.sql.execute("UPDATE OR IGNORE t SET cnt = cnt + NULL WHERE id = 1;")
+box.space.T:select()
+
+-- Overflow is an error too.
+box.sql.execute("UPDATE t SET cnt = 9223372036854775807 WHERE id = 1;")
+box.sql.execute("UPDATE t SET cnt = cnt + 1 WHERE id = 1;")
+box.space.T:select{1}
+
+box.sql.execute("DROP TABLE t;")
@@ -195,12 +195,83 @@ void test_get_set()
 	footer();
 }
 
+static
+void test_sparse()
+{
+	header();
+
+	struct tt_bitset bm;
+	tt_bitset_create_sparse(&bm, realloc);
+	struct tt_bitset_info info;
+
+	/* One page with a few bits is kept as an array. */
+	fail_if(tt_bitset_set(&bm, 100) < 0);
+	fail_if(tt_bitset_set(&bm, 10) < 0);
+	fail_if(tt_bitset_set(&bm, 1000) < 0);
+	fail_unless(tt_bitset_set(&bm, 10) == 1);
+	tt_bitset_info(&bm, &info);
+	fail_unless(info.pages == 1 && info.array_pages == 1);
+	fail_unless(info.mem_size < info.page_total_size);
+	fail_unless(tt_bitset_test(&bm, 10));
+	fail_unless(tt_bitset_test(&bm, 100));
+	fail_unless(tt_bitset_test(&bm, 1000));
+	fail_if(tt_bitset_test(&bm, 11));
+
+	/* A filled up array is converted to a bitmap. */
+	const size_t PAGE_BIT = info.page_data_size * CHAR_BIT;
+	for (size_t i = 0; i < PAGE_BIT; i += 2)
+		fail_if(tt_bitset_set(&bm, i) < 0);
+	fail_if(tt_bitset_set(&bm, 1001) < 0);
+	tt_bitset_info(&bm, &info);
+	fail_unless(info.pages == 1 && info.array_pages == 0);
+	fail_unless(tt_bitset_cardinality(&bm) == PAGE_BIT / 2 + 1);
+
+	/* And back to an array once most bits are cleared. */
+	for (size_t i = 0; i < PAGE_BIT; i += 2) {
+		if (i % 64 != 0)
+			fail_unless(tt_bitset_clear(&bm, i) == 1);
+	}
+	tt_bitset_info(&bm, &info);
+	fail_unless(info.pages == 1 && info.array_pages == 1);
+	for (size_t i = 0; i < PAGE_BIT; i++) {
+		bool is_set = i % 64 == 0 || i == 1001;
+		fail_unless(tt_bitset_test(&bm, i) == is_set);
+	}
+	tt_bitset_destroy(&bm);
+
+	/* Compare with a dense bitset on random data. */
+	tt_bitset_create_sparse(&bm, realloc);
+	struct tt_bitset dense;
+	tt_bitset_create(&dense, realloc);
+	for (size_t k = 0; k < (1 << 16); k++) {
+		size_t pos = rand() % (1 << 19);
+		if (rand() % 3 == 0) {
+			fail_unless(tt_bitset_clear(&bm, pos) ==
+				    tt_bitset_clear(&dense, pos));
+		} else {
+			fail_unless(tt_bitset_set(&bm, pos) ==
+				    tt_bitset_set(&dense, pos));
+		}
+	}
+	fail_unless(tt_bitset_cardinality(&bm) ==
+		    tt_bitset_cardinality(&dense));
+	for (size_t pos = 0; pos < (1 << 19); pos++)
+		fail_unless(tt_bitset_test(&bm, pos) ==
+			    tt_bitset_test(&dense, pos));
+	tt_bitset_destroy(&dense);
+
+	tt_bitset_destroy(&bm);
+
+	footer();
+}
+
 int main(int argc, char *argv[])
 {
 	setbuf(stdout, NULL);
 	srand(time(NULL));
 	test_cardinality();
 	test_get_set();
+	test_sparse();
 
 	return 0;
 }
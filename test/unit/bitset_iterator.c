@@ -478,6 +478,79 @@ void test_disjunction()
 	footer();
 }
 
+static
+void test_sparse()
+{
+	header();
+
+	enum { BITSETS_SIZE = 8, MAX_POS = 1 << 16 };
+	struct tt_bitset **bitsets = bitsets_create(BITSETS_SIZE);
+	/* Mix sparse and dense bitsets of different density. */
+	for (size_t b = 0; b < BITSETS_SIZE; b += 2) {
+		tt_bitset_destroy(bitsets[b]);
+		tt_bitset_create_sparse(bitsets[b], realloc);
+	}
+	for (size_t b = 0; b < BITSETS_SIZE; b++) {
+		size_t step = 1 + b * 3;
+		for (size_t pos = rand() % step; pos < MAX_POS;
+		     pos += 1 + rand() % step)
+			tt_bitset_set(bitsets[b], pos);
+	}
+
+	/* (b0 & ~b1 & b2) | (b3 & ~b4) | (~b5 & b6 & b7) */
+	static const int PARAMS[][3] = {
+		{0, -1, 2}, {3, -4, BITSETS_SIZE}, {-5, 6, 7},
+	};
+	enum { CONJS = sizeof(PARAMS) / sizeof(PARAMS[0]) };
+	struct tt_bitset_expr expr;
+	tt_bitset_expr_create(&expr, realloc);
+	for (size_t c = 0; c < CONJS; c++) {
+		fail_unless(tt_bitset_expr_add_conj(&expr) == 0);
+		for (size_t p = 0; p < 3; p++) {
+			int b = PARAMS[c][p];
+			if (b == BITSETS_SIZE)
+				continue;
+			fail_unless(tt_bitset_expr_add_param(&expr,
+					b < 0 ? -b : b, b < 0) == 0);
+		}
+	}
+
+	struct tt_bitset_iterator it;
+	tt_bitset_iterator_create(&it, realloc);
+	fail_unless(
+		tt_bitset_iterator_init(&it, &expr, bitsets, BITSETS_SIZE) == 0);
+	tt_bitset_expr_destroy(&expr);
+
+	size_t next = tt_bitset_iterator_next(&it);
+	for (size_t pos = 0; pos < MAX_POS; pos++) {
+		bool match = false;
+		for (size_t c = 0; c < CONJS && !match; c++) {
+			match = true;
+			for (size_t p = 0; p < 3; p++) {
+				int b = PARAMS[c][p];
+				if (b == BITSETS_SIZE)
+					continue;
+				bool is_set = tt_bitset_test(bitsets[b < 0 ?
+								     -b : b],
+							     pos);
+				if (is_set == (b < 0))
+					match = false;
+			}
+		}
+		if (!match)
+			continue;
+		fail_unless(next == pos);
+		next = tt_bitset_iterator_next(&it);
+	}
+	fail_unless(next == SIZE_MAX);
+
+	tt_bitset_iterator_destroy(&it);
+
+	bitsets_destroy(bitsets, BITSETS_SIZE);
+
+	footer();
+}
+
 int main(void)
 {
 	setbuf(stdout, NULL);
@@ -493,6 +566,7 @@ int main(void)
 	test_not_empty();
 	test_not_last();
 	test_disjunction();
+	test_sparse();
 
 	return 0;
 }
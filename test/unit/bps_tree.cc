@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #include <inttypes.h>
 #include <time.h>
 
@@ -70,6 +71,27 @@ compare(type_t a, type_t b);
 #define bps_tree_key_t uint32_t
 #define bps_tree_arg_t int
 #include "salad/bps_tree.h"
+#undef BPS_TREE_NAME
+#undef BPS_TREE_BLOCK_SIZE
+#undef BPS_TREE_EXTENT_SIZE
+#undef BPS_TREE_COMPARE
+#undef BPS_TREE_COMPARE_KEY
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
+#undef bps_tree_arg_t
+
+/* tree with subtree cardinalities in inner blocks */
+#define BPS_TREE_NAME card
+#define BPS_TREE_BLOCK_SIZE 128 /* value is to low specially for tests */
+#define BPS_TREE_EXTENT_SIZE 2048 /* value is to low specially for tests */
+#define BPS_TREE_COMPARE(a, b, arg) compare(a, b)
+#define BPS_TREE_COMPARE_KEY(a, b, arg) compare(a, b)
+#define bps_tree_elem_t type_t
+#define bps_tree_key_t type_t
+#define bps_tree_arg_t int
+#define BPS_INNER_CARD
+#include "salad/bps_tree.h"
+#undef BPS_INNER_CARD
 
 #define bps_insert_and_check(tree_name, tree, elem, replaced) \
 {\
@@ -792,6 +814,112 @@ insert_get_iterator()
 	footer();
 }
 
+static void
+inner_card_check()
+{
+	header();
+
+	card tree;
+	card_create(&tree, 0, extent_alloc, extent_free, &extents_count);
+
+	const int test_count = 2000;
+	/* set[i] is true if 2 * i is in the tree */
+	bool set[test_count];
+	memset(set, 0, sizeof(set));
+	for (int round = 0; round < 20000; round++) {
+		int i = rand() % test_count;
+		if (set[i]) {
+			if (card_delete(&tree, 2 * i))
+				fail("delete failed", "true");
+		} else {
+			if (card_insert(&tree, 2 * i, NULL))
+				fail("insert failed", "true");
+		}
+		set[i] = !set[i];
+		if (round % 100 != 0)
+			continue;
+		if (card_debug_check(&tree))
+			fail("debug check nonzero", "true");
+		size_t offset = 0;
+		for (int j = 0; j < test_count; j++) {
+			size_t lower, upper;
+			card_lower_bound_get_offset(&tree, 2 * j, NULL, &lower);
+			card_upper_bound_get_offset(&tree, 2 * j, NULL, &upper);
+			if (lower != offset)
+				fail("wrong lower bound offset", "true");
+			if (upper != offset + set[j])
+				fail("wrong upper bound offset", "true");
+			card_lower_bound_get_offset(&tree, 2 * j + 1, NULL,
+						    &lower);
+			if (lower != upper)
+				fail("wrong lower bound offset", "true");
+			if (set[j]) {
+				card_iterator itr =
+					card_iterator_at(&tree, offset);
+				type_t *v = card_iterator_get_elem(&tree, &itr);
+				if (v == NULL || *v != 2 * j)
+					fail("wrong iterator_at result", "true");
+			}
+			offset += set[j];
+		}
+		card_iterator itr = card_iterator_at(&tree, offset);
+		if (!card_iterator_is_invalid(&itr))
+			fail("iterator_at past the end is valid", "true");
+	}
+	card_destroy(&tree);
+
+	type_t arr[test_count];
+	for (int i = 0; i < test_count; i++)
+		arr[i] = i;
+	card_create(&tree, 0, extent_alloc, extent_free, &extents_count);
+	if (card_build(&tree, arr, test_count))
+		fail("building failed", "true");
+	if (card_debug_check(&tree))
+		fail("debug check nonzero", "true");
+	for (int i = 0; i < test_count; i++) {
+		card_iterator itr = card_iterator_at(&tree, i);
+		type_t *v = card_iterator_get_elem(&tree, &itr);
+		if (v == NULL || *v != i)
+			fail("wrong iterator_at result", "true");
+	}
+	card_destroy(&tree);
+
+	footer();
+}
+
+static void
+find_batch_check()
+{
+	header();
+
+	test tree;
+	test_create(&tree, 0, extent_alloc, extent_free, &extents_count);
+	for (type_t i = 0; i < 10000; i += 2)
+		test_insert(&tree, i, NULL);
+
+	const int key_count = 1000;
+	type_t keys[key_count];
+	type_t *results[key_count];
+	for (int i = 0; i < key_count; i++)
+		keys[i] = rand() % 10000;
+	test_find_batch(&tree, keys, key_count, results);
+	for (int i = 0; i < key_count; i++) {
+		if (results[i] != test_find(&tree, keys[i]))
+			fail("batch find result differs from find", "true");
+	}
+	test_destroy(&tree);
+
+	test_create(&tree, 0, extent_alloc, extent_free, &extents_count);
+	test_find_batch(&tree, keys, key_count, results);
+	for (int i = 0; i < key_count; i++) {
+		if (results[i] != NULL)
+			fail("found in an empty tree", "true");
+	}
+	test_destroy(&tree);
+
+	footer();
+}
+
 int
 main(void)
 {
@@ -806,4 +934,8 @@ main(void)
 	if (extents_count != 0)
 		fail("memory leak!", "true");
 	insert_get_iterator();
+	inner_card_check();
+	find_batch_check();
+	if (extents_count != 0)
+		fail("memory leak!", "true");
 }
@@ -17,7 +17,7 @@ int
 main()
 {
 	header();
-	plan(38);
+	plan(44);
 
 	srand(time(NULL));
 	double now = rand();
@@ -89,6 +89,35 @@ main()
 		   interval);
 	}
 
+	bool is_due;
+	checkpoint_schedule_cfg(&sched, now, 3600);
+	checkpoint_schedule_set_window(&sched, 600);
+	double t = checkpoint_schedule_timeout(&sched, now);
+	double a = checkpoint_schedule_adjust(&sched, now,
+					      CHECKPOINT_LOAD_IDLE, &is_due);
+	ok(feq(a, t - 600) && !is_due, "load window - wait for window");
+
+	now += t - 300;
+	a = checkpoint_schedule_adjust(&sched, now,
+				       CHECKPOINT_LOAD_IDLE, &is_due);
+	ok(feq(a, 0) && is_due, "load window - idle before schedule");
+	a = checkpoint_schedule_adjust(&sched, now,
+				       CHECKPOINT_LOAD_NORMAL, &is_due);
+	ok(feq(a, 1) && !is_due, "load window - normal before schedule");
+
+	now += 300;
+	a = checkpoint_schedule_adjust(&sched, now,
+				       CHECKPOINT_LOAD_BUSY, &is_due);
+	ok(feq(a, 1) && !is_due, "load window - busy after schedule");
+	a = checkpoint_schedule_adjust(&sched, now,
+				       CHECKPOINT_LOAD_NORMAL, &is_due);
+	ok(feq(a, 0) && is_due, "load window - normal after schedule");
+
+	now += 599.5;
+	a = checkpoint_schedule_adjust(&sched, now,
+				       CHECKPOINT_LOAD_BUSY, &is_due);
+	ok(feq(a, 0) && is_due, "load window - busy past window");
+
 	check_plan();
 	footer();
 
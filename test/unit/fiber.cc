@@ -2,6 +2,34 @@
 #include "fiber.h"
 #include "unit.h"
 #include "trivia/util.h"
+#include "trivia/config.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef __THROW
+#define __THROW
+#endif
+
+/** Number of madvise() calls and the range of the last one. */
+static int madvise_count;
+static void *madvise_addr;
+static size_t madvise_len;
+
+/**
+ * Intercept madvise() to see fiber stacks being trimmed on
+ * recycle: the pages are freed lazily, so their residency
+ * can't be checked reliably.
+ */
+extern "C" int
+madvise(void *addr, size_t len, int advice) __THROW
+{
+	madvise_count++;
+	madvise_addr = addr;
+	madvise_len = len;
+	return syscall(SYS_madvise, addr, len, advice);
+}
 
 static int
 noop_f(va_list ap)
@@ -68,6 +96,109 @@ test_stack_f(va_list ap)
 	return 0;
 }
 
+static void NOINLINE
+stack_expand_to(void *ptr, size_t depth)
+{
+	char buf[2048];
+	memset(buf, 0x45, 2048);
+	ptrdiff_t stack_diff = (buf - (char *)ptr);
+	stack_diff = stack_diff >= 0 ? stack_diff : -stack_diff;
+	if (stack_diff < (ptrdiff_t)depth)
+		stack_expand_to(ptr, depth);
+}
+
+static int
+deep_stack_f(va_list ap)
+{
+	size_t depth = va_arg(ap, size_t);
+	char s;
+	stack_expand_to(&s, depth);
+	return 0;
+}
+
+static void
+fiber_custom_stack_test()
+{
+	header();
+
+	size_t stack_size = 512 * 1024;
+	struct fiber_attr *fiber_attr = fiber_attr_new();
+	fiber_attr_setstacksize(fiber_attr, stack_size);
+
+	/* A deep stack is trimmed on recycle. */
+	struct fiber *fiber = fiber_new_ex("deep_stack", fiber_attr,
+					   deep_stack_f);
+	if (fiber == NULL)
+		diag_raise();
+	fiber_set_joinable(fiber, true);
+	int count = madvise_count;
+	fiber_start(fiber, stack_size / 2);
+	fiber_join(fiber);
+#if !ENABLE_ASAN
+	if (madvise_count == count)
+		fail("deep stack is not trimmed", "");
+	if ((char *)madvise_addr < (char *)fiber->stack ||
+	    (char *)madvise_addr + madvise_len >
+	    (char *)fiber->stack + fiber->stack_size ||
+	    madvise_len >= fiber->stack_size)
+		fail("trimmed range is out of the unused stack", "");
+#endif
+	note("deep stack is trimmed");
+
+	/* A dead fiber with the same stack size is reused. */
+	struct fiber *reused = fiber_new_ex("shallow_stack", fiber_attr,
+					    noop_f);
+	if (reused != fiber)
+		fail("custom stack fiber is not reused", "");
+	fiber_set_joinable(reused, true);
+	count = madvise_count;
+	fiber_wakeup(reused);
+	fiber_join(reused);
+	if (madvise_count != count)
+		fail("shallow stack is trimmed", "");
+	note("custom stack fiber is reused");
+
+	/* The trimmed stack is usable after reuse. */
+	reused = fiber_new_ex("deep_stack", fiber_attr, deep_stack_f);
+	if (reused != fiber)
+		fail("custom stack fiber is not reused", "");
+	fiber_set_joinable(reused, true);
+	fiber_start(reused, stack_size / 2);
+	fiber_join(reused);
+	note("trimmed stack is usable");
+
+	/* A fiber with another stack size isn't reused. */
+	fiber_attr_setstacksize(fiber_attr, stack_size * 2);
+	struct fiber *other = fiber_new_ex("other_stack", fiber_attr, noop_f);
+	if (other == NULL)
+		diag_raise();
+	if (other == fiber)
+		fail("fiber with another stack size is reused", "");
+	fiber_set_joinable(other, true);
+	fiber_wakeup(other);
+	fiber_join(other);
+	note("another stack size is not reused");
+
+	/* The cache of dead custom stack fibers is bounded. */
+	struct fiber *fibers[100];
+	for (int i = 0; i < (int)lengthof(fibers); i++) {
+		fiber_attr_setstacksize(fiber_attr, 65536 + i * 4096);
+		fibers[i] = fiber_new_ex("bounded", fiber_attr, noop_f);
+		if (fibers[i] == NULL)
+			diag_raise();
+		fiber_set_joinable(fibers[i], true);
+		fiber_wakeup(fibers[i]);
+	}
+	for (int i = 0; i < (int)lengthof(fibers); i++)
+		fiber_join(fibers[i]);
+	if (cord()->dead_custom_count > 64)
+		fail("dead custom stack fibers are not bounded", "");
+	note("dead custom stack fibers are bounded");
+
+	fiber_attr_delete(fiber_attr);
+	footer();
+}
+
 static void
 fiber_join_test()
 {
@@ -166,6 +297,7 @@ main_f(va_list ap)
 {
 	fiber_name_test();
 	fiber_join_test();
+	fiber_custom_stack_test();
 	ev_break(loop(), EVBREAK_ALL);
 	return 0;
 }
@@ -78,12 +78,52 @@ fiber_channel_get()
 	status = check_plan();
 }
 
+void
+fiber_channel_many()
+{
+	header();
+	plan(6);
+
+	struct fiber_channel *channel = fiber_channel_new(2);
+
+	struct ipc_value *values[3];
+	for (int i = 0; i < 3; i++) {
+		values[i] = ipc_value_new();
+		values[i]->i = i;
+	}
+	struct ipc_msg *msgs[3];
+	for (int i = 0; i < 3; i++)
+		msgs[i] = &values[i]->base;
+	ok(fiber_channel_put_msg_many_timeout(channel, msgs, 3, 0) == 2,
+	   "fiber_channel_put_msg_many_timeout(full)");
+	ok(fiber_channel_count(channel) == 2, "fiber_channel_count(2)");
+
+	struct ipc_msg *got[3];
+	ok(fiber_channel_get_msg_many_timeout(channel, got, 3, 0) == 2,
+	   "fiber_channel_get_msg_many_timeout()");
+	ok(got[0] == msgs[0] && got[1] == msgs[1], "messages order");
+	ok(fiber_channel_get_msg_many_timeout(channel, got, 3, 0) == -1,
+	   "fiber_channel_get_msg_many_timeout(empty)");
+
+	fiber_channel_close(channel);
+	ok(fiber_channel_put_msg_many_timeout(channel, &msgs[2], 1, 0) == -1,
+	   "fiber_channel_put_msg_many_timeout(closed)");
+
+	for (int i = 0; i < 3; i++)
+		ipc_value_delete(msgs[i]);
+	fiber_channel_delete(channel);
+
+	footer();
+	status = check_plan();
+}
+
 int
 main_f(va_list ap)
 {
 	(void) ap;
 	fiber_channel_basic();
 	fiber_channel_get();
+	fiber_channel_many();
 	ev_break(loop(), EVBREAK_ALL);
 	return 0;
 }
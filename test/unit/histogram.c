@@ -164,6 +164,8 @@ test_percentile(void)
 		}
 		int64_t result = histogram_percentile(hist, pct);
 		fail_if(result != expected);
+		result = histogram_permille(hist, pct * 10);
+		fail_if(result != expected);
 		int64_t result_lo = histogram_percentile_lower(hist, pct);
 		fail_if(result_lo != expected_lo);
 	}
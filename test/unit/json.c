@@ -502,17 +502,76 @@ test_path_snprint()
 	footer();
 }
 
+void
+test_multikey()
+{
+	header();
+	plan(10);
+
+	struct json_lexer lexer;
+	struct json_token token;
+	const char *path = "[1][*].name";
+	int path_len = strlen(path);
+	json_lexer_create(&lexer, path, path_len, INDEX_BASE);
+	json_lexer_next_token(&lexer, &token);
+	is(json_lexer_next_token(&lexer, &token), 0, "parse <[*]>");
+	is(token.type, JSON_TOKEN_ANY, "<[*]> is any");
+
+	json_lexer_create(&lexer, "[*", 2, INDEX_BASE);
+	is(json_lexer_next_token(&lexer, &token), 3,
+	   "error on position 3 for <[*>");
+
+	is(json_path_multikey_offset(path, path_len, INDEX_BASE), 3,
+	   "multikey offset");
+	is(json_path_multikey_offset("[1].name", 8, INDEX_BASE), 8,
+	   "no multikey offset");
+	is(json_path_cmp("[1][*]", 6, "[1][*]", 6, INDEX_BASE), 0,
+	   "[*] is equal to [*]");
+	isnt(json_path_cmp("[1][*]", 6, "[1][1]", 6, INDEX_BASE), 0,
+	     "[*] is not equal to [1]");
+
+	struct json_tree tree;
+	int rc = json_tree_create(&tree);
+	fail_if(rc != 0);
+	struct test_struct records[6];
+	int records_idx = 0;
+	struct test_struct *node, *node_tmp;
+	node = test_add_path(&tree, path, path_len, records, &records_idx);
+	test_add_path(&tree, "[1][*].id", strlen("[1][*].id"), records,
+		      &records_idx);
+	struct test_struct *found =
+		json_tree_lookup_path_entry(&tree, &tree.root, path, path_len,
+					    INDEX_BASE, struct test_struct,
+					    node);
+	is(found, node, "lookup by path with [*]");
+	is(json_token_is_multikey(node->node.parent->parent), true,
+	   "array of [*] is multikey");
+
+	char buf[64];
+	rc = json_tree_snprint_path(buf, sizeof(buf), &node->node, INDEX_BASE);
+	is(strcmp(buf, "[1][*][\"name\"]"), 0, "print path with [*]");
+
+	json_tree_foreach_entry_safe(node, &tree.root, struct test_struct,
+				     node, node_tmp)
+		json_tree_del(&tree, &node->node);
+	json_tree_destroy(&tree);
+
+	check_plan();
+	footer();
+}
+
 int
 main()
 {
 	header();
-	plan(5);
+	plan(6);
 
 	test_basic();
 	test_errors();
 	test_tree();
 	test_path_cmp();
 	test_path_snprint();
+	test_multikey();
 
 	int rc = check_plan();
 	footer();
@@ -318,6 +318,47 @@ iterator_freeze_check()
 	footer();
 }
 
+static void
+reserve_test()
+{
+	header();
+
+	struct light_core ht;
+	light_create(&ht, light_extent_size,
+		     my_light_alloc, my_light_free, &extents_count, 0);
+	const size_t count = 100000;
+	if (light_reserve(&ht, count) != 0)
+		fail("reserve failed!", "true");
+	if (ht.table_size < count || ht.count != 0)
+		fail("reserved size check failed!", "true");
+	if (light_selfcheck(&ht))
+		fail("internal test failed!", "true");
+
+	/* Filling the reserved table doesn't allocate */
+	uint32_t table_size = ht.table_size;
+	size_t extents = extents_count;
+	for (size_t i = 0; i < count; i++) {
+		hash_value_t val = i * 7;
+		light_insert(&ht, hash(val), val);
+	}
+	if (ht.table_size != table_size || extents_count != extents)
+		fail("table grew after reserve!", "true");
+	for (size_t i = 0; i < count; i++) {
+		hash_value_t val = i * 7;
+		if (light_find(&ht, hash(val), val) == light_end)
+			fail("find key failed!", "true");
+	}
+	if (light_selfcheck(&ht))
+		fail("internal test failed!", "true");
+
+	/* Reserving less than there is does nothing */
+	if (light_reserve(&ht, count / 2) != 0 || ht.table_size != table_size)
+		fail("reserve shrank the table!", "true");
+	light_destroy(&ht);
+
+	footer();
+}
+
 int
 main(int, const char**)
 {
@@ -326,6 +367,7 @@ main(int, const char**)
 	collision_test();
 	iterator_test();
 	iterator_freeze_check();
+	reserve_test();
 	if (extents_count != 0)
 		fail("memory leak!", "true");
 }
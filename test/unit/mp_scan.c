@@ -0,0 +1,92 @@
+#include "mp_scan.h"
+#include "unit.h"
+
+#include <string.h>
+
+static void
+test_scalar_run(void)
+{
+	header();
+	plan(5);
+
+	char buf[64];
+	memset(buf, 1, 40);
+	buf[40] = (char)0xa1;
+	is(mp_scalar_run(buf, buf + 41, 100), 40, "fixint run");
+	is(mp_scalar_run(buf, buf + 41, 10), 10, "run limited by count");
+	is(mp_scalar_run(buf, buf + 20, 100), 20, "run limited by end");
+
+	const char mixed[] = {
+		(char)0xff, (char)0xe0, (char)0xc0, (char)0xc2,
+		(char)0xc3, (char)0x7f, (char)0x00, (char)0xcc,
+	};
+	is(mp_scalar_run(mixed, mixed + sizeof(mixed), 100), 7,
+	   "nil, booleans and negative fixints");
+	is(mp_scalar_run(mixed, mixed, 100), 0, "empty buffer");
+
+	check_plan();
+	footer();
+}
+
+static void
+check_same_as_mp_check(const char *data, const char *end, const char *msg)
+{
+	const char *pos = data;
+	const char *fast_pos = data;
+	int rc = mp_check(&pos, end);
+	int fast_rc = mp_check_fast(&fast_pos, end);
+	is(fast_rc != 0, rc != 0, "%s: result", msg);
+	ok(rc != 0 || pos == fast_pos, "%s: position", msg);
+}
+
+static void
+test_check_fast(void)
+{
+	header();
+	plan(12);
+
+	char buf[1024];
+	char *end = mp_encode_array(buf, 100);
+	for (int i = 0; i < 100; i++)
+		end = mp_encode_uint(end, i % 7 == 0 ? 1000 + i : i);
+	check_same_as_mp_check(buf, end, "integers");
+	check_same_as_mp_check(buf, end - 1, "truncated integers");
+
+	end = mp_encode_array(buf, 6);
+	end = mp_encode_int(end, -5);
+	end = mp_encode_str(end, "abc", 3);
+	end = mp_encode_map(end, 1);
+	end = mp_encode_str(end, "key", 3);
+	end = mp_encode_array(end, 2);
+	end = mp_encode_nil(end);
+	end = mp_encode_bool(end, true);
+	end = mp_encode_double(end, 1.5);
+	end = mp_encode_uint(end, 7);
+	end = mp_encode_nil(end);
+	check_same_as_mp_check(buf, end, "nested");
+	check_same_as_mp_check(buf, end - 3, "truncated nested");
+
+	end = mp_encode_array(buf, 3);
+	end = mp_encode_uint(end, 1);
+	check_same_as_mp_check(buf, end, "missing elements");
+
+	end = mp_encode_str(buf, "not an array", 12);
+	check_same_as_mp_check(buf, end, "string");
+
+	check_plan();
+	footer();
+}
+
+int
+main(void)
+{
+	header();
+	plan(2);
+
+	test_scalar_run();
+	test_check_fast();
+
+	int rc = check_plan();
+	footer();
+	return rc;
+}
@@ -276,12 +276,92 @@ neighbor_test()
 	footer();
 }
 
+static void
+bulk_load_check()
+{
+	struct rtree_rect rect;
+	struct rtree_iterator iterator;
+	rtree_iterator_init(&iterator);
+	const size_t rounds = 2000;
+
+	header();
+
+	struct rtree tree, ref_tree;
+	rtree_init(&tree, 2, extent_size, extent_alloc, extent_free,
+		   &page_count, RTREE_EUCLID);
+	rtree_init(&ref_tree, 2, extent_size, extent_alloc, extent_free,
+		   &page_count, RTREE_EUCLID);
+
+	size_t item_size = rtree_bulk_item_size(&tree);
+	char *items = (char *)malloc(rounds * item_size);
+	for (size_t i = 1; i <= rounds; i++) {
+		coord_t x = (i * 7919) % 2003, y = (i * 104729) % 1000;
+		rtree_set2d(&rect, x, y, x + 0.5, y + 0.5);
+		rtree_bulk_item_set(&tree, items, i - 1, &rect, (record_t)i);
+		rtree_insert(&ref_tree, &rect, (record_t)i);
+	}
+	rtree_bulk_load(&tree, items, rounds);
+	free(items);
+
+	if (rtree_number_of_records(&tree) != rounds)
+		fail("Tree count mismatch", "true");
+	if (rtree_used_size(&tree) >= rtree_used_size(&ref_tree))
+		fail("bulk loaded tree is packed", "false");
+	for (size_t i = 1; i <= rounds; i++) {
+		coord_t x = (i * 7919) % 2003, y = (i * 104729) % 1000;
+		rtree_set2d(&rect, x, y, x + 0.5, y + 0.5);
+		if (!rtree_search(&tree, &rect, SOP_EQUALS, &iterator))
+			fail("element in tree", "false");
+		if (rtree_iterator_next(&iterator) != (record_t)i)
+			fail("right search result", "true");
+	}
+	for (coord_t c = 0; c < 1000; c += 97) {
+		rtree_set2d(&rect, 2 * c, c, 2 * c + 200, c + 50);
+		size_t n = 0, ref_n = 0;
+		if (rtree_search(&tree, &rect, SOP_OVERLAPS, &iterator))
+			while (rtree_iterator_next(&iterator) != NULL)
+				n++;
+		if (rtree_search(&ref_tree, &rect, SOP_OVERLAPS, &iterator))
+			while (rtree_iterator_next(&iterator) != NULL)
+				ref_n++;
+		if (n != ref_n)
+			fail("overlaps count matches", "false");
+	}
+	/* The tree stays consistent on further modifications */
+	for (size_t i = 1; i <= rounds; i += 2) {
+		coord_t x = (i * 7919) % 2003, y = (i * 104729) % 1000;
+		rtree_set2d(&rect, x, y, x + 0.5, y + 0.5);
+		if (!rtree_remove(&tree, &rect, (record_t)i))
+			fail("delete element in tree", "false");
+		rtree_set2d(&rect, x + 0.25, y, x + 0.75, y + 0.5);
+		rtree_insert(&tree, &rect, (record_t)i);
+	}
+	if (rtree_number_of_records(&tree) != rounds)
+		fail("Tree count mismatch after update", "true");
+	for (size_t i = 1; i <= rounds; i++) {
+		coord_t x = (i * 7919) % 2003, y = (i * 104729) % 1000;
+		if (i % 2 == 1)
+			rtree_set2d(&rect, x + 0.25, y, x + 0.75, y + 0.5);
+		else
+			rtree_set2d(&rect, x, y, x + 0.5, y + 0.5);
+		if (!rtree_search(&tree, &rect, SOP_EQUALS, &iterator))
+			fail("element in tree after update", "false");
+	}
+
+	rtree_iterator_destroy(&iterator);
+	rtree_destroy(&tree);
+	rtree_destroy(&ref_tree);
+
+	footer();
+}
+
 
 int
 main(void)
 {
 	simple_check();
 	neighbor_test();
+	bulk_load_check();
 	if (page_count != 0) {
 		fail("memory leak!", "true");
 	}
@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "unit.h"
+
+/* Poor hash function to exercise collisions. */
+static uint32_t
+hash(uint64_t value, int bits)
+{
+	uint32_t h = (uint32_t)(value * 2654435761u);
+	return bits < 32 ? h & ((1u << bits) - 1) : h;
+}
+
+#define SWISS_NAME
+#define SWISS_DATA_TYPE uint64_t
+#define SWISS_KEY_TYPE uint64_t
+#define SWISS_CMP_ARG_TYPE int
+#define SWISS_EQUAL(a, b, arg) ((a) == (b))
+#define SWISS_EQUAL_KEY(a, b, arg) ((a) == (b))
+#define SWISS_HASH(a, arg) hash(a, arg)
+#include "salad/swiss.h"
+
+static void
+check_table(struct swiss_core *ht, const bool *present, uint64_t limit)
+{
+	for (uint64_t v = 0; v < limit; v++) {
+		uint32_t slot = swiss_find_key(ht, hash(v, ht->arg), v);
+		fail_unless((slot != swiss_end) == present[v]);
+		if (slot != swiss_end)
+			fail_unless(swiss_get(ht, slot) == v);
+	}
+	fail_unless(swiss_selfcheck(ht) == 0);
+}
+
+static void
+random_test(int bits)
+{
+	header();
+
+	struct swiss_core ht;
+	swiss_create(&ht, bits);
+	enum { LIMIT = 2000, ROUNDS = 20000 };
+	bool present[LIMIT];
+	memset(present, 0, sizeof(present));
+	uint32_t count = 0;
+	for (int i = 0; i < ROUNDS; i++) {
+		uint64_t v = rand() % LIMIT;
+		uint32_t h = hash(v, bits);
+		uint32_t slot = swiss_find(&ht, h, v);
+		fail_unless((slot != swiss_end) == present[v]);
+		if (slot == swiss_end) {
+			fail_if(swiss_insert(&ht, h, v) == swiss_end);
+			present[v] = true;
+			count++;
+		} else {
+			swiss_delete(&ht, slot);
+			present[v] = false;
+			count--;
+		}
+		fail_unless(ht.count == count);
+		if (i % 1000 == 0)
+			check_table(&ht, present, LIMIT);
+	}
+	check_table(&ht, present, LIMIT);
+
+	uint32_t iterated = 0;
+	for (uint32_t slot = swiss_next(&ht, swiss_end); slot != swiss_end;
+	     slot = swiss_next(&ht, slot)) {
+		fail_unless(present[swiss_get(&ht, slot)]);
+		iterated++;
+	}
+	fail_unless(iterated == count);
+	swiss_destroy(&ht);
+
+	footer();
+}
+
+static void
+replace_reserve_test()
+{
+	header();
+
+	struct swiss_core ht;
+	swiss_create(&ht, 32);
+	fail_if(swiss_reserve(&ht, 1000) != 0);
+	uint32_t capacity = ht.capacity;
+	for (uint64_t v = 0; v < 1000; v++)
+		fail_if(swiss_insert(&ht, hash(v, 32), v) == swiss_end);
+	fail_unless(ht.capacity == capacity);
+
+	uint64_t replaced;
+	bool is_replaced;
+	uint32_t slot = swiss_replace(&ht, hash(10, 32), 10, &replaced,
+				      &is_replaced);
+	fail_unless(slot != swiss_end && is_replaced && replaced == 10);
+	slot = swiss_replace(&ht, hash(1000, 32), 1000, &replaced,
+			     &is_replaced);
+	fail_unless(slot != swiss_end && !is_replaced);
+	fail_unless(ht.count == 1001);
+	fail_unless(swiss_selfcheck(&ht) == 0);
+	swiss_destroy(&ht);
+
+	footer();
+}
+
+int
+main(void)
+{
+	srand(time(NULL));
+	random_test(32);
+	random_test(6);
+	replace_reserve_test();
+	return 0;
+}
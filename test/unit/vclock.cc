@@ -70,7 +70,7 @@ test_compare_one(uint32_t a_count, const int64_t *lsns_a,
 int
 test_compare()
 {
-	plan(40);
+	plan(42);
 	header();
 
 	test(arg(), arg(), 0);
@@ -94,6 +94,18 @@ test_compare()
 	test(arg(10, 10, 10), arg(10, 10, 10, 1, 2, 3), -1);
 	test(arg(0, 0, 0), arg(10, 0, 0, 0, 0), -1);
 
+	/* The highest replica id. */
+	struct vclock a, b;
+	vclock_create(&a);
+	vclock_create(&b);
+	vclock_follow(&a, 1, 10);
+	vclock_follow(&b, 1, 10);
+	vclock_follow(&b, VCLOCK_MAX - 1, 1);
+	is(vclock_compare(&a, &b), -1, "compare with the last component set");
+	vclock_follow(&a, 2, 1);
+	is(vclock_compare(&a, &b), VCLOCK_ORDER_UNDEFINED,
+	   "compare concurrent with the last component set");
+
 	footer();
 	return check_plan();
 }
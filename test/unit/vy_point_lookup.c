@@ -24,7 +24,8 @@ write_run(struct vy_run *run, const char *dir_name,
 	if (vy_run_writer_create(&writer, run, dir_name,
 				 lsm->space_id, lsm->index_id,
 				 lsm->cmp_def, lsm->key_def,
-				 4096, 0.1) != 0)
+				 4096, 0.1, 0, NULL, 0, 0, false, 0,
+				 NULL, 0, 0) != 0)
 		goto fail;
 
 	if (wi->iface->start(wi) != 0)
@@ -66,7 +67,7 @@ test_basic()
 
 	int rc;
 	struct vy_lsm_env lsm_env;
-	rc = vy_lsm_env_create(&lsm_env, ".", &generation, NULL, NULL);
+	rc = vy_lsm_env_create(&lsm_env, ".", NULL, &generation, NULL, NULL);
 	is(rc, 0, "vy_lsm_env_create");
 
 	struct vy_run_env run_env;
@@ -86,7 +87,7 @@ test_basic()
 	struct tuple_format *format = tuple_format_new(&vy_tuple_format_vtab,
 						       NULL, &key_def, 1, NULL,
 						       0, 0, NULL, false,
-						       false);
+						       false, false, false);
 	isnt(format, NULL, "tuple_format_new is not NULL");
 	tuple_format_ref(format);
 
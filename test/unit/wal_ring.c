@@ -0,0 +1,135 @@
+#include <stdlib.h>
+#include <string.h>
+#include <small/ibuf.h>
+
+#include "box/wal_ring.h"
+#include "box/xrow.h"
+#include "box/iproto_constants.h"
+#include "fiber.h"
+#include "memory.h"
+#include "unit.h"
+#include "trivia/util.h"
+
+static void
+append_rows(struct wal_ring *ring, int64_t from, int64_t to)
+{
+	for (int64_t lsn = from; lsn <= to; lsn++) {
+		struct xrow_header row;
+		memset(&row, 0, sizeof(row));
+		row.type = IPROTO_INSERT;
+		row.replica_id = 1;
+		row.lsn = lsn;
+		fail_unless(wal_ring_append(ring, &row) == 0);
+	}
+	fiber_gc();
+}
+
+/**
+ * Read rows following the cursor and check that their LSNs
+ * go one after another. Return the number of rows read and
+ * store the first and the last LSN.
+ */
+static int
+read_rows(struct wal_ring *ring, struct wal_ring_cursor *cursor,
+	  int64_t *first, int64_t *last)
+{
+	struct ibuf buf;
+	ibuf_create(&buf, &cord()->slabc, 1024);
+	fail_unless(wal_ring_read(ring, cursor, &buf) == 0);
+	int count = 0;
+	const char *pos = buf.rpos;
+	while (pos < buf.wpos) {
+		struct xrow_header row;
+		fail_unless(wal_ring_decode_row(&pos, buf.wpos, &row) == 0);
+		fail_unless(row.replica_id == 1);
+		if (count == 0)
+			*first = row.lsn;
+		else
+			fail_unless(row.lsn == *last + 1);
+		*last = row.lsn;
+		count++;
+	}
+	ibuf_destroy(&buf);
+	return count;
+}
+
+static int
+read_status(struct wal_ring *ring, struct wal_ring_cursor *cursor)
+{
+	struct ibuf buf;
+	ibuf_create(&buf, &cord()->slabc, 1024);
+	int rc = wal_ring_read(ring, cursor, &buf);
+	ibuf_destroy(&buf);
+	return rc;
+}
+
+int
+main()
+{
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	header();
+	plan(12);
+
+	struct vclock vclock;
+	vclock_create(&vclock);
+	struct wal_ring_cursor cursor;
+	int64_t first = 0, last = 0;
+
+	struct wal_ring *ring = wal_ring_new(4096);
+	fail_if(ring == NULL);
+	wal_ring_reset(ring, &vclock);
+
+	append_rows(ring, 1, 10);
+	is(wal_ring_cursor_create(ring, &cursor, &vclock), 0,
+	   "cursor at the start of the ring");
+	is(read_rows(ring, &cursor, &first, &last), 10, "read all rows");
+	ok(first == 1 && last == 10, "rows are read in order");
+	is(read_rows(ring, &cursor, &first, &last), 0, "no new rows");
+	append_rows(ring, 11, 12);
+	is(read_rows(ring, &cursor, &first, &last), 2, "read new rows");
+	wal_ring_delete(ring);
+
+	ring = wal_ring_new(256);
+	fail_if(ring == NULL);
+	wal_ring_reset(ring, &vclock);
+	append_rows(ring, 1, 100);
+	is(wal_ring_cursor_create(ring, &cursor, &vclock), -1,
+	   "cursor can't be created if unseen rows were evicted");
+	vclock_follow(&vclock, 1, 90);
+	is(wal_ring_cursor_create(ring, &cursor, &vclock), 0,
+	   "cursor can be created if evicted rows were seen");
+	read_rows(ring, &cursor, &first, &last);
+	ok(first > 1 && first <= 91 && last == 100,
+	   "the ring keeps the newest rows");
+	append_rows(ring, 101, 200);
+	is(read_status(ring, &cursor), 1, "lagging cursor sees eviction");
+
+	vclock_follow(&vclock, 1, 200);
+	is(wal_ring_cursor_create(ring, &cursor, &vclock), 0,
+	   "cursor at the end of the ring");
+	wal_ring_reset(ring, &vclock);
+	is(read_status(ring, &cursor), 1, "reset evicts all rows");
+
+	struct xrow_header row;
+	memset(&row, 0, sizeof(row));
+	row.type = IPROTO_INSERT;
+	row.replica_id = 1;
+	row.lsn = 201;
+	char body[512];
+	memset(body, 0, sizeof(body));
+	row.bodycnt = 1;
+	row.body[0].iov_base = body;
+	row.body[0].iov_len = sizeof(body);
+	fail_unless(wal_ring_append(ring, &row) == 0);
+	fiber_gc();
+	is(wal_ring_cursor_create(ring, &cursor, &vclock), -1,
+	   "row bigger than the ring is evicted right away");
+
+	wal_ring_delete(ring);
+
+	footer();
+	fiber_free();
+	memory_free();
+	return check_plan();
+}
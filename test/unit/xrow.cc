@@ -39,6 +39,7 @@ extern "C" {
 #include "random.h"
 #include "memory.h"
 #include "fiber.h"
+#include "box/vclock.h"
 
 int
 test_iproto_constants()
@@ -239,6 +240,62 @@ test_xrow_header_encode_decode()
 	check_plan();
 }
 
+void
+test_xrow_header_decode_fast()
+{
+	plan(14);
+	struct xrow_header header;
+	memset(&header, 0, sizeof(header));
+	header.type = IPROTO_REPLACE;
+	header.replica_id = 1;
+	header.lsn = 1ULL << 40;
+	header.tm = 123.456;
+	struct iovec vec[1];
+	xrow_header_encode(&header, 0, vec, 0);
+	const char *begin = (const char *)vec[0].iov_base;
+	const char *end = begin + vec[0].iov_len;
+	const char *pos = begin;
+	is(mp_decode_map(&pos), 4, "row header map size");
+
+	struct xrow_header decoded_header;
+	pos = begin;
+	is(xrow_header_decode(&decoded_header, &pos, end), 0,
+	   "row header decode");
+	is(decoded_header.type, header.type, "decoded type");
+	is(decoded_header.replica_id, header.replica_id, "decoded replica_id");
+	is(decoded_header.lsn, header.lsn, "decoded lsn");
+	is(decoded_header.tm, header.tm, "decoded tm");
+	ok(pos == end, "row header end");
+	pos = begin;
+	is(xrow_header_decode(&decoded_header, &pos, end - 1), -1,
+	   "truncated row header");
+
+	char buffer[64];
+	char *d = mp_encode_map(buffer, 2);
+	d = mp_encode_uint(d, IPROTO_SYNC);
+	d = mp_encode_uint(d, 100500);
+	d = mp_encode_uint(d, IPROTO_REQUEST_TYPE);
+	d = mp_encode_uint(d, IPROTO_SELECT);
+	pos = buffer;
+	is(xrow_header_decode(&decoded_header, &pos, d), 0,
+	   "request header decode");
+	is(decoded_header.sync, 100500, "decoded sync");
+	is(decoded_header.type, IPROTO_SELECT, "decoded type");
+
+	d = mp_encode_map(buffer, 2);
+	d = mp_encode_uint(d, IPROTO_REQUEST_TYPE);
+	d = mp_encode_uint(d, IPROTO_PING);
+	d = mp_encode_uint(d, IPROTO_SYNC);
+	d = mp_encode_uint(d, UINT64_MAX);
+	pos = buffer;
+	is(xrow_header_decode(&decoded_header, &pos, d), 0,
+	   "request header decode, type first");
+	is(decoded_header.sync, UINT64_MAX, "decoded sync");
+	is(decoded_header.type, IPROTO_PING, "decoded type");
+
+	check_plan();
+}
+
 void
 test_request_str()
 {
@@ -272,19 +329,140 @@ test_request_str()
 	check_plan();
 }
 
+/** Decode CDC_SUBSCRIBE with a body made of @a body..@a end. */
+static int
+test_cdc_decode_body(const char *body, const char *end)
+{
+	struct xrow_header row;
+	memset(&row, 0, sizeof(row));
+	row.type = IPROTO_CDC_SUBSCRIBE;
+	row.body[0].iov_base = (void *)body;
+	row.body[0].iov_len = end - body;
+	row.bodycnt = 1;
+	struct vclock vclock;
+	vclock_create(&vclock);
+	struct cdc_filter filter;
+	int rc = xrow_decode_cdc_subscribe(&row, &vclock, &filter);
+	if (rc != 0 && (filter.space_ids != NULL || filter.fields != NULL))
+		rc = -2;
+	cdc_filter_destroy(&filter);
+	return rc;
+}
+
+void
+test_xrow_cdc_subscribe()
+{
+	plan(23);
+	struct vclock vclock, decoded_vclock;
+	vclock_create(&vclock);
+	vclock_follow(&vclock, 1, 10);
+	vclock_follow(&vclock, 2, 20);
+	uint32_t space_ids[] = {515, 512, 600};
+	uint32_t fields[] = {3, 0};
+	struct cdc_filter filter;
+	filter.space_ids = space_ids;
+	filter.space_count = lengthof(space_ids);
+	filter.fields = fields;
+	filter.field_count = lengthof(fields);
+
+	struct xrow_header row;
+	is(xrow_encode_cdc_subscribe(&row, &vclock, &filter), 0, "encode");
+	is(row.type, IPROTO_CDC_SUBSCRIBE, "encoded type");
+	struct cdc_filter decoded;
+	vclock_create(&decoded_vclock);
+	is(xrow_decode_cdc_subscribe(&row, &decoded_vclock, &decoded), 0,
+	   "decode");
+	is(vclock_compare(&vclock, &decoded_vclock), 0, "decoded vclock");
+	is(decoded.space_count, 3, "decoded space count");
+	ok(decoded.space_ids[0] == 512 && decoded.space_ids[1] == 515 &&
+	   decoded.space_ids[2] == 600, "decoded space ids are sorted");
+	is(decoded.field_count, 2, "decoded field count");
+	ok(decoded.fields[0] == 3 && decoded.fields[1] == 0,
+	   "decoded fields keep order");
+	ok(cdc_filter_has_space(&decoded, 515), "space in filter");
+	ok(!cdc_filter_has_space(&decoded, 513), "space not in filter");
+	cdc_filter_destroy(&decoded);
+	ok(decoded.space_ids == NULL && decoded.fields == NULL, "destroy");
+
+	memset(&filter, 0, sizeof(filter));
+	is(xrow_encode_cdc_subscribe(&row, &vclock, &filter), 0,
+	   "encode without lists");
+	is(xrow_decode_cdc_subscribe(&row, &decoded_vclock, &decoded), 0,
+	   "decode without lists");
+	ok(decoded.space_ids == NULL && decoded.fields == NULL,
+	   "decoded no lists");
+	ok(cdc_filter_has_space(&decoded, 513), "no space filter");
+	cdc_filter_destroy(&decoded);
+
+	struct vclock tmp;
+	struct cdc_filter tmp_filter;
+	memset(&row, 0, sizeof(row));
+	row.type = IPROTO_CDC_SUBSCRIBE;
+	is(xrow_decode_cdc_subscribe(&row, &tmp, &tmp_filter), -1,
+	   "no body");
+
+	char buf[128];
+	char *pos = mp_encode_array(buf, 0);
+	is(test_cdc_decode_body(buf, pos), -1, "body is not a map");
+
+	pos = mp_encode_map(buf, 1);
+	pos = mp_encode_uint(pos, IPROTO_SPACE_IDS);
+	pos = mp_encode_uint(pos, 512);
+	is(test_cdc_decode_body(buf, pos), -1, "space ids is not an array");
+
+	pos = mp_encode_map(buf, 1);
+	pos = mp_encode_uint(pos, IPROTO_SPACE_IDS);
+	pos = mp_encode_array(pos, 2);
+	pos = mp_encode_uint(pos, 512);
+	pos = mp_encode_str(pos, "abc", 3);
+	is(test_cdc_decode_body(buf, pos), -1, "space id is a string");
+
+	pos = mp_encode_map(buf, 2);
+	pos = mp_encode_uint(pos, IPROTO_SPACE_IDS);
+	pos = mp_encode_array(pos, 1);
+	pos = mp_encode_uint(pos, 512);
+	pos = mp_encode_uint(pos, IPROTO_FIELDS);
+	pos = mp_encode_array(pos, 1);
+	pos = mp_encode_uint(pos, (uint64_t)UINT32_MAX + 1);
+	is(test_cdc_decode_body(buf, pos), -1,
+	   "field number out of range, lists freed");
+
+	pos = mp_encode_map(buf, 1);
+	pos = mp_encode_uint(pos, IPROTO_FIELDS);
+	pos = mp_encode_array(pos, 1);
+	pos = mp_encode_int(pos, -1);
+	is(test_cdc_decode_body(buf, pos), -1, "negative field number");
+
+	pos = mp_encode_map(buf, 1);
+	pos = mp_encode_uint(pos, IPROTO_VCLOCK);
+	pos = mp_encode_array(pos, 1);
+	pos = mp_encode_uint(pos, 1);
+	is(test_cdc_decode_body(buf, pos), -1, "vclock is not a map");
+
+	pos = mp_encode_map(buf, 1);
+	pos = mp_encode_uint(pos, IPROTO_SPACE_IDS);
+	pos = mp_encode_array(pos, 2);
+	pos = mp_encode_uint(pos, 512);
+	is(test_cdc_decode_body(buf, pos), -1, "truncated body");
+
+	check_plan();
+}
+
 int
 main(void)
 {
 	memory_init();
 	fiber_init(fiber_c_invoke);
-	plan(3);
+	plan(5);
 
 	random_init();
 
 	test_iproto_constants();
 	test_greeting();
 	test_xrow_header_encode_decode();
+	test_xrow_header_decode_fast();
 	test_request_str();
+	test_xrow_cdc_subscribe();
 
 	random_free();
 	fiber_free();
@@ -0,0 +1,49 @@
+test_run = require('test_run').new()
+fio = require('fio')
+
+--
+-- Big tuples are stored in blob files.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {blob_threshold = -1})
+pk = s:create_index('pk', {blob_threshold = 100, run_count_per_level = 10})
+pk.options.blob_threshold
+-- Only the primary key can store tuples in blob files.
+s:create_index('sk', {parts = {2, 'string'}, blob_threshold = 100})
+
+path = fio.pathjoin(box.cfg.vinyl_dir, s.id, 0)
+function blob_count() return #fio.glob(fio.pathjoin(path, '*.blob')) end
+
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+
+big = string.rep('x', 200)
+for i = 1, 10 do s:replace{i, i % 2 == 0 and big or 'small'} end
+box.snapshot()
+blob_count()
+
+-- Tuples are read back from blob files.
+s:get(2)[2] == big
+s:get(3)
+#s:select()
+
+-- Compaction carries tuples stored in blob files over.
+s:upsert({4, big}, {{'=', 3, 'upserted'}})
+_ = s:replace{5, big}
+s:delete(6)
+box.snapshot()
+pk:compact()
+test_run:wait_cond(function() return pk:stat().run_count == 1 end, 10)
+s:get(4)[3]
+s:get(4)[2] == big
+s:get(5)[2] == big
+s:get(6)
+#s:select()
+
+-- Blob files are recovered after restart.
+test_run:cmd('restart server default')
+s = box.space.test
+s:get(2)[2] == string.rep('x', 200)
+s:get(4)[3]
+#s:select()
+s:drop()
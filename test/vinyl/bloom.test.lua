@@ -33,16 +33,16 @@ box.snapshot()
 --
 -- There are 1000 unique tuples in the index. The cardinality of the
 -- first key part is 100, of the first two key parts is 500, of the
--- first three key parts is 1000. With the default bloom fpr of 0.05,
--- we use 5 hash functions or 5 / ln(2) ~= 7.3 bits per tuple.If we
--- allocated a full sized bloom filter per each sub key, we would need
--- to allocate at least (100 + 500 + 1000 + 1000) * 7 bits or 2275
--- bytes. However, since we adjust the fpr of bloom filters of higher
--- ranks (because a full key lookup checks all its sub keys as well),
--- we use 5, 4, 3, and 1 hash functions for each sub key respectively.
--- This leaves us only (100*5 + 500*4 + 1000*3 + 1000*1) / ln(2) bits
--- or 1172 bytes, and after rounding up to the block size (128 byte)
--- we have 1280 bytes plus the header overhead.
+-- first three key parts is 1000. New runs use split block bloom
+-- filters, which set one bit in each of eight 64-bit words of a
+-- 64-byte block per key. With the default bloom fpr of 0.05, this
+-- takes about 6.9 bits per tuple. If we allocated a full sized bloom
+-- filter per each sub key, we would need to allocate at least
+-- (100 + 500 + 1000 + 1000) * 6.9 bits or 2243 bytes. However, since
+-- we adjust the fpr of bloom filters of higher ranks (because a full
+-- key lookup checks all its sub keys as well), we need only 2, 7, 11,
+-- and 7 blocks for each sub key respectively, which gives us 1728
+-- bytes plus the header overhead.
 --
 s.index.pk:stat().disk.bloom_size
 
@@ -81,6 +81,19 @@ for i = 1, 1000 do s:select{i, i, i, i} end
 new_reflects() > 980
 new_seeks() < 20
 
+-- Bloom filters are checked for REQ iterators, too.
+for i = 1, 100 do s:select({i}, {iterator = 'req'}) end
+new_reflects() == 0
+new_seeks() == 100
+
+for i = 1001, 2000 do s:select({i}, {iterator = 'req'}) end
+new_reflects() > 980
+new_seeks() < 20
+
+for i = 1, 1000 do s:select({i, i}, {iterator = 'req'}) end
+new_reflects() > 980
+new_seeks() < 20
+
 test_run:cmd('restart server default')
 
 vinyl_cache = box.cfg.vinyl_cache
@@ -0,0 +1,63 @@
+test_run = require('test_run').new()
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 64})
+
+-- Load sorted tuples into an empty space.
+t = {}
+for i = 1, 100 do table.insert(t, {i, string.rep('x', 10)}) end
+s:bulk_load(t)
+s:count()
+s:get(50)
+s:select(95, {iterator = 'ge'})
+s.index.pk:stat().run_count
+s.index.pk:stat().memory.rows
+
+-- The loaded data survives restart.
+box.snapshot()
+test_run:cmd('restart server default')
+s = box.space.test
+s:count()
+s:get(100)
+
+-- Writes after load are applied on top of the loaded data.
+s:replace{1, 'y'}
+s:delete{2}
+s:select({}, {limit = 3})
+
+-- The space must be empty.
+s:bulk_load({{101}})
+s:drop()
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+
+-- Tuples must be sorted and unique.
+s:bulk_load({{1}, {3}, {2}})
+s:bulk_load({{1}, {1}})
+s:count()
+
+-- Tuples must match the space format.
+s:format({{'a', 'unsigned'}, {'b', 'string'}})
+s:bulk_load({{1, 2}})
+s:bulk_load({{1, 'a'}, {2, 'b'}})
+s:select()
+
+-- Loading an empty source is a no-op.
+s:truncate()
+s:bulk_load({})
+s:count()
+
+-- Not supported with secondary indexes or in a transaction.
+_ = s:create_index('sk', {parts = {2, 'string'}})
+s:bulk_load({{1, 'a'}})
+s.index.sk:drop()
+box.begin() ok, err = pcall(s.bulk_load, s, {{1, 'a'}}) box.rollback()
+ok, err
+s:drop()
+
+-- Not supported by memtx.
+s = box.schema.space.create('test', {engine = 'memtx'})
+_ = s:create_index('pk')
+s:bulk_load({{1}})
+s:drop()
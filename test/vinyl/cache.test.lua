@@ -398,3 +398,26 @@ s.index.i2:count()
 box.stat.vinyl().memory.tuple_cache -- should be about 200 KB
 s:drop()
 box.cfg{vinyl_cache = vinyl_cache}
+
+--
+-- A scan doesn't evict tuples that are read frequently.
+--
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 100 * 1000}
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 300 do s:replace{i, string.rep('x', 1000)} end
+box.snapshot()
+for i = 1, 20 do s:get{i} s:get{i} end
+for _ in s:pairs({20}, {iterator = 'gt'}) do end
+st = s.index.pk:stat().disk.iterator.lookup
+for i = 1, 20 do s:get{i} end
+s.index.pk:stat().disk.iterator.lookup - st -- 0
+-- Tuples read with fill_cache = false are not cached.
+st = s.index.pk:stat().cache.put.rows
+n = 0
+for _ in s:pairs({}, {fill_cache = false}) do n = n + 1 end
+n
+s.index.pk:stat().cache.put.rows - st -- 0
+s:drop()
+box.cfg{vinyl_cache = vinyl_cache}
@@ -0,0 +1,92 @@
+test_run = require('test_run').new()
+
+--
+-- Run pages can be stored column by column.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {columnar = true, page_restart_interval = 4})
+pk = s:create_index('pk', {columnar = true, page_size = 512, run_count_per_level = 10})
+pk.options.columnar
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false, columnar = true, page_size = 512})
+m = box.schema.space.create('test_memtx')
+_ = m:create_index('pk')
+_ = m:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+
+box.cfg{vinyl_cache = 0}
+
+test_run:cmd("setopt delimiter ';'")
+function fill(from, to)
+    for i = from, to do
+        local t = {i, i % 10, 'event', i * 1.5}
+        for j = 1, i % 4 do
+            table.insert(t, string.rep('x', j))
+        end
+        s:replace(t)
+        m:replace(t)
+    end
+end;
+function check_index(name, k)
+    for _, it in ipairs({'eq', 'ge', 'gt', 'le', 'lt'}) do
+        local a = s.index[name]:select({k}, {iterator = it})
+        local b = m.index[name]:select({k}, {iterator = it})
+        if #a ~= #b then
+            return false
+        end
+        for j = 1, #a do
+            if #a[j] ~= #b[j] then
+                return false
+            end
+            for f = 1, #a[j] do
+                if a[j][f] ~= b[j][f] then
+                    return false
+                end
+            end
+        end
+    end
+    return true
+end;
+function check()
+    for i = 0, 301 do
+        if not check_index('pk', i) then
+            return false, 'pk', i
+        end
+    end
+    for i = 0, 10 do
+        if not check_index('sk', i) then
+            return false, 'sk', i
+        end
+    end
+    return true
+end;
+test_run:cmd("setopt delimiter ''");
+
+fill(1, 200)
+box.snapshot()
+check()
+
+-- Statements without a tuple and upserts are stored too.
+for i = 1, 200, 3 do s:delete{i} m:delete{i} end
+for i = 2, 200, 5 do s:upsert({i, 0}, {{'+', 2, 1}}) m:upsert({i, 0}, {{'+', 2, 1}}) end
+box.snapshot()
+check()
+
+-- Columnar runs can be compacted together with row ones.
+pk:alter{columnar = false}
+pk.options.columnar
+fill(150, 300)
+box.snapshot()
+pk:alter{columnar = true}
+pk:compact()
+test_run:wait_cond(function() return pk:stat().run_count == 1 end, 10)
+check()
+
+test_run:cmd('restart server default')
+s = box.space.test
+m = box.space.test_memtx
+s.index.pk.options.columnar
+#s:select() == #m:select()
+s:select{42}
+s:select{43}
+s.index.sk:count{3} == m.index.sk:count{3}
+s:drop()
+m:drop()
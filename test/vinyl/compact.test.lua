@@ -96,3 +96,25 @@ compact()
 info() -- 4 ranges, 4 runs
 
 s:drop()
+--
+-- Tiered compaction strategy.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {compaction_strategy = 'foo'})
+_ = s:create_index('pk', {run_count_per_level = 2, compaction_strategy = 'tiered'})
+s.index.pk.options.compaction_strategy
+-- Two runs of similar size fit in one tier and aren't compacted,
+-- while the leveled strategy would merge them at the last level.
+for i = 1, 10 do s:replace{i, string.rep('x', 1000)} end
+box.snapshot()
+for i = 1, 10 do s:replace{i, string.rep('y', 1000)} end
+box.snapshot()
+s.index.pk:stat().run_count
+s.index.pk:stat().disk.compaction.queue.rows
+s.index.pk:stat().disk.write_amplification
+s.index.pk:compact()
+while s.index.pk:stat().run_count > 1 do fiber.sleep(0.01) end
+s.index.pk:stat().disk.write_amplification > 1
+s.index.pk:alter{compaction_strategy = 'leveled'}
+s.index.pk.options.compaction_strategy
+s:drop()
@@ -0,0 +1,36 @@
+test_run = require('test_run').new()
+
+--
+-- Run pages can be compressed with a dictionary trained on
+-- the previous run of the same LSM tree.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {compression_dict_size = -1})
+s:create_index('pk', {compression_dict_size = 2 * 1024 * 1024})
+pk = s:create_index('pk', {compression_dict_size = 4096, page_size = 512, run_count_per_level = 10})
+pk.options.compression_dict_size
+
+pad = string.rep('abcdefgh', 16)
+for i = 1, 1000 do s:replace{i, pad .. i} end
+box.snapshot()
+for i = 1001, 2000 do s:replace{i, pad .. i} end
+box.snapshot()
+for i = 1, 2000, 100 do s:replace{i, pad} end
+box.snapshot()
+pk:stat().run_count
+s:count()
+s:get{1}[2] == pad
+s:get{1500}[2] == pad .. 1500
+
+-- Compaction of dictionary-compressed runs.
+pk:compact()
+test_run:wait_cond(function() return pk:stat().run_count == 1 end)
+s:count()
+s:get{2}[2] == pad .. 2
+
+test_run:cmd('restart server default')
+s = box.space.test
+s.index.pk.options.compression_dict_size
+s:count()
+s:get{1500}[2] == string.rep('abcdefgh', 16) .. 1500
+s:drop()
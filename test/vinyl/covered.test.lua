@@ -0,0 +1,53 @@
+test_run = require('test_run').new()
+
+--
+-- Secondary index covering columns.
+--
+format = {{'id', 'unsigned'}, {'name', 'string'}, {'val', 'unsigned'}, {'data', 'any'}}
+s = box.schema.space.create('test', {engine = 'vinyl', format = format})
+pk = s:create_index('pk')
+-- Primary key can't have covered fields.
+pk:alter({covered_fields = {'val'}})
+-- Covered fields must have a scalar type.
+s:create_index('sk', {parts = {'name'}, covered_fields = {'data'}})
+s:create_index('sk', {parts = {'name'}, covered_fields = {5}})
+s:create_index('sk', {parts = {'name'}, covered_fields = {'foo'}})
+s:create_index('sk', {parts = {'name'}, covered_fields = 'val'})
+sk = s:create_index('sk', {parts = {'name'}, covered_fields = {'val'}})
+sk.options.covered_fields
+
+for i = 1, 10 do s:insert{i, 'name' .. i, i * 10, {i}} end
+
+-- Projection needs no lookups in the primary index
+-- when all requested fields are stored in the index.
+lookup = pk:stat().lookup
+sk:select({}, {fields = {'id', 'val'}, limit = 3})
+sk:select({'name5'}, {fields = {'val'}})
+pk:stat().lookup - lookup
+
+-- Fields not stored in the index are fetched from the primary.
+lookup = pk:stat().lookup
+sk:select({'name5'}, {fields = {'id', 'data'}})
+pk:stat().lookup - lookup
+
+-- Updates of a covered field are visible after dump.
+s:update(5, {{'=', 'val', 500}})
+s:delete(6)
+box.snapshot()
+s:update(7, {{'=', 'val', 700}})
+lookup = pk:stat().lookup
+sk:select({'name5'}, {fields = {'val'}})
+sk:select({'name6'}, {fields = {'val'}})
+sk:select({'name7'}, {fields = {'val'}})
+pk:stat().lookup - lookup
+
+-- Projection works for indexes without covered fields as well.
+pk:select({3}, {fields = {'name', 3}})
+pk:select({3}, {fields = {'foo'}})
+
+-- Dropping covered fields rebuilds the index.
+sk:alter({covered_fields = {}})
+sk.options.covered_fields
+sk:select({'name5'}, {fields = {'val'}})
+
+s:drop()
@@ -305,3 +305,25 @@ s:drop()
 test_run:cmd("switch default")
 test_run:cmd("stop server test")
 test_run:cmd("cleanup server test")
+
+--
+-- Check that deferred DELETEs are not generated for tuples
+-- overwritten without changing secondary keys.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {run_count_per_level = 10})
+sk = s:create_index('sk', {run_count_per_level = 10, parts = {2, 'unsigned'}, unique = false})
+for i = 1, 10 do s:replace{i, i, 'a'} end
+box.snapshot()
+for i = 1, 10 do s:replace{i, i % 5 == 0 and i * 10 or i, 'b'} end
+box.snapshot()
+box.stat.reset()
+
+pk:compact()
+while pk:stat().disk.compaction.count == 0 do fiber.sleep(0.001) end
+pk:stat().deferred_delete.rows -- 2
+pk:stat().deferred_delete.skipped -- 8
+sk:stat().rows -- 10 old REPLACEs + 10 new REPLACEs + 2 deferred DELETEs
+sk:select()
+
+s:drop()
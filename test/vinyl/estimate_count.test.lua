@@ -0,0 +1,44 @@
+--
+-- Check approximate counts computed from statement statistics
+-- and the page index without reading data.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 1024, run_count_per_level = 10})
+for i = 1, 1000 do s:insert{i, string.rep('x', 100)} end
+
+-- Nothing is on disk yet so the count is exact.
+s:count({501}, {iterator = 'ge', approximate = true})
+s:len({approximate = true})
+
+box.snapshot()
+s.index.pk:stat().disk.pages > 10
+s:len({approximate = true})
+s.index.pk:len({approximate = true})
+
+-- DELETEs are subtracted, unlike in len().
+for i = 1, 1000, 2 do s:delete{i} end
+s:len()
+s:len({approximate = true})
+box.snapshot()
+s:len({approximate = true})
+
+-- Key ranges are estimated from the page index.
+c = s:count({501}, {iterator = 'ge', approximate = true})
+c > 150 and c < 350
+c = s:count({100}, {iterator = 'lt', approximate = true})
+c > 25 and c < 75
+c = s:count({}, {approximate = true})
+c
+
+-- Lookups by a full unique key are exact.
+s:count({1}, {approximate = true})
+s:count({2}, {approximate = true})
+s:drop()
+
+-- Other engines return the exact count.
+s = box.schema.space.create('test', {engine = 'memtx'})
+_ = s:create_index('pk')
+for i = 1, 10 do s:insert{i} end
+s:len({approximate = true})
+s:count({5}, {iterator = 'gt', approximate = true})
+s:drop()
@@ -0,0 +1,44 @@
+test_run = require('test_run').new()
+
+--
+-- Check that page index blocks and bloom filters of runs are
+-- evicted when they don't fit in vinyl_index_cache and are
+-- loaded back on demand.
+--
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 1024, run_count_per_level = 10})
+for k = 1, 3 do for i = k, 6000, 3 do s:replace{i, string.rep('x', 100)} end box.snapshot() end
+s.index.pk:stat().run_count
+s.index.pk:stat().disk.pages > 3 * 128
+
+mem = box.stat.vinyl().memory
+mem.page_index == s.index.pk:stat().disk.index_size
+mem.bloom_filter > 0
+
+box.cfg{vinyl_index_cache = 1}
+box.stat.vinyl().memory.page_index < mem.page_index
+box.stat.vinyl().memory.bloom_filter
+
+-- Evicted metadata is loaded back on demand.
+s:get(1)[1], s:get(2)[1], s:get(3)[1], s:get(6001)
+#s:select()
+t = s:select({}, {iterator = 'le'})
+#t, t[1][1], t[6000][1]
+cnt = 0
+for i = 1, 6000, 7 do if s:get(i) ~= nil then cnt = cnt + 1 end end
+cnt
+box.stat.vinyl().memory.page_index < mem.page_index
+
+-- Compaction reads evicted blocks too.
+s.index.pk:compact()
+test_run:wait_cond(function() return s.index.pk:stat().run_count == 1 end, 10)
+s:count()
+
+box.cfg{vinyl_index_cache = 0}
+s:get(5000)[1]
+
+s:drop()
+box.cfg{vinyl_cache = vinyl_cache}
@@ -0,0 +1,8 @@
+#!/usr/bin/env tarantool
+
+box.cfg{
+    io_uring = true,
+    wal_mode = arg[1],
+}
+
+require('console').listen(os.getenv('ADMIN'))
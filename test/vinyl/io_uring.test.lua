@@ -0,0 +1,38 @@
+test_run = require('test_run').new()
+
+--
+-- I/O through io_uring. If io_uring isn't available, the
+-- instance falls back on thread pools, so the test checks
+-- only that data is written and read back.
+--
+test_run:cmd("create server test with script='vinyl/io_uring.lua'")
+test_run:cmd("start server test with args='fsync'")
+test_run:cmd("switch test")
+
+box.cfg.io_uring
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 128})
+for i = 1, 100 do s:replace{i, string.rep('x', 100)} end
+box.snapshot()
+-- Pages are read from disk.
+sum = 0
+for i = 1, 100 do sum = sum + s:get(i)[1] end
+sum
+#s:select()
+-- Rows are recovered from WAL.
+for i = 101, 200 do s:replace{i, string.rep('y', 100)} end
+
+test_run:cmd("switch default")
+test_run:cmd("stop server test")
+test_run:cmd("start server test with args='fsync'")
+test_run:cmd("switch test")
+
+s = box.space.test
+#s:select()
+s:get(150)[2] == string.rep('y', 100)
+s:drop()
+
+test_run:cmd("switch default")
+test_run:cmd("stop server test")
+test_run:cmd("cleanup server test")
@@ -1637,3 +1637,21 @@ box.stat.vinyl().tx.read_views -- 0 (no read views needed)
 box.stat.vinyl().tx.transactions -- 0 (all done)
 
 s:drop()
+
+--
+-- A read-only transaction reads from a read view and
+-- fails writes.
+--
+s = box.schema.space.create('test_ro', {engine = 'vinyl'})
+_ = s:create_index('pk')
+_ = s:replace{1, 1}
+c1("box.begin{read_only = true}")
+c1("box.space.test_ro:get{1}") -- {1, 1}
+_ = s:replace{1, 2}
+box.stat.vinyl().tx.read_views -- 1
+c1("box.space.test_ro:get{1}") -- {1, 1}
+c1("box.space.test_ro:replace{2}") -- error
+c1:commit()
+box.stat.vinyl().tx.read_views -- 0
+s:get{1}
+s:drop()
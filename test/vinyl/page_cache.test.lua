@@ -0,0 +1,36 @@
+test_run = require('test_run').new()
+
+--
+-- Check that pages read from disk are stored in the page cache
+-- and shared by lookups.
+--
+box.cfg{vinyl_page_cache = 1024 * 1024}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 100 do s:replace{i, string.rep('x', 100)} end
+box.snapshot()
+
+st = box.stat.vinyl().page_cache
+_ = s:get(1)
+box.stat.vinyl().page_cache.miss > st.miss
+box.stat.vinyl().page_cache.used > 0
+
+-- The second key is stored in the same page.
+st = box.stat.vinyl().page_cache
+_ = s:get(2)
+box.stat.vinyl().page_cache.hit > st.hit
+box.stat.vinyl().page_cache.miss == st.miss
+
+-- Shrinking the quota evicts pages.
+box.cfg{vinyl_page_cache = 0}
+box.stat.vinyl().page_cache.used
+box.stat.vinyl().page_cache.evict > st.evict
+
+-- Disabled cache isn't looked up.
+st = box.stat.vinyl().page_cache
+_ = s:get(3)
+box.stat.vinyl().page_cache.hit == st.hit
+box.stat.vinyl().page_cache.miss == st.miss
+
+s:drop()
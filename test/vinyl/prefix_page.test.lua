@@ -0,0 +1,100 @@
+test_run = require('test_run').new()
+
+--
+-- Statements of run pages can be prefix-compressed.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {page_restart_interval = -1})
+pk = s:create_index('pk', {parts = {1, 'string'}, page_size = 512, page_restart_interval = 4, run_count_per_level = 10})
+pk.options.page_restart_interval
+sk = s:create_index('sk', {parts = {2, 'string'}, page_size = 512, page_restart_interval = 4})
+m = box.schema.space.create('test_memtx')
+_ = m:create_index('pk', {parts = {1, 'string'}})
+_ = m:create_index('sk', {parts = {2, 'string'}})
+
+box.cfg{vinyl_cache = 0}
+
+test_run:cmd("setopt delimiter ';'")
+function key(i)
+    return string.format('tenant:%04d:user:%06d', i % 3, i)
+end;
+function fill(from, to)
+    for i = from, to do
+        local t = {key(i), string.format('value:%06d', i * 7 % 1000)}
+        s:replace(t)
+        m:replace(t)
+    end
+end;
+function check_index(name, k)
+    for _, it in ipairs({'eq', 'ge', 'gt', 'le', 'lt'}) do
+        local a = s.index[name]:select({k}, {iterator = it})
+        local b = m.index[name]:select({k}, {iterator = it})
+        if #a ~= #b then
+            return false
+        end
+        for j = 1, #a do
+            if a[j][1] ~= b[j][1] or a[j][2] ~= b[j][2] then
+                return false
+            end
+        end
+    end
+    return true
+end;
+function check()
+    for i = 0, 301 do
+        if not check_index('pk', key(i)) then
+            return false, 'pk', i
+        end
+        if not check_index('sk', string.format('value:%06d', i)) then
+            return false, 'sk', i
+        end
+    end
+    return true
+end;
+test_run:cmd("setopt delimiter ''");
+
+fill(1, 200)
+box.snapshot()
+check()
+
+-- Prefix-compressed pages can be compacted together with
+-- plain ones.
+pk:alter{page_restart_interval = 0}
+pk.options.page_restart_interval
+fill(150, 300)
+box.snapshot()
+check()
+pk:alter{page_restart_interval = 7}
+pk:compact()
+test_run:wait_cond(function() return pk:stat().run_count == 1 end, 10)
+check()
+
+test_run:cmd('restart server default')
+s = box.space.test
+m = box.space.test_memtx
+s.index.pk.options.page_restart_interval
+test_run:cmd("setopt delimiter ';'")
+function key(i)
+    return string.format('tenant:%04d:user:%06d', i % 3, i)
+end;
+function check()
+    for i = 0, 301 do
+        for _, it in ipairs({'eq', 'ge', 'gt', 'le', 'lt'}) do
+            local a = s:select({key(i)}, {iterator = it})
+            local b = m:select({key(i)}, {iterator = it})
+            if #a ~= #b then
+                return false, i, it
+            end
+            for j = 1, #a do
+                if a[j][2] ~= b[j][2] then
+                    return false, i, it
+                end
+            end
+        end
+    end
+    return true
+end;
+test_run:cmd("setopt delimiter ''");
+check()
+s:drop()
+m:drop()
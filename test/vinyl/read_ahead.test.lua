@@ -0,0 +1,40 @@
+test_run = require('test_run').new()
+
+--
+-- Check that sequential scans read pages ahead.
+--
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 1024})
+for i = 1, 1000 do s:replace{i, string.rep('x', 100)} end
+box.snapshot()
+s.index.pk:stat().disk.pages > 10
+
+st = box.stat.vinyl().read_ahead
+#s:select()
+box.stat.vinyl().read_ahead.pages > st.pages
+
+st = box.stat.vinyl().read_ahead
+t = s:select({}, {iterator = 'le'})
+#t, t[1][1], t[1000][1]
+box.stat.vinyl().read_ahead.pages > st.pages
+
+-- Pages read ahead are released when the scan is over.
+test_run:wait_cond(function() return box.stat.vinyl().read_ahead.used == 0 end, 10)
+
+-- Point lookups don't read ahead.
+st = box.stat.vinyl().read_ahead
+for i = 1, 1000, 100 do s:get(i) end
+box.stat.vinyl().read_ahead.pages == st.pages
+
+-- Read-ahead can be disabled.
+box.cfg{vinyl_read_ahead = 0}
+st = box.stat.vinyl().read_ahead
+#s:select()
+box.stat.vinyl().read_ahead.pages == st.pages
+box.cfg{vinyl_read_ahead = 16 * 1024 * 1024}
+
+s:drop()
+box.cfg{vinyl_cache = vinyl_cache}
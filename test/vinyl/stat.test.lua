@@ -77,6 +77,7 @@ function istat()
     st.latency = nil
     st.disk.dump.time = nil
     st.disk.compaction.time = nil
+    st.disk.write_amplification = nil
     return st
 end;
 
@@ -90,6 +91,9 @@ end;
 function gstat()
     local st = box.stat.vinyl()
     st.regulator = nil
+    st.page_cache = nil
+    st.read_ahead = nil
+    st.tx.conflict_check = nil
     st.scheduler.dump_time = nil
     st.scheduler.compaction_time = nil
     return st
@@ -357,6 +361,18 @@ stat_diff(gstat(), st, 'scheduler')
 
 s:drop()
 
+-- dumps of secondary indexes are done by one task
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 4 do s:create_index('sk' .. i, {parts = {i + 1, 'unsigned'}}) end
+for i = 1, 10 do s:replace{i, i, i, i, i} end
+st = gstat()
+box.snapshot()
+gstat().scheduler.tasks_completed - st.scheduler.tasks_completed -- 2
+for i = 0, 4 do assert(s.index[i]:stat().disk.dump.count == 1) end
+s.index.sk4:select({}, {limit = 2})
+s:drop()
+
 --
 -- space.bsize, index.len, index.bsize
 --
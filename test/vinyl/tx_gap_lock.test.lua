@@ -525,6 +525,36 @@ end;
 s:drop();
 
 test_run:cmd("setopt delimiter ''");
+
+----------------------------------------------------------------
+-- Point reads are checked for conflicts with a hash lookup,
+-- range reads with an interval tree walk.
+----------------------------------------------------------------
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+
+_ = s:insert{1}
+_ = s:insert{10}
+
+c1:begin()
+c1("s:get(1)") -- {1}
+c2:begin()
+c2("s:select({5}, {iterator = 'GE'})") -- {10}
+
+st = box.stat.vinyl().tx.conflict_check
+_ = s:replace{1, 1} -- send c1 to read view
+_ = s:replace{20} -- send c2 to read view
+cs = box.stat.vinyl().tx.conflict_check
+cs.statements - st.statements
+cs.points - st.points
+cs.intervals - st.intervals
+
+c1("s:get(1)") -- {1}
+c2("s:select({5}, {iterator = 'GE'})") -- {10}
+c1:commit()
+c2:commit()
+
+s:drop()
 ----------------------------------------------------------------
 
 c = nil
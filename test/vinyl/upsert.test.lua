@@ -325,3 +325,23 @@ s:upsert({100}, {{'+', 2, 100}})
 s:select({100}, 'GE')
 
 s:drop()
+
+--
+-- A lookup that has to apply a long series of upserts squashes
+-- the key in background. Arithmetic operations of successive
+-- upserts are folded when applied.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+s:replace{1, 0}
+box.snapshot()
+s:upsert({1, 0}, {{'=', 2, 10}})
+for i = 1, 20 do s:upsert({1, 0}, {{'+', 2, 1}}) end
+s:upsert({1, 0}, {{'-', 2, 0.5}})
+stat = s.index.pk:stat()
+s:get{1}
+s.index.pk:stat().upsert.applied - stat.upsert.applied
+test_run:wait_cond(function() return s.index.pk:stat().upsert.squashed > stat.upsert.squashed end, 10)
+s:upsert({1, 0}, {{'+', 2, 1}})
+s:get{1}
+s:drop()
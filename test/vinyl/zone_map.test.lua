@@ -0,0 +1,112 @@
+test_run = require('test_run').new()
+fio = require('fio')
+xlog = require('xlog')
+
+--
+-- Run pages can store min/max values of non-key fields.
+--
+format = {{'id', 'unsigned'}, {'ts', 'unsigned'}, {'tag', 'string'}, {'data', 'any'}}
+s = box.schema.space.create('test', {engine = 'vinyl', format = format})
+s:create_index('pk', {zone_map_fields = {'foo'}})
+s:create_index('pk', {zone_map_fields = 'ts'})
+pk = s:create_index('pk', {zone_map_fields = {'ts', 'tag', 4}, page_size = 256, run_count_per_level = 10})
+pk.options.zone_map_fields
+s:create_index('sk', {parts = {2, 'unsigned'}, zone_map_fields = {'tag'}})
+
+-- Check the zone maps of all pages of the space runs against
+-- the statements stored in the pages.
+test_run:cmd("setopt delimiter ';'")
+function expected_zone_map(rows)
+    for _, row in ipairs(rows) do
+        if row.HEADER.type ~= 'REPLACE' and row.HEADER.type ~= 'INSERT' then
+            return nil
+        end
+    end
+    local map = {}
+    for _, f in ipairs({2, 3, 4}) do
+        local min, max, kind
+        for _, row in ipairs(rows) do
+            local v = row.BODY.tuple[f]
+            kind = kind or type(v)
+            if type(v) ~= kind then
+                kind = nil
+                break
+            end
+            if min == nil or v < min then min = v end
+            if max == nil or v > max then max = v end
+        end
+        if kind == 'number' or kind == 'string' then
+            map[f - 1] = {min, max}
+        end
+    end
+    return map
+end;
+function zone_map_equal(a, b)
+    if a == nil or b == nil then
+        return a == nil and b == nil
+    end
+    for f = 1, 3 do
+        if (a[f] == nil) ~= (b[f] == nil) then
+            return false
+        end
+        if a[f] ~= nil and (a[f][1] ~= b[f][1] or a[f][2] ~= b[f][2]) then
+            return false
+        end
+    end
+    return true
+end;
+function check_zone_maps()
+    local dir = fio.pathjoin(box.cfg.vinyl_dir, tostring(s.id), '0')
+    local page_count = 0
+    for _, path in ipairs(fio.glob(fio.pathjoin(dir, '*.index'))) do
+        local maps = {}
+        for _, row in xlog.pairs(path) do
+            if row.HEADER.type == 'PAGEINFO' then
+                table.insert(maps, row.BODY.zone_map or false)
+            end
+        end
+        local rows = {}
+        local page_no = 1
+        local run = path:gsub('%.index$', '.run')
+        for _, row in xlog.pairs(run) do
+            if row.HEADER.type == 'ROWINDEX' then
+                local map = maps[page_no] or nil
+                if not zone_map_equal(map, expected_zone_map(rows)) then
+                    return false, path, page_no
+                end
+                rows = {}
+                page_no = page_no + 1
+            else
+                table.insert(rows, row)
+            end
+        end
+        page_count = page_count + #maps
+    end
+    return page_count > 1
+end;
+test_run:cmd("setopt delimiter ''");
+
+for i = 1, 100 do s:replace{i, 1000 + i, string.format('tag%03d', i), i % 2 == 0 and i or 'x'} end
+box.snapshot()
+check_zone_maps()
+
+-- Pages with deletions don't get zone maps.
+for i = 10, 20 do s:delete{i} end
+for i = 101, 120 do s:replace{i, 1000 + i, string.format('tag%03d', i), i} end
+box.snapshot()
+check_zone_maps()
+
+s:select({42}, {iterator = 'ge', limit = 2})
+s:select({25}, {iterator = 'le', limit = 2})
+
+-- The set of fields can be changed without rebuilding the index.
+pk:alter{zone_map_fields = {'ts'}}
+pk.options.zone_map_fields
+
+test_run:cmd('restart server default')
+s = box.space.test
+s.index.pk.options.zone_map_fields
+s:count()
+s:get{42}
+s:get{15}
+s:drop()
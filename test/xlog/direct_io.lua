@@ -0,0 +1,10 @@
+#!/usr/bin/env tarantool
+
+box.cfg {
+    listen = os.getenv("LISTEN"),
+    wal_mode = 'fsync',
+    wal_direct_io = true,
+    rows_per_wal = 10,
+}
+
+require('console').listen(os.getenv('ADMIN'))
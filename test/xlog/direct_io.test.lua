@@ -0,0 +1,26 @@
+env = require('test_run').new()
+
+--
+-- Check that WAL files written with O_DIRECT are recovered
+-- correctly, including rows that share a block with the
+-- previous ones.
+--
+env:cmd('create server direct_io with script = "xlog/direct_io.lua"')
+env:cmd('start server direct_io')
+env:cmd('switch direct_io')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 100 do s:insert{i, string.rep('x', i)} end
+box.begin() for i = 101, 110 do s:insert{i, string.rep('y', 5000)} end box.commit()
+
+env:cmd('restart server direct_io')
+s = box.space.test
+s:count()
+for i = 1, 100 do assert(s:get(i)[2] == string.rep('x', i)) end
+for i = 101, 110 do assert(s:get(i)[2] == string.rep('y', 5000)) end
+s:drop()
+
+env:cmd('switch default')
+env:cmd('stop server direct_io')
+env:cmd('cleanup server direct_io')
+env:cmd('delete server direct_io')
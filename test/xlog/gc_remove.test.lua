@@ -0,0 +1,24 @@
+test_run = require('test_run').new()
+fio = require('fio')
+
+--
+-- Check that garbage files are removed in the background
+-- when gc_remove_rate_limit is set.
+--
+box.cfg{gc_remove_rate_limit = -1}
+box.cfg{checkpoint_count = 1, gc_remove_rate_limit = 1}
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 100 do s:insert{i, string.rep('x', 1000)} end
+box.snapshot()
+s:insert{0}
+box.snapshot()
+
+test_run:wait_cond(function() return box.info.gc().removal.files == 0 end)
+box.info.gc().removal.size
+box.info.gc().removal.removed > 0
+#fio.glob(fio.pathjoin(box.cfg.memtx_dir, '*.snap'))
+
+box.cfg{checkpoint_count = 2, gc_remove_rate_limit = box.NULL}
+s:drop()
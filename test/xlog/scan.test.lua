@@ -0,0 +1,64 @@
+test_run = require('test_run').new()
+fio = require('fio')
+xlog = require('xlog')
+msgpack = require('msgpack')
+
+--
+-- Parallel scan of xlog files with a filter by space and type.
+-- Only files written by the test are scanned.
+--
+box.snapshot()
+first = fio.pathjoin(box.cfg.wal_dir, string.format('%020d.xlog', box.info.signature))
+s1 = box.schema.space.create('scan1')
+_ = s1:create_index('pk')
+s2 = box.schema.space.create('scan2')
+_ = s2:create_index('pk')
+box.snapshot()
+for i = 1, 3000 do s1:insert{i, string.rep('x', 100)} s2:insert{i} end
+box.snapshot()
+for i = 1, 1000 do s1:replace{i} s2:delete{i} end
+box.snapshot()
+
+files = {}
+for _, f in ipairs(fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))) do if f >= first then table.insert(files, f) end end
+#files > 1
+
+-- Check every row of a batch and count rows by type.
+test_run:cmd("setopt delimiter ';'")
+function scan(opts)
+    local counts = {}
+    local total = 0
+    for _, batch in xlog.scan(files, opts) do
+        local pos = 1
+        for _ = 1, batch.count do
+            local len
+            len, pos = msgpack.decode_unchecked(batch.data, pos)
+            local header, next = msgpack.decode_unchecked(batch.data, pos)
+            local body = msgpack.decode_unchecked(batch.data, next)
+            assert(body[0x10] == s1.id)
+            local t = header[0x00]
+            counts[t] = (counts[t] or 0) + 1
+            pos = pos + len
+        end
+        assert(pos == #batch.data + 1)
+        total = total + batch.count
+    end
+    return total, counts
+end;
+test_run:cmd("setopt delimiter ''");
+
+scan({spaces = {s1.id}})
+scan({spaces = {s1.id}, types = {'INSERT'}, threads = 3, part_size = 16384})
+scan({spaces = {s1.id}, types = {'REPLACE', 'UPDATE'}, threads = 8, part_size = 1000})
+
+-- No rows match.
+scan({spaces = {s1.id}, types = {'DELETE'}})
+
+-- Errors.
+xlog.scan(files, {types = {'FOO'}})
+xlog.scan(files, {threads = 0})
+xlog.scan({'no_such_file.xlog'})
+xlog.scan()
+
+s1:drop()
+s2:drop()
@@ -0,0 +1,32 @@
+env = require('test_run').new()
+
+--
+-- Check that delta snapshots, which contain only spaces changed
+-- since the previous snapshot, are recovered correctly.
+--
+box.cfg{memtx_snap_delta_max = -1}
+
+for i = 1, 3 do box.schema.space.create('test' .. i):create_index('pk') end
+for i = 1, 3 do s = box.space['test' .. i] for j = 1, i * 1000 do s:insert{j, i} end end
+box.snapshot()
+
+box.cfg{memtx_snap_delta_max = 2}
+box.space.test1:replace{1, 10}
+box.snapshot()
+box.space.test2:delete{1}
+box.snapshot()
+
+env:cmd('restart server default')
+box.space.test1:count(), box.space.test1:get(1)
+box.space.test2:count(), box.space.test2:get(1)
+box.space.test3:count(), box.space.test3:get(1)
+
+-- A space left in the base may be changed after recovery.
+box.cfg{memtx_snap_delta_max = 2}
+box.space.test3:delete{1}
+box.snapshot()
+env:cmd('restart server default')
+box.space.test1:count(), box.space.test2:count(), box.space.test3:count()
+
+box.cfg{memtx_snap_delta_max = 0}
+for i = 1, 3 do box.space['test' .. i]:drop() end
@@ -0,0 +1,19 @@
+env = require('test_run').new()
+
+--
+-- Check that a snapshot written by several threads is
+-- recovered correctly.
+--
+box.cfg{memtx_snap_threads = 0}
+box.cfg{memtx_snap_threads = 65}
+
+for i = 1, 5 do box.schema.space.create('test' .. i):create_index('pk') end
+for i = 1, 5 do s = box.space['test' .. i] for j = 1, i * 1000 do s:insert{j, string.rep('x', j % 100)} end end
+
+box.cfg{memtx_snap_threads = 4}
+box.snapshot()
+box.cfg{memtx_snap_threads = 1}
+
+env:cmd('restart server default')
+for i = 1, 5 do s = box.space['test' .. i] assert(s:count() == i * 1000) assert(s:get(i)[2] == string.rep('x', i)) end
+for i = 1, 5 do box.space['test' .. i]:drop() end
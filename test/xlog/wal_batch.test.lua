@@ -0,0 +1,31 @@
+env = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- Check that group commit collects transactions arriving
+-- within wal_batch_delay in a single WAL write.
+--
+box.cfg{wal_batch_delay = -1}
+box.cfg{wal_batch_max_size = 0}
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+function insert(n) local ch = fiber.channel(n) for i = 1, n do fiber.create(function() s:replace{i} ch:put(true) end) fiber.sleep(0.01) end for i = 1, n do ch:get() end end
+
+box.cfg{wal_batch_delay = 0.5}
+batches = box.stat.wal().batches
+insert(10)
+box.stat.wal().batches - batches
+
+-- A batch exceeding wal_batch_max_size is written at once.
+box.cfg{wal_batch_max_size = 1}
+batches = box.stat.wal().batches
+insert(10)
+box.stat.wal().batches - batches
+
+box.stat.wal().batch_size.p99 > 0
+box.stat.wal().fsync_latency.p99
+
+box.cfg{wal_batch_delay = 0, wal_batch_max_size = 1024 * 1024}
+s:drop()
@@ -0,0 +1,23 @@
+env = require('test_run').new()
+
+--
+-- Check that WAL blocks compressed by several threads are
+-- recovered correctly.
+--
+box.cfg{wal_compress_threads = 0}
+box.cfg{wal_compress_threads = 65}
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+box.cfg{wal_compress_threads = 4}
+box.begin() for i = 1, 1000 do s:insert{i, string.rep('x', i)} end box.commit()
+for i = 1001, 1100 do s:insert{i, string.rep('y', i)} end
+box.cfg{wal_compress_threads = 1}
+
+env:cmd('restart server default')
+s = box.space.test
+s:count()
+for i = 1, 1000 do assert(s:get(i)[2] == string.rep('x', i)) end
+for i = 1001, 1100 do assert(s:get(i)[2] == string.rep('y', i)) end
+s:drop()
@@ -0,0 +1,28 @@
+env = require('test_run').new()
+
+--
+-- Check that the result of the WAL directory scan is saved
+-- to an index file and that a broken index file is ignored.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 10 do s:insert{i} box.snapshot() s:insert{-i} end
+
+env:cmd('restart server default')
+fio = require('fio')
+index = fio.pathjoin(box.cfg.wal_dir, 'xlog.index')
+fio.path.exists(index)
+box.space.test:count()
+
+env:cmd('restart server default')
+fio = require('fio')
+index = fio.pathjoin(box.cfg.wal_dir, 'xlog.index')
+box.space.test:count()
+
+f = fio.open(index, {'O_WRONLY', 'O_TRUNC'})
+f:write('XDIR INDEX\ngarbage\n')
+f:close()
+
+env:cmd('restart server default')
+box.space.test:count()
+box.space.test:drop()
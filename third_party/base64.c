@@ -28,6 +28,13 @@
  */
 #include "third_party/base64.h"
 #include <trivia/util.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BASE64_HAVE_SSSE3 1
+#include <tmmintrin.h>
+#endif
 
 /*
  * This is part of the libb64 project, and has been placed in the
@@ -70,6 +77,95 @@ base64_encode_value(char value, const char *encoding)
 	return encoding[codepos];
 }
 
+/*
+ * Full 3-byte groups are encoded in bulk, bypassing the state
+ * machine below, a vector register at a time if the CPU
+ * supports SSSE3. The vector code follows the algorithm of
+ * Wojciech Mula, http://0x80.pl/articles/index.html#base64.
+ */
+
+static const char *
+base64_encode_groups_scalar(const char *in, int count, char *out,
+			    const char *encoding)
+{
+	const unsigned char *p = (const unsigned char *)in;
+	for (int i = 0; i < count; i++, p += 3) {
+		uint32_t v = (p[0] << 16) | (p[1] << 8) | p[2];
+		*out++ = encoding[v >> 18];
+		*out++ = encoding[(v >> 12) & 0x3f];
+		*out++ = encoding[(v >> 6) & 0x3f];
+		*out++ = encoding[v & 0x3f];
+	}
+	return in + 3 * count;
+}
+
+#if defined(BASE64_HAVE_SSSE3)
+
+__attribute__((target("ssse3")))
+static const char *
+base64_encode_groups_ssse3(const char *in, int count, char *out,
+			   const char *encoding)
+{
+	const __m128i shift_lut = _mm_setr_epi8(
+		'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, encoding[62] - 62, encoding[63] - 63, 'A', 0, 0);
+	/*
+	 * 12 bytes are encoded at a time, but 16 bytes are
+	 * loaded, so stop 4 bytes before the end of the input.
+	 */
+	for (; count >= 6; count -= 4, in += 12, out += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)in);
+		/* Spread 3-byte groups to 32-bit lanes. */
+		v = _mm_shuffle_epi8(v, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4,
+						      7, 6, 8, 7, 10, 9, 11,
+						      10));
+		/* Extract 6-bit indexes, one per byte. */
+		__m128i t0 = _mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00));
+		__m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+		__m128i t2 = _mm_and_si128(v, _mm_set1_epi32(0x003f03f0));
+		__m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+		__m128i idx = _mm_or_si128(t1, t3);
+		/* Map indexes to characters. */
+		__m128i r = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+		__m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), idx);
+		r = _mm_or_si128(r, _mm_and_si128(less, _mm_set1_epi8(13)));
+		r = _mm_add_epi8(_mm_shuffle_epi8(shift_lut, r), idx);
+		_mm_storeu_si128((__m128i *)out, r);
+	}
+	return base64_encode_groups_scalar(in, count, out, encoding);
+}
+
+#endif /* defined(BASE64_HAVE_SSSE3) */
+
+typedef const char *
+(*base64_encode_groups_f)(const char *in, int count, char *out,
+			  const char *encoding);
+
+static base64_encode_groups_f
+base64_encode_groups_impl(void)
+{
+#if defined(BASE64_HAVE_SSSE3)
+	if (__builtin_cpu_supports("ssse3"))
+		return base64_encode_groups_ssse3;
+#endif
+	return base64_encode_groups_scalar;
+}
+
+/**
+ * Encode @a count full 3-byte groups of @a in to @a out.
+ * @retval the end of the encoded input
+ */
+static inline const char *
+base64_encode_groups(const char *in, int count, char *out,
+		     const char *encoding)
+{
+	static base64_encode_groups_f impl = NULL;
+	if (impl == NULL)
+		impl = base64_encode_groups_impl();
+	return impl(in, count, out, encoding);
+}
+
 static int
 base64_encode_block(const char *in_bin, int in_len,
 		    char *out_base64, int out_len,
@@ -90,6 +186,29 @@ base64_encode_block(const char *in_bin, int in_len,
 		while (1)
 		{
 	case step_A:
+			if (in_end - in_pos >= 3 && out_end - out_pos >= 4) {
+				int count = MIN((in_end - in_pos) / 3,
+						(out_end - out_pos) / 4);
+				bool wrap = (options & BASE64_NOWRAP) == 0;
+				if (wrap) {
+					count = MIN(count,
+						    BASE64_CHARS_PER_LINE / 4 -
+						    state->stepcount);
+				}
+				in_pos = base64_encode_groups(in_pos, count,
+							      out_pos,
+							      encoding);
+				out_pos += 4 * count;
+				state->stepcount += count;
+				if (wrap && state->stepcount * 4 ==
+					    BASE64_CHARS_PER_LINE) {
+					if (out_pos >= out_end)
+						return out_pos - out_base64;
+					*out_pos++ = '\n';
+					state->stepcount = 0;
+				}
+				continue;
+			}
 			if (in_pos == in_end || out_pos >= out_end) {
 				state->step = step_A;
 				goto out;
@@ -230,6 +349,116 @@ base64_decode_value(int value)
 	return decoding[codepos];
 }
 
+/*
+ * Runs of 4-character groups without line breaks, padding or
+ * invalid characters are decoded in bulk, see
+ * base64_encode_groups().
+ */
+
+static const char *
+base64_decode_groups_scalar(const char *in, int count, char *out,
+			    char **out_pos)
+{
+	for (int i = 0; i < count; i++, in += 4) {
+		int a = base64_decode_value(in[0]);
+		int b = base64_decode_value(in[1]);
+		int c = base64_decode_value(in[2]);
+		int d = base64_decode_value(in[3]);
+		if ((a | b | c | d) < 0)
+			break;
+		uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+		*out++ = v >> 16;
+		*out++ = v >> 8;
+		*out++ = v;
+	}
+	*out_pos = out;
+	return in;
+}
+
+#if defined(BASE64_HAVE_SSSE3)
+
+__attribute__((target("ssse3")))
+static inline __m128i
+base64_in_range(__m128i v, char lo, char hi)
+{
+	return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+			     _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+
+__attribute__((target("ssse3")))
+static const char *
+base64_decode_groups_ssse3(const char *in, int count, char *out,
+			   char **out_pos)
+{
+	/*
+	 * 16 bytes are stored for every 12 decoded, so stop one
+	 * register before the end of the output.
+	 */
+	for (; count >= 8; count -= 4, in += 16, out += 12) {
+		__m128i v = _mm_loadu_si128((const __m128i *)in);
+		__m128i upper = base64_in_range(v, 'A', 'Z');
+		__m128i lower = base64_in_range(v, 'a', 'z');
+		__m128i digit = base64_in_range(v, '0', '9');
+		__m128i c62 = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('+')),
+					   _mm_cmpeq_epi8(v, _mm_set1_epi8('-')));
+		__m128i c63 = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')),
+					   _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+		__m128i valid = _mm_or_si128(_mm_or_si128(upper, lower),
+					     _mm_or_si128(digit,
+						_mm_or_si128(c62, c63)));
+		if (_mm_movemask_epi8(valid) != 0xffff)
+			break;
+		/* Map characters to 6-bit values. */
+		__m128i r = _mm_and_si128(upper,
+			_mm_sub_epi8(v, _mm_set1_epi8('A')));
+		r = _mm_or_si128(r, _mm_and_si128(lower,
+			_mm_sub_epi8(v, _mm_set1_epi8('a' - 26))));
+		r = _mm_or_si128(r, _mm_and_si128(digit,
+			_mm_add_epi8(v, _mm_set1_epi8(52 - '0'))));
+		r = _mm_or_si128(r, _mm_and_si128(c62, _mm_set1_epi8(62)));
+		r = _mm_or_si128(r, _mm_and_si128(c63, _mm_set1_epi8(63)));
+		/* Pack 4 6-bit values into 24 bits of each lane. */
+		r = _mm_maddubs_epi16(r, _mm_set1_epi32(0x01400140));
+		r = _mm_madd_epi16(r, _mm_set1_epi32(0x00011000));
+		r = _mm_shuffle_epi8(r, _mm_setr_epi8(2, 1, 0, 6, 5, 4,
+						      10, 9, 8, 14, 13, 12,
+						      -1, -1, -1, -1));
+		_mm_storeu_si128((__m128i *)out, r);
+	}
+	return base64_decode_groups_scalar(in, count, out, out_pos);
+}
+
+#endif /* defined(BASE64_HAVE_SSSE3) */
+
+typedef const char *
+(*base64_decode_groups_f)(const char *in, int count, char *out,
+			  char **out_pos);
+
+static base64_decode_groups_f
+base64_decode_groups_impl(void)
+{
+#if defined(BASE64_HAVE_SSSE3)
+	if (__builtin_cpu_supports("ssse3"))
+		return base64_decode_groups_ssse3;
+#endif
+	return base64_decode_groups_scalar;
+}
+
+/**
+ * Decode up to @a count 4-character groups of @a in to @a out.
+ * Stops at the first group that can't be decoded in bulk.
+ * @param[out] out_pos the end of the decoded output
+ * @retval the end of the decoded input
+ */
+static inline const char *
+base64_decode_groups(const char *in, int count, char *out, char **out_pos)
+{
+	static base64_decode_groups_f impl = NULL;
+	if (impl == NULL)
+		impl = base64_decode_groups_impl();
+	return impl(in, count, out, out_pos);
+}
+
 static inline void
 base64_decodestate_init(struct base64_decodestate *state)
 {
@@ -255,6 +484,16 @@ base64_decode_block(const char *in_base64, int in_len,
 		while (1)
 		{
 	case step_a:
+			if (in_end - in_pos >= 4 && out_end - out_pos >= 3) {
+				int count = MIN((in_end - in_pos) / 4,
+						(out_end - out_pos) / 3);
+				const char *end = base64_decode_groups(
+					in_pos, count, out_pos, &out_pos);
+				if (end != in_pos) {
+					in_pos = end;
+					continue;
+				}
+			}
 			do {
 				if (in_pos == in_end || out_pos >= out_end)
 				{
@@ -37,6 +37,7 @@
  */
 
 #include "trivia/util.h"
+#include "trivia/config.h"
 
 #include <assert.h>
 #include <string.h>
@@ -46,8 +47,15 @@
 #include <lauxlib.h>
 
 #include "strbuf.h"
+#include "msgpuck.h"
 
 #include "lua/utils.h"
+#include "cpu_feature.h"
+
+#if defined(HAVE_CPUID) && (defined(__x86_64__) || defined(__i386__))
+#include <nmmintrin.h>
+#define JSON_SCAN_SSE42 1
+#endif
 
 #define DEFAULT_ENCODE_KEEP_BUFFER 1
 
@@ -102,6 +110,7 @@ static strbuf_t encode_buf;
 typedef struct {
     const char *data;
     const char *ptr;
+    const char *end;  /* Terminating NUL of the input */
     strbuf_t *tmp;    /* Temporary storage for strings */
     struct luaL_serializer *cfg;
     int current_depth;
@@ -225,6 +234,95 @@ static void json_create_tokens()
     escape2char['u'] = 'u';          /* Unicode parsing required */
 }
 
+/* ===== STRING SCANNING =====
+ *
+ * Most strings have long runs of characters which are copied
+ * as is both ways. The scanners below find the length of such
+ * a run so that it is copied with a single memcpy(). The SSE 4.2
+ * variants check 16 bytes per instruction and are selected at
+ * startup if the CPU supports them. */
+
+/* Return the number of leading bytes of @str which don't need
+ * escaping when encoded. */
+static size_t json_escape_scan_generic(const char *str, size_t len)
+{
+    size_t i = 0;
+    while (i < len && char2escape[(unsigned char)str[i]] == NULL)
+        i++;
+    return i;
+}
+
+/* Return the number of leading bytes of @str before a quote,
+ * backslash or NUL. @len is the number of bytes which can be
+ * read. */
+static size_t json_unescape_scan_generic(const char *str, size_t len)
+{
+    size_t i = 0;
+    while (i < len && str[i] != '"' && str[i] != '\\' && str[i] != '\0')
+        i++;
+    return i;
+}
+
+#ifdef JSON_SCAN_SSE42
+
+/* Characters escaped by the encoder, must match char2escape. */
+static const char json_escape_ranges[16] __attribute__((aligned(16))) =
+    "\x00\x1f\"\"//\\\\\x7f\x7f";
+enum { JSON_ESCAPE_RANGES_LEN = 10 };
+
+static const char json_unescape_chars[16] __attribute__((aligned(16))) =
+    "\"\\\x00";
+enum { JSON_UNESCAPE_CHARS_LEN = 3 };
+
+__attribute__((target("sse4.2")))
+static size_t json_escape_scan_sse42(const char *str, size_t len)
+{
+    const __m128i set = _mm_load_si128((const __m128i *)json_escape_ranges);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(str + i));
+        int idx = _mm_cmpestri(set, JSON_ESCAPE_RANGES_LEN, chunk, 16,
+                               _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES |
+                               _SIDD_LEAST_SIGNIFICANT);
+        if (idx != 16)
+            return i + idx;
+    }
+    return i + json_escape_scan_generic(str + i, len - i);
+}
+
+__attribute__((target("sse4.2")))
+static size_t json_unescape_scan_sse42(const char *str, size_t len)
+{
+    const __m128i set = _mm_load_si128((const __m128i *)json_unescape_chars);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(str + i));
+        int idx = _mm_cmpestri(set, JSON_UNESCAPE_CHARS_LEN, chunk, 16,
+                               _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY |
+                               _SIDD_LEAST_SIGNIFICANT);
+        if (idx != 16)
+            return i + idx;
+    }
+    return i + json_unescape_scan_generic(str + i, len - i);
+}
+
+#endif /* JSON_SCAN_SSE42 */
+
+static size_t (*json_escape_scan)(const char *, size_t) =
+    json_escape_scan_generic;
+static size_t (*json_unescape_scan)(const char *, size_t) =
+    json_unescape_scan_generic;
+
+static void json_init_scan(void)
+{
+#ifdef JSON_SCAN_SSE42
+    if (sse42_enabled_cpu()) {
+        json_escape_scan = json_escape_scan_sse42;
+        json_unescape_scan = json_unescape_scan_sse42;
+    }
+#endif
+}
+
 /* ===== ENCODING ===== */
 
 /* json_append_string args:
@@ -247,12 +345,16 @@ static void json_append_string(struct luaL_serializer *cfg, strbuf_t *json,
     strbuf_ensure_empty_length(json, len * 6 + 2);
 
     strbuf_append_char_unsafe(json, '\"');
-    for (i = 0; i < len; i++) {
+    i = 0;
+    while (i < len) {
+        size_t run = json_escape_scan(str + i, len - i);
+        strbuf_append_mem_unsafe(json, str + i, run);
+        i += run;
+        if (i == len)
+            break;
         escstr = char2escape[(unsigned char)str[i]];
-        if (escstr)
-            strbuf_append_string(json, escstr);
-        else
-            strbuf_append_char_unsafe(json, str[i]);
+        strbuf_append_string(json, escstr);
+        i++;
     }
     strbuf_append_char_unsafe(json, '\"');
 }
@@ -439,6 +541,103 @@ static int json_encode(lua_State *l) {
     return 1;
 }
 
+/* Transcode a MsgPack value into JSON without creating Lua objects.
+ * The output is the same as of json_append_data() for the decoded
+ * value. */
+static void json_append_msgpack(lua_State *l, struct luaL_serializer *cfg,
+                                int current_depth, strbuf_t *json,
+                                const char **data)
+{
+    uint32_t len, size, i;
+    const char *str;
+
+    switch (mp_typeof(**data)) {
+    case MP_UINT:
+        return json_append_uint(cfg, json, mp_decode_uint(data));
+    case MP_INT:
+        return json_append_int(cfg, json, mp_decode_int(data));
+    case MP_STR:
+        str = mp_decode_str(data, &len);
+        return json_append_string(cfg, json, str, len);
+    case MP_BIN:
+        str = mp_decode_bin(data, &len);
+        return json_append_string(cfg, json, str, len);
+    case MP_FLOAT:
+        return json_append_number(cfg, json, mp_decode_float(data));
+    case MP_DOUBLE:
+        return json_append_number(cfg, json, mp_decode_double(data));
+    case MP_BOOL:
+        if (mp_decode_bool(data))
+            strbuf_append_mem(json, "true", 4);
+        else
+            strbuf_append_mem(json, "false", 5);
+        return;
+    case MP_NIL:
+        mp_decode_nil(data);
+        return json_append_nil(cfg, json);
+    case MP_ARRAY:
+        if (current_depth >= cfg->encode_max_depth) {
+            mp_next(data);
+            return json_append_nil(cfg, json); /* Limit nested arrays */
+        }
+        size = mp_decode_array(data);
+        strbuf_append_char(json, '[');
+        for (i = 0; i < size; i++) {
+            if (i > 0)
+                strbuf_append_char(json, ',');
+            json_append_msgpack(l, cfg, current_depth, json, data);
+        }
+        strbuf_append_char(json, ']');
+        return;
+    case MP_MAP:
+        if (current_depth >= cfg->encode_max_depth) {
+            mp_next(data);
+            return json_append_nil(cfg, json); /* Limit nested maps */
+        }
+        size = mp_decode_map(data);
+        strbuf_append_char(json, '{');
+        for (i = 0; i < size; i++) {
+            if (i > 0)
+                strbuf_append_char(json, ',');
+            switch (mp_typeof(**data)) {
+            case MP_UINT:
+                strbuf_append_char(json, '"');
+                json_append_uint(cfg, json, mp_decode_uint(data));
+                strbuf_append_mem(json, "\":", 2);
+                break;
+            case MP_INT:
+                strbuf_append_char(json, '"');
+                json_append_int(cfg, json, mp_decode_int(data));
+                strbuf_append_mem(json, "\":", 2);
+                break;
+            case MP_STR:
+                str = mp_decode_str(data, &len);
+                json_append_string(cfg, json, str, len);
+                strbuf_append_char(json, ':');
+                break;
+            default:
+                luaL_error(l, "table key must be a number or string");
+            }
+            json_append_msgpack(l, cfg, current_depth + 1, json, data);
+        }
+        strbuf_append_char(json, '}');
+        return;
+    case MP_EXT:
+        luaL_error(l, "unsupported MsgPack extension");
+        return;
+    }
+}
+
+int
+json_encode_msgpack(lua_State *l, const char *data)
+{
+    strbuf_reset(&encode_buf);
+    json_append_msgpack(l, luaL_json_default, 0, &encode_buf, &data);
+    char *json = strbuf_string(&encode_buf, NULL);
+    lua_pushlstring(l, json, strbuf_length(&encode_buf));
+    return 1;
+}
+
 /* ===== DECODING ===== */
 
 static void json_process_value(lua_State *l, json_parse_t *json,
@@ -606,7 +805,15 @@ static void json_next_string_token(json_parse_t *json, json_token_t *token)
      */
     strbuf_reset(json->tmp);
 
-    while ((ch = *json->ptr) != '"') {
+    for (;;) {
+        /* Copy characters which need no translation */
+        size_t run = json_unescape_scan(json->ptr, json->end - json->ptr);
+        strbuf_append_mem_unsafe(json->tmp, json->ptr, run);
+        json->ptr += run;
+
+        ch = *json->ptr;
+        if (ch == '"')
+            break;
         if (!ch) {
             /* Premature end of the string */
             json_set_token_error(token, json, "unexpected end of string");
@@ -995,6 +1202,7 @@ static int json_decode(lua_State *l)
     json.data = luaL_checklstring(l, 1, &json_len);
     json.current_depth = 0;
     json.ptr = json.data;
+    json.end = json.data + json_len;
 
     /* Detect Unicode other than UTF-8 (see RFC 4627, Sec 3)
      *
@@ -1046,6 +1254,7 @@ int
 luaopen_json(lua_State *L)
 {
     json_create_tokens();
+    json_init_scan();
     luaL_json_default = luaL_newserializer(L, "json", jsonlib);
     luaL_pushnull(L);
     lua_setfield(L, -2, "null"); /* compatibility with cjson */
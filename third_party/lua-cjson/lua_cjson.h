@@ -10,6 +10,18 @@ extern "C" {
 LUALIB_API  int
 luaopen_json(lua_State *L);
 
+/**
+ * Encode a MsgPack value into JSON with the default json
+ * serializer options and push the result onto the Lua stack.
+ * Unlike json.encode() the value isn't converted to Lua objects.
+ *
+ * @param L Lua state.
+ * @param data MsgPack value.
+ * @return 1, the number of pushed values.
+ */
+int
+json_encode_msgpack(lua_State *L, const char *data);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif